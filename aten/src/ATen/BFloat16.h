@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ATen/ATenGeneral.h"
+#include "ATen/Half.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace at {
+
+// The upper 16 bits of an IEEE float: the range of float with 8 bits of
+// precision. The conversions are inline so that kernels computing in float
+// can widen and round elements in their inner loops; they match
+// TH_bfloat162float and TH_float2bfloat16 (TH/THBFloat16.h).
+struct alignas(2) BFloat16 {
+  uint16_t x;
+  operator double();
+};
+
+template<> inline float convert(BFloat16 f) {
+  uint32_t bits = static_cast<uint32_t>(f.x) << 16;
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+// rounds to the nearest even value, NaNs stay (quiet) NaNs
+template<> inline BFloat16 convert(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  if ((bits & 0x7fffffffU) > 0x7f800000U) {
+    return BFloat16 { static_cast<uint16_t>((bits >> 16) | 0x40U) };
+  }
+  bits += 0x7fffU + ((bits >> 16) & 1U);
+  return BFloat16 { static_cast<uint16_t>(bits >> 16) };
+}
+
+template<> inline BFloat16 convert(double f) {
+  return convert<BFloat16, float>(static_cast<float>(f));
+}
+template<> inline double convert(BFloat16 f) {
+  return convert<float, BFloat16>(f);
+}
+
+template<> inline BFloat16 convert(int64_t f) {
+  return convert<BFloat16, float>(static_cast<float>(f));
+}
+template<> inline int64_t convert(BFloat16 f) {
+  return static_cast<int64_t>(convert<float, BFloat16>(f));
+}
+
+inline BFloat16::operator double() {
+  return convert<double, BFloat16>(*this);
+}
+
+// the largest finite bfloat16 is 0x7F7F, (2 - 2^-7) * 2^127
+template<> inline bool overflows<BFloat16, double>(double f) {
+  return std::isfinite(f) && std::fabs(f) > 3.3895313892515355e38;
+}
+// every int64_t is below the largest bfloat16
+template<> inline bool overflows<BFloat16, int64_t>(int64_t) {
+  return false;
+}
+
+} // namespace at
@@ -3,13 +3,23 @@
 #include <memory>
 #include <thread>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace at {
 // Lock free atomic type
 std::atomic<int> num_threads(-1);
 
+// The same budget applies to every parallel backend, including the OpenMP
+// loops in TH, so that they don't oversubscribe the machine together.
 void set_num_threads(int num_threads_) {
-  if (num_threads_ >= 0)
+  if (num_threads_ >= 0) {
     num_threads.store(num_threads_);
+#ifdef _OPENMP
+    omp_set_num_threads(num_threads_ > 0 ? num_threads_ : 1);
+#endif
+  }
 }
 
 int get_num_threads() { return num_threads.load(); }
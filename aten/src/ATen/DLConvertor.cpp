@@ -1,5 +1,10 @@
 #include "ATen/DLConvertor.h"
 
+#include "ATen/Config.h"
+#if AT_CUDA_ENABLED()
+#include "THC/THC.h"
+#endif
+
 #include <iostream>
 #include <sstream>
 
@@ -36,6 +41,8 @@ static DLDataType getDLDataType(const Type& type) {
     case ScalarType::Half:
       dtype.code = DLDataTypeCode::kDLFloat;
       break;
+    case ScalarType::BFloat16:
+      throw std::logic_error("BFloat16 is not supported by dlpack");
     case ScalarType::Undefined:
       throw std::logic_error("Undefined is not a valid ScalarType");
     case ScalarType::NumOptions:
@@ -45,11 +52,36 @@ static DLDataType getDLDataType(const Type& type) {
 }
 
 
-static DLContext getDLContext(const Type& type, const int64_t& device_id) {
+// Whether data is page-locked host memory, registered with CUDA. Pinned
+// memory is only allocated once CUDA is initialized, so the check doesn't
+// initialize it.
+static bool isPinned(void* data) {
+#if AT_CUDA_ENABLED()
+  if (!globalContext().thc_state || !data) {
+    return false;
+  }
+  cudaPointerAttributes attr;
+  cudaError_t err = cudaPointerGetAttributes(&attr, data);
+  if (err != cudaSuccess) {
+    // pageable memory is an invalid value for the CUDA runtime; clear it
+    cudaGetLastError();
+    return false;
+  }
+  return attr.memoryType == cudaMemoryTypeHost;
+#else
+  (void)data; // avoid unused parameter warning
+  return false;
+#endif
+}
+
+
+static DLContext getDLContext(const Tensor& src, const int64_t& device_id) {
   DLContext ctx;
   ctx.device_id = device_id;
-  if (type.is_cuda()) {
+  if (src.type().is_cuda()) {
     ctx.device_type = DLDeviceType::kDLGPU;
+  } else if (isPinned(src.data_ptr())) {
+    ctx.device_type = DLDeviceType::kDLCPUPinned;
   } else {
     ctx.device_type = DLDeviceType::kDLCPU;
   }
@@ -61,6 +93,9 @@ static Backend getATenBackend(const DLContext& ctx) {
   Backend backend;
   switch (ctx.device_type) {
     case DLDeviceType::kDLCPU:
+    case DLDeviceType::kDLCPUPinned:
+      // pinned memory is accessed as any host memory, and is still pinned
+      // for the copies to the device
       backend = Backend::CPU;
       break;
     case DLDeviceType::kDLGPU:
@@ -125,19 +160,63 @@ ScalarType toScalarType(const DLDataType& dtype) {
   return stype;
 }
 
+#if AT_CUDA_ENABLED()
+// Makes the device current for the lifetime of the guard
+struct CUDADeviceGuard {
+  explicit CUDADeviceGuard(int device) {
+    THCudaCheck(cudaGetDevice(&previous));
+    if (device != previous) {
+      THCudaCheck(cudaSetDevice(device));
+    }
+  }
+  ~CUDADeviceGuard() {
+    cudaSetDevice(previous);
+  }
+  int previous;
+};
+
+// Orders the work queued on producer before the work queued next on
+// consumer, both streams of the current device
+static void streamWaitStream(cudaStream_t consumer, cudaStream_t producer) {
+  if (consumer == producer) {
+    return;
+  }
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, producer));
+  THCudaCheck(cudaStreamWaitEvent(consumer, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+#endif
+
 struct ATenDLMTensor {
   Tensor handle;
   DLManagedTensor tensor;
+  // the stream of the consumer, for tensors exported to one
+  bool has_stream = false;
+  cudaStream_t stream = nullptr;
 };
 
 void deleter(DLManagedTensor * arg) {
-  delete static_cast<ATenDLMTensor*>(arg->manager_ctx);
+  auto atDLMTensor = static_cast<ATenDLMTensor*>(arg->manager_ctx);
+#if AT_CUDA_ENABLED()
+  if (atDLMTensor->has_stream) {
+    // The memory goes back to the caching allocator, which reuses it on the
+    // current stream: order the work the consumer queued before that reuse
+    int device = atDLMTensor->handle.get_device();
+    CUDADeviceGuard guard(device);
+    streamWaitStream(
+        THCState_getCurrentStreamOnDevice(globalContext().thc_state, device),
+        atDLMTensor->stream);
+  }
+#endif
+  delete atDLMTensor;
 }
 
 
 // This function returns a shared_ptr to memory managed DLpack tensor constructed
 // out of ATen tensor
-DLManagedTensor* toDLPack(const Tensor& src) {
+static ATenDLMTensor* newATenDLMTensor(const Tensor& src) {
   ATenDLMTensor * atDLMTensor(new ATenDLMTensor);
   atDLMTensor->handle = src;
   atDLMTensor->tensor.manager_ctx = atDLMTensor;
@@ -147,12 +226,35 @@ DLManagedTensor* toDLPack(const Tensor& src) {
   if (src.type().is_cuda()) {
     device_id = src.get_device();
   }
-  atDLMTensor->tensor.dl_tensor.ctx = getDLContext(src.type(), device_id);
+  atDLMTensor->tensor.dl_tensor.ctx = getDLContext(src, device_id);
   atDLMTensor->tensor.dl_tensor.ndim = src.dim();
   atDLMTensor->tensor.dl_tensor.dtype = getDLDataType(src.type());
   atDLMTensor->tensor.dl_tensor.shape = const_cast<int64_t*>(src.sizes().data());
   atDLMTensor->tensor.dl_tensor.strides = const_cast<int64_t*>(src.strides().data());
   atDLMTensor->tensor.dl_tensor.byte_offset = 0;
+  return atDLMTensor;
+}
+
+
+DLManagedTensor* toDLPack(const Tensor& src) {
+  return &(newATenDLMTensor(src)->tensor);
+}
+
+
+DLManagedTensor* toDLPack(const Tensor& src, cudaStream_t stream) {
+  ATenDLMTensor * atDLMTensor = newATenDLMTensor(src);
+#if AT_CUDA_ENABLED()
+  if (src.type().is_cuda()) {
+    int device = src.get_device();
+    CUDADeviceGuard guard(device);
+    streamWaitStream(stream,
+        THCState_getCurrentStreamOnDevice(globalContext().thc_state, device));
+    atDLMTensor->has_stream = true;
+    atDLMTensor->stream = stream;
+  }
+#else
+  (void)stream; // avoid unused parameter warning
+#endif
   return &(atDLMTensor->tensor);
 }
 
@@ -169,4 +271,21 @@ Tensor fromDLPack(const DLManagedTensor* src) {
       IntList(src->dl_tensor.strides, src->dl_tensor.ndim),
       deleter);
 }
+
+
+Tensor fromDLPack(const DLManagedTensor* src, cudaStream_t stream) {
+  Tensor tensor = fromDLPack(src);
+#if AT_CUDA_ENABLED()
+  if (tensor.type().is_cuda()) {
+    int device = tensor.get_device();
+    CUDADeviceGuard guard(device);
+    streamWaitStream(
+        THCState_getCurrentStreamOnDevice(globalContext().thc_state, device),
+        stream);
+  }
+#else
+  (void)stream; // avoid unused parameter warning
+#endif
+  return tensor;
+}
 } //namespace at
@@ -14,4 +14,14 @@ AT_API ScalarType toScalarType(const DLDataType& dtype);
 AT_API DLManagedTensor * toDLPack(const Tensor& src);
 AT_API Tensor fromDLPack(const DLManagedTensor* src);
 
+// Stream ordered exchange of CUDA tensors, which the DLPack format doesn't
+// carry: toDLPack orders the work queued on the current stream of the device
+// of src before the work queued next on the stream of the consumer, and
+// fromDLPack orders the work queued on the stream of the producer before the
+// work queued next on the current stream. Both only record an event and make
+// a stream wait on it, without synchronizing the host or the device. The
+// stream is ignored for CPU tensors, and a null stream is the default one.
+AT_API DLManagedTensor * toDLPack(const Tensor& src, cudaStream_t stream);
+AT_API Tensor fromDLPack(const DLManagedTensor* src, cudaStream_t stream);
+
 } //namespace at
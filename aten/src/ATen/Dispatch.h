@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ATen/BFloat16.h>
 #include <ATen/Error.h>
 #include <ATen/Half.h>
 #include <ATen/Type.h>
@@ -33,6 +34,18 @@
     }                                                                         \
   }()
 
+#define AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(TYPE, NAME, ...)              \
+  [&] {                                                                       \
+    const at::Type& the_type = TYPE;                                          \
+    switch (the_type.scalarType()) {                                          \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Double, double, __VA_ARGS__)       \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::Float, float, __VA_ARGS__)         \
+      AT_PRIVATE_CASE_TYPE(at::ScalarType::BFloat16, BFloat16, __VA_ARGS__)   \
+      default:                                                                \
+        AT_ERROR("%s not implemented for '%s'", (NAME), the_type.toString()); \
+    }                                                                         \
+  }()
+
 #define AT_DISPATCH_ALL_TYPES(TYPE, NAME, ...)                                \
   [&] {                                                                       \
     const at::Type& the_type = TYPE;                                          \
@@ -1,13 +1,105 @@
 #include <ATen/CPUGeneral.h>
 #include <ATen/Parallel.h>
 #include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/partitioner.h>
 #include <tbb/tbb.h>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
 #include <thread>
 
-namespace at { namespace internal {
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace at {
+
+namespace {
+
+ParallelBackend default_backend() {
+  const char* env = std::getenv("ATEN_PARALLEL_BACKEND");
+  if (env) {
+    if (strcmp(env, "sequential") == 0)
+      return ParallelBackend::SEQUENTIAL;
+#ifdef _OPENMP
+    if (strcmp(env, "openmp") == 0)
+      return ParallelBackend::OPENMP;
+#endif
+  }
+  return ParallelBackend::TBB;
+}
+
+std::atomic<ParallelBackend>& current_backend() {
+  static std::atomic<ParallelBackend> backend(default_backend());
+  return backend;
+}
+
+std::atomic<ParallelForImpl> custom_impl(nullptr);
+
+#ifdef _OPENMP
+void omp_parallel_for(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f) {
+  int64_t max_chunks = (end - begin + grain_size - 1) / grain_size;
+  int num_threads = get_num_threads();
+  if (num_threads < 0) {
+    num_threads = omp_get_max_threads();
+  }
+  num_threads = static_cast<int>(std::min<int64_t>(num_threads, max_chunks));
+  // exceptions can't leave an OpenMP region, rethrow the first one after it
+  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
+  std::exception_ptr eptr;
+#pragma omp parallel num_threads(num_threads)
+  {
+    int64_t tid = omp_get_thread_num();
+    int64_t nthreads = omp_get_num_threads();
+    int64_t chunk_size = (end - begin + nthreads - 1) / nthreads;
+    int64_t chunk_begin = begin + tid * chunk_size;
+    if (chunk_begin < end) {
+      try {
+        f(chunk_begin, std::min(end, chunk_begin + chunk_size));
+      } catch (...) {
+        if (!err_flag.test_and_set()) {
+          eptr = std::current_exception();
+        }
+      }
+    }
+  }
+  if (eptr) {
+    std::rethrow_exception(eptr);
+  }
+}
+#endif
+
+} // anonymous namespace
+
+void set_parallel_backend(ParallelBackend backend) {
+#ifndef _OPENMP
+  if (backend == ParallelBackend::OPENMP)
+    throw std::runtime_error("set_parallel_backend: ATen was built without OpenMP");
+#endif
+  if (backend == ParallelBackend::CUSTOM && !custom_impl.load())
+    throw std::runtime_error("set_parallel_backend: no parallel_for implementation was registered");
+  current_backend().store(backend);
+}
+
+ParallelBackend get_parallel_backend() {
+  return current_backend().load();
+}
+
+void set_parallel_for_impl(ParallelForImpl impl) {
+  custom_impl.store(impl);
+  current_backend().store(impl ? ParallelBackend::CUSTOM : default_backend());
+}
+
+namespace internal {
 
 // thread_local variable with internal linkage
 // requires no guarding as it's storage duration is defined to be per thread
@@ -51,4 +143,34 @@ void init_tbb_num_threads() {
     num_threads_ = num_threads;
   }
 }
+
+void parallel_for_impl(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f) {
+  switch (current_backend().load()) {
+    case ParallelBackend::TBB:
+      init_tbb_num_threads();
+      tbb::parallel_for(
+          tbb::blocked_range<int64_t>(begin, end, grain_size),
+          [&f](const tbb::blocked_range<int64_t>& r) { f(r.begin(), r.end()); });
+      return;
+#ifdef _OPENMP
+    case ParallelBackend::OPENMP:
+      omp_parallel_for(begin, end, grain_size, f);
+      return;
+#endif
+    case ParallelBackend::CUSTOM:
+      if (auto impl = custom_impl.load()) {
+        impl(begin, end, grain_size, f);
+        return;
+      }
+      break;
+    default:
+      break;
+  }
+  f(begin, end);
+}
+
 }} // namespace at::internal
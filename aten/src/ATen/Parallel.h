@@ -1,9 +1,43 @@
 #pragma once
 #include <ATen/ATen.h>
-#include <tbb/tbb.h>
+#include <ATen/CPUGeneral.h>
+#include <algorithm>
 #include <cstddef>
+#include <functional>
+#include <numeric>
+#include <vector>
 
 namespace at {
+
+// Intra-op parallelism.
+//
+// Kernels split their work with at::parallel_for and at::parallel_reduce,
+// and the process picks which thread pool actually runs it, so that all the
+// libraries sharing a process can also share one pool and one thread budget
+// (at::set_num_threads) instead of oversubscribing the machine.
+//
+// TBB is the default backend. OpenMP can be selected when ATen is built with
+// it, either with set_parallel_backend or by setting ATEN_PARALLEL_BACKEND to
+// "openmp" ("tbb" and "sequential" are also accepted). Other pools (e.g.
+// Caffe2's) can be plugged in with set_parallel_for_impl.
+enum class ParallelBackend { TBB, OPENMP, SEQUENTIAL, CUSTOM };
+
+// Runs f(chunk_begin, chunk_end) for chunks covering [begin, end), possibly
+// in parallel, and only returns once all of them finished. Chunks must not be
+// smaller than grain_size, except for the last one.
+using ParallelForImpl = void (*)(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f);
+
+// Throws if backend isn't available in this build, or if it is CUSTOM and
+// no implementation was registered.
+AT_API void set_parallel_backend(ParallelBackend backend);
+AT_API ParallelBackend get_parallel_backend();
+// Registers impl and selects the CUSTOM backend. nullptr restores the default.
+AT_API void set_parallel_for_impl(ParallelForImpl impl);
+
 namespace internal {
 // This needs to be called before the first use of any algorithm such as
 // parallel or it will have no effect and the default task scheduler is
@@ -20,10 +54,65 @@ void init_tbb_num_threads();
 // work that warrants paralellism. For example, when summing an array, it is
 // deemed inefficient to parallelise over arrays shorter than 32768. Further,
 // no parallel algorithm (such as parallel_reduce) should split work into
-// smaller than GRAIN_SIZE chunks.
-constexpr int64_t TBB_GRAIN_SIZE = 32768;
+// smaller than GRAIN_SIZE chunks. Kernels with more work per element should
+// pass a smaller grain size to parallel_for.
+constexpr int64_t GRAIN_SIZE = 32768;
+constexpr int64_t TBB_GRAIN_SIZE = GRAIN_SIZE;
+
+// Runs f with the current backend, end - begin is larger than grain_size.
+AT_API void parallel_for_impl(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f);
 } // namespace internal
 
+// Calls f(chunk_begin, chunk_end) over [begin, end) split in chunks of at
+// least grain_size elements. Work smaller than grain_size runs inline.
+template <class F>
+void parallel_for(int64_t begin, int64_t end, int64_t grain_size, const F& f) {
+  if (begin >= end) {
+    return;
+  }
+  grain_size = std::max<int64_t>(grain_size, 1);
+  int num_threads = get_num_threads();
+  if (end - begin <= grain_size || num_threads == 0 || num_threads == 1) {
+    f(begin, end);
+    return;
+  }
+  internal::parallel_for_impl(begin, end, grain_size, f);
+}
+
+// Reduces [begin, end) in chunks of grain_size elements with
+// f(chunk_begin, chunk_end, ident), and combines the partial results with sf.
+// The chunks don't depend on the backend or the number of threads, so the
+// result is deterministic. ident must be the identity of sf.
+template <class scalar_t, class F, class SF>
+scalar_t parallel_reduce(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    scalar_t ident,
+    const F& f,
+    const SF& sf) {
+  if (begin >= end) {
+    return ident;
+  }
+  grain_size = std::max<int64_t>(grain_size, 1);
+  if (end - begin <= grain_size) {
+    return f(begin, end, ident);
+  }
+  int64_t num_chunks = (end - begin + grain_size - 1) / grain_size;
+  std::vector<scalar_t> results(num_chunks, ident);
+  parallel_for(0, num_chunks, 1, [&](int64_t chunk_begin, int64_t chunk_end) {
+    for (int64_t c = chunk_begin; c != chunk_end; c++) {
+      int64_t b = begin + c * grain_size;
+      results[c] = f(b, std::min(end, b + grain_size), ident);
+    }
+  });
+  return std::accumulate(results.begin(), results.end(), ident, sf);
+}
+
 template <class T, template <class> class OP>
 T parallel_reduce(
     T (*f)(const T*, size_t, size_t, T),
@@ -31,23 +120,13 @@ T parallel_reduce(
     size_t start,
     size_t end,
     T init_) {
-  internal::init_tbb_num_threads();
-
-  T result_;
-  static tbb::affinity_partitioner ap;
-  if (end - start < internal::TBB_GRAIN_SIZE) {
-    result_ = f(data, start, end, init_);
-  } else {
-    result_ = tbb::parallel_reduce(
-        tbb::blocked_range<size_t>(start, end, internal::TBB_GRAIN_SIZE),
-        init_,
-        [&data, &f](const tbb::blocked_range<size_t> r, T init) -> T {
-          return f(data, r.begin(), r.end(), init);
-        },
-        OP<T>(),
-        ap);
-  }
-  return result_;
+  return parallel_reduce(
+      start,
+      end,
+      internal::GRAIN_SIZE,
+      init_,
+      [&data, &f](int64_t b, int64_t e, T init) { return f(data, b, e, init); },
+      OP<T>());
 }
 
 template <class T>
@@ -58,35 +137,25 @@ void parallel_reduce_2d(
     size_t numel,
     const T* arr_,
     T* outarr_) {
-  internal::init_tbb_num_threads();
-
-  static tbb::affinity_partitioner ap;
-
   size_t max_i_ =
       (numel && num_rows && num_cols) ? numel / (num_rows * num_cols) : 0;
-  if (numel < internal::TBB_GRAIN_SIZE) {
-    for (size_t i_ = 0; i_ < max_i_; i_++) {
-      int64_t i = i_ * num_rows * num_cols;
-      int64_t i_r = i_ * num_cols;
-      const T* arr = arr_ + i;
-      T* outarr = outarr_ + i_r;
-      f(arr, outarr, num_rows, num_cols);
-    }
-  } else {
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, max_i_, 1),
-        [&arr_, &outarr_, num_rows, num_cols, &f](
-            const tbb::blocked_range<size_t> r) {
-          for (size_t i_ = r.begin(); i_ < r.end(); i_++) {
-            int64_t i = i_ * num_rows * num_cols;
-            int64_t i_r = i_ * num_cols;
-            const T* arr = arr_ + i;
-            T* outarr = outarr_ + i_r;
-            f(arr, outarr, num_rows, num_cols);
-          }
-        },
-        ap);
-  }
+  // split the work so that every chunk covers roughly GRAIN_SIZE elements
+  int64_t grain_size = (numel && max_i_)
+      ? std::max<int64_t>(1, internal::GRAIN_SIZE * max_i_ / numel)
+      : 1;
+  parallel_for(
+      0,
+      max_i_,
+      grain_size,
+      [&arr_, &outarr_, num_rows, num_cols, &f](int64_t begin, int64_t end) {
+        for (int64_t i_ = begin; i_ < end; i_++) {
+          int64_t i = i_ * num_rows * num_cols;
+          int64_t i_r = i_ * num_cols;
+          const T* arr = arr_ + i;
+          T* outarr = outarr_ + i_r;
+          f(arr, outarr, num_rows, num_cols);
+        }
+      });
 }
 
 } // namespace at
@@ -4,6 +4,7 @@
 
 #include "ATen/ArrayRef.h"
 #include "ATen/ATenGeneral.h"
+#include "ATen/BFloat16.h"
 #include "ATen/Half.h"
 
 namespace at {
@@ -16,7 +17,8 @@ _(int,Int,i) \
 _(int64_t,Long,i) \
 _(Half,Half,d) \
 _(float,Float,d) \
-_(double,Double,d)
+_(double,Double,d) \
+_(BFloat16,BFloat16,d)
 
 enum class ScalarType {
 #define DEFINE_ENUM(_1,n,_2) \
@@ -100,7 +102,8 @@ static inline bool isIntegralType(ScalarType t) {
 static inline bool isFloatingType(ScalarType t) {
   return (t == ScalarType::Double ||
           t == ScalarType::Float ||
-          t == ScalarType::Half);
+          t == ScalarType::Half ||
+          t == ScalarType::BFloat16);
 }
 
 static inline ScalarType promoteTypes(ScalarType a, ScalarType b) {
@@ -113,20 +116,22 @@ static inline ScalarType promoteTypes(ScalarType a, ScalarType b) {
 #define f2 ScalarType::Half
 #define f4 ScalarType::Float
 #define f8 ScalarType::Double
+#define b2 ScalarType::BFloat16
 #define ud ScalarType::Undefined
   static constexpr ScalarType _promoteTypesLookup
       [static_cast<int>(ScalarType::NumOptions)]
       [static_cast<int>(ScalarType::NumOptions)] = {
-            /* u1  i1  i2  i4  i8  f2  f4  f8, ud */
-    /* u1 */ { u1, i2, i2, i4, i8, f2, f4, f8, ud },
-    /* i1 */ { i2, i1, i2, i4, i8, f2, f4, f8, ud },
-    /* i2 */ { i2, i2, i2, i4, i8, f4, f4, f8, ud },
-    /* i4 */ { i4, i4, i4, i4, i8, f8, f4, f8, ud },
-    /* i8 */ { i8, i8, i8, i8, i8, f8, f4, f8, ud },
-    /* f2 */ { f2, f2, f4, f8, f8, f2, f4, f8, ud },
-    /* f4 */ { f4, f4, f4, f4, f4, f4, f4, f8, ud },
-    /* f8 */ { f8, f8, f8, f8, f8, f8, f8, f8, ud },
-    /* ud */ { ud, ud, ud, ud, ud, ud, ud, ud, ud },
+            /* u1  i1  i2  i4  i8  f2  f4  f8  b2, ud */
+    /* u1 */ { u1, i2, i2, i4, i8, f2, f4, f8, b2, ud },
+    /* i1 */ { i2, i1, i2, i4, i8, f2, f4, f8, b2, ud },
+    /* i2 */ { i2, i2, i2, i4, i8, f4, f4, f8, f4, ud },
+    /* i4 */ { i4, i4, i4, i4, i8, f8, f4, f8, f8, ud },
+    /* i8 */ { i8, i8, i8, i8, i8, f8, f4, f8, f8, ud },
+    /* f2 */ { f2, f2, f4, f8, f8, f2, f4, f8, f4, ud },
+    /* f4 */ { f4, f4, f4, f4, f4, f4, f4, f8, f4, ud },
+    /* f8 */ { f8, f8, f8, f8, f8, f8, f8, f8, f8, ud },
+    /* b2 */ { b2, b2, f4, f8, f8, f4, f4, f8, b2, ud },
+    /* ud */ { ud, ud, ud, ud, ud, ud, ud, ud, ud, ud },
   };
 #undef u1
 #undef i1
@@ -136,6 +141,7 @@ static inline ScalarType promoteTypes(ScalarType a, ScalarType b) {
 #undef f2
 #undef f4
 #undef f8
+#undef b2
 #undef ud
   return _promoteTypesLookup[static_cast<int>(a)][static_cast<int>(b)];
 }
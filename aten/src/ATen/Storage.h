@@ -8,6 +8,8 @@ struct Type;
 
 struct Storage {
   static const char RESIZABLE = 2;
+  // Tensors on a read-only storage can't be modified in-place
+  static const char READONLY = 16;
 
   Storage() {}
   Storage(const Storage& other) = delete;
@@ -36,6 +38,7 @@ struct Storage {
 
   virtual void set_flag(char flag) = 0;
   virtual void clear_flag(char flag) = 0;
+  virtual bool has_flag(char flag) const = 0;
 };
 
 } // namespace at
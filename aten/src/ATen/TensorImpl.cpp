@@ -0,0 +1,15 @@
+#include "ATen/TensorImpl.h"
+
+#include "TH/THSmallAlloc.h"
+
+namespace at {
+
+void * TensorImpl::operator new(std::size_t size) {
+  return THSmallAlloc(size);
+}
+
+void TensorImpl::operator delete(void * ptr, std::size_t size) {
+  THSmallFree(ptr, size);
+}
+
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
 #include <iostream>
 
+#include "ATen/ATenGeneral.h"
 #include "ATen/Retainable.h"
 #include "ATen/ScalarType.h"
 
@@ -13,10 +15,15 @@ struct Type;
 class Scalar;
 struct Storage;
 
-struct TensorImpl : public Retainable {
+struct AT_API TensorImpl : public Retainable {
   explicit TensorImpl(Type * type)
   : is_scalar(false), type_(type) {}
 
+  // One is created with every tensor, so they come from the small blocks
+  // cached by each thread (TH/THSmallAlloc.h) rather than from malloc
+  static void * operator new(std::size_t size);
+  static void operator delete(void * ptr, std::size_t size);
+
   Type & type() const {
     return *type_;
   }
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ATen/ATen.h"
+#include "benchmark/benchmark.h"
+
+#include <string>
+
+// Helpers shared by the ATen microbenchmarks. Every benchmark takes its
+// problem size and the number of intra-op threads as arguments, so that the
+// JSON output (--benchmark_format=json) can be compared across builds for
+// every configuration.
+
+namespace at { namespace benchmark_utils {
+
+// Sets the number of intra-op threads from argument `arg` of the state.
+inline void setThreads(benchmark::State& state, int arg) {
+  at::set_num_threads(static_cast<int>(state.range(arg)));
+  state.counters["threads"] = static_cast<double>(state.range(arg));
+}
+
+// A random tensor of the given type. If strided, the result is a
+// non-contiguous view of the same sizes: the transpose of a contiguous
+// tensor for 2-d (and higher) sizes, every other element for 1-d ones.
+inline Tensor makeTensor(Type& type, IntList sizes, bool strided = false) {
+  std::vector<int64_t> base(sizes.begin(), sizes.end());
+  if (strided && base.size() == 1) {
+    base[0] *= 2;
+  } else if (strided) {
+    std::swap(base[0], base[1]);
+  }
+  // rand only exists for floating types; the values are in [-5, 5)
+  auto t = (at::rand(type.toScalarType(kFloat), base) * 10 - 5)
+               .toType(type.scalarType());
+  if (!strided) {
+    return t;
+  } else if (base.size() == 1) {
+    return t.slice(0, 0, base[0], 2);
+  } else {
+    return t.transpose(0, 1);
+  }
+}
+
+// Random indices in [0, range), as a contiguous LongTensor.
+inline Tensor makeIndices(int64_t n, int64_t range) {
+  auto indices = (at::rand(CPU(kFloat), {n}) * range).toType(kLong);
+  return indices.clamp_(0, range - 1);
+}
+
+inline void setBytesProcessed(benchmark::State& state, int64_t bytes) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * bytes);
+}
+
+inline void setItemsProcessed(benchmark::State& state, int64_t items) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * items);
+}
+
+// The sizes x thread counts most benchmarks are run on.
+inline void sizesAndThreads(benchmark::internal::Benchmark* b) {
+  for (int64_t size : {1 << 10, 1 << 16, 1 << 22}) {
+    for (int64_t threads : {1, 4}) {
+      b->Args({size, threads});
+    }
+  }
+}
+
+}} // namespace at::benchmark_utils
@@ -0,0 +1,43 @@
+#include "benchmark_utils.h"
+
+using namespace at;
+using namespace at::benchmark_utils;
+
+// Copies between tensors of the same and of different types and layouts.
+// The arguments are the number of elements and the number of threads.
+
+static void BM_Copy(
+    benchmark::State& state,
+    ScalarType from,
+    ScalarType to,
+    bool strided) {
+  setThreads(state, 1);
+  auto src = makeTensor(CPU(from), {state.range(0) / 64, 64}, strided);
+  auto dst = CPU(to).tensor({state.range(0) / 64, 64});
+  while (state.KeepRunning()) {
+    dst.copy_(src);
+  }
+  setBytesProcessed(
+      state,
+      src.numel() *
+          (src.type().elementSizeInBytes() + dst.type().elementSizeInBytes()));
+}
+BENCHMARK_CAPTURE(BM_Copy, float, kFloat, kFloat, false)
+    ->Apply(sizesAndThreads);
+BENCHMARK_CAPTURE(BM_Copy, float_transposed, kFloat, kFloat, true)
+    ->Apply(sizesAndThreads);
+BENCHMARK_CAPTURE(BM_Copy, float_to_double, kFloat, kDouble, false)
+    ->Apply(sizesAndThreads);
+BENCHMARK_CAPTURE(BM_Copy, long_to_float, kLong, kFloat, false)
+    ->Apply(sizesAndThreads);
+
+// contiguous() of a transposed tensor, allocating the result.
+static void BM_Contiguous(benchmark::State& state) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(kFloat), {state.range(0) / 64, 64}, true);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(x.contiguous());
+  }
+  setBytesProcessed(state, 2 * x.numel() * sizeof(float));
+}
+BENCHMARK(BM_Contiguous)->Apply(sizesAndThreads);
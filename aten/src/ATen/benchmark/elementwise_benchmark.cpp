@@ -0,0 +1,100 @@
+#include "benchmark_utils.h"
+
+using namespace at;
+using namespace at::benchmark_utils;
+
+// Unary and binary elementwise ops on contiguous and strided inputs. The
+// arguments are the number of elements and the number of threads.
+
+template <typename F>
+static void BM_Unary(
+    benchmark::State& state,
+    F op,
+    ScalarType dtype,
+    bool strided) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(dtype), {state.range(0) / 64, 64}, strided);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(op(x));
+  }
+  setItemsProcessed(state, x.numel());
+  setBytesProcessed(state, 2 * x.numel() * x.type().elementSizeInBytes());
+}
+
+template <typename F>
+static void BM_Binary(
+    benchmark::State& state,
+    F op,
+    ScalarType dtype,
+    bool strided) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(dtype), {state.range(0) / 64, 64}, strided);
+  auto y = makeTensor(CPU(dtype), {state.range(0) / 64, 64}, strided);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(op(x, y));
+  }
+  setItemsProcessed(state, x.numel());
+  setBytesProcessed(state, 3 * x.numel() * x.type().elementSizeInBytes());
+}
+
+// Broadcasting a row over a matrix.
+static void BM_AddBroadcast(benchmark::State& state) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(kFloat), {state.range(0) / 64, 64});
+  auto row = makeTensor(CPU(kFloat), {64});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(x + row);
+  }
+  setItemsProcessed(state, x.numel());
+}
+BENCHMARK(BM_AddBroadcast)->Apply(sizesAndThreads);
+
+// In place, without allocating the output.
+static void BM_AddInplace(benchmark::State& state) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(kFloat), {state.range(0) / 64, 64});
+  auto y = makeTensor(CPU(kFloat), {state.range(0) / 64, 64});
+  while (state.KeepRunning()) {
+    x.add_(y);
+  }
+  setItemsProcessed(state, x.numel());
+}
+BENCHMARK(BM_AddInplace)->Apply(sizesAndThreads);
+
+#define UNARY_BENCHMARK(name, expr)                                        \
+  static Tensor name##_op(const Tensor& x) {                               \
+    return expr;                                                           \
+  }                                                                        \
+  BENCHMARK_CAPTURE(BM_Unary, name##_float, name##_op, kFloat, false)      \
+      ->Apply(sizesAndThreads);                                            \
+  BENCHMARK_CAPTURE(BM_Unary, name##_double, name##_op, kDouble, false)    \
+      ->Apply(sizesAndThreads);                                            \
+  BENCHMARK_CAPTURE(BM_Unary, name##_float_strided, name##_op, kFloat, true) \
+      ->Apply(sizesAndThreads);
+
+#define BINARY_BENCHMARK(name, expr)                                         \
+  static Tensor name##_op(const Tensor& x, const Tensor& y) {                 \
+    return expr;                                                             \
+  }                                                                          \
+  BENCHMARK_CAPTURE(BM_Binary, name##_float, name##_op, kFloat, false)       \
+      ->Apply(sizesAndThreads);                                              \
+  BENCHMARK_CAPTURE(BM_Binary, name##_double, name##_op, kDouble, false)     \
+      ->Apply(sizesAndThreads);                                              \
+  BENCHMARK_CAPTURE(BM_Binary, name##_int, name##_op, kInt, false)           \
+      ->Apply(sizesAndThreads);                                              \
+  BENCHMARK_CAPTURE(BM_Binary, name##_float_strided, name##_op, kFloat, true) \
+      ->Apply(sizesAndThreads);
+
+UNARY_BENCHMARK(exp, x.exp())
+UNARY_BENCHMARK(log, x.abs().log())
+UNARY_BENCHMARK(sigmoid, x.sigmoid())
+UNARY_BENCHMARK(tanh, x.tanh())
+UNARY_BENCHMARK(sqrt, x.abs().sqrt())
+UNARY_BENCHMARK(relu, x.clamp_min(0))
+
+BINARY_BENCHMARK(add, x + y)
+BINARY_BENCHMARK(mul, x * y)
+BINARY_BENCHMARK(div, x / (y.abs() + 1))
+
+#undef UNARY_BENCHMARK
+#undef BINARY_BENCHMARK
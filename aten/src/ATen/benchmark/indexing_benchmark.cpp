@@ -0,0 +1,86 @@
+#include "benchmark_utils.h"
+
+using namespace at;
+using namespace at::benchmark_utils;
+
+// Gathers and scatters of rows of a 100000 x dim float table, at random
+// indices. The arguments are the number of indices and the number of threads.
+
+static const int64_t kRows = 100000;
+static const int64_t kDim = 64;
+
+static void indexSizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n : {1 << 8, 1 << 14}) {
+    for (int64_t threads : {1, 4}) {
+      b->Args({n, threads});
+    }
+  }
+}
+
+static void BM_IndexSelect(benchmark::State& state) {
+  setThreads(state, 1);
+  auto table = makeTensor(CPU(kFloat), {kRows, kDim});
+  auto indices = makeIndices(state.range(0), kRows);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(table.index_select(0, indices));
+  }
+  setBytesProcessed(state, 2 * state.range(0) * kDim * sizeof(float));
+}
+BENCHMARK(BM_IndexSelect)->Apply(indexSizes);
+
+// Advanced indexing, table[indices].
+static void BM_Index(benchmark::State& state) {
+  setThreads(state, 1);
+  auto table = makeTensor(CPU(kFloat), {kRows, kDim});
+  auto indices = makeIndices(state.range(0), kRows);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(table.index({indices}));
+  }
+  setBytesProcessed(state, 2 * state.range(0) * kDim * sizeof(float));
+}
+BENCHMARK(BM_Index)->Apply(indexSizes);
+
+// One element per row of an n x kDim matrix.
+static void BM_Gather(benchmark::State& state) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(kFloat), {state.range(0), kDim});
+  auto indices = makeIndices(state.range(0), kDim).view({-1, 1});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(x.gather(1, indices));
+  }
+  setItemsProcessed(state, state.range(0));
+}
+BENCHMARK(BM_Gather)->Apply(indexSizes);
+
+static void BM_IndexAdd(benchmark::State& state) {
+  setThreads(state, 1);
+  auto table = makeTensor(CPU(kFloat), {kRows, kDim});
+  auto indices = makeIndices(state.range(0), kRows);
+  auto source = makeTensor(CPU(kFloat), {state.range(0), kDim});
+  while (state.KeepRunning()) {
+    table.index_add_(0, indices, source);
+  }
+  setBytesProcessed(state, 3 * state.range(0) * kDim * sizeof(float));
+}
+BENCHMARK(BM_IndexAdd)->Apply(indexSizes);
+
+// Bags of 20 rows, summed (mode 0) or averaged (mode 1). The arguments are
+// the number of bags, the mode and the number of threads.
+static void BM_EmbeddingBag(benchmark::State& state) {
+  setThreads(state, 2);
+  const int64_t bags = state.range(0);
+  const int64_t bagSize = 20;
+  auto weight = makeTensor(CPU(kFloat), {kRows, kDim});
+  auto indices = makeIndices(bags * bagSize, kRows);
+  auto offsets = at::arange(CPU(kLong), 0, bags * bagSize, bagSize);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        at::embedding_bag(weight, indices, offsets, false, state.range(1)));
+  }
+  setBytesProcessed(state, bags * bagSize * kDim * sizeof(float));
+}
+BENCHMARK(BM_EmbeddingBag)
+    ->Args({64, 0, 1})
+    ->Args({1024, 0, 1})
+    ->Args({1024, 0, 4})
+    ->Args({1024, 1, 4});
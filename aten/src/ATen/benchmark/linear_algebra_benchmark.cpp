@@ -0,0 +1,88 @@
+#include "benchmark_utils.h"
+
+using namespace at;
+using namespace at::benchmark_utils;
+
+// GEMM and convolutions. The flop counts are reported as items, so that the
+// items_per_second of the JSON output is the achieved flop rate.
+
+// An n x n by n x n product. The first argument is n, the second the number
+// of threads.
+static void BM_Mm(benchmark::State& state, ScalarType dtype, bool transposed) {
+  setThreads(state, 1);
+  const int64_t n = state.range(0);
+  auto a = makeTensor(CPU(dtype), {n, n}, transposed);
+  auto b = makeTensor(CPU(dtype), {n, n});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(a.mm(b));
+  }
+  setItemsProcessed(state, 2 * n * n * n);
+}
+
+static void gemmSizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n : {64, 256, 1024}) {
+    for (int64_t threads : {1, 4}) {
+      b->Args({n, threads});
+    }
+  }
+}
+
+BENCHMARK_CAPTURE(BM_Mm, float, kFloat, false)->Apply(gemmSizes);
+BENCHMARK_CAPTURE(BM_Mm, double, kDouble, false)->Apply(gemmSizes);
+BENCHMARK_CAPTURE(BM_Mm, float_transposed, kFloat, true)->Apply(gemmSizes);
+
+// A batch of 32 n x n products.
+static void BM_Bmm(benchmark::State& state) {
+  setThreads(state, 1);
+  const int64_t n = state.range(0);
+  auto a = makeTensor(CPU(kFloat), {32, n, n});
+  auto b = makeTensor(CPU(kFloat), {32, n, n});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(a.bmm(b));
+  }
+  setItemsProcessed(state, 32 * 2 * n * n * n);
+}
+BENCHMARK(BM_Bmm)->Args({16, 1})->Args({64, 1})->Args({64, 4});
+
+// A fully connected layer: a batch x 1024 input, 1024 x 1024 weights and a
+// bias.
+static void BM_Addmm(benchmark::State& state) {
+  setThreads(state, 1);
+  const int64_t batch = state.range(0);
+  auto x = makeTensor(CPU(kFloat), {batch, 1024});
+  auto w = makeTensor(CPU(kFloat), {1024, 1024});
+  auto bias = makeTensor(CPU(kFloat), {1024});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(bias.addmm(x, w));
+  }
+  setItemsProcessed(state, 2 * batch * 1024 * 1024);
+}
+BENCHMARK(BM_Addmm)->Args({1, 1})->Args({64, 1})->Args({64, 4});
+
+// Convolutions of a batch x channels x 56 x 56 input into as many channels,
+// with stride 1 and same padding. The arguments are the batch, the channels,
+// the kernel size, the groups and the number of threads.
+static void BM_Conv2d(benchmark::State& state) {
+  setThreads(state, 4);
+  const int64_t batch = state.range(0);
+  const int64_t channels = state.range(1);
+  const int64_t kernel = state.range(2);
+  const int64_t groups = state.range(3);
+  auto input = makeTensor(CPU(kFloat), {batch, channels, 56, 56});
+  auto weight =
+      makeTensor(CPU(kFloat), {channels, channels / groups, kernel, kernel});
+  auto bias = makeTensor(CPU(kFloat), {channels});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        at::conv2d(input, weight, bias, 1, kernel / 2, 1, groups));
+  }
+  setItemsProcessed(
+      state,
+      2 * batch * channels * (channels / groups) * kernel * kernel * 56 * 56);
+}
+BENCHMARK(BM_Conv2d)
+    ->Args({1, 64, 3, 1, 1})
+    ->Args({1, 64, 3, 1, 4})
+    ->Args({8, 64, 3, 1, 4})
+    ->Args({8, 64, 1, 1, 4})
+    ->Args({8, 64, 3, 64, 4});
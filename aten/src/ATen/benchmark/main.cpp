@@ -0,0 +1,5 @@
+#include "benchmark/benchmark.h"
+
+// The benchmarks register themselves; run with --benchmark_format=json (or
+// --benchmark_out=<file> --benchmark_out_format=json) to compare builds.
+BENCHMARK_MAIN();
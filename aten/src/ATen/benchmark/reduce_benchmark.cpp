@@ -0,0 +1,44 @@
+#include "benchmark_utils.h"
+
+using namespace at;
+using namespace at::benchmark_utils;
+
+// Reductions of a (size / 64) x 64 matrix, over all of it, its inner and its
+// outer dimension. The arguments are the number of elements and the number of
+// threads.
+
+template <typename F>
+static void BM_Reduce(
+    benchmark::State& state,
+    F op,
+    ScalarType dtype,
+    bool strided) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(dtype), {state.range(0) / 64, 64}, strided);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(op(x));
+  }
+  setItemsProcessed(state, x.numel());
+  setBytesProcessed(state, x.numel() * x.type().elementSizeInBytes());
+}
+
+#define REDUCE_BENCHMARK(name, expr)                                         \
+  static Tensor name##_op(const Tensor& x) {                                 \
+    return expr;                                                             \
+  }                                                                          \
+  BENCHMARK_CAPTURE(BM_Reduce, name##_float, name##_op, kFloat, false)       \
+      ->Apply(sizesAndThreads);                                              \
+  BENCHMARK_CAPTURE(BM_Reduce, name##_double, name##_op, kDouble, false)     \
+      ->Apply(sizesAndThreads);                                              \
+  BENCHMARK_CAPTURE(BM_Reduce, name##_float_strided, name##_op, kFloat, true) \
+      ->Apply(sizesAndThreads);
+
+REDUCE_BENCHMARK(sum_all, x.sum())
+REDUCE_BENCHMARK(sum_inner, x.sum(1))
+REDUCE_BENCHMARK(sum_outer, x.sum(0))
+REDUCE_BENCHMARK(mean_inner, x.mean(1))
+REDUCE_BENCHMARK(max_inner, std::get<0>(x.max(1)))
+REDUCE_BENCHMARK(norm_all, x.norm())
+REDUCE_BENCHMARK(softmax_inner, at::softmax(x, 1))
+
+#undef REDUCE_BENCHMARK
@@ -0,0 +1,40 @@
+#include "benchmark_utils.h"
+
+using namespace at;
+using namespace at::benchmark_utils;
+
+// Sorting and top-k along the last dimension of a rows x (size / rows)
+// matrix. The arguments are the number of elements and the number of
+// threads.
+
+static void sortSizes(benchmark::internal::Benchmark* b) {
+  for (int64_t size : {1 << 12, 1 << 18, 1 << 22}) {
+    for (int64_t threads : {1, 4}) {
+      b->Args({size, threads});
+    }
+  }
+}
+
+static void BM_Sort(benchmark::State& state, ScalarType dtype, int64_t rows) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(dtype), {rows, state.range(0) / rows});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(x.sort(1));
+  }
+  setItemsProcessed(state, x.numel());
+}
+BENCHMARK_CAPTURE(BM_Sort, float_1d, kFloat, 1)->Apply(sortSizes);
+BENCHMARK_CAPTURE(BM_Sort, float_rows, kFloat, 64)->Apply(sortSizes);
+BENCHMARK_CAPTURE(BM_Sort, long_rows, kLong, 64)->Apply(sortSizes);
+
+static void BM_Topk(benchmark::State& state, int64_t k, int64_t rows) {
+  setThreads(state, 1);
+  auto x = makeTensor(CPU(kFloat), {rows, state.range(0) / rows});
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(x.topk(k, 1));
+  }
+  setItemsProcessed(state, x.numel());
+}
+BENCHMARK_CAPTURE(BM_Topk, k10_1d, 10, 1)->Apply(sortSizes);
+BENCHMARK_CAPTURE(BM_Topk, k10_rows, 10, 64)->Apply(sortSizes);
+BENCHMARK_CAPTURE(BM_Topk, k1000_1d, 1000, 1)->Apply(sortSizes);
@@ -23,6 +23,12 @@ COPY = CodeTemplate("""\
 ${THTensor}_copy${cuda}${src_scalar_name}(${state,}self_->tensor, static_cast<${src_tensor}*>(src.pImpl)->tensor);
 """)
 
+# same-type CPU copies go through THTensor_copy, which has fast paths for
+# contiguous and transposed sources
+COPY_SAME_TYPE_CPU = CodeTemplate("""\
+${THTensor}_copy(self_->tensor, static_cast<${src_tensor}*>(src.pImpl)->tensor);
+""")
+
 COPY_ASYNC_CPU = CodeTemplate("""\
 if (non_blocking) {
     ${THTensor}_copyAsyncCPU(${state,}self_->tensor, static_cast<${src_tensor}*>(src.pImpl)->tensor);
@@ -66,6 +72,10 @@ def create_one(env, all_types):
         if env['Density'] == 'Sparse' or src_type['Density'] == 'Sparse':
             # skip sparse copies, which are not yet implemented
             continue
+        if ((env['Backend'] == 'CUDA' or src_type['Backend'] == 'CUDA') and
+                'BFloat16' in (env['ScalarName'], src_type['ScalarName'])):
+            # THC has no BFloat16 copies, these go through a CPU Float tensor
+            continue
         state = []
         cuda = ''
         if src_type['Backend'] == 'CUDA':
@@ -87,7 +97,11 @@ def create_one(env, all_types):
                 copies.append(COPY_ASYNC_CPU.substitute(combined))
             if env['Backend'] == 'CPU' and src_type['Backend'] == 'CUDA':
                 copies.append(COPY_ASYNC_CUDA.substitute(combined))
-        copies.append(COPY.substitute(combined))
+        if (env['ScalarType'] == src_type['ScalarType'] and
+                env['Backend'] == 'CPU' and src_type['Backend'] == 'CPU'):
+            copies.append(COPY_SAME_TYPE_CPU.substitute(combined))
+        else:
+            copies.append(COPY.substitute(combined))
 
         copy_body.append(CASE.substitute(combined, copies=copies))
     return FUNCTION.substitute(env, copy_body=copy_body)
@@ -6,6 +6,7 @@
 #include "vec256_float.h"
 #include "vec256_double.h"
 #include "vec256_int.h"
+#include "vec256_half.h"
 
 #include <algorithm>
 #include <cstddef>
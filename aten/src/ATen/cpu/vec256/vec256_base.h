@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <cstring>
 
 #if defined(__GNUC__)
@@ -61,6 +62,12 @@ struct Vec256 {
   Vec256<T> exp() const {
     return map(std::exp);
   }
+  // exp of inputs that are at most 0, like the x - max(x) of a softmax. The
+  // float specializations use cephes' expf polynomial (accurate to about 2
+  // ulp), which flushes results below FLT_MIN to 0.
+  Vec256<T> exp_nonpositive() const {
+    return map(std::exp);
+  }
   Vec256<T> log() const {
     return map(std::log);
   }
@@ -85,6 +92,32 @@ struct Vec256 {
   Vec256<T> sqrt() const {
     return map(std::sqrt);
   }
+  Vec256<T> erf() const {
+    return map(std::erf);
+  }
+  Vec256<T> expm1() const {
+    return map(std::expm1);
+  }
+  Vec256<T> log1p() const {
+    return map(std::log1p);
+  }
+  Vec256<T> rsqrt() const {
+    Vec256<T> ret;
+    for (int64_t i = 0; i != size; i++) {
+      ret.values[i] = 1 / std::sqrt(values[i]);
+    }
+    return ret;
+  }
+  Vec256<T> sigmoid() const {
+    Vec256<T> ret;
+    for (int64_t i = 0; i != size; i++) {
+      ret.values[i] = 1 / (1 + std::exp(-values[i]));
+    }
+    return ret;
+  }
+  Vec256<T> tanh() const {
+    return map(std::tanh);
+  }
 };
 
 template <class T> Vec256<T> operator+(const Vec256<T> &a, const Vec256<T> &b) {
@@ -95,6 +128,14 @@ template <class T> Vec256<T> operator+(const Vec256<T> &a, const Vec256<T> &b) {
   return c;
 }
 
+template <class T> Vec256<T> operator-(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = a.values[i] - b.values[i];
+  }
+  return c;
+}
+
 template <class T> Vec256<T> operator*(const Vec256<T> &a, const Vec256<T> &b) {
   Vec256<T> c = Vec256<T>();
   for (int i = 0; i != c.size; i++) {
@@ -103,4 +144,14 @@ template <class T> Vec256<T> operator*(const Vec256<T> &a, const Vec256<T> &b) {
   return c;
 }
 
+// a > b ? a : b in every lane, which is b when either is NaN (like
+// _mm256_max_ps)
+template <class T> Vec256<T> maximum(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = a.values[i] > b.values[i] ? a.values[i] : b.values[i];
+  }
+  return c;
+}
+
 }}}
@@ -57,6 +57,9 @@ public:
   Vec256<double> exp() const {
     return map(std::exp);
   }
+  Vec256<double> exp_nonpositive() const {
+    return map(std::exp);
+  }
   Vec256<double> log() const {
     return map(std::log);
   }
@@ -81,6 +84,24 @@ public:
   Vec256<double> sqrt() const {
     return _mm256_sqrt_pd(values);
   }
+  Vec256<double> erf() const {
+    return map(std::erf);
+  }
+  Vec256<double> expm1() const {
+    return map(std::expm1);
+  }
+  Vec256<double> log1p() const {
+    return map(std::log1p);
+  }
+  Vec256<double> rsqrt() const {
+    return _mm256_div_pd(_mm256_set1_pd(1), _mm256_sqrt_pd(values));
+  }
+  Vec256<double> sigmoid() const {
+    return map([](double x) { return 1 / (1 + std::exp(-x)); });
+  }
+  Vec256<double> tanh() const {
+    return map(std::tanh);
+  }
 };
 
 template <>
@@ -88,6 +109,16 @@ Vec256<double> inline operator+(const Vec256<double>& a, const Vec256<double>& b
   return _mm256_add_pd(a, b);
 }
 
+template <>
+Vec256<double> inline operator-(const Vec256<double>& a, const Vec256<double>& b) {
+  return _mm256_sub_pd(a, b);
+}
+
+template <>
+Vec256<double> inline maximum(const Vec256<double>& a, const Vec256<double>& b) {
+  return _mm256_max_pd(a, b);
+}
+
 template <>
 Vec256<double> inline operator*(const Vec256<double>& a, const Vec256<double>& b) {
   return _mm256_mul_pd(a, b);
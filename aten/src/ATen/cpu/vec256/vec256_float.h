@@ -2,6 +2,9 @@
 
 #include "intrinsics.h"
 #include "vec256_base.h"
+#if defined(__AVX2__)
+#include "ATen/native/cpu/avx_mathfun.h"
+#endif
 
 namespace at {
 namespace vec256 {
@@ -81,6 +84,71 @@ public:
   Vec256<float> sqrt() const {
     return _mm256_sqrt_ps(values);
   }
+  Vec256<float> erf() const {
+    return map(std::erf);
+  }
+  Vec256<float> expm1() const {
+    return map(std::expm1);
+  }
+  Vec256<float> log1p() const {
+    return map(std::log1p);
+  }
+  Vec256<float> rsqrt() const {
+    // _mm256_rsqrt_ps is only accurate to 12 bits
+    return _mm256_div_ps(_mm256_set1_ps(1), _mm256_sqrt_ps(values));
+  }
+#if defined(__AVX2__)
+  Vec256<float> sigmoid() const {
+    auto one = _mm256_set1_ps(1);
+    auto neg = _mm256_xor_ps(_mm256_set1_ps(-0.f), values);
+    auto ret = _mm256_div_ps(one, _mm256_add_ps(one, exp256_ps(neg)));
+    return keep_nan(ret);
+  }
+  // Same approximation as cephes' tanhf: an odd polynomial for small inputs
+  // and 1 - 2 / (exp(2|x|) + 1) with the sign of x restored for the others.
+  Vec256<float> tanh() const {
+    auto sign_mask = _mm256_set1_ps(-0.f);
+    auto one = _mm256_set1_ps(1);
+    auto sign = _mm256_and_ps(sign_mask, values);
+    auto ax = _mm256_andnot_ps(sign_mask, values);
+
+    auto z = _mm256_mul_ps(values, values);
+    auto p = _mm256_set1_ps(-5.70498872745E-3f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(2.06390887954E-2f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(-5.37397155531E-2f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.33314422036E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(-3.33332819422E-1f));
+    auto small = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, z), values), values);
+
+    auto e = exp256_ps(_mm256_add_ps(ax, ax));
+    auto large = _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2), _mm256_add_ps(e, one)));
+    large = _mm256_or_ps(large, sign);
+
+    auto is_small = _mm256_cmp_ps(ax, _mm256_set1_ps(0.625f), _CMP_LT_OQ);
+    return keep_nan(_mm256_blendv_ps(large, small, is_small));
+  }
+  Vec256<float> exp_nonpositive() const {
+    // exp256_ps clamps its input to -88.38, below which exp is denormal
+    auto is_tiny = _mm256_cmp_ps(values, _mm256_set1_ps(-88.3762626647949f), _CMP_LT_OQ);
+    return keep_nan(_mm256_andnot_ps(is_tiny, exp256_ps(values)));
+  }
+#else
+  Vec256<float> sigmoid() const {
+    return map([](float x) { return 1 / (1 + std::exp(-x)); });
+  }
+  Vec256<float> tanh() const {
+    return map(std::tanh);
+  }
+  Vec256<float> exp_nonpositive() const {
+    return map(std::exp);
+  }
+#endif
+private:
+  // exp256_ps clamps its input, so NaNs have to be put back explicitly
+  Vec256<float> keep_nan(__m256 ret) const {
+    auto is_nan = _mm256_cmp_ps(values, values, _CMP_UNORD_Q);
+    return _mm256_blendv_ps(ret, values, is_nan);
+  }
 };
 
 template <>
@@ -88,6 +156,16 @@ Vec256<float> inline operator+(const Vec256<float>& a, const Vec256<float>& b) {
   return _mm256_add_ps(a, b);
 }
 
+template <>
+Vec256<float> inline operator-(const Vec256<float>& a, const Vec256<float>& b) {
+  return _mm256_sub_ps(a, b);
+}
+
+template <>
+Vec256<float> inline maximum(const Vec256<float>& a, const Vec256<float>& b) {
+  return _mm256_max_ps(a, b);
+}
+
 template <>
 Vec256<float> inline operator*(const Vec256<float>& a, const Vec256<float>& b) {
   return _mm256_mul_ps(a, b);
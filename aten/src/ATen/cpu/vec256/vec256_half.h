@@ -0,0 +1,47 @@
+#pragma once
+
+#include "intrinsics.h"
+#include "ATen/Half.h"
+
+#include <cstdint>
+
+// Conversions of contiguous arrays between Half and float, eight values at a
+// time with the F16C instructions when the including kernel is compiled for
+// them (the AVX2 and AVX512 capabilities), and one at a time otherwise. Both
+// round to the nearest even half.
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define AT_VEC256_HAVE_F16C
+#endif
+
+namespace at {
+namespace vec256 {
+namespace {
+
+inline void convert_to_float(const Half* src, float* dst, int64_t n) {
+  int64_t i = 0;
+#ifdef AT_VEC256_HAVE_F16C
+  for (; i + 8 <= n; i += 8) {
+    __m128i half_values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half_values));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = convert<float, Half>(src[i]);
+  }
+}
+
+inline void convert_to_half(const float* src, Half* dst, int64_t n) {
+  int64_t i = 0;
+#ifdef AT_VEC256_HAVE_F16C
+  for (; i + 8 <= n; i += 8) {
+    __m128i half_values = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), half_values);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = convert<Half, float>(src[i]);
+  }
+}
+
+}}}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+#include "vec512_base.h"
+
+namespace at {
+namespace vec512 {
+namespace {
+
+#ifdef __AVX512F__
+
+template <> class Vec512<double> {
+public:
+  static constexpr int size = 8;
+  __m512d values;
+  Vec512() {}
+  Vec512(__m512d v) : values(v) {}
+  Vec512(double val) {
+    values = _mm512_set1_pd(val);
+  }
+  operator __m512d() const {
+    return values;
+  }
+  void load(const void *ptr) {
+    values = _mm512_loadu_pd(reinterpret_cast<const double*>(ptr));
+  }
+  void load_partial(const void *ptr, int count) {
+    auto mask = static_cast<__mmask8>((1 << count) - 1);
+    values = _mm512_maskz_loadu_pd(mask, ptr);
+  }
+  static Vec512<double> s_load(const void* ptr) {
+    Vec512<double> vec;
+    vec.load(ptr);
+    return vec;
+  }
+  void store(void *ptr) const {
+    _mm512_storeu_pd(reinterpret_cast<double*>(ptr), values);
+  }
+  void store_partial(void* ptr, int count) const {
+    auto mask = static_cast<__mmask8>((1 << count) - 1);
+    _mm512_mask_storeu_pd(ptr, mask, values);
+  }
+  Vec512<double> map(double (*f)(double)) const {
+    __at_align64__ double tmp[8];
+    store(tmp);
+    for (int64_t i = 0; i < 8; i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return s_load(tmp);
+  }
+  Vec512<double> abs() const {
+    // _mm512_andnot_pd needs AVX512DQ, clear the sign bit as an integer
+    auto mask = _mm512_set1_epi64(0x7fffffffffffffffLL);
+    return _mm512_castsi512_pd(_mm512_and_si512(mask, _mm512_castpd_si512(values)));
+  }
+  Vec512<double> exp() const {
+    return map(std::exp);
+  }
+  Vec512<double> exp_nonpositive() const {
+    return map(std::exp);
+  }
+  Vec512<double> log() const {
+    return map(std::log);
+  }
+  Vec512<double> sin() const {
+    return map(std::sin);
+  }
+  Vec512<double> cos() const {
+    return map(std::cos);
+  }
+  Vec512<double> ceil() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> floor() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> round() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> trunc() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> sqrt() const {
+    return _mm512_sqrt_pd(values);
+  }
+  Vec512<double> erf() const {
+    return map(std::erf);
+  }
+  Vec512<double> expm1() const {
+    return map(std::expm1);
+  }
+  Vec512<double> log1p() const {
+    return map(std::log1p);
+  }
+  Vec512<double> rsqrt() const {
+    return _mm512_div_pd(_mm512_set1_pd(1), _mm512_sqrt_pd(values));
+  }
+  Vec512<double> sigmoid() const {
+    return map([](double x) { return 1 / (1 + std::exp(-x)); });
+  }
+  Vec512<double> tanh() const {
+    return map(std::tanh);
+  }
+};
+
+template <>
+Vec512<double> inline operator+(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_add_pd(a, b);
+}
+
+template <>
+Vec512<double> inline operator-(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_sub_pd(a, b);
+}
+
+template <>
+Vec512<double> inline maximum(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_max_pd(a, b);
+}
+
+template <>
+Vec512<double> inline operator*(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_mul_pd(a, b);
+}
+
+#endif
+
+}}}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+#include "vec512_base.h"
+
+namespace at {
+namespace vec512 {
+namespace {
+
+#ifdef __AVX512F__
+
+template <> class Vec512<float> {
+public:
+  static constexpr int size = 16;
+  __m512 values;
+  Vec512() {}
+  Vec512(__m512 v) : values(v) {}
+  Vec512(float val) {
+    values = _mm512_set1_ps(val);
+  }
+  operator __m512() const {
+    return values;
+  }
+  void load(const void *ptr) {
+    values = _mm512_loadu_ps(reinterpret_cast<const float*>(ptr));
+  }
+  void load_partial(const void *ptr, int count) {
+    auto mask = static_cast<__mmask16>((1 << count) - 1);
+    values = _mm512_maskz_loadu_ps(mask, ptr);
+  }
+  static Vec512<float> s_load(const void* ptr) {
+    Vec512<float> vec;
+    vec.load(ptr);
+    return vec;
+  }
+  void store(void *ptr) const {
+    _mm512_storeu_ps(reinterpret_cast<float*>(ptr), values);
+  }
+  void store_partial(void* ptr, int count) const {
+    auto mask = static_cast<__mmask16>((1 << count) - 1);
+    _mm512_mask_storeu_ps(ptr, mask, values);
+  }
+  Vec512<float> map(float (*f)(float)) const {
+    __at_align64__ float tmp[16];
+    store(tmp);
+    for (int64_t i = 0; i < 16; i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return s_load(tmp);
+  }
+  Vec512<float> abs() const {
+    // _mm512_andnot_ps needs AVX512DQ, clear the sign bit as an integer
+    auto mask = _mm512_set1_epi32(0x7fffffff);
+    return _mm512_castsi512_ps(_mm512_and_si512(mask, _mm512_castps_si512(values)));
+  }
+  Vec512<float> exp() const {
+    return map(std::exp);
+  }
+  Vec512<float> log() const {
+    return map(std::log);
+  }
+  Vec512<float> sin() const {
+    return map(std::sin);
+  }
+  Vec512<float> cos() const {
+    return map(std::cos);
+  }
+  Vec512<float> ceil() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> floor() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> round() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> trunc() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> sqrt() const {
+    return _mm512_sqrt_ps(values);
+  }
+  Vec512<float> erf() const {
+    return map(std::erf);
+  }
+  Vec512<float> expm1() const {
+    return map(std::expm1);
+  }
+  Vec512<float> log1p() const {
+    return map(std::log1p);
+  }
+  Vec512<float> rsqrt() const {
+    // _mm512_rsqrt14_ps is only accurate to 14 bits
+    return _mm512_div_ps(_mm512_set1_ps(1), _mm512_sqrt_ps(values));
+  }
+  Vec512<float> sigmoid() const {
+    auto one = _mm512_set1_ps(1);
+    auto neg = _mm512_sub_ps(_mm512_setzero_ps(), values);
+    auto ret = _mm512_div_ps(one, _mm512_add_ps(one, exp512_ps(neg)));
+    return keep_nan(ret);
+  }
+  // Same approximation as Vec256<float>::tanh
+  Vec512<float> tanh() const {
+    auto one = _mm512_set1_ps(1);
+    auto ax = abs().values;
+    auto sign = _mm512_xor_si512(_mm512_castps_si512(values), _mm512_castps_si512(ax));
+
+    auto z = _mm512_mul_ps(values, values);
+    auto p = _mm512_set1_ps(-5.70498872745E-3f);
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(2.06390887954E-2f));
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(-5.37397155531E-2f));
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(1.33314422036E-1f));
+    p = _mm512_fmadd_ps(p, z, _mm512_set1_ps(-3.33332819422E-1f));
+    auto small = _mm512_fmadd_ps(_mm512_mul_ps(p, z), values, values);
+
+    auto e = exp512_ps(_mm512_add_ps(ax, ax));
+    auto large = _mm512_sub_ps(one, _mm512_div_ps(_mm512_set1_ps(2), _mm512_add_ps(e, one)));
+    large = _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(large), sign));
+
+    auto is_small = _mm512_cmp_ps_mask(ax, _mm512_set1_ps(0.625f), _CMP_LT_OQ);
+    return keep_nan(_mm512_mask_blend_ps(is_small, large, small));
+  }
+  Vec512<float> exp_nonpositive() const {
+    // exp512_ps clamps its input to -88.38, below which exp is denormal
+    auto is_tiny = _mm512_cmp_ps_mask(values, _mm512_set1_ps(-88.3762626647949f), _CMP_LT_OQ);
+    return keep_nan(_mm512_mask_blend_ps(is_tiny, exp512_ps(values), _mm512_setzero_ps()));
+  }
+private:
+  // exp512_ps clamps its input, so NaNs have to be put back explicitly
+  Vec512<float> keep_nan(__m512 ret) const {
+    auto is_nan = _mm512_cmp_ps_mask(values, values, _CMP_UNORD_Q);
+    return _mm512_mask_blend_ps(is_nan, ret, values);
+  }
+  // cephes expf, as exp256_ps in native/cpu/avx_mathfun.h
+  static __m512 exp512_ps(__m512 x) {
+    x = _mm512_min_ps(x, _mm512_set1_ps(88.3762626647949f));
+    x = _mm512_max_ps(x, _mm512_set1_ps(-88.3762626647949f));
+
+    // express exp(x) as exp(g + n*log(2))
+    auto fx = _mm512_fmadd_ps(x, _mm512_set1_ps(1.44269504088896341f), _mm512_set1_ps(0.5f));
+    fx = _mm512_roundscale_ps(fx, (_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(0.693359375f), x);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(-2.12194440e-4f), x);
+
+    auto z = _mm512_mul_ps(x, x);
+    auto y = _mm512_set1_ps(1.9875691500E-4f);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.3981999507E-3f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(8.3334519073E-3f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(4.1665795894E-2f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.6666665459E-1f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(5.0000001201E-1f));
+    y = _mm512_add_ps(_mm512_fmadd_ps(y, z, x), _mm512_set1_ps(1));
+
+    // build 2^n
+    auto n = _mm512_add_epi32(_mm512_cvttps_epi32(fx), _mm512_set1_epi32(0x7f));
+    auto pow2n = _mm512_castsi512_ps(_mm512_slli_epi32(n, 23));
+    return _mm512_mul_ps(y, pow2n);
+  }
+};
+
+template <>
+Vec512<float> inline operator+(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_add_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator-(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_sub_ps(a, b);
+}
+
+template <>
+Vec512<float> inline maximum(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_max_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator*(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_mul_ps(a, b);
+}
+
+#endif
+
+}}}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace at { namespace native {
+
+// The algorithms picked for cudnn_convolution and its backward functions are
+// cached by convolution parameters (see BenchmarkCache in Conv.cpp).
+
+// Writes the cached algorithms to a file, tagged with the cuDNN version and
+// the name of the current GPU.
+void cudnn_save_benchmark_cache(const std::string& path);
+
+// Adds the algorithms of a file written by cudnn_save_benchmark_cache to the
+// cache, replacing the entries for the same parameters, and returns how many
+// there were. Files of another cuDNN version or GPU model add nothing.
+int64_t cudnn_load_benchmark_cache(const std::string& path);
+
+}}  // namespace at::native
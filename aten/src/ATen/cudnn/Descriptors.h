@@ -186,7 +186,10 @@ struct ConvolutionDescriptor
                       &cudnnCreateConvolutionDescriptor,
                       &cudnnDestroyConvolutionDescriptor>
 {
-  void set(cudnnDataType_t dataType, int dim, int* pad, int* stride, int * upscale /* aka dilation */, int groups) {
+  // allow_tensor_op_float lets float convolutions use tensor cores, rounding
+  // their inputs to half precision (cuDNN 7.2 and later)
+  void set(cudnnDataType_t dataType, int dim, int* pad, int* stride, int * upscale /* aka dilation */, int groups,
+           bool allow_tensor_op_float = false) {
     cudnnDataType_t mathType = dataType;
     if (dataType == CUDNN_DATA_HALF) mathType = CUDNN_DATA_FLOAT;
     CUDNN_CHECK(cudnnSetConvolutionNdDescriptor(mut_desc(), dim, pad, stride, upscale,
@@ -196,6 +199,10 @@ struct ConvolutionDescriptor
     CUDNN_CHECK(cudnnSetConvolutionMathType(mut_desc(), CUDNN_DEFAULT_MATH));
     if(dataType == CUDNN_DATA_HALF)
       CUDNN_CHECK(cudnnSetConvolutionMathType(mut_desc(), CUDNN_TENSOR_OP_MATH));
+#if CUDNN_VERSION >= 7200
+    if(dataType == CUDNN_DATA_FLOAT && allow_tensor_op_float)
+      CUDNN_CHECK(cudnnSetConvolutionMathType(mut_desc(), CUDNN_TENSOR_OP_MATH_ALLOW_CONVERSION));
+#endif
 #endif
   }
 };
@@ -289,7 +296,8 @@ struct RNNDescriptor
   DropoutDescriptor dropout_desc_;
   void set(cudnnHandle_t handle, int hidden_size, int num_layers, DropoutDescriptor&& dropout_desc,
            cudnnRNNInputMode_t input_mode, cudnnDirectionMode_t bidirectional,
-           cudnnRNNMode_t mode, cudnnDataType_t datatype) {
+           cudnnRNNMode_t mode, cudnnDataType_t datatype,
+           cudnnRNNAlgo_t algo = CUDNN_RNN_ALGO_STANDARD) {
     dropout_desc_ = std::move(dropout_desc);
     CUDNN_CHECK(cudnnSetRNNDescriptor_v6(
           handle,
@@ -300,7 +308,7 @@ struct RNNDescriptor
           input_mode,
           bidirectional,
           mode,
-          CUDNN_RNN_ALGO_STANDARD,
+          algo,
           datatype));
 #if CUDNN_VERSION >= 7000 && CUDA_VERSION >= 9000
     cudaDeviceProp* prop = globalContext().getCurrentDeviceProperties();
@@ -317,6 +325,24 @@ struct RNNDescriptor
   }
 };
 
+#if CUDNN_VERSION >= 7201
+// Describes the whole input or output sequence of an RNN at once, for the
+// cudnnRNN*Ex functions.  seq_lengths holds the length of each of the
+// batch_size sequences.
+struct RNNDataDescriptor
+  : public Descriptor<cudnnRNNDataStruct,
+                      &cudnnCreateRNNDataDescriptor,
+                      &cudnnDestroyRNNDataDescriptor>
+{
+  void set(cudnnDataType_t datatype, cudnnRNNDataLayout_t layout, int max_seq_length,
+           int batch_size, int vector_size, const int* seq_lengths) {
+    CUDNN_CHECK(cudnnSetRNNDataDescriptor(
+          mut_desc(), datatype, layout, max_seq_length, batch_size, vector_size,
+          seq_lengths, nullptr /* paddingFill */));
+  }
+};
+#endif
+
 union Constant
 {
   float f;
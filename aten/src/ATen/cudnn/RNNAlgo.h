@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+namespace at { namespace native {
+
+// How _cudnn_rnn picks the cuDNN RNN algorithm:
+//
+//   "auto"            persistent kernels (CUDNN_RNN_ALGO_PERSIST_STATIC)
+//                     for the small batches and hidden sizes they are
+//                     faster at, the standard algorithm otherwise (default)
+//   "standard"        always CUDNN_RNN_ALGO_STANDARD
+//   "persist_static"  persistent kernels whenever cuDNN supports them
+//
+// Persistent kernels need a device of compute capability 6.0 or higher and
+// don't take packed sequences, which always use the standard algorithm.
+// TORCH_CUDNN_RNN_ALGO sets the initial value.  The backward of an RNN
+// must use the algorithm of its forward, so don't change it while there
+// are RNN graphs left to differentiate.
+std::string getCudnnRNNAlgo();
+void setCudnnRNNAlgo(const std::string& algo);
+
+}}  // namespace at::native
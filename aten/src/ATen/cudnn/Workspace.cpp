@@ -0,0 +1,120 @@
+#include "Workspace.h"
+
+#include "Exceptions.h"
+
+#include <ATen/ATen.h>
+#include "THC/THC.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace at { namespace native {
+
+struct CudnnWorkspace::Buffer {
+  void* data = nullptr;
+  size_t size = 0;
+  bool borrowed = false;
+};
+
+namespace {
+
+std::mutex mutex;
+// by device and stream; never erased, so that the pointers stay valid
+std::map<std::pair<int, cudaStream_t>, CudnnWorkspace::Buffer> buffers;
+
+size_t limitFromEnv() {
+  const char* env = getenv("TORCH_CUDNN_WORKSPACE_LIMIT_MB");
+  if (!env) {
+    return SIZE_MAX;
+  }
+  return (size_t)strtoull(env, NULL, 10) << 20;
+}
+
+std::atomic<size_t>& workspaceLimit() {
+  static std::atomic<size_t> limit(limitFromEnv());
+  return limit;
+}
+
+}  // namespace
+
+CudnnWorkspace::CudnnWorkspace(size_t size)
+  : size(size), data(nullptr), buffer(nullptr) {
+  if (size == 0) {
+    return;
+  }
+  THCState* state = globalContext().lazyInitCUDA();
+  int device;
+  CUDA_CHECK(cudaGetDevice(&device));
+  cudaStream_t stream = THCState_getCurrentStream(state);
+
+  std::lock_guard<std::mutex> guard(mutex);
+  Buffer& shared = buffers[std::make_pair(device, stream)];
+  if (shared.borrowed) {
+    CUDA_CHECK(THCudaMalloc(state, &data, size));
+    return;
+  }
+  if (shared.size < size) {
+    // the old buffer goes back to the caching allocator first, which can
+    // hand it out again as part of the new one
+    if (shared.data) {
+      THCudaFree(state, shared.data);
+      shared.data = nullptr;
+      shared.size = 0;
+    }
+    CUDA_CHECK(THCudaMalloc(state, &shared.data, size));
+    shared.size = size;
+  }
+  shared.borrowed = true;
+  buffer = &shared;
+  data = shared.data;
+}
+
+CudnnWorkspace::CudnnWorkspace(CudnnWorkspace&& other)
+  : size(other.size), data(other.data), buffer(other.buffer) {
+  other.size = 0;
+  other.data = nullptr;
+  other.buffer = nullptr;
+}
+
+CudnnWorkspace::~CudnnWorkspace() {
+  if (buffer) {
+    std::lock_guard<std::mutex> guard(mutex);
+    buffer->borrowed = false;
+  } else if (data) {
+    THCudaFree(globalContext().lazyInitCUDA(), data);
+  }
+}
+
+size_t getCudnnWorkspaceLimit() {
+  return workspaceLimit().load();
+}
+
+void setCudnnWorkspaceLimit(size_t bytes) {
+  workspaceLimit() = bytes;
+}
+
+void releaseCudnnWorkspaces() {
+  std::lock_guard<std::mutex> guard(mutex);
+  if (buffers.empty()) {
+    return;
+  }
+  THCState* state = globalContext().lazyInitCUDA();
+  int prev_device;
+  CUDA_CHECK(cudaGetDevice(&prev_device));
+  for (auto& entry : buffers) {
+    Buffer& shared = entry.second;
+    if (shared.data && !shared.borrowed) {
+      CUDA_CHECK(cudaSetDevice(entry.first.first));
+      THCudaFree(state, shared.data);
+      shared.data = nullptr;
+      shared.size = 0;
+    }
+  }
+  CUDA_CHECK(cudaSetDevice(prev_device));
+}
+
+}}  // namespace at::native
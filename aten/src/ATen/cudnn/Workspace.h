@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+namespace at { namespace native {
+
+// Scratch memory for a cuDNN call, borrowed from a buffer kept for each
+// device and stream. Calls on a stream run one after the other, so they can
+// all share its buffer, which only grows, up to the largest workspace asked
+// for. A workspace asked for while the buffer is borrowed by another thread
+// is allocated for the call alone. Either way, the memory comes from
+// THCudaMalloc on the current device and stream.
+struct CudnnWorkspace {
+  explicit CudnnWorkspace(size_t size);
+  CudnnWorkspace(const CudnnWorkspace&) = delete;
+  CudnnWorkspace(CudnnWorkspace&& other);
+  CudnnWorkspace& operator=(const CudnnWorkspace&) = delete;
+  ~CudnnWorkspace();
+
+  size_t size;
+  void* data;
+
+private:
+  struct Buffer;
+  Buffer* buffer;  // the shared buffer if borrowed, NULL if data is our own
+};
+
+// The largest workspace the algorithm selection of cuDNN convolutions
+// picks, SIZE_MAX (no limit) by default, or TORCH_CUDNN_WORKSPACE_LIMIT_MB
+// megabytes. The default algorithms are used when nothing faster fits.
+size_t getCudnnWorkspaceLimit();
+void setCudnnWorkspaceLimit(size_t bytes);
+
+// Frees the buffers which aren't borrowed, e.g. before emptying the cache of
+// the caching allocator.
+void releaseCudnnWorkspaces();
+
+}}  // namespace at::native
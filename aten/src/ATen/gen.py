@@ -155,6 +155,7 @@ scalar_types = [
     ('Long', 'int64_t', 'Long', 'int64_t', False),
     ('Short', 'int16_t', 'Long', 'int16_t', False),
     ('Half', 'Half', 'Double', 'THHalf', True),
+    ('BFloat16', 'BFloat16', 'Double', 'THBFloat16', True),
 ]
 
 # shared environment for non-derived base classes Type.h Tensor.h Storage.h
@@ -287,6 +288,10 @@ def generate_storage_type_and_tensor(backend, density, scalar_type, declarations
         else:
             env['to_th_type'] = 'HalfFix<THHalf,Half>'
             env['to_at_type'] = 'HalfFix<Half,THHalf>'
+    elif scalar_name == "BFloat16":
+        env['SparseTensor'] = 'Tensor'
+        env['to_th_type'] = 'HalfFix<THBFloat16,BFloat16>'
+        env['to_at_type'] = 'HalfFix<BFloat16,THBFloat16>'
     elif scalar_name == 'Long':
         env['to_th_type'] = 'long'
         env['to_at_type'] = 'int64_t'
@@ -333,6 +338,9 @@ def iterate_types():
                 if density == 'Sparse' and scalar_type[0] == 'Half':
                     # THS does not do half type yet.
                     continue
+                if scalar_type[0] == 'BFloat16' and (backend == 'CUDA' or density == 'Sparse'):
+                    # BFloat16 is a CPU dense storage type, THC and THS don't have it
+                    continue
                 yield (backend, density, scalar_type)
 
 
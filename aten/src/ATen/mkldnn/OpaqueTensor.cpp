@@ -0,0 +1,288 @@
+#include <ATen/mkldnn/OpaqueTensor.h>
+#include <ATen/native/MemoryFormat.h>
+
+#include <algorithm>
+
+namespace at { namespace native {
+
+namespace {
+
+const auto data_t = memory::data_type::f32;
+
+memory::dims to_dims(IntList sizes) {
+  return memory::dims(sizes.begin(), sizes.end());
+}
+
+// The primitive desc of an activation in any format, which lets the
+// primitive pick its preferred one
+memory::desc any_desc(IntList sizes) {
+  return memory::desc(to_dims(sizes), data_t, memory::format::any);
+}
+
+memory::desc desc_of(const MKLDNNTensor& tensor) {
+  return tensor.primitive_desc().desc();
+}
+
+void check_input(const MKLDNNTensor& input, const char* name) {
+  if (!input.defined()) {
+    AT_ERROR("%s: expected a defined input", name);
+  }
+}
+
+// Wraps a contiguous 1-d float tensor, e.g. a bias or running mean
+memory dense_vector(const Tensor& tensor, const memory::primitive_desc& pd) {
+  if (!tensor.is_contiguous() || tensor.type().scalarType() != kFloat) {
+    AT_ERROR("expected a contiguous float tensor");
+  }
+  return memory(pd, tensor.data_ptr());
+}
+
+void submit(std::vector<primitive>& net) {
+  Stream::Instance().get_stream().submit(net);
+}
+
+std::vector<int64_t> pool_output_size(
+    const MKLDNNTensor& input, IntList kernel_size, IntList stride, IntList padding) {
+  if (kernel_size.size() != 2 || stride.size() != 2 || padding.size() != 2) {
+    AT_ERROR("mkldnn pooling: expected 2 kernel sizes, strides and paddings");
+  }
+  std::vector<int64_t> output_size(input.sizes().begin(), input.sizes().end());
+  for (int d = 0; d < 2; ++d) {
+    output_size[d + 2] =
+        (input.size(d + 2) + 2 * padding[d] - kernel_size[d]) / stride[d] + 1;
+  }
+  return output_size;
+}
+
+MKLDNNTensor pool2d(
+    const MKLDNNTensor& input, IntList kernel_size, IntList stride, IntList padding,
+    algorithm alg) {
+  check_input(input, "mkldnn pooling");
+  auto output_size = pool_output_size(input, kernel_size, stride, padding);
+  auto cpu_engine = CpuEngine::Instance().get_engine();
+  pooling_forward::desc desc(prop_kind::forward_inference, alg,
+    desc_of(input), any_desc(output_size),
+    to_dims(stride), to_dims(kernel_size), to_dims(padding), to_dims(padding),
+    padding_kind::zero);
+  pooling_forward::primitive_desc pd(desc, cpu_engine);
+
+  std::vector<primitive> net;
+  auto input_memory = input.reorder_to(pd.src_primitive_desc(), net);
+  MKLDNNTensor output(pd.dst_primitive_desc(), output_size);
+  net.push_back(pooling_forward(pd, input_memory, output.get_memory()));
+  submit(net);
+  return output;
+}
+
+} // anonymous namespace
+
+MKLDNNTensor::MKLDNNTensor(const Tensor& dense) {
+  if (dense.type().backend() != kCPU || dense.type().scalarType() != kFloat ||
+      dense.dim() != 4) {
+    AT_ERROR("MKLDNNTensor: expected a 4-d float CPU tensor, got a %lld-d %s",
+             (long long)dense.dim(), dense.type().toString());
+  }
+  auto format = memory::format::nhwc;
+  dense_ = dense;
+  if (!is_channels_last(dense)) {
+    format = memory::format::nchw;
+    dense_ = dense.contiguous();
+  }
+  sizes_ = dense.sizes().vec();
+  auto cpu_engine = CpuEngine::Instance().get_engine();
+  memory_ = std::make_shared<memory>(
+    memory::primitive_desc({to_dims(sizes_), data_t, format}, cpu_engine),
+    dense_.data_ptr());
+}
+
+MKLDNNTensor::MKLDNNTensor(const memory::primitive_desc& pd, IntList sizes)
+  : memory_(std::make_shared<memory>(pd))
+  , sizes_(sizes.vec()) {}
+
+Tensor MKLDNNTensor::to_dense() const {
+  if (!defined()) {
+    return Tensor();
+  }
+  auto dense = CPU(kFloat).tensor(sizes_);
+  auto cpu_engine = CpuEngine::Instance().get_engine();
+  memory dense_memory(
+    {{to_dims(sizes_), data_t, memory::format::nchw}, cpu_engine}, dense.data_ptr());
+  std::vector<primitive> net;
+  net.push_back(reorder(*memory_, dense_memory));
+  submit(net);
+  return dense;
+}
+
+memory MKLDNNTensor::reorder_to(
+    const memory::primitive_desc& pd, std::vector<primitive>& net) const {
+  if (memory_->get_primitive_desc() == pd) {
+    return *memory_;
+  }
+  memory reordered(pd);
+  net.push_back(reorder(*memory_, reordered));
+  return reordered;
+}
+
+MKLDNNConvWeight::MKLDNNConvWeight(
+    const Tensor& weight, const Tensor& bias,
+    IntList padding, IntList stride, IntList dilation)
+  : weight_(weight.contiguous())
+  , padding_(padding.vec())
+  , stride_(stride.vec()) {
+  if (weight.type().backend() != kCPU || weight.type().scalarType() != kFloat ||
+      weight.dim() != 4) {
+    AT_ERROR("MKLDNNConvWeight: expected a 4-d float CPU weight");
+  }
+  if (padding.size() != 2 || stride.size() != 2 || dilation.size() != 2) {
+    AT_ERROR("MKLDNNConvWeight: expected 2 paddings, strides and dilations");
+  }
+  for (auto d : dilation) {
+    if (d != 1) {
+      AT_ERROR("MKLDNNConvWeight: dilated convolutions are not supported");
+    }
+  }
+  if (bias.defined()) {
+    bias_ = bias.contiguous();
+  }
+}
+
+MKLDNNTensor mkldnn_conv2d(const MKLDNNTensor& input, MKLDNNConvWeight& weight) {
+  check_input(input, "mkldnn_conv2d");
+  const auto& w = weight.weight_;
+  if (input.sizes().size() != 4 || input.size(1) != w.size(1)) {
+    AT_ERROR("mkldnn_conv2d: expected a 4-d input with %lld channels",
+             (long long)w.size(1));
+  }
+  std::vector<int64_t> output_size = {input.size(0), w.size(0), 0, 0};
+  for (int d = 0; d < 2; ++d) {
+    output_size[d + 2] = (input.size(d + 2) + 2 * weight.padding_[d]
+                          - w.size(d + 2)) / weight.stride_[d] + 1;
+  }
+  auto cpu_engine = CpuEngine::Instance().get_engine();
+  auto stride = to_dims(weight.stride_);
+  auto padding = to_dims(weight.padding_);
+
+  // the input keeps its format if the primitive reads it, which is the case
+  // of the output of another convolution
+  std::shared_ptr<convolution_forward::desc> desc;
+  if (weight.bias_.defined()) {
+    desc.reset(new convolution_forward::desc(prop_kind::forward_inference,
+      convolution_direct, any_desc(input.sizes()), any_desc(w.sizes()),
+      any_desc({w.size(0)}), any_desc(output_size),
+      stride, padding, padding, padding_kind::zero));
+  } else {
+    desc.reset(new convolution_forward::desc(prop_kind::forward_inference,
+      convolution_direct, any_desc(input.sizes()), any_desc(w.sizes()),
+      any_desc(output_size),
+      stride, padding, padding, padding_kind::zero));
+  }
+  convolution_forward::primitive_desc pd(*desc, cpu_engine);
+
+  std::vector<primitive> net;
+  auto input_memory = input.reorder_to(pd.src_primitive_desc(), net);
+
+  std::shared_ptr<memory> weight_memory;
+  {
+    std::lock_guard<std::mutex> lock(weight.mutex_);
+    if (!weight.reordered_ ||
+        weight.reordered_->get_primitive_desc() != pd.weights_primitive_desc()) {
+      memory weight_usr_memory(
+        {{to_dims(w.sizes()), data_t, memory::format::oihw}, cpu_engine}, w.data_ptr());
+      auto reordered = std::make_shared<memory>(pd.weights_primitive_desc());
+      std::vector<primitive> weight_net;
+      weight_net.push_back(reorder(weight_usr_memory, *reordered));
+      submit(weight_net);
+      weight.reordered_ = reordered;
+    }
+    weight_memory = weight.reordered_;
+  }
+
+  MKLDNNTensor output(pd.dst_primitive_desc(), output_size);
+  if (weight.bias_.defined()) {
+    auto bias_memory = dense_vector(weight.bias_, pd.bias_primitive_desc());
+    net.push_back(convolution_forward(pd, input_memory, *weight_memory,
+      bias_memory, output.get_memory()));
+  } else {
+    net.push_back(convolution_forward(pd, input_memory, *weight_memory,
+      output.get_memory()));
+  }
+  submit(net);
+  return output;
+}
+
+MKLDNNTensor mkldnn_relu(const MKLDNNTensor& input) {
+  check_input(input, "mkldnn_relu");
+  auto cpu_engine = CpuEngine::Instance().get_engine();
+  eltwise_forward::desc desc(prop_kind::forward_inference,
+    algorithm::eltwise_relu, desc_of(input), 0.0f);
+  eltwise_forward::primitive_desc pd(desc, cpu_engine);
+  MKLDNNTensor output(pd.dst_primitive_desc(), input.sizes());
+  std::vector<primitive> net;
+  net.push_back(eltwise_forward(pd, input.get_memory(), output.get_memory()));
+  submit(net);
+  return output;
+}
+
+MKLDNNTensor mkldnn_max_pool2d(
+    const MKLDNNTensor& input, IntList kernel_size, IntList stride, IntList padding) {
+  return pool2d(input, kernel_size, stride, padding, algorithm::pooling_max);
+}
+
+MKLDNNTensor mkldnn_avg_pool2d(
+    const MKLDNNTensor& input, IntList kernel_size, IntList stride, IntList padding,
+    bool count_include_pad) {
+  return pool2d(input, kernel_size, stride, padding,
+    count_include_pad ? algorithm::pooling_avg_include_padding
+                      : algorithm::pooling_avg_exclude_padding);
+}
+
+MKLDNNTensor mkldnn_batch_norm(
+    const MKLDNNTensor& input, const Tensor& weight, const Tensor& bias,
+    const Tensor& running_mean, const Tensor& running_var, double eps) {
+  check_input(input, "mkldnn_batch_norm");
+  auto channels = input.size(1);
+  auto cpu_engine = CpuEngine::Instance().get_engine();
+  batch_normalization_forward::desc desc(prop_kind::forward_inference,
+    desc_of(input), static_cast<float>(eps), use_global_stats | use_scale_shift);
+  batch_normalization_forward::primitive_desc pd(desc, cpu_engine);
+
+  // the scale and shift are concatenated in one [2, C] memory
+  memory scale_shift(pd.weights_primitive_desc());
+  auto scale_shift_data = static_cast<float*>(scale_shift.get_data_handle());
+  auto scale = weight.defined() ? weight.contiguous() : CPU(kFloat).ones({channels});
+  auto shift = bias.defined() ? bias.contiguous() : CPU(kFloat).zeros({channels});
+  std::copy_n(scale.data<float>(), channels, scale_shift_data);
+  std::copy_n(shift.data<float>(), channels, scale_shift_data + channels);
+
+  auto mean = running_mean.contiguous();
+  auto var = running_var.contiguous();
+  auto mean_memory = dense_vector(mean, pd.mean_primitive_desc());
+  auto var_memory = dense_vector(var, pd.variance_primitive_desc());
+  MKLDNNTensor output(pd.dst_primitive_desc(), input.sizes());
+  std::vector<primitive> net;
+  net.push_back(batch_normalization_forward(pd, input.get_memory(),
+    primitive::at(mean_memory), primitive::at(var_memory),
+    scale_shift, output.get_memory()));
+  submit(net);
+  return output;
+}
+
+MKLDNNTensor mkldnn_sum(const MKLDNNTensor& a, const MKLDNNTensor& b) {
+  check_input(a, "mkldnn_sum");
+  check_input(b, "mkldnn_sum");
+  if (!a.sizes().equals(b.sizes())) {
+    AT_ERROR("mkldnn_sum: the inputs must have the same sizes");
+  }
+  std::vector<primitive> net;
+  auto pd_a = a.primitive_desc();
+  // e.g. the shortcut of a residual block may have another format
+  auto b_memory = b.reorder_to(pd_a, net);
+  sum::primitive_desc pd(desc_of(a), {1.0f, 1.0f}, {pd_a, pd_a});
+  MKLDNNTensor output(pd.dst_primitive_desc(), a.sizes());
+  std::vector<primitive::at> inputs = {a.get_memory(), b_memory};
+  net.push_back(sum(pd, inputs, output.get_memory()));
+  submit(net);
+  return output;
+}
+
+}}  // namespace at::native
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/mkldnn/Runtime.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace at { namespace native {
+
+// A float activation in the memory format MKL-DNN picked for it, usually a
+// blocked one (nChw8c, nChw16c) that the other ATen functions can't read.
+// The mkldnn_* functions below take and return these, so a chain of them
+// (e.g. the convolutions, batch norms, relus, poolings and residual sums of
+// a ResNet) only reorders where a primitive asks for another format, instead
+// of converting from and to NCHW around every op like mkldnn_convolution.
+// Only the first input and the last output pay for a conversion, with the
+// MKLDNNTensor(Tensor) constructor and to_dense().
+//
+// These are inference only functions: they compute no workspace for a
+// backward pass.
+struct MKLDNNTensor {
+  MKLDNNTensor() {}
+  // Shares the memory of a 4-d NCHW (or channels last) float CPU tensor,
+  // made contiguous first if it is neither
+  explicit MKLDNNTensor(const Tensor& dense);
+  // Allocates an activation of the given sizes in the format of pd
+  MKLDNNTensor(const memory::primitive_desc& pd, IntList sizes);
+
+  bool defined() const {
+    return memory_ != nullptr;
+  }
+  IntList sizes() const {
+    return sizes_;
+  }
+  int64_t size(int64_t dim) const {
+    return sizes_.at(dim);
+  }
+  memory::primitive_desc primitive_desc() const {
+    return memory_->get_primitive_desc();
+  }
+  const memory& get_memory() const {
+    return *memory_;
+  }
+
+  // Copies the activation to a new contiguous NCHW tensor
+  Tensor to_dense() const;
+  // The memory of the activation in the format of pd: its own memory if it
+  // already has that format, or a new one, the reorder into which is
+  // appended to net
+  memory reorder_to(const memory::primitive_desc& pd, std::vector<primitive>& net) const;
+
+private:
+  // the dense tensor shared by the first constructor, kept alive with it
+  Tensor dense_;
+  std::shared_ptr<memory> memory_;
+  std::vector<int64_t> sizes_;
+};
+
+// The weight and bias of a 2-d convolution for inference. The weight is
+// reordered to the format the convolution primitive prefers on its first
+// use, and the reordered copy is reused by the next calls, as long as the
+// primitive asks for the same format. The copy isn't updated if the weight
+// changes: a new MKLDNNConvWeight has to be created then.
+struct MKLDNNConvWeight {
+  MKLDNNConvWeight(
+      const Tensor& weight, const Tensor& bias,
+      IntList padding, IntList stride, IntList dilation);
+
+  MKLDNNConvWeight(const MKLDNNConvWeight&) = delete;
+  MKLDNNConvWeight& operator=(const MKLDNNConvWeight&) = delete;
+
+private:
+  friend MKLDNNTensor mkldnn_conv2d(const MKLDNNTensor& input, MKLDNNConvWeight& weight);
+
+  Tensor weight_;
+  Tensor bias_;
+  std::vector<int64_t> padding_;
+  std::vector<int64_t> stride_;
+  // the weight in the format of the last convolution, guarded by mutex_
+  std::shared_ptr<memory> reordered_;
+  std::mutex mutex_;
+};
+
+MKLDNNTensor mkldnn_conv2d(const MKLDNNTensor& input, MKLDNNConvWeight& weight);
+MKLDNNTensor mkldnn_relu(const MKLDNNTensor& input);
+MKLDNNTensor mkldnn_max_pool2d(
+    const MKLDNNTensor& input, IntList kernel_size, IntList stride, IntList padding);
+MKLDNNTensor mkldnn_avg_pool2d(
+    const MKLDNNTensor& input, IntList kernel_size, IntList stride, IntList padding,
+    bool count_include_pad);
+// Normalizes with the running statistics, like batch_norm with
+// training=false. weight and bias may be undefined.
+MKLDNNTensor mkldnn_batch_norm(
+    const MKLDNNTensor& input, const Tensor& weight, const Tensor& bias,
+    const Tensor& running_mean, const Tensor& running_var, double eps);
+// a + b, in the format of a
+MKLDNNTensor mkldnn_sum(const MKLDNNTensor& a, const MKLDNNTensor& b);
+
+}}  // namespace at::native
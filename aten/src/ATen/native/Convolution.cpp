@@ -1,5 +1,6 @@
 #include "ATen/ATen.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/MemoryFormat.h"
 
 #include "ATen/Config.h"
 #if AT_CUDNN_ENABLED()
@@ -138,12 +139,14 @@ auto ConvParams::use_mkldnn(const at::Tensor& input) const -> bool {
   return false;
 }
 
-// We currently only have depthwise support for the case where groups ==
-// nInputPlane and nInputPlane == nOutputPlane (the latter due to the lack of
-// a depthwise multiplier)
+// Depthwise convolutions (groups == nInputPlane, nOutputPlane a multiple of
+// nInputPlane) have direct kernels on both CPU and CUDA, instead of a
+// convolution per group
 auto ConvParams::is_depthwise(
         const at::Tensor& input, const at::Tensor& weight) const -> bool {
-  return input.type().is_cuda() &&
+  return (input.type().is_cuda() ||
+          input.type().scalarType() == kFloat ||
+          input.type().scalarType() == kDouble) &&
          !transposed &&
          input.ndimension() == 4 &&
          input.size(1) == groups &&
@@ -300,7 +303,7 @@ at::Tensor _convolution(
     bool transposed_, IntList output_padding_, int64_t groups_,
     bool benchmark, bool deterministic, bool cudnn_enabled) {
 
-  auto input = input_r.contiguous();
+  auto input = input_r;
   auto weight = weight_r;
   auto bias = bias_r;
   auto k = input.ndimension();
@@ -326,6 +329,12 @@ at::Tensor _convolution(
 
   check_input_shape_forward(input, weight, bias, params.groups, params.transposed);
 
+  // MKL-DNN reads and writes channels last tensors directly, the other
+  // backends want NCHW
+  if (!(is_channels_last(input) && params.use_mkldnn(input))) {
+    input = input.contiguous();
+  }
+
   if (k == 3) {
     params.view1d_as_2d();
     input = view4d(input);
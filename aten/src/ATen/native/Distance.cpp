@@ -1,10 +1,111 @@
 #include "ATen/ATen.h"
+#include "ATen/ExpandUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/Distance.h"
+#include "ATen/native/cpu/DistanceKernel.h"
 
 
 namespace at { namespace native {
 
+void check_cdist(const char* function, const Tensor& x1, const Tensor& x2, double p) {
+  if (x1.dim() != 2 || x2.dim() != 2) {
+    AT_ERROR("%s(): expected 2D inputs (got %d and %d dimensions)", function,
+             (int)x1.dim(), (int)x2.dim());
+  }
+  if (x1.size(1) != x2.size(1)) {
+    AT_ERROR("%s(): x1 and x2 should have the same number of columns (got %d and %d)",
+             function, (int)x1.size(1), (int)x2.size(1));
+  }
+  if (x1.type() != x2.type()) {
+    AT_ERROR("%s(): expected x1 and x2 of the same type (got %s and %s)", function,
+             x1.type().toString(), x2.type().toString());
+  }
+  if (p < 0) {
+    AT_ERROR("%s(): p should be non-negative (got %f)", function, p);
+  }
+}
+
+bool cdist_use_gemm(const Tensor& x1, const Tensor& x2, double p) {
+  // the expansion cancels out most of the digits of the distances between
+  // close rows, so it's only worth it for problems large enough for the
+  // GEMM to pay off
+  return p == 2 && x1.size(0) > 25 && x2.size(0) > 25;
+}
+
+Tensor euclidean_dist_gemm(const Tensor& x1, const Tensor& x2) {
+  auto x1_norm = x1.pow(2).sum(1, true);
+  auto x2_norm = x2.pow(2).sum(1, true);
+  auto result = at::addmm(x2_norm.t(), x1, x2.t(), 1, -2);
+  return result.add_(x1_norm).clamp_min_(0).sqrt_();
+}
+
+Tensor euclidean_dist_backward_gemm(const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                                    const Tensor& cdist) {
+  // sum over j of grad[i][j] * (x1[i] - x2[j]) / cdist[i][j]
+  auto ratio = grad / cdist;
+  ratio.masked_fill_(cdist == 0, 0);
+  return x1 * ratio.sum(1, true) - ratio.mm(x2);
+}
+
+Tensor cdist(const Tensor& x1, const Tensor& x2, double p) {
+  return at::_cdist_forward(x1, x2, p);
+}
+
+Tensor _cdist_forward_cpu(const Tensor& x1, const Tensor& x2, double p) {
+  check_cdist("cdist", x1, x2, p);
+  if (cdist_use_gemm(x1, x2, p)) {
+    return euclidean_dist_gemm(x1, x2);
+  }
+  auto a = x1.contiguous();
+  auto b = x2.contiguous();
+  auto result = a.type().tensor({a.size(0), b.size(0)});
+  cdist_kernel(result, a, b, p);
+  return result;
+}
+
+Tensor _cdist_backward_cpu(const Tensor& grad, const Tensor& x1, const Tensor& x2, double p,
+                           const Tensor& cdist) {
+  if (p == 2) {
+    return euclidean_dist_backward_gemm(grad, x1, x2, cdist);
+  }
+  auto a = x1.contiguous();
+  auto b = x2.contiguous();
+  auto grad_x1 = a.type().tensor(a.sizes());
+  cdist_backward_kernel(grad_x1, grad.contiguous(), a, b, p, cdist.contiguous());
+  return grad_x1;
+}
+
 Tensor pairwise_distance(const Tensor& x1, const Tensor& x2, double p, double eps, bool keepdim) {
-  return norm(x1 - x2 + eps, p, 1, keepdim);
+  // 2D inputs, possibly broadcast against a row, are reduced without
+  // materializing x1 - x2
+  bool fused = std::max(x1.dim(), x2.dim()) == 2 && x1.type() == x2.type() &&
+      at::isFloatingType(x1.type().scalarType()) &&
+      (x1.type().is_cuda() || x1.type().scalarType() != kHalf) && p >= 0;
+  if (!fused) {
+    return norm(x1 - x2 + eps, p, 1, keepdim);
+  }
+  auto size = infer_size(x1.sizes(), x2.sizes());
+  // the kernels need contiguous rows, but a broadcast row is read in place
+  auto expand_rows = [&](const Tensor& x) {
+    auto expanded = x.contiguous().expand(size);
+    return expanded.stride(1) == 1 ? expanded : expanded.contiguous();
+  };
+  auto result = at::_pairwise_distance_forward(expand_rows(x1), expand_rows(x2), p, eps);
+  return keepdim ? result.unsqueeze(1) : result;
 }
+
+Tensor _pairwise_distance_forward_cpu(const Tensor& x1, const Tensor& x2, double p, double eps) {
+  auto result = x1.type().tensor({x1.size(0)});
+  pairwise_distance_kernel(result, x1, x2, p, eps);
+  return result;
+}
+
+Tensor _pairwise_distance_backward_cpu(const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                                       double p, double eps, const Tensor& result) {
+  auto grad_x1 = x1.type().tensor(x1.sizes());
+  pairwise_distance_backward_kernel(grad_x1, grad.contiguous(), x1, x2, p, eps,
+                                    result.contiguous());
+  return grad_x1;
+}
+
 }}  // namespace at::native
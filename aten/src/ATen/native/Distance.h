@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ATen/ATen.h"
+
+namespace at { namespace native {
+
+// Checks the arguments of cdist: N x D x1 and M x D x2 of the same type,
+// and p >= 0
+void check_cdist(const char* function, const Tensor& x1, const Tensor& x2, double p);
+
+// Whether the p = 2 distances between the rows of x1 and x2 are computed
+// as sqrt(|x1|^2 + |x2|^2 - 2 x1 x2^T), with a GEMM
+bool cdist_use_gemm(const Tensor& x1, const Tensor& x2, double p);
+
+// The Euclidean distances between the rows of x1 and x2, with a GEMM
+Tensor euclidean_dist_gemm(const Tensor& x1, const Tensor& x2);
+
+// Gradient of a p = 2 cdist wrt x1, with a GEMM
+Tensor euclidean_dist_backward_gemm(const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                                    const Tensor& cdist);
+
+}} // namespace at::native
@@ -8,9 +8,13 @@
 #include "ATen/CPUGenerator.h"
 #include "ATen/CheckGenerator.h"
 #include "ATen/Generator.h"
+#include "ATen/native/cpu/DistributionsKernel.h"
 
+#include "TH/THGenerator.h"
 #include "TH/THRandom.h"
 
+#include <mutex>
+
 namespace {
 /*
  * This section is a counterpart to Distributions.cu
@@ -49,6 +53,30 @@ THGenerator* get_generator(at::Generator* gen) {
   return gen_->generator;
 }
 
+// Fills self with fill(contiguous, seed, offset), from a range of the Philox
+// stream of the generator with a block per pair of elements
+template <typename F>
+at::Tensor& philox_fill(at::Tensor& self, at::Generator* gen, F fill) {
+  uint64_t seed, offset;
+  {
+    THGenerator* generator = get_generator(gen);
+    std::lock_guard<std::mutex> lock(generator->mutex);
+    seed = THRandom_initialSeed(generator);
+    offset = THRandom_philoxOffset(generator, (self.numel() + 1) / 2);
+  }
+  if (self.numel() == 0) {
+    return self;
+  }
+  if (self.is_contiguous()) {
+    fill(self, seed, offset);
+  } else {
+    at::Tensor contiguous = self.type().tensor(self.sizes());
+    fill(contiguous, seed, offset);
+    self.copy_(contiguous);
+  }
+  return self;
+}
+
 int64_t sample_poisson(double lambda, THGenerator* generator) {
   if (lambda >= 10) {
     // transformed rejection method, (Hoermann, 1993)
@@ -179,11 +207,39 @@ Tensor& bernoulli_(Tensor& self, const Tensor& p, Generator* generator) {
   return self;
 }
 
-Tensor& bernoulli_(Tensor& self, double p, Generator* generator) {
+Tensor& _bernoulli_scalar_cpu_(Tensor& self, double p, Generator* generator) {
+  AT_ASSERT(p >= 0 && p <= 1, "bernoulli_ expects p to be in [0, 1], but got p=%f", p);
+  return philox_fill(self, generator, [p](Tensor& t, uint64_t seed, uint64_t offset) {
+    bernoulliImpl(t, p, seed, offset);
+  });
+}
+
+Tensor& _bernoulli_scalar_cuda_(Tensor& self, double p, Generator* generator) {
   Tensor probs = self.type().toScalarType(kDouble).tensor({}).fill_(p);
   return native::bernoulli_(self, probs, generator);
 }
 
+Tensor& _uniform__cpu(Tensor& self, double from, double to, Generator* generator) {
+  return philox_fill(self, generator, [from, to](Tensor& t, uint64_t seed, uint64_t offset) {
+    uniformImpl(t, from, to, seed, offset);
+  });
+}
+
+Tensor& _uniform__cuda(Tensor& self, double from, double to, Generator* generator) {
+  return self._th_uniform_(from, to, generator);
+}
+
+Tensor& _normal__cpu(Tensor& self, double mean, double std, Generator* generator) {
+  AT_ASSERT(std >= 0, "normal_ expects std >= 0, but got std=%f", std);
+  return philox_fill(self, generator, [mean, std](Tensor& t, uint64_t seed, uint64_t offset) {
+    normalImpl(t, mean, std, seed, offset);
+  });
+}
+
+Tensor& _normal__cuda(Tensor& self, double mean, double std, Generator* generator) {
+  return self._th_normal_(mean, std, generator);
+}
+
 Tensor _standard_gamma_grad_cpu(const Tensor& self, const Tensor& output) {
   Tensor ret = self.type().tensor(self.sizes());
   AT_DISPATCH_FLOATING_TYPES(self.type(), "_standard_gamma_grad", [&] {
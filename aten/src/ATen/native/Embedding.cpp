@@ -1,7 +1,13 @@
 #include "ATen/ATen.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/Dispatch.h"
+#include "ATen/native/EmbeddingUtils.h"
+#include "ATen/native/RadixSort.h"
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <memory>
 #include <sstream>
@@ -44,7 +50,7 @@ Tensor embedding_backward(
   }
 }
 
-Tensor embedding_sparse_backward(
+Tensor embedding_sparse_backward_cuda(
     const Tensor & grad_, const Tensor & indices_, int64_t num_weights,
     int64_t padding_idx, bool scale_grad_by_freq) {
 
@@ -52,7 +58,7 @@ Tensor embedding_sparse_backward(
   checkScalarType("embedding_backward", indices_arg, kLong);
   checkContiguous("embedding_backward", indices_arg);
 
-  // TODO: implement scale_grad_by_freq
+  // TODO: implement scale_grad_by_freq (the CPU version supports it)
   if (scale_grad_by_freq) {
     AT_ERROR(
         "embedding_backward: scale_grad_by_freq not supported with sparse gradients");
@@ -82,72 +88,125 @@ Tensor embedding_sparse_backward(
   return sparse_type.sparse_coo_tensor(index, values, weight_size);
 }
 
-Tensor embedding_backward_cpu(
-    const Tensor & grad_, const Tensor & indices, int64_t num_weights,
-    int64_t padding_idx, bool scale_grad_by_freq) {
-
-  auto indices_arg = TensorArg(indices, "indices", 2);
-  checkScalarType("embedding_backward", indices_arg, kLong);
-  checkContiguous("embedding_backward", indices_arg);
-
-  auto indices_data = indices.data<int64_t>();
+IndexSegments segment_indices(const Tensor& indices_, int64_t num_weights,
+                              int64_t padding_idx) {
+  Tensor indices = indices_.contiguous().view(-1);
   int64_t numel = indices.numel();
+  auto indices_data = indices.data<int64_t>();
+  std::vector<int64_t> sorted(numel);
+  std::vector<int64_t> order(numel);
+  radix_sort(indices_data, numel, sorted.data(), order.data());
+  if (numel > 0 && (sorted[0] < 0 || sorted[numel - 1] >= num_weights)) {
+    AT_ERROR("embedding_backward: index %lld is out of range for %lld embeddings",
+             (long long)(sorted[0] < 0 ? sorted[0] : sorted[numel - 1]),
+             (long long)num_weights);
+  }
 
-  std::unique_ptr<int64_t[]> counts;
-  if (scale_grad_by_freq) {
-    counts.reset(new int64_t[num_weights]);
-    for (int i = 0; i < numel; i++) {
-      counts[indices_data[i]] = 0;
+  std::vector<int64_t> kept_order;
+  std::vector<int64_t> offsets;
+  std::vector<int64_t> unique;
+  kept_order.reserve(numel);
+  for (int64_t i = 0; i < numel; i++) {
+    if (sorted[i] == padding_idx) {
+      continue;
     }
-    for (int i = 0; i < numel; i++) {
-      counts[indices_data[i]]++;
+    if (unique.empty() || sorted[i] != unique.back()) {
+      offsets.push_back(kept_order.size());
+      unique.push_back(sorted[i]);
     }
+    kept_order.push_back(order[i]);
   }
+  offsets.push_back(kept_order.size());
+
+  auto to_tensor = [&](const std::vector<int64_t>& v) {
+    auto t = indices.type().tensor({(int64_t)v.size()});
+    std::copy(v.begin(), v.end(), t.data<int64_t>());
+    return t;
+  };
+  return IndexSegments{to_tensor(kept_order), to_tensor(offsets), to_tensor(unique)};
+}
 
-  auto grad = grad_.contiguous().view({numel, grad_.size(-1)});
-  auto grad_weight = at::zeros(grad_.type(), {num_weights, grad_.size(-1)});
-
-#ifdef _OPENMP
-  if (numel > 1000) {
-    // The strategy is to parallelize over sections of the vocabulary, so that
-    // thread 1 handles updates to gradWeight[0..nVocab/nThreads]. Every thread
-    // has to traverse the entire input, but the dominating factor is the axpy
-    // BLAS call.
-    #pragma omp parallel
-    {
-      int tid = omp_get_thread_num();
-      int nthreads = omp_get_num_threads();
-      int64_t start = tid * (num_weights/nthreads + 1);
-      int64_t end = start + (num_weights/nthreads + 1);
-      for (int64_t i = 0; i < numel; i++) {
-        if (indices_data[i] != padding_idx) {
-          int64_t k = indices_data[i];
-          if (k >= start && k < end) {
-            double scale = 1.0;
-            if (scale_grad_by_freq) {
-              scale /= counts[k];
-            }
-            grad_weight[k].add_(grad[i], scale);
-          }
-        }
-      }
-    }
+Tensor embedding_backward_from_segments(const Tensor& grad, const IndexSegments& segments,
+                                        const Tensor& src_rows, const Tensor& scales,
+                                        int64_t num_weights, bool sparse) {
+  int64_t num_features = grad.size(1);
+  auto& dense_type = grad.type();
+  if (!sparse) {
+    auto grad_weight = at::zeros(dense_type, {num_weights, num_features});
+    embedding_backward_kernel(grad_weight, grad, segments.order, segments.offsets,
+                              segments.unique, src_rows, scales);
     return grad_weight;
   }
-#endif
 
-  for (int64_t i = 0; i < numel; i++) {
-    if (indices_data[i] != padding_idx) {
-      int64_t k = indices_data[i];
-      double scale = 1.0;
-      if (scale_grad_by_freq) {
-        scale /= counts[k];
+  auto weight_size = std::array<int64_t, 2>{{ num_weights, num_features }};
+  auto& sparse_type = dense_type.toBackend(kSparseCPU);
+  if (segments.size() == 0) {
+    return sparse_type.sparse_coo_tensor(segments.unique.type().tensor(),
+                                         dense_type.tensor(), weight_size);
+  }
+  auto values = dense_type.tensor({segments.size(), num_features});
+  embedding_backward_kernel(values, grad, segments.order, segments.offsets,
+                            Tensor(), src_rows, scales);
+  auto result = sparse_type.sparse_coo_tensor(segments.unique.view({1, -1}), values, weight_size);
+  // the indices are unique and sorted, spare the optimizers a coalesce()
+  result._set_coalesced_(true);
+  return result;
+}
+
+// 1 / (number of occurrences of the index) for every position, or undefined
+static Tensor frequency_scales(const Tensor& grad, const IndexSegments& segments,
+                               int64_t numel, bool scale_grad_by_freq) {
+  if (!scale_grad_by_freq) {
+    return Tensor();
+  }
+  auto scales = at::zeros(grad.type(), {numel});
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_backward", [&] {
+    auto scales_data = scales.data<scalar_t>();
+    auto order_data = segments.order.data<int64_t>();
+    auto offsets_data = segments.offsets.data<int64_t>();
+    for (int64_t s = 0; s < segments.size(); s++) {
+      scalar_t scale = scalar_t(1) / (offsets_data[s + 1] - offsets_data[s]);
+      for (int64_t j = offsets_data[s]; j < offsets_data[s + 1]; j++) {
+        scales_data[order_data[j]] = scale;
       }
-      grad_weight[k].add_(grad[i], scale);
     }
-  }
+  });
+  return scales;
+}
+
+Tensor embedding_sparse_backward_cpu(
+    const Tensor & grad_, const Tensor & indices, int64_t num_weights,
+    int64_t padding_idx, bool scale_grad_by_freq) {
+
+  auto indices_arg = TensorArg(indices, "indices", 2);
+  checkScalarType("embedding_backward", indices_arg, kLong);
+  checkContiguous("embedding_backward", indices_arg);
+
+  int64_t numel = indices.numel();
+  auto grad = grad_.contiguous().view({numel, grad_.size(-1)});
+  auto segments = segment_indices(indices, num_weights, padding_idx);
+  auto scales = frequency_scales(grad, segments, numel, scale_grad_by_freq);
+  return embedding_backward_from_segments(grad, segments, Tensor(), scales,
+                                          num_weights, true);
+}
+
+Tensor embedding_backward_cpu(
+    const Tensor & grad_, const Tensor & indices, int64_t num_weights,
+    int64_t padding_idx, bool scale_grad_by_freq) {
 
-  return grad_weight;
+  auto indices_arg = TensorArg(indices, "indices", 2);
+  checkScalarType("embedding_backward", indices_arg, kLong);
+  checkContiguous("embedding_backward", indices_arg);
+
+  // Each unique index is owned by one thread (or, when it occurs very often,
+  // by a fixed set of pieces reduced in order), so there are no races on the
+  // rows of grad_weight and the sums don't depend on the number of threads.
+  int64_t numel = indices.numel();
+  auto grad = grad_.contiguous().view({numel, grad_.size(-1)});
+  auto segments = segment_indices(indices, num_weights, padding_idx);
+  auto scales = frequency_scales(grad, segments, numel, scale_grad_by_freq);
+  return embedding_backward_from_segments(grad, segments, Tensor(), scales,
+                                          num_weights, false);
 }
 
 Tensor & embedding_renorm_cpu_(
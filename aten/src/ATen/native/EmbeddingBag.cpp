@@ -1,15 +1,19 @@
 #include "ATen/ATen.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
+#include "ATen/Dispatch.h"
+#include "ATen/native/EmbeddingUtils.h"
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <vector>
 
-#include <TH/THBlas.h>
-
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -17,44 +21,14 @@
 namespace at {
 namespace native {
 
-static void make_offset2bag(const Tensor &offsets, const Tensor &indices,
-                            Tensor &offset2bag) {
-  offset2bag.index_fill_(0, offsets, 1); // offset2bag = [1 0 1 0 1]
-  offset2bag[0] = 0;                     // offset2bag = [0 0 1 0 1]
-  offset2bag = offset2bag.cumsum(0);     // offset2bag = [0 0 1 1 2]
-}
-
-template<typename T>
-static void axpy(int64_t n, T a, T *x, int64_t incx, T *y, int64_t incy);
-template<>
-void axpy<float>(int64_t n, float a, float *x, int64_t incx,
-                 float *y, int64_t incy) {
-  THFloatBlas_axpy(n, a, x, incx, y, incy);
-}
-template<>
-void axpy<double>(int64_t n, double a, double *x, int64_t incx,
-                  double *y, int64_t incy) {
-  THDoubleBlas_axpy(n, a, x, incx, y, incy);
-}
-
-// This function combines index_select (using select_indices as the index) and
-// index_add (using add_indices as the index), without creating an intermediary
-// tensor to hold the selected embeddings
-template<typename T>
-static void index_select_add(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output) {
-  auto add_indices_data = add_indices.data<int64_t>();
-  auto select_indices_data = select_indices.data<int64_t>();
-  auto src_data = src.data<T>();
-  auto output_data = output.data<T>();
-  auto numel = add_indices.numel();
-  int64_t ddim = src.sizes()[1];
-  for (int64_t i = 0; i < numel; i++) {
-    axpy<T>(ddim, 1, src_data + ddim * select_indices_data[i], 1,
-            output_data + ddim * add_indices_data[i], 1);
-  }
+static Tensor make_offset2bag(const Tensor &offsets, const Tensor &indices) {
+  // one extra slot, so that empty bags at the end have somewhere to count,
+  // and index_add_ so that empty bags in the middle are counted too
+  auto offset2bag = at::zeros(indices.type(), {indices.sizes()[0] + 1});
+  offset2bag.index_add_(0, offsets, at::ones_like(offsets)); // offset2bag = [1 0 1 0 1]
+  offset2bag[0] -= 1;                                        // offset2bag = [0 0 1 0 1]
+  offset2bag = offset2bag.cumsum(0);                         // offset2bag = [0 0 1 1 2]
+  return offset2bag.narrow(0, 0, indices.sizes()[0]);
 }
 
 static void make_bag_size(const Tensor &offsets, const Tensor &indices,
@@ -69,22 +43,6 @@ static void make_bag_size(const Tensor &offsets, const Tensor &indices,
   }
 }
 
-static Tensor apply_bag_size(const Tensor &offsets, const Tensor &indices,
-                             const int64_t mode, Tensor &output,
-                             const Tensor &bag_size) {
-  if (mode == 1) { // MODE_MEAN
-    if (offsets.sizes()[0] == 1) {
-      auto bag_size_ = indices.sizes()[0];
-      output /= bag_size_;
-    } else {
-      auto bag_size_ =
-          bag_size.toType(output.type()).unsqueeze(1).expand_as(output);
-      output /= bag_size_;
-    }
-  }
-  return output;
-}
-
 static Tensor apply_bag_size_backward(const Tensor &offsets,
                                       const Tensor &indices, const int64_t mode,
                                       Tensor &output, const Tensor &offset2bag,
@@ -106,7 +64,8 @@ static Tensor apply_bag_size_backward(const Tensor &offsets,
 std::tuple<Tensor, Tensor, Tensor>
 embedding_bag_cpu(const Tensor &weight, const Tensor &indices__,
                   const Tensor &offsets__, const bool scale_grad_by_freq,
-                  const int64_t mode, bool sparse) {
+                  const int64_t mode, bool sparse,
+                  const Tensor &per_sample_weights__) {
   auto indices_arg = TensorArg(indices__, "indices__", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   auto offsets_arg = TensorArg(offsets__, "offsets__", 1);
@@ -114,21 +73,25 @@ embedding_bag_cpu(const Tensor &weight, const Tensor &indices__,
   Tensor indices = indices__.contiguous();
   Tensor offsets = offsets__.contiguous();
   auto weight_arg = TensorArg(weight, "weight", 1);
-  checkScalarTypes("embedding_bag", weight_arg, {kFloat, kDouble});
+  checkScalarTypes("embedding_bag", weight_arg, {kFloat, kDouble, kHalf});
+  checkDim("embedding_bag", weight_arg, 2);
+  Tensor per_sample_weights;
+  if (per_sample_weights__.defined()) {
+    auto per_sample_weights_arg = TensorArg(per_sample_weights__, "per_sample_weights", 7);
+    checkSameType("embedding_bag", weight_arg, per_sample_weights_arg);
+    checkSameSize("embedding_bag", indices_arg, per_sample_weights_arg);
+    per_sample_weights = per_sample_weights__.contiguous();
+  }
 
   auto bag_size = at::zeros(indices.type(), offsets.sizes());
-  auto offset2bag =
-      at::zeros(indices__.type(), {indices.sizes()[0]}); // offset2bag = [0 0 0 0 0]
-  make_offset2bag(offsets, indices, offset2bag);
-  auto output = at::zeros(weight.type(), {offsets.sizes()[0], weight.sizes()[1]});
-  if (weight.type().scalarType() == kFloat) {
-    index_select_add<float>(indices, offset2bag, weight, output);
-  } else if (weight.type().scalarType() == kDouble) {
-    index_select_add<double>(indices, offset2bag, weight, output);
-  }
+  auto offset2bag = make_offset2bag(offsets, indices);
   make_bag_size(offsets, indices, mode, bag_size);
-  auto ret = apply_bag_size(offsets, indices, mode, output, bag_size);
-  return std::tuple<Tensor, Tensor, Tensor>(ret, offset2bag, bag_size);
+  // the kernel reads rows with their stride, but wants them contiguous
+  Tensor weight_rows = weight.stride(1) == 1 ? weight : weight.contiguous();
+  auto output = weight.type().tensor({offsets.sizes()[0], weight.sizes()[1]});
+  embedding_bag_kernel(output, weight_rows, indices, offsets, per_sample_weights,
+                       mode == 1 /* MODE_MEAN */);
+  return std::tuple<Tensor, Tensor, Tensor>(output, offset2bag, bag_size);
 }
 
 Tensor embedding_bag_backward(const Tensor &grad_, const Tensor &indices__,
@@ -136,7 +99,7 @@ Tensor embedding_bag_backward(const Tensor &grad_, const Tensor &indices__,
                               const Tensor &offset2bag__,
                               const Tensor &bag_size_, int64_t num_weights,
                               bool scale_grad_by_freq, int64_t mode,
-                              bool sparse) {
+                              bool sparse, const Tensor &per_sample_weights) {
   auto indices_arg = TensorArg(indices__, "indices__", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   auto offsets_arg = TensorArg(offsets__, "offsets__", 1);
@@ -147,6 +110,18 @@ Tensor embedding_bag_backward(const Tensor &grad_, const Tensor &indices__,
   Tensor indices = indices__.contiguous();
   Tensor offsets = offsets__.contiguous();
 
+  if (per_sample_weights.defined()) {
+    // every index scales its row of grad differently, so the rows are
+    // gathered and weighted before being accumulated like embedding's
+    Tensor offset2bag = offset2bag__.contiguous();
+    Tensor index_grad = grad_.index_select(0, offset2bag);
+    index_grad = apply_bag_size_backward(offsets, indices, mode, index_grad,
+                                         offset2bag, bag_size_);
+    index_grad *= per_sample_weights.unsqueeze(1);
+    return native::embedding_backward(index_grad, indices, num_weights, -1,
+                                      scale_grad_by_freq, sparse);
+  }
+
   if (sparse) {
     return at::embedding_bag_sparse_backward(
         grad_, indices, offsets, offset2bag__, bag_size_, num_weights,
@@ -158,11 +133,54 @@ Tensor embedding_bag_backward(const Tensor &grad_, const Tensor &indices__,
   }
 }
 
-Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
-                                  const Tensor &offsets__,
-                                  const Tensor &offset2bag__,
-                                  const Tensor &bag_size_, int64_t num_weights,
+// Gradient scale of every index: 1 / bag size for the mean, times
+// 1 / (number of occurrences of the index) with scale_grad_by_freq.
+static Tensor bag_backward_scales(const Tensor &grad, const Tensor &indices,
+                                  const Tensor &offsets, const IndexSegments &segments,
                                   bool scale_grad_by_freq, int64_t mode) {
+  bool mean = mode == 1; // MODE_MEAN
+  if (!mean && !scale_grad_by_freq) {
+    return Tensor();
+  }
+  int64_t numel = indices.size(0);
+  int64_t num_bags = offsets.size(0);
+  auto scales = at::ones(grad.type(), {numel});
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_bag_backward", [&] {
+    auto scales_data = scales.data<scalar_t>();
+    if (mean) {
+      // same bags as the forward kernel
+      auto offsets_data = offsets.data<int64_t>();
+      for (int64_t bag = 0; bag < num_bags; bag++) {
+        int64_t start = bag == 0 ? 0 : std::min(offsets_data[bag], numel);
+        int64_t stop = bag + 1 < num_bags ? std::min(offsets_data[bag + 1], numel) : numel;
+        for (int64_t i = start; i < stop; i++) {
+          scales_data[i] = scalar_t(1) / (stop - start);
+        }
+      }
+    }
+    if (scale_grad_by_freq) {
+      auto order_data = segments.order.data<int64_t>();
+      auto segment_data = segments.offsets.data<int64_t>();
+      for (int64_t s = 0; s < segments.size(); s++) {
+        int64_t count = segment_data[s + 1] - segment_data[s];
+        for (int64_t j = segment_data[s]; j < segment_data[s + 1]; j++) {
+          scales_data[order_data[j]] /= count;
+        }
+      }
+    }
+  });
+  return scales;
+}
+
+// The indices are grouped with a radix sort and every weight row sums the
+// rows of grad of the bags its occurrences belong to, without gathering them
+// first. See embedding_backward_cpu.
+static Tensor embedding_bag_backward_cpu_impl(const Tensor &grad_, const Tensor &indices__,
+                                              const Tensor &offsets__,
+                                              const Tensor &offset2bag__,
+                                              int64_t num_weights,
+                                              bool scale_grad_by_freq, int64_t mode,
+                                              bool sparse) {
   auto grad = grad_.contiguous();
   auto grad_arg = TensorArg(grad, "grad_", 1);
   checkScalarTypes("embedding_bag", grad_arg, {kFloat, kDouble});
@@ -172,84 +190,37 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
   checkScalarType("embedding_bag", offsets_arg, kLong);
   auto offset2bag_arg = TensorArg(offset2bag__, "offset2bag__", 1);
   checkScalarType("embedding_bag", offset2bag_arg, kLong);
-  checkContiguous("embedding_bag", offset2bag_arg);
-  Tensor indices_ = indices__.contiguous();
-  Tensor offsets_ = offsets__.contiguous();
-
-  Tensor &offset2bag_ = const_cast<Tensor &>(offset2bag__);
-
-  auto ind_sort_ = indices_.sort();
-  auto indices = std::get<0>(ind_sort_);
-  auto ind_sort = std::get<1>(ind_sort_);
-  auto offset2bag = offset2bag_.index_select(0, ind_sort);
-
-  auto indices_data = indices.data<int64_t>();
-  auto offsets_data = offsets_.data<int64_t>();
-  auto offset2bag_data = offset2bag.data<int64_t>();
-  int64_t numel = indices.numel();
-
-  std::vector<int64_t> counts(num_weights);
-  for (int i = 0; i < numel; i++) {
-    counts[indices_data[i]] = 0;
-  }
-  for (int i = 0; i < numel; i++) {
-    counts[indices_data[i]]++;
-  }
-
-  std::vector<int64_t> counts_uniq;
-  counts_uniq.reserve(num_weights);
-  int64_t o = 0;
-  for (int64_t i = 0; i < numel; i += counts[indices_data[i]]) {
-    counts_uniq.push_back(counts[indices_data[i]]);
-    if (o > 0) {
-      counts_uniq[o] += counts_uniq[o - 1];
-    }
-    o++;
-  }
+  Tensor indices = indices__.contiguous();
+  Tensor offsets = offsets__.contiguous();
+  Tensor offset2bag = offset2bag__.contiguous();
 
-  auto index_grad_weight =
-      at::zeros(grad.type(), {num_weights, grad.sizes()[1]}).contiguous();
+  auto segments = segment_indices(indices, num_weights, -1);
+  auto scales = bag_backward_scales(grad, indices, offsets, segments,
+                                    scale_grad_by_freq, mode);
+  return embedding_backward_from_segments(grad, segments, offset2bag, scales,
+                                          num_weights, sparse);
+}
 
-#pragma omp parallel for if (numel > 1000)
-  for (int64_t i = 0; i < (int64_t)counts_uniq.size(); i++) {
-    int64_t start = i == 0 ? 0 : counts_uniq[i - 1];
-    int64_t index = indices_data[start];
-    for (int64_t j = start; j < counts_uniq[i]; j++) {
-      int64_t source = offset2bag_data[j];
-      double scale = 1.0;
-      if (scale_grad_by_freq) {
-        scale /= counts[indices_data[i]];
-      }
-      if (mode == 1) { // MODE_MEAN
-        if (offsets_.sizes()[0] == 1) {
-          auto bag_size = indices.sizes()[0];
-          scale /= bag_size;
-        } else {
-          if (source == offsets_.sizes()[0] - 1) {
-            scale /= indices.sizes()[0] - offsets_data[offsets_.sizes()[0] - 1];
-          } else {
-            scale /= offsets_data[source + 1] - offsets_data[source];
-          }
-        }
-      }
-      int64_t ddim = grad.sizes()[1];
-      if (grad.type().scalarType() == kFloat) {
-        auto igwd = index_grad_weight.data<float>();
-        auto gd = grad.data<float>();
-        axpy<float>(ddim, (float)scale, gd + ddim * source, 1,
-                    igwd + ddim * index, 1);
-      } else if (grad.type().scalarType() == kDouble) {
-        auto igwd = index_grad_weight.data<double>();
-        auto gd = grad.data<double>();
-        axpy<double>(ddim, (double)scale, gd + ddim * source, 1,
-                     igwd + ddim * index, 1);
-      }
-    }
-  }
+Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
+                                  const Tensor &offsets__,
+                                  const Tensor &offset2bag__,
+                                  const Tensor &bag_size_, int64_t num_weights,
+                                  bool scale_grad_by_freq, int64_t mode) {
+  return embedding_bag_backward_cpu_impl(grad_, indices__, offsets__, offset2bag__,
+                                         num_weights, scale_grad_by_freq, mode, false);
+}
 
-  return index_grad_weight;
+Tensor embedding_bag_sparse_backward_cpu(
+    const Tensor &grad_, const Tensor &indices__, const Tensor &offsets__,
+    const Tensor &offset2bag__, const Tensor &bag_size_, int64_t num_weights,
+    bool scale_grad_by_freq, int64_t mode) {
+  return embedding_bag_backward_cpu_impl(grad_, indices__, offsets__, offset2bag__,
+                                         num_weights, scale_grad_by_freq, mode, true);
 }
-Tensor embedding_bag_sparse_backward(
+
+// CUDA has no fused version: the rows of grad are gathered per index and
+// reduced by embedding's sparse backward.
+Tensor embedding_bag_sparse_backward_cuda(
     const Tensor &grad_, const Tensor &indices__, const Tensor &offsets__,
     const Tensor &offset2bag__, const Tensor &bag_size_, int64_t num_weights,
     bool scale_grad_by_freq, int64_t mode) {
@@ -270,5 +241,153 @@ Tensor embedding_bag_sparse_backward(
   return native::embedding_backward(index_grad, indices, num_weights, -1,
                                     scale_grad_by_freq, true);
 }
+
+Tensor _embedding_bag_per_sample_weights_backward(
+    const Tensor &grad, const Tensor &weight, const Tensor &indices__,
+    const Tensor &offsets__, const Tensor &offset2bag__,
+    const Tensor &bag_size_, int64_t mode) {
+  Tensor indices = indices__.contiguous();
+  Tensor offsets = offsets__.contiguous();
+  Tensor offset2bag = offset2bag__.contiguous();
+  // d output[bag] / d per_sample_weights[i] = weight[indices[i]] (/ bag size)
+  Tensor index_grad = grad.index_select(0, offset2bag);
+  index_grad = apply_bag_size_backward(offsets, indices, mode, index_grad,
+                                       offset2bag, bag_size_);
+  return (index_grad * weight.index_select(0, indices)).sum(1);
+}
+
+// Fused rowwise quantization, the format of Caffe2's
+// FloatToFused8BitRowwiseQuantized: every row of the uint8 result holds the
+// quantized values of a row of self, followed by its scale and its bias as
+// floats, so that a value is q * scale + bias. With 4 bits, the values are
+// packed two per byte (the first in the low nibble).
+static void check_fused_rowwise_bits(const char* name, int64_t bits) {
+  if (bits != 8 && bits != 4) {
+    AT_ERROR("%s: bits should be 8 or 4, got %lld", name, (long long)bits);
+  }
+}
+
+Tensor fused_rowwise_quantize_cpu(const Tensor &self_, int64_t bits) {
+  check_fused_rowwise_bits("fused_rowwise_quantize", bits);
+  auto self_arg = TensorArg(self_, "self", 1);
+  checkScalarType("fused_rowwise_quantize", self_arg, kFloat);
+  checkDim("fused_rowwise_quantize", self_arg, 2);
+  int64_t rows = self_.size(0);
+  int64_t cols = self_.size(1);
+  if (bits == 4 && cols % 2 != 0) {
+    AT_ERROR("fused_rowwise_quantize: 4-bit quantization needs an even number "
+             "of columns, got %lld", (long long)cols);
+  }
+  Tensor self = self_.contiguous();
+  const int64_t values_per_byte = 8 / bits;
+  const int64_t data_bytes = cols / values_per_byte;
+  const float max_q = (1 << bits) - 1;
+  auto output = at::CPU(kByte).tensor({rows, data_bytes + 2 * int64_t(sizeof(float))});
+  auto in_data = self.data<float>();
+  auto out_data = output.data<uint8_t>();
+  int64_t out_stride = output.stride(0);
+
+  int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(1, cols));
+  parallel_for(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r != end; r++) {
+      const float* in = in_data + r * cols;
+      uint8_t* out = out_data + r * out_stride;
+      float min = cols ? *std::min_element(in, in + cols) : 0.f;
+      float max = cols ? *std::max_element(in, in + cols) : 0.f;
+      float range = max - min;
+      // same epsilon as Caffe2, a constant row quantizes to zeros
+      float inv_scale = max_q / (range + 1e-8f);
+      std::memset(out, 0, data_bytes);
+      for (int64_t c = 0; c != cols; c++) {
+        uint8_t q = std::lrint((in[c] - min) * inv_scale);
+        if (bits == 8) {
+          out[c] = q;
+        } else {
+          out[c / 2] |= q << ((c % 2) * 4);
+        }
+      }
+      float scale_bias[2] = {range / max_q, min};
+      std::memcpy(out + data_bytes, scale_bias, sizeof(scale_bias));
+    }
+  });
+  return output;
+}
+
+Tensor fused_rowwise_dequantize_cpu(const Tensor &self_, int64_t bits) {
+  check_fused_rowwise_bits("fused_rowwise_dequantize", bits);
+  auto self_arg = TensorArg(self_, "self", 1);
+  checkScalarType("fused_rowwise_dequantize", self_arg, kByte);
+  checkDim("fused_rowwise_dequantize", self_arg, 2);
+  int64_t data_bytes = self_.size(1) - 2 * sizeof(float);
+  if (data_bytes < 0) {
+    AT_ERROR("fused_rowwise_dequantize: rows should have at least %d bytes for "
+             "the scale and the bias, got %lld", (int)(2 * sizeof(float)),
+             (long long)self_.size(1));
+  }
+  Tensor self = self_.contiguous();
+  int64_t rows = self.size(0);
+  int64_t cols = data_bytes * (8 / bits);
+  auto output = at::CPU(kFloat).tensor({rows, cols});
+  auto in_data = self.data<uint8_t>();
+  auto out_data = output.data<float>();
+
+  int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(1, cols));
+  parallel_for(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r != end; r++) {
+      const uint8_t* in = in_data + r * self.stride(0);
+      float* out = out_data + r * cols;
+      float scale_bias[2];
+      std::memcpy(scale_bias, in + data_bytes, sizeof(scale_bias));
+      for (int64_t c = 0; c != cols; c++) {
+        int q = bits == 8 ? in[c] : (in[c / 2] >> ((c % 2) * 4)) & 0xF;
+        out[c] = q * scale_bias[0] + scale_bias[1];
+      }
+    }
+  });
+  return output;
+}
+
+// embedding_bag over a weight quantized by fused_rowwise_quantize, without
+// dequantizing the table: only the rows that are looked up are expanded, in
+// registers. Forward only, sum and mean modes.
+Tensor embedding_bag_fused_rowwise_cpu(const Tensor &weight, const Tensor &indices__,
+                                       const Tensor &offsets__, int64_t bits,
+                                       int64_t mode,
+                                       const Tensor &per_sample_weights__) {
+  check_fused_rowwise_bits("embedding_bag_fused_rowwise", bits);
+  if (mode != 0 && mode != 1) {
+    AT_ERROR("embedding_bag_fused_rowwise: only the sum (0) and mean (1) modes "
+             "are supported, got %lld", (long long)mode);
+  }
+  auto indices_arg = TensorArg(indices__, "indices__", 1);
+  checkScalarType("embedding_bag_fused_rowwise", indices_arg, kLong);
+  auto offsets_arg = TensorArg(offsets__, "offsets__", 1);
+  checkScalarType("embedding_bag_fused_rowwise", offsets_arg, kLong);
+  auto weight_arg = TensorArg(weight, "weight", 1);
+  checkScalarType("embedding_bag_fused_rowwise", weight_arg, kByte);
+  checkDim("embedding_bag_fused_rowwise", weight_arg, 2);
+  if (weight.size(1) < int64_t(2 * sizeof(float))) {
+    AT_ERROR("embedding_bag_fused_rowwise: rows should have at least %d bytes "
+             "for the scale and the bias, got %lld", (int)(2 * sizeof(float)),
+             (long long)weight.size(1));
+  }
+  Tensor indices = indices__.contiguous();
+  Tensor offsets = offsets__.contiguous();
+  Tensor per_sample_weights;
+  if (per_sample_weights__.defined()) {
+    auto per_sample_weights_arg = TensorArg(per_sample_weights__, "per_sample_weights", 6);
+    checkScalarType("embedding_bag_fused_rowwise", per_sample_weights_arg, kFloat);
+    checkSameSize("embedding_bag_fused_rowwise", indices_arg, per_sample_weights_arg);
+    per_sample_weights = per_sample_weights__.contiguous();
+  }
+
+  Tensor weight_rows = weight.stride(1) == 1 ? weight : weight.contiguous();
+  int64_t ddim = (weight.size(1) - 2 * sizeof(float)) * (8 / bits);
+  auto output = at::CPU(kFloat).tensor({offsets.size(0), ddim});
+  fused_rowwise_embedding_bag_kernel(output, weight_rows, indices, offsets,
+                                     per_sample_weights, bits,
+                                     mode == 1 /* MODE_MEAN */);
+  return output;
+}
 }
 } // namespace at::native
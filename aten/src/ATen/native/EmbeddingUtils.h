@@ -0,0 +1,32 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+namespace at { namespace native {
+
+// The positions of the indices of an embedding lookup, grouped by index:
+// segment s holds the positions order[offsets[s] : offsets[s + 1]] of the
+// occurrences of unique[s], in increasing position. unique is sorted, so the
+// gradient rows built from the segments form a coalesced sparse tensor.
+struct IndexSegments {
+  Tensor order;
+  Tensor offsets;
+  Tensor unique;
+
+  int64_t size() const { return unique.size(0); }
+};
+
+// Groups the (contiguous) indices with a parallel radix sort, dropping the
+// occurrences of padding_idx. Throws if an index is not in [0, num_weights).
+IndexSegments segment_indices(const Tensor& indices, int64_t num_weights,
+                              int64_t padding_idx);
+
+// Gradient of a (num_weights, grad.size(1)) weight from the segments, dense or
+// as a coalesced sparse tensor: the row of index unique[s] is the sum over
+// the positions p of segment s of scales[p] * grad[src_rows[p]]. src_rows and
+// scales are optional, see embedding_backward_fn.
+Tensor embedding_backward_from_segments(const Tensor& grad, const IndexSegments& segments,
+                                        const Tensor& src_rows, const Tensor& scales,
+                                        int64_t num_weights, bool sparse);
+
+}} // namespace at::native
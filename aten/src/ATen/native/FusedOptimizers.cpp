@@ -0,0 +1,151 @@
+#include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/FusedOptimizers.h"
+
+#include <cmath>
+
+namespace at { namespace native {
+
+void check_fused_step_list(CheckedFrom c, TensorList params, TensorList list,
+                           const char* name, bool optional, bool same_type) {
+  if (list.empty() && optional) {
+    return;
+  }
+  if (list.size() != params.size()) {
+    AT_ERROR("%s: expected %s to have %lld tensors, like params, but got %lld",
+             c, name, (long long)params.size(), (long long)list.size());
+  }
+  for (size_t i = 0; i < list.size(); i++) {
+    TensorArg param_arg{params[i], "params", static_cast<int>(i)};
+    TensorArg arg{list[i], name, static_cast<int>(i)};
+    checkContiguous(c, arg);
+    checkSameNumel(c, arg, param_arg);
+    if (same_type) {
+      checkSameType(c, arg, TensorArg{params[0], "params", 0});
+    }
+  }
+}
+
+namespace {
+
+// The grads of a step in the type of the params: the model_params type
+// ones of a master weights step are converted
+static std::vector<Tensor> grads_like_params(TensorList params, TensorList grads) {
+  std::vector<Tensor> result;
+  result.reserve(grads.size());
+  for (size_t i = 0; i < grads.size(); i++) {
+    result.push_back(grads[i].type() == params[i].type() ? grads[i] : grads[i].toType(params[i].type()));
+  }
+  return result;
+}
+
+static void check_grads_type(CheckedFrom c, TensorList params, TensorList grads,
+                             TensorList model_params) {
+  for (size_t i = 0; i < grads.size(); i++) {
+    if (grads[i].type() != params[i].type() &&
+        (model_params.empty() || grads[i].type() != model_params[i].type())) {
+      AT_ERROR("%s: expected grads[%lld] to have the type of its param or model param, "
+               "but got %s", c, (long long)i, grads[i].type().toString());
+    }
+  }
+}
+
+// The updates of torch.optim.SGD and torch.optim.Adam, with the same
+// operations in the same order, in the type of the params
+template <typename scalar_t>
+static void sgd_step_kernel(scalar_t* param, const scalar_t* grad, scalar_t* buf, int64_t numel,
+                            scalar_t lr, scalar_t weight_decay, scalar_t momentum,
+                            scalar_t dampening, bool nesterov, bool first_step) {
+  parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      scalar_t d = grad[i];
+      if (weight_decay != 0) {
+        d += weight_decay * param[i];
+      }
+      if (buf) {
+        buf[i] = first_step ? d : momentum * buf[i] + (1 - dampening) * d;
+        d = nesterov ? d + momentum * buf[i] : buf[i];
+      }
+      param[i] -= lr * d;
+    }
+  });
+}
+
+template <typename scalar_t>
+static void adam_step_kernel(scalar_t* param, const scalar_t* grad, scalar_t* exp_avg,
+                             scalar_t* exp_avg_sq, int64_t numel, scalar_t step_size,
+                             scalar_t beta1, scalar_t beta2, scalar_t eps, scalar_t weight_decay) {
+  parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      scalar_t g = grad[i];
+      if (weight_decay != 0) {
+        g += weight_decay * param[i];
+      }
+      exp_avg[i] = beta1 * exp_avg[i] + (1 - beta1) * g;
+      exp_avg_sq[i] = beta2 * exp_avg_sq[i] + (1 - beta2) * g * g;
+      param[i] -= step_size * exp_avg[i] / (std::sqrt(exp_avg_sq[i]) + eps);
+    }
+  });
+}
+
+} // anonymous namespace
+
+void _fused_sgd_step_cpu(TensorList params, TensorList grads_, TensorList momentum_buffers,
+                         TensorList model_params, double lr, double weight_decay,
+                         double momentum, double dampening, bool nesterov, bool first_step) {
+  CheckedFrom c = "_fused_sgd_step";
+  check_fused_step_list(c, params, params, "params", false, true);
+  check_fused_step_list(c, params, grads_, "grads", false, false);
+  check_fused_step_list(c, params, momentum_buffers, "momentum_buffers", true, true);
+  check_fused_step_list(c, params, model_params, "model_params", true, false);
+  check_grads_type(c, params, grads_, model_params);
+  if (params.empty()) {
+    return;
+  }
+
+  auto grads = grads_like_params(params, grads_);
+  AT_DISPATCH_FLOATING_TYPES(params[0].type(), "_fused_sgd_step", [&] {
+    for (size_t t = 0; t < params.size(); t++) {
+      scalar_t* buf = momentum_buffers.empty() ? nullptr : momentum_buffers[t].data<scalar_t>();
+      sgd_step_kernel<scalar_t>(params[t].data<scalar_t>(), grads[t].data<scalar_t>(), buf,
+                                params[t].numel(), lr, weight_decay, momentum, dampening,
+                                nesterov, first_step);
+      if (!model_params.empty()) {
+        Tensor model_param = model_params[t];
+        model_param.copy_(params[t]);
+      }
+    }
+  });
+}
+
+void _fused_adam_step_cpu(TensorList params, TensorList grads_, TensorList exp_avgs,
+                          TensorList exp_avg_sqs, TensorList model_params, double step_size,
+                          double beta1, double beta2, double eps, double weight_decay) {
+  CheckedFrom c = "_fused_adam_step";
+  check_fused_step_list(c, params, params, "params", false, true);
+  check_fused_step_list(c, params, grads_, "grads", false, false);
+  check_fused_step_list(c, params, exp_avgs, "exp_avgs", false, true);
+  check_fused_step_list(c, params, exp_avg_sqs, "exp_avg_sqs", false, true);
+  check_fused_step_list(c, params, model_params, "model_params", true, false);
+  check_grads_type(c, params, grads_, model_params);
+  if (params.empty()) {
+    return;
+  }
+
+  auto grads = grads_like_params(params, grads_);
+  AT_DISPATCH_FLOATING_TYPES(params[0].type(), "_fused_adam_step", [&] {
+    for (size_t t = 0; t < params.size(); t++) {
+      adam_step_kernel<scalar_t>(params[t].data<scalar_t>(), grads[t].data<scalar_t>(),
+                                 exp_avgs[t].data<scalar_t>(), exp_avg_sqs[t].data<scalar_t>(),
+                                 params[t].numel(), step_size, beta1, beta2, eps, weight_decay);
+      if (!model_params.empty()) {
+        Tensor model_param = model_params[t];
+        model_param.copy_(params[t]);
+      }
+    }
+  });
+}
+
+}} // namespace at::native
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/TensorUtils.h>
+
+namespace at { namespace native {
+
+// Checks a list of a fused optimizer step against its params: the list is
+// as long as params (or empty, if optional), and each of its tensors is
+// contiguous and as large as its param. With same_type, they also have the
+// type of the first param.
+void check_fused_step_list(CheckedFrom c, TensorList params, TensorList list,
+                           const char* name, bool optional, bool same_type);
+
+}} // namespace at::native
@@ -20,11 +20,17 @@
 // Note 2: The behavior is more complicated when the index tensors are not all
 // adjacent (e.g. x[[0, 1], :, [2, 3]]). In this case, self and the index
 // tensors are transposed to the front: x.transpose(1, 2)[[0, 1], [2, 3]]
+//
+// index() gathers with _index(), which computes the offset of every row of the
+// result from the strides of the indices. index_put_() builds the linear index
+// of the assigned elements and calls put_().
 
 
 #include "ATen/ATen.h"
 #include "ATen/NativeFunctions.h"
 #include "ATen/ExpandUtils.h"
+#include "ATen/native/IndexingUtils.h"
+#include "ATen/native/cpu/IndexKernel.h"
 
 #include <algorithm>
 #include <functional>
@@ -205,40 +211,70 @@ static bool hasEmptyTensor(TensorList tensors) {
   return false;
 }
 
-static std::tuple<Tensor, Tensor> makeLinearIndex(Tensor self, TensorList orig) {
-  checkIndexTensorTypes(orig);
-  // first expand ByteTensor (boolean masks) into 1 or more LongTensors
-  auto indices = expandByteTensors(self, orig);
-  if (hasEmptyTensor(indices)) {
-    return std::make_tuple(self, self.type().toScalarType(kLong).tensor());
-  }
-  // next broadcast all index tensors together
+// Broadcasts the (long) indices together and adds missing null indices so
+// that there is one per dimension of self. If the non-null indices are not all
+// adjacent, self and the indices are transposed together so that they're
+// adjacent at the front.
+static std::tuple<Tensor, std::vector<Tensor>>
+broadcastIndices(Tensor self, std::vector<Tensor> indices) {
   indices = expand_outplace(indices);
-  // add missing null Tensors so that it matches self.dim()
   while (indices.size() < (size_t)self.dim()) {
     indices.emplace_back();
   }
-  // if the non-null indices are not all adjacent, transpose self and indices
-  // together so that they're adjacent at the front
   if (!hasContiguousSubspace(indices)) {
     std::tie(self, indices) = transposeToFront(self, indices);
   }
+  return std::make_tuple(self, std::move(indices));
+}
+
+static std::tuple<Tensor, Tensor> makeLinearIndex(Tensor self, TensorList orig) {
+  checkIndexTensorTypes(orig);
+  // first expand ByteTensor (boolean masks) into 1 or more LongTensors
+  auto indices = expandByteTensors(self, orig);
+  if (hasEmptyTensor(indices)) {
+    return std::make_tuple(self, self.type().toScalarType(kLong).tensor());
+  }
+  std::tie(self, indices) = broadcastIndices(self, std::move(indices));
   auto linearIndex = computeLinearIndex(self, indices);
   return std::make_tuple(self, linearIndex);
 }
 
-Tensor index(const Tensor & self, TensorList indices) {
-  if (indices.size() > (size_t)self.dim()) {
+Tensor index(const Tensor & self, TensorList orig) {
+  if (orig.size() > (size_t)self.dim()) {
    AT_ERROR("too many indices for tensor of dimension %d (got %d)",
-      (int)self.dim(), (int)indices.size());
+      (int)self.dim(), (int)orig.size());
   }
 
-  Tensor src, linearIndex;
-  std::tie(src, linearIndex) = makeLinearIndex(self, indices);
-  return src.take(linearIndex);
+  checkIndexTensorTypes(orig);
+  auto indices = expandByteTensors(self, orig);
+  if (hasEmptyTensor(indices) ||
+      std::none_of(indices.begin(), indices.end(), [](const Tensor& index) { return index.defined(); })) {
+    Tensor src, linearIndex;
+    std::tie(src, linearIndex) = makeLinearIndex(self, orig);
+    return src.take(linearIndex);
+  }
+  // Gather with the strides of the indices instead of building the linear
+  // index, which has the size of the result. Indices are moved to the backend
+  // of self, which allows e.g. indexing a cuda tensor with a cpu tensor.
+  Tensor src;
+  std::tie(src, indices) = broadcastIndices(self, std::move(indices));
+  Type& longType = src.type().toScalarType(kLong);
+  for (auto& index : indices) {
+    if (index.defined()) {
+      index = index.toType(longType);
+    }
+  }
+  return at::_index(src, indices);
+}
+
+Tensor _index_cpu(const Tensor & self, TensorList indices) {
+  auto dims = checkIndexedDims(self, indices);
+  auto result = self.type().tensor(dims.result_sizes);
+  index_kernel(result, self, indices, dims.begin, dims.end);
+  return result;
 }
 
-Tensor & index_put_(Tensor & self, TensorList indices, const Tensor & value) {
+Tensor & index_put_(Tensor & self, TensorList indices, const Tensor & value, bool accumulate) {
   if (indices.size() > (size_t)self.dim()) {
    AT_ERROR("too many indices for tensor of dimension %d (got %d)",
       (int)self.dim(), (int)indices.size());
@@ -247,7 +283,7 @@ Tensor & index_put_(Tensor & self, TensorList indices, const Tensor & value) {
   Tensor src, linearIndex, expandedValue;
   std::tie(src, linearIndex) = makeLinearIndex(self, indices);
   std::tie(expandedValue) = expand_inplace(linearIndex, value);
-  return src.put_(linearIndex, expandedValue);
+  return src.put_(linearIndex, expandedValue, accumulate);
 }
 
 Tensor & index_copy_(Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+#include <sstream>
+#include <vector>
+
+namespace at { namespace native {
+
+// The layout of _index(self, indices): there is one index per dimension of
+// self, and the defined ones index the adjacent dimensions [begin, end) and
+// all have the same shape. The result has the sizes of self with these
+// dimensions replaced by the shape of the indices.
+struct IndexedDims {
+  int64_t begin;
+  int64_t end;
+  std::vector<int64_t> result_sizes;
+};
+
+static inline IndexedDims checkIndexedDims(const Tensor& self, TensorList indices) {
+  if ((int64_t)indices.size() != self.dim()) {
+    AT_ERROR("_index(): expected %d indices (got %d)", (int)self.dim(), (int)indices.size());
+  }
+  IndexedDims dims{-1, -1, {}};
+  for (int64_t i = 0; i < self.dim(); i++) {
+    if (!indices[i].defined()) {
+      continue;
+    }
+    if (dims.end != -1 && dims.end != i) {
+      AT_ERROR("_index(): the indexed dimensions must be adjacent");
+    }
+    if (dims.begin == -1) {
+      dims.begin = i;
+    } else if (!indices[i].sizes().equals(indices[dims.begin].sizes())) {
+      std::stringstream ss;
+      ss << "_index(): indices of shape " << indices[dims.begin].sizes()
+         << " and " << indices[i].sizes() << " are not broadcast together";
+      throw std::runtime_error(ss.str());
+    }
+    if (indices[i].type().scalarType() != kLong) {
+      AT_ERROR("_index(): expected long indices");
+    }
+    dims.end = i + 1;
+  }
+  if (dims.begin == -1) {
+    AT_ERROR("_index(): expected at least one index");
+  }
+  auto sizes = self.sizes();
+  dims.result_sizes.insert(dims.result_sizes.end(), sizes.begin(), sizes.begin() + dims.begin);
+  auto index_sizes = indices[dims.begin].sizes();
+  dims.result_sizes.insert(dims.result_sizes.end(), index_sizes.begin(), index_sizes.end());
+  dims.result_sizes.insert(dims.result_sizes.end(), sizes.begin() + dims.end, sizes.end());
+  return dims;
+}
+
+}} // namespace at::native
@@ -1,6 +1,7 @@
 #include "ATen/ATen.h"
 #include "ATen/ExpandUtils.h"
 #include "ATen/NativeFunctions.h"
+#include <algorithm>
 #include <functional>
 #include <numeric>
 #include <vector>
@@ -114,10 +115,38 @@ Tensor& ger_out(Tensor& result, const Tensor& self, const Tensor& vec2) {
   return at::_ger_out(result, self, vec2);
 }
 
+static inline bool is_cpu_half(const Tensor& self) {
+  return !self.type().is_cuda() && self.type().scalarType() == kHalf;
+}
+
+// Rows of self converted to float at a time by the CPU Half product
+constexpr int64_t HALF_MM_BLOCK_ROWS = 256;
+
+// There is no Half BLAS on the CPU, so the product is computed in float, one
+// block of rows of self at a time: only mat2 is held in float in full.
+static Tensor& half_mm_out_cpu(Tensor& result, const Tensor& self, const Tensor& mat2) {
+  if (self.dim() != 2 || mat2.dim() != 2) {
+    AT_ERROR("mm: expected 2D tensors, got %lldD and %lldD",
+             (long long)self.dim(), (long long)mat2.dim());
+  }
+  int64_t rows = self.size(0);
+  auto mat2_float = mat2.toType(kFloat);
+  result.resize_({rows, mat2.size(1)});
+  for (int64_t r = 0; r < rows; r += HALF_MM_BLOCK_ROWS) {
+    int64_t n = std::min(HALF_MM_BLOCK_ROWS, rows - r);
+    result.narrow(0, r, n).copy_(self.narrow(0, r, n).toType(kFloat).mm(mat2_float));
+  }
+  return result;
+}
+
 Tensor mm(const Tensor& self, const Tensor& mat2) {
   if (self.is_sparse()) {
     return mat2.type().addmm(at::zeros(mat2.type(), {}), self, mat2, 0, 1);
   }
+  if (is_cpu_half(self)) {
+    Tensor result = self.type().tensor();
+    return half_mm_out_cpu(result, self, mat2);
+  }
   return self.type()._mm(self, mat2);
 }
 
@@ -125,6 +154,9 @@ Tensor& mm_out(Tensor& result, const Tensor& self, const Tensor& mat2) {
   if (self.is_sparse()) {
     return mat2.type().addmm_out(result, at::zeros(mat2.type(), {}), self, mat2, 0, 1);
   }
+  if (is_cpu_half(self)) {
+    return half_mm_out_cpu(result, self, mat2);
+  }
   return self.type()._mm_out(result, self, mat2);
 }
 
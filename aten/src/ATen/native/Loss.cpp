@@ -1,5 +1,10 @@
 #include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/TensorUtils.h"
+
+#include <algorithm>
+#include <cmath>
 
 #define EPSILON 1e-12
 
@@ -71,4 +76,111 @@ Tensor margin_ranking_loss(const Tensor& input1, const Tensor& input2, const Ten
   }
   return output;
 }
+
+Tensor cross_entropy_loss(const Tensor& self, const Tensor& target, double label_smoothing,
+                          int64_t ignore_index, bool size_average, bool reduce) {
+  auto losses = std::get<0>(at::_cross_entropy_forward(self, target, label_smoothing, ignore_index));
+
+  if (reduce && size_average) {
+    // Like nll_loss, a batch with every target ignored has a loss of 0
+    auto count = target.ne(ignore_index).toType(losses.type()).sum();
+    return losses.sum() / count.clamp_min(1);
+  } else if (reduce) {
+    return losses.sum();
+  }
+  return losses;
+}
+
+// The loss against target distribution q = (1 - eps) * onehot(t) + eps / C
+// is  logsumexp(x) - (1 - eps) * x[t] - eps / C * sum(x),  and its gradient
+// with respect to x is  softmax(x) - q.  Rows whose target is ignore_index
+// have zero loss and gradient.
+std::tuple<Tensor, Tensor> _cross_entropy_forward_cpu(const Tensor& self_, const Tensor& target_,
+                                                      double label_smoothing, int64_t ignore_index) {
+  auto self_arg = TensorArg(self_, "self", 1);
+  auto target_arg = TensorArg(target_, "target", 2);
+  checkDim("cross_entropy_forward", self_arg, 2);
+  checkDim("cross_entropy_forward", target_arg, 1);
+  checkScalarType("cross_entropy_forward", target_arg, kLong);
+  checkSize("cross_entropy_forward", target_arg, 0, self_.size(0));
+
+  auto self = self_.contiguous();
+  auto target = target_.contiguous();
+  int64_t batch_size = self.size(0);
+  int64_t num_classes = self.size(1);
+  auto losses = self.type().tensor({batch_size});
+  auto logsumexp = self.type().tensor({batch_size});
+  auto target_data = target.data<int64_t>();
+
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "cross_entropy_forward", [&] {
+    auto self_data = self.data<scalar_t>();
+    auto losses_data = losses.data<scalar_t>();
+    auto lse_data = logsumexp.data<scalar_t>();
+    scalar_t smooth = label_smoothing / num_classes;
+
+    for (int64_t i = 0; i < batch_size; i++) {
+      const scalar_t* row = self_data + i * num_classes;
+      scalar_t max_input = *std::max_element(row, row + num_classes);
+      scalar_t sum_exp = 0;
+      scalar_t sum_input = 0;
+      for (int64_t j = 0; j < num_classes; j++) {
+        sum_exp += std::exp(row[j] - max_input);
+        sum_input += row[j];
+      }
+      lse_data[i] = max_input + std::log(sum_exp);
+
+      int64_t t = target_data[i];
+      if (t == ignore_index) {
+        losses_data[i] = 0;
+        continue;
+      }
+      if (t < 0 || t >= num_classes) {
+        AT_ERROR("cross_entropy_forward: target %lld is out of range for %lld classes",
+                 (long long)t, (long long)num_classes);
+      }
+      losses_data[i] = lse_data[i] - (1 - label_smoothing) * row[t] - smooth * sum_input;
+    }
+  });
+
+  return std::make_tuple(losses, logsumexp);
+}
+
+Tensor _cross_entropy_backward_cpu(const Tensor& grad_output, const Tensor& self_, const Tensor& target_,
+                                   const Tensor& logsumexp_, double label_smoothing,
+                                   int64_t ignore_index) {
+  auto self = self_.contiguous();
+  auto target = target_.contiguous();
+  auto grad = grad_output.contiguous();
+  auto logsumexp = logsumexp_.contiguous();
+  int64_t batch_size = self.size(0);
+  int64_t num_classes = self.size(1);
+  auto grad_input = self.type().tensor(self.sizes());
+  auto target_data = target.data<int64_t>();
+
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "cross_entropy_backward", [&] {
+    auto self_data = self.data<scalar_t>();
+    auto grad_data = grad.data<scalar_t>();
+    auto lse_data = logsumexp.data<scalar_t>();
+    auto grad_input_data = grad_input.data<scalar_t>();
+    scalar_t smooth = label_smoothing / num_classes;
+
+    for (int64_t i = 0; i < batch_size; i++) {
+      const scalar_t* row = self_data + i * num_classes;
+      scalar_t* grad_row = grad_input_data + i * num_classes;
+      int64_t t = target_data[i];
+      if (t == ignore_index) {
+        std::fill(grad_row, grad_row + num_classes, scalar_t(0));
+        continue;
+      }
+      scalar_t g = grad_data[i];
+      for (int64_t j = 0; j < num_classes; j++) {
+        grad_row[j] = g * (std::exp(row[j] - lse_data[i]) - smooth);
+      }
+      grad_row[t] -= g * (1 - label_smoothing);
+    }
+  });
+
+  return grad_input;
+}
+
 }}  // namespace at::native
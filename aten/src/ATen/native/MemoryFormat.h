@@ -0,0 +1,44 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+namespace at { namespace native {
+
+// Tensors have no layout tag: a 4-d NCHW tensor is "channels last" (NHWC)
+// when its strides are the ones of x.permute(0, 2, 3, 1).contiguous()
+// viewed back as NCHW, i.e. the channels are the innermost dimension in
+// memory. Kernels that can read and write that layout directly (MKL-DNN
+// convolution, the elementwise kernels) keep it instead of calling
+// contiguous(), so a chain of such ops doesn't transpose in between.
+//
+// Strides of size 1 dimensions are ignored, like in is_contiguous().
+inline bool is_channels_last(const Tensor& self) {
+  if (self.dim() != 4) {
+    return false;
+  }
+  static constexpr int nhwc_order[] = {1, 3, 2, 0};
+  int64_t expected = 1;
+  for (auto d : nhwc_order) {
+    if (self.size(d) != 1 && self.stride(d) != expected) {
+      return false;
+    }
+    expected *= self.size(d);
+  }
+  // a tensor that is also contiguous is treated as NCHW
+  return !self.is_contiguous();
+}
+
+// Allocates an NCHW-shaped tensor with the channels last layout
+inline Tensor empty_channels_last(const Type& type, IntList sizes) {
+  return type.tensor({sizes[0], sizes[2], sizes[3], sizes[1]}).permute({0, 3, 1, 2});
+}
+
+// Allocates a tensor of the shape of self, channels last if self is
+inline Tensor empty_with_layout_of(const Tensor& self) {
+  if (is_channels_last(self)) {
+    return empty_channels_last(self.type(), self.sizes());
+  }
+  return self.type().tensor(self.sizes());
+}
+
+}} // namespace at::native
@@ -1,5 +1,7 @@
 #include "ATen/ATen.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/MemoryFormat.h"
+#include "ATen/native/cpu/BatchNormKernel.h"
 
 #include "ATen/Config.h"
 #if AT_CUDNN_ENABLED()
@@ -65,11 +67,46 @@ Tensor batch_norm(
                         training, momentum, eps));
   }
 #endif
+
+  auto same_type = [&](const Tensor& t) {
+    return !t.defined() || t.type() == input.type();
+  };
+  if (!input.type().is_cuda() && input.dim() >= 2 &&
+      (input.type().scalarType() == kFloat || input.type().scalarType() == kDouble) &&
+      same_type(weight) && same_type(bias) && same_type(running_mean) && same_type(running_var)) {
+    return std::get<0>(at::_batch_norm_cpu(
+                        input, weight, bias,
+                        running_mean, running_var, training, momentum, eps, false));
+  }
   return at::thnn_batch_norm(
             input, weight, bias,
             running_mean, running_var, training, momentum, eps);
 }
 
+std::tuple<Tensor,Tensor,Tensor> _batch_norm_cpu(
+    const Tensor& self, const Tensor& weight /* optional */, const Tensor& bias /* optional */,
+    const Tensor& running_mean /* optional */, const Tensor& running_var /* optional */,
+    bool training, double momentum, double eps, bool relu) {
+  if (self.dim() < 2) {
+    AT_ERROR("_batch_norm_cpu(): expected an input with at least 2 dimensions (got %d)",
+             (int)self.dim());
+  }
+  if (!training && (!running_mean.defined() || !running_var.defined())) {
+    AT_ERROR("_batch_norm_cpu(): running_mean and running_var must be defined in evaluation mode");
+  }
+  Tensor input = is_channels_last(self) ? self : self.contiguous();
+  // contiguous inputs with one element per channel and sample (e.g. N x C)
+  // are rows of channels too
+  bool channels_last = is_channels_last(input) || input.numel() == input.size(0) * input.size(1);
+  Tensor output = empty_with_layout_of(input);
+  auto num_features = input.size(1);
+  Tensor save_mean = input.type().tensor({num_features});
+  Tensor save_invstd = input.type().tensor({num_features});
+  batch_norm_kernel(output, save_mean, save_invstd, input, weight, bias,
+                    running_mean, running_var, channels_last, training, momentum, eps, relu);
+  return std::make_tuple(output, save_mean, save_invstd);
+}
+
 Tensor layer_norm(const Tensor& input, IntList normalized_shape,
     const Tensor& weight /* optional */, const Tensor& bias /* optional */,
     double eps, bool cudnn_enabled) {
@@ -120,6 +157,23 @@ Tensor layer_norm(const Tensor& input, IntList normalized_shape,
       n *= input_shape[i];
     }
 
+    // On CUDA, the fused kernels compute the statistics of each row in a
+    // single pass, and the affine transform with the normalization
+    if (input.type().is_cuda() &&
+        (!weight.defined() || weight.type() == input.type()) &&
+        (!bias.defined() || bias.type() == input.type())) {
+      int64_t m = 1;
+      for (auto size : normalized_shape) {
+        m *= size;
+      }
+      auto out = std::get<0>(at::_layer_norm_forward(
+          input.contiguous(),
+          weight.defined() ? weight.contiguous().view({m}) : weight,
+          bias.defined() ? bias.contiguous().view({m}) : bias,
+          n, m, eps));
+      return out.view(input_shape);
+    }
+
     // Apply layer norm
     auto input_reshaped = input.contiguous().view({1, n, -1});
 
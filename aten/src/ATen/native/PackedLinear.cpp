@@ -0,0 +1,121 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
+#include "ATen/TensorUtils.h"
+
+#include <algorithm>
+
+namespace at { namespace native {
+
+namespace {
+
+// The packed weight is made of ceil(out_features / kPanelWidth) panels, each
+// of them in_features x kPanelWidth contiguous floats: panel p holds the
+// output features [p * kPanelWidth, (p + 1) * kPanelWidth), zero padded.
+constexpr int64_t kPanelWidth = 8;
+// rows of the input computed together, which read each panel once
+constexpr int64_t kRows = 4;
+
+int64_t num_panels(int64_t out_features) {
+  return (out_features + kPanelWidth - 1) / kPanelWidth;
+}
+
+// output[0:rows, 0:cols] = input[0:rows] * panel (+ bias), with a full
+// kPanelWidth wide accumulator that the compiler keeps in vector registers
+template <int64_t rows>
+void linear_panel(int64_t K, const float* input, const float* panel,
+                  const float* bias, int64_t cols, float* output, int64_t ldo) {
+  float acc[rows][kPanelWidth] = {};
+  for (int64_t k = 0; k < K; ++k) {
+    const float* w = panel + k * kPanelWidth;
+    for (int64_t i = 0; i < rows; ++i) {
+      const float x = input[i * K + k];
+      for (int64_t j = 0; j < kPanelWidth; ++j) {
+        acc[i][j] += x * w[j];
+      }
+    }
+  }
+  for (int64_t i = 0; i < rows; ++i) {
+    for (int64_t j = 0; j < cols; ++j) {
+      output[i * ldo + j] = acc[i][j] + (bias ? bias[j] : 0.f);
+    }
+  }
+}
+
+} // anonymous namespace
+
+Tensor _pack_linear_weight_cpu(const Tensor& weight_) {
+  CheckedFrom c = "_pack_linear_weight";
+  TensorArg weight_arg{weight_, "weight", 1};
+  checkDim(c, weight_arg, 2);
+  checkScalarType(c, weight_arg, kFloat);
+  auto weight = weight_.contiguous();
+  int64_t N = weight.size(0);
+  int64_t K = weight.size(1);
+  auto packed = weight.type().zeros({num_panels(N) * K * kPanelWidth});
+  const float* w = weight.data<float>();
+  float* p = packed.data<float>();
+  for (int64_t n = 0; n < N; ++n) {
+    float* panel = p + (n / kPanelWidth) * K * kPanelWidth + n % kPanelWidth;
+    for (int64_t k = 0; k < K; ++k) {
+      panel[k * kPanelWidth] = w[n * K + k];
+    }
+  }
+  return packed;
+}
+
+Tensor _packed_linear_cpu(const Tensor& input_, const Tensor& packed_weight,
+                          const Tensor& bias_, int64_t out_features) {
+  CheckedFrom c = "_packed_linear";
+  TensorArg input_arg{input_, "input", 1}, packed_arg{packed_weight, "packed_weight", 2};
+  checkScalarType(c, input_arg, kFloat);
+  checkScalarType(c, packed_arg, kFloat);
+  checkContiguous(c, packed_arg);
+  if (input_.dim() == 0) {
+    AT_ERROR("_packed_linear: expected an input with at least 1 dimension");
+  }
+  int64_t K = input_.size(-1);
+  int64_t N = out_features;
+  if (packed_weight.numel() != num_panels(N) * K * kPanelWidth) {
+    AT_ERROR("_packed_linear: packed_weight doesn't hold a %lld x %lld weight",
+             (long long)N, (long long)K);
+  }
+  Tensor bias;
+  if (bias_.defined()) {
+    checkScalarType(c, TensorArg{bias_, "bias", 3}, kFloat);
+    if (bias_.numel() != N) {
+      AT_ERROR("_packed_linear: expected a bias of %lld elements", (long long)N);
+    }
+    bias = bias_.contiguous();
+  }
+  auto input = input_.contiguous();
+  auto output_size = input.sizes().vec();
+  output_size.back() = N;
+  auto output = input.type().tensor(output_size);
+  int64_t M = N == 0 ? 0 : output.numel() / N;
+
+  const float* x = input.data<float>();
+  const float* p = packed_weight.data<float>();
+  const float* b = bias.defined() ? bias.data<float>() : nullptr;
+  float* y = output.data<float>();
+  // each panel writes its own columns of the output
+  parallel_for(0, num_panels(N), internal::GRAIN_SIZE / std::max<int64_t>(M * K, 1),
+               [&](int64_t begin, int64_t end) {
+    for (int64_t panel = begin; panel < end; ++panel) {
+      int64_t n = panel * kPanelWidth;
+      const float* w = p + panel * K * kPanelWidth;
+      int64_t cols = std::min(kPanelWidth, N - n);
+      const float* panel_bias = b ? b + n : nullptr;
+      int64_t m = 0;
+      for (; m + kRows <= M; m += kRows) {
+        linear_panel<kRows>(K, x + m * K, w, panel_bias, cols, y + m * N + n, N);
+      }
+      for (; m < M; ++m) {
+        linear_panel<1>(K, x + m * K, w, panel_bias, cols, y + m * N + n, N);
+      }
+    }
+  });
+  return output;
+}
+
+}} // namespace at::native
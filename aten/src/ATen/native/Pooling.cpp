@@ -1,7 +1,10 @@
 #include "ATen/ATen.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/MemoryFormat.h"
+#include "ATen/native/cpu/PoolingKernel.h"
 
+#include <cmath>
 #include <sstream>
 #include <vector>
 
@@ -54,15 +57,136 @@ std::tuple<Tensor,Tensor> max_pool1d(
   check1d("dilation", dilation);
 
   Tensor output, indices;
-  std::tie(output, indices) = at::max_pool2d(
+  std::tie(output, indices) = at::_max_pool2d(
       self.unsqueeze(2),
       {1, kernel_size[0]},
       {1, stride[0]},
       {0, padding[0]},
       {1, dilation[0]},
-      ceil_mode);
+      ceil_mode,
+      true);
 
   return std::make_tuple(output.squeeze(2), indices.squeeze(2));
 }
 
+static void check2d(const char* function, const char* name, IntList x) {
+  if (x.size() != 2) {
+    std::ostringstream ss;
+    ss << function << "() argument '" << name << "' should contain two ints (got "
+       << x.size() << ")";
+    throw std::runtime_error(ss.str());
+  }
+}
+
+// Checks the arguments of a 2d pooling and sizes its output like THNN does
+static Pool2dParams pool2d_params(
+    const char* function, const Tensor& self, IntList kernel_size, IntList stride,
+    IntList padding, IntList dilation, bool ceil_mode) {
+  if (self.dim() != 3 && self.dim() != 4) {
+    AT_ERROR("%s(): expected a 3D or 4D input (got %d dimensions)", function, (int)self.dim());
+  }
+  check2d(function, "kernel_size", kernel_size);
+  check2d(function, "stride", stride);
+  check2d(function, "padding", padding);
+  check2d(function, "dilation", dilation);
+  Pool2dParams p;
+  p.kH = kernel_size[0];
+  p.kW = kernel_size[1];
+  p.dH = stride[0];
+  p.dW = stride[1];
+  p.padH = padding[0];
+  p.padW = padding[1];
+  p.dilationH = dilation[0];
+  p.dilationW = dilation[1];
+  if (p.kH <= 0 || p.kW <= 0 || p.dH <= 0 || p.dW <= 0 ||
+      p.dilationH <= 0 || p.dilationW <= 0) {
+    AT_ERROR("%s(): kernel size, stride and dilation should be greater than zero", function);
+  }
+  if (p.kW / 2 < p.padW || p.kH / 2 < p.padH) {
+    AT_ERROR("%s(): pad should be smaller than half of kernel size, but got padW = %d, "
+             "padH = %d, kW = %d, kH = %d", function, (int)p.padW, (int)p.padH,
+             (int)p.kW, (int)p.kH);
+  }
+
+  int64_t H = self.size(-2);
+  int64_t W = self.size(-1);
+  auto output_size = [&](int64_t size, int64_t k, int64_t pad, int64_t s, int64_t d) {
+    float span = (float)(size - (d * (k - 1) + 1) + 2 * pad) / s;
+    return (int64_t)(ceil_mode ? std::ceil(span) : std::floor(span)) + 1;
+  };
+  p.OH = output_size(H, p.kH, p.padH, p.dH, p.dilationH);
+  p.OW = output_size(W, p.kW, p.padW, p.dW, p.dilationW);
+  if (p.padW || p.padH) {
+    // ensure that the last pooling starts inside the image
+    if ((p.OH - 1) * p.dH >= H + p.padH) --p.OH;
+    if ((p.OW - 1) * p.dW >= W + p.padW) --p.OW;
+  }
+  if (p.OH < 1 || p.OW < 1) {
+    AT_ERROR("%s(): given input size (%dx%d), the calculated output size (%dx%d) is too small",
+             function, (int)H, (int)W, (int)p.OH, (int)p.OW);
+  }
+  return p;
+}
+
+// A 4-d view of self, either channels last or contiguous, which are the
+// layouts the pooling kernels read
+static Tensor pooling_input(const Tensor& self) {
+  Tensor input = self.dim() == 3 ? self.unsqueeze(0) : self;
+  return is_channels_last(input) ? input : input.contiguous();
+}
+
+static Tensor pooling_output(const Tensor& input, const Type& type, const Pool2dParams& p) {
+  std::vector<int64_t> sizes = {input.size(0), input.size(1), p.OH, p.OW};
+  return input.is_contiguous() ? type.tensor(sizes) : empty_channels_last(type, sizes);
+}
+
+std::tuple<Tensor,Tensor> _max_pool2d_cpu(
+    const Tensor& self, IntList kernel_size, IntList stride, IntList padding,
+    IntList dilation, bool ceil_mode, bool return_indices) {
+  if (stride.empty()) {
+    stride = kernel_size;
+  }
+  auto p = pool2d_params("max_pool2d", self, kernel_size, stride, padding, dilation, ceil_mode);
+  auto input = pooling_input(self);
+  auto output = pooling_output(input, input.type(), p);
+  Tensor indices;
+  if (return_indices) {
+    indices = pooling_output(input, input.type().toScalarType(kLong), p);
+  }
+  max_pool2d_kernel(output, indices, input, p);
+  if (self.dim() == 3) {
+    output = output.squeeze(0);
+    if (return_indices) {
+      indices = indices.squeeze(0);
+    }
+  }
+  return std::make_tuple(output, indices);
+}
+
+std::tuple<Tensor,Tensor> _max_pool2d_cuda(
+    const Tensor& self, IntList kernel_size, IntList stride, IntList padding,
+    IntList dilation, bool ceil_mode, bool return_indices) {
+  // THCUNN always computes the indices
+  return at::max_pool2d(self, kernel_size, stride, padding, dilation, ceil_mode);
+}
+
+Tensor _avg_pool2d_cpu(
+    const Tensor& self, IntList kernel_size, IntList stride, IntList padding,
+    bool ceil_mode, bool count_include_pad) {
+  if (stride.empty()) {
+    stride = kernel_size;
+  }
+  auto p = pool2d_params("avg_pool2d", self, kernel_size, stride, padding, {1, 1}, ceil_mode);
+  auto input = pooling_input(self);
+  auto output = pooling_output(input, input.type(), p);
+  avg_pool2d_kernel(output, input, p, count_include_pad);
+  return self.dim() == 3 ? output.squeeze(0) : output;
+}
+
+Tensor _avg_pool2d_cuda(
+    const Tensor& self, IntList kernel_size, IntList stride, IntList padding,
+    bool ceil_mode, bool count_include_pad) {
+  return at::avg_pool2d(self, kernel_size, stride, padding, ceil_mode, count_include_pad);
+}
+
 }}  // namespace at::native
@@ -0,0 +1,105 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/TensorUtils.h"
+#include "ATen/native/cpu/RNNCellKernel.h"
+
+#include <tuple>
+
+namespace at { namespace native {
+
+namespace {
+
+// Checks the gates, state and optional biases of a fused cell with num_gates
+// chunks per row
+void check_rnn_cell_args(CheckedFrom c, const Tensor& input_gates, const Tensor& hidden_gates,
+                         const Tensor& state, const Tensor& input_bias,
+                         const Tensor& hidden_bias, int64_t num_gates) {
+  TensorArg input_gates_arg{input_gates, "input_gates", 1};
+  TensorArg hidden_gates_arg{hidden_gates, "hidden_gates", 2};
+  TensorArg state_arg{state, "hidden", 3};
+  checkDim(c, state_arg, 2);
+  checkSize(c, input_gates_arg, {state.size(0), num_gates * state.size(1)});
+  checkSameSize(c, input_gates_arg, hidden_gates_arg);
+  checkAllSameType(c, {input_gates_arg, hidden_gates_arg, state_arg});
+  if (input_bias.defined() != hidden_bias.defined()) {
+    AT_ERROR("%s: expected both input_bias and hidden_bias, or none of them", c);
+  }
+  if (input_bias.defined()) {
+    TensorArg input_bias_arg{input_bias, "input_bias", 4};
+    TensorArg hidden_bias_arg{hidden_bias, "hidden_bias", 5};
+    checkNumel(c, input_bias_arg, num_gates * state.size(1));
+    checkNumel(c, hidden_bias_arg, num_gates * state.size(1));
+    checkAllSameType(c, {input_gates_arg, input_bias_arg, hidden_bias_arg});
+  }
+}
+
+Tensor contiguous_if_defined(const Tensor& t) {
+  return t.defined() ? t.contiguous() : t;
+}
+
+} // anonymous namespace
+
+std::tuple<Tensor, Tensor, Tensor> _thnn_fused_lstm_cell_cpu(
+    const Tensor& input_gates, const Tensor& hidden_gates, const Tensor& cx_,
+    const Tensor& input_bias, const Tensor& hidden_bias) {
+  check_rnn_cell_args("_thnn_fused_lstm_cell", input_gates, hidden_gates, cx_,
+                      input_bias, hidden_bias, 4);
+  auto cx = cx_.contiguous();
+  auto hy = cx.type().tensor(cx.sizes());
+  auto cy = cx.type().tensor(cx.sizes());
+  auto workspace = cx.type().tensor(input_gates.sizes());
+  lstm_cell_kernel(hy, cy, workspace, input_gates.contiguous(), hidden_gates.contiguous(),
+                   cx, contiguous_if_defined(input_bias), contiguous_if_defined(hidden_bias));
+  return std::make_tuple(hy, cy, workspace);
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _thnn_fused_lstm_cell_backward_cpu(
+    const Tensor& grad_hy, const Tensor& grad_cy, const Tensor& cx_, const Tensor& cy,
+    const Tensor& workspace, bool has_bias) {
+  auto cx = cx_.contiguous();
+  auto grad_gates = cx.type().tensor(workspace.sizes());
+  auto grad_cx = cx.type().tensor(cx.sizes());
+  lstm_cell_backward_kernel(grad_gates, grad_cx, contiguous_if_defined(grad_hy),
+                            contiguous_if_defined(grad_cy), cx, cy.contiguous(),
+                            workspace.contiguous());
+  // the input and hidden gates (and biases) are summed, so share a gradient
+  Tensor grad_bias;
+  if (has_bias) {
+    grad_bias = grad_gates.sum(0);
+  }
+  return std::make_tuple(grad_gates, grad_gates, grad_cx, grad_bias, grad_bias);
+}
+
+std::tuple<Tensor, Tensor> _thnn_fused_gru_cell_cpu(
+    const Tensor& input_gates, const Tensor& hidden_gates, const Tensor& hx_,
+    const Tensor& input_bias, const Tensor& hidden_bias) {
+  check_rnn_cell_args("_thnn_fused_gru_cell", input_gates, hidden_gates, hx_,
+                      input_bias, hidden_bias, 3);
+  auto hx = hx_.contiguous();
+  auto hy = hx.type().tensor(hx.sizes());
+  auto workspace = hx.type().tensor({hx.size(0), 5 * hx.size(1)});
+  gru_cell_kernel(hy, workspace, input_gates.contiguous(), hidden_gates.contiguous(),
+                  hx, contiguous_if_defined(input_bias), contiguous_if_defined(hidden_bias));
+  return std::make_tuple(hy, workspace);
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _thnn_fused_gru_cell_backward_cpu(
+    const Tensor& grad_hy_, const Tensor& workspace, bool has_bias) {
+  auto grad_hy = grad_hy_.contiguous();
+  int64_t B = grad_hy.size(0);
+  int64_t H = grad_hy.size(1);
+  auto grad_input_gates = grad_hy.type().tensor({B, 3 * H});
+  auto grad_hidden_gates = grad_hy.type().tensor({B, 3 * H});
+  auto grad_hx = grad_hy.type().tensor({B, H});
+  gru_cell_backward_kernel(grad_input_gates, grad_hidden_gates, grad_hx, grad_hy,
+                           workspace.contiguous());
+  Tensor grad_input_bias, grad_hidden_bias;
+  if (has_bias) {
+    grad_input_bias = grad_input_gates.sum(0);
+    grad_hidden_bias = grad_hidden_gates.sum(0);
+  }
+  return std::make_tuple(grad_input_gates, grad_hidden_gates, grad_hx,
+                         grad_input_bias, grad_hidden_bias);
+}
+
+}} // namespace at::native
@@ -0,0 +1,101 @@
+#include "ATen/native/RadixSort.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "ATen/Parallel.h"
+
+namespace at { namespace native {
+
+namespace {
+
+constexpr int RADIX_BITS = 8;
+constexpr int64_t RADIX = int64_t(1) << RADIX_BITS;
+// below this, a comparison sort is faster than the radix passes
+constexpr int64_t MIN_RADIX_SIZE = 4096;
+
+} // anonymous namespace
+
+void radix_sort(const int64_t* keys, int64_t n, int64_t* sorted_keys, int64_t* order) {
+  if (n == 0) {
+    return;
+  }
+  std::iota(order, order + n, int64_t(0));
+  if (n < MIN_RADIX_SIZE) {
+    std::stable_sort(order, order + n, [&](int64_t a, int64_t b) {
+      return keys[a] < keys[b];
+    });
+    for (int64_t i = 0; i != n; i++) {
+      sorted_keys[i] = keys[order[i]];
+    }
+    return;
+  }
+
+  // sort key - min as unsigned, which also handles negative keys
+  auto minmax = std::minmax_element(keys, keys + n);
+  int64_t min = *minmax.first;
+  uint64_t range = uint64_t(*minmax.second) - uint64_t(min);
+  int passes = 0;
+  while (passes * RADIX_BITS < 64 && (range >> (passes * RADIX_BITS)) != 0) {
+    passes++;
+  }
+
+  std::vector<uint64_t> key_buf(2 * n);
+  std::vector<int64_t> order_buf(n);
+  uint64_t* src_keys = key_buf.data();
+  uint64_t* dst_keys = key_buf.data() + n;
+  int64_t* src_order = order;
+  int64_t* dst_order = order_buf.data();
+  for (int64_t i = 0; i != n; i++) {
+    src_keys[i] = uint64_t(keys[i]) - uint64_t(min);
+  }
+
+  // fixed chunks, each counted and scattered by one thread
+  int64_t chunk_size = std::max<int64_t>(internal::GRAIN_SIZE, (n + 255) / 256);
+  int64_t num_chunks = (n + chunk_size - 1) / chunk_size;
+  std::vector<int64_t> offsets(num_chunks * RADIX);
+  for (int pass = 0; pass != passes; pass++) {
+    int shift = pass * RADIX_BITS;
+    std::fill(offsets.begin(), offsets.end(), 0);
+    parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c != end; c++) {
+        int64_t* hist = &offsets[c * RADIX];
+        for (int64_t i = c * chunk_size; i != std::min(n, (c + 1) * chunk_size); i++) {
+          hist[(src_keys[i] >> shift) & (RADIX - 1)]++;
+        }
+      }
+    });
+    // digit-major exclusive scan: chunk c writes digit d after the earlier
+    // chunks' elements with the same digit, which keeps the sort stable
+    int64_t total = 0;
+    for (int64_t d = 0; d != RADIX; d++) {
+      for (int64_t c = 0; c != num_chunks; c++) {
+        int64_t count = offsets[c * RADIX + d];
+        offsets[c * RADIX + d] = total;
+        total += count;
+      }
+    }
+    parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c != end; c++) {
+        int64_t* pos = &offsets[c * RADIX];
+        for (int64_t i = c * chunk_size; i != std::min(n, (c + 1) * chunk_size); i++) {
+          int64_t p = pos[(src_keys[i] >> shift) & (RADIX - 1)]++;
+          dst_keys[p] = src_keys[i];
+          dst_order[p] = src_order[i];
+        }
+      }
+    });
+    std::swap(src_keys, dst_keys);
+    std::swap(src_order, dst_order);
+  }
+
+  if (src_order != order) {
+    std::copy(src_order, src_order + n, order);
+  }
+  for (int64_t i = 0; i != n; i++) {
+    sorted_keys[i] = int64_t(src_keys[i] + uint64_t(min));
+  }
+}
+
+}} // namespace at::native
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+namespace at { namespace native {
+
+// Stable sort of n int64_t keys, returning the sorted keys in sorted_keys and
+// the position in keys of every sorted key in order (both arrays of n), so
+// that sorted_keys[i] == keys[order[i]]. Equal keys keep their order.
+//
+// Runs as a least significant digit radix sort, 8 bits per pass and only as
+// many passes as the range of the keys needs, with the histograms and the
+// scatters of every pass split between threads. Because the sort is stable,
+// the result doesn't depend on the number of threads.
+AT_API void radix_sort(const int64_t* keys, int64_t n, int64_t* sorted_keys, int64_t* order);
+
+}} // namespace at::native
@@ -17,22 +17,34 @@ namespace native {
 
 // ALL REDUCE #################################################################
 
+static std::vector<int64_t> _all_dims(const Tensor& self) {
+  std::vector<int64_t> dims(self.dim());
+  std::iota(dims.begin(), dims.end(), 0);
+  return dims;
+}
+
+// BFloat16 has no arithmetic of its own: it is reduced as float, and the
+// result rounded back.
+static inline bool is_cpu_bfloat16(const Tensor& self) {
+  return !self.type().is_cuda() && self.type().scalarType() == kBFloat16;
+}
+
 Tensor _sum_cpu(const Tensor& self) {
-  if (self.is_contiguous()) {
-    Tensor result = self.type().tensor({});
-    sum_kernel(result, self, at::nullopt);
-    return result;
+  if (is_cpu_bfloat16(self)) {
+    return _sum_cpu(self.toType(kFloat)).toType(self.type());
   }
-  return self._sumall();
+  Tensor result = self.type().tensor({});
+  sum_kernel(result, self, _all_dims(self));
+  return result;
 }
 
 Tensor _prod_cpu(const Tensor &self) {
-  if (self.is_contiguous()) {
-    Tensor result = self.type().tensor({});
-    prod_kernel(result, self, at::nullopt);
-    return result;
+  if (is_cpu_bfloat16(self)) {
+    return _prod_cpu(self.toType(kFloat)).toType(self.type());
   }
-  return self._prodall();
+  Tensor result = self.type().tensor({});
+  prod_kernel(result, self, _all_dims(self));
+  return result;
 }
 
 Tensor _sum_cuda(const Tensor &self_) { return self_._sumall(); }
@@ -59,47 +71,79 @@ static bool _dimreduce_return_trivial(Tensor &result, const Tensor &self,
   return false;
 }
 
+static std::vector<int64_t> _wrap_dims(IntList dims_, int64_t ndim) {
+  std::vector<int64_t> dims;
+  for (auto dim : dims_) {
+    dims.push_back(maybe_wrap_dim(dim, ndim));
+  }
+  std::sort(dims.begin(), dims.end());
+  if (std::adjacent_find(dims.begin(), dims.end()) != dims.end()) {
+    throw std::runtime_error("dim appears multiple times in the list of reduced dims");
+  }
+  return dims;
+}
+
 static Tensor &_dimreduce_setup(Tensor &result, const Tensor &self,
-                                int64_t dim) {
-  IntList self_sizes = self.sizes();
-  std::vector<int64_t> result_sizes;
-  result_sizes.insert(result_sizes.end(), self_sizes.begin(), self_sizes.end());
-  result_sizes[dim] = 1;
+                                IntList dims) {
+  std::vector<int64_t> result_sizes = self.sizes();
+  for (auto dim : dims) {
+    result_sizes[dim] = 1;
+  }
   result.resize_(result_sizes);
   return result;
 }
 
-Tensor &_sum_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
+Tensor &_sum_out_cpu(Tensor &result, const Tensor &self, IntList dims_,
                      bool keepdim) {
-  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  if (is_cpu_bfloat16(self)) {
+    Tensor result_float = self.type().toScalarType(kFloat).tensor();
+    _sum_out_cpu(result_float, self.toType(kFloat), dims_, keepdim);
+    result.resize_(result_float.sizes());
+    return result.copy_(result_float);
+  }
+  auto dims = _wrap_dims(dims_, self.dim());
   if (_dimreduce_return_trivial(result, self, 0))
     return result;
-  if (self.is_contiguous() && result.is_contiguous()) {
-    _dimreduce_setup(result, self, dim);
-    sum_kernel(result, self, dim);
-    if (!keepdim) result.squeeze_(dim);
-    return result;
+  _dimreduce_setup(result, self, dims);
+  sum_kernel(result, self, dims);
+  if (!keepdim) {
+    for (auto it = dims.rbegin(); it != dims.rend(); ++it) {
+      result.squeeze_(*it);
+    }
   }
-  return at::_sum_out(result, self, dim, keepdim);
+  return result;
 }
 
 Tensor &_prod_out_cpu(Tensor &result, const Tensor &self, int64_t dim_,
                       bool keepdim) {
+  if (is_cpu_bfloat16(self)) {
+    Tensor result_float = self.type().toScalarType(kFloat).tensor();
+    _prod_out_cpu(result_float, self.toType(kFloat), dim_, keepdim);
+    result.resize_(result_float.sizes());
+    return result.copy_(result_float);
+  }
   int64_t dim = maybe_wrap_dim(dim_, self.dim());
   if (_dimreduce_return_trivial(result, self, 1))
     return result;
-  if (self.is_contiguous() && result.is_contiguous()) {
-    _dimreduce_setup(result, self, dim);
-    prod_kernel(result, self, dim);
-    if (!keepdim) result.squeeze_(dim);
-    return result;
-  }
-  return at::_prod_out(result, self, dim, keepdim);
+  _dimreduce_setup(result, self, dim);
+  prod_kernel(result, self, dim);
+  if (!keepdim) result.squeeze_(dim);
+  return result;
 }
 
-Tensor &_sum_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
+Tensor &_sum_out_cuda(Tensor &result, const Tensor &self, IntList dims_,
                       bool keepdim) {
-  return at::_sum_out(result, self, dim, keepdim);
+  auto dims = _wrap_dims(dims_, self.dim());
+  if (dims.size() == 1) {
+    return at::_sum_out(result, self, dims[0], keepdim);
+  }
+  // reduce the highest dims first, so the remaining ones keep their position
+  Tensor partial = self;
+  for (auto it = dims.rbegin(); it != dims.rend(); ++it) {
+    partial = at::_sum(partial, *it, keepdim);
+  }
+  result.resize_as_(partial);
+  return result.copy_(partial);
 }
 
 Tensor &_prod_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
@@ -107,8 +151,7 @@ Tensor &_prod_out_cuda(Tensor &result, const Tensor &self, int64_t dim,
   return at::_prod_out(result, self, dim, keepdim);
 }
 
-Tensor sum(const Tensor &self, int64_t dim_, bool keepdim) {
-  int64_t dim = maybe_wrap_dim(dim_, self.dim());
+Tensor sum(const Tensor &self, IntList dim, bool keepdim) {
   Tensor result = self.type().tensor();
   return at::sum_out(result, self, dim, keepdim);
 }
@@ -0,0 +1,42 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/WrapDimUtils.h"
+#include "ATen/native/cpu/SoftmaxKernel.h"
+
+namespace at { namespace native {
+
+// The CPU kernels replace THNN's, which loop one slice at a time without
+// vectorizing (see cpu/SoftmaxKernel.cpp). The backward is still THNN's.
+
+static Tensor softmax_cpu(const Tensor& self, int64_t dim, bool log) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  auto input = self.contiguous();
+  auto output = input.type().tensor(input.sizes());
+  if (input.numel() == 0) {
+    return output;
+  }
+  if (log) {
+    log_softmax_kernel(output, input, dim);
+  } else {
+    softmax_kernel(output, input, dim);
+  }
+  return output;
+}
+
+Tensor _softmax_cpu(const Tensor& self, int64_t dim) {
+  return softmax_cpu(self, dim, false);
+}
+
+Tensor _softmax_cuda(const Tensor& self, int64_t dim) {
+  return at::softmax(self, dim);
+}
+
+Tensor _log_softmax_cpu(const Tensor& self, int64_t dim) {
+  return softmax_cpu(self, dim, true);
+}
+
+Tensor _log_softmax_cuda(const Tensor& self, int64_t dim) {
+  return at::log_softmax(self, dim);
+}
+
+}}  // namespace at::native
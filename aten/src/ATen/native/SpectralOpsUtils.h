@@ -1,8 +1,17 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <stdexcept>
 #include <sstream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 namespace at { namespace native {
 
@@ -34,4 +43,86 @@ inline int64_t infer_ft_complex_to_real_onesided_size(int64_t complex_size, int6
   }
 }
 
+// A bounded LRU cache of FFT plans (cuFFT plans, MKL DFTI descriptors),
+// which cost much more to create than running a small transform. Keys are
+// POD structs compared and hashed byte by byte, so they should be memset to
+// zero before being filled in.
+//
+// A plan is taken out of the cache while it runs and put back afterwards, so
+// that concurrent transforms never share one. The cache holds at most
+// TORCH_FFT_PLAN_CACHE_SIZE plans (32 by default, 0 disables it) of every
+// kind.
+constexpr size_t kDefaultFFTPlanCacheSize = 32;
+
+template <typename Key>
+struct FFTPlanKeyHash {
+  size_t operator()(const Key& key) const {
+    static_assert(std::is_pod<Key>::value, "FFT plan keys should be POD");
+    auto ptr = reinterpret_cast<const uint8_t*>(&key);
+    uint32_t value = 0x811C9DC5;
+    for (size_t i = 0; i < sizeof(Key); ++i) {
+      value ^= ptr[i];
+      value *= 0x01000193;
+    }
+    return (size_t)value;
+  }
+};
+
+template <typename Key>
+struct FFTPlanKeyEqual {
+  bool operator()(const Key& a, const Key& b) const {
+    return std::memcmp(&a, &b, sizeof(Key)) == 0;
+  }
+};
+
+template <typename Key, typename Plan>
+class FFTPlanCache {
+public:
+  FFTPlanCache() : max_size_(kDefaultFFTPlanCacheSize) {
+    const char* env = std::getenv("TORCH_FFT_PLAN_CACHE_SIZE");
+    if (env) {
+      max_size_ = std::strtoul(env, nullptr, 10);
+    }
+  }
+
+  // Returns nullptr if there is no plan for key
+  std::unique_ptr<Plan> take(const Key& key) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return nullptr;
+    }
+    auto plan = std::move(it->second->second);
+    lru_.erase(it->second);
+    map_.erase(it);
+    return plan;
+  }
+
+  // Keeps the plan as the most recently used one, unless another plan for
+  // the same key was put back first.
+  void put(const Key& key, std::unique_ptr<Plan> plan) {
+    std::unique_ptr<Plan> evicted;  // destroyed after the lock is released
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (max_size_ == 0 || map_.count(key)) {
+      return;
+    }
+    if (lru_.size() >= max_size_) {
+      evicted = std::move(lru_.back().second);
+      map_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+    lru_.emplace_front(key, std::move(plan));
+    map_.emplace(key, lru_.begin());
+  }
+
+private:
+  using Entry = std::pair<Key, std::unique_ptr<Plan>>;
+
+  std::mutex mutex_;
+  std::list<Entry> lru_;  // the most recently used first
+  std::unordered_map<Key, typename std::list<Entry>::iterator,
+                     FFTPlanKeyHash<Key>, FFTPlanKeyEqual<Key>> map_;
+  size_t max_size_;
+};
+
 }} // at::native
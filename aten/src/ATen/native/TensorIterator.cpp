@@ -0,0 +1,65 @@
+#include "ATen/native/TensorIterator.h"
+
+#include <numeric>
+#include <sstream>
+
+namespace at { namespace native {
+
+TensorIterator::TensorIterator(ArrayRef<Tensor> tensors)
+  : ntensors_(tensors.size()) {
+  AT_ASSERT(ntensors_ > 0, "TensorIterator: expected at least one tensor");
+  auto shape = tensors[0].sizes();
+  for (auto& t : tensors) {
+    if (!t.sizes().equals(shape)) {
+      std::ostringstream ss;
+      ss << "TensorIterator: all tensors must have the same shape, got "
+         << shape << " and " << t.sizes();
+      throw std::runtime_error(ss.str());
+    }
+  }
+  numel_ = std::accumulate(shape.begin(), shape.end(), int64_t(1), std::multiplies<int64_t>());
+
+  // Dimensions of size 1 don't affect the iteration. Sort the others from
+  // the smallest stride to the largest, looking at the first tensor and
+  // breaking ties with the following ones.
+  std::vector<int64_t> perm;
+  for (int64_t dim = 0; dim < (int64_t) shape.size(); dim++) {
+    if (shape[dim] != 1) {
+      perm.push_back(dim);
+    }
+  }
+  std::stable_sort(perm.begin(), perm.end(), [&](int64_t a, int64_t b) {
+    for (auto& t : tensors) {
+      if (t.stride(a) != t.stride(b)) {
+        return t.stride(a) < t.stride(b);
+      }
+    }
+    // equal strides: iterate the later (inner in C order) dimension first
+    return a > b;
+  });
+
+  for (auto dim : perm) {
+    // merge with the previous dimension if stepping over it in every tensor
+    // lands exactly on the next element of this dimension
+    bool can_merge = !sizes_.empty();
+    int prev = sizes_.size() - 1;
+    for (int arg = 0; can_merge && arg < ntensors_; arg++) {
+      can_merge = strides_[prev * ntensors_ + arg] * sizes_[prev] == tensors[arg].stride(dim);
+    }
+    if (can_merge) {
+      sizes_[prev] *= shape[dim];
+      continue;
+    }
+    sizes_.push_back(shape[dim]);
+    for (auto& t : tensors) {
+      strides_.push_back(t.stride(dim));
+    }
+  }
+  if (sizes_.empty()) {
+    // every dimension has size 1 (or this is a scalar)
+    sizes_.push_back(1);
+    strides_.resize(ntensors_, 0);
+  }
+}
+
+}} // namespace at::native
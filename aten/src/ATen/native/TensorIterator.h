@@ -0,0 +1,103 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <algorithm>
+#include <vector>
+
+namespace at { namespace native {
+
+// Walks tensors of the same shape elementwise as a series of 1-d inner
+// loops, so that kernels written for contiguous data also apply to
+// transposed, sliced or otherwise strided tensors.
+//
+// The dimensions are ordered by the strides of the first tensor (usually the
+// output), so that it is traversed in memory order, and adjacent dimensions
+// that are contiguous with each other in every tensor are merged to make the
+// inner loops as long as possible. Contiguous tensors end up as a single
+// inner loop.
+//
+// Example:
+//   TensorIterator iter({result, self});
+//   parallel_for(0, iter.numel(), grain_size, [&](int64_t begin, int64_t end) {
+//     iter.for_each(begin, end, [&](const int64_t* offsets, int64_t size) {
+//       // size elements of result starting at offsets[0], iter.inner_stride(0)
+//       // apart, and of self starting at offsets[1], iter.inner_stride(1) apart
+//     });
+//   });
+struct AT_API TensorIterator {
+  explicit TensorIterator(ArrayRef<Tensor> tensors);
+
+  int ntensors() const { return ntensors_; }
+  int ndim() const { return sizes_.size(); }
+  int64_t numel() const { return numel_; }
+  // sizes of the coalesced dimensions, innermost first
+  IntList sizes() const { return sizes_; }
+  int64_t inner_size() const { return sizes_[0]; }
+  // stride in elements of tensor arg along dimension dim (innermost first)
+  int64_t stride(int dim, int arg) const { return strides_[dim * ntensors_ + arg]; }
+  int64_t inner_stride(int arg) const { return strides_[arg]; }
+
+  // Calls f(offsets, size) for pieces of inner loops covering the elements
+  // [begin, end) in iteration order. offsets[arg] is the offset in elements
+  // of the first element of the piece in tensor arg (relative to its data
+  // pointer). The first and last pieces may be partial inner loops, so the
+  // range can be split arbitrarily, e.g. by parallel_for.
+  template <typename F>
+  void for_each(int64_t begin, int64_t end, const F& f) const {
+    if (begin >= end) {
+      return;
+    }
+    int64_t inner = inner_size();
+    int64_t inner_index = begin % inner;
+    int64_t outer_index = begin / inner;
+    std::vector<int64_t> counter(ndim(), 0);
+    std::vector<int64_t> offsets(ntensors_, 0);
+    for (int dim = 1; dim < ndim(); dim++) {
+      counter[dim] = outer_index % sizes_[dim];
+      outer_index /= sizes_[dim];
+      for (int arg = 0; arg < ntensors_; arg++) {
+        offsets[arg] += counter[dim] * stride(dim, arg);
+      }
+    }
+    for (int arg = 0; arg < ntensors_; arg++) {
+      offsets[arg] += inner_index * inner_stride(arg);
+    }
+
+    int64_t remaining = end - begin;
+    while (true) {
+      int64_t size = std::min(inner - inner_index, remaining);
+      f(static_cast<const int64_t*>(offsets.data()), size);
+      remaining -= size;
+      if (remaining == 0) {
+        return;
+      }
+      // rewind to the start of this inner loop and step to the next one
+      for (int arg = 0; arg < ntensors_; arg++) {
+        offsets[arg] -= inner_index * inner_stride(arg);
+      }
+      inner_index = 0;
+      for (int dim = 1; dim < ndim(); dim++) {
+        counter[dim]++;
+        for (int arg = 0; arg < ntensors_; arg++) {
+          offsets[arg] += stride(dim, arg);
+        }
+        if (counter[dim] < sizes_[dim]) {
+          break;
+        }
+        for (int arg = 0; arg < ntensors_; arg++) {
+          offsets[arg] -= counter[dim] * stride(dim, arg);
+        }
+        counter[dim] = 0;
+      }
+    }
+  }
+
+private:
+  int ntensors_;
+  int64_t numel_;
+  std::vector<int64_t> sizes_;
+  // strides_[dim * ntensors_ + arg]
+  std::vector<int64_t> strides_;
+};
+
+}} // namespace at::native
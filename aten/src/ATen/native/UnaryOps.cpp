@@ -3,6 +3,7 @@
 #include "ATen/ExpandUtils.h"
 #include "ATen/NativeFunctions.h"
 #include "ATen/WrapDimUtils.h"
+#include "ATen/native/MemoryFormat.h"
 #include "cpu/UnaryOpsKernel.h"
 
 #include <algorithm>
@@ -14,37 +15,45 @@
 
 namespace at { namespace native {
 
-#define IMPLEMENT_UNARY_OP(op)                                                \
+// th_op is the TH binding used for CUDA tensors. The result of op(self) has
+// the layout of self when self is channels last.
+#define IMPLEMENT_UNARY_OP_TH(op, th_op)                                      \
 Tensor op(const Tensor& self) {                                               \
-  Tensor result = self.type().tensor();                                       \
+  Tensor result = empty_with_layout_of(self);                                 \
   return at::op ## _out(result, self);                                        \
 }                                                                             \
 Tensor& op##_(Tensor& self) {                                                 \
   return at::op ## _out(self, self);                                          \
 }                                                                             \
 Tensor& _ ## op ## _out_cuda(Tensor& result, const Tensor& self) {            \
-  return at::_ ## op ## _out(result, self);                                   \
+  return at::th_op ## _out(result, self);                                     \
 }                                                                             \
 Tensor& _ ## op ## _out_cpu(Tensor& result, const Tensor& self) {             \
-  if (result.is_contiguous() && self.is_contiguous()) {                       \
-    result.resize_(self.sizes());                                             \
-    if (result.numel() > 0) {                                                 \
-      op ## Impl(result, self);                                               \
-    }                                                                         \
-    return result;                                                            \
+  result.resize_(self.sizes());                                               \
+  if (result.numel() > 0) {                                                   \
+    op ## Impl(result, self);                                                 \
   }                                                                           \
-  return at::_ ## op ## _out(result, self);                                   \
+  return result;                                                              \
 }
 
+#define IMPLEMENT_UNARY_OP(op) IMPLEMENT_UNARY_OP_TH(op, _ ## op)
+
 IMPLEMENT_UNARY_OP(abs)
 IMPLEMENT_UNARY_OP(ceil)
 IMPLEMENT_UNARY_OP(cos)
+IMPLEMENT_UNARY_OP(erf)
 IMPLEMENT_UNARY_OP(exp)
+IMPLEMENT_UNARY_OP(expm1)
 IMPLEMENT_UNARY_OP(floor)
 IMPLEMENT_UNARY_OP(log)
+IMPLEMENT_UNARY_OP(log1p)
 IMPLEMENT_UNARY_OP(round)
+IMPLEMENT_UNARY_OP(rsqrt)
 IMPLEMENT_UNARY_OP(sin)
 IMPLEMENT_UNARY_OP(sqrt)
 IMPLEMENT_UNARY_OP(trunc)
+// _sigmoid and _tanh are the THNN bindings (nn.yaml)
+IMPLEMENT_UNARY_OP_TH(sigmoid, _th_sigmoid)
+IMPLEMENT_UNARY_OP_TH(tanh, _th_tanh)
 
 }} // namespace at::native
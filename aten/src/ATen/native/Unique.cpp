@@ -2,57 +2,136 @@
 
 #include "ATen/ATen.h"
 #include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/RadixSort.h"
 
-#include <set>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <tuple>
-#include <unordered_map>
-#include <unordered_set>
+#include <type_traits>
+#include <vector>
 
 namespace at {
 namespace native{
 
 namespace {
 
+// Integer keys with the order of the values, for radix_sort.
 template <typename scalar_t>
-std::tuple<Tensor, Tensor> _unique_cpu_template(
+typename std::enable_if<std::is_integral<scalar_t>::value, int64_t>::type
+sort_key(scalar_t value) {
+  return static_cast<int64_t>(value);
+}
+
+// The bits of a float, with the magnitude bits flipped for negative values,
+// compare like the float. -0 is folded into 0 so that they are one value.
+template <typename scalar_t>
+typename std::enable_if<std::is_floating_point<scalar_t>::value, int64_t>::type
+sort_key(scalar_t value) {
+  using bits_t = typename std::conditional<sizeof(scalar_t) == 4, int32_t, int64_t>::type;
+  if (value == 0) {
+    value = 0;
+  }
+  bits_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits >= 0 ? bits : bits ^ std::numeric_limits<bits_t>::max();
+}
+
+// The input is sorted once with a parallel radix sort; the unique values
+// are the first element of every run of equal keys, so the output is always
+// sorted. Runs are numbered with a per chunk count of run starts and a scan
+// over the chunks, then every chunk writes its part of the outputs.
+template <typename scalar_t>
+std::tuple<Tensor, Tensor, Tensor> _unique_cpu_template(
     const Tensor& self,
-    const bool sorted,
-    const bool return_inverse) {
+    const bool return_inverse,
+    const bool return_counts) {
   const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data<scalar_t>();
-  std::unordered_set<scalar_t> set(input_data, input_data + input.numel());
-  Tensor output = input.type().tensor({static_cast<int64_t>(set.size())});
-  scalar_t* output_data = output.data<scalar_t>();
+  int64_t numel = input.numel();
+
+  std::vector<int64_t> keys(numel);
+  parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      keys[i] = sort_key(input_data[i]);
+    }
+  });
+  std::vector<int64_t> sorted_keys(numel);
+  std::vector<int64_t> order(numel);
+  radix_sort(keys.data(), numel, sorted_keys.data(), order.data());
 
-  if (sorted) {
-    std::vector<scalar_t> vec(set.begin(), set.end());
-    std::sort(vec.begin(), vec.end());
-    std::copy(vec.begin(), vec.end(), output_data);
-  } else {
-    std::copy(set.begin(), set.end(), output_data);
+  int64_t chunk_size = internal::GRAIN_SIZE;
+  int64_t num_chunks = (numel + chunk_size - 1) / chunk_size;
+  // number of runs starting before each chunk
+  std::vector<int64_t> chunk_runs(num_chunks + 1, 0);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t runs = 0;
+      for (int64_t i = c * chunk_size; i < std::min(numel, (c + 1) * chunk_size); i++) {
+        runs += i == 0 || sorted_keys[i] != sorted_keys[i - 1];
+      }
+      chunk_runs[c + 1] = runs;
+    }
+  });
+  for (int64_t c = 0; c < num_chunks; c++) {
+    chunk_runs[c + 1] += chunk_runs[c];
   }
+  int64_t num_unique = chunk_runs[num_chunks];
 
+  Tensor output = input.type().tensor({num_unique});
   Tensor inverse_indices = self.type().toScalarType(kLong).tensor({0});
+  Tensor counts = self.type().toScalarType(kLong).tensor({0});
   if (return_inverse) {
     inverse_indices.resize_(input.sizes());
-    int64_t* inverse_indices_data = inverse_indices.data<int64_t>();
-    std::unordered_map<scalar_t, int64_t> inverse_map;
-    inverse_map.reserve(output.numel());
-    for (int i = 0; i < output.numel(); ++i) {
-      inverse_map[output_data[i]] = i;
+  }
+  if (return_counts) {
+    counts.resize_({num_unique});
+  }
+  scalar_t* output_data = output.data<scalar_t>();
+  int64_t* inverse_data = return_inverse ? inverse_indices.data<int64_t>() : nullptr;
+  int64_t* counts_data = return_counts ? counts.data<int64_t>() : nullptr;
+
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t run = chunk_runs[c] - 1;
+      for (int64_t i = c * chunk_size; i < std::min(numel, (c + 1) * chunk_size); i++) {
+        if (i == 0 || sorted_keys[i] != sorted_keys[i - 1]) {
+          run++;
+          output_data[run] = input_data[order[i]];
+          if (counts_data) {
+            // the start of the run for now, made a count below
+            counts_data[run] = i;
+          }
+        }
+        if (inverse_data) {
+          inverse_data[order[i]] = run;
+        }
+      }
     }
-    for (int i = 0; i < input.numel(); ++i) {
-      inverse_indices_data[i] = inverse_map[input_data[i]];
+  });
+  if (counts_data) {
+    for (int64_t u = 0; u < num_unique; u++) {
+      int64_t next = u + 1 < num_unique ? counts_data[u + 1] : numel;
+      counts_data[u] = next - counts_data[u];
     }
   }
-  return std::make_tuple(output, inverse_indices);
+  return std::make_tuple(output, inverse_indices, counts);
 }
 } // namespace
 
 std::tuple<Tensor, Tensor>
 _unique_cpu(const Tensor& self, const bool sorted, const bool return_inverse) {
   return AT_DISPATCH_ALL_TYPES(self.type(), "unique", [&] {
-    return _unique_cpu_template<scalar_t>(self, sorted, return_inverse);
+    auto result = _unique_cpu_template<scalar_t>(self, return_inverse, false);
+    return std::make_tuple(std::get<0>(result), std::get<1>(result));
+  });
+}
+
+std::tuple<Tensor, Tensor, Tensor>
+_unique_with_counts_cpu(const Tensor& self, const bool sorted, const bool return_inverse) {
+  return AT_DISPATCH_ALL_TYPES(self.type(), "unique", [&] {
+    return _unique_cpu_template<scalar_t>(self, return_inverse, true);
   });
 }
 
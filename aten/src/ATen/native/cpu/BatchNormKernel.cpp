@@ -0,0 +1,279 @@
+#include "ATen/native/cpu/BatchNormKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/cpu/Vec.h"
+
+namespace at { namespace native { namespace {
+
+// The normalized output is written in blocks of this many elements, so that
+// the ReLU reads them back from L1
+constexpr int64_t kBlockSize = 1024;
+
+// Count, mean and sum of squared deviations from the mean of a set of values
+struct Moments {
+  int64_t count = 0;
+  double mean = 0;
+  double m2 = 0;
+};
+
+// The moments of the union of two disjoint sets
+static inline Moments merge(const Moments& a, const Moments& b) {
+  if (a.count == 0) {
+    return b;
+  }
+  if (b.count == 0) {
+    return a;
+  }
+  Moments result;
+  result.count = a.count + b.count;
+  double delta = b.mean - a.mean;
+  double b_fraction = (double)b.count / result.count;
+  result.mean = a.mean + delta * b_fraction;
+  result.m2 = a.m2 + b.m2 + delta * delta * a.count * b_fraction;
+  return result;
+}
+
+static inline void welford_update(Moments& m, double x) {
+  m.count++;
+  double delta = x - m.mean;
+  m.mean += delta / m.count;
+  m.m2 += delta * (x - m.mean);
+}
+
+// Welford's update of every lane of mean and m2 with the lane of x, where
+// reciprocal is 1 / the new count of values of each lane
+template <typename scalar_t>
+static inline void welford_update(Vec<scalar_t>& mean, Vec<scalar_t>& m2,
+                                  const Vec<scalar_t>& x, const Vec<scalar_t>& reciprocal) {
+  auto delta = x - mean;
+  mean = mean + delta * reciprocal;
+  m2 = m2 + delta * (x - mean);
+}
+
+// The moments of channel c of N x C x L planes. Every lane of a vector
+// accumulates its own moments, which are merged at the end.
+template <typename scalar_t>
+static Moments plane_moments(const scalar_t* in, int64_t N, int64_t C, int64_t L, int64_t c) {
+  using Vector = Vec<scalar_t>;
+  Vector mean(0), m2(0);
+  int64_t count = 0;
+  Moments result;
+  int64_t vec_end = L - L % Vector::size;
+  for (int64_t n = 0; n < N; n++) {
+    const scalar_t* row = in + (n * C + c) * L;
+    for (int64_t j = 0; j < vec_end; j += Vector::size) {
+      welford_update(mean, m2, Vector::s_load(row + j), Vector(scalar_t(1) / ++count));
+    }
+    for (int64_t j = vec_end; j < L; j++) {
+      welford_update(result, row[j]);
+    }
+  }
+  scalar_t lane_means[Vector::size];
+  scalar_t lane_m2s[Vector::size];
+  mean.store(lane_means);
+  m2.store(lane_m2s);
+  for (int64_t i = 0; i < Vector::size; i++) {
+    Moments lane;
+    lane.count = count;
+    lane.mean = lane_means[i];
+    lane.m2 = lane_m2s[i];
+    result = merge(result, lane);
+  }
+  return result;
+}
+
+// The moments of every channel of M rows of C channels. The rows are split
+// in chunks that don't depend on the number of threads, so the statistics
+// are deterministic, and within a chunk the channels are the vector lanes.
+template <typename scalar_t>
+static std::vector<Moments> channels_last_moments(const scalar_t* in, int64_t M, int64_t C) {
+  using Vector = Vec<scalar_t>;
+  int64_t rows_per_chunk = std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(C, 1));
+  int64_t num_chunks = (M + rows_per_chunk - 1) / rows_per_chunk;
+  std::vector<scalar_t> chunk_means(num_chunks * C, 0);
+  std::vector<scalar_t> chunk_m2s(num_chunks * C, 0);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t chunk = begin; chunk < end; chunk++) {
+      scalar_t* mean = chunk_means.data() + chunk * C;
+      scalar_t* m2 = chunk_m2s.data() + chunk * C;
+      int64_t row_begin = chunk * rows_per_chunk;
+      int64_t row_end = std::min(M, row_begin + rows_per_chunk);
+      for (int64_t row = row_begin; row < row_end; row++) {
+        const scalar_t* x = in + row * C;
+        scalar_t reciprocal = scalar_t(1) / (row - row_begin + 1);
+        int64_t c = 0;
+        for (; c + Vector::size <= C; c += Vector::size) {
+          auto mean_vec = Vector::s_load(mean + c);
+          auto m2_vec = Vector::s_load(m2 + c);
+          welford_update(mean_vec, m2_vec, Vector::s_load(x + c), Vector(reciprocal));
+          mean_vec.store(mean + c);
+          m2_vec.store(m2 + c);
+        }
+        for (; c < C; c++) {
+          scalar_t delta = x[c] - mean[c];
+          mean[c] += delta * reciprocal;
+          m2[c] += delta * (x[c] - mean[c]);
+        }
+      }
+    }
+  });
+  std::vector<Moments> result(C);
+  for (int64_t chunk = 0; chunk < num_chunks; chunk++) {
+    int64_t count = std::min(M, (chunk + 1) * rows_per_chunk) - chunk * rows_per_chunk;
+    for (int64_t c = 0; c < C; c++) {
+      Moments m;
+      m.count = count;
+      m.mean = chunk_means[chunk * C + c];
+      m.m2 = chunk_m2s[chunk * C + c];
+      result[c] = merge(result[c], m);
+    }
+  }
+  return result;
+}
+
+// Same as threshold(x, 0, 0), which keeps NaNs
+template <typename scalar_t>
+static inline void relu_(scalar_t* x, int64_t n) {
+  for (int64_t j = 0; j < n; j++) {
+    x[j] = x[j] <= 0 ? scalar_t(0) : x[j];
+  }
+}
+
+// out = in * scale + shift for n elements of the same channel
+template <typename scalar_t>
+static inline void transform_plane(scalar_t* out, const scalar_t* in, int64_t n,
+                                   scalar_t scale, scalar_t shift, bool relu) {
+  using Vector = Vec<scalar_t>;
+  Vector scale_vec(scale), shift_vec(shift);
+  for (int64_t block = 0; block < n; block += kBlockSize) {
+    int64_t block_end = std::min(n, block + kBlockSize);
+    int64_t j = block;
+    for (; j + Vector::size <= block_end; j += Vector::size) {
+      (Vector::s_load(in + j) * scale_vec + shift_vec).store(out + j);
+    }
+    for (; j < block_end; j++) {
+      out[j] = in[j] * scale + shift;
+    }
+    if (relu) {
+      relu_(out + block, block_end - block);
+    }
+  }
+}
+
+// out = in * scale + shift for a row of C channels
+template <typename scalar_t>
+static inline void transform_row(scalar_t* out, const scalar_t* in, int64_t C,
+                                 const scalar_t* scale, const scalar_t* shift, bool relu) {
+  using Vector = Vec<scalar_t>;
+  int64_t c = 0;
+  for (; c + Vector::size <= C; c += Vector::size) {
+    (Vector::s_load(in + c) * Vector::s_load(scale + c) + Vector::s_load(shift + c)).store(out + c);
+  }
+  for (; c < C; c++) {
+    out[c] = in[c] * scale[c] + shift[c];
+  }
+  if (relu) {
+    relu_(out, C);
+  }
+}
+
+template <typename scalar_t>
+static void batch_norm_impl(Tensor& output, Tensor& save_mean, Tensor& save_invstd,
+                            const Tensor& input, const Tensor& weight, const Tensor& bias,
+                            const Tensor& running_mean, const Tensor& running_var,
+                            bool channels_last, bool training, double momentum,
+                            double eps, bool relu) {
+  int64_t N = input.size(0);
+  int64_t C = input.size(1);
+  int64_t M = input.numel() / std::max<int64_t>(C, 1);
+  int64_t L = M / std::max<int64_t>(N, 1);
+  const scalar_t* in = input.data<scalar_t>();
+  scalar_t* out = output.data<scalar_t>();
+
+  std::vector<Moments> moments;
+  if (training) {
+    if (channels_last) {
+      moments = channels_last_moments(in, M, C);
+    } else {
+      moments.resize(C);
+      parallel_for(0, C, std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(M, 1)),
+                   [&](int64_t begin, int64_t end) {
+        for (int64_t c = begin; c < end; c++) {
+          moments[c] = plane_moments(in, N, C, L, c);
+        }
+      });
+    }
+  }
+
+  // the per channel scale and shift that the normalization and the affine
+  // transform amount to
+  std::vector<scalar_t> scale(C), shift(C);
+  auto save_mean_a = save_mean.accessor<scalar_t, 1>();
+  auto save_invstd_a = save_invstd.accessor<scalar_t, 1>();
+  for (int64_t c = 0; c < C; c++) {
+    double mean, invstd;
+    if (training) {
+      const Moments& m = moments[c];
+      mean = m.mean;
+      invstd = (m.m2 == 0 && eps == 0.0) ? 0 : 1 / std::sqrt(m.m2 / m.count + eps);
+      if (running_mean.defined()) {
+        auto running_mean_a = running_mean.accessor<scalar_t, 1>();
+        running_mean_a[c] = momentum * mean + (1 - momentum) * running_mean_a[c];
+      }
+      if (running_var.defined()) {
+        auto running_var_a = running_var.accessor<scalar_t, 1>();
+        double unbiased_var = m.m2 / (m.count - 1);
+        running_var_a[c] = momentum * unbiased_var + (1 - momentum) * running_var_a[c];
+      }
+    } else {
+      mean = running_mean.accessor<scalar_t, 1>()[c];
+      invstd = 1 / std::sqrt(running_var.accessor<scalar_t, 1>()[c] + eps);
+    }
+    save_mean_a[c] = mean;
+    save_invstd_a[c] = invstd;
+    double w = weight.defined() ? weight.accessor<scalar_t, 1>()[c] : 1;
+    double b = bias.defined() ? bias.accessor<scalar_t, 1>()[c] : 0;
+    scale[c] = w * invstd;
+    shift[c] = b - mean * w * invstd;
+  }
+
+  if (channels_last) {
+    parallel_for(0, M, std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(C, 1)),
+                 [&](int64_t begin, int64_t end) {
+      for (int64_t row = begin; row < end; row++) {
+        transform_row(out + row * C, in + row * C, C, scale.data(), shift.data(), relu);
+      }
+    });
+  } else {
+    parallel_for(0, N * C, std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(L, 1)),
+                 [&](int64_t begin, int64_t end) {
+      for (int64_t plane = begin; plane < end; plane++) {
+        int64_t c = plane % C;
+        transform_plane(out + plane * L, in + plane * L, L, scale[c], shift[c], relu);
+      }
+    });
+  }
+}
+
+static void batch_norm_kernel_impl(Tensor& output, Tensor& save_mean, Tensor& save_invstd,
+                                   const Tensor& input, const Tensor& weight, const Tensor& bias,
+                                   const Tensor& running_mean, const Tensor& running_var,
+                                   bool channels_last, bool training, double momentum,
+                                   double eps, bool relu) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "_batch_norm_cpu", [&] {
+    batch_norm_impl<scalar_t>(output, save_mean, save_invstd, input, weight, bias,
+                              running_mean, running_var, channels_last, training,
+                              momentum, eps, relu);
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(batch_norm_kernel, &batch_norm_kernel_impl);
+
+}} // namespace at::native
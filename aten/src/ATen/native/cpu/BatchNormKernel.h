@@ -0,0 +1,30 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// Batch normalization of input, which is read either as N x C x L
+// contiguous planes or, when channels_last is set, as rows of C contiguous
+// channels (channels last 4-d inputs and N x C inputs). output has the
+// layout of input.
+//
+// In training, the statistics of each channel are computed in a single
+// (Welford) pass, the running statistics are updated like THNN updates
+// them and save_mean and save_invstd get the batch mean and 1 / std.
+// Otherwise save_mean and save_invstd get the running statistics. Either
+// way the output is then one multiply-add per element with a per channel
+// scale and shift, followed by a ReLU when relu is set.
+//
+// weight, bias, running_mean and running_var are C long or undefined, and
+// save_mean and save_invstd are C long.
+using batch_norm_fn = void(*)(Tensor& output, Tensor& save_mean, Tensor& save_invstd,
+                              const Tensor& input, const Tensor& weight, const Tensor& bias,
+                              const Tensor& running_mean, const Tensor& running_var,
+                              bool channels_last, bool training, double momentum,
+                              double eps, bool relu);
+
+extern DispatchStub<batch_norm_fn> batch_norm_kernel;
+
+}} // namespace at::native
@@ -29,7 +29,7 @@
 namespace at {
 namespace native {
 
-enum class CPUCapability { DEFAULT, AVX, AVX2, NUM_OPTIONS };
+enum class CPUCapability { DEFAULT, AVX, AVX2, AVX512, NUM_OPTIONS };
 
 template <typename FnPtr>
 struct DispatchStub {
@@ -47,6 +47,10 @@ struct DispatchStub {
 // Do not use cpuinfo on PowerPC as it shows confusing errors when run on ppc
 #ifndef __powerpc__
     if (cpuinfo_initialize()) {
+      int avx512 = static_cast<int>(CPUCapability::AVX512);
+      if (!std::getenv("ATEN_DISABLE_AVX512") && cpuinfo_has_x86_avx512f() && table[avx512]) {
+        return table[avx512];
+      }
       int avx2 = static_cast<int>(CPUCapability::AVX2);
       if (!std::getenv("ATEN_DISABLE_AVX2") && cpuinfo_has_x86_avx2() && table[avx2]) {
         return table[avx2];
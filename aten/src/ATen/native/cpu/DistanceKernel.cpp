@@ -0,0 +1,309 @@
+#include "ATen/native/cpu/DistanceKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/cpu/Vec.h"
+
+namespace at { namespace native { namespace {
+
+// cdist reads the rows of x2 in tiles of about this many bytes, which stay
+// in cache while every row of x1 of a chunk is compared with them
+constexpr int64_t kTileBytes = 32 * 1024;
+
+template <typename scalar_t>
+static inline scalar_t sign(scalar_t x) {
+  return (0 < x) - (x < 0);
+}
+
+// sum of f(a[k] - b[k] + eps) over the D elements of two rows, where vf is
+// f on vectors
+template <typename scalar_t, typename F, typename VF>
+static inline scalar_t sum_diffs(const scalar_t* a, const scalar_t* b, int64_t D, scalar_t eps,
+                                 const F& f, const VF& vf) {
+  using Vector = Vec<scalar_t>;
+  Vector acc(0);
+  Vector eps_vec(eps);
+  int64_t k = 0;
+  for (; k + Vector::size <= D; k += Vector::size) {
+    acc = acc + vf(Vector::s_load(a + k) - Vector::s_load(b + k) + eps_vec);
+  }
+  scalar_t lanes[Vector::size];
+  acc.store(lanes);
+  scalar_t sum = 0;
+  for (int64_t i = 0; i < Vector::size; i++) {
+    sum += lanes[i];
+  }
+  for (; k < D; k++) {
+    sum += f(a[k] - b[k] + eps);
+  }
+  return sum;
+}
+
+// Each distance has
+//  - reduce(a, b, D, eps, p): the distance between two rows of D elements
+//  - coef(grad, dist, p) and backward(diff, coef, dist, p): the gradient wrt
+//    each difference of a distance dist with gradient grad is
+//    backward(diff, coef(grad, dist, p), dist, p), and 0 when coef is 0
+
+template <typename scalar_t>
+struct ZeroDist {
+  static inline scalar_t reduce(const scalar_t* a, const scalar_t* b, int64_t D, scalar_t eps,
+                                scalar_t p) {
+    scalar_t count = 0;
+    for (int64_t k = 0; k < D; k++) {
+      count += (a[k] - b[k] + eps) != 0;
+    }
+    return count;
+  }
+  static inline scalar_t coef(scalar_t grad, scalar_t dist, scalar_t p) {
+    return 0;
+  }
+  static inline scalar_t backward(scalar_t diff, scalar_t coef, scalar_t dist, scalar_t p) {
+    return 0;
+  }
+};
+
+template <typename scalar_t>
+struct OneDist {
+  static inline scalar_t reduce(const scalar_t* a, const scalar_t* b, int64_t D, scalar_t eps,
+                                scalar_t p) {
+    return sum_diffs(a, b, D, eps,
+                     [](scalar_t diff) { return std::abs(diff); },
+                     [](const Vec<scalar_t>& diff) { return diff.abs(); });
+  }
+  static inline scalar_t coef(scalar_t grad, scalar_t dist, scalar_t p) {
+    return grad;
+  }
+  static inline scalar_t backward(scalar_t diff, scalar_t coef, scalar_t dist, scalar_t p) {
+    return coef * sign(diff);
+  }
+};
+
+template <typename scalar_t>
+struct TwoDist {
+  static inline scalar_t reduce(const scalar_t* a, const scalar_t* b, int64_t D, scalar_t eps,
+                                scalar_t p) {
+    return std::sqrt(sum_diffs(a, b, D, eps,
+                               [](scalar_t diff) { return diff * diff; },
+                               [](const Vec<scalar_t>& diff) { return diff * diff; }));
+  }
+  static inline scalar_t coef(scalar_t grad, scalar_t dist, scalar_t p) {
+    return dist == 0 ? scalar_t(0) : grad / dist;
+  }
+  static inline scalar_t backward(scalar_t diff, scalar_t coef, scalar_t dist, scalar_t p) {
+    return coef * diff;
+  }
+};
+
+// The gradient goes to every difference that reaches the maximum
+template <typename scalar_t>
+struct InfDist {
+  static inline scalar_t reduce(const scalar_t* a, const scalar_t* b, int64_t D, scalar_t eps,
+                                scalar_t p) {
+    scalar_t max = 0;
+    for (int64_t k = 0; k < D; k++) {
+      scalar_t diff = std::abs(a[k] - b[k] + eps);
+      max = diff > max ? diff : max;
+    }
+    return max;
+  }
+  static inline scalar_t coef(scalar_t grad, scalar_t dist, scalar_t p) {
+    return grad;
+  }
+  static inline scalar_t backward(scalar_t diff, scalar_t coef, scalar_t dist, scalar_t p) {
+    return coef * sign(diff) * (std::abs(diff) == dist);
+  }
+};
+
+template <typename scalar_t>
+struct PDist {
+  static inline scalar_t reduce(const scalar_t* a, const scalar_t* b, int64_t D, scalar_t eps,
+                                scalar_t p) {
+    scalar_t sum = 0;
+    for (int64_t k = 0; k < D; k++) {
+      sum += std::pow(std::abs(a[k] - b[k] + eps), p);
+    }
+    return std::pow(sum, 1 / p);
+  }
+  static inline scalar_t coef(scalar_t grad, scalar_t dist, scalar_t p) {
+    return dist == 0 ? scalar_t(0) : grad / std::pow(dist, p - 1);
+  }
+  static inline scalar_t backward(scalar_t diff, scalar_t coef, scalar_t dist, scalar_t p) {
+    return diff == 0 ? scalar_t(0) : coef * sign(diff) * std::pow(std::abs(diff), p - 1);
+  }
+};
+
+template <typename scalar_t, typename Dist>
+struct Cdist {
+  static void apply(Tensor& result, const Tensor& x1, const Tensor& x2, scalar_t p) {
+    int64_t N = x1.size(0);
+    int64_t M = x2.size(0);
+    int64_t D = x1.size(1);
+    const scalar_t* a = x1.data<scalar_t>();
+    const scalar_t* b = x2.data<scalar_t>();
+    scalar_t* out = result.data<scalar_t>();
+    int64_t tile = std::max<int64_t>(1, kTileBytes / (std::max<int64_t>(D, 1) * sizeof(scalar_t)));
+    int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(M * D, 1));
+    parallel_for(0, N, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t j_begin = 0; j_begin < M; j_begin += tile) {
+        int64_t j_end = std::min(M, j_begin + tile);
+        for (int64_t i = begin; i < end; i++) {
+          for (int64_t j = j_begin; j < j_end; j++) {
+            out[i * M + j] = Dist::reduce(a + i * D, b + j * D, D, 0, p);
+          }
+        }
+      }
+    });
+  }
+};
+
+template <typename scalar_t, typename Dist>
+struct CdistBackward {
+  static void apply(Tensor& grad_x1, const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                    scalar_t p, const Tensor& cdist) {
+    int64_t N = x1.size(0);
+    int64_t M = x2.size(0);
+    int64_t D = x1.size(1);
+    const scalar_t* a = x1.data<scalar_t>();
+    const scalar_t* b = x2.data<scalar_t>();
+    const scalar_t* g = grad.data<scalar_t>();
+    const scalar_t* dist = cdist.data<scalar_t>();
+    scalar_t* out = grad_x1.data<scalar_t>();
+    int64_t tile = std::max<int64_t>(1, kTileBytes / (std::max<int64_t>(D, 1) * sizeof(scalar_t)));
+    int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(M * D, 1));
+    // every chunk owns its rows of grad_x1, so the sums over j need no atomics
+    parallel_for(0, N, grain_size, [&](int64_t begin, int64_t end) {
+      std::fill(out + begin * D, out + end * D, scalar_t(0));
+      for (int64_t j_begin = 0; j_begin < M; j_begin += tile) {
+        int64_t j_end = std::min(M, j_begin + tile);
+        for (int64_t i = begin; i < end; i++) {
+          const scalar_t* a_row = a + i * D;
+          scalar_t* out_row = out + i * D;
+          for (int64_t j = j_begin; j < j_end; j++) {
+            scalar_t d = dist[i * M + j];
+            scalar_t c = Dist::coef(g[i * M + j], d, p);
+            if (c == 0) {
+              continue;
+            }
+            const scalar_t* b_row = b + j * D;
+            for (int64_t k = 0; k < D; k++) {
+              out_row[k] += Dist::backward(a_row[k] - b_row[k], c, d, p);
+            }
+          }
+        }
+      }
+    });
+  }
+};
+
+template <typename scalar_t, typename Dist>
+struct PairwiseDistance {
+  static void apply(Tensor& result, const Tensor& x1, const Tensor& x2, scalar_t p,
+                    scalar_t eps) {
+    int64_t N = x1.size(0);
+    int64_t D = x1.size(1);
+    int64_t stride1 = x1.stride(0);
+    int64_t stride2 = x2.stride(0);
+    const scalar_t* a = x1.data<scalar_t>();
+    const scalar_t* b = x2.data<scalar_t>();
+    scalar_t* out = result.data<scalar_t>();
+    parallel_for(0, N, std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(D, 1)),
+                 [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        out[i] = Dist::reduce(a + i * stride1, b + i * stride2, D, eps, p);
+      }
+    });
+  }
+};
+
+template <typename scalar_t, typename Dist>
+struct PairwiseDistanceBackward {
+  static void apply(Tensor& grad_x1, const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                    scalar_t p, scalar_t eps, const Tensor& result) {
+    int64_t N = x1.size(0);
+    int64_t D = x1.size(1);
+    int64_t stride1 = x1.stride(0);
+    int64_t stride2 = x2.stride(0);
+    const scalar_t* a = x1.data<scalar_t>();
+    const scalar_t* b = x2.data<scalar_t>();
+    const scalar_t* g = grad.data<scalar_t>();
+    const scalar_t* dist = result.data<scalar_t>();
+    scalar_t* out = grad_x1.data<scalar_t>();
+    parallel_for(0, N, std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(D, 1)),
+                 [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        const scalar_t* a_row = a + i * stride1;
+        const scalar_t* b_row = b + i * stride2;
+        scalar_t* out_row = out + i * D;
+        scalar_t c = Dist::coef(g[i], dist[i], p);
+        if (c == 0) {
+          std::fill(out_row, out_row + D, scalar_t(0));
+          continue;
+        }
+        for (int64_t k = 0; k < D; k++) {
+          out_row[k] = Dist::backward(a_row[k] - b_row[k] + eps, c, dist[i], p);
+        }
+      }
+    });
+  }
+};
+
+// Runs Impl<scalar_t, Dist>::apply(args...) with the distance for p
+template <typename scalar_t, template <typename, typename> class Impl, typename... Args>
+static void dispatch_p(double p, Args&&... args) {
+  if (p == 0) {
+    Impl<scalar_t, ZeroDist<scalar_t>>::apply(std::forward<Args>(args)...);
+  } else if (p == 1) {
+    Impl<scalar_t, OneDist<scalar_t>>::apply(std::forward<Args>(args)...);
+  } else if (p == 2) {
+    Impl<scalar_t, TwoDist<scalar_t>>::apply(std::forward<Args>(args)...);
+  } else if (std::isinf(p)) {
+    Impl<scalar_t, InfDist<scalar_t>>::apply(std::forward<Args>(args)...);
+  } else {
+    Impl<scalar_t, PDist<scalar_t>>::apply(std::forward<Args>(args)...);
+  }
+}
+
+static void cdist_kernel_impl(Tensor& result, const Tensor& x1, const Tensor& x2, double p) {
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "cdist", [&] {
+    dispatch_p<scalar_t, Cdist>(p, result, x1, x2, static_cast<scalar_t>(p));
+  });
+}
+
+static void cdist_backward_kernel_impl(Tensor& grad_x1, const Tensor& grad, const Tensor& x1,
+                                       const Tensor& x2, double p, const Tensor& cdist) {
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "cdist_backward", [&] {
+    dispatch_p<scalar_t, CdistBackward>(p, grad_x1, grad, x1, x2, static_cast<scalar_t>(p),
+                                        cdist);
+  });
+}
+
+static void pairwise_distance_kernel_impl(Tensor& result, const Tensor& x1, const Tensor& x2,
+                                          double p, double eps) {
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "pairwise_distance", [&] {
+    dispatch_p<scalar_t, PairwiseDistance>(p, result, x1, x2, static_cast<scalar_t>(p),
+                                           static_cast<scalar_t>(eps));
+  });
+}
+
+static void pairwise_distance_backward_kernel_impl(Tensor& grad_x1, const Tensor& grad,
+                                                   const Tensor& x1, const Tensor& x2,
+                                                   double p, double eps, const Tensor& result) {
+  AT_DISPATCH_FLOATING_TYPES(x1.type(), "pairwise_distance_backward", [&] {
+    dispatch_p<scalar_t, PairwiseDistanceBackward>(
+        p, grad_x1, grad, x1, x2, static_cast<scalar_t>(p), static_cast<scalar_t>(eps), result);
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(cdist_kernel, &cdist_kernel_impl);
+REGISTER_DISPATCH(cdist_backward_kernel, &cdist_backward_kernel_impl);
+REGISTER_DISPATCH(pairwise_distance_kernel, &pairwise_distance_kernel_impl);
+REGISTER_DISPATCH(pairwise_distance_backward_kernel, &pairwise_distance_backward_kernel_impl);
+
+}} // namespace at::native
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// p-norm distances between the rows of N x D x1 and the rows of M x D x2,
+// both contiguous, into the N x M result. p is 0 (number of differing
+// elements), 1, 2, infinity or any other positive value.
+using cdist_fn = void(*)(Tensor& result, const Tensor& x1, const Tensor& x2, double p);
+
+// Gradient of a cdist_fn result wrt x1, for the contiguous N x M grad and
+// result. The gradient wrt x2 is the one wrt the first argument of the
+// transposed problem.
+using cdist_backward_fn = void(*)(Tensor& grad_x1, const Tensor& grad, const Tensor& x1,
+                                  const Tensor& x2, double p, const Tensor& cdist);
+
+// p-norm of x1[i] - x2[i] + eps for the rows of N x D x1 and x2, into the
+// N long result. The rows are contiguous, but their stride may be 0 for a
+// broadcast one.
+using pairwise_distance_fn = void(*)(Tensor& result, const Tensor& x1, const Tensor& x2,
+                                     double p, double eps);
+
+// Gradient of a pairwise_distance_fn result wrt x1, into the contiguous
+// N x D grad_x1. The gradient wrt x2 is its negation.
+using pairwise_distance_backward_fn = void(*)(Tensor& grad_x1, const Tensor& grad,
+                                              const Tensor& x1, const Tensor& x2,
+                                              double p, double eps, const Tensor& result);
+
+extern DispatchStub<cdist_fn> cdist_kernel;
+extern DispatchStub<cdist_backward_fn> cdist_backward_kernel;
+extern DispatchStub<pairwise_distance_fn> pairwise_distance_kernel;
+extern DispatchStub<pairwise_distance_backward_fn> pairwise_distance_backward_kernel;
+
+}} // namespace at::native
@@ -0,0 +1,131 @@
+#include "ATen/native/cpu/DistributionsKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/cpu/Vec.h"
+#include "TH/THPhilox.h"
+
+namespace at { namespace native { namespace {
+
+// Each block costs a Philox evaluation, so chunks are smaller than for
+// elementwise math
+constexpr int64_t GRAIN_BLOCKS = 2048;
+
+// The two uniforms on [0, 1) of each block of [begin, end), in x and y.
+// Floats take 24 bits of the first and third words, doubles the 53 bits of
+// each half, as in TH.
+template <typename scalar_t>
+static void philox_uniforms(
+    uint64_t seed, uint64_t offset, int64_t begin, int64_t end,
+    scalar_t* x, scalar_t* y);
+
+template <>
+void philox_uniforms<float>(
+    uint64_t seed, uint64_t offset, int64_t begin, int64_t end,
+    float* x, float* y) {
+  for (int64_t j = begin; j != end; j++) {
+    uint32_t block[4];
+    THPhilox_block(seed, offset + j, block);
+    x[j - begin] = THPhilox_uniformFloat(block[0]);
+    y[j - begin] = THPhilox_uniformFloat(block[2]);
+  }
+}
+
+template <>
+void philox_uniforms<double>(
+    uint64_t seed, uint64_t offset, int64_t begin, int64_t end,
+    double* x, double* y) {
+  for (int64_t j = begin; j != end; j++) {
+    uint32_t block[4];
+    THPhilox_block(seed, offset + j, block);
+    THPhilox_uniform2(block, &x[j - begin], &y[j - begin]);
+  }
+}
+
+// Sets the elements 2j and 2j+1 of data to the outputs of
+// f(x, y, first, second) on the uniforms of block j, in chunks of full
+// vectors.
+template <typename scalar_t, typename F>
+static void pairwise_fill(
+    scalar_t* data, int64_t size, uint64_t seed, uint64_t offset, F f) {
+  using Vector = Vec<scalar_t>;
+  constexpr int64_t BUF_SIZE = 4 * Vector::size;
+  parallel_for(0, (size + 1) / 2, GRAIN_BLOCKS, [&](int64_t begin, int64_t end) {
+    scalar_t x[BUF_SIZE] = {}, y[BUF_SIZE] = {};
+    scalar_t first[BUF_SIZE], second[BUF_SIZE];
+    for (int64_t b = begin; b < end; b += BUF_SIZE) {
+      int64_t n = std::min(BUF_SIZE, end - b);
+      philox_uniforms(seed, offset, b, b + n, x, y);
+      for (int64_t k = 0; k < n; k += Vector::size) {
+        f(Vector::s_load(x + k), Vector::s_load(y + k), first + k, second + k);
+      }
+      for (int64_t k = 0; k != n; k++) {
+        int64_t i = 2 * (b + k);
+        data[i] = first[k];
+        if (i + 1 < size) {
+          data[i + 1] = second[k];
+        }
+      }
+    }
+  });
+}
+
+static void uniform_kernel(Tensor& self, double from, double to, uint64_t seed, uint64_t offset) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "uniform", [&] {
+    using Vector = Vec<scalar_t>;
+    const Vector width(static_cast<scalar_t>(to) - static_cast<scalar_t>(from));
+    const Vector start(static_cast<scalar_t>(from));
+    pairwise_fill<scalar_t>(self.data<scalar_t>(), self.numel(), seed, offset,
+        [&](const Vector& x, const Vector& y, scalar_t* first, scalar_t* second) {
+      (x * width + start).store(first);
+      (y * width + start).store(second);
+    });
+  });
+}
+
+// Box-Muller, on both values of each pair of uniforms
+static void normal_kernel(Tensor& self, double mean, double std, uint64_t seed, uint64_t offset) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "normal", [&] {
+    using Vector = Vec<scalar_t>;
+    const Vector minus_one(-1), one(1), minus_two(-2), two_pi(2 * M_PI);
+    const Vector stdv(static_cast<scalar_t>(std)), shift(static_cast<scalar_t>(mean));
+    pairwise_fill<scalar_t>(self.data<scalar_t>(), self.numel(), seed, offset,
+        [&](const Vector& x, const Vector& y, scalar_t* first, scalar_t* second) {
+      // 1 - y is on (0, 1], for the log
+      auto radius = ((y * minus_one + one).log() * minus_two).sqrt() * stdv;
+      auto theta = x * two_pi;
+      (radius * theta.cos() + shift).store(first);
+      (radius * theta.sin() + shift).store(second);
+    });
+  });
+}
+
+static void bernoulli_kernel(Tensor& self, double p, uint64_t seed, uint64_t offset) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "bernoulli", [&] {
+    scalar_t* data = self.data<scalar_t>();
+    const int64_t size = self.numel();
+    parallel_for(0, (size + 1) / 2, GRAIN_BLOCKS, [&](int64_t begin, int64_t end) {
+      for (int64_t j = begin; j != end; j++) {
+        uint32_t block[4];
+        double x, y;
+        THPhilox_block(seed, offset + j, block);
+        THPhilox_uniform2(block, &x, &y);
+        data[2 * j] = static_cast<scalar_t>(x <= p);
+        if (2 * j + 1 < size) {
+          data[2 * j + 1] = static_cast<scalar_t>(y <= p);
+        }
+      }
+    });
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(uniformImpl, &uniform_kernel);
+REGISTER_DISPATCH(normalImpl, &normal_kernel);
+REGISTER_DISPATCH(bernoulliImpl, &bernoulli_kernel);
+
+}} // namespace at::native
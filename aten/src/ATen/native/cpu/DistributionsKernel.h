@@ -0,0 +1,21 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at {
+namespace native {
+
+// Fill the contiguous self from the Philox4x32-10 stream of key seed
+// (TH/THPhilox.h): elements 2j and 2j+1 come from block offset + j, so the
+// result doesn't depend on how the work is split across threads.
+using uniform_fn = void(*)(Tensor& self, double from, double to, uint64_t seed, uint64_t offset);
+using normal_fn = void(*)(Tensor& self, double mean, double std, uint64_t seed, uint64_t offset);
+using bernoulli_fn = void(*)(Tensor& self, double p, uint64_t seed, uint64_t offset);
+
+extern DispatchStub<uniform_fn> uniformImpl;
+extern DispatchStub<normal_fn> normalImpl;
+extern DispatchStub<bernoulli_fn> bernoulliImpl;
+
+}
+}
@@ -0,0 +1,287 @@
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/cpu/Vec.h"
+
+namespace at { namespace native { namespace {
+
+// out[0 ... size-1] += scale * row[0 ... size-1]
+template <typename scalar_t>
+static inline void scaled_add(scalar_t* out, const scalar_t* row, scalar_t scale, int64_t size) {
+  using Vector = Vec<scalar_t>;
+  Vector scale_vec(scale);
+  int64_t d = 0;
+  for (; d + Vector::size <= size; d += Vector::size) {
+    auto acc = Vector::s_load(out + d) + Vector::s_load(row + d) * scale_vec;
+    acc.store(out + d);
+  }
+  for (; d != size; d++) {
+    out[d] += scale * row[d];
+  }
+}
+
+static inline void check_index(int64_t idx, int64_t num_rows) {
+  if (idx < 0 || idx >= num_rows) {
+    AT_ERROR("embedding_bag: index %lld is out of range for a weight with %lld rows",
+             (long long)idx, (long long)num_rows);
+  }
+}
+
+// Calls f(bag, start, stop) for every bag, in parallel, where bag covers
+// indices [start, stop). ddim is the number of columns reduced per index.
+template <typename F>
+static void parallel_for_bags(const Tensor& indices, const Tensor& offsets, int64_t ddim, const F& f) {
+  int64_t num_bags = offsets.size(0);
+  int64_t num_indices = indices.size(0);
+  auto offsets_data = offsets.data<int64_t>();
+
+  // a bag costs about (num_indices / num_bags) * ddim multiply-adds
+  int64_t work = std::max<int64_t>(1, num_indices * ddim);
+  int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE * num_bags / work);
+  parallel_for(0, num_bags, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t bag = begin; bag != end; bag++) {
+      // like offset2bag, indices before offsets[1] belong to the first bag
+      int64_t start = bag == 0 ? 0 : std::min(offsets_data[bag], num_indices);
+      int64_t stop = bag + 1 < num_bags ? std::min(offsets_data[bag + 1], num_indices) : num_indices;
+      f(bag, start, stop);
+    }
+  });
+}
+
+template <typename scalar_t>
+static void scale_by_bag_size(scalar_t* out, int64_t ddim, int64_t bag_size) {
+  if (bag_size > 0) {
+    scalar_t inv_size = scalar_t(1) / bag_size;
+    for (int64_t d = 0; d != ddim; d++) {
+      out[d] *= inv_size;
+    }
+  }
+}
+
+template <typename scalar_t>
+static void embedding_bag_impl(Tensor& output, const Tensor& weight,
+                               const Tensor& indices, const Tensor& offsets,
+                               const Tensor& per_sample_weights, bool mean) {
+  int64_t num_rows = weight.size(0);
+  int64_t ddim = weight.size(1);
+  int64_t row_stride = weight.stride(0);
+  auto weight_data = weight.data<scalar_t>();
+  auto indices_data = indices.data<int64_t>();
+  auto output_data = output.data<scalar_t>();
+  const scalar_t* psw_data = per_sample_weights.defined() ? per_sample_weights.data<scalar_t>() : nullptr;
+
+  parallel_for_bags(indices, offsets, ddim, [&](int64_t bag, int64_t start, int64_t stop) {
+    scalar_t* out = output_data + bag * ddim;
+    std::fill(out, out + ddim, scalar_t(0));
+    for (int64_t i = start; i < stop; i++) {
+      int64_t idx = indices_data[i];
+      check_index(idx, num_rows);
+      scalar_t scale = psw_data ? psw_data[i] : scalar_t(1);
+      scaled_add(out, weight_data + idx * row_stride, scale, ddim);
+    }
+    if (mean) {
+      scale_by_bag_size(out, ddim, stop - start);
+    }
+  });
+}
+
+// Half weights are summed in float: every row is converted to a float buffer
+// and accumulated like a float row, and the bag is converted back once.
+static void embedding_bag_half_impl(Tensor& output, const Tensor& weight,
+                                    const Tensor& indices, const Tensor& offsets,
+                                    const Tensor& per_sample_weights, bool mean) {
+  int64_t num_rows = weight.size(0);
+  int64_t ddim = weight.size(1);
+  int64_t row_stride = weight.stride(0);
+  auto weight_data = weight.data<Half>();
+  auto indices_data = indices.data<int64_t>();
+  auto output_data = output.data<Half>();
+  const Half* psw_data = per_sample_weights.defined() ? per_sample_weights.data<Half>() : nullptr;
+
+  parallel_for_bags(indices, offsets, ddim, [&](int64_t bag, int64_t start, int64_t stop) {
+    std::vector<float> out(ddim, 0.f);
+    std::vector<float> row(ddim);
+    for (int64_t i = start; i < stop; i++) {
+      int64_t idx = indices_data[i];
+      check_index(idx, num_rows);
+      float scale = psw_data ? convert<float, Half>(psw_data[i]) : 1.f;
+      vec256::convert_to_float(weight_data + idx * row_stride, row.data(), ddim);
+      scaled_add(out.data(), row.data(), scale, ddim);
+    }
+    if (mean) {
+      scale_by_bag_size(out.data(), ddim, stop - start);
+    }
+    vec256::convert_to_half(out.data(), output_data + bag * ddim, ddim);
+  });
+}
+
+static void embedding_bag_kernel_impl(Tensor& output, const Tensor& weight,
+                                      const Tensor& indices, const Tensor& offsets,
+                                      const Tensor& per_sample_weights, bool mean) {
+  if (weight.type().scalarType() == kHalf) {
+    embedding_bag_half_impl(output, weight, indices, offsets, per_sample_weights, mean);
+    return;
+  }
+  AT_DISPATCH_FLOATING_TYPES(weight.type(), "embedding_bag", [&] {
+    embedding_bag_impl<scalar_t>(output, weight, indices, offsets, per_sample_weights, mean);
+  });
+}
+
+// positions summed by one thread, the pieces of a longer segment are
+// reduced separately and then combined in order
+constexpr int64_t SEGMENT_PIECE_SIZE = 1024;
+
+template <typename scalar_t>
+static void embedding_backward_impl(Tensor& output, const Tensor& grad,
+                                    const Tensor& order, const Tensor& segment_offsets,
+                                    const Tensor& output_rows, const Tensor& src_rows,
+                                    const Tensor& scales) {
+  int64_t ddim = grad.size(1);
+  int64_t num_segments = segment_offsets.size(0) - 1;
+  auto grad_data = grad.data<scalar_t>();
+  auto output_data = output.data<scalar_t>();
+  auto order_data = order.data<int64_t>();
+  auto segment_data = segment_offsets.data<int64_t>();
+  const int64_t* output_rows_data = output_rows.defined() ? output_rows.data<int64_t>() : nullptr;
+  const int64_t* src_rows_data = src_rows.defined() ? src_rows.data<int64_t>() : nullptr;
+  const scalar_t* scales_data = scales.defined() ? scales.data<scalar_t>() : nullptr;
+
+  struct Piece {
+    int64_t segment;
+    int64_t begin;
+    int64_t end;
+    int64_t partial;  // row of partials, or -1 to write the output row
+  };
+  std::vector<Piece> pieces;
+  std::vector<int64_t> split_segments;
+  int64_t num_partials = 0;
+  for (int64_t s = 0; s != num_segments; s++) {
+    int64_t begin = segment_data[s];
+    int64_t end = segment_data[s + 1];
+    if (end - begin <= SEGMENT_PIECE_SIZE) {
+      pieces.push_back({s, begin, end, -1});
+      continue;
+    }
+    split_segments.push_back(pieces.size());
+    for (int64_t b = begin; b < end; b += SEGMENT_PIECE_SIZE) {
+      pieces.push_back({s, b, std::min(end, b + SEGMENT_PIECE_SIZE), num_partials++});
+    }
+  }
+  Tensor partials = grad.type().tensor({num_partials, ddim});
+  auto partials_data = partials.data<scalar_t>();
+  auto output_row = [&](int64_t s) {
+    return output_data + (output_rows_data ? output_rows_data[s] : s) * ddim;
+  };
+
+  int64_t num_positions = segment_data[num_segments] - segment_data[0];
+  int64_t work = std::max<int64_t>(1, num_positions * ddim);
+  int64_t num_pieces = pieces.size();
+  int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE * num_pieces / work);
+  parallel_for(0, num_pieces, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k != end; k++) {
+      const Piece& piece = pieces[k];
+      scalar_t* out = piece.partial < 0 ? output_row(piece.segment)
+                                        : partials_data + piece.partial * ddim;
+      std::fill(out, out + ddim, scalar_t(0));
+      for (int64_t j = piece.begin; j != piece.end; j++) {
+        int64_t p = order_data[j];
+        int64_t src = src_rows_data ? src_rows_data[p] : p;
+        scalar_t scale = scales_data ? scales_data[p] : scalar_t(1);
+        scaled_add(out, grad_data + src * ddim, scale, ddim);
+      }
+    }
+  });
+
+  parallel_for(0, split_segments.size(), 1, [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k != end; k++) {
+      int64_t first = split_segments[k];
+      int64_t segment = pieces[first].segment;
+      scalar_t* out = output_row(segment);
+      std::fill(out, out + ddim, scalar_t(0));
+      for (int64_t i = first; i != num_pieces && pieces[i].segment == segment; i++) {
+        scaled_add(out, partials_data + pieces[i].partial * ddim, scalar_t(1), ddim);
+      }
+    }
+  });
+}
+
+static void embedding_backward_kernel_impl(Tensor& output, const Tensor& grad,
+                                           const Tensor& order, const Tensor& segment_offsets,
+                                           const Tensor& output_rows, const Tensor& src_rows,
+                                           const Tensor& scales) {
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_backward", [&] {
+    embedding_backward_impl<scalar_t>(output, grad, order, segment_offsets,
+                                      output_rows, src_rows, scales);
+  });
+}
+
+// Rows are dequantized on the fly: with w the per sample weight, a row adds
+// (w * scale) * q + (w * bias) to the bag. The loops are simple enough for
+// the compiler to vectorize with the flags of each CPU capability.
+template <int BITS>
+static void fused_rowwise_embedding_bag_impl(Tensor& output, const Tensor& weight,
+                                             const Tensor& indices, const Tensor& offsets,
+                                             const Tensor& per_sample_weights, bool mean) {
+  int64_t num_rows = weight.size(0);
+  int64_t data_bytes = weight.size(1) - 2 * sizeof(float);
+  int64_t ddim = data_bytes * (8 / BITS);
+  int64_t row_stride = weight.stride(0);
+  auto weight_data = weight.data<uint8_t>();
+  auto indices_data = indices.data<int64_t>();
+  auto output_data = output.data<float>();
+  const float* psw_data = per_sample_weights.defined() ? per_sample_weights.data<float>() : nullptr;
+
+  parallel_for_bags(indices, offsets, ddim, [&](int64_t bag, int64_t start, int64_t stop) {
+    float* out = output_data + bag * ddim;
+    std::fill(out, out + ddim, 0.f);
+    for (int64_t i = start; i < stop; i++) {
+      int64_t idx = indices_data[i];
+      check_index(idx, num_rows);
+      const uint8_t* row = weight_data + idx * row_stride;
+      // scale and bias aren't necessarily aligned
+      float scale_bias[2];
+      std::memcpy(scale_bias, row + data_bytes, sizeof(scale_bias));
+      float w = psw_data ? psw_data[i] : 1.f;
+      float scale = w * scale_bias[0];
+      float bias = w * scale_bias[1];
+      if (BITS == 8) {
+        for (int64_t d = 0; d != ddim; d++) {
+          out[d] += scale * row[d] + bias;
+        }
+      } else {
+        // two values per byte, the first one in the low nibble
+        for (int64_t b = 0; b != data_bytes; b++) {
+          out[2 * b] += scale * (row[b] & 0xF) + bias;
+          out[2 * b + 1] += scale * (row[b] >> 4) + bias;
+        }
+      }
+    }
+    if (mean) {
+      scale_by_bag_size(out, ddim, stop - start);
+    }
+  });
+}
+
+static void fused_rowwise_embedding_bag_kernel_impl(Tensor& output, const Tensor& weight,
+                                                    const Tensor& indices, const Tensor& offsets,
+                                                    const Tensor& per_sample_weights,
+                                                    int64_t bits, bool mean) {
+  if (bits == 8) {
+    fused_rowwise_embedding_bag_impl<8>(output, weight, indices, offsets, per_sample_weights, mean);
+  } else {
+    fused_rowwise_embedding_bag_impl<4>(output, weight, indices, offsets, per_sample_weights, mean);
+  }
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(embedding_bag_kernel, &embedding_bag_kernel_impl);
+REGISTER_DISPATCH(embedding_backward_kernel, &embedding_backward_kernel_impl);
+REGISTER_DISPATCH(fused_rowwise_embedding_bag_kernel, &fused_rowwise_embedding_bag_kernel_impl);
+
+}}  // namespace at::native
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// Sums (or averages, if mean) the rows of weight selected by indices into
+// one row of output per bag, without materializing the gathered rows. Bag i
+// covers indices[offsets[i] : offsets[i + 1]]. Every row is scaled by the
+// matching entry of per_sample_weights when it is defined. Half weights are
+// accumulated in float.
+using embedding_bag_fn = void(*)(Tensor& output, const Tensor& weight,
+                                 const Tensor& indices, const Tensor& offsets,
+                                 const Tensor& per_sample_weights, bool mean);
+
+// Same as embedding_bag_fn, for a weight quantized with bits (8 or 4) per
+// value by fused_rowwise_quantize: every uint8 row holds the packed values,
+// followed by a float scale and a float bias. The output is float.
+using fused_rowwise_embedding_bag_fn = void(*)(Tensor& output, const Tensor& weight,
+                                               const Tensor& indices, const Tensor& offsets,
+                                               const Tensor& per_sample_weights,
+                                               int64_t bits, bool mean);
+
+// Backward of embedding and embedding_bag, one output row per segment of
+// equal indices: segment s covers order[segment_offsets[s] : segment_offsets[s + 1]]
+// and writes
+//   output[output_rows[s]] = sum over its positions p of scales[p] * grad[src_rows[p]]
+// where output_rows, src_rows and scales default to the identity (s and p)
+// and to 1 when undefined. Rows other than output_rows are left untouched.
+// Long segments are split in fixed pieces that are summed in order, so the
+// result is deterministic and doesn't depend on the number of threads.
+using embedding_backward_fn = void(*)(Tensor& output, const Tensor& grad,
+                                      const Tensor& order, const Tensor& segment_offsets,
+                                      const Tensor& output_rows, const Tensor& src_rows,
+                                      const Tensor& scales);
+
+extern DispatchStub<embedding_bag_fn> embedding_bag_kernel;
+extern DispatchStub<embedding_backward_fn> embedding_backward_kernel;
+extern DispatchStub<fused_rowwise_embedding_bag_fn> fused_rowwise_embedding_bag_kernel;
+
+}} // namespace at::native
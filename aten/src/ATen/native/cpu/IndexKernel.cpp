@@ -0,0 +1,164 @@
+#include "ATen/native/cpu/IndexKernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "ATen/Parallel.h"
+
+namespace at { namespace native { namespace {
+
+// Offsets in elements of the elements of the dimensions [begin, end) of t,
+// in row-major order
+static std::vector<int64_t> dim_offsets(const Tensor& t, int64_t begin, int64_t end) {
+  std::vector<int64_t> offsets(1, 0);
+  for (int64_t d = begin; d < end; d++) {
+    std::vector<int64_t> next;
+    next.reserve(offsets.size() * t.size(d));
+    for (auto offset : offsets) {
+      for (int64_t i = 0; i < t.size(d); i++) {
+        next.push_back(offset + i * t.stride(d));
+      }
+    }
+    offsets = std::move(next);
+  }
+  return offsets;
+}
+
+// whether the dimensions from begin on are laid out contiguously
+static bool is_contiguous_from(const Tensor& t, int64_t begin) {
+  int64_t expected = 1;
+  for (int64_t d = t.dim() - 1; d >= begin; d--) {
+    if (t.size(d) != 1 && t.stride(d) != expected) {
+      return false;
+    }
+    expected *= t.size(d);
+  }
+  return true;
+}
+
+// Maps a position in the (broadcast) indices to the offset in self of the
+// element they select in the indexed dimensions.
+struct Indexer {
+  Indexer(const Tensor& self, TensorList indices, int64_t begin, int64_t end)
+    : sizes(indices[begin].sizes()), contiguous(true) {
+    for (int64_t d = begin; d < end; d++) {
+      const auto& index = indices[d];
+      data.push_back(index.data<int64_t>());
+      strides.push_back(index.strides().vec());
+      contiguous = contiguous && index.is_contiguous();
+      dim_sizes.push_back(self.size(d));
+      dim_strides.push_back(self.stride(d));
+    }
+    numel = 1;
+    for (auto size : sizes) {
+      numel *= size;
+    }
+  }
+
+  // offset of element pos of the j-th index
+  int64_t element(size_t j, int64_t pos) const {
+    if (contiguous) {
+      return pos;
+    }
+    int64_t offset = 0;
+    for (int64_t d = sizes.size() - 1; d >= 0; d--) {
+      offset += (pos % sizes[d]) * strides[j][d];
+      pos /= sizes[d];
+    }
+    return offset;
+  }
+
+  int64_t offset(int64_t pos) const {
+    int64_t offset = 0;
+    for (size_t j = 0; j < data.size(); j++) {
+      int64_t idx = data[j][element(j, pos)];
+      if (idx < 0) {
+        idx += dim_sizes[j];
+      }
+      offset += idx * dim_strides[j];
+    }
+    return offset;
+  }
+
+  void check() const {
+    for (size_t j = 0; j < data.size(); j++) {
+      for (int64_t pos = 0; pos < numel; pos++) {
+        int64_t idx = data[j][element(j, pos)];
+        if (idx < -dim_sizes[j] || idx >= dim_sizes[j]) {
+          AT_ERROR("index %lld is out of bounds for dimension with size %lld",
+                   (long long)idx, (long long)dim_sizes[j]);
+        }
+      }
+    }
+  }
+
+  IntList sizes;
+  int64_t numel;
+  bool contiguous;
+  std::vector<const int64_t*> data;
+  std::vector<std::vector<int64_t>> strides;
+  std::vector<int64_t> dim_sizes;
+  std::vector<int64_t> dim_strides;
+};
+
+// The result is a sequence of rows, one per element of the dimensions before
+// begin and per position in the indices, each holding the elements of the
+// dimensions from end on. Only the element size matters to copy them.
+template <typename scalar_t>
+static void index_rows(Tensor& result, const Tensor& self, const Indexer& indexer,
+                       int64_t begin, int64_t end) {
+  auto before_offsets = dim_offsets(self, 0, begin);
+  bool inner_contiguous = is_contiguous_from(self, end);
+  std::vector<int64_t> inner_offsets;
+  int64_t inner_numel = 1;
+  for (int64_t d = end; d < self.dim(); d++) {
+    inner_numel *= self.size(d);
+  }
+  if (!inner_contiguous) {
+    inner_offsets = dim_offsets(self, end, self.dim());
+  }
+
+  auto out = static_cast<scalar_t*>(result.data_ptr());
+  auto in = static_cast<const scalar_t*>(self.data_ptr());
+  int64_t npos = indexer.numel;
+  int64_t rows = before_offsets.size() * npos;
+  int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(1, inner_numel));
+  parallel_for(0, rows, grain_size, [&](int64_t start, int64_t stop) {
+    for (int64_t row = start; row != stop; row++) {
+      auto src = in + before_offsets[row / npos] + indexer.offset(row % npos);
+      auto dst = out + row * inner_numel;
+      if (inner_numel == 1) {
+        *dst = *src;
+      } else if (inner_contiguous) {
+        std::memcpy(dst, src, inner_numel * sizeof(scalar_t));
+      } else {
+        for (int64_t i = 0; i < inner_numel; i++) {
+          dst[i] = src[inner_offsets[i]];
+        }
+      }
+    }
+  });
+}
+
+static void index_kernel_impl(Tensor& result, const Tensor& self, TensorList indices,
+                              int64_t begin, int64_t end) {
+  if (result.numel() == 0) {
+    return;
+  }
+  Indexer indexer(self, indices, begin, end);
+  indexer.check();
+  switch (self.type().elementSizeInBytes()) {
+    case 1: index_rows<uint8_t>(result, self, indexer, begin, end); break;
+    case 2: index_rows<uint16_t>(result, self, indexer, begin, end); break;
+    case 4: index_rows<uint32_t>(result, self, indexer, begin, end); break;
+    case 8: index_rows<uint64_t>(result, self, indexer, begin, end); break;
+    default: AT_ERROR("index(): unsupported element size %d", (int)self.type().elementSizeInBytes());
+  }
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(index_kernel, &index_kernel_impl);
+
+}}  // namespace at::native
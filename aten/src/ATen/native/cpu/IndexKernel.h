@@ -0,0 +1,17 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// result = self[indices] for the indices of _index() (see IndexingUtils.h),
+// which index the dimensions [begin, end) of self. The source offset of every
+// row of the result is computed from the strides of self and of the indices,
+// without building the linear index of the result. result is contiguous.
+using index_fn = void(*)(Tensor& result, const Tensor& self, TensorList indices,
+                         int64_t begin, int64_t end);
+
+extern DispatchStub<index_fn> index_kernel;
+
+}} // namespace at::native
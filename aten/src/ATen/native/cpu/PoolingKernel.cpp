@@ -0,0 +1,326 @@
+#include "ATen/native/cpu/PoolingKernel.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+
+namespace at { namespace native { namespace {
+
+// The inner loops below run along W (contiguous input) or C (channels last)
+// with a branch free body, which the compiler vectorizes for the capability
+// this file is compiled for.
+
+// The rows (or columns) start, start + dilation, ... < end of the input that
+// the max pooling window of output position o covers, like THNN clips them
+struct MaxWindow {
+  int64_t start;
+  int64_t end;
+};
+
+static inline MaxWindow max_window(int64_t o, int64_t k, int64_t stride, int64_t pad,
+                                   int64_t dilation, int64_t size) {
+  int64_t start = o * stride - pad;
+  int64_t end = std::min(start + (k - 1) * dilation + 1, size);
+  while (start < 0) {
+    start += dilation;
+  }
+  return {start, end};
+}
+
+// The rows (or columns) [start, end) of the input that the average pooling
+// window of o covers. padded_size also counts the padding it covers.
+struct AvgWindow {
+  int64_t start;
+  int64_t end;
+  int64_t padded_size;
+};
+
+static inline AvgWindow avg_window(int64_t o, int64_t k, int64_t stride, int64_t pad,
+                                   int64_t size) {
+  int64_t start = o * stride - pad;
+  int64_t end = std::min(start + k, size + pad);
+  return {std::max<int64_t>(start, 0), std::min(end, size), end - start};
+}
+
+// The output columns [begin, end) whose window of extent kernel_extent is
+// entirely inside the W input columns, so that every one of them reads the
+// input at the same offsets from its first column
+struct InnerColumns {
+  int64_t begin;
+  int64_t end;
+};
+
+static inline InnerColumns inner_columns(int64_t W, int64_t OW, int64_t stride, int64_t pad,
+                                         int64_t kernel_extent) {
+  int64_t begin = std::min((pad + stride - 1) / stride, OW);
+  int64_t last_start = W + pad - kernel_extent;
+  int64_t end = last_start < 0 ? 0 : std::min(last_start / stride + 1, OW);
+  return {begin, std::max(end, begin)};
+}
+
+static inline int64_t grain_size(int64_t work_per_item) {
+  return std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(work_per_item, 1));
+}
+
+template <typename scalar_t, bool with_indices>
+static void max_pool2d_plane(scalar_t* out, int64_t* ind, const scalar_t* in,
+                             int64_t H, int64_t W, const Pool2dParams& p,
+                             const InnerColumns& inner) {
+  const scalar_t lowest = -std::numeric_limits<scalar_t>::infinity();
+  for (int64_t oh = 0; oh < p.OH; oh++) {
+    auto rows = max_window(oh, p.kH, p.dH, p.padH, p.dilationH, H);
+    scalar_t* out_row = out + oh * p.OW;
+    int64_t* ind_row = with_indices ? ind + oh * p.OW : nullptr;
+
+    auto border_column = [&](int64_t ow) {
+      auto cols = max_window(ow, p.kW, p.dW, p.padW, p.dilationW, W);
+      scalar_t max = lowest;
+      int64_t index = -1;
+      for (int64_t y = rows.start; y < rows.end; y += p.dilationH) {
+        for (int64_t x = cols.start; x < cols.end; x += p.dilationW) {
+          scalar_t val = in[y * W + x];
+          if (val > max) {
+            max = val;
+            index = y * W + x;
+          }
+        }
+      }
+      out_row[ow] = max;
+      if (with_indices) {
+        ind_row[ow] = index;
+      }
+    };
+
+    for (int64_t ow = 0; ow < inner.begin; ow++) {
+      border_column(ow);
+    }
+    for (int64_t ow = inner.begin; ow < inner.end; ow++) {
+      out_row[ow] = lowest;
+      if (with_indices) {
+        ind_row[ow] = -1;
+      }
+    }
+    // every inner column sees the taps of its window in the same order as
+    // border_column, so it ends up with the same maximum and index
+    for (int64_t y = rows.start; y < rows.end; y += p.dilationH) {
+      const scalar_t* in_row = in + y * W;
+      for (int64_t kx = 0; kx < p.kW; kx++) {
+        int64_t offset = kx * p.dilationW - p.padW;
+        for (int64_t ow = inner.begin; ow < inner.end; ow++) {
+          int64_t x = ow * p.dW + offset;
+          scalar_t val = in_row[x];
+          bool greater = val > out_row[ow];
+          out_row[ow] = greater ? val : out_row[ow];
+          if (with_indices) {
+            ind_row[ow] = greater ? y * W + x : ind_row[ow];
+          }
+        }
+      }
+    }
+    for (int64_t ow = inner.end; ow < p.OW; ow++) {
+      border_column(ow);
+    }
+  }
+}
+
+template <typename scalar_t, bool with_indices>
+static void max_pool2d_channels_last(scalar_t* out, int64_t* ind, const scalar_t* in,
+                                     int64_t N, int64_t C, int64_t H, int64_t W,
+                                     const Pool2dParams& p) {
+  const scalar_t lowest = -std::numeric_limits<scalar_t>::infinity();
+  int64_t work_per_row = p.OW * p.kH * p.kW * C;
+  parallel_for(0, N * p.OH, grain_size(work_per_row), [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      int64_t n = row / p.OH;
+      int64_t oh = row % p.OH;
+      auto rows = max_window(oh, p.kH, p.dH, p.padH, p.dilationH, H);
+      for (int64_t ow = 0; ow < p.OW; ow++) {
+        auto cols = max_window(ow, p.kW, p.dW, p.padW, p.dilationW, W);
+        scalar_t* out_pixel = out + (row * p.OW + ow) * C;
+        int64_t* ind_pixel = with_indices ? ind + (row * p.OW + ow) * C : nullptr;
+        for (int64_t c = 0; c < C; c++) {
+          out_pixel[c] = lowest;
+          if (with_indices) {
+            ind_pixel[c] = -1;
+          }
+        }
+        for (int64_t y = rows.start; y < rows.end; y += p.dilationH) {
+          for (int64_t x = cols.start; x < cols.end; x += p.dilationW) {
+            const scalar_t* in_pixel = in + ((n * H + y) * W + x) * C;
+            int64_t index = y * W + x;
+            for (int64_t c = 0; c < C; c++) {
+              scalar_t val = in_pixel[c];
+              bool greater = val > out_pixel[c];
+              out_pixel[c] = greater ? val : out_pixel[c];
+              if (with_indices) {
+                ind_pixel[c] = greater ? index : ind_pixel[c];
+              }
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t, bool with_indices>
+static void max_pool2d_impl(Tensor& output, Tensor& indices, const Tensor& input,
+                            const Pool2dParams& p) {
+  int64_t N = input.size(0);
+  int64_t C = input.size(1);
+  int64_t H = input.size(2);
+  int64_t W = input.size(3);
+  const scalar_t* in = input.data<scalar_t>();
+  scalar_t* out = output.data<scalar_t>();
+  int64_t* ind = with_indices ? indices.data<int64_t>() : nullptr;
+
+  if (!input.is_contiguous()) {
+    max_pool2d_channels_last<scalar_t, with_indices>(out, ind, in, N, C, H, W, p);
+    return;
+  }
+  auto inner = inner_columns(W, p.OW, p.dW, p.padW, (p.kW - 1) * p.dilationW + 1);
+  int64_t work_per_plane = p.OH * p.OW * p.kH * p.kW;
+  parallel_for(0, N * C, grain_size(work_per_plane), [&](int64_t begin, int64_t end) {
+    for (int64_t plane = begin; plane < end; plane++) {
+      max_pool2d_plane<scalar_t, with_indices>(
+          out + plane * p.OH * p.OW,
+          with_indices ? ind + plane * p.OH * p.OW : nullptr,
+          in + plane * H * W, H, W, p, inner);
+    }
+  });
+}
+
+template <typename scalar_t>
+static void avg_pool2d_plane(scalar_t* out, const scalar_t* in, int64_t H, int64_t W,
+                             const Pool2dParams& p, bool count_include_pad,
+                             const InnerColumns& inner) {
+  for (int64_t oh = 0; oh < p.OH; oh++) {
+    auto rows = avg_window(oh, p.kH, p.dH, p.padH, H);
+    scalar_t* out_row = out + oh * p.OW;
+
+    auto border_column = [&](int64_t ow) {
+      auto cols = avg_window(ow, p.kW, p.dW, p.padW, W);
+      scalar_t sum = 0;
+      for (int64_t y = rows.start; y < rows.end; y++) {
+        for (int64_t x = cols.start; x < cols.end; x++) {
+          sum += in[y * W + x];
+        }
+      }
+      int64_t divide_factor = count_include_pad
+          ? rows.padded_size * cols.padded_size
+          : (rows.end - rows.start) * (cols.end - cols.start);
+      out_row[ow] = sum / divide_factor;
+    };
+
+    for (int64_t ow = 0; ow < inner.begin; ow++) {
+      border_column(ow);
+    }
+    for (int64_t ow = inner.begin; ow < inner.end; ow++) {
+      out_row[ow] = 0;
+    }
+    // summed in the order of border_column, so the sums are the same
+    for (int64_t y = rows.start; y < rows.end; y++) {
+      const scalar_t* in_row = in + y * W;
+      for (int64_t kx = 0; kx < p.kW; kx++) {
+        int64_t offset = kx - p.padW;
+        for (int64_t ow = inner.begin; ow < inner.end; ow++) {
+          out_row[ow] += in_row[ow * p.dW + offset];
+        }
+      }
+    }
+    // the inner windows cover no padding along W
+    int64_t divide_factor = (count_include_pad ? rows.padded_size : rows.end - rows.start) * p.kW;
+    for (int64_t ow = inner.begin; ow < inner.end; ow++) {
+      out_row[ow] = out_row[ow] / divide_factor;
+    }
+    for (int64_t ow = inner.end; ow < p.OW; ow++) {
+      border_column(ow);
+    }
+  }
+}
+
+template <typename scalar_t>
+static void avg_pool2d_channels_last(scalar_t* out, const scalar_t* in,
+                                     int64_t N, int64_t C, int64_t H, int64_t W,
+                                     const Pool2dParams& p, bool count_include_pad) {
+  int64_t work_per_row = p.OW * p.kH * p.kW * C;
+  parallel_for(0, N * p.OH, grain_size(work_per_row), [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      int64_t n = row / p.OH;
+      int64_t oh = row % p.OH;
+      auto rows = avg_window(oh, p.kH, p.dH, p.padH, H);
+      for (int64_t ow = 0; ow < p.OW; ow++) {
+        auto cols = avg_window(ow, p.kW, p.dW, p.padW, W);
+        scalar_t* out_pixel = out + (row * p.OW + ow) * C;
+        for (int64_t c = 0; c < C; c++) {
+          out_pixel[c] = 0;
+        }
+        for (int64_t y = rows.start; y < rows.end; y++) {
+          for (int64_t x = cols.start; x < cols.end; x++) {
+            const scalar_t* in_pixel = in + ((n * H + y) * W + x) * C;
+            for (int64_t c = 0; c < C; c++) {
+              out_pixel[c] += in_pixel[c];
+            }
+          }
+        }
+        int64_t divide_factor = count_include_pad
+            ? rows.padded_size * cols.padded_size
+            : (rows.end - rows.start) * (cols.end - cols.start);
+        for (int64_t c = 0; c < C; c++) {
+          out_pixel[c] = out_pixel[c] / divide_factor;
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+static void avg_pool2d_impl(Tensor& output, const Tensor& input, const Pool2dParams& p,
+                            bool count_include_pad) {
+  int64_t N = input.size(0);
+  int64_t C = input.size(1);
+  int64_t H = input.size(2);
+  int64_t W = input.size(3);
+  const scalar_t* in = input.data<scalar_t>();
+  scalar_t* out = output.data<scalar_t>();
+
+  if (!input.is_contiguous()) {
+    avg_pool2d_channels_last<scalar_t>(out, in, N, C, H, W, p, count_include_pad);
+    return;
+  }
+  auto inner = inner_columns(W, p.OW, p.dW, p.padW, p.kW);
+  int64_t work_per_plane = p.OH * p.OW * p.kH * p.kW;
+  parallel_for(0, N * C, grain_size(work_per_plane), [&](int64_t begin, int64_t end) {
+    for (int64_t plane = begin; plane < end; plane++) {
+      avg_pool2d_plane<scalar_t>(out + plane * p.OH * p.OW, in + plane * H * W, H, W, p,
+                                 count_include_pad, inner);
+    }
+  });
+}
+
+static void max_pool2d_kernel_impl(Tensor& output, Tensor& indices, const Tensor& input,
+                                   const Pool2dParams& p) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "_max_pool2d", [&] {
+    if (indices.defined()) {
+      max_pool2d_impl<scalar_t, true>(output, indices, input, p);
+    } else {
+      max_pool2d_impl<scalar_t, false>(output, indices, input, p);
+    }
+  });
+}
+
+static void avg_pool2d_kernel_impl(Tensor& output, const Tensor& input, const Pool2dParams& p,
+                                   bool count_include_pad) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "_avg_pool2d", [&] {
+    avg_pool2d_impl<scalar_t>(output, input, p, count_include_pad);
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(max_pool2d_kernel, &max_pool2d_kernel_impl);
+REGISTER_DISPATCH(avg_pool2d_kernel, &avg_pool2d_kernel_impl);
+
+}} // namespace at::native
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// The windows of a 2d pooling of H x W planes into OH x OW ones, which are
+// sized like THNN sizes them
+struct Pool2dParams {
+  int64_t kH, kW;
+  int64_t dH, dW;
+  int64_t padH, padW;
+  int64_t dilationH, dilationW;
+  int64_t OH, OW;
+};
+
+// Max pooling of a 4-d input, either contiguous or channels last, into an
+// output allocated with the same layout. indices is skipped if undefined,
+// otherwise it is laid out like output and gets the offset of each maximum
+// in its H x W plane, like THNN's. The maxima and indices are the THNN ones
+// too: the first of equal maxima is taken and NaNs are skipped.
+using max_pool2d_fn = void(*)(Tensor& output, Tensor& indices, const Tensor& input,
+                              const Pool2dParams& p);
+
+// Average pooling, with the same layouts. Each window is summed in the order
+// THNN sums it, so the results are the same.
+using avg_pool2d_fn = void(*)(Tensor& output, const Tensor& input, const Pool2dParams& p,
+                              bool count_include_pad);
+
+extern DispatchStub<max_pool2d_fn> max_pool2d_kernel;
+extern DispatchStub<avg_pool2d_fn> avg_pool2d_kernel;
+
+}} // namespace at::native
@@ -0,0 +1,267 @@
+#include "ATen/native/cpu/RNNCellKernel.h"
+
+#include <algorithm>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/cpu/Vec.h"
+
+namespace at { namespace native { namespace {
+
+// Loads n <= Vec::size elements, the last lanes of a partial load are unused
+template <typename scalar_t>
+static inline Vec<scalar_t> load(const scalar_t* ptr, int64_t n) {
+  using Vector = Vec<scalar_t>;
+  if (n == Vector::size) {
+    return Vector::s_load(ptr);
+  }
+  Vector vec;
+  vec.load_partial(ptr, n);
+  return vec;
+}
+
+// Same as load, with zeros for a missing (null) tensor
+template <typename scalar_t>
+static inline Vec<scalar_t> load_or_zero(const scalar_t* ptr, int64_t n) {
+  return ptr ? load(ptr, n) : Vec<scalar_t>(0);
+}
+
+template <typename scalar_t>
+static inline void store(const Vec<scalar_t>& vec, scalar_t* ptr, int64_t n) {
+  if (n == Vec<scalar_t>::size) {
+    vec.store(ptr);
+  } else {
+    vec.store_partial(ptr, n);
+  }
+}
+
+template <typename scalar_t>
+static inline const scalar_t* data_or_null(const Tensor& t) {
+  return t.defined() ? t.data<scalar_t>() : nullptr;
+}
+
+template <typename scalar_t>
+static inline const scalar_t* offset_or_null(const scalar_t* ptr, int64_t offset) {
+  return ptr ? ptr + offset : nullptr;
+}
+
+// Calls f(row, col, n) for the rows of a batch in parallel, and for every
+// vector of n elements of the H wide row, starting at col
+template <typename scalar_t, typename F>
+static void parallel_for_rows(int64_t B, int64_t H, const F& f) {
+  using Vector = Vec<scalar_t>;
+  parallel_for(0, B, internal::GRAIN_SIZE / std::max<int64_t>(H, 1),
+               [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      for (int64_t j = 0; j < H; j += Vector::size) {
+        f(b, j, std::min<int64_t>(Vector::size, H - j));
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+static void lstm_cell_impl(Tensor& hy, Tensor& cy, Tensor& workspace,
+                           const Tensor& input_gates, const Tensor& hidden_gates,
+                           const Tensor& cx, const Tensor& input_bias,
+                           const Tensor& hidden_bias) {
+  using Vector = Vec<scalar_t>;
+  int64_t B = cx.size(0);
+  int64_t H = cx.size(1);
+  const scalar_t* igates = input_gates.data<scalar_t>();
+  const scalar_t* hgates = hidden_gates.data<scalar_t>();
+  const scalar_t* cx_data = cx.data<scalar_t>();
+  const scalar_t* ibias = data_or_null<scalar_t>(input_bias);
+  const scalar_t* hbias = data_or_null<scalar_t>(hidden_bias);
+  scalar_t* hy_data = hy.data<scalar_t>();
+  scalar_t* cy_data = cy.data<scalar_t>();
+  scalar_t* ws = workspace.data<scalar_t>();
+
+  parallel_for_rows<scalar_t>(B, H, [&](int64_t b, int64_t j, int64_t n) {
+    Vector gates[4];
+    for (int64_t k = 0; k < 4; ++k) {
+      int64_t col = k * H + j;
+      int64_t offset = b * 4 * H + col;
+      gates[k] = load(igates + offset, n) + load(hgates + offset, n) +
+                 load_or_zero(offset_or_null(ibias, col), n) +
+                 load_or_zero(offset_or_null(hbias, col), n);
+    }
+    Vector ingate = gates[0].sigmoid();
+    Vector forgetgate = gates[1].sigmoid();
+    Vector cellgate = gates[2].tanh();
+    Vector outgate = gates[3].sigmoid();
+    Vector c = forgetgate * load(cx_data + b * H + j, n) + ingate * cellgate;
+    store(c, cy_data + b * H + j, n);
+    store(outgate * c.tanh(), hy_data + b * H + j, n);
+
+    scalar_t* ws_row = ws + b * 4 * H + j;
+    store(ingate, ws_row, n);
+    store(forgetgate, ws_row + H, n);
+    store(cellgate, ws_row + 2 * H, n);
+    store(outgate, ws_row + 3 * H, n);
+  });
+}
+
+template <typename scalar_t>
+static void lstm_cell_backward_impl(Tensor& grad_gates, Tensor& grad_cx,
+                                    const Tensor& grad_hy, const Tensor& grad_cy,
+                                    const Tensor& cx, const Tensor& cy,
+                                    const Tensor& workspace) {
+  using Vector = Vec<scalar_t>;
+  int64_t B = cx.size(0);
+  int64_t H = cx.size(1);
+  const scalar_t* ghy = data_or_null<scalar_t>(grad_hy);
+  const scalar_t* gcy = data_or_null<scalar_t>(grad_cy);
+  const scalar_t* cx_data = cx.data<scalar_t>();
+  const scalar_t* cy_data = cy.data<scalar_t>();
+  const scalar_t* ws = workspace.data<scalar_t>();
+  scalar_t* ggates = grad_gates.data<scalar_t>();
+  scalar_t* gcx = grad_cx.data<scalar_t>();
+
+  parallel_for_rows<scalar_t>(B, H, [&](int64_t b, int64_t j, int64_t n) {
+    const Vector one(1);
+    const scalar_t* ws_row = ws + b * 4 * H + j;
+    Vector ingate = load(ws_row, n);
+    Vector forgetgate = load(ws_row + H, n);
+    Vector cellgate = load(ws_row + 2 * H, n);
+    Vector outgate = load(ws_row + 3 * H, n);
+    int64_t offset = b * H + j;
+    Vector tanh_cy = load(cy_data + offset, n).tanh();
+    Vector gh = load_or_zero(offset_or_null(ghy, offset), n);
+    // gradient of the cell state, from hy and from cy
+    Vector gc = gh * outgate * (one - tanh_cy * tanh_cy) +
+                load_or_zero(offset_or_null(gcy, offset), n);
+
+    scalar_t* ggates_row = ggates + b * 4 * H + j;
+    store(gc * cellgate * ingate * (one - ingate), ggates_row, n);
+    store(gc * load(cx_data + offset, n) * forgetgate * (one - forgetgate), ggates_row + H, n);
+    store(gc * ingate * (one - cellgate * cellgate), ggates_row + 2 * H, n);
+    store(gh * tanh_cy * outgate * (one - outgate), ggates_row + 3 * H, n);
+    store(gc * forgetgate, gcx + offset, n);
+  });
+}
+
+template <typename scalar_t>
+static void gru_cell_impl(Tensor& hy, Tensor& workspace,
+                          const Tensor& input_gates, const Tensor& hidden_gates,
+                          const Tensor& hx, const Tensor& input_bias,
+                          const Tensor& hidden_bias) {
+  using Vector = Vec<scalar_t>;
+  int64_t B = hx.size(0);
+  int64_t H = hx.size(1);
+  const scalar_t* igates = input_gates.data<scalar_t>();
+  const scalar_t* hgates = hidden_gates.data<scalar_t>();
+  const scalar_t* hx_data = hx.data<scalar_t>();
+  const scalar_t* ibias = data_or_null<scalar_t>(input_bias);
+  const scalar_t* hbias = data_or_null<scalar_t>(hidden_bias);
+  scalar_t* hy_data = hy.data<scalar_t>();
+  scalar_t* ws = workspace.data<scalar_t>();
+
+  parallel_for_rows<scalar_t>(B, H, [&](int64_t b, int64_t j, int64_t n) {
+    Vector ig[3], hg[3];
+    for (int64_t k = 0; k < 3; ++k) {
+      int64_t col = k * H + j;
+      int64_t offset = b * 3 * H + col;
+      ig[k] = load(igates + offset, n) + load_or_zero(offset_or_null(ibias, col), n);
+      hg[k] = load(hgates + offset, n) + load_or_zero(offset_or_null(hbias, col), n);
+    }
+    Vector resetgate = (ig[0] + hg[0]).sigmoid();
+    Vector inputgate = (ig[1] + hg[1]).sigmoid();
+    Vector newgate = (ig[2] + resetgate * hg[2]).tanh();
+    Vector h = load(hx_data + b * H + j, n);
+    store(newgate + inputgate * (h - newgate), hy_data + b * H + j, n);
+
+    scalar_t* ws_row = ws + b * 5 * H + j;
+    store(resetgate, ws_row, n);
+    store(inputgate, ws_row + H, n);
+    store(newgate, ws_row + 2 * H, n);
+    store(h, ws_row + 3 * H, n);
+    store(hg[2], ws_row + 4 * H, n);
+  });
+}
+
+template <typename scalar_t>
+static void gru_cell_backward_impl(Tensor& grad_input_gates, Tensor& grad_hidden_gates,
+                                   Tensor& grad_hx, const Tensor& grad_hy,
+                                   const Tensor& workspace) {
+  using Vector = Vec<scalar_t>;
+  int64_t B = grad_hy.size(0);
+  int64_t H = grad_hy.size(1);
+  const scalar_t* ghy = grad_hy.data<scalar_t>();
+  const scalar_t* ws = workspace.data<scalar_t>();
+  scalar_t* gigates = grad_input_gates.data<scalar_t>();
+  scalar_t* ghgates = grad_hidden_gates.data<scalar_t>();
+  scalar_t* ghx = grad_hx.data<scalar_t>();
+
+  parallel_for_rows<scalar_t>(B, H, [&](int64_t b, int64_t j, int64_t n) {
+    const Vector one(1);
+    const scalar_t* ws_row = ws + b * 5 * H + j;
+    Vector resetgate = load(ws_row, n);
+    Vector inputgate = load(ws_row + H, n);
+    Vector newgate = load(ws_row + 2 * H, n);
+    Vector h = load(ws_row + 3 * H, n);
+    Vector hn = load(ws_row + 4 * H, n);
+    Vector gh = load(ghy + b * H + j, n);
+
+    Vector gn = gh * (one - inputgate) * (one - newgate * newgate);
+    Vector gi = gh * (h - newgate) * inputgate * (one - inputgate);
+    Vector gr = gn * hn * resetgate * (one - resetgate);
+    store(gh * inputgate, ghx + b * H + j, n);
+
+    int64_t offset = b * 3 * H + j;
+    store(gr, gigates + offset, n);
+    store(gi, gigates + offset + H, n);
+    store(gn, gigates + offset + 2 * H, n);
+    store(gr, ghgates + offset, n);
+    store(gi, ghgates + offset + H, n);
+    store(gn * resetgate, ghgates + offset + 2 * H, n);
+  });
+}
+
+static void lstm_cell_kernel_impl(Tensor& hy, Tensor& cy, Tensor& workspace,
+                                  const Tensor& input_gates, const Tensor& hidden_gates,
+                                  const Tensor& cx, const Tensor& input_bias,
+                                  const Tensor& hidden_bias) {
+  AT_DISPATCH_FLOATING_TYPES(cx.type(), "_thnn_fused_lstm_cell", [&] {
+    lstm_cell_impl<scalar_t>(hy, cy, workspace, input_gates, hidden_gates, cx,
+                             input_bias, hidden_bias);
+  });
+}
+
+static void lstm_cell_backward_kernel_impl(Tensor& grad_gates, Tensor& grad_cx,
+                                           const Tensor& grad_hy, const Tensor& grad_cy,
+                                           const Tensor& cx, const Tensor& cy,
+                                           const Tensor& workspace) {
+  AT_DISPATCH_FLOATING_TYPES(cx.type(), "_thnn_fused_lstm_cell_backward", [&] {
+    lstm_cell_backward_impl<scalar_t>(grad_gates, grad_cx, grad_hy, grad_cy, cx, cy,
+                                      workspace);
+  });
+}
+
+static void gru_cell_kernel_impl(Tensor& hy, Tensor& workspace,
+                                 const Tensor& input_gates, const Tensor& hidden_gates,
+                                 const Tensor& hx, const Tensor& input_bias,
+                                 const Tensor& hidden_bias) {
+  AT_DISPATCH_FLOATING_TYPES(hx.type(), "_thnn_fused_gru_cell", [&] {
+    gru_cell_impl<scalar_t>(hy, workspace, input_gates, hidden_gates, hx, input_bias,
+                            hidden_bias);
+  });
+}
+
+static void gru_cell_backward_kernel_impl(Tensor& grad_input_gates, Tensor& grad_hidden_gates,
+                                          Tensor& grad_hx, const Tensor& grad_hy,
+                                          const Tensor& workspace) {
+  AT_DISPATCH_FLOATING_TYPES(grad_hy.type(), "_thnn_fused_gru_cell_backward", [&] {
+    gru_cell_backward_impl<scalar_t>(grad_input_gates, grad_hidden_gates, grad_hx,
+                                     grad_hy, workspace);
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(lstm_cell_kernel, &lstm_cell_kernel_impl);
+REGISTER_DISPATCH(lstm_cell_backward_kernel, &lstm_cell_backward_kernel_impl);
+REGISTER_DISPATCH(gru_cell_kernel, &gru_cell_kernel_impl);
+REGISTER_DISPATCH(gru_cell_backward_kernel, &gru_cell_backward_kernel_impl);
+
+}} // namespace at::native
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// Pointwise part of an LSTM cell, for contiguous B x 4H input_gates and
+// hidden_gates (chunks in, forget, cell and out gate order) and B x H cx.
+// input_bias and hidden_bias are 4H long, or undefined. workspace gets the
+// activated gates, which the backward reads instead of saving the inputs.
+using lstm_cell_fn = void(*)(Tensor& hy, Tensor& cy, Tensor& workspace,
+                             const Tensor& input_gates, const Tensor& hidden_gates,
+                             const Tensor& cx, const Tensor& input_bias,
+                             const Tensor& hidden_bias);
+
+// Gradient of the lstm_cell_fn gates (the same for input_gates and
+// hidden_gates) and of cx. An undefined grad_hy or grad_cy counts as zeros.
+using lstm_cell_backward_fn = void(*)(Tensor& grad_gates, Tensor& grad_cx,
+                                      const Tensor& grad_hy, const Tensor& grad_cy,
+                                      const Tensor& cx, const Tensor& cy,
+                                      const Tensor& workspace);
+
+// Pointwise part of a GRU cell, for contiguous B x 3H input_gates and
+// hidden_gates (chunks in reset, input and new gate order) and B x H hx.
+// workspace is B x 5H: the reset, input and new gates, hx and the new gate
+// chunk of hidden_gates with its bias.
+using gru_cell_fn = void(*)(Tensor& hy, Tensor& workspace,
+                            const Tensor& input_gates, const Tensor& hidden_gates,
+                            const Tensor& hx, const Tensor& input_bias,
+                            const Tensor& hidden_bias);
+
+using gru_cell_backward_fn = void(*)(Tensor& grad_input_gates, Tensor& grad_hidden_gates,
+                                     Tensor& grad_hx, const Tensor& grad_hy,
+                                     const Tensor& workspace);
+
+extern DispatchStub<lstm_cell_fn> lstm_cell_kernel;
+extern DispatchStub<lstm_cell_backward_fn> lstm_cell_backward_kernel;
+extern DispatchStub<gru_cell_fn> gru_cell_kernel;
+extern DispatchStub<gru_cell_backward_fn> gru_cell_backward_kernel;
+
+}} // namespace at::native
@@ -1,148 +1,270 @@
 #include "ATen/native/cpu/ReduceOpsKernel.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include "ATen/Dispatch.h"
 #include "ATen/Parallel.h"
-#include "ATen/optional.h"
-#include "ATen/cpu/vec256/vec256.h"
+#include "ATen/native/TensorIterator.h"
+#include "ATen/native/cpu/Vec.h"
 
 namespace at { namespace native { namespace {
 
-using namespace vec256;
-
 static inline int64_t round_down(int64_t a, int64_t m) {
   return a - (a % m);
 }
 
-template<typename F>
-static void parallel_for(int64_t end, int64_t step, bool parallelize, F func) {
-  if (parallelize) {
-    tbb::parallel_for<int64_t>(0, end, step, func);
-  } else {
-    for (int64_t i = 0; i != end; i += step) {
-      func(i);
-    }
-  }
-}
-
-static tbb::affinity_partitioner ap;
-
-// Vectorized reduction defined by reduce operation `Op` with identity `ident`.
-// The reduction is built on top of reduce128, which reduces down a column
-// 128 bytes wide (WIDTH scalar elements). The width of 128 bytes is chosen
-// because of the "adjacent cache line prefetch" behavior on x86 CPUs.
+// Vectorized reduction defined by reduce operation `Op` with identity `ident`,
+// over any set of dimensions of a tensor with any strides.
+//
+// The input and the output, viewed with the input's shape and a zero stride
+// along the reduced dimensions, are walked with a TensorIterator ordered by
+// the input's strides. The innermost dimension decides the loop:
+//  - it is reduced and contiguous: each run is reduced with vectors, using
+//    pairwise summation (reduce_run) for accuracy.
+//  - it is kept and contiguous while the next one is reduced: columns are
+//    reduced 128 bytes at a time (reduce128), vectorized across outputs.
+//  - otherwise a scalar loop accumulates the elements into the output.
+//
+// The width of 128 bytes is chosen because of the "adjacent cache line
+// prefetch" behavior on x86 CPUs.
 template<typename scalar_t, template <class> class Op, int ident>
 struct Reduction {
   // reduction width in number of scalar elements
   static constexpr int WIDTH = 128 / sizeof(scalar_t);
+  // runs longer than this are split in two halves by reduce_run
+  static constexpr int64_t PAIRWISE_BLOCK = 8 * WIDTH;
+  // rows accumulated by reduce128 before folding them into the output
+  static constexpr int64_t ROW_BLOCK = 256;
 
-  using Vec = Vec256<scalar_t>;
-  using Reduce = Op<Vec>;
+  using Vector = Vec<scalar_t>;
+  using Reduce = Op<Vector>;
   using ReduceScalar = Op<scalar_t>;
 
-  static void apply(Tensor& res, const Tensor& self, at::optional<int64_t> dim) {
-    internal::init_tbb_num_threads();
+  // result has the shape of self with size 1 along dims, or is 0-dim when
+  // every dim is reduced.
+  static void apply(Tensor& res, const Tensor& self, IntList dims) {
+    res.fill_(ident);
+    if (self.numel() == 0) {
+      return;
+    }
+    std::vector<bool> reduced(self.dim(), false);
+    for (auto dim : dims) {
+      reduced[dim] = true;
+    }
+    std::vector<int64_t> out_strides(self.dim(), 0);
+    for (int64_t dim = 0; dim < self.dim(); dim++) {
+      if (!reduced[dim] && res.dim() != 0) {
+        out_strides[dim] = res.stride(dim);
+      }
+    }
+    Tensor out = res.as_strided(self.sizes(), out_strides);
 
-    auto out = res.data<scalar_t>();
-    auto data = self.data<scalar_t>();
-    auto numel = self.numel();
-    if (!dim.has_value()) {
-      *out = reduce_all(data, numel);
+    // Many outputs: split them between threads along the outermost kept dim.
+    int64_t split_dim = -1;
+    for (int64_t dim = 0; dim < self.dim(); dim++) {
+      if (!reduced[dim] && self.size(dim) > 1 &&
+          (split_dim < 0 || self.stride(dim) > self.stride(split_dim))) {
+        split_dim = dim;
+      }
+    }
+    if (split_dim >= 0 && res.numel() >= internal::GRAIN_SIZE / WIDTH) {
+      int64_t size = self.size(split_dim);
+      int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / (self.numel() / size));
+      parallel_for(0, size, grain_size, [&](int64_t begin, int64_t end) {
+        reduce(out.narrow(split_dim, begin, end - begin),
+               self.narrow(split_dim, begin, end - begin));
+      });
       return;
     }
 
-    int64_t n = self.size(*dim);
-    int64_t stride = self.stride(*dim);
-    int64_t batch = numel / (n * stride);
-    bool paralellize = batch * n > internal::TBB_GRAIN_SIZE;
-    parallel_for(batch, 1, paralellize, [=](int64_t b) {
-      if (stride == 1) {
-        out[b] = reduce_all(&data[b * n], n);
-      } else {
-        reduce2d(&data[b * n * stride], &out[b * stride], n, stride, stride);
+    // Few outputs: split the outermost reduced dim in fixed chunks, reduce
+    // each into its own partial result and combine them in order, so the
+    // result doesn't depend on the number of threads.
+    int64_t reduce_dim = -1;
+    for (int64_t dim = 0; dim < self.dim(); dim++) {
+      if (reduced[dim] && self.size(dim) > 1 &&
+          (reduce_dim < 0 || self.stride(dim) > self.stride(reduce_dim))) {
+        reduce_dim = dim;
+      }
+    }
+    if (reduce_dim < 0 || self.numel() <= internal::GRAIN_SIZE) {
+      reduce(out, self);
+      return;
+    }
+    int64_t size = self.size(reduce_dim);
+    int64_t chunk_size = std::max<int64_t>(1, internal::GRAIN_SIZE / (self.numel() / size));
+    int64_t num_chunks = (size + chunk_size - 1) / chunk_size;
+    if (num_chunks == 1) {
+      reduce(out, self);
+      return;
+    }
+    std::vector<int64_t> partial_sizes = res.sizes();
+    partial_sizes.insert(partial_sizes.begin(), num_chunks);
+    Tensor partials = res.type().tensor(partial_sizes).fill_(ident);
+    parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t chunk = begin; chunk != end; chunk++) {
+        int64_t start = chunk * chunk_size;
+        int64_t length = std::min(chunk_size, size - start);
+        Tensor partial = partials[chunk];
+        std::vector<int64_t> partial_strides(self.dim(), 0);
+        for (int64_t dim = 0; dim < self.dim(); dim++) {
+          if (!reduced[dim] && res.dim() != 0) {
+            partial_strides[dim] = partial.stride(dim);
+          }
+        }
+        reduce(partial.as_strided(self.sizes(), partial_strides).narrow(reduce_dim, start, length),
+               self.narrow(reduce_dim, start, length));
       }
     });
+
+    // view the partials as an input with num_chunks elements along
+    // reduce_dim, and size 1 along the other reduced dims
+    std::vector<int64_t> sizes = self.sizes();
+    std::vector<int64_t> strides(self.dim(), 0);
+    for (int64_t dim = 0; dim < self.dim(); dim++) {
+      if (reduced[dim]) {
+        sizes[dim] = 1;
+      } else {
+        strides[dim] = partials.stride(dim + 1);
+      }
+    }
+    sizes[reduce_dim] = num_chunks;
+    strides[reduce_dim] = partials.stride(0);
+    reduce(res.as_strided(sizes, out_strides), partials.as_strided(sizes, strides));
   }
 
-  static scalar_t reduce_all(const scalar_t* data, int64_t size) {
-    int64_t k = size / WIDTH;
+  // Accumulates self into out, both with the same shape.
+  static void reduce(Tensor out, const Tensor& self) {
+    TensorIterator iter({self, out});
+    auto in_data = self.data<scalar_t>();
+    auto out_data = out.data<scalar_t>();
+    int64_t size0 = iter.inner_size();
+    int64_t in_stride0 = iter.inner_stride(0);
+    int64_t out_stride0 = iter.inner_stride(1);
 
-    scalar_t sum;
-    if (size > internal::TBB_GRAIN_SIZE) {
-      sum = tbb::parallel_reduce(
-          tbb::blocked_range<int64_t>(0, k, internal::TBB_GRAIN_SIZE / WIDTH),
-          scalar_t(ident),
-          [=](const tbb::blocked_range<int64_t>& r, scalar_t init) {
-            scalar_t buf[WIDTH];
-            reduce128(&data[r.begin() * WIDTH], buf, r.end() - r.begin(), WIDTH);
-            return std::accumulate(buf, buf + WIDTH, init, ReduceScalar());
-          },
-          ReduceScalar(),
-          ap);
+    if (out_stride0 == 0 && in_stride0 == 1) {
+      for_each_offset(iter, 1, [&](int64_t in, int64_t out) {
+        out_data[out] = ReduceScalar()(out_data[out], reduce_run(&in_data[in], size0));
+      });
+    } else if (out_stride0 == 1 && in_stride0 == 1 && iter.ndim() > 1 && iter.stride(1, 1) == 0) {
+      int64_t rows = iter.sizes()[1];
+      int64_t row_stride = iter.stride(1, 0);
+      for_each_offset(iter, 2, [&](int64_t in, int64_t out) {
+        reduce2d(&in_data[in], &out_data[out], rows, size0, row_stride);
+      });
     } else {
-      scalar_t buf[WIDTH];
-      reduce128(data, buf, k, WIDTH);
-      sum = std::accumulate(buf, buf + WIDTH, scalar_t(ident), ReduceScalar());
+      for_each_offset(iter, 1, [&](int64_t in, int64_t out) {
+        for (int64_t i = 0; i != size0; i++) {
+          auto& dst = out_data[out + i * out_stride0];
+          dst = ReduceScalar()(dst, in_data[in + i * in_stride0]);
+        }
+      });
+    }
+  }
+
+  // Calls f(in_offset, out_offset) for every index of the dimensions
+  // first_dim and above of iter.
+  template <typename F>
+  static void for_each_offset(const TensorIterator& iter, int first_dim, const F& f) {
+    int ndim = iter.ndim();
+    std::vector<int64_t> counter(ndim, 0);
+    int64_t in = 0;
+    int64_t out = 0;
+    while (true) {
+      f(in, out);
+      int dim = first_dim;
+      for (; dim < ndim; dim++) {
+        counter[dim]++;
+        in += iter.stride(dim, 0);
+        out += iter.stride(dim, 1);
+        if (counter[dim] < iter.sizes()[dim]) {
+          break;
+        }
+        in -= counter[dim] * iter.stride(dim, 0);
+        out -= counter[dim] * iter.stride(dim, 1);
+        counter[dim] = 0;
+      }
+      if (dim >= ndim) {
+        return;
+      }
     }
+  }
 
-    for (int i = k * WIDTH; i != size; i++) {
-      sum = ReduceScalar()(sum, data[i]);
+  // Reduces a contiguous run. Long runs are split in halves and the halves
+  // combined (pairwise summation), which keeps the rounding error of float
+  // sums growing with log(size) instead of size.
+  static scalar_t reduce_run(const scalar_t* data, int64_t size) {
+    if (size > PAIRWISE_BLOCK) {
+      int64_t half = round_down(size / 2, WIDTH);
+      return ReduceScalar()(reduce_run(data, half), reduce_run(data + half, size - half));
+    }
+    int64_t k = size / WIDTH;
+    scalar_t buf[WIDTH];
+    reduce128(data, buf, k, WIDTH);
+    scalar_t acc = std::accumulate(buf, buf + WIDTH, scalar_t(ident), ReduceScalar());
+    for (int64_t i = k * WIDTH; i != size; i++) {
+      acc = ReduceScalar()(acc, data[i]);
     }
-    return sum;
+    return acc;
   }
 
   // Reduce down a column of WIDTH elements (128 bytes) with the given number
   // of rows. Stores the results in out[0 ... WIDTH-1].
   static void reduce128(const scalar_t* data, scalar_t* out, int64_t rows, int64_t stride) {
-    Vec acc[4] = {ident, ident, ident, ident};  // 128 bytes (two cache lines)
+    // 128 bytes (two cache lines): four Vec256 or two Vec512
+    constexpr int NUM_ACC = WIDTH / Vector::size;
+    Vector acc[NUM_ACC];
+    for (int j = 0; j != NUM_ACC; j++) {
+      acc[j] = Vector(ident);
+    }
     static_assert(sizeof(acc) == 128, "accumulator should be 128 bytes");
     for (int64_t row = 0; row != rows; row++) {
-      for (int j = 0; j != 4; j++) {
-        auto val = Vec::s_load(&data[row * stride + j * Vec::size]);
+      for (int j = 0; j != NUM_ACC; j++) {
+        auto val = Vector::s_load(&data[row * stride + j * Vector::size]);
         acc[j] = Reduce()(acc[j], val);
       }
     }
-    for (int j = 0; j != 4; j++) {
-      acc[j].store(&out[j * Vec::size]);
+    for (int j = 0; j != NUM_ACC; j++) {
+      acc[j].store(&out[j * Vector::size]);
     }
   }
 
-  // Reduce a 2d matrix down each column. Stores the results in out[0 ... cols-1]
+  // Reduce a 2d matrix down each column and accumulates the results into
+  // out[0 ... cols-1]. Rows are reduced ROW_BLOCK at a time before being
+  // folded into out, a cascade that bounds the rounding error of long sums.
   static void reduce2d(const scalar_t* data, scalar_t* out, int64_t rows, int64_t cols, int64_t stride) {
     int64_t cols_rounded = round_down(cols, WIDTH);
-    bool paralellize = cols * rows > internal::TBB_GRAIN_SIZE;
-    parallel_for(cols_rounded, WIDTH, paralellize, [=](int64_t col) {
-      reduce128(&data[col], &out[col], rows, stride);
-    });
-
-    if (cols_rounded != cols) {
-      scalar_t buf[WIDTH];
-      for (int64_t j = 0; j != cols - cols_rounded; j++) {
-        buf[j] = ident;
-      }
-      for (int64_t row = 0; row != rows; row++) {
-        for (int64_t j = 0; j != cols - cols_rounded; j++) {
-          auto val = data[row * stride + j + cols_rounded];
-          buf[j] = ReduceScalar()(buf[j], val);
+    scalar_t buf[WIDTH];
+    for (int64_t row = 0; row < rows; row += ROW_BLOCK) {
+      int64_t block_rows = std::min(ROW_BLOCK, rows - row);
+      const scalar_t* block = &data[row * stride];
+      for (int64_t col = 0; col != cols_rounded; col += WIDTH) {
+        reduce128(&block[col], buf, block_rows, stride);
+        for (int j = 0; j != WIDTH; j++) {
+          out[col + j] = ReduceScalar()(out[col + j], buf[j]);
         }
       }
-      for (int64_t j = 0; j != cols - cols_rounded; j++) {
-        out[j + cols_rounded] = buf[j];
+      for (int64_t col = cols_rounded; col != cols; col++) {
+        scalar_t acc = ident;
+        for (int64_t r = 0; r != block_rows; r++) {
+          acc = ReduceScalar()(acc, block[r * stride + col]);
+        }
+        out[col] = ReduceScalar()(out[col], acc);
       }
     }
   }
 };
 
-static void sum_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
+static void sum_kernel_impl(Tensor& result, const Tensor& self, IntList dims) {
   AT_DISPATCH_ALL_TYPES(self.type(), "sum", [&] {
-    Reduction<scalar_t, std::plus, 0>::apply(result, self, dim);
+    Reduction<scalar_t, std::plus, 0>::apply(result, self, dims);
   });
 }
 
-static void prod_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
+static void prod_kernel_impl(Tensor& result, const Tensor& self, IntList dims) {
   AT_DISPATCH_ALL_TYPES(self.type(), "prod", [&] {
-    Reduction<scalar_t, std::multiplies, 1>::apply(result, self, dim);
+    Reduction<scalar_t, std::multiplies, 1>::apply(result, self, dims);
   });
 }
 
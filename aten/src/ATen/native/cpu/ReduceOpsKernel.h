@@ -1,13 +1,14 @@
 #pragma once
 
 #include <ATen/ATen.h>
-#include <ATen/optional.h>
 #include "CapabilityDispatch.h"
 
 namespace at {
 namespace native {
 
-using reduce_fn = void(*)(Tensor &, const Tensor &, at::optional<int64_t>);
+// Reduces self over the (wrapped, sorted, unique) dims into result, which
+// has the shape of self with size 1 along dims, or is 0-dim.
+using reduce_fn = void(*)(Tensor &, const Tensor &, IntList dims);
 
 extern DispatchStub<reduce_fn> sum_kernel;
 extern DispatchStub<reduce_fn> prod_kernel;
@@ -0,0 +1,227 @@
+#include "ATen/native/cpu/SoftmaxKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/cpu/Vec.h"
+
+namespace at { namespace native { namespace {
+
+// The input is read as outer_size x dim_size x inner_size, and every slice
+// softmax normalizes is dim_size long with a stride of inner_size. When that
+// is 1 the slices are contiguous rows, which are vectorized along: one pass
+// takes the max, one writes exp(x - max) (softmax) or sums it (log-softmax),
+// and one normalizes. Otherwise slices next to each other are computed
+// together with the same passes, vectorized across them.
+//
+// A single "online" pass that rescales a running sum whenever the max grows
+// needs a second exp per element, which costs more than a max pass over a
+// row that stays in cache.
+
+// Contiguous rows are summed in chunks of this many elements, each into a
+// vector whose lanes are then added in double, so that long rows are summed
+// about as precisely as THNN's double sums
+constexpr int64_t kChunkSize = 256;
+
+// Slices that aren't contiguous are computed this many at a time, which are
+// next to each other, so that every pass along dim reads kColumns contiguous
+// elements at a time
+constexpr int64_t kColumns = 64;
+
+template <typename scalar_t>
+static inline scalar_t row_max(const scalar_t* x, int64_t n) {
+  using Vector = Vec<scalar_t>;
+  scalar_t max = -std::numeric_limits<scalar_t>::infinity();
+  int64_t j = 0;
+  if (n >= Vector::size) {
+    Vector max_vec(max);
+    for (; j + Vector::size <= n; j += Vector::size) {
+      max_vec = maximum(Vector::s_load(x + j), max_vec);
+    }
+    scalar_t lanes[Vector::size];
+    max_vec.store(lanes);
+    for (int k = 0; k < Vector::size; k++) {
+      max = lanes[k] > max ? lanes[k] : max;
+    }
+  }
+  for (; j < n; j++) {
+    max = x[j] > max ? x[j] : max;
+  }
+  return max;
+}
+
+// The sum of exp(x - max) over a row, which is also written to out when
+// store is set
+template <typename scalar_t, bool store>
+static inline double row_exp_sum(scalar_t* out, const scalar_t* x, int64_t n, scalar_t max) {
+  using Vector = Vec<scalar_t>;
+  Vector max_vec(max);
+  double sum = 0;
+  int64_t j = 0;
+  while (j + Vector::size <= n) {
+    int64_t chunk_end = std::min(n, j + kChunkSize);
+    Vector sum_vec(0);
+    for (; j + Vector::size <= chunk_end; j += Vector::size) {
+      auto e = (Vector::s_load(x + j) - max_vec).exp_nonpositive();
+      if (store) {
+        e.store(out + j);
+      }
+      sum_vec = sum_vec + e;
+    }
+    scalar_t lanes[Vector::size];
+    sum_vec.store(lanes);
+    for (int k = 0; k < Vector::size; k++) {
+      sum += lanes[k];
+    }
+  }
+  for (; j < n; j++) {
+    scalar_t e = std::exp(x[j] - max);
+    if (store) {
+      out[j] = e;
+    }
+    sum += e;
+  }
+  return sum;
+}
+
+// out = x * scale (softmax) or x - shift (log-softmax) over a row
+template <typename scalar_t, bool log>
+static inline void row_normalize(scalar_t* out, const scalar_t* x, int64_t n, scalar_t c) {
+  using Vector = Vec<scalar_t>;
+  Vector c_vec(c);
+  int64_t j = 0;
+  for (; j + Vector::size <= n; j += Vector::size) {
+    auto v = Vector::s_load(x + j);
+    (log ? v - c_vec : v * c_vec).store(out + j);
+  }
+  for (; j < n; j++) {
+    out[j] = log ? x[j] - c : x[j] * c;
+  }
+}
+
+template <typename scalar_t, bool log>
+static void softmax_row(scalar_t* out, const scalar_t* in, int64_t n) {
+  scalar_t max = row_max(in, n);
+  if (log) {
+    double sum = row_exp_sum<scalar_t, false>(nullptr, in, n, max);
+    row_normalize<scalar_t, true>(out, in, n, max + std::log(sum));
+  } else {
+    double sum = row_exp_sum<scalar_t, true>(out, in, n, max);
+    // like THNN, the sum is truncated to scalar_t once
+    scalar_t inv_sum = 1 / static_cast<scalar_t>(sum);
+    row_normalize<scalar_t, false>(out, out, n, inv_sum);
+  }
+}
+
+// The width (at most kColumns) slices that start at in and out, next to each
+// other. Each of them is a lane of a vector, except for the last
+// width % Vec<scalar_t>::size.
+template <typename scalar_t, bool log>
+static void softmax_columns(scalar_t* out, const scalar_t* in, int64_t width,
+                            int64_t dim_size, int64_t stride) {
+  using Vector = Vec<scalar_t>;
+  int64_t vec_width = width - width % Vector::size;
+  scalar_t max[kColumns], sum[kColumns];
+  std::fill(max, max + width, -std::numeric_limits<scalar_t>::infinity());
+  std::fill(sum, sum + width, scalar_t(0));
+
+  for (int64_t d = 0; d < dim_size; d++) {
+    const scalar_t* x = in + d * stride;
+    for (int64_t j = 0; j < vec_width; j += Vector::size) {
+      maximum(Vector::s_load(x + j), Vector::s_load(max + j)).store(max + j);
+    }
+    for (int64_t j = vec_width; j < width; j++) {
+      max[j] = x[j] > max[j] ? x[j] : max[j];
+    }
+  }
+  for (int64_t d = 0; d < dim_size; d++) {
+    const scalar_t* x = in + d * stride;
+    scalar_t* y = out + d * stride;
+    for (int64_t j = 0; j < vec_width; j += Vector::size) {
+      auto e = (Vector::s_load(x + j) - Vector::s_load(max + j)).exp_nonpositive();
+      if (!log) {
+        e.store(y + j);
+      }
+      (Vector::s_load(sum + j) + e).store(sum + j);
+    }
+    for (int64_t j = vec_width; j < width; j++) {
+      scalar_t e = std::exp(x[j] - max[j]);
+      if (!log) {
+        y[j] = e;
+      }
+      sum[j] += e;
+    }
+  }
+
+  // the shift (log-softmax) or scale (softmax) of every slice
+  for (int64_t j = 0; j < width; j++) {
+    sum[j] = log ? max[j] + std::log(sum[j]) : 1 / sum[j];
+  }
+  for (int64_t d = 0; d < dim_size; d++) {
+    const scalar_t* x = in + d * stride;
+    scalar_t* y = out + d * stride;
+    for (int64_t j = 0; j < vec_width; j += Vector::size) {
+      auto c = Vector::s_load(sum + j);
+      (log ? Vector::s_load(x + j) - c : Vector::s_load(y + j) * c).store(y + j);
+    }
+    for (int64_t j = vec_width; j < width; j++) {
+      y[j] = log ? x[j] - sum[j] : y[j] * sum[j];
+    }
+  }
+}
+
+template <typename scalar_t, bool log>
+static void softmax_impl(Tensor& output, const Tensor& input, int64_t dim) {
+  int64_t dim_size = input.dim() > 0 ? input.size(dim) : 1;
+  int64_t inner_size = 1;
+  for (int64_t d = dim + 1; d < input.dim(); d++) {
+    inner_size *= input.size(d);
+  }
+  int64_t outer_size = input.numel() / (dim_size * inner_size);
+  const scalar_t* in = input.data<scalar_t>();
+  scalar_t* out = output.data<scalar_t>();
+
+  if (inner_size == 1) {
+    int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / dim_size);
+    parallel_for(0, outer_size, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t row = begin; row < end; row++) {
+        softmax_row<scalar_t, log>(out + row * dim_size, in + row * dim_size, dim_size);
+      }
+    });
+    return;
+  }
+
+  // every outer index has groups of kColumns slices, the last of which may
+  // be narrower
+  int64_t groups = (inner_size + kColumns - 1) / kColumns;
+  int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / (dim_size * kColumns));
+  parallel_for(0, outer_size * groups, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      int64_t offset = (i / groups) * dim_size * inner_size + (i % groups) * kColumns;
+      int64_t width = std::min(kColumns, inner_size - (i % groups) * kColumns);
+      softmax_columns<scalar_t, log>(out + offset, in + offset, width, dim_size, inner_size);
+    }
+  });
+}
+
+static void softmax_kernel_impl(Tensor& output, const Tensor& input, int64_t dim) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "softmax", [&] {
+    softmax_impl<scalar_t, false>(output, input, dim);
+  });
+}
+
+static void log_softmax_kernel_impl(Tensor& output, const Tensor& input, int64_t dim) {
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "log_softmax", [&] {
+    softmax_impl<scalar_t, true>(output, input, dim);
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(softmax_kernel, &softmax_kernel_impl);
+REGISTER_DISPATCH(log_softmax_kernel, &log_softmax_kernel_impl);
+
+}} // namespace at::native
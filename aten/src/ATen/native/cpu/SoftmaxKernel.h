@@ -0,0 +1,17 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// Softmax (or log-softmax) of a contiguous input along dim into an output of
+// the same sizes, which is contiguous too. Like THNN, the max of every slice
+// is subtracted before exponentiating, and both are NaN for slices with a
+// NaN. input is not empty.
+using softmax_fn = void(*)(Tensor& output, const Tensor& input, int64_t dim);
+
+extern DispatchStub<softmax_fn> softmax_kernel;
+extern DispatchStub<softmax_fn> log_softmax_kernel;
+
+}} // namespace at::native
@@ -1,130 +1,232 @@
 #include "ATen/native/cpu/UnaryOpsKernel.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include "ATen/Dispatch.h"
 #include "ATen/Parallel.h"
-#include "ATen/cpu/vec256/vec256.h"
+#include "ATen/native/TensorIterator.h"
 #include "ATen/native/cpu/CapabilityDispatch.h"
+#include "ATen/native/cpu/Vec.h"
 
 namespace at { namespace native { namespace {
 
-using namespace vec256;
-
 template <typename scalar_t, typename F>
 static void unary_kernel(scalar_t* arr_out, const scalar_t* arr_in, int64_t size, F func) {
-  using Vec = Vec256<scalar_t>;
-  int64_t size_rounded = size - (size % Vec::size);
+  using Vector = Vec<scalar_t>;
+  int64_t size_rounded = size - (size % Vector::size);
   int64_t k = 0;
-  for (; k != size_rounded; k += Vec::size) {
-    auto value = func(Vec::s_load(arr_in + k));
+  for (; k != size_rounded; k += Vector::size) {
+    auto value = func(Vector::s_load(arr_in + k));
     value.store(arr_out + k);
   }
   auto leftover = size - k;
   if (leftover > 0) {
-    Vec a;
+    Vector a;
     a.load_partial(arr_in + k, leftover);
     func(a).store_partial(arr_out + k, leftover);
   }
 }
 
-template <class scalar_t, class F>
-static void parallel_apply(Tensor& result, const Tensor& self, F f) {
-  internal::init_tbb_num_threads();
+// Strided version of unary_kernel. Elements are gathered into a small
+// contiguous buffer, so that func still runs on full vectors.
+template <typename scalar_t, typename F>
+static void strided_unary_kernel(
+    scalar_t* arr_out, int64_t stride_out,
+    const scalar_t* arr_in, int64_t stride_in,
+    int64_t size, F func) {
+  if (stride_out == 1 && stride_in == 1) {
+    unary_kernel(arr_out, arr_in, size, func);
+    return;
+  }
+  constexpr int64_t BUF_SIZE = 4 * Vec<scalar_t>::size;
+  scalar_t buf[BUF_SIZE];
+  for (int64_t k = 0; k < size; k += BUF_SIZE) {
+    int64_t n = std::min(BUF_SIZE, size - k);
+    for (int64_t i = 0; i != n; i++) {
+      buf[i] = arr_in[(k + i) * stride_in];
+    }
+    unary_kernel(buf, buf, n, func);
+    for (int64_t i = 0; i != n; i++) {
+      arr_out[(k + i) * stride_out] = buf[i];
+    }
+  }
+}
 
-  static tbb::affinity_partitioner ap;
+// BFloat16 has no arithmetic of its own: elements are widened to float a
+// buffer at a time, func runs on float vectors and the results are rounded
+// back.
+template <typename F>
+static void strided_unary_kernel(
+    BFloat16* arr_out, int64_t stride_out,
+    const BFloat16* arr_in, int64_t stride_in,
+    int64_t size, F func) {
+  constexpr int64_t BUF_SIZE = 4 * Vec<float>::size;
+  float buf[BUF_SIZE];
+  for (int64_t k = 0; k < size; k += BUF_SIZE) {
+    int64_t n = std::min(BUF_SIZE, size - k);
+    for (int64_t i = 0; i != n; i++) {
+      buf[i] = convert<float>(arr_in[(k + i) * stride_in]);
+    }
+    unary_kernel(buf, buf, n, func);
+    for (int64_t i = 0; i != n; i++) {
+      arr_out[(k + i) * stride_out] = convert<BFloat16>(buf[i]);
+    }
+  }
+}
 
+// The vector type func is called with for scalar_t
+template <typename scalar_t>
+struct ComputeType {
+  using type = scalar_t;
+};
+template <>
+struct ComputeType<BFloat16> {
+  using type = float;
+};
+template <typename scalar_t>
+using ComputeVec = Vec<typename ComputeType<scalar_t>::type>;
+
+// Works on tensors of any layout, contiguous ones take a single inner loop.
+// grain_size can be lowered for ops that do more work per element
+template <class scalar_t, class F>
+static void parallel_apply(Tensor& result, const Tensor& self, F f, int64_t grain_size = internal::GRAIN_SIZE) {
   auto arr_out = result.data<scalar_t>();
   auto arr_in = self.data<scalar_t>();
-  int64_t size = self.numel();
-  if (size < internal::TBB_GRAIN_SIZE) {
-    unary_kernel(arr_out, arr_in, size, f);
-  } else {
-    tbb::parallel_for(
-        tbb::blocked_range<int64_t>(0, size, internal::TBB_GRAIN_SIZE),
-        [&](const tbb::blocked_range<int64_t>& r) {
-          auto size = r.end() - r.begin();
-          unary_kernel(arr_out + r.begin(), arr_in + r.begin(), size, f);
-        },
-        ap);
-  }
+  TensorIterator iter({result, self});
+  int64_t stride_out = iter.inner_stride(0);
+  int64_t stride_in = iter.inner_stride(1);
+  parallel_for(0, iter.numel(), grain_size, [&](int64_t begin, int64_t end) {
+    iter.for_each(begin, end, [&](const int64_t* offsets, int64_t size) {
+      strided_unary_kernel(
+          arr_out + offsets[0], stride_out, arr_in + offsets[1], stride_in, size, f);
+    });
+  });
 }
 
 static void abs_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_ALL_TYPES(self.type(), "abs", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vec<scalar_t>& x) {
       return x.abs();
     });
   });
 }
 
 static void ceil_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "ceil", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "ceil", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.ceil();
     });
   });
 }
 
 static void cos_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "cos", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "cos", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.cos();
     });
   });
 }
 
+static void erf_kernel(Tensor& result, const Tensor& self) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "erf", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
+      return x.erf();
+    });
+  });
+}
+
 static void exp_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "exp", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "exp", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.exp();
     });
   });
 }
 
+static void expm1_kernel(Tensor& result, const Tensor& self) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "expm1", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
+      return x.expm1();
+    });
+  });
+}
+
 static void floor_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "floor", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "floor", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.floor();
     });
   });
 }
 
 static void log_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "log", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "log", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.log();
     });
   });
 }
 
+static void log1p_kernel(Tensor& result, const Tensor& self) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "log1p", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
+      return x.log1p();
+    });
+  });
+}
+
 static void round_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "round", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "round", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.round();
     });
   });
 }
 
+static void rsqrt_kernel(Tensor& result, const Tensor& self) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "rsqrt", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
+      return x.rsqrt();
+    });
+  });
+}
+
+static void sigmoid_kernel(Tensor& result, const Tensor& self) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "sigmoid", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
+      return x.sigmoid();
+    });
+  });
+}
+
 static void sin_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "sin", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "sin", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.sin();
     });
   });
 }
 
 static void sqrt_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "sqrt", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "sqrt", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.sqrt();
     });
   });
 }
 
+static void tanh_kernel(Tensor& result, const Tensor& self) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "tanh", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
+      return x.tanh();
+    });
+  });
+}
+
 static void trunc_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "trunc", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+  AT_DISPATCH_FLOATING_TYPES_AND_BFLOAT16(self.type(), "trunc", [&] {
+    parallel_apply<scalar_t>(result, self, [](const ComputeVec<scalar_t>& x) {
       return x.trunc();
     });
   });
@@ -135,12 +237,18 @@ static void trunc_kernel(Tensor& result, const Tensor& self) {
 REGISTER_DISPATCH(absImpl, &abs_kernel);
 REGISTER_DISPATCH(ceilImpl, &ceil_kernel);
 REGISTER_DISPATCH(cosImpl, &cos_kernel);
+REGISTER_DISPATCH(erfImpl, &erf_kernel);
 REGISTER_DISPATCH(expImpl, &exp_kernel);
+REGISTER_DISPATCH(expm1Impl, &expm1_kernel);
 REGISTER_DISPATCH(floorImpl, &floor_kernel);
 REGISTER_DISPATCH(logImpl, &log_kernel);
+REGISTER_DISPATCH(log1pImpl, &log1p_kernel);
 REGISTER_DISPATCH(roundImpl, &round_kernel);
+REGISTER_DISPATCH(rsqrtImpl, &rsqrt_kernel);
+REGISTER_DISPATCH(sigmoidImpl, &sigmoid_kernel);
 REGISTER_DISPATCH(sinImpl, &sin_kernel);
 REGISTER_DISPATCH(sqrtImpl, &sqrt_kernel);
+REGISTER_DISPATCH(tanhImpl, &tanh_kernel);
 REGISTER_DISPATCH(truncImpl, &trunc_kernel);
 
 }} // namespace at::native
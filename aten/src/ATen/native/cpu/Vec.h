@@ -0,0 +1,22 @@
+#pragma once
+
+// Vec<T> is the widest vector type available to the capability the including
+// kernel is compiled for: Vec512 under AVX512 and Vec256 otherwise. Kernels
+// written against Vec<T> get the AVX512 tier for free.
+
+#include "ATen/cpu/vec256/vec256.h"
+#if defined(CPU_CAPABILITY_AVX512)
+#include "ATen/cpu/vec512/vec512.h"
+#endif
+
+namespace at { namespace native { namespace {
+
+#if defined(CPU_CAPABILITY_AVX512)
+template <typename T>
+using Vec = vec512::Vec512<T>;
+#else
+template <typename T>
+using Vec = vec256::Vec256<T>;
+#endif
+
+}}}  // namespace at::native
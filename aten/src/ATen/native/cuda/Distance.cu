@@ -0,0 +1,359 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/native/Distance.h"
+
+#include "ATen/cuda/AccumulateType.cuh"
+#include "ATen/cuda/CUDATensorMethods.cuh"
+#include "ATen/cuda/CUDATypeConversion.cuh"
+
+#include <THC/THCDeviceUtils.cuh>
+#include <THC/THCGeneral.h>
+#include <THC/THCNumerics.cuh>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+
+namespace at { namespace native {
+
+namespace {
+
+// cdist computes TILE x TILE blocks of distances, reading TILE columns of
+// the rows of both blocks at a time through shared memory
+static const int TILE = 16;
+static const int BLOCK_SIZE = 256;
+static const int MAX_GRID_SIZE = 65535;
+
+template <typename T>
+__device__ __forceinline__ T sign(T x) {
+  return (0 < x) - (x < 0);
+}
+
+// Each distance maps every difference to a contribution, combines them
+// with combine (starting from 0) and turns the result into the distance
+// with finish. The gradient wrt a difference is
+// backward(diff, coef(grad, dist, p), dist, p), or 0 when coef is 0, like
+// in the CPU kernels.
+
+template <typename T>
+struct ZeroDist {
+  static __device__ __forceinline__ T map(T diff, T p) { return diff != 0; }
+  static __device__ __forceinline__ T combine(T a, T b) { return a + b; }
+  static __device__ __forceinline__ T finish(T agg, T p) { return agg; }
+  static __device__ __forceinline__ T coef(T grad, T dist, T p) { return 0; }
+  static __device__ __forceinline__ T backward(T diff, T coef, T dist, T p) { return 0; }
+};
+
+template <typename T>
+struct OneDist {
+  static __device__ __forceinline__ T map(T diff, T p) { return THCNumerics<T>::abs(diff); }
+  static __device__ __forceinline__ T combine(T a, T b) { return a + b; }
+  static __device__ __forceinline__ T finish(T agg, T p) { return agg; }
+  static __device__ __forceinline__ T coef(T grad, T dist, T p) { return grad; }
+  static __device__ __forceinline__ T backward(T diff, T coef, T dist, T p) {
+    return coef * sign(diff);
+  }
+};
+
+template <typename T>
+struct TwoDist {
+  static __device__ __forceinline__ T map(T diff, T p) { return diff * diff; }
+  static __device__ __forceinline__ T combine(T a, T b) { return a + b; }
+  static __device__ __forceinline__ T finish(T agg, T p) { return THCNumerics<T>::sqrt(agg); }
+  static __device__ __forceinline__ T coef(T grad, T dist, T p) {
+    return dist == 0 ? T(0) : grad / dist;
+  }
+  static __device__ __forceinline__ T backward(T diff, T coef, T dist, T p) {
+    return coef * diff;
+  }
+};
+
+template <typename T>
+struct InfDist {
+  static __device__ __forceinline__ T map(T diff, T p) { return THCNumerics<T>::abs(diff); }
+  static __device__ __forceinline__ T combine(T a, T b) { return a > b ? a : b; }
+  static __device__ __forceinline__ T finish(T agg, T p) { return agg; }
+  static __device__ __forceinline__ T coef(T grad, T dist, T p) { return grad; }
+  static __device__ __forceinline__ T backward(T diff, T coef, T dist, T p) {
+    return coef * sign(diff) * (THCNumerics<T>::abs(diff) == dist);
+  }
+};
+
+template <typename T>
+struct PDist {
+  static __device__ __forceinline__ T map(T diff, T p) {
+    return THCNumerics<T>::pow(THCNumerics<T>::abs(diff), p);
+  }
+  static __device__ __forceinline__ T combine(T a, T b) { return a + b; }
+  static __device__ __forceinline__ T finish(T agg, T p) {
+    return THCNumerics<T>::pow(agg, 1 / p);
+  }
+  static __device__ __forceinline__ T coef(T grad, T dist, T p) {
+    return dist == 0 ? T(0) : grad / THCNumerics<T>::pow(dist, p - 1);
+  }
+  static __device__ __forceinline__ T backward(T diff, T coef, T dist, T p) {
+    return diff == 0 ? T(0) : coef * sign(diff) * THCNumerics<T>::pow(THCNumerics<T>::abs(diff), p - 1);
+  }
+};
+
+// One TILE x TILE block of the N x M distances per thread block
+template <typename scalar_t, typename accscalar_t, typename Dist>
+__global__ void cdist_kernel(scalar_t* result, const scalar_t* x1, const scalar_t* x2,
+                             int64_t N, int64_t M, int64_t D, accscalar_t p) {
+  __shared__ accscalar_t tile1[TILE][TILE + 1];
+  __shared__ accscalar_t tile2[TILE][TILE + 1];
+  int tx = threadIdx.x;
+  int ty = threadIdx.y;
+  int64_t i = blockIdx.y * TILE + ty;
+  int64_t j = blockIdx.x * TILE + tx;
+  // thread (ty, tx) loads column tx of row ty of both blocks
+  int64_t row2 = blockIdx.x * TILE + ty;
+
+  accscalar_t agg = 0;
+  for (int64_t k0 = 0; k0 < D; k0 += TILE) {
+    int64_t k = k0 + tx;
+    tile1[ty][tx] = (i < N && k < D) ? scalar_cast<accscalar_t>(x1[i * D + k]) : accscalar_t(0);
+    tile2[ty][tx] = (row2 < M && k < D) ? scalar_cast<accscalar_t>(x2[row2 * D + k]) : accscalar_t(0);
+    __syncthreads();
+    int64_t width = min((int64_t)TILE, D - k0);
+    for (int64_t kk = 0; kk < width; kk++) {
+      agg = Dist::combine(agg, Dist::map(tile1[ty][kk] - tile2[tx][kk], p));
+    }
+    __syncthreads();
+  }
+  if (i < N && j < M) {
+    result[i * M + j] = scalar_cast<scalar_t>(Dist::finish(agg, p));
+  }
+}
+
+// One thread per element of the N x D gradient, summing over the M rows of x2
+template <typename scalar_t, typename accscalar_t, typename Dist>
+__global__ void cdist_backward_kernel(scalar_t* grad_x1, const scalar_t* grad,
+                                      const scalar_t* x1, const scalar_t* x2,
+                                      const scalar_t* cdist, int64_t N, int64_t M, int64_t D,
+                                      accscalar_t p) {
+  for (int64_t index = blockIdx.x * blockDim.x + threadIdx.x; index < N * D;
+       index += blockDim.x * gridDim.x) {
+    int64_t i = index / D;
+    int64_t k = index % D;
+    accscalar_t a = scalar_cast<accscalar_t>(x1[index]);
+    accscalar_t sum = 0;
+    for (int64_t j = 0; j < M; j++) {
+      accscalar_t dist = scalar_cast<accscalar_t>(cdist[i * M + j]);
+      accscalar_t c = Dist::coef(scalar_cast<accscalar_t>(grad[i * M + j]), dist, p);
+      if (c != 0) {
+        sum += Dist::backward(a - scalar_cast<accscalar_t>(x2[j * D + k]), c, dist, p);
+      }
+    }
+    grad_x1[index] = scalar_cast<scalar_t>(sum);
+  }
+}
+
+// One block per row, which reduces its strided part of the row and then
+// combines the partial results in shared memory
+template <typename scalar_t, typename accscalar_t, typename Dist>
+__global__ void pairwise_distance_kernel(scalar_t* result, const scalar_t* x1, const scalar_t* x2,
+                                         int64_t N, int64_t D, int64_t stride1, int64_t stride2,
+                                         accscalar_t p, accscalar_t eps) {
+  __shared__ accscalar_t partial[BLOCK_SIZE];
+  int tid = threadIdx.x;
+  for (int64_t i = blockIdx.x; i < N; i += gridDim.x) {
+    const scalar_t* a = x1 + i * stride1;
+    const scalar_t* b = x2 + i * stride2;
+    accscalar_t agg = 0;
+    for (int64_t k = tid; k < D; k += BLOCK_SIZE) {
+      accscalar_t diff = scalar_cast<accscalar_t>(a[k]) - scalar_cast<accscalar_t>(b[k]) + eps;
+      agg = Dist::combine(agg, Dist::map(diff, p));
+    }
+    partial[tid] = agg;
+    __syncthreads();
+    for (int offset = BLOCK_SIZE / 2; offset > 0; offset >>= 1) {
+      if (tid < offset) {
+        partial[tid] = Dist::combine(partial[tid], partial[tid + offset]);
+      }
+      __syncthreads();
+    }
+    if (tid == 0) {
+      result[i] = scalar_cast<scalar_t>(Dist::finish(partial[0], p));
+    }
+    __syncthreads();
+  }
+}
+
+template <typename scalar_t, typename accscalar_t, typename Dist>
+__global__ void pairwise_distance_backward_kernel(scalar_t* grad_x1, const scalar_t* grad,
+                                                  const scalar_t* x1, const scalar_t* x2,
+                                                  const scalar_t* result, int64_t N, int64_t D,
+                                                  int64_t stride1, int64_t stride2,
+                                                  accscalar_t p, accscalar_t eps) {
+  for (int64_t index = blockIdx.x * blockDim.x + threadIdx.x; index < N * D;
+       index += blockDim.x * gridDim.x) {
+    int64_t i = index / D;
+    int64_t k = index % D;
+    accscalar_t dist = scalar_cast<accscalar_t>(result[i]);
+    accscalar_t c = Dist::coef(scalar_cast<accscalar_t>(grad[i]), dist, p);
+    accscalar_t diff = scalar_cast<accscalar_t>(x1[i * stride1 + k]) -
+        scalar_cast<accscalar_t>(x2[i * stride2 + k]) + eps;
+    grad_x1[index] = scalar_cast<scalar_t>(c == 0 ? accscalar_t(0) : Dist::backward(diff, c, dist, p));
+  }
+}
+
+static dim3 elementwise_grid(int64_t numel) {
+  return dim3(std::min<int64_t>(THCCeilDiv(numel, (int64_t)BLOCK_SIZE), MAX_GRID_SIZE));
+}
+
+// Launches Kernel<scalar_t, accscalar_t, Dist> for the distance for p
+template <template <typename, typename, typename> class Launch, typename scalar_t,
+          typename accscalar_t, typename... Args>
+static void dispatch_p(double p, Args&&... args) {
+  if (p == 0) {
+    Launch<scalar_t, accscalar_t, ZeroDist<accscalar_t>>::run(std::forward<Args>(args)...);
+  } else if (p == 1) {
+    Launch<scalar_t, accscalar_t, OneDist<accscalar_t>>::run(std::forward<Args>(args)...);
+  } else if (p == 2) {
+    Launch<scalar_t, accscalar_t, TwoDist<accscalar_t>>::run(std::forward<Args>(args)...);
+  } else if (std::isinf(p)) {
+    Launch<scalar_t, accscalar_t, InfDist<accscalar_t>>::run(std::forward<Args>(args)...);
+  } else {
+    Launch<scalar_t, accscalar_t, PDist<accscalar_t>>::run(std::forward<Args>(args)...);
+  }
+}
+
+template <typename scalar_t, typename accscalar_t, typename Dist>
+struct CdistLaunch {
+  static void run(Tensor& result, const Tensor& x1, const Tensor& x2, accscalar_t p) {
+    int64_t N = x1.size(0);
+    int64_t M = x2.size(0);
+    int64_t D = x1.size(1);
+    dim3 block(TILE, TILE);
+    dim3 grid(THCCeilDiv(M, (int64_t)TILE), THCCeilDiv(N, (int64_t)TILE));
+    cudaStream_t stream = globalContext().getCurrentCUDAStream();
+    cdist_kernel<scalar_t, accscalar_t, Dist><<<grid, block, 0, stream>>>(
+        result.data<scalar_t>(), x1.data<scalar_t>(), x2.data<scalar_t>(), N, M, D, p);
+  }
+};
+
+template <typename scalar_t, typename accscalar_t, typename Dist>
+struct CdistBackwardLaunch {
+  static void run(Tensor& grad_x1, const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                  const Tensor& cdist, accscalar_t p) {
+    int64_t N = x1.size(0);
+    int64_t M = x2.size(0);
+    int64_t D = x1.size(1);
+    cudaStream_t stream = globalContext().getCurrentCUDAStream();
+    cdist_backward_kernel<scalar_t, accscalar_t, Dist>
+        <<<elementwise_grid(N * D), BLOCK_SIZE, 0, stream>>>(
+        grad_x1.data<scalar_t>(), grad.data<scalar_t>(), x1.data<scalar_t>(),
+        x2.data<scalar_t>(), cdist.data<scalar_t>(), N, M, D, p);
+  }
+};
+
+template <typename scalar_t, typename accscalar_t, typename Dist>
+struct PairwiseDistanceLaunch {
+  static void run(Tensor& result, const Tensor& x1, const Tensor& x2, accscalar_t p,
+                  accscalar_t eps) {
+    int64_t N = x1.size(0);
+    int64_t D = x1.size(1);
+    dim3 grid(std::min<int64_t>(N, MAX_GRID_SIZE));
+    cudaStream_t stream = globalContext().getCurrentCUDAStream();
+    pairwise_distance_kernel<scalar_t, accscalar_t, Dist><<<grid, BLOCK_SIZE, 0, stream>>>(
+        result.data<scalar_t>(), x1.data<scalar_t>(), x2.data<scalar_t>(), N, D,
+        x1.stride(0), x2.stride(0), p, eps);
+  }
+};
+
+template <typename scalar_t, typename accscalar_t, typename Dist>
+struct PairwiseDistanceBackwardLaunch {
+  static void run(Tensor& grad_x1, const Tensor& grad, const Tensor& x1, const Tensor& x2,
+                  const Tensor& result, accscalar_t p, accscalar_t eps) {
+    int64_t N = x1.size(0);
+    int64_t D = x1.size(1);
+    cudaStream_t stream = globalContext().getCurrentCUDAStream();
+    pairwise_distance_backward_kernel<scalar_t, accscalar_t, Dist>
+        <<<elementwise_grid(N * D), BLOCK_SIZE, 0, stream>>>(
+        grad_x1.data<scalar_t>(), grad.data<scalar_t>(), x1.data<scalar_t>(),
+        x2.data<scalar_t>(), result.data<scalar_t>(), N, D, x1.stride(0), x2.stride(0),
+        p, eps);
+  }
+};
+
+} // namespace
+
+Tensor _cdist_forward_cuda(const Tensor& x1_, const Tensor& x2_, double p) {
+  check_cdist("cdist", x1_, x2_, p);
+  if (cdist_use_gemm(x1_, x2_, p)) {
+    return euclidean_dist_gemm(x1_, x2_);
+  }
+  auto x1 = x1_.contiguous();
+  auto x2 = x2_.contiguous();
+  auto result = x1.type().tensor({x1.size(0), x2.size(0)});
+  if (result.numel() == 0) {
+    return result;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(x1.type(), "cdist", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    dispatch_p<CdistLaunch, cuda_scalar_t, accscalar_t>(p, result, x1, x2, (accscalar_t)p);
+  });
+  THCudaCheck(cudaGetLastError());
+  return result;
+}
+
+Tensor _cdist_backward_cuda(const Tensor& grad_, const Tensor& x1_, const Tensor& x2_, double p,
+                            const Tensor& cdist_) {
+  if (p == 2) {
+    return euclidean_dist_backward_gemm(grad_, x1_, x2_, cdist_);
+  }
+  auto grad = grad_.contiguous();
+  auto x1 = x1_.contiguous();
+  auto x2 = x2_.contiguous();
+  auto cdist = cdist_.contiguous();
+  auto grad_x1 = x1.type().tensor(x1.sizes());
+  if (grad_x1.numel() == 0) {
+    return grad_x1;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(x1.type(), "cdist_backward", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    dispatch_p<CdistBackwardLaunch, cuda_scalar_t, accscalar_t>(
+        p, grad_x1, grad, x1, x2, cdist, (accscalar_t)p);
+  });
+  THCudaCheck(cudaGetLastError());
+  return grad_x1;
+}
+
+Tensor _pairwise_distance_forward_cuda(const Tensor& x1, const Tensor& x2, double p, double eps) {
+  auto result = x1.type().tensor({x1.size(0)});
+  if (result.numel() == 0) {
+    return result;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(x1.type(), "pairwise_distance", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    dispatch_p<PairwiseDistanceLaunch, cuda_scalar_t, accscalar_t>(
+        p, result, x1, x2, (accscalar_t)p, (accscalar_t)eps);
+  });
+  THCudaCheck(cudaGetLastError());
+  return result;
+}
+
+Tensor _pairwise_distance_backward_cuda(const Tensor& grad_, const Tensor& x1, const Tensor& x2,
+                                        double p, double eps, const Tensor& result_) {
+  auto grad = grad_.contiguous();
+  auto result = result_.contiguous();
+  auto grad_x1 = x1.type().tensor(x1.sizes());
+  if (grad_x1.numel() == 0) {
+    return grad_x1;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(x1.type(), "pairwise_distance_backward", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    dispatch_p<PairwiseDistanceBackwardLaunch, cuda_scalar_t, accscalar_t>(
+        p, grad_x1, grad, x1, x2, result, (accscalar_t)p, (accscalar_t)eps);
+  });
+  THCudaCheck(cudaGetLastError());
+  return grad_x1;
+}
+
+}} // namespace at::native
@@ -146,7 +146,11 @@ __global__ void EmbeddingBag_accGradParametersKernel(
 std::tuple<Tensor, Tensor, Tensor>
 embedding_bag_cuda(const Tensor &weight, const Tensor &indices,
                    const Tensor &offsets, const bool scale_grad_by_freq,
-                   const int64_t mode, bool sparse) {
+                   const int64_t mode, bool sparse,
+                   const Tensor &per_sample_weights) {
+  if (per_sample_weights.defined()) {
+    AT_ERROR("embedding_bag_cuda: per_sample_weights is only supported on CPU");
+  }
   auto indices_arg = TensorArg(indices, "indices", 1);
   checkScalarType("embedding_bag_cuda", indices_arg, kLong);
   checkContiguous("embedding_bag_cuda", indices_arg);
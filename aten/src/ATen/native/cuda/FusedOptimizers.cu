@@ -0,0 +1,227 @@
+#include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
+#include "ATen/Error.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/native/FusedOptimizers.h"
+#include "ATen/native/cuda/MultiTensorApply.cuh"
+
+#include "ATen/cuda/AccumulateType.cuh"
+#include "ATen/cuda/CUDATensorMethods.cuh"
+#include "ATen/cuda/CUDATypeConversion.cuh"
+
+#include <THC/THCNumerics.cuh>
+
+
+namespace at { namespace native {
+
+namespace {
+
+// The lists are params, grads, then momentum_buffers and model_params when
+// they are used. The update is computed in the accumulation type of the
+// params, model_t is the type of the model_params and grad_t the type of the
+// grads, which is either.
+template <typename scalar_t, typename grad_t, typename model_t,
+          bool has_momentum, bool has_model>
+struct SGDStepOp {
+  using accscalar_t = cuda::acc_type<scalar_t>;
+
+  accscalar_t lr;
+  accscalar_t weight_decay;
+  accscalar_t momentum;
+  accscalar_t dampening;
+  bool nesterov;
+  bool first_step;
+
+  __device__ __forceinline__ void operator()(void* const* ptrs, int64_t i) const {
+    scalar_t* param = static_cast<scalar_t*>(ptrs[0]);
+    accscalar_t p = scalar_cast<accscalar_t>(param[i]);
+    accscalar_t d = scalar_cast<accscalar_t>(static_cast<grad_t*>(ptrs[1])[i]);
+    if (weight_decay != 0) {
+      d += weight_decay * p;
+    }
+    if (has_momentum) {
+      scalar_t* buf = static_cast<scalar_t*>(ptrs[2]);
+      accscalar_t b = first_step ? d : momentum * scalar_cast<accscalar_t>(buf[i]) + (1 - dampening) * d;
+      buf[i] = scalar_cast<scalar_t>(b);
+      d = nesterov ? d + momentum * b : b;
+    }
+    p -= lr * d;
+    param[i] = scalar_cast<scalar_t>(p);
+    if (has_model) {
+      static_cast<model_t*>(ptrs[has_momentum ? 3 : 2])[i] = scalar_cast<model_t>(p);
+    }
+  }
+};
+
+// The lists are params, grads, exp_avgs, exp_avg_sqs, then model_params
+template <typename scalar_t, typename grad_t, typename model_t, bool has_model>
+struct AdamStepOp {
+  using accscalar_t = cuda::acc_type<scalar_t>;
+
+  accscalar_t step_size;
+  accscalar_t beta1;
+  accscalar_t beta2;
+  accscalar_t eps;
+  accscalar_t weight_decay;
+
+  __device__ __forceinline__ void operator()(void* const* ptrs, int64_t i) const {
+    scalar_t* param = static_cast<scalar_t*>(ptrs[0]);
+    scalar_t* exp_avg = static_cast<scalar_t*>(ptrs[2]);
+    scalar_t* exp_avg_sq = static_cast<scalar_t*>(ptrs[3]);
+    accscalar_t p = scalar_cast<accscalar_t>(param[i]);
+    accscalar_t g = scalar_cast<accscalar_t>(static_cast<grad_t*>(ptrs[1])[i]);
+    if (weight_decay != 0) {
+      g += weight_decay * p;
+    }
+    accscalar_t m = beta1 * scalar_cast<accscalar_t>(exp_avg[i]) + (1 - beta1) * g;
+    accscalar_t v = beta2 * scalar_cast<accscalar_t>(exp_avg_sq[i]) + (1 - beta2) * g * g;
+    exp_avg[i] = scalar_cast<scalar_t>(m);
+    exp_avg_sq[i] = scalar_cast<scalar_t>(v);
+    p -= step_size * m / (THCNumerics<accscalar_t>::sqrt(v) + eps);
+    param[i] = scalar_cast<scalar_t>(p);
+    if (has_model) {
+      static_cast<model_t*>(ptrs[4])[i] = scalar_cast<model_t>(p);
+    }
+  }
+};
+
+template <typename scalar_t, typename grad_t, typename model_t>
+void sgd_step(TensorList params, TensorList grads, TensorList momentum_buffers,
+              TensorList model_params, double lr, double weight_decay, double momentum,
+              double dampening, bool nesterov, bool first_step) {
+  using accscalar_t = cuda::acc_type<scalar_t>;
+  auto a = [](double x) { return static_cast<accscalar_t>(x); };
+  if (momentum_buffers.empty() && model_params.empty()) {
+    multi_tensor_apply<2>({params, grads}, SGDStepOp<scalar_t, grad_t, model_t, false, false>{
+        a(lr), a(weight_decay), a(momentum), a(dampening), nesterov, first_step});
+  } else if (model_params.empty()) {
+    multi_tensor_apply<3>({params, grads, momentum_buffers}, SGDStepOp<scalar_t, grad_t, model_t, true, false>{
+        a(lr), a(weight_decay), a(momentum), a(dampening), nesterov, first_step});
+  } else if (momentum_buffers.empty()) {
+    multi_tensor_apply<3>({params, grads, model_params}, SGDStepOp<scalar_t, grad_t, model_t, false, true>{
+        a(lr), a(weight_decay), a(momentum), a(dampening), nesterov, first_step});
+  } else {
+    multi_tensor_apply<4>({params, grads, momentum_buffers, model_params},
+        SGDStepOp<scalar_t, grad_t, model_t, true, true>{
+            a(lr), a(weight_decay), a(momentum), a(dampening), nesterov, first_step});
+  }
+}
+
+template <typename scalar_t, typename grad_t, typename model_t>
+void adam_step(TensorList params, TensorList grads, TensorList exp_avgs, TensorList exp_avg_sqs,
+               TensorList model_params, double step_size, double beta1, double beta2,
+               double eps, double weight_decay) {
+  using accscalar_t = cuda::acc_type<scalar_t>;
+  auto a = [](double x) { return static_cast<accscalar_t>(x); };
+  if (model_params.empty()) {
+    multi_tensor_apply<4>({params, grads, exp_avgs, exp_avg_sqs},
+        AdamStepOp<scalar_t, grad_t, model_t, false>{
+            a(step_size), a(beta1), a(beta2), a(eps), a(weight_decay)});
+  } else {
+    multi_tensor_apply<5>({params, grads, exp_avgs, exp_avg_sqs, model_params},
+        AdamStepOp<scalar_t, grad_t, model_t, true>{
+            a(step_size), a(beta1), a(beta2), a(eps), a(weight_decay)});
+  }
+}
+
+// Every tensor of the lists is on the GPU of the first param
+static void check_same_gpu(CheckedFrom c, ArrayRef<TensorList> lists) {
+  int64_t device = lists[0][0].get_device();
+  for (auto list : lists) {
+    checkBackend(c, list, kCUDA);
+    for (auto& tensor : list) {
+      if (tensor.get_device() != device) {
+        AT_ERROR("%s: expected all tensors on GPU %lld, but got one on GPU %lld",
+                 c, (long long)device, (long long)tensor.get_device());
+      }
+    }
+  }
+}
+
+// The model_params of a step are Half, with float params, and the grads are
+// all either Half or float
+static bool check_master_weights(CheckedFrom c, TensorList params, TensorList grads,
+                                 TensorList model_params) {
+  if (model_params.empty()) {
+    for (size_t i = 0; i < grads.size(); i++) {
+      checkSameType(c, TensorArg{grads[i], "grads", static_cast<int>(i)},
+                    TensorArg{params[i], "params", static_cast<int>(i)});
+    }
+    return false;
+  }
+  checkScalarType(c, TensorArg{params[0], "params", 0}, kFloat);
+  for (size_t i = 0; i < model_params.size(); i++) {
+    checkScalarType(c, TensorArg{model_params[i], "model_params", static_cast<int>(i)}, kHalf);
+  }
+  auto grad_type = grads[0].type().scalarType();
+  for (size_t i = 0; i < grads.size(); i++) {
+    checkScalarTypes(c, TensorArg{grads[i], "grads", static_cast<int>(i)}, {kFloat, kHalf});
+    if (grads[i].type().scalarType() != grad_type) {
+      AT_ERROR("%s: expected the grads to all be Half or all be Float", c);
+    }
+  }
+  return grad_type == kHalf;
+}
+
+} // anonymous namespace
+
+void _fused_sgd_step_cuda(TensorList params, TensorList grads, TensorList momentum_buffers,
+                          TensorList model_params, double lr, double weight_decay,
+                          double momentum, double dampening, bool nesterov, bool first_step) {
+  CheckedFrom c = "_fused_sgd_step";
+  check_fused_step_list(c, params, params, "params", false, true);
+  check_fused_step_list(c, params, grads, "grads", false, false);
+  check_fused_step_list(c, params, momentum_buffers, "momentum_buffers", true, true);
+  check_fused_step_list(c, params, model_params, "model_params", true, false);
+  if (params.empty()) {
+    return;
+  }
+  check_same_gpu(c, {params, grads, momentum_buffers, model_params});
+
+  if (check_master_weights(c, params, grads, model_params)) {
+    sgd_step<float, half, half>(params, grads, momentum_buffers, model_params, lr,
+                                weight_decay, momentum, dampening, nesterov, first_step);
+  } else if (!model_params.empty()) {
+    sgd_step<float, float, half>(params, grads, momentum_buffers, model_params, lr,
+                                 weight_decay, momentum, dampening, nesterov, first_step);
+  } else {
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].type(), "_fused_sgd_step", [&] {
+      using cuda_scalar_t = cuda::type<scalar_t>;
+      sgd_step<cuda_scalar_t, cuda_scalar_t, cuda_scalar_t>(
+          params, grads, momentum_buffers, model_params, lr, weight_decay, momentum,
+          dampening, nesterov, first_step);
+    });
+  }
+}
+
+void _fused_adam_step_cuda(TensorList params, TensorList grads, TensorList exp_avgs,
+                           TensorList exp_avg_sqs, TensorList model_params, double step_size,
+                           double beta1, double beta2, double eps, double weight_decay) {
+  CheckedFrom c = "_fused_adam_step";
+  check_fused_step_list(c, params, params, "params", false, true);
+  check_fused_step_list(c, params, grads, "grads", false, false);
+  check_fused_step_list(c, params, exp_avgs, "exp_avgs", false, true);
+  check_fused_step_list(c, params, exp_avg_sqs, "exp_avg_sqs", false, true);
+  check_fused_step_list(c, params, model_params, "model_params", true, false);
+  if (params.empty()) {
+    return;
+  }
+  check_same_gpu(c, {params, grads, exp_avgs, exp_avg_sqs, model_params});
+
+  if (check_master_weights(c, params, grads, model_params)) {
+    adam_step<float, half, half>(params, grads, exp_avgs, exp_avg_sqs, model_params,
+                                 step_size, beta1, beta2, eps, weight_decay);
+  } else if (!model_params.empty()) {
+    adam_step<float, float, half>(params, grads, exp_avgs, exp_avg_sqs, model_params,
+                                  step_size, beta1, beta2, eps, weight_decay);
+  } else {
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].type(), "_fused_adam_step", [&] {
+      using cuda_scalar_t = cuda::type<scalar_t>;
+      adam_step<cuda_scalar_t, cuda_scalar_t, cuda_scalar_t>(
+          params, grads, exp_avgs, exp_avg_sqs, model_params, step_size, beta1, beta2,
+          eps, weight_decay);
+    });
+  }
+}
+
+}} // namespace at::native
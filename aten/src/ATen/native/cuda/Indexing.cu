@@ -0,0 +1,133 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/native/IndexingUtils.h"
+
+#include <THC/THCDeviceUtils.cuh>
+
+#include <algorithm>
+#include <cassert>
+
+namespace at { namespace native {
+
+namespace {
+
+// Like MAX_CUTORCH_DIMS
+constexpr int kMaxIndexDims = 25;
+
+// Everything the kernel needs to compute the source offset of an element of
+// the result of _index(), passed by value. The result is made of rows, one
+// per element of the dimensions before the indexed ones and per position in
+// the indices, each holding the elements of the dimensions after them.
+struct IndexLayout {
+  int before_ndim;
+  int64_t before_sizes[kMaxIndexDims];
+  int64_t before_strides[kMaxIndexDims];
+  int inner_ndim;
+  int64_t inner_sizes[kMaxIndexDims];
+  int64_t inner_strides[kMaxIndexDims];
+  int nindices;
+  // contiguous indices, npos elements each
+  const int64_t* indices[kMaxIndexDims];
+  int64_t dim_sizes[kMaxIndexDims];
+  int64_t dim_strides[kMaxIndexDims];
+  int64_t npos;
+  int64_t inner_numel;
+};
+
+__device__ __forceinline__ int64_t dims_offset(int64_t linear, int ndim,
+                                               const int64_t* sizes, const int64_t* strides) {
+  int64_t offset = 0;
+  for (int d = ndim - 1; d >= 0; d--) {
+    offset += (linear % sizes[d]) * strides[d];
+    linear /= sizes[d];
+  }
+  return offset;
+}
+
+// One thread per element of the result, so that consecutive threads read
+// consecutive elements of the rows. Only the element size matters to copy.
+template <typename scalar_t>
+__global__ void index_gather_kernel(scalar_t* out, const scalar_t* in,
+                                    const IndexLayout layout, int64_t numel) {
+  for (int64_t linear = blockIdx.x * (int64_t)blockDim.x + threadIdx.x;
+       linear < numel;
+       linear += (int64_t)blockDim.x * gridDim.x) {
+    int64_t row = linear / layout.inner_numel;
+    int64_t pos = row % layout.npos;
+    int64_t offset =
+        dims_offset(linear % layout.inner_numel, layout.inner_ndim,
+                    layout.inner_sizes, layout.inner_strides) +
+        dims_offset(row / layout.npos, layout.before_ndim,
+                    layout.before_sizes, layout.before_strides);
+    for (int j = 0; j < layout.nindices; j++) {
+      int64_t idx = layout.indices[j][pos];
+      if (idx < 0) {
+        idx += layout.dim_sizes[j];
+      }
+      assert(idx >= 0 && idx < layout.dim_sizes[j]);
+      offset += idx * layout.dim_strides[j];
+    }
+    out[linear] = in[offset];
+  }
+}
+
+template <typename scalar_t>
+void launch_index_gather(Tensor& result, const Tensor& self, const IndexLayout& layout) {
+  const int64_t numel = result.numel();
+  const int64_t block = 512;
+  const int64_t grid = std::min<int64_t>(THCCeilDiv(numel, block), 65535);
+  index_gather_kernel<scalar_t><<<grid, block, 0, globalContext().getCurrentCUDAStream()>>>(
+      static_cast<scalar_t*>(result.data_ptr()),
+      static_cast<const scalar_t*>(self.data_ptr()),
+      layout, numel);
+  THCudaCheck(cudaGetLastError());
+}
+
+} // anonymous namespace
+
+Tensor _index_cuda(const Tensor & self, TensorList indices_) {
+  auto dims = checkIndexedDims(self, indices_);
+  auto result = self.type().tensor(dims.result_sizes);
+  if (result.numel() == 0) {
+    return result;
+  }
+  if (self.dim() > kMaxIndexDims) {
+    AT_ERROR("index(): tensors with more than %d dimensions are not supported", kMaxIndexDims);
+  }
+
+  // Broadcast indices are made contiguous, which costs one index per position
+  // instead of the linear index of every element of the result.
+  std::vector<Tensor> indices;
+  IndexLayout layout;
+  layout.before_ndim = dims.begin;
+  for (int64_t d = 0; d < dims.begin; d++) {
+    layout.before_sizes[d] = self.size(d);
+    layout.before_strides[d] = self.stride(d);
+  }
+  layout.inner_ndim = self.dim() - dims.end;
+  layout.inner_numel = 1;
+  for (int64_t d = dims.end; d < self.dim(); d++) {
+    layout.inner_sizes[d - dims.end] = self.size(d);
+    layout.inner_strides[d - dims.end] = self.stride(d);
+    layout.inner_numel *= self.size(d);
+  }
+  layout.nindices = dims.end - dims.begin;
+  for (int64_t d = dims.begin; d < dims.end; d++) {
+    indices.push_back(indices_[d].contiguous());
+    layout.indices[d - dims.begin] = indices.back().data<int64_t>();
+    layout.dim_sizes[d - dims.begin] = self.size(d);
+    layout.dim_strides[d - dims.begin] = self.stride(d);
+  }
+  layout.npos = indices[0].numel();
+
+  switch (self.type().elementSizeInBytes()) {
+    case 1: launch_index_gather<uint8_t>(result, self, layout); break;
+    case 2: launch_index_gather<uint16_t>(result, self, layout); break;
+    case 4: launch_index_gather<uint32_t>(result, self, layout); break;
+    case 8: launch_index_gather<uint64_t>(result, self, layout); break;
+    default: AT_ERROR("index(): unsupported element size %d", (int)self.type().elementSizeInBytes());
+  }
+  return result;
+}
+
+}} // namespace at::native
@@ -0,0 +1,217 @@
+#include "ATen/ATen.h"
+#include "ATen/TensorUtils.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/Error.h"
+
+#include "ATen/cuda/AccumulateType.cuh"
+#include "ATen/cuda/CUDATensorMethods.cuh"
+#include "ATen/cuda/CUDATypeConversion.cuh"
+
+#include <THC/THCDeviceUtils.cuh>
+#include <THC/THCGeneral.h>
+#include <THC/THCNumerics.cuh>
+
+#include <algorithm>
+
+
+namespace at { namespace native {
+
+namespace {
+
+static const int MAX_BLOCK_SIZE = 1024;
+
+// Merges two partial log-sum-exp states (max, sum of exp(x - max)).
+template <typename accscalar_t>
+__device__ __forceinline__ void lse_combine(accscalar_t& max_a, accscalar_t& sum_a,
+                                            accscalar_t max_b, accscalar_t sum_b) {
+  if (sum_b == 0) {
+    return;
+  }
+  if (sum_a == 0) {
+    max_a = max_b;
+    sum_a = sum_b;
+    return;
+  }
+  if (max_b > max_a) {
+    sum_a = sum_a * THCNumerics<accscalar_t>::exp(max_a - max_b) + sum_b;
+    max_a = max_b;
+  } else {
+    sum_a += sum_b * THCNumerics<accscalar_t>::exp(max_b - max_a);
+  }
+}
+
+// One block per row of the input. Each thread keeps an online max and
+// sum of exponentials over its strided part of the row, so the row is
+// read once; the block then merges the partial states in shared memory.
+// The loss is logsumexp - (1 - eps) * x[t] - eps / C * sum(x).
+template <typename scalar_t, typename accscalar_t>
+__global__ void cross_entropy_forward_kernel(
+    const scalar_t* input, const int64_t* target, scalar_t* losses,
+    accscalar_t* logsumexp, int64_t num_classes, accscalar_t label_smoothing,
+    int64_t ignore_index) {
+
+  // Some casting hacks since dynamic shared memory and templates don't work together:
+  extern __shared__ unsigned char smem[];
+  auto smax = reinterpret_cast<accscalar_t*>(smem);
+  auto ssum = smax + blockDim.x;
+  auto sinput = ssum + blockDim.x;
+
+  const scalar_t* row = input + blockIdx.x * num_classes;
+  int tid = threadIdx.x;
+
+  accscalar_t max_input = 0;
+  accscalar_t sum_exp = 0;
+  accscalar_t sum_input = 0;
+  for (int64_t j = tid; j < num_classes; j += blockDim.x) {
+    accscalar_t x = scalar_cast<accscalar_t>(row[j]);
+    lse_combine(max_input, sum_exp, x, accscalar_t(1));
+    sum_input += x;
+  }
+  smax[tid] = max_input;
+  ssum[tid] = sum_exp;
+  sinput[tid] = sum_input;
+  __syncthreads();
+
+  // blockDim.x is a power of two
+  for (int offset = blockDim.x / 2; offset > 0; offset >>= 1) {
+    if (tid < offset) {
+      lse_combine(smax[tid], ssum[tid], smax[tid + offset], ssum[tid + offset]);
+      sinput[tid] += sinput[tid + offset];
+    }
+    __syncthreads();
+  }
+
+  if (tid == 0) {
+    accscalar_t lse = smax[0] + THCNumerics<accscalar_t>::log(ssum[0]);
+    logsumexp[blockIdx.x] = lse;
+
+    int64_t t = target[blockIdx.x];
+    if (t == ignore_index) {
+      losses[blockIdx.x] = scalar_cast<scalar_t>(accscalar_t(0));
+    } else {
+      assert(t >= 0 && t < num_classes);
+      accscalar_t loss = lse
+          - (1 - label_smoothing) * scalar_cast<accscalar_t>(row[t])
+          - label_smoothing / num_classes * sinput[0];
+      losses[blockIdx.x] = scalar_cast<scalar_t>(loss);
+    }
+  }
+}
+
+// grad_input = grad[i] * (softmax(x) - q), where q is the smoothed
+// one-hot target. The grid's y dimension strides over rows.
+template <typename scalar_t, typename accscalar_t>
+__global__ void cross_entropy_backward_kernel(
+    scalar_t* grad_input, const scalar_t* input, const scalar_t* grad,
+    const int64_t* target, const accscalar_t* logsumexp, int64_t batch_size,
+    int64_t num_classes, accscalar_t label_smoothing, int64_t ignore_index) {
+
+  for (int64_t i = blockIdx.y; i < batch_size; i += gridDim.y) {
+    const scalar_t* row = input + i * num_classes;
+    scalar_t* grad_row = grad_input + i * num_classes;
+    int64_t t = target[i];
+    accscalar_t g = t == ignore_index ? accscalar_t(0) : scalar_cast<accscalar_t>(grad[i]);
+    accscalar_t lse = logsumexp[i];
+    accscalar_t smooth = label_smoothing / num_classes;
+
+    for (int64_t j = blockIdx.x * blockDim.x + threadIdx.x; j < num_classes;
+         j += gridDim.x * blockDim.x) {
+      accscalar_t q = j == t ? 1 - label_smoothing + smooth : smooth;
+      accscalar_t p = THCNumerics<accscalar_t>::exp(scalar_cast<accscalar_t>(row[j]) - lse);
+      grad_row[j] = scalar_cast<scalar_t>(g * (p - q));
+    }
+  }
+}
+
+int cross_entropy_block_size(int64_t num_classes) {
+  int block = 32;
+  while (block < MAX_BLOCK_SIZE && block < num_classes) {
+    block *= 2;
+  }
+  return block;
+}
+
+} // anonymous namespace
+
+std::tuple<Tensor, Tensor> _cross_entropy_forward_cuda(const Tensor& self_, const Tensor& target_,
+                                                       double label_smoothing, int64_t ignore_index) {
+  auto self_arg = TensorArg(self_, "self", 1);
+  auto target_arg = TensorArg(target_, "target", 2);
+  checkDim("cross_entropy_forward", self_arg, 2);
+  checkDim("cross_entropy_forward", target_arg, 1);
+  checkScalarType("cross_entropy_forward", target_arg, kLong);
+  checkSize("cross_entropy_forward", target_arg, 0, self_.size(0));
+  checkSameGPU("cross_entropy_forward", self_arg, target_arg);
+
+  auto self = self_.contiguous();
+  auto target = target_.contiguous();
+  int64_t batch_size = self.size(0);
+  int64_t num_classes = self.size(1);
+  auto losses = self.type().tensor({batch_size});
+  // Keep the log-sum-exp in the accumulation type: in half, its rounding
+  // error is large next to the probabilities recomputed from it
+  auto& acc_type = self.type().scalarType() == kHalf ? self.type().toScalarType(kFloat) : self.type();
+  auto logsumexp = acc_type.tensor({batch_size});
+  if (batch_size == 0) {
+    return std::make_tuple(losses, logsumexp);
+  }
+
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  int block = cross_entropy_block_size(num_classes);
+
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(self.type(), "cross_entropy_forward", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    cross_entropy_forward_kernel<<<batch_size, block, 3 * block * sizeof(accscalar_t), stream>>>(
+      self.data<cuda_scalar_t>(),
+      target.data<int64_t>(),
+      losses.data<cuda_scalar_t>(),
+      logsumexp.data<accscalar_t>(),
+      num_classes,
+      static_cast<accscalar_t>(label_smoothing),
+      ignore_index);
+  });
+  THCudaCheck(cudaGetLastError());
+
+  return std::make_tuple(losses, logsumexp);
+}
+
+Tensor _cross_entropy_backward_cuda(const Tensor& grad_output, const Tensor& self_, const Tensor& target_,
+                                    const Tensor& logsumexp_, double label_smoothing,
+                                    int64_t ignore_index) {
+  auto self = self_.contiguous();
+  auto target = target_.contiguous();
+  auto grad = grad_output.contiguous();
+  auto logsumexp = logsumexp_.contiguous();
+  int64_t batch_size = self.size(0);
+  int64_t num_classes = self.size(1);
+  auto grad_input = self.type().tensor(self.sizes());
+  if (grad_input.numel() == 0) {
+    return grad_input;
+  }
+
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  dim3 block(std::min<int64_t>(cross_entropy_block_size(num_classes), 256));
+  dim3 grid(std::min<int64_t>(THCCeilDiv(num_classes, (int64_t)block.x), 64),
+            std::min<int64_t>(batch_size, 65535));
+
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(self.type(), "cross_entropy_backward", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    cross_entropy_backward_kernel<<<grid, block, 0, stream>>>(
+      grad_input.data<cuda_scalar_t>(),
+      self.data<cuda_scalar_t>(),
+      grad.data<cuda_scalar_t>(),
+      target.data<int64_t>(),
+      logsumexp.data<accscalar_t>(),
+      batch_size,
+      num_classes,
+      static_cast<accscalar_t>(label_smoothing),
+      ignore_index);
+  });
+  THCudaCheck(cudaGetLastError());
+
+  return grad_input;
+}
+
+}} // namespace at::native
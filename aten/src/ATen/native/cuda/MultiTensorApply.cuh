@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ATen/ATen.h"
+#include "ATen/Error.h"
+
+#include <THC/THCGeneral.h>
+
+// Applies an elementwise op to several lists of tensors with few launches.
+// Each block of a launch handles a chunk of one tensor: the addresses of up
+// to max_tensors tensors of each list and the tensor and chunk of each block
+// are passed by value, in the kernel arguments (4KB at most), so a launch
+// updates chunks of up to max_blocks tensors without any host to device copy.
+//
+// Example, with two lists of float tensors:
+//
+//   struct AddOp {
+//     float alpha;
+//     __device__ void operator()(void* const* ptrs, int64_t i) const {
+//       static_cast<float*>(ptrs[0])[i] += alpha * static_cast<float*>(ptrs[1])[i];
+//     }
+//   };
+//   multi_tensor_apply<2>({self, other}, AddOp{alpha});
+
+namespace at { namespace native {
+
+namespace multi_tensor_apply_detail {
+
+constexpr int BLOCK_SIZE = 512;
+constexpr int64_t CHUNK_SIZE = 65536;
+constexpr int MAX_BLOCKS = 320;
+// Indexed by depth - 1, to keep TensorListMetadata under 4KB
+constexpr int MAX_TENSORS[5] = {110, 64, 48, 36, 30};
+
+} // namespace multi_tensor_apply_detail
+
+template <int depth>
+struct TensorListMetadata {
+  static constexpr int max_tensors = multi_tensor_apply_detail::MAX_TENSORS[depth - 1];
+  static constexpr int max_blocks = multi_tensor_apply_detail::MAX_BLOCKS;
+
+  void* addresses[depth][max_tensors];
+  int64_t sizes[max_tensors];
+  unsigned char block_to_tensor[max_blocks];
+  int block_to_chunk[max_blocks];
+};
+
+template <int depth, typename Op>
+__global__ void multi_tensor_apply_kernel(TensorListMetadata<depth> tl, int64_t chunk_size, Op op) {
+  int tensor = tl.block_to_tensor[blockIdx.x];
+  int64_t begin = tl.block_to_chunk[blockIdx.x] * chunk_size;
+  int64_t end = tl.sizes[tensor] < begin + chunk_size ? tl.sizes[tensor] : begin + chunk_size;
+  void* ptrs[depth];
+  #pragma unroll
+  for (int d = 0; d < depth; d++) {
+    ptrs[d] = tl.addresses[d][tensor];
+  }
+  for (int64_t i = begin + threadIdx.x; i < end; i += blockDim.x) {
+    op(ptrs, i);
+  }
+}
+
+// Calls op(ptrs, i) on the device for every element i of the tensors of the
+// lists, where ptrs holds the data of the tensors of each list at the same
+// position. The tensors at one position must be contiguous with the same
+// number of elements.
+template <int depth, typename Op>
+void multi_tensor_apply(ArrayRef<TensorList> lists, const Op& op,
+                        int64_t chunk_size = multi_tensor_apply_detail::CHUNK_SIZE) {
+  using Metadata = TensorListMetadata<depth>;
+  AT_ASSERT(lists.size() == depth, "multi_tensor_apply: expected %d lists, but got %d",
+            depth, (int)lists.size());
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  auto launch = [&](const Metadata& tl, int blocks) {
+    multi_tensor_apply_kernel<depth><<<blocks, multi_tensor_apply_detail::BLOCK_SIZE, 0, stream>>>(
+        tl, chunk_size, op);
+    THCudaCheck(cudaGetLastError());
+  };
+
+  Metadata tl;
+  int loaded_tensors = 0;
+  int loaded_blocks = 0;
+  for (size_t t = 0; t < lists[0].size(); t++) {
+    int64_t numel = lists[0][t].numel();
+    if (numel == 0) {
+      continue;
+    }
+    tl.sizes[loaded_tensors] = numel;
+    for (int d = 0; d < depth; d++) {
+      tl.addresses[d][loaded_tensors] = lists[d][t].data_ptr();
+    }
+    loaded_tensors++;
+
+    int64_t chunks = (numel + chunk_size - 1) / chunk_size;
+    for (int64_t chunk = 0; chunk < chunks; chunk++) {
+      tl.block_to_tensor[loaded_blocks] = loaded_tensors - 1;
+      tl.block_to_chunk[loaded_blocks] = chunk;
+      loaded_blocks++;
+      bool last_chunk = chunk == chunks - 1;
+      if (loaded_blocks == Metadata::max_blocks ||
+          (last_chunk && loaded_tensors == Metadata::max_tensors)) {
+        // The kernel arguments are copied at the launch, so tl can be refilled
+        launch(tl, loaded_blocks);
+        loaded_blocks = 0;
+        if (last_chunk) {
+          loaded_tensors = 0;
+        } else {
+          // The rest of the chunks of this tensor go to the next launch
+          tl.sizes[0] = tl.sizes[loaded_tensors - 1];
+          for (int d = 0; d < depth; d++) {
+            tl.addresses[d][0] = tl.addresses[d][loaded_tensors - 1];
+          }
+          loaded_tensors = 1;
+        }
+      }
+    }
+  }
+  if (loaded_blocks > 0) {
+    launch(tl, loaded_blocks);
+  }
+}
+
+}} // namespace at::native
@@ -0,0 +1,386 @@
+#include "ATen/ATen.h"
+#include "ATen/TensorUtils.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/Error.h"
+
+#include "ATen/cuda/AccumulateType.cuh"
+#include "ATen/cuda/CUDATensorMethods.cuh"
+#include "ATen/cuda/CUDATypeConversion.cuh"
+
+#include <THC/THCDeviceUtils.cuh>
+#include <THC/THCGeneral.h>
+#include <THC/THCNumerics.cuh>
+
+#include <algorithm>
+
+
+namespace at { namespace native {
+
+namespace {
+
+static const int MAX_ROW_THREADS = 512;
+static const int MIN_BLOCK_SIZE = 128;
+
+// The running mean, sum of squared deviations and count of part of a row
+template <typename accscalar_t>
+struct WelfordData {
+  accscalar_t mean;
+  accscalar_t m2;
+  accscalar_t n;
+};
+
+template <typename accscalar_t>
+struct WelfordCombine {
+  __device__ __forceinline__ WelfordData<accscalar_t> operator()(
+      const WelfordData<accscalar_t>& a, const WelfordData<accscalar_t>& b) const {
+    accscalar_t n = a.n + b.n;
+    if (n == 0) {
+      return a;
+    }
+    accscalar_t delta = b.mean - a.mean;
+    accscalar_t b_ratio = b.n / n;
+    return {a.mean + delta * b_ratio, a.m2 + b.m2 + delta * delta * a.n * b_ratio, n};
+  }
+};
+
+template <typename accscalar_t>
+__device__ __forceinline__ WelfordData<accscalar_t> shfl_down(
+    const WelfordData<accscalar_t>& w, unsigned int offset) {
+  return {WARP_SHFL_DOWN(w.mean, offset), WARP_SHFL_DOWN(w.m2, offset),
+          WARP_SHFL_DOWN(w.n, offset)};
+}
+
+// The sums of h and h * xhat over part of a row
+template <typename accscalar_t>
+struct SumPair {
+  accscalar_t first;
+  accscalar_t second;
+};
+
+template <typename accscalar_t>
+struct SumPairCombine {
+  __device__ __forceinline__ SumPair<accscalar_t> operator()(
+      const SumPair<accscalar_t>& a, const SumPair<accscalar_t>& b) const {
+    return {a.first + b.first, a.second + b.second};
+  }
+};
+
+template <typename accscalar_t>
+__device__ __forceinline__ SumPair<accscalar_t> shfl_down(
+    const SumPair<accscalar_t>& p, unsigned int offset) {
+  return {WARP_SHFL_DOWN(p.first, offset), WARP_SHFL_DOWN(p.second, offset)};
+}
+
+// Reduces val over the threads of the block with the same threadIdx.y (a
+// whole number of warps), returning the result to all of them. shared holds
+// blockDim.y * (blockDim.x / warpSize) values.
+template <typename T, typename Combine>
+__device__ T row_reduce(T val, Combine combine, T identity, T* shared) {
+  for (int offset = warpSize / 2; offset > 0; offset >>= 1) {
+    val = combine(val, shfl_down(val, offset));
+  }
+  const int lane = threadIdx.x % warpSize;
+  const int warp = threadIdx.x / warpSize;
+  const int num_warps = blockDim.x / warpSize;
+  T* row_shared = shared + threadIdx.y * num_warps;
+  if (lane == 0) {
+    row_shared[warp] = val;
+  }
+  __syncthreads();
+  if (warp == 0) {
+    val = lane < num_warps ? row_shared[lane] : identity;
+    for (int offset = warpSize / 2; offset > 0; offset >>= 1) {
+      val = combine(val, shfl_down(val, offset));
+    }
+    if (lane == 0) {
+      row_shared[0] = val;
+    }
+  }
+  __syncthreads();
+  val = row_shared[0];
+  // the next reduction may overwrite shared
+  __syncthreads();
+  return val;
+}
+
+// Each row of the input is normalized by blockDim.x threads (a warp for the
+// small rows, up to MAX_ROW_THREADS for the large ones), blockDim.y rows per
+// block. The threads compute the mean and variance of their part of the row
+// with Welford's algorithm, merge them, then normalize the row, so that it is
+// read twice instead of three times for separate mean, variance and
+// normalization kernels.
+template <typename scalar_t, typename accscalar_t>
+__global__ void layer_norm_forward_kernel(
+    int64_t M, int64_t N, accscalar_t eps, const scalar_t* input,
+    const scalar_t* gamma, const scalar_t* beta, scalar_t* output,
+    accscalar_t* mean, accscalar_t* rstd) {
+
+  // Some casting hacks since dynamic shared memory and templates don't work together:
+  extern __shared__ unsigned char smem[];
+  auto shared = reinterpret_cast<WelfordData<accscalar_t>*>(smem);
+
+  const int64_t i = static_cast<int64_t>(blockIdx.x) * blockDim.y + threadIdx.y;
+  // the threads past the last row still take part in the reduction
+  const bool valid_row = i < M;
+  const scalar_t* row = input + i * N;
+
+  WelfordData<accscalar_t> w = {0, 0, 0};
+  if (valid_row) {
+    for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+      accscalar_t x = scalar_cast<accscalar_t>(row[j]);
+      w.n += 1;
+      accscalar_t delta = x - w.mean;
+      w.mean += delta / w.n;
+      w.m2 += delta * (x - w.mean);
+    }
+  }
+  w = row_reduce(w, WelfordCombine<accscalar_t>(),
+                 WelfordData<accscalar_t>{0, 0, 0}, shared);
+  if (!valid_row) {
+    return;
+  }
+
+  accscalar_t row_rstd = 1 / THCNumerics<accscalar_t>::sqrt(w.m2 / N + eps);
+  if (threadIdx.x == 0) {
+    mean[i] = w.mean;
+    rstd[i] = row_rstd;
+  }
+  scalar_t* out_row = output + i * N;
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    accscalar_t y = (scalar_cast<accscalar_t>(row[j]) - w.mean) * row_rstd;
+    if (gamma) {
+      y *= scalar_cast<accscalar_t>(gamma[j]);
+    }
+    if (beta) {
+      y += scalar_cast<accscalar_t>(beta[j]);
+    }
+    out_row[j] = scalar_cast<scalar_t>(y);
+  }
+}
+
+// grad_input = rstd * (h - mean(h) - xhat * mean(h * xhat)), with
+// h = grad_output * gamma, the rows split between the threads like in the
+// forward kernel
+template <typename scalar_t, typename accscalar_t>
+__global__ void layer_norm_backward_input_kernel(
+    int64_t M, int64_t N, const scalar_t* grad_output, const scalar_t* input,
+    const accscalar_t* mean, const accscalar_t* rstd, const scalar_t* gamma,
+    scalar_t* grad_input) {
+
+  extern __shared__ unsigned char smem[];
+  auto shared = reinterpret_cast<SumPair<accscalar_t>*>(smem);
+
+  const int64_t i = static_cast<int64_t>(blockIdx.x) * blockDim.y + threadIdx.y;
+  const bool valid_row = i < M;
+  const scalar_t* row = input + i * N;
+  const scalar_t* grad_row = grad_output + i * N;
+  const accscalar_t row_mean = valid_row ? mean[i] : accscalar_t(0);
+  const accscalar_t row_rstd = valid_row ? rstd[i] : accscalar_t(0);
+
+  SumPair<accscalar_t> sums = {0, 0};
+  if (valid_row) {
+    for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+      accscalar_t h = scalar_cast<accscalar_t>(grad_row[j]);
+      if (gamma) {
+        h *= scalar_cast<accscalar_t>(gamma[j]);
+      }
+      accscalar_t xhat = (scalar_cast<accscalar_t>(row[j]) - row_mean) * row_rstd;
+      sums.first += h;
+      sums.second += h * xhat;
+    }
+  }
+  sums = row_reduce(sums, SumPairCombine<accscalar_t>(),
+                    SumPair<accscalar_t>{0, 0}, shared);
+  if (!valid_row) {
+    return;
+  }
+
+  const accscalar_t h_mean = sums.first / N;
+  const accscalar_t hxhat_mean = sums.second / N;
+  scalar_t* grad_input_row = grad_input + i * N;
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    accscalar_t h = scalar_cast<accscalar_t>(grad_row[j]);
+    if (gamma) {
+      h *= scalar_cast<accscalar_t>(gamma[j]);
+    }
+    accscalar_t xhat = (scalar_cast<accscalar_t>(row[j]) - row_mean) * row_rstd;
+    grad_input_row[j] = scalar_cast<scalar_t>(row_rstd * (h - h_mean - xhat * hxhat_mean));
+  }
+}
+
+static const int GAMMA_BETA_COLUMNS = 32;
+static const int GAMMA_BETA_ROW_THREADS = 16;
+
+// grad_gamma = sum(grad_output * xhat) and grad_beta = sum(grad_output) over
+// the rows. The threads of a warp read consecutive columns, the threadIdx.y
+// stride over the rows, and the block adds up their partial sums.
+template <typename scalar_t, typename accscalar_t>
+__global__ void layer_norm_backward_gamma_beta_kernel(
+    int64_t M, int64_t N, const scalar_t* grad_output, const scalar_t* input,
+    const accscalar_t* mean, const accscalar_t* rstd, scalar_t* grad_gamma,
+    scalar_t* grad_beta) {
+
+  __shared__ accscalar_t gamma_sums[GAMMA_BETA_ROW_THREADS][GAMMA_BETA_COLUMNS];
+  __shared__ accscalar_t beta_sums[GAMMA_BETA_ROW_THREADS][GAMMA_BETA_COLUMNS];
+
+  const int64_t j = static_cast<int64_t>(blockIdx.x) * GAMMA_BETA_COLUMNS + threadIdx.x;
+  accscalar_t gamma_sum = 0;
+  accscalar_t beta_sum = 0;
+  if (j < N) {
+    for (int64_t i = threadIdx.y; i < M; i += GAMMA_BETA_ROW_THREADS) {
+      accscalar_t g = scalar_cast<accscalar_t>(grad_output[i * N + j]);
+      accscalar_t xhat = (scalar_cast<accscalar_t>(input[i * N + j]) - mean[i]) * rstd[i];
+      gamma_sum += g * xhat;
+      beta_sum += g;
+    }
+  }
+  gamma_sums[threadIdx.y][threadIdx.x] = gamma_sum;
+  beta_sums[threadIdx.y][threadIdx.x] = beta_sum;
+  __syncthreads();
+
+  for (int offset = GAMMA_BETA_ROW_THREADS / 2; offset > 0; offset >>= 1) {
+    if (threadIdx.y < offset) {
+      gamma_sums[threadIdx.y][threadIdx.x] += gamma_sums[threadIdx.y + offset][threadIdx.x];
+      beta_sums[threadIdx.y][threadIdx.x] += beta_sums[threadIdx.y + offset][threadIdx.x];
+    }
+    __syncthreads();
+  }
+
+  if (threadIdx.y == 0 && j < N) {
+    if (grad_gamma) {
+      grad_gamma[j] = scalar_cast<scalar_t>(gamma_sums[0][threadIdx.x]);
+    }
+    if (grad_beta) {
+      grad_beta[j] = scalar_cast<scalar_t>(beta_sums[0][threadIdx.x]);
+    }
+  }
+}
+
+// A warp per row for rows of up to 32 elements, more threads for the larger
+// rows, and rows grouped so that blocks have at least MIN_BLOCK_SIZE threads
+dim3 layer_norm_block(int64_t N) {
+  int row_threads = 32;
+  while (row_threads < MAX_ROW_THREADS && row_threads < N) {
+    row_threads *= 2;
+  }
+  return dim3(row_threads, std::max(MIN_BLOCK_SIZE / row_threads, 1));
+}
+
+} // anonymous namespace
+
+std::tuple<Tensor, Tensor, Tensor> _layer_norm_forward_cuda(
+    const Tensor& input_, const Tensor& weight_, const Tensor& bias_,
+    int64_t M, int64_t N, double eps) {
+  CheckedFrom c = "_layer_norm_forward";
+  auto input_arg = TensorArg(input_, "input", 1);
+  checkNumel(c, input_arg, M * N);
+  Tensor weight, bias;
+  if (weight_.defined()) {
+    auto weight_arg = TensorArg(weight_, "weight", 2);
+    checkNumel(c, weight_arg, N);
+    checkSameType(c, input_arg, weight_arg);
+    checkSameGPU(c, input_arg, weight_arg);
+    weight = weight_.contiguous();
+  }
+  if (bias_.defined()) {
+    auto bias_arg = TensorArg(bias_, "bias", 3);
+    checkNumel(c, bias_arg, N);
+    checkSameType(c, input_arg, bias_arg);
+    checkSameGPU(c, input_arg, bias_arg);
+    bias = bias_.contiguous();
+  }
+
+  auto input = input_.contiguous();
+  auto output = input.type().tensor(input.sizes());
+  // The statistics are kept in the accumulation type, which the backward
+  // reads them in
+  auto& acc_type = input.type().scalarType() == kHalf ? input.type().toScalarType(kFloat) : input.type();
+  auto mean = acc_type.tensor({M});
+  auto rstd = acc_type.tensor({M});
+  if (M == 0) {
+    return std::make_tuple(output, mean, rstd);
+  }
+
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  dim3 block = layer_norm_block(N);
+  dim3 grid(THCCeilDiv(M, static_cast<int64_t>(block.y)));
+
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.type(), "layer_norm_forward", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    size_t smem = block.y * (block.x / 32) * sizeof(WelfordData<accscalar_t>);
+    layer_norm_forward_kernel<<<grid, block, smem, stream>>>(
+      M, N, static_cast<accscalar_t>(eps),
+      input.data<cuda_scalar_t>(),
+      weight.defined() ? weight.data<cuda_scalar_t>() : nullptr,
+      bias.defined() ? bias.data<cuda_scalar_t>() : nullptr,
+      output.data<cuda_scalar_t>(),
+      mean.data<accscalar_t>(),
+      rstd.data<accscalar_t>());
+  });
+  THCudaCheck(cudaGetLastError());
+
+  return std::make_tuple(output, mean, rstd);
+}
+
+std::tuple<Tensor, Tensor, Tensor> _layer_norm_backward_cuda(
+    const Tensor& grad_output_, const Tensor& input_, const Tensor& mean_,
+    const Tensor& rstd_, const Tensor& weight_, int64_t M, int64_t N,
+    std::array<bool,3> output_mask) {
+  auto grad_output = grad_output_.contiguous();
+  auto input = input_.contiguous();
+  auto mean = mean_.contiguous();
+  auto rstd = rstd_.contiguous();
+  auto weight = weight_.defined() ? weight_.contiguous() : weight_;
+
+  // the sums over no rows are zeros
+  Tensor grad_input, grad_weight, grad_bias;
+  if (output_mask[0]) {
+    grad_input = input.type().tensor(input.sizes());
+  }
+  if (output_mask[1] && weight.defined()) {
+    grad_weight = input.type().zeros({N});
+  }
+  if (output_mask[2]) {
+    grad_bias = input.type().zeros({N});
+  }
+  if (M == 0) {
+    return std::make_tuple(grad_input, grad_weight, grad_bias);
+  }
+
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.type(), "layer_norm_backward", [&] {
+    using cuda_scalar_t = cuda::type<scalar_t>;
+    using accscalar_t = cuda::acc_type<cuda_scalar_t>;
+    if (grad_input.defined()) {
+      dim3 block = layer_norm_block(N);
+      dim3 grid(THCCeilDiv(M, static_cast<int64_t>(block.y)));
+      size_t smem = block.y * (block.x / 32) * sizeof(SumPair<accscalar_t>);
+      layer_norm_backward_input_kernel<<<grid, block, smem, stream>>>(
+        M, N,
+        grad_output.data<cuda_scalar_t>(),
+        input.data<cuda_scalar_t>(),
+        mean.data<accscalar_t>(),
+        rstd.data<accscalar_t>(),
+        weight.defined() ? weight.data<cuda_scalar_t>() : nullptr,
+        grad_input.data<cuda_scalar_t>());
+    }
+    if (grad_weight.defined() || grad_bias.defined()) {
+      dim3 block(GAMMA_BETA_COLUMNS, GAMMA_BETA_ROW_THREADS);
+      dim3 grid(THCCeilDiv(N, static_cast<int64_t>(GAMMA_BETA_COLUMNS)));
+      layer_norm_backward_gamma_beta_kernel<<<grid, block, 0, stream>>>(
+        M, N,
+        grad_output.data<cuda_scalar_t>(),
+        input.data<cuda_scalar_t>(),
+        mean.data<accscalar_t>(),
+        rstd.data<accscalar_t>(),
+        grad_weight.defined() ? grad_weight.data<cuda_scalar_t>() : nullptr,
+        grad_bias.defined() ? grad_bias.data<cuda_scalar_t>() : nullptr);
+    }
+  });
+  THCudaCheck(cudaGetLastError());
+
+  return std::make_tuple(grad_input, grad_weight, grad_bias);
+}
+
+}} // namespace at::native
@@ -135,6 +135,28 @@ static void _fft_fill_with_conjugate_symmetry_(Tensor& input,
   });
 }
 
+// Everything cufftXtMakePlanMany is called with, and the device and stream
+// the plan runs on. A plan has its own work area, so plans are only reused
+// on the stream they ran on, after the previous transform. The direction
+// isn't part of the plan: it is given to cufftXtExec.
+struct CufftPlanKey {
+  int device;
+  cudaStream_t stream;
+  int signal_ndim;
+  long long int signal_sizes[3];
+  long long int inembed[3];
+  long long int onembed[3];
+  long long int base_istride, idist;
+  long long int base_ostride, odist;
+  long long int batch;
+  cudaDataType itype, otype, exec_type;
+};
+
+static FFTPlanCache<CufftPlanKey, CufftHandle>& cufft_plan_cache() {
+  static FFTPlanCache<CufftPlanKey, CufftHandle> cache;
+  return cache;
+}
+
 // cuFFT
 // Currently not utilizing multi GPUs so this potentially speed up.
 Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
@@ -254,8 +276,6 @@ Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
   std::vector<long long int> onembed(output_sizes.data() + 1, output_sizes.data() + signal_ndim + 1);
   long long int base_ostride = 1;
 
-  CufftHandle plan;
-  size_t ws = 0;
   cudaDataType itype, otype, exec_type;
   if (input.type().scalarType() == ScalarType::Float) {
     itype = complex_input ? CUDA_C_32F : CUDA_R_32F;
@@ -276,17 +296,40 @@ Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
     throw std::runtime_error(ss.str());
   }
 
-  // make plan
-  CUFFT_CHECK(cufftXtMakePlanMany(plan.get(), signal_ndim, signal_sizes.data(),
-    inembed.data(), base_istride, idist, itype, onembed.data(), base_ostride,
-    odist, otype, batch, &ws, exec_type));
-
-  // set to current stream
-  CUFFT_CHECK(cufftSetStream(plan.get(), at::globalContext().getCurrentCUDAStream()));
+  CufftPlanKey key;
+  memset(&key, 0, sizeof(key));
+  THCudaCheck(cudaGetDevice(&key.device));
+  key.stream = at::globalContext().getCurrentCUDAStream();
+  key.signal_ndim = signal_ndim;
+  std::copy(signal_sizes.begin(), signal_sizes.end(), key.signal_sizes);
+  std::copy(inembed.begin(), inembed.end(), key.inembed);
+  std::copy(onembed.begin(), onembed.end(), key.onembed);
+  key.base_istride = base_istride;
+  key.idist = idist;
+  key.base_ostride = base_ostride;
+  key.odist = odist;
+  key.batch = batch;
+  key.itype = itype;
+  key.otype = otype;
+  key.exec_type = exec_type;
+
+  auto plan = cufft_plan_cache().take(key);
+  if (!plan) {
+    // make plan
+    plan.reset(new CufftHandle());
+    size_t ws = 0;
+    CUFFT_CHECK(cufftXtMakePlanMany(plan->get(), signal_ndim, signal_sizes.data(),
+      inembed.data(), base_istride, idist, itype, onembed.data(), base_ostride,
+      odist, otype, batch, &ws, exec_type));
+
+    // set to current stream
+    CUFFT_CHECK(cufftSetStream(plan->get(), key.stream));
+  }
 
   // run
-  CUFFT_CHECK(cufftXtExec(plan.get(), input.data_ptr(), output.data_ptr(),
+  CUFFT_CHECK(cufftXtExec(plan->get(), input.data_ptr(), output.data_ptr(),
     inverse ? CUFFT_INVERSE : CUFFT_FORWARD));
+  cufft_plan_cache().put(key, std::move(plan));
 
   // rescale if needed by normalized flag or inverse transform
   auto size_last_signal_dim = checked_signal_sizes[signal_ndim - 1];
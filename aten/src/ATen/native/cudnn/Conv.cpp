@@ -76,9 +76,11 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 #include "THC/THC.h"
 
 #include <ATen/cudnn/cudnn-wrapper.h>
+#include <ATen/cudnn/BenchmarkCache.h>
 #include <ATen/cudnn/Descriptors.h>
 #include <ATen/cudnn/Types.h>
 #include <ATen/cudnn/Utils.h>
+#include <ATen/cudnn/Workspace.h>
 
 #include <ATen/TensorUtils.h>
 
@@ -86,10 +88,16 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 #include <iterator>
 #include <sstream>
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <memory>
 #include <mutex>
 #include <stdint.h>
+#include <string>
 #include <unordered_map>
+#include <vector>
+#include <unistd.h>
 
 namespace at { namespace native {
 
@@ -260,6 +268,8 @@ struct ConvolutionParams
   int dilation[max_dim];
   int64_t groups;
   bool deterministic;
+  // THCState_getTensorOpFloatMath, which changes the fastest algorithms
+  bool allow_tensor_op_float;
   // NB: transposed purposely omitted: transposed just swaps
   // forward and backward, so you can reuse the benchmark entry,
 };
@@ -298,6 +308,8 @@ void setConvolutionParams(
   // CuDNN, but it doesn't seem worth the effort to actually do this.
   params->groups = groups;
   params->deterministic = deterministic;
+  params->allow_tensor_op_float =
+      THCState_getTensorOpFloatMath(globalContext().lazyInitCUDA());
 }
 
 // Convenience struct for passing around descriptors and data
@@ -361,30 +373,86 @@ struct BenchmarkCache {
     std::lock_guard<std::mutex> guard(mutex);
     map[params] = results;
   }
+
+  std::vector<std::pair<ConvolutionParams, T>> entries() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return std::vector<std::pair<ConvolutionParams, T>>(map.begin(), map.end());
+  }
 };
 
 BenchmarkCache<cudnnConvolutionFwdAlgo_t> fwd_algos;
 BenchmarkCache<cudnnConvolutionBwdDataAlgo_t> bwd_data_algos;
 BenchmarkCache<cudnnConvolutionBwdFilterAlgo_t> bwd_filter_algos;
 
-// TODO: Stop manually allocating CUDA memory; allocate an ATen byte
-// tensor instead.
-struct Workspace {
-  Workspace(size_t size) : size(size), data(NULL) {
-    CUDA_CHECK(THCudaMalloc(globalContext().lazyInitCUDA(), &data, size));
+// A benchmark cache file is made of lines of text:
+//
+//   cudnn_benchmark_cache 1
+//   cudnn_version <CUDNN_VERSION>
+//   device <name of the GPU>
+//   params_size <sizeof(ConvolutionParams)>
+//   <fwd|bwd_data|bwd_filter> <algorithm> <ConvolutionParams in hex>
+//
+// The entries are only valid for the GPU model and cuDNN version they were
+// benchmarked with.  The parameters are the bytes which are hashed to look
+// the algorithm up, so the layout of ConvolutionParams is part of the
+// format, which params_size partially checks.
+constexpr int benchmark_cache_format_version = 1;
+
+std::string current_device_name() {
+  int device;
+  CUDA_CHECK(cudaGetDevice(&device));
+  cudaDeviceProp prop;
+  CUDA_CHECK(cudaGetDeviceProperties(&prop, device));
+  return prop.name;
+}
+
+std::string params_to_hex(const ConvolutionParams& params) {
+  static const char digits[] = "0123456789abcdef";
+  auto ptr = reinterpret_cast<const uint8_t*>(&params);
+  std::string hex;
+  hex.reserve(2 * sizeof(ConvolutionParams));
+  for (size_t i = 0; i < sizeof(ConvolutionParams); ++i) {
+    hex += digits[ptr[i] >> 4];
+    hex += digits[ptr[i] & 0xf];
+  }
+  return hex;
+}
+
+bool params_from_hex(const std::string& hex, ConvolutionParams* params) {
+  if (hex.size() != 2 * sizeof(ConvolutionParams)) {
+    return false;
   }
-  Workspace(const Workspace&) = delete;
-  Workspace(Workspace&&) = default;
-  Workspace& operator=(Workspace&&) = default;
-  ~Workspace() {
-    if (data) {
-      THCudaFree(globalContext().lazyInitCUDA(), data);
+  auto digit = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  };
+  auto ptr = reinterpret_cast<uint8_t*>(params);
+  for (size_t i = 0; i < sizeof(ConvolutionParams); ++i) {
+    int hi = digit(hex[2 * i]), lo = digit(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0) {
+      return false;
     }
+    ptr[i] = (uint8_t)(hi << 4 | lo);
+  }
+  return true;
+}
+
+template<typename algo_t>
+void write_entries(std::ostream& out, const char* kind, BenchmarkCache<algo_t>& cache) {
+  for (auto& entry : cache.entries()) {
+    out << kind << " " << (int)entry.second << " " << params_to_hex(entry.first) << "\n";
   }
+}
 
-  size_t size;
-  void* data;
-};
+template<typename algo_t>
+bool insert_entry(BenchmarkCache<algo_t>& cache, int algo, int num_algos, const ConvolutionParams& params) {
+  if (algo < 0 || algo >= num_algos) {
+    return false;
+  }
+  cache.insert(params, (algo_t)algo);
+  return true;
+}
 
 template<typename algo_t>
 struct algorithm_search {
@@ -444,6 +512,7 @@ size_t getMaxWorkspaceSize(
     size_t free_gpu_mem = 0;
 
     THCudaCheck(THCudaMemGetInfoCached(state, &free_gpu_mem, &total_gpu_mem, &max_block_size));
+    max_block_size = std::min(max_block_size, getCudnnWorkspaceLimit());
 
     for (int i = 0; i < n_algo; i++) {
         cudnnStatus_t err;
@@ -499,7 +568,7 @@ struct algorithm_search<cudnnConvolutionFwdAlgo_t> {
     int perf_count;
     std::unique_ptr<perf_t[]> perf_results(new perf_t[num_algos]);
     size_t max_ws_size = getMaxWorkspaceSize(args, algos, num_algos);
-    Workspace ws(max_ws_size);
+    CudnnWorkspace ws(max_ws_size);
     CUDNN_CHECK(cudnnFindConvolutionForwardAlgorithmEx(
         args.handle,
         args.idesc.desc(), args.input.data_ptr(),
@@ -518,7 +587,10 @@ struct algorithm_search<cudnnConvolutionFwdAlgo_t> {
     const ConvolutionArgs& args,
     algo_t* algo)
   {
-    cudnnConvolutionFwdPreference_t pref = CUDNN_CONVOLUTION_FWD_PREFER_FASTEST;
+    size_t limit = getCudnnWorkspaceLimit();
+    cudnnConvolutionFwdPreference_t pref = limit == SIZE_MAX
+        ? CUDNN_CONVOLUTION_FWD_PREFER_FASTEST
+        : CUDNN_CONVOLUTION_FWD_SPECIFY_WORKSPACE_LIMIT;
     CUDNN_CHECK(cudnnGetConvolutionForwardAlgorithm(
         args.handle,
         args.idesc.desc(),
@@ -526,7 +598,7 @@ struct algorithm_search<cudnnConvolutionFwdAlgo_t> {
         args.cdesc.desc(),
         args.odesc.desc(),
         pref,
-        0,
+        limit == SIZE_MAX ? 0 : limit,
         algo));
   }
 
@@ -568,7 +640,7 @@ struct algorithm_search<cudnnConvolutionBwdDataAlgo_t> {
     int perf_count;
     std::unique_ptr<perf_t[]> perf_results(new perf_t[num_algos]);
     size_t max_ws_size = getMaxWorkspaceSize(args, algos, num_algos);
-    Workspace ws(max_ws_size);
+    CudnnWorkspace ws(max_ws_size);
     CUDNN_CHECK(cudnnFindConvolutionBackwardDataAlgorithmEx(
         args.handle,
         args.wdesc.desc(), args.weight.data_ptr(),
@@ -584,14 +656,16 @@ struct algorithm_search<cudnnConvolutionBwdDataAlgo_t> {
   }
 
   static void getAlgorithm(const ConvolutionArgs& args, algo_t* algo) {
+    size_t limit = getCudnnWorkspaceLimit();
     CUDNN_CHECK(cudnnGetConvolutionBackwardDataAlgorithm(
         args.handle,
         args.wdesc.desc(),
         args.odesc.desc(),
         args.cdesc.desc(),
         args.idesc.desc(),
-        CUDNN_CONVOLUTION_BWD_DATA_PREFER_FASTEST,
-        0,
+        limit == SIZE_MAX ? CUDNN_CONVOLUTION_BWD_DATA_PREFER_FASTEST
+                          : CUDNN_CONVOLUTION_BWD_DATA_SPECIFY_WORKSPACE_LIMIT,
+        limit == SIZE_MAX ? 0 : limit,
         algo));
   }
 
@@ -637,7 +711,7 @@ struct algorithm_search<cudnnConvolutionBwdFilterAlgo_t> {
     std::unique_ptr<perf_t[]> perf_results(new perf_t[num_algos]);
     size_t max_ws_size = getMaxWorkspaceSize(args, algos, num_algos);
     int perf_count;
-    Workspace ws(max_ws_size);
+    CudnnWorkspace ws(max_ws_size);
 
     CUDNN_CHECK(cudnnFindConvolutionBackwardFilterAlgorithmEx(
         args.handle,
@@ -654,14 +728,16 @@ struct algorithm_search<cudnnConvolutionBwdFilterAlgo_t> {
   }
 
   static void getAlgorithm(const ConvolutionArgs& args, algo_t* algo) {
+    size_t limit = getCudnnWorkspaceLimit();
     CUDNN_CHECK(cudnnGetConvolutionBackwardFilterAlgorithm(
         args.handle,
         args.idesc.desc(),
         args.odesc.desc(),
         args.cdesc.desc(),
         args.wdesc.desc(),
-        CUDNN_CONVOLUTION_BWD_FILTER_PREFER_FASTEST,
-        0,
+        limit == SIZE_MAX ? CUDNN_CONVOLUTION_BWD_FILTER_PREFER_FASTEST
+                          : CUDNN_CONVOLUTION_BWD_FILTER_SPECIFY_WORKSPACE_LIMIT,
+        limit == SIZE_MAX ? 0 : limit,
         algo)
     );
   }
@@ -719,7 +795,7 @@ void findAlgorithm(const ConvolutionArgs& args, bool benchmark, algo_t* algo) {
 }
 
 template<typename algo_t>
-Workspace chooseAlgorithm(
+CudnnWorkspace chooseAlgorithm(
     const ConvolutionArgs& args,
     bool benchmark,
     algo_t* algo)
@@ -729,8 +805,13 @@ Workspace chooseAlgorithm(
   using search = algorithm_search<algo_t>;
   size_t workspace_size;
   search::getWorkspaceSize(args, *algo, &workspace_size);
+  // an algorithm cached before the workspace limit was lowered
+  if (workspace_size > getCudnnWorkspaceLimit() && *algo != search::DEFAULT_ALGO) {
+    *algo = search::DEFAULT_ALGO;
+    search::getWorkspaceSize(args, *algo, &workspace_size);
+  }
   try {
-    return Workspace(workspace_size);
+    return CudnnWorkspace(workspace_size);
   } catch (std::runtime_error& e) {
     cudaGetLastError(); // clear OOM error
 
@@ -740,7 +821,7 @@ Workspace chooseAlgorithm(
     search::cache().insert(args.params, *algo);
 
     search::getWorkspaceSize(args, *algo, &workspace_size);
-    return Workspace(workspace_size);
+    return CudnnWorkspace(workspace_size);
   }
 }
 
@@ -826,15 +907,14 @@ void raw_cudnn_convolution_forward_out(
   args.idesc.set(input);
   args.wdesc.set(weight);
   args.odesc.set(output);
-  args.cdesc.set(dataType, input.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups);
+  args.cdesc.set(dataType, input.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups,
+                 args.params.allow_tensor_op_float);
 
-  // TODO: when we do legacy group convolution support, we'll repeatedly
-  // reinitialize the workspace for each convolution we do.  This is
-  // wasteful; we'd rather reuse the workspace.  OTOH, legacy group
-  // convolution support is already pretty slow, so this might not
-  // matter.  (This applies to raw_cudnn_convolution_backward_input as well.)
+  // The workspace is borrowed from the buffer of the current stream, which
+  // every cuDNN call on it reuses.  (This applies to
+  // raw_cudnn_convolution_backward_input as well.)
   cudnnConvolutionFwdAlgo_t fwdAlg;
-  Workspace workspace = chooseAlgorithm(args, benchmark, &fwdAlg);
+  CudnnWorkspace workspace = chooseAlgorithm(args, benchmark, &fwdAlg);
 
   Constant one(dataType, 1);
   Constant zero(dataType, 0);
@@ -959,10 +1039,11 @@ void raw_cudnn_convolution_backward_input_out(
   args.idesc.set(grad_input);
   args.wdesc.set(weight);
   args.odesc.set(grad_output);
-  args.cdesc.set(dataType, grad_output.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups);
+  args.cdesc.set(dataType, grad_output.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups,
+                 args.params.allow_tensor_op_float);
 
   cudnnConvolutionBwdDataAlgo_t bwdDataAlg;
-  Workspace workspace = chooseAlgorithm(args, benchmark, &bwdDataAlg);
+  CudnnWorkspace workspace = chooseAlgorithm(args, benchmark, &bwdDataAlg);
 
   Constant one(dataType, 1);
   Constant zero(dataType, 0);
@@ -1103,10 +1184,11 @@ void raw_cudnn_convolution_backward_weight_out(
   args.idesc.set(input);
   args.wdesc.set(grad_weight);
   args.odesc.set(grad_output);
-  args.cdesc.set(dataType, input.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups);
+  args.cdesc.set(dataType, input.dim() - 2, args.params.padding, args.params.stride, args.params.dilation, args.params.groups,
+                 args.params.allow_tensor_op_float);
 
   cudnnConvolutionBwdFilterAlgo_t bwdFilterAlg;
-  Workspace workspace = chooseAlgorithm(args, benchmark, &bwdFilterAlg);
+  CudnnWorkspace workspace = chooseAlgorithm(args, benchmark, &bwdFilterAlg);
 
   Constant one(dataType, 1);
   Constant zero(dataType, 0);
@@ -1219,6 +1301,95 @@ Tensor cudnn_convolution_backward_bias(
 }
 
 
+// ---------------------------------------------------------------------
+//
+// Benchmark cache export and import
+//
+// ---------------------------------------------------------------------
+
+void cudnn_save_benchmark_cache(const std::string& path) {
+  // written next to the file and renamed, so that processes loading it
+  // concurrently never see a partial file
+  std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream out(tmp_path);
+    if (!out) {
+      throw std::runtime_error("cudnn_save_benchmark_cache: cannot open " + tmp_path);
+    }
+    out << "cudnn_benchmark_cache " << benchmark_cache_format_version << "\n";
+    out << "cudnn_version " << CUDNN_VERSION << "\n";
+    out << "device " << current_device_name() << "\n";
+    out << "params_size " << sizeof(ConvolutionParams) << "\n";
+    write_entries(out, "fwd", fwd_algos);
+    write_entries(out, "bwd_data", bwd_data_algos);
+    write_entries(out, "bwd_filter", bwd_filter_algos);
+    out.close();
+    if (!out) {
+      std::remove(tmp_path.c_str());
+      throw std::runtime_error("cudnn_save_benchmark_cache: cannot write " + tmp_path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    throw std::runtime_error("cudnn_save_benchmark_cache: cannot rename " + tmp_path +
+                             " to " + path);
+  }
+}
+
+int64_t cudnn_load_benchmark_cache(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("cudnn_load_benchmark_cache: cannot open " + path);
+  }
+  std::string line;
+  auto read_field = [&](const char* name) {
+    if (!std::getline(in, line) || line.compare(0, strlen(name) + 1, std::string(name) + " ") != 0) {
+      throw std::runtime_error("cudnn_load_benchmark_cache: " + path +
+                               " is not a benchmark cache (expected " + name + ")");
+    }
+    return line.substr(strlen(name) + 1);
+  };
+  if (read_field("cudnn_benchmark_cache") != std::to_string(benchmark_cache_format_version)) {
+    throw std::runtime_error("cudnn_load_benchmark_cache: unsupported version of " + path);
+  }
+  // entries benchmarked with another library or GPU aren't an error: they
+  // are skipped like a cold cache
+  if (read_field("cudnn_version") != std::to_string(CUDNN_VERSION) ||
+      read_field("device") != current_device_name() ||
+      read_field("params_size") != std::to_string(sizeof(ConvolutionParams))) {
+    return 0;
+  }
+
+  int64_t count = 0;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream fields(line);
+    std::string kind, hex;
+    int algo;
+    ConvolutionParams params;
+    if (!(fields >> kind >> algo >> hex) || !params_from_hex(hex, &params)) {
+      throw std::runtime_error("cudnn_load_benchmark_cache: invalid entry in " + path + ": " + line);
+    }
+    bool valid;
+    if (kind == "fwd") {
+      valid = insert_entry(fwd_algos, algo, CUDNN_CONVOLUTION_FWD_ALGO_COUNT, params);
+    } else if (kind == "bwd_data") {
+      valid = insert_entry(bwd_data_algos, algo, CUDNN_CONVOLUTION_BWD_DATA_ALGO_COUNT, params);
+    } else if (kind == "bwd_filter") {
+      valid = insert_entry(bwd_filter_algos, algo, CUDNN_CONVOLUTION_BWD_FILTER_ALGO_COUNT, params);
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      throw std::runtime_error("cudnn_load_benchmark_cache: invalid entry in " + path + ": " + line);
+    }
+    count++;
+  }
+  return count;
+}
+
 }}  // namespace
 
 #endif
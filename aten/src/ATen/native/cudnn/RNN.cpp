@@ -55,8 +55,18 @@ Tensor _cudnn_init_dropout_state(const Type& ty, double dropout, bool train, int
 
 #include <ATen/cudnn/cudnn-wrapper.h>
 #include <ATen/cudnn/Descriptors.h>
+#include <ATen/cudnn/RNNAlgo.h>
 #include <ATen/cudnn/Types.h>
 #include <ATen/cudnn/Utils.h>
+#include <ATen/cudnn/Workspace.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
 
 namespace at { namespace native {
 
@@ -95,6 +105,7 @@ namespace {
     cudnnDataType_t datatype;
 
     cudnnRNNInputMode_t input_mode = CUDNN_LINEAR_INPUT;
+    cudnnRNNAlgo_t algo = CUDNN_RNN_ALGO_STANDARD;
 
     int64_t num_directions() const {
       return bidirectional ? 2 : 1;
@@ -138,7 +149,7 @@ namespace {
 
     RNNDescriptor descriptor(cudnnHandle_t handle, DropoutDescriptor&& dropout_desc) const {
       RNNDescriptor rnn_desc;
-      rnn_desc.set(handle, hidden_size, num_layers, std::move(dropout_desc), input_mode, bidirectional, mode, datatype);
+      rnn_desc.set(handle, hidden_size, num_layers, std::move(dropout_desc), input_mode, bidirectional, mode, datatype, algo);
       return rnn_desc;
     }
 
@@ -157,10 +168,105 @@ namespace {
     }
   };
 
+  // Descriptor caches
+  //
+  // Setting up the descriptors costs more than running a small RNN, so the
+  // RNN descriptors (with their dropout descriptor) and the tensor
+  // descriptors are kept, and shared by all the calls with the same
+  // parameters.  Descriptors are only read by the cuDNN calls, so they can
+  // be used from several threads at once.  The caches are simply emptied
+  // when they grow past kMaxCachedDescriptors; the descriptors still in use
+  // are kept alive by their shared_ptr.
+
+  constexpr size_t kMaxCachedDescriptors = 1024;
+
+  // POD keys, hashed and compared byte by byte, so they should be memset
+  // to zero before being filled in.
+  template <typename Key>
+  struct DescriptorKeyHash {
+    size_t operator()(const Key& key) const {
+      auto ptr = reinterpret_cast<const uint8_t*>(&key);
+      uint32_t value = 0x811C9DC5;
+      for (size_t i = 0; i < sizeof(Key); ++i) {
+        value ^= ptr[i];
+        value *= 0x01000193;
+      }
+      return (size_t)value;
+    }
+  };
+
+  template <typename Key>
+  struct DescriptorKeyEqual {
+    bool operator()(const Key& a, const Key& b) const {
+      return memcmp(&a, &b, sizeof(Key)) == 0;
+    }
+  };
+
+  template <typename Key, typename Desc>
+  struct DescriptorCache {
+    std::mutex mutex;
+    std::unordered_map<Key, std::shared_ptr<const Desc>,
+                       DescriptorKeyHash<Key>, DescriptorKeyEqual<Key>> map;
+
+    template <typename Make>
+    std::shared_ptr<const Desc> get(const Key& key, Make make) {
+      static_assert(std::is_pod<Key>::value, "descriptor keys should be POD");
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = map.find(key);
+        if (it != map.end()) {
+          return it->second;
+        }
+      }
+      std::shared_ptr<const Desc> desc = make();
+      std::lock_guard<std::mutex> guard(mutex);
+      if (map.size() >= kMaxCachedDescriptors) {
+        map.clear();
+      }
+      return map.emplace(key, desc).first->second;
+    }
+  };
+
+  struct TensorDescriptorKey {
+    cudnnDataType_t datatype;
+    int64_t dim;
+    int64_t sizes[5];
+    int64_t strides[5];
+    int64_t pad;
+  };
+
+  DescriptorCache<TensorDescriptorKey, TensorDescriptor>& tensor_descriptor_cache() {
+    static DescriptorCache<TensorDescriptorKey, TensorDescriptor> cache;
+    return cache;
+  }
+
+  std::shared_ptr<const TensorDescriptor> cached_tensor_descriptor(
+      cudnnDataType_t datatype, IntList sizes, IntList strides, size_t pad) {
+    TensorDescriptorKey key;
+    memset(&key, 0, sizeof(key));
+    key.datatype = datatype;
+    key.dim = sizes.size();
+    AT_ASSERT(sizes.size() <= 5, "RNN tensor descriptors have at most 5 dimensions");
+    std::copy(sizes.begin(), sizes.end(), key.sizes);
+    std::copy(strides.begin(), strides.end(), key.strides);
+    key.pad = pad;
+    return tensor_descriptor_cache().get(key, [&] {
+      auto desc = std::make_shared<TensorDescriptor>();
+      desc->set(datatype, sizes, strides, pad);
+      return desc;
+    });
+  }
+
+  std::shared_ptr<const TensorDescriptor> cached_tensor_descriptor(const Tensor& tensor, size_t pad) {
+    return cached_tensor_descriptor(getCudnnDataType(tensor), tensor.sizes(), tensor.strides(), pad);
+  }
+
   // TensorDescriptor list
 
-  std::vector<TensorDescriptor> rnn_descriptor_sequence(const Tensor& tensor, IntList batch_sizes) {
-    std::vector<TensorDescriptor> descriptors(batch_sizes.size());
+  using TensorDescriptorList = std::vector<std::shared_ptr<const TensorDescriptor>>;
+
+  TensorDescriptorList rnn_descriptor_sequence(const Tensor& tensor, IntList batch_sizes) {
+    TensorDescriptorList descriptors(batch_sizes.size());
     size_t i = 0;
     // To be mutated in the loop
     std::vector<int64_t> batch_tensor_size(tensor.sizes());
@@ -168,18 +274,15 @@ namespace {
       batch_tensor_size[0] = batch_size;
       // NB: cuDNN RNN API does not support 2d descriptors, so we
       // must pad it out to 3d.
-      descriptors[i].set(getCudnnDataType(tensor), batch_tensor_size, tensor.strides(), 3);
+      descriptors[i] = cached_tensor_descriptor(getCudnnDataType(tensor), batch_tensor_size, tensor.strides(), 3);
       i++;
     }
     return descriptors;
   }
 
-  std::vector<TensorDescriptor> rnn_descriptor(const Tensor& tensor, int64_t N) {
-    std::vector<TensorDescriptor> descriptors(N);
-    for (int64_t i = 0; i < N; i++) {
-      descriptors[i].set(tensor, 5);
-    }
-    return descriptors;
+  TensorDescriptorList rnn_descriptor(const Tensor& tensor, int64_t N) {
+    // every step has the same descriptor
+    return TensorDescriptorList(N, cached_tensor_descriptor(tensor, 5));
   }
 
   // The best way to understand the meaning of the values stored in
@@ -283,7 +386,7 @@ namespace {
     }
 
     // TODO: check x for consistency with input_size?
-    std::vector<TensorDescriptor> descriptors(Tensor x) const {
+    TensorDescriptorList descriptors(Tensor x) const {
       auto is_input_packed = batch_sizes.size() != 0;
       if (is_input_packed) {
         return rnn_descriptor_sequence(x, batch_sizes);
@@ -293,6 +396,70 @@ namespace {
     }
   };
 
+  // Algorithm selection
+
+  enum class RNNAlgoSetting { Auto, Standard, PersistStatic };
+
+  bool parse_rnn_algo(const std::string& name, RNNAlgoSetting* setting) {
+    if (name == "auto") {
+      *setting = RNNAlgoSetting::Auto;
+    } else if (name == "standard") {
+      *setting = RNNAlgoSetting::Standard;
+    } else if (name == "persist_static") {
+      *setting = RNNAlgoSetting::PersistStatic;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  std::atomic<int>& rnn_algo_setting() {
+    static std::atomic<int> setting([] {
+      RNNAlgoSetting s = RNNAlgoSetting::Auto;
+      const char* env = getenv("TORCH_CUDNN_RNN_ALGO");
+      if (env && !parse_rnn_algo(env, &s)) {
+        throw std::runtime_error(std::string("TORCH_CUDNN_RNN_ALGO should be auto, standard "
+                                             "or persist_static, but got ") + env);
+      }
+      return static_cast<int>(s);
+    }());
+    return setting;
+  }
+
+  // Persistent kernels keep the recurrent weights on chip for the whole
+  // sequence.  They win when the batch is too small for the per-step GEMMs
+  // of the standard algorithm to fill the GPU, as long as the hidden state
+  // fits and the sequence is long enough to pay for loading the weights.
+  // These limits follow NVIDIA's guidance for fp16 on Volta.
+  bool use_persist_static_heuristics(const RNNDescriptorParams& rnn, const TensorDescriptorListParams& tensors,
+                                     const cudaDeviceProp* prop) {
+    auto batch = tensors.mini_batch;
+    return rnn.datatype == CUDNN_DATA_HALF &&
+           prop->major >= 7 &&
+           rnn.hidden_size <= 1024 &&
+           rnn.hidden_size % 128 == 0 &&
+           tensors.input_size % 128 == 0 &&
+           batch % 8 == 0 &&
+           ((tensors.seq_length >= 40 && batch <= 128) ||
+            (tensors.seq_length >= 20 && batch <= 96) ||
+            (tensors.seq_length >= 10 && batch <= 32));
+  }
+
+  cudnnRNNAlgo_t choose_rnn_algo(const RNNDescriptorParams& rnn, const TensorDescriptorListParams& tensors) {
+    auto setting = static_cast<RNNAlgoSetting>(rnn_algo_setting().load());
+    if (setting == RNNAlgoSetting::Standard || tensors.is_input_packed()) {
+      return CUDNN_RNN_ALGO_STANDARD;
+    }
+    cudaDeviceProp* prop = globalContext().getCurrentDeviceProperties();
+    if (prop->major < 6) {
+      return CUDNN_RNN_ALGO_STANDARD;
+    }
+    if (setting == RNNAlgoSetting::PersistStatic || use_persist_static_heuristics(rnn, tensors, prop)) {
+      return CUDNN_RNN_ALGO_PERSIST_STATIC;
+    }
+    return CUDNN_RNN_ALGO_STANDARD;
+  }
+
   // Everything together
 
   struct RNNParams {
@@ -301,37 +468,111 @@ namespace {
     TensorDescriptorListParams tensors;
   };
 
+  // Everything an RNN descriptor is set up with.  The dropout state is
+  // identified by its address, which can't be reused while the cached
+  // descriptor holds the state tensor.
+  struct RNNDescriptorKey {
+    cudnnHandle_t handle;  // one per device
+    int64_t hidden_size;
+    int64_t num_layers;
+    cudnnDirectionMode_t bidirectional;
+    cudnnRNNMode_t mode;
+    cudnnDataType_t datatype;
+    cudnnRNNInputMode_t input_mode;
+    cudnnRNNAlgo_t algo;
+    double dropout;        // 0 if not training
+    void* dropout_state;   // nullptr without dropout
+  };
+
+  DescriptorCache<RNNDescriptorKey, RNNDescriptor>& rnn_descriptor_cache() {
+    static DescriptorCache<RNNDescriptorKey, RNNDescriptor> cache;
+    return cache;
+  }
+
+  std::shared_ptr<const RNNDescriptor> cached_rnn_descriptor(const RNNParams& fn, cudnnHandle_t handle) {
+    RNNDescriptorKey key;
+    memset(&key, 0, sizeof(key));
+    key.handle = handle;
+    key.hidden_size = fn.rnn.hidden_size;
+    key.num_layers = fn.rnn.num_layers;
+    key.bidirectional = fn.rnn.bidirectional;
+    key.mode = fn.rnn.mode;
+    key.datatype = fn.rnn.datatype;
+    key.input_mode = fn.rnn.input_mode;
+    key.algo = fn.rnn.algo;
+    key.dropout = fn.dropout.train ? fn.dropout.dropout : 0;
+    if (key.dropout != 0) {
+      key.dropout_state = fn.dropout.dropout_state.data_ptr();
+    }
+    return rnn_descriptor_cache().get(key, [&] {
+      return std::make_shared<RNNDescriptor>(fn.rnn.descriptor(handle, fn.dropout.descriptor(handle)));
+    });
+  }
+
   // NB: Doesn't include the weight descriptor
   struct RNNDescriptors {
-    RNNDescriptor rnn_desc;
+    std::shared_ptr<const RNNDescriptor> rnn_desc_ptr;
+    const RNNDescriptor& rnn_desc;
     // NB: this won't actually lay out the tensor descriptor pointers
     // in the right way, so you'll have to preprocess them
-    std::vector<TensorDescriptor> x_descs;
-    std::vector<TensorDescriptor> y_descs;
-    TensorDescriptor hx_desc;
-    TensorDescriptor hy_desc;
-    TensorDescriptor cx_desc;
-    TensorDescriptor cy_desc;
-
-    RNNDescriptors(const RNNParams& fn, cudnnHandle_t handle, Tensor x, Tensor y, Tensor hx, Tensor cx) {
-      rnn_desc = fn.rnn.descriptor(handle, fn.dropout.descriptor(handle));
-      x_descs = fn.tensors.descriptors(x);
-      y_descs = fn.tensors.descriptors(y);
-      hx_desc.set(hx, 5);
-      hy_desc.set(hx, 5);
-      if (cx.defined()) {
-        cx_desc.set(cx, 5);
-        cy_desc.set(cx, 5);
+    TensorDescriptorList x_descs;
+    TensorDescriptorList y_descs;
+    std::shared_ptr<const TensorDescriptor> hx_desc_ptr;
+    std::shared_ptr<const TensorDescriptor> cx_desc_ptr;
+    // hy and cy have the same sizes as hx and cx.  Without cx, the
+    // descriptors are left uninitialized, i.e. NULL.
+    TensorDescriptor no_cx_desc;
+    const TensorDescriptor& hx_desc;
+    const TensorDescriptor& hy_desc;
+    const TensorDescriptor& cx_desc;
+    const TensorDescriptor& cy_desc;
+#if CUDNN_VERSION >= 7201
+    // Packed x and y are also described as a whole, for the cudnnRNN*Ex
+    // functions; the workspace and reserve sizes are still queried with
+    // the per-step descriptors.
+    bool packed = false;
+    RNNDataDescriptor x_data_desc;
+    RNNDataDescriptor y_data_desc;
+#endif
+
+    RNNDescriptors(const RNNParams& fn, cudnnHandle_t handle, Tensor x, Tensor y, Tensor hx, Tensor cx)
+      : rnn_desc_ptr(cached_rnn_descriptor(fn, handle))
+      , rnn_desc(*rnn_desc_ptr)
+      , x_descs(fn.tensors.descriptors(x))
+      , y_descs(fn.tensors.descriptors(y))
+      , hx_desc_ptr(cached_tensor_descriptor(hx, 5))
+      , cx_desc_ptr(cx.defined() ? cached_tensor_descriptor(cx, 5) : nullptr)
+      , hx_desc(*hx_desc_ptr)
+      , hy_desc(*hx_desc_ptr)
+      , cx_desc(cx_desc_ptr ? *cx_desc_ptr : no_cx_desc)
+      , cy_desc(cx_desc_ptr ? *cx_desc_ptr : no_cx_desc) {
+#if CUDNN_VERSION >= 7201
+      if (fn.tensors.is_input_packed()) {
+        packed = true;
+        // batch_sizes[t] sequences are longer than t
+        auto& batch_sizes = fn.tensors.batch_sizes;
+        std::vector<int> seq_lengths(fn.tensors.mini_batch, 0);
+        for (auto batch_size : batch_sizes) {
+          for (int64_t i = 0; i < batch_size; i++) {
+            seq_lengths[i]++;
+          }
+        }
+        auto datatype = getCudnnDataType(x);
+        x_data_desc.set(datatype, CUDNN_RNN_DATA_LAYOUT_SEQ_MAJOR_PACKED, fn.tensors.seq_length,
+                        fn.tensors.mini_batch, x.size(-1), seq_lengths.data());
+        y_data_desc.set(datatype, CUDNN_RNN_DATA_LAYOUT_SEQ_MAJOR_PACKED, fn.tensors.seq_length,
+                        fn.tensors.mini_batch, y.size(-1), seq_lengths.data());
       }
+#endif
     }
 
     // TODO: This is annoying, having to put the cudnnTensorDescriptor_t
     // in a contiguous array...
-    std::vector<cudnnTensorDescriptor_t> get_descs(const std::vector<TensorDescriptor>& descs) {
+    std::vector<cudnnTensorDescriptor_t> get_descs(const TensorDescriptorList& descs) {
       std::vector<cudnnTensorDescriptor_t> r;
       r.reserve(descs.size());
       for (auto& desc : descs) {
-        r.emplace_back(desc.desc());
+        r.emplace_back(desc->desc());
       }
       return r;
     }
@@ -588,6 +829,7 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
   fn.rnn.set(fn_mode, fn_hidden_size, fn_num_layers, fn_bidirectional, getCudnnDataType(input));
   fn.dropout.set(fn_train, fn_dropout, fn_dropout_state);
   fn.tensors.set(input.sizes(), fn_batch_sizes, batch_first);
+  fn.rnn.algo = choose_rnn_algo(fn.rnn, fn.tensors);
 
   // TODO: Set device to input
 
@@ -629,13 +871,13 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
 
   FilterDescriptor w_desc;
   if (!weight_buf.defined()) {
-    auto num_weights = get_num_weights(handle, descs.rnn_desc, descs.x_descs[0], fn.rnn.datatype);
+    auto num_weights = get_num_weights(handle, descs.rnn_desc, *descs.x_descs[0], fn.rnn.datatype);
     weight_buf = x.type().tensor(num_weights);
     w_desc.set(weight_buf, 3);
     weight_buf.zero_();
     std::vector<Tensor> params;
     size_t params_stride0;
-    std::tie(params, params_stride0) = get_parameters(handle, fn.rnn, descs.rnn_desc, descs.x_descs[0], w_desc, weight_buf);
+    std::tie(params, params_stride0) = get_parameters(handle, fn.rnn, descs.rnn_desc, *descs.x_descs[0], w_desc, weight_buf);
     _copyParams(MatrixRef<Tensor>{weight, static_cast<size_t>(weight_stride0)},
                 MatrixRef<Tensor>{params, params_stride0});
   } else {
@@ -658,7 +900,7 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
         x_descs_arr.data(),
         &workspace_size
         ));
-  Tensor workspace = input.type().toScalarType(kByte).tensor(workspace_size);
+  CudnnWorkspace workspace(workspace_size);
 
   Tensor reserve;
   // NB: Previously, the test was for fn.requires_grad, but we don't have
@@ -673,6 +915,25 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
           &reserve_size
           ));
     reserve = input.type().toScalarType(kByte).tensor(reserve_size);
+#if CUDNN_VERSION >= 7201
+    if (descs.packed) {
+      CUDNN_CHECK(cudnnRNNForwardTrainingEx(
+            handle,
+            descs.rnn_desc.desc(),
+            descs.x_data_desc.desc(), x.data_ptr(),
+            descs.hx_desc.desc(), hx.data_ptr(),
+            descs.cx_desc.desc(), cx.defined() ? cx.data_ptr() : nullptr,
+            w_desc.desc(), weight_buf.data_ptr(),
+            descs.y_data_desc.desc(), y.data_ptr(),
+            descs.hy_desc.desc(), hy.data_ptr(),
+            descs.cy_desc.desc(), cy.defined() ? cy.data_ptr() : nullptr,
+            nullptr, nullptr, nullptr, nullptr, // keys and attention (unused)
+            nullptr, nullptr, nullptr, nullptr,
+            workspace.data, workspace.size,
+            reserve.data_ptr(), reserve.size(0)
+            ));
+    } else
+#endif
     CUDNN_CHECK(cudnnRNNForwardTraining(
           handle,
           descs.rnn_desc.desc(),
@@ -684,11 +945,29 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
           y_descs_arr.data(), y.data_ptr(),
           descs.hy_desc.desc(), hy.data_ptr(),
           descs.cy_desc.desc(), cy.defined() ? cy.data_ptr() : nullptr,
-          workspace.data_ptr(), workspace.size(0),
+          workspace.data, workspace.size,
           reserve.data_ptr(), reserve.size(0)
           ));
   } else { // inference
     reserve = input.type().toScalarType(kByte).tensor();
+#if CUDNN_VERSION >= 7201
+    if (descs.packed) {
+      CUDNN_CHECK(cudnnRNNForwardInferenceEx(
+            handle,
+            descs.rnn_desc.desc(),
+            descs.x_data_desc.desc(), x.data_ptr(),
+            descs.hx_desc.desc(), hx.data_ptr(),
+            descs.cx_desc.desc(), cx.defined() ? cx.data_ptr() : nullptr,
+            w_desc.desc(), weight_buf.data_ptr(),
+            descs.y_data_desc.desc(), y.data_ptr(),
+            descs.hy_desc.desc(), hy.data_ptr(),
+            descs.cy_desc.desc(), cy.defined() ? cy.data_ptr() : nullptr,
+            nullptr, nullptr, nullptr, nullptr, // keys and attention (unused)
+            nullptr, nullptr, nullptr, nullptr,
+            workspace.data, workspace.size
+            ));
+    } else
+#endif
     CUDNN_CHECK(cudnnRNNForwardInference(
           handle,
           descs.rnn_desc.desc(),
@@ -700,7 +979,7 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
           y_descs_arr.data(), y.data_ptr(),
           descs.hy_desc.desc(), hy.data_ptr(),
           descs.cy_desc.desc(), cy.defined() ? cy.data_ptr() : nullptr,
-          workspace.data_ptr(), workspace.size(0)
+          workspace.data, workspace.size
           ));
 
   }
@@ -731,6 +1010,7 @@ std::tuple<Tensor, Tensor, Tensor> _cudnn_rnn_backward_input(
   fn.rnn.set(fn_mode, fn_hidden_size, fn_num_layers, fn_bidirectional, getCudnnDataType(input));
   fn.dropout.set(fn_train, fn_dropout, fn_dropout_state);
   fn.tensors.set(input.sizes(), fn_batch_sizes, batch_first);
+  fn.rnn.algo = choose_rnn_algo(fn.rnn, fn.tensors);
 
   // TODO: Set device to input
   auto handle = getCudnnHandle();
@@ -822,9 +1102,30 @@ std::tuple<Tensor, Tensor, Tensor> _cudnn_rnn_backward_input(
         x_descs_arr.data(),
         &workspace_size
         ));
-  // TODO: put this in the correct device???
-  Tensor workspace = input.type().toScalarType(kByte).tensor(workspace_size);
+  CudnnWorkspace workspace(workspace_size);
 
+#if CUDNN_VERSION >= 7201
+  if (descs.packed) {
+    CUDNN_CHECK(cudnnRNNBackwardDataEx(
+          handle,
+          descs.rnn_desc.desc(),
+          descs.y_data_desc.desc(), y.data_ptr(),
+          descs.y_data_desc.desc(), dy.data_ptr(),
+          nullptr, nullptr, // attention (unused)
+          descs.hy_desc.desc(), dhy.data_ptr(),
+          descs.cy_desc.desc(), cx.defined() ? dcy.data_ptr() : nullptr,
+          w_desc.desc(), w.data_ptr(),
+          descs.hx_desc.desc(), hx.data_ptr(),
+          descs.cx_desc.desc(), cx.defined() ? cx.data_ptr() : nullptr,
+          descs.x_data_desc.desc(), dx.data_ptr(),
+          descs.hx_desc.desc(), dhx.data_ptr(),
+          descs.cx_desc.desc(), cx.defined() ? dcx.data_ptr() : nullptr,
+          nullptr, nullptr, // keys (unused)
+          workspace.data, workspace.size,
+          fn_reserve.data_ptr(), fn_reserve.size(0)
+          ));
+  } else
+#endif
   CUDNN_CHECK(cudnnRNNBackwardData(
         handle,
         descs.rnn_desc.desc(),
@@ -839,7 +1140,7 @@ std::tuple<Tensor, Tensor, Tensor> _cudnn_rnn_backward_input(
         x_descs_arr.data(), dx.data_ptr(),
         descs.hx_desc.desc(), dhx.data_ptr(),
         descs.cx_desc.desc(), cx.defined() ? dcx.data_ptr() : nullptr,
-        workspace.data_ptr(), workspace.size(0),
+        workspace.data, workspace.size,
         fn_reserve.data_ptr(), fn_reserve.size(0)
         ));
 
@@ -872,6 +1173,7 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
   fn.rnn.set(fn_mode, fn_hidden_size, fn_num_layers, fn_bidirectional, getCudnnDataType(input));
   fn.dropout.set(fn_train, fn_dropout, fn_dropout_state);
   fn.tensors.set(input.sizes(), fn_batch_sizes, batch_first);
+  fn.rnn.algo = choose_rnn_algo(fn.rnn, fn.tensors);
 
   auto handle = getCudnnHandle();
 
@@ -932,8 +1234,22 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
         x_descs_arr.data(),
         &workspace_size
         ));
-  Tensor workspace = input.type().toScalarType(kByte).tensor(workspace_size);
+  CudnnWorkspace workspace(workspace_size);
 
+#if CUDNN_VERSION >= 7201
+  if (descs.packed) {
+    CUDNN_CHECK(cudnnRNNBackwardWeightsEx(
+          handle,
+          descs.rnn_desc.desc(),
+          descs.x_data_desc.desc(), x.data_ptr(),
+          descs.hx_desc.desc(), hx.data_ptr(),
+          descs.y_data_desc.desc(), y.data_ptr(),
+          workspace.data, workspace.size,
+          w_desc.desc(), dw.data_ptr(),
+          fn_reserve.data_ptr(), fn_reserve.size(0)
+          ));
+  } else
+#endif
   CUDNN_CHECK(cudnnRNNBackwardWeights(
         handle,
         descs.rnn_desc.desc(),
@@ -941,7 +1257,7 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
         x_descs_arr.data(), x.data_ptr(),
         descs.hx_desc.desc(), hx.data_ptr(),
         y_descs_arr.data(), y.data_ptr(),
-        workspace.data_ptr(), workspace.size(0),
+        workspace.data, workspace.size,
         w_desc.desc(), dw.data_ptr(),
         fn_reserve.data_ptr(), fn_reserve.size(0)
         ));
@@ -954,7 +1270,7 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
 
   std::vector<Tensor> grad_params_arr;
   size_t grad_params_stride0;
-  std::tie(grad_params_arr, grad_params_stride0) = get_parameters(handle, fn.rnn, descs.rnn_desc, descs.x_descs[0], w_desc, dw);
+  std::tie(grad_params_arr, grad_params_stride0) = get_parameters(handle, fn.rnn, descs.rnn_desc, *descs.x_descs[0], w_desc, dw);
   _copyParams(MatrixRef<Tensor>{grad_params_arr, grad_params_stride0},
               MatrixRef<Tensor>{grad_weight_arr, static_cast<size_t>(weight_stride0)});
 
@@ -988,6 +1304,26 @@ std::tuple<Tensor, Tensor, Tensor, std::vector<Tensor>> _cudnn_rnn_backward(
   return std::tuple<Tensor, Tensor, Tensor, TensorList>{dx, dhx, dcx, dw};
 }
 
+std::string getCudnnRNNAlgo() {
+  switch (static_cast<RNNAlgoSetting>(rnn_algo_setting().load())) {
+    case RNNAlgoSetting::Standard:
+      return "standard";
+    case RNNAlgoSetting::PersistStatic:
+      return "persist_static";
+    default:
+      return "auto";
+  }
+}
+
+void setCudnnRNNAlgo(const std::string& algo) {
+  RNNAlgoSetting setting;
+  if (!parse_rnn_algo(algo, &setting)) {
+    throw std::runtime_error("the cuDNN RNN algorithm should be auto, standard or persist_static, "
+                             "but got " + algo);
+  }
+  rnn_algo_setting() = static_cast<int>(setting);
+}
+
 // TODO: I am not sure if we actually need the 'dropout' and 'train' parameters
 // to initialize just the state tensor
 Tensor _cudnn_init_dropout_state(const Type& ty, double dropout, bool train, int64_t dropout_seed) {
@@ -35,6 +35,7 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> mkldnn_convolution_backward(
 #else // AT_MKLDNN_EBABLED
 
 #include <ATen/mkldnn/Runtime.h>
+#include <ATen/native/MemoryFormat.h>
 
 using namespace mkldnn;
 
@@ -66,11 +67,24 @@ std::vector<int64_t> conv_output_size(
   return output_size;
 }
 
+// MKL-DNN memory format of an NCHW or channels last activation tensor
+static memory::format activation_format(const at::Tensor& tensor) {
+  return is_channels_last(tensor) ? memory::format::nhwc : memory::format::nchw;
+}
+
+// Allocates a tensor with the same layout as like
+static at::Tensor empty_activation(const at::Tensor& like, IntList sizes) {
+  if (is_channels_last(like)) {
+    return empty_channels_last(like.type(), sizes);
+  }
+  return like.type().tensor(sizes);
+}
+
 at::Tensor mkldnn_convolution(
     const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias,
     IntList padding, IntList stride, IntList dilation)
 {
-  auto output = input.type().tensor(conv_output_size(
+  auto output = empty_activation(input, conv_output_size(
     input.sizes(), weight.sizes(), padding, stride, dilation));
 
   auto cpu_engine = CpuEngine::Instance().get_engine();
@@ -94,7 +108,6 @@ at::Tensor mkldnn_convolution(
 
   auto data_t = memory::data_type::f32;
   auto format_any = memory::format::any;
-  auto format_nchw = memory::format::nchw;
   auto format_oihw = memory::format::oihw;
   auto format_x = memory::format::x;
 
@@ -125,11 +138,11 @@ at::Tensor mkldnn_convolution(
   conv_forward_pd.reset(new convolution_forward::primitive_desc(
     *conv_forward_desc, cpu_engine));
 
-  auto input_usr_memory = memory({{{input_tz}, data_t, format_nchw}, cpu_engine},
+  auto input_usr_memory = memory({{{input_tz}, data_t, activation_format(input)}, cpu_engine},
     input.data_ptr());
   auto weight_usr_memory = memory({{{weight_tz}, data_t,  format_oihw}, cpu_engine},
     weight.data_ptr());
-  auto output_usr_memory = memory({{{output_tz}, data_t, format_nchw}, cpu_engine},
+  auto output_usr_memory = memory({{{output_tz}, data_t, activation_format(output)}, cpu_engine},
     output.data_ptr());
 
   std::vector<primitive> net;
@@ -180,7 +193,7 @@ Tensor mkldnn_convolution_backward_input(
     IntList input_size, const at::Tensor& grad_output, const at::Tensor& weight,
     IntList padding, IntList stride, IntList dilation, bool bias_defined)
 {
-  auto grad_input = grad_output.type().tensor(input_size);
+  auto grad_input = empty_activation(grad_output, input_size);
 
   auto cpu_engine = CpuEngine::Instance().get_engine();
 
@@ -203,7 +216,6 @@ Tensor mkldnn_convolution_backward_input(
 
   auto data_t = memory::data_type::f32;
   auto format_any = memory::format::any;
-  auto format_nchw = memory::format::nchw;
   auto format_oihw = memory::format::oihw;
 
   memory::dims input_tz = {n, ic, ih, iw};
@@ -243,11 +255,11 @@ Tensor mkldnn_convolution_backward_input(
   conv_backward_data_pd.reset(new convolution_backward_data::primitive_desc(
     *conv_backward_data_desc, cpu_engine, *conv_forward_pd));
 
-  auto grad_output_usr_memory = memory({{{output_tz}, data_t, format_nchw}, cpu_engine},
+  auto grad_output_usr_memory = memory({{{output_tz}, data_t, activation_format(grad_output)}, cpu_engine},
     grad_output.data_ptr());
   auto weight_usr_memory = memory({{{weight_tz}, data_t, format_oihw}, cpu_engine},
     weight.data_ptr());
-  auto grad_input_usr_memory = memory({{{input_tz}, data_t, format_nchw}, cpu_engine},
+  auto grad_input_usr_memory = memory({{{input_tz}, data_t, activation_format(grad_input)}, cpu_engine},
     grad_input.data_ptr());
 
   std::vector<primitive> net;
@@ -318,7 +330,6 @@ std::tuple<at::Tensor, at::Tensor> mkldnn_convolution_backward_weights(
 
   auto data_t = memory::data_type::f32;
   auto format_any = memory::format::any;
-  auto format_nchw = memory::format::nchw;
   auto format_oihw = memory::format::oihw;
   auto format_x = memory::format::x;
 
@@ -365,9 +376,9 @@ std::tuple<at::Tensor, at::Tensor> mkldnn_convolution_backward_weights(
   conv_backward_weight_pd.reset(new convolution_backward_weights::primitive_desc(
     *conv_backward_weight_desc, cpu_engine, *conv_forward_pd));
 
-  auto input_usr_memory = memory({{{input_tz}, data_t, format_nchw}, cpu_engine},
+  auto input_usr_memory = memory({{{input_tz}, data_t, activation_format(input)}, cpu_engine},
     input.data_ptr());
-  auto grad_output_usr_memory = memory({{{output_tz}, data_t, format_nchw}, cpu_engine},
+  auto grad_output_usr_memory = memory({{{output_tz}, data_t, activation_format(grad_output)}, cpu_engine},
     grad_output.data_ptr());
   auto grad_weight_usr_memory = memory({{{weight_tz}, data_t, format_oihw}, cpu_engine},
     grad_weight.data_ptr());
@@ -421,7 +432,7 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> mkldnn_convolution_backward(
     const at::Tensor& input, const at::Tensor& grad_output_t, const at::Tensor& weight,
     IntList padding, IntList stride, IntList dilation, std::array<bool,3> output_mask)
 {
-  Tensor grad_output = grad_output_t.contiguous();
+  Tensor grad_output = is_channels_last(grad_output_t) ? grad_output_t : grad_output_t.contiguous();
 
   Tensor grad_input, grad_weight, grad_bias;
   if (output_mask[0]) {
@@ -112,6 +112,10 @@ def run(paths):
             declaration['arguments'] = func.get('arguments', parse_arguments(arguments, func,
                                                 declaration['name'], declaration['return']))
             declaration['type_method_definition_dispatch'] = func.get('dispatch', declaration['name'])
+            if isinstance(declaration['type_method_definition_dispatch'], dict):
+                # only the backends listed in dispatch get a definition
+                declaration['backends'] = [backend for backend in ['CPU', 'CUDA']
+                                           if backend in declaration['type_method_definition_dispatch']]
             declaration['aten_sparse'] = has_sparse_dispatches(
                 declaration['type_method_definition_dispatch'])
             declarations.append(declaration)
@@ -8,6 +8,7 @@ type_map = {
         'Float',
         'Double',
         'Half',
+        'BFloat16',
     ],
     'integral': [
         'Byte',
@@ -64,6 +65,11 @@ def process_types_and_backends(option):
     # special case remove Half for cpu unless it is explicitly enabled,
     if not option.get('cpu_half', False):
         pairs.discard(('CPU', 'Half'))
+        pairs.discard(('CPU', 'BFloat16'))
+
+    # BFloat16 only exists as a dense CPU type
+    for backend in ['CUDA', 'SparseCPU', 'SparseCUDA']:
+        pairs.discard((backend, 'BFloat16'))
 
     # sort the result for easy reading
     option['backend_type_pairs'] = sorted([p for p in pairs])
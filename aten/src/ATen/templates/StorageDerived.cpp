@@ -174,6 +174,10 @@ void ${Storage}::clear_flag(char flag) {
   ${THStorage}_clearFlag(${state,} storage, flag);
 }
 
+bool ${Storage}::has_flag(char flag) const {
+  return storage && (storage->flag & flag);
+}
+
 int ${Storage}::getDevice() const {
   ${storage_device} //storage->device;
 }
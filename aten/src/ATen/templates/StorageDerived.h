@@ -38,6 +38,7 @@ public:
 
   virtual void set_flag(char flag) override;
   virtual void clear_flag(char flag) override;
+  virtual bool has_flag(char flag) const override;
 
   virtual Type& type() const override;
   virtual int getDevice() const override;
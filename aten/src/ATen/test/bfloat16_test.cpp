@@ -0,0 +1,89 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "test_seed.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace at;
+
+static float bits_to_float(uint32_t bits) {
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// float rounded to bfloat16 precision, through the conversions
+static float round_trip(float f) {
+  return convert<float>(convert<BFloat16>(f));
+}
+
+TEST_CASE( "bfloat16 test", "[]" ) {
+  manual_seed(123);
+
+  SECTION( "conversion" ) {
+    // values with 8 significant bits are exact
+    REQUIRE(round_trip(1.0f) == 1.0f);
+    REQUIRE(round_trip(-3.5f) == -3.5f);
+    REQUIRE(round_trip(1.0f / 256) == 1.0f / 256);
+    // to nearest, ties to even
+    REQUIRE(convert<BFloat16>(bits_to_float(0x3F808001)).x == 0x3F81);
+    REQUIRE(convert<BFloat16>(bits_to_float(0x3F808000)).x == 0x3F80);
+    REQUIRE(convert<BFloat16>(bits_to_float(0x3F818000)).x == 0x3F82);
+    // the range of float
+    REQUIRE(round_trip(1e38f) > 9.9e37f);
+    REQUIRE(std::isinf(round_trip(std::numeric_limits<float>::infinity())));
+    REQUIRE(std::isnan(round_trip(std::numeric_limits<float>::quiet_NaN())));
+    REQUIRE(std::isnan(round_trip(bits_to_float(0x7F800001))));
+
+    REQUIRE(Scalar(1e38).toBFloat16().x == convert<BFloat16>(1e38f).x);
+    REQUIRE_THROWS_AS(Scalar(1e39).toBFloat16(), std::domain_error);
+    REQUIRE(promoteTypes(kBFloat16, kFloat) == kFloat);
+    REQUIRE(promoteTypes(kBFloat16, kHalf) == kFloat);
+    REQUIRE(promoteTypes(kByte, kBFloat16) == kBFloat16);
+  }
+
+  SECTION( "copy" ) {
+    auto a = randn(CPU(kFloat), {3, 4, 5});
+    auto b = a.toType(kBFloat16);
+    REQUIRE(b.type().scalarType() == kBFloat16);
+    REQUIRE(b.type().elementSizeInBytes() == 2);
+    auto back = b.toType(kFloat);
+    auto a_data = a.data<float>();
+    auto back_data = back.data<float>();
+    for (int64_t i = 0; i < a.numel(); i++) {
+      REQUIRE(back_data[i] == round_trip(a_data[i]));
+    }
+    // strided copies go element by element
+    REQUIRE(b.transpose(0, 2).toType(kDouble).equal(back.transpose(0, 2).toType(kDouble)));
+  }
+
+  SECTION( "unary ops compute in float" ) {
+    auto a = randn(CPU(kFloat), {7, 33});
+    auto b = a.toType(kBFloat16);
+    auto expected = b.toType(kFloat).exp();
+    auto result = b.exp().toType(kFloat);
+    auto expected_data = expected.data<float>();
+    auto result_data = result.data<float>();
+    for (int64_t i = 0; i < a.numel(); i++) {
+      REQUIRE(result_data[i] == round_trip(expected_data[i]));
+    }
+    // non-contiguous input
+    auto t = b.t().sin().toType(kFloat);
+    REQUIRE(t.equal(b.toType(kFloat).t().sin().toType(kBFloat16).toType(kFloat)));
+  }
+
+  SECTION( "reductions accumulate in float" ) {
+    // a bfloat16 accumulator would stop at 256, where adding 1 rounds away
+    auto ones_ = ones(CPU(kFloat), {64, 64}).toType(kBFloat16);
+    REQUIRE(ones_.sum().toCFloat() == 4096);
+    auto col_sums = ones_.sum(0);
+    REQUIRE(col_sums.type().scalarType() == kBFloat16);
+    REQUIRE(col_sums.toType(kFloat).equal(ones(CPU(kFloat), {64}).mul(64)));
+    auto twos = ones(CPU(kFloat), {10}).mul(2).toType(kBFloat16);
+    REQUIRE(twos.prod().toCFloat() == 1024);
+  }
+}
@@ -0,0 +1,42 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "TH/THCachingAllocator.h"
+#include "test_seed.h"
+
+using namespace at;
+
+TEST_CASE( "caching CPU allocator", "[cpu]" ) {
+  manual_seed(123);
+
+  // allocated before the cache is enabled, and freed after
+  Tensor before = ones(CPU(kFloat), {1 << 20});
+
+  THCachingAllocator_setEnabled(1);
+  REQUIRE(THCachingAllocator_enabled());
+
+  SECTION( "blocks are reused by the same size class" ) {
+    void* ptr;
+    {
+      Tensor t = ones(CPU(kFloat), {1 << 20});
+      ptr = t.data_ptr();
+      REQUIRE(THCachingAllocator_allocatedBytes() >= (4u << 20));
+    }
+    REQUIRE(THCachingAllocator_cachedBytes() >= (4u << 20));
+    Tensor t = zeros(CPU(kFloat), {(1 << 20) - 100});
+    REQUIRE(t.data_ptr() == ptr);
+    REQUIRE(t.sum().toCFloat() == 0);
+  }
+
+  SECTION( "resizing keeps the data" ) {
+    Tensor t = ones(CPU(kFloat), {1 << 18});
+    t.resize_({1 << 20});
+    REQUIRE(t.narrow(0, 0, 1 << 18).sum().toCFloat() == (1 << 18));
+  }
+
+  before = Tensor();
+  THCachingAllocator_emptyCache();
+  REQUIRE(THCachingAllocator_cachedBytes() == 0);
+  THCachingAllocator_setEnabled(0);
+}
@@ -26,3 +26,22 @@ TEST_CASE( "dlconvertor", "[cpu]" ) {
   REQUIRE(a.equal(b));
 }
 
+
+TEST_CASE( "dlconvertor pinned and streams", "[cpu]" ) {
+
+  manual_seed(123);
+
+  Tensor a = rand(CPU(at::kFloat), {3,4});
+  DLManagedTensor* dlMTensor = toDLPack(a);
+  REQUIRE(dlMTensor->dl_tensor.ctx.device_type == kDLCPU);
+
+  INFO( "import pinned memory as a CPU tensor" );
+  dlMTensor->dl_tensor.ctx.device_type = kDLCPUPinned;
+  Tensor b = fromDLPack(dlMTensor);
+  REQUIRE(b.type().backend() == kCPU);
+  REQUIRE(b.data_ptr() == a.data_ptr());
+
+  INFO( "the stream is ignored for CPU tensors" );
+  Tensor c = fromDLPack(toDLPack(a, nullptr), nullptr);
+  REQUIRE(a.equal(c));
+}
@@ -0,0 +1,60 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "ATen/mkldnn/OpaqueTensor.h"
+#include "test_seed.h"
+
+using namespace at;
+using namespace at::native;
+
+static bool almost_equal(const Tensor& a, const Tensor& b) {
+  return a.sizes().equals(b.sizes()) && (a - b).abs().max().toCFloat() < 1e-4;
+}
+
+TEST_CASE( "mkldnn opaque tensors", "[cpu]" ) {
+  manual_seed(123);
+
+  auto input = randn(CPU(kFloat), {2, 3, 15, 15});
+  auto weight = randn(CPU(kFloat), {16, 3, 3, 3});
+  auto bias = randn(CPU(kFloat), {16});
+  auto bn_weight = rand(CPU(kFloat), {16});
+  auto bn_bias = randn(CPU(kFloat), {16});
+  auto mean = randn(CPU(kFloat), {16});
+  auto var = rand(CPU(kFloat), {16}) + 0.5;
+  auto weight2 = randn(CPU(kFloat), {16, 16, 3, 3});
+
+  SECTION( "round trip" ) {
+    MKLDNNTensor x(input);
+    REQUIRE(x.to_dense().equal(input));
+    // channels last inputs are read in place
+    auto nhwc = input.permute({0, 2, 3, 1}).contiguous().permute({0, 3, 1, 2});
+    REQUIRE(MKLDNNTensor(nhwc).to_dense().equal(input));
+  }
+
+  SECTION( "residual block" ) {
+    auto y = at::conv2d(input, weight, bias, {1, 1}, {1, 1});
+    y = at::relu(at::batch_norm(y, bn_weight, bn_bias, mean, var, false, 0.1, 1e-5, false));
+    auto z = at::conv2d(y, weight2, {}, {1, 1}, {1, 1});
+    auto expected = std::get<0>(at::max_pool2d(z + y, {3, 3}, {2, 2}, {1, 1}));
+    auto expected_avg = at::avg_pool2d(z + y, {3, 3}, {2, 2}, {1, 1}, false, true);
+
+    MKLDNNConvWeight conv1(weight, bias, {1, 1}, {1, 1}, {1, 1});
+    MKLDNNConvWeight conv2(weight2, {}, {1, 1}, {1, 1}, {1, 1});
+    // the weights are reordered by the first run only
+    for (int i = 0; i < 2; ++i) {
+      auto a = mkldnn_conv2d(MKLDNNTensor(input), conv1);
+      a = mkldnn_relu(mkldnn_batch_norm(a, bn_weight, bn_bias, mean, var, 1e-5));
+      auto b = mkldnn_sum(mkldnn_conv2d(a, conv2), a);
+      REQUIRE(almost_equal(mkldnn_max_pool2d(b, {3, 3}, {2, 2}, {1, 1}).to_dense(), expected));
+      REQUIRE(almost_equal(mkldnn_avg_pool2d(b, {3, 3}, {2, 2}, {1, 1}, true).to_dense(), expected_avg));
+    }
+  }
+
+  SECTION( "errors" ) {
+    REQUIRE_THROWS(MKLDNNTensor(randn(CPU(kDouble), {2, 3, 4, 4})));
+    REQUIRE_THROWS(MKLDNNConvWeight(weight, bias, {1, 1}, {1, 1}, {2, 2}));
+    MKLDNNConvWeight conv(weight2, {}, {1, 1}, {1, 1}, {1, 1});
+    REQUIRE_THROWS(mkldnn_conv2d(MKLDNNTensor(input), conv));
+  }
+}
@@ -0,0 +1,44 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "TH/THSmallAlloc.h"
+
+using namespace at;
+
+TEST_CASE( "small allocations", "[cpu]" ) {
+
+  SECTION( "freed blocks are reused by their size class" ) {
+    void* ptr = THSmallAlloc(100);
+    THSmallFree(ptr, 100);
+    void* again = THSmallAlloc(112);
+    REQUIRE(again == ptr);
+    THSmallFree(again, 112);
+
+    void* large = THSmallAlloc(1 << 10);
+    THSmallFree(large, 1 << 10);
+  }
+
+  SECTION( "sizes and strides beyond the inline dimensions" ) {
+    Tensor t = ones(CPU(kFloat), {2, 1, 3, 1, 2});
+    Tensor u = t.unsqueeze(0).unsqueeze(6);
+    REQUIRE(u.sizes().equals({1, 2, 1, 3, 1, 2, 1}));
+    REQUIRE(u.strides().equals({12, 6, 6, 2, 2, 1, 1}));
+    REQUIRE(u.squeeze().sizes().equals({2, 3, 2}));
+    REQUIRE(u.sum().toCFloat() == 12);
+
+    Tensor big = ones(CPU(kFloat), {1, 2, 1, 2, 1, 2, 1, 2});
+    REQUIRE(big.sum().toCFloat() == 16);
+    big.resize_({4, 4});
+    REQUIRE(big.strides().equals({4, 1}));
+    big.resize_({2, 2, 2, 2, 1, 1});
+    REQUIRE(big.strides().equals({8, 4, 2, 1, 1, 1}));
+
+    Tensor w = t.view({12}).unfold(0, 4, 2);
+    REQUIRE(w.sizes().equals({5, 4}));
+    REQUIRE(w.strides().equals({2, 1}));
+    Tensor v = ones(CPU(kFloat), {2, 2, 2, 2, 4}).unfold(4, 2, 2);
+    REQUIRE(v.sizes().equals({2, 2, 2, 2, 2, 2}));
+    REQUIRE(v.strides().equals({32, 16, 8, 4, 2, 1}));
+  }
+}
@@ -3,7 +3,10 @@
 
 #include "ATen/ATen.h"
 #include "ATen/DLConvertor.h"
+#include "ATen/Parallel.h"
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <string.h>
 #include <sstream>
@@ -27,3 +30,59 @@ TEST_CASE( "parallel", "[cpu]" ) {
   REQUIRE(a.sum(0).equal(as));
 }
 
+
+static int custom_calls = 0;
+
+static void custom_parallel_for(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f) {
+  custom_calls++;
+  for (int64_t b = begin; b < end; b += grain_size) {
+    f(b, std::min(end, b + grain_size));
+  }
+}
+
+TEST_CASE( "parallel backends", "[cpu]" ) {
+
+  set_num_threads(4);
+  std::vector<ParallelBackend> backends = {ParallelBackend::TBB, ParallelBackend::SEQUENTIAL};
+  try {
+    set_parallel_backend(ParallelBackend::OPENMP);
+    backends.push_back(ParallelBackend::OPENMP);
+  } catch (std::runtime_error& e) {
+    // built without OpenMP
+  }
+
+  Tensor a = ones(CPU(at::kFloat), {1000 * 1000});
+  const int64_t n = 100000;
+  for (auto backend : backends) {
+    set_parallel_backend(backend);
+    REQUIRE(get_parallel_backend() == backend);
+    std::vector<int> visited(n, 0);
+    parallel_for(0, n, 1000, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        visited[i]++;
+      }
+    });
+    REQUIRE(std::all_of(visited.begin(), visited.end(), [](int v) { return v == 1; }));
+    auto sum = parallel_reduce(0, n, 1000, int64_t(0),
+        [](int64_t begin, int64_t end, int64_t init) {
+          for (int64_t i = begin; i < end; i++) {
+            init += i;
+          }
+          return init;
+        },
+        std::plus<int64_t>());
+    REQUIRE(sum == n * (n - 1) / 2);
+    REQUIRE(a.sum().toCFloat() == 1000 * 1000);
+  }
+
+  set_parallel_for_impl(&custom_parallel_for);
+  REQUIRE(get_parallel_backend() == ParallelBackend::CUSTOM);
+  REQUIRE(a.sum().toCFloat() == 1000 * 1000);
+  REQUIRE(custom_calls > 0);
+  set_parallel_for_impl(nullptr);
+  REQUIRE(get_parallel_backend() != ParallelBackend::CUSTOM);
+}
@@ -1,5 +1,6 @@
 #include "THAllocator.h"
 #include "THAtomic.h"
+#include "THCachingAllocator.h"
 
 /* needed for ATOMIC_INT_LOCK_FREE */
 /* cannot go in THAtomic.h because of interactions with OpenMP giving
@@ -27,16 +28,20 @@
 #endif
 /* end of stuff for mapped files */
 
+/* the caching allocator frees memory from THAlloc with THFree, so that it
+ * can be enabled at any time */
 static void *THDefaultAllocator_alloc(void* ctx, ptrdiff_t size) {
+  if (THCachingAllocator_enabled())
+    return THCachingAllocator.malloc(NULL, size);
   return THAlloc(size);
 }
 
 static void *THDefaultAllocator_realloc(void* ctx, void* ptr, ptrdiff_t size) {
-  return THRealloc(ptr, size);
+  return THCachingAllocator.realloc(NULL, ptr, size);
 }
 
 static void THDefaultAllocator_free(void* ctx, void* ptr) {
-  THFree(ptr);
+  THCachingAllocator.free(NULL, ptr);
 }
 
 THAllocator THDefaultAllocator = {
@@ -594,6 +599,12 @@ int THRefcountedMapAllocator_decref(THMapAllocatorContext *ctx, void *data)
   return THAtomicDecrementRef(&map_info->refcount);
 }
 
+int THRefcountedMapAllocator_refcount(THMapAllocatorContext *ctx, void *data)
+{
+  THMapInfo *map_info = (THMapInfo*)(((char*)data) - TH_ALLOC_ALIGNMENT);
+  return THAtomicGet(&map_info->refcount);
+}
+
 #else
 
 static void * THRefcountedMapAllocator_alloc(void *ctx, ptrdiff_t size) {
@@ -621,6 +632,12 @@ int THRefcountedMapAllocator_decref(THMapAllocatorContext *ctx, void *data)
   return 0;
 }
 
+int THRefcountedMapAllocator_refcount(THMapAllocatorContext *ctx, void *data)
+{
+  THError("refcounted file mapping not supported on your system");
+  return 0;
+}
+
 #endif
 
 THAllocator THMapAllocator = {
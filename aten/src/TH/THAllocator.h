@@ -36,6 +36,7 @@ TH_API ptrdiff_t THMapAllocatorContext_size(THMapAllocatorContext *ctx);
 TH_API void THMapAllocatorContext_free(THMapAllocatorContext *ctx);
 TH_API void THRefcountedMapAllocator_incref(THMapAllocatorContext *ctx, void *data);
 TH_API int THRefcountedMapAllocator_decref(THMapAllocatorContext *ctx, void *data);
+TH_API int THRefcountedMapAllocator_refcount(THMapAllocatorContext *ctx, void *data);
 
 TH_API THAllocator THMapAllocator;
 TH_API THAllocator THRefcountedMapAllocator;
@@ -0,0 +1,56 @@
+#ifndef TH_BFLOAT16_H
+#define TH_BFLOAT16_H
+
+#include "THGeneral.h"
+#include <stdint.h>
+#include <string.h>
+
+/* bfloat16: the upper half of an IEEE float, with its 8 bits of exponent and
+   7 of mantissa. It has the range of float at half the size, and converting
+   from float is a rounding of the lower 16 bits. */
+
+#if defined(__GNUC__)
+#define __thalign__(n) __attribute__((aligned(n)))
+#elif defined(_WIN32)
+#define __thalign__(n) __declspec(align(n))
+#else
+#define __thalign__(n)
+#endif
+
+typedef struct __thalign__(2){
+  uint16_t x;
+} THBFloat16;
+
+#undef __thalign__
+
+static inline float TH_bfloat162float(THBFloat16 value)
+{
+  uint32_t bits = (uint32_t)value.x << 16;
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+/* Rounds to the nearest even bfloat16, NaNs stay (quiet) NaNs */
+static inline THBFloat16 TH_float2bfloat16(float value)
+{
+  THBFloat16 result;
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  if ((bits & 0x7fffffffU) > 0x7f800000U) {
+    result.x = (uint16_t)((bits >> 16) | 0x40U);
+    return result;
+  }
+  bits += 0x7fffU + ((bits >> 16) & 1U);
+  result.x = (uint16_t)(bits >> 16);
+  return result;
+}
+
+#ifndef TH_BFLOAT16_BITS_TO_LITERAL
+# define TH_BFLOAT16_BITS_TO_LITERAL(n) { n }
+#endif
+
+#define TH_BFLOAT16_ZERO 0x0U
+#define TH_BFLOAT16_INF  0x7F80U
+
+#endif
@@ -1,4 +1,7 @@
 #include "THBlas.h"
 
+// Below this number of multiply-adds, batched products run serially
+#define TH_OMP_OVERHEAD_THRESHOLD_GEMM 100000
+
 #include "generic/THBlas.c"
 #include "THGenerateAllTypes.h"
@@ -0,0 +1,401 @@
+#include "THCachingAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+//
+// Yet another caching allocator for CPU allocations.
+//
+// - Blocks are only reused by allocations of their size class, so the size
+//   classes are kept coarse enough that the tensors of an iteration map to
+//   the blocks freed by the previous one.
+// - Freed blocks first go to a small cache of the freeing thread, which
+//   takes no lock, then to the free lists shared by all the threads.
+// - The blocks owned by the allocator, in use or free, are registered in a
+//   few hash maps sharded by address, so that frees from different threads
+//   rarely wait on each other.
+// - Nothing is returned to the system until THCachingAllocator_emptyCache,
+//   except when an allocation fails, which empties the cache and retries.
+//
+
+namespace {
+
+const size_t kMinCachedSize = 256 << 10;  // smaller sizes go to THAlloc
+const size_t kHugePageSize = 2 << 20;     // size of a transparent huge page
+const size_t kAlignment = 64;             // alignment of THAlloc
+const size_t kThreadCacheBlocks = 8;      // free blocks kept by a thread
+const size_t kThreadCacheBytes = 64 << 20;
+const int kNumShards = 16;
+
+size_t roundSize(size_t size)
+{
+  if (size >= kHugePageSize) {
+    return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  }
+  size_t rounded = kMinCachedSize;
+  while (rounded < size) {
+    rounded *= 2;
+  }
+  return rounded;
+}
+
+struct Block {
+  size_t size;   // size of the block, a size class
+  bool mapped;   // true if the block was mapped with mmap, false if malloc'd
+};
+
+struct Shard {
+  std::mutex mutex;
+  std::unordered_map<void*, Block> blocks;
+};
+
+struct ThreadCache;
+
+struct CachingAllocator
+{
+  // blocks owned by the allocator, in use or free
+  Shard shards[kNumShards];
+  std::atomic<size_t> num_blocks;
+
+  // free blocks which aren't in a thread cache, by size
+  std::mutex free_mutex;
+  std::unordered_map<size_t, std::vector<void*>> free_blocks;
+
+  std::atomic<size_t> cached_bytes;
+  std::atomic<size_t> allocated_bytes;
+
+  // -1 until TH_CACHING_ALLOCATOR is read
+  std::atomic<int> enabled;
+  bool use_hugetlb;
+
+  CachingAllocator()
+    : num_blocks(0), cached_bytes(0), allocated_bytes(0), enabled(-1) {
+    const char* env = getenv("TH_CACHING_ALLOCATOR_HUGETLB");
+    use_hugetlb = env != NULL && strcmp(env, "1") == 0;
+  }
+
+  Shard& shardOf(void* ptr) {
+    return shards[((uintptr_t)ptr / kHugePageSize) % kNumShards];
+  }
+
+  bool isEnabled() {
+    int state = enabled.load();
+    if (state < 0) {
+      const char* env = getenv("TH_CACHING_ALLOCATOR");
+      state = env != NULL && strcmp(env, "1") == 0;
+      int expected = -1;
+      enabled.compare_exchange_strong(expected, state);
+      state = enabled.load();
+    }
+    return state == 1;
+  }
+
+  void* malloc(ptrdiff_t size);
+  void* realloc(void* ptr, ptrdiff_t size);
+  void free(void* ptr);
+  void emptyCache();
+
+  // returns the size of the block if ptr is one of ours, 0 otherwise
+  size_t blockSize(void* ptr) {
+    Shard& shard = shardOf(ptr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.blocks.find(ptr);
+    return it == shard.blocks.end() ? 0 : it->second.size;
+  }
+
+  void* takeShared(size_t size) {
+    std::lock_guard<std::mutex> lock(free_mutex);
+    auto it = free_blocks.find(size);
+    if (it == free_blocks.end() || it->second.empty()) {
+      return NULL;
+    }
+    void* ptr = it->second.back();
+    it->second.pop_back();
+    return ptr;
+  }
+
+  void putShared(size_t size, void* ptr) {
+    std::lock_guard<std::mutex> lock(free_mutex);
+    free_blocks[size].push_back(ptr);
+  }
+
+  void* newBlock(size_t size);
+  void releaseBlock(void* ptr);
+};
+
+// Never destroyed, so that the threads exiting after the static destructors
+// can still return their blocks.
+CachingAllocator& allocator() {
+  static CachingAllocator* instance = new CachingAllocator();
+  return *instance;
+}
+
+// Trivially destructible, so that it can be read during the destruction of
+// the other thread locals of an exiting thread.
+thread_local bool thread_cache_destroyed = false;
+
+struct ThreadCache {
+  std::vector<std::pair<size_t, void*>> blocks;
+  size_t bytes = 0;
+
+  void* take(size_t size) {
+    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+      if (it->first == size) {
+        void* ptr = it->second;
+        blocks.erase(it);
+        bytes -= size;
+        return ptr;
+      }
+    }
+    return NULL;
+  }
+
+  bool put(size_t size, void* ptr) {
+    if (blocks.size() >= kThreadCacheBlocks || bytes + size > kThreadCacheBytes) {
+      return false;
+    }
+    blocks.emplace_back(size, ptr);
+    bytes += size;
+    return true;
+  }
+
+  void flush() {
+    for (auto& block : blocks) {
+      allocator().putShared(block.first, block.second);
+    }
+    blocks.clear();
+    bytes = 0;
+  }
+
+  ~ThreadCache() {
+    flush();
+    thread_cache_destroyed = true;
+  }
+};
+
+ThreadCache* threadCache() {
+  if (thread_cache_destroyed) {
+    return NULL;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+void* CachingAllocator::newBlock(size_t size)
+{
+  void* ptr = NULL;
+  bool mapped = false;
+#ifdef __linux__
+  if (size >= kHugePageSize) {
+    if (use_hugetlb) {
+      ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (ptr == MAP_FAILED) {
+        ptr = NULL;
+      }
+    }
+    if (!ptr) {
+      // map an extra huge page to align the block on one
+      size_t mapped_size = size + kHugePageSize;
+      char* base = (char*)mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base != MAP_FAILED) {
+        char* aligned = (char*)(((uintptr_t)base + kHugePageSize - 1) & ~(kHugePageSize - 1));
+        if (aligned > base) {
+          munmap(base, aligned - base);
+        }
+        size_t tail = (base + mapped_size) - (aligned + size);
+        if (tail > 0) {
+          munmap(aligned + size, tail);
+        }
+        // a hint, which fails on kernels without transparent huge pages
+        madvise(aligned, size, MADV_HUGEPAGE);
+        ptr = aligned;
+      }
+    }
+    mapped = ptr != NULL;
+  }
+#endif
+  if (!ptr) {
+#ifndef _WIN32
+    if (posix_memalign(&ptr, kAlignment, size) != 0) {
+      ptr = NULL;
+    }
+#else
+    ptr = ::malloc(size);
+#endif
+  }
+  if (!ptr) {
+    return NULL;
+  }
+
+  Shard& shard = shardOf(ptr);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.blocks.insert({ptr, Block{size, mapped}});
+  num_blocks++;
+  return ptr;
+}
+
+void CachingAllocator::releaseBlock(void* ptr)
+{
+  Block block;
+  {
+    Shard& shard = shardOf(ptr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.blocks.find(ptr);
+    block = it->second;
+    shard.blocks.erase(it);
+    num_blocks--;
+  }
+  cached_bytes -= block.size;
+#ifdef __linux__
+  if (block.mapped) {
+    munmap(ptr, block.size);
+    return;
+  }
+#endif
+  ::free(ptr);
+}
+
+void* CachingAllocator::malloc(ptrdiff_t size)
+{
+  if (size < (ptrdiff_t)kMinCachedSize) {
+    return THAlloc(size);
+  }
+  size_t rounded = roundSize(size);
+
+  ThreadCache* cache = threadCache();
+  void* ptr = cache ? cache->take(rounded) : NULL;
+  if (!ptr) {
+    ptr = takeShared(rounded);
+  }
+  if (ptr) {
+    cached_bytes -= rounded;
+  } else {
+    ptr = newBlock(rounded);
+    if (!ptr) {
+      emptyCache();
+      ptr = newBlock(rounded);
+    }
+    if (!ptr) {
+      THError("$ Torch: not enough memory: you tried to allocate %dGB. Buy new RAM!",
+              (int)(size / 1073741824));
+    }
+  }
+  allocated_bytes += rounded;
+  return ptr;
+}
+
+void CachingAllocator::free(void* ptr)
+{
+  if (!ptr) {
+    return;
+  }
+  // memory allocated by THAlloc, while no block was ever allocated here
+  size_t size = num_blocks.load() > 0 ? blockSize(ptr) : 0;
+  if (size == 0) {
+    THFree(ptr);
+    return;
+  }
+  allocated_bytes -= size;
+  cached_bytes += size;
+  ThreadCache* cache = threadCache();
+  if (!cache || !cache->put(size, ptr)) {
+    putShared(size, ptr);
+  }
+}
+
+void* CachingAllocator::realloc(void* ptr, ptrdiff_t size)
+{
+  size_t old_size = ptr && num_blocks.load() > 0 ? blockSize(ptr) : 0;
+  if (old_size == 0) {
+    return THRealloc(ptr, size);
+  }
+  if (size == 0) {
+    free(ptr);
+    return NULL;
+  }
+  if (size >= (ptrdiff_t)kMinCachedSize && roundSize(size) == old_size) {
+    return ptr;
+  }
+  void* new_ptr = malloc(size);
+  memcpy(new_ptr, ptr, std::min(old_size, (size_t)size));
+  free(ptr);
+  return new_ptr;
+}
+
+void CachingAllocator::emptyCache()
+{
+  ThreadCache* cache = threadCache();
+  if (cache) {
+    cache->flush();
+  }
+  std::unordered_map<size_t, std::vector<void*>> blocks;
+  {
+    std::lock_guard<std::mutex> lock(free_mutex);
+    std::swap(blocks, free_blocks);
+  }
+  for (auto& size_blocks : blocks) {
+    for (void* ptr : size_blocks.second) {
+      releaseBlock(ptr);
+    }
+  }
+}
+
+void* THCachingAllocator_alloc(void* ctx, ptrdiff_t size)
+{
+  return allocator().malloc(size);
+}
+
+void* THCachingAllocator_realloc(void* ctx, void* ptr, ptrdiff_t size)
+{
+  return allocator().realloc(ptr, size);
+}
+
+void THCachingAllocator_free(void* ctx, void* ptr)
+{
+  allocator().free(ptr);
+}
+
+} // namespace
+
+THAllocator THCachingAllocator = {
+  &THCachingAllocator_alloc,
+  &THCachingAllocator_realloc,
+  &THCachingAllocator_free
+};
+
+void THCachingAllocator_setEnabled(int enabled)
+{
+  allocator().enabled = enabled ? 1 : 0;
+}
+
+int THCachingAllocator_enabled(void)
+{
+  return allocator().isEnabled();
+}
+
+void THCachingAllocator_emptyCache(void)
+{
+  allocator().emptyCache();
+}
+
+size_t THCachingAllocator_cachedBytes(void)
+{
+  return allocator().cached_bytes.load();
+}
+
+size_t THCachingAllocator_allocatedBytes(void)
+{
+  return allocator().allocated_bytes.load();
+}
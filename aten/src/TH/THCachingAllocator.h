@@ -0,0 +1,37 @@
+#ifndef TH_CACHING_ALLOCATOR_INC
+#define TH_CACHING_ALLOCATOR_INC
+
+#include "THAllocator.h"
+
+/*
+ * A caching allocator for CPU memory, the counterpart of THCCachingAllocator.
+ *
+ * Allocations of 256KB or more are rounded up to a size class (a power of
+ * two below 2MB, a multiple of 2MB above) and freed blocks are kept and
+ * reused by allocations of the same class, so that large tensors allocated
+ * at every iteration don't fault their pages in again. Blocks of 2MB or
+ * more are mapped at a 2MB alignment and backed by transparent huge pages,
+ * or by explicit huge pages (MAP_HUGETLB) when TH_CACHING_ALLOCATOR_HUGETLB=1
+ * and the system has some reserved. Each thread keeps a few freed blocks for
+ * itself before returning them to the shared free lists. Smaller allocations
+ * go to THAlloc.
+ *
+ * THDefaultAllocator, which backs the CPU storages, allocates from it once
+ * it is enabled, with THCachingAllocator_setEnabled or by setting
+ * TH_CACHING_ALLOCATOR=1. Memory allocated before that is still freed with
+ * THFree. Cached memory is only returned to the system by
+ * THCachingAllocator_emptyCache.
+ */
+TH_API THAllocator THCachingAllocator;
+
+TH_API void THCachingAllocator_setEnabled(int enabled);
+TH_API int THCachingAllocator_enabled(void);
+
+/* releases the free blocks of the shared lists and of the calling thread */
+TH_API void THCachingAllocator_emptyCache(void);
+
+/* size of the free blocks held by the allocator, and of the blocks in use */
+TH_API size_t THCachingAllocator_cachedBytes(void);
+TH_API size_t THCachingAllocator_allocatedBytes(void);
+
+#endif
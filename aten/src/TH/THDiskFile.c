@@ -1,9 +1,25 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "THGeneral.h"
 #include "THDiskFile.h"
 #include "THFilePrivate.h"
 
 #ifndef _WIN32
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__linux__) && defined(O_DIRECT)
+#define TH_DISK_FILE_HAS_DIRECT_IO
 #endif
 
 #include <stdint.h>
@@ -19,6 +35,8 @@ typedef struct THDiskFile__
     char *name;
     int isNativeEncoding;
     int longSize;
+    int isRegularFile;
+    int directFd;
 
 } THDiskFile;
 
@@ -47,6 +65,138 @@ size_t fread__(void *ptr, size_t size, size_t nitems, FILE *stream)
 #define fread__ fread
 #endif
 
+#ifndef _WIN32
+/* Binary reads of at least this many bytes skip stdio: they are read with
+   pread straight into the destination, in chunks of TH_DISK_FILE_CHUNK_SIZE
+   that OpenMP threads read in parallel */
+#define TH_DISK_FILE_PREAD_SIZE (1L << 20)
+#define TH_DISK_FILE_CHUNK_SIZE (4L << 20)
+/* how much the kernel is asked to read ahead past such a read, so that the
+   next records are in the page cache by the time they are read */
+#define TH_DISK_FILE_READAHEAD_SIZE (16L << 20)
+/* the alignment of the buffers, offsets and sizes of O_DIRECT reads */
+#define TH_DISK_FILE_DIRECT_ALIGNMENT 4096
+
+/* Reads size bytes at offset, fewer only at the end of the file or on error */
+static size_t THDiskFile_preadFully(int fd, char *data, size_t size, off_t offset)
+{
+  size_t nread = 0;
+  while(nread < size)
+  {
+    ssize_t ret = pread(fd, data+nread, size-nread, offset+nread);
+    if(ret < 0 && errno == EINTR)
+      continue;
+    if(ret <= 0)
+      break;
+    nread += ret;
+  }
+  return nread;
+}
+
+/* Reads the size bytes at offset into data. With O_DIRECT, data is read into
+   directly when it is aligned like the file, otherwise the blocks around the
+   chunk are read into buffer and copied. What O_DIRECT fails to read (e.g. a
+   file system refusing it) is read through the page cache. */
+static size_t THDiskFile_readChunk(THDiskFile *dfself, char *data, size_t size, off_t offset, char *buffer)
+{
+  size_t nread = 0;
+#ifdef TH_DISK_FILE_HAS_DIRECT_IO
+  if(dfself->directFd >= 0 && buffer != NULL)
+  {
+    const size_t alignment = TH_DISK_FILE_DIRECT_ALIGNMENT;
+    size_t head = offset % alignment;
+    if(head == 0 && size % alignment == 0 && (uintptr_t)data % alignment == 0)
+      nread = THDiskFile_preadFully(dfself->directFd, data, size, offset);
+    else
+    {
+      size_t blocks = (head + size + alignment - 1) / alignment * alignment;
+      size_t got = THDiskFile_preadFully(dfself->directFd, buffer, blocks, offset - head);
+      if(got > head)
+      {
+        nread = THMin(got - head, size);
+        memcpy(data, buffer + head, nread);
+      }
+    }
+  }
+#endif
+  if(nread < size)
+    nread += THDiskFile_preadFully(fileno(dfself->handle), data + nread, size - nread, offset + nread);
+  return nread;
+}
+#endif
+
+/* Reads n blocks of blockSize bytes like fread does. Large reads of regular
+   files skip the stdio buffer (see TH_DISK_FILE_PREAD_SIZE), and leave the
+   stream positioned after what was read. */
+static size_t THDiskFile_readBlocks(THDiskFile *dfself, void *data, size_t blockSize, size_t n)
+{
+#ifndef _WIN32
+  size_t size = blockSize*n;
+  off_t position;
+  off_t first;
+  int64_t nchunks, i;
+  size_t *nreads;
+  size_t nread = 0;
+
+  if(!dfself->isRegularFile || size < TH_DISK_FILE_PREAD_SIZE)
+    return fread__(data, blockSize, n, dfself->handle);
+
+  /* pending writes must be in the file before it is read around stdio */
+  if(dfself->file.isWritable)
+    fflush(dfself->handle);
+  position = ftello(dfself->handle);
+  if(position < 0)
+    return fread__(data, blockSize, n, dfself->handle);
+
+  /* the chunks are aligned in the file, except for the first and last ones */
+  first = position / TH_DISK_FILE_CHUNK_SIZE * TH_DISK_FILE_CHUNK_SIZE;
+  nchunks = (position - first + size + TH_DISK_FILE_CHUNK_SIZE - 1) / TH_DISK_FILE_CHUNK_SIZE;
+  nreads = THAlloc(sizeof(size_t)*nchunks);
+#ifdef _OPENMP
+#pragma omp parallel if(nchunks > 1 && !omp_in_parallel())
+#endif
+  {
+    char *buffer = NULL;
+#ifdef TH_DISK_FILE_HAS_DIRECT_IO
+    if(dfself->directFd >= 0 &&
+       posix_memalign((void**)&buffer, TH_DISK_FILE_DIRECT_ALIGNMENT,
+                      TH_DISK_FILE_CHUNK_SIZE + 2*TH_DISK_FILE_DIRECT_ALIGNMENT) != 0)
+      buffer = NULL;
+#endif
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for(i = 0; i < nchunks; i++)
+    {
+      off_t begin = THMax(position, first + i*TH_DISK_FILE_CHUNK_SIZE);
+      off_t end = THMin((off_t)(position + size), first + (i+1)*TH_DISK_FILE_CHUNK_SIZE);
+      nreads[i] = THDiskFile_readChunk(dfself, (char*)data + (begin - position), end - begin, begin, buffer);
+    }
+    free(buffer);
+  }
+
+  /* like fread, what follows a short chunk doesn't count */
+  for(i = 0; i < nchunks; i++)
+  {
+    off_t begin = THMax(position, first + i*TH_DISK_FILE_CHUNK_SIZE);
+    off_t end = THMin((off_t)(position + size), first + (i+1)*TH_DISK_FILE_CHUNK_SIZE);
+    nread += nreads[i];
+    if(nreads[i] < (size_t)(end - begin))
+      break;
+  }
+  THFree(nreads);
+
+  fseeko(dfself->handle, position + nread, SEEK_SET);
+#ifdef POSIX_FADV_WILLNEED
+  if(dfself->directFd < 0)
+    posix_fadvise(fileno(dfself->handle), position + nread, TH_DISK_FILE_READAHEAD_SIZE, POSIX_FADV_WILLNEED);
+#endif
+  return nread / blockSize;
+#else
+  return fread__(data, blockSize, n, dfself->handle);
+#endif
+}
+
 #define READ_WRITE_METHODS(TYPE, TYPEC, ASCII_READ_ELEM, ASCII_WRITE_ELEM) \
   static size_t THDiskFile_read##TYPEC(THFile *self, TYPE *data, size_t n)  \
   {                                                                     \
@@ -58,7 +208,7 @@ size_t fread__(void *ptr, size_t size, size_t nitems, FILE *stream)
                                                                         \
     if(dfself->file.isBinary)                                           \
     {                                                                   \
-      nread = fread__(data, sizeof(TYPE), n, dfself->handle);           \
+      nread = THDiskFile_readBlocks(dfself, data, sizeof(TYPE), n);     \
       if(!dfself->isNativeEncoding && (sizeof(TYPE) > 1) && (nread > 0)) \
         THDiskFile_reverseMemory(data, data, sizeof(TYPE), nread);      \
     }                                                                   \
@@ -242,6 +392,11 @@ static void THDiskFile_close(THFile *self)
   THArgCheck(dfself->handle != NULL, 1, "attempt to use a closed file");
   fclose(dfself->handle);
   dfself->handle = NULL;
+#ifndef _WIN32
+  if(dfself->directFd >= 0)
+    close(dfself->directFd);
+  dfself->directFd = -1;
+#endif
 }
 
 /* Little and Big Endian */
@@ -324,11 +479,27 @@ void THDiskFile_noBuffer(THFile *self)
   }
 }
 
+/* Makes the large binary reads (see THDiskFile_readBlocks) use O_DIRECT,
+   bypassing the page cache. Returns 0 where O_DIRECT isn't available, in
+   which case they keep going through the page cache. */
+int THDiskFile_directIO(THFile *self)
+{
+  THDiskFile *dfself = (THDiskFile*)(self);
+  THArgCheck(dfself->handle != NULL, 1, "attempt to use a closed file");
+#ifdef TH_DISK_FILE_HAS_DIRECT_IO
+  if(dfself->directFd < 0 && dfself->isRegularFile)
+    dfself->directFd = open(dfself->name, O_RDONLY | O_DIRECT);
+  return dfself->directFd >= 0;
+#else
+  return 0;
+#endif
+}
+
 static void THDiskFile_free(THFile *self)
 {
   THDiskFile *dfself = (THDiskFile*)(self);
   if(dfself->handle)
-    fclose(dfself->handle);
+    THDiskFile_close(self);
   THFree(dfself->name);
   THFree(dfself);
 }
@@ -381,12 +552,12 @@ static size_t THDiskFile_readLong(THFile *self, int64_t *data, size_t n)
   {
     if(dfself->longSize == 0 || dfself->longSize == sizeof(int64_t))
     {
-      nread = fread__(data, sizeof(int64_t), n, dfself->handle);
+      nread = THDiskFile_readBlocks(dfself, data, sizeof(int64_t), n);
       if(!dfself->isNativeEncoding && (sizeof(int64_t) > 1) && (nread > 0))
         THDiskFile_reverseMemory(data, data, sizeof(int64_t), nread);
     } else if(dfself->longSize == 4)
     {
-      nread = fread__(data, 4, n, dfself->handle);
+      nread = THDiskFile_readBlocks(dfself, data, 4, n);
       if(!dfself->isNativeEncoding && (nread > 0))
         THDiskFile_reverseMemory(data, data, 4, nread);
       size_t i;
@@ -397,7 +568,7 @@ static size_t THDiskFile_readLong(THFile *self, int64_t *data, size_t n)
     {
       int big_endian = !THDiskFile_isLittleEndianCPU();
       int32_t *buffer = THAlloc(8*n);
-      nread = fread__(buffer, 8, n, dfself->handle);
+      nread = THDiskFile_readBlocks(dfself, buffer, 8, n);
       size_t i;
       for(i = nread; i > 0; i--)
         data[i-1] = buffer[2*(i-1) + big_endian];
@@ -684,6 +855,18 @@ THFile *THDiskFile_new(const char *name, const char *mode, int isQuiet)
   strcpy(self->name, name);
   self->isNativeEncoding = 1;
   self->longSize = 0;
+  self->isRegularFile = 0;
+  self->directFd = -1;
+#ifndef _WIN32
+  {
+    struct stat st;
+    self->isRegularFile = (fstat(fileno(handle), &st) == 0) && S_ISREG(st.st_mode);
+  }
+#ifdef POSIX_FADV_SEQUENTIAL
+  if(self->isRegularFile && !isWritable)
+    posix_fadvise(fileno(handle), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
 
   self->file.vtable = &vtable;
   self->file.isQuiet = isQuiet;
@@ -788,6 +971,8 @@ THFile *THPipeFile_new(const char *name, const char *mode, int isQuiet)
   strcpy(self->name, name);
   self->isNativeEncoding = 1;
   self->longSize = 0;
+  self->isRegularFile = 0;
+  self->directFd = -1;
 
   self->file.vtable = &vtable;
   self->file.isQuiet = isQuiet;
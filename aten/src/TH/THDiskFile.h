@@ -15,5 +15,6 @@ TH_API void THDiskFile_littleEndianEncoding(THFile *self);
 TH_API void THDiskFile_bigEndianEncoding(THFile *self);
 TH_API void THDiskFile_longSize(THFile *self, int size);
 TH_API void THDiskFile_noBuffer(THFile *self);
+TH_API int THDiskFile_directIO(THFile *self);
 
 #endif
@@ -1,3 +1,7 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "THGeneral.h"
 #include "THAtomic.h"
 
@@ -21,6 +25,13 @@
 #include <malloc/malloc.h>
 #endif
 
+#ifdef __linux__
+#include <sched.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #ifdef TH_BLAS_MKL
 // this is the C prototype, while mkl_set_num_threads is the fortran prototype
 extern void MKL_Set_Num_Threads(int);
@@ -159,6 +170,149 @@ void THSetGCHandler( void (*torchGCFunction_)(void *data), void *data )
   torchGCData = data;
 }
 
+/* NUMA placement */
+static int numaPolicy = TH_NUMA_DEFAULT;
+static __thread int threadNumaNode = -1;
+
+/* smaller allocations likely reuse pages that were already touched */
+#define TH_NUMA_MIN_SIZE (1 << 20)
+
+#ifdef __linux__
+/* from numaif.h, which is part of libnuma */
+#define TH_MPOL_PREFERRED  1
+#define TH_MPOL_INTERLEAVE 3
+#define TH_NUMA_MAX_NODES  64
+
+static int numNumaNodes = 0;
+
+static int numaNodeCount(void)
+{
+  if (numNumaNodes == 0) {
+    char path[64];
+    int n = 0;
+    while (n < TH_NUMA_MAX_NODES) {
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", n);
+      if (access(path, F_OK) != 0)
+        break;
+      n++;
+    }
+    numNumaNodes = n > 0 ? n : 1;
+  }
+  return numNumaNodes;
+}
+
+static void numaPlace(void *ptr, ptrdiff_t size)
+{
+  int policy = numaPolicy;
+  if (policy == TH_NUMA_DEFAULT || size < TH_NUMA_MIN_SIZE || numaNodeCount() < 2)
+    return;
+
+  /* only the pages which belong to this allocation alone */
+  uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+  uintptr_t start = ((uintptr_t)ptr + page - 1) & ~(page - 1);
+  uintptr_t end = ((uintptr_t)ptr + size) & ~(page - 1);
+  if (end <= start)
+    return;
+
+  unsigned long mask = 0;
+  int mode;
+  if (policy == TH_NUMA_INTERLEAVE) {
+    mode = TH_MPOL_INTERLEAVE;
+    mask = numaNodeCount() == TH_NUMA_MAX_NODES ? ~0UL : (1UL << numaNodeCount()) - 1;
+  } else {
+    int node = threadNumaNode;
+    if (node < 0) {
+      unsigned cpu, cpu_node;
+      if (syscall(SYS_getcpu, &cpu, &cpu_node, NULL) != 0)
+        return;
+      node = (int)cpu_node;
+    }
+    mode = TH_MPOL_PREFERRED;
+    mask = 1UL << node;
+  }
+  /* the policy is a hint for the pages not touched yet, ignore failures */
+  syscall(SYS_mbind, (void*)start, (unsigned long)(end - start), mode,
+          &mask, (unsigned long)TH_NUMA_MAX_NODES + 1, 0);
+}
+
+static int readNodeCpus(int node, cpu_set_t *cpus)
+{
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return 0;
+  CPU_ZERO(cpus);
+  /* ranges like "0-15,32-47" */
+  int first, last;
+  char sep;
+  while (fscanf(f, "%d", &first) == 1) {
+    last = first;
+    if (fscanf(f, "%c", &sep) == 1 && sep == '-') {
+      if (fscanf(f, "%d", &last) != 1)
+        break;
+      if (fscanf(f, "%c", &sep) != 1)
+        sep = '\n';
+    }
+    for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+      CPU_SET(cpu, cpus);
+    if (sep != ',')
+      break;
+  }
+  fclose(f);
+  return CPU_COUNT(cpus) > 0;
+}
+#endif
+
+void THSetNumaPolicy(int policy)
+{
+  THArgCheck(policy == TH_NUMA_DEFAULT || policy == TH_NUMA_LOCAL ||
+             policy == TH_NUMA_INTERLEAVE, 1, "unknown NUMA policy %d", policy);
+  numaPolicy = policy;
+}
+
+int THGetNumaPolicy(void)
+{
+  return numaPolicy;
+}
+
+void THSetNumaNode(int node)
+{
+  THArgCheck(node < THGetNumNumaNodes(), 1, "NUMA node %d is unavailable", node);
+  threadNumaNode = node < 0 ? -1 : node;
+}
+
+int THGetNumNumaNodes(void)
+{
+#ifdef __linux__
+  return numaNodeCount();
+#else
+  return 1;
+#endif
+}
+
+void THBindThreadsToNumaNode(int node)
+{
+  THArgCheck(node >= 0 && node < THGetNumNumaNodes(), 1,
+             "NUMA node %d is unavailable", node);
+#ifdef __linux__
+  cpu_set_t cpus;
+  if (!readNodeCpus(node, &cpus))
+    THError("cannot read the cpus of NUMA node %d", node);
+  if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+    THError("cannot bind the thread to NUMA node %d", node);
+  threadNumaNode = node;
+#ifdef _OPENMP
+  /* the threads of the pool already exist, and don't inherit the affinity */
+  #pragma omp parallel
+  {
+    sched_setaffinity(0, sizeof(cpus), &cpus);
+    threadNumaNode = node;
+  }
+#endif
+#endif
+}
+
 /* it is guaranteed the allocated size is not bigger than PTRDIFF_MAX */
 static ptrdiff_t getAllocSize(void *ptr) {
 #if defined(__unix) && defined(HAVE_MALLOC_USABLE_SIZE)
@@ -217,6 +371,10 @@ void* THAlloc(ptrdiff_t size)
   if(!ptr)
     THError("$ Torch: not enough memory: you tried to allocate %dGB. Buy new RAM!", size/1073741824);
 
+#ifdef __linux__
+  numaPlace(ptr, size);
+#endif
+
   return ptr;
 }
 
@@ -0,0 +1,25 @@
+#ifndef TH_GENERIC_FILE
+#error "You must define TH_GENERIC_FILE before including THGenerateBFloat16Type.h"
+#endif
+
+#include "THBFloat16.h"
+#define real THBFloat16
+#define accreal float
+#define TH_CONVERT_REAL_TO_ACCREAL(_val) TH_bfloat162float(_val)
+#define TH_CONVERT_ACCREAL_TO_REAL(_val) TH_float2bfloat16(_val)
+#define Real BFloat16
+#define THInf TH_BFLOAT16_BITS_TO_LITERAL(TH_BFLOAT16_INF)
+#define TH_REAL_IS_BFLOAT16
+#line 1 TH_GENERIC_FILE
+#include TH_GENERIC_FILE
+#undef real
+#undef accreal
+#undef Real
+#undef THInf
+#undef TH_REAL_IS_BFLOAT16
+#undef TH_CONVERT_REAL_TO_ACCREAL
+#undef TH_CONVERT_ACCREAL_TO_REAL
+
+#ifndef THGenerateManyTypes
+#undef TH_GENERIC_FILE
+#endif
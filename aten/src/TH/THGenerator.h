@@ -18,6 +18,10 @@ struct THGeneratorState {
   double normal_y;
   double normal_rho;
   int normal_is_valid; /* = 0; */
+
+  /* The next block of the Philox stream of the_initial_seed. States saved
+     before it was added end before it. */
+  uint64_t philox_offset;
 };
 
 /* A THGenerator contains all the state required for a single random number stream */
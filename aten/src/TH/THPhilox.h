@@ -0,0 +1,62 @@
+#ifndef TH_PHILOX_INC
+#define TH_PHILOX_INC
+
+#include <stdint.h>
+
+/* The Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+   numbers: as easy as 1, 2, 3", SC 2011). Block #counter# of the stream of
+   key #seed# is a pure function of both, so that any range of a stream can
+   be generated independently: by another thread, or out of order. */
+
+#define TH_PHILOX_M0 0xD2511F53U
+#define TH_PHILOX_M1 0xCD9E8D57U
+#define TH_PHILOX_W0 0x9E3779B9U
+#define TH_PHILOX_W1 0xBB67AE85U
+
+static inline uint32_t THPhilox_mulhilo(uint32_t a, uint32_t b, uint32_t *hi)
+{
+  uint64_t product = (uint64_t)a * b;
+  *hi = (uint32_t)(product >> 32);
+  return (uint32_t)product;
+}
+
+/* Sets out to the 4 x 32 random bits of block #counter# */
+static inline void THPhilox_block(uint64_t seed, uint64_t counter, uint32_t out[4])
+{
+  uint32_t c0 = (uint32_t)counter, c1 = (uint32_t)(counter >> 32), c2 = 0, c3 = 0;
+  uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+  int round;
+  for (round = 0; round < 10; round++) {
+    uint32_t hi0, hi1;
+    uint32_t lo0 = THPhilox_mulhilo(TH_PHILOX_M0, c0, &hi0);
+    uint32_t lo1 = THPhilox_mulhilo(TH_PHILOX_M1, c2, &hi1);
+    c0 = hi1 ^ c1 ^ k0;
+    c1 = lo1;
+    c2 = hi0 ^ c3 ^ k1;
+    c3 = lo0;
+    k0 += TH_PHILOX_W0;
+    k1 += TH_PHILOX_W1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+/* The uniform doubles on [0,1) of the two 64 bit halves of a block, with the
+   53 bits of mantissa of THRandom_standard_uniform */
+static inline void THPhilox_uniform2(const uint32_t block[4], double *x, double *y)
+{
+  const uint64_t mask = (1ULL << 53) - 1;
+  const double divisor = 1.0 / (1ULL << 53);
+  *x = ((((uint64_t)block[1] << 32) | block[0]) & mask) * divisor;
+  *y = ((((uint64_t)block[3] << 32) | block[2]) & mask) * divisor;
+}
+
+/* The uniform float on [0,1) of a 32 bit word, with 24 bits of mantissa */
+static inline float THPhilox_uniformFloat(uint32_t word)
+{
+  return (word & ((1U << 24) - 1)) * (1.0f / (1U << 24));
+}
+
+#endif
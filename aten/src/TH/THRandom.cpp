@@ -175,6 +175,13 @@ uint64_t THRandom_initialSeed(THGenerator *_generator)
   return _generator->gen_state.the_initial_seed;
 }
 
+uint64_t THRandom_philoxOffset(THGenerator *_generator, uint64_t blocks)
+{
+  uint64_t offset = _generator->gen_state.philox_offset;
+  _generator->gen_state.philox_offset += blocks;
+  return offset;
+}
+
 void THRandom_nextState(THGenerator *_generator)
 {
   uint64_t *p = _generator->gen_state.state;
@@ -37,6 +37,10 @@ TH_API void THRandom_manualSeed(THGenerator *_generator, uint64_t the_seed_);
 /* Returns the starting seed used. */
 TH_API uint64_t THRandom_initialSeed(THGenerator *_generator);
 
+/* Reserves #blocks# blocks of the Philox4x32-10 stream of the initial seed (see
+THPhilox.h) and returns the first. */
+TH_API uint64_t THRandom_philoxOffset(THGenerator *_generator, uint64_t blocks);
+
 /* Generates a uniform 32 bits integer. */
 TH_API uint64_t THRandom_random(THGenerator *_generator);
 
@@ -0,0 +1,70 @@
+#include "THSmallAlloc.h"
+
+namespace {
+
+const ptrdiff_t kSizeClass = 16;
+const ptrdiff_t kMaxSize = 256;
+const int kNumClasses = kMaxSize / kSizeClass;
+const int kMaxBlocks = 64;  // free blocks kept by a thread, per class
+
+thread_local bool free_lists_destroyed = false;
+
+struct FreeLists {
+  void* blocks[kNumClasses][kMaxBlocks];
+  int count[kNumClasses] = {};
+
+  ~FreeLists() {
+    for (int c = 0; c < kNumClasses; c++) {
+      for (int i = 0; i < count[c]; i++) {
+        THFree(blocks[c][i]);
+      }
+    }
+    free_lists_destroyed = true;
+  }
+};
+
+// NULL once the lists of the thread are destroyed, as blocks are still
+// freed by the destructors of static tensors
+FreeLists* freeLists() {
+  if (free_lists_destroyed) {
+    return NULL;
+  }
+  static thread_local FreeLists lists;
+  return &lists;
+}
+
+bool isSmall(ptrdiff_t size) {
+  return size > 0 && size <= kMaxSize;
+}
+
+int sizeClass(ptrdiff_t size) {
+  return static_cast<int>((size - 1) / kSizeClass);
+}
+
+} // anonymous namespace
+
+void *THSmallAlloc(ptrdiff_t size)
+{
+  if (!isSmall(size)) {
+    return THAlloc(size);
+  }
+  int c = sizeClass(size);
+  FreeLists* lists = freeLists();
+  if (lists && lists->count[c] > 0) {
+    return lists->blocks[c][--lists->count[c]];
+  }
+  return THAlloc((c + 1) * kSizeClass);
+}
+
+void THSmallFree(void *ptr, ptrdiff_t size)
+{
+  if (ptr && isSmall(size)) {
+    int c = sizeClass(size);
+    FreeLists* lists = freeLists();
+    if (lists && lists->count[c] < kMaxBlocks) {
+      lists->blocks[c][lists->count[c]++] = ptr;
+      return;
+    }
+  }
+  THFree(ptr);
+}
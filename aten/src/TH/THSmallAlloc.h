@@ -0,0 +1,20 @@
+#ifndef TH_SMALL_ALLOC_INC
+#define TH_SMALL_ALLOC_INC
+
+#include "THGeneral.h"
+
+/*
+ * Allocation of the small structs created with every tensor: THTensor,
+ * THStorage and the ATen TensorImpl.
+ *
+ * Each thread keeps up to 64 freed blocks of each size class (multiples of
+ * 16 bytes, up to 256) and reuses them for its next allocations of the
+ * class, which then take no call to malloc. A block may be freed by another
+ * thread than the one which allocated it. Larger sizes, and blocks freed
+ * when the cache of their class is full, go to THAlloc and THFree. The size
+ * passed to THSmallFree must be the size passed to THSmallAlloc.
+ */
+TH_API void *THSmallAlloc(ptrdiff_t size);
+TH_API void THSmallFree(void *ptr, ptrdiff_t size);
+
+#endif
@@ -17,12 +17,18 @@
 #include "generic/THStorage.h"
 #include "THGenerateHalfType.h"
 
+#include "generic/THStorage.h"
+#include "THGenerateBFloat16Type.h"
+
 #include "generic/THStorageCopy.h"
 #include "THGenerateAllTypes.h"
 
 #include "generic/THStorageCopy.h"
 #include "THGenerateHalfType.h"
 
+#include "generic/THStorageCopy.h"
+#include "THGenerateBFloat16Type.h"
+
 TH_API THDescBuff THLongStorage_sizeDesc(const THLongStorage *size);
 TH_API THLongStorage *THLongStorage_newInferSize(THLongStorage *size, ptrdiff_t nElement);
 
@@ -2,6 +2,7 @@
 #include <float.h>
 
 #include "THAtomic.h"
+#include "THSmallAlloc.h"
 #include "THTensor.h"
 #include "THVector.h"
 #include "generic/simd/simd.h"
@@ -18,12 +19,18 @@
 #include "generic/THTensor.cpp"
 #include "THGenerateHalfType.h"
 
+#include "generic/THTensor.cpp"
+#include "THGenerateBFloat16Type.h"
+
 #include "generic/THTensorCopy.c"
 #include "THGenerateAllTypes.h"
 
 #include "generic/THTensorCopy.c"
 #include "THGenerateHalfType.h"
 
+#include "generic/THTensorCopy.c"
+#include "THGenerateBFloat16Type.h"
+
 #include "generic/THTensorRandom.cpp"
 #include "THGenerateAllTypes.h"
 
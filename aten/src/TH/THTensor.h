@@ -17,12 +17,18 @@ extern "C" {
 #include "generic/THTensor.h"
 #include "THGenerateHalfType.h"
 
+#include "generic/THTensor.h"
+#include "THGenerateBFloat16Type.h"
+
 #include "generic/THTensorCopy.h"
 #include "THGenerateAllTypes.h"
 
 #include "generic/THTensorCopy.h"
 #include "THGenerateHalfType.h"
 
+#include "generic/THTensorCopy.h"
+#include "THGenerateBFloat16Type.h"
+
 #include "THTensorMacros.h"
 
 /* random numbers */
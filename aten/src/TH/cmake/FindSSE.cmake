@@ -1,5 +1,6 @@
 INCLUDE(CheckCSourceRuns)
 INCLUDE(CheckCXXSourceRuns)
+INCLUDE(CheckCXXSourceCompiles)
 
 SET(SSE1_CODE "
   #include <xmmintrin.h>
@@ -79,6 +80,17 @@ SET(AVX2_CODE "
   }
 ")
 
+SET(AVX512_CODE "
+  #include <immintrin.h>
+
+  int main()
+  {
+    __m512 a = _mm512_set1_ps(0);
+    a = _mm512_roundscale_ps(a, 0);
+    return 0;
+  }
+")
+
 MACRO(CHECK_SSE lang type flags)
   SET(__FLAG_I 1)
   SET(CMAKE_REQUIRED_FLAGS_SAVE ${CMAKE_REQUIRED_FLAGS})
@@ -123,3 +135,32 @@ CHECK_SSE(CXX "SSE4_1" " ;-msse4.1;-msse4;/arch:SSE4")
 CHECK_SSE(CXX "SSE4_2" " ;-msse4.2;-msse4;/arch:SSE4")
 CHECK_SSE(CXX "AVX" " ;-mavx;/arch:AVX")
 CHECK_SSE(CXX "AVX2" " ;-mavx2 -mfma;/arch:AVX2")
+
+# The AVX512 ATen kernels are only picked at runtime on CPUs supporting them,
+# so unlike the checks above this one doesn't require the build machine to
+# run AVX512 code.
+MACRO(CHECK_CXX_AVX512 flags)
+  SET(CMAKE_REQUIRED_FLAGS_SAVE ${CMAKE_REQUIRED_FLAGS})
+  SET(__FLAG_I 1)
+  FOREACH(__FLAG ${flags})
+    IF(NOT CXX_AVX512_FOUND)
+      SET(CMAKE_REQUIRED_FLAGS ${__FLAG})
+      CHECK_CXX_SOURCE_COMPILES("${AVX512_CODE}" CXX_HAS_AVX512_${__FLAG_I})
+      IF(CXX_HAS_AVX512_${__FLAG_I})
+        SET(CXX_AVX512_FOUND TRUE CACHE BOOL "CXX AVX512 support")
+        SET(CXX_AVX512_FLAGS "${__FLAG}" CACHE STRING "CXX AVX512 flags")
+      ENDIF()
+      MATH(EXPR __FLAG_I "${__FLAG_I}+1")
+    ENDIF()
+  ENDFOREACH()
+  SET(CMAKE_REQUIRED_FLAGS ${CMAKE_REQUIRED_FLAGS_SAVE})
+
+  IF(NOT CXX_AVX512_FOUND)
+    SET(CXX_AVX512_FOUND FALSE CACHE BOOL "CXX AVX512 support")
+    SET(CXX_AVX512_FLAGS "" CACHE STRING "CXX AVX512 flags")
+  ENDIF()
+
+  MARK_AS_ADVANCED(CXX_AVX512_FOUND CXX_AVX512_FLAGS)
+ENDMACRO()
+
+CHECK_CXX_AVX512("-mavx512f;/arch:AVX512")
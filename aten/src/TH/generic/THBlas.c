@@ -36,6 +36,15 @@ TH_EXTERNC void dger_(int *m, int *n, double *alpha, double *x, int *incx, doubl
 TH_EXTERNC void sger_(int *m, int *n, float *alpha, float *x, int *incx, float *y, int *incy, float *a, int *lda);
 TH_EXTERNC void dgemm_(char *transa, char *transb, int *m, int *n, int *k, double *alpha, double *a, int *lda, double *b, int *ldb, double *beta, double *c, int *ldc);
 TH_EXTERNC void sgemm_(char *transa, char *transb, int *m, int *n, int *k, float *alpha, float *a, int *lda, float *b, int *ldb, float *beta, float *c, int *ldc);
+#ifdef TH_BLAS_MKL
+/* the CBLAS enums of the layout and the transpositions are passed as ints */
+TH_EXTERNC void cblas_dgemm_batch(int layout, const int *transa, const int *transb, const int *m, const int *n, const int *k, const double *alpha, const double **a, const int *lda, const double **b, const int *ldb, const double *beta, double **c, const int *ldc, int group_count, const int *group_size);
+TH_EXTERNC void cblas_sgemm_batch(int layout, const int *transa, const int *transb, const int *m, const int *n, const int *k, const float *alpha, const float **a, const int *lda, const float **b, const int *ldb, const float *beta, float **c, const int *ldc, int group_count, const int *group_size);
+#ifndef THBlas_CBLAS_ENUMS_
+#define THBlas_CBLAS_ENUMS_
+enum { THBlas_CblasColMajor = 102, THBlas_CblasNoTrans = 111, THBlas_CblasTrans = 112 };
+#endif
+#endif
 
 
 
@@ -432,4 +441,64 @@ void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, re
   }
 }
 
+void THBlas_(gemmBatched)(char transa, char transb, int64_t m, int64_t n, int64_t k, real alpha, real **a, int64_t lda, real **b, int64_t ldb, real beta, real **c, int64_t ldc, int64_t batchCount)
+{
+  int64_t i;
+#if defined(TH_BLAS_MKL) && (defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT))
+  int transa_ = ((transa == 't') || (transa == 'T'));
+  int transb_ = ((transb == 't') || (transb == 'T'));
+  /* the same degenerate leading dimensions as gemm */
+  if(n == 1)
+    ldc = m;
+  if(transa_ ? m == 1 : k == 1)
+    lda = transa_ ? k : m;
+  if(transb_ ? k == 1 : n == 1)
+    ldb = transb_ ? n : k;
+
+  if( (m <= INT_MAX) && (n <= INT_MAX) && (k <= INT_MAX) &&
+      (lda <= INT_MAX) && (ldb <= INT_MAX) && (ldc <= INT_MAX) &&
+      (batchCount <= INT_MAX) )
+  {
+    THArgCheck(lda >= THMax(1, (transa_ ? k : m)), 8,
+      "lda should be at least max(1, %d), but have %d", (transa_ ? k : m), lda);
+    THArgCheck(ldb >= THMax(1, (transb_ ? n : k)), 10,
+      "ldb should be at least max(1, %d), but have %d", (transb_ ? n : k), ldb);
+    THArgCheck(ldc >= THMax(1, m), 13,
+      "ldc should be at least max(1, m=%d), but have %d", m, ldc);
+    int i_transa = transa_ ? THBlas_CblasTrans : THBlas_CblasNoTrans;
+    int i_transb = transb_ ? THBlas_CblasTrans : THBlas_CblasNoTrans;
+    int i_m = (int)m;
+    int i_n = (int)n;
+    int i_k = (int)k;
+    int i_lda = (int)lda;
+    int i_ldb = (int)ldb;
+    int i_ldc = (int)ldc;
+    int i_batchCount = (int)batchCount;
+
+    /* a single group of batchCount products of the same shape */
+#if defined(TH_REAL_IS_DOUBLE)
+    cblas_dgemm_batch(THBlas_CblasColMajor, &i_transa, &i_transb, &i_m, &i_n, &i_k,
+      &alpha, (const double **)a, &i_lda, (const double **)b, &i_ldb,
+      &beta, c, &i_ldc, 1, &i_batchCount);
+#else
+    cblas_sgemm_batch(THBlas_CblasColMajor, &i_transa, &i_transb, &i_m, &i_n, &i_k,
+      &alpha, (const float **)a, &i_lda, (const float **)b, &i_ldb,
+      &beta, c, &i_ldc, 1, &i_batchCount);
+#endif
+    return;
+  }
+#endif
+#if defined(USE_BLAS) && (defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT))
+  /* other BLAS libraries thread each product themselves, and aren't all
+     safe to call from several threads */
+  for(i = 0; i < batchCount; i++)
+    THBlas_(gemm)(transa, transb, m, n, k, alpha, a[i], lda, b[i], ldb, beta, c[i], ldc);
+#else
+  /* the reference gemm is single threaded */
+#pragma omp parallel for private(i) if(batchCount > 1 && batchCount * m * n * k > TH_OMP_OVERHEAD_THRESHOLD_GEMM)
+  for(i = 0; i < batchCount; i++)
+    THBlas_(gemm)(transa, transb, m, n, k, alpha, a[i], lda, b[i], ldb, beta, c[i], ldc);
+#endif
+}
+
 #endif
@@ -15,5 +15,7 @@ TH_API void THBlas_(ger)(int64_t m, int64_t n, real alpha, real *x, int64_t incx
 
 /* Level 3 */
 TH_API void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, real alpha, real *a, int64_t lda, real *b, int64_t ldb, real beta, real *c, int64_t ldc);
+/* batchCount products of the same shape, c[i] = alpha * op(a[i]) * op(b[i]) + beta * c[i] */
+TH_API void THBlas_(gemmBatched)(char transa, char transb, int64_t m, int64_t n, int64_t k, real alpha, real **a, int64_t lda, real **b, int64_t ldb, real beta, real **c, int64_t ldc, int64_t batchCount);
 
 #endif
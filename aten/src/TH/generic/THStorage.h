@@ -20,6 +20,7 @@
 #define TH_STORAGE_RESIZABLE  2
 #define TH_STORAGE_FREEMEM    4
 #define TH_STORAGE_VIEW       8
+#define TH_STORAGE_READONLY  16
 
 typedef struct THStorage
 {
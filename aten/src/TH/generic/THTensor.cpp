@@ -67,12 +67,13 @@ void THTensor_(clearFlag)(THTensor *self, const char flag)
 /**** creation methods ****/
 
 static void THTensor_(rawInit)(THTensor *self);
+static void THTensor_(reserveDims)(THTensor *self, int nDimension);
 
 
 /* Empty init */
 THTensor *THTensor_(new)(void)
 {
-  THTensor *self = (THTensor *)THAlloc(sizeof(THTensor));
+  THTensor *self = (THTensor *)THSmallAlloc(sizeof(THTensor));
   THTensor_(rawInit)(self);
   return self;
 }
@@ -80,7 +81,7 @@ THTensor *THTensor_(new)(void)
 /* Pointer-copy init */
 THTensor *THTensor_(newWithTensor)(THTensor *tensor)
 {
-  THTensor *self = (THTensor *)THAlloc(sizeof(THTensor));
+  THTensor *self = (THTensor *)THSmallAlloc(sizeof(THTensor));
   THTensor_(rawInit)(self);
   THTensor_(setStorageNd)(self,
                           tensor->storage,
@@ -94,7 +95,7 @@ THTensor *THTensor_(newWithTensor)(THTensor *tensor)
 /* Storage init */
 THTensor *THTensor_(newWithStorage)(THStorage *storage, ptrdiff_t storageOffset, THLongStorage *size, THLongStorage *stride)
 {
-  THTensor *self = (THTensor *)THAlloc(sizeof(THTensor));
+  THTensor *self = (THTensor *)THSmallAlloc(sizeof(THTensor));
   if(size && stride)
     THArgCheck(size->size == stride->size, 4, "inconsistent size");
 
@@ -141,7 +142,7 @@ THTensor *THTensor_(newWithStorage4d)(THStorage *storage, ptrdiff_t storageOffse
   int64_t size[4] = {size0, size1, size2, size3};
   int64_t stride[4] = {stride0, stride1, stride2, stride3};
 
-  THTensor *self = (THTensor *)THAlloc(sizeof(THTensor));
+  THTensor *self = (THTensor *)THSmallAlloc(sizeof(THTensor));
   THTensor_(rawInit)(self);
   THTensor_(setStorageNd)(self, storage, storageOffset, 4, size, stride);
 
@@ -172,7 +173,7 @@ THTensor *THTensor_(newWithSize4d)(int64_t size0, int64_t size1, int64_t size2,
 {
   int64_t size[4] = {size0, size1, size2, size3};
 
-  THTensor *self = (THTensor *)THAlloc(sizeof(THTensor));
+  THTensor *self = (THTensor *)THSmallAlloc(sizeof(THTensor));
   THTensor_(rawInit)(self);
   THTensor_(resizeNd)(self, 4, size, NULL);
 
@@ -469,9 +470,6 @@ void THTensor_(transpose)(THTensor *self, THTensor *src, int dimension1, int dim
 
 void THTensor_(unfold)(THTensor *self, THTensor *src, int dimension, int64_t size, int64_t step)
 {
-  int64_t *newSize;
-  int64_t *newStride;
-  int d;
 
   if(!src)
     src = self;
@@ -482,31 +480,12 @@ void THTensor_(unfold)(THTensor *self, THTensor *src, int dimension, int64_t siz
   THArgCheck(step > 0, 4, "invalid step");
 
   THTensor_(set)(self, src);
+  THTensor_(reserveDims)(self, self->nDimension+1);
 
-  newSize = (int64_t *)THAlloc(sizeof(int64_t)*(self->nDimension+1));
-  newStride = (int64_t *)THAlloc(sizeof(int64_t)*(self->nDimension+1));
-
-  newSize[self->nDimension] = size;
-  newStride[self->nDimension] = self->stride[dimension];
-  for(d = 0; d < self->nDimension; d++)
-  {
-    if(d == dimension)
-    {
-      newSize[d] = (self->size[d] - size) / step + 1;
-      newStride[d] = step*self->stride[d];
-    }
-    else
-    {
-      newSize[d] = self->size[d];
-      newStride[d] = self->stride[d];
-    }
-  }
-
-  THFree(self->size);
-  THFree(self->stride);
-
-  self->size = newSize;
-  self->stride = newStride;
+  self->size[self->nDimension] = size;
+  self->stride[self->nDimension] = self->stride[dimension];
+  self->size[dimension] = (self->size[dimension] - size) / step + 1;
+  self->stride[dimension] = step*self->stride[dimension];
   self->nDimension++;
 }
 
@@ -578,8 +557,7 @@ void THTensor_(unsqueeze1d)(THTensor *self, THTensor *src, int dimension)
 
   THTensor_(set)(self, src);
 
-  self->size = (int64_t*)THRealloc(self->size, sizeof(int64_t)*(self->nDimension+1));
-  self->stride = (int64_t*)THRealloc(self->stride, sizeof(int64_t)*(self->nDimension+1));
+  THTensor_(reserveDims)(self, self->nDimension+1);
   self->nDimension++;
   for (d = self->nDimension-1; d > dimension; d--) {
     self->size[d] = self->size[d-1];
@@ -709,11 +687,14 @@ void THTensor_(free)(THTensor *self)
   {
     if(THAtomicDecrementRef(&self->refcount))
     {
-      THFree(self->size);
-      THFree(self->stride);
+      if(self->size != self->inlineSize)
+      {
+        THFree(self->size);
+        THFree(self->stride);
+      }
       if(self->storage)
         THStorage_(free)(self->storage);
-      THFree(self);
+      THSmallFree(self, sizeof(THTensor));
     }
   }
 }
@@ -733,12 +714,54 @@ static void THTensor_(rawInit)(THTensor *self)
   self->refcount = 1;
   self->storage = THStorage_(new)();
   self->storageOffset = 0;
-  self->size = NULL;
-  self->stride = NULL;
+  self->size = self->inlineSize;
+  self->stride = self->inlineStride;
   self->nDimension = 0;
   self->flag = TH_TENSOR_REFCOUNTED;
 }
 
+/* Makes room for nDimension dimensions in size and stride, keeping the
+   values of the current ones */
+static void THTensor_(reserveDims)(THTensor *self, int nDimension)
+{
+  int64_t *size;
+  int64_t *stride;
+  int kept = self->nDimension < nDimension ? self->nDimension : nDimension;
+  int d;
+
+  if(nDimension <= TH_TENSOR_INLINE_DIMS)
+  {
+    if(self->size == self->inlineSize)
+      return;
+    size = self->inlineSize;
+    stride = self->inlineStride;
+  }
+  else if(self->size != self->inlineSize)
+  {
+    self->size = (int64_t *)THRealloc(self->size, sizeof(int64_t)*nDimension);
+    self->stride = (int64_t *)THRealloc(self->stride, sizeof(int64_t)*nDimension);
+    return;
+  }
+  else
+  {
+    size = (int64_t *)THAlloc(sizeof(int64_t)*nDimension);
+    stride = (int64_t *)THAlloc(sizeof(int64_t)*nDimension);
+  }
+
+  for(d = 0; d < kept; d++)
+  {
+    size[d] = self->size[d];
+    stride[d] = self->stride[d];
+  }
+  if(self->size != self->inlineSize)
+  {
+    THFree(self->size);
+    THFree(self->stride);
+  }
+  self->size = size;
+  self->stride = stride;
+}
+
 void THTensor_(setStorageNd)(THTensor *self, THStorage *storage, ptrdiff_t storageOffset, int nDimension, int64_t *size, int64_t *stride)
 {
   /* storage */
@@ -799,8 +822,7 @@ void THTensor_(resizeNd)(THTensor *self, int nDimension, int64_t *size, int64_t
   {
     if(nDimension != self->nDimension)
     {
-      self->size = (int64_t *)THRealloc(self->size, sizeof(int64_t)*nDimension);
-      self->stride = (int64_t *)THRealloc(self->stride, sizeof(int64_t)*nDimension);
+      THTensor_(reserveDims)(self, nDimension);
       self->nDimension = nDimension;
     }
 
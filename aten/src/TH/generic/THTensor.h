@@ -6,6 +6,10 @@
 
 #define TH_TENSOR_REFCOUNTED 1
 
+/* size and stride point to inlineSize and inlineStride for up to
+   TH_TENSOR_INLINE_DIMS dimensions, and are allocated beyond */
+#define TH_TENSOR_INLINE_DIMS 5
+
 typedef struct THTensor
 {
     int64_t *size;
@@ -20,6 +24,9 @@ typedef struct THTensor
 
     char flag;
 
+    int64_t inlineSize[TH_TENSOR_INLINE_DIMS];
+    int64_t inlineStride[TH_TENSOR_INLINE_DIMS];
+
 } THTensor;
 
 
@@ -13,70 +13,94 @@
 #include <omp.h>
 #endif
 
+// elements converted at a time by the contiguous copies between float and
+// half, which go through THFloatVector_fromHalf and THFloatVector_toHalf
+#define TH_COPY_HALF_CHUNK 4096
+
+#if !defined(TH_REAL_IS_HALF) && !defined(TH_REAL_IS_BFLOAT16)
+// Returns the dimension of src walked by the transposed copy (a dimension
+// other than the last one with stride 1), or -1 if the copy isn't one.
+static int THTensor_(copyTransposeDim)(THTensor *src) {
+  int ndim = THTensor_(nDimension)(src);
+  int d;
+  if (ndim < 2 || THTensor_(size)(src, ndim - 1) == 1 || THTensor_(stride)(src, ndim - 1) == 1) {
+    return -1;
+  }
+  for (d = ndim - 2; d >= 0; d--) {
+    if (THTensor_(stride)(src, d) == 1 && THTensor_(size)(src, d) > 1) {
+      return d;
+    }
+  }
+  return -1;
+}
+
 int THTensor_(copyTransposeValid)(THTensor *tensor, THTensor *src) {
   const int MIN_SZ = 60 * 60;
   return THTensor_(isContiguous)(tensor) &&
-         THTensor_(nDimension)(src) == 2 &&
-         THTensor_(stride)(src, 0) == 1 &&
-         THTensor_(stride)(src, 1) == THTensor_(size)(src, 0) &&
-         THTensor_(nElement)(tensor) >= MIN_SZ;
+         THTensor_(nElement)(tensor) >= MIN_SZ &&
+         THTensor_(copyTransposeDim)(src) >= 0;
 }
 
-// special case copy where tensor is contiguous and src is a transposed matrix
-// This can be generalized to most copies, but it's tricker
+// special case copy where tensor is contiguous and src has a stride 1
+// dimension other than its last one, e.g. src is a transposed matrix or a
+// permutation of a contiguous tensor (NCHW <-> NHWC). Every plane spanned by
+// that dimension and the last one is copied in square tiles that fit in the
+// L1 cache, transposed by THVector_(transpose), and the tiles are spread
+// over the OpenMP threads.
 void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src) {
-  #define MIN(x, y) (((x) < (y)) ? (x) : (y))
-  #define MAX(x, y) (((x) > (y)) ? (x) : (y))
-
 #ifdef TH_REAL_IS_BYTE
-  const int BLOCK_SZ = 120;
+  const int64_t BLOCK_SZ = 64;
 #else
-  const int BLOCK_SZ = 60;
+  const int64_t BLOCK_SZ = 32;
 #endif
 
-  THTensor *buf = THTensor_(newWithSize2d)(BLOCK_SZ, BLOCK_SZ);
   real *sp = THTensor_(data)(src);
   real *rp = THTensor_(data)(tensor);
-  real *bp = THTensor_(data)(buf);
-
-
-  int64_t NR = THTensor_(size)(src, 0);
-  int64_t NC = THTensor_(size)(src, 1);
-  for (int64_t R = 0; R < NR; R += BLOCK_SZ) {
-    for (int64_t C = 0; C < NC; C += BLOCK_SZ) {
-      real *spo = sp + R + C * NR;
-      real *rpo = rp + C + R * NC;
-
-      int nr = MIN(NR - R, BLOCK_SZ);
-      int nc = MIN(NC - C, BLOCK_SZ);
-
-      // 1. copy columns from src to buf
-      for (int c = 0; c < nc; c++) {
-        memcpy(bp + c * BLOCK_SZ, spo + c * NR, nr * sizeof(real));
-      }
+  int ndim = THTensor_(nDimension)(src);
+  int tdim = THTensor_(copyTransposeDim)(src);
+  int64_t *sizes = src->size;
+  int64_t *strides = src->stride;
+  // tensor is contiguous, so it is addressed as a contiguous tensor of
+  // src's shape
+  int64_t *rstrides = (int64_t*)THAlloc(sizeof(int64_t) * ndim);
+  int64_t NR = sizes[tdim];
+  int64_t NC = sizes[ndim - 1];
+  int64_t tiles_r = (NR + BLOCK_SZ - 1) / BLOCK_SZ;
+  int64_t tiles_c = (NC + BLOCK_SZ - 1) / BLOCK_SZ;
+  int64_t num_tiles;
+  ptrdiff_t t;
+  int d;
 
-      // 2. transpose buf in place
-      int rc_max = MAX(nr, nc);
-      int rc_min = MIN(nr, nc);
-      for (int r = 0; r < rc_max; r++) {
-        int end = MIN(r, rc_min);
-        for (int c = 0; c < end; c++) {
-          real tmp = bp[r + BLOCK_SZ * c];
-          bp[r + BLOCK_SZ * c] = bp[r * BLOCK_SZ + c];
-          bp[r * BLOCK_SZ + c] = tmp;
-        }
-      }
+  rstrides[ndim - 1] = 1;
+  for (d = ndim - 2; d >= 0; d--) {
+    rstrides[d] = rstrides[d + 1] * sizes[d + 1];
+  }
+  num_tiles = THTensor_(nElement)(src) / (NR * NC) * tiles_r * tiles_c;
 
-      // 3. copy rows from buf to dst
-      for (int r = 0; r < nr; r++) {
-        memcpy(rpo + r * NC, bp + r * BLOCK_SZ, nc * sizeof(real));
+#ifdef _OPENMP
+  #pragma omp parallel for if ( (THTensor_(nElement)(src) > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!omp_in_parallel()) ) private(d)
+#endif
+  for (t = 0; t < num_tiles; t++) {
+    int64_t plane = t / (tiles_r * tiles_c);
+    int64_t R = (t / tiles_c) % tiles_r * BLOCK_SZ;
+    int64_t C = t % tiles_c * BLOCK_SZ;
+    int64_t soff = 0;
+    int64_t roff = 0;
+    for (d = ndim - 2; d >= 0; d--) {
+      if (d != tdim) {
+        int64_t idx = plane % sizes[d];
+        plane /= sizes[d];
+        soff += idx * strides[d];
+        roff += idx * rstrides[d];
       }
     }
+    THVector_(transpose)(rp + roff + R * rstrides[tdim] + C, rstrides[tdim],
+                         sp + soff + R + C * strides[ndim - 1], strides[ndim - 1],
+                         THMin(NR - R, BLOCK_SZ), THMin(NC - C, BLOCK_SZ));
   }
-  THTensor_(free)(buf);
-  #undef MIN
-  #undef MAX
+  THFree(rstrides);
 }
+#endif
 
 void THTensor_(copy)(THTensor *tensor, THTensor *src)
 {
@@ -94,7 +118,7 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
     if ( tensorContig && srcContig) {
       real *sp = THTensor_(data)(src);
       real *rp = THTensor_(data)(tensor);
-#ifndef TH_REAL_IS_HALF
+#if !defined(TH_REAL_IS_HALF) && !defined(TH_REAL_IS_BFLOAT16)
 #ifdef _OPENMP
       #pragma omp parallel if ( (tensorSize > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!inOMP) )
       {
@@ -129,7 +153,7 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
 
 #endif
 
-#ifndef TH_REAL_IS_HALF
+#if !defined(TH_REAL_IS_HALF) && !defined(TH_REAL_IS_BFLOAT16)
     } else if (THTensor_(copyTransposeValid)(tensor, src)) {
       THTensor_(copyTranspose)(tensor, src);
 #endif
@@ -171,13 +195,25 @@ void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src
  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = (real)TH_half2float(*src_data);) \
 }
 
+#define IMPLEMENT_THTensor_COPY_TO_BFLOAT16(TYPENAMESRC, TYPE_SRC) \
+void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
+{ \
+ TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = TH_float2bfloat16((float)*src_data);) \
+}
+
+#define IMPLEMENT_THTensor_COPY_FROM_BFLOAT16(TYPENAMESRC, TYPE_SRC) \
+void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
+{ \
+ TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = (real)TH_bfloat162float(*src_data);) \
+}
+
 #define IMPLEMENT_THTensor_COPY_TO_FROM_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = *src_data;) \
 }
 
-#ifndef TH_REAL_IS_HALF
+#if !defined(TH_REAL_IS_HALF) && !defined(TH_REAL_IS_BFLOAT16)
 IMPLEMENT_THTensor_COPY(Byte, uint8_t)
 IMPLEMENT_THTensor_COPY(Char, int8_t)
 IMPLEMENT_THTensor_COPY(Short, int16_t)
@@ -185,8 +221,30 @@ IMPLEMENT_THTensor_COPY(Int, int32_t)
 IMPLEMENT_THTensor_COPY(Long, int64_t)
 IMPLEMENT_THTensor_COPY(Float, float)
 IMPLEMENT_THTensor_COPY(Double, double)
-IMPLEMENT_THTensor_COPY_FROM_HALF(Half, THHalf)
+#ifdef TH_REAL_IS_FLOAT
+void THTensor_(copyHalf)(THTensor *tensor, THHalfTensor *src)
+{
+  ptrdiff_t size = THTensor_(nElement)(tensor);
+  if (THTensor_(isContiguous)(tensor) && THHalfTensor_isContiguous(src) &&
+      size == THHalfTensor_nElement(src)) {
+    real *rp = THTensor_(data)(tensor);
+    THHalf *sp = THHalfTensor_data(src);
+    ptrdiff_t i;
+#ifdef _OPENMP
+    #pragma omp parallel for if ( (size > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!omp_in_parallel()) )
+#endif
+    for (i = 0; i < size; i += TH_COPY_HALF_CHUNK) {
+      THFloatVector_fromHalf(rp + i, sp + i, THMin(TH_COPY_HALF_CHUNK, size - i));
+    }
+    return;
+  }
+  TH_TENSOR_APPLY2(real, tensor, THHalf, src, *tensor_data = TH_half2float(*src_data);)
+}
 #else
+IMPLEMENT_THTensor_COPY_FROM_HALF(Half, THHalf)
+#endif
+IMPLEMENT_THTensor_COPY_FROM_BFLOAT16(BFloat16, THBFloat16)
+#elif defined(TH_REAL_IS_HALF)
 /* only allow pass-through for Half */
 IMPLEMENT_THTensor_COPY_TO_FROM_HALF(Half, THHalf)
 IMPLEMENT_THTensor_COPY_TO_HALF(Byte, uint8_t)
@@ -194,8 +252,43 @@ IMPLEMENT_THTensor_COPY_TO_HALF(Char, int8_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Short, int16_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Int, int32_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Long, int64_t)
-IMPLEMENT_THTensor_COPY_TO_HALF(Float, float)
+void THTensor_(copyFloat)(THTensor *tensor, THFloatTensor *src)
+{
+  ptrdiff_t size = THTensor_(nElement)(tensor);
+  if (THTensor_(isContiguous)(tensor) && THFloatTensor_isContiguous(src) &&
+      size == THFloatTensor_nElement(src)) {
+    THHalf *rp = THTensor_(data)(tensor);
+    float *sp = THFloatTensor_data(src);
+    ptrdiff_t i;
+#ifdef _OPENMP
+    #pragma omp parallel for if ( (size > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!omp_in_parallel()) )
+#endif
+    for (i = 0; i < size; i += TH_COPY_HALF_CHUNK) {
+      THFloatVector_toHalf(rp + i, sp + i, THMin(TH_COPY_HALF_CHUNK, size - i));
+    }
+    return;
+  }
+  TH_TENSOR_APPLY2(real, tensor, float, src, *tensor_data = TH_float2half(*src_data);)
+}
 IMPLEMENT_THTensor_COPY_TO_HALF(Double, double)
+void THTensor_(copyBFloat16)(THTensor *tensor, THBFloat16Tensor *src)
+{
+  TH_TENSOR_APPLY2(real, tensor, THBFloat16, src, *tensor_data = TH_float2half(TH_bfloat162float(*src_data));)
+}
+#else
+/* BFloat16 converts through float, like Half */
+IMPLEMENT_THTensor_COPY_TO_FROM_HALF(BFloat16, THBFloat16)
+IMPLEMENT_THTensor_COPY_TO_BFLOAT16(Byte, uint8_t)
+IMPLEMENT_THTensor_COPY_TO_BFLOAT16(Char, int8_t)
+IMPLEMENT_THTensor_COPY_TO_BFLOAT16(Short, int16_t)
+IMPLEMENT_THTensor_COPY_TO_BFLOAT16(Int, int32_t)
+IMPLEMENT_THTensor_COPY_TO_BFLOAT16(Long, int64_t)
+IMPLEMENT_THTensor_COPY_TO_BFLOAT16(Float, float)
+IMPLEMENT_THTensor_COPY_TO_BFLOAT16(Double, double)
+void THTensor_(copyHalf)(THTensor *tensor, THHalfTensor *src)
+{
+  TH_TENSOR_APPLY2(real, tensor, THHalf, src, *tensor_data = TH_float2bfloat16(TH_half2float(*src_data));)
+}
 
 #endif /* REAL_IS_HALF */
 
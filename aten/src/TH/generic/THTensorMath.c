@@ -241,9 +241,37 @@ void THTensor_(maskedCopy)(THTensor *tensor, THByteTensor *mask, THTensor* src )
 
 void THTensor_(maskedSelect)(THTensor *tensor, THTensor *src, THByteTensor *mask)
 {
-  ptrdiff_t numel = THByteTensor_sumall(mask);
+  ptrdiff_t numel;
   real *tensor_data;
 
+  if (THTensor_(isContiguous)(src) && THByteTensor_isContiguous(mask) &&
+      THTensor_(nElement)(src) == THByteTensor_nElement(mask)) {
+    /* Stream compaction without branches on the mask: every element is
+       written to the next output slot, which only advances when the element
+       is selected, until all the selected elements are written. */
+    real *src_data = THTensor_(data)(src);
+    unsigned char *mask_data = THByteTensor_data(mask);
+    ptrdiff_t n = THTensor_(nElement)(src);
+    ptrdiff_t i, j = 0;
+    unsigned char invalid = 0;
+    for (i = 0; i < n; i++) {
+      invalid |= mask_data[i] > 1;
+      j += mask_data[i];
+    }
+    if (invalid) {
+      THError("Mask tensor can take 0 and 1 values only");
+    }
+    numel = j;
+    THTensor_(resize1d)(tensor, numel);
+    tensor_data = THTensor_(data)(tensor);
+    for (i = 0, j = 0; i < n && j < numel; i++) {
+      tensor_data[j] = src_data[i];
+      j += mask_data[i];
+    }
+    return;
+  }
+
+  numel = THByteTensor_sumall(mask);
 #ifdef DEBUG
   THAssert(numel <= LONG_MAX);
 #endif
@@ -2287,21 +2315,101 @@ void THTensor_(baddbmm)(THTensor *result, real beta, THTensor *t, real alpha, TH
     }
   }
 
-  THTensor *matrix1 = THTensor_(new)();
-  THTensor *matrix2 = THTensor_(new)();
-  THTensor *result_matrix = THTensor_(new)();
+  // n == 1 || ldc >= max(1, m)
+  #define LDC_COND(M, N, LDC) ((N) == 1 || (LDC) >= THMax(1, M))
 
-  for (batch = 0; batch < THTensor_(size)(batch1, 0); ++batch) {
-    THTensor_(select)(matrix1, batch1, 0, batch);
-    THTensor_(select)(matrix2, batch2, 0, batch);
-    THTensor_(select)(result_matrix, result, 0, batch);
+  /* The batch is a single gemmBatched when the matrices of result can be
+     written in place, with the same layout choices as addmm */
+  int64_t k_ = THTensor_(size)(batch1, 2);
+  char transpose_r = 0;
+  if (bs > 0 && dim1 > 0 && dim2 > 0 && k_ > 0) {
+    if (result->stride[1] == 1 && LDC_COND(dim1, dim2, result->stride[2])) {
+      transpose_r = 'n';
+    } else if (result->stride[2] == 1 && LDC_COND(dim2, dim1, result->stride[1])) {
+      THTensor *swap = batch2;
+      batch2 = batch1;
+      batch1 = swap;
+      transpose_r = 't';
+    }
+  }
+
+  #undef LDC_COND
 
-    THTensor_(addmm)(result_matrix, beta, result_matrix, alpha, matrix1, matrix2);
+  if (transpose_r == 0) {
+    THTensor *matrix1 = THTensor_(new)();
+    THTensor *matrix2 = THTensor_(new)();
+    THTensor *result_matrix = THTensor_(new)();
+
+    for (batch = 0; batch < THTensor_(size)(batch1, 0); ++batch) {
+      THTensor_(select)(matrix1, batch1, 0, batch);
+      THTensor_(select)(matrix2, batch2, 0, batch);
+      THTensor_(select)(result_matrix, result, 0, batch);
+
+      THTensor_(addmm)(result_matrix, beta, result_matrix, alpha, matrix1, matrix2);
+    }
+
+    THTensor_(free)(matrix1);
+    THTensor_(free)(matrix2);
+    THTensor_(free)(result_matrix);
+    return;
   }
 
-  THTensor_(free)(matrix1);
-  THTensor_(free)(matrix2);
-  THTensor_(free)(result_matrix);
+  /* the dimensions of the matrices in the column major order of BLAS */
+  int row = (transpose_r == 'n' ? 1 : 2);
+  int col = (transpose_r == 'n' ? 2 : 1);
+  int64_t m = result->size[row];
+  int64_t n = result->size[col];
+  int64_t k = batch1->size[col];
+  int64_t ldr = result->stride[col];
+  char transpose_m1, transpose_m2;
+  THTensor *m1_, *m2_;
+
+  /* batch1 */
+  if (batch1->stride[row] == 1 && batch1->stride[col] >= THMax(1, m)) {
+    transpose_m1 = 'n';
+    m1_ = batch1;
+    THTensor_(retain)(m1_);
+  } else if (batch1->stride[col] == 1 && batch1->stride[row] >= THMax(1, k)) {
+    transpose_m1 = 't';
+    m1_ = batch1;
+    THTensor_(retain)(m1_);
+  } else {
+    transpose_m1 = (transpose_r == 'n' ? 't' : 'n');
+    m1_ = THTensor_(newContiguous)(batch1);
+  }
+
+  /* batch2 */
+  if (batch2->stride[row] == 1 && batch2->stride[col] >= THMax(1, k)) {
+    transpose_m2 = 'n';
+    m2_ = batch2;
+    THTensor_(retain)(m2_);
+  } else if (batch2->stride[col] == 1 && batch2->stride[row] >= THMax(1, n)) {
+    transpose_m2 = 't';
+    m2_ = batch2;
+    THTensor_(retain)(m2_);
+  } else {
+    transpose_m2 = (transpose_r == 'n' ? 't' : 'n');
+    m2_ = THTensor_(newContiguous)(batch2);
+  }
+
+  int64_t ldm1 = (transpose_m1 == 'n' ? m1_->stride[col] : m1_->stride[row]);
+  int64_t ldm2 = (transpose_m2 == 'n' ? m2_->stride[col] : m2_->stride[row]);
+
+  real **pointers = (real **)THAlloc(3 * bs * sizeof(real *));
+  real **a = pointers, **b = pointers + bs, **c = pointers + 2 * bs;
+  for (batch = 0; batch < bs; ++batch) {
+    a[batch] = THTensor_(data)(m1_) + batch * m1_->stride[0];
+    b[batch] = THTensor_(data)(m2_) + batch * m2_->stride[0];
+    c[batch] = THTensor_(data)(result) + batch * result->stride[0];
+  }
+
+#pragma omp critical(blasgemm)
+  THBlas_(gemmBatched)(transpose_m1, transpose_m2, m, n, k,
+                       alpha, a, ldm1, b, ldm2, beta, c, ldr, bs);
+
+  THFree(pointers);
+  THTensor_(free)(m1_);
+  THTensor_(free)(m2_);
 }
 
 ptrdiff_t THTensor_(numel)(THTensor *t)
@@ -3168,6 +3276,129 @@ static void THTensor_(quicksortdescend)(real *arr, int64_t *idx, int64_t element
 #undef MAX_LEVELS
 #undef M_SMALL
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE)
+#define TH_RADIX_BITS 8
+#define TH_RADIX (1 << TH_RADIX_BITS)
+/* slices shorter than this are faster to quicksort */
+#define TH_RADIX_SORT_THRESHOLD 4096
+
+/* Stable LSD radix sort of a strided slice of integers, with their indices
+   in idx. The keys are offset by the slice's minimum (or subtracted from its
+   maximum when descending), so that only as many 8-bit passes as the range
+   of the values needs are done. Large slices split the histograms and the
+   scatters of every pass between the OpenMP threads. */
+static void THTensor_(radixsort)(real *arr, int64_t *idx, int64_t elements, int64_t stride, int descending)
+{
+  int64_t i;
+  int64_t min = arr[0], max = arr[0];
+  for (i = 1; i < elements; i++) {
+    int64_t v = arr[i*stride];
+    if (v < min) min = v;
+    if (v > max) max = v;
+  }
+  uint64_t range = (uint64_t)max - (uint64_t)min;
+  int passes = 0;
+  while (passes * TH_RADIX_BITS < 64 && (range >> (passes * TH_RADIX_BITS)) != 0)
+    passes++;
+
+  uint64_t *keys = (uint64_t*)THAlloc(2 * elements * sizeof(uint64_t));
+  int64_t *order = (int64_t*)THAlloc(2 * elements * sizeof(int64_t));
+  for (i = 0; i < elements; i++) {
+    int64_t v = arr[i*stride];
+    keys[i] = descending ? (uint64_t)max - (uint64_t)v : (uint64_t)v - (uint64_t)min;
+    order[i] = idx[i*stride];
+  }
+  uint64_t *src_keys = keys, *dst_keys = keys + elements;
+  int64_t *src_order = order, *dst_order = order + elements;
+
+#ifdef _OPENMP
+  int max_threads = omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+  int max_threads = 1;
+#endif
+  int64_t *hist = (int64_t*)THAlloc(max_threads * TH_RADIX * sizeof(int64_t));
+
+  #pragma omp parallel if(elements > TH_OMP_OVERHEAD_THRESHOLD && max_threads > 1) num_threads(max_threads)
+  {
+#ifdef _OPENMP
+    int nthreads = omp_get_num_threads();
+    int tid = omp_get_thread_num();
+#else
+    int nthreads = 1;
+    int tid = 0;
+#endif
+    int64_t chunk = (elements + nthreads - 1) / nthreads;
+    int64_t begin = THMin(elements, tid * chunk);
+    int64_t end = THMin(elements, begin + chunk);
+    int64_t *h = hist + tid * TH_RADIX;
+    int pass;
+    for (pass = 0; pass < passes; pass++) {
+      int shift = pass * TH_RADIX_BITS;
+      int64_t j;
+      memset(h, 0, TH_RADIX * sizeof(int64_t));
+      for (j = begin; j < end; j++)
+        h[(src_keys[j] >> shift) & (TH_RADIX - 1)]++;
+      #pragma omp barrier
+      #pragma omp single
+      {
+        /* digit-major scan: a thread writes each digit after the lower
+           threads' elements with the same digit, which keeps the order */
+        int64_t total = 0;
+        int d, t;
+        for (d = 0; d < TH_RADIX; d++) {
+          for (t = 0; t < nthreads; t++) {
+            int64_t count = hist[t * TH_RADIX + d];
+            hist[t * TH_RADIX + d] = total;
+            total += count;
+          }
+        }
+      }
+      for (j = begin; j < end; j++) {
+        int64_t p = h[(src_keys[j] >> shift) & (TH_RADIX - 1)]++;
+        dst_keys[p] = src_keys[j];
+        dst_order[p] = src_order[j];
+      }
+      #pragma omp barrier
+      #pragma omp single
+      {
+        uint64_t *tmp_keys = src_keys; src_keys = dst_keys; dst_keys = tmp_keys;
+        int64_t *tmp_order = src_order; src_order = dst_order; dst_order = tmp_order;
+      }
+    }
+  }
+
+  for (i = 0; i < elements; i++) {
+    arr[i*stride] = (real)(descending ? (int64_t)((uint64_t)max - src_keys[i])
+                                      : (int64_t)(src_keys[i] + (uint64_t)min));
+    idx[i*stride] = src_order[i];
+  }
+  THFree(hist);
+  THFree(keys);
+  THFree(order);
+}
+
+#undef TH_RADIX_BITS
+#undef TH_RADIX
+#endif
+
+/* Sorts one slice in place, filling idx with the original positions */
+static void THTensor_(sortSlice)(real *arr, int64_t *idx, int64_t elements, int64_t stride, int descendingOrder)
+{
+  int64_t i;
+  for (i = 0; i < elements; i++)
+    idx[i*stride] = i;
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE)
+  if (elements >= TH_RADIX_SORT_THRESHOLD) {
+    THTensor_(radixsort)(arr, idx, elements, stride, descendingOrder);
+    return;
+  }
+#endif
+  if (descendingOrder)
+    THTensor_(quicksortdescend)(arr, idx, elements, stride);
+  else
+    THTensor_(quicksortascend)(arr, idx, elements, stride);
+}
+
 void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimension, int descendingOrder)
 {
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "invalid dimension %d",
@@ -3182,24 +3413,28 @@ void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimensio
     THLongStorage_free(size);
   }
 
-  if(descendingOrder)
-  {
-    TH_TENSOR_DIM_APPLY2(real, rt_, int64_t, ri_, dimension,
-                         int64_t i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortdescend)(rt__data, ri__data, rt__size, rt__stride);)
-      }
-  else
-  {
-    TH_TENSOR_DIM_APPLY2(real, rt_, int64_t, ri_, dimension,
-                         int64_t i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortascend)(rt__data, ri__data, rt__size, rt__stride);)
-      }
+  int64_t sliceSize = THTensor_(size)(rt_, dimension);
+  if (dimension == THTensor_(nDimension)(rt_) - 1 &&
+      THTensor_(isContiguous)(rt_) && THLongTensor_isContiguous(ri_)) {
+    /* rows of a contiguous tensor: sort them in parallel */
+    real *rt__data = THTensor_(data)(rt_);
+    int64_t *ri__data = THLongTensor_data(ri_);
+    int64_t numSlices = sliceSize ? THTensor_(nElement)(rt_) / sliceSize : 0;
+    int64_t s;
+    #pragma omp parallel for if(numSlices > 1 && numSlices * sliceSize > TH_OMP_OVERHEAD_THRESHOLD) private(s)
+    for (s = 0; s < numSlices; s++)
+      THTensor_(sortSlice)(rt__data + s * sliceSize, ri__data + s * sliceSize, sliceSize, 1, descendingOrder);
+    return;
+  }
+
+  TH_TENSOR_DIM_APPLY2(real, rt_, int64_t, ri_, dimension,
+                       THTensor_(sortSlice)(rt__data, ri__data, rt__size, rt__stride, descendingOrder);)
 }
 
+#if !defined(TH_REAL_IS_FLOAT) && !defined(TH_REAL_IS_DOUBLE)
+#undef TH_RADIX_SORT_THRESHOLD
+#endif
+
 /* Implementation of the Quickselect algorithm, based on Nicolas Devillard's
 public domain implementation at http://ndevilla.free.fr/median/median/
 Adapted similarly to the above Quicksort algorithm.
@@ -3429,6 +3664,47 @@ void THTensor_(median)(THTensor *values_, THLongTensor *indices_, THTensor *t, i
   THTensor_(kthvalue)(values_, indices_, t, k+1, dimension, keepdim);
 }
 
+/* Selects the k largest (dir) or smallest elements of one slice with
+   quickselect, so that only the k selected elements are sorted when sorted
+   is set. tmp and tmpi are scratch buffers of sliceSize elements. */
+static void THTensor_(topkSlice)(real *tmp__data, int64_t *tmpi__data,
+                                 real *t_data, int64_t t_stride,
+                                 real *rt__data, int64_t rt__stride,
+                                 int64_t *ri__data, int64_t ri__stride,
+                                 int64_t sliceSize, int64_t k, int dir, int sorted)
+{
+  int64_t i;
+  for(i = 0; i < sliceSize; i++)
+  {
+    tmp__data[i] = t_data[i*t_stride];
+    tmpi__data[i] = i;
+  }
+  if (dir) {
+    /* k largest elements, descending order (optional: see sorted) */
+    int64_t K = sliceSize - k;
+    if (K > 0)
+      THTensor_(quickselect)(tmp__data, tmpi__data, K - 1, sliceSize, 1);
+    if (sorted)
+      THTensor_(quicksortdescend)(tmp__data + K, tmpi__data + K, k, 1);
+    for(i = 0; i < k; i++)
+    {
+      rt__data[i*rt__stride] = tmp__data[i + K];
+      ri__data[i*ri__stride] = tmpi__data[i + K];
+    }
+  }
+  else {
+    /* k smallest elements, ascending order (optional: see sorted) */
+    THTensor_(quickselect)(tmp__data, tmpi__data, k - 1, sliceSize, 1);
+    if (sorted)
+      THTensor_(quicksortascend)(tmp__data, tmpi__data, k - 1, 1);
+    for(i = 0; i < k; i++)
+    {
+      rt__data[i*rt__stride] = tmp__data[i];
+      ri__data[i*ri__stride] = tmpi__data[i];
+    }
+  }
+}
+
 void THTensor_(topk)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int64_t k, int dim, int dir, int sorted)
 {
   int numDims = THTensor_(nDimension)(t);
@@ -3437,6 +3713,36 @@ void THTensor_(topk)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int64_t k, i
   int64_t sliceSize = THTensor_(size)(t, dim);
   THArgCheck(k > 0 && k <= sliceSize, 2, "k not in range for dimension");
 
+  THLongStorage *topKSize = THTensor_(newSizeOf)(t);
+  THLongStorage_set(topKSize, dim, k);
+  THTensor_(resize)(rt_, topKSize, NULL);
+  THLongTensor_resize(ri_, topKSize, NULL);
+  THLongStorage_free(topKSize);
+
+  if (dim == numDims - 1 && THTensor_(isContiguous)(t) &&
+      THTensor_(isContiguous)(rt_) && THLongTensor_isContiguous(ri_)) {
+    /* rows of a contiguous tensor: select them in parallel, every thread
+       with its own scratch buffers */
+    real *t_data = THTensor_(data)(t);
+    real *rt__data = THTensor_(data)(rt_);
+    int64_t *ri__data = THLongTensor_data(ri_);
+    int64_t numSlices = THTensor_(nElement)(t) / sliceSize;
+    #pragma omp parallel if(numSlices > 1 && numSlices * sliceSize > TH_OMP_OVERHEAD_THRESHOLD)
+    {
+      real *tmp__data = (real*)THAlloc(sliceSize * sizeof(real));
+      int64_t *tmpi__data = (int64_t*)THAlloc(sliceSize * sizeof(int64_t));
+      int64_t s;
+      #pragma omp for
+      for (s = 0; s < numSlices; s++)
+        THTensor_(topkSlice)(tmp__data, tmpi__data, t_data + s * sliceSize, 1,
+                             rt__data + s * k, 1, ri__data + s * k, 1,
+                             sliceSize, k, dir, sorted);
+      THFree(tmp__data);
+      THFree(tmpi__data);
+    }
+    return;
+  }
+
   THTensor *tmpResults = THTensor_(new)();
   THTensor_(resize1d)(tmpResults, sliceSize);
   real *tmp__data = THTensor_(data)(tmpResults);
@@ -3445,52 +3751,11 @@ void THTensor_(topk)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int64_t k, i
   THLongTensor_resize1d(tmpIndices, sliceSize);
   int64_t *tmpi__data = THLongTensor_data(tmpIndices);
 
-  THLongStorage *topKSize = THTensor_(newSizeOf)(t);
-  THLongStorage_set(topKSize, dim, k);
-  THTensor_(resize)(rt_, topKSize, NULL);
-  THLongTensor_resize(ri_, topKSize, NULL);
-  THLongStorage_free(topKSize);
-
-  if (dir) {
-    /* k largest elements, descending order (optional: see sorted) */
-    int64_t K = sliceSize - k;
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, int64_t, ri_, dim,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         int64_t i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         if (K > 0)
-                           THTensor_(quickselect)(tmp__data, tmpi__data, K - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortdescend)(tmp__data + K, tmpi__data + K, k, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i + K];
-                           ri__data[i*ri__stride] = tmpi__data[i + K];
-                         })
-  }
-  else {
-    /* k smallest elements, ascending order (optional: see sorted) */
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, int64_t, ri_, dim,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         int64_t i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         THTensor_(quickselect)(tmp__data, tmpi__data, k - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortascend)(tmp__data, tmpi__data, k - 1, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i];
-                           ri__data[i*ri__stride] = tmpi__data[i];
-                         })
-  }
+  TH_TENSOR_DIM_APPLY3(real, t, real, rt_, int64_t, ri_, dim,
+                       TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
+                       THTensor_(topkSlice)(tmp__data, tmpi__data, t_data, t_stride,
+                                            rt__data, rt__stride, ri__data, ri__stride,
+                                            sliceSize, k, dir, sorted);)
 
   THTensor_(free)(tmpResults);
   THLongTensor_free(tmpIndices);
@@ -3649,21 +3914,52 @@ void THTensor_(catArray)(THTensor *result, THTensor **inputs, int numInputs, int
   }
   allContiguous = allContiguous && THTensor_(isContiguous)(result);
 
-  // First path is for contiguous inputs along dim 0
+  // First path is for contiguous inputs along any dimension
   // Second path for non-contiguous
   int64_t offset;
-  if (cat_dimension == 0 && allContiguous) {
-    real* result_data = result->storage->data + result->storageOffset;
+  if (allContiguous) {
+    // The result is made of `outer` blocks, each holding one slice of
+    // size[cat_dimension] * inner elements per input. Computing the offset of
+    // every slice up front lets all of them be copied in parallel, one memcpy
+    // each.
+    int64_t outer = 1, inner = 1;
+    for (int dim = 0; dim < cat_dimension; dim++) {
+      outer *= result->size[dim];
+    }
+    for (int dim = cat_dimension + 1; dim < nDims; dim++) {
+      inner *= result->size[dim];
+    }
+    int64_t result_slice = cat_dim_size * inner;
+
+    real **input_data = (real**)THAlloc(numInputs * sizeof(real*));
+    int64_t *slice_offset = (int64_t*)THAlloc(numInputs * sizeof(int64_t));
+    int64_t *slice_size = (int64_t*)THAlloc(numInputs * sizeof(int64_t));
     offset = 0;
     for (int j = 0; j < numInputs; j++) {
-      if (inputs[j]->nDimension) {
-        THTensor* input0 = inputs[j];
-        real* input0_data = input0->storage->data + input0->storageOffset;
-        int64_t input0_size = THTensor_(nElement)(input0);
-        memcpy(result_data + offset, input0_data, input0_size*sizeof(real));
-        offset += input0_size;
+      THTensor *input = inputs[j];
+      input_data[j] = input->nDimension ? input->storage->data + input->storageOffset : NULL;
+      slice_size[j] = input->nDimension ? input->size[cat_dimension] * inner : 0;
+      slice_offset[j] = offset;
+      offset += slice_size[j];
+    }
+
+    real* result_data = result->storage->data + result->storageOffset;
+    int64_t numSlices = outer * numInputs;
+    int64_t s;
+#pragma omp parallel for if(outer * result_slice > TH_OMP_OVERHEAD_THRESHOLD) private(s)
+    for (s = 0; s < numSlices; s++) {
+      int64_t o = s / numInputs;
+      int j = (int)(s % numInputs);
+      if (slice_size[j]) {
+        memcpy(result_data + o * result_slice + slice_offset[j],
+               input_data[j] + o * slice_size[j],
+               slice_size[j] * sizeof(real));
       }
     }
+
+    THFree(input_data);
+    THFree(slice_offset);
+    THFree(slice_size);
   } else {
     offset = 0;
     for (int j = 0; j < numInputs; j++) {
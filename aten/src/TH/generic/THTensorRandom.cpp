@@ -3,6 +3,41 @@
 #else
 
 #include "THGenerator.h"
+#include "THPhilox.h"
+
+#define TH_OMP_OVERHEAD_THRESHOLD_RANDOM 20000
+
+/* Fills self from the Philox stream of the generator. Element 2j and 2j+1 are
+   set by pair(block, values) from block j of a range reserved on the
+   generator, so that the blocks are generated in parallel and the result
+   doesn't depend on the number of threads. */
+template <typename F>
+static void THTensor_(philoxFill)(THTensor *self_, THGenerator *_generator, F pair)
+{
+  THTensor *self = THTensor_(newContiguous)(self_);
+  real *data = THTensor_(data)(self);
+  const int64_t size = THTensor_(nElement)(self);
+  const int64_t blocks = (size + 1) / 2;
+  uint64_t seed, offset;
+  {
+    std::lock_guard<std::mutex> lock(_generator->mutex);
+    seed = THRandom_initialSeed(_generator);
+    offset = THRandom_philoxOffset(_generator, blocks);
+  }
+  int64_t j;
+#pragma omp parallel for private(j) if (size > TH_OMP_OVERHEAD_THRESHOLD_RANDOM)
+  for (j = 0; j < blocks; j++) {
+    uint32_t block[4];
+    real values[2];
+    THPhilox_block(seed, offset + j, block);
+    pair(block, values);
+    data[2 * j] = values[0];
+    if (2 * j + 1 < size) {
+      data[2 * j + 1] = values[1];
+    }
+  }
+  THTensor_(freeCopyTo)(self, self_);
+}
 
 void THTensor_(random)(THTensor *self, THGenerator *_generator)
 {
@@ -53,8 +88,13 @@ void THTensor_(geometric)(THTensor *self, THGenerator *_generator, double p)
 
 void THTensor_(bernoulli)(THTensor *self, THGenerator *_generator, double p)
 {
-  std::lock_guard<std::mutex> lock(_generator->mutex);
-  TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_bernoulli(_generator, p););
+  THArgCheck(p >= 0 && p <= 1, 1, "must be >= 0 and <= 1");
+  THTensor_(philoxFill)(self, _generator, [p](const uint32_t *block, real *values) {
+    double x, y;
+    THPhilox_uniform2(block, &x, &y);
+    values[0] = (real)(x <= p);
+    values[1] = (real)(y <= p);
+  });
 }
 
 void THTensor_(bernoulli_FloatTensor)(THTensor *self, THGenerator *_generator, THFloatTensor *p)
@@ -88,25 +128,31 @@ void THTensor_(bernoulli_Tensor)(THTensor *self, THGenerator *_generator, THTens
 
 void THTensor_(uniform)(THTensor *self, THGenerator *_generator, double a, double b)
 {
-  std::lock_guard<std::mutex> lock(_generator->mutex);
+  THTensor_(philoxFill)(self, _generator, [a, b](const uint32_t *block, real *values) {
   #if defined(TH_REAL_IS_FLOAT)
-  TH_TENSOR_APPLY(real, self, *self_data =
-    (real)THRandom_uniformFloat(_generator, (real)a, (real)b););
+    values[0] = THPhilox_uniformFloat(block[0]) * ((real)b - (real)a) + (real)a;
+    values[1] = THPhilox_uniformFloat(block[2]) * ((real)b - (real)a) + (real)a;
   #else
-  TH_TENSOR_APPLY(real, self, *self_data =
-    (real)THRandom_uniform(_generator, a, b););
+    double x, y;
+    THPhilox_uniform2(block, &x, &y);
+    values[0] = x * (b - a) + a;
+    values[1] = y * (b - a) + a;
   #endif
+  });
 }
 
 void THTensor_(normal)(THTensor *self, THGenerator *_generator, double mean, double stddev)
 {
-  std::lock_guard<std::mutex> lock(_generator->mutex);
-  const int64_t size = THTensor_(numel)(self);
-  if (size >= 16 && THTensor_(isContiguous)(self)) {
-    THVector_(normal_fill)(self->storage->data, size, _generator, mean, stddev);
-  } else {
-    TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_normal(_generator, mean, stddev););
-  }
+  THArgCheck(stddev >= 0, 2, "standard deviation must be non-negative");
+  /* Box-Muller, both values of each pair of uniforms are used */
+  THTensor_(philoxFill)(self, _generator, [mean, stddev](const uint32_t *block, real *values) {
+    double x, y;
+    THPhilox_uniform2(block, &x, &y);
+    const double radius = sqrt(-2 * log(1 - y));
+    const double theta = 2 * M_PI * x;
+    values[0] = (real)(radius * cos(theta) * stddev + mean);
+    values[1] = (real)(radius * sin(theta) * stddev + mean);
+  });
 }
 
 void THTensor_(normal_means)(THTensor *self, THGenerator *gen, THTensor *means, double stddev)
@@ -456,12 +502,15 @@ void THTensor_(setRNGState)(THGenerator *_generator, THTensor *self)
 {
   std::lock_guard<std::mutex> lock(_generator->mutex);
   static const size_t size = sizeof(THGeneratorState);
-  THGeneratorState *rng_state;
-  THArgCheck(THTensor_(nElement)(self) == size, 1, "RNG state is wrong size");
+  static const size_t size_without_philox = offsetof(THGeneratorState, philox_offset);
+  THGeneratorState rng_state;
+  const ptrdiff_t nElement = THTensor_(nElement)(self);
+  THArgCheck(nElement == size || nElement == size_without_philox, 1, "RNG state is wrong size");
   THArgCheck(THTensor_(isContiguous)(self), 1, "RNG state needs to be contiguous");
-  rng_state = (THGeneratorState *)THTensor_(data)(self);
-  THArgCheck(THGeneratorState_isValid(rng_state), 1, "Invalid RNG state");
-  THGeneratorState_copy(&_generator->gen_state, rng_state);
+  memset(&rng_state, 0, sizeof(rng_state));
+  memcpy(&rng_state, THTensor_(data)(self), nElement);
+  THArgCheck(THGeneratorState_isValid(&rng_state), 1, "Invalid RNG state");
+  THGeneratorState_copy(&_generator->gen_state, &rng_state);
 }
 #endif
 #endif
@@ -12,6 +12,10 @@ TH_API void THVector_(muls)(real *y, const real *x, const real c, const ptrdiff_
 TH_API void THVector_(cdiv)(real *z, const real *x, const real *y, const ptrdiff_t n);
 TH_API void THVector_(divs)(real *y, const real *x, const real c, const ptrdiff_t n);
 TH_API void THVector_(copy)(real *y, const real *x, const ptrdiff_t n);
+/* y[r*ys + c] = x[c*xs + r] for r < rows, c < cols: copies a column-major
+ * block of x into a row-major block of y. Meant for cache-sized blocks. */
+TH_API void THVector_(transpose)(real *y, const ptrdiff_t ys, const real *x, const ptrdiff_t xs,
+                                 const ptrdiff_t rows, const ptrdiff_t cols);
 TH_API void THVector_(neg)(real *y, const real *x, const ptrdiff_t n);
 TH_API void THVector_(normal_fill)(real *data,
                                    const int64_t size,
@@ -23,6 +27,13 @@ TH_API void THVector_(normal_fill)(real *data,
 TH_API void THVector_(abs)(real *y, const real *x, const ptrdiff_t n);
 #endif
 
+#if defined(TH_REAL_IS_FLOAT)
+/* Conversions of contiguous arrays between THHalf and float, rounding to the
+ * nearest even half like TH_float2halfbits. */
+TH_API void THVector_(fromHalf)(real *y, const THHalf *x, const ptrdiff_t n);
+TH_API void THVector_(toHalf)(THHalf *y, const real *x, const ptrdiff_t n);
+#endif
+
 /* floating point only now */
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
 
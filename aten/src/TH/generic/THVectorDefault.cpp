@@ -19,6 +19,15 @@ void THVector_(copy_DEFAULT)(real *x, const real *y, const ptrdiff_t n) {
     x[i] = y[i];
 }
 
+void THVector_(transpose_DEFAULT)(real *y, const ptrdiff_t ys, const real *x, const ptrdiff_t xs,
+                                  const ptrdiff_t rows, const ptrdiff_t cols) {
+  ptrdiff_t r, c;
+
+  for(r = 0; r < rows; r++)
+    for(c = 0; c < cols; c++)
+      y[r*ys + c] = x[c*xs + r];
+}
+
 void THVector_(fill_DEFAULT)(real *x, const real c, const ptrdiff_t n) {
   ptrdiff_t i = 0;
 
@@ -221,6 +230,22 @@ VECTOR_IMPLEMENT_FUNCTION(abs,abs)
 #endif /* int only part */
 
 
+#if defined(TH_REAL_IS_FLOAT)
+void THVector_(fromHalf_DEFAULT)(real *y, const THHalf *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i < n; i++) {
+    y[i] = TH_half2float(x[i]);
+  }
+}
+
+void THVector_(toHalf_DEFAULT)(THHalf *y, const real *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i < n; i++) {
+    y[i] = TH_float2half(x[i]);
+  }
+}
+#endif
+
 /* floating point only now */
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
 
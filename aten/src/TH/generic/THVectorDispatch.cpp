@@ -239,6 +239,22 @@ void THVector_(copy)(real *y, const real *x, const ptrdiff_t n) {
   THVector_(copy_DISPATCHPTR)(y, x, n);
 }
 
+static void (*THVector_(transpose_DISPATCHPTR))(real *, const ptrdiff_t, const real *, const ptrdiff_t, const ptrdiff_t, const ptrdiff_t) = &THVector_(transpose_DEFAULT);
+static FunctionDescription THVector_(transpose_DISPATCHTABLE)[] = {
+  #if defined(USE_SSE2) || defined(USE_SSE3) || defined(USE_SSSE3) \
+          || defined(USE_SSE4_1) || defined(USE_SSE4_2)
+    #if defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT)
+      FUNCTION_IMPL(THVector_(transpose_SSE), SIMDExtension_SSE),
+    #endif
+  #endif
+
+  FUNCTION_IMPL(THVector_(transpose_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(transpose)(real *y, const ptrdiff_t ys, const real *x, const ptrdiff_t xs,
+                          const ptrdiff_t rows, const ptrdiff_t cols) {
+  THVector_(transpose_DISPATCHPTR)(y, ys, x, xs, rows, cols);
+}
+
 static void (*THVector_(normal_fill_DISPATCHPTR))(real *, const int64_t, THGenerator *, const real, const real) = &THVector_(normal_fill_DEFAULT);
 static FunctionDescription THVector_(normal_fill_DISPATCHTABLE)[] = {
   #if defined(TH_REAL_IS_FLOAT) && defined(USE_AVX2)
@@ -269,6 +285,33 @@ void THVector_(sigmoid)(real *y, const real *x, const ptrdiff_t n) {
 }
 #endif
 
+#if defined(TH_REAL_IS_FLOAT)
+/* Every CPU with AVX2 also has the F16C conversions, so they share its slot */
+static void (*THVector_(fromHalf_DISPATCHPTR))(real *, const THHalf *, const ptrdiff_t) = &THVector_(fromHalf_DEFAULT);
+static FunctionDescription THVector_(fromHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+      FUNCTION_IMPL(THVector_(fromHalf_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(fromHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(fromHalf)(real *y, const THHalf *x, const ptrdiff_t n) {
+  THVector_(fromHalf_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(toHalf_DISPATCHPTR))(THHalf *, const real *, const ptrdiff_t) = &THVector_(toHalf_DEFAULT);
+static FunctionDescription THVector_(toHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+      FUNCTION_IMPL(THVector_(toHalf_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(toHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(toHalf)(THHalf *y, const real *x, const ptrdiff_t n) {
+  THVector_(toHalf_DISPATCHPTR)(y, x, n);
+}
+#endif
+
 /*
  * This struct's constructor initalizes the dispatch tables. It simply checks
  * what SIMD extensions are available, and then walks the dispatch table
@@ -288,11 +331,17 @@ struct THVector_(startup) {
     INIT_DISPATCH_PTR(cdiv);
     INIT_DISPATCH_PTR(divs);
     INIT_DISPATCH_PTR(copy);
+    INIT_DISPATCH_PTR(transpose);
     INIT_DISPATCH_PTR(normal_fill);
 
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
     INIT_DISPATCH_PTR(sigmoid);
 #endif
+
+#if defined(TH_REAL_IS_FLOAT)
+    INIT_DISPATCH_PTR(fromHalf);
+    INIT_DISPATCH_PTR(toHalf);
+#endif
   }
 };
 
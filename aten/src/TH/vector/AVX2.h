@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "../THHalf.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,8 @@ void THFloatVector_normal_fill_AVX2(float *data,
                                     const float mean,
                                     const float stddev);
 void THFloatVector_sigmoid_AVX2(float *y, const float *x, const ptrdiff_t n);
+void THFloatVector_fromHalf_AVX2(float *y, const THHalf *x, const ptrdiff_t n);
+void THFloatVector_toHalf_AVX2(THHalf *y, const float *x, const ptrdiff_t n);
 #ifdef __cplusplus
 }
 #endif
@@ -135,6 +135,29 @@ static void THDoubleVector_divs_SSE(double *y, const double *x, const double c,
   }
 }
 
+static void THDoubleVector_transpose_SSE(double *y, const ptrdiff_t ys, const double *x, const ptrdiff_t xs,
+                                         const ptrdiff_t rows, const ptrdiff_t cols) {
+  ptrdiff_t r, c;
+  __m128d XMM0, XMM1;
+  for (r=0; r<=((rows)-2); r+=2) {
+    for (c=0; c<=((cols)-2); c+=2) {
+      XMM0 = _mm_loadu_pd(x + c*xs + r);
+      XMM1 = _mm_loadu_pd(x + (c+1)*xs + r);
+      _mm_storeu_pd(y + r*ys + c, _mm_unpacklo_pd(XMM0, XMM1));
+      _mm_storeu_pd(y + (r+1)*ys + c, _mm_unpackhi_pd(XMM0, XMM1));
+    }
+    for (; c<(cols); c++) {
+      y[r*ys + c] = x[c*xs + r];
+      y[(r+1)*ys + c] = x[c*xs + r + 1];
+    }
+  }
+  for (; r<(rows); r++) {
+    for (c=0; c<(cols); c++) {
+      y[r*ys + c] = x[c*xs + r];
+    }
+  }
+}
+
 static void THFloatVector_fill_SSE(float *x, const float c, const ptrdiff_t n) {
   ptrdiff_t i;
   __m128 XMM0 = _mm_set_ps1(c);
@@ -266,3 +289,32 @@ static void THFloatVector_divs_SSE(float *y, const float *x, const float c, cons
     y[i] = x[i] / c;
   }
 }
+
+static void THFloatVector_transpose_SSE(float *y, const ptrdiff_t ys, const float *x, const ptrdiff_t xs,
+                                        const ptrdiff_t rows, const ptrdiff_t cols) {
+  ptrdiff_t r, c, k;
+  __m128 XMM0, XMM1, XMM2, XMM3;
+  for (r=0; r<=((rows)-4); r+=4) {
+    for (c=0; c<=((cols)-4); c+=4) {
+      XMM0 = _mm_loadu_ps(x + c*xs + r);
+      XMM1 = _mm_loadu_ps(x + (c+1)*xs + r);
+      XMM2 = _mm_loadu_ps(x + (c+2)*xs + r);
+      XMM3 = _mm_loadu_ps(x + (c+3)*xs + r);
+      _MM_TRANSPOSE4_PS(XMM0, XMM1, XMM2, XMM3);
+      _mm_storeu_ps(y + r*ys + c, XMM0);
+      _mm_storeu_ps(y + (r+1)*ys + c, XMM1);
+      _mm_storeu_ps(y + (r+2)*ys + c, XMM2);
+      _mm_storeu_ps(y + (r+3)*ys + c, XMM3);
+    }
+    for (; c<(cols); c++) {
+      for (k=0; k<4; k++) {
+        y[(r+k)*ys + c] = x[c*xs + r + k];
+      }
+    }
+  }
+  for (; r<(rows); r++) {
+    for (c=0; c<(cols); c++) {
+      y[r*ys + c] = x[c*xs + r];
+    }
+  }
+}
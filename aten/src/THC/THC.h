@@ -6,6 +6,7 @@
 #include "THCBlas.h"
 #include "THCCachingAllocator.h"
 #include "THCCachingHostAllocator.h"
+#include "THCIpcMemHandleCache.h"
 #include "THCSleep.h"
 #include "THCStorage.h"
 #include "THCStorageCopy.h"
@@ -1,4 +1,5 @@
 #include "THCAllocator.h"
+#include "THCIpcMemHandleCache.h"
 
 static void *THCudaHostAllocator_malloc(void* ctx, ptrdiff_t size) {
   void* ptr;
@@ -32,20 +33,7 @@ static cudaError_t THCIpcAllocator_malloc(void* ctx, void** devPtr, size_t size,
 
 static cudaError_t THCIpcAllocator_free(void* ctx, void* devPtr)
 {
-  cudaError_t err;
-  int prev_device;
-  int device = (int)(int64_t)ctx;
-
-  err = cudaGetDevice(&prev_device);
-  if (err != cudaSuccess) { return err; }
-
-  err = cudaSetDevice(device);
-  if (err != cudaSuccess) { return err; }
-
-  err = cudaIpcCloseMemHandle(devPtr);
-
-  cudaSetDevice(prev_device);
-  return err;
+  return THCIpcMemHandleCache_release(devPtr);
 }
 
 THCDeviceAllocator THCIpcAllocator = {
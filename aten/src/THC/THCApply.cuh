@@ -161,6 +161,130 @@ kernelPointwiseApply3(const OffsetInfo<Ta, IndexType, ADims> a,
   }
 }
 
+// Vectorized kernels for contiguous tensors whose data is aligned to the
+// vector size: each thread loads N elements of each tensor at once, with
+// up to 128-bit loads (e.g. 4 floats or 8 halves), applies the op to them
+// in registers, and stores them back the same way.  The first tensor is
+// always stored, like every op writes; the others only when the op has
+// changed them.  The elements past the last whole vector are done one by
+// one.
+template <typename T, int N>
+struct alignas(sizeof(T) * N) THCApplyVec {
+  T val[N];
+};
+
+template <typename T, int N>
+__device__ __forceinline__ bool applyVecChanged(const THCApplyVec<T, N>& x,
+                                                const THCApplyVec<T, N>& y) {
+  const unsigned char* px = reinterpret_cast<const unsigned char*>(&x);
+  const unsigned char* py = reinterpret_cast<const unsigned char*>(&y);
+  bool changed = false;
+#pragma unroll
+  for (int i = 0; i < (int) sizeof(x); ++i) {
+    changed |= px[i] != py[i];
+  }
+  return changed;
+}
+
+template <typename Op,
+          typename Ta,
+          typename IndexType,
+          int N>
+__global__ void
+kernelPointwiseApply1Vec(Ta* a,
+                         IndexType totalElements,
+                         Op op) {
+  typedef THCApplyVec<Ta, N> VecA;
+  const IndexType numVecs = totalElements / N;
+  for (IndexType v = (IndexType) blockIdx.x * blockDim.x + threadIdx.x;
+       v < numVecs;
+       v += (IndexType) gridDim.x * blockDim.x) {
+    VecA va = reinterpret_cast<VecA*>(a)[v];
+#pragma unroll
+    for (int i = 0; i < N; ++i) {
+      op(&va.val[i]);
+    }
+    reinterpret_cast<VecA*>(a)[v] = va;
+  }
+  for (IndexType linearIndex = numVecs * N + (IndexType) blockIdx.x * blockDim.x + threadIdx.x;
+       linearIndex < totalElements;
+       linearIndex += (IndexType) gridDim.x * blockDim.x) {
+    op(&a[linearIndex]);
+  }
+}
+
+template <typename Op,
+          typename Ta, typename Tb,
+          typename IndexType,
+          int N>
+__global__ void
+kernelPointwiseApply2Vec(Ta* a, Tb* b,
+                         IndexType totalElements,
+                         Op op) {
+  typedef THCApplyVec<Ta, N> VecA;
+  typedef THCApplyVec<Tb, N> VecB;
+  const IndexType numVecs = totalElements / N;
+  for (IndexType v = (IndexType) blockIdx.x * blockDim.x + threadIdx.x;
+       v < numVecs;
+       v += (IndexType) gridDim.x * blockDim.x) {
+    VecA va = reinterpret_cast<VecA*>(a)[v];
+    const VecB vbIn = reinterpret_cast<VecB*>(b)[v];
+    VecB vb = vbIn;
+#pragma unroll
+    for (int i = 0; i < N; ++i) {
+      op(&va.val[i], &vb.val[i]);
+    }
+    reinterpret_cast<VecA*>(a)[v] = va;
+    if (applyVecChanged(vbIn, vb)) {
+      reinterpret_cast<VecB*>(b)[v] = vb;
+    }
+  }
+  for (IndexType linearIndex = numVecs * N + (IndexType) blockIdx.x * blockDim.x + threadIdx.x;
+       linearIndex < totalElements;
+       linearIndex += (IndexType) gridDim.x * blockDim.x) {
+    op(&a[linearIndex], &b[linearIndex]);
+  }
+}
+
+template <typename Op,
+          typename Ta, typename Tb, typename Tc,
+          typename IndexType,
+          int N>
+__global__ void
+kernelPointwiseApply3Vec(Ta* a, Tb* b, Tc* c,
+                         IndexType totalElements,
+                         Op op) {
+  typedef THCApplyVec<Ta, N> VecA;
+  typedef THCApplyVec<Tb, N> VecB;
+  typedef THCApplyVec<Tc, N> VecC;
+  const IndexType numVecs = totalElements / N;
+  for (IndexType v = (IndexType) blockIdx.x * blockDim.x + threadIdx.x;
+       v < numVecs;
+       v += (IndexType) gridDim.x * blockDim.x) {
+    VecA va = reinterpret_cast<VecA*>(a)[v];
+    const VecB vbIn = reinterpret_cast<VecB*>(b)[v];
+    const VecC vcIn = reinterpret_cast<VecC*>(c)[v];
+    VecB vb = vbIn;
+    VecC vc = vcIn;
+#pragma unroll
+    for (int i = 0; i < N; ++i) {
+      op(&va.val[i], &vb.val[i], &vc.val[i]);
+    }
+    reinterpret_cast<VecA*>(a)[v] = va;
+    if (applyVecChanged(vbIn, vb)) {
+      reinterpret_cast<VecB*>(b)[v] = vb;
+    }
+    if (applyVecChanged(vcIn, vc)) {
+      reinterpret_cast<VecC*>(c)[v] = vc;
+    }
+  }
+  for (IndexType linearIndex = numVecs * N + (IndexType) blockIdx.x * blockDim.x + threadIdx.x;
+       linearIndex < totalElements;
+       linearIndex += (IndexType) gridDim.x * blockDim.x) {
+    op(&a[linearIndex], &b[linearIndex], &c[linearIndex]);
+  }
+}
+
 inline dim3 getApplyBlock() {
   return dim3(THC_APPLY_THREADS_PER_BLOCK);
 }
@@ -184,6 +308,39 @@ inline bool getApplyGrid(THCState* state, uint64_t totalElements, dim3& grid) {
   return true;
 }
 
+// Ops that reach other elements through the pointers they are given, like
+// TensorCrossOp, can't work on the copies of the vectorized kernels, and
+// opt out by specializing this to false.
+template <typename Op>
+struct THCApplyVectorizable {
+  static const bool value = true;
+};
+
+// Elements per thread of the vectorized kernels: as many as fit in 16
+// bytes of the widest element type.
+template <typename Ta, typename Tb = Ta, typename Tc = Ta>
+struct THCApplyVecSize {
+  static constexpr size_t maxSize =
+    sizeof(Ta) > sizeof(Tb) ? (sizeof(Ta) > sizeof(Tc) ? sizeof(Ta) : sizeof(Tc))
+                            : (sizeof(Tb) > sizeof(Tc) ? sizeof(Tb) : sizeof(Tc));
+  static constexpr int value = (int) (16 / maxSize);
+};
+
+template <typename TensorType, int N>
+bool canApplyVectorized(THCState* state, TensorType* t) {
+  uintptr_t address = (uintptr_t) TensorUtils<TensorType>::getData(state, t);
+  return TensorUtils<TensorType>::isContiguous(state, t) &&
+    address % (sizeof(typename TensorUtils<TensorType>::DataType) * N) == 0;
+}
+
+// The vectorized kernels apply the op to copies of the elements, which
+// would break if two of the arguments were the same memory
+template <typename TensorTypeA, typename TensorTypeB>
+bool sameApplyData(THCState* state, TensorTypeA* a, TensorTypeB* b) {
+  return (void*) TensorUtils<TensorTypeA>::getData(state, a) ==
+         (void*) TensorUtils<TensorTypeB>::getData(state, b);
+}
+
 template <typename TensorTypeA,
           typename Op>
 bool THC_pointwiseApply1(THCState* state,
@@ -262,11 +419,29 @@ bool THC_pointwiseApply1(THCState* state,
     }                                           \
   }
 
+  typedef typename TensorUtils<TensorTypeA>::DataType Ta;
+  const int vecSize = THCApplyVecSize<Ta>::value;
+
+  if (THCApplyVectorizable<Op>::value &&
+      canApplyVectorized<TensorTypeA, vecSize>(state, a)) {
+    if (!getApplyGrid(state, THCCeilDiv((uint64_t) totalElements, (uint64_t) vecSize), grid)) {
+      return false;
+    }
+    Ta* aData = TensorUtils<TensorTypeA>::getData(state, a);
+    if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a)) {
+      kernelPointwiseApply1Vec<Op, Ta, unsigned int, vecSize>
+        <<<grid, block, 0, THCState_getCurrentStream(state)>>>(
+          aData, (unsigned int) totalElements, op);
+    } else {
+      kernelPointwiseApply1Vec<Op, Ta, uint64_t, vecSize>
+        <<<grid, block, 0, THCState_getCurrentStream(state)>>>(
+          aData, (uint64_t) totalElements, op);
+    }
   // Can we use 32-bit integer math in the kernel (the linear ID for the copy
   // and the resulting non-linear offset is all computable using 32-bit math?)
   // We also use unsigned index math in the kernel, as signed div/mod has
   // additional overhead.
-  if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a)) {
+  } else if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a)) {
     TensorInfo<typename TensorUtils<TensorTypeA>::DataType, unsigned int> aInfo =
       getTensorInfo<TensorTypeA, unsigned int>(state, a);
     rearrangeDims(&aInfo);
@@ -437,7 +612,30 @@ bool THC_pointwiseApply2(THCState* state,
     }                                           \
   }
 
-  if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a) &&
+  typedef typename TensorUtils<TensorTypeA>::DataType Ta;
+  typedef typename TensorUtils<TensorTypeB>::DataType Tb;
+  const int vecSize = THCApplyVecSize<Ta, Tb>::value;
+
+  if (THCApplyVectorizable<Op>::value &&
+      canApplyVectorized<TensorTypeA, vecSize>(state, a) &&
+      canApplyVectorized<TensorTypeB, vecSize>(state, b) &&
+      !sameApplyData(state, a, b)) {
+    if (!getApplyGrid(state, THCCeilDiv((uint64_t) totalElements, (uint64_t) vecSize), grid)) {
+      return false;
+    }
+    Ta* aData = TensorUtils<TensorTypeA>::getData(state, a);
+    Tb* bData = TensorUtils<TensorTypeB>::getData(state, b);
+    if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a) &&
+        TensorUtils<TensorTypeB>::canUse32BitIndexMath(state, b)) {
+      kernelPointwiseApply2Vec<Op, Ta, Tb, unsigned int, vecSize>
+        <<<grid, block, 0, THCState_getCurrentStream(state)>>>(
+          aData, bData, (unsigned int) totalElements, op);
+    } else {
+      kernelPointwiseApply2Vec<Op, Ta, Tb, uint64_t, vecSize>
+        <<<grid, block, 0, THCState_getCurrentStream(state)>>>(
+          aData, bData, (uint64_t) totalElements, op);
+    }
+  } else if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a) &&
       TensorUtils<TensorTypeB>::canUse32BitIndexMath(state, b)) {
     TensorInfo<typename TensorUtils<TensorTypeA>::DataType, unsigned int> aInfo =
       getTensorInfo<TensorTypeA, unsigned int>(state, a);
@@ -661,7 +859,36 @@ bool THC_pointwiseApply3(THCState* state,
     }                                           \
   }
 
-  if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a) &&
+  typedef typename TensorUtils<TensorTypeA>::DataType Ta;
+  typedef typename TensorUtils<TensorTypeB>::DataType Tb;
+  typedef typename TensorUtils<TensorTypeC>::DataType Tc;
+  const int vecSize = THCApplyVecSize<Ta, Tb, Tc>::value;
+
+  if (THCApplyVectorizable<Op>::value &&
+      canApplyVectorized<TensorTypeA, vecSize>(state, a) &&
+      canApplyVectorized<TensorTypeB, vecSize>(state, b) &&
+      canApplyVectorized<TensorTypeC, vecSize>(state, c) &&
+      !sameApplyData(state, a, b) &&
+      !sameApplyData(state, a, c) &&
+      !sameApplyData(state, b, c)) {
+    if (!getApplyGrid(state, THCCeilDiv((uint64_t) totalElements, (uint64_t) vecSize), grid)) {
+      return false;
+    }
+    Ta* aData = TensorUtils<TensorTypeA>::getData(state, a);
+    Tb* bData = TensorUtils<TensorTypeB>::getData(state, b);
+    Tc* cData = TensorUtils<TensorTypeC>::getData(state, c);
+    if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a) &&
+        TensorUtils<TensorTypeB>::canUse32BitIndexMath(state, b) &&
+        TensorUtils<TensorTypeC>::canUse32BitIndexMath(state, c)) {
+      kernelPointwiseApply3Vec<Op, Ta, Tb, Tc, unsigned int, vecSize>
+        <<<grid, block, 0, THCState_getCurrentStream(state)>>>(
+          aData, bData, cData, (unsigned int) totalElements, op);
+    } else {
+      kernelPointwiseApply3Vec<Op, Ta, Tb, Tc, uint64_t, vecSize>
+        <<<grid, block, 0, THCState_getCurrentStream(state)>>>(
+          aData, bData, cData, (uint64_t) totalElements, op);
+    }
+  } else if (TensorUtils<TensorTypeA>::canUse32BitIndexMath(state, a) &&
       TensorUtils<TensorTypeB>::canUse32BitIndexMath(state, b) &&
       TensorUtils<TensorTypeC>::canUse32BitIndexMath(state, c)) {
     TensorInfo<typename TensorUtils<TensorTypeA>::DataType, unsigned int> aInfo =
@@ -229,6 +229,36 @@ void adjustLd(char transa, char transb, int64_t m, int64_t n, int64_t k, int64_t
 }
 
 /* Level 3 */
+
+/* Lets the float GEMMs run while it lives use tensor cores, rounding their
+   inputs to half precision, when THCState_setTensorOpFloatMath is on and the
+   current device has tensor cores */
+struct TensorOpFloatMathGuard
+{
+  TensorOpFloatMathGuard(THCState *state, cublasHandle_t handle) : handle(handle), enabled(false)
+  {
+#if CUDA_VERSION >= 9000
+    if (THCState_getTensorOpFloatMath(state) &&
+        THCState_getCurrentDeviceProperties(state)->major >= 7) {
+      THCublasCheck(cublasSetMathMode(handle, CUBLAS_TENSOR_OP_MATH));
+      enabled = true;
+    }
+#endif
+  }
+
+  ~TensorOpFloatMathGuard()
+  {
+#if CUDA_VERSION >= 9000
+    if (enabled) {
+      cublasSetMathMode(handle, CUBLAS_DEFAULT_MATH);
+    }
+#endif
+  }
+
+  cublasHandle_t handle;
+  bool enabled;
+};
+
 void THCudaBlas_Sgemm(THCState *state, char transa, char transb, int64_t m, int64_t n, int64_t k, float alpha, float *a, int64_t lda, float *b, int64_t ldb, float beta, float *c, int64_t ldc)
 {
   adjustLd(transa, transb, m, n, k, &lda, &ldb, &ldc);
@@ -246,6 +276,7 @@ void THCudaBlas_Sgemm(THCState *state, char transa, char transb, int64_t m, int6
 
     cublasHandle_t handle = THCState_getCurrentBlasHandle(state);
     cublasSetStream(handle, THCState_getCurrentStream(state));
+    TensorOpFloatMathGuard mathGuard(state, handle);
     THCublasCheck(cublasSgemm(handle, opa, opb, i_m, i_n, i_k, &alpha, a, i_lda, b, i_ldb, &beta, c, i_ldc));
     return;
   }
@@ -381,6 +412,7 @@ void THCudaBlas_SgemmBatched(THCState *state, char transa, char transb, int64_t
 
   cublasHandle_t handle = THCState_getCurrentBlasHandle(state);
   cublasSetStream(handle, THCState_getCurrentStream(state));
+  TensorOpFloatMathGuard mathGuard(state, handle);
   THCublasCheck(cublasSgemmBatched(handle,
                                    opa, opb, (int)m, (int)n, (int)k,
                                    &alpha, a, (int)lda, b, (int)ldb, &beta, c, (int)ldc,
@@ -405,6 +437,7 @@ void THCudaBlas_SgemmStridedBatched(THCState *state, char transa, char transb, i
 
   cublasHandle_t handle = THCState_getCurrentBlasHandle(state);
   cublasSetStream(handle, THCState_getCurrentStream(state));
+  TensorOpFloatMathGuard mathGuard(state, handle);
   THCublasCheck(cublasSgemmStridedBatched(handle,
                                    opa, opb, (int)m, (int)n, (int)k,
                                    &alpha, a, (int)lda, strideA, b, (int)ldb, strideB, &beta, c, (int)ldc, strideC,
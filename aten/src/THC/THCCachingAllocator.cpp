@@ -2,6 +2,9 @@
 
 #include <cuda_runtime_api.h>
 #include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <deque>
 #include <map>
 #include <memory>
@@ -10,19 +13,39 @@
 #include <unordered_map>
 #include <vector>
 
+// Static tracepoints on the allocation paths, from the caffe2 USDT provider
+// when the build has it (see aten/src/ATen/CMakeLists.txt). They are nops
+// unless a tracer is attached.
+#ifdef THC_STATIC_TRACEPOINTS
+#include "caffe2/core/static_tracepoint.h"
+#define THC_SDT(name, ...) CAFFE_SDT(name, ##__VA_ARGS__)
+#else
+#define THC_SDT(name, ...) do {} while (0)
+#endif
+
 //
 // Yet another caching allocator for CUDA device allocations.
 //
 // - Allocations are associated with a stream. Once freed, blocks can be
-//   re-allocated on the same stream, but not on any other stream.
+//   re-allocated on the same stream, but not on any other stream, unless
+//   cross-stream reuse is enabled (see below).
 // - The allocator attempts to find the smallest cached block that will fit the
 //   requested size. If the block is larger than the requested size, it may be
 //   split. If no block is found, the allocator will delegate to cudaMalloc.
 // - If the cudaMalloc fails, the allocator will free all cached blocks that
 //   are not split and retry the allocation.
-// - Large (>1MB) and small allocation requests are handled separately. Large
-//   allocation requests can be filled by a cudaMalloc call of the exact size.
-//   Small requests will allocate and split a 1MB buffer, if necessary.
+// - Large (>1MB) and small allocation requests are handled separately. Small
+//   requests will allocate and split a 1MB buffer, if necessary. Large
+//   requests smaller than 10MB allocate and split a shared 20MB buffer, and
+//   larger ones are filled by a cudaMalloc call rounded up to a multiple of
+//   2MB. Sharing segments between requests of similar sizes keeps the number
+//   of distinct segment sizes small, which matters for workloads with
+//   variable shapes: a freed block can be reused by any request that fits in
+//   it, instead of only by one of exactly the same rounded size.
+// - Freed blocks are merged with their free neighbours within the same
+//   segment. THCCachingAllocator_freeBlockStats reports how fragmented the
+//   cache of a device is (largest free block, and a histogram of the free
+//   blocks bucketed into power-of-two size classes).
 //
 // With this allocator, allocations and frees should logically be considered
 // "usages" of the memory segment associated with streams, just like kernel
@@ -34,6 +57,27 @@
 // ensure that the block is not reused before each recorded stream completes
 // work.
 //
+// By default every stream has its own pool of free blocks. When cross-stream
+// reuse is enabled (THC_CACHING_ALLOCATOR_CROSS_STREAM=1 or
+// THCCachingAllocator_setCrossStreamReuse), an event is recorded on the
+// allocation stream whenever a block is freed. A request on another stream
+// that can't be served from its own pool takes a free block of a different
+// stream whose event has completed, before falling back to cudaMalloc. This
+// never blocks: the events are only queried, and the workloads that keep
+// every stream busy simply fall back to the per-stream behaviour.
+//
+// Tensors are shared with other processes by exporting the whole segment
+// they belong to. THCCachingAllocator_getIpcMemHandle keeps the handle of a
+// segment from its first export until the segment is returned to CUDA, so
+// that sharing the many tensors carved out of one segment doesn't call
+// cudaIpcGetMemHandle for each of them.
+//
+// The replays of a CUDA graph access the addresses its capture used. Between
+// THCCachingAllocator_beginGraphCapture and endGraphCapture, the blocks
+// allocated and freed by the capturing thread belong to the graph: once
+// freed they are kept out of the cache, without events, until
+// THCCachingAllocator_releaseGraph returns them after the last replay.
+//
 
 
 namespace {
@@ -41,19 +85,23 @@ namespace {
 typedef std::shared_ptr<THCStream> THCStreamPtr;
 typedef std::set<THCStreamPtr> stream_set;
 
-const size_t kRoundSmall = 512;     // round up small allocs to 512 bytes
-const size_t kRoundLarge = 131072;  // round up large allocs to 128 KiB
-const size_t kSmallAlloc = 1048576; // largest "small" allocation is 1 MiB
+const size_t kRoundSmall = 512;       // round up small allocs to 512 bytes
+const size_t kRoundLarge = 131072;    // round up large allocs to 128 KiB
+const size_t kSmallAlloc = 1048576;   // largest "small" allocation is 1 MiB
+const size_t kMinLargeAlloc = 10485760; // allocations under 10 MiB share a buffer
+const size_t kLargeBuffer = 20971520; // size of the shared large buffer (20 MiB)
+const size_t kRoundSegment = 2097152; // round up dedicated segments to 2 MiB
 
 struct DeviceStats {
   uint64_t   amount_allocated;      // total amount allocated in bytes
   uint64_t   max_amount_allocated;  // max total amount allocated in bytes
   uint64_t   amount_cached;         // total amount in cache in bytes
   uint64_t   max_amount_cached;     // max total amount in cache in bytes
+  uint64_t   num_cuda_mallocs;      // number of cudaMalloc calls
 
   DeviceStats() :
       amount_allocated(0), max_amount_allocated(0),
-      amount_cached(0), max_amount_cached(0) { }
+      amount_cached(0), max_amount_cached(0), num_cuda_mallocs(0) { }
 
   void increaseAllocated(size_t delta) {
     amount_allocated += delta;
@@ -84,10 +132,20 @@ struct Block {
   Block*        prev;        // prev block if split from a larger allocation
   Block*        next;        // next block if split from a larger allocation
   int           event_count; // number of outstanding CUDA events
+  cudaEvent_t   free_event;  // recorded on stream when freed (cross-stream reuse)
+  bool          idle;        // no pending work on the memory, on any stream
+  int           graph;       // CUDA graph replaying accesses to it, or 0
 
   Block(int device, cudaStream_t stream, size_t size, char* ptr=NULL) :
       device(device), stream(stream), stream_uses(), size(size), ptr(ptr),
-      allocated(0), prev(NULL), next(NULL), event_count(0) { }
+      allocated(0), prev(NULL), next(NULL), event_count(0), free_event(NULL),
+      idle(false), graph(0) { }
+
+  ~Block() {
+    if (free_event) {
+      cudaEventDestroy(free_event);
+    }
+  }
 };
 
 static bool BlockComparator(const Block* a, const Block* b)
@@ -104,6 +162,9 @@ static bool BlockComparator(const Block* a, const Block* b)
   return (uintptr_t)a->ptr < (uintptr_t)b->ptr;
 }
 
+// graph captured by the thread, or 0
+thread_local int capturing_graph = 0;
+
 } // namespace
 
 struct THCCachingAllocator
@@ -132,9 +193,26 @@ struct THCCachingAllocator
   // outstanding cuda events
   std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
 
+  // IPC handles of the exported segments, by base address
+  std::unordered_map<void*, cudaIpcMemHandle_t> ipc_handles;
+
+  // whether free blocks may be handed over to other streams
+  bool cross_stream_reuse;
+
+  // freed blocks of the CUDA graphs, kept until the graphs are released
+  std::unordered_map<int, std::vector<Block*>> graph_blocks;
+  int next_graph;
+
   THCCachingAllocator() :
       large_blocks(BlockComparator),
-      small_blocks(BlockComparator) {}
+      small_blocks(BlockComparator),
+      cross_stream_reuse(false),
+      next_graph(1) {
+    const char* env = getenv("THC_CACHING_ALLOCATOR_CROSS_STREAM");
+    if (env && strcmp(env, "0") != 0) {
+      cross_stream_reuse = true;
+    }
+  }
 
   DeviceStats &get_stats_for_device(int device) {
     THAssert(device >= 0);
@@ -166,7 +244,7 @@ struct THCCachingAllocator
     DeviceStats &stats = get_stats_for_device(device);
 
     Block search_key(device, stream, size);
-    auto& free_blocks = small ? large_blocks : small_blocks;
+    auto& free_blocks = get_free_blocks(size);
 
     Block* block = NULL;
     Block* remaining = NULL;
@@ -175,15 +253,22 @@ struct THCCachingAllocator
     if (it != free_blocks.end() && (*it)->device == device && (*it)->stream == stream) {
       block = *it;
       free_blocks.erase(it);
+    } else if (cross_stream_reuse &&
+               (block = find_idle_block(free_blocks, device, stream, size)) != NULL) {
+      free_blocks.erase(block);
+      block->stream = stream;
     } else {
       void* ptr;
-      size_t alloc_size = small ? kSmallAlloc : size;
+      size_t alloc_size = get_allocation_size(size);
+      THC_SDT(thc_cuda_malloc_start, device, alloc_size, stream);
       err = cuda_malloc_retry(device, &ptr, alloc_size);
+      THC_SDT(thc_cuda_malloc_end, device, alloc_size, stream, (int)err);
       if (err != cudaSuccess) {
         return err;
       }
       stats.increaseCached(alloc_size);
       block = new Block(device, stream, alloc_size, (char*)ptr);
+      block->idle = true;
     }
 
     if (block->size - size >= (small ? kRoundSmall : kSmallAlloc + 1)) {
@@ -203,11 +288,14 @@ struct THCCachingAllocator
     }
 
     block->allocated = true;
+    block->idle = false;
+    block->graph = capturing_graph;
     allocated_blocks[block->ptr] = block;
 
     *devPtr = (void*)block->ptr;
 
     stats.increaseAllocated(block->size);
+    THC_SDT(thc_malloc, device, block->size, stream, block->ptr);
     return cudaSuccess;
   }
 
@@ -226,8 +314,24 @@ struct THCCachingAllocator
     Block* block = it->second;
     allocated_blocks.erase(it);
     block->allocated = false;
+    THC_SDT(thc_free, block->device, block->size, block->stream, block->ptr);
 
     get_stats_for_device(block->device).decreaseAllocated(block->size);
+    if (!block->graph) {
+      block->graph = capturing_graph;
+    }
+    if (block->graph) {
+      graph_blocks[block->graph].push_back(block);
+      return cudaSuccess;
+    }
+    // Blocks that already have an event keep it up to date, so that it is
+    // never stale if cross-stream reuse is toggled at runtime
+    if (cross_stream_reuse || block->free_event) {
+      cudaError_t err = record_free_event(block);
+      if (err != cudaSuccess) {
+        return err;
+      }
+    }
     if (!block->stream_uses.empty()) {
       return insert_events(block);
     }
@@ -236,6 +340,58 @@ struct THCCachingAllocator
     return cudaSuccess;
   }
 
+  int beginGraphCapture()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    THAssertMsg(!capturing_graph, "a graph is already captured by the thread");
+    capturing_graph = next_graph++;
+    return capturing_graph;
+  }
+
+  void endGraphCapture()
+  {
+    capturing_graph = 0;
+  }
+
+  /** returns the blocks of a graph whose replays are all queued */
+  cudaError_t releaseGraph(int graph)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& it : allocated_blocks) {
+      if (it.second->graph == graph) {
+        it.second->graph = 0;
+      }
+    }
+    auto it = graph_blocks.find(graph);
+    if (it == graph_blocks.end()) {
+      return cudaSuccess;
+    }
+    std::vector<Block*> blocks(std::move(it->second));
+    graph_blocks.erase(it);
+    cudaError_t err = cudaSuccess;
+    for (Block* block : blocks) {
+      block->graph = 0;
+      if (err != cudaSuccess) {
+        continue;
+      }
+      if (cross_stream_reuse || block->free_event) {
+        err = record_free_event(block);
+      }
+      if (err == cudaSuccess && !block->stream_uses.empty()) {
+        err = insert_events(block);
+      } else if (err == cudaSuccess) {
+        free_block(block);
+      }
+    }
+    return err;
+  }
+
+  void setCrossStreamReuse(bool enabled)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cross_stream_reuse = enabled;
+  }
+
   /** returns cached blocks to the system allocator */
   cudaError_t emptyCache()
   {
@@ -273,6 +429,21 @@ struct THCCachingAllocator
     return basePtr;
   }
 
+  /** returns the base address of the segment of ptr and its IPC handle */
+  void* getIpcMemHandle(void* ptr, size_t* outSize, cudaIpcMemHandle_t* handle)
+  {
+    void* basePtr = getBaseAllocation(ptr, outSize);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ipc_handles.find(basePtr);
+    if (it == ipc_handles.end()) {
+      cudaIpcMemHandle_t new_handle;
+      THCudaCheck(cudaIpcGetMemHandle(&new_handle, basePtr));
+      it = ipc_handles.insert({basePtr, new_handle}).first;
+    }
+    *handle = it->second;
+    return basePtr;
+  }
+
   // Accumulates sizes of all memory blocks for given device in given free list
   void cacheInfoAux(FreeBlocks& blocks, int dev_id, size_t* total, size_t* largest)
   {
@@ -314,8 +485,7 @@ struct THCCachingAllocator
   void free_block(Block* block)
   {
     THAssert(!block->allocated && block->event_count == 0);
-    bool small = block->size <= kSmallAlloc;
-    auto& free_blocks = small ? large_blocks : small_blocks;
+    auto& free_blocks = get_free_blocks(block->size);
     try_merge_blocks(block, block->prev, free_blocks);
     try_merge_blocks(block, block->next, free_blocks);
     free_blocks.insert(block);
@@ -324,7 +494,13 @@ struct THCCachingAllocator
   /** combine previously split blocks */
   void try_merge_blocks(Block* dst, Block* src, FreeBlocks& free_blocks)
   {
-    if (!src || src->allocated || src->event_count > 0) {
+    if (!src || src->allocated || src->event_count > 0 || src->graph) {
+      return;
+    }
+    // Neighbours can end up on different streams with cross-stream reuse.
+    // The merged block keeps the stream of dst, which is only safe if
+    // nothing is still pending on src.
+    if (src->stream != dst->stream && !is_idle(src)) {
       return;
     }
     if (dst->prev == src) {
@@ -344,6 +520,117 @@ struct THCCachingAllocator
     delete src;
   }
 
+  FreeBlocks& get_free_blocks(size_t size)
+  {
+    return size <= kSmallAlloc ? small_blocks : large_blocks;
+  }
+
+  /** size of the cudaMalloc backing a request of (rounded) size */
+  size_t get_allocation_size(size_t size)
+  {
+    if (size <= kSmallAlloc) {
+      return kSmallAlloc;
+    } else if (size < kMinLargeAlloc) {
+      return kLargeBuffer;
+    } else {
+      return kRoundSegment * ((size + kRoundSegment - 1) / kRoundSegment);
+    }
+  }
+
+  void freeBlockStatsAux(FreeBlocks& blocks, int dev_id, THCCachingAllocatorFreeStats* stats)
+  {
+    Block search_key(dev_id, 0, 0);
+    auto it = blocks.lower_bound(&search_key);
+    for (; it != blocks.end() && (*it)->device == dev_id; ++it) {
+      size_t blocksize = (*it)->size;
+      int size_class = 0;
+      while (size_class < THC_CACHING_ALLOCATOR_SIZE_CLASSES - 1 &&
+             (blocksize >> (size_class + 1)) != 0) {
+        size_class++;
+      }
+      stats->num_free_blocks++;
+      stats->amount_free += blocksize;
+      stats->largest_free_block = std::max<uint64_t>(stats->largest_free_block, blocksize);
+      stats->size_class_blocks[size_class]++;
+      stats->size_class_bytes[size_class] += blocksize;
+    }
+  }
+
+  void freeBlockStats(int dev_id, THCCachingAllocatorFreeStats* stats)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    memset(stats, 0, sizeof(*stats));
+    freeBlockStatsAux(large_blocks, dev_id, stats);
+    freeBlockStatsAux(small_blocks, dev_id, stats);
+  }
+
+  /** records an event marking the last use of the block on its stream */
+  cudaError_t record_free_event(Block* block)
+  {
+    int prev_device;
+    cudaError_t err = cudaGetDevice(&prev_device);
+    if (err != cudaSuccess) return err;
+    if (prev_device != block->device) {
+      err = cudaSetDevice(block->device);
+      if (err != cudaSuccess) return err;
+    }
+    if (!block->free_event) {
+      err = cudaEventCreateWithFlags(&block->free_event, cudaEventDisableTiming);
+    }
+    if (err == cudaSuccess) {
+      err = cudaEventRecord(block->free_event, block->stream);
+    }
+    if (prev_device != block->device) {
+      cudaSetDevice(prev_device);
+    }
+    return err;
+  }
+
+  /** true if the free block can be handed over to any stream */
+  bool is_idle(Block* block)
+  {
+    if (!block->idle && block->free_event && block->stream_uses.empty() &&
+        block->event_count == 0) {
+      cudaError_t err = cudaEventQuery(block->free_event);
+      if (err == cudaSuccess) {
+        block->idle = true;
+      } else {
+        // cudaErrorNotReady, or an error that will resurface elsewhere
+        cudaGetLastError();
+      }
+    }
+    return block->idle;
+  }
+
+  /** finds the smallest idle free block of another stream which fits size */
+  Block* find_idle_block(FreeBlocks& blocks, int device, cudaStream_t stream, size_t size)
+  {
+    Block* best = NULL;
+    Block start_key(device, NULL, 0);
+    auto it = blocks.lower_bound(&start_key);
+    while (it != blocks.end() && (*it)->device == device) {
+      cudaStream_t block_stream = (*it)->stream;
+      if (block_stream != stream) {
+        Block size_key(device, block_stream, size);
+        for (auto jt = blocks.lower_bound(&size_key);
+             jt != blocks.end() && (*jt)->device == device && (*jt)->stream == block_stream;
+             ++jt) {
+          if (best && (*jt)->size >= best->size) {
+            break;
+          }
+          if (is_idle(*jt)) {
+            best = *jt;
+            break;
+          }
+        }
+      }
+      // skip to the first block of the next stream
+      Block next_key(device, block_stream, SIZE_MAX, (char*)UINTPTR_MAX);
+      it = blocks.upper_bound(&next_key);
+    }
+    return best;
+  }
+
   size_t round_size(size_t size)
   {
     if (size < kRoundSmall) {
@@ -360,13 +647,17 @@ struct THCCachingAllocator
   {
     // Try cudaMalloc. If cudaMalloc fails, frees all non-split cached blocks
     // and retries.
+    DeviceStats &stats = get_stats_for_device(device);
+    stats.num_cuda_mallocs++;
     cudaError_t err = cudaMalloc(devPtr, size);
     if (err != cudaSuccess) {
       cudaGetLastError();
+      THC_SDT(thc_free_cached_blocks, device, size);
       err = free_cached_blocks(device);
       if (err != cudaSuccess) {
         return err;
       }
+      stats.num_cuda_mallocs++;
       err = cudaMalloc(devPtr, size);
       if (err != cudaSuccess) {
         return err;
@@ -407,6 +698,7 @@ struct THCCachingAllocator
           return err;
         }
         get_stats_for_device(block->device).decreaseCached(block->size);
+        ipc_handles.erase(block->ptr);
         auto cur = it;
         ++it;
         blocks.erase(cur);
@@ -535,6 +827,11 @@ THC_API void* THCCachingAllocator_getBaseAllocation(void *ptr, size_t *size)
   return caching_allocator.getBaseAllocation(ptr, size);
 }
 
+THC_API void* THCCachingAllocator_getIpcMemHandle(void *ptr, size_t *size, cudaIpcMemHandle_t *handle)
+{
+  return caching_allocator.getIpcMemHandle(ptr, size, handle);
+}
+
 THC_API void THCCachingAllocator_recordStream(void *ptr, THCStream* stream)
 {
   caching_allocator.recordStream(ptr, stream);
@@ -572,3 +869,34 @@ THC_API uint64_t THCCachingAllocator_maxMemoryCached(int device) {
   assertValidDevice(device);
   return caching_allocator.get_stats_for_device(device).max_amount_cached;
 }
+
+THC_API uint64_t THCCachingAllocator_numCudaMallocs(int device) {
+  assertValidDevice(device);
+  return caching_allocator.get_stats_for_device(device).num_cuda_mallocs;
+}
+
+THC_API int THCCachingAllocator_beginGraphCapture(void)
+{
+  return caching_allocator.beginGraphCapture();
+}
+
+THC_API void THCCachingAllocator_endGraphCapture(void)
+{
+  caching_allocator.endGraphCapture();
+}
+
+THC_API void THCCachingAllocator_releaseGraph(int graph)
+{
+  THCudaCheck(caching_allocator.releaseGraph(graph));
+}
+
+THC_API void THCCachingAllocator_setCrossStreamReuse(int enabled)
+{
+  caching_allocator.setCrossStreamReuse(enabled != 0);
+}
+
+THC_API void THCCachingAllocator_freeBlockStats(int device, THCCachingAllocatorFreeStats* stats)
+{
+  assertValidDevice(device);
+  caching_allocator.freeBlockStats(device, stats);
+}
@@ -8,13 +8,40 @@
 #include "THCGeneral.h"
 #include "THCStream.h"
 
+// Number of size classes reported by THCCachingAllocator_freeBlockStats.
+// Class i holds the free blocks whose size is in [2^i, 2^(i+1)) bytes.
+#define THC_CACHING_ALLOCATOR_SIZE_CLASSES 48
+
+typedef struct THCCachingAllocatorFreeStats {
+  uint64_t num_free_blocks;     // number of cached blocks not in use
+  uint64_t amount_free;         // total size of these blocks in bytes
+  uint64_t largest_free_block;  // size of the largest of them in bytes
+  uint64_t size_class_blocks[THC_CACHING_ALLOCATOR_SIZE_CLASSES];
+  uint64_t size_class_bytes[THC_CACHING_ALLOCATOR_SIZE_CLASSES];
+} THCCachingAllocatorFreeStats;
+
 THC_API THCDeviceAllocator* THCCachingAllocator_get(void);
 THC_API void* THCCachingAllocator_getBaseAllocation(void *ptr, size_t *size);
+// Like getBaseAllocation, and fills handle with the IPC handle of the
+// segment, which is only created on its first export.
+THC_API void* THCCachingAllocator_getIpcMemHandle(void *ptr, size_t *size, cudaIpcMemHandle_t *handle);
 THC_API void THCCachingAllocator_recordStream(void *ptr, THCStream* stream);
 THC_API uint64_t THCCachingAllocator_currentMemoryAllocated(int device);
 THC_API uint64_t THCCachingAllocator_maxMemoryAllocated(int device);
 THC_API uint64_t THCCachingAllocator_currentMemoryCached(int device);
 THC_API uint64_t THCCachingAllocator_maxMemoryCached(int device);
+// Number of cudaMalloc calls the allocator made for the device: it only
+// grows when a request can't be served from the cache.
+THC_API uint64_t THCCachingAllocator_numCudaMallocs(int device);
+THC_API void THCCachingAllocator_freeBlockStats(int device, THCCachingAllocatorFreeStats* stats);
+THC_API void THCCachingAllocator_setCrossStreamReuse(int enabled);
+// The memory the calling thread allocates or frees between begin and end
+// belongs to the returned CUDA graph, whose replays access it: it isn't
+// reused before the graph is released. The caller releases it once the last
+// replay is ordered before the next work of the allocation streams.
+THC_API int THCCachingAllocator_beginGraphCapture(void);
+THC_API void THCCachingAllocator_endGraphCapture(void);
+THC_API void THCCachingAllocator_releaseGraph(int graph);
 
 #if (__cplusplus >= 201103L) || (defined(_MSC_VER) && defined(__cplusplus))
 THC_API std::mutex* THCCachingAllocator_getCudaFreeMutex();
@@ -2,6 +2,7 @@
 
 #include <cuda_runtime_api.h>
 #include <deque>
+#include <cstdlib>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -14,6 +15,18 @@ namespace {
 
 typedef std::shared_ptr<THCStream> THCStreamPtr;
 
+// allocations are rounded up to a power of two, at least this large
+const size_t kMinBlockSize = 512;
+
+static size_t roundSize(size_t size)
+{
+  size_t rounded = kMinBlockSize;
+  while (rounded < size) {
+    rounded *= 2;
+  }
+  return rounded;
+}
+
 struct BlockSize
 {
   size_t  size; // allocation size
@@ -25,11 +38,13 @@ struct BlockSize
 struct Block : public BlockSize
 {
   bool  allocated;    // true if the block is currently allocated
+  bool  in_arena;     // true if the block is carved out of the arena
   int   event_count;  // number of outstanding cuda events
   std::set<THCStreamPtr> streams;
 
-  Block(size_t size, void* ptr, bool allocated) :
-      BlockSize(size, ptr), allocated(allocated), event_count(0), streams() {}
+  Block(size_t size, void* ptr, bool allocated, bool in_arena) :
+      BlockSize(size, ptr), allocated(allocated), in_arena(in_arena),
+      event_count(0), streams() {}
 };
 
 static bool BlockComparator(const BlockSize& a, const BlockSize& b)
@@ -57,7 +72,41 @@ struct HostAllocator
   // outstanding cuda events
   std::deque<std::pair<cudaEvent_t, void*>> cuda_events;
 
-  HostAllocator() : available(BlockComparator) {}
+  // pinned memory allocated at once when the first block is requested, of
+  // THC_CACHING_HOST_ALLOCATOR_ARENA_MB megabytes if set, from which new
+  // blocks are carved until it runs out. It is never freed.
+  bool arena_initialized;
+  char* arena;
+  size_t arena_size;
+  size_t arena_used;
+
+  THCCachingHostAllocatorStats stats;
+
+  HostAllocator() : available(BlockComparator), arena_initialized(false),
+      arena(NULL), arena_size(0), arena_used(0), stats() {}
+
+  cudaError_t initArena()
+  {
+    arena_initialized = true;
+    const char* env = getenv("THC_CACHING_HOST_ALLOCATOR_ARENA_MB");
+    if (!env) {
+      return cudaSuccess;
+    }
+    size_t size = (size_t)strtoull(env, NULL, 10) << 20;
+    if (size == 0) {
+      return cudaSuccess;
+    }
+    void* ptr = NULL;
+    cudaError_t err = cudaHostAlloc(&ptr, size, cudaHostAllocDefault);
+    if (err != cudaSuccess) {
+      return err;
+    }
+    arena = (char*)ptr;
+    arena_size = size;
+    stats.arena_bytes = size;
+    stats.cached_bytes += size;
+    return cudaSuccess;
+  }
 
   cudaError_t malloc(void** ptr, size_t size)
   {
@@ -68,6 +117,17 @@ struct HostAllocator
     if (err != cudaSuccess) {
       return err;
     }
+    if (!arena_initialized) {
+      err = initArena();
+      if (err != cudaSuccess) {
+        return err;
+      }
+    }
+
+    // variable sizes are rounded up to a few size classes, so that the
+    // blocks are reused
+    size = roundSize(size);
+    stats.allocations++;
 
     // search for the smallest block which can hold this allocation
     BlockSize search_key(size);
@@ -78,6 +138,18 @@ struct HostAllocator
       block.allocated = true;
       *ptr = block.ptr;
       available.erase(it);
+      stats.cache_hits++;
+      stats.allocated_bytes += block.size;
+      return cudaSuccess;
+    }
+
+    // block sizes are multiples of kMinBlockSize, so the blocks in the
+    // arena stay aligned
+    if (arena_size - arena_used >= size) {
+      *ptr = arena + arena_used;
+      arena_used += size;
+      blocks.insert({*ptr, Block(size, *ptr, true, true)});
+      stats.allocated_bytes += size;
       return cudaSuccess;
     }
 
@@ -90,7 +162,9 @@ struct HostAllocator
       return err;
     }
 
-    blocks.insert({*ptr, Block(size, *ptr, true)});
+    blocks.insert({*ptr, Block(size, *ptr, true, false)});
+    stats.allocated_bytes += size;
+    stats.cached_bytes += size;
     return cudaSuccess;
   }
 
@@ -117,6 +191,7 @@ struct HostAllocator
     // free (on valid memory) shouldn't fail, so mark unallocated before
     // we process the streams.
     block.allocated = false;
+    stats.allocated_bytes -= block.size;
 
     // insert CUDA events for each stream on which this block was used. This
     err = insertEvents(block);
@@ -203,18 +278,29 @@ struct HostAllocator
     // clear list of available blocks
     available.clear();
 
-    // free and erase non-allocated blocks
+    // free and erase non-allocated blocks, except those of the arena, which
+    // stay available
     for (auto it = blocks.begin(); it != blocks.end();) {
       Block& block = it->second;
-      if (!block.allocated) {
+      if (block.allocated) {
+        ++it;
+      } else if (block.in_arena) {
+        available.insert(block);
+        ++it;
+      } else {
         THCudaCheckWarn(cudaFreeHost(block.ptr));
+        stats.cached_bytes -= block.size;
         it = blocks.erase(it);
-      } else {
-        ++it;
       }
     }
   }
 
+  void getStats(THCCachingHostAllocatorStats* result)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    *result = stats;
+  }
+
   cudaError_t insertEvents(Block& block)
   {
     cudaError_t err;
@@ -273,6 +359,11 @@ void THCCachingHostAllocator_emptyCache()
   allocator.emptyCache();
 }
 
+void THCCachingHostAllocator_getStats(THCCachingHostAllocatorStats* stats)
+{
+  allocator.getStats(stats);
+}
+
 THAllocator THCCachingHostAllocator = {
   &THCCachingHostAllocator_malloc,
   NULL,
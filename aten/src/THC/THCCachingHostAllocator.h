@@ -17,7 +17,14 @@
 // and tensors in THCTensor_(copyAsyncCPU) and THCTensor_(copyAsyncCuda).
 //
 // Note that this allocator does not split larger allocations into smaller
-// blocks, unlike the caching device allocator.
+// blocks, unlike the caching device allocator. Allocation sizes are rounded
+// up to a power of two, so that blocks are reused by requests of similar
+// sizes.
+//
+// If THC_CACHING_HOST_ALLOCATOR_ARENA_MB is set, that much pinned memory is
+// allocated at once on the first request, and new blocks are carved out of
+// it until it runs out, when cudaHostAlloc is called again. The arena is
+// never released.
 //
 THC_API THAllocator THCCachingHostAllocator;
 
@@ -28,4 +35,14 @@ THC_API cudaError_t THCCachingHostAllocator_recordEvent(void *ptr, THCStream *st
 // Releases cached pinned memory allocations via cudaHostFree
 THC_API void THCCachingHostAllocator_emptyCache(void);
 
+typedef struct THCCachingHostAllocatorStats {
+  uint64_t allocated_bytes;  // size of the blocks in use
+  uint64_t cached_bytes;     // pinned memory held by the allocator, in use or not
+  uint64_t arena_bytes;      // size of the arena, included in cached_bytes
+  uint64_t allocations;      // number of allocations
+  uint64_t cache_hits;       // allocations served by a cached block
+} THCCachingHostAllocatorStats;
+
+THC_API void THCCachingHostAllocator_getStats(THCCachingHostAllocatorStats* stats);
+
 #endif
@@ -96,6 +96,8 @@ void THCudaInit(THCState* state)
   // should be cross-GPU leads to synchronization errors. The user can choose
   // to disable this functionality, however.
   state->p2pKernelAccessEnabled = 0;
+  state->deterministicAccumulation = 0;
+  state->tensorOpFloatMath = 0;
 
   // p2pAccessEnabled records if p2p copies are allowed between pairs of
   // devices. Values include "1" (copy allowed), "0" (copy not allowed), and
@@ -288,6 +290,22 @@ void THCState_setKernelPeerToPeerAccessEnabled(THCState* state, int val) {
   state->p2pKernelAccessEnabled = val;
 }
 
+int THCState_getDeterministicAccumulation(THCState* state) {
+  return state->deterministicAccumulation;
+}
+
+void THCState_setDeterministicAccumulation(THCState* state, int val) {
+  state->deterministicAccumulation = val;
+}
+
+int THCState_getTensorOpFloatMath(THCState* state) {
+  return state->tensorOpFloatMath;
+}
+
+void THCState_setTensorOpFloatMath(THCState* state, int val) {
+  state->tensorOpFloatMath = val;
+}
+
 struct cudaDeviceProp* THCState_getCurrentDeviceProperties(THCState* state)
 {
   int curDev = -1;
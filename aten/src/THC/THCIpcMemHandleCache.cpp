@@ -0,0 +1,139 @@
+#include "THCIpcMemHandleCache.h"
+
+#include <cuda_runtime_api.h>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+const size_t kDefaultCacheSize = 64;
+
+struct Segment {
+  int device;
+  void* ptr;
+  int refcount;
+  std::list<std::string>::iterator idle_pos;  // valid if refcount == 0
+};
+
+cudaError_t closeSegment(const Segment& segment)
+{
+  int prev_device;
+  cudaError_t err = cudaGetDevice(&prev_device);
+  if (err != cudaSuccess) {
+    return err;
+  }
+  err = cudaSetDevice(segment.device);
+  if (err != cudaSuccess) {
+    return err;
+  }
+  err = cudaIpcCloseMemHandle(segment.ptr);
+  cudaSetDevice(prev_device);
+  return err;
+}
+
+struct IpcMemHandleCache
+{
+  std::mutex mutex;
+
+  // open segments by handle, and their handles by address
+  std::unordered_map<std::string, Segment> segments;
+  std::unordered_map<void*, std::string> handles;
+
+  // handles of the idle segments, the most recently used first
+  std::list<std::string> idle;
+  size_t capacity;
+
+  IpcMemHandleCache() : capacity(kDefaultCacheSize) {
+    const char* env = getenv("THC_IPC_MEM_HANDLE_CACHE_SIZE");
+    if (env) {
+      capacity = strtoul(env, NULL, 10);
+    }
+  }
+
+  void* open(int device, cudaIpcMemHandle_t handle)
+  {
+    std::string key((const char*)&handle, sizeof(handle));
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = segments.find(key);
+    if (it != segments.end()) {
+      Segment& segment = it->second;
+      if (segment.refcount == 0) {
+        idle.erase(segment.idle_pos);
+      }
+      segment.refcount++;
+      return segment.ptr;
+    }
+
+    // the caller has already set the current device
+    void* ptr = NULL;
+    THCudaCheck(cudaIpcOpenMemHandle(&ptr, handle, cudaIpcMemLazyEnablePeerAccess));
+    segments.insert({key, Segment{device, ptr, 1, idle.end()}});
+    handles.insert({ptr, key});
+    return ptr;
+  }
+
+  cudaError_t release(void* ptr)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto handle_it = handles.find(ptr);
+    if (handle_it == handles.end()) {
+      THError("THCIpcAllocator: invalid device pointer: %p", ptr);
+    }
+    auto it = segments.find(handle_it->second);
+    Segment& segment = it->second;
+    if (--segment.refcount > 0) {
+      return cudaSuccess;
+    }
+    idle.push_front(it->first);
+    segment.idle_pos = idle.begin();
+    return evict(capacity);
+  }
+
+  // closes the least recently used idle segments beyond max_idle
+  cudaError_t evict(size_t max_idle)
+  {
+    while (idle.size() > max_idle) {
+      auto it = segments.find(idle.back());
+      Segment segment = it->second;
+      idle.pop_back();
+      handles.erase(segment.ptr);
+      segments.erase(it);
+      cudaError_t err = closeSegment(segment);
+      if (err != cudaSuccess) {
+        return err;
+      }
+    }
+    return cudaSuccess;
+  }
+
+  cudaError_t emptyCache()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return evict(0);
+  }
+};
+
+IpcMemHandleCache& cache() {
+  static IpcMemHandleCache* instance = new IpcMemHandleCache();
+  return *instance;
+}
+
+} // namespace
+
+THC_API void* THCIpcMemHandleCache_open(int device, cudaIpcMemHandle_t handle)
+{
+  return cache().open(device, handle);
+}
+
+THC_API cudaError_t THCIpcMemHandleCache_release(void* devPtr)
+{
+  return cache().release(devPtr);
+}
+
+THC_API cudaError_t THCIpcMemHandleCache_emptyCache(void)
+{
+  return cache().emptyCache();
+}
@@ -0,0 +1,29 @@
+#ifndef THC_IPC_MEM_HANDLE_CACHE_INC
+#define THC_IPC_MEM_HANDLE_CACHE_INC
+
+#include "THCGeneral.h"
+
+//
+// The memory segments of other processes opened in this one.
+//
+// A segment is opened by cudaIpcOpenMemHandle the first time one of its
+// handles is received, and every storage rebuilt from the same handle shares
+// that mapping, addressing its data by offset. When the last of them is
+// freed, the segment stays open, so that the next tensors sent from it don't
+// pay for cudaIpcOpenMemHandle again. Up to THC_IPC_MEM_HANDLE_CACHE_SIZE
+// idle segments (64 by default, 0 to close them right away) are kept open,
+// and the least recently used ones are closed first. An idle segment keeps
+// the memory of the exporting process mapped until it is closed.
+//
+
+// Returns the address at which the segment of the handle is mapped on
+// device, and takes a reference to it.
+THC_API void* THCIpcMemHandleCache_open(int device, cudaIpcMemHandle_t handle);
+
+// Drops a reference to the segment mapped at devPtr. Used by THCIpcAllocator.
+THC_API cudaError_t THCIpcMemHandleCache_release(void* devPtr);
+
+// Closes the idle segments
+THC_API cudaError_t THCIpcMemHandleCache_emptyCache(void);
+
+#endif
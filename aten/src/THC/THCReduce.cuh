@@ -14,6 +14,8 @@
 
 // Threads per thread block
 #define THC_NONCONTIG_REDUCE_BLOCK_SIZE 32 * 16
+// Warps per thread block when each warp reduces a slice
+#define THC_CONTIG_REDUCE_WARPS_PER_BLOCK 8
 
 template <typename IndexType>
 __device__ __forceinline__ IndexType getReduceNoncontigDimSliceIndex() {
@@ -213,6 +215,51 @@ kernelReduceContigDim(TensorInfo<T, IndexType> out,
   }
 }
 
+// Kernel that handles an entire reduction of a slice of a tensor per
+// each warp, for contiguous slices too short to keep a block busy. Each
+// threadIdx.y is a warp.
+template <typename ModifyOp,
+          typename ReduceOp,
+          typename ReduceAccOp,
+          typename T,
+          typename AccT,
+          typename IndexType,
+          int ADims, int BDims>
+__global__ void
+kernelReduceContigDimWarp(TensorInfo<T, IndexType> out,
+                          TensorInfo<T, IndexType> in,
+                          IndexType reductionSize,
+                          IndexType totalSlices,
+                          AccT init,
+                          ModifyOp modifyOp,
+                          ReduceOp reduceOp,
+                          ReduceAccOp reduceAccOp) {
+  const IndexType sliceIndex =
+    getLinearBlockId<IndexType>() * blockDim.y + threadIdx.y;
+
+  // Whole warps leave, so that the shuffles below have all their lanes
+  if (sliceIndex >= totalSlices) {
+    return;
+  }
+
+  const IndexType outOffset =
+    IndexToOffset<T, IndexType, ADims>::get(sliceIndex, out);
+  const IndexType inBaseOffset =
+    IndexToOffset<T, IndexType, BDims>::get(sliceIndex, in);
+
+  AccT r = init;
+  for (IndexType i = threadIdx.x; i < reductionSize; i += blockDim.x) {
+    r = reduceOp(r, modifyOp(in.data[inBaseOffset + i]));
+  }
+
+  r = reduceWarp<AccT, ReduceAccOp>(r, reduceAccOp);
+
+  if (threadIdx.x == 0) {
+    // Write out reduced value
+    out.data[outOffset] = ScalarConvert<AccT, T>::to(r);
+  }
+}
+
 inline dim3 getNoncontigReduceBlock() {
   return dim3(THC_NONCONTIG_REDUCE_BLOCK_SIZE);
 }
@@ -242,6 +289,24 @@ inline dim3 getContigReduceBlock(ptrdiff_t numSlices, int64_t reductionSize) {
   return dim3(numWarps * 32);
 }
 
+// A block per slice leaves most of its warps idle, and waits on
+// __syncthreads, when the slices are short. If there are enough of them to
+// fill the device (again assuming 15 SMs) with a warp each, use a warp per
+// slice instead.
+inline bool useWarpContigReduce(ptrdiff_t numSlices, int64_t reductionSize) {
+  return reductionSize <= 32 * 16 && numSlices >= 15 * 64;
+}
+
+inline dim3 getContigWarpReduceBlock() {
+  return dim3(32, THC_CONTIG_REDUCE_WARPS_PER_BLOCK);
+}
+
+inline bool getContigWarpReduceGrid(ptrdiff_t elements, dim3& grid) {
+  // One output point per warp
+  return THC_getGridFromTiles(THCCeilDiv(elements,
+                                         (ptrdiff_t) THC_CONTIG_REDUCE_WARPS_PER_BLOCK), grid);
+}
+
 inline bool getNoncontigReduceGrid(ptrdiff_t elements, dim3& grid) {
   // One output point per thread
   return THC_getGridFromTiles(THCCeilDiv(elements,
@@ -288,11 +353,18 @@ bool THC_reduceDim(THCState* state,
   // Is the reduction dimension contiguous? If so, then we can use a
   // shared memory reduction kernel to increase performance.
   bool contigReduction = (reductionStride == 1);
+  bool warpReduction = contigReduction && useWarpContigReduce(outElements, reductionSize);
 
   dim3 block;
   dim3 grid;
   int smemSize = 0; // contiguous reduction uses smem
-  if (contigReduction) {
+  if (warpReduction) {
+    if (!getContigWarpReduceGrid(outElements, grid)) {
+      return false;
+    }
+
+    block = getContigWarpReduceBlock();
+  } else if (contigReduction) {
     if (!getContigReduceGrid(outElements, grid)) {
       return false;
     }
@@ -347,7 +419,15 @@ bool THC_reduceDim(THCState* state,
   // dimension, and the loop to translate the linear index to the array
   // index can be similarly collapsed. That is what this unrolling is for.
 #define HANDLE_CASE(TYPE, OUT, IN)                                      \
-  if (contigReduction) {                                                \
+  if (warpReduction) {                                                  \
+    kernelReduceContigDimWarp<ModifyOp, ReduceOp, ReduceAccOp,          \
+                              typename TensorUtils<TensorType>::DataType, \
+                              AccT,                                     \
+                              TYPE, OUT, IN>                            \
+      <<<grid, block, 0, THCState_getCurrentStream(state)>>>(           \
+        outInfo, inInfo, reductionSize,                                 \
+        (TYPE) outElements, init, modifyOp, reduceOp, reduceAccOp);     \
+  } else if (contigReduction) {                                         \
     kernelReduceContigDim<ModifyOp, ReduceOp, ReduceAccOp,              \
                           typename TensorUtils<TensorType>::DataType,   \
                           AccT,                                         \
@@ -460,5 +540,6 @@ bool THC_reduceDim(THCState* state,
 }
 
 #undef THC_NONCONTIG_REDUCE_BLOCK_SIZE
+#undef THC_CONTIG_REDUCE_WARPS_PER_BLOCK
 
 #endif // THC_REDUCE_INC
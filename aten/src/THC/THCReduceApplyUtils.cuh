@@ -116,6 +116,33 @@ __device__ T reduceBlock(T* smem,
 }
 
 
+// Shuffles a value of any trivially copyable type down the warp, 32 bits at
+// a time, so that accumulator types without a __shfl overload work too
+template <typename T>
+__device__ __forceinline__ T WARP_SHFL_DOWN_WORDS(T value, unsigned int delta) {
+  constexpr int kWords = (sizeof(T) + sizeof(int) - 1) / sizeof(int);
+  int words[kWords];
+  memcpy(words, &value, sizeof(T));
+#pragma unroll
+  for (int i = 0; i < kWords; ++i) {
+    words[i] = WARP_SHFL_DOWN(words[i], delta);
+  }
+  T result;
+  memcpy(&result, words, sizeof(T));
+  return result;
+}
+
+// Warp-wide reduction with shuffles; only lane 0 returns the reduced
+// value. All the lanes of the warp must call it.
+template <typename T, typename ReduceOp>
+__device__ __forceinline__ T reduceWarp(T threadVal, ReduceOp reduceOp) {
+#pragma unroll
+  for (int offset = 16; offset > 0; offset /= 2) {
+    threadVal = reduceOp(threadVal, WARP_SHFL_DOWN_WORDS(threadVal, offset));
+  }
+  return threadVal;
+}
+
 // Block-wide reduction where each thread locally reduces N
 // values before letting a single warp take over - assumes
 // threadVals is in registers, not shared memory
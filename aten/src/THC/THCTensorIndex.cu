@@ -199,6 +199,58 @@ __global__ void indexAddLargeIndex(TensorInfo<T, IndexType> dst,
   }
 }
 
+// Used instead of the atomicAdd kernels above when many indices repeat
+// or when a reproducible result is requested. `sortedIndices` holds the
+// indices stably sorted, and `origIndices` the position in `src` each of
+// them came from. The y dimension of the grid walks the sorted indices,
+// and only the first of a run of equal indices does any work: it sums
+// the whole run in source order and writes the destination once.
+template <typename T, typename AccT, typename IndexType, int DstDim, int SrcDim>
+__global__ void indexAddSortedIndex(TensorInfo<T, IndexType> dst,
+                                    TensorInfo<T, IndexType> src,
+                                    const int64_t* sortedIndices,
+                                    const int64_t* origIndices,
+                                    int dstAddDim,
+                                    int srcAddDim,
+                                    IndexType numIndices,
+                                    IndexType innerSize,
+                                    int64_t dstAddDimSize) {
+  for (IndexType idx = blockIdx.y * blockDim.y + threadIdx.y;
+       idx < numIndices;
+       idx += gridDim.y * blockDim.y) {
+    if (idx > 0 && sortedIndices[idx] == sortedIndices[idx - 1]) {
+      continue;
+    }
+
+    // Lua indices begin at 1
+    IndexType dstIndex = sortedIndices[idx] - TH_INDEX_BASE;
+    assert(dstIndex < dstAddDimSize);
+
+    for (IndexType linearIndex = blockIdx.x * blockDim.x + threadIdx.x;
+         linearIndex < innerSize;
+         linearIndex += gridDim.x * blockDim.x) {
+      IndexType srcSliceOffset =
+        IndexToOffset<T, IndexType, SrcDim>::get(linearIndex, src);
+
+      AccT sum = ScalarConvert<int, AccT>::to(0);
+      for (IndexType run = idx;
+           run < numIndices && sortedIndices[run] == sortedIndices[idx];
+           ++run) {
+        IndexType srcOffset =
+          srcSliceOffset + origIndices[run] * src.strides[srcAddDim];
+        sum += ScalarConvert<T, AccT>::to(src.data[srcOffset]);
+      }
+
+      IndexType dstOffset =
+        IndexToOffset<T, IndexType, DstDim>::get(linearIndex, dst);
+      dstOffset += dstIndex * dst.strides[dstAddDim];
+
+      dst.data[dstOffset] = ScalarConvert<AccT, T>::to(
+        ScalarConvert<T, AccT>::to(dst.data[dstOffset]) + sum);
+    }
+  }
+}
+
 // We prefer this kernel to avoid reloading index points if the number
 // of indices is a small number.
 // This kernel in fact works for all choices of problem size, but if
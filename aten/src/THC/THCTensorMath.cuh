@@ -23,8 +23,9 @@ __global__ void THCTensor_copyToDiagonal(T* a, T* b, ptrdiff_t start, ptrdiff_t
   }
 }
 
-#define CAT_ARRAY_BATCH_SIZE 1024
 #define CAT_ARRAY_MAX_INPUT_DIMS 4
+// Upper bound on gridDim.y; the blocks of a row loop over the inputs beyond it
+#define CAT_ARRAY_MAX_GRID_Y 65535
 
 inline bool getCatGrid(THCState* state, ptrdiff_t nTensors, dim3& grid) {
   int curDevice = -1;
@@ -39,7 +40,8 @@ inline bool getCatGrid(THCState* state, ptrdiff_t nTensors, dim3& grid) {
         state ? THCState_getCurrentDeviceProperties(state)->multiProcessorCount : 15;
   //X dim of grid for cat array cooperates on a single tensor in the cat.
   //Given half of the GPU, full utilization will always occur.
-  grid = dim3( 2LL * numSM, (long long) nTensors );
+  grid = dim3( 2LL * numSM,
+      (long long) (nTensors < CAT_ARRAY_MAX_GRID_Y ? nTensors : CAT_ARRAY_MAX_GRID_Y) );
 	     
   return true;
 }
@@ -84,46 +86,42 @@ struct OutputTensorSizeStride {
 };
 
 /**
-  * Kernel used to concatenated grimDim.y tensors into an output tensor. Uses a grid-stride loop based off of
-  * the blockIdx.x, threadIdx.x for each input to copy each element from each input tensor into the output.
+  * Kernel used to concatenate nInputs tensors into an output tensor. Row blockIdx.y of the grid copies
+  * inputs blockIdx.y, blockIdx.y + gridDim.y, ..., so that any number of inputs is handled by a single
+  * launch; within an input, a grid-stride loop based off of blockIdx.x, threadIdx.x copies each element
+  * into the output.
   *
   * output: base pointer to the storage associated with the output tensor
   * inputs: GPU-allocated array of input metadata for each input to concatenate in the kernel
+  * nInputs: number of entries of inputs
   * os: the size/stride vectors for the output tensor
   * concatDim: dimension along which we are concatenating
   * dimStride: the stride of the output tensor at the concatDim
   *
   * The most important assumption made is that the input tensors are contiguous.
   */
-
-
-
 template <typename T, typename IndexType, int Dims>
 __global__ void CatArrayBatchedCopy(
     T* output,
     CatArrInputTensor<T, IndexType>* inputs,
+    int nInputs,
     OutputTensorSizeStride<IndexType, CAT_ARRAY_MAX_INPUT_DIMS> os,
     const int concatDim,
     IndexType dimStride) {
 
-    IndexType tid = blockIdx.x * blockDim.x + threadIdx.x;
-    IndexType nElements = inputs[blockIdx.y].nElements;
-
-    if(tid >= nElements) return;
-    
-    T* data = inputs[blockIdx.y].input;
-    IndexType offset = inputs[blockIdx.y].offset;
-    IndexType dimSize = inputs[blockIdx.y].dimSize;
-    IndexType dataOffset = offset * dimStride;
-
     IndexType stride = gridDim.x * blockDim.x;
 
-    while( tid < nElements){
-    IndexType elementOffset = CatArrIndexToOffset<IndexType, Dims>::compute(
-    	      os.outputSize, os.outputStride, dimSize, concatDim, tid);
-    output[dataOffset + elementOffset] = data[tid];
-
-    tid += stride;
+    for (int t = blockIdx.y; t < nInputs; t += gridDim.y) {
+      IndexType nElements = inputs[t].nElements;
+      T* data = inputs[t].input;
+      IndexType dimSize = inputs[t].dimSize;
+      IndexType dataOffset = inputs[t].offset * dimStride;
+
+      for (IndexType tid = blockIdx.x * blockDim.x + threadIdx.x; tid < nElements; tid += stride) {
+        IndexType elementOffset = CatArrIndexToOffset<IndexType, Dims>::compute(
+            os.outputSize, os.outputStride, dimSize, concatDim, tid);
+        output[dataOffset + elementOffset] = data[tid];
+      }
     }
 }
 
@@ -614,6 +614,12 @@ struct TensorCrossOp {
   const int64_t sx, sy, so;
 };
 
+// TensorCrossOp reads and writes the neighbours of its elements
+template <typename T>
+struct THCApplyVectorizable<TensorCrossOp<T> > {
+  static const bool value = false;
+};
+
 template <typename T>
 struct TensorMaxOp {
   __device__ __forceinline__ void operator()(T* out, T* in) {
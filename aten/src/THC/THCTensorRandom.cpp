@@ -110,6 +110,7 @@ void THCRandom_manualSeed(THCState* state, uint64_t seed)
 {
   THCGenerator* gen = THCRandom_rawGenerator(state);
   gen->initial_seed = seed;
+  gen->philox_seed_offset = 0;
   if (gen->initf) {
     createGeneratorState(gen, seed);
   }
@@ -5,6 +5,7 @@
 #include "THCTensorMath.h"
 #include "THCReduceApplyUtils.cuh"
 #include "THCTensorRandom.cuh"
+#include "THAtomic.h"
 
 #include <thrust/functional.h>
 #include <curand.h>
@@ -14,6 +15,7 @@
 
 #define MAX_NUM_BLOCKS 200 
 #define BLOCK_SIZE 256
+#define PHILOX_MAX_NUM_BLOCKS 1024
 
 
 THCGenerator* THCRandom_getGenerator(THCState* state);
@@ -140,6 +142,46 @@ __global__ void NAME(curandStateMtgp32 *state, int size, T *result, ARG1, ARG2)
   }                                                                                  \
 }
 
+// Philox kernels don't share the MTGP32 states: thread idx draws from
+// subsequence idx of the stream of the initial seed, from an offset reserved
+// on the generator, so the grid isn't bounded by the number of states and
+// the result only depends on the size.
+#define GENERATE_PHILOX_KERNEL1(NAME, T, ARG1, CURAND_T, CURAND_FUNC, TRANSFORM)       \
+__global__ void NAME(uint64_t seed, uint64_t offset, int size, T *result, ARG1)        \
+{                                                                                      \
+  int idx = blockIdx.x * BLOCK_SIZE + threadIdx.x;                                     \
+  curandStatePhilox4_32_10_t state;                                                    \
+  curand_init(seed, idx, offset, &state);                                              \
+  for (int i = idx; i < size; i += BLOCK_SIZE * gridDim.x) {                           \
+    CURAND_T x = CURAND_FUNC(&state);                                                  \
+    T y = TRANSFORM;                                                                   \
+    result[i] = y;                                                                     \
+  }                                                                                    \
+}
+
+#define GENERATE_PHILOX_KERNEL2(NAME, T, ARG1, ARG2, CURAND_T, CURAND_FUNC, TRANSFORM) \
+__global__ void NAME(uint64_t seed, uint64_t offset, int size, T *result, ARG1, ARG2)  \
+{                                                                                      \
+  int idx = blockIdx.x * BLOCK_SIZE + threadIdx.x;                                     \
+  curandStatePhilox4_32_10_t state;                                                    \
+  curand_init(seed, idx, offset, &state);                                              \
+  for (int i = idx; i < size; i += BLOCK_SIZE * gridDim.x) {                           \
+    CURAND_T x = CURAND_FUNC(&state);                                                  \
+    T y = TRANSFORM;                                                                   \
+    result[i] = y;                                                                     \
+  }                                                                                    \
+}
+
+// The number of blocks of a Philox kernel over size elements. Sets offset to
+// the first of the values reserved for each thread: at most 4 per element.
+__host__ int philoxNumBlocks(THCGenerator* gen, ptrdiff_t size, uint64_t* offset)
+{
+  int blocks = min((int)THCCeilDiv(size, (ptrdiff_t) BLOCK_SIZE), PHILOX_MAX_NUM_BLOCKS);
+  int64_t perThread = THCCeilDiv(size, (ptrdiff_t) BLOCK_SIZE * blocks);
+  *offset = THAtomicAddLong(&gen->philox_seed_offset, 4 * perThread);
+  return blocks;
+}
+
 template<typename T, typename U>
 struct is_same { static const bool value = false; };
 
@@ -166,11 +208,11 @@ __global__ void generate_bernoulli_tensor(curandStateMtgp32 *state, int size,
 }
 
 // NOTE: curand_uniform is (0, 1] and we want [a, b)
-GENERATE_KERNEL2(generate_uniform, float, float a, float b, float, curand_uniform, reverse_bounds(x) * (b-a) + a)
-GENERATE_KERNEL2(generate_uniform, double, double a, double b, double, curand_uniform_double, reverse_bounds(x) * (b-a) + a)
+GENERATE_PHILOX_KERNEL2(generate_uniform, float, float a, float b, float, curand_uniform, reverse_bounds(x) * (b-a) + a)
+GENERATE_PHILOX_KERNEL2(generate_uniform, double, double a, double b, double, curand_uniform_double, reverse_bounds(x) * (b-a) + a)
 
-GENERATE_KERNEL2(generate_normal, float, double mean, double stdv, float, curand_normal, (x * stdv) + mean)
-GENERATE_KERNEL2(generate_normal, double, double mean, double stdv, double, curand_normal_double, (x * stdv) + mean)
+GENERATE_PHILOX_KERNEL2(generate_normal, float, double mean, double stdv, float, curand_normal, (x * stdv) + mean)
+GENERATE_PHILOX_KERNEL2(generate_normal, double, double mean, double stdv, double, curand_normal_double, (x * stdv) + mean)
 
 GENERATE_KERNEL1(generate_exponential, float, double lambda, float, curand_uniform, (float)(-1. / lambda * log(x)))
 GENERATE_KERNEL1(generate_exponential, double, double lambda, double, curand_uniform_double, (double)(-1. / lambda * log(x)))
@@ -179,8 +221,8 @@ GENERATE_KERNEL2(generate_cauchy, float, double median, double sigma, float, cur
 GENERATE_KERNEL2(generate_cauchy, double, double median, double sigma, double, curand_uniform_double, (double)(median + sigma * tan(M_PI*(x-0.5))))
 
 #ifdef CUDA_HALF_TENSOR
-GENERATE_KERNEL2(generate_uniform, half, double a, double b, float, curand_uniform, (half_uniform_scale_and_shift(x, a, b)))
-GENERATE_KERNEL2(generate_normal, half, double mean, double stdv, float, curand_normal, (ScalarConvert<float, half>::to((x * stdv) + mean)))
+GENERATE_PHILOX_KERNEL2(generate_uniform, half, double a, double b, float, curand_uniform, (half_uniform_scale_and_shift(x, a, b)))
+GENERATE_PHILOX_KERNEL2(generate_normal, half, double mean, double stdv, float, curand_normal, (ScalarConvert<float, half>::to((x * stdv) + mean)))
 GENERATE_KERNEL1(generate_exponential, half, double lambda, float, curand_uniform, (ScalarConvert<float, half>::to((float)(-1. / lambda * log(x)))))
 GENERATE_KERNEL2(generate_cauchy, half, double median, double sigma, float, curand_uniform, (ScalarConvert<float, half>::to((float)(median + sigma * tan(M_PI*(x-0.5))))))
 #endif // CUDA_HALF_TENSOR
@@ -190,3 +232,5 @@ GENERATE_KERNEL2(generate_cauchy, half, double median, double sigma, float, cura
 
 #undef GENERATE_KERNEL1
 #undef GENERATE_KERNEL2
+#undef GENERATE_PHILOX_KERNEL1
+#undef GENERATE_PHILOX_KERNEL2
@@ -2,6 +2,8 @@
 #include "THCGeneral.h"
 #include "THCAtomics.cuh"
 #include "THCApply.cuh"
+#include "THCNumerics.cuh"
+#include "THCTensorSort.cuh"
 
 // Compute the offsets into the given tensors for a linear index. For the 't2'
 // tensor, dimension 'dim' is skipped. The tensors are assumed to have the same
@@ -155,6 +157,74 @@ __global__ void THCudaTensor_scatterAddKernel(
   }
 }
 
+// The sort-based scatterAdd runs in two steps. This kernel records, for
+// each element of `index`, the offset into `tensor` it accumulates into.
+template <typename IndexType, typename Real, int Dims>
+__global__ void THCudaTensor_scatterAddOffsetsKernel(
+    TensorInfo<Real, IndexType> tensor,
+    TensorInfo<Real, IndexType> src,
+    TensorInfo<int64_t, IndexType> index,
+    const int dim,
+    const IndexType totalElements,
+    int64_t* tensorOffsets) {
+  for (IndexType linearId = blockIdx.x * blockDim.x + threadIdx.x;
+       linearId < totalElements;
+       linearId += gridDim.x * blockDim.x) {
+    IndexType tensorOffset = 0;
+    IndexType srcOffset = 0;
+    IndexType indexOffset = 0;
+
+    IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(linearId, dim,
+                                                          index, &indexOffset,
+                                                          src, &srcOffset,
+                                                          tensor, &tensorOffset);
+
+    int64_t indexValue = index.data[indexOffset] - TH_INDEX_BASE;
+    assert(indexValue >= 0 && indexValue < tensor.sizes[dim]);
+    tensorOffsets[linearId] = tensorOffset + indexValue * tensor.strides[dim];
+  }
+}
+
+// Once the offsets are stably sorted, the first thread of each run of
+// equal offsets sums the run in source order and writes `tensor` once.
+template <typename IndexType, typename Real, typename AccReal, int Dims>
+__global__ void THCudaTensor_scatterAddSortedKernel(
+    TensorInfo<Real, IndexType> tensor,
+    TensorInfo<Real, IndexType> src,
+    TensorInfo<int64_t, IndexType> index,
+    const int dim,
+    const IndexType totalElements,
+    const int64_t* sortedOffsets,
+    const int64_t* positions) {
+  for (IndexType i = blockIdx.x * blockDim.x + threadIdx.x;
+       i < totalElements;
+       i += gridDim.x * blockDim.x) {
+    if (i > 0 && sortedOffsets[i] == sortedOffsets[i - 1]) {
+      continue;
+    }
+
+    AccReal sum = ScalarConvert<int, AccReal>::to(0);
+    for (IndexType run = i;
+         run < totalElements && sortedOffsets[run] == sortedOffsets[i];
+         ++run) {
+      IndexType tensorOffset = 0;
+      IndexType srcOffset = 0;
+      IndexType indexOffset = 0;
+
+      IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(
+        (IndexType) positions[run], dim,
+        index, &indexOffset,
+        src, &srcOffset,
+        tensor, &tensorOffset);
+      sum += ScalarConvert<Real, AccReal>::to(src.data[srcOffset]);
+    }
+
+    Real* out = &tensor.data[sortedOffsets[i]];
+    *out = ScalarConvert<AccReal, Real>::to(
+      ScalarConvert<Real, AccReal>::to(*out) + sum);
+  }
+}
+
 template <typename IndexType, typename Real, int Dims>
 __global__ void THCudaTensor_scatterFillKernel(
     TensorInfo<Real, IndexType> tensor,
@@ -1,4 +1,6 @@
 #include "THCTensorSort.cuh"
+#include <thrust/copy.h>
+#include <thrust/iterator/counting_iterator.h>
 
 void THCudaLongTensor_fillSliceWithIndex(THCState* state,
                                          THCudaLongTensor* t,
@@ -60,3 +62,30 @@ void THCudaLongTensor_fillSliceWithIndex(THCState* state,
 
   THCudaCheck(cudaGetLastError());
 }
+
+void THCudaLongTensor_sortKeysWithPositions(THCState* state,
+                                            THCudaLongTensor* keys,
+                                            THCudaLongTensor* positions) {
+  THAssert(THCudaLongTensor_isContiguous(state, keys));
+  ptrdiff_t n = THCudaLongTensor_nElement(state, keys);
+  THCudaLongTensor_resize1d(state, positions, n);
+
+  THCThrustAllocator thrustAlloc(state);
+  thrust::device_ptr<int64_t> keysIter(THCudaLongTensor_data(state, keys));
+  thrust::device_ptr<int64_t> positionsIter(THCudaLongTensor_data(state, positions));
+
+  thrust::counting_iterator<int64_t> countIter(0);
+  thrust::copy(
+#if CUDA_VERSION >= 7000
+    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+#endif
+    countIter, countIter + n, positionsIter);
+
+  // The default comparator lets Thrust pick its radix sort, which is
+  // stable, so equal keys keep their positions in increasing order
+  thrust::stable_sort_by_key(
+#if CUDA_VERSION >= 7000
+    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+#endif
+    keysIter, keysIter + n, positionsIter);
+}
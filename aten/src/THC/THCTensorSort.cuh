@@ -12,6 +12,11 @@
 #if CUDA_VERSION >= 7000
 #include <thrust/system/cuda/execution_policy.h>
 #endif
+#ifdef USE_CUB
+#include <limits.h>
+#include <thrust/sequence.h>
+#include <cub/device/device_segmented_radix_sort.cuh>
+#endif
 
 template <typename T>
 struct ThrustGTOp {
@@ -83,4 +88,11 @@ struct GlobalIndexToPerSliceIndex {
 void THCudaLongTensor_fillSliceWithIndex(THCState* state,
                                          THCudaLongTensor* t,
                                          int dim);
+
+// Stably sorts the contiguous tensor `keys` in place and resizes
+// `positions` to hold, for each sorted key, its position before the sort
+// (0-based). Equal keys are left in order of increasing position.
+void THCudaLongTensor_sortKeysWithPositions(THCState* state,
+                                            THCudaLongTensor* keys,
+                                            THCudaLongTensor* positions);
 #endif // THC_TENSORSORT_CUH
@@ -140,72 +140,47 @@ struct TopKTypeConfig<half> {
 };
 #endif // CUDA_HALF_TENSOR
 
+// Over what radix we are selecting values
+#define RADIX_BITS 8 // digits are base-(2 ^ RADIX_BITS)
+#define RADIX_SIZE 256 // 2 ^ RADIX_BITS
+#define RADIX_MASK (RADIX_SIZE - 1)
+
 // This function counts the distribution of all input values in a
 // slice we are selecting by radix digit at `radixDigitPos`, but only
 // those that pass the filter `((v & desiredMask) == desired)`.
-// This produces and broadcasts the seen counts for a single block only.
-// `smem` must have at least `RadixSize` elements.
+// The counts of the whole block are left in `smem`, which must have at
+// least `RadixSize` elements. With 8-bit digits, a 32-bit type takes four
+// passes over the slice, and each element adds to one shared memory
+// counter.
 template <typename DataType, typename BitDataType,
           typename IndexType, typename CountType,
           int RadixSize, int RadixBits>
-__device__ void countRadixUsingMask(CountType counts[RadixSize],
-                                    CountType* smem,
+__device__ void countRadixUsingMask(CountType* smem,
                                     BitDataType desired,
                                     BitDataType desiredMask,
                                     int radixDigitPos,
                                     IndexType sliceSize,
                                     IndexType withinSliceStride,
                                     DataType* data) {
-  // Clear out per-thread counts from a previous round
-#pragma unroll
-  for (int i = 0; i < RadixSize; ++i) {
-    counts[i] = 0;
-  }
-
-  if (threadIdx.x < RadixSize) {
-    smem[threadIdx.x] = 0;
+  // Wait for every thread to be done with the counts of a previous round
+  __syncthreads();
+  for (int i = threadIdx.x; i < RadixSize; i += blockDim.x) {
+    smem[i] = 0;
   }
   __syncthreads();
 
-  // Scan over all the data. Upon a read, the warp will accumulate
-  // counts per each digit in the radix using warp voting.
   for (IndexType i = threadIdx.x; i < sliceSize; i += blockDim.x) {
     BitDataType val = TopKTypeConfig<DataType>::convert(doLdg(&data[i * withinSliceStride]));
 
-    bool hasVal = ((val & desiredMask) == desired);
-    BitDataType digitInRadix = Bitfield<BitDataType>::getBitfield(val, radixDigitPos, RadixBits);
-
-#pragma unroll
-    for (unsigned int j = 0; j < RadixSize; ++j) {
-      bool vote = hasVal && (digitInRadix == j);
-      counts[j] += __popc(WARP_BALLOT(vote, ACTIVE_MASK()));
-    }
-  }
-
-  // Now, for each warp, sum values
-  if (getLaneId() == 0) {
-#pragma unroll
-    for (unsigned int i = 0; i < RadixSize; ++i) {
-      atomicAdd(&smem[i], counts[i]);
+    if ((val & desiredMask) == desired) {
+      BitDataType digitInRadix = Bitfield<BitDataType>::getBitfield(val, radixDigitPos, RadixBits);
+      atomicAdd(&smem[digitInRadix], (CountType) 1);
     }
   }
 
   __syncthreads();
-
-  // For each thread, read in the total counts
-#pragma unroll
-  for (unsigned int i = 0; i < RadixSize; ++i) {
-    counts[i] = smem[i];
-  }
-
-  __syncthreads();
 }
 
-// Over what radix we are selecting values
-#define RADIX_BITS 2 // digits are base-(2 ^ RADIX_BITS)
-#define RADIX_SIZE 4 // 2 ^ RADIX_BITS
-#define RADIX_MASK (RADIX_SIZE - 1)
-
 // This finds the unique value `v` that matches the pattern
 // ((v & desired) == desiredMask) in our sorted int format
 template <typename DataType, typename BitDataType, typename IndexType>
@@ -215,6 +190,8 @@ __device__ DataType findPattern(DataType* smem,
                              IndexType withinSliceStride,
                              BitDataType desired,
                              BitDataType desiredMask) {
+  // Wait for every thread to be done with the radix counts
+  __syncthreads();
   if (threadIdx.x < 32) {
     smem[threadIdx.x] = ScalarConvert<int, DataType>::to(0);
   }
@@ -260,10 +237,6 @@ __device__ void radixSelect(DataType* data,
                             IndexType withinSliceStride,
                             int* smem,
                             DataType* topK) {
-  // Per-thread buckets into which we accumulate digit counts in our
-  // radix
-  int counts[RADIX_SIZE];
-
   // We only consider elements x such that (x & desiredMask) == desired
   // Initially, we consider all elements of the array, so the above
   // statement is true regardless of input.
@@ -277,7 +250,6 @@ __device__ void radixSelect(DataType* data,
 
   // We start at the most significant digit in our radix, scanning
   // through to the least significant digit
-#pragma unroll
   for (int digitPos = sizeof(DataType) * 8 - RADIX_BITS;
        digitPos >= 0;
        digitPos -= RADIX_BITS) {
@@ -287,7 +259,7 @@ __device__ void radixSelect(DataType* data,
     countRadixUsingMask<DataType, BitDataType,
                         IndexType, int,
                         RADIX_SIZE, RADIX_BITS>(
-                          counts, smem,
+                          smem,
                           desired, desiredMask, digitPos,
                           sliceSize, withinSliceStride, data);
 
@@ -296,7 +268,7 @@ __device__ void radixSelect(DataType* data,
 
 
 #define CHECK_RADIX(i)                                                  \
-    int count = counts[i];                                              \
+    int count = smem[i];                                                \
                                                                         \
     /* All threads have the same value in counts here, so all */        \
     /* threads will return from the function. */                        \
@@ -333,13 +305,11 @@ __device__ void radixSelect(DataType* data,
 
     if (Order) {
       // Process in descending order
-#pragma unroll
       for (int i = RADIX_SIZE - 1; i >= 0; --i) {
         CHECK_RADIX(i);
       }
     } else {
       // Process in ascending order
-#pragma unroll
       for (int i = 0; i < RADIX_SIZE; ++i) {
         CHECK_RADIX(i);
       }
@@ -350,6 +320,10 @@ __device__ void radixSelect(DataType* data,
   // There is no unique result, but there is a non-unique result
   // matching `desired` exactly
   *topK = TopKTypeConfig<DataType>::deconvert(desired);
+
+  // Wait for every thread to be done with the radix counts, since the
+  // caller reuses smem
+  __syncthreads();
 }
 
 template <typename T, typename IndexType, int Dim, bool Order>
@@ -367,8 +341,9 @@ __global__ void gatherTopK(TensorInfo<T, IndexType> input,
                            TensorInfo<int64_t, IndexType> indices,
                            IndexType indicesWithinSliceStride) {
   // Indices are limited to integer fp precision, so counts can fit in
-  // int32, regardless of IndexType
-  __shared__ int smem[32]; // one per each warp, up to warp limit
+  // int32, regardless of IndexType. Holds the radix counts, then one
+  // value per warp for the prefix scans.
+  __shared__ int smem[RADIX_SIZE];
 
   IndexType slice = getLinearBlockId<IndexType>();
   if (slice >= numInputSlices) {
@@ -293,6 +293,77 @@ void THCTensor_(put)(THCState *state, THCTensor *dst, THCudaLongTensor *index, T
   }
 }
 
+// indexAdd without atomics: the indices are sorted once so every
+// destination element is written by a single thread, which adds up the
+// matching source elements in their original order.
+static void THCTensor_(indexAddSorted)(THCState *state, THCTensor *dst, int dim,
+                                       THCudaLongTensor *indices, THCTensor *src,
+                                       ptrdiff_t sliceSize, int64_t dstAddDimSize)
+{
+  ptrdiff_t numIndices = THCudaLongTensor_nElement(state, indices);
+  cudaStream_t stream = THCState_getCurrentStream(state);
+
+  THCudaLongTensor *sortedIndices = THCudaLongTensor_new(state);
+  THCudaLongTensor *origIndices = THCudaLongTensor_new(state);
+  THCudaLongTensor_resize1d(state, sortedIndices, numIndices);
+  THCudaLongTensor_copy(state, sortedIndices, indices);
+  THCudaLongTensor_sortKeysWithPositions(state, sortedIndices, origIndices);
+
+  int64_t *sortedIndicesData = THCudaLongTensor_data(state, sortedIndices);
+  int64_t *origIndicesData = THCudaLongTensor_data(state, origIndices);
+
+#define SORTED_INDEX(TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM)                  \
+  indexAddSortedIndex<TENSOR_TYPE, accreal, TYPE, DST_DIM, SRC_DIM>        \
+    <<<grid, block, 0, stream>>>(                                         \
+      dstInfo, srcInfo, sortedIndicesData, origIndicesData,               \
+      dstAddDim, srcAddDim, numIndices, sliceSize, dstAddDimSize);
+
+  // A warp per run of equal indices, striding over the slice; the grid
+  // stays within the 65535 limit on its y dimension.
+  dim3 block(32, 8);
+  dim3 grid(std::min(THCCeilDiv(sliceSize, (ptrdiff_t)32), (ptrdiff_t)64),
+            std::min(THCCeilDiv(numIndices, (ptrdiff_t)8), (ptrdiff_t)4096));
+
+  if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, dst) &&
+      TensorUtils<THCTensor>::canUse32BitIndexMath(state, src)) {
+    TensorInfo<real, unsigned int> dstInfo =
+      getTensorInfo<THCTensor, unsigned int>(state, dst);
+    int dstAddDim = dstInfo.collapseDims(dim);
+    dstInfo.reduceDim(dstAddDim);
+
+    TensorInfo<real, unsigned int> srcInfo =
+      getTensorInfo<THCTensor, unsigned int>(state, src);
+    int srcAddDim = srcInfo.collapseDims(dim);
+    srcInfo.reduceDim(srcAddDim);
+
+    if (dstInfo.dims == 1 && srcInfo.dims == 1) {
+      SORTED_INDEX(real, unsigned int, 1, 1);
+    } else if (dstInfo.dims == 2 && srcInfo.dims == 2) {
+      SORTED_INDEX(real, unsigned int, 2, 2);
+    } else {
+      SORTED_INDEX(real, unsigned int, -1, -1);
+    }
+  } else {
+    TensorInfo<real, uint64_t> dstInfo =
+      getTensorInfo<THCTensor, uint64_t>(state, dst);
+    int dstAddDim = dstInfo.collapseDims(dim);
+    dstInfo.reduceDim(dstAddDim);
+
+    TensorInfo<real, uint64_t> srcInfo =
+      getTensorInfo<THCTensor, uint64_t>(state, src);
+    int srcAddDim = srcInfo.collapseDims(dim);
+    srcInfo.reduceDim(srcAddDim);
+
+    SORTED_INDEX(real, uint64_t, -1, -1);
+  }
+  THCudaCheck(cudaGetLastError());
+
+#undef SORTED_INDEX
+
+  THCudaLongTensor_free(state, sortedIndices);
+  THCudaLongTensor_free(state, origIndices);
+}
+
 void THCTensor_(indexAdd_long)(THCState *state, THCTensor *dst, int dim, THLongTensor *indices, THCTensor *src)
 {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 2, dst, src));
@@ -332,6 +403,23 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
 
   int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
 
+  // With many indices per destination row the atomics below keep hitting
+  // the same addresses (and for half each one is a compare-and-swap
+  // loop), so sorting the indices first is faster. The sorted version is
+  // also the one to use when results have to be reproducible.
+#if defined(THC_REAL_IS_HALF)
+  const ptrdiff_t sortedMinIndicesPerRow = 2;
+#else
+  const ptrdiff_t sortedMinIndicesPerRow = 8;
+#endif
+  if (numIndices > 0 && sliceSize > 0 &&
+      (THCState_getDeterministicAccumulation(state) ||
+       numIndices >= sortedMinIndicesPerRow * dstAddDimSize)) {
+    THCTensor_(indexAddSorted)(state, dst, dim, indices, src,
+                               sliceSize, dstAddDimSize);
+    return;
+  }
+
 #define SMALL_INDEX(TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM, IDX_DIM) \
   indexAddSmallIndex<TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM, IDX_DIM> \
     <<<smallIndexGrid, smallIndexBlock, 0, stream>>>(   \
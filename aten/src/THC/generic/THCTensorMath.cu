@@ -116,7 +116,7 @@ void THCTensor_(catArray)(THCState *state, THCTensor *result,
 			  THCTensor **inputs, int numInputs, int dimension)
 {
   THLongStorage *size;
-  int i, j, cohortMax;
+  int i, j;
   int64_t offset;
   bool hasEmptyInput = false;
   THCTensor *notEmptyTensor = NULL;
@@ -201,8 +201,9 @@ void THCTensor_(catArray)(THCState *state, THCTensor *result,
     // for the output Tensor.
     real *data = THCTensor_(data)(state, result);
 
-    // Kernel Parameter
-    size_t tensorMetadataSize = sizeof(CatArrInputTensor<real, unsigned int>) * CAT_ARRAY_BATCH_SIZE;
+    // Kernel Parameter: the metadata of all the inputs, copied to the GPU at
+    // once so that a single launch handles any number of inputs.
+    size_t tensorMetadataSize = sizeof(CatArrInputTensor<real, unsigned int>) * numInputs;
     CatArrInputTensor<real, unsigned int> *d_inputs;
     THCudaCheck(THCudaMalloc(state, (void**) &d_inputs, tensorMetadataSize));
 
@@ -216,67 +217,61 @@ void THCTensor_(catArray)(THCState *state, THCTensor *result,
 
     THCStream* stream = THCState_getStream(state);
 
+    CatArrInputTensor<real, unsigned int>* stackInputs = (CatArrInputTensor<real, unsigned int>*) THCudaHostAlloc(state, tensorMetadataSize);
+    offset = 0;
+    for (j = 0; j < numInputs; ++j) {
+      int64_t dimSize = cat_dimension < THCTensor_(nDimension)(state, inputs[j])
+        ? THCTensor_(size)(state, inputs[j], cat_dimension)
+        : 1;
+
+      stackInputs[j].input = THCTensor_(data)(state, inputs[j]);
+      stackInputs[j].offset = offset;
+      stackInputs[j].dimSize = dimSize;
+      stackInputs[j].nElements = THCTensor_(nElement)(state, inputs[j]);
+
+      // update offset
+      offset += dimSize;
+    }
+    THCudaCheck(cudaMemcpyAsync(
+        d_inputs,
+        stackInputs,
+        tensorMetadataSize,
+        cudaMemcpyHostToDevice,
+        stream->stream));
+    THCudaHostRecord(state, stackInputs);
+    THCudaHostFree(state, stackInputs);
+
+    // Next, let's consider how we set our kernel launch parameters.
+    // We borrow from THCApply, which the kernel's internal indexing
+    // is based on.
+    dim3 applyBlock = getApplyBlock();
+
+    //Get grid where x dim fills half gpu and y dim is number of tensors
+    //(capped, with each row of blocks then looping over several tensors).
+    //This will have cating two tensors fill the entire grid, but prevent
+    //many threads from needlessly load meta data if their sizes is small.
+    dim3 catGrid;
+    getCatGrid(state, numInputs, catGrid);
+
     // Template Declarations for dim = 1, 2, 3, 4
 #define HANDLE_CASE(DIMS) \
-  CatArrayBatchedCopy<real, unsigned int, DIMS><<<catGrid, applyBlock, 0, stream->stream>>>(data, d_inputs, param, cat_dimension, param.outputStride[cat_dimension]);
-
-    // Now we loop
-    offset = 0;
-    for (i = 0; i < numInputs; i += CAT_ARRAY_BATCH_SIZE) {
-      // Re-allocate stackInputs every iteration to avoid read-after-write hazard
-      CatArrInputTensor<real, unsigned int>* stackInputs = (CatArrInputTensor<real, unsigned int>*) THCudaHostAlloc(state, tensorMetadataSize);
-      cohortMax = 0;
-      for (j = 0; j < CAT_ARRAY_BATCH_SIZE && (i+j) < numInputs; ++j) {
-        int64_t dimSize = cat_dimension < THCTensor_(nDimension)(state, inputs[i+j])
-          ? THCTensor_(size)(state, inputs[i+j], cat_dimension)
-          : 1;
-
-        stackInputs[j].input = THCTensor_(data)(state, inputs[i+j]);
-        stackInputs[j].offset = offset;
-        stackInputs[j].dimSize = dimSize;
-        stackInputs[j].nElements = THCTensor_(nElement)(state, inputs[i+j]);
-        cohortMax = cohortMax > (int) stackInputs[j].nElements ? cohortMax : (int) stackInputs[j].nElements;
-
-        // update offset
-        offset += dimSize;
-      }
-      THCudaCheck(cudaMemcpyAsync(
-          d_inputs,
-          stackInputs,
-          j * sizeof(CatArrInputTensor<real, unsigned int>),
-          cudaMemcpyHostToDevice,
-          stream->stream));
-      THCudaHostRecord(state, stackInputs);
-      THCudaHostFree(state, stackInputs);
-
-      // Next, let's consider how we set our kernel launch parameters.
-      // We borrow from THCApply, which the kernel's internal indexing
-      // is based on.
-      dim3 applyBlock = getApplyBlock();
-
-      //Get grid where x dim fills half gpu and y dim is number of tensors.
-      //This will have cating two tensors fill the entire grid, but prevent
-      //many threads from needlessly load meta data if their sizes is small.
-      dim3 catGrid;
-      getCatGrid(state, j, catGrid);
-
-
-      switch (nDims) {
-        case 1:
-          HANDLE_CASE(1);
-          break;
-        case 2:
-          HANDLE_CASE(2);
-          break;
-        case 3:
-          HANDLE_CASE(3);
-          break;
-        case 4:
-          HANDLE_CASE(4);
-          break;
-      }
-      THCudaCheck(cudaGetLastError());
+  CatArrayBatchedCopy<real, unsigned int, DIMS><<<catGrid, applyBlock, 0, stream->stream>>>(data, d_inputs, numInputs, param, cat_dimension, param.outputStride[cat_dimension]);
+
+    switch (nDims) {
+      case 1:
+        HANDLE_CASE(1);
+        break;
+      case 2:
+        HANDLE_CASE(2);
+        break;
+      case 3:
+        HANDLE_CASE(3);
+        break;
+      case 4:
+        HANDLE_CASE(4);
+        break;
     }
+    THCudaCheck(cudaGetLastError());
     THCudaCheck(THCudaFree(state, d_inputs));
 #undef HANDLE_CASE
   } else {
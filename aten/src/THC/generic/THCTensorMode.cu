@@ -23,29 +23,34 @@ THC_API void THCTensor_(calculateMode)(THCState *state,
   int64_t nElement = THCTensor_(size)(state, input, THCTensor_(nDimension)(state, input) - 1);
   THCThrustAllocator thrustAlloc(state);
 
-  // Wrap input data, sortBuffer, in Thrust device vectors
-  thrust::device_ptr<real> vecPtr = thrust::device_pointer_cast(data);
-  thrust::device_vector<real> iter(vecPtr, vecPtr + nElement);
-  thrust::device_ptr<int64_t> sbPtr = thrust::device_pointer_cast(THCudaLongStorage_data(state, sortBuffer));
-  thrust::device_vector<int64_t> seq(sbPtr, sbPtr + nElement);
+  cudaStream_t stream = THCState_getCurrentStream(state);
+
+  // Sort a copy of the input data, in temporary storage of the caching
+  // allocator rather than in Thrust device vectors
+  real *iterData;
+  THCudaCheck(THCudaMalloc(state, (void**) &iterData, nElement * sizeof(real)));
+  THCudaCheck(cudaMemcpyAsync(iterData, data, nElement * sizeof(real),
+                              cudaMemcpyDeviceToDevice, stream));
+  thrust::device_ptr<real> iter = thrust::device_pointer_cast(iterData);
+  thrust::device_ptr<int64_t> seq = thrust::device_pointer_cast(THCudaLongStorage_data(state, sortBuffer));
 
   // Fill sortBuffer with [0, 1, 2, ... nElement - 1]
   thrust::sequence(
 #if CUDA_VERSION >= 7000
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+    thrust::cuda::par(thrustAlloc).on(stream),
 #else
     thrust::device,
 #endif
-    seq.begin(), seq.end());
+    seq, seq + nElement);
 
   // Sort the input data. The original indices of the data are stored in seq
   thrust::sort_by_key(
 #if CUDA_VERSION >= 7000
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+    thrust::cuda::par(thrustAlloc).on(stream),
 #else
     thrust::device,
 #endif
-    iter.begin(), iter.end(), seq.begin()
+    iter, iter + nElement, seq
 #if defined(THC_REAL_IS_HALF)
     , ThrustHalfLess()
 #endif
@@ -55,11 +60,11 @@ THC_API void THCTensor_(calculateMode)(THCState *state,
   // Add 1 if two neighboring element are not equal.
   int unique = 1 + thrust::inner_product(
 #if CUDA_VERSION >= 7000
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+    thrust::cuda::par(thrustAlloc).on(stream),
 #else
     thrust::device,
 #endif
-    iter.begin(), iter.end() - 1, iter.begin() + 1, 0, thrust::plus<int>(),
+    iter, iter + nElement - 1, iter + 1, 0, thrust::plus<int>(),
 #if defined(THC_REAL_IS_HALF)
     ThrustHalfNotEqualTo()
 #else
@@ -68,52 +73,68 @@ THC_API void THCTensor_(calculateMode)(THCState *state,
   );
 
   // Count frequency of each element
-  thrust::device_vector<real> keys(unique);
-  thrust::device_vector<int> counts(unique);
+  real *keysData;
+  int *countsData;
+  THCudaCheck(THCudaMalloc(state, (void**) &keysData, unique * sizeof(real)));
+  THCudaCheck(THCudaMalloc(state, (void**) &countsData, unique * sizeof(int)));
+  thrust::device_ptr<real> keys = thrust::device_pointer_cast(keysData);
+  thrust::device_ptr<int> counts = thrust::device_pointer_cast(countsData);
   thrust::reduce_by_key(
 #if CUDA_VERSION >= 7000
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+    thrust::cuda::par(thrustAlloc).on(stream),
 #else
     thrust::device,
 #endif
-    iter.begin(), iter.end(),
-    thrust::constant_iterator<int>(1), keys.begin(), counts.begin()
+    iter, iter + nElement,
+    thrust::constant_iterator<int>(1), keys, counts
 #if defined(THC_REAL_IS_HALF)
     , ThrustHalfEqualTo()
 #endif
   );
 
   // Find index of maximum count
-  thrust::device_vector<int>::iterator it = thrust::max_element(
+  thrust::device_ptr<int> it = thrust::max_element(
 #if CUDA_VERSION >= 7000
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+    thrust::cuda::par(thrustAlloc).on(stream),
 #else
     thrust::device,
 #endif
-    counts.begin(), counts.end());
-  real mode = keys[it - counts.begin()];
+    counts, counts + unique);
+  real mode;
+  THCudaCheck(cudaMemcpyAsync(&mode, keysData + (it - counts), sizeof(real),
+                              cudaMemcpyDeviceToHost, stream));
+  THCudaCheck(cudaStreamSynchronize(stream));
 
   // Find first index within which it occurs
 #if defined(THC_REAL_IS_HALF)
-  thrust::device_vector<real>::iterator positionIter = thrust::find_if(
+  thrust::device_ptr<real> positionIter = thrust::find_if(
 #if CUDA_VERSION >= 7000
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+    thrust::cuda::par(thrustAlloc).on(stream),
 #else
     thrust::device,
 #endif
-    iter.begin(), iter.end(), ThrustHalfEqualToPredicate(mode));
+    iter, iter + nElement, ThrustHalfEqualToPredicate(mode));
 #else
-  thrust::device_vector<real>::iterator positionIter = thrust::find(
+  thrust::device_ptr<real> positionIter = thrust::find(
 #if CUDA_VERSION >= 7000
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+    thrust::cuda::par(thrustAlloc).on(stream),
 #else
     thrust::device,
 #endif
-    iter.begin(), iter.end(), mode);
+    iter, iter + nElement, mode);
 #endif
 
-  THAssert(positionIter != iter.end());
-  int64_t index = TH_INDEX_BASE + seq[positionIter - iter.begin()];
+  THAssert(positionIter != iter + nElement);
+  int64_t position_index;
+  THCudaCheck(cudaMemcpyAsync(&position_index,
+                              THCudaLongStorage_data(state, sortBuffer) + (positionIter - iter),
+                              sizeof(int64_t), cudaMemcpyDeviceToHost, stream));
+  THCudaCheck(cudaStreamSynchronize(stream));
+  int64_t index = TH_INDEX_BASE + position_index;
+
+  THCudaCheck(THCudaFree(state, iterData));
+  THCudaCheck(THCudaFree(state, keysData));
+  THCudaCheck(THCudaFree(state, countsData));
 
   // Place mode, index in output
   ptrdiff_t valuesOffset = THCTensor_(storageOffset)(state, values);
@@ -15,8 +15,10 @@ THC_API void THCTensor_(uniform)(THCState* state, THCTensor *self_, double a, do
   THCTensor *self = THCTensor_(newContiguous)(state, self_);
   real *data = THCTensor_(data)(state, self);
 
-  generate_uniform<<<NUM_BLOCKS, BLOCK_SIZE, 0, THCState_getCurrentStream(state)>>>(
-      gen->gen_states, size, data, a, b);
+  uint64_t offset;
+  int blocks = philoxNumBlocks(gen, size, &offset);
+  generate_uniform<<<blocks, BLOCK_SIZE, 0, THCState_getCurrentStream(state)>>>(
+      gen->initial_seed, offset, size, data, a, b);
 
   THCTensor_(freeCopyTo)(state, self, self_);
 };
@@ -30,8 +32,10 @@ THC_API void THCTensor_(normal)(THCState* state, THCTensor *self_, double mean,
   THCTensor *self = THCTensor_(newContiguous)(state, self_);
   real *data = THCTensor_(data)(state, self);
 
-  generate_normal<<<NUM_BLOCKS, BLOCK_SIZE, 0, THCState_getCurrentStream(state)>>>(
-      gen->gen_states, size, data, mean, stdv);
+  uint64_t offset;
+  int blocks = philoxNumBlocks(gen, size, &offset);
+  generate_normal<<<blocks, BLOCK_SIZE, 0, THCState_getCurrentStream(state)>>>(
+      gen->initial_seed, offset, size, data, mean, stdv);
 
   THCTensor_(freeCopyTo)(state, self, self_);
 };
@@ -397,9 +401,9 @@ void THCTensor_(randn)(THCState *state, THCTensor *r_, THLongStorage *size)
 #endif
 
 #if defined(THC_REAL_IS_DOUBLE)
-GENERATE_KERNEL1(generate_bernoulli, double, double p, double, curand_uniform_double, x <= p)
+GENERATE_PHILOX_KERNEL1(generate_bernoulli, double, double p, double, curand_uniform_double, x <= p)
 #else
-GENERATE_KERNEL1(generate_bernoulli, real, double p, float, curand_uniform, (ScalarConvert<bool, real>::to(x <= p)))
+GENERATE_PHILOX_KERNEL1(generate_bernoulli, real, double p, float, curand_uniform, (ScalarConvert<bool, real>::to(x <= p)))
 #endif
 
 THC_API void THCTensor_(bernoulli)(THCState* state, THCTensor *self_, double p)
@@ -411,8 +415,10 @@ THC_API void THCTensor_(bernoulli)(THCState* state, THCTensor *self_, double p)
   THCTensor *self = THCTensor_(newContiguous)(state, self_);
   real *data = THCTensor_(data)(state, self);
 
-  generate_bernoulli<<<NUM_BLOCKS, BLOCK_SIZE, 0, THCState_getCurrentStream(state)>>>(
-      gen->gen_states, size, data, p);
+  uint64_t offset;
+  int blocks = philoxNumBlocks(gen, size, &offset);
+  generate_bernoulli<<<blocks, BLOCK_SIZE, 0, THCState_getCurrentStream(state)>>>(
+      gen->initial_seed, offset, size, data, p);
 
   THCTensor_(freeCopyTo)(state, self, self_);
 };
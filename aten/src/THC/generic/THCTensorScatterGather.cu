@@ -185,9 +185,22 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
 #undef RUN
 
 #define RUN(TYPE, DIMS, REAL)                                           \
-  THCudaTensor_scatterAddKernel<TYPE, REAL, DIMS>                               \
-  <<<grid, block, 0, THCState_getCurrentStream(state)>>>(               \
-    tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements);
+  if (sortedOffsets) {                                                  \
+    THCudaTensor_scatterAddOffsetsKernel<TYPE, REAL, DIMS>              \
+    <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
+      tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements,         \
+      THCudaLongTensor_data(state, sortedOffsets));                     \
+    THCudaLongTensor_sortKeysWithPositions(state, sortedOffsets, positions); \
+    THCudaTensor_scatterAddSortedKernel<TYPE, REAL, accreal, DIMS>      \
+    <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
+      tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements,         \
+      THCudaLongTensor_data(state, sortedOffsets),                      \
+      THCudaLongTensor_data(state, positions));                         \
+  } else {                                                              \
+    THCudaTensor_scatterAddKernel<TYPE, REAL, DIMS>                     \
+    <<<grid, block, 0, THCState_getCurrentStream(state)>>>(             \
+      tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements);        \
+  }
 
 void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaLongTensor *index, THCTensor *src) {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 2, tensor, src));
@@ -225,6 +238,26 @@ void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaL
     tensor = THCTensor_(newContiguous)(state, tensor);
   }
 
+  // When many source elements land on each output element, the atomics
+  // of scatterAddKernel serialize on the same addresses (and for half each
+  // one is a compare-and-swap loop). Sorting the destination offsets lets
+  // a single thread sum each output element instead, in a fixed order, so
+  // this is also the path for reproducible results.
+#if defined(THC_REAL_IS_HALF)
+  const int64_t sortedMinPerOutput = 2;
+#else
+  const int64_t sortedMinPerOutput = 8;
+#endif
+  THCudaLongTensor *sortedOffsets = NULL;
+  THCudaLongTensor *positions = NULL;
+  if (totalElements > 0 &&
+      (THCState_getDeterministicAccumulation(state) ||
+       THCudaLongTensor_size(state, index, dim) >=
+         sortedMinPerOutput * THCTensor_(size)(state, tensor, dim))) {
+    sortedOffsets = THCudaLongTensor_newWithSize1d(state, totalElements);
+    positions = THCudaLongTensor_new(state);
+  }
+
   if (TensorUtils<THCTensor>::canUse32BitIndexMath(state, tensor) &&
       TensorUtils<THCTensor>::canUse32BitIndexMath(state, src) &&
       TensorUtils<THCudaLongTensor>::canUse32BitIndexMath(state, index)) {
@@ -261,6 +294,11 @@ void THCTensor_(scatterAdd)(THCState* state, THCTensor *tensor, int dim, THCudaL
     RUN(uint64_t, -1, real)
   }
 
+  if (sortedOffsets) {
+    THCudaLongTensor_free(state, sortedOffsets);
+    THCudaLongTensor_free(state, positions);
+  }
+
   if (oldTensor) {
     TensorUtils<THCTensor>::copyIgnoringOverlaps(state, oldTensor, tensor);
     THCTensor_(free)(state, tensor);
@@ -276,6 +276,95 @@ void sortViaThrust(THCState* state,
   THCudaLongTensor_freeCopyTo(state, trContigIndices, indices);
 }
 
+#if defined(USE_CUB) && !defined(THC_REAL_IS_HALF)
+// Sorts each slice with CUB's segmented radix sort, which is stable like
+// sortViaThrust, but makes a few passes over the keys per slice instead of
+// sorting every element twice across all slices. CUB counts elements
+// with an int.
+bool canSortViaCub(THCState* state, THCTensor* input) {
+  return THCTensor_(nElement)(state, input) <= INT_MAX;
+}
+
+void sortViaCub(THCState* state,
+                THCTensor* sorted,
+                THCudaLongTensor* indices,
+                THCTensor* input,
+                int dim, bool dir) {
+  int nDims = THCTensor_(nDimension)(state, input);
+  ptrdiff_t totalElements = THCTensor_(nElement)(state, input);
+  int64_t sliceSize = THCTensor_(size)(state, input, dim);
+  int numSlices = (int) (totalElements / sliceSize);
+
+  // CUB needs the slices innermost and contiguous
+  THCTensor* trInput = THCTensor_(newWithTensor)(state, input);
+  if (dim != nDims - 1) {
+    THCTensor_(transpose)(state, trInput, NULL, dim, nDims - 1);
+  }
+  THCTensor* keysIn = THCTensor_(newContiguous)(state, trInput);
+  THCTensor_(free)(state, trInput);
+
+  THCTensor* keysOut = THCTensor_(new)(state);
+  THCTensor_(resizeAs)(state, keysOut, keysIn);
+  THCudaLongTensor* valuesIn = THCudaLongTensor_new(state);
+  THLongStorage* keySize = THCTensor_(newSizeOf)(state, keysIn);
+  THCudaLongTensor_resize(state, valuesIn, keySize, NULL);
+  THLongStorage_free(keySize);
+  THCudaLongTensor_fillSliceWithIndex(state, valuesIn, nDims - 1);
+  THCudaLongTensor* valuesOut = THCudaLongTensor_new(state);
+  THCudaLongTensor_resizeAs(state, valuesOut, valuesIn);
+
+  // Slice i is [offsets[i], offsets[i + 1])
+  THCThrustAllocator thrustAlloc(state);
+  int* offsets;
+  THCudaCheck(THCudaMalloc(state, (void**) &offsets, (numSlices + 1) * sizeof(int)));
+  thrust::device_ptr<int> offsetsIter(offsets);
+  thrust::sequence(
+#if CUDA_VERSION >= 7000
+    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+#endif
+    offsetsIter, offsetsIter + numSlices + 1, 0, (int) sliceSize);
+
+  real* keysInData = THCTensor_(data)(state, keysIn);
+  real* keysOutData = THCTensor_(data)(state, keysOut);
+  int64_t* valuesInData = THCudaLongTensor_data(state, valuesIn);
+  int64_t* valuesOutData = THCudaLongTensor_data(state, valuesOut);
+
+#define SORT_PAIRS(TEMP, TEMP_BYTES)                                    \
+  (dir ?                                                                \
+   cub::DeviceSegmentedRadixSort::SortPairsDescending(                  \
+     TEMP, TEMP_BYTES, keysInData, keysOutData,                         \
+     valuesInData, valuesOutData, (int) totalElements, numSlices,       \
+     offsets, offsets + 1, 0, sizeof(real) * 8,                         \
+     THCState_getCurrentStream(state)) :                                \
+   cub::DeviceSegmentedRadixSort::SortPairs(                            \
+     TEMP, TEMP_BYTES, keysInData, keysOutData,                         \
+     valuesInData, valuesOutData, (int) totalElements, numSlices,       \
+     offsets, offsets + 1, 0, sizeof(real) * 8,                         \
+     THCState_getCurrentStream(state)))
+
+  size_t tempBytes = 0;
+  THCudaCheck(SORT_PAIRS(NULL, tempBytes));
+  void* temp;
+  THCudaCheck(THCudaMalloc(state, &temp, tempBytes));
+  THCudaCheck(SORT_PAIRS(temp, tempBytes));
+#undef SORT_PAIRS
+
+  THCudaCheck(THCudaFree(state, temp));
+  THCudaCheck(THCudaFree(state, offsets));
+  THCTensor_(free)(state, keysIn);
+  THCudaLongTensor_free(state, valuesIn);
+
+  // Reverse the transposition as needed
+  if (dim != nDims - 1) {
+    THCTensor_(transpose)(state, keysOut, NULL, dim, nDims - 1);
+    THCudaLongTensor_transpose(state, valuesOut, NULL, dim, nDims - 1);
+  }
+
+  THCTensor_(freeCopyTo)(state, keysOut, sorted);
+  THCudaLongTensor_freeCopyTo(state, valuesOut, indices);
+}
+#endif
+
 THC_API void THCTensor_(sort)(THCState* state,
                                THCTensor *sorted,
                                THCudaLongTensor *indices,
@@ -324,6 +413,10 @@ THC_API void THCTensor_(sort)(THCState* state,
     // Sort using our in-place k/v kernel that supports arbitrary
     // layout
     THCTensor_(sortKeyValueInplace)(state, sorted, indices, dim, order);
+#if defined(USE_CUB) && !defined(THC_REAL_IS_HALF)
+  } else if (canSortViaCub(state, input)) {
+    sortViaCub(state, sorted, indices, input, dim, (bool) order);
+#endif
   } else {
     // Otherwise, fall back upon Thrust, which handles all other cases
     // (potentially slowly, with extra copies/memory allocations)
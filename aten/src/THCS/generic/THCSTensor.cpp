@@ -73,6 +73,8 @@ static void THCSTensor_(rawInit)(THCState *state, THCSTensor *self)
   self->nDimensionV = 0;
   self->coalesced = 0;
   self->nnz = 0;
+  self->csr = NULL;
+  self->csrColumns = NULL;
   // self->flag = TH_TENSOR_REFCOUNTED;
   self->refcount = 1;
 }
@@ -86,9 +88,21 @@ THCSTensor* THCSTensor_(rawResize)(THCState *state, THCSTensor *self, int nDimI,
   }
   self->nDimensionI = nDimI;
   self->nDimensionV = nDimV;
+  THCSTensor_(invalidateRowPointers)(state, self);
   return self;
 }
 
+void THCSTensor_(invalidateRowPointers)(THCState *state, THCSTensor *self) {
+  if (self->csr) {
+    THCudaIntTensor_free(state, self->csr);
+    self->csr = NULL;
+  }
+  if (self->csrColumns) {
+    THCudaIntTensor_free(state, self->csrColumns);
+    self->csrColumns = NULL;
+  }
+}
+
 // directly assign without cloning or retaining (internal method)
 THCSTensor* THCSTensor_(_move)(THCState *state, THCSTensor *self, THCIndexTensor *indices, THCTensor *values) {
   int empty = THCTensor_(nDimension)(state, values) == 0;
@@ -111,6 +125,7 @@ THCSTensor* THCSTensor_(_move)(THCState *state, THCSTensor *self, THCIndexTensor
   self->values = values;
   self->nnz = empty ? 0 : THCTensor_(size)(state, values, 0);
   self->coalesced = 0;
+  THCSTensor_(invalidateRowPointers)(state, self);
 
   return self;
 }
@@ -353,6 +368,11 @@ int THCSTensor_(isCoalesced)(THCState *state, const THCSTensor *self) {
   return self->coalesced;
 }
 
+void THCSTensor_(setCoalesced)(THCState *state, THCSTensor *self, int coalesced) {
+  self->coalesced = coalesced;
+  THCSTensor_(invalidateRowPointers)(state, self);
+}
+
 void THCSTensor_(free)(THCState *state, THCSTensor *self)
 {
   if(!self)
@@ -362,6 +382,7 @@ void THCSTensor_(free)(THCState *state, THCSTensor *self)
     THFree(self->size);
     THCIndexTensor_(free)(state, self->indices);
     THCTensor_(free)(state, self->values);
+    THCSTensor_(invalidateRowPointers)(state, self);
     THFree(self);
   }
 }
@@ -448,6 +469,7 @@ void THCTensor_(sparseMask)(THCState *state, THCSTensor *r_, THCTensor *t, THCST
   THCSTensor_(_move)(state, r_, THCIndexTensor_(newClone)(state, maskIndices), rValues);
   r_->coalesced = mask->coalesced;
   r_->nnz = mask->nnz;
+  THCSTensor_(invalidateRowPointers)(state, r_);
 
   THCudaLongTensor *indices = THCudaLongTensor_newWithSize1d(state, mask->nnz);
   THCudaLongTensor *indicesBuffer = THCudaLongTensor_new(state);
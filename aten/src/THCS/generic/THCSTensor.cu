@@ -224,6 +224,7 @@ void THCSTensor_(transpose)(THCState *state, THCSTensor *self, int d1, int d2) {
   THCIndexTensor_(free)(state, buffer);
   THCIndexTensor_(free)(state, slice1);
   THCIndexTensor_(free)(state, slice2);
+  THCSTensor_(invalidateRowPointers)(state, self);
 }
 
 int THCSTensor_(getDevice)(THCState* state, const THCSTensor* tensor) {
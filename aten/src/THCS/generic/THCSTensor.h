@@ -16,6 +16,12 @@ typedef struct THCSTensor
     // Some math operations can only be performed on ordered sparse tensors
     int coalesced;
     int refcount;
+    // The CSR row pointers and column indices of a coalesced matrix, in the
+    // 32-bit integers of cuSPARSE, computed by newRowPointers and
+    // newColumnIndices and dropped when the indices change. NULL when not
+    // computed.
+    THCudaIntTensor *csr;
+    THCudaIntTensor *csrColumns;
 
 } THCSTensor;
 
@@ -58,6 +64,8 @@ TH_API void THCSTensor_(copy)(THCState *state, THCSTensor *self, THCSTensor *src
 
 TH_API void THCSTensor_(transpose)(THCState *state, THCSTensor *self, int dimension1_, int dimension2_);
 TH_API int THCSTensor_(isCoalesced)(THCState *state, const THCSTensor *self);
+// Only for callers that built the indices sorted and unique
+TH_API void THCSTensor_(setCoalesced)(THCState *state, THCSTensor *self, int coalesced);
 TH_API THCSTensor *THCSTensor_(newCoalesce)(THCState *state, THCSTensor *self);
 
 TH_API void THCTensor_(sparseMask)(THCState *state, THCSTensor *r_, THCTensor *t, THCSTensor *mask);
@@ -76,6 +84,8 @@ TH_API THCSTensor* THCSTensor_(rawResize)(THCState *state, THCSTensor *self, int
 TH_API THCTensor *THCSTensor_(newValuesWithSizeOf)(THCState *state, THCTensor *values, int64_t nnz);
 TH_API THCSTensor* THCSTensor_(_move)(THCState *state, THCSTensor *self, THCIndexTensor *indices, THCTensor *values);
 TH_API THCSTensor* THCSTensor_(_set)(THCState *state, THCSTensor *self, THCIndexTensor *indices, THCTensor *values);
+// Drops the cached CSR indices, for callers writing to the indices
+TH_API void THCSTensor_(invalidateRowPointers)(THCState *state, THCSTensor *self);
 // forceClone is intended to use as a boolean
 TH_API THCIndexTensor* THCSTensor_(newFlattenedIndices)(THCState *state, THCSTensor *self, int forceClone);
 
@@ -23,6 +23,47 @@ THCudaIntTensor *THCSTensor_(toCSR)(THCState *state, THCIndexTensor *rowIndices,
   return csr;
 }
 
+THCudaIntTensor *THCSTensor_(newRowPointers)(THCState *state, THCSTensor *self) {
+  THArgCheck(self->coalesced, 2, "row pointers of an uncoalesced tensor");
+  THArgCheck(self->nDimensionI >= 1, 2, "row pointers of a 0-dim tensor");
+  ptrdiff_t volatile *cache = (ptrdiff_t volatile *)&self->csr;
+  THCudaIntTensor *csr = (THCudaIntTensor *)THAtomicGetPtrdiff(cache);
+  if (!csr) {
+    THCIndexTensor *indices = THCSTensor_(newIndices)(state, self);
+    THCIndexTensor *rowIndices = THCIndexTensor_(newSelect)(state, indices, 0, 0);
+    csr = THCSTensor_(toCSR)(state, rowIndices, self->size[0], self->nnz);
+    THCIndexTensor_(free)(state, rowIndices);
+    THCIndexTensor_(free)(state, indices);
+    // Concurrent readers may compute them at once, the first one is kept
+    if (!THAtomicCompareAndSwapPtrdiff(cache, 0, (ptrdiff_t)csr)) {
+      THCudaIntTensor_free(state, csr);
+      csr = (THCudaIntTensor *)THAtomicGetPtrdiff(cache);
+    }
+  }
+  THCudaIntTensor_retain(state, csr);
+  return csr;
+}
+
+THCudaIntTensor *THCSTensor_(newColumnIndices)(THCState *state, THCSTensor *self) {
+  THArgCheck(self->nDimensionI == 2, 2, "column indices of a %dD tensor", self->nDimensionI);
+  ptrdiff_t volatile *cache = (ptrdiff_t volatile *)&self->csrColumns;
+  THCudaIntTensor *columns = (THCudaIntTensor *)THAtomicGetPtrdiff(cache);
+  if (!columns) {
+    THCIndexTensor *indices = THCSTensor_(newIndices)(state, self);
+    THCIndexTensor *colIndices = THCIndexTensor_(newSelect)(state, indices, 0, 1);
+    columns = THCudaIntTensor_newWithSize1d(state, colIndices->size[0]);
+    THCudaIntTensor_copyCudaLong(state, columns, colIndices);
+    THCIndexTensor_(free)(state, colIndices);
+    THCIndexTensor_(free)(state, indices);
+    if (!THAtomicCompareAndSwapPtrdiff(cache, 0, (ptrdiff_t)columns)) {
+      THCudaIntTensor_free(state, columns);
+      columns = (THCudaIntTensor *)THAtomicGetPtrdiff(cache);
+    }
+  }
+  THCudaIntTensor_retain(state, columns);
+  return columns;
+}
+
 void THCSTensor_(zero)(THCState *state, THCSTensor *self) {
   if (self->indices->nDimension) {
     THCIndexTensor_(resizeNd)(state, self->indices, 0, NULL, NULL);
@@ -31,6 +72,7 @@ void THCSTensor_(zero)(THCState *state, THCSTensor *self) {
     THCTensor_(resizeNd)(state, self->values, 0, NULL, NULL);
   }
   self->nnz = 0;
+  THCSTensor_(invalidateRowPointers)(state, self);
 }
 
 void THCSTensor_(zeros)(THCState *state, THCSTensor *r_, THLongStorage *size)
@@ -59,7 +101,6 @@ void THCSTensor_(spaddmm)(THCState *state, THCTensor *r_, real beta, THCTensor *
 #if defined(THCS_REAL_IS_FLOAT) || defined(THCS_REAL_IS_DOUBLE)
   THCAssertSameGPU(THCSTensor_(checkGPU)(state, 1, 4, sparse_, r_, t, dense));
   THCudaIntTensor *csr;
-  THCIndexTensor *indices;
   THCTensor *values, *r__, *dense_;
 
   THArgCheck(sparse_->nDimensionI == 2, 2,
@@ -85,14 +126,11 @@ void THCSTensor_(spaddmm)(THCState *state, THCTensor *r_, real beta, THCTensor *
   THCSTensor *sparse = THCSTensor_(newCoalesce)(state, sparse_);
 
   int64_t nnz = THCSTensor_(nnz)(state, sparse);
-  indices = THCSTensor_(newIndices)(state, sparse);
   values = THCSTensor_(newValues)(state, sparse);
 
-  THCIndexTensor *rowIndices = THCIndexTensor_(newSelect)(state, indices, 0, 0);
-  THCIndexTensor *colIndices = THCIndexTensor_(newSelect)(state, indices, 0, 1);
-  csr = THCSTensor_(toCSR)(state, rowIndices, m, nnz);
-  THCudaIntTensor *colIndicesInt = THCudaIntTensor_newWithSize1d(state, colIndices->size[0]);
-  THCudaIntTensor_copyCudaLong(state, colIndicesInt, colIndices);
+  // Cached on the sparse tensor, which is sparse_ if it was coalesced
+  csr = THCSTensor_(newRowPointers)(state, sparse);
+  THCudaIntTensor *colIndicesInt = THCSTensor_(newColumnIndices)(state, sparse);
 
   char transpose_dense;
 
@@ -157,9 +195,6 @@ void THCSTensor_(spaddmm)(THCState *state, THCTensor *r_, real beta, THCTensor *
   THCTensor_(freeCopyTo)(state, r__, r_);
   THCudaIntTensor_free(state, colIndicesInt);
   THCudaIntTensor_free(state, csr);
-  THCIndexTensor_(free)(state, indices);
-  THCIndexTensor_(free)(state, rowIndices);
-  THCIndexTensor_(free)(state, colIndices);
   THCTensor_(free)(state, values);
   THCSTensor_(free)(state, sparse);
 #else
@@ -332,6 +367,7 @@ void THCSTensor_(mul)(THCState *state, THCSTensor *r_, THCSTensor *t, real value
     THCIndexTensor_(copy)(state, r_indices_, t_indices_);
     THCTensor_(mul)(state, r_values_, t_values_, value);
     r_->nnz = t->nnz;
+    THCSTensor_(invalidateRowPointers)(state, r_);
     r_->coalesced = t->coalesced;
 
     THCIndexTensor_(free)(state, r_indices_);
@@ -358,6 +394,7 @@ void THCSTensor_(div)(THCState *state, THCSTensor *r_, THCSTensor *t, real value
     THCIndexTensor_(copy)(state, r_indices_, t_indices_);
     THCTensor_(div)(state, r_values_, t_values_, value);
     r_->nnz = t->nnz;
+    THCSTensor_(invalidateRowPointers)(state, r_);
     r_->coalesced = t->coalesced;
 
     THCIndexTensor_(free)(state, r_indices_);
@@ -468,6 +505,7 @@ void THCSTensor_(cmul)(THCState *state, THCSTensor *r_, THCSTensor *t_, THCSTens
       (uint64_t)t_nnz, (uint64_t)s_nnz, (uint64_t*)resultNnz->data);
   THCudaCheck(cudaGetLastError());
   r_->nnz = THCudaLongStorage_get(state, resultNnz, 0);
+  THCSTensor_(invalidateRowPointers)(state, r_);
   THCudaLongStorage_free(state, resultNnz);
   r_->coalesced = 1;
 
@@ -495,6 +533,7 @@ void THCSTensor_(pow)(THCState *state, THCSTensor *r_, THCSTensor *t_, real valu
   THCIndexTensor_(copy)(state, r_indices_, t_indices_);
   THCTensor_(pow)(state, r_values_, t_values_, value);
   r_->nnz = t->nnz;
+  THCSTensor_(invalidateRowPointers)(state, r_);
   r_->coalesced = t->coalesced;
 
   THCIndexTensor_(free)(state, r_indices_);
@@ -18,6 +18,11 @@ TH_API void THCTensor_(spaddcmul)(THCState *state, THCTensor *r_, THCTensor *t,
 TH_API void THCTensor_(spaddcdiv)(THCState *state, THCTensor *r_, THCTensor *t, real value, THCSTensor *src1, THCSTensor *src2);
 
 // dense = beta * dense + alpha * sparse * dense
+// The CSR row pointers (size(0) + 1 values) and column indices of a
+// coalesced matrix, cached until its indices change
+TH_API THCudaIntTensor *THCSTensor_(newRowPointers)(THCState *state, THCSTensor *self);
+TH_API THCudaIntTensor *THCSTensor_(newColumnIndices)(THCState *state, THCSTensor *self);
+
 TH_API void THCSTensor_(spaddmm)(THCState *state, THCTensor *r_, real beta, THCTensor *t, real alpha, THCSTensor *sparse, THCTensor *dense);
 // sparse = beta * sparse + alpha * sparse * dense
 TH_API void THCSTensor_(sspaddmm)(THCState *state, THCSTensor *r_, real beta, THCSTensor *t, real alpha, THCSTensor *sparse, THCTensor *dense);
@@ -17,6 +17,13 @@ inline int GET_BLOCKS(const int N)
   return (N + CUDA_NUM_THREADS - 1) / CUDA_NUM_THREADS;
 }
 
+// Gives the storage of a scratch tensor, like the columns of the im2col
+// convolutions, back to the caching allocator. The next convolution on the
+// same device and stream reuses the memory, instead of every layer keeping
+// its own columns from the forward to the backward pass.
+#define THCUNN_releaseScratch(STATE, T) \
+  THCTensor_(setStorage)(STATE, T, NULL, 0, NULL, NULL)
+
 #define THCUNN_resizeAs_indices(STATE, I1, I2)              \
   THLongStorage *size2 = THCTensor_(newSizeOf)(STATE, I2);  \
   if (!THCIndexTensor_(isSize)(STATE, I1, size2))           \
@@ -12,8 +12,13 @@ void THNN_(L1Cost_updateOutput)(
   accreal sum;
   ptrdiff_t size = THCTensor_(nElement)(state, input);
   input = THCTensor_(newContiguous)(state, input);
+  THCThrustAllocator thrustAlloc(state);
   thrust::device_ptr<real> input_data(THCTensor_(data)(state, input));
-  sum = thrust::transform_reduce(input_data, input_data+size, l1cost_functor<real, accreal>(), accreal(0), thrust::plus<accreal>());
+  sum = thrust::transform_reduce(
+#if CUDA_VERSION >= 7000
+    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+#endif
+    input_data, input_data+size, l1cost_functor<real, accreal>(), accreal(0), thrust::plus<accreal>());
 
   THCTensor_(free)(state, input);
 
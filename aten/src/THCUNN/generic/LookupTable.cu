@@ -178,8 +178,13 @@ void THNN_(LookupTable_renorm)(
   THCIndex_t * idxRaw = THCIndexTensor_(data)(state, idx);
 
   // get the unique indices
+  THCThrustAllocator thrustAlloc(state);
   thrust::device_ptr<THCIndex_t> idxThrust(idxRaw);
-  thrust::device_ptr<THCIndex_t> endIdxThrust(thrust::unique(idxThrust, idxThrust+numel));
+  thrust::device_ptr<THCIndex_t> endIdxThrust(thrust::unique(
+#if CUDA_VERSION >= 7000
+    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+#endif
+    idxThrust, idxThrust+numel));
   numel = endIdxThrust - idxThrust;
 
   // At launch time figure out what the index type is and norm type
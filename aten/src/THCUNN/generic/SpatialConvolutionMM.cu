@@ -234,6 +234,8 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
   }
 
   THCTensor_(free)(state, input);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 void THNN_(SpatialConvolutionMM_updateGradInput)(
@@ -351,6 +353,8 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
 
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
+
+  THCUNN_releaseScratch(state, gradColumns);
 }
 
 void THNN_(SpatialConvolutionMM_accGradParameters)(
@@ -522,6 +526,8 @@ void THNN_(SpatialConvolutionMM_accGradParameters)(
 
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 #endif
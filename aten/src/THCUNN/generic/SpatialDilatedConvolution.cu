@@ -219,6 +219,8 @@ void THNN_(SpatialDilatedConvolution_updateOutput)(
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, weight);
   if (bias) THCTensor_(free)(state, bias);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 void THNN_(SpatialDilatedConvolution_updateGradInput)(
@@ -327,6 +329,8 @@ void THNN_(SpatialDilatedConvolution_updateGradInput)(
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
   THCTensor_(free)(state, weight);
+
+  THCUNN_releaseScratch(state, gradColumns);
 }
 
 void THNN_(SpatialDilatedConvolution_accGradParameters)(
@@ -492,6 +496,8 @@ void THNN_(SpatialDilatedConvolution_accGradParameters)(
 
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 #endif
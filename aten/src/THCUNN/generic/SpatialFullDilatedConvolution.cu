@@ -213,6 +213,8 @@ void THNN_(SpatialFullDilatedConvolution_updateOutput)(
 
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, weight);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 void THNN_(SpatialFullDilatedConvolution_updateGradInput)(
@@ -322,6 +324,8 @@ void THNN_(SpatialFullDilatedConvolution_updateGradInput)(
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
   THCTensor_(free)(state, weight);
+
+  THCUNN_releaseScratch(state, gradColumns);
 }
 
 
@@ -493,6 +497,8 @@ void THNN_(SpatialFullDilatedConvolution_accGradParameters)(
 
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 #endif
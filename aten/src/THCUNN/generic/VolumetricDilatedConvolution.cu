@@ -232,6 +232,8 @@ void THNN_(VolumetricDilatedConvolution_updateOutput)(
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, weight);
   if (bias) THCTensor_(free)(state, bias);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 void THNN_(VolumetricDilatedConvolution_updateGradInput)(
@@ -345,6 +347,8 @@ void THNN_(VolumetricDilatedConvolution_updateGradInput)(
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
   THCTensor_(free)(state, weight);
+
+  THCUNN_releaseScratch(state, gradColumns);
 }
 
 void THNN_(VolumetricDilatedConvolution_accGradParameters)(
@@ -501,6 +505,8 @@ void THNN_(VolumetricDilatedConvolution_accGradParameters)(
 
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 #endif
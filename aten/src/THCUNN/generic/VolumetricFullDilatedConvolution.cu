@@ -236,6 +236,8 @@ void THNN_(VolumetricFullDilatedConvolution_updateOutput)(
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, weight);
 
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 void THNN_(VolumetricFullDilatedConvolution_updateGradInput)(
@@ -354,6 +356,8 @@ void THNN_(VolumetricFullDilatedConvolution_updateGradInput)(
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
   THCTensor_(free)(state, weight);
+
+  THCUNN_releaseScratch(state, gradColumns);
 }
 
 
@@ -532,6 +536,8 @@ void THNN_(VolumetricFullDilatedConvolution_accGradParameters)(
 
   THCTensor_(free)(state, input);
   THCTensor_(free)(state, gradOutput);
+
+  THCUNN_releaseScratch(state, columns);
 }
 
 #endif
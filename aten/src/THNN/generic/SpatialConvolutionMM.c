@@ -91,6 +91,27 @@ static THTensor* THNN_(newViewWeightMM2d)(THTensor *weight) {
   return weight;
 }
 
+// The number of threads (at most one per frame) of the parallel loops over
+// the T frames of a batch. The loops are statically scheduled, so that
+// omp_get_thread_num() is below it and the frames of a thread are fixed.
+static inline int64_t THNN_(SpatialConvolutionMM_numThreads)(int64_t T) {
+  int64_t nThreads = 1;
+#ifdef _OPENMP
+  if (!omp_in_parallel()) {
+    nThreads = omp_get_max_threads();
+  }
+#endif
+  return nThreads < T ? nThreads : T;
+}
+
+static inline int64_t THNN_(SpatialConvolutionMM_threadId)(void) {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
 static void THNN_(SpatialConvolutionMM_updateOutput_frame)(
           THTensor *input,
           THTensor *output,
@@ -266,17 +287,16 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
   gradOutput = THTensor_(newContiguous)(gradOutput);
 
   THTensor_(resizeAs)(gradInput, input);
-  THTensor_(resizeAs)(fgradInput, finput);
-
-  // depending on the BLAS library, fgradInput (result tensor) might
-  // be left uninitialized on zero alpha, which might lead to weird behavior
-  // hence, to be safe, zero it
-  THTensor_(zero)(fgradInput);
   THTensor *tweight = THTensor_(new)();
   THTensor_(transpose)(tweight, weight, 0, 1);
 
   if(input->nDimension == 3)
   {
+    THTensor_(resizeAs)(fgradInput, finput);
+    // depending on the BLAS library, fgradInput (result tensor) might
+    // be left uninitialized on zero alpha, which might lead to weird behavior
+    // hence, to be safe, zero it
+    THTensor_(zero)(fgradInput);
     THNN_(SpatialConvolutionMM_updateGradInput_frame)(gradInput, gradOutput,
 						      tweight, fgradInput,
 						      kW, kH, dW, dH, padW, padH);
@@ -286,12 +306,20 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
     int64_t T = input->size[0];
     int64_t t;
 
-#pragma omp parallel for private(t)
+    // The columns of a frame are only needed until they are folded back
+    // into gradInput, so fgradInput holds those of one frame per thread
+    // rather than the whole batch, and is reused from call to call.
+    int64_t nThreads = THNN_(SpatialConvolutionMM_numThreads)(T);
+    THTensor_(resize3d)(fgradInput, nThreads, finput->size[1], finput->size[2]);
+    THTensor_(zero)(fgradInput);
+
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(t)
     for(t = 0; t < T; t++)
     {
       THTensor *gradInput_t = THTensor_(newSelect)(gradInput, 0, t);
       THTensor *gradOutput_t = THTensor_(newSelect)(gradOutput, 0, t);
-      THTensor *fgradInput_t = THTensor_(newSelect)(fgradInput, 0, t);
+      THTensor *fgradInput_t = THTensor_(newSelect)(
+        fgradInput, 0, THNN_(SpatialConvolutionMM_threadId)());
 
       THNN_(SpatialConvolutionMM_updateGradInput_frame)(gradInput_t, gradOutput_t,
 							tweight, fgradInput_t,
@@ -385,21 +413,70 @@ void THNN_(SpatialConvolutionMM_accGradParameters)(
     int64_t T = input->size[0];
     int64_t t;
 
+    // Every thread accumulates the gradients of its frames on its own, and
+    // the partial sums are then added up in thread order, so that the
+    // result does not depend on the timing of the threads.
+    int64_t nThreads = THNN_(SpatialConvolutionMM_numThreads)(T);
+    THTensor *gradWeightPartial = NULL;
+    THTensor *gradBiasPartial = NULL;
+    if (gradWeight) {
+      gradWeightPartial = THTensor_(newWithSize3d)(
+        nThreads, gradWeight->size[0], gradWeight->size[1]);
+      THTensor_(zero)(gradWeightPartial);
+    }
+    if (gradBias) {
+      gradBiasPartial = THTensor_(newWithSize2d)(nThreads, gradBias->size[0]);
+      THTensor_(zero)(gradBiasPartial);
+    }
+
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(t)
     for(t = 0; t < T; t++)
     {
+      int64_t tid = THNN_(SpatialConvolutionMM_threadId)();
       THTensor *gradOutput_t = THTensor_(newSelect)(gradOutput, 0, t);
       THTensor *finput_t = NULL;
+      THTensor *gradWeight_t = NULL;
+      THTensor *gradBias_t = NULL;
       if (gradWeight) {
         finput_t = THTensor_(newSelect)(finput, 0, t);
+        gradWeight_t = THTensor_(newSelect)(gradWeightPartial, 0, tid);
+      }
+      if (gradBias) {
+        gradBias_t = THTensor_(newSelect)(gradBiasPartial, 0, tid);
       }
 
-      THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradOutput_t, gradWeight,
-							  gradBias, finput_t, scale);
+      THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradOutput_t, gradWeight_t,
+							  gradBias_t, finput_t, scale);
 
       THTensor_(free)(gradOutput_t);
       if (gradWeight) {
         THTensor_(free)(finput_t);
+        THTensor_(free)(gradWeight_t);
+      }
+      if (gradBias) {
+        THTensor_(free)(gradBias_t);
+      }
+    }
+
+    int64_t i;
+    for(i = 0; i < nThreads; i++)
+    {
+      if (gradWeight) {
+        THTensor *partial = THTensor_(newSelect)(gradWeightPartial, 0, i);
+        THTensor_(cadd)(gradWeight, gradWeight, 1, partial);
+        THTensor_(free)(partial);
       }
+      if (gradBias) {
+        THTensor *partial = THTensor_(newSelect)(gradBiasPartial, 0, i);
+        THTensor_(cadd)(gradBias, gradBias, 1, partial);
+        THTensor_(free)(partial);
+      }
+    }
+    if (gradWeight) {
+      THTensor_(free)(gradWeightPartial);
+    }
+    if (gradBias) {
+      THTensor_(free)(gradBiasPartial);
     }
   }
 
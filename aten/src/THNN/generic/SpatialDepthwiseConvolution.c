@@ -0,0 +1,303 @@
+#ifndef TH_GENERIC_FILE
+#define TH_GENERIC_FILE "generic/SpatialDepthwiseConvolution.c"
+#else
+
+// Direct depthwise convolution: every output plane is the convolution of a
+// single input plane (input plane oc / depthwiseMultiplier for output plane
+// oc) with its kH x kW filter, so unlike SpatialDilatedConvolution, which
+// would need a separate im2col + GEMM per group, it needs no column buffer.
+// For every kernel tap, the loops run over the range of output columns that
+// read inside the input, leaving plain contiguous (for stride 1) inner loops
+// without bound checks.
+
+static inline void THNN_(SpatialDepthwiseConvolution_shapeCheck)(
+	THTensor *input, THTensor *gradOutput,
+	THTensor *weight, THTensor *bias,
+	int kH, int kW, int dH, int dW, int padH, int padW,
+	int dilationH, int dilationW) {
+  THArgCheck(kW > 0 && kH > 0, 9,
+             "kernel size should be greater than zero, but got kH: %d kW: %d", kH, kW);
+  THArgCheck(dW > 0 && dH > 0, 11,
+             "stride should be greater than zero, but got dH: %d dW: %d", dH, dW);
+  THArgCheck(dilationW > 0 && dilationH > 0, 15,
+             "dilation should be greater than zero, but got dilationH: %d, dilationW: %d",
+             dilationH, dilationW);
+
+  THNN_ARGCHECK(weight->nDimension == 4, 4, weight,
+                "4D weight tensor (nOutputPlane, 1, kH, kW) expected, "
+                "but got: %s");
+  THNN_CHECK_DIM_SIZE(weight, 4, 1, 1);
+  THNN_CHECK_DIM_SIZE(weight, 4, 2, kH);
+  THNN_CHECK_DIM_SIZE(weight, 4, 3, kW);
+  if (bias != NULL) {
+    THNN_CHECK_DIM_SIZE(bias, 1, 0, weight->size[0]);
+  }
+
+  THNN_ARGCHECK(input->nDimension == 4, 2, input,
+		"4D input tensor expected but got: %s");
+  int64_t nInputPlane = input->size[1];
+  int64_t nOutputPlane = weight->size[0];
+  THArgCheck(nOutputPlane % nInputPlane == 0, 4,
+             "the number of output planes (%ld) should be a multiple of the "
+             "number of input planes (%ld)", nOutputPlane, nInputPlane);
+
+  int64_t inputHeight  = input->size[2];
+  int64_t inputWidth   = input->size[3];
+  int64_t outputHeight = (inputHeight + 2*padH - (dilationH * (kH - 1) + 1)) / dH + 1;
+  int64_t outputWidth  = (inputWidth + 2*padW - (dilationW * (kW - 1) + 1)) / dW + 1;
+
+  if (outputWidth < 1 || outputHeight < 1) {
+    THError("Given input size per channel: (%ld x %ld). "
+      "Calculated output size per channel: (%ld x %ld). Output size is too small",
+      inputHeight, inputWidth, outputHeight, outputWidth);
+  }
+
+  if (gradOutput != NULL) {
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 0, input->size[0]);
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 1, nOutputPlane);
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 2, outputHeight);
+    THNN_CHECK_DIM_SIZE(gradOutput, 4, 3, outputWidth);
+  }
+}
+
+// The output columns [*begin, *end) whose input column (ow * dW + offset)
+// is in [0, inputWidth).
+static inline void THNN_(SpatialDepthwiseConvolution_validRange)(
+    int64_t offset, int dW, int64_t inputWidth, int64_t outputWidth,
+    int64_t *begin, int64_t *end) {
+  *begin = offset >= 0 ? 0 : (-offset + dW - 1) / dW;
+  *end = offset >= inputWidth ? 0 : (inputWidth - 1 - offset) / dW + 1;
+  if (*end > outputWidth) {
+    *end = outputWidth;
+  }
+}
+
+void THNN_(SpatialDepthwiseConvolution_updateOutput)(
+    THNNState *state,
+    THTensor *input,
+    THTensor *output,
+    THTensor *weight,
+    THTensor *bias,
+    int kW, int kH,
+    int dW, int dH,
+    int padW, int padH,
+    int dilationW, int dilationH)
+{
+  THNN_(SpatialDepthwiseConvolution_shapeCheck)
+    (input, NULL, weight, bias, kH, kW, dH, dW, padH, padW,
+     dilationH, dilationW);
+
+  input = THTensor_(newContiguous)(input);
+  weight = THTensor_(newContiguous)(weight);
+  if (bias) {
+    bias = THTensor_(newContiguous)(bias);
+  }
+
+  int64_t batchSize = input->size[0];
+  int64_t nInputPlane = input->size[1];
+  int64_t inputHeight = input->size[2];
+  int64_t inputWidth = input->size[3];
+  int64_t nOutputPlane = weight->size[0];
+  int64_t depthwiseMultiplier = nOutputPlane / nInputPlane;
+  int64_t outputHeight = (inputHeight + 2*padH - (dilationH * (kH - 1) + 1)) / dH + 1;
+  int64_t outputWidth  = (inputWidth + 2*padW - (dilationW * (kW - 1) + 1)) / dW + 1;
+
+  THTensor_(resize4d)(output, batchSize, nOutputPlane, outputHeight, outputWidth);
+
+  real *input_data = THTensor_(data)(input);
+  real *output_data = THTensor_(data)(output);
+  real *weight_data = THTensor_(data)(weight);
+  real *bias_data = bias ? THTensor_(data)(bias) : NULL;
+
+  int64_t p;
+#pragma omp parallel for private(p)
+  for (p = 0; p < batchSize * nOutputPlane; p++) {
+    int64_t oc = p % nOutputPlane;
+    int64_t ic = oc / depthwiseMultiplier;
+    real *input_p = input_data + ((p / nOutputPlane) * nInputPlane + ic) * inputHeight * inputWidth;
+    real *output_p = output_data + p * outputHeight * outputWidth;
+    real *weight_p = weight_data + oc * kH * kW;
+
+    real b = bias_data ? bias_data[oc] : 0;
+    int64_t i;
+    for (i = 0; i < outputHeight * outputWidth; i++) {
+      output_p[i] = b;
+    }
+
+    int64_t oh, ow;
+    int kh, kw;
+    for (oh = 0; oh < outputHeight; oh++) {
+      real *output_row = output_p + oh * outputWidth;
+      for (kh = 0; kh < kH; kh++) {
+        int64_t ih = oh * dH - padH + kh * dilationH;
+        if (ih < 0 || ih >= inputHeight) {
+          continue;
+        }
+        real *input_row = input_p + ih * inputWidth;
+        for (kw = 0; kw < kW; kw++) {
+          int64_t offset = kw * dilationW - padW;
+          int64_t begin, end;
+          THNN_(SpatialDepthwiseConvolution_validRange)
+            (offset, dW, inputWidth, outputWidth, &begin, &end);
+          real w = weight_p[kh * kW + kw];
+          for (ow = begin; ow < end; ow++) {
+            output_row[ow] += w * input_row[ow * dW + offset];
+          }
+        }
+      }
+    }
+  }
+
+  THTensor_(free)(input);
+  THTensor_(free)(weight);
+  if (bias) {
+    THTensor_(free)(bias);
+  }
+}
+
+void THNN_(SpatialDepthwiseConvolution_updateGradInput)(
+    THNNState *state,
+    THTensor *input,
+    THTensor *gradOutput,
+    THTensor *gradInput,
+    THTensor *weight,
+    int kW, int kH,
+    int dW, int dH,
+    int padW, int padH,
+    int dilationW, int dilationH)
+{
+  THNN_(SpatialDepthwiseConvolution_shapeCheck)
+    (input, gradOutput, weight, NULL, kH, kW, dH, dW, padH, padW,
+     dilationH, dilationW);
+
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+  weight = THTensor_(newContiguous)(weight);
+
+  int64_t batchSize = input->size[0];
+  int64_t nInputPlane = input->size[1];
+  int64_t inputHeight = input->size[2];
+  int64_t inputWidth = input->size[3];
+  int64_t nOutputPlane = weight->size[0];
+  int64_t depthwiseMultiplier = nOutputPlane / nInputPlane;
+  int64_t outputHeight = gradOutput->size[2];
+  int64_t outputWidth = gradOutput->size[3];
+
+  THTensor_(resize4d)(gradInput, batchSize, nInputPlane, inputHeight, inputWidth);
+  THTensor_(zero)(gradInput);
+
+  real *gradOutput_data = THTensor_(data)(gradOutput);
+  real *gradInput_data = THTensor_(data)(gradInput);
+  real *weight_data = THTensor_(data)(weight);
+
+  // Every input plane only gets the gradients of its own output planes, so
+  // the planes can be done in parallel.
+  int64_t p;
+#pragma omp parallel for private(p)
+  for (p = 0; p < batchSize * nInputPlane; p++) {
+    int64_t ic = p % nInputPlane;
+    real *gradInput_p = gradInput_data + p * inputHeight * inputWidth;
+    int64_t j;
+    for (j = 0; j < depthwiseMultiplier; j++) {
+      int64_t oc = ic * depthwiseMultiplier + j;
+      real *gradOutput_p = gradOutput_data +
+        ((p / nInputPlane) * nOutputPlane + oc) * outputHeight * outputWidth;
+      real *weight_p = weight_data + oc * kH * kW;
+
+      int64_t oh, ow;
+      int kh, kw;
+      for (oh = 0; oh < outputHeight; oh++) {
+        real *gradOutput_row = gradOutput_p + oh * outputWidth;
+        for (kh = 0; kh < kH; kh++) {
+          int64_t ih = oh * dH - padH + kh * dilationH;
+          if (ih < 0 || ih >= inputHeight) {
+            continue;
+          }
+          real *gradInput_row = gradInput_p + ih * inputWidth;
+          for (kw = 0; kw < kW; kw++) {
+            int64_t offset = kw * dilationW - padW;
+            int64_t begin, end;
+            THNN_(SpatialDepthwiseConvolution_validRange)
+              (offset, dW, inputWidth, outputWidth, &begin, &end);
+            real w = weight_p[kh * kW + kw];
+            for (ow = begin; ow < end; ow++) {
+              gradInput_row[ow * dW + offset] += w * gradOutput_row[ow];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  THTensor_(free)(gradOutput);
+  THTensor_(free)(weight);
+}
+
+void THNN_(SpatialDepthwiseConvolution_accGradParameters)(
+    THNNState *state,
+    THTensor *input,
+    THTensor *gradOutput,
+    THTensor *gradWeight,
+    int kW, int kH,
+    int dW, int dH,
+    int padW, int padH,
+    int dilationW, int dilationH)
+{
+  THNN_(SpatialDepthwiseConvolution_shapeCheck)
+    (input, gradOutput, gradWeight, NULL, kH, kW, dH, dW, padH, padW,
+     dilationH, dilationW);
+  THArgCheck(THTensor_(isContiguous)(gradWeight), 4, "gradWeight needs to be contiguous");
+
+  input = THTensor_(newContiguous)(input);
+  gradOutput = THTensor_(newContiguous)(gradOutput);
+
+  int64_t batchSize = input->size[0];
+  int64_t nInputPlane = input->size[1];
+  int64_t inputHeight = input->size[2];
+  int64_t inputWidth = input->size[3];
+  int64_t nOutputPlane = gradWeight->size[0];
+  int64_t depthwiseMultiplier = nOutputPlane / nInputPlane;
+  int64_t outputHeight = gradOutput->size[2];
+  int64_t outputWidth = gradOutput->size[3];
+
+  real *input_data = THTensor_(data)(input);
+  real *gradOutput_data = THTensor_(data)(gradOutput);
+  real *gradWeight_data = THTensor_(data)(gradWeight);
+
+  int64_t oc;
+#pragma omp parallel for private(oc)
+  for (oc = 0; oc < nOutputPlane; oc++) {
+    int64_t ic = oc / depthwiseMultiplier;
+    int kh, kw;
+    for (kh = 0; kh < kH; kh++) {
+      for (kw = 0; kw < kW; kw++) {
+        int64_t offset = kw * dilationW - padW;
+        int64_t begin, end;
+        THNN_(SpatialDepthwiseConvolution_validRange)
+          (offset, dW, inputWidth, outputWidth, &begin, &end);
+        accreal sum = 0;
+        int64_t n, oh, ow;
+        for (n = 0; n < batchSize; n++) {
+          real *input_p = input_data + (n * nInputPlane + ic) * inputHeight * inputWidth;
+          real *gradOutput_p = gradOutput_data + (n * nOutputPlane + oc) * outputHeight * outputWidth;
+          for (oh = 0; oh < outputHeight; oh++) {
+            int64_t ih = oh * dH - padH + kh * dilationH;
+            if (ih < 0 || ih >= inputHeight) {
+              continue;
+            }
+            real *input_row = input_p + ih * inputWidth;
+            real *gradOutput_row = gradOutput_p + oh * outputWidth;
+            for (ow = begin; ow < end; ow++) {
+              sum += gradOutput_row[ow] * input_row[ow * dW + offset];
+            }
+          }
+        }
+        gradWeight_data[oc * kH * kW + kh * kW + kw] += sum;
+      }
+    }
+  }
+
+  THTensor_(free)(input);
+  THTensor_(free)(gradOutput);
+}
+
+#endif
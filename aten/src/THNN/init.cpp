@@ -226,6 +226,9 @@
 #include "generic/SpatialDilatedConvolution.c"
 #include "THGenerateFloatTypes.h"
 
+#include "generic/SpatialDepthwiseConvolution.c"
+#include "THGenerateFloatTypes.h"
+
 #include "generic/SpatialAdaptiveMaxPooling.c"
 #include "THGenerateFloatTypes.h"
 
@@ -1,5 +1,81 @@
 #include "THSTensor.h"
 
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Below this number of non-zeros, indices are sorted and merged serially
+#define THS_PARALLEL_NNZ 10000
+
+// Sorts the n keys, 0 <= keys[i] < maxKey, by least significant digit radix
+// sort, and sets perm to the positions in the input of the sorted keys. The
+// counts and the scatter of each pass are split in contiguous chunks across
+// threads, so that the sort is stable.
+static void THSTensor_radixSort(int64_t *keys, int64_t *perm, int64_t n, int64_t maxKey)
+{
+  const int bits = 8;
+  const int64_t radix = (int64_t)1 << bits;
+#ifdef _OPENMP
+  const int64_t nChunks = n < THS_PARALLEL_NNZ ? 1 : omp_get_max_threads();
+#else
+  const int64_t nChunks = 1;
+#endif
+  const int64_t chunkSize = (n + nChunks - 1) / nChunks;
+  int64_t *counts = (int64_t *)THAlloc(sizeof(int64_t) * nChunks * radix);
+  int64_t *keysIn = keys, *permIn = perm;
+  int64_t *keysOut = (int64_t *)THAlloc(sizeof(int64_t) * n);
+  int64_t *permOut = (int64_t *)THAlloc(sizeof(int64_t) * n);
+  int64_t i, c;
+
+  for (i = 0; i < n; i++) {
+    perm[i] = i;
+  }
+  for (int shift = 0; shift < 64 && ((maxKey - 1) >> shift) > 0; shift += bits) {
+    memset(counts, 0, sizeof(int64_t) * nChunks * radix);
+#pragma omp parallel for private(c, i) if (nChunks > 1)
+    for (c = 0; c < nChunks; c++) {
+      int64_t *chunkCounts = counts + c * radix;
+      int64_t end = THMin(n, (c + 1) * chunkSize);
+      for (i = c * chunkSize; i < end; i++) {
+        chunkCounts[(keysIn[i] >> shift) & (radix - 1)]++;
+      }
+    }
+    // The output of digit d from chunk c follows the digits < d and the
+    // digits d of the chunks < c
+    int64_t offset = 0;
+    for (int64_t d = 0; d < radix; d++) {
+      for (c = 0; c < nChunks; c++) {
+        int64_t count = counts[c * radix + d];
+        counts[c * radix + d] = offset;
+        offset += count;
+      }
+    }
+#pragma omp parallel for private(c, i) if (nChunks > 1)
+    for (c = 0; c < nChunks; c++) {
+      int64_t *chunkOffsets = counts + c * radix;
+      int64_t end = THMin(n, (c + 1) * chunkSize);
+      for (i = c * chunkSize; i < end; i++) {
+        int64_t pos = chunkOffsets[(keysIn[i] >> shift) & (radix - 1)]++;
+        keysOut[pos] = keysIn[i];
+        permOut[pos] = permIn[i];
+      }
+    }
+    int64_t *tmp = keysIn; keysIn = keysOut; keysOut = tmp;
+    tmp = permIn; permIn = permOut; permOut = tmp;
+  }
+  if (keysIn != keys) {
+    memcpy(keys, keysIn, sizeof(int64_t) * n);
+    memcpy(perm, permIn, sizeof(int64_t) * n);
+    keysOut = keysIn;
+    permOut = permIn;
+  }
+  THFree(keysOut);
+  THFree(permOut);
+  THFree(counts);
+}
+
 #include "generic/THSTensor.cpp"
 #include "THSGenerateAllTypes.h"
 
@@ -73,6 +73,7 @@ static void THSTensor_(rawInit)(THSTensor *self)
   self->nDimensionV = 0;
   self->coalesced = 0;
   self->nnz = 0;
+  self->csr = NULL;
   // self->flag = TH_TENSOR_REFCOUNTED;
 }
 
@@ -85,10 +86,18 @@ THSTensor* THSTensor_(rawResize)(THSTensor *self, int nDimI, int nDimV, int64_t
   }
   self->nDimensionI = nDimI;
   self->nDimensionV = nDimV;
+  THSTensor_(invalidateRowPointers)(self);
 
   return self;
 }
 
+void THSTensor_(invalidateRowPointers)(THSTensor *self) {
+  if (self->csr) {
+    THLongTensor_free(self->csr);
+    self->csr = NULL;
+  }
+}
+
 // directly assign without cloning or retaining (internal method)
 THSTensor* THSTensor_(_move)(THSTensor *self, THLongTensor *indices, THTensor *values) {
   int empty = THTensor_(nDimension)(values) == 0;
@@ -111,6 +120,7 @@ THSTensor* THSTensor_(_move)(THSTensor *self, THLongTensor *indices, THTensor *v
   self->values = values;
   self->nnz = empty ? 0 : THTensor_(size)(values, 0);
   self->coalesced = 0;
+  THSTensor_(invalidateRowPointers)(self);
 
   return self;
 }
@@ -375,12 +385,18 @@ void THSTensor_(transpose)(THSTensor *self, int d1, int d2) {
   self->size[d1] = self->size[d2];
   self->size[d2] = i;
   THLongTensor_free(indices);
+  THSTensor_(invalidateRowPointers)(self);
 }
 
 int THSTensor_(isCoalesced)(const THSTensor *self) {
   return self->coalesced;
 }
 
+void THSTensor_(setCoalesced)(THSTensor *self, int coalesced) {
+  self->coalesced = coalesced;
+  THSTensor_(invalidateRowPointers)(self);
+}
+
 /* Internal slice operations. Buffers can be reused across calls to avoid
 allocating tensors every time */
 
@@ -434,15 +450,12 @@ THSTensor *THSTensor_(newCoalesce)(THSTensor *self) {
     return self;
   }
   THLongTensor *indices = THSTensor_(newIndices)(self);
-  THTensor *values_ = THSTensor_(newValues)(self);
-  THTensor *values = THTensor_(newContiguous)(values_);
   int64_t nDimI = THSTensor_(nDimensionI)(self);
   int64_t nDimV = THSTensor_(nDimensionV)(self);
+  int64_t nnz = self->nnz;
 
-  THLongTensor *indicesScalar = THLongTensor_newWithSize1d(self->nnz);
+  THLongTensor *indicesScalar = THLongTensor_newWithSize1d(nnz);
   THLongTensor *indicesSlice = THLongTensor_new();
-  THLongTensor *indicesBuffer = THLongTensor_newWithSize1d(self->nnz);
-  THLongTensor *indicesPermutation = THLongTensor_newWithSize1d(self->nnz);
   THLongTensor_zero(indicesScalar);
   int64_t factor = 1;
   for (int64_t d = nDimI - 1; d >= 0; d--) {
@@ -450,45 +463,73 @@ THSTensor *THSTensor_(newCoalesce)(THSTensor *self) {
     THLongTensor_cadd(indicesScalar, indicesScalar, factor, indicesSlice);
     factor *= self->size[d];
   }
+  THLongTensor_free(indicesSlice);
+
+  // Tensors built from sorted indices, like the results of most sparse ops,
+  // only need the flag, and sorted ones with duplicates only the merge
+  int64_t *keys = THLongTensor_data(indicesScalar);
+  int sorted = 1, unique = 1;
+  for (int64_t j = 1; j < nnz && sorted; j++) {
+    sorted = keys[j - 1] <= keys[j];
+    unique = unique && keys[j - 1] != keys[j];
+  }
+  if (sorted && unique) {
+    THLongTensor_free(indicesScalar);
+    THLongTensor_free(indices);
+    self->coalesced = 1;
+    THSTensor_(retain)(self);
+    return self;
+  }
 
-  THLongTensor *newIndices = THLongTensor_new();
-  THTensor *newValues = THTensor_(new)();
-  THLongTensor_resizeAs(newIndices, indices);
-  THTensor_(resizeAs)(newValues, values_);
-  // THSTensor_(_move)(self, newIndices, newValues);
+  THLongTensor *indicesPermutation = THLongTensor_newWithSize1d(nnz);
+  int64_t *perm = THLongTensor_data(indicesPermutation);
+  if (sorted) {
+    for (int64_t j = 0; j < nnz; j++) {
+      perm[j] = j;
+    }
+  } else {
+    THSTensor_radixSort(keys, perm, nnz, factor);
+  }
+
+  // The first sorted position of each distinct index, and nnz
+  THLongTensor *uniqueStarts = THLongTensor_newWithSize1d(nnz + 1);
+  int64_t *starts = THLongTensor_data(uniqueStarts);
+  int64_t newNnz = 0;
+  for (int64_t j = 0; j < nnz; j++) {
+    if (j == 0 || keys[j] != keys[j - 1]) {
+      starts[newNnz++] = j;
+    }
+  }
+  starts[newNnz] = nnz;
+
+  THTensor *values_ = THSTensor_(newValues)(self);
+  THTensor *values = THTensor_(newContiguous)(values_);
+  THLongTensor *newIndices = THLongTensor_newWithSize2d(nDimI, newNnz);
+  THTensor *newValues = THSTensor_(newValuesWithSizeOf)(values, newNnz);
   THSTensor *dst = THSTensor_(new)();
   THSTensor_(rawResize)(dst, nDimI, nDimV, self->size);
   THSTensor_(_move)(dst, newIndices, newValues);
 
-  THLongTensor_sort(indicesBuffer, indicesPermutation, indicesScalar, 0, 0);
-
-  int64_t i = -1;
-  int64_t prev = -1;
   int64_t blockSize = values->stride[0];
-  for (int64_t j = 0; j < self->nnz; j++) {
-    int64_t pos = THTensor_fastGet1d(indicesPermutation, j);
-    int64_t curr = THTensor_fastGet1d(indicesBuffer, j);
-    if (curr == prev) {
-      THBlas_(axpy)(blockSize, 1,
-        THTensor_(data)(values) + pos * blockSize, 1,
-        THTensor_(data)(newValues) + i * blockSize, 1);
-    } else {
-      ++i;
-      for (int64_t d = 0; d < nDimI; d++) {
-        THTensor_fastSet2d(newIndices, d, i, THTensor_fastGet2d(indices, d, pos));
-      }
-      THBlas_(copy)(blockSize,
-        THTensor_(data)(values) + pos * blockSize, 1,
-        THTensor_(data)(newValues) + i * blockSize, 1);
+  real *src = THTensor_(data)(values);
+  real *out = THTensor_(data)(newValues);
+  int64_t i;
+#pragma omp parallel for private(i) schedule(static) if (nnz > THS_PARALLEL_NNZ)
+  for (i = 0; i < newNnz; i++) {
+    int64_t pos = perm[starts[i]];
+    for (int64_t d = 0; d < nDimI; d++) {
+      THTensor_fastSet2d(newIndices, d, i, THTensor_fastGet2d(indices, d, pos));
+    }
+    THBlas_(copy)(blockSize, src + pos * blockSize, 1, out + i * blockSize, 1);
+    for (int64_t j = starts[i] + 1; j < starts[i + 1]; j++) {
+      THBlas_(axpy)(blockSize, 1, src + perm[j] * blockSize, 1,
+        out + i * blockSize, 1);
     }
-    prev = curr;
   }
-  dst->nnz = i + 1;
   dst->coalesced = 1;
+  THLongTensor_free(uniqueStarts);
   THLongTensor_free(indicesScalar);
-  THLongTensor_free(indicesBuffer);
   THLongTensor_free(indicesPermutation);
-  THLongTensor_free(indicesSlice);
   THLongTensor_free(indices);
   THTensor_(free)(values_);
   THTensor_(free)(values);
@@ -512,6 +553,7 @@ void THTensor_(sparseMask)(THSTensor *r_, THTensor *t, THSTensor *mask) {
   THSTensor_(_move)(r_, THLongTensor_newClone(mask_indices_), r_values_);
   r_->coalesced = mask->coalesced;
   r_->nnz = mask->nnz;
+  THSTensor_(invalidateRowPointers)(r_);
 
   if (nDim > nDimI) {
     THTensor *srcBuffer = THTensor_(new)();
@@ -550,6 +592,7 @@ void THSTensor_(free)(THSTensor *self)
     THFree(self->size);
     THLongTensor_free(self->indices);
     THTensor_(free)(self->values);
+    THSTensor_(invalidateRowPointers)(self);
     THFree(self);
   }
 }
@@ -18,6 +18,10 @@ typedef struct THSTensor
     // Most math operations can only be performed on ordered sparse tensors
     int coalesced;
     int refcount;
+    // Row pointers of the first index dimension of a coalesced tensor, nnz
+    // values as in CSR, computed by newRowPointers and dropped when the
+    // indices change. NULL when not computed.
+    THLongTensor *csr;
 
 } THSTensor;
 
@@ -59,6 +63,8 @@ TH_API void THSTensor_(copy)(THSTensor *self, THSTensor *src);
 
 TH_API void THSTensor_(transpose)(THSTensor *self, int dimension1_, int dimension2_);
 TH_API int THSTensor_(isCoalesced)(const THSTensor *self);
+// Only for callers that built the indices sorted and unique
+TH_API void THSTensor_(setCoalesced)(THSTensor *self, int coalesced);
 TH_API int THSTensor_(isSameSizeAs)(const THSTensor *self, const THSTensor *src);
 TH_API THSTensor *THSTensor_(newCoalesce)(THSTensor *self);
 
@@ -79,5 +85,7 @@ TH_API void THSTensor_(select)(THSTensor *self, THSTensor *src, int dimension_,
 TH_API THSTensor* THSTensor_(rawResize)(THSTensor *self, int nDimI, int nDimV, int64_t *size);
 THSTensor* THSTensor_(_move)(THSTensor *self, THLongTensor *indices, THTensor *values);
 THSTensor* THSTensor_(_set)(THSTensor *self, THLongTensor *indices, THTensor *values);
+// Drops the cached row pointers, for callers writing to the indices
+void THSTensor_(invalidateRowPointers)(THSTensor *self);
 
 #endif
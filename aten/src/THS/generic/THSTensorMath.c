@@ -13,6 +13,7 @@ void THSTensor_(zero)(THSTensor *self) {
     THTensor_(resizeNd)(self->values, 0, NULL, NULL);
   }
   self->nnz = 0;
+  THSTensor_(invalidateRowPointers)(self);
 }
 
 void THSTensor_(zeros)(THSTensor *r_, THLongStorage *size)
@@ -44,6 +45,7 @@ void THSTensor_(mul)(THSTensor *r_, THSTensor *t, real value) {
     THLongTensor_copy(r_indices_, t_indices_);
     THTensor_(mul)(r_values_, t_values_, value);
     r_->nnz = t->nnz;
+    THSTensor_(invalidateRowPointers)(r_);
     r_->coalesced = t->coalesced;
 
     THLongTensor_free(r_indices_);
@@ -72,6 +74,7 @@ void THSTensor_(pow)(THSTensor *r_, THSTensor *t_, real value) {
   THLongTensor_copy(r_indices_, t_indices_);
   THTensor_(pow)(r_values_, t_values_, value);
   r_->nnz = t->nnz;
+  THSTensor_(invalidateRowPointers)(r_);
   r_->coalesced = t->coalesced;
 
   THLongTensor_free(r_indices_);
@@ -112,6 +115,7 @@ void THSTensor_(div)(THSTensor *r_, THSTensor *t, real value) {
     THLongTensor_copy(r_indices_, t_indices_);
     THTensor_(div)(r_values_, t_values_, value);
     r_->nnz = t->nnz;
+    THSTensor_(invalidateRowPointers)(r_);
     r_->coalesced = t->coalesced;
 
     THLongTensor_free(r_indices_);
@@ -121,6 +125,48 @@ void THSTensor_(div)(THSTensor *r_, THSTensor *t, real value) {
   }
 }
 
+// Appends value * src to the entries of self, which is left uncoalesced.
+// The buffers grow geometrically, so repeatedly accumulating into the same
+// tensor costs the size of each addend rather than of the running sum.
+static void THSTensor_(appendScaled)(THSTensor *self, real value, THSTensor *src) {
+  ptrdiff_t nnz = self->nnz, s_nnz = src->nnz, new_nnz = nnz + s_nnz;
+  int64_t nDimI = THSTensor_(nDimensionI)(self);
+  int64_t capacity = THMin(THLongTensor_size(self->indices, 1),
+                           THTensor_(size)(self->values, 0));
+  THLongTensor *s_indices = THSTensor_(newIndices)(src);
+  THTensor *s_values = THSTensor_(newValues)(src);
+
+  if (capacity < new_nnz) {
+    int64_t new_capacity = THMax(new_nnz, 2 * capacity);
+    THLongTensor *indices = THLongTensor_newWithSize2d(nDimI, new_capacity);
+    THTensor *values = THSTensor_(newValuesWithSizeOf)(s_values, new_capacity);
+    THLongTensor *old_indices = THSTensor_(newIndices)(self);
+    THTensor *old_values = THSTensor_(newValues)(self);
+    THLongTensor *dst_indices = THLongTensor_newNarrow(indices, 1, 0, nnz);
+    THTensor *dst_values = THTensor_(newNarrow)(values, 0, 0, nnz);
+    THLongTensor_copy(dst_indices, old_indices);
+    THTensor_(copy)(dst_values, old_values);
+    THLongTensor_free(dst_indices);
+    THTensor_(free)(dst_values);
+    THLongTensor_free(old_indices);
+    THTensor_(free)(old_values);
+    THSTensor_(_move)(self, indices, values);
+  }
+
+  THLongTensor *dst_indices = THLongTensor_newNarrow(self->indices, 1, nnz, s_nnz);
+  THTensor *dst_values = THTensor_(newNarrow)(self->values, 0, nnz, s_nnz);
+  THLongTensor_copy(dst_indices, s_indices);
+  THTensor_(mul)(dst_values, s_values, value);
+  self->nnz = new_nnz;
+  self->coalesced = 0;
+  THSTensor_(invalidateRowPointers)(self);
+
+  THLongTensor_free(dst_indices);
+  THTensor_(free)(dst_values);
+  THLongTensor_free(s_indices);
+  THTensor_(free)(s_values);
+}
+
 void THSTensor_(cadd)(THSTensor *r_, THSTensor *t, real value, THSTensor *src) {
   if(!THSTensor_(isSameSizeAs)(t, src)) {
     THError("cadd operands have incompatible sizes or dimension types");
@@ -134,6 +180,11 @@ void THSTensor_(cadd)(THSTensor *r_, THSTensor *t, real value, THSTensor *src) {
     THSTensor_(mul)(r_, src, value);
     return;
   }
+  // The sum isn't coalesced anyway, so an in-place add doesn't need to merge
+  if (r_ == t && !(t->coalesced && src->coalesced)) {
+    THSTensor_(appendScaled)(r_, value, src);
+    return;
+  }
 
   // saving those because they can be overwritten when doing in-place operations
   ptrdiff_t t_nnz = t->nnz, s_nnz = src->nnz, max_nnz = t_nnz + s_nnz;
@@ -192,6 +243,7 @@ void THSTensor_(cadd)(THSTensor *r_, THSTensor *t, real value, THSTensor *src) {
   }
 
   r_->nnz = r_i;
+  THSTensor_(invalidateRowPointers)(r_);
   // TODO: I think it may be possible to track inside the loop and
   // detect when we are uncoalesced (e.g., by observing that an
   // index goes backwards) which may be more precise than using the
@@ -265,6 +317,7 @@ void THSTensor_(cmul)(THSTensor *r_, THSTensor *t_, THSTensor *src_) {
   }
 
   r_->nnz = r_i;
+  THSTensor_(invalidateRowPointers)(r_);
   r_->coalesced = 1;
 
   THLongTensor_free(t_indices_);
@@ -302,6 +355,30 @@ THLongTensor *THSTensor_(toCSR)(int64_t const *indices, int64_t dim, int64_t nnz
   return csr;
 }
 
+THLongTensor *THSTensor_(newRowPointers)(THSTensor *self) {
+  THArgCheck(self->coalesced, 1, "row pointers of an uncoalesced tensor");
+  THArgCheck(self->nDimensionI >= 1, 1, "row pointers of a 0-dim tensor");
+  ptrdiff_t volatile *cache = (ptrdiff_t volatile *)&self->csr;
+  THLongTensor *csr = (THLongTensor *)THAtomicGetPtrdiff(cache);
+  if (!csr) {
+    THLongTensor *indices = THSTensor_(newIndices)(self);
+    THLongTensor *rows = THLongTensor_newSelect(indices, 0, 0);
+    THLongTensor *contiguous = THLongTensor_newContiguous(rows);
+    csr = THSTensor_(toCSR)(
+        THLongTensor_data(contiguous), self->size[0], self->nnz);
+    THLongTensor_free(contiguous);
+    THLongTensor_free(rows);
+    THLongTensor_free(indices);
+    // Concurrent readers may compute them at once, the first one is kept
+    if (!THAtomicCompareAndSwapPtrdiff(cache, 0, (ptrdiff_t)csr)) {
+      THLongTensor_free(csr);
+      csr = (THLongTensor *)THAtomicGetPtrdiff(cache);
+    }
+  }
+  THLongTensor_retain(csr);
+  return csr;
+}
+
 void THSTensor_(spaddmm)(THTensor *r_,
     real beta, THTensor *t,
     real alpha, THSTensor *sparse_, THTensor *dense) {
@@ -337,7 +414,7 @@ void THSTensor_(spaddmm)(THTensor *r_,
   indices = THSTensor_(newIndices)(sparse);
   values  = THSTensor_(newValues)(sparse);
 
-  csr = THSTensor_(toCSR)(THLongTensor_data(indices), dim_i, nnz);
+  csr = THSTensor_(newRowPointers)(sparse);
 
   // r_ = alpha * sparse * dense
   if (beta == 0) {
@@ -410,7 +487,7 @@ void THSTensor_(sspaddmm)(THSTensor *r_,
   indices = THSTensor_(newIndices)(sparse);
   values  = THSTensor_(newValues)(sparse);
 
-  csr = THSTensor_(toCSR)(THLongTensor_data(indices), dim_i, nnz);
+  csr = THSTensor_(newRowPointers)(sparse);
 
   t_nnz = THSTensor_(nnz)(t);
   r_nnz = nnz * dim_k + t_nnz;
@@ -464,6 +541,7 @@ void THSTensor_(sspaddmm)(THSTensor *r_,
   r_->indices = newi;
   r_-> values = newv;
   r_->    nnz = p;
+  THSTensor_(invalidateRowPointers)(r_);
 
   THLongTensor_free(csr);
   THLongTensor_free(indices);
@@ -527,7 +605,7 @@ void THSTensor_(hspmm)(THSTensor *r_, real alpha, THSTensor *sparse_, THTensor *
 
 void THSTensor_(spcadd)(THTensor *r_, THTensor *dense, real value, THSTensor *sparse_) {
   THTensor_(resizeAs)(r_, dense);
-  THSTensor *sparse = THSTensor_(newCoalesce)(sparse_);
+  THSTensor *sparse = sparse_;
 
   int64_t k;
   THLongTensor  *indices = THSTensor_(newIndices)(sparse);
@@ -552,7 +630,9 @@ void THSTensor_(spcadd)(THTensor *r_, THTensor *dense, real value, THSTensor *sp
     THTensor_(free)(srcBuffer);
     THTensor_(free)(dstBuffer);
   } else {
-    #pragma omp parallel for private(k)
+    // Duplicate indices of an uncoalesced input would race; the sum doesn't
+    // need the input coalesced otherwise
+    #pragma omp parallel for private(k) if(sparse->coalesced)
     for (k = 0; k < sparse->nnz; k++) {
       int64_t index = r_->storageOffset;
       for (int64_t d = 0; d < sparse->nDimensionI; d++) {
@@ -565,7 +645,6 @@ void THSTensor_(spcadd)(THTensor *r_, THTensor *dense, real value, THSTensor *sp
   THLongTensor_free(indices);
   THTensor_(free)(values);
   THLongStorage_free(storage);
-  THSTensor_(free)(sparse);
 }
 
 #undef ROW_PTR2
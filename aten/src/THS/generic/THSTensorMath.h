@@ -23,6 +23,10 @@ TH_API void THSTensor_(cmul)(THSTensor *r_, THSTensor *t, THSTensor *src);
 TH_API void THTensor_(spaddcmul)(THTensor *r_, THTensor *t, real value, THSTensor *src1, THSTensor *src2);
 
 // dense = beta * dense + alpha * sparse * dense
+// The CSR row pointers of a coalesced tensor, size(0) + 1 values, cached
+// until its indices change
+TH_API THLongTensor *THSTensor_(newRowPointers)(THSTensor *self);
+
 TH_API void THSTensor_(spaddmm)(THTensor *r_, real beta, THTensor *t, real alpha, THSTensor *sparse, THTensor *dense);
 // sparse = beta * sparse + alpha * sparse * dense
 TH_API void THSTensor_(sspaddmm)(THSTensor *r_, real beta, THSTensor *t, real alpha, THSTensor *sparse, THTensor *dense);
@@ -12,10 +12,16 @@ $BUILD_ROOT/src/ATen/test/wrapdim_test
 $BUILD_ROOT/src/ATen/test/dlconvertor_test
 $BUILD_ROOT/src/ATen/test/native_test
 $BUILD_ROOT/src/ATen/test/scalar_tensor_test
+$BUILD_ROOT/src/ATen/test/bfloat16_test
 $BUILD_ROOT/src/ATen/test/undefined_tensor_test
+$BUILD_ROOT/src/ATen/test/caching_allocator_test
+$BUILD_ROOT/src/ATen/test/small_alloc_test
 if [[ -x $BUILD_ROOT/src/ATen/test/cudnn_test ]]; then
   $BUILD_ROOT/src/ATen/test/cudnn_test
 fi
+if [[ -x $BUILD_ROOT/src/ATen/test/mkldnn_test ]]; then
+  $BUILD_ROOT/src/ATen/test/mkldnn_test
+fi
 if [ "$VALGRIND" == "ON" ]
 then
   valgrind --suppressions=`dirname $0`/valgrind.sup --error-exitcode=1 $BUILD_ROOT/src/ATen/test/basic "[cpu]"
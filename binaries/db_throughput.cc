@@ -30,6 +30,8 @@ CAFFE2_DEFINE_int(repeat, 10, "The number to repeat the throughput test.");
 CAFFE2_DEFINE_bool(use_reader, false, "If true, use the reader interface.");
 CAFFE2_DEFINE_int(num_read_threads, 1,
                    "The number of concurrent reading threads.");
+CAFFE2_DEFINE_int(prefetch, 0,
+                  "If positive, the reader prefetches this many records.");
 
 using caffe2::db::Cursor;
 using caffe2::db::DB;
@@ -76,6 +78,9 @@ void TestThroughputWithReaderWorker(const DBReader* reader, int thread_id) {
 void TestThroughputWithReader() {
   caffe2::db::DBReader reader(
       caffe2::FLAGS_input_db_type, caffe2::FLAGS_input_db);
+  if (caffe2::FLAGS_prefetch > 0) {
+    reader.StartPrefetch(caffe2::FLAGS_prefetch);
+  }
   std::vector<std::unique_ptr<std::thread>> reading_threads(
       caffe2::FLAGS_num_read_threads);
   for (int i = 0; i < reading_threads.size(); ++i) {
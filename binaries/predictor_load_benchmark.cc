@@ -0,0 +1,444 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Drives a Predictor from several client threads and reports the latency
+// percentiles, throughput, CPU utilization and allocations of every
+// configuration of --clients and --intra_op_threads. With --qps the requests
+// arrive open loop, as a Poisson process: a request's latency counts from
+// its scheduled arrival, so the time it waits for a busy client is included
+// rather than hidden by slowing the arrivals down.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#ifdef _OPENMP
+#include "caffe2/core/common_omp.h"
+#endif // _OPENMP
+
+#ifdef CAFFE2_USE_MKL
+#include <mkl.h>
+#endif // CAFFE2_USE_MKL
+
+#include "caffe2/core/allocator.h"
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/predictor.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+#include "caffe2/utils/string_utils.h"
+
+CAFFE2_DEFINE_string(init_net, "", "The given path to the init protobuffer.");
+CAFFE2_DEFINE_string(
+    predict_net,
+    "",
+    "The given path to the predict protobuffer.");
+CAFFE2_DEFINE_string(
+    input_file,
+    "",
+    "Files that contain the serialized protobuf of the inputs, which are fed "
+    "to the first external inputs of predict_net, separated by commas.");
+CAFFE2_DEFINE_string(
+    input_dims,
+    "",
+    "Alternate to input_file, the dimensions of zero filled inputs as comma "
+    "separated numbers. If multiple inputs are needed, use semicolon to "
+    "separate the dimensions of different tensors.");
+CAFFE2_DEFINE_string(
+    input_type,
+    "float",
+    "The types (uint8_t/float) of the inputs of input_dims, separated by "
+    "semicolons. A single type is used for all of them.");
+CAFFE2_DEFINE_string(
+    clients,
+    "1",
+    "The numbers of client threads to run with, separated by commas.");
+CAFFE2_DEFINE_string(
+    intra_op_threads,
+    "1",
+    "The numbers of OpenMP (and MKL) threads of every client to run with, "
+    "separated by commas. 0 keeps the default.");
+CAFFE2_DEFINE_double(
+    qps,
+    0,
+    "The rate the requests arrive at, shared by all the clients. 0 runs the "
+    "clients closed loop, each sending a request once its last one is done.");
+CAFFE2_DEFINE_double(
+    duration,
+    10,
+    "The seconds every configuration is measured for.");
+CAFFE2_DEFINE_int(
+    warmup,
+    10,
+    "The number of requests every client runs before the measurement.");
+CAFFE2_DEFINE_bool(
+    predictor_per_thread,
+    false,
+    "Give every client its own Predictor on top of a workspace holding the "
+    "parameters, instead of sharing one through Predictor::run_concurrent.");
+CAFFE2_DEFINE_int(seed, 0, "The seed of the arrival times.");
+
+namespace caffe2 {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Counts the allocations of Caffe2's CPU tensors. The size of every
+// allocation is stored in front of it, so that it is known when freed.
+class CountingCPUAllocator final : public CPUAllocator {
+ public:
+  std::pair<void*, MemoryDeleter> New(size_t nbytes) override {
+    auto data = inner_.New(nbytes + kHeaderSize);
+    *static_cast<size_t*>(data.first) = nbytes;
+    allocations_++;
+    allocatedBytes_ += nbytes;
+    size_t live = liveBytes_ += nbytes;
+    size_t peak = peakBytes_;
+    while (live > peak && !peakBytes_.compare_exchange_weak(peak, live)) {
+    }
+    return {static_cast<char*>(data.first) + kHeaderSize, Delete};
+  }
+
+  MemoryDeleter GetDeleter() override {
+    return Delete;
+  }
+
+  struct Stats {
+    size_t allocations;
+    size_t allocated_bytes;
+    size_t peak_bytes;
+  };
+
+  // Starts counting from zero, and the peak from the memory in use
+  static void Reset() {
+    allocations_ = 0;
+    allocatedBytes_ = 0;
+    peakBytes_ = liveBytes_.load();
+  }
+
+  static Stats Get() {
+    return {allocations_, allocatedBytes_, peakBytes_};
+  }
+
+ private:
+  // keeps the data aligned like the inner allocator's
+  static constexpr size_t kHeaderSize = gCaffe2Alignment;
+
+  static void Delete(void* data) {
+    void* header = static_cast<char*>(data) - kHeaderSize;
+    liveBytes_ -= *static_cast<size_t*>(header);
+    DefaultCPUAllocator::Delete(header);
+  }
+
+  DefaultCPUAllocator inner_;
+  static std::atomic<size_t> allocations_;
+  static std::atomic<size_t> allocatedBytes_;
+  static std::atomic<size_t> liveBytes_;
+  static std::atomic<size_t> peakBytes_;
+};
+
+constexpr size_t CountingCPUAllocator::kHeaderSize;
+std::atomic<size_t> CountingCPUAllocator::allocations_{0};
+std::atomic<size_t> CountingCPUAllocator::allocatedBytes_{0};
+std::atomic<size_t> CountingCPUAllocator::liveBytes_{0};
+std::atomic<size_t> CountingCPUAllocator::peakBytes_{0};
+
+// The CPU time of the process, of all its threads, in seconds
+double ProcessCPUSeconds() {
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  CAFFE_ENFORCE_EQ(getrusage(RUSAGE_SELF, &usage), 0);
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+      usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+#endif
+}
+
+// The OpenMP and MKL settings are per thread, every client sets its own
+void SetIntraOpThreads(int threads) {
+  if (threads <= 0) {
+    return;
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif // _OPENMP
+#ifdef CAFFE2_USE_MKL
+  mkl_set_num_threads_local(threads);
+#endif // CAFFE2_USE_MKL
+}
+
+std::vector<int> ParseInts(const std::string& list) {
+  std::vector<int> values;
+  for (const auto& s : split(',', list)) {
+    values.push_back(caffe2::stoi(s));
+  }
+  CAFFE_ENFORCE(!values.empty(), "Empty list: ", list);
+  return values;
+}
+
+std::vector<std::unique_ptr<Blob>> LoadInputs() {
+  std::vector<std::unique_ptr<Blob>> inputs;
+  if (FLAGS_input_file.size()) {
+    for (const auto& file : split(',', FLAGS_input_file)) {
+      BlobProto blob_proto;
+      CAFFE_ENFORCE(ReadProtoFromFile(file, &blob_proto));
+      inputs.emplace_back(new Blob());
+      inputs.back()->Deserialize(blob_proto);
+      CAFFE_ENFORCE(
+          inputs.back()->IsType<TensorCPU>(),
+          "Input ",
+          file,
+          " is not a TensorCPU");
+    }
+  } else if (FLAGS_input_dims.size()) {
+    auto dims_list = split(';', FLAGS_input_dims);
+    auto type_list = split(';', FLAGS_input_type);
+    CAFFE_ENFORCE(
+        type_list.size() == 1 || type_list.size() == dims_list.size(),
+        "Input dims and type should have the same number of items.");
+    for (size_t i = 0; i < dims_list.size(); ++i) {
+      std::vector<TIndex> dims;
+      for (const auto& s : split(',', dims_list[i])) {
+        dims.push_back(caffe2::stoi(s));
+      }
+      inputs.emplace_back(new Blob());
+      auto* tensor = inputs.back()->GetMutable<TensorCPU>();
+      tensor->Resize(dims);
+      const auto& type = type_list[type_list.size() == 1 ? 0 : i];
+      void* data = nullptr;
+      if (type == "uint8_t") {
+        data = tensor->mutable_data<uint8_t>();
+      } else if (type == "float") {
+        data = tensor->mutable_data<float>();
+      } else {
+        CAFFE_THROW("Unsupported input type: ", type);
+      }
+      memset(data, 0, tensor->nbytes());
+    }
+  }
+  return inputs;
+}
+
+// Blocks the clients until all of them warmed up and the measurement starts
+class StartGate {
+ public:
+  explicit StartGate(int clients) : waiting_(clients) {}
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (--waiting_ == 0) {
+      cv_.notify_all();
+    }
+    cv_.wait(lock, [this] { return opened_; });
+  }
+
+  void WaitForClients() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return waiting_ == 0; });
+  }
+
+  void Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    opened_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int waiting_;
+  bool opened_ = false;
+};
+
+class LoadBenchmark {
+ public:
+  LoadBenchmark(const NetDef& init_net, const NetDef& predict_net)
+      : predict_net_(predict_net), inputBlobs_(LoadInputs()) {
+    for (const auto& blob : inputBlobs_) {
+      inputs_.push_back(blob->GetMutable<TensorCPU>());
+    }
+    if (FLAGS_predictor_per_thread) {
+      CAFFE_ENFORCE(weights_.RunNetOnce(init_net));
+    } else {
+      predictor_.reset(new Predictor(init_net, predict_net));
+    }
+  }
+
+  void Run(int clients, int intra_op_threads) {
+    std::vector<double> arrivals;
+    if (FLAGS_qps > 0) {
+      std::mt19937_64 rng(FLAGS_seed);
+      std::exponential_distribution<double> interval(FLAGS_qps);
+      for (double t = interval(rng); t < FLAGS_duration; t += interval(rng)) {
+        arrivals.push_back(t);
+      }
+    }
+
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failures{0};
+    StartGate gate(clients);
+    Clock::time_point start;
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+      threads.emplace_back([&, c] {
+        SetIntraOpThreads(intra_op_threads);
+        auto run = MakeClient();
+        for (int i = 0; i < FLAGS_warmup; ++i) {
+          run();
+        }
+        gate.Wait();
+        const auto end = start +
+            std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<double>(FLAGS_duration));
+        auto& latency = latencies[c];
+        while (true) {
+          Clock::time_point arrival;
+          if (FLAGS_qps > 0) {
+            size_t i = next++;
+            if (i >= arrivals.size()) {
+              break;
+            }
+            arrival = start +
+                std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(arrivals[i]));
+            std::this_thread::sleep_until(arrival);
+          } else {
+            arrival = Clock::now();
+            if (arrival >= end) {
+              break;
+            }
+          }
+          if (!run()) {
+            failures++;
+          }
+          latency.push_back(
+              std::chrono::duration<double, std::milli>(Clock::now() - arrival)
+                  .count());
+        }
+      });
+    }
+
+    gate.WaitForClients();
+    CountingCPUAllocator::Reset();
+    double cpu_start = ProcessCPUSeconds();
+    start = Clock::now();
+    gate.Open();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    double cpu = ProcessCPUSeconds() - cpu_start;
+    auto allocs = CountingCPUAllocator::Get();
+
+    std::vector<double> all;
+    for (const auto& latency : latencies) {
+      all.insert(all.end(), latency.begin(), latency.end());
+    }
+    CAFFE_ENFORCE(!all.empty(), "No request was run");
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+      size_t i = std::min(all.size() - 1, static_cast<size_t>(p * all.size()));
+      return all[i];
+    };
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    LOG(INFO) << "clients=" << clients
+              << " intra_op_threads=" << intra_op_threads
+              << " requests=" << all.size() << " failures=" << failures
+              << " target_qps=" << FLAGS_qps
+              << " achieved_qps=" << all.size() / wall
+              << " p50_ms=" << percentile(0.5) << " p90_ms=" << percentile(0.9)
+              << " p99_ms=" << percentile(0.99)
+              << " p999_ms=" << percentile(0.999) << " max_ms=" << all.back()
+              << " cpu_cores_busy=" << cpu / wall
+              << " cpu_utilization=" << 100. * cpu / (wall * cores) << "%"
+              << " allocs_per_request="
+              << static_cast<double>(allocs.allocations) / all.size()
+              << " alloc_bytes_per_request="
+              << static_cast<double>(allocs.allocated_bytes) / all.size()
+              << " peak_alloc_mb=" << allocs.peak_bytes / (1024. * 1024.);
+  }
+
+ private:
+  // A request of one client, which returns whether it succeeded
+  std::function<bool()> MakeClient() {
+    if (!FLAGS_predictor_per_thread) {
+      return [this] {
+        std::vector<TensorCPU> outputs;
+        return predictor_->run_concurrent(inputs_, &outputs);
+      };
+    }
+    // the inputs and activations are created in the predictor's workspace,
+    // weights_ is only read
+    std::shared_ptr<Predictor> predictor(
+        new Predictor(NetDef(), predict_net_, &weights_));
+    return [this, predictor] {
+      Predictor::TensorVector outputs;
+      return predictor->run(inputs_, &outputs);
+    };
+  }
+
+  const NetDef& predict_net_;
+  std::vector<std::unique_ptr<Blob>> inputBlobs_;
+  Predictor::TensorVector inputs_;
+  // holds the parameters of the predictors of --predictor_per_thread
+  Workspace weights_;
+  std::unique_ptr<Predictor> predictor_;
+};
+
+void run() {
+  if (FLAGS_init_net.empty()) {
+    LOG(FATAL) << "No init net specified. Use --init_net=/path/to/net.";
+  }
+  if (FLAGS_predict_net.empty()) {
+    LOG(FATAL) << "No predict net specified. Use --predict_net=/path/to/net.";
+  }
+  // before any tensor is created, so that every allocation is counted
+  SetCPUAllocator(new CountingCPUAllocator());
+
+  NetDef init_net, predict_net;
+  CAFFE_ENFORCE(ReadProtoFromFile(FLAGS_init_net, &init_net));
+  CAFFE_ENFORCE(ReadProtoFromFile(FLAGS_predict_net, &predict_net));
+  LoadBenchmark benchmark(init_net, predict_net);
+  for (int clients : ParseInts(FLAGS_clients)) {
+    for (int intra_op_threads : ParseInts(FLAGS_intra_op_threads)) {
+      benchmark.Run(clients, intra_op_threads);
+    }
+  }
+}
+
+} // namespace
+} // namespace caffe2
+
+int main(int argc, char** argv) {
+  caffe2::GlobalInit(&argc, &argv);
+  caffe2::run();
+  return 0;
+}
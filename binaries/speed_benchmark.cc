@@ -16,6 +16,7 @@
 
 #include <string>
 
+#include "caffe2/core/engine_tuner.h"
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
@@ -72,6 +73,12 @@ CAFFE2_DEFINE_bool(force_engine, false, "Force engine field for all operators");
 CAFFE2_DEFINE_string(engine, "", "Forced engine field value");
 CAFFE2_DEFINE_bool(force_algo, false, "Force algo arg for all operators");
 CAFFE2_DEFINE_string(algo, "", "Forced algo arg value");
+CAFFE2_DEFINE_bool(
+    autotune_engines,
+    false,
+    "Benchmark the engines of every operator without an engine on the first "
+    "run and use the fastest. The choice is saved to and read from "
+    "--caffe2_engine_cache_file, if set.");
 
 using std::string;
 using std::unique_ptr;
@@ -170,6 +177,9 @@ int main(int argc, char** argv) {
           ->set_s(caffe2::FLAGS_algo);
     }
   }
+  if (caffe2::FLAGS_autotune_engines) {
+    net_def = caffe2::AutotuneEngines(net_def, workspace.get());
+  }
   caffe2::NetBase* net = workspace->CreateNet(net_def);
   CHECK_NOTNULL(net);
   CAFFE_ENFORCE(net->Run());
@@ -11,6 +11,7 @@ at::Backend ATenOp<CPUContext>::backend() const {
 
 OPERATOR_SCHEMA(ATen);
 CAFFE_KNOWN_TYPE(at::Half);
+CAFFE_KNOWN_TYPE(at::BFloat16);
 
 namespace math {
 template <>
@@ -21,6 +22,15 @@ void Set<at::Half, CPUContext>(
     CPUContext* c) {
   Set(0, h.x, (uint16_t*) v, c);
 }
+
+template <>
+void Set<at::BFloat16, CPUContext>(
+    const size_t /*N*/,
+    const at::BFloat16 h,
+    at::BFloat16* v,
+    CPUContext* c) {
+  Set(0, h.x, (uint16_t*) v, c);
+}
 }
 
 }
@@ -18,6 +18,15 @@ void Set<at::Half, CUDAContext>(
     CUDAContext* c) {
   Set(0, h.x, (uint16_t*) v, c);
 }
+
+template <>
+void Set<at::BFloat16, CUDAContext>(
+    const size_t /*N*/,
+    const at::BFloat16 h,
+    at::BFloat16* v,
+    CUDAContext* c) {
+  Set(0, h.x, (uint16_t*) v, c);
+}
 }
 
 }
@@ -16,6 +16,7 @@ static std::unordered_map<std::string, int> op_to_key = {
 namespace caffe2 {
 
 using at::Half; // for AT_FORALL_SCALAR_TYPES
+using at::BFloat16;
 
 template <class Context>
 class ATenOp : public Operator<Context> {
@@ -46,6 +46,10 @@ class AllgatherOp final : public Operator<Context> {
 
   virtual ~AllgatherOp() {}
 
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     std::call_once(once_, [&] { initialize(); });
 
@@ -34,6 +34,10 @@ class AllreduceOp final : public Operator<Context> {
 
   virtual ~AllreduceOp() {}
 
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     std::call_once(once_, [&] { initialize(); });
 
@@ -26,6 +26,10 @@ class BarrierOp final : public Operator<Context> {
 
   virtual ~BarrierOp() {}
 
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     auto context = OperatorBase::Input<std::shared_ptr<::gloo::Context>>(0);
     std::call_once(once_, [&] {
@@ -31,6 +31,10 @@ class BroadcastOp final : public Operator<Context> {
 
   virtual ~BroadcastOp() {}
 
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     std::call_once(once_, [&] { initialize(); });
 
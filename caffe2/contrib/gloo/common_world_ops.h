@@ -38,6 +38,8 @@ class CreateCommonWorld final : public Operator<Context> {
         status_blob_(
             OperatorBase::GetSingleArgument<std::string>("status_blob", "")),
         timeout_ms_(OperatorBase::GetSingleArgument<int>("timeout_ms", -1)),
+        rendezvous_fanout_(
+            OperatorBase::GetSingleArgument<int>("rendezvous_fanout", 0)),
         ws_(ws) {
     CAFFE_ENFORCE(
         operator_def.has_name(), "CreateCommonWorld operator requires name");
@@ -70,8 +72,18 @@ class CreateCommonWorld final : public Operator<Context> {
   CommonWorld rendezvousWithStore(
       const std::unique_ptr<StoreHandler>& handler) {
     // Use PrefixStore to isolate different CreateCommonWorld instances
-    StoreHandlerWrapper wrapper(*handler);
-    ::gloo::rendezvous::PrefixStore store(name_, wrapper);
+    std::unique_ptr<StoreHandlerWrapper> wrapper;
+    if (rendezvous_fanout_ > 0) {
+      // The wrapper sees the keys after PrefixStore prepended name_.
+      const auto timeout = timeout_ms_ != -1
+          ? std::chrono::milliseconds(timeout_ms_)
+          : ::gloo::rendezvous::Store::kDefaultTimeout;
+      wrapper = caffe2::make_unique<StoreHandlerWrapper>(
+          *handler, name_, rank_, size_, rendezvous_fanout_, timeout);
+    } else {
+      wrapper = caffe2::make_unique<StoreHandlerWrapper>(*handler);
+    }
+    ::gloo::rendezvous::PrefixStore store(name_, *wrapper);
     auto context = std::make_shared<::gloo::rendezvous::Context>(rank_, size_);
     if (timeout_ms_ != -1) {
       context->setTimeout(std::chrono::milliseconds(timeout_ms_));
@@ -149,6 +161,7 @@ class CreateCommonWorld final : public Operator<Context> {
   const bool mpi_rendezvous_;
   const std::string status_blob_;
   const int timeout_ms_;
+  const int rendezvous_fanout_;
   Workspace* ws_;
 
   std::string name_;
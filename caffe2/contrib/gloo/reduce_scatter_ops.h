@@ -46,6 +46,10 @@ class ReduceScatterOp final : public Operator<Context> {
 
   virtual ~ReduceScatterOp() {}
 
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     std::call_once(once_, [&] { initialize(); });
 
@@ -1,16 +1,129 @@
 #include "store_handler.h"
 
+#include <cstring>
+
+#include "caffe2/core/logging.h"
+
 namespace caffe2 {
 namespace gloo {
 
+namespace {
+
+// Merged subtree values are a sequence of (rank, size, bytes) entries.
+void appendEntry(std::string& out, int32_t rank, const char* data, int64_t n) {
+  out.append(reinterpret_cast<const char*>(&rank), sizeof(rank));
+  out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+  out.append(data, n);
+}
+
+} // namespace
+
+StoreHandlerWrapper::StoreHandlerWrapper(
+    StoreHandler& handler,
+    const std::string& prefix,
+    int rank,
+    int size,
+    int fanout,
+    const std::chrono::milliseconds& timeout)
+    : handler_(handler),
+      prefix_(prefix),
+      rank_(rank),
+      size_(size),
+      fanout_(fanout),
+      timeout_(timeout) {
+  CAFFE_ENFORCE(rank_ >= 0 && rank_ < size_);
+  CAFFE_ENFORCE_GE(fanout_, 1);
+}
+
+int StoreHandlerWrapper::rankOf(const std::string& key) const {
+  if (fanout_ == 0 || key.size() <= prefix_.size() + 1 ||
+      key.compare(0, prefix_.size(), prefix_) != 0 ||
+      key[prefix_.size()] != '/') {
+    return -1;
+  }
+  int rank = 0;
+  for (auto i = prefix_.size() + 1; i < key.size(); ++i) {
+    if (key[i] < '0' || key[i] > '9') {
+      return -1;
+    }
+    rank = rank * 10 + (key[i] - '0');
+    if (rank >= size_) {
+      return -1;
+    }
+  }
+  return rank;
+}
+
+std::string StoreHandlerWrapper::treeKey(const std::string& name, int rank)
+    const {
+  return prefix_ + "/tree/" + name + "/" + caffe2::to_string(rank);
+}
+
+void StoreHandlerWrapper::fanIn(const std::vector<char>& data) {
+  std::string merged;
+  appendEntry(merged, rank_, data.data(), data.size());
+
+  std::vector<std::string> children;
+  for (int i = 1; i <= fanout_ && rank_ * fanout_ + i < size_; ++i) {
+    children.push_back(treeKey("up", rank_ * fanout_ + i));
+  }
+  if (!children.empty()) {
+    handler_.wait(children, timeout_);
+    for (const auto& value : handler_.multiGet(children)) {
+      merged += value;
+    }
+  }
+
+  handler_.set(rank_ == 0 ? treeKey("all", 0) : treeKey("up", rank_), merged);
+}
+
+void StoreHandlerWrapper::fetchAll(const std::chrono::milliseconds& timeout) {
+  if (!values_.empty()) {
+    return;
+  }
+  const auto key = treeKey("all", 0);
+  handler_.wait({key}, timeout);
+  const auto merged = handler_.get(key);
+
+  std::vector<std::vector<char>> values(size_);
+  std::vector<bool> seen(size_, false);
+  size_t pos = 0;
+  while (pos < merged.size()) {
+    int32_t rank;
+    int64_t n;
+    CAFFE_ENFORCE_LE(pos + sizeof(rank) + sizeof(n), merged.size());
+    std::memcpy(&rank, merged.data() + pos, sizeof(rank));
+    std::memcpy(&n, merged.data() + pos + sizeof(rank), sizeof(n));
+    pos += sizeof(rank) + sizeof(n);
+    CAFFE_ENFORCE(rank >= 0 && rank < size_ && !seen[rank]);
+    CAFFE_ENFORCE_LE(pos + n, merged.size());
+    values[rank].assign(merged.data() + pos, merged.data() + pos + n);
+    seen[rank] = true;
+    pos += n;
+  }
+  for (int i = 0; i < size_; ++i) {
+    CAFFE_ENFORCE(seen[i], "Rendezvous is missing rank ", i);
+  }
+  values_ = std::move(values);
+}
+
 void StoreHandlerWrapper::set(
     const std::string& key,
     const std::vector<char>& data) {
+  if (rankOf(key) == rank_) {
+    fanIn(data);
+    return;
+  }
   std::string stringValue(data.data(), data.size());
   handler_.set(key, stringValue);
 }
 
 std::vector<char> StoreHandlerWrapper::get(const std::string& key) {
+  const auto rank = rankOf(key);
+  if (rank != -1) {
+    fetchAll(timeout_);
+    return values_[rank];
+  }
   std::string str = handler_.get(key);
   return std::vector<char>(str.begin(), str.end());
 }
@@ -18,6 +131,14 @@ std::vector<char> StoreHandlerWrapper::get(const std::string& key) {
 void StoreHandlerWrapper::wait(
     const std::vector<std::string>& keys,
     const std::chrono::milliseconds& timeout) {
+  bool rankKeys = !keys.empty();
+  for (const auto& key : keys) {
+    rankKeys = rankKeys && rankOf(key) != -1;
+  }
+  if (rankKeys) {
+    fetchAll(timeout);
+    return;
+  }
   handler_.wait(keys, timeout);
 }
 
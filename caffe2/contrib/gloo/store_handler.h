@@ -11,6 +11,19 @@ class StoreHandlerWrapper : public ::gloo::rendezvous::Store {
  public:
   explicit StoreHandlerWrapper(StoreHandler& handler) : handler_(handler) {}
 
+  // Exchanges the per-rank keys of a rendezvous ("<prefix>/<rank>") through
+  // a tree with the given fanout: every rank merges the keys of its subtree
+  // and passes them to its parent, and the root publishes all of them under
+  // a single key. Each rank then does a constant number of round trips to
+  // the store plus the depth of the tree, instead of one per peer.
+  StoreHandlerWrapper(
+      StoreHandler& handler,
+      const std::string& prefix,
+      int rank,
+      int size,
+      int fanout,
+      const std::chrono::milliseconds& timeout);
+
   virtual ~StoreHandlerWrapper() {}
 
   virtual void set(const std::string& key, const std::vector<char>& data)
@@ -27,7 +40,25 @@ class StoreHandlerWrapper : public ::gloo::rendezvous::Store {
       const std::chrono::milliseconds& timeout) override;
 
  protected:
+  // Returns the rank of a per-rank rendezvous key, or -1.
+  int rankOf(const std::string& key) const;
+
+  std::string treeKey(const std::string& name, int rank) const;
+
+  void fanIn(const std::vector<char>& data);
+
+  void fetchAll(const std::chrono::milliseconds& timeout);
+
   StoreHandler& handler_;
+
+  // Tree rendezvous state (fanout_ is 0 when disabled).
+  std::string prefix_;
+  int rank_ = 0;
+  int size_ = 0;
+  int fanout_ = 0;
+  std::chrono::milliseconds timeout_ = StoreHandler::kDefaultTimeout;
+  // Values of the per-rank keys, once fetched from the root.
+  std::vector<std::vector<char>> values_;
 };
 
 } // namespace gloo
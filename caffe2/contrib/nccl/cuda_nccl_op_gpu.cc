@@ -53,6 +53,10 @@ class NCCLAllreduceOp final : public Operator<CUDAContext> {
   using Operator::Operator;
   NCCLAllreduceOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<CUDAContext>(operator_def, ws) {}
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     if (InputSize() == 1)
       return true;
@@ -75,6 +79,10 @@ class NCCLBroadcastOp final : public Operator<CUDAContext> {
  public:
   USE_OPERATOR_FUNCTIONS(CUDAContext);
   using Operator::Operator;
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     if (InputSize() == 1)
       return true;
@@ -96,6 +104,10 @@ class NCCLReduceOp final : public Operator<CUDAContext> {
  public:
   USE_OPERATOR_FUNCTIONS(CUDAContext);
   using Operator::Operator;
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     if (InputSize() == 1)
       return true;
@@ -119,6 +131,10 @@ class NCCLAllGatherOp final : public Operator<CUDAContext> {
  public:
   USE_OPERATOR_FUNCTIONS(CUDAContext);
   using Operator::Operator;
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     if (InputSize() == 1)
       return true;
@@ -140,6 +156,10 @@ class NCCLReduceScatterOp final : public Operator<CUDAContext> {
  public:
   USE_OPERATOR_FUNCTIONS(CUDAContext);
   using Operator::Operator;
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
   bool RunOnDevice() override {
     if (AllInputsAre<float>(this)) {
       nccl::NCCL<float>::ReduceScatter(getNCCLElements(this, context_));
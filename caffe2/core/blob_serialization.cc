@@ -1,11 +1,16 @@
 #include "caffe2/core/blob_serialization.h"
 
+#include <algorithm>
 #include <sstream>
 #include <mutex>
 
 #include "caffe2/core/blob.h"
 #include "caffe2/utils/proto_utils.h"
 
+#ifdef CAFFE2_USE_ZSTD
+#include <zstd.h>
+#endif
+
 CAFFE2_DEFINE_int(
     caffe2_tensor_chunk_size,
     1000000,
@@ -21,6 +26,21 @@ CAFFE2_DEFINE_bool(
     false,
     "Serialize FLOAT16 tensors using byte_data field");
 
+CAFFE2_DEFINE_string(
+    caffe2_tensor_compression,
+    "",
+    "Compression of the tensor chunks: empty for none, or zstd");
+
+CAFFE2_DEFINE_int(
+    caffe2_tensor_compression_level,
+    3,
+    "Compression level of the tensor chunks");
+
+CAFFE2_DEFINE_bool(
+    caffe2_tensor_byte_shuffle,
+    true,
+    "Shuffle the bytes of floating point tensors before compressing them");
+
 namespace caffe2 {
 /**
  * @brief StringSerializer is the serializer for String.
@@ -127,6 +147,196 @@ void Blob::Deserialize(const BlobProto& blob_proto) {
   }
 }
 
+namespace detail {
+
+TensorProto::Compression SelectedCompression() {
+  const string& name = FLAGS_caffe2_tensor_compression;
+  if (name.empty()) {
+    return TensorProto_Compression_NO_COMPRESSION;
+  }
+  CAFFE_ENFORCE_EQ(name, "zstd", "Unknown tensor compression ", name);
+#ifndef CAFFE2_USE_ZSTD
+  CAFFE_THROW("Caffe2 was built without zstd, rebuild it with USE_ZSTD=ON");
+#endif
+  return TensorProto_Compression_ZSTD;
+}
+
+bool IsCompressible(TensorProto::DataType data_type) {
+  switch (data_type) {
+    case TensorProto_DataType_FLOAT:
+    case TensorProto_DataType_INT32:
+    case TensorProto_DataType_BOOL:
+    case TensorProto_DataType_UINT8:
+    case TensorProto_DataType_INT8:
+    case TensorProto_DataType_UINT16:
+    case TensorProto_DataType_INT16:
+    case TensorProto_DataType_INT64:
+    case TensorProto_DataType_FLOAT16:
+    case TensorProto_DataType_DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#ifdef CAFFE2_USE_ZSTD
+namespace {
+
+// out[b * n + i] = in[i * itemsize + b] for the n elements
+void ShuffleBytes(const char* in, size_t nbytes, size_t itemsize, char* out) {
+  const size_t n = nbytes / itemsize;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < itemsize; ++b) {
+      out[b * n + i] = in[i * itemsize + b];
+    }
+  }
+}
+
+void UnshuffleBytes(const char* in, size_t nbytes, size_t itemsize, char* out) {
+  const size_t n = nbytes / itemsize;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < itemsize; ++b) {
+      out[i * itemsize + b] = in[b * n + i];
+    }
+  }
+}
+
+} // namespace
+#endif // CAFFE2_USE_ZSTD
+
+void CompressChunk(
+    const char* data,
+    size_t nbytes,
+    size_t itemsize,
+    bool shuffle,
+    TensorProto::Compression compression,
+    string* out) {
+  CAFFE_ENFORCE_EQ(
+      compression,
+      TensorProto_Compression_ZSTD,
+      "Unknown tensor compression");
+#ifdef CAFFE2_USE_ZSTD
+  unique_ptr<char[]> shuffled;
+  if (shuffle && itemsize > 1) {
+    shuffled.reset(new char[nbytes]);
+    ShuffleBytes(data, nbytes, itemsize, shuffled.get());
+    data = shuffled.get();
+  }
+  out->clear();
+  // Every frame records its decompressed size, so that the frames can be
+  // found and decompressed independently.
+  for (size_t begin = 0; begin < nbytes; begin += kCompressionFrameSize) {
+    const size_t size = std::min(kCompressionFrameSize, nbytes - begin);
+    const size_t offset = out->size();
+    out->resize(offset + ZSTD_compressBound(size));
+    const size_t compressed_size = ZSTD_compress(
+        &(*out)[offset],
+        out->size() - offset,
+        data + begin,
+        size,
+        FLAGS_caffe2_tensor_compression_level);
+    CAFFE_ENFORCE(
+        !ZSTD_isError(compressed_size),
+        "zstd compression failed: ",
+        ZSTD_getErrorName(compressed_size));
+    out->resize(offset + compressed_size);
+  }
+#else
+  CAFFE_THROW("Caffe2 was built without zstd, rebuild it with USE_ZSTD=ON");
+#endif
+}
+
+void DecompressChunk(
+    const string& compressed,
+    size_t nbytes,
+    size_t itemsize,
+    bool shuffled,
+    TensorProto::Compression compression,
+    char* out) {
+  CAFFE_ENFORCE_EQ(
+      compression,
+      TensorProto_Compression_ZSTD,
+      "Unknown tensor compression");
+#ifdef CAFFE2_USE_ZSTD
+  unique_ptr<char[]> unshuffled;
+  char* dst = out;
+  if (shuffled && itemsize > 1) {
+    unshuffled.reset(new char[nbytes]);
+    dst = unshuffled.get();
+  }
+
+  // The frame headers are read sequentially, which is cheap, and the frames
+  // are decompressed in parallel.
+  struct Frame {
+    const char* src;
+    size_t src_size;
+    char* dst;
+    size_t dst_size;
+  };
+  vector<Frame> frames;
+  const char* src = compressed.data();
+  size_t src_left = compressed.size();
+  size_t dst_offset = 0;
+  while (src_left > 0) {
+    const size_t frame_size = ZSTD_findFrameCompressedSize(src, src_left);
+    CAFFE_ENFORCE(!ZSTD_isError(frame_size), "Corrupted compressed chunk");
+    const unsigned long long content_size =
+        ZSTD_getFrameContentSize(src, frame_size);
+    CAFFE_ENFORCE(
+        content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+            content_size != ZSTD_CONTENTSIZE_ERROR &&
+            content_size <= nbytes - dst_offset,
+        "Corrupted compressed chunk");
+    frames.push_back({src, frame_size, dst + dst_offset, content_size});
+    src += frame_size;
+    src_left -= frame_size;
+    dst_offset += content_size;
+  }
+  CAFFE_ENFORCE_EQ(dst_offset, nbytes, "Incorrect compressed chunk size.");
+
+  auto decompress = [&frames](size_t i) {
+    const Frame& frame = frames[i];
+    const size_t size =
+        ZSTD_decompress(frame.dst, frame.dst_size, frame.src, frame.src_size);
+    CAFFE_ENFORCE(
+        !ZSTD_isError(size) && size == frame.dst_size,
+        "zstd decompression failed");
+  };
+#ifndef __ANDROID__
+  const size_t num_threads = std::max<size_t>(
+      1,
+      std::min<size_t>(
+          FLAGS_caffe2_max_tensor_serializer_threads, frames.size()));
+  if (num_threads > 1) {
+    std::vector<std::future<void>> futures;
+    for (size_t t = 0; t < num_threads; ++t) {
+      futures.emplace_back(std::async(std::launch::async, [&, t]() {
+        for (size_t i = t; i < frames.size(); i += num_threads) {
+          decompress(i);
+        }
+      }));
+    }
+    for (auto& future : futures) {
+      future.get();
+    }
+  } else
+#endif
+  {
+    for (size_t i = 0; i < frames.size(); ++i) {
+      decompress(i);
+    }
+  }
+
+  if (unshuffled) {
+    UnshuffleBytes(unshuffled.get(), nbytes, itemsize, out);
+  }
+#else
+  CAFFE_THROW("Caffe2 was built without zstd, rebuild it with USE_ZSTD=ON");
+#endif
+}
+
+} // namespace detail
+
 namespace {
 // Serialize TensorCPU.
 REGISTER_BLOB_SERIALIZER(
@@ -16,6 +16,9 @@
 CAFFE2_DECLARE_int(caffe2_tensor_chunk_size);
 CAFFE2_DECLARE_int(caffe2_max_tensor_serializer_threads);
 CAFFE2_DECLARE_bool(caffe2_serialize_fp16_as_bytes);
+CAFFE2_DECLARE_string(caffe2_tensor_compression);
+CAFFE2_DECLARE_int(caffe2_tensor_compression_level);
+CAFFE2_DECLARE_bool(caffe2_tensor_byte_shuffle);
 
 namespace caffe2 {
 
@@ -180,6 +183,32 @@ inline void CopyFromProtoWithCast(
   context->template Copy<DstType, CPUContext, Context>(size, buffer.get(), dst);
 }
 
+// Compression of the tensor chunks, see TensorProto::compression. The raw
+// data is split in frames of kCompressionFrameSize bytes at most.
+constexpr size_t kCompressionFrameSize = 1 << 20;
+
+// Returns the compression selected by --caffe2_tensor_compression
+TensorProto::Compression SelectedCompression();
+
+// Returns true if the data of a type can be compressed
+bool IsCompressible(TensorProto::DataType data_type);
+
+void CompressChunk(
+    const char* data,
+    size_t nbytes,
+    size_t itemsize,
+    bool shuffle,
+    TensorProto::Compression compression,
+    string* out);
+
+void DecompressChunk(
+    const string& compressed,
+    size_t nbytes,
+    size_t itemsize,
+    bool shuffled,
+    TensorProto::Compression compression,
+    char* out);
+
 }  // namespace detail
 
 template <class Context>
@@ -297,6 +326,33 @@ void TensorSerializer<Context>::Serialize(
   proto.set_data_type(data_type);
   StoreDeviceDetail(input, &proto);
 
+  const auto compression = detail::SelectedCompression();
+  if (compression != TensorProto_Compression_NO_COMPRESSION &&
+      detail::IsCompressible(data_type)) {
+    const size_t itemsize = input.itemsize();
+    const size_t nbytes = chunkSize * itemsize;
+    unique_ptr<char[]> buffer(new char[nbytes]);
+    this->context_.template Copy<char, Context, CPUContext>(
+        nbytes,
+        static_cast<const char*>(input.raw_data()) + chunkBegin * itemsize,
+        buffer.get());
+    this->context_.FinishDeviceComputation();
+    const bool shuffle = FLAGS_caffe2_tensor_byte_shuffle &&
+        (data_type == TensorProto_DataType_FLOAT ||
+         data_type == TensorProto_DataType_DOUBLE ||
+         data_type == TensorProto_DataType_FLOAT16);
+    detail::CompressChunk(
+        buffer.get(),
+        nbytes,
+        itemsize,
+        shuffle,
+        compression,
+        proto.mutable_byte_data());
+    proto.set_compression(compression);
+    proto.set_byte_shuffled(shuffle);
+    return;
+  }
+
   // A lot of copypaste is error prone. Should we create a macro for this?
   switch (data_type) {
   case TensorProto_DataType_FLOAT:
@@ -452,6 +508,31 @@ void TensorDeserializer<Context>::Deserialize(
       tensor->size());
   auto chunkSize = chunkEnd - chunkBegin;
 
+  if (proto.compression() != TensorProto_Compression_NO_COMPRESSION) {
+    CAFFE_ENFORCE(
+        detail::IsCompressible(proto.data_type()),
+        "Compressed chunk of a type which isn't compressed: ",
+        proto.data_type());
+    const TypeMeta& meta = DataTypeToTypeMeta(proto.data_type());
+    const size_t itemsize = meta.itemsize();
+    const size_t nbytes = chunkSize * itemsize;
+    unique_ptr<char[]> buffer(new char[nbytes]);
+    detail::DecompressChunk(
+        proto.byte_data(),
+        nbytes,
+        itemsize,
+        proto.byte_shuffled(),
+        proto.compression(),
+        buffer.get());
+    context.template Copy<char, CPUContext, Context>(
+        nbytes,
+        buffer.get(),
+        static_cast<char*>(tensor->raw_mutable_data(meta)) +
+            chunkBegin * itemsize);
+    context.FinishDeviceComputation();
+    return;
+  }
+
   switch (proto.data_type()) {
     case TensorProto_DataType_FLOAT:
       detail::CopyFromProtoAsIs(
@@ -478,6 +478,44 @@ TYPED_TEST(TensorCPUTest, MaxKeepOnShrink) {
   FLAGS_caffe2_max_keep_on_shrink_memory = LLONG_MAX;
 }
 
+TYPED_TEST(TensorCPUTest, GrowthPct) {
+  FLAGS_caffe2_keep_on_shrink = true;
+  FLAGS_caffe2_max_keep_on_shrink_memory = LLONG_MAX;
+
+  TensorCPU tensor(vector<int>{10});
+  tensor.SetGrowthPct(50);
+  tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 10 * sizeof(TypeParam));
+  // Growing allocates 50% more than the old capacity
+  tensor.Resize(11);
+  TypeParam* ptr = tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 15 * sizeof(TypeParam));
+  // which the following sizes fit in
+  tensor.Resize(14);
+  EXPECT_EQ(ptr, tensor.mutable_data<TypeParam>());
+  tensor.Resize(3);
+  EXPECT_EQ(ptr, tensor.mutable_data<TypeParam>());
+  tensor.Resize(15);
+  EXPECT_EQ(ptr, tensor.mutable_data<TypeParam>());
+  // Outgrowing by more than the growth allocates the exact size
+  tensor.Resize(40);
+  tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 40 * sizeof(TypeParam));
+
+  // The flag applies when the tensor doesn't override it
+  FLAGS_caffe2_tensor_growth_pct = 100;
+  TensorCPU other(vector<int>{4});
+  other.mutable_data<TypeParam>();
+  other.Resize(5);
+  other.mutable_data<TypeParam>();
+  EXPECT_EQ(other.capacity_nbytes(), 8 * sizeof(TypeParam));
+  other.SetGrowthPct(0);
+  other.Resize(9);
+  other.mutable_data<TypeParam>();
+  EXPECT_EQ(other.capacity_nbytes(), 9 * sizeof(TypeParam));
+  FLAGS_caffe2_tensor_growth_pct = 0;
+}
+
 TYPED_TEST(TensorCPUDeathTest, CannotAccessRawDataWhenEmpty) {
   TensorCPU tensor;
   EXPECT_EQ(tensor.ndim(), 0);
@@ -692,6 +730,47 @@ TEST(TensorTest, float16) {
   }
 }
 
+#ifdef CAFFE2_USE_ZSTD
+TEST(TensorTest, CompressedSerialization) {
+  const TIndex kSize = 3000000;
+  Blob blob;
+  TensorCPU* tensor = blob.GetMutable<TensorCPU>();
+  tensor->Resize(kSize);
+  for (int i = 0; i < kSize; ++i) {
+    tensor->mutable_data<float>()[i] = (i % 1000) * 0.5f;
+  }
+  FLAGS_caffe2_tensor_compression = "zstd";
+  vector<string> chunks;
+  std::mutex mutex;
+  blob.Serialize(
+      "test",
+      [&](const string& /*key*/, const string& value) {
+        std::lock_guard<std::mutex> guard(mutex);
+        chunks.push_back(value);
+      },
+      kSize / 2);
+  FLAGS_caffe2_tensor_compression = "";
+  EXPECT_EQ(chunks.size(), 2);
+
+  Blob new_blob;
+  for (const auto& chunk : chunks) {
+    BlobProto proto;
+    CHECK(proto.ParseFromString(chunk));
+    const TensorProto& tensor_proto = proto.tensor();
+    EXPECT_EQ(tensor_proto.compression(), TensorProto_Compression_ZSTD);
+    EXPECT_TRUE(tensor_proto.byte_shuffled());
+    EXPECT_EQ(tensor_proto.float_data_size(), 0);
+    EXPECT_LT(tensor_proto.byte_data().size(), kSize / 2 * sizeof(float));
+    EXPECT_NO_THROW(new_blob.Deserialize(proto));
+  }
+  const TensorCPU& new_tensor = new_blob.Get<TensorCPU>();
+  EXPECT_EQ(new_tensor.dim(0), kSize);
+  for (int i = 0; i < kSize; ++i) {
+    EXPECT_EQ(new_tensor.data<float>()[i], (i % 1000) * 0.5f);
+  }
+}
+#endif
+
 TEST(QTensorTest, QTensorSerialization) {
   Blob blob;
   QTensor<CPUContext>* qtensor = blob.GetMutable<QTensor<CPUContext>>();
@@ -14,9 +14,13 @@
 #include "caffe2/core/tensor.h"
 #include "caffe2/utils/string_utils.h"
 
+#ifdef CAFFE2_USE_ATEN
+#include "THC/THCCachingAllocator.h"
+#endif
+
 CAFFE2_DEFINE_string(caffe2_cuda_memory_pool, "",
               "Sets the memory pool used by caffe2. Possible values are "
-              "none, cnmen and cub.");
+              "none, cnmen, cub and thc.");
 
 // For description of CUB caching allocator configuration, see
 // https://nvlabs.github.io/cub/structcub_1_1_caching_device_allocator.html
@@ -85,6 +89,13 @@ static std::vector<long> g_max_by_gpu_map(CAFFE2_COMPILE_TIME_MAX_GPUS, 0);
 static long g_total_mem = 0;
 static long g_last_rep = 0;
 
+// The memory of the CUDA graphs, by pointer, with the graph and whether it
+// was deleted. Guarded by the CUDAContext::mutex.
+static std::unordered_map<void*, std::pair<int, bool>> g_graph_memory;
+static int g_next_graph = 1;
+// The CUDA graph captured by the thread, or 0
+static thread_local int g_capturing_graph = 0;
+
 CudaMemoryPoolType GetCudaMemoryPoolType() {
   return g_cuda_memory_pool_type;
 }
@@ -192,6 +203,14 @@ static void Caffe2SetCUDAMemoryPool() {
     // Sets up cub.
     g_cuda_memory_pool_type = CudaMemoryPoolType::CUB;
     SetUpCub();
+  } else if (FLAGS_caffe2_cuda_memory_pool == "thc") {
+#ifdef CAFFE2_USE_ATEN
+    // The THC caching allocator is initialized statically, and shared with
+    // the ATen ops, so that the free blocks of either are reused by both.
+    g_cuda_memory_pool_type = CudaMemoryPoolType::THC;
+#else
+    CAFFE_THROW("The thc memory pool requires Caffe2 to be built with ATen.");
+#endif
   } else {
     CAFFE_THROW("Unrecognized cuda memory pool type: ",
                 FLAGS_caffe2_cuda_memory_pool);
@@ -329,7 +348,7 @@ std::pair<void*, MemoryDeleter> CUDAContext::New(size_t nbytes) {
       g_size_map[ptr] = nbytes;
       g_cuda_device_affiliation[ptr] = CaffeCudaGetDevice();
     }
-    return {ptr, Delete};
+    break;
   case CudaMemoryPoolType::CUB:
     CUDA_ENFORCE(g_cub_allocator->DeviceAllocate(&ptr, nbytes));
     g_cuda_device_affiliation[ptr] = CaffeCudaGetDevice();
@@ -338,15 +357,80 @@ std::pair<void*, MemoryDeleter> CUDAContext::New(size_t nbytes) {
     if (FLAGS_caffe2_gpu_memory_tracking) {
       g_size_map[ptr] = nbytes;
     }
-    return {ptr, Delete};
+    break;
+  case CudaMemoryPoolType::THC: {
+#ifdef CAFFE2_USE_ATEN
+    // Blocks are associated with the stream of the calling thread, on which
+    // its Caffe2 ops run by default: the caching allocator reuses them for
+    // the allocations of that stream, and for the other streams after their
+    // uses are recorded, just as for the ATen tensors.
+    auto* allocator = THCCachingAllocator_get();
+    CUDA_ENFORCE(allocator->malloc(
+        allocator->state,
+        &ptr,
+        nbytes,
+        CUDAContext::cuda_stream(CaffeCudaGetDevice(), 0)));
+    if (FLAGS_caffe2_gpu_memory_tracking) {
+      g_size_map[ptr] = nbytes;
+      g_cuda_device_affiliation[ptr] = CaffeCudaGetDevice();
+    }
+#endif
+    break;
+  }
+  }
+  if (g_capturing_graph && ptr) {
+    g_graph_memory[ptr] = {g_capturing_graph, false};
+  }
+  return {ptr, Delete};
+}
+
+int CUDAContext::BeginGraphCapture() {
+  std::lock_guard<std::mutex> lock(CUDAContext::mutex());
+  CAFFE_ENFORCE(!g_capturing_graph, "A graph is already captured by the thread");
+  g_capturing_graph = g_next_graph++;
+  return g_capturing_graph;
+}
+
+void CUDAContext::EndGraphCapture() {
+  g_capturing_graph = 0;
+}
+
+void CUDAContext::ReleaseGraphMemory(int graph) {
+  std::vector<void*> deleted;
+  {
+    std::lock_guard<std::mutex> lock(CUDAContext::mutex());
+    for (auto it = g_graph_memory.begin(); it != g_graph_memory.end();) {
+      if (it->second.first == graph) {
+        if (it->second.second) {
+          deleted.push_back(it->first);
+        }
+        it = g_graph_memory.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (void* ptr : deleted) {
+    Delete(ptr);
   }
-  return {nullptr, Delete};
 }
 
 void CUDAContext::Delete(void* ptr) {
   // lock the mutex
   std::lock_guard<std::mutex> lock(CUDAContext::mutex());
 
+  // The memory of a CUDA graph, and the memory freed while capturing one, is
+  // accessed by the replays of the graph: keep it until the graph is released
+  auto graph_it = g_graph_memory.find(ptr);
+  if (graph_it != g_graph_memory.end()) {
+    graph_it->second.second = true;
+    return;
+  }
+  if (g_capturing_graph) {
+    g_graph_memory[ptr] = {g_capturing_graph, true};
+    return;
+  }
+
   if (FLAGS_caffe2_gpu_memory_tracking) {
     auto sz_it = g_size_map.find(ptr);
     DCHECK(sz_it != g_size_map.end());
@@ -385,6 +469,21 @@ void CUDAContext::Delete(void* ptr) {
     g_cuda_device_affiliation.erase(it);
     break;
   }
+  case CudaMemoryPoolType::THC: {
+#ifdef CAFFE2_USE_ATEN
+    auto* allocator = THCCachingAllocator_get();
+    cudaError_t error = allocator->free(allocator->state, ptr);
+    // As with cudaFree, ignore the deletions after the cuda runtime exits
+    if (error != cudaSuccess && error != cudaErrorCudartUnloading) {
+      LOG(FATAL) << "Error at: " << __FILE__ << ":" << __LINE__ << ": "
+                 << cudaGetErrorString(error);
+    }
+    if (FLAGS_caffe2_gpu_memory_tracking) {
+      g_cuda_device_affiliation.erase(g_cuda_device_affiliation.find(ptr));
+    }
+#endif
+    break;
+  }
   }
 }
 
@@ -18,6 +18,9 @@ namespace caffe2 {
 enum class CudaMemoryPoolType {
   NONE = 0,
   CUB = 1,
+  // The THCCachingAllocator of ATen, shared with the ATen ops of the process.
+  // Only available in builds with ATen.
+  THC = 2,
 };
 
 /**
@@ -200,6 +203,15 @@ class CUDAContext final {
   // deadlocks
   static std::mutex& mutex();
 
+  // The memory allocated or freed by the calling thread between
+  // BeginGraphCapture and EndGraphCapture belongs to the returned CUDA
+  // graph, whose replays access it: it keeps its address and is only freed
+  // by ReleaseGraphMemory, once the last replay is done or ordered before the
+  // next uses of the memory.
+  static int BeginGraphCapture();
+  static void EndGraphCapture();
+  static void ReleaseGraphMemory(int graph);
+
   // Functions to query memory stats. Only available if flag
   // --caffe2_gpu_memory_tracking is enabled.
   static std::vector<long> TotalMemoryByGpu();
@@ -8,6 +8,10 @@
 #include "caffe2/core/context_gpu.h"
 #include <gtest/gtest.h>
 
+#ifdef CAFFE2_USE_ATEN
+#include "THC/THCCachingAllocator.h"
+#endif
+
 CAFFE2_DECLARE_bool(caffe2_cuda_full_device_control);
 
 namespace caffe2 {
@@ -85,6 +89,26 @@ TEST(CUDAContextTest, MemoryPoolAllocateDealloc) {
   }
 }
 
+#ifdef CAFFE2_USE_ATEN
+TEST(CUDAContextTest, THCMemoryPoolIsShared) {
+  if (!HasCudaGPU())
+    return;
+  if (GetCudaMemoryPoolType() != CudaMemoryPoolType::THC) {
+    LOG(ERROR) << "Choose the thc memory pool to test sharing it.";
+    return;
+  }
+  const int nbytes = 1048576;
+  DeviceGuard guard(0);
+  uint64_t before = THCCachingAllocator_currentMemoryAllocated(0);
+  auto allocated = shared_from_new(CUDAContext::New(nbytes));
+  EXPECT_NE(allocated, nullptr);
+  // The allocation is counted by the caching allocator of ATen
+  EXPECT_EQ(THCCachingAllocator_currentMemoryAllocated(0), before + nbytes);
+  allocated.reset();
+  EXPECT_EQ(THCCachingAllocator_currentMemoryAllocated(0), before);
+}
+#endif
+
 cudaStream_t getStreamForHandle(cublasHandle_t handle) {
   cudaStream_t stream = nullptr;
   CUBLAS_ENFORCE(cublasGetStream(handle, &stream));
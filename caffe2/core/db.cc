@@ -169,6 +169,90 @@ class MiniDB : public DB {
 REGISTER_CAFFE2_DB(MiniDB, MiniDB);
 REGISTER_CAFFE2_DB(minidb, MiniDB);
 
+void DBReader::StartPrefetch(size_t num_records) const {
+  CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
+  StopPrefetch();
+  if (num_records == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+  prefetch_ring_.resize(num_records);
+  prefetch_head_ = 0;
+  prefetch_count_ = 0;
+  prefetch_stop_ = false;
+  prefetch_error_ = nullptr;
+  prefetch_size_ = num_records;
+  prefetch_thread_ = std::thread(&DBReader::PrefetchLoop, this);
+}
+
+void DBReader::StopPrefetch() const {
+  {
+    std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    if (!prefetch_thread_.joinable()) {
+      return;
+    }
+    prefetch_stop_ = true;
+    prefetch_not_full_.notify_all();
+  }
+  prefetch_thread_.join();
+  std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+  prefetch_size_ = 0;
+  prefetch_count_ = 0;
+  prefetch_ring_.clear();
+  prefetch_not_empty_.notify_all();
+}
+
+void DBReader::PrefetchLoop() const {
+  string key, value;
+  while (true) {
+    // the cursor is only used by this thread while prefetching
+    try {
+      ReadFromCursor(&key, &value);
+    } catch (...) {
+      std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+      prefetch_error_ = std::current_exception();
+      prefetch_not_empty_.notify_all();
+      return;
+    }
+    std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    prefetch_not_full_.wait(mutex_lock, [this] {
+      return prefetch_stop_ || prefetch_count_ < prefetch_ring_.size();
+    });
+    if (prefetch_stop_) {
+      return;
+    }
+    auto& slot = prefetch_ring_
+        [(prefetch_head_ + prefetch_count_) % prefetch_ring_.size()];
+    slot.first.swap(key);
+    slot.second.swap(value);
+    ++prefetch_count_;
+    prefetch_not_empty_.notify_one();
+  }
+}
+
+void DBReader::ReadPrefetched(
+    std::unique_lock<std::mutex>& mutex_lock,
+    string* key,
+    string* value) const {
+  prefetch_not_empty_.wait(mutex_lock, [this] {
+    return prefetch_count_ > 0 || prefetch_error_ || prefetch_size_ == 0;
+  });
+  if (prefetch_count_ == 0) {
+    if (prefetch_error_) {
+      std::rethrow_exception(prefetch_error_);
+    }
+    // prefetching was stopped while waiting
+    ReadFromCursor(key, value);
+    return;
+  }
+  auto& slot = prefetch_ring_[prefetch_head_];
+  key->swap(slot.first);
+  value->swap(slot.second);
+  prefetch_head_ = (prefetch_head_ + 1) % prefetch_ring_.size();
+  --prefetch_count_;
+  prefetch_not_full_.notify_one();
+}
+
 void DBReaderSerializer::Serialize(
     const Blob& blob,
     const string& name,
@@ -180,7 +264,13 @@ void DBReaderSerializer::Serialize(
   proto.set_source(reader.source_);
   proto.set_db_type(reader.db_type_);
   if (reader.cursor() && reader.cursor()->SupportsSeek()) {
-    proto.set_key(reader.cursor()->key());
+    std::unique_lock<std::mutex> mutex_lock(reader.reader_mutex_);
+    // the cursor is ahead of the prefetched records that weren't read yet
+    if (reader.prefetch_count_ > 0) {
+      proto.set_key(reader.prefetch_ring_[reader.prefetch_head_].first);
+    } else {
+      proto.set_key(reader.cursor()->key());
+    }
   }
   BlobProto blob_proto;
   blob_proto.set_name(name);
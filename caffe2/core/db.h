@@ -1,7 +1,12 @@
 #ifndef CAFFE2_CORE_DB_H_
 #define CAFFE2_CORE_DB_H_
 
+#include <condition_variable>
+#include <exception>
 #include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/registry.h"
@@ -16,6 +21,14 @@ namespace db {
  */
 enum Mode { READ, WRITE, NEW };
 
+/**
+ * Bytes owned by someone else, e.g. the value under a cursor.
+ */
+struct ValueView {
+  const char* data = nullptr;
+  size_t size = 0;
+};
+
 /**
  * An abstract class for the cursor of the database while reading.
  */
@@ -46,12 +59,28 @@ class Cursor {
    * Returns the current value.
    */
   virtual string value() = 0;
+  /**
+   * Returns the current value without copying it when the db allows it
+   * (e.g. LMDB hands out pointers into its memory map). The view is only
+   * valid until the cursor moves. By default it views a copy of value()
+   * kept by the cursor.
+   */
+  virtual ValueView value_view() {
+    value_copy_ = value();
+    ValueView view;
+    view.data = value_copy_.data();
+    view.size = value_copy_.size();
+    return view;
+  }
   /**
    * Returns whether the current location is valid - for example, if we have
    * reached the end of the database, return false.
    */
   virtual bool Valid() = 0;
 
+ private:
+  string value_copy_;
+
   DISABLE_COPY_AND_ASSIGN(Cursor);
 };
 
@@ -175,11 +204,16 @@ class DBReader {
     cursor_ = db_->NewCursor();
   }
 
+  ~DBReader() {
+    StopPrefetch();
+  }
+
   void Open(
       const string& db_type,
       const string& source,
       const int32_t num_shards = 1,
       const int32_t shard_id = 0) {
+    StopPrefetch();
     // Note(jiayq): resetting is needed when we re-open e.g. leveldb where no
     // concurrent access is allowed.
     cursor_.reset();
@@ -195,6 +229,7 @@ class DBReader {
       unique_ptr<DB>&& db,
       const int32_t num_shards = 1,
       const int32_t shard_id = 0) {
+    StopPrefetch();
     cursor_.reset();
     db_.reset();
     db_ = std::move(db);
@@ -222,17 +257,37 @@ class DBReader {
   void Read(string* key, string* value) const {
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
-    *key = cursor_->key();
-    *value = cursor_->value();
+    if (prefetch_size_ > 0) {
+      ReadPrefetched(mutex_lock, key, value);
+      return;
+    }
+    ReadFromCursor(key, value);
+  }
 
-    // In sharded mode, each read skips num_shards_ records
-    for (int s = 0; s < num_shards_; s++) {
-      cursor_->Next();
-      if (!cursor_->Valid()) {
-        MoveToBeginning();
-        break;
-      }
+  /**
+   * Like Read, but calls f(const ValueView&) on the value instead of copying
+   * it into a string, for values that are parsed right away. The view is
+   * only valid during the call. Unless prefetching, f runs under the
+   * reader's lock, so it should do no more than parse the value.
+   */
+  template <typename F>
+  void ReadView(string* key, F&& f) const {
+    CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
+    std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    if (prefetch_size_ > 0) {
+      // the prefetched value is already a string of its own
+      string value;
+      ReadPrefetched(mutex_lock, key, &value);
+      mutex_lock.unlock();
+      ValueView view;
+      view.data = value.data();
+      view.size = value.size();
+      f(view);
+      return;
     }
+    *key = cursor_->key();
+    f(cursor_->value_view());
+    MoveToNextRecord();
   }
 
   /**
@@ -240,10 +295,43 @@ class DBReader {
    */
   void SeekToFirst() const {
     CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
-    std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
-    MoveToBeginning();
+    size_t prefetch_size;
+    {
+      std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+      prefetch_size = prefetch_size_;
+    }
+    StopPrefetch();
+    {
+      std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+      MoveToBeginning();
+    }
+    if (prefetch_size > 0) {
+      StartPrefetch(prefetch_size);
+    }
   }
 
+  /**
+   * @brief Reads ahead of Read() in a background thread.
+   *
+   * Up to num_records records are read from the cursor into a ring while the
+   * callers process earlier ones, so that reading overlaps with the work
+   * done on the records instead of serializing all the readers on the db.
+   * Read() then only waits when the ring is empty, and moves the record out
+   * of it without copying. num_records = 0 stops prefetching.
+   *
+   * While prefetching, the cursor is ahead of the records returned by
+   * Read(), and must not be used directly.
+   */
+  void StartPrefetch(size_t num_records) const;
+
+  /**
+   * @brief Stops the background thread and drops the prefetched records.
+   *
+   * The next Read() continues from the position of the cursor, after the
+   * dropped records.
+   */
+  void StopPrefetch() const;
+
   /**
    * Returns the underlying cursor of the db reader.
    *
@@ -268,6 +356,31 @@ class DBReader {
     SeekToFirst();
   }
 
+  // Reads the record under the cursor and moves to the next one for this
+  // shard. Requires reader_mutex_ or, while prefetching, the prefetch thread.
+  void ReadFromCursor(string* key, string* value) const {
+    *key = cursor_->key();
+    *value = cursor_->value();
+    MoveToNextRecord();
+  }
+
+  void MoveToNextRecord() const {
+    // In sharded mode, each read skips num_shards_ records
+    for (int s = 0; s < num_shards_; s++) {
+      cursor_->Next();
+      if (!cursor_->Valid()) {
+        MoveToBeginning();
+        break;
+      }
+    }
+  }
+
+  void ReadPrefetched(
+      std::unique_lock<std::mutex>& mutex_lock,
+      string* key,
+      string* value) const;
+  void PrefetchLoop() const;
+
   void MoveToBeginning() const {
     cursor_->SeekToFirst();
     for (auto s = 0; s < shard_id_; s++) {
@@ -285,6 +398,18 @@ class DBReader {
   uint32_t num_shards_;
   uint32_t shard_id_;
 
+  // Prefetching state, see StartPrefetch. The ring holds
+  // prefetch_count_ records from prefetch_head_, guarded by reader_mutex_.
+  mutable size_t prefetch_size_ = 0;
+  mutable std::vector<std::pair<string, string>> prefetch_ring_;
+  mutable size_t prefetch_head_ = 0;
+  mutable size_t prefetch_count_ = 0;
+  mutable bool prefetch_stop_ = false;
+  mutable std::exception_ptr prefetch_error_;
+  mutable std::condition_variable prefetch_not_empty_;
+  mutable std::condition_variable prefetch_not_full_;
+  mutable std::thread prefetch_thread_;
+
   DISABLE_COPY_AND_ASSIGN(DBReader);
 };
 
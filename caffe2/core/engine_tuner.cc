@@ -0,0 +1,261 @@
+#include "caffe2/core/engine_tuner.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/utils/proto_utils.h"
+
+CAFFE2_DEFINE_string(
+    caffe2_engine_cache_file,
+    "",
+    "If set, the file the engines chosen by AutotuneEngines are saved to, and "
+    "that CreateOperator reads them from.");
+CAFFE2_DECLARE_int(caffe2_operator_max_engine_name_length);
+
+namespace caffe2 {
+
+namespace {
+
+const std::string kEngineSeparator = "_ENGINE_";
+
+// FNV-1a, so that keys are the same across processes and platforms.
+uint64_t hashString(const std::string& s, uint64_t hash) {
+  for (unsigned char c : s) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// The milliseconds per run of op, or a negative value if it fails.
+double benchmarkOperator(OperatorBase* op, int warmup, int iters) {
+  try {
+    for (int i = 0; i < warmup; ++i) {
+      if (!op->Run()) {
+        return -1;
+      }
+    }
+    Timer timer;
+    for (int i = 0; i < iters; ++i) {
+      if (!op->Run()) {
+        return -1;
+      }
+    }
+    return timer.MilliSeconds() / std::max(iters, 1);
+  } catch (const std::exception& e) {
+    VLOG(1) << "Engine " << op->engine() << " failed: " << e.what();
+    return -1;
+  }
+}
+
+bool isInplace(const OperatorDef& def) {
+  for (const auto& output : def.output()) {
+    for (const auto& input : def.input()) {
+      if (input == output) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+std::vector<std::string> RegisteredEngines(
+    const std::string& op_type,
+    int device_type) {
+  std::vector<std::string> engines;
+  if (!gDeviceTypeRegistry()->count(device_type)) {
+    return engines;
+  }
+  OperatorRegistry* registry = gDeviceTypeRegistry()->at(device_type);
+  if (registry->Has(op_type)) {
+    engines.push_back("DEFAULT");
+  }
+  const std::string prefix = op_type + kEngineSeparator;
+  for (const auto& key : registry->Keys()) {
+    if (key.size() > prefix.size() &&
+        key.compare(0, prefix.size(), prefix) == 0) {
+      engines.push_back(key.substr(prefix.size()));
+    }
+  }
+  return engines;
+}
+
+bool EngineCacheKey(
+    const OperatorDef& def,
+    const std::vector<TensorShape>& input_shapes,
+    std::string* key) {
+  std::stringstream ss;
+  const auto& device = def.device_option();
+  ss << DeviceTypeName(device.device_type());
+  if (device.device_type() == CUDA) {
+    ss << device.cuda_gpu_id();
+  }
+  ss << "|" << def.type() << "|";
+  for (size_t i = 0; i < input_shapes.size(); ++i) {
+    const auto& shape = input_shapes[i];
+    if (shape.unknown_shape() ||
+        shape.data_type() == TensorProto::UNDEFINED) {
+      return false;
+    }
+    ss << (i ? "," : "") << shape.data_type() << ":";
+    for (int j = 0; j < shape.dims_size(); ++j) {
+      ss << (j ? "x" : "") << shape.dims(j);
+    }
+  }
+  uint64_t hash = 14695981039346656037ULL;
+  for (const auto& arg : def.arg()) {
+    hash = hashString(arg.SerializeAsString(), hash);
+  }
+  ss << "|" << std::hex << hash;
+  *key = ss.str();
+  return true;
+}
+
+EngineCache& EngineCache::Global() {
+  static EngineCache cache;
+  return cache;
+}
+
+bool EngineCache::Empty() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ensureLoaded();
+  return engines_.empty();
+}
+
+bool EngineCache::Lookup(const std::string& key, std::string* engine) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ensureLoaded();
+  auto it = engines_.find(key);
+  if (it == engines_.end()) {
+    return false;
+  }
+  *engine = it->second;
+  return true;
+}
+
+void EngineCache::Insert(const std::string& key, const std::string& engine) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ensureLoaded();
+  engines_[key] = engine;
+}
+
+bool EngineCache::Load(const std::string& filename) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return loadLocked(filename);
+}
+
+bool EngineCache::Save(const std::string& filename) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ensureLoaded();
+  std::ofstream file(filename);
+  for (const auto& it : engines_) {
+    file << it.first << " " << it.second << "\n";
+  }
+  return bool(file);
+}
+
+void EngineCache::ensureLoaded() {
+  if (!loaded_) {
+    loaded_ = true;
+    if (!FLAGS_caffe2_engine_cache_file.empty()) {
+      loadLocked(FLAGS_caffe2_engine_cache_file);
+    }
+  }
+}
+
+bool EngineCache::loadLocked(const std::string& filename) {
+  std::ifstream file(filename);
+  if (!file) {
+    return false;
+  }
+  std::string key, engine;
+  while (file >> key >> engine) {
+    engines_[key] = engine;
+  }
+  return true;
+}
+
+NetDef AutotuneEngines(
+    const NetDef& net,
+    Workspace* ws,
+    int warmup,
+    int iters) {
+  NetDef tuned = net;
+  for (auto& tunedDef : *tuned.mutable_op()) {
+    OperatorDef def = tunedDef;
+    if (!def.has_device_option() && net.has_device_option()) {
+      def.mutable_device_option()->CopyFrom(net.device_option());
+    }
+    const auto engines =
+        RegisteredEngines(def.type(), def.device_option().device_type());
+    std::vector<TensorShape> shapes;
+    bool hasInputs = true;
+    for (const auto& input : def.input()) {
+      const Blob* blob = ws->GetBlob(input);
+      hasInputs = hasInputs && blob;
+      if (blob) {
+        shapes.push_back(GetTensorShapeOfBlob(blob));
+      }
+    }
+    std::string key;
+    if (def.engine().empty() && engines.size() > 1 && hasInputs &&
+        EngineCacheKey(def, shapes, &key)) {
+      std::string best;
+      if (!EngineCache::Global().Lookup(key, &best) && !isInplace(def)) {
+        double bestTime = std::numeric_limits<double>::max();
+        for (const auto& engine : engines) {
+          OperatorDef candidate = def;
+          candidate.set_engine(engine);
+          unique_ptr<OperatorBase> op;
+          try {
+            op = CreateOperator(candidate, ws);
+          } catch (const std::exception& e) {
+            VLOG(1) << "Engine " << engine << " failed: " << e.what();
+            continue;
+          }
+          // CreateOperator falls back to the default implementation, and
+          // annotates the op with a prefix of the engine name.
+          if (op->engine() !=
+              engine.substr(0, FLAGS_caffe2_operator_max_engine_name_length)) {
+            continue;
+          }
+          const double time = benchmarkOperator(op.get(), warmup, iters);
+          VLOG(1) << def.type() << " with engine " << engine << ": " << time
+                  << " ms";
+          if (time >= 0 && time < bestTime) {
+            bestTime = time;
+            best = engine;
+          }
+        }
+        if (!best.empty()) {
+          LOG(INFO) << "Engine " << best << " is the fastest for " << key;
+          EngineCache::Global().Insert(key, best);
+        }
+      }
+      if (!best.empty()) {
+        tunedDef.set_engine(best);
+        def.set_engine(best);
+      }
+    }
+    CAFFE_ENFORCE(
+        CreateOperator(def, ws)->Run(),
+        "Failed to run ",
+        ProtoDebugString(def));
+  }
+  if (!FLAGS_caffe2_engine_cache_file.empty()) {
+    CAFFE_ENFORCE(
+        EngineCache::Global().Save(FLAGS_caffe2_engine_cache_file),
+        "Cannot write the engine cache to ",
+        FLAGS_caffe2_engine_cache_file);
+  }
+  return tuned;
+}
+
+} // namespace caffe2
@@ -0,0 +1,74 @@
+#ifndef CAFFE2_CORE_ENGINE_TUNER_H_
+#define CAFFE2_CORE_ENGINE_TUNER_H_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+CAFFE2_DECLARE_string(caffe2_engine_cache_file);
+
+namespace caffe2 {
+
+// The engines registered for op_type on device_type, the default
+// implementation (as "DEFAULT") first.
+std::vector<std::string> RegisteredEngines(
+    const std::string& op_type,
+    int device_type);
+
+// The key of an operator in the engine cache: its device, type, arguments
+// and the shapes of its inputs. Returns false if some input is not an
+// initialized tensor.
+bool EngineCacheKey(
+    const OperatorDef& def,
+    const std::vector<TensorShape>& input_shapes,
+    std::string* key);
+
+// The fastest engine measured for each cache key. The global cache is loaded
+// from --caffe2_engine_cache_file on first use; CreateOperator picks the
+// cached engine of an operator without an explicit engine when the shapes of
+// its inputs are known at creation.
+class EngineCache {
+ public:
+  static EngineCache& Global();
+
+  bool Empty();
+  bool Lookup(const std::string& key, std::string* engine);
+  void Insert(const std::string& key, const std::string& engine);
+
+  // One "<key> <engine>" line per entry. Load adds to the current entries.
+  bool Load(const std::string& filename);
+  bool Save(const std::string& filename);
+
+ private:
+  // Loads --caffe2_engine_cache_file on first use, so that saving the cache
+  // keeps the entries of earlier processes.
+  void ensureLoaded();
+  bool loadLocked(const std::string& filename);
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::string> engines_;
+  bool loaded_ = false;
+};
+
+// Runs the net once in ws, op by op. Every op without an explicit engine and
+// with more than one registered engine is first benchmarked with each of them
+// on its actual inputs (warmup and iters runs), unless the cache already has
+// its key, and the fastest one goes into the cache and into the engine field
+// of the returned net. The cache is then saved to
+// --caffe2_engine_cache_file, if set. In-place ops are not benchmarked, as
+// running them repeatedly changes their inputs.
+NetDef AutotuneEngines(
+    const NetDef& net,
+    Workspace* ws,
+    int warmup = 1,
+    int iters = 5);
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_ENGINE_TUNER_H_
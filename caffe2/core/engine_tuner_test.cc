@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "caffe2/core/engine_tuner.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+class EngineTunerTestOp : public OperatorBase {
+ public:
+  EngineTunerTestOp(const OperatorDef& def, Workspace* ws, int sleep_ms)
+      : OperatorBase(def, ws), sleep_ms_(sleep_ms) {}
+  bool Run(int /* unused */ /*stream_id*/) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms_));
+    Output<TensorCPU>(0)->CopyFrom(Input<TensorCPU>(0));
+    return true;
+  }
+
+ private:
+  int sleep_ms_;
+};
+
+class SlowEngineTunerTestOp final : public EngineTunerTestOp {
+ public:
+  SlowEngineTunerTestOp(const OperatorDef& def, Workspace* ws)
+      : EngineTunerTestOp(def, ws, 20) {}
+};
+
+class FastEngineTunerTestOp final : public EngineTunerTestOp {
+ public:
+  FastEngineTunerTestOp(const OperatorDef& def, Workspace* ws)
+      : EngineTunerTestOp(def, ws, 0) {}
+};
+
+REGISTER_CPU_OPERATOR(EngineTunerTest, SlowEngineTunerTestOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(
+    EngineTunerTest,
+    FAST,
+    FastEngineTunerTestOp);
+OPERATOR_SCHEMA(EngineTunerTest).NumInputs(1).NumOutputs(1);
+
+NetDef CreateNetDef() {
+  NetDef net;
+  auto* op = net.add_op();
+  op->set_type("EngineTunerTest");
+  op->add_input("X");
+  op->add_output("Y");
+  net.add_external_input("X");
+  return net;
+}
+
+void FeedInput(Workspace* ws, const std::vector<TIndex>& dims) {
+  auto* X = ws->CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(dims);
+  X->mutable_data<float>();
+}
+
+} // namespace
+
+TEST(EngineTunerTest, RegisteredEngines) {
+  EXPECT_EQ(
+      RegisteredEngines("EngineTunerTest", CPU),
+      (std::vector<std::string>{"DEFAULT", "FAST"}));
+  EXPECT_TRUE(RegisteredEngines("EngineTunerTest", -1).empty());
+}
+
+TEST(EngineTunerTest, PicksTheFastestEngine) {
+  Workspace ws;
+  FeedInput(&ws, {2, 3});
+  const auto tuned = AutotuneEngines(CreateNetDef(), &ws, 0, 2);
+  EXPECT_EQ(tuned.op(0).engine(), "FAST");
+  EXPECT_EQ(ws.GetBlob("Y")->Get<TensorCPU>().dims(), (vector<TIndex>{2, 3}));
+
+  // Later operators with the same shapes use the cached engine.
+  auto op = CreateOperator(CreateNetDef().op(0), &ws);
+  EXPECT_EQ(op->engine(), "FAST");
+
+  // but not with other shapes, as the key differs
+  FeedInput(&ws, {4, 3});
+  op = CreateOperator(CreateNetDef().op(0), &ws);
+  EXPECT_EQ(op->engine(), "");
+}
+
+TEST(EngineTunerTest, SaveAndLoad) {
+  OperatorDef def;
+  def.set_type("EngineTunerTest");
+  TensorShape shape;
+  shape.set_data_type(TensorProto::FLOAT);
+  shape.add_dims(5);
+  std::string key;
+  ASSERT_TRUE(EngineCacheKey(def, {shape}, &key));
+  shape.set_unknown_shape(true);
+  std::string unknown;
+  EXPECT_FALSE(EngineCacheKey(def, {shape}, &unknown));
+
+  const std::string filename = "/tmp/caffe2_engine_tuner_test_cache";
+  EngineCache saved;
+  saved.Insert(key, "FAST");
+  ASSERT_TRUE(saved.Save(filename));
+  EngineCache loaded;
+  ASSERT_TRUE(loaded.Load(filename));
+  std::string engine;
+  EXPECT_TRUE(loaded.Lookup(key, &engine));
+  EXPECT_EQ(engine, "FAST");
+  std::remove(filename.c_str());
+}
+
+} // namespace caffe2
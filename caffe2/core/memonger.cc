@@ -1,8 +1,11 @@
 #include "caffe2/core/memonger.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <set>
 #include <unordered_set>
 
+#include "caffe2/core/types.h"
 #include "caffe2/utils/proto_utils.h"
 
 namespace caffe2 {
@@ -123,6 +126,445 @@ NetDef optimize_inference_net(
   return optim_net;
 }
 
+namespace {
+
+// Ops whose output may share the memory of their first input
+bool mayAliasInput(const OperatorDef& op) {
+  static const std::unordered_set<string> ops = {"Alias",
+                                                 "EnsureDense",
+                                                 "ExpandDims",
+                                                 "Flatten",
+                                                 "FlattenToVec",
+                                                 "Reshape",
+                                                 "Squeeze",
+                                                 "StopGradient"};
+  return ops.count(op.type()) > 0;
+}
+
+// Size in bytes of a tensor of the given shape, or 0 if it is unknown or the
+// type is not POD.
+size_t tensor_bytes(const TensorShape& shape) {
+  if (shape.unknown_shape()) {
+    return 0;
+  }
+  const auto& meta = DataTypeToTypeMeta(shape.data_type());
+  if (meta.id() == 0 || meta.ctor() != nullptr) {
+    return 0;
+  }
+  size_t size = meta.itemsize();
+  for (auto d : shape.dims()) {
+    size *= d;
+  }
+  return size;
+}
+
+bool hasSubnets(const OperatorDef& op) {
+  return op.type() == "RecurrentNetwork" || op.type() == "If" ||
+      op.type() == "While" || op.type() == "Do";
+}
+
+struct BlobInterval {
+  string name;
+  int begin;
+  int end; // inclusive
+  size_t bytes;
+  size_t offset;
+};
+
+} // namespace
+
+ArenaPlan plan_inference_arena(
+    const NetDef& net,
+    const std::set<string>& static_blobs,
+    const TensorShapes& shapes,
+    size_t alignment) {
+  ArenaPlan plan;
+  if (net.type() != "" && net.type() != "simple") {
+    // ops of other nets may run in any order compatible with the dependencies
+    LOG(INFO) << "Cannot plan memory for nets of type: " << net.type();
+    return plan;
+  }
+  for (const auto& op : net.op()) {
+    if (hasSubnets(op)) {
+      LOG(INFO) << "Cannot plan memory for op type: " << op.type();
+      return plan;
+    }
+  }
+
+  std::unordered_map<string, const TensorShape*> shape_of;
+  for (const auto& shape : shapes.shapes()) {
+    shape_of[shape.name()] = &shape;
+  }
+  auto blob_bytes = [&](const string& name) -> size_t {
+    auto it = shape_of.find(name);
+    return it == shape_of.end() ? 0 : tensor_bytes(*it->second);
+  };
+
+  // Step 1: live ranges. A view stays readable as long as the blob it views,
+  // so views extend the range of their source and aren't planned.
+  std::unordered_map<string, string> alias_of;
+  auto source = [&](const string& name) {
+    auto it = alias_of.find(name);
+    return it == alias_of.end() ? name : it->second;
+  };
+  std::unordered_map<string, size_t> index;
+  std::vector<BlobInterval> intervals;
+  std::unordered_set<string> unplanned;
+  auto touch = [&](const string& name, int i) {
+    auto it = index.find(source(name));
+    if (it != index.end()) {
+      intervals[it->second].end = i;
+    }
+  };
+  for (int i = 0; i < net.op_size(); i++) {
+    const auto& op = net.op(i);
+    for (const auto& inp : op.input()) {
+      // read before being written: holds state between runs
+      if (!index.count(source(inp)) && !alias_of.count(inp)) {
+        unplanned.insert(inp);
+      }
+      touch(inp, i);
+    }
+    for (const auto& outp : op.output()) {
+      if (mayAliasInput(op) && op.input_size() > 0 && outp != op.input(0)) {
+        alias_of[outp] = source(op.input(0));
+        continue;
+      }
+      touch(outp, i);
+      if (index.count(outp) || unplanned.count(outp) ||
+          static_blobs.count(outp)) {
+        continue;
+      }
+      auto bytes = blob_bytes(outp);
+      if (bytes == 0) {
+        unplanned.insert(outp);
+        continue;
+      }
+      index[outp] = intervals.size();
+      intervals.push_back(BlobInterval{outp, i, i, bytes, 0});
+    }
+  }
+
+  // Step 2: best-fit packing, largest blobs first
+  std::vector<BlobInterval*> order;
+  for (auto& interval : intervals) {
+    order.push_back(&interval);
+  }
+  std::stable_sort(
+      order.begin(), order.end(), [](BlobInterval* a, BlobInterval* b) {
+        return a->bytes > b->bytes;
+      });
+  auto align = [&](size_t n) {
+    return (n + alignment - 1) / alignment * alignment;
+  };
+  std::vector<BlobInterval*> placed;
+  for (auto* interval : order) {
+    std::vector<BlobInterval*> conflicts;
+    for (auto* p : placed) {
+      if (p->begin <= interval->end && interval->begin <= p->end) {
+        conflicts.push_back(p);
+      }
+    }
+    std::sort(
+        conflicts.begin(),
+        conflicts.end(),
+        [](BlobInterval* a, BlobInterval* b) { return a->offset < b->offset; });
+    size_t best_offset = 0;
+    size_t best_gap = 0;
+    bool found = false;
+    size_t free_begin = 0;
+    for (auto* c : conflicts) {
+      if (c->offset >= free_begin + interval->bytes) {
+        size_t gap = c->offset - free_begin;
+        if (!found || gap < best_gap) {
+          found = true;
+          best_gap = gap;
+          best_offset = free_begin;
+        }
+      }
+      free_begin = std::max(free_begin, align(c->offset + c->bytes));
+    }
+    interval->offset = found ? best_offset : free_begin;
+    placed.push_back(interval);
+    plan.arena_bytes =
+        std::max(plan.arena_bytes, align(interval->offset + interval->bytes));
+    plan.offsets[interval->name] = interval->offset;
+  }
+
+  LOG(INFO) << "planned " << intervals.size() << " blobs in an arena of "
+            << plan.arena_bytes << " bytes";
+  return plan;
+}
+
+namespace {
+
+// Whether op i finishes before op j starts, in any execution of a net.
+class OpOrdering {
+ public:
+  explicit OpOrdering(const NetDef& net)
+      : sequential_(net.type() == "" || net.type() == "simple") {
+    if (sequential_) {
+      return;
+    }
+    // The dependencies are those of the DAG executors: an op runs after the
+    // last writers of its inputs and outputs, and after the readers of its
+    // outputs since they were last written.
+    const int n = net.op_size();
+    const int words = (n + 63) / 64;
+    before_.assign(n, std::vector<uint64_t>(words, 0));
+    std::unordered_map<string, int> last_writer;
+    std::unordered_map<string, std::vector<int>> readers;
+    for (int j = 0; j < n; ++j) {
+      const auto& op = net.op(j);
+      std::vector<int> parents;
+      for (const auto& input : op.input()) {
+        auto it = last_writer.find(input);
+        if (it != last_writer.end()) {
+          parents.push_back(it->second);
+        }
+      }
+      for (const auto& output : op.output()) {
+        auto it = last_writer.find(output);
+        if (it != last_writer.end()) {
+          parents.push_back(it->second);
+        }
+        for (int reader : readers[output]) {
+          parents.push_back(reader);
+        }
+      }
+      for (int p : parents) {
+        if (p == j) {
+          continue;
+        }
+        before_[j][p / 64] |= uint64_t(1) << (p % 64);
+        for (int w = 0; w < words; ++w) {
+          before_[j][w] |= before_[p][w];
+        }
+      }
+      for (const auto& input : op.input()) {
+        readers[input].push_back(j);
+      }
+      for (const auto& output : op.output()) {
+        last_writer[output] = j;
+        readers[output].clear();
+      }
+    }
+  }
+
+  bool operator()(int i, int j) const {
+    if (sequential_) {
+      return i < j;
+    }
+    return (before_[j][i / 64] >> (i % 64)) & 1;
+  }
+
+ private:
+  const bool sequential_;
+  // before_[j]: the bit set of the ops that finish before op j starts
+  std::vector<std::vector<uint64_t>> before_;
+};
+
+struct BlobLifetime {
+  string name;
+  // first writer, and every op reading or writing the blob or a view of it
+  int first;
+  std::vector<int> accesses;
+  size_t bytes;
+  int data_type;
+  DeviceOption device;
+};
+
+// Blobs sharing one allocation, in the order they use it.
+struct SharedAllocation {
+  std::vector<BlobLifetime*> blobs;
+  size_t bytes;
+  // the accesses of the last blob that no other of its accesses follows
+  std::vector<int> last_accesses;
+};
+
+} // namespace
+
+NetDef share_blobs_by_lifetime(
+    const NetDef& net,
+    const std::set<string>& static_blobs,
+    const TensorShapes& shapes,
+    SharingStats* stats) {
+  SharingStats local_stats;
+  if (!stats) {
+    stats = &local_stats;
+  }
+  *stats = SharingStats();
+  for (const auto& op : net.op()) {
+    if (hasSubnets(op)) {
+      LOG(INFO) << "Cannot share blobs in nets with op type: " << op.type();
+      return net;
+    }
+  }
+
+  std::unordered_map<string, const TensorShape*> shape_of;
+  for (const auto& shape : shapes.shapes()) {
+    shape_of[shape.name()] = &shape;
+  }
+  auto find_shape = [&](const string& name) -> const TensorShape* {
+    auto it = shape_of.find(name);
+    if (it != shape_of.end() && !it->second->unknown_shape()) {
+      return it->second;
+    }
+    // Gradient ops rarely have shape inference.
+    const string suffix = "_grad";
+    if (name.size() > suffix.size() &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) ==
+            0) {
+      it = shape_of.find(name.substr(0, name.size() - suffix.size()));
+      if (it != shape_of.end() && !it->second->unknown_shape()) {
+        return it->second;
+      }
+    }
+    return nullptr;
+  };
+
+  std::set<string> fixed(static_blobs);
+  fixed.insert(net.external_input().begin(), net.external_input().end());
+  fixed.insert(net.external_output().begin(), net.external_output().end());
+
+  // Step 1: lifetimes, with views extending those of their source as in
+  // plan_inference_arena.
+  std::unordered_map<string, string> alias_of;
+  auto source = [&](const string& name) {
+    auto it = alias_of.find(name);
+    return it == alias_of.end() ? name : it->second;
+  };
+  std::unordered_map<string, size_t> index;
+  std::vector<BlobLifetime> blobs;
+  std::unordered_set<string> unplanned;
+  auto touch = [&](const string& name, int i) {
+    auto it = index.find(source(name));
+    if (it != index.end() && blobs[it->second].accesses.back() != i) {
+      blobs[it->second].accesses.push_back(i);
+    }
+  };
+  for (int i = 0; i < net.op_size(); i++) {
+    const auto& op = net.op(i);
+    for (const auto& inp : op.input()) {
+      if (!index.count(source(inp)) && !alias_of.count(inp)) {
+        unplanned.insert(inp);
+      }
+      touch(inp, i);
+    }
+    for (const auto& outp : op.output()) {
+      if (mayAliasInput(op) && op.input_size() > 0 && outp != op.input(0)) {
+        alias_of[outp] = source(op.input(0));
+        continue;
+      }
+      touch(outp, i);
+      if (index.count(outp) || unplanned.count(outp) || fixed.count(outp)) {
+        continue;
+      }
+      const auto* shape = find_shape(outp);
+      const size_t bytes = shape ? tensor_bytes(*shape) : 0;
+      if (bytes == 0) {
+        unplanned.insert(outp);
+        continue;
+      }
+      DeviceOption device = op.device_option();
+      // CopyGPUToCPU runs on the GPU but writes CPU blobs.
+      if (op.type() == "CopyGPUToCPU") {
+        device.set_device_type(CPU);
+        device.set_cuda_gpu_id(0);
+      }
+      index[outp] = blobs.size();
+      blobs.push_back(
+          BlobLifetime{outp, i, {i}, bytes, shape->data_type(), device});
+    }
+  }
+
+  // Step 2: give each blob, in the order they are first written, the
+  // allocation that fits it best among those it can take over.
+  const OpOrdering before(net);
+  std::vector<SharedAllocation> allocations;
+  for (auto& blob : blobs) {
+    SharedAllocation* best = nullptr;
+    for (auto& allocation : allocations) {
+      const auto* other = allocation.blobs.back();
+      if (other->data_type != blob.data_type ||
+          other->device.device_type() != blob.device.device_type() ||
+          other->device.cuda_gpu_id() != blob.device.cuda_gpu_id()) {
+        continue;
+      }
+      bool available = true;
+      for (int access : allocation.last_accesses) {
+        if (!before(access, blob.first)) {
+          available = false;
+          break;
+        }
+      }
+      if (!available) {
+        continue;
+      }
+      // The smallest that fits, or else the largest.
+      if (!best ||
+          (best->bytes < blob.bytes
+               ? allocation.bytes > best->bytes
+               : allocation.bytes >= blob.bytes &&
+                   allocation.bytes < best->bytes)) {
+        best = &allocation;
+      }
+    }
+    if (!best) {
+      allocations.emplace_back();
+      best = &allocations.back();
+      best->bytes = 0;
+    }
+    best->blobs.push_back(&blob);
+    best->bytes = std::max(best->bytes, blob.bytes);
+    best->last_accesses.clear();
+    for (int a : blob.accesses) {
+      bool last = true;
+      for (int b : blob.accesses) {
+        if (a != b && before(a, b)) {
+          last = false;
+          break;
+        }
+      }
+      if (last) {
+        best->last_accesses.push_back(a);
+      }
+    }
+    stats->bytes_before += blob.bytes;
+  }
+
+  // Step 3: rename the blobs of each allocation to its first one.
+  std::unordered_map<string, string> renaming;
+  for (const auto& allocation : allocations) {
+    stats->bytes_after += allocation.bytes;
+    for (size_t k = 1; k < allocation.blobs.size(); ++k) {
+      renaming[allocation.blobs[k]->name] = allocation.blobs[0]->name;
+    }
+  }
+  stats->blobs = blobs.size();
+  stats->shared_blobs = renaming.size();
+  NetDef optimized = net;
+  for (auto& op : *optimized.mutable_op()) {
+    for (int i = 0; i < op.input_size(); i++) {
+      auto it = renaming.find(op.input(i));
+      if (it != renaming.end()) {
+        op.set_input(i, it->second);
+      }
+    }
+    for (int i = 0; i < op.output_size(); i++) {
+      auto it = renaming.find(op.output(i));
+      if (it != renaming.end()) {
+        op.set_output(i, it->second);
+      }
+    }
+  }
+
+  LOG(INFO) << "shared " << stats->shared_blobs << " of " << stats->blobs
+            << " blobs: " << stats->bytes_before << " bytes before, "
+            << stats->bytes_after << " bytes after";
+  return optimized;
+}
+
 class ComputeBlobRecyclingForDag {
  public:
   explicit ComputeBlobRecyclingForDag(const int size)
@@ -1,6 +1,8 @@
 #ifndef CAFFE2_CORE_MEMONGER_H_
 #define CAFFE2_CORE_MEMONGER_H_
 
+#include <set>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "caffe2/core/common.h"
@@ -14,6 +16,55 @@ NetDef optimize_inference_net(
     const NetDef& net,
     const std::set<string>& static_blobs);
 
+// Placement of the intermediate blobs of a net in one contiguous arena.
+struct ArenaPlan {
+  // size in bytes of the arena
+  size_t arena_bytes = 0;
+  // blob name -> offset in bytes of the blob in the arena
+  std::unordered_map<string, size_t> offsets;
+};
+
+// Assigns every intermediate blob of an inference net an offset in a single
+// arena, given the shapes and types inferred for them. Blobs whose live
+// ranges (first to last op touching them) overlap get disjoint bytes; the
+// largest blobs are placed first, each in the smallest gap that fits it.
+// Static blobs, blobs of unknown shape or non POD type, and the outputs of
+// ops that may return a view of their input are not planned.
+ArenaPlan plan_inference_arena(
+    const NetDef& net,
+    const std::set<string>& static_blobs,
+    const TensorShapes& shapes,
+    size_t alignment = 64);
+
+// Memory of the intermediate blobs of a net before and after sharing.
+struct SharingStats {
+  // number of blobs planned, and of those renamed to share another's memory
+  int blobs = 0;
+  int shared_blobs = 0;
+  // total size in bytes of the planned blobs, each in its own allocation,
+  // and of the shared allocations
+  size_t bytes_before = 0;
+  size_t bytes_after = 0;
+};
+
+// Renames the intermediate blobs of a (training) net so that blobs with
+// disjoint lifetimes share an allocation, given the shapes and types inferred
+// for them. A blob can take over another's memory if every op touching the
+// other one finishes before the first op writing it starts: in net order for
+// simple nets and along the dependencies of the operator DAG (which the
+// chains of async nets follow) otherwise. Only blobs of the same type and
+// device share, and each blob picks the smallest free allocation it fits in
+// (or else grows the largest), so that large blobs are not mapped onto small
+// ones. Gradients of unknown shape take the shape of the blob they are the
+// gradient of. Static blobs, external inputs and outputs, blobs read before
+// being written (state between runs), blobs of unknown shape and views are
+// left alone.
+NetDef share_blobs_by_lifetime(
+    const NetDef& net,
+    const std::set<string>& static_blobs,
+    const TensorShapes& shapes,
+    SharingStats* stats = nullptr);
+
 NetDef compute_blob_recycling_for_dag(
     const NetDef& net,
     const std::vector<string>& heads,
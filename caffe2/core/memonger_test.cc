@@ -0,0 +1,190 @@
+#include "caffe2/core/memonger.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+OperatorDef makeOp(
+    const string& type,
+    const std::vector<string>& inputs,
+    const std::vector<string>& outputs) {
+  OperatorDef op;
+  op.set_type(type);
+  for (const auto& input : inputs) {
+    op.add_input(input);
+  }
+  for (const auto& output : outputs) {
+    op.add_output(output);
+  }
+  return op;
+}
+
+void addShape(TensorShapes* shapes, const string& name, int64_t numel) {
+  auto* shape = shapes->add_shapes();
+  shape->set_name(name);
+  shape->set_data_type(TensorProto::FLOAT);
+  shape->add_dims(numel);
+}
+
+} // namespace
+
+TEST(MemongerTest, PlanInferenceArenaReusesDeadBlobs) {
+  // x -> a -> b -> c -> y, where a is dead once b is computed
+  NetDef net;
+  *net.add_op() = makeOp("Relu", {"x"}, {"a"});
+  *net.add_op() = makeOp("Relu", {"a"}, {"b"});
+  *net.add_op() = makeOp("Relu", {"b"}, {"c"});
+  *net.add_op() = makeOp("Relu", {"c"}, {"y"});
+  TensorShapes shapes;
+  addShape(&shapes, "a", 100);
+  addShape(&shapes, "b", 10);
+  addShape(&shapes, "c", 50);
+  addShape(&shapes, "y", 100);
+
+  auto plan = memonger::plan_inference_arena(net, {"x", "y"}, shapes);
+  EXPECT_EQ(plan.offsets.size(), 3);
+  EXPECT_EQ(plan.offsets.count("y"), 0);
+  // a and c are never live together and share the start of the arena
+  EXPECT_EQ(plan.offsets["a"], 0);
+  EXPECT_EQ(plan.offsets["c"], 0);
+  EXPECT_EQ(plan.offsets["b"], 448);
+  EXPECT_EQ(plan.arena_bytes, 512);
+}
+
+TEST(MemongerTest, PlanInferenceArenaFillsGaps) {
+  // q dies after the second op, leaving a gap between p and r that s and t
+  // are placed in instead of at the end of the arena
+  NetDef net;
+  *net.add_op() = makeOp("Split", {"x"}, {"p", "q", "r"});
+  *net.add_op() = makeOp("Relu", {"q"}, {"unknown"});
+  *net.add_op() = makeOp("Relu", {"p"}, {"s"});
+  *net.add_op() = makeOp("Relu", {"s"}, {"t"});
+  *net.add_op() = makeOp("Sum", {"p", "r", "s", "t"}, {"y"});
+  TensorShapes shapes;
+  addShape(&shapes, "p", 128);
+  addShape(&shapes, "q", 64);
+  addShape(&shapes, "r", 48);
+  addShape(&shapes, "s", 32);
+  addShape(&shapes, "t", 16);
+
+  auto plan = memonger::plan_inference_arena(net, {"x", "y"}, shapes);
+  EXPECT_EQ(plan.offsets.count("unknown"), 0);
+  EXPECT_EQ(plan.offsets["p"], 0);
+  EXPECT_EQ(plan.offsets["q"], 512);
+  EXPECT_EQ(plan.offsets["r"], 768);
+  EXPECT_EQ(plan.offsets["s"], 512);
+  EXPECT_EQ(plan.offsets["t"], 640);
+  EXPECT_EQ(plan.arena_bytes, 960);
+}
+
+TEST(MemongerTest, PlanInferenceArenaKeepsViewsAlive) {
+  // r views a, so a must stay live until r's last use
+  NetDef net;
+  *net.add_op() = makeOp("Relu", {"x"}, {"a"});
+  *net.add_op() = makeOp("Reshape", {"a"}, {"r", "old_shape"});
+  *net.add_op() = makeOp("Relu", {"x"}, {"b"});
+  *net.add_op() = makeOp("Sum", {"r", "b"}, {"y"});
+  TensorShapes shapes;
+  addShape(&shapes, "a", 16);
+  addShape(&shapes, "r", 16);
+  addShape(&shapes, "b", 16);
+
+  auto plan = memonger::plan_inference_arena(net, {"x", "y"}, shapes);
+  EXPECT_EQ(plan.offsets.count("r"), 0);
+  ASSERT_EQ(plan.offsets.count("a"), 1);
+  ASSERT_EQ(plan.offsets.count("b"), 1);
+  EXPECT_NE(plan.offsets["a"], plan.offsets["b"]);
+}
+
+TEST(MemongerTest, PlanInferenceArenaSkipsAsyncNets) {
+  NetDef net;
+  net.set_type("dag");
+  *net.add_op() = makeOp("Relu", {"x"}, {"a"});
+  *net.add_op() = makeOp("Relu", {"a"}, {"y"});
+  TensorShapes shapes;
+  addShape(&shapes, "a", 16);
+
+  auto plan = memonger::plan_inference_arena(net, {"x", "y"}, shapes);
+  EXPECT_TRUE(plan.offsets.empty());
+  EXPECT_EQ(plan.arena_bytes, 0);
+}
+
+TEST(MemongerTest, ShareBlobsByLifetimeIsSizeAware) {
+  // a and b are dead once c is computed; d fits in b but not in a
+  NetDef net;
+  *net.add_op() = makeOp("Relu", {"x"}, {"a"});
+  *net.add_op() = makeOp("Relu", {"x"}, {"b"});
+  *net.add_op() = makeOp("Sum", {"a", "b"}, {"c"});
+  *net.add_op() = makeOp("Relu", {"c"}, {"d"});
+  *net.add_op() = makeOp("Relu", {"d"}, {"y"});
+  net.add_external_input("x");
+  net.add_external_output("y");
+  TensorShapes shapes;
+  addShape(&shapes, "a", 100);
+  addShape(&shapes, "b", 1000);
+  addShape(&shapes, "c", 10);
+  addShape(&shapes, "d", 900);
+  addShape(&shapes, "y", 900);
+
+  memonger::SharingStats stats;
+  auto optimized = memonger::share_blobs_by_lifetime(net, {}, shapes, &stats);
+  EXPECT_EQ(optimized.op(3).output(0), "b");
+  EXPECT_EQ(optimized.op(4).input(0), "b");
+  EXPECT_EQ(optimized.op(4).output(0), "y");
+  EXPECT_EQ(optimized.op(2).output(0), "c");
+  EXPECT_EQ(stats.blobs, 4);
+  EXPECT_EQ(stats.shared_blobs, 1);
+  EXPECT_EQ(stats.bytes_before, (100 + 1000 + 10 + 900) * 4);
+  EXPECT_EQ(stats.bytes_after, (100 + 1000 + 10) * 4);
+}
+
+TEST(MemongerTest, ShareBlobsByLifetimeFollowsDependencies) {
+  // Two branches, x -> a -> c and x -> b -> d. In net order d can take over
+  // a, but an async net may run the branches in parallel.
+  NetDef net;
+  *net.add_op() = makeOp("Relu", {"x"}, {"a"});
+  *net.add_op() = makeOp("Relu", {"x"}, {"b"});
+  *net.add_op() = makeOp("Relu", {"a"}, {"c"});
+  *net.add_op() = makeOp("Relu", {"b"}, {"d"});
+  *net.add_op() = makeOp("Sum", {"c", "d"}, {"y"});
+  net.add_external_input("x");
+  net.add_external_output("y");
+  TensorShapes shapes;
+  for (const auto& name : {"a", "b", "c", "d"}) {
+    addShape(&shapes, name, 16);
+  }
+
+  auto optimized = memonger::share_blobs_by_lifetime(net, {}, shapes);
+  EXPECT_EQ(optimized.op(3).output(0), "a");
+
+  net.set_type("async_scheduling");
+  memonger::SharingStats stats;
+  optimized = memonger::share_blobs_by_lifetime(net, {}, shapes, &stats);
+  EXPECT_EQ(stats.shared_blobs, 0);
+  EXPECT_EQ(optimized.op(3).output(0), "d");
+  EXPECT_EQ(stats.bytes_after, stats.bytes_before);
+}
+
+TEST(MemongerTest, ShareBlobsByLifetimeUsesForwardShapesForGradients) {
+  // fc_grad has no inferred shape but fc does; state is read before being
+  // written, so it is kept
+  NetDef net;
+  *net.add_op() = makeOp("Relu", {"x", "state"}, {"fc"});
+  *net.add_op() = makeOp("Relu", {"fc"}, {"loss"});
+  *net.add_op() = makeOp("ReluGradient", {"loss"}, {"fc_grad"});
+  *net.add_op() = makeOp("ReluGradient", {"fc_grad", "state"}, {"state"});
+  net.add_external_input("x");
+  TensorShapes shapes;
+  addShape(&shapes, "fc", 16);
+  addShape(&shapes, "loss", 16);
+
+  memonger::SharingStats stats;
+  auto optimized = memonger::share_blobs_by_lifetime(net, {}, shapes, &stats);
+  EXPECT_EQ(stats.blobs, 3);
+  EXPECT_EQ(optimized.op(2).output(0), "fc");
+  EXPECT_EQ(optimized.op(3).output(0), "state");
+}
+
+} // namespace caffe2
@@ -1,7 +1,9 @@
 #include "caffe2/core/net_async_polling.h"
 
 #include "caffe2/core/operator.h"
+#include "caffe2/core/static_tracepoint.h"
 #include "caffe2/core/timer.h"
+#include "caffe2/utils/lock_free_thread_pool.h"
 
 CAFFE2_DEFINE_int(
     caffe2_streams_per_gpu,
@@ -30,11 +32,35 @@ CAFFE2_DEFINE_int(
     0,
     "Number of threads in CPU pool by default");
 
+CAFFE2_DEFINE_string(
+    caffe2_net_async_cpu_pool_type,
+    "CPU",
+    "ThreadPoolRegistry key of the CPU pools: CPU (priority queue) or "
+    "CPU_LOCK_FREE (lock-free FIFO ring, ignores task priorities)");
+
 CAFFE2_DEFINE_bool(
     caffe2_net_async_check_stream_status,
     true,
     "Select next non-busy stream");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_skip_metadata_waits,
+    true,
+    "Don't wait for the parents of ops that only read the shapes of their "
+    "inputs, e.g. Shape or Size after a GPU op");
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_comm_overlap,
+    true,
+    "Run communication ops (e.g. Allreduce) in a dedicated pool and a "
+    "dedicated GPU stream, ahead of compute, so they overlap with it");
+
+CAFFE2_DEFINE_int(
+    caffe2_net_async_comm_pool_size,
+    0,
+    "Number of threads in the communication pool of a net; by default one "
+    "per communication task, since collectives block until all peers join");
+
 namespace caffe2 {
 
 thread_local std::vector<int> AsyncNetBase::stream_counters_;
@@ -59,6 +85,17 @@ AsyncNetBase::AsyncNetBase(
   }
   chain_nodes_ = dag_utils::prepareChainGraphNodes(operator_nodes_, chains_);
 
+  parents_to_wait_.resize(chains_.size());
+  for (auto task_id = 0; task_id < chains_.size(); ++task_id) {
+    for (auto parent_id : parents(task_id)) {
+      if (!FLAGS_caffe2_net_async_skip_metadata_waits ||
+          !dag_utils::dependsOnlyOnMetadata(
+              operator_nodes_, chains_[parent_id], chains_[task_id])) {
+        parents_to_wait_[task_id].push_back(parent_id);
+      }
+    }
+  }
+
   events_.reserve(chains_.size());
   for (const auto& chain : chains_) {
     const auto& op = operators_[chain.back()];
@@ -66,6 +103,23 @@ AsyncNetBase::AsyncNetBase(
   }
 
   num_workers_ = net_def->has_num_workers() ? net_def->num_workers() : -1;
+
+  // chains never mix communication and compute ops (see computeChains)
+  comm_tasks_.assign(chains_.size(), false);
+  int comm_tasks_num = 0;
+  if (FLAGS_caffe2_net_async_comm_overlap) {
+    for (auto task_id = 0; task_id < chains_.size(); ++task_id) {
+      comm_tasks_[task_id] =
+          operators_[chains_[task_id].front()]->IsCommunicationOp();
+      comm_tasks_num += comm_tasks_[task_id];
+    }
+  }
+  if (comm_tasks_num > 0) {
+    auto comm_pool_size = FLAGS_caffe2_net_async_comm_pool_size > 0
+        ? FLAGS_caffe2_net_async_comm_pool_size
+        : comm_tasks_num;
+    comm_pool_ = std::make_shared<TaskThreadPool>(comm_pool_size);
+  }
 }
 
 std::shared_ptr<TaskThreadPool> AsyncNetBase::pool_getter(
@@ -76,8 +130,10 @@ std::shared_ptr<TaskThreadPool> AsyncNetBase::pool_getter(
   std::unique_lock<std::mutex> pools_lock(pools_mutex_);
   auto pool = pools[device_id][pool_size];
   if (!pool) {
-    pool = ThreadPoolRegistry()->Create(
-        DeviceTypeName(device_type), device_id, pool_size);
+    auto pool_type = device_type == CPU ? FLAGS_caffe2_net_async_cpu_pool_type
+                                        : DeviceTypeName(device_type);
+    pool = ThreadPoolRegistry()->Create(pool_type, device_id, pool_size);
+    CAFFE_ENFORCE(pool, "Unknown thread pool type: " + pool_type);
     pools[device_id][pool_size] = pool;
   }
   return pool;
@@ -105,12 +161,28 @@ std::shared_ptr<TaskThreadPool> AsyncNetBase::pool(
   }
 }
 
+std::shared_ptr<TaskThreadPool> AsyncNetBase::taskPool(int task_id) {
+  if (isCommTask(task_id)) {
+    return comm_pool_;
+  }
+  return pool(event(task_id).GetDeviceOption());
+}
+
+bool AsyncNetBase::isCommTask(int task_id) const {
+  return comm_tasks_[task_id];
+}
+
 int AsyncNetBase::stream(int task_id) {
   const auto& device_option = event(task_id).GetDeviceOption();
   int stream_id = 0;
   if (device_option.device_type() == CUDA) {
     int gpu_id = device_option.cuda_gpu_id();
     CAFFE_ENFORCE_GE(gpu_id, 0, "Invalid gpu id: " + caffe2::to_string(gpu_id));
+    if (isCommTask(task_id)) {
+      // a stream outside of the compute streams' rotation; streams are per
+      // thread, so concurrent collectives still get separate streams
+      return FLAGS_caffe2_streams_per_gpu;
+    }
     if (gpu_id >= stream_counters_.size()) {
       stream_counters_.resize(gpu_id + 1, 0);
     }
@@ -133,7 +205,7 @@ bool AsyncNetBase::canSchedule(
     int task_id,
     const std::vector<EventStatus>* status) {
   auto first_child_op_id = chains_[task_id].front();
-  for (auto parent_id : parents(task_id)) {
+  for (auto parent_id : parentsToWait(task_id)) {
     auto last_parent_op_id = chains_[parent_id].back();
     EventStatus parent_status;
     if (status) {
@@ -178,6 +250,10 @@ const std::vector<int>& AsyncNetBase::parents(int task_id) const {
   return task_node.parents_;
 }
 
+const std::vector<int>& AsyncNetBase::parentsToWait(int task_id) const {
+  return parents_to_wait_[task_id];
+}
+
 void AsyncNetBase::asyncWait(
     int task_id,
     int stream_id,
@@ -194,10 +270,14 @@ void AsyncNetBase::asyncWait(
 
 void AsyncNetBase::run(int task_id, int stream_id) {
   std::string err_msg;
+  CAFFE_SDT(async_net_task_start, Name().c_str(), task_id, stream_id);
   for (auto& op_id : chains_[task_id]) {
     auto& op = operators_[op_id];
+    const char* op_type = op->has_debug_def() ? op->type().c_str() : "";
     try {
+      CAFFE_SDT(async_net_op_start, Name().c_str(), op_type, op_id, stream_id);
       CAFFE_ENFORCE(op->RunAsync(stream_id), "Failed to execute an op");
+      CAFFE_SDT(async_net_op_end, Name().c_str(), op_type, op_id, stream_id);
     } catch (const std::exception& e) {
       CAFFE_THROW(
           std::string(e.what()) + ",  op " +
@@ -212,6 +292,7 @@ void AsyncNetBase::run(int task_id, int stream_id) {
   if (FLAGS_caffe2_net_async_finish_chain) {
     operators_[chains_[task_id].back()]->event().Finish();
   }
+  CAFFE_SDT(async_net_task_end, Name().c_str(), task_id, stream_id);
 }
 
 void AsyncNetBase::finishTasks(const std::unordered_set<int>& task_ids) {
@@ -237,8 +318,17 @@ CAFFE_DEFINE_SHARED_REGISTRY(ThreadPoolRegistry, TaskThreadPool, int, int);
 
 CAFFE_REGISTER_CREATOR(ThreadPoolRegistry, CPU, GetAsyncNetCPUThreadPool);
 
-/* static */
-std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
+CAFFE_REGISTER_CREATOR(
+    ThreadPoolRegistry,
+    CPU_LOCK_FREE,
+    GetAsyncNetCPULockFreeThreadPool);
+
+namespace {
+
+// Returns the pool of the given NUMA node and size, creating it if there is
+// none alive. Pools of each type are cached separately.
+template <typename Pool>
+std::shared_ptr<TaskThreadPool> GetCPUThreadPool(
     int numa_node_id,
     int pool_size) {
   // Note: numa_node_id = -1 (DeviceOption's default value) corresponds to
@@ -270,10 +360,26 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
   if (!shared_pool) {
     LOG(INFO) << "Created CPU pool, size: " << pool_size
               << "; NUMA node id: " << numa_node_id;
-    shared_pool = std::make_shared<TaskThreadPool>(pool_size, numa_node_id);
+    shared_pool = std::make_shared<Pool>(pool_size, numa_node_id);
     pools[numa_node_id][pool_size] = shared_pool;
   }
   return shared_pool;
 }
 
+} // namespace
+
+/* static */
+std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
+    int numa_node_id,
+    int pool_size) {
+  return GetCPUThreadPool<TaskThreadPool>(numa_node_id, pool_size);
+}
+
+/* static */
+std::shared_ptr<TaskThreadPool> GetAsyncNetCPULockFreeThreadPool(
+    int numa_node_id,
+    int pool_size) {
+  return GetCPUThreadPool<LockFreeTaskThreadPool>(numa_node_id, pool_size);
+}
+
 } // namespace caffe2
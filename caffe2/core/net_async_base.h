@@ -39,6 +39,9 @@ class AsyncNetBase : public NetBase {
   EventStatus query(int task_id) const;
   const std::vector<int>& children(int task_id) const;
   const std::vector<int>& parents(int task_id) const;
+  // The parents whose events the task waits for: all of them, except those
+  // it only reads the shapes of (see dag_utils::dependsOnlyOnMetadata)
+  const std::vector<int>& parentsToWait(int task_id) const;
   void asyncWait(
       int task_id,
       int stream_id,
@@ -46,6 +49,10 @@ class AsyncNetBase : public NetBase {
   void run(int task_id, int stream_id);
   int stream(int task_id);
   std::shared_ptr<TaskThreadPool> pool(const DeviceOption& device_option);
+  // The pool to run the task in: the communication pool for communication
+  // tasks, the pool of the task's device otherwise
+  std::shared_ptr<TaskThreadPool> taskPool(int task_id);
+  bool isCommTask(int task_id) const;
 
   void finishTasks(const std::unordered_set<int>& task_ids);
   void finalizeEvents();
@@ -57,6 +64,7 @@ class AsyncNetBase : public NetBase {
   std::vector<dag_utils::OperatorNode> operator_nodes_;
   std::vector<std::vector<int>> chains_;
   std::vector<dag_utils::OpGraphNode> chain_nodes_; // chains' parents/children
+  std::vector<std::vector<int>> parents_to_wait_;
 
   // Pools and streams
   std::mutex pools_mutex_;
@@ -69,6 +77,10 @@ class AsyncNetBase : public NetBase {
   PoolsMap gpu_pools_;
   static thread_local std::vector<int> stream_counters_;
   int num_workers_;
+  // Tasks made of communication ops, and the net's own pool for them, so
+  // that blocking collectives don't hold the device pools' threads
+  std::vector<bool> comm_tasks_;
+  std::shared_ptr<TaskThreadPool> comm_pool_;
 
   DISABLE_COPY_AND_ASSIGN(AsyncNetBase);
 
@@ -99,6 +111,10 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
     int numa_node_id,
     int pool_size);
 
+std::shared_ptr<TaskThreadPool> GetAsyncNetCPULockFreeThreadPool(
+    int numa_node_id,
+    int pool_size);
+
 } // namespace caffe2
 
 #endif // CAFFE2_CORE_NET_ASYNC_POLLING_H_
@@ -24,6 +24,13 @@ CAFFE2_DEFINE_bool(
     false,
     "Use multiple streams per thread");
 
+CAFFE2_DEFINE_bool(
+    caffe2_async_dag_requeue_blocked_chains,
+    true,
+    "Put back in the queue the chains whose first op would block its worker "
+    "waiting for the events of its parents (e.g. a CPU op after GPU ops), "
+    "and run the chains after them first");
+
 CAFFE2_DECLARE_bool(caffe2_dag_net_collect_stats);
 
 CAFFE2_DECLARE_bool(caffe2_net_async_finish_chain);
@@ -32,6 +39,8 @@ CAFFE2_DECLARE_int(caffe2_streams_per_gpu);
 
 CAFFE2_DECLARE_bool(caffe2_net_async_check_stream_status);
 
+CAFFE2_DECLARE_bool(caffe2_net_async_skip_metadata_waits);
+
 namespace caffe2 {
 
 thread_local std::vector<int> AsyncDAGNet::stream_counters_;
@@ -95,13 +104,30 @@ AsyncDAGNet::AsyncDAGNet(
   VLOG(1) << "Constructing Async DAG Net " << net_def->name();
   eventRecorded_.resize(net_def->op_size());
 
+  parents_to_wait_.resize(operator_nodes_.size());
+  // ops some chain doesn't wait for, whose events Run() has to wait for
+  std::unordered_set<int> skipped_parents;
+  for (const auto& chain : execution_chains_) {
+    const int head_op_idx = chain.first;
+    for (auto parent_idx : operator_nodes_[head_op_idx].parents_) {
+      if (FLAGS_caffe2_net_async_skip_metadata_waits &&
+          dag_utils::dependsOnlyOnMetadata(
+              operator_nodes_, {parent_idx}, chain.second)) {
+        skipped_parents.insert(parent_idx);
+      } else {
+        parents_to_wait_[head_op_idx].push_back(parent_idx);
+      }
+    }
+  }
+
   // For all chains, their tail should consist the list of events that we are
   // needing for synchronization in the Run() inteface, unless there are other
   // chains depending on it.
   events_.reserve(execution_chains_.size());
   for (const auto& chain : execution_chains_) {
     const int tail_op_idx = chain.second.back();
-    if (operator_nodes_[tail_op_idx].children_.empty()) {
+    if (operator_nodes_[tail_op_idx].children_.empty() ||
+        skipped_parents.count(tail_op_idx)) {
       events_.push_back(&operator_nodes_[tail_op_idx].operator_->event());
     }
   }
@@ -147,8 +173,8 @@ bool AsyncDAGNet::RunAt(int chain_id, const std::vector<int>& chain) {
   }
 
   std::vector<const Event*> parent_events;
-  parent_events.reserve(operator_nodes_[source_idx].parents_.size());
-  for (auto source_parent_idx : operator_nodes_[source_idx].parents_) {
+  parent_events.reserve(parents_to_wait_[source_idx].size());
+  for (auto source_parent_idx : parents_to_wait_[source_idx]) {
     parent_events.push_back(
         &operator_nodes_[source_parent_idx].operator_->event());
   }
@@ -196,6 +222,27 @@ bool AsyncDAGNet::RunAt(int chain_id, const std::vector<int>& chain) {
   return success;
 }
 
+bool AsyncDAGNet::CanRunWithoutBlocking(int chain_id) {
+  if (!FLAGS_caffe2_async_dag_requeue_blocked_chains) {
+    return true;
+  }
+  // a waiting op blocks only on the parents still running on their device;
+  // the failed ones are reported by WaitEvents
+  const auto& op = operator_nodes_[chain_id].operator_;
+  for (auto parent_idx : parents_to_wait_[chain_id]) {
+    const auto& parent_event = operator_nodes_[parent_idx].operator_->event();
+    if (!Event::CanSchedule(
+            parent_event.GetType(),
+            EventStatus::EVENT_SCHEDULED,
+            op->event().GetType(),
+            op->SupportsAsyncScheduling()) &&
+        parent_event.Query() == EventStatus::EVENT_SCHEDULED) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool AsyncDAGNet::DoRunAsync() {
   // Reset the event tracking at each iteration
   eventRecorded_.assign(eventRecorded_.size(), 0);
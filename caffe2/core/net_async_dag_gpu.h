@@ -24,6 +24,12 @@ class AsyncDAGNet : public DAGNetBase {
 
  protected:
   bool DoRunAsync() override;
+  bool CanRunWithoutBlocking(int chain_id) override;
+
+  // For the first op of each chain, its parents whose events it waits for:
+  // all of them, except those it only reads the shapes of (see
+  // dag_utils::dependsOnlyOnMetadata)
+  std::vector<std::vector<int>> parents_to_wait_;
 
   // Tracks whether a given op has had an event recorded in each
   // RunAt() iteration.
@@ -54,7 +54,7 @@ void AsyncPollingNet::schedule(int task_id) {
     task_timers_[task_id]->Start();
   }
   const auto& device_option = event(task_id).GetDeviceOption();
-  pool(device_option)->run([this, task_id, device_option]() {
+  taskPool(task_id)->run([this, task_id, device_option]() {
     int stream_id = stream(task_id);
 
     if (FLAGS_caffe2_dag_net_collect_stats) {
@@ -68,7 +68,7 @@ void AsyncPollingNet::schedule(int task_id) {
     // canSchedule ensures that there's no busy wait,
     // for CUDA events we need to insert CUDA event synchronization to ensure
     // that async CUDA computations are executed in correct order
-    asyncWait(task_id, stream_id, parents(task_id));
+    asyncWait(task_id, stream_id, parentsToWait(task_id));
     try {
       if (FLAGS_caffe2_dag_net_collect_stats) {
         Timer run_time;
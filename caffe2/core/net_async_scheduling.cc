@@ -1,19 +1,137 @@
 #include "caffe2/core/net_async_scheduling.h"
 
+#include <algorithm>
+#include <numeric>
+
+#include "caffe2/core/operator.h"
+
 CAFFE2_DEFINE_bool(
     caffe2_net_async_always_schedule_child,
     false,
     "Always schedule child chains from parent chain");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_scheduling_priority,
+    true,
+    "Run the chains on the critical path first, with chain costs from cost "
+    "inference and then from the runtimes of the previous run");
+
 namespace caffe2 {
 
 AsyncSchedulingNet::AsyncSchedulingNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
-    : AsyncNetBase(net_def, ws), running_(false) {
+    : AsyncNetBase(net_def, ws),
+      running_(false),
+      costs_measured_(false),
+      has_run_(false) {
+  task_costs_.resize(tasksNum());
+  task_runtimes_.assign(tasksNum(), 0);
+  task_priorities_.assign(tasksNum(), 0);
+  if (FLAGS_caffe2_net_async_scheduling_priority) {
+    for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+      task_costs_[task_id] = estimateTaskCost(task_id, ws);
+    }
+    computePriorities();
+  }
   reset();
 }
 
+// Sum of the FLOPs of the chain's operators, for the operators that have a
+// cost inference function and whose inputs already exist (e.g. parameters
+// and external inputs); every other operator counts as the average of those.
+float AsyncSchedulingNet::estimateTaskCost(int task_id, Workspace* ws) const {
+  std::vector<float> op_costs;
+  int unknown = 0;
+  for (auto op_id : chains_[task_id]) {
+    const auto& def = operators_[op_id]->debug_def();
+    const auto* schema = OpSchemaRegistry::Schema(def.type());
+    bool known = schema && schema->HasCostInferenceFunction();
+    std::vector<TensorShape> shapes;
+    for (const auto& input : def.input()) {
+      const Blob* blob = known ? ws->GetBlob(input) : nullptr;
+      if (!blob) {
+        known = false;
+        break;
+      }
+      shapes.push_back(GetTensorShapeOfBlob(blob));
+      known = known && !shapes.back().unknown_shape();
+    }
+    if (known) {
+      try {
+        op_costs.push_back(schema->InferCost(def, shapes).flops);
+        continue;
+      } catch (const std::exception&) {
+      }
+    }
+    unknown++;
+  }
+  float known_cost = std::accumulate(op_costs.begin(), op_costs.end(), 0.f);
+  float default_cost = op_costs.empty() ? 1.f : known_cost / op_costs.size();
+  return known_cost + unknown * std::max(default_cost, 1.f);
+}
+
+void AsyncSchedulingNet::computePriorities() {
+  // longest path from every task to the end of the net, visiting children
+  // before parents
+  std::vector<float> path_cost(tasksNum(), 0);
+  std::vector<int> pending_children(tasksNum());
+  std::vector<int> ready;
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    pending_children[task_id] = children(task_id).size();
+    if (pending_children[task_id] == 0) {
+      ready.push_back(task_id);
+    }
+  }
+  while (!ready.empty()) {
+    auto task_id = ready.back();
+    ready.pop_back();
+    float longest_child = 0;
+    for (auto child_id : children(task_id)) {
+      longest_child = std::max(longest_child, path_cost[child_id]);
+    }
+    path_cost[task_id] = task_costs_[task_id] + longest_child;
+    for (auto parent_id : parents(task_id)) {
+      if (--pending_children[parent_id] == 0) {
+        ready.push_back(parent_id);
+      }
+    }
+  }
+
+  // ranks rather than costs, so that priorities are comparable between the
+  // nets sharing a pool
+  std::vector<int> order(tasksNum());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return path_cost[a] < path_cost[b];
+  });
+  for (size_t rank = 0; rank < order.size(); ++rank) {
+    task_priorities_[order[rank]] = rank;
+  }
+  // communication goes ahead of all compute once its inputs are ready, so
+  // that it overlaps with the rest of the net instead of trailing it
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    if (isCommTask(task_id)) {
+      task_priorities_[task_id] += tasksNum();
+    }
+  }
+}
+
+int64_t AsyncSchedulingNet::priority(int task_id) const {
+  return task_priorities_[task_id];
+}
+
+void AsyncSchedulingNet::updateTaskCosts() {
+  // measured runtimes replace the estimates, averaged with the earlier runs
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    task_costs_[task_id] = costs_measured_
+        ? 0.5f * (task_costs_[task_id] + task_runtimes_[task_id])
+        : task_runtimes_[task_id];
+  }
+  costs_measured_ = true;
+  computePriorities();
+}
+
 void AsyncSchedulingNet::reset() {
   processed_tasks_num_ = 0;
   cleanup_ = false;
@@ -35,13 +153,14 @@ void AsyncSchedulingNet::Wait() {
 }
 
 void AsyncSchedulingNet::schedule(int task_id) {
-  const auto& device_option = event(task_id).GetDeviceOption();
-  pool(device_option)->run([this, task_id]() {
+  taskPool(task_id)->runWithPriority([this, task_id]() {
     if (success_) {
       int stream_id = stream(task_id);
-      asyncWait(task_id, stream_id, parents(task_id));
+      asyncWait(task_id, stream_id, parentsToWait(task_id));
       try {
+        Timer timer;
         run(task_id, stream_id);
+        task_runtimes_[task_id] = timer.MicroSeconds();
       } catch (const std::exception& e) {
         std::unique_lock<std::mutex> lock(exception_mutex_);
         exception_messages_.push_back(e.what());
@@ -58,10 +177,11 @@ void AsyncSchedulingNet::schedule(int task_id) {
             canSchedule(child_id)) {
           schedule(child_id);
         } else {
-          const auto& device_option = event(child_id).GetDeviceOption();
-          pool(device_option)
-              ->run(std::bind(
-                  &AsyncSchedulingNet::pollAndSchedule, this, child_id));
+          taskPool(child_id)
+              ->runWithPriority(
+                  std::bind(
+                      &AsyncSchedulingNet::pollAndSchedule, this, child_id),
+                  priority(child_id));
         }
       }
     }
@@ -99,7 +219,7 @@ void AsyncSchedulingNet::schedule(int task_id) {
       // Notify observers and waiters
       finishRun();
     }
-  });
+  }, priority(task_id));
 }
 
 void AsyncSchedulingNet::pollAndSchedule(int task_id) {
@@ -107,9 +227,10 @@ void AsyncSchedulingNet::pollAndSchedule(int task_id) {
     // force schedule the rest of the tasks if cleanup is started
     schedule(task_id);
   } else {
-    const auto& device_option = event(task_id).GetDeviceOption();
-    pool(device_option)
-        ->run(std::bind(&AsyncSchedulingNet::pollAndSchedule, this, task_id));
+    taskPool(task_id)
+        ->runWithPriority(
+            std::bind(&AsyncSchedulingNet::pollAndSchedule, this, task_id),
+            priority(task_id));
   }
 }
 
@@ -132,6 +253,10 @@ bool AsyncSchedulingNet::DoRunAsync() {
   std::unique_lock<std::mutex> lock(running_mutex_);
   CAFFE_ENFORCE(!running_, "Concurrent RunAsync calls");
   running_ = true;
+  if (FLAGS_caffe2_net_async_scheduling_priority && has_run_ && success_) {
+    updateTaskCosts();
+  }
+  has_run_ = true;
   reset();
 
   StartAllObservers();
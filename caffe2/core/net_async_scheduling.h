@@ -23,6 +23,14 @@ class AsyncSchedulingNet : public AsyncNetBase {
   virtual void finishRun();
   int updateParentCount(int child_id);
 
+  // Critical path scheduling: a task's priority is the rank of its longest
+  // remaining path (its own cost plus the costliest chain of descendants),
+  // so that the pools run the longest chains first when they are busy.
+  void computePriorities();
+  void updateTaskCosts();
+  float estimateTaskCost(int task_id, Workspace* ws) const;
+  int64_t priority(int task_id) const;
+
   std::mutex running_mutex_;
   std::condition_variable running_cv_;
   std::atomic<bool> running_;
@@ -35,6 +43,14 @@ class AsyncSchedulingNet : public AsyncNetBase {
   std::mutex exception_mutex_;
   std::vector<std::string> exception_messages_;
 
+  // estimated cost of every task, replaced by measured runtimes (in
+  // microseconds) once a run completes
+  std::vector<float> task_costs_;
+  std::vector<float> task_runtimes_;
+  std::vector<int64_t> task_priorities_;
+  bool costs_measured_;
+  bool has_run_;
+
   DISABLE_COPY_AND_ASSIGN(AsyncSchedulingNet);
 };
 
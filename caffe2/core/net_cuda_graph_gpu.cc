@@ -0,0 +1,260 @@
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/net_simple.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <unordered_set>
+
+namespace caffe2 {
+
+namespace {
+
+// A net of CUDA ops on one GPU, which runs like a simple net and then
+// replays as a CUDA graph: once the warmup runs allocated its blobs, a run is
+// captured on the stream of the ops, and the next runs are a single graph
+// launch as long as every blob of the net keeps its data and shape. A blob
+// that changes, e.g. an input fed with another shape, makes the net run
+// eagerly for the warmup runs again before it is captured again.
+//
+// The replays only repeat the device work of the capture: nets whose ops do
+// host work every run (CPU ops, host synchronization, random number
+// generation, host state) must not use this net. The capture of ops that
+// synchronize with the host fails, and the net then keeps running as a simple
+// net.
+//
+// Arguments of the net:
+//   cuda_graph_warmup_runs (default 1): eager runs before each capture
+class CudaGraphNet : public SimpleNet {
+ public:
+  CudaGraphNet(const std::shared_ptr<const NetDef>& net_def, Workspace* ws);
+  ~CudaGraphNet() override;
+
+ protected:
+  bool Run() override;
+
+ private:
+  struct BlobState {
+    const void* data;
+    vector<TIndex> dims;
+
+    bool operator==(const BlobState& other) const {
+      return data == other.data && dims == other.dims;
+    }
+  };
+
+  bool Capture();
+  bool Replay();
+  void ReleaseGraph();
+  // The state of the blobs, or false if some are on the CPU
+  bool GetBlobStates(vector<BlobState>* states) const;
+
+  bool capturable_ = true;
+  int gpu_id_ = 0;
+  int warmup_runs_ = 1;
+  int eager_runs_ = 0;
+  vector<const Blob*> blobs_;
+  vector<BlobState> captured_states_;
+#if CUDART_VERSION >= 10010
+  cudaGraphExec_t graph_exec_ = nullptr;
+#endif
+  int graph_memory_ = 0;
+
+  DISABLE_COPY_AND_ASSIGN(CudaGraphNet);
+};
+
+CudaGraphNet::CudaGraphNet(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws)
+    : SimpleNet(net_def, ws) {
+  for (const auto& arg : net_def->arg()) {
+    if (arg.name() == "cuda_graph_warmup_runs") {
+      warmup_runs_ = arg.i();
+    }
+  }
+  CAFFE_ENFORCE_GE(warmup_runs_, 1, "A run must allocate the blobs first");
+#if CUDART_VERSION >= 10010
+  std::unordered_set<const Blob*> seen;
+  for (int i = 0; i < operators_.size(); ++i) {
+    const auto& option = operators_[i]->device_option();
+    if (option.device_type() != CUDA ||
+        (i > 0 &&
+         !IsSameDevice(option, operators_[0]->device_option()))) {
+      LOG(WARNING) << "Net " << name_ << " has ops which are not on the GPU "
+                   << "of its first op, running it as a simple net.";
+      capturable_ = false;
+      return;
+    }
+    for (const auto* blob : operators_[i]->Inputs()) {
+      if (seen.insert(blob).second) {
+        blobs_.push_back(blob);
+      }
+    }
+    for (const auto* blob : operators_[i]->Outputs()) {
+      if (seen.insert(blob).second) {
+        blobs_.push_back(blob);
+      }
+    }
+  }
+  if (operators_.empty()) {
+    capturable_ = false;
+    return;
+  }
+  gpu_id_ = operators_[0]->device_option().cuda_gpu_id();
+#else
+  LOG(WARNING) << "CUDA graphs require CUDA 10.1, running net " << name_
+               << " as a simple net.";
+  capturable_ = false;
+#endif
+}
+
+CudaGraphNet::~CudaGraphNet() {
+  ReleaseGraph();
+}
+
+bool CudaGraphNet::GetBlobStates(vector<BlobState>* states) const {
+  states->clear();
+  states->reserve(blobs_.size());
+  for (const auto* blob : blobs_) {
+    if (blob->IsType<TensorCPU>()) {
+      return false;
+    }
+    if (blob->IsType<TensorCUDA>()) {
+      const auto& tensor = blob->Get<TensorCUDA>();
+      states->push_back(
+          {tensor.size() > 0 ? tensor.raw_data() : nullptr, tensor.dims()});
+    } else {
+      states->push_back({blob->GetRaw(), {}});
+    }
+  }
+  return true;
+}
+
+bool CudaGraphNet::Run() {
+  if (!capturable_) {
+    return SimpleNet::Run();
+  }
+  DeviceGuard guard(gpu_id_);
+#if CUDART_VERSION >= 10010
+  if (graph_exec_) {
+    vector<BlobState> states;
+    if (GetBlobStates(&states) && states == captured_states_) {
+      return Replay();
+    }
+    VLOG(1) << "The blobs of net " << name_ << " changed, capturing it again";
+    ReleaseGraph();
+  }
+#endif
+  if (eager_runs_ < warmup_runs_) {
+    ++eager_runs_;
+    return SimpleNet::Run();
+  }
+  if (!Capture()) {
+    return SimpleNet::Run();
+  }
+  return Replay();
+}
+
+bool CudaGraphNet::Capture() {
+#if CUDART_VERSION >= 10010
+  if (!GetBlobStates(&captured_states_)) {
+    LOG(WARNING) << "Net " << name_ << " uses CPU blobs, running it as a "
+                 << "simple net.";
+    capturable_ = false;
+    return false;
+  }
+  VLOG(1) << "Capturing net " << name_ << " into a CUDA graph";
+  cudaStream_t stream = CUDAContext::cuda_stream(gpu_id_, 0);
+  graph_memory_ = CUDAContext::BeginGraphCapture();
+  // Relaxed, since ops may call cudaMalloc
+  cudaError_t err = cudaStreamBeginCapture(stream, cudaStreamCaptureModeRelaxed);
+  bool captured = err == cudaSuccess;
+  std::string error;
+  if (captured) {
+    try {
+      for (auto& op : operators_) {
+        // Without the host synchronization of Run
+        if (!op->RunAsync(0)) {
+          error = "operator " + op->debug_def().type() + " failed";
+          captured = false;
+          break;
+        }
+      }
+    } catch (const std::exception& e) {
+      error = e.what();
+      captured = false;
+    }
+    cudaGraph_t graph = nullptr;
+    cudaError_t end_err = cudaStreamEndCapture(stream, &graph);
+    if (captured && end_err == cudaSuccess) {
+#if CUDART_VERSION >= 12000
+      err = cudaGraphInstantiate(&graph_exec_, graph, 0);
+#else
+      err = cudaGraphInstantiate(&graph_exec_, graph, nullptr, nullptr, 0);
+#endif
+    } else if (end_err != cudaSuccess) {
+      err = end_err;
+    }
+    if (graph) {
+      cudaGraphDestroy(graph);
+    }
+  }
+  CUDAContext::EndGraphCapture();
+  // The events recorded by RunAsync are not used by this net
+  for (auto& op : operators_) {
+    op->ResetEvent();
+  }
+  if (!captured || err != cudaSuccess) {
+    if (error.empty()) {
+      error = cudaGetErrorString(err);
+    }
+    // clear the error of the capture
+    cudaGetLastError();
+    graph_exec_ = nullptr;
+    CUDAContext::ReleaseGraphMemory(graph_memory_);
+    graph_memory_ = 0;
+    LOG(WARNING) << "Net " << name_ << " can't be captured into a CUDA graph ("
+                 << error << "), running it as a simple net.";
+    capturable_ = false;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool CudaGraphNet::Replay() {
+#if CUDART_VERSION >= 10010
+  StartAllObservers();
+  cudaStream_t stream = CUDAContext::cuda_stream(gpu_id_, 0);
+  CUDA_ENFORCE(cudaGraphLaunch(graph_exec_, stream));
+  // Like the ops of a simple net, the run is done on return
+  CUDA_ENFORCE(cudaStreamSynchronize(stream));
+  StopAllObservers();
+  return true;
+#else
+  return false;
+#endif
+}
+
+void CudaGraphNet::ReleaseGraph() {
+#if CUDART_VERSION >= 10010
+  if (!graph_exec_) {
+    return;
+  }
+  // Replay synchronizes, so no replay is pending
+  DeviceGuard guard(gpu_id_);
+  cudaGraphExecDestroy(graph_exec_);
+  graph_exec_ = nullptr;
+  CUDAContext::ReleaseGraphMemory(graph_memory_);
+  graph_memory_ = 0;
+  eager_runs_ = 0;
+#endif
+}
+
+} // namespace
+
+REGISTER_NET(cuda_graph, CudaGraphNet);
+
+} // namespace caffe2
@@ -203,6 +203,16 @@ void DAGNetBase::WorkerFunction() {
     if (!job_queue_->Pop(&idx)) {
       return;
     }
+    if (!CanRunWithoutBlocking(idx)) {
+      std::unique_lock<std::mutex> mutex_lock(remaining_ops_mutex_);
+      if (!success_) {
+        return;
+      }
+      job_queue_->Push(idx);
+      mutex_lock.unlock();
+      std::this_thread::yield();
+      continue;
+    }
     if (FLAGS_caffe2_dag_net_collect_stats) {
       auto device_option =
           operator_nodes_[idx].operator_->event().GetDeviceOption();
@@ -52,6 +52,12 @@ class DAGNetBase : public NetBase {
   bool DoRunAsync() override;
 
   virtual bool RunAt(int chain_id, const std::vector<int>& chain) = 0;
+  // Whether RunAt(chain_id) would start without blocking its worker. The
+  // worker puts back in the queue the chains that would block, so that the
+  // chains queued after them run first.
+  virtual bool CanRunWithoutBlocking(int /* chain_id */) {
+    return true;
+  }
   void HandleException(int operator_idx, const std::string& exception_str);
 
   vector<dag_utils::OperatorNode> operator_nodes_;
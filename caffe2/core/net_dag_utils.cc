@@ -180,13 +180,17 @@ ExecutionChains computeChains(std::vector<OperatorNode>& orig_nodes) {
              // (parent and dependent) need to satisfy:
              //  1. Both ops are on the same device _and_
              //  2. Parent op does not have an async part or
-             //     dependent op can be executed as an async dependency
+             //     dependent op can be executed as an async dependency _and_
+             //  3. Either both or neither are communication ops, so that
+             //     collectives are not serialized behind compute in a chain
 
              IsSameDevice(
                  orig_nodes[cur.first].operator_->device_option(),
                  orig_nodes[chain.back()].operator_->device_option()) &&
              (!orig_nodes[chain.back()].operator_->HasAsyncPart() ||
-              orig_nodes[cur.first].operator_->SupportsAsyncScheduling()))));
+              orig_nodes[cur.first].operator_->SupportsAsyncScheduling()) &&
+             orig_nodes[cur.first].operator_->IsCommunicationOp() ==
+                 orig_nodes[chain.back()].operator_->IsCommunicationOp())));
   };
   auto commit_chain = [&]() {
     if (chain.size() > 0) {
@@ -425,5 +429,45 @@ std::vector<OpGraphNode> prepareChainGraphNodes(
   return chain_nodes;
 }
 
+bool dependsOnlyOnMetadata(
+    const std::vector<OperatorNode>& nodes,
+    const std::vector<int>& parent_ops,
+    const std::vector<int>& chain) {
+  if (parent_ops.empty()) {
+    return false;
+  }
+  std::unordered_set<std::string> chain_outputs;
+  for (auto op_idx : chain) {
+    const auto& op = nodes[op_idx].operator_;
+    if (!op->has_debug_def() || op->debug_def().control_input_size() > 0) {
+      return false;
+    }
+    const auto* schema = OpSchemaRegistry::Schema(op->type());
+    if (!schema || !schema->reads_only_input_metadata()) {
+      return false;
+    }
+    for (const auto& output : op->debug_def().output()) {
+      chain_outputs.insert(output);
+    }
+  }
+  for (auto parent_idx : parent_ops) {
+    const auto& op = nodes[parent_idx].operator_;
+    if (!op->has_debug_def() || op->device_option().device_type() == CPU) {
+      return false;
+    }
+    for (const auto& input : op->debug_def().input()) {
+      if (chain_outputs.count(input)) {
+        return false;
+      }
+    }
+    for (const auto& output : op->debug_def().output()) {
+      if (chain_outputs.count(output)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 } // namespace dag_utils
 } // namespace caffe2
@@ -54,6 +54,16 @@ std::vector<OpGraphNode> prepareChainGraphNodes(
     const std::vector<dag_utils::OperatorNode>& operator_nodes,
     const std::vector<std::vector<int>>& execution_chains);
 
+// Whether the ops of chain can start before the events of parent_ops (parents
+// of the chain) are finished: every op of the chain has the
+// ReadsOnlyInputMetadata schema, the parents run on a device other than CPU,
+// so that their outputs are resized by the time their RunAsync returns, and no
+// parent reads or writes an output of the chain.
+bool dependsOnlyOnMetadata(
+    const std::vector<OperatorNode>& nodes,
+    const std::vector<int>& parent_ops,
+    const std::vector<int>& chain);
+
 } // namespace dag_utils
 } // namespace caffe2
 
@@ -1,9 +1,11 @@
 #include <gtest/gtest.h>
 #include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
 #include "caffe2/core/net.h"
 #include "caffe2/core/net_dag.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/scope_guard.h"
+#include "caffe2/utils/math.h"
 
 CAFFE2_DECLARE_bool(caffe2_disable_chaining);
 
@@ -59,6 +61,14 @@ OPERATOR_SCHEMA(NetTestDummy2)
     .NumOutputs(0, INT_MAX)
     .AllowInplace({{1, 0}});
 
+REGISTER_CPU_OPERATOR(NetTestMetadataDummy, NetTestDummyOp);
+REGISTER_CUDA_OPERATOR(NetTestMetadataDummy, NetTestDummyOp);
+
+OPERATOR_SCHEMA(NetTestMetadataDummy)
+    .NumInputs(0, INT_MAX)
+    .NumOutputs(0, INT_MAX)
+    .ReadsOnlyInputMetadata();
+
 }  // namespace
 
 void testExecution(std::unique_ptr<NetBase>& net, int num_ops) {
@@ -133,4 +143,157 @@ TEST(NetTest, DISABLED_ChainingForDifferentDevices) {
   }
 }
 
+TEST(NetTest, CudaGraphNetReplaysDeviceWork) {
+  if (!HasCudaGPU()) {
+    return;
+  }
+  const auto init_spec = R"DOC(
+        name: "init"
+        device_option {
+          device_type: 1
+        }
+        op {
+          output: "acc"
+          type: "ConstantFill"
+          arg {
+            name: "shape"
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 0.0
+          }
+        }
+        op {
+          output: "one"
+          type: "ConstantFill"
+          arg {
+            name: "shape"
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 1.0
+          }
+        }
+)DOC";
+  const auto spec = R"DOC(
+        name: "example"
+        type: "cuda_graph"
+        device_option {
+          device_type: 1
+        }
+        external_input: "acc"
+        external_input: "one"
+        op {
+          input: "acc"
+          input: "one"
+          output: "acc"
+          type: "Add"
+        }
+        op {
+          input: "acc"
+          output: "out"
+          type: "NetTestDummy"
+        }
+)DOC";
+  Workspace ws;
+  NetDef init_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(init_spec, &init_def));
+  CAFFE_ENFORCE(ws.RunNetOnce(init_def));
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+
+  counter.exchange(0);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(net->Run());
+  }
+  // The host work only runs for the warmup run and the capture
+  EXPECT_EQ(counter.load(), 2);
+  TensorCPU acc(ws.GetBlob("acc")->Get<TensorCUDA>());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(acc.data<float>()[i], 5);
+  }
+
+  // A blob with another shape makes the net capture again
+  CUDAContext context(0);
+  auto* one = ws.GetBlob("one")->GetMutable<TensorCUDA>();
+  one->Resize(8);
+  math::Set<float, CUDAContext>(8, 1, one->mutable_data<float>(), &context);
+  auto* acc_cuda = ws.GetBlob("acc")->GetMutable<TensorCUDA>();
+  acc_cuda->Resize(8);
+  math::Set<float, CUDAContext>(8, 0, acc_cuda->mutable_data<float>(), &context);
+  context.FinishDeviceComputation();
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(net->Run());
+  }
+  TensorCPU acc8(ws.GetBlob("acc")->Get<TensorCUDA>());
+  EXPECT_EQ(acc8.size(), 8);
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(acc8.data<float>()[i], 3);
+  }
+}
+
+TEST(NetTest, MetadataOpsSkipDeviceWaits) {
+  if (!HasCudaGPU()) {
+    return;
+  }
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_dag"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "hidden"
+          type: "NetTestDummy"
+          device_option {
+            device_type: 1
+          }
+        }
+        op {
+          input: "hidden"
+          output: "shape"
+          type: "NetTestMetadataDummy"
+          device_option {
+            device_type: 0
+          }
+        }
+        op {
+          input: "shape"
+          output: "size"
+          type: "NetTestMetadataDummy"
+          device_option {
+            device_type: 0
+          }
+        }
+        op {
+          input: "size"
+          output: "hidden"
+          type: "NetTestMetadataDummy"
+          device_option {
+            device_type: 0
+          }
+        }
+)DOC";
+  Workspace ws;
+  ws.CreateBlob("in");
+  auto net_def = std::make_shared<NetDef>();
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, net_def.get()));
+
+  auto nodes = dag_utils::prepareOperatorNodes(net_def, &ws);
+  // shape only reads the shape of the output of a GPU op
+  EXPECT_TRUE(dag_utils::dependsOnlyOnMetadata(nodes, {0}, {1}));
+  // size waits for a CPU op
+  EXPECT_FALSE(dag_utils::dependsOnlyOnMetadata(nodes, {1}, {2}));
+  // the last op overwrites the output of the GPU op
+  EXPECT_FALSE(dag_utils::dependsOnlyOnMetadata(nodes, {0}, {3}));
+  // the GPU op computes values
+  EXPECT_FALSE(dag_utils::dependsOnlyOnMetadata(nodes, {}, {0}));
+
+  net_def->set_num_workers(2);
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  testExecution(net, net_def->op().size());
+}
+
 } // namespace caffe2
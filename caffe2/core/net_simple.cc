@@ -1,8 +1,12 @@
 #include "caffe2/core/net_simple.h"
 #include "caffe2/core/net.h"
 
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <mutex>
 #include <set>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -12,6 +16,13 @@
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/proto_utils.h"
 
+CAFFE2_DEFINE_int(
+    caffe2_simple_net_creation_threads,
+    1,
+    "Number of threads constructing the operators of a simple net. With more "
+    "than one, the outputs of all the operators are created before any "
+    "operator, so their constructors must not modify the workspace.");
+
 namespace caffe2 {
 
 SimpleNet::SimpleNet(
@@ -20,8 +31,7 @@ SimpleNet::SimpleNet(
     : NetBase(net_def, ws) {
   VLOG(1) << "Constructing SimpleNet " << net_def->name();
   const bool net_def_has_device_option = net_def->has_device_option();
-  // Initialize the operators
-  for (int idx = 0; idx < net_def->op_size(); ++idx) {
+  auto createOperator = [&](int idx) {
     const auto& operator_def = net_def->op(idx);
     VLOG(1) << "Creating operator " << operator_def.name() << ": "
             << operator_def.type();
@@ -38,7 +48,64 @@ SimpleNet::SimpleNet(
       op->set_debug_def(
           std::shared_ptr<const OperatorDef>{net_def, &(net_def->op(idx))});
     }
-    operators_.emplace_back(std::move(op));
+    return op;
+  };
+
+  const int num_threads =
+      std::min(FLAGS_caffe2_simple_net_creation_threads, net_def->op_size());
+  if (num_threads <= 1) {
+    // Initialize the operators
+    for (int idx = 0; idx < net_def->op_size(); ++idx) {
+      operators_.emplace_back(createOperator(idx));
+    }
+    return;
+  }
+
+  // An operator finds its inputs and creates its outputs when constructed.
+  // Do that upfront, in order, so that the operators can then be constructed
+  // concurrently, only reading the workspace.
+  for (const auto& operator_def : net_def->op()) {
+    for (const auto& input : operator_def.input()) {
+      CAFFE_ENFORCE(
+          ws->HasBlob(input),
+          "op ",
+          operator_def.type(),
+          ": Encountered a non-existing input blob: ",
+          input);
+    }
+    for (const auto& output : operator_def.output()) {
+      ws->CreateBlob(output);
+    }
+  }
+  operators_.resize(net_def->op_size());
+  std::atomic<int> next{0};
+  std::mutex error_mutex;
+  int error_idx = net_def->op_size();
+  std::exception_ptr error;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&]() {
+      for (int idx = next++; idx < net_def->op_size(); idx = next++) {
+        try {
+          operators_[idx] = createOperator(idx);
+        } catch (...) {
+          // report the failure of the first operator, like a serial
+          // construction would
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (idx < error_idx) {
+            error_idx = idx;
+            error = std::current_exception();
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    ws->last_failed_op_net_position = error_idx;
+    std::rethrow_exception(error);
   }
 }
 
@@ -5,6 +5,7 @@
 #include "caffe2/core/scope_guard.h"
 
 CAFFE2_DECLARE_bool(caffe2_disable_chaining);
+CAFFE2_DECLARE_int(caffe2_simple_net_creation_threads);
 
 namespace caffe2 {
 
@@ -58,6 +59,28 @@ OPERATOR_SCHEMA(NetTestDummy2)
     .NumOutputs(0, INT_MAX)
     .AllowInplace({{1, 0}});
 
+// Simulates a collective, e.g. Allreduce
+class NetTestCommDummyOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+
+  bool Run(int /* unused */ /*stream_id*/) override {
+    counter.fetch_add(1);
+    return true;
+  }
+
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(NetTestCommDummy, NetTestCommDummyOp);
+
+OPERATOR_SCHEMA(NetTestCommDummy)
+    .NumInputs(0, INT_MAX)
+    .NumOutputs(0, INT_MAX)
+    .AllowInplace({{0, 0}, {1, 1}});
+
 unique_ptr<NetBase> CreateNetTestHelper(
     Workspace* ws,
     const vector<string>& input,
@@ -229,6 +252,30 @@ TEST(NetTest, ChainingForFork) {
   checkChainingAndRun(spec, {{0, {0}}, {1, {1}}, {2, {2}}});
 }
 
+TEST(NetTest, ChainingForCommunication) {
+  const auto spec = R"DOC(
+        name: "example"
+        type: "dag"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "grad"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "grad"
+          output: "grad"
+          type: "NetTestCommDummy"
+        }
+        op {
+          input: "grad"
+          output: "out"
+          type: "NetTestDummy"
+        }
+)DOC";
+  checkChainingAndRun(spec, {{0, {0}}, {1, {1}}, {2, {2}}});
+}
+
 // TEST(NetTest, ChainingForJoinWithAncestor) {
 //   const auto spec = R"DOC(
 //         name: "example"
@@ -580,6 +627,42 @@ TEST(NetTest, FailingOperator) {
   }
 }
 
+TEST(NetTest, ParallelOperatorCreation) {
+  auto old = FLAGS_caffe2_simple_net_creation_threads;
+  auto g = MakeGuard([&]() { FLAGS_caffe2_simple_net_creation_threads = old; });
+  FLAGS_caffe2_simple_net_creation_threads = 4;
+
+  // a chain in -> blob_0 -> ... -> blob_99
+  NetDef net_def;
+  net_def.set_type("simple");
+  for (int i = 0; i < 100; ++i) {
+    auto& op = *net_def.add_op();
+    op.set_type("NetTestDummy");
+    op.add_input(i ? "blob_" + caffe2::to_string(i - 1) : "in");
+    op.add_output("blob_" + caffe2::to_string(i));
+  }
+
+  Workspace ws;
+  ws.CreateBlob("in");
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  ASSERT_TRUE(net);
+  auto ops = net->GetOperators();
+  ASSERT_EQ(ops.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(ops[i]->debug_def().output(0), "blob_" + caffe2::to_string(i));
+    EXPECT_EQ(ops[i]->OutputBlob(0), ws.GetBlob("blob_" + caffe2::to_string(i)));
+  }
+  counter.exchange(0);
+  ASSERT_TRUE(net->Run());
+  ASSERT_EQ(100, counter.load());
+
+  // inputs must still be produced by an earlier operator
+  net_def.mutable_op(10)->set_input(0, "blob_50");
+  Workspace ws2;
+  ws2.CreateBlob("in");
+  ASSERT_THROW(CreateNet(net_def, &ws2), EnforceNotMet);
+}
+
 const int kTestPoolSize = 4;
 
 class ExecutorHelperDummyOp final : public OperatorBase {
@@ -620,4 +703,107 @@ TEST(NetTest, OperatorWithExecutorHelper) {
   ASSERT_TRUE(net->Run());
 }
 
+TEST(NetTest, AsyncSchedulingPriorities) {
+  // a long chain next to short ones, run repeatedly so that the priorities
+  // are recomputed from the measured runtimes
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "long1"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "long1"
+          output: "long2"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "long2"
+          output: "long3"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "in"
+          output: "short1"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "in"
+          output: "short2"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "long3"
+          input: "short1"
+          input: "short2"
+          output: "out"
+          type: "NetTestDummy"
+        }
+)DOC";
+
+  Workspace ws;
+  ws.CreateBlob("in");
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(2);
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  for (int i = 0; i < 10; i++) {
+    counter.exchange(0);
+    ASSERT_TRUE(net->Run());
+    ASSERT_EQ(6, counter.load());
+  }
+}
+
+TEST(NetTest, AsyncSchedulingCommunication) {
+  // the collectives run in the net's communication pool, next to the compute
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "grad1"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "grad1"
+          output: "grad1"
+          type: "NetTestCommDummy"
+        }
+        op {
+          input: "in"
+          output: "grad2"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "grad2"
+          output: "grad2"
+          type: "NetTestCommDummy"
+        }
+        op {
+          input: "grad1"
+          input: "grad2"
+          output: "out"
+          type: "NetTestDummy"
+        }
+)DOC";
+
+  Workspace ws;
+  ws.CreateBlob("in");
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(1);
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  for (int i = 0; i < 10; i++) {
+    counter.exchange(0);
+    ASSERT_TRUE(net->Run());
+    ASSERT_EQ(5, counter.load());
+  }
+}
+
 } // namespace caffe2
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 
+#include "caffe2/core/engine_tuner.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/net.h"
 #include "caffe2/core/operator_gradient.h"
@@ -122,6 +123,27 @@ unique_ptr<OperatorBase> _CreateOperator(
     const auto op_def_engines = split(',', operator_def.engine());
     engines.insert(engines.end(), op_def_engines.begin(), op_def_engines.end());
   }
+  // then the engine measured to be the fastest by AutotuneEngines, if the
+  // shapes of the inputs are known already
+  if (!operator_def.engine().size() && !EngineCache::Global().Empty()) {
+    vector<TensorShape> shapes;
+    for (const auto& input : operator_def.input()) {
+      const Blob* blob = ws->GetBlob(input);
+      if (blob) {
+        shapes.push_back(GetTensorShapeOfBlob(blob));
+      } else {
+        shapes.emplace_back();
+        shapes.back().set_unknown_shape(true);
+      }
+    }
+    std::string key;
+    std::string tuned_engine;
+    if (EngineCacheKey(operator_def, shapes, &key) &&
+        EngineCache::Global().Lookup(key, &tuned_engine)) {
+      VLOG(2) << "Inserting tuned engine: " << tuned_engine;
+      engines.push_back(tuned_engine);
+    }
+  }
   if (!FLAGS_caffe2_disable_implicit_engine_preference &&
       g_per_op_engine_pref().count(device_type) &&
       g_per_op_engine_pref()[device_type].count(op_type)) {
@@ -35,31 +35,24 @@ class OperatorBase : public Observable<OperatorBase> {
   /** @brief Checks if the operator has an argument of the given name.
    */
   inline bool HasArgument(const string& name) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::HasArgument(*operator_def_, name);
+    return arg_helper().HasArgument(name);
   }
 
   // Functions that deal with arguments. Basically, this allows us to map an
   // argument name to a specific type of argument that we are trying to access.
   template <typename T>
   inline T GetSingleArgument(const string& name, const T& default_value) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::GetSingleArgument<OperatorDef, T>(
-        *operator_def_, name, default_value);
+    return arg_helper().GetSingleArgument<T>(name, default_value);
   }
   template <typename T>
   inline bool HasSingleArgumentOfType(const string& name) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::HasSingleArgumentOfType<OperatorDef, T>(
-        *operator_def_, name);
+    return arg_helper().HasSingleArgumentOfType<T>(name);
   }
   template <typename T>
   inline vector<T> GetRepeatedArgument(
       const string& name,
       const vector<T>& default_value = {}) const {
-    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
-    return ArgumentHelper::GetRepeatedArgument<OperatorDef, T>(
-        *operator_def_, name, default_value);
+    return arg_helper().GetRepeatedArgument<T>(name, default_value);
   }
 
   // Get the inputs and outputs as specific types.
@@ -151,6 +144,13 @@ class OperatorBase : public Observable<OperatorBase> {
     return false;
   }
 
+  // Collective communication ops (e.g. Allreduce) are kept out of compute
+  // chains and run on their own threads and streams by the async executors,
+  // so that they overlap with the compute that does not depend on them.
+  virtual bool IsCommunicationOp() const {
+    return false;
+  }
+
   // RunAsync, if implemenented by the specific operators, will schedule the
   // computation on the corresponding context and record the event in its
   // event_ member object. If the specific operator does not support RunAsync,
@@ -216,6 +216,7 @@ class OperatorBase : public Observable<OperatorBase> {
   inline void set_debug_def(
       const std::shared_ptr<const OperatorDef>& operator_def) {
     operator_def_ = operator_def;
+    arg_helper_.reset();
   }
 
   inline bool has_debug_def() const {
@@ -311,6 +312,18 @@ class OperatorBase : public Observable<OperatorBase> {
 
   ExecutorHelper* helper_ = nullptr;
 
+  // The arguments of operator_def_, indexed on first access. Building an
+  // ArgumentHelper copies all the arguments, so it isn't done per access.
+  mutable std::unique_ptr<ArgumentHelper> arg_helper_;
+
+  const ArgumentHelper& arg_helper() const {
+    CAFFE_ENFORCE(operator_def_, "operator_def was null!");
+    if (!arg_helper_) {
+      arg_helper_.reset(new ArgumentHelper(*operator_def_));
+    }
+    return *arg_helper_;
+  }
+
  protected:
   virtual void RecordEvent(const char* err_msg = nullptr) {
     CAFFE_NOT_IMPLEMENTED;
@@ -1,6 +1,8 @@
 #include "caffe2/core/operator_schema.h"
 #include "caffe2/core/logging.h"
 
+#include <mutex>
+
 namespace caffe2 {
 
 bool OpSchema::Verify(const OperatorDef& def) const {
@@ -189,6 +191,11 @@ OpSchema& OpSchema::InputsCanCrossDevices() {
   return *this;
 }
 
+OpSchema& OpSchema::ReadsOnlyInputMetadata() {
+  reads_only_input_metadata_ = true;
+  return *this;
+}
+
 OpSchema& OpSchema::TensorInferenceFunction(
     TensorInferenceFunctionType function) {
   tensor_inference_function_ = function;
@@ -287,7 +294,7 @@ OpSchema& OpSchema::Output(const int n, const char* name, const char* descriptio
 
 OpSchema& OpSchema::FillUsing(std::function<void(OpSchema&)> populator) {
   if (populator) {
-    populator(*this);
+    populators_.push_back(populator);
   }
   return *this;
 }
@@ -346,6 +353,20 @@ std::ostream& operator<<(std::ostream& out, const OpSchema& schema) {
   return out;
 }
 
+void OpSchemaRegistry::Populate(OpSchema& schema) {
+  // schemas are looked up concurrently by the threads creating operators
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  // a populator may call FillUsing itself
+  while (!schema.populators_.empty()) {
+    auto populators = std::move(schema.populators_);
+    schema.populators_.clear();
+    for (const auto& populator : populators) {
+      populator(schema);
+    }
+  }
+}
+
 CaffeMap<string, OpSchema>& OpSchemaRegistry::map() {
   static CaffeMap<string, OpSchema> map;
   return map;
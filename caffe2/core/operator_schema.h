@@ -261,7 +261,10 @@ class OpSchema {
   OpSchema& Input(const int n, const char* name, const char* description);
   OpSchema& Output(const int n, const char* name, const char* description);
   // Calls the passed function with `this` as an argument. Useful for
-  // adding docs for temlated/macro ops.
+  // adding docs for temlated/macro ops. The call is deferred to the first
+  // lookup of the schema in OpSchemaRegistry, after the other setters of
+  // the registration, so that generating the docs doesn't slow down static
+  // initialization.
   OpSchema& FillUsing(std::function<void(OpSchema&)> populator);
 
   // Remove from documentation
@@ -270,6 +273,11 @@ class OpSchema {
   // This op can pass data across devices
   OpSchema& InputsCanCrossDevices();
 
+  // This op only reads the shapes of its inputs, not their data, so it can
+  // run as soon as they are allocated, without waiting for the ops (e.g. on
+  // a GPU) that compute their values
+  OpSchema& ReadsOnlyInputMetadata();
+
   /**
    * @brief A function to allow one to get the number of outputs based on the
    * number of inputs, if this schema supports it.
@@ -330,6 +338,9 @@ class OpSchema {
   bool inputs_can_cross_devices() const {
     return inputs_can_cross_devices_;
   }
+  bool reads_only_input_metadata() const {
+    return reads_only_input_metadata_;
+  }
 
   /**
    * @brief Returns the required device location of inputs and outputs.
@@ -349,6 +360,8 @@ class OpSchema {
   }
 
  private:
+  friend class OpSchemaRegistry;
+
   string file_;
   string doc_;
   string onnx_schema_;
@@ -362,6 +375,7 @@ class OpSchema {
   int max_output_ = std::numeric_limits<int>::max();
   bool private_ = false;
   bool inputs_can_cross_devices_ = false;
+  bool reads_only_input_metadata_ = false;
   std::function<bool(int)> num_inputs_allowed_ = [](int) { return true; };
   std::function<bool(int)> num_outputs_allowed_ = [](int) { return true; };
   std::function<bool(int, int)> num_inputs_outputs_allowed_ = [](int, int) {
@@ -386,6 +400,8 @@ class OpSchema {
         return out;
       };
   std::unique_ptr<CostInferenceFunctionType> cost_inference_function_ = nullptr;
+  // FillUsing functions not called yet
+  std::vector<std::function<void(OpSchema&)>> populators_{};
   DeviceInferenceFunctionType device_inference_function_ =
       [](const OperatorDef& def) {
         auto op_device =
@@ -422,6 +438,7 @@ class OpSchemaRegistry {
     auto& m = map();
     auto it = m.find(key);
     if (it != m.end()) {
+      Populate(it->second);
       return &it->second;
     } else {
       return nullptr;
@@ -429,6 +446,9 @@ class OpSchemaRegistry {
   }
 
  private:
+  // Calls the pending FillUsing functions of the schema.
+  static void Populate(OpSchema& schema);
+
   // OpSchemaRegistry should not need to be instantiated.
   OpSchemaRegistry() = delete;
 
@@ -276,4 +276,30 @@ TEST(OperatorSchemaTest, TestCostInference) {
   EXPECT_EQ(2000, schema->InferCost(def, shapes).flops);
 }
 
+static int populator_calls = 0;
+
+OPERATOR_SCHEMA(OpSchemaFillUsing)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .FillUsing([](OpSchema& schema) {
+      populator_calls++;
+      schema.SetDoc("Filled documentation");
+      schema.Input(0, "in0", "filled input.");
+    });
+
+TEST(OperatorSchemaTest, TestFillUsingOnLookup) {
+#ifdef CAFFE2_NO_OPERATOR_SCHEMA
+  return;
+#endif
+  // the populator only runs when the schema is first looked up
+  EXPECT_EQ(populator_calls, 0);
+  const OpSchema* schema = OpSchemaRegistry::Schema("OpSchemaFillUsing");
+  EXPECT_TRUE(schema != nullptr);
+  EXPECT_EQ(populator_calls, 1);
+  EXPECT_STREQ(schema->doc(), "Filled documentation");
+  EXPECT_EQ(schema->input_desc().size(), 1u);
+  EXPECT_EQ(OpSchemaRegistry::Schema("OpSchemaFillUsing"), schema);
+  EXPECT_EQ(populator_calls, 1);
+}
+
 }  // namespace caffe2
@@ -201,6 +201,9 @@ struct ExecutionStepWrapper {
     CompiledExecutionStep* operator->() {
       return compiledRef_;
     }
+    CompiledExecutionStep& operator*() {
+      return *compiledRef_;
+    }
 
    private:
     CompiledGuard() {}
@@ -275,9 +278,29 @@ struct CompiledExecutionStep {
       return net;
     };
 
+    if (step->has_num_micro_batches()) {
+      CAFFE_ENFORCE_GT(
+          step->num_micro_batches(),
+          0,
+          "ExecutionStep ",
+          step->name(),
+          " must have a positive number of micro-batches");
+      CAFFE_ENFORCE(
+          step->substep_size() > 0 && !step->concurrent_substeps() &&
+              !step->has_num_concurrent_instances(),
+          "Pipelined ExecutionStep ",
+          step->name(),
+          " should have substeps, which are its stages, and no other "
+          "concurrency");
+    }
+
     if (step->substep_size()) {
       ShouldContinue substepShouldContinue;
-      if (!step->concurrent_substeps() || step->substep().size() <= 1) {
+      if (step->has_num_micro_batches()) {
+        substepShouldContinue = [this, externalShouldContinue](int64_t it) {
+          return !gotFailure && externalShouldContinue(it);
+        };
+      } else if (!step->concurrent_substeps() || step->substep().size() <= 1) {
         substepShouldContinue = externalShouldContinue;
       } else {
         substepShouldContinue = [this, externalShouldContinue](int64_t it) {
@@ -346,6 +369,87 @@ std::unique_ptr<CompiledExecutionStep> ExecutionStepWrapper::doCompile() {
       ws_id_injector_));
 }
 
+bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper);
+
+/**
+ * Runs one iteration of a pipelined step: every stage runs in its own thread
+ * for all the micro-batches, with stage i running micro-batch m once stage
+ * i - 1 has finished it. The data itself goes through BlobsQueues between the
+ * stages, which also bound how far ahead a stage can get.
+ */
+bool ExecutePipelineIteration(CompiledExecutionStep& compiledStep) {
+  const auto& step = *compiledStep.step;
+  const auto& stages = compiledStep.recurringSubsteps;
+  const int64_t numMicroBatches = step.num_micro_batches();
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  // micro-batches finished by every stage
+  std::vector<int64_t> finished(stages.size(), 0);
+  string first_exception;
+
+  auto worker = [&](size_t stage) {
+    for (int64_t microBatch = 0; microBatch < numMicroBatches; ++microBatch) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() {
+          return compiledStep.gotFailure ||
+              (stage == 0 || finished[stage - 1] > microBatch);
+        });
+        if (compiledStep.gotFailure) {
+          return;
+        }
+      }
+      bool ok = false;
+      try {
+        ok = ExecuteStepRecursive(*stages[stage]);
+      } catch (const std::exception& ex) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!first_exception.size()) {
+          first_exception = GetExceptionString(ex);
+          LOG(ERROR) << "Pipeline stage exception:\n" << first_exception;
+        }
+        compiledStep.gotFailure = true;
+        cv.notify_all();
+        if (!FLAGS_caffe2_handle_executor_threads_exceptions) {
+          // see the workers of concurrent substeps
+          throw;
+        }
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!ok) {
+        compiledStep.gotFailure = true;
+      } else {
+        finished[stage] = microBatch + 1;
+      }
+      cv.notify_all();
+      if (!ok) {
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t stage = 0; stage < stages.size(); ++stage) {
+    threads.emplace_back(worker, stage);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (compiledStep.gotFailure) {
+    LOG(ERROR) << "One of the pipeline stages of " << step.name()
+               << " failed.";
+    if (first_exception.size()) {
+      CAFFE_THROW(
+          "One of the pipeline stages died with an unhandled exception ",
+          first_exception);
+    }
+    return false;
+  }
+  return true;
+}
+
 #define CHECK_SHOULD_STOP(step, shouldStop)                       \
   if (getShouldStop(shouldStop)) {                                \
     VLOG(1) << "Execution step " << step.name() << " stopped by " \
@@ -389,7 +493,16 @@ bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
         (!step.has_num_concurrent_instances() ||
          step.num_concurrent_instances() <= 1);
     for (int64_t iter = 0; compiledStep->shouldContinue(iter); ++iter) {
-      if (sequential) {
+      if (step.has_num_micro_batches()) {
+        VLOG(1) << "Executing step " << step.name() << " iteration " << iter
+                << " as a pipeline of " << step.substep().size()
+                << " stages over " << step.num_micro_batches()
+                << " micro-batches";
+        if (!ExecutePipelineIteration(*compiledStep)) {
+          return false;
+        }
+        CHECK_SHOULD_STOP(step, shouldStop);
+      } else if (sequential) {
         VLOG(1) << "Executing step " << step.name() << " iteration " << iter;
         for (auto& substepWrapper : compiledStep->recurringSubsteps) {
           if (!ExecuteStepRecursive(*substepWrapper)) {
@@ -1,34 +1,54 @@
 #include "caffe2/core/predictor.h"
 
+#include <list>
+#include <set>
 #include <unordered_set>
 
+#include "caffe2/core/memonger.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
+#include "caffe2/utils/murmur_hash3.h"
+
 namespace caffe2 {
 
 namespace {
 
-void enforceIsTensor(Workspace* ws, const std::string& name) {
-  auto blob = ws->GetBlob(name);
+void enforceIsTensor(const Blob* blob, const std::string& name) {
   CAFFE_ENFORCE(blob, "Blob does not exist: ", name);
   CAFFE_ENFORCE(
       blob->template IsType<TensorCPU>(), "Blob is not a CPU Tensor: ", name);
 }
 
-void shareInputTensor(
-    Workspace* ws,
-    const std::string& name,
-    TensorCPU* input) {
-  enforceIsTensor(ws, name);
-  auto* blob = ws->GetBlob(name);
-  CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
+void shareInputTensor(Blob* blob, const std::string& name, TensorCPU* input) {
+  enforceIsTensor(blob, name);
   auto* tensor = blob->template GetMutable<TensorCPU>();
   tensor->ResizeLike(*input);
   tensor->ShareData(*input);
 }
 
-TensorCPU* extractOutputTensor(Workspace* ws, const std::string& name) {
-  enforceIsTensor(ws, name);
-  auto* blob = ws->GetBlob(name);
-  CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
+size_t externalBytes(const Predictor::ExternalTensor& external) {
+  if (external.capacity) {
+    return external.capacity;
+  }
+  size_t size = external.meta.itemsize();
+  for (auto d : external.dims) {
+    size *= d;
+  }
+  return size;
+}
+
+void bindExternalTensor(
+    TensorCPU* tensor,
+    const Predictor::ExternalTensor& external) {
+  CAFFE_ENFORCE(external.data, "External tensor has no data");
+  CAFFE_ENFORCE(external.meta.id(), "External tensor has no type");
+  tensor->Resize(external.dims);
+  tensor->ShareExternalPointer(
+      external.data, external.meta, externalBytes(external), external.deleter);
+}
+
+TensorCPU* extractOutputTensor(Blob* blob, const std::string& name) {
+  enforceIsTensor(blob, name);
   return blob->template GetMutable<TensorCPU>();
 }
 
@@ -53,6 +73,149 @@ const ::google::protobuf::RepeatedPtrField<::std::string>& getBlobs(
 }
 } // namespace
 
+// The LRU of the results of a sub-net, see Predictor::cache_subnet
+class SubnetCache {
+ public:
+  using Key = std::pair<uint64_t, uint64_t>;
+
+  SubnetCache(
+      NetDef subnet,
+      NetDef rest,
+      std::vector<std::string> inputs,
+      size_t capacity,
+      std::chrono::milliseconds ttl)
+      : subnet_(std::move(subnet)),
+        rest_(std::move(rest)),
+        inputs_(std::move(inputs)),
+        capacity_(capacity),
+        ttl_(ttl) {}
+
+  const NetDef& subnet() const {
+    return subnet_;
+  }
+
+  const NetDef& rest() const {
+    return rest_;
+  }
+
+  // 128 bits of murmur hash of the inputs in ws, with their types and dims
+  Key key(Workspace* ws) const {
+    std::vector<uint64_t> hashes;
+    for (const auto& name : inputs_) {
+      const auto* blob = ws->GetBlob(name);
+      enforceIsTensor(blob, name);
+      const auto& tensor = blob->template Get<TensorCPU>();
+      CAFFE_ENFORCE(
+          !tensor.meta().ctor(),
+          "Can't hash the data of input ",
+          name,
+          " of type ",
+          tensor.meta().name());
+      std::vector<int64_t> header{static_cast<int64_t>(tensor.meta().id())};
+      header.insert(header.end(), tensor.dims().begin(), tensor.dims().end());
+      uint64_t hash[2];
+      MurmurHash3_x64_128(
+          header.data(), header.size() * sizeof(int64_t), 0, hash);
+      hashes.insert(hashes.end(), hash, hash + 2);
+      MurmurHash3_x64_128(tensor.raw_data(), tensor.nbytes(), 0, hash);
+      hashes.insert(hashes.end(), hash, hash + 2);
+    }
+    uint64_t hash[2];
+    MurmurHash3_x64_128(
+        hashes.data(), hashes.size() * sizeof(uint64_t), 0, hash);
+    return Key(hash[0], hash[1]);
+  }
+
+  // Copies the outputs cached under key to their blobs in ws, returns false
+  // if there are none
+  bool restore(const Key& key, Workspace* ws) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end() && expired(*it->second)) {
+      entries_.erase(it->second);
+      index_.erase(it);
+      it = index_.end();
+      stats_.expirations++;
+    }
+    if (it == index_.end()) {
+      stats_.misses++;
+      return false;
+    }
+    stats_.hits++;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    const auto& outputs = it->second->outputs;
+    for (auto i = 0; i < outputs.size(); ++i) {
+      const auto& name = subnet_.external_output(i);
+      ws->GetBlob(name)->template GetMutable<TensorCPU>()->CopyFrom(
+          outputs[i]);
+    }
+    return true;
+  }
+
+  // Caches the outputs in ws under key
+  void store(const Key& key, Workspace* ws) {
+    Entry entry;
+    entry.key = key;
+    entry.time = std::chrono::steady_clock::now();
+    entry.outputs.resize(subnet_.external_output_size());
+    for (auto i = 0; i < entry.outputs.size(); ++i) {
+      const auto& name = subnet_.external_output(i);
+      entry.outputs[i].CopyFrom(*extractOutputTensor(ws->GetBlob(name), name));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      // computed by another run at the same time
+      entries_.erase(it->second);
+      index_.erase(it);
+    }
+    entries_.push_front(std::move(entry));
+    index_[key] = entries_.begin();
+    if (entries_.size() > capacity_) {
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+      stats_.evictions++;
+    }
+  }
+
+  Predictor::SubnetCacheStats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats.size = entries_.size();
+    return stats;
+  }
+
+ private:
+  struct Entry {
+    Key key;
+    std::chrono::steady_clock::time_point time;
+    std::vector<TensorCPU> outputs;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return key.first;
+    }
+  };
+
+  bool expired(const Entry& entry) const {
+    return ttl_ != std::chrono::milliseconds::zero() &&
+        std::chrono::steady_clock::now() - entry.time > ttl_;
+  }
+
+  const NetDef subnet_;
+  const NetDef rest_;
+  // the inputs hashed into the keys, in order
+  const std::vector<std::string> inputs_;
+  const size_t capacity_;
+  const std::chrono::milliseconds ttl_;
+  mutable std::mutex mutex_;
+  // most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+  Predictor::SubnetCacheStats stats_;
+};
+
 Predictor::Predictor(const MetaNetDef& def, Workspace* parent)
     : Predictor(
           getNet(
@@ -64,6 +227,7 @@ Predictor::Predictor(const MetaNetDef& def, Workspace* parent)
       getBlobs(def, PredictorConsts::default_instance().inputs_blob_type());
   for (const auto& input : inputs) {
     inputNames_.insert(input);
+    localBlobs_.insert(input);
   }
 }
 
@@ -82,9 +246,23 @@ Predictor::Predictor(
     if (!initialized.count(name)) {
       auto* blob = ws_.CreateBlob(name);
       blob->template GetMutable<TensorCPU>();
+      localBlobs_.insert(name);
+    }
+  }
+  for (const auto& op : run_net.op()) {
+    for (const auto& output : op.output()) {
+      localBlobs_.insert(output);
     }
   }
   CAFFE_ENFORCE(ws_.CreateNet(run_net));
+
+  // The blobs outlive the net, resolve them once rather than on every run
+  for (const auto& name : run_net.external_input()) {
+    inputBlobs_.push_back(ws_.GetBlob(name));
+  }
+  for (const auto& name : run_net.external_output()) {
+    outputBlobs_.push_back(ws_.CreateBlob(name));
+  }
 }
 
 Predictor::~Predictor() {}
@@ -92,16 +270,17 @@ Predictor::~Predictor() {}
 bool Predictor::run(const TensorVector& inputs, TensorVector* outputs) {
   CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
   for (auto i = 0; i < inputs.size(); ++i) {
-    shareInputTensor(&ws_, run_net_.external_input(i), inputs[i]);
+    shareInputTensor(inputBlobs_[i], run_net_.external_input(i), inputs[i]);
   }
 
-  if (!ws_.RunNet(run_net_.name())) {
+  if (!runNet(&ws_)) {
     return false;
   }
 
   outputs->resize(run_net_.external_output_size());
   for (auto i = 0; i < outputs->size(); ++i) {
-    (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
+    (*outputs)[i] =
+        extractOutputTensor(outputBlobs_[i], run_net_.external_output(i));
   }
   return true;
 }
@@ -114,17 +293,307 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
     if (!inputNames_.empty()) {
       CAFFE_ENFORCE_GT(inputNames_.count(input.first), 0);
     }
-    shareInputTensor(&ws_, input.first, input.second);
+    shareInputTensor(ws_.GetBlob(input.first), input.first, input.second);
+  }
+
+  if (!runNet(&ws_)) {
+    return false;
+  }
+
+  outputs->resize(run_net_.external_output_size());
+  for (auto i = 0; i < outputs->size(); ++i) {
+    (*outputs)[i] =
+        extractOutputTensor(outputBlobs_[i], run_net_.external_output(i));
+  }
+  return true;
+}
+
+bool Predictor::run_external(
+    const ExternalTensorVector& inputs,
+    ExternalTensorVector* outputs) {
+  CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
+  outputs->resize(run_net_.external_output_size());
+  std::vector<TensorCPU*> bound;
+  for (auto i = 0; i < inputs.size(); ++i) {
+    const auto& name = run_net_.external_input(i);
+    enforceIsTensor(inputBlobs_[i], name);
+    auto* tensor = inputBlobs_[i]->template GetMutable<TensorCPU>();
+    bindExternalTensor(tensor, inputs[i]);
+    bound.push_back(tensor);
+  }
+  for (auto i = 0; i < outputs->size(); ++i) {
+    auto& output = (*outputs)[i];
+    if (!output.data) {
+      continue;
+    }
+    auto* tensor = outputBlobs_[i]->template GetMutable<TensorCPU>();
+    // The operator resizes the tensor, which keeps the buffer as long as
+    // the new size fits in it
+    auto bytes = externalBytes(output);
+    output.capacity = bytes;
+    tensor->Resize(static_cast<TIndex>(bytes / output.meta.itemsize()));
+    tensor->ShareExternalPointer(output.data, output.meta, bytes);
+    bound.push_back(tensor);
+  }
+  auto unbind = [&]() {
+    for (auto* tensor : bound) {
+      tensor->FreeMemory();
+    }
+  };
+
+  bool success;
+  try {
+    success = runNet(&ws_);
+    for (auto i = 0; success && i < outputs->size(); ++i) {
+      auto& output = (*outputs)[i];
+      auto* tensor =
+          extractOutputTensor(outputBlobs_[i], run_net_.external_output(i));
+      if (!output.data) {
+        output.data = tensor->raw_mutable_data(tensor->meta());
+        output.meta = tensor->meta();
+        output.capacity = tensor->nbytes();
+      } else if (tensor->raw_data() != output.data) {
+        CAFFE_ENFORCE(
+            tensor->meta() == output.meta,
+            "Output type doesn't match its buffer: ",
+            run_net_.external_output(i));
+        CAFFE_ENFORCE_LE(
+            tensor->nbytes(),
+            output.capacity,
+            "Output doesn't fit its buffer: ",
+            run_net_.external_output(i));
+        CPUContext context;
+        context.template CopyItems<CPUContext, CPUContext>(
+            tensor->meta(), tensor->size(), tensor->raw_data(), output.data);
+      }
+      output.dims = tensor->dims();
+    }
+  } catch (...) {
+    unbind();
+    throw;
+  }
+  unbind();
+  return success;
+}
+
+void Predictor::plan_memory(const TensorVector& inputs) {
+  CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
+  for (auto i = 0; i < inputs.size(); ++i) {
+    shareInputTensor(inputBlobs_[i], run_net_.external_input(i), inputs[i]);
+  }
+  NetDef net = run_net_;
+  auto shapes = InferBlobShapesAndTypesFromWorkspace(&ws_, {&net});
+
+  std::set<std::string> static_blobs(
+      run_net_.external_input().begin(), run_net_.external_input().end());
+  static_blobs.insert(
+      run_net_.external_output().begin(), run_net_.external_output().end());
+  auto plan = memonger::plan_inference_arena(run_net_, static_blobs, shapes);
+
+  arena_.Resize(static_cast<TIndex>(plan.arena_bytes));
+  auto* base = arena_.template mutable_data<uint8_t>();
+  for (const auto& shape : shapes.shapes()) {
+    auto it = plan.offsets.find(shape.name());
+    if (it == plan.offsets.end()) {
+      continue;
+    }
+    auto* tensor = ws_.GetBlob(shape.name())->template GetMutable<TensorCPU>();
+    tensor->Resize(
+        std::vector<TIndex>(shape.dims().begin(), shape.dims().end()));
+    const auto& meta = DataTypeToTypeMeta(shape.data_type());
+    tensor->ShareExternalPointer(
+        base + it->second, meta, tensor->size() * meta.itemsize());
+  }
+}
+
+void Predictor::cache_subnet(
+    const std::vector<std::string>& inputs,
+    const std::vector<std::string>& outputs,
+    size_t capacity,
+    std::chrono::milliseconds ttl) {
+  CAFFE_ENFORCE_GT(capacity, 0);
+  const std::unordered_set<std::string> inputSet(inputs.begin(), inputs.end());
+  const std::unordered_set<std::string> outputSet(
+      outputs.begin(), outputs.end());
+
+  // Walks back from the outputs to the ops computing them
+  std::vector<bool> cached(run_net_.op_size(), false);
+  std::unordered_set<std::string> needed(outputs.begin(), outputs.end());
+  std::unordered_set<std::string> read, written;
+  for (int i = run_net_.op_size() - 1; i >= 0; --i) {
+    const auto& op = run_net_.op(i);
+    for (const auto& output : op.output()) {
+      cached[i] = cached[i] || needed.count(output);
+    }
+    if (!cached[i]) {
+      continue;
+    }
+    for (const auto& output : op.output()) {
+      CAFFE_ENFORCE(
+          !inputSet.count(output),
+          "Input ",
+          output,
+          " of the cached sub-net is written by it");
+      written.insert(output);
+    }
+    for (const auto& input : op.input()) {
+      read.insert(input);
+      if (!inputSet.count(input)) {
+        needed.insert(input);
+      }
+    }
+  }
+  for (const auto& output : outputs) {
+    CAFFE_ENFORCE(
+        written.count(output), "No op computes sub-net output ", output);
+  }
+  std::vector<std::string> externalInputs = inputs;
+  for (const auto& name : needed) {
+    if (written.count(name)) {
+      continue;
+    }
+    CAFFE_ENFORCE(
+        !localBlobs_.count(name) && ws_.HasBlob(name),
+        "The cached sub-net reads ",
+        name,
+        ", which is neither one of its inputs nor created by init_net");
+    externalInputs.push_back(name);
+  }
+
+  // The other ops only see the outputs of the sub-net
+  auto enforceNotInternal = [&](const std::string& name) {
+    CAFFE_ENFORCE(
+        !written.count(name) || outputSet.count(name),
+        "Blob ",
+        name,
+        " of the cached sub-net is used outside of it, it has to be one of "
+        "its outputs");
+  };
+  for (auto i = 0; i < run_net_.op_size(); ++i) {
+    if (cached[i]) {
+      continue;
+    }
+    for (const auto& input : run_net_.op(i).input()) {
+      enforceNotInternal(input);
+    }
+    for (const auto& output : run_net_.op(i).output()) {
+      CAFFE_ENFORCE(
+          !read.count(output) && !written.count(output),
+          "Blob ",
+          output,
+          " of the cached sub-net is written outside of it");
+    }
+  }
+  for (const auto& output : run_net_.external_output()) {
+    enforceNotInternal(output);
+  }
+
+  NetDef subnet = run_net_;
+  subnet.set_name(run_net_.name() + "_cached_subnet");
+  subnet.clear_op();
+  subnet.clear_external_input();
+  subnet.clear_external_output();
+  NetDef rest = subnet;
+  rest.set_name(run_net_.name() + "_cached_subnet_rest");
+  for (auto i = 0; i < run_net_.op_size(); ++i) {
+    (cached[i] ? subnet : rest).add_op()->CopyFrom(run_net_.op(i));
+  }
+  for (const auto& name : externalInputs) {
+    subnet.add_external_input(name);
+  }
+  for (const auto& name : outputs) {
+    subnet.add_external_output(name);
+  }
+  rest.mutable_external_input()->CopyFrom(run_net_.external_input());
+  for (const auto& name : outputs) {
+    rest.add_external_input(name);
+  }
+  rest.mutable_external_output()->CopyFrom(run_net_.external_output());
+
+  CAFFE_ENFORCE(ws_.CreateNet(subnet));
+  CAFFE_ENFORCE(ws_.CreateNet(rest));
+  subnetCache_.reset(new SubnetCache(
+      std::move(subnet), std::move(rest), inputs, capacity, ttl));
+  // the workspaces created before don't have the nets
+  std::lock_guard<std::mutex> lock(workspacesMutex_);
+  freeWorkspaces_.clear();
+}
+
+Predictor::SubnetCacheStats Predictor::subnet_cache_stats() const {
+  CAFFE_ENFORCE(subnetCache_, "No sub-net is cached");
+  return subnetCache_->stats();
+}
+
+bool Predictor::runNet(Workspace* ws) {
+  if (!subnetCache_) {
+    return ws->RunNet(run_net_.name());
+  }
+  const auto key = subnetCache_->key(ws);
+  if (!subnetCache_->restore(key, ws)) {
+    if (!ws->RunNet(subnetCache_->subnet().name())) {
+      return false;
+    }
+    subnetCache_->store(key, ws);
+  }
+  return ws->RunNet(subnetCache_->rest().name());
+}
+
+std::unique_ptr<Workspace> Predictor::acquireWorkspace() {
+  {
+    std::lock_guard<std::mutex> lock(workspacesMutex_);
+    if (!freeWorkspaces_.empty()) {
+      auto ws = std::move(freeWorkspaces_.back());
+      freeWorkspaces_.pop_back();
+      return ws;
+    }
+  }
+  // The local blobs hide the ones of the same name in ws_, they must exist
+  // before the net is created as operators keep pointers to their blobs.
+  auto ws = caffe2::make_unique<Workspace>(&ws_);
+  for (const auto& name : localBlobs_) {
+    ws->CreateLocalBlob(name)->template GetMutable<TensorCPU>();
+  }
+  CAFFE_ENFORCE(ws->CreateNet(run_net_));
+  if (subnetCache_) {
+    CAFFE_ENFORCE(ws->CreateNet(subnetCache_->subnet()));
+    CAFFE_ENFORCE(ws->CreateNet(subnetCache_->rest()));
+  }
+  return ws;
+}
+
+void Predictor::releaseWorkspace(std::unique_ptr<Workspace> ws) {
+  std::lock_guard<std::mutex> lock(workspacesMutex_);
+  freeWorkspaces_.push_back(std::move(ws));
+}
+
+bool Predictor::run_concurrent(
+    const TensorVector& inputs,
+    std::vector<TensorCPU>* outputs) {
+  CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
+  auto ws = acquireWorkspace();
+  for (auto i = 0; i < inputs.size(); ++i) {
+    const auto& name = run_net_.external_input(i);
+    CAFFE_ENFORCE(
+        localBlobs_.count(name),
+        "Input ",
+        name,
+        " is created by init_net and can't be fed concurrently");
+    shareInputTensor(ws->GetBlob(name), name, inputs[i]);
   }
 
-  if (!ws_.RunNet(run_net_.name())) {
+  if (!runNet(ws.get())) {
+    // the net may have failed half way, don't reuse its workspace
     return false;
   }
 
+  outputs->clear();
   outputs->resize(run_net_.external_output_size());
   for (auto i = 0; i < outputs->size(); ++i) {
-    (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
+    const auto& name = run_net_.external_output(i);
+    auto* output = extractOutputTensor(ws->GetBlob(name), name);
+    (*outputs)[i].swap(*output);
   }
+  releaseWorkspace(std::move(ws));
   return true;
 }
 } // namespace caffe2
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <unordered_set>
 #include "caffe2/core/net.h"
 #include "caffe2/core/tensor.h"
@@ -8,11 +11,26 @@
 
 namespace caffe2 {
 
+class SubnetCache;
+
 class Predictor {
  public:
   using TensorVector = std::vector<TensorCPU*>;
   using TensorMap = std::unordered_map<std::string, TensorCPU*>;
 
+  // A buffer owned by the caller, bound to a blob without copying
+  struct ExternalTensor {
+    void* data = nullptr;
+    TypeMeta meta;
+    std::vector<TIndex> dims;
+    // size of the buffer in bytes, 0 means exactly the size of dims
+    size_t capacity = 0;
+    // called on data once the workspace is done with it, nullptr if the
+    // caller keeps the ownership
+    MemoryDeleter deleter = nullptr;
+  };
+  using ExternalTensorVector = std::vector<ExternalTensor>;
+
   // MetaNetDef contains 'init_net', 'run_net', and meta-info
   // The meta-info is used to verify inputs are correctly passed
   Predictor(const MetaNetDef& net, Workspace* parent = nullptr);
@@ -41,6 +59,67 @@ class Predictor {
   // Similar to run, but consumes a map of name to tensor as input
   bool run_map(const TensorMap& inputs, TensorVector* outputs);
 
+  // Similar to run, but the inputs are the caller's buffers, bound to the
+  // input blobs with ShareExternalPointer. Non null entries of `outputs`
+  // (sized like run_net.external_outputs) are buffers the outputs are
+  // written into: they are bound to the output blobs before the run, so
+  // operators producing outputs that fit write there directly. An output
+  // that didn't fit its buffer throws, one whose operator allocated its own
+  // memory anyway is copied. The dims of every output are set, and entries
+  // with null data get the workspace's data and dims like run's outputs.
+  // No blob refers to the caller's buffers once this returns.
+  bool run_external(
+      const ExternalTensorVector& inputs,
+      ExternalTensorVector* outputs);
+
+  // Similar to run, but can be called from several threads at once. Each
+  // call borrows a child workspace of ws() that shares the blobs created by
+  // `init_net` (the parameters are loaded once) and holds its own inputs and
+  // activations; one child is created per concurrent caller and reused.
+  // The outputs are moved out of the child workspace, so they stay valid
+  // after later calls. `run_net` must not write to the parameters.
+  bool run_concurrent(
+      const TensorVector& inputs,
+      std::vector<TensorCPU>* outputs);
+
+  // Places the intermediate blobs of `run_net` in one preallocated arena,
+  // using the shapes inferred for inputs of the same shapes as `inputs`
+  // (see memonger::plan_inference_arena). Later runs that keep the shapes
+  // allocate nothing; a blob growing past its planned size gets its own
+  // memory. Only simple nets are planned, and run_concurrent isn't affected.
+  void plan_memory(const TensorVector& inputs);
+
+  // Memoizes the part of `run_net` that computes `outputs` from `inputs`
+  // and the blobs created by `init_net`, e.g. a user tower whose features
+  // repeat across the requests for many items. The results are kept in an
+  // LRU of `capacity` entries keyed by a hash of the inputs (their types,
+  // dims and data), and entries older than `ttl` are recomputed (zero keeps
+  // them until evicted). On a hit the outputs are copied to their blobs and
+  // only the rest of `run_net` runs. The sub-net must not have side effects,
+  // and the ops outside of it may not use its other blobs nor write to the
+  // blobs it uses. Not thread-safe with the runs.
+  void cache_subnet(
+      const std::vector<std::string>& inputs,
+      const std::vector<std::string>& outputs,
+      size_t capacity,
+      std::chrono::milliseconds ttl = std::chrono::milliseconds::zero());
+
+  struct SubnetCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // entries dropped for being older than the ttl, and for the capacity
+    uint64_t expirations = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+
+    double hit_rate() const {
+      return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0;
+    }
+  };
+
+  // The stats of the cache set by cache_subnet, which must have been called
+  SubnetCacheStats subnet_cache_stats() const;
+
   const NetDef& def() const {
     return run_net_;
   };
@@ -50,8 +129,23 @@ class Predictor {
   };
 
  private:
+  // Runs `run_net` in ws, through the sub-net cache if there is one
+  bool runNet(Workspace* ws);
+  std::unique_ptr<Workspace> acquireWorkspace();
+  void releaseWorkspace(std::unique_ptr<Workspace> ws);
+
   NetDef run_net_;
   Workspace ws_;
+  // blobs of the external inputs and outputs of `run_net` in ws_
+  std::vector<Blob*> inputBlobs_;
+  std::vector<Blob*> outputBlobs_;
   std::unordered_set<std::string> inputNames_;
+  // blobs each child workspace holds locally: the outputs of `run_net` and
+  // the inputs not created by `init_net`
+  std::unordered_set<std::string> localBlobs_;
+  TensorCPU arena_;
+  std::mutex workspacesMutex_;
+  std::vector<std::unique_ptr<Workspace>> freeWorkspaces_;
+  std::unique_ptr<SubnetCache> subnetCache_;
 };
 }
@@ -6,6 +6,10 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 namespace caffe2 {
 
 namespace {
@@ -197,6 +201,205 @@ TEST_F(PredictorTest, SimpleBatchSizedMapInput) {
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
 
+TEST_F(PredictorTest, ConcurrentRuns) {
+  const int kThreads = 4;
+  std::vector<std::unique_ptr<Blob>> inputs;
+  std::vector<std::vector<float>> expected;
+  for (int i = 0; i < kThreads; ++i) {
+    inputs.push_back(randomTensor({2, 4}, ctx_.get()));
+    Predictor::TensorVector input{inputs.back()->GetMutable<TensorCPU>()};
+    Predictor::TensorVector output;
+    ASSERT_TRUE(p_->run(input, &output));
+    const auto* data = output.front()->data<float>();
+    expected.emplace_back(data, data + output.front()->size());
+  }
+
+  std::vector<std::thread> threads;
+  std::atomic<int> failures(0);
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      Predictor::TensorVector input{inputs[i]->GetMutable<TensorCPU>()};
+      for (int iter = 0; iter < 20; ++iter) {
+        std::vector<TensorCPU> output;
+        if (!p_->run_concurrent(input, &output) || output.size() != 1 ||
+            std::vector<float>(
+                output[0].data<float>(),
+                output[0].data<float>() + output[0].size()) != expected[i]) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(failures.load(), 0);
+}
+
+TEST_F(PredictorTest, PlannedMemory) {
+  auto run = parseNetDef(predictSpec);
+  run.set_type("simple");
+  run.set_external_output(0, "z");
+  auto* fc = run.mutable_op(0);
+  fc->set_output(0, "y");
+  auto* relu = run.add_op();
+  relu->set_type("Relu");
+  relu->add_input("y");
+  relu->add_output("h");
+  auto* relu2 = run.add_op();
+  relu2->set_type("Relu");
+  relu2->add_input("h");
+  relu2->add_output("z");
+  Predictor p(parseNetDef(initSpec), run);
+
+  auto inputData = randomTensor({3, 4}, ctx_.get());
+  Predictor::TensorVector input{inputData->GetMutable<TensorCPU>()};
+  Predictor::TensorVector output;
+  ASSERT_TRUE(p.run(input, &output));
+  const auto* data = output.front()->data<float>();
+  std::vector<float> expected(data, data + output.front()->size());
+
+  p.plan_memory(input);
+  auto* y = p.ws()->GetBlob("y")->GetMutable<TensorCPU>();
+  auto* h = p.ws()->GetBlob("h")->GetMutable<TensorCPU>();
+  const void* y_data = y->raw_data();
+  const void* h_data = h->raw_data();
+  EXPECT_NE(y_data, h_data);
+  for (int iter = 0; iter < 3; ++iter) {
+    ASSERT_TRUE(p.run(input, &output));
+    data = output.front()->data<float>();
+    EXPECT_EQ(std::vector<float>(data, data + output.front()->size()), expected);
+    // the intermediates stay in the arena
+    EXPECT_EQ(y->raw_data(), y_data);
+    EXPECT_EQ(h->raw_data(), h_data);
+  }
+}
+
+namespace {
+int freedBuffers = 0;
+void countingDeleter(void* data) {
+  ++freedBuffers;
+  delete[] static_cast<float*>(data);
+}
+} // namespace
+
+TEST_F(PredictorTest, ExternalBuffers) {
+  auto inputData = randomTensor({2, 4}, ctx_.get());
+  auto* inputTensor = inputData->GetMutable<TensorCPU>();
+  Predictor::TensorVector input{inputTensor};
+  Predictor::TensorVector output;
+  ASSERT_TRUE(p_->run(input, &output));
+  const auto* data = output.front()->data<float>();
+  std::vector<float> expected(data, data + output.front()->size());
+
+  float* inputBuffer = new float[8];
+  std::copy(
+      inputTensor->data<float>(), inputTensor->data<float>() + 8, inputBuffer);
+  std::vector<float> outputBuffer(32, -1);
+  Predictor::ExternalTensor externalInput;
+  externalInput.data = inputBuffer;
+  externalInput.meta = TypeMeta::Make<float>();
+  externalInput.dims = {2, 4};
+  externalInput.deleter = countingDeleter;
+  Predictor::ExternalTensorVector outputs(1);
+  outputs[0].data = outputBuffer.data();
+  outputs[0].meta = TypeMeta::Make<float>();
+  outputs[0].capacity = outputBuffer.size() * sizeof(float);
+
+  freedBuffers = 0;
+  ASSERT_TRUE(p_->run_external({externalInput}, &outputs));
+  // the input buffer was handed over and released after the run
+  EXPECT_EQ(freedBuffers, 1);
+  EXPECT_EQ(outputs[0].data, outputBuffer.data());
+  EXPECT_EQ(outputs[0].dims, std::vector<TIndex>({2, 10}));
+  EXPECT_EQ(
+      std::vector<float>(outputBuffer.begin(), outputBuffer.begin() + 20),
+      expected);
+  // later runs don't write into the caller's buffer
+  ASSERT_TRUE(p_->run(input, &output));
+  EXPECT_NE(output.front()->raw_data(), outputBuffer.data());
+
+  // an output buffer that is too small
+  outputs[0].data = outputBuffer.data();
+  outputs[0].capacity = 4 * sizeof(float);
+  externalInput.data = inputTensor->mutable_data<float>();
+  externalInput.deleter = nullptr;
+  EXPECT_THROW(p_->run_external({externalInput}, &outputs), EnforceNotMet);
+}
+
+TEST_F(PredictorTest, CachedSubnet) {
+  // y = FC(user) + FC(data), with the user tower cached
+  auto run = parseNetDef(predictSpec);
+  run.set_type("simple");
+  run.clear_external_input();
+  for (const char* name : {"user", "data", "W", "b"}) {
+    run.add_external_input(name);
+  }
+  run.mutable_op(0)->set_output(0, "d");
+  auto* user = run.add_op();
+  user->CopyFrom(run.op(0));
+  user->set_input(0, "user");
+  user->set_output(0, "u");
+  auto* add = run.add_op();
+  add->set_type("Add");
+  add->add_input("u");
+  add->add_input("d");
+  add->add_output("y");
+  Predictor reference(parseNetDef(initSpec), run);
+  Predictor p(parseNetDef(initSpec), run);
+  // the data isn't one of the inputs
+  EXPECT_THROW(p.cache_subnet({"user"}, {"y"}, 1), EnforceNotMet);
+  EXPECT_THROW(p.cache_subnet({"user"}, {"x"}, 1), EnforceNotMet);
+  p.cache_subnet({"user"}, {"u"}, 1);
+
+  std::vector<std::unique_ptr<Blob>> users, datas;
+  for (int i = 0; i < 2; ++i) {
+    users.push_back(randomTensor({2, 4}, ctx_.get()));
+    datas.push_back(randomTensor({2, 4}, ctx_.get()));
+  }
+  auto expectRun = [&](int u, int d) {
+    Predictor::TensorVector input{users[u]->GetMutable<TensorCPU>(),
+                                  datas[d]->GetMutable<TensorCPU>()};
+    Predictor::TensorVector output, expected;
+    ASSERT_TRUE(reference.run(input, &expected));
+    ASSERT_TRUE(p.run(input, &output));
+    const auto* data = output.front()->data<float>();
+    const auto* expectedData = expected.front()->data<float>();
+    EXPECT_EQ(
+        std::vector<float>(data, data + output.front()->size()),
+        std::vector<float>(
+            expectedData, expectedData + expected.front()->size()));
+  };
+  expectRun(0, 0);
+  expectRun(0, 1);
+  auto stats = p.subnet_cache_stats();
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.size, 1);
+  EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.5);
+  // the second user evicts the first one
+  expectRun(1, 0);
+  expectRun(0, 0);
+  stats = p.subnet_cache_stats();
+  EXPECT_EQ(stats.misses, 3);
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.evictions, 2);
+
+  Predictor q(parseNetDef(initSpec), run);
+  q.cache_subnet({"user"}, {"u"}, 2, std::chrono::milliseconds(1));
+  Predictor::TensorVector input{users[0]->GetMutable<TensorCPU>(),
+                                datas[0]->GetMutable<TensorCPU>()};
+  Predictor::TensorVector output;
+  ASSERT_TRUE(q.run(input, &output));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_TRUE(q.run(input, &output));
+  stats = q.subnet_cache_stats();
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.expirations, 1);
+  EXPECT_EQ(stats.size, 1);
+}
+
 class PredictorMetaNetDefTest : public testing::Test {
  public:
   void SetUp() override {
@@ -42,5 +42,13 @@ TEST(RegistryTest, CanRunCreator) {
 TEST(RegistryTest, ReturnNullOnNonExistingCreator) {
   EXPECT_EQ(FooRegistry()->Create("Non-existing bar", 1), nullptr);
 }
+
+TEST(RegistryTest, HelpMessageIsClassName) {
+  const char* help = FooRegistry()->HelpMessage("Bar");
+  ASSERT_TRUE(help != nullptr);
+  EXPECT_TRUE(string(help).find("Bar") != string::npos);
+  EXPECT_EQ(FooRegistry()->HelpMessage().count("AnotherBar"), 1);
+  EXPECT_EQ(FooRegistry()->HelpMessage("Non-existing bar"), nullptr);
+}
 }
 }  // namespace caffe2
@@ -1,5 +1,7 @@
 #include "caffe2/core/stats.h"
 
+#include <algorithm>
+#include <cmath>
 #include <condition_variable>
 #include <thread>
 
@@ -14,6 +16,62 @@ ExportedStatMap toMap(const ExportedStatList& stats) {
   return statMap;
 }
 
+std::vector<int64_t> StatHistogram::snapshot(bool reset) {
+  std::vector<int64_t> counts(kNumBuckets);
+  for (int i = 0; i < kNumBuckets; ++i) {
+    counts[i] = reset ? buckets_[i].exchange(0) : buckets_[i].load();
+  }
+  return counts;
+}
+
+int StatHistogram::bucketOf(int64_t value) {
+  if (value < kSubBuckets) {
+    return value < 0 ? 0 : value;
+  }
+  // the position of the highest bit set
+  int e = 0;
+  for (int shift = 32; shift > 0; shift >>= 1) {
+    if (value >> (e + shift)) {
+      e += shift;
+    }
+  }
+  const int sub = (value >> (e - kSubBucketBits)) - kSubBuckets;
+  return (e - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+int64_t StatHistogram::bucketUpperBound(int bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  const int shift = bucket / kSubBuckets - 1;
+  const int64_t lower = static_cast<int64_t>(kSubBuckets + bucket % kSubBuckets)
+      << shift;
+  return lower + ((static_cast<int64_t>(1) << shift) - 1);
+}
+
+int64_t StatHistogram::percentile(
+    const std::vector<int64_t>& counts,
+    double q) {
+  int64_t total = 0;
+  for (auto count : counts) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  // the rank, from 1 to total, of the value to return
+  const int64_t rank =
+      std::max<int64_t>(1, static_cast<int64_t>(std::ceil(q * total)));
+  int64_t seen = 0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return bucketUpperBound(i);
+    }
+  }
+  return bucketUpperBound(counts.size() - 1);
+}
+
 StatValue* StatRegistry::add(const std::string& name) {
   std::lock_guard<std::mutex> lg(mutex_);
   auto it = stats_.find(name);
@@ -26,6 +84,15 @@ StatValue* StatRegistry::add(const std::string& name) {
   return value;
 }
 
+StatHistogram* StatRegistry::addHistogram(const std::string& name) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  auto& histogram = histograms_[name];
+  if (!histogram) {
+    histogram.reset(new StatHistogram);
+  }
+  return histogram.get();
+}
+
 void StatRegistry::publish(ExportedStatList& exported, bool reset) {
   std::lock_guard<std::mutex> lg(mutex_);
   exported.resize(stats_.size());
@@ -36,6 +103,26 @@ void StatRegistry::publish(ExportedStatList& exported, bool reset) {
     out.value = reset ? kv.second->reset() : kv.second->get();
     out.ts = std::chrono::high_resolution_clock::now();
   }
+  for (const auto& kv : histograms_) {
+    const auto counts = kv.second->snapshot(reset);
+    const auto ts = std::chrono::high_resolution_clock::now();
+    int64_t count = 0;
+    int64_t max = 0;
+    for (size_t b = 0; b < counts.size(); ++b) {
+      count += counts[b];
+      if (counts[b]) {
+        max = StatHistogram::bucketUpperBound(b);
+      }
+    }
+    exported.push_back({kv.first + "/count", count, ts});
+    exported.push_back(
+        {kv.first + "/p50", StatHistogram::percentile(counts, 0.5), ts});
+    exported.push_back(
+        {kv.first + "/p99", StatHistogram::percentile(counts, 0.99), ts});
+    exported.push_back(
+        {kv.first + "/p999", StatHistogram::percentile(counts, 0.999), ts});
+    exported.push_back({kv.first + "/max", max, ts});
+  }
 }
 
 void StatRegistry::update(const ExportedStatList& data) {
@@ -28,6 +28,58 @@ class StatValue {
   }
 };
 
+/**
+ * @brief A lock-free histogram of non-negative values, for latencies.
+ *
+ * The buckets are logarithmic, HDR style: values below kSubBuckets have a
+ * bucket each, and every larger power of two range [2^e, 2^(e+1)) is split
+ * in kSubBuckets buckets of equal width. A bucket thus spans at most
+ * 1/kSubBuckets of its values, whatever their magnitude, with a fixed number
+ * of buckets for all of int64_t. Recording a value is one atomic increment.
+ */
+class StatHistogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kNumBuckets = (64 - kSubBucketBits) * kSubBuckets;
+
+  StatHistogram() {
+    for (auto& bucket : buckets_) {
+      bucket.store(0);
+    }
+  }
+
+  /**
+   * Adds a value; negative values count as 0.
+   */
+  void record(int64_t value) {
+    buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * The count of every bucket. If `reset` is true, the buckets are set to zero
+   * as they are read, so that no recorded value is lost.
+   */
+  std::vector<int64_t> snapshot(bool reset = false);
+
+  static int bucketOf(int64_t value);
+
+  /**
+   * The largest value of a bucket.
+   */
+  static int64_t bucketUpperBound(int bucket);
+
+  /**
+   * The upper bound of the bucket of the value of rank q (in [0, 1]) among
+   * the counts of a snapshot, or 0 if they are all zero. The result is thus
+   * at most 1/kSubBuckets above the actual percentile.
+   */
+  static int64_t percentile(const std::vector<int64_t>& counts, double q);
+
+ private:
+  std::atomic<int64_t> buckets_[kNumBuckets];
+};
+
 struct ExportedStatValue {
   std::string key;
   int64_t value;
@@ -117,6 +169,7 @@ ExportedStatMap toMap(const ExportedStatList& stats);
 class StatRegistry {
   std::mutex mutex_;
   std::unordered_map<std::string, std::unique_ptr<StatValue>> stats_;
+  std::unordered_map<std::string, std::unique_ptr<StatHistogram>> histograms_;
 
  public:
   /**
@@ -131,10 +184,20 @@ class StatRegistry {
    */
   StatValue* add(const std::string& name);
 
+  /**
+   * Add a new histogram with given name. If a histogram for this name already
+   * exists, returns a pointer to it.
+   */
+  StatHistogram* addHistogram(const std::string& name);
+
   /**
    * Populate an ExportedStatList with current counter values.
    * If `reset` is true, resets all counters to zero. It is guaranteed that no
    * count is lost.
+   *
+   * A histogram is exported as <name>/count, <name>/p50, <name>/p99,
+   * <name>/p999 and <name>/max; with `reset`, over the values recorded since
+   * the last reset.
    */
   void publish(ExportedStatList& exported, bool reset = false);
 
@@ -146,7 +209,8 @@ class StatRegistry {
 
   /**
    * Update values of counters contained in the given ExportedStatList to
-   * the values provided, creating counters that don't exist.
+   * the values provided, creating counters that don't exist. Percentiles
+   * can't be merged this way: exported histograms are updated as counters.
    */
   void update(const ExportedStatList& data);
 
@@ -258,6 +322,25 @@ class DetailedExportedStat : public ExportedStat {
   }
 };
 
+class HistogramExportedStat : public Stat {
+  StatHistogram* histogram_;
+
+ public:
+  HistogramExportedStat(const std::string& gn, const std::string& n)
+      : Stat(gn, n),
+        histogram_(StatRegistry::get().addHistogram(gn + "/" + n)) {}
+
+  int64_t increment(int64_t value = 1) {
+    histogram_->record(value);
+    return value;
+  }
+
+  template <typename T, typename Unused1, typename... Unused>
+  int64_t increment(T value, Unused1, Unused...) {
+    return increment(value);
+  }
+};
+
 namespace detail {
 
 template <class T>
@@ -306,6 +389,11 @@ _ScopeGuard<T> ScopeGuard(T f) {
     groupName, #name                     \
   }
 
+#define CAFFE_HISTOGRAM_EXPORTED_STAT(name) \
+  HistogramExportedStat name {              \
+    groupName, #name                        \
+  }
+
 #define CAFFE_DETAILED_EXPORTED_STAT(name) \
   DetailedExportedStat name {              \
     groupName, #name                       \
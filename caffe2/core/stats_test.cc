@@ -1,5 +1,6 @@
 #include <chrono>
 #include <iostream>
+#include <limits>
 #include <thread>
 
 #include "caffe2/core/stats.h"
@@ -88,6 +89,42 @@ TEST(StatsTest, StatsTestDuration) {
   EXPECT_GT(sumIt->second, 0);
 }
 
+TEST(StatsTest, StatsTestHistogram) {
+  for (int64_t value : std::vector<int64_t>{
+           0, 15, 16, 17, 100, 1000000, std::numeric_limits<int64_t>::max()}) {
+    const int bucket = StatHistogram::bucketOf(value);
+    EXPECT_LT(bucket, StatHistogram::kNumBuckets);
+    EXPECT_GE(StatHistogram::bucketUpperBound(bucket), value);
+    if (bucket > 0) {
+      EXPECT_LT(StatHistogram::bucketUpperBound(bucket - 1), value);
+    }
+  }
+  EXPECT_EQ(StatHistogram::bucketOf(-5), 0);
+
+  struct TestStats {
+    CAFFE_STAT_CTOR(TestStats);
+    CAFFE_HISTOGRAM_EXPORTED_STAT(latency_ns);
+  };
+  TestStats stats("histogram");
+  for (int i = 1; i <= 1000; ++i) {
+    CAFFE_EVENT(stats, latency_ns, i * 1000);
+  }
+  auto map = toMap(StatRegistry::get().publish(true));
+  EXPECT_EQ(map["histogram/latency_ns/count"], 1000);
+  // within a bucket, 1/16 of the value, above the exact percentiles
+  EXPECT_GE(map["histogram/latency_ns/p50"], 500000);
+  EXPECT_LE(map["histogram/latency_ns/p50"], 500000 * 17 / 16);
+  EXPECT_GE(map["histogram/latency_ns/p99"], 990000);
+  EXPECT_LE(map["histogram/latency_ns/p99"], 990000 * 17 / 16);
+  EXPECT_GE(map["histogram/latency_ns/p999"], 999000);
+  EXPECT_GE(map["histogram/latency_ns/max"], 1000000);
+
+  // reset by the last publish
+  map = toMap(StatRegistry::get().publish());
+  EXPECT_EQ(map["histogram/latency_ns/count"], 0);
+  EXPECT_EQ(map["histogram/latency_ns/p99"], 0);
+}
+
 TEST(StatsTest, StatsTestSimple) {
   struct TestStats {
     CAFFE_STAT_CTOR(TestStats);
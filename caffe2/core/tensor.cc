@@ -3,6 +3,8 @@
 #include "caffe2/core/blob_stats.h"
 #include "caffe2/core/flags.h"
 
+#include <atomic>
+
 CAFFE2_DEFINE_bool(
     caffe2_keep_on_shrink,
     true,
@@ -14,10 +16,22 @@ CAFFE2_DEFINE_int64(
     "The maximum memory in bytes to keep on shrink, if the difference between "
     "tensor sizes is bigger than this then tensor will be reset.");
 
+CAFFE2_DEFINE_int(
+    caffe2_tensor_growth_pct,
+    0,
+    "If positive, a tensor outgrowing its capacity allocates at least this "
+    "percentage more than its old capacity.");
+
 namespace caffe2 {
 // declaring it here instead of context.cc because tensor.h includes context.h
 CAFFE_KNOWN_TYPE(Tensor<CPUContext>);
 
+uint64_t NewTensorVersion() {
+  // the low 32 bits count the writes to the tensor
+  static std::atomic<uint64_t> num_tensors(0);
+  return (++num_tensors) << 32;
+}
+
 TensorPrinter::TensorPrinter(
     const std::string& tensor_name,
     const std::string& file_name,
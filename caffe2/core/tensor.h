@@ -25,6 +25,12 @@ CAFFE2_DECLARE_bool(caffe2_keep_on_shrink);
 // is larger than this flag in bytes.
 CAFFE2_DECLARE_int64(caffe2_max_keep_on_shrink_memory);
 
+// When a Tensor outgrows its capacity, allocate at least this percentage
+// more than the old capacity, so that a blob whose size varies across runs
+// settles on a capacity after a few reallocations. 0 allocates exactly the
+// new size. Can be overridden per tensor with SetGrowthPct().
+CAFFE2_DECLARE_int(caffe2_tensor_growth_pct);
+
 namespace caffe2 {
 
 /**
@@ -80,6 +86,10 @@ inline int canonical_axis_index_(int axis_index, int ndims) {
   return axis_index;
 }
 
+// The first version of a new tensor: versions of different tensors don't
+// collide, see Tensor::version()
+uint64_t NewTensorVersion();
+
 /**
  * @brief Tensor is the basic class in Caffe2 that stores a contiguous memory
  * with its shape information.
@@ -244,6 +254,8 @@ class Tensor {
     auto oldSize = size_;
     auto oldDims = dims_;
     Resize(newCapacity);
+    // The caller picked the capacity, don't grow it any further.
+    grow_from_ = 0;
     auto* newData = raw_mutable_data(meta_);
     context->template CopyItems<ContextForCopy, ContextForCopy>(
         meta_, oldSize, oldData.get(), newData);
@@ -283,6 +295,10 @@ class Tensor {
    * is deleted and new memory will be allocated next time you call
    * mutable_data(). However, if the shape is different but the total number of
    * items is the same, the underlying storage is kept.
+   *
+   * When the new shape needs more memory than the tensor's capacity, the next
+   * allocation is grown geometrically if caffe2_tensor_growth_pct (or
+   * SetGrowthPct()) is positive.
    */
   template <typename... Ts>
   void Resize(Ts... dim_source) {
@@ -297,12 +313,16 @@ class Tensor {
         // is smaller than new size
         reset_tensor = capacity_ < new_size;
       } else {
-        reset_tensor = capacity_ < new_size || !FLAGS_caffe2_keep_on_shrink ||
-            capacity_ - new_size > FLAGS_caffe2_max_keep_on_shrink_memory;
+        reset_tensor = capacity_ < new_size ||
+            (!keep_on_shrink_ &&
+             (!FLAGS_caffe2_keep_on_shrink ||
+              capacity_ - new_size > FLAGS_caffe2_max_keep_on_shrink_memory));
       }
 
       if (reset_tensor) {
+        size_t old_capacity = capacity_ < new_size ? capacity_ : 0;
         FreeMemory();
+        grow_from_ = old_capacity;
       }
     }
   }
@@ -353,12 +373,31 @@ class Tensor {
   inline void FreeMemory() {
     data_.reset();
     capacity_ = 0;
+    grow_from_ = 0;
     // If reserved is true and we changed tensor memory then it is fine
     // to switch it to false, if Resize is called from Reserve and it triggers
     // FreeMemory() then reserved_ will be set to true at end of Reserve()
     reserved_ = false;
   }
 
+  /**
+   * Sets the percentage by which this tensor's capacity grows when a Resize
+   * outgrows it, overriding caffe2_tensor_growth_pct. A negative value goes
+   * back to the flag.
+   */
+  void SetGrowthPct(int growth_pct) {
+    growth_pct_ = growth_pct;
+  }
+
+  /**
+   * Keeps the memory of this tensor when a Resize shrinks it, whatever
+   * caffe2_keep_on_shrink and caffe2_max_keep_on_shrink_memory say, so that
+   * it only ever grows. Meant for scratch buffers reused with varying sizes.
+   */
+  void SetKeepOnShrink(bool keep_on_shrink) {
+    keep_on_shrink_ = keep_on_shrink;
+  }
+
   /**
    * A utility function to print the debug string for the tensor. Note that this
    * is very slow since it involves quite some string operations, so do not use
@@ -383,6 +422,10 @@ class Tensor {
     std::swap(shares_data_, other.shares_data_);
     std::swap(capacity_, other.capacity_);
     std::swap(reserved_, other.reserved_);
+    std::swap(grow_from_, other.grow_from_);
+    std::swap(growth_pct_, other.growth_pct_);
+    std::swap(keep_on_shrink_, other.keep_on_shrink_);
+    std::swap(version_, other.version_);
   }
 
   /**
@@ -412,7 +455,9 @@ class Tensor {
     // Finally, do sharing.
     data_ = src.data_;
     capacity_ = src.capacity_;
+    grow_from_ = 0;
     shares_data_ = true;
+    ++version_;
   }
 
   /**
@@ -458,13 +503,27 @@ class Tensor {
     } else {
       capacity_ = nbytes();
     }
+    grow_from_ = 0;
     shares_data_ = true;
+    ++version_;
   }
 
   bool shares_data() const {
     return shares_data_;
   }
 
+  /**
+   * Returns the version of the data, which changes whenever it may have been
+   * written: on every mutable_data() or raw_mutable_data() call, and when the
+   * tensor shares other data. Computations derived from the data (e.g. a
+   * packed weight) can be cached as long as the version doesn't change.
+   *
+   * Writes through another tensor sharing the same data don't change it.
+   */
+  uint64_t version() const {
+    return version_;
+  }
+
   /**
    * Returns a const raw void* pointer of the underlying storage. mutable_data()
    * or raw_mutable_data() must have been called prior to this function call.
@@ -508,6 +567,7 @@ class Tensor {
    * and a new storage will be created.
    */
   inline void* raw_mutable_data(const TypeMeta& meta) {
+    ++version_;
     // For 0-size tensors it's fine to return any pointer (including nullptr)
     if (meta_ == meta && (data_.get() || size_ == 0)) {
       return data_.get();
@@ -541,12 +601,20 @@ class Tensor {
               deleter(ptr);
             });
         meta_.ctor()(data_.get(), size_);
+        capacity_ = size_ * meta_.itemsize();
       } else {
         // For fundamental type, new and delete is easier.
-        auto ptr_and_deleter = Context::New(size_ * meta_.itemsize());
+        size_t nbytes = size_ * meta_.itemsize();
+        int growth_pct =
+            growth_pct_ >= 0 ? growth_pct_ : FLAGS_caffe2_tensor_growth_pct;
+        if (growth_pct > 0) {
+          nbytes = std::max(nbytes, grow_from_ * (100 + growth_pct) / 100);
+        }
+        auto ptr_and_deleter = Context::New(nbytes);
         data_.reset(ptr_and_deleter.first, ptr_and_deleter.second);
+        capacity_ = nbytes;
       }
-      capacity_ = size_ * meta_.itemsize();
+      grow_from_ = 0;
       return data_.get();
     }
   }
@@ -577,6 +645,7 @@ class Tensor {
    template <typename T>
     inline T* mutable_data() {
       if ((size_ == 0 || data_.get()) && IsType<T>()) {
+        ++version_;
         return static_cast<T*>(data_.get());
       }
       return static_cast<T*>(raw_mutable_data(TypeMeta::Make<T>()));
@@ -684,6 +753,14 @@ class Tensor {
   bool shares_data_ = false;
   size_t capacity_ = 0;
   bool reserved_ = false;
+  // The capacity freed by a Resize that outgrew it, which the next allocation
+  // grows from.
+  size_t grow_from_ = 0;
+  // Overrides FLAGS_caffe2_tensor_growth_pct if not negative.
+  int growth_pct_ = -1;
+  // Overrides the keep on shrink flags if set, see SetKeepOnShrink().
+  bool keep_on_shrink_ = false;
+  uint64_t version_ = NewTensorVersion();
   // In case of chunk load we store how much data was already loaded
 
  private:
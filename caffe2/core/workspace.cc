@@ -78,15 +78,13 @@ vector<string> Workspace::LocalBlobs() const {
   for (auto& entry : blob_map_) {
     names.push_back(entry.first);
   }
+  // The blob map is hashed, keep listing the blobs in order
+  std::sort(names.begin(), names.end());
   return names;
 }
 
 vector<string> Workspace::Blobs() const {
-  vector<string> names;
-  names.reserve(blob_map_.size());
-  for (auto& entry : blob_map_) {
-    names.push_back(entry.first);
-  }
+  vector<string> names = LocalBlobs();
   for (const auto& forwarded : forwarded_blobs_) {
     const auto parent_ws = forwarded.second.first;
     const auto& parent_name = forwarded.second.second;
@@ -102,27 +100,32 @@ vector<string> Workspace::Blobs() const {
 }
 
 Blob* Workspace::CreateBlob(const string& name) {
-  if (HasBlob(name)) {
+  if (const auto* blob = FindBlob(name)) {
     VLOG(1) << "Blob " << name << " already exists. Skipping.";
-  } else if (forwarded_blobs_.count(name)) {
+    return const_cast<Blob*>(blob);
+  }
+  auto forwarded = forwarded_blobs_.find(name);
+  if (forwarded != forwarded_blobs_.end()) {
     // possible if parent workspace deletes forwarded blob
     VLOG(1) << "Blob " << name << " is already forwarded from parent workspace "
-            << "(blob " << forwarded_blobs_[name].second << "). Skipping.";
-  } else {
-    VLOG(1) << "Creating blob " << name;
-    blob_map_[name] = unique_ptr<Blob>(new Blob());
+            << "(blob " << forwarded->second.second << "). Skipping.";
+    return GetBlob(name);
   }
-  return GetBlob(name);
+  VLOG(1) << "Creating blob " << name;
+  auto& blob = blob_map_[name];
+  blob.reset(new Blob());
+  return blob.get();
 }
 
 Blob* Workspace::CreateLocalBlob(const string& name) {
-  if (blob_map_.count(name)) {
+  auto& blob = blob_map_[name];
+  if (blob) {
     VLOG(1) << "Blob " << name << " already exists. Skipping.";
   } else {
     VLOG(1) << "Creating blob " << name;
-    blob_map_[name] = unique_ptr<Blob>(new Blob());
+    blob.reset(new Blob());
   }
-  return GetBlob(name);
+  return blob.get();
 }
 
 Blob* Workspace::RenameBlob(const string& old_name, const string& new_name) {
@@ -161,15 +164,26 @@ bool Workspace::RemoveBlob(const string& name) {
   return false;
 }
 
+const Blob* Workspace::FindBlob(const string& name) const {
+  auto it = blob_map_.find(name);
+  if (it != blob_map_.end()) {
+    return it->second.get();
+  }
+  auto forwarded = forwarded_blobs_.find(name);
+  if (forwarded != forwarded_blobs_.end()) {
+    const auto parent_ws = forwarded->second.first;
+    const auto& parent_name = forwarded->second.second;
+    return parent_ws->FindBlob(parent_name);
+  }
+  if (shared_) {
+    return shared_->FindBlob(name);
+  }
+  return nullptr;
+}
+
 const Blob* Workspace::GetBlob(const string& name) const {
-  if (blob_map_.count(name)) {
-    return blob_map_.at(name).get();
-  } else if (forwarded_blobs_.count(name)) {
-    const auto parent_ws = forwarded_blobs_.at(name).first;
-    const auto& parent_name = forwarded_blobs_.at(name).second;
-    return parent_ws->GetBlob(parent_name);
-  } else if (shared_ && shared_->HasBlob(name)) {
-    return shared_->GetBlob(name);
+  if (const auto* blob = FindBlob(name)) {
+    return blob;
   }
   LOG(WARNING) << "Blob " << name << " not in the workspace.";
   // TODO(Yangqing): do we want to always print out the list of blobs here?
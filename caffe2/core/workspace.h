@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <mutex>
 #include <typeinfo>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -47,7 +48,8 @@ struct StopOnSignal {
 class Workspace {
  public:
   typedef std::function<bool(int)> ShouldContinue;
-  typedef CaffeMap<string, unique_ptr<Blob> > BlobMap;
+  // Looked up on every feed, fetch and step net setup, hence hashed
+  typedef std::unordered_map<string, unique_ptr<Blob> > BlobMap;
   typedef CaffeMap<string, unique_ptr<NetBase> > NetMap;
   /**
    * Initializes an empty workspace.
@@ -169,18 +171,7 @@ class Workspace {
    * Checks if a blob with the given name is present in the current workspace.
    */
   inline bool HasBlob(const string& name) const {
-    // First, check the local workspace,
-    // Then, check the forwarding map, then the parent workspace
-    if (blob_map_.count(name)) {
-      return true;
-    } else if (forwarded_blobs_.count(name)) {
-      const auto parent_ws = forwarded_blobs_.at(name).first;
-      const auto& parent_name = forwarded_blobs_.at(name).second;
-      return parent_ws->HasBlob(parent_name);
-    } else if (shared_) {
-      return shared_->HasBlob(name);
-    }
-    return false;
+    return FindBlob(name) != nullptr;
   }
 
   void PrintBlobSizes();
@@ -208,6 +199,12 @@ class Workspace {
   /**
    * Gets the blob with the given name as a const pointer. If the blob does not
    * exist, a nullptr is returned.
+   *
+   * The pointers returned by GetBlob() and CreateBlob() are stable handles:
+   * they stay valid, and keep referring to the same blob, until the blob is
+   * removed (renaming keeps the pointer) or its workspace is destroyed. Code
+   * accessing a blob repeatedly should look it up once and keep the pointer,
+   * like operators do for their inputs and outputs.
    */
   const Blob* GetBlob(const string& name) const;
   /**
@@ -288,6 +285,10 @@ class Workspace {
   std::atomic<int> last_failed_op_net_position;
 
  private:
+  // Looks the blob up in the local workspace, then in the forwarding map,
+  // then in the parent workspace, without logging when it is missing.
+  const Blob* FindBlob(const string& name) const;
+
   BlobMap blob_map_;
   NetMap net_map_;
   const string root_folder_;
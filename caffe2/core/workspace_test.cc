@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 
 #include "caffe2/core/operator.h"
@@ -115,4 +116,31 @@ TEST(WorkspaceTest, BlobMapping) {
   }
 }
 
+TEST(WorkspaceTest, StableBlobHandles) {
+  Workspace parent;
+  Blob* c = parent.CreateBlob("c");
+  Blob* a = parent.CreateBlob("a");
+  Workspace child(&parent);
+  Blob* b = child.CreateBlob("b");
+  // Handles returned by CreateBlob are the ones found by GetBlob, through
+  // the parent workspace too
+  EXPECT_EQ(child.GetBlob("a"), a);
+  EXPECT_EQ(child.GetBlob("b"), b);
+  EXPECT_EQ(child.CreateBlob("c"), c);
+  // Creating more blobs doesn't move the existing ones
+  for (int i = 0; i < 1000; ++i) {
+    parent.CreateBlob("blob_" + caffe2::to_string(i));
+  }
+  EXPECT_EQ(parent.GetBlob("a"), a);
+  EXPECT_EQ(child.GetBlob("c"), c);
+  // Renaming keeps the blob
+  EXPECT_EQ(child.RenameBlob("b", "d"), b);
+  EXPECT_EQ(child.GetBlob("d"), b);
+  // Local blobs are listed in order
+  parent.RemoveBlob("blob_0");
+  auto blobs = parent.LocalBlobs();
+  EXPECT_EQ(blobs.size(), 1001);
+  EXPECT_TRUE(std::is_sorted(blobs.begin(), blobs.end()));
+}
+
 }  // namespace caffe2
@@ -0,0 +1,103 @@
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/cuda_rtc/common_rtc.h"
+#include "caffe2/operators/fused_elementwise_op.h"
+
+namespace caffe2 {
+namespace {
+class FusedElementwiseRTCFunction
+    : public CudaRTCFunction<FusedElementwiseRTCFunction> {
+ public:
+  FusedElementwiseRTCFunction()
+      : CudaRTCFunction(), name_(GetUniqueName()) {}
+
+  template <typename... Args>
+  string KernelName(Args... /*args*/) {
+    return name_;
+  }
+
+  template <typename... Args>
+  string GetSource(Args... args);
+
+ private:
+  string name_;
+};
+
+template <>
+string FusedElementwiseRTCFunction::GetSource(
+    const FusedElementwiseExpr* expr) {
+  std::stringstream ss;
+  ss << "extern \"C\" __global__ void " << name_
+     << "(const size_t nthreads, \n";
+  for (int i = 0; i < expr->numInputs(); ++i) {
+    ss << "const float* in" << i << ", \n";
+  }
+  ss << "float* out0) {\n"
+        "for (int index = blockIdx.x * blockDim.x + threadIdx.x;\n"
+        "index < nthreads; index += blockDim.x * gridDim.x) {\n"
+     << expr->CudaSource() << "\n"
+     << "}\n}";
+  return ss.str();
+}
+} // namespace
+
+// The GPU FusedElementwise: the expression is compiled with NVRTC, once per
+// operator, to a kernel reading every input and writing the output once.
+class FusedElementwiseRTCOp final : public Operator<CUDAContext> {
+ public:
+  FusedElementwiseRTCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CUDAContext>(operator_def, ws),
+        expr_(
+            InputSize(),
+            OperatorBase::GetRepeatedArgument<string>("exprs")) {
+    func_.Compile(&expr_);
+  }
+  ~FusedElementwiseRTCOp() {}
+
+  bool RunOnDevice() override {
+    const auto& X0 = Input(0);
+    CAFFE_ENFORCE(
+        X0.size() < std::numeric_limits<int>::max(),
+        "The kernel function currently only supports int index.");
+    static_assert(sizeof(void*) == sizeof(size_t),
+                  "The argbuffer relies on the assumption that void* and "
+                  "size_t have the same size.");
+    vector<size_t> argBuffer_vec(InputSize() + 2);
+    size_t* argBuffer = argBuffer_vec.data();
+    argBuffer[0] = X0.size();
+    void** ptr_buffer = reinterpret_cast<void**>(argBuffer + 1);
+    for (int i = 0; i < InputSize(); ++i) {
+      CAFFE_ENFORCE(
+          Input(i).dims() == X0.dims(),
+          "All inputs of FusedElementwise must have the same shape");
+      ptr_buffer[i] = const_cast<float*>(Input(i).data<float>());
+    }
+    auto* Y = Output(0);
+    Y->ResizeLike(X0);
+    ptr_buffer[InputSize()] = Y->mutable_data<float>();
+    if (X0.size() == 0) {
+      return true;
+    }
+    size_t argBufferSize = argBuffer_vec.size() * sizeof(size_t);
+    void* config[] = {
+      CU_LAUNCH_PARAM_BUFFER_POINTER, argBuffer,
+      CU_LAUNCH_PARAM_BUFFER_SIZE, &argBufferSize,
+      CU_LAUNCH_PARAM_END
+    };
+    func_.LaunchEx(CAFFE_GET_BLOCKS(X0.size()), 1, 1,
+                   CAFFE_CUDA_NUM_THREADS, 1, 1,
+                   0, context_.cuda_stream(), config);
+    return true;
+  }
+
+ private:
+  const FusedElementwiseExpr expr_;
+  FusedElementwiseRTCFunction func_;
+};
+
+namespace {
+REGISTER_CUDA_OPERATOR(FusedElementwise, FusedElementwiseRTCOp);
+}
+
+} // namespace caffe2
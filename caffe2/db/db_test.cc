@@ -1,5 +1,6 @@
 #include <cstdio>
 #include <iomanip>
+#include <set>
 #include <sstream>
 #include <thread>
 
@@ -196,5 +197,68 @@ TEST(DBReaderShardedTest, Reader) {
   EXPECT_EQ(value, "05");
 }
 
+TEST(DBReaderPrefetchTest, Reader) {
+  std::string name = std::tmpnam(nullptr);
+  CreateAndFill("minidb", name);
+  std::unique_ptr<DBReader> reader(new DBReader("minidb", name, 3, 1));
+  reader->StartPrefetch(2);
+  string key;
+  string value;
+  // the records come in cursor order, wrapping around at the end
+  for (const auto& expected : {"01", "04", "07", "01", "04"}) {
+    reader->Read(&key, &value);
+    EXPECT_EQ(key, expected);
+    EXPECT_EQ(value, expected);
+  }
+  // records read ahead are dropped when seeking
+  reader->SeekToFirst();
+  reader->Read(&key, &value);
+  EXPECT_EQ(key, "01");
+  // after stopping, reads continue from the cursor, past the dropped records
+  reader->StopPrefetch();
+  reader->Read(&key, &value);
+  EXPECT_TRUE(key == "04" || key == "07" || key == "01");
+
+  reader->StartPrefetch(4);
+  reader->SeekToFirst();
+  vector<unique_ptr<std::thread>> threads(6);
+  vector<string> keys(threads.size());
+  vector<string> values(threads.size());
+  for (int i = 0; i < threads.size(); ++i) {
+    threads[i].reset(new std::thread(
+        [&reader](string* key, string* value) { reader->Read(key, value); },
+        &keys[i],
+        &values[i]));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  std::multiset<string> keys_set(keys.begin(), keys.end());
+  EXPECT_EQ(keys_set.count("01"), 2);
+  EXPECT_EQ(keys_set.count("04"), 2);
+  EXPECT_EQ(keys_set.count("07"), 2);
+  EXPECT_EQ(keys, values);
+}
+
+TEST(DBReaderViewTest, Reader) {
+  std::string name = std::tmpnam(nullptr);
+  CreateAndFill("minidb", name);
+  DBReader reader("minidb", name);
+  string key;
+  string value;
+  auto copy = [&value](const ValueView& view) {
+    value.assign(view.data, view.size);
+  };
+  reader.ReadView(&key, copy);
+  EXPECT_EQ(key, "00");
+  EXPECT_EQ(value, "00");
+  reader.Read(&key, &value);
+  EXPECT_EQ(key, "01");
+  reader.StartPrefetch(3);
+  reader.ReadView(&key, copy);
+  EXPECT_EQ(key, "02");
+  EXPECT_EQ(value, "02");
+}
+
 }  // namespace db
 }  // namespace caffe2
@@ -68,6 +68,15 @@ class LMDBCursor : public Cursor {
         mdb_value_.mv_size);
   }
 
+  // points into the memory map, which is read-only and valid as long as
+  // the cursor stays on this record
+  ValueView value_view() override {
+    ValueView view;
+    view.data = static_cast<const char*>(mdb_value_.mv_data);
+    view.size = mdb_value_.mv_size;
+    return view;
+  }
+
   bool Valid() override { return valid_; }
 
  private:
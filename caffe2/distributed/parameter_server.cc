@@ -0,0 +1,502 @@
+#include "parameter_server.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+#include <caffe2/core/logging.h>
+#include <caffe2/core/typeid.h>
+#include <caffe2/perfkernels/adagrad.h>
+
+namespace caffe2 {
+
+namespace {
+
+enum RequestType : uint8_t {
+  kPull = 1,
+  kPush = 2,
+};
+
+// How long a client retries to connect to a shard that isn't up yet.
+constexpr auto kConnectTimeout = std::chrono::seconds(60);
+
+void sendAll(int fd, const void* data, size_t size) {
+  auto* ptr = static_cast<const char*>(data);
+  while (size > 0) {
+    auto n = ::send(fd, ptr, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    CAFFE_ENFORCE_GT(n, 0, "send: ", std::strerror(errno));
+    ptr += n;
+    size -= n;
+  }
+}
+
+// Returns false if the peer closed the connection before the first byte.
+bool recvAll(int fd, void* data, size_t size) {
+  auto* ptr = static_cast<char*>(data);
+  bool first = true;
+  while (size > 0) {
+    auto n = ::recv(fd, ptr, size, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n == 0 && first) {
+      return false;
+    }
+    CAFFE_ENFORCE_GT(
+        n, 0, "recv: ", n == 0 ? "connection closed" : std::strerror(errno));
+    first = false;
+    ptr += n;
+    size -= n;
+  }
+  return true;
+}
+
+template <typename T>
+void append(std::string& buf, const T& value) {
+  buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T recvValue(int fd) {
+  T value;
+  CAFFE_ENFORCE(recvAll(fd, &value, sizeof(value)), "connection closed");
+  return value;
+}
+
+void sendStatus(int fd, const std::string& error) {
+  std::string buf;
+  append<uint8_t>(buf, error.empty() ? 0 : 1);
+  if (!error.empty()) {
+    append<uint32_t>(buf, error.size());
+    buf += error;
+  }
+  sendAll(fd, buf.data(), buf.size());
+}
+
+// Returns the error sent by the server, if any.
+std::string recvStatus(int fd) {
+  if (recvValue<uint8_t>(fd) == 0) {
+    return "";
+  }
+  std::string error(recvValue<uint32_t>(fd), '\0');
+  CAFFE_ENFORCE(recvAll(fd, &error[0], error.size()), "connection closed");
+  return error;
+}
+
+void setNoDelay(int fd) {
+  int flag = 1;
+  CAFFE_ENFORCE_EQ(
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)), 0);
+}
+
+int connectTo(const std::string& endpoint) {
+  auto colon = endpoint.rfind(':');
+  CAFFE_ENFORCE(
+      colon != std::string::npos, "Expected host:port, got ", endpoint);
+  auto host = endpoint.substr(0, colon);
+  auto port = endpoint.substr(colon + 1);
+
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  const auto deadline = std::chrono::steady_clock::now() + kConnectTimeout;
+  while (true) {
+    struct addrinfo* addrs = nullptr;
+    auto rv = getaddrinfo(host.c_str(), port.c_str(), &hints, &addrs);
+    CAFFE_ENFORCE_EQ(rv, 0, "getaddrinfo ", endpoint, ": ", gai_strerror(rv));
+    for (auto* addr = addrs; addr; addr = addr->ai_next) {
+      int fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+      if (fd < 0) {
+        continue;
+      }
+      if (connect(fd, addr->ai_addr, addr->ai_addrlen) == 0) {
+        freeaddrinfo(addrs);
+        setNoDelay(fd);
+        return fd;
+      }
+      close(fd);
+    }
+    freeaddrinfo(addrs);
+    CAFFE_ENFORCE(
+        std::chrono::steady_clock::now() < deadline,
+        "Failed to connect to parameter server ",
+        endpoint);
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+std::string requestHeader(
+    RequestType type,
+    const std::string& table,
+    size_t n) {
+  std::string buf;
+  append<uint8_t>(buf, type);
+  append<uint32_t>(buf, table.size());
+  buf += table;
+  append<uint64_t>(buf, n);
+  return buf;
+}
+
+} // namespace
+
+ParameterServer::ParameterServer(
+    std::map<std::string, Table> tables,
+    int port)
+    : tables_(std::move(tables)), stop_(false), row_locks_(kNumLocks) {
+  for (const auto& kv : tables_) {
+    const auto& table = kv.second;
+    CAFFE_ENFORCE_GE(table.param->ndim(), 1, "Table ", kv.first);
+    CAFFE_ENFORCE(
+        table.moment->size() == table.param->size() ||
+            table.moment->size() == table.param->dim(0),
+        "The moment of table ",
+        kv.first,
+        " should have one value per parameter or per row");
+  }
+
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  CAFFE_ENFORCE_GE(listen_fd_, 0, "socket: ", std::strerror(errno));
+  int flag = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  CAFFE_ENFORCE_EQ(
+      bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)),
+      0,
+      "bind: ",
+      std::strerror(errno));
+  CAFFE_ENFORCE_EQ(listen(listen_fd_, SOMAXCONN), 0);
+  socklen_t len = sizeof(addr);
+  CAFFE_ENFORCE_EQ(getsockname(listen_fd_, (struct sockaddr*)&addr, &len), 0);
+  port_ = ntohs(addr.sin_port);
+
+  accept_thread_ = std::thread(&ParameterServer::acceptLoop, this);
+}
+
+ParameterServer::~ParameterServer() {
+  stop_ = true;
+  shutdown(listen_fd_, SHUT_RDWR);
+  accept_thread_.join();
+  close(listen_fd_);
+
+  std::lock_guard<std::mutex> lock(connections_mutex_);
+  for (auto fd : connections_) {
+    shutdown(fd, SHUT_RDWR);
+  }
+  for (auto& thread : connection_threads_) {
+    thread.join();
+  }
+  for (auto fd : connections_) {
+    close(fd);
+  }
+}
+
+void ParameterServer::acceptLoop() {
+  while (!stop_) {
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (!stop_) {
+        LOG(ERROR) << "Parameter server stopped accepting connections: "
+                   << std::strerror(errno);
+      }
+      return;
+    }
+    setNoDelay(fd);
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    if (stop_) {
+      close(fd);
+      return;
+    }
+    connections_.push_back(fd);
+    connection_threads_.emplace_back(&ParameterServer::serve, this, fd);
+  }
+}
+
+void ParameterServer::serve(int fd) {
+  try {
+    uint8_t type;
+    while (!stop_ && recvAll(fd, &type, sizeof(type))) {
+      CAFFE_ENFORCE(type == kPull || type == kPush, "Bad request ", type);
+      std::string name(recvValue<uint32_t>(fd), '\0');
+      CAFFE_ENFORCE(recvAll(fd, &name[0], name.size()));
+      std::vector<int64_t> rows(recvValue<uint64_t>(fd));
+      CAFFE_ENFORCE(recvAll(fd, rows.data(), rows.size() * sizeof(int64_t)));
+
+      uint64_t dim = 0;
+      float lr = 0, epsilon = 0, decay = 0;
+      std::vector<float> grads;
+      if (type == kPush) {
+        dim = recvValue<uint64_t>(fd);
+        lr = recvValue<float>(fd);
+        epsilon = recvValue<float>(fd);
+        decay = recvValue<float>(fd);
+        grads.resize(rows.size() * dim);
+        CAFFE_ENFORCE(recvAll(fd, grads.data(), grads.size() * sizeof(float)));
+      }
+
+      // Requests are read in full before they are checked, so that a bad
+      // request doesn't break the connection.
+      std::string error;
+      auto it = tables_.find(name);
+      if (it == tables_.end()) {
+        error = "Unknown table " + name;
+      } else {
+        const auto& param = *it->second.param;
+        for (auto row : rows) {
+          if (row < 0 || row >= param.dim(0)) {
+            error = "Row " + caffe2::to_string(row) + " is out of range of " +
+                name;
+            break;
+          }
+        }
+        if (type == kPush && dim != param.size_from_dim(1)) {
+          error = "Gradients don't have the width of " + name;
+        }
+      }
+      if (!error.empty()) {
+        sendStatus(fd, error);
+      } else if (type == kPull) {
+        pull(fd, it->second, rows);
+      } else {
+        push(fd, it->second, rows, grads, lr, epsilon, decay);
+      }
+    }
+  } catch (const std::exception& e) {
+    if (!stop_) {
+      LOG(ERROR) << "Parameter server connection failed: " << e.what();
+    }
+  }
+}
+
+void ParameterServer::pull(
+    int fd,
+    const Table& table,
+    const std::vector<int64_t>& rows) {
+  const auto dim = table.param->size_from_dim(1);
+  const auto* data = table.param->data<float>();
+  std::vector<float> values(rows.size() * dim);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    std::memcpy(
+        values.data() + i * dim, data + rows[i] * dim, dim * sizeof(float));
+  }
+  std::string buf;
+  append<uint8_t>(buf, 0);
+  append<uint64_t>(buf, dim);
+  sendAll(fd, buf.data(), buf.size());
+  sendAll(fd, values.data(), values.size() * sizeof(float));
+}
+
+void ParameterServer::push(
+    int fd,
+    const Table& table,
+    const std::vector<int64_t>& rows,
+    const std::vector<float>& grads,
+    float lr,
+    float epsilon,
+    float decay) {
+  const int dim = table.param->size_from_dim(1);
+  const bool row_wise = table.moment->size() != table.param->size();
+  auto* param = table.param->mutable_data<float>();
+  auto* moment = table.moment->mutable_data<float>();
+  for (size_t i = 0; i < rows.size(); ++i) {
+    auto row = rows[i];
+    std::lock_guard<std::mutex> lock(row_locks_[row % kNumLocks]);
+    auto* w = param + row * dim;
+    const auto* g = grads.data() + i * dim;
+    if (row_wise) {
+      RowWiseAdagradUpdate(
+          dim, w, g, moment + row, w, moment + row, epsilon, lr);
+    } else {
+      auto* h = moment + row * dim;
+      AdagradUpdate(dim, w, g, h, w, h, epsilon, decay, lr);
+    }
+  }
+  sendStatus(fd, "");
+}
+
+ParameterServerClient::ParameterServerClient(
+    const std::vector<std::string>& endpoints,
+    int max_pending)
+    : max_pending_(max_pending) {
+  CAFFE_ENFORCE(!endpoints.empty(), "No parameter server endpoints");
+  CAFFE_ENFORCE_GE(max_pending_, 0);
+  for (const auto& endpoint : endpoints) {
+    shards_.emplace_back(new Shard());
+    shards_.back()->fd = connectTo(endpoint);
+  }
+}
+
+ParameterServerClient::~ParameterServerClient() {
+  for (auto& shard : shards_) {
+    close(shard->fd);
+  }
+}
+
+void ParameterServerClient::drain(Shard& shard, int max_pending) {
+  std::string error;
+  while (shard.pending > max_pending) {
+    auto status = recvStatus(shard.fd);
+    shard.pending--;
+    if (error.empty()) {
+      error = status;
+    }
+  }
+  CAFFE_ENFORCE(error.empty(), "Parameter server push failed: ", error);
+}
+
+void ParameterServerClient::pull(
+    const std::string& table,
+    const int64_t* ids,
+    size_t n,
+    TensorCPU* rows) {
+  const int num_shards = shards_.size();
+  // the distinct rows requested from every shard, and where each id is
+  std::vector<std::vector<int64_t>> shard_rows(num_shards);
+  std::vector<std::unordered_map<int64_t, size_t>> slots(num_shards);
+  std::vector<std::pair<int, size_t>> where(n);
+  for (size_t i = 0; i < n; ++i) {
+    CAFFE_ENFORCE_GE(ids[i], 0, "Negative id");
+    int shard = ids[i] % num_shards;
+    auto inserted =
+        slots[shard].emplace(ids[i] / num_shards, shard_rows[shard].size());
+    if (inserted.second) {
+      shard_rows[shard].push_back(ids[i] / num_shards);
+    }
+    where[i] = {shard, inserted.first->second};
+  }
+
+  // Send to all the shards first, then read the replies. An empty pull
+  // still asks shard 0, for the width of the rows.
+  std::vector<std::unique_lock<std::mutex>> locks;
+  for (auto& shard : shards_) {
+    locks.emplace_back(shard->mutex);
+  }
+  std::vector<int> asked;
+  for (int s = 0; s < num_shards; ++s) {
+    if (!shard_rows[s].empty() || (n == 0 && s == 0)) {
+      auto header = requestHeader(kPull, table, shard_rows[s].size());
+      sendAll(shards_[s]->fd, header.data(), header.size());
+      sendAll(
+          shards_[s]->fd,
+          shard_rows[s].data(),
+          shard_rows[s].size() * sizeof(int64_t));
+      asked.push_back(s);
+    }
+  }
+
+  // Replies are read in full even after an error, to keep the connections
+  // usable.
+  std::string error;
+  int64_t dim = -1;
+  std::vector<std::vector<float>> values(num_shards);
+  for (auto s : asked) {
+    auto& shard = *shards_[s];
+    try {
+      drain(shard, 0);
+    } catch (const std::exception& e) {
+      error = e.what();
+    }
+    auto status = recvStatus(shard.fd);
+    if (!status.empty()) {
+      error = status;
+      continue;
+    }
+    auto shard_dim = recvValue<uint64_t>(shard.fd);
+    values[s].resize(shard_rows[s].size() * shard_dim);
+    CAFFE_ENFORCE(recvAll(
+        shard.fd, values[s].data(), values[s].size() * sizeof(float)));
+    if (dim != -1 && dim != shard_dim) {
+      error = "Shards of " + table + " have different widths";
+    }
+    dim = shard_dim;
+  }
+  CAFFE_ENFORCE(error.empty(), "Parameter server pull failed: ", error);
+
+  rows->Resize(n, dim);
+  auto* out = rows->mutable_data<float>();
+  for (size_t i = 0; i < n; ++i) {
+    std::memcpy(
+        out + i * dim,
+        values[where[i].first].data() + where[i].second * dim,
+        dim * sizeof(float));
+  }
+}
+
+void ParameterServerClient::push(
+    const std::string& table,
+    const int64_t* ids,
+    size_t n,
+    const float* grads,
+    size_t dim,
+    float lr,
+    float epsilon,
+    float decay) {
+  const int num_shards = shards_.size();
+  std::vector<std::vector<int64_t>> shard_rows(num_shards);
+  std::vector<std::vector<float>> shard_grads(num_shards);
+  for (size_t i = 0; i < n; ++i) {
+    CAFFE_ENFORCE_GE(ids[i], 0, "Negative id");
+    int shard = ids[i] % num_shards;
+    shard_rows[shard].push_back(ids[i] / num_shards);
+    shard_grads[shard].insert(
+        shard_grads[shard].end(), grads + i * dim, grads + (i + 1) * dim);
+  }
+
+  for (int s = 0; s < num_shards; ++s) {
+    if (shard_rows[s].empty()) {
+      continue;
+    }
+    auto& shard = *shards_[s];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto header = requestHeader(kPush, table, shard_rows[s].size());
+    sendAll(shard.fd, header.data(), header.size());
+    sendAll(
+        shard.fd,
+        shard_rows[s].data(),
+        shard_rows[s].size() * sizeof(int64_t));
+    std::string params;
+    append<uint64_t>(params, dim);
+    append<float>(params, lr);
+    append<float>(params, epsilon);
+    append<float>(params, decay);
+    sendAll(shard.fd, params.data(), params.size());
+    sendAll(
+        shard.fd,
+        shard_grads[s].data(),
+        shard_grads[s].size() * sizeof(float));
+    shard.pending++;
+    drain(shard, max_pending_);
+  }
+}
+
+void ParameterServerClient::flush() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    drain(*shard, 0);
+  }
+}
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<ParameterServer>);
+CAFFE_KNOWN_TYPE(std::unique_ptr<ParameterServerClient>);
+
+} // namespace caffe2
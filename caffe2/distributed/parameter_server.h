@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <caffe2/core/tensor.h>
+
+namespace caffe2 {
+
+/**
+ * A shard of sparse parameter tables, served over TCP.
+ *
+ * Trainers pull rows of the tables and push gradients for them through a
+ * ParameterServerClient; pushed gradients are applied on the server with
+ * Adagrad, element-wise or row-wise depending on the shape of the moment.
+ *
+ * Each connection is served by its own thread, in order, so that a trainer
+ * always reads its own updates. Updates of a row are serialized by striped
+ * locks, while reads don't lock (like the Hogwild sparse optimizers).
+ */
+class ParameterServer {
+ public:
+  struct Table {
+    // [rows, ...] parameters of the shard
+    TensorCPU* param;
+    // same shape as param for Adagrad, [rows] for row-wise Adagrad
+    TensorCPU* moment;
+  };
+
+  // Serves the tables on the given port, or an ephemeral one if port is 0.
+  ParameterServer(std::map<std::string, Table> tables, int port);
+  ~ParameterServer();
+
+  int port() const {
+    return port_;
+  }
+
+ private:
+  void acceptLoop();
+  void serve(int fd);
+  void pull(int fd, const Table& table, const std::vector<int64_t>& rows);
+  void push(
+      int fd,
+      const Table& table,
+      const std::vector<int64_t>& rows,
+      const std::vector<float>& grads,
+      float lr,
+      float epsilon,
+      float decay);
+
+  std::map<std::string, Table> tables_;
+  int listen_fd_;
+  int port_;
+  std::atomic<bool> stop_;
+
+  static constexpr int kNumLocks = 1024;
+  std::vector<std::mutex> row_locks_;
+
+  std::thread accept_thread_;
+  std::mutex connections_mutex_;
+  std::vector<int> connections_;
+  std::vector<std::thread> connection_threads_;
+};
+
+/**
+ * A trainer's connections to the shards of a ParameterServer.
+ *
+ * Global row i of a table is row i / num_shards of shard i % num_shards.
+ * Pulls send the (deduplicated) rows of every shard before waiting for any
+ * reply. Pushes return once their request is sent; their acknowledgements
+ * are checked later, and at most max_pending of them are in flight per
+ * shard, so that pushes overlap with compute.
+ */
+class ParameterServerClient {
+ public:
+  ParameterServerClient(
+      const std::vector<std::string>& endpoints,
+      int max_pending);
+  ~ParameterServerClient();
+
+  int numShards() const {
+    return shards_.size();
+  }
+
+  // Returns rows, ids.size() x dim
+  void pull(
+      const std::string& table,
+      const int64_t* ids,
+      size_t n,
+      TensorCPU* rows);
+
+  void push(
+      const std::string& table,
+      const int64_t* ids,
+      size_t n,
+      const float* grads,
+      size_t dim,
+      float lr,
+      float epsilon,
+      float decay);
+
+  // Waits for the acknowledgements of all the pushes.
+  void flush();
+
+ private:
+  struct Shard {
+    int fd = -1;
+    int pending = 0;
+    std::mutex mutex;
+  };
+
+  // Reads the acknowledgements of the shard's pushes until at most
+  // max_pending are left.
+  void drain(Shard& shard, int max_pending);
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  int max_pending_;
+};
+
+} // namespace caffe2
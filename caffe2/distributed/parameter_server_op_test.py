@@ -0,0 +1,89 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from caffe2.python import core, workspace, dyndep
+from caffe2.python.test_util import TestCase
+
+dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:parameter_server_ops")
+
+
+class TestParameterServerOps(TestCase):
+    num_shards = 2
+    rows_per_shard = 5
+    dim = 4
+
+    def setUp(self):
+        super(TestParameterServerOps, self).setUp()
+        workspace.ResetWorkspace()
+        self.table = np.random.rand(
+            self.num_shards * self.rows_per_shard, self.dim
+        ).astype(np.float32)
+        endpoints = []
+        for shard in range(self.num_shards):
+            param = "param_{}".format(shard)
+            moment = "moment_{}".format(shard)
+            port = "port_{}".format(shard)
+            workspace.FeedBlob(param, self.table[shard::self.num_shards])
+            workspace.FeedBlob(
+                moment, np.ones(self.table[shard::self.num_shards].shape,
+                                dtype=np.float32))
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "CreateParameterServer",
+                    [param, moment],
+                    ["server_{}".format(shard), port],
+                    tables=["table"]))
+            endpoints.append(
+                "localhost:{}".format(int(workspace.FetchBlob(port))))
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "CreateParameterServerClient",
+                [],
+                ["client"],
+                endpoints=endpoints))
+
+    def tearDown(self):
+        workspace.ResetWorkspace()
+        super(TestParameterServerOps, self).tearDown()
+
+    def pull(self, ids):
+        workspace.FeedBlob("ids", np.array(ids, dtype=np.int64))
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "PSPullRows", ["client", "ids"], ["rows"], table="table"))
+        return workspace.FetchBlob("rows")
+
+    def test_pull(self):
+        ids = [7, 0, 7, 2, 9]
+        np.testing.assert_array_equal(self.pull(ids), self.table[ids])
+        self.assertEqual(self.pull([]).shape, (0, self.dim))
+
+    def test_push(self):
+        ids = [3, 4, 3]
+        grad = np.random.rand(len(ids), self.dim).astype(np.float32)
+        lr = -0.1
+        epsilon = 1e-5
+        workspace.FeedBlob("ids", np.array(ids, dtype=np.int32))
+        workspace.FeedBlob("grad", grad)
+        workspace.FeedBlob("lr", np.array([lr], dtype=np.float32))
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "PSPushGrads",
+                ["client", "ids", "grad", "lr"],
+                [],
+                table="table",
+                epsilon=epsilon))
+        workspace.RunOperatorOnce(core.CreateOperator("PSFlush", ["client"], []))
+
+        # Duplicate ids are applied one after the other, like SparseAdagrad.
+        expected = self.table.copy()
+        moment = np.ones_like(expected)
+        for i, id in enumerate(ids):
+            moment[id] += grad[i] ** 2
+            expected[id] += lr * grad[i] / (np.sqrt(moment[id]) + epsilon)
+        np.testing.assert_allclose(
+            self.pull([3, 4]), expected[[3, 4]], rtol=1e-5)
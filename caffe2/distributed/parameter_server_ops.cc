@@ -0,0 +1,233 @@
+#include "parameter_server_ops.h"
+
+namespace caffe2 {
+
+namespace {
+
+// The ids as int64_t, converted into ids if they aren't already.
+template <typename T>
+const int64_t* int64Ids(const TensorCPU& indices, std::vector<int64_t>* ids) {
+  ids->assign(indices.data<T>(), indices.data<T>() + indices.size());
+  return ids->data();
+}
+
+template <>
+const int64_t* int64Ids<int64_t>(
+    const TensorCPU& indices,
+    std::vector<int64_t>* /* unused */) {
+  return indices.data<int64_t>();
+}
+
+} // namespace
+
+CreateParameterServerOp::CreateParameterServerOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      tables_(GetRepeatedArgument<std::string>("tables")),
+      port_(GetSingleArgument<int>("port", 0)) {
+  CAFFE_ENFORCE_EQ(InputSize() % 2, 0, "Expected (param, moment) pairs");
+  // The server updates the tables in place, after the op has returned.
+  for (const auto& input : operator_def.input()) {
+    blobs_.push_back(ws->GetBlob(input));
+  }
+  if (tables_.empty()) {
+    for (int i = 0; i < InputSize(); i += 2) {
+      tables_.push_back(operator_def.input(i));
+    }
+  }
+  CAFFE_ENFORCE_EQ(tables_.size(), InputSize() / 2);
+}
+
+bool CreateParameterServerOp::RunOnDevice() {
+  std::map<std::string, ParameterServer::Table> tables;
+  for (int i = 0; i < tables_.size(); ++i) {
+    auto* param = blobs_[2 * i]->GetMutable<TensorCPU>();
+    auto* moment = blobs_[2 * i + 1]->GetMutable<TensorCPU>();
+    CAFFE_ENFORCE(param->IsType<float>(), "Tables must be float");
+    CAFFE_ENFORCE(moment->IsType<float>(), "Moments must be float");
+    tables[tables_[i]] = ParameterServer::Table{param, moment};
+  }
+  auto server = std::unique_ptr<ParameterServer>(
+      new ParameterServer(std::move(tables), port_));
+  if (OutputSize() > PORT) {
+    auto* port = Output(PORT);
+    port->Resize();
+    *port->mutable_data<int>() = server->port();
+  }
+  *OperatorBase::Output<std::unique_ptr<ParameterServer>>(SERVER) =
+      std::move(server);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(CreateParameterServer, CreateParameterServerOp);
+OPERATOR_SCHEMA(CreateParameterServer)
+    .NumInputs(0, INT_MAX)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Serves sparse parameter tables, as one shard of a parameter server, until the
+returned server is destroyed. Each table is given as a (param, moment) pair of
+float tensors: param is [rows, ...] and moment is either of the same shape, for
+Adagrad, or [rows], for row-wise Adagrad. Gradients pushed by the trainers are
+applied to the tables on the server, in place.
+)DOC")
+    .Arg("tables", "names of the tables (optional, default: the param names)")
+    .Arg("port", "port to listen on (optional, default: an ephemeral port)")
+    .Input(0, "param", "parameters of the first table")
+    .Input(1, "moment", "Adagrad moment of the first table")
+    .Output(0, "server", "unique_ptr<ParameterServer>")
+    .Output(1, "port", "port the server listens on (optional)");
+
+CreateParameterServerClientOp::CreateParameterServerClientOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      endpoints_(GetRepeatedArgument<std::string>("endpoints")),
+      maxPending_(GetSingleArgument<int>("max_pending", 16)) {
+  CAFFE_ENFORCE(!endpoints_.empty(), "endpoints is a required argument");
+}
+
+bool CreateParameterServerClientOp::RunOnDevice() {
+  *OperatorBase::Output<std::unique_ptr<ParameterServerClient>>(CLIENT) =
+      std::unique_ptr<ParameterServerClient>(
+          new ParameterServerClient(endpoints_, maxPending_));
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    CreateParameterServerClient,
+    CreateParameterServerClientOp);
+OPERATOR_SCHEMA(CreateParameterServerClient)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Connects to the shards of a parameter server. Row i of a table lives in row
+i / num_shards of shard i % num_shards, where the shards are numbered in the
+order of the endpoints.
+)DOC")
+    .Arg("endpoints", "host:port of every shard (required)")
+    .Arg(
+        "max_pending",
+        "pushes in flight per shard before a push waits (optional, "
+        "default: 16)")
+    .Output(0, "client", "unique_ptr<ParameterServerClient>");
+
+PSPullRowsOp::PSPullRowsOp(const OperatorDef& operator_def, Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      table_(GetSingleArgument<std::string>("table", "")) {
+  CAFFE_ENFORCE_NE(table_, "", "table is a required argument");
+}
+
+bool PSPullRowsOp::RunOnDevice() {
+  return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+      this, Input(INDICES));
+}
+
+template <typename T>
+bool PSPullRowsOp::DoRunWithType() {
+  auto* client =
+      OperatorBase::Input<std::unique_ptr<ParameterServerClient>>(CLIENT)
+          .get();
+  const auto& indices = Input(INDICES);
+  CAFFE_ENFORCE_EQ(indices.ndim(), 1, "INDICES must be a vector");
+  client->pull(
+      table_, int64Ids<T>(indices, &ids_), indices.size(), Output(ROWS));
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(PSPullRows, PSPullRowsOp);
+OPERATOR_SCHEMA(PSPullRows)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Fetches rows of a table from the parameter server. The requests to all the
+shards are sent before any reply is awaited, and each distinct row is fetched
+once. Acknowledgements of earlier pushes are awaited first, so that the rows
+include all the updates pushed by this client.
+)DOC")
+    .Arg("table", "name of the table (required)")
+    .Input(0, "client", "unique_ptr<ParameterServerClient>")
+    .Input(1, "indices", "int32 or int64 ids of the rows")
+    .Output(0, "rows", "[len(indices), dim] rows of the table");
+
+PSPushGradsOp::PSPushGradsOp(const OperatorDef& operator_def, Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      table_(GetSingleArgument<std::string>("table", "")),
+      epsilon_(GetSingleArgument<float>("epsilon", 1e-5f)),
+      decay_(GetSingleArgument<float>("decay", 1.0f)) {
+  CAFFE_ENFORCE_NE(table_, "", "table is a required argument");
+}
+
+bool PSPushGradsOp::RunOnDevice() {
+  return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+      this, Input(INDICES));
+}
+
+template <typename T>
+bool PSPushGradsOp::DoRunWithType() {
+  auto* client =
+      OperatorBase::Input<std::unique_ptr<ParameterServerClient>>(CLIENT)
+          .get();
+  const auto& indices = Input(INDICES);
+  const auto& grad = Input(GRAD);
+  const auto& lr = Input(LR);
+  CAFFE_ENFORCE_EQ(indices.ndim(), 1, "INDICES must be a vector");
+  CAFFE_ENFORCE_GE(grad.ndim(), 1);
+  CAFFE_ENFORCE_EQ(grad.dim(0), indices.size());
+  CAFFE_ENFORCE_EQ(lr.size(), 1);
+  client->push(
+      table_,
+      int64Ids<T>(indices, &ids_),
+      indices.size(),
+      grad.data<float>(),
+      grad.size_from_dim(1),
+      lr.data<float>()[0],
+      epsilon_,
+      decay_);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(PSPushGrads, PSPushGradsOp);
+OPERATOR_SCHEMA(PSPushGrads)
+    .NumInputs(4)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Sends gradients of rows of a table to the parameter server, which applies them
+with Adagrad (or row-wise Adagrad, depending on the table's moment), as
+SparseAdagrad would. The op returns once the gradients are sent; up to
+max_pending pushes per shard may be unacknowledged, and errors of a push are
+raised by a later op of the same client. Use PSFlush to wait for all of them.
+)DOC")
+    .Arg("table", "name of the table (required)")
+    .Arg("epsilon", "Adagrad epsilon (optional, default: 1e-5)")
+    .Arg("decay", "Adagrad moment decay (optional, default: 1.0)")
+    .Input(0, "client", "unique_ptr<ParameterServerClient>")
+    .Input(1, "indices", "int32 or int64 ids of the rows")
+    .Input(2, "grad", "[len(indices), dim] gradients of the rows")
+    .Input(3, "lr", "learning rate");
+
+PSFlushOp::PSFlushOp(const OperatorDef& operator_def, Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws) {}
+
+bool PSFlushOp::RunOnDevice() {
+  OperatorBase::Input<std::unique_ptr<ParameterServerClient>>(CLIENT)->flush();
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(PSFlush, PSFlushOp);
+OPERATOR_SCHEMA(PSFlush)
+    .NumInputs(1)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Waits until the parameter server has applied all the gradients pushed by the
+client.
+)DOC")
+    .Input(0, "client", "unique_ptr<ParameterServerClient>");
+
+NO_GRADIENT(CreateParameterServer);
+NO_GRADIENT(CreateParameterServerClient);
+NO_GRADIENT(PSPullRows);
+NO_GRADIENT(PSPushGrads);
+NO_GRADIENT(PSFlush);
+
+} // namespace caffe2
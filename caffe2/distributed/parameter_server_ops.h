@@ -0,0 +1,88 @@
+#pragma once
+
+#include "parameter_server.h"
+
+#include <caffe2/core/operator.h>
+
+namespace caffe2 {
+
+class CreateParameterServerOp final : public Operator<CPUContext> {
+ public:
+  CreateParameterServerOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  std::vector<std::string> tables_;
+  int port_;
+  std::vector<Blob*> blobs_;
+
+  OUTPUT_TAGS(SERVER, PORT);
+};
+
+class CreateParameterServerClientOp final : public Operator<CPUContext> {
+ public:
+  CreateParameterServerClientOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  std::vector<std::string> endpoints_;
+  int maxPending_;
+
+  OUTPUT_TAGS(CLIENT);
+};
+
+class PSPullRowsOp final : public Operator<CPUContext> {
+ public:
+  PSPullRowsOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
+  template <typename T>
+  bool DoRunWithType();
+
+ private:
+  std::string table_;
+  std::vector<int64_t> ids_;
+
+  INPUT_TAGS(CLIENT, INDICES);
+  OUTPUT_TAGS(ROWS);
+};
+
+class PSPushGradsOp final : public Operator<CPUContext> {
+ public:
+  PSPushGradsOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
+  template <typename T>
+  bool DoRunWithType();
+
+ private:
+  std::string table_;
+  float epsilon_;
+  float decay_;
+  std::vector<int64_t> ids_;
+
+  INPUT_TAGS(CLIENT, INDICES, GRAD, LR);
+};
+
+class PSFlushOp final : public Operator<CPUContext> {
+ public:
+  PSFlushOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(CLIENT);
+};
+
+} // namespace caffe2
@@ -3,11 +3,38 @@
 #include <caffe2/core/logging.h>
 
 #include <chrono>
+#include <memory>
 #include <thread>
 #include <vector>
 
 namespace caffe2 {
 
+namespace {
+
+using RedisReply = std::unique_ptr<redisReply, void (*)(void*)>;
+
+RedisReply takeReply(redisContext* redis, void* ptr) {
+  CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis->errstr);
+  return RedisReply(static_cast<redisReply*>(ptr), freeReplyObject);
+}
+
+RedisReply commandArgv(
+    redisContext* redis,
+    const std::vector<std::string>& args) {
+  std::vector<const char*> argv;
+  std::vector<size_t> argvlen;
+  for (const auto& arg : args) {
+    argv.push_back(arg.c_str());
+    argvlen.push_back(arg.length());
+  }
+
+  auto argc = argv.size();
+  return takeReply(
+      redis, redisCommandArgv(redis, argc, argv.data(), argvlen.data()));
+}
+
+} // namespace
+
 RedisStoreHandler::RedisStoreHandler(
     std::string& host,
     int port,
@@ -31,44 +58,87 @@ std::string RedisStoreHandler::compoundKey(const std::string& name) {
 }
 
 void RedisStoreHandler::set(const std::string& name, const std::string& data) {
-  auto key = compoundKey(name);
-  void* ptr = redisCommand(
-      redis_,
-      "SETNX %b %b",
-      key.c_str(),
-      (size_t)key.size(),
-      data.c_str(),
-      (size_t)data.size());
-  CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis_->errstr);
-  redisReply* reply = static_cast<redisReply*>(ptr);
-  CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_INTEGER);
-  CAFFE_ENFORCE_EQ(
-      reply->integer,
-      1,
-      "Value at ",
-      name,
-      " was already set",
-      " (perhaps you reused a run ID you have used before?)");
+  multiSet({name}, {data});
+}
+
+void RedisStoreHandler::multiSet(
+    const std::vector<std::string>& names,
+    const std::vector<std::string>& data) {
+  CAFFE_ENFORCE_EQ(names.size(), data.size());
+  // Pipeline the commands: send all of them, then read all replies.
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto key = compoundKey(names[i]);
+    auto rv = redisAppendCommand(
+        redis_,
+        "SETNX %b %b",
+        key.c_str(),
+        (size_t)key.size(),
+        data[i].c_str(),
+        (size_t)data[i].size());
+    CAFFE_ENFORCE_EQ(rv, REDIS_OK, redis_->errstr);
+  }
+  for (size_t i = 0; i < names.size(); ++i) {
+    void* ptr = nullptr;
+    redisGetReply(redis_, &ptr);
+    auto reply = takeReply(redis_, ptr);
+    CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_INTEGER);
+    CAFFE_ENFORCE_EQ(
+        reply->integer,
+        1,
+        "Value at ",
+        names[i],
+        " was already set",
+        " (perhaps you reused a run ID you have used before?)");
+    cache_[names[i]] = data[i];
+  }
 }
 
 std::string RedisStoreHandler::get(const std::string& name) {
-  // Block until key is set
-  wait({name});
+  return multiGet({name})[0];
+}
 
-  auto key = compoundKey(name);
-  void* ptr = redisCommand(redis_, "GET %b", key.c_str(), (size_t)key.size());
-  CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis_->errstr);
-  redisReply* reply = static_cast<redisReply*>(ptr);
-  CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_STRING);
-  return std::string(reply->str, reply->len);
+std::vector<std::string> RedisStoreHandler::multiGet(
+    const std::vector<std::string>& names) {
+  std::vector<std::string> missing;
+  for (const auto& name : names) {
+    if (!cache_.count(name)) {
+      missing.push_back(name);
+    }
+  }
+
+  if (!missing.empty()) {
+    // Block until keys are set
+    wait(missing);
+
+    std::vector<std::string> args;
+    args.push_back("MGET");
+    for (const auto& name : missing) {
+      args.push_back(compoundKey(name));
+    }
+    auto reply = commandArgv(redis_, args);
+    CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_ARRAY);
+    CAFFE_ENFORCE_EQ(reply->elements, missing.size());
+    for (size_t i = 0; i < missing.size(); ++i) {
+      const auto* element = reply->element[i];
+      CAFFE_ENFORCE_EQ(element->type, REDIS_REPLY_STRING);
+      cache_[missing[i]] = std::string(element->str, element->len);
+    }
+  }
+
+  std::vector<std::string> data;
+  data.reserve(names.size());
+  for (const auto& name : names) {
+    data.push_back(cache_.at(name));
+  }
+  return data;
 }
 
 int64_t RedisStoreHandler::add(const std::string& name, int64_t value) {
   auto key = compoundKey(name);
-  void* ptr = redisCommand(
-      redis_, "INCRBY %b %ld", key.c_str(), (size_t)key.size(), value);
-  CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis_->errstr);
-  redisReply* reply = static_cast<redisReply*>(ptr);
+  auto reply = takeReply(
+      redis_,
+      redisCommand(
+          redis_, "INCRBY %b %ld", key.c_str(), (size_t)key.size(), value));
   CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_INTEGER);
   return reply->integer;
 }
@@ -77,22 +147,17 @@ bool RedisStoreHandler::check(const std::vector<std::string>& names) {
   std::vector<std::string> args;
   args.push_back("EXISTS");
   for (const auto& name : names) {
-    args.push_back(compoundKey(name));
+    if (!cache_.count(name)) {
+      args.push_back(compoundKey(name));
+    }
   }
-
-  std::vector<const char*> argv;
-  std::vector<size_t> argvlen;
-  for (const auto& arg : args) {
-    argv.push_back(arg.c_str());
-    argvlen.push_back(arg.length());
+  if (args.size() == 1) {
+    return true;
   }
 
-  auto argc = argv.size();
-  void* ptr = redisCommandArgv(redis_, argc, argv.data(), argvlen.data());
-  CAFFE_ENFORCE_NE(ptr, (void*)nullptr, redis_->errstr);
-  redisReply* reply = static_cast<redisReply*>(ptr);
+  auto reply = commandArgv(redis_, args);
   CAFFE_ENFORCE_EQ(reply->type, REDIS_REPLY_INTEGER);
-  return reply->integer == names.size();
+  return reply->integer == args.size() - 1;
 }
 
 void RedisStoreHandler::wait(
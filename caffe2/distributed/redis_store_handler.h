@@ -7,6 +7,7 @@ extern "C" {
 }
 
 #include <string>
+#include <unordered_map>
 
 namespace caffe2 {
 
@@ -19,6 +20,13 @@ class RedisStoreHandler : public StoreHandler {
 
   virtual std::string get(const std::string& name) override;
 
+  virtual void multiSet(
+      const std::vector<std::string>& names,
+      const std::vector<std::string>& data) override;
+
+  virtual std::vector<std::string> multiGet(
+      const std::vector<std::string>& names) override;
+
   virtual int64_t add(const std::string& name, int64_t value) override;
 
   virtual bool check(const std::vector<std::string>& names) override;
@@ -34,6 +42,10 @@ class RedisStoreHandler : public StoreHandler {
 
   redisContext* redis_;
 
+  // Keys can only be set once, so values seen by this handler stay valid
+  // and are served locally instead of with another round trip.
+  std::unordered_map<std::string, std::string> cache_;
+
   std::string compoundKey(const std::string& name);
 };
 
@@ -30,6 +30,23 @@ class StoreHandler {
    */
   virtual std::string get(const std::string& name) = 0;
 
+  /*
+   * Set data for multiple keys, with the semantics of set() for each key.
+   * The default implementation calls set() for each key; stores that can
+   * batch the requests should override it.
+   */
+  virtual void multiSet(
+      const std::vector<std::string>& names,
+      const std::vector<std::string>& data);
+
+  /*
+   * Get the data for multiple keys, waiting until all of them are stored.
+   * The default implementation calls get() for each key; stores that can
+   * batch the requests should override it.
+   */
+  virtual std::vector<std::string> multiGet(
+      const std::vector<std::string>& names);
+
   /*
    * Does an atomic add operation on the key and returns the latest updated
    * value.
@@ -8,25 +8,40 @@ constexpr auto kAddValue = "add_value";
 StoreSetOp::StoreSetOp(const OperatorDef& operator_def, Workspace* ws)
     : Operator<CPUContext>(operator_def, ws),
       blobName_(
-          GetSingleArgument<std::string>(kBlobName, operator_def.input(DATA))) {
+          GetSingleArgument<std::string>(kBlobName, operator_def.input(DATA))),
+      blobNames_(
+          operator_def.input().begin() + DATA,
+          operator_def.input().end()) {
+  CAFFE_ENFORCE(
+      InputSize() == 2 || !HasArgument(kBlobName),
+      "blob_name can only be specified for a single blob");
 }
 
 bool StoreSetOp::RunOnDevice() {
   // Serialize and pass to store
   auto* handler =
       OperatorBase::Input<std::unique_ptr<StoreHandler>>(HANDLER).get();
-  handler->set(blobName_, InputBlob(DATA).Serialize(blobName_));
+  if (InputSize() == 2) {
+    handler->set(blobName_, InputBlob(DATA).Serialize(blobName_));
+    return true;
+  }
+  std::vector<std::string> data;
+  for (int i = DATA; i < InputSize(); ++i) {
+    data.push_back(InputBlob(i).Serialize(blobNames_[i - DATA]));
+  }
+  handler->multiSet(blobNames_, data);
   return true;
 }
 
 REGISTER_CPU_OPERATOR(StoreSet, StoreSetOp);
 OPERATOR_SCHEMA(StoreSet)
-    .NumInputs(2)
+    .NumInputs(2, INT_MAX)
     .NumOutputs(0)
     .SetDoc(R"DOC(
 Set a blob in a store. The key is the input blob's name and the value
 is the data in that blob. The key can be overridden by specifying the
-'blob_name' argument.
+'blob_name' argument. When several blobs are given, they are all set in one
+batch, keyed by their names.
 )DOC")
     .Arg("blob_name", "alternative key for the blob (optional)")
     .Input(0, "handler", "unique_ptr<StoreHandler>")
@@ -36,23 +51,36 @@ StoreGetOp::StoreGetOp(const OperatorDef& operator_def, Workspace* ws)
     : Operator<CPUContext>(operator_def, ws),
       blobName_(GetSingleArgument<std::string>(
           kBlobName,
-          operator_def.output(DATA))) {}
+          operator_def.output(DATA))),
+      blobNames_(operator_def.output().begin(), operator_def.output().end()) {
+  CAFFE_ENFORCE(
+      OutputSize() == 1 || !HasArgument(kBlobName),
+      "blob_name can only be specified for a single blob");
+}
 
 bool StoreGetOp::RunOnDevice() {
   // Get from store and deserialize
   auto* handler =
       OperatorBase::Input<std::unique_ptr<StoreHandler>>(HANDLER).get();
-  OperatorBase::Outputs()[DATA]->Deserialize(handler->get(blobName_));
+  if (OutputSize() == 1) {
+    OperatorBase::Outputs()[DATA]->Deserialize(handler->get(blobName_));
+    return true;
+  }
+  const auto data = handler->multiGet(blobNames_);
+  for (int i = 0; i < OutputSize(); ++i) {
+    OperatorBase::Outputs()[i]->Deserialize(data[i]);
+  }
   return true;
 }
 
 REGISTER_CPU_OPERATOR(StoreGet, StoreGetOp);
 OPERATOR_SCHEMA(StoreGet)
     .NumInputs(1)
-    .NumOutputs(1)
+    .NumOutputs(1, INT_MAX)
     .SetDoc(R"DOC(
 Get a blob from a store. The key is the output blob's name. The key
-can be overridden by specifying the 'blob_name' argument.
+can be overridden by specifying the 'blob_name' argument. When several
+outputs are given, they are all fetched in one batch, keyed by their names.
 )DOC")
     .Arg("blob_name", "alternative key for the blob (optional)")
     .Input(0, "handler", "unique_ptr<StoreHandler>")
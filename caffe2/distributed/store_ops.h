@@ -13,6 +13,8 @@ class StoreSetOp final : public Operator<CPUContext> {
 
  private:
   std::string blobName_;
+  // keys of all data blobs, when several are set at once
+  std::vector<std::string> blobNames_;
 
   INPUT_TAGS(HANDLER, DATA);
 };
@@ -24,6 +26,8 @@ class StoreGetOp final : public Operator<CPUContext> {
 
  private:
   std::string blobName_;
+  // keys of all data blobs, when several are fetched at once
+  std::vector<std::string> blobNames_;
 
   INPUT_TAGS(HANDLER);
   OUTPUT_TAGS(DATA);
@@ -68,6 +68,24 @@ class StoreOpsTests(object):
         if not queue.empty():
             raise queue.get()
 
+    @classmethod
+    def test_multi_set_get(cls, create_store_handler_fn):
+        store_handler = create_store_handler_fn()
+        blobs = ["blob_{}".format(i) for i in range(3)]
+        for i, blob in enumerate(blobs):
+            workspace.FeedBlob(blob, np.full(1, i, np.float32))
+        workspace.RunOperatorOnce(
+            core.CreateOperator("StoreSet", [store_handler] + blobs, []))
+
+        # Overwrite the local blobs and read them back in a different order
+        for blob in blobs:
+            workspace.FeedBlob(blob, np.full(1, -1, np.float32))
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "StoreGet", [store_handler], list(reversed(blobs))))
+        for i, blob in enumerate(blobs):
+            np.testing.assert_array_equal(workspace.FetchBlob(blob), i)
+
     @classmethod
     def test_get_timeout(cls, create_store_handler_fn):
         store_handler = create_store_handler_fn()
@@ -15,9 +15,13 @@ OPERATOR_SCHEMA(ImageInput)
           int crop = helper.GetSingleArgument<int>("crop", -1);
           int color = helper.GetSingleArgument<int>("color", 1);
           CHECK_GT(crop, 0);
+          // a CPU op with use_gpu_transform outputs the raw uint8 images
+          bool uint8_output =
+              helper.GetSingleArgument<int>("use_gpu_transform", 0) &&
+              def.device_option().device_type() == CPU;
           out[0] = CreateTensorShape(
               vector<int>{batch_size, crop, crop, color ? 3 : 1},
-              TensorProto::FLOAT);
+              uint8_output ? TensorProto::UINT8 : TensorProto::FLOAT);
           out[1] =
               CreateTensorShape(vector<int>{1, batch_size}, TensorProto::INT32);
           return out;
@@ -85,9 +89,16 @@ The dimension of the output image will always be cropxcrop
     .ArgIsTest("Set to 1 to do deterministic cropping. Defaults to 0")
     .Arg("use_caffe_datum", "1 if the input is in Caffe format. Defaults to 0")
     .Arg("use_gpu_transform", "1 if GPU acceleration should be used."
-         " Defaults to 0. Can only be 1 in a CUDAContext")
+         " Defaults to 0. In a CPU op, outputs the cropped images as uint8"
+         " NHWC without normalization, so that it can be done by the"
+         " consumer (e.g. on the GPU). Color jitter and lighting are not"
+         " applied")
     .Arg("decode_threads", "Number of CPU decode/transform threads."
-         " Defaults to 4")
+         " Defaults to 4. The threads are bound to the NUMA node of the"
+         " op's device option, if any")
+    .Arg("db_prefetch", "Number of records read ahead in a background thread"
+         " when the op creates its own db reader. Defaults to 0 (no read"
+         " ahead)")
     .Arg("output_type", "If gpu_transform, can set to FLOAT or FLOAT16.")
     .Arg("db", "Name of the database (if not passed as input)")
     .Arg("db_type", "Type of database (if not passed as input)."
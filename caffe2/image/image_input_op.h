@@ -192,7 +192,11 @@ ImageInputOp<Context>::ImageInputOp(
           0)),
       num_decode_threads_(
           OperatorBase::template GetSingleArgument<int>("decode_threads", 4)),
-      thread_pool_(std::make_shared<TaskThreadPool>(num_decode_threads_)),
+      // the decode threads run next to the memory of the NUMA node the op
+      // is placed on
+      thread_pool_(std::make_shared<TaskThreadPool>(
+          num_decode_threads_,
+          operator_def.device_option().numa_node_id())),
       // output type only supported with CUDA and use_gpu_transform for now
       output_type_(
           cast::GetCastDataType(ArgumentHelper(operator_def), "output_type")),
@@ -238,6 +242,13 @@ ImageInputOp<Context>::ImageInputOp(
             "db_type", "leveldb"),
         db_name));
     reader_ = owned_reader_.get();
+    // read the records ahead in the background, so that reading overlaps
+    // with the decoding of the previous records
+    const int db_prefetch =
+        OperatorBase::template GetSingleArgument<int>("db_prefetch", 0);
+    if (db_prefetch > 0) {
+      owned_reader_->StartPrefetch(db_prefetch);
+    }
   }
 
   // hard-coded PCA eigenvectors and eigenvalues, based on RBG channel order
@@ -309,7 +320,12 @@ ImageInputOp<Context>::ImageInputOp(
   LOG(INFO) << "Creating an image input op with the following setting: ";
   LOG(INFO) << "    Using " << num_decode_threads_ << " CPU threads;";
   if (gpu_transform_) {
-    LOG(INFO) << "    Performing transformation on GPU";
+    if (std::is_same<Context, CPUContext>::value) {
+      LOG(INFO) << "    Outputting uint8 NHWC images, normalization is left "
+                   "to the consumer;";
+    } else {
+      LOG(INFO) << "    Performing transformation on GPU";
+    }
   }
   LOG(INFO) << "    Outputting in batches of " << batch_size_ << " images;";
   LOG(INFO) << "    Treating input image as "
@@ -1086,8 +1102,11 @@ bool ImageInputOp<Context>::Prefetch() {
     std::string key, value;
     cv::Mat img;
 
-    // read data
-    reader_->Read(&key, &value);
+    // read data, the value is copied once as it outlives the cursor's view
+    // in the decoding task
+    reader_->ReadView(&key, [&value](const db::ValueView& view) {
+      value.assign(view.data, view.size);
+    });
 
     // determine label type based on first item
     if( item_id == 0 ) {
@@ -1133,7 +1152,7 @@ bool ImageInputOp<Context>::Prefetch() {
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransposeOnly,
           this,
-          std::string(value),
+          std::move(value),
           image_data,
           item_id,
           channels,
@@ -1144,7 +1163,7 @@ bool ImageInputOp<Context>::Prefetch() {
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransform,
           this,
-          std::string(value),
+          std::move(value),
           image_data,
           item_id,
           channels,
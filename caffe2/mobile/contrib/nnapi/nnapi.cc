@@ -5,6 +5,8 @@
 
 #include "nnapi.h"
 
+#include <set>
+
 namespace {
 // Bug: ANEURALNETWORKS_UNMAPPABLE and ANEURALNETWORKS_OP_FAILED share the same
 // enum value
@@ -61,6 +63,8 @@ bool NNApi::run(const TensorVector& inputs, TensorVector* outputs) {
   }
 
   try {
+    // The compiled model is kept, but an execution only computes once
+    setupExecution(inputs, outputs);
     VLOG(1) << "Start compute";
     int result_code =
         libnnapi_.ANeuralNetworksExecution_startCompute(run_, &run_end_);
@@ -74,8 +78,60 @@ bool NNApi::run(const TensorVector& inputs, TensorVector* outputs) {
     VLOG(1) << "Finish compute";
   } catch (const std::exception& e) {
     LOG(ERROR) << "Error during model run: " << e.what();
+    freeExecution();
     return false;
   }
+  freeExecution();
+  return true;
+}
+
+bool NNApi::isSupported(const OperatorDef& op) {
+  static const std::set<std::string> supported_types{
+      "AveragePool", "Conv", "MaxPool", "Relu", "Softmax"};
+  if (supported_types.count(op.type()) == 0 || op.input_size() < 1 ||
+      op.output_size() != 1) {
+    return false;
+  }
+  // operands are identified by blob names, so ops can't be in place
+  for (const auto& input : op.input()) {
+    if (input == op.output(0)) {
+      return false;
+    }
+  }
+
+  ArgumentHelper helper(op);
+  if (op.type() == "Relu") {
+    return true;
+  }
+  if (op.type() == "Softmax") {
+    return helper.GetSingleArgument<int>("axis", 1) == 1;
+  }
+
+  // Conv and pooling
+  StorageOrder order = StringToStorageOrder(
+      helper.GetSingleArgument<std::string>("order", "NCHW"));
+  if (order != NHWC) {
+    return false;
+  }
+  ConvPoolArgs args;
+  getConvPoolArgs(helper, args);
+  if (args.stride_x != args.stride_y) {
+    return false;
+  }
+  if (op.type() == "Conv") {
+    if (op.input_size() != 3) {
+      return false;
+    }
+    std::vector<int> dilation(helper.GetRepeatedArgument<int>("dilations"));
+    dilation.push_back(helper.GetSingleArgument<int>("dilation", 1));
+    dilation.push_back(helper.GetSingleArgument<int>("dilation_h", 1));
+    dilation.push_back(helper.GetSingleArgument<int>("dilation_w", 1));
+    for (auto d : dilation) {
+      if (d != 1) {
+        return false;
+      }
+    }
+  }
   return true;
 }
 
@@ -642,74 +698,203 @@ void NNApi::init(const TensorVector& inputs, TensorVector* outputs) {
 
       LOG(INFO) << "Finish compilation";
     }
+  }
+}
 
-    // pre-execution
-    if (!run_) {
-      result_code =
-          libnnapi_.ANeuralNetworksExecution_create(compilation_, &run_);
-      if (result_code != ANEURALNETWORKS_NO_ERROR) {
-        reportError(result_code);
-      }
-      LOG(INFO) << "Created model execution";
+void NNApi::setupExecution(const TensorVector& inputs, TensorVector* outputs) {
+  int result_code =
+      libnnapi_.ANeuralNetworksExecution_create(compilation_, &run_);
+  if (result_code != ANEURALNETWORKS_NO_ERROR) {
+    reportError(result_code);
+  }
+  VLOG(1) << "Created model execution";
+
+  // set external input and output
+  for (int i = 0; i < inputs.size(); i++) {
+    result_code = libnnapi_.ANeuralNetworksExecution_setInput(
+        run_, i, NULL, inputs[i]->raw_data(), inputs[i]->nbytes());
+    if (result_code != ANEURALNETWORKS_NO_ERROR) {
+      reportError(result_code);
     }
 
-    // set external input and output
-    for (int i = 0; i < inputs.size(); i++) {
-      result_code = libnnapi_.ANeuralNetworksExecution_setInput(
-          run_, i, NULL, inputs[i]->raw_data(), inputs[i]->size());
-      if (result_code != ANEURALNETWORKS_NO_ERROR) {
-        reportError(result_code);
-      }
+    VLOG(1) << "Set external input " << i << " at " << inputs[i]->raw_data()
+            << ", size = " << inputs[i]->size();
+  }
+  // allocate memory for outputs
+  int output_size = run_net_.external_output_size();
+  for (int i = 0; i < output_size; i++) {
+    const std::string& blob = run_net_.external_output(i);
+    if (operand_map_.find(blob) == operand_map_.end()) {
+      CAFFE_THROW("Unknown external output, ", blob);
+    }
+    if (tensor_dims_.find(blob) == tensor_dims_.end()) {
+      CAFFE_THROW("Operand dimension unknown");
+    }
+    std::vector<int> output_dims;
+    for (auto dim : tensor_dims_[blob]) {
+      output_dims.push_back(dim);
+    }
 
-      VLOG(1) << "Set external input " << i << " at " << inputs[i]->raw_data()
-              << ", size = " << inputs[i]->size();
+    auto* tensor = ws_.CreateBlob(blob)->GetMutable<TensorCPU>();
+    tensor->Resize(output_dims);
+    outputs->push_back(tensor);
+
+    void* data = tensor_type_ == ANEURALNETWORKS_TENSOR_FLOAT32
+        ? (void*)tensor->template mutable_data<float>()
+        : (void*)tensor->template mutable_data<uint8_t>();
+    result_code = libnnapi_.ANeuralNetworksExecution_setOutput(
+        run_, i, NULL, data, tensor->nbytes());
+    if (result_code != ANEURALNETWORKS_NO_ERROR) {
+      reportError(result_code);
     }
-    // allocate memory for outputs
-    for (int i = 0; i < output_size; i++) {
-      const std::string& blob = run_net_.external_output(i);
-      if (operand_map_.find(blob) == operand_map_.end()) {
-        CAFFE_THROW("Unknown external output, ", blob);
+
+    VLOG(1) << "Set external output " << i << " at " << tensor->raw_data()
+            << ", size = " << tensor->size();
+  }
+}
+
+void NNApi::freeExecution() {
+  if (run_end_) {
+    libnnapi_.ANeuralNetworksEvent_free(run_end_);
+    run_end_ = nullptr;
+  }
+  if (run_) {
+    libnnapi_.ANeuralNetworksExecution_free(run_);
+    run_ = nullptr;
+  }
+}
+
+NNApiPartitionedNet::NNApiPartitionedNet(
+    const NetDef& init_net,
+    const NetDef& run_net,
+    Workspace* ws,
+    const PreferenceCode pref)
+    : run_net_(run_net), ws_(ws) {
+  CAFFE_ENFORCE(ws_.RunNetOnce(init_net));
+  for (const auto& input : run_net_.external_input()) {
+    ws_.CreateBlob(input);
+  }
+
+  // maximal runs of consecutive ops that NN API supports, or doesn't
+  for (int i = 0; i < run_net_.op_size(); i++) {
+    const auto& op = run_net_.op(i);
+    const bool nnapi = NNApi::isSupported(op);
+    if (partitions_.empty() || partitions_.back().nnapi != nnapi) {
+      partitions_.emplace_back();
+      partitions_.back().nnapi = nnapi;
+      partitions_.back().begin = i;
+    }
+    partitions_.back().end = i + 1;
+  }
+
+  for (size_t p = 0; p < partitions_.size(); p++) {
+    auto& partition = partitions_[p];
+    auto& net = partition.net;
+    net.set_name(run_net_.name() + "_partition_" + caffe2::to_string(p));
+    std::set<std::string> produced;
+    std::set<std::string> inputs;
+    for (int i = partition.begin; i < partition.end; i++) {
+      const auto& op = run_net_.op(i);
+      net.add_op()->CopyFrom(op);
+      // NN API takes the weights as constants from the workspace, so only
+      // the data inputs are model inputs
+      const int num_inputs = partition.nnapi ? 1 : op.input_size();
+      for (int j = 0; j < num_inputs; j++) {
+        const auto& input = op.input(j);
+        if (!produced.count(input) && inputs.insert(input).second) {
+          net.add_external_input(input);
+        }
       }
-      uint32_t idx = operand_map_[blob];
-      if (tensor_dims_.find(blob) == tensor_dims_.end()) {
-        CAFFE_THROW("Operand dimension unknown");
+      for (const auto& output : op.output()) {
+        produced.insert(output);
+        // read by the following partitions through the workspace
+        ws_.CreateBlob(output);
       }
-      std::vector<int> output_dims;
-      for (auto dim : tensor_dims_[blob]) {
-        output_dims.push_back(dim);
+    }
+    // the outputs read after the partition
+    std::set<std::string> used_after(
+        run_net_.external_output().begin(), run_net_.external_output().end());
+    for (int i = partition.end; i < run_net_.op_size(); i++) {
+      for (const auto& input : run_net_.op(i).input()) {
+        used_after.insert(input);
       }
+    }
+    for (int i = partition.begin; i < partition.end; i++) {
+      const auto& output = run_net_.op(i).output(0);
+      if (used_after.count(output)) {
+        net.add_external_output(output);
+        used_after.erase(output);
+      }
+    }
+    if (net.external_output_size() == 0) {
+      net.add_external_output(run_net_.op(partition.end - 1).output(0));
+    }
 
-      auto* tensor = ws_.CreateBlob(blob)->GetMutable<TensorCPU>();
-      tensor->Resize(output_dims);
-      outputs->push_back(tensor);
-
-      if (tensor_type_ == ANEURALNETWORKS_TENSOR_FLOAT32) {
-        result_code = libnnapi_.ANeuralNetworksExecution_setOutput(
-            run_,
-            i,
-            NULL,
-            (void*)tensor->template mutable_data<float>(),
-            tensor->size());
-        if (result_code != ANEURALNETWORKS_NO_ERROR) {
-          reportError(result_code);
-        }
-
-      } else {
-        result_code = libnnapi_.ANeuralNetworksExecution_setOutput(
-            run_,
-            i,
-            NULL,
-            (void*)tensor->template mutable_data<uint8_t>(),
-            tensor->size());
-        if (result_code != ANEURALNETWORKS_NO_ERROR) {
-          reportError(result_code);
-        }
+    if (partition.nnapi) {
+      try {
+        partition.model.reset(new NNApi(NetDef(), net, &ws_, pref));
+      } catch (const std::exception& e) {
+        LOG(WARNING) << "Running " << net.name()
+                     << " on the CPU: " << e.what();
+        partition.nnapi = false;
       }
+    }
+    if (!partition.nnapi) {
+      partition.cpu_net = ws_.CreateNet(net);
+      CAFFE_ENFORCE(partition.cpu_net, "Failed to create ", net.name());
+    }
+  }
+}
+
+bool NNApiPartitionedNet::run(
+    const TensorVector& inputs,
+    TensorVector* outputs) {
+  CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
+  for (int i = 0; i < inputs.size(); i++) {
+    auto* tensor =
+        ws_.GetBlob(run_net_.external_input(i))->GetMutable<TensorCPU>();
+    if (tensor != inputs[i]) {
+      tensor->ResizeLike(*inputs[i]);
+      tensor->ShareData(*inputs[i]);
+    }
+  }
 
-      VLOG(1) << "Set external output " << i << " at " << tensor->raw_data()
-              << ", size = " << tensor->size();
+  for (auto& partition : partitions_) {
+    if (partition.nnapi) {
+      TensorVector partition_inputs, partition_outputs;
+      for (const auto& input : partition.net.external_input()) {
+        partition_inputs.push_back(
+            ws_.GetBlob(input)->GetMutable<TensorCPU>());
+      }
+      if (partition.model->run(partition_inputs, &partition_outputs)) {
+        continue;
+      }
+      // e.g. shapes or arguments that the driver doesn't support
+      LOG(WARNING) << "Running " << partition.net.name() << " on the CPU";
+      partition.nnapi = false;
+      partition.model.reset();
+      partition.cpu_net = ws_.CreateNet(partition.net);
+      if (!partition.cpu_net) {
+        return false;
+      }
+    }
+    if (!partition.cpu_net->Run()) {
+      return false;
     }
   }
+
+  for (const auto& output : run_net_.external_output()) {
+    outputs->push_back(ws_.GetBlob(output)->GetMutable<TensorCPU>());
+  }
+  return true;
+}
+
+size_t NNApiPartitionedNet::numNNApiPartitions() const {
+  size_t count = 0;
+  for (const auto& partition : partitions_) {
+    count += partition.nnapi;
+  }
+  return count;
 }
 
 } // namespace caffe2
@@ -37,6 +37,9 @@ class NNApi {
 
   bool run(const TensorVector& inputs, TensorVector* outputs);
 
+  // Whether the operator can be added to a model, judging from its arguments
+  static bool isSupported(const OperatorDef& op);
+
  private:
   dlnnapi libnnapi_;
   ANeuralNetworksModel* model_{nullptr};
@@ -80,7 +83,9 @@ class NNApi {
     int pad_r{0};
   };
 
-  void getConvPoolArgs(const ArgumentHelper& helper, ConvPoolArgs& args);
+  static void getConvPoolArgs(
+      const ArgumentHelper& helper,
+      ConvPoolArgs& args);
 
   uint32_t addScalarOperand(int32_t val);
 
@@ -93,9 +98,14 @@ class NNApi {
       float scale = 1.0,
       int32_t zero_point = 0);
 
-  // lazily initialize model_ in run()
+  // lazily initialize model_ and compilation_ in run()
   void init(const TensorVector& inputs, TensorVector* outputs);
 
+  // create run_ with the inputs and outputs of a single run
+  void setupExecution(const TensorVector& inputs, TensorVector* outputs);
+
+  void freeExecution();
+
   void addConv(const OperatorDef& op, bool fuse_relu = false);
 
   void addPooling(
@@ -107,4 +117,43 @@ class NNApi {
 
   void addSoftmax(const OperatorDef& op);
 };
+
+// Runs a net that NN API only partly supports. The maximal runs of
+// consecutive supported operators become NN API models, compiled once and
+// kept across runs, and the operators in between run on the CPU. The
+// partitions exchange blobs of the shared workspace, which NN API reads and
+// writes in place.
+class NNApiPartitionedNet {
+ public:
+  using TensorVector = NNApi::TensorVector;
+
+  NNApiPartitionedNet(
+      const NetDef& init_net,
+      const NetDef& run_net,
+      Workspace* ws = nullptr,
+      const PreferenceCode pref = ANEURALNETWORKS_PREFER_SUSTAINED_SPEED);
+
+  // inputs are the first external inputs of run_net, and outputs are set to
+  // all its external outputs
+  bool run(const TensorVector& inputs, TensorVector* outputs);
+
+  // The partitions falling back to the CPU, because NN API failed to build
+  // or run them, are not counted.
+  size_t numNNApiPartitions() const;
+
+ private:
+  struct Partition {
+    bool nnapi;
+    // ops [begin, end) of run_net_
+    int begin;
+    int end;
+    NetDef net;
+    std::unique_ptr<NNApi> model;
+    NetBase* cpu_net{nullptr};
+  };
+
+  NetDef run_net_;
+  Workspace ws_;
+  std::vector<Partition> partitions_;
+};
 } // namespace caffe2
@@ -637,6 +637,96 @@ TEST(NNApi, TestSoftmax) {
   // test_softmax(5, 17, 13, 13);
 }
 
+TEST(NNApi, TestPartitionedNet) {
+  Workspace ws;
+  {
+    auto* t = ws.CreateBlob("X_cpu")->GetMutable<TensorCPU>();
+    t->Resize(1, 26, 26, 8);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(
+        t->size(), 0, 30, t->mutable_data<float>(), &ctx);
+  }
+  {
+    auto* t = ws.CreateBlob("W")->GetMutable<TensorCPU>();
+    t->Resize(16, 3, 3, 8);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(
+        t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+  }
+  {
+    auto* t = ws.CreateBlob("B")->GetMutable<TensorCPU>();
+    t->Resize(16);
+    CPUContext ctx;
+    math::RandGaussian<float, CPUContext>(
+        t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+  }
+
+  // Conv + Relu on NN API, Sigmoid on the CPU, then MaxPool on NN API
+  NetDef netdef;
+  netdef.set_name("partitioned");
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Conv");
+    op.add_input("X_cpu");
+    op.add_input("W");
+    op.add_input("B");
+    op.add_output("conv");
+    op.add_arg()->CopyFrom(MakeArgument<std::string>("order", "NHWC"));
+    op.add_arg()->CopyFrom(MakeArgument<int>("kernel", 3));
+    op.add_arg()->CopyFrom(MakeArgument<int>("pad", 1));
+  }
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Relu");
+    op.add_input("conv");
+    op.add_output("relu");
+  }
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("Sigmoid");
+    op.add_input("relu");
+    op.add_output("sigmoid");
+  }
+  {
+    auto& op = *(netdef.add_op());
+    op.set_type("MaxPool");
+    op.add_input("sigmoid");
+    op.add_output("Y_cpu");
+    op.add_arg()->CopyFrom(MakeArgument<std::string>("order", "NHWC"));
+    op.add_arg()->CopyFrom(MakeArgument<int>("kernel", 2));
+    op.add_arg()->CopyFrom(MakeArgument<int>("stride", 2));
+  }
+  netdef.add_external_input("X_cpu");
+  netdef.add_external_input("W");
+  netdef.add_external_input("B");
+  netdef.add_external_output("Y_cpu");
+
+  ws.RunNetOnce(netdef);
+  TensorCPU t_cpu;
+  t_cpu.CopyFrom(ws.GetBlob("Y_cpu")->Get<TensorCPU>());
+
+  // NN API
+  for (int i = 0; i < netdef.op_size(); i++) {
+    auto* op = netdef.mutable_op(i);
+    op->set_output(0, op->output(0) + "_nn");
+    if (i > 0) {
+      op->set_input(0, op->input(0) + "_nn");
+    }
+  }
+  netdef.set_external_output(0, "Y_cpu_nn");
+  NetDef initNet;
+  NNApiPartitionedNet model(initNet, netdef, &ws);
+  EXPECT_EQ(model.numNNApiPartitions(), 2);
+  // the compiled models are reused
+  for (int run = 0; run < 2; run++) {
+    std::vector<TensorCPU*> inputs, outputs;
+    inputs.push_back(ws.GetBlob("X_cpu")->GetMutable<TensorCPU>());
+    EXPECT_TRUE(model.run(inputs, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    checkError(t_cpu, *outputs[0], 0.01);
+  }
+}
+
 } // namespace
 
 } // namespace caffe2
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "caffe2/core/net.h"
+
+namespace caffe2 {
+
+// Converts a CNN made of the operators in vulkan_ops.cc to run on a Vulkan
+// compute device. The operators of the net only record their shaders, and the
+// whole net is submitted at once by the final CopyFromVulkan.
+// On failure, returns false. On success, returns true, and sets the Vulkan
+// net in the output parameter.
+bool tryConvertToVulkan(
+    const NetDef& initNet,
+    const NetDef& predictNet,
+    NetDef* vulkanPredictNet);
+
+// Exposed for testing.
+NetDef rewriteForVulkan(const NetDef& net);
+bool isVulkanAvailable();
+} // namespace caffe2
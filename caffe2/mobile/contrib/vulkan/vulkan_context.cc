@@ -0,0 +1,554 @@
+#include "vulkan_context.h"
+#include "vulkan_shaders.h"
+
+#include "caffe2/core/blob.h"
+#include "caffe2/core/typeid.h"
+
+#include <cstring>
+#include <limits>
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(VulkanTensor);
+
+namespace {
+
+// The push constants of all the shaders fit in the minimum guaranteed size
+constexpr uint32_t kMaxPushConstantsSize = 128;
+constexpr uint32_t kDescriptorSetsPerPool = 256;
+constexpr uint32_t kMaxBuffersPerSet = 4;
+constexpr uint32_t kMaxWorkgroups = 65535;
+
+std::atomic<uint64_t> next_buffer_id{1};
+
+uint32_t divRoundUp(size_t x, uint32_t y) {
+  return (x + y - 1) / y;
+}
+
+} // namespace
+
+VulkanBuffer::VulkanBuffer(size_t size) : size_(size), id_(next_buffer_id++) {
+  auto& context = getVulkanContext();
+  VkBufferCreateInfo info = {};
+  info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  // Vulkan doesn't allow empty buffers
+  info.size = std::max(size, sizeof(float));
+  info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  VULKAN_CHECK(vkCreateBuffer(context.device(), &info, nullptr, &buffer_));
+
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(context.device(), buffer_, &requirements);
+  VkMemoryAllocateInfo allocate_info = {};
+  allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocate_info.allocationSize = requirements.size;
+  allocate_info.memoryTypeIndex =
+      context.memoryType(requirements.memoryTypeBits, &coherent_);
+  VULKAN_CHECK(
+      vkAllocateMemory(context.device(), &allocate_info, nullptr, &memory_));
+  VULKAN_CHECK(vkBindBufferMemory(context.device(), buffer_, memory_, 0));
+}
+
+VulkanBuffer::~VulkanBuffer() {
+  auto device = getVulkanContext().device();
+  vkDestroyBuffer(device, buffer_, nullptr);
+  vkFreeMemory(device, memory_, nullptr);
+}
+
+void VulkanBuffer::copyFromHost(const void* src, size_t nbytes) {
+  CAFFE_ENFORCE_LE(nbytes, size_);
+  auto& context = getVulkanContext();
+  if (context.pending(batch_)) {
+    context.submit();
+  }
+  void* data;
+  VULKAN_CHECK(vkMapMemory(context.device(), memory_, 0, VK_WHOLE_SIZE, 0, &data));
+  memcpy(data, src, nbytes);
+  if (!coherent_) {
+    VkMappedMemoryRange range = {};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = memory_;
+    range.size = VK_WHOLE_SIZE;
+    VULKAN_CHECK(vkFlushMappedMemoryRanges(context.device(), 1, &range));
+  }
+  vkUnmapMemory(context.device(), memory_);
+}
+
+void VulkanBuffer::copyToHost(void* dst, size_t nbytes) {
+  CAFFE_ENFORCE_LE(nbytes, size_);
+  auto& context = getVulkanContext();
+  if (context.pending(batch_)) {
+    context.submit();
+  }
+  void* data;
+  VULKAN_CHECK(vkMapMemory(context.device(), memory_, 0, VK_WHOLE_SIZE, 0, &data));
+  if (!coherent_) {
+    VkMappedMemoryRange range = {};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = memory_;
+    range.size = VK_WHOLE_SIZE;
+    VULKAN_CHECK(vkInvalidateMappedMemoryRanges(context.device(), 1, &range));
+  }
+  memcpy(dst, data, nbytes);
+  vkUnmapMemory(context.device(), memory_);
+}
+
+void VulkanTensor::Resize(const std::vector<TIndex>& dims) {
+  dims_ = dims;
+  if (!buffer_ || buffer_->size() != nbytes()) {
+    // recorded commands keep the old buffer alive
+    buffer_ = std::make_shared<VulkanBuffer>(nbytes());
+  }
+}
+
+VulkanContext::VulkanContext() {
+  CAFFE_ENFORCE(vulkanSymbolWrapperInitLoader(), "Failed to load libvulkan.");
+  CAFFE_ENFORCE(vulkanSymbolWrapperLoadGlobalSymbols());
+
+  VkApplicationInfo app_info = {};
+  app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  app_info.pApplicationName = "caffe2";
+  app_info.pEngineName = "caffe2";
+  app_info.apiVersion = VK_API_VERSION_1_0;
+  VkInstanceCreateInfo instance_info = {};
+  instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  instance_info.pApplicationInfo = &app_info;
+  VULKAN_CHECK(vkCreateInstance(&instance_info, nullptr, &instance_));
+  CAFFE_ENFORCE(vulkanSymbolWrapperLoadCoreInstanceSymbols(instance_));
+
+  // the first device with a compute queue
+  uint32_t num_devices = 0;
+  VULKAN_CHECK(vkEnumeratePhysicalDevices(instance_, &num_devices, nullptr));
+  std::vector<VkPhysicalDevice> devices(num_devices);
+  VULKAN_CHECK(
+      vkEnumeratePhysicalDevices(instance_, &num_devices, devices.data()));
+  for (auto device : devices) {
+    uint32_t num_families = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &num_families, nullptr);
+    std::vector<VkQueueFamilyProperties> families(num_families);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        device, &num_families, families.data());
+    for (uint32_t i = 0; i < num_families; ++i) {
+      if (families[i].queueCount > 0 &&
+          (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+        physical_device_ = device;
+        queue_family_ = i;
+        break;
+      }
+    }
+    if (physical_device_ != VK_NULL_HANDLE) {
+      break;
+    }
+  }
+  CAFFE_ENFORCE(
+      physical_device_ != VK_NULL_HANDLE,
+      "No Vulkan device with a compute queue.");
+  vkGetPhysicalDeviceMemoryProperties(physical_device_, &memory_properties_);
+
+  const float priority = 1.0;
+  VkDeviceQueueCreateInfo queue_info = {};
+  queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queue_info.queueFamilyIndex = queue_family_;
+  queue_info.queueCount = 1;
+  queue_info.pQueuePriorities = &priority;
+  VkDeviceCreateInfo device_info = {};
+  device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  device_info.queueCreateInfoCount = 1;
+  device_info.pQueueCreateInfos = &queue_info;
+  VULKAN_CHECK(
+      vkCreateDevice(physical_device_, &device_info, nullptr, &device_));
+  CAFFE_ENFORCE(vulkanSymbolWrapperLoadCoreDeviceSymbols(device_));
+  vkGetDeviceQueue(device_, queue_family_, 0, &queue_);
+
+  VkCommandPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  pool_info.queueFamilyIndex = queue_family_;
+  VULKAN_CHECK(
+      vkCreateCommandPool(device_, &pool_info, nullptr, &command_pool_));
+  VkCommandBufferAllocateInfo buffer_info = {};
+  buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  buffer_info.commandPool = command_pool_;
+  buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  buffer_info.commandBufferCount = 1;
+  VULKAN_CHECK(
+      vkAllocateCommandBuffers(device_, &buffer_info, &command_buffer_));
+
+  VkFenceCreateInfo fence_info = {};
+  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  VULKAN_CHECK(vkCreateFence(device_, &fence_info, nullptr, &fence_));
+}
+
+uint32_t VulkanContext::memoryType(uint32_t allowed_types, bool* coherent)
+    const {
+  // host visible, then device local and coherent if possible
+  int best = -1;
+  int best_score = -1;
+  for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+    const auto flags = memory_properties_.memoryTypes[i].propertyFlags;
+    if (!(allowed_types & (1u << i)) ||
+        !(flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+      continue;
+    }
+    int score = ((flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) ? 2 : 0) +
+        ((flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) ? 1 : 0);
+    if (score > best_score) {
+      best = i;
+      best_score = score;
+    }
+  }
+  CAFFE_ENFORCE_GE(best, 0, "No host visible Vulkan memory.");
+  *coherent = memory_properties_.memoryTypes[best].propertyFlags &
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  return best;
+}
+
+const VulkanPipeline& VulkanContext::pipeline(const std::string& name) {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  auto it = pipelines_.find(name);
+  if (it != pipelines_.end()) {
+    return *it->second;
+  }
+  const auto& shader = getVulkanShader(name);
+  std::unique_ptr<VulkanPipeline> pipeline(new VulkanPipeline());
+  pipeline->num_buffers = shader.num_buffers;
+  pipeline->local_size = shader.local_size;
+
+  std::vector<VkDescriptorSetLayoutBinding> bindings(shader.num_buffers);
+  for (uint32_t i = 0; i < shader.num_buffers; ++i) {
+    bindings[i] = {};
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  VkDescriptorSetLayoutCreateInfo set_info = {};
+  set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  set_info.bindingCount = bindings.size();
+  set_info.pBindings = bindings.data();
+  VULKAN_CHECK(vkCreateDescriptorSetLayout(
+      device_, &set_info, nullptr, &pipeline->set_layout));
+
+  VkPushConstantRange range = {};
+  range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  range.size = kMaxPushConstantsSize;
+  VkPipelineLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  layout_info.setLayoutCount = 1;
+  layout_info.pSetLayouts = &pipeline->set_layout;
+  layout_info.pushConstantRangeCount = 1;
+  layout_info.pPushConstantRanges = &range;
+  VULKAN_CHECK(vkCreatePipelineLayout(
+      device_, &layout_info, nullptr, &pipeline->layout));
+
+  VkShaderModuleCreateInfo module_info = {};
+  module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  module_info.codeSize = shader.size;
+  module_info.pCode = shader.code;
+  VkShaderModule module;
+  VULKAN_CHECK(vkCreateShaderModule(device_, &module_info, nullptr, &module));
+
+  VkComputePipelineCreateInfo pipeline_info = {};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.layout = pipeline->layout;
+  VkResult result = vkCreateComputePipelines(
+      device_, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline->pipeline);
+  vkDestroyShaderModule(device_, module, nullptr);
+  VULKAN_CHECK(result);
+
+  auto& ret = *pipeline;
+  pipelines_[name] = std::move(pipeline);
+  return ret;
+}
+
+VkDescriptorSet VulkanContext::allocateDescriptorSet(
+    const VulkanPipeline& pipeline) {
+  std::lock_guard<std::mutex> lock(descriptor_mutex_);
+  CAFFE_ENFORCE_LE(pipeline.num_buffers, kMaxBuffersPerSet);
+  if (descriptor_pools_.empty() ||
+      descriptor_pools_.back().used == kDescriptorSetsPerPool) {
+    VkDescriptorPoolSize size = {};
+    size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    size.descriptorCount = kDescriptorSetsPerPool * kMaxBuffersPerSet;
+    VkDescriptorPoolCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    info.maxSets = kDescriptorSetsPerPool;
+    info.poolSizeCount = 1;
+    info.pPoolSizes = &size;
+    VkDescriptorPool pool;
+    VULKAN_CHECK(vkCreateDescriptorPool(device_, &info, nullptr, &pool));
+    descriptor_pools_.push_back({pool, 0});
+  }
+  auto& pool = descriptor_pools_.back();
+  VkDescriptorSetAllocateInfo info = {};
+  info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  info.descriptorPool = pool.pool;
+  info.descriptorSetCount = 1;
+  info.pSetLayouts = &pipeline.set_layout;
+  VkDescriptorSet set;
+  VULKAN_CHECK(vkAllocateDescriptorSets(device_, &info, &set));
+  pool.used++;
+  descriptor_set_pools_[set] = descriptor_pools_.size() - 1;
+  return set;
+}
+
+void VulkanContext::freeDescriptorSet(VkDescriptorSet set) {
+  std::lock_guard<std::mutex> lock(descriptor_mutex_);
+  auto it = descriptor_set_pools_.find(set);
+  CAFFE_ENFORCE(it != descriptor_set_pools_.end());
+  auto& pool = descriptor_pools_[it->second];
+  VULKAN_CHECK(vkFreeDescriptorSets(device_, pool.pool, 1, &set));
+  pool.used--;
+  descriptor_set_pools_.erase(it);
+}
+
+void VulkanContext::beginLocked() {
+  if (recording_) {
+    return;
+  }
+  VULKAN_CHECK(vkResetCommandBuffer(command_buffer_, 0));
+  VkCommandBufferBeginInfo info = {};
+  info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  VULKAN_CHECK(vkBeginCommandBuffer(command_buffer_, &info));
+  recording_ = true;
+}
+
+void VulkanContext::barrierLocked() {
+  // Orders each command after the previous ones, and the host reads after
+  // the batch. The nets are mostly chains, so little parallelism is lost.
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask =
+      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT |
+      VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(
+      command_buffer_,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT |
+          VK_PIPELINE_STAGE_HOST_BIT,
+      0,
+      1,
+      &barrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+}
+
+void VulkanContext::retainLocked(const std::shared_ptr<VulkanBuffer>& buffer) {
+  if (buffer->batch_ != batch_) {
+    buffer->batch_ = batch_;
+    batch_buffers_.push_back(buffer);
+  }
+}
+
+void VulkanContext::dispatch(
+    const VulkanPipeline& pipeline,
+    VkDescriptorSet set,
+    const void* push_constants,
+    uint32_t push_constants_size,
+    const std::array<uint32_t, 3>& groups,
+    const std::vector<std::shared_ptr<VulkanBuffer>>& buffers) {
+  CAFFE_ENFORCE_LE(push_constants_size, kMaxPushConstantsSize);
+  std::lock_guard<std::mutex> lock(mutex_);
+  beginLocked();
+  vkCmdBindPipeline(
+      command_buffer_, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+  vkCmdBindDescriptorSets(
+      command_buffer_,
+      VK_PIPELINE_BIND_POINT_COMPUTE,
+      pipeline.layout,
+      0,
+      1,
+      &set,
+      0,
+      nullptr);
+  if (push_constants_size > 0) {
+    vkCmdPushConstants(
+        command_buffer_,
+        pipeline.layout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        push_constants_size,
+        push_constants);
+  }
+  vkCmdDispatch(command_buffer_, groups[0], groups[1], groups[2]);
+  barrierLocked();
+  for (const auto& buffer : buffers) {
+    retainLocked(buffer);
+  }
+}
+
+void VulkanContext::copy(
+    const std::shared_ptr<VulkanBuffer>& src,
+    const std::shared_ptr<VulkanBuffer>& dst,
+    const std::vector<CopyRegion>& regions) {
+  std::vector<VkBufferCopy> copies;
+  for (const auto& region : regions) {
+    CAFFE_ENFORCE_LE(region.src_offset + region.size, src->size());
+    CAFFE_ENFORCE_LE(region.dst_offset + region.size, dst->size());
+    if (region.size > 0) {
+      copies.push_back({region.src_offset, region.dst_offset, region.size});
+    }
+  }
+  if (copies.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  beginLocked();
+  vkCmdCopyBuffer(
+      command_buffer_, src->buffer(), dst->buffer(), copies.size(),
+      copies.data());
+  barrierLocked();
+  retainLocked(src);
+  retainLocked(dst);
+}
+
+bool VulkanContext::pending(uint64_t batch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return recording_ && batch == batch_;
+}
+
+void VulkanContext::submit() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  submitLocked();
+}
+
+void VulkanContext::submitLocked() {
+  if (!recording_) {
+    return;
+  }
+  VULKAN_CHECK(vkEndCommandBuffer(command_buffer_));
+  VkSubmitInfo info = {};
+  info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  info.commandBufferCount = 1;
+  info.pCommandBuffers = &command_buffer_;
+  VULKAN_CHECK(vkQueueSubmit(queue_, 1, &info, fence_));
+  VULKAN_CHECK(vkWaitForFences(
+      device_, 1, &fence_, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+  VULKAN_CHECK(vkResetFences(device_, 1, &fence_));
+  recording_ = false;
+  batch_++;
+  num_submissions_++;
+  batch_buffers_.clear();
+}
+
+VulkanContext& getVulkanContext() {
+  // Leaked, so that the buffers of static workspaces can still be freed at
+  // exit.
+  static VulkanContext* context = new VulkanContext();
+  return *context;
+}
+
+bool isVulkanAvailable() {
+  static bool available = []() {
+    try {
+      getVulkanContext();
+      return true;
+    } catch (const std::exception& e) {
+      LOG(INFO) << "Vulkan is not available: " << e.what();
+      return false;
+    }
+  }();
+  return available;
+}
+
+VulkanKernel::VulkanKernel(const std::string& shader)
+    : pipeline_(getVulkanContext().pipeline(shader)),
+      set_(getVulkanContext().allocateDescriptorSet(pipeline_)) {}
+
+VulkanKernel::~VulkanKernel() {
+  auto& context = getVulkanContext();
+  if (context.pending(batch_)) {
+    context.submit();
+  }
+  context.freeDescriptorSet(set_);
+}
+
+void VulkanKernel::update(
+    const std::vector<std::shared_ptr<VulkanBuffer>>& buffers) {
+  CAFFE_ENFORCE_EQ(buffers.size(), pipeline_.num_buffers);
+  std::vector<uint64_t> ids;
+  for (const auto& buffer : buffers) {
+    ids.push_back(buffer->id());
+  }
+  if (ids == buffer_ids_) {
+    return;
+  }
+  auto& context = getVulkanContext();
+  // the set can't change while a recorded command uses it
+  if (context.pending(batch_)) {
+    context.submit();
+  }
+  std::vector<VkDescriptorBufferInfo> infos(buffers.size());
+  std::vector<VkWriteDescriptorSet> writes(buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    infos[i].buffer = buffers[i]->buffer();
+    infos[i].offset = 0;
+    infos[i].range = VK_WHOLE_SIZE;
+    writes[i] = {};
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].dstSet = set_;
+    writes[i].dstBinding = i;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[i].pBufferInfo = &infos[i];
+  }
+  vkUpdateDescriptorSets(
+      context.device(), writes.size(), writes.data(), 0, nullptr);
+  buffer_ids_ = ids;
+}
+
+void VulkanKernel::record(
+    const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+    const void* params,
+    uint32_t params_size,
+    const std::array<uint32_t, 3>& groups) {
+  update(buffers);
+  auto& context = getVulkanContext();
+  context.dispatch(pipeline_, set_, params, params_size, groups, buffers);
+  batch_ = context.currentBatch();
+}
+
+void VulkanKernel::dispatch(
+    const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+    const void* params,
+    uint32_t params_size,
+    const std::array<uint32_t, 3>& threads) {
+  std::array<uint32_t, 3> groups;
+  for (int i = 0; i < 3; ++i) {
+    groups[i] = divRoundUp(threads[i], pipeline_.local_size[i]);
+    CAFFE_ENFORCE_LE(groups[i], kMaxWorkgroups);
+    if (groups[i] == 0) {
+      return;
+    }
+  }
+  record(buffers, params, params_size, groups);
+}
+
+void VulkanKernel::dispatch1d(
+    const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+    const void* params,
+    uint32_t params_size,
+    size_t threads) {
+  const auto groups = divRoundUp(threads, pipeline_.local_size[0]);
+  if (groups == 0) {
+    return;
+  }
+  const auto groups_x = std::min(groups, kMaxWorkgroups);
+  const auto groups_y = divRoundUp(groups, groups_x);
+  CAFFE_ENFORCE_LE(groups_y, kMaxWorkgroups);
+  record(buffers, params, params_size, {{groups_x, groups_y, 1}});
+}
+
+} // namespace caffe2
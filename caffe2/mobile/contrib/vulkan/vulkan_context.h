@@ -0,0 +1,259 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+
+#include "libvulkan-stub.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace caffe2 {
+
+#define VULKAN_CHECK(expr)                                                  \
+  do {                                                                      \
+    VkResult result = (expr);                                               \
+    CAFFE_ENFORCE_EQ(result, VK_SUCCESS, "Vulkan call failed: " #expr "."); \
+  } while (false)
+
+// A storage buffer with its own device memory. The memory is host visible,
+// preferably device local too as on the shared memory of mobile GPUs, so
+// the copies to and from the CPU are plain memcpys.
+class VulkanBuffer {
+ public:
+  explicit VulkanBuffer(size_t size);
+  ~VulkanBuffer();
+
+  VkBuffer buffer() const {
+    return buffer_;
+  }
+  size_t size() const {
+    return size_;
+  }
+  // Unique among all the buffers ever created, unlike the VkBuffer handle
+  uint64_t id() const {
+    return id_;
+  }
+
+  // Waits for the recorded work that uses the buffer before copying.
+  void copyFromHost(const void* src, size_t nbytes);
+  void copyToHost(void* dst, size_t nbytes);
+
+ private:
+  friend class VulkanContext;
+
+  VkBuffer buffer_{VK_NULL_HANDLE};
+  VkDeviceMemory memory_{VK_NULL_HANDLE};
+  size_t size_;
+  uint64_t id_;
+  bool coherent_;
+  // last batch of commands using the buffer
+  uint64_t batch_{0};
+
+  DISABLE_COPY_AND_ASSIGN(VulkanBuffer);
+};
+
+// A float NCHW tensor in a Vulkan buffer, the blob type between Vulkan
+// operators. The buffer is kept across runs while the size doesn't change,
+// so the descriptor sets of the operators that read it stay valid.
+class VulkanTensor {
+ public:
+  void Resize(const std::vector<TIndex>& dims);
+  template <typename... Ts>
+  void Resize(Ts... dims) {
+    Resize(std::vector<TIndex>{dims...});
+  }
+
+  const std::vector<TIndex>& dims() const {
+    return dims_;
+  }
+  int ndim() const {
+    return dims_.size();
+  }
+  int dim32(int i) const {
+    return dims_.at(i);
+  }
+  TIndex size() const {
+    TIndex size = 1;
+    for (auto d : dims_) {
+      size *= d;
+    }
+    return size;
+  }
+  size_t nbytes() const {
+    return size() * sizeof(float);
+  }
+  const std::shared_ptr<VulkanBuffer>& buffer() const {
+    return buffer_;
+  }
+
+ private:
+  std::vector<TIndex> dims_;
+  std::shared_ptr<VulkanBuffer> buffer_;
+};
+
+// A compute pipeline of one of the shaders, whose storage buffers are the
+// bindings 0 to num_buffers - 1 of set 0.
+struct VulkanPipeline {
+  VkDescriptorSetLayout set_layout;
+  VkPipelineLayout layout;
+  VkPipeline pipeline;
+  uint32_t num_buffers;
+  std::array<uint32_t, 3> local_size;
+};
+
+// The work of the Vulkan operators is recorded in a single command buffer,
+// the current batch, which is only submitted when the CPU needs the results.
+// A net of Vulkan operators between CopyToVulkan and CopyFromVulkan is one
+// submission.
+class VulkanContext {
+ public:
+  VulkanContext();
+
+  VkDevice device() const {
+    return device_;
+  }
+
+  const VulkanPipeline& pipeline(const std::string& shader);
+
+  // Descriptor sets are owned by the operators and reused across runs
+  VkDescriptorSet allocateDescriptorSet(const VulkanPipeline& pipeline);
+  void freeDescriptorSet(VkDescriptorSet set);
+
+  // Records a dispatch of `groups` workgroups into the current batch, which
+  // keeps the buffers alive until it's done.
+  void dispatch(
+      const VulkanPipeline& pipeline,
+      VkDescriptorSet set,
+      const void* push_constants,
+      uint32_t push_constants_size,
+      const std::array<uint32_t, 3>& groups,
+      const std::vector<std::shared_ptr<VulkanBuffer>>& buffers);
+
+  struct CopyRegion {
+    size_t src_offset;
+    size_t dst_offset;
+    size_t size;
+  };
+  // Records copies between two buffers into the current batch.
+  void copy(
+      const std::shared_ptr<VulkanBuffer>& src,
+      const std::shared_ptr<VulkanBuffer>& dst,
+      const std::vector<CopyRegion>& regions);
+
+  // Whether the given batch is recorded but not submitted yet
+  bool pending(uint64_t batch);
+  uint64_t currentBatch() const {
+    return batch_;
+  }
+  // Submits the current batch and waits for its completion.
+  void submit();
+  uint64_t numSubmissions() const {
+    return num_submissions_;
+  }
+
+  // Memory type for VulkanBuffer, and whether it's coherent
+  uint32_t memoryType(uint32_t allowed_types, bool* coherent) const;
+
+ private:
+  void beginLocked();
+  void barrierLocked();
+  void retainLocked(const std::shared_ptr<VulkanBuffer>& buffer);
+  void submitLocked();
+
+  VkInstance instance_{VK_NULL_HANDLE};
+  VkPhysicalDevice physical_device_{VK_NULL_HANDLE};
+  VkPhysicalDeviceMemoryProperties memory_properties_;
+  VkDevice device_{VK_NULL_HANDLE};
+  uint32_t queue_family_;
+  VkQueue queue_{VK_NULL_HANDLE};
+  VkCommandPool command_pool_{VK_NULL_HANDLE};
+  VkCommandBuffer command_buffer_{VK_NULL_HANDLE};
+  VkFence fence_{VK_NULL_HANDLE};
+
+  std::mutex mutex_;
+  bool recording_ = false;
+  uint64_t batch_ = 1;
+  std::atomic<uint64_t> num_submissions_{0};
+  std::vector<std::shared_ptr<VulkanBuffer>> batch_buffers_;
+
+  std::mutex pipeline_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<VulkanPipeline>> pipelines_;
+
+  struct DescriptorPool {
+    VkDescriptorPool pool;
+    uint32_t used;
+  };
+  std::mutex descriptor_mutex_;
+  std::vector<DescriptorPool> descriptor_pools_;
+  std::unordered_map<VkDescriptorSet, size_t> descriptor_set_pools_;
+
+  DISABLE_COPY_AND_ASSIGN(VulkanContext);
+};
+
+// Gets the singleton instance, and throws if there is no Vulkan device with
+// a compute queue.
+VulkanContext& getVulkanContext();
+bool isVulkanAvailable();
+
+// A shader with its descriptor set, owned by an operator. The set is only
+// updated when the buffers change.
+class VulkanKernel {
+ public:
+  explicit VulkanKernel(const std::string& shader);
+  ~VulkanKernel();
+
+  // Records the shader on the buffers with at least `threads` invocations.
+  // Params are the push constants.
+  template <typename Params>
+  void dispatch(
+      const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+      const Params& params,
+      const std::array<uint32_t, 3>& threads) {
+    dispatch(buffers, &params, sizeof(Params), threads);
+  }
+
+  // For the 1-d shaders, which index their invocations with
+  // gl_GlobalInvocationID.x + gl_GlobalInvocationID.y * gl_NumWorkGroups.x *
+  // gl_WorkGroupSize.x, so that there are more than 65535 workgroups.
+  template <typename Params>
+  void dispatch1d(
+      const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+      const Params& params,
+      size_t threads) {
+    dispatch1d(buffers, &params, sizeof(Params), threads);
+  }
+
+ private:
+  void dispatch(
+      const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+      const void* params,
+      uint32_t params_size,
+      const std::array<uint32_t, 3>& threads);
+  void dispatch1d(
+      const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+      const void* params,
+      uint32_t params_size,
+      size_t threads);
+  void update(const std::vector<std::shared_ptr<VulkanBuffer>>& buffers);
+  void record(
+      const std::vector<std::shared_ptr<VulkanBuffer>>& buffers,
+      const void* params,
+      uint32_t params_size,
+      const std::array<uint32_t, 3>& groups);
+
+  const VulkanPipeline& pipeline_;
+  VkDescriptorSet set_;
+  std::vector<uint64_t> buffer_ids_;
+  // last batch the descriptor set is bound in
+  uint64_t batch_{0};
+
+  DISABLE_COPY_AND_ASSIGN(VulkanKernel);
+};
+
+} // namespace caffe2
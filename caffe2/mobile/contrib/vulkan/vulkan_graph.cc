@@ -0,0 +1,160 @@
+#include "caffe2/core/operator.h"
+#include "vulkan.h"
+#include "vulkan_context.h"
+
+#include <map>
+#include <set>
+
+namespace caffe2 {
+
+namespace {
+
+constexpr const char* kInputCopy = "__VULKAN_INPUT_COPY__";
+constexpr const char* kOutputCopy = "__VULKAN_OUTPUT_COPY__";
+
+// Number of operators reading each blob version, keyed by the index of the
+// operator writing it (-1 for the external inputs).
+std::map<std::pair<std::string, int>, int> countReads(const NetDef& net) {
+  std::map<std::string, int> writers;
+  std::map<std::pair<std::string, int>, int> reads;
+  for (auto i = 0; i < net.op_size(); ++i) {
+    const auto& op = net.op(i);
+    for (const auto& input : op.input()) {
+      auto it = writers.find(input);
+      reads[{input, it == writers.end() ? -1 : it->second}]++;
+    }
+    for (const auto& output : op.output()) {
+      writers[output] = i;
+    }
+  }
+  return reads;
+}
+
+NetDef runVulkanFusion(const NetDef& def) {
+  static const std::map<std::pair<std::string, std::string>, std::string>
+      fusionOpportunities = {{
+          {{"VulkanConv", "VulkanRelu"}, "VulkanConvRelu"},
+      }};
+  const auto reads = countReads(def);
+  NetDef mdef;
+  mdef.CopyFrom(def);
+  mdef.clear_op();
+  auto i = 0;
+  while (i < def.op_size()) {
+    const auto& currentOp = def.op(i);
+    if (i + 1 < def.op_size()) {
+      const auto& nextOp = def.op(i + 1);
+      auto it = fusionOpportunities.find({currentOp.type(), nextOp.type()});
+      // The next op has to be the only reader of the output, which the fused
+      // op doesn't produce, and VulkanConvRelu can't be in place.
+      if (it != fusionOpportunities.end() && currentOp.output_size() == 1 &&
+          nextOp.input_size() == 1 && nextOp.output_size() == 1 &&
+          currentOp.output(0) == nextOp.input(0) &&
+          currentOp.input(0) != nextOp.output(0) &&
+          reads.at({currentOp.output(0), i}) == 1) {
+        LOG(INFO) << "Found a fusion between adjacent ops: ("
+                  << currentOp.type() << ", " << nextOp.type() << ") -> "
+                  << it->second;
+        auto* op = mdef.add_op();
+        op->CopyFrom(currentOp);
+        op->set_type(it->second);
+        op->set_output(0, nextOp.output(0));
+        i += 2;
+        continue;
+      }
+    }
+    mdef.add_op()->CopyFrom(currentOp);
+    i += 1;
+  }
+  return mdef;
+}
+
+NetDef insertInputOutputCopyOps(const NetDef& def) {
+  // As for MPSCNN, the single input (external_input(0)) is only read by the
+  // first operator, and the single output (external_output(0)) is produced by
+  // the last one.
+  CAFFE_ENFORCE_GE(def.external_input_size(), 1);
+  CAFFE_ENFORCE_GE(def.external_output_size(), 1);
+  CAFFE_ENFORCE_GE(def.op_size(), 1);
+  const auto& inputBlob = def.external_input(0);
+  const auto& outputBlob = def.external_output(0);
+  const auto reads = countReads(def);
+  CAFFE_ENFORCE_EQ(def.op(0).input(0), inputBlob);
+  CAFFE_ENFORCE_EQ(reads.at({inputBlob, -1}), 1);
+  CAFFE_ENFORCE_EQ(def.op(def.op_size() - 1).output(0), outputBlob);
+
+  NetDef mdef;
+  mdef.CopyFrom(def);
+  mdef.clear_op();
+  {
+    auto& op = *(mdef.add_op());
+    op.set_type("CopyToVulkan");
+    op.add_input(inputBlob);
+    op.add_output(kInputCopy);
+  }
+  for (auto i = 0; i < def.op_size(); ++i) {
+    auto* op = mdef.add_op();
+    op->CopyFrom(def.op(i));
+    if (i == 0) {
+      op->set_input(0, kInputCopy);
+    }
+    if (i == def.op_size() - 1) {
+      op->set_output(0, kOutputCopy);
+    }
+  }
+  {
+    auto& op = *(mdef.add_op());
+    op.set_type("CopyFromVulkan");
+    op.add_input(kOutputCopy);
+    op.add_output(outputBlob);
+  }
+  return mdef;
+}
+
+} // namespace
+
+NetDef rewriteForVulkan(const NetDef& def) {
+  NetDef mdef;
+  mdef.CopyFrom(def);
+
+  const auto& opKeyList = CPUOperatorRegistry()->Keys();
+  const auto& opKeySet =
+      std::set<std::string>(opKeyList.begin(), opKeyList.end());
+  for (auto i = 0; i < mdef.op_size(); ++i) {
+    auto* op = mdef.mutable_op(i);
+    const auto vulkanOp = std::string("Vulkan") + op->type();
+    CAFFE_ENFORCE(
+        opKeySet.find(vulkanOp) != opKeySet.end(),
+        "No Vulkan operator for ",
+        op->type());
+    op->set_type(vulkanOp);
+  }
+  mdef = runVulkanFusion(mdef);
+  return insertInputOutputCopyOps(mdef);
+}
+
+bool tryConvertToVulkan(
+    const NetDef& initNet,
+    const NetDef& predictNet,
+    NetDef* vulkanPredictNet) {
+  if (!isVulkanAvailable()) {
+    LOG(ERROR) << "No Vulkan device with a compute queue is available.";
+    return false;
+  }
+  try {
+    Workspace ws;
+    ws.RunNetOnce(initNet);
+    // Throws if unsupported operators are found.
+    *vulkanPredictNet = rewriteForVulkan(predictNet);
+    // Throws if unsupported parameters are found.
+    ws.CreateNet(*vulkanPredictNet);
+    LOG(INFO) << "Vulkan is successfully enabled";
+    return true;
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Caught exception trying to convert NetDef to Vulkan: "
+               << e.what();
+    return false;
+  }
+}
+
+} // namespace caffe2
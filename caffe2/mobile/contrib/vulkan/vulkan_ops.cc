@@ -0,0 +1,429 @@
+#include "vulkan_context.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/operators/concat_split_op.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+
+namespace caffe2 {
+
+namespace {
+
+void computeOutputHW(
+    ConvPoolOpBase<CPUContext>* op,
+    int C,
+    int H,
+    int W,
+    int* OH,
+    int* OW) {
+  Tensor<CPUContext> input, output;
+  input.Resize(1, C, H, W);
+  op->SetOutputSize<CPUContext>(input, &output, C);
+  CAFFE_ENFORCE_EQ(output.ndim(), 4);
+  *OH = output.dim(2);
+  *OW = output.dim(3);
+}
+
+// Weights are uploaded on the first run, as for MPSCNN
+std::shared_ptr<VulkanBuffer> uploadTensor(const TensorCPU& X) {
+  auto buffer = std::make_shared<VulkanBuffer>(X.nbytes());
+  buffer->copyFromHost(X.raw_data(), X.nbytes());
+  return buffer;
+}
+
+} // namespace
+
+class CopyToVulkanOp final : public Operator<CPUContext> {
+ public:
+  CopyToVulkanOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    caffe2::Timer t;
+    for (auto i = 0; i < Inputs().size(); ++i) {
+      const auto& X = Input(i);
+      auto* Y = Outputs()[i]->GetMutable<VulkanTensor>();
+      Y->Resize(X.dims());
+      // waits for the previous run if it still reads the buffer
+      Y->buffer()->copyFromHost(X.raw_data(), X.nbytes());
+    }
+    VLOG(2) << "CopyToVulkanOp took: " << t.MilliSeconds();
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(CopyToVulkan, CopyToVulkanOp);
+OPERATOR_SCHEMA(CopyToVulkan)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1, INT_MAX)
+    .SameNumberOfOutput();
+
+class CopyFromVulkanOp final : public Operator<CPUContext> {
+ public:
+  CopyFromVulkanOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    caffe2::Timer t;
+    // everything recorded since CopyToVulkan goes in a single submission
+    getVulkanContext().submit();
+    VLOG(2) << "CopyFromVulkanOp submit took: " << t.MilliSeconds();
+    for (auto i = 0; i < Inputs().size(); ++i) {
+      const auto& X = Inputs()[i]->Get<VulkanTensor>();
+      auto* Y = Output(i);
+      Y->Resize(X.dims());
+      X.buffer()->copyToHost(Y->mutable_data<float>(), Y->nbytes());
+    }
+    VLOG(2) << "CopyFromVulkanOp took: " << t.MilliSeconds();
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(CopyFromVulkan, CopyFromVulkanOp);
+OPERATOR_SCHEMA(CopyFromVulkan)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1, INT_MAX)
+    .SameNumberOfOutput();
+
+template <bool Relu>
+class VulkanConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  VulkanConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws), kernel_("conv2d") {
+    OPERATOR_NEEDS_FEATURE(
+        this->order_ == StorageOrder::NCHW, "Vulkan only supports NCHW order.");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    caffe2::Timer t;
+    const auto& X = Inputs()[0]->Get<VulkanTensor>();
+    const auto& W = Input(1);
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(W.ndim(), 4);
+    const int N = X.dim32(0);
+    const int C = X.dim32(1);
+    const int H = X.dim32(2);
+    const int Wd = X.dim32(3);
+    const int M = W.dim32(0);
+    CAFFE_ENFORCE_EQ(C % group_, 0);
+    CAFFE_ENFORCE_EQ(M % group_, 0);
+    CAFFE_ENFORCE_EQ(W.dim32(1), C / group_);
+    CAFFE_ENFORCE_EQ(W.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(W.dim32(3), kernel_w());
+
+    if (!weight_) {
+      weight_ = uploadTensor(W);
+      if (InputSize() == 3) {
+        const auto& b = Input(2);
+        CAFFE_ENFORCE_EQ(b.size(), M);
+        bias_ = uploadTensor(b);
+      } else {
+        std::vector<float> zeros(M, 0);
+        bias_ = std::make_shared<VulkanBuffer>(M * sizeof(float));
+        bias_->copyFromHost(zeros.data(), M * sizeof(float));
+      }
+    }
+
+    int OH, OW;
+    computeOutputHW(this, C, H, Wd, &OH, &OW);
+    auto* Y = Outputs()[0]->GetMutable<VulkanTensor>();
+    Y->Resize(N, M, OH, OW);
+
+    Params params = {N,
+                     C,
+                     H,
+                     Wd,
+                     M,
+                     OH,
+                     OW,
+                     kernel_h(),
+                     kernel_w(),
+                     stride_h(),
+                     stride_w(),
+                     pad_t(),
+                     pad_l(),
+                     dilation_h(),
+                     dilation_w(),
+                     group_,
+                     Relu};
+    kernel_.dispatch(
+        {X.buffer(), weight_, bias_, Y->buffer()},
+        params,
+        {{uint32_t(OW), uint32_t(OH), uint32_t(N * M)}});
+    VLOG(2) << "VulkanConvOp took: " << t.MilliSeconds();
+    return true;
+  }
+
+ private:
+  // push constants of conv2d.comp
+  struct Params {
+    int32_t batch, in_c, in_h, in_w, out_c, out_h, out_w;
+    int32_t kernel_h, kernel_w, stride_h, stride_w, pad_t, pad_l;
+    int32_t dilation_h, dilation_w, group, relu;
+  };
+
+  VulkanKernel kernel_;
+  std::shared_ptr<VulkanBuffer> weight_;
+  std::shared_ptr<VulkanBuffer> bias_;
+};
+
+// Depthwise convolutions are the group == channels case.
+REGISTER_CPU_OPERATOR(VulkanConv, VulkanConvOp<false>);
+OPERATOR_SCHEMA(VulkanConv).NumInputs(2, 3).NumOutputs(1);
+REGISTER_CPU_OPERATOR(VulkanConvRelu, VulkanConvOp<true>);
+OPERATOR_SCHEMA(VulkanConvRelu).NumInputs(2, 3).NumOutputs(1);
+
+class VulkanReluOp final : public Operator<CPUContext> {
+ public:
+  VulkanReluOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), kernel_("relu") {}
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->Get<VulkanTensor>();
+    auto* Y = Outputs()[0]->GetMutable<VulkanTensor>();
+    // in place keeps the buffer
+    Y->Resize(X.dims());
+    const uint32_t size = X.size();
+    kernel_.dispatch1d({X.buffer(), Y->buffer()}, size, size);
+    return true;
+  }
+
+ private:
+  VulkanKernel kernel_;
+};
+
+REGISTER_CPU_OPERATOR(VulkanRelu, VulkanReluOp);
+OPERATOR_SCHEMA(VulkanRelu).NumInputs(1).NumOutputs(1).AllowInplace({{0, 0}});
+
+class VulkanAddOp final : public Operator<CPUContext> {
+ public:
+  VulkanAddOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), kernel_("add") {
+    OPERATOR_NEEDS_FEATURE(
+        OperatorBase::GetSingleArgument<int>("broadcast", 0) == 0,
+        "VulkanAdd does not support broadcast.");
+  }
+
+  bool RunOnDevice() override {
+    const auto& A = Inputs()[0]->Get<VulkanTensor>();
+    const auto& B = Inputs()[1]->Get<VulkanTensor>();
+    CAFFE_ENFORCE(A.dims() == B.dims(), "VulkanAdd inputs differ in shape.");
+    auto* Y = Outputs()[0]->GetMutable<VulkanTensor>();
+    Y->Resize(A.dims());
+    const uint32_t size = A.size();
+    kernel_.dispatch1d({A.buffer(), B.buffer(), Y->buffer()}, size, size);
+    return true;
+  }
+
+ private:
+  VulkanKernel kernel_;
+};
+
+REGISTER_CPU_OPERATOR(VulkanAdd, VulkanAddOp);
+OPERATOR_SCHEMA(VulkanAdd).NumInputs(2).NumOutputs(1).AllowInplace(
+    {{0, 0}, {1, 0}});
+// Sum of two inputs, which is the residual connection of most nets
+REGISTER_CPU_OPERATOR(VulkanSum, VulkanAddOp);
+OPERATOR_SCHEMA(VulkanSum).NumInputs(2).NumOutputs(1).AllowInplace(
+    {{0, 0}, {1, 0}});
+
+class VulkanFullyConnectedOp final : public Operator<CPUContext> {
+ public:
+  VulkanFullyConnectedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), kernel_("fc") {
+    OPERATOR_NEEDS_FEATURE(
+        OperatorBase::GetSingleArgument<int32_t>("axis", 1) == 1 &&
+            OperatorBase::GetSingleArgument<int32_t>("axis_w", 1) == 1,
+        "VulkanFC only supports the default axes.");
+  }
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->Get<VulkanTensor>();
+    const auto& W = Input(1);
+    const auto& b = Input(2);
+    CAFFE_ENFORCE_GE(X.ndim(), 1);
+    const int M = X.dim32(0);
+    CAFFE_ENFORCE_GT(M, 0);
+    const int K = X.size() / M;
+    const int N = W.dim32(0);
+    CAFFE_ENFORCE_EQ(W.size(), N * K);
+    CAFFE_ENFORCE_EQ(b.size(), N);
+    if (!weight_) {
+      weight_ = uploadTensor(W);
+      bias_ = uploadTensor(b);
+    }
+    auto* Y = Outputs()[0]->GetMutable<VulkanTensor>();
+    Y->Resize(M, N);
+    Params params = {M, K, N};
+    kernel_.dispatch(
+        {X.buffer(), weight_, bias_, Y->buffer()},
+        params,
+        {{uint32_t(N), uint32_t(M), 1}});
+    return true;
+  }
+
+ private:
+  struct Params {
+    int32_t M, K, N;
+  };
+
+  VulkanKernel kernel_;
+  std::shared_ptr<VulkanBuffer> weight_;
+  std::shared_ptr<VulkanBuffer> bias_;
+};
+
+REGISTER_CPU_OPERATOR(VulkanFC, VulkanFullyConnectedOp);
+OPERATOR_SCHEMA(VulkanFC).NumInputs(3).NumOutputs(1);
+
+template <bool Average>
+class VulkanPoolOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  VulkanPoolOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws), kernel_("pool") {
+    OPERATOR_NEEDS_FEATURE(
+        this->order_ == StorageOrder::NCHW, "Vulkan only supports NCHW order.");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const auto& X = Inputs()[0]->Get<VulkanTensor>();
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    const int N = X.dim32(0);
+    const int C = X.dim32(1);
+    const int H = X.dim32(2);
+    const int W = X.dim32(3);
+    int OH, OW;
+    computeOutputHW(this, C, H, W, &OH, &OW);
+    auto* Y = Outputs()[0]->GetMutable<VulkanTensor>();
+    Y->Resize(N, C, OH, OW);
+    Params params = {N * C,
+                     H,
+                     W,
+                     OH,
+                     OW,
+                     kernel_h(),
+                     kernel_w(),
+                     stride_h(),
+                     stride_w(),
+                     pad_t(),
+                     pad_l(),
+                     Average};
+    kernel_.dispatch(
+        {X.buffer(), Y->buffer()},
+        params,
+        {{uint32_t(OW), uint32_t(OH), uint32_t(N * C)}});
+    return true;
+  }
+
+ private:
+  struct Params {
+    int32_t channels, in_h, in_w, out_h, out_w;
+    int32_t kernel_h, kernel_w, stride_h, stride_w, pad_t, pad_l, average;
+  };
+
+  VulkanKernel kernel_;
+};
+
+REGISTER_CPU_OPERATOR(VulkanMaxPool, VulkanPoolOp<false>);
+OPERATOR_SCHEMA(VulkanMaxPool).NumInputs(1).NumOutputs(1);
+REGISTER_CPU_OPERATOR(VulkanAveragePool, VulkanPoolOp<true>);
+OPERATOR_SCHEMA(VulkanAveragePool).NumInputs(1).NumOutputs(1);
+
+// Concatenation along the channels, as buffer copies recorded in the batch.
+class VulkanConcatOp final : public Operator<CPUContext> {
+ public:
+  VulkanConcatOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {
+    const int axis = OperatorBase::HasArgument("axis")
+        ? OperatorBase::GetSingleArgument<int>("axis", -1)
+        : GetDimFromOrderString(
+              OperatorBase::GetSingleArgument<string>("order", "NCHW"));
+    OPERATOR_NEEDS_FEATURE(
+        axis == 1 && OperatorBase::GetSingleArgument<int>("add_axis", 0) == 0,
+        "VulkanConcat only supports the channel axis.");
+  }
+
+  bool RunOnDevice() override {
+    const auto& X0 = Inputs()[0]->Get<VulkanTensor>();
+    CAFFE_ENFORCE_GE(X0.ndim(), 2);
+    const int N = X0.dim32(0);
+    auto dims = X0.dims();
+    dims[1] = 0;
+    for (auto i = 0; i < InputSize(); ++i) {
+      const auto& Xi = Inputs()[i]->Get<VulkanTensor>();
+      CAFFE_ENFORCE_EQ(Xi.ndim(), X0.ndim());
+      for (auto d = 0; d < X0.ndim(); ++d) {
+        if (d != 1) {
+          CAFFE_ENFORCE_EQ(Xi.dim32(d), X0.dim32(d));
+        }
+      }
+      dims[1] += Xi.dim32(1);
+    }
+    auto* Y = Outputs()[0]->GetMutable<VulkanTensor>();
+    Y->Resize(dims);
+    const size_t output_stride = Y->nbytes() / N;
+
+    size_t offset = 0;
+    for (auto i = 0; i < InputSize(); ++i) {
+      const auto& Xi = Inputs()[i]->Get<VulkanTensor>();
+      const size_t input_stride = Xi.nbytes() / N;
+      std::vector<VulkanContext::CopyRegion> regions;
+      for (auto n = 0; n < N; ++n) {
+        regions.push_back(
+            {n * input_stride, n * output_stride + offset, input_stride});
+      }
+      getVulkanContext().copy(Xi.buffer(), Y->buffer(), regions);
+      offset += input_stride;
+    }
+
+    if (OutputSize() == 2) {
+      auto* split = Output(1);
+      split->Resize(InputSize());
+      auto* split_data = split->mutable_data<int>();
+      for (auto i = 0; i < InputSize(); ++i) {
+        split_data[i] = Inputs()[i]->Get<VulkanTensor>().dim32(1);
+      }
+    }
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(VulkanConcat, VulkanConcatOp);
+OPERATOR_SCHEMA(VulkanConcat).NumInputs(1, INT_MAX).NumOutputs(1, 2);
+
+class VulkanSoftmaxOp final : public Operator<CPUContext> {
+ public:
+  VulkanSoftmaxOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), kernel_("softmax") {
+    OPERATOR_NEEDS_FEATURE(
+        OperatorBase::GetSingleArgument<int>("axis", 1) == 1,
+        "VulkanSoftmax only supports axis 1.");
+  }
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->Get<VulkanTensor>();
+    CAFFE_ENFORCE_GE(X.ndim(), 1);
+    const uint32_t rows = X.dim32(0);
+    CAFFE_ENFORCE_GT(rows, 0);
+    const uint32_t cols = X.size() / rows;
+    auto* Y = Outputs()[0]->GetMutable<VulkanTensor>();
+    Y->Resize(X.dims());
+    Params params = {rows, cols};
+    // one workgroup per row
+    kernel_.dispatch({X.buffer(), Y->buffer()}, params, {{1, rows, 1}});
+    return true;
+  }
+
+ private:
+  struct Params {
+    uint32_t rows, cols;
+  };
+
+  VulkanKernel kernel_;
+};
+
+REGISTER_CPU_OPERATOR(VulkanSoftmax, VulkanSoftmaxOp);
+OPERATOR_SCHEMA(VulkanSoftmax).NumInputs(1).NumOutputs(1);
+
+} // namespace caffe2
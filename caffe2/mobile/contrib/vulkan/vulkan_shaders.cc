@@ -0,0 +1,40 @@
+#include "vulkan_shaders.h"
+
+#include "caffe2/core/logging.h"
+
+#include <unordered_map>
+
+// Generated from shaders/*.comp by CMakeLists.txt
+#include "caffe2/mobile/contrib/vulkan/shaders/add.spv.h"
+#include "caffe2/mobile/contrib/vulkan/shaders/conv2d.spv.h"
+#include "caffe2/mobile/contrib/vulkan/shaders/fc.spv.h"
+#include "caffe2/mobile/contrib/vulkan/shaders/pool.spv.h"
+#include "caffe2/mobile/contrib/vulkan/shaders/relu.spv.h"
+#include "caffe2/mobile/contrib/vulkan/shaders/softmax.spv.h"
+
+namespace caffe2 {
+
+#define VULKAN_SHADER(name, num_buffers, x, y, z) \
+  {                                               \
+    #name, {                                      \
+      name##_spv, sizeof(name##_spv), num_buffers, {{x, y, z}} \
+    }                                             \
+  }
+
+const VulkanShader& getVulkanShader(const std::string& name) {
+  static const std::unordered_map<std::string, VulkanShader> shaders = {
+      VULKAN_SHADER(add, 3, 64, 1, 1),
+      VULKAN_SHADER(conv2d, 4, 8, 8, 1),
+      VULKAN_SHADER(fc, 4, 64, 1, 1),
+      VULKAN_SHADER(pool, 2, 8, 8, 1),
+      VULKAN_SHADER(relu, 2, 64, 1, 1),
+      VULKAN_SHADER(softmax, 2, 64, 1, 1),
+  };
+  auto it = shaders.find(name);
+  CAFFE_ENFORCE(it != shaders.end(), "Unknown Vulkan shader: ", name);
+  return it->second;
+}
+
+#undef VULKAN_SHADER
+
+} // namespace caffe2
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace caffe2 {
+
+// SPIR-V of one of the compute shaders in shaders/, compiled by
+// glslangValidator when configuring the build.
+struct VulkanShader {
+  const uint32_t* code;
+  size_t size;
+  // storage buffers, the bindings 0 to num_buffers - 1 of set 0
+  uint32_t num_buffers;
+  // has to match the local_size of the shader
+  std::array<uint32_t, 3> local_size;
+};
+
+// Throws for unknown shaders.
+const VulkanShader& getVulkanShader(const std::string& name);
+
+} // namespace caffe2
@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/utils/math.h"
+
+#include "vulkan.h"
+#include "vulkan_context.h"
+
+namespace caffe2 {
+
+namespace {
+
+void randomTensor(
+    Workspace* ws,
+    const std::string& name,
+    std::vector<TIndex> dims) {
+  auto* t = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  t->Resize(dims);
+  CPUContext ctx;
+  math::RandGaussian<float, CPUContext>(
+      t->size(), 0, 1, t->mutable_data<float>(), &ctx);
+}
+
+OperatorDef* addOp(
+    NetDef* net,
+    const std::string& type,
+    const std::vector<std::string>& inputs,
+    const std::vector<std::string>& outputs) {
+  auto* op = net->add_op();
+  op->set_type(type);
+  for (const auto& input : inputs) {
+    op->add_input(input);
+  }
+  for (const auto& output : outputs) {
+    op->add_output(output);
+  }
+  return op;
+}
+
+void addArg(OperatorDef* op, const std::string& name, int value) {
+  auto* arg = op->add_arg();
+  arg->set_name(name);
+  arg->set_i(value);
+}
+
+// Runs the CPU net and its Vulkan rewrite on the external input X and
+// compares the external output Y.
+void compareWithCPU(Workspace* ws, NetDef net, float error = 1e-3) {
+  net.add_external_input("X");
+  net.add_external_output("Y");
+  ws->RunNetOnce(net);
+  TensorCPU expected;
+  expected.CopyFrom(ws->GetBlob("Y")->Get<TensorCPU>());
+
+  ws->RunNetOnce(rewriteForVulkan(net));
+  const auto& actual = ws->GetBlob("Y")->Get<TensorCPU>();
+  ASSERT_EQ(expected.dims(), actual.dims());
+  for (auto i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected.data<float>()[i], actual.data<float>()[i], error);
+  }
+}
+
+void testConv(
+    int N,
+    int C,
+    int H,
+    int W,
+    int M,
+    int kernel,
+    int pad,
+    int stride,
+    int group,
+    bool relu) {
+  Workspace ws;
+  randomTensor(&ws, "X", {N, C, H, W});
+  randomTensor(&ws, "W", {M, C / group, kernel, kernel});
+  randomTensor(&ws, "b", {M});
+  NetDef net;
+  auto* op = addOp(&net, "Conv", {"X", "W", "b"}, {relu ? "Z" : "Y"});
+  addArg(op, "kernel", kernel);
+  addArg(op, "pad", pad);
+  addArg(op, "stride", stride);
+  addArg(op, "group", group);
+  if (relu) {
+    addOp(&net, "Relu", {"Z"}, {"Y"});
+  }
+  compareWithCPU(&ws, net);
+}
+
+} // namespace
+
+#define SKIP_WITHOUT_VULKAN()                       \
+  if (!isVulkanAvailable()) {                       \
+    LOG(INFO) << "No Vulkan device, skipping test"; \
+    return;                                         \
+  }
+
+TEST(VulkanTest, Conv) {
+  SKIP_WITHOUT_VULKAN();
+  testConv(1, 3, 16, 16, 8, 3, 1, 1, 1, false);
+  testConv(2, 4, 15, 17, 6, 5, 2, 2, 1, false);
+  testConv(1, 8, 9, 9, 4, 1, 0, 1, 1, true);
+  testConv(1, 8, 10, 10, 8, 3, 1, 2, 2, true);
+}
+
+TEST(VulkanTest, Depthwise) {
+  SKIP_WITHOUT_VULKAN();
+  testConv(1, 16, 14, 14, 16, 3, 1, 1, 16, false);
+  testConv(2, 8, 7, 7, 8, 3, 1, 2, 8, true);
+}
+
+TEST(VulkanTest, ConvReluIsFused) {
+  NetDef net;
+  addOp(&net, "Conv", {"X", "W", "b"}, {"Z"});
+  addOp(&net, "Relu", {"Z"}, {"Y"});
+  net.add_external_input("X");
+  net.add_external_output("Y");
+  const auto vulkanNet = rewriteForVulkan(net);
+  ASSERT_EQ(vulkanNet.op_size(), 3);
+  EXPECT_EQ(vulkanNet.op(0).type(), "CopyToVulkan");
+  EXPECT_EQ(vulkanNet.op(1).type(), "VulkanConvRelu");
+  EXPECT_EQ(vulkanNet.op(2).type(), "CopyFromVulkan");
+  EXPECT_EQ(vulkanNet.op(2).output(0), "Y");
+}
+
+TEST(VulkanTest, Relu) {
+  SKIP_WITHOUT_VULKAN();
+  Workspace ws;
+  randomTensor(&ws, "X", {2, 3, 17, 19});
+  NetDef net;
+  addOp(&net, "Relu", {"X"}, {"Y"});
+  compareWithCPU(&ws, net);
+}
+
+TEST(VulkanTest, AddAndSum) {
+  SKIP_WITHOUT_VULKAN();
+  for (const auto& type : {"Add", "Sum"}) {
+    Workspace ws;
+    randomTensor(&ws, "X", {1, 4, 8, 8});
+    randomTensor(&ws, "W", {4, 4, 3, 3});
+    randomTensor(&ws, "b", {4});
+    NetDef net;
+    auto* conv = addOp(&net, "Conv", {"X", "W", "b"}, {"A"});
+    addArg(conv, "kernel", 3);
+    addArg(conv, "pad", 1);
+    addOp(&net, "Relu", {"A"}, {"B"});
+    addOp(&net, type, {"A", "B"}, {"Y"});
+    compareWithCPU(&ws, net);
+  }
+}
+
+TEST(VulkanTest, FC) {
+  SKIP_WITHOUT_VULKAN();
+  Workspace ws;
+  randomTensor(&ws, "X", {3, 8, 2, 2});
+  randomTensor(&ws, "W", {10, 32});
+  randomTensor(&ws, "b", {10});
+  NetDef net;
+  addOp(&net, "FC", {"X", "W", "b"}, {"Y"});
+  compareWithCPU(&ws, net);
+}
+
+TEST(VulkanTest, Pool) {
+  SKIP_WITHOUT_VULKAN();
+  for (const auto& type : {"MaxPool", "AveragePool"}) {
+    Workspace ws;
+    randomTensor(&ws, "X", {2, 5, 13, 11});
+    NetDef net;
+    auto* op = addOp(&net, type, {"X"}, {"Y"});
+    addArg(op, "kernel", 3);
+    addArg(op, "stride", 2);
+    addArg(op, "pad", 1);
+    compareWithCPU(&ws, net);
+  }
+}
+
+TEST(VulkanTest, Concat) {
+  SKIP_WITHOUT_VULKAN();
+  Workspace ws;
+  randomTensor(&ws, "X", {2, 3, 6, 6});
+  randomTensor(&ws, "W", {5, 3, 1, 1});
+  randomTensor(&ws, "b", {5});
+  NetDef net;
+  auto* conv = addOp(&net, "Conv", {"X", "W", "b"}, {"A"});
+  addArg(conv, "kernel", 1);
+  addOp(&net, "Relu", {"A"}, {"B"});
+  addOp(&net, "Concat", {"A", "B"}, {"Y", "split_info"});
+  compareWithCPU(&ws, net);
+}
+
+TEST(VulkanTest, Softmax) {
+  SKIP_WITHOUT_VULKAN();
+  Workspace ws;
+  randomTensor(&ws, "X", {4, 1000});
+  NetDef net;
+  addOp(&net, "Softmax", {"X"}, {"Y"});
+  compareWithCPU(&ws, net, 1e-5);
+}
+
+TEST(VulkanTest, OneSubmissionPerRun) {
+  SKIP_WITHOUT_VULKAN();
+  Workspace ws;
+  randomTensor(&ws, "X", {1, 3, 16, 16});
+  randomTensor(&ws, "W", {8, 3, 3, 3});
+  randomTensor(&ws, "b", {8});
+  randomTensor(&ws, "W_fc", {10, 8 * 8 * 8});
+  randomTensor(&ws, "b_fc", {10});
+  NetDef net;
+  auto* conv = addOp(&net, "Conv", {"X", "W", "b"}, {"A"});
+  addArg(conv, "kernel", 3);
+  addArg(conv, "pad", 1);
+  addOp(&net, "Relu", {"A"}, {"A"});
+  auto* pool = addOp(&net, "MaxPool", {"A"}, {"B"});
+  addArg(pool, "kernel", 2);
+  addArg(pool, "stride", 2);
+  addOp(&net, "FC", {"B", "W_fc", "b_fc"}, {"C"});
+  addOp(&net, "Softmax", {"C"}, {"Y"});
+  net.add_external_input("X");
+  net.add_external_output("Y");
+  net.set_name("vulkan_net");
+
+  auto* vulkanNet = ws.CreateNet(rewriteForVulkan(net));
+  ASSERT_TRUE(vulkanNet);
+  for (auto run = 0; run < 3; ++run) {
+    const auto submissions = getVulkanContext().numSubmissions();
+    ASSERT_TRUE(vulkanNet->Run());
+    EXPECT_EQ(getVulkanContext().numSubmissions(), submissions + 1);
+  }
+}
+
+#undef SKIP_WITHOUT_VULKAN
+
+} // namespace caffe2
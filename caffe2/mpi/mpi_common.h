@@ -25,6 +25,8 @@ template <typename T> class MPIDataTypeWrapper;
 MPI_DATATYPE_WRAPPER(char, MPI_CHAR)
 MPI_DATATYPE_WRAPPER(float, MPI_FLOAT)
 MPI_DATATYPE_WRAPPER(double, MPI_DOUBLE)
+MPI_DATATYPE_WRAPPER(int, MPI_INT)
+MPI_DATATYPE_WRAPPER(int64_t, MPI_INT64_T)
 // Note(Yangqing): as necessary, add more specializations.
 #undef MPI_DATATYPE_WRAPPER
 
@@ -0,0 +1,68 @@
+#include "caffe2/mpi/mpi_sharded_embedding_ops.h"
+
+namespace caffe2 {
+
+OPERATOR_SCHEMA(MPIShardedSparseLengthsSum)
+    .NumInputs(4)
+    .NumOutputs(4)
+    .Arg("shard_by", "How the table is sharded: \"row\" (default) or \"table\"")
+    .Arg("owner", "For shard_by = \"table\", the rank holding the table")
+    .SetDoc(R"DOC(
+SparseLengthsSum over an embedding table sharded across the ranks of an MPI
+common world. Each rank passes its shard of the table as DATA and its own
+INDICES (rows of the whole table) and LENGTHS. The indices are sent to the
+ranks holding their rows, pooled there per bag, and the partial sums are sent
+back, so that OUTPUT is the same as SparseLengthsSum over the whole table.
+
+With shard_by = "row", row i of the table is row i / size of the shard of
+rank i % size. With shard_by = "table", rank `owner` holds the whole table and
+the other ranks pass a DATA with no rows.
+
+The other outputs are the indices each rank received, which the gradient
+reuses; SHARD_INDICES are the local rows the gradient is for.
+)DOC")
+    .Input(0, "COMM", "The MPI common world.")
+    .Input(1, "DATA", "The local shard of the table.")
+    .Input(2, "INDICES", "Integer vector of rows of the whole table.")
+    .Input(3, "LENGTHS", "Vector of bag lengths, summing up to len(INDICES).")
+    .Output(0, "OUTPUT", "The pooled bags, of shape [len(LENGTHS), ...].")
+    .Output(1, "SHARD_LENGTHS", "The lengths of the bags received from every "
+            "rank, in the order of the ranks.")
+    .Output(2, "SHARD_INDICES", "The local rows received from every rank.")
+    .Output(3, "SHARD_BAGS", "The number of bags received from every rank.");
+
+OPERATOR_SCHEMA(MPIShardedSparseLengthsSumGradient)
+    .NumInputs(7)
+    .NumOutputs(1);
+
+REGISTER_CPU_OPERATOR(
+    MPIShardedSparseLengthsSum,
+    MPIShardedSparseLengthsSumOp);
+REGISTER_CPU_OPERATOR(
+    MPIShardedSparseLengthsSumGradient,
+    MPIShardedSparseLengthsSumGradientOp);
+
+namespace {
+
+class GetMPIShardedSparseLengthsSumGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    auto defs = SingleGradientDef(
+        "MPIShardedSparseLengthsSumGradient",
+        "",
+        vector<string>{I(0), GO(0), I(2), I(3), O(1), O(2), O(3)},
+        vector<string>{GI_V(1)});
+    // The gradient is for the local rows of the shard, so that the update of
+    // the table stays local too.
+    SetSparse(1, O(2), GI_V(1));
+    return defs;
+  }
+};
+
+} // namespace
+
+REGISTER_GRADIENT(
+    MPIShardedSparseLengthsSum,
+    GetMPIShardedSparseLengthsSumGradient);
+
+} // namespace caffe2
@@ -0,0 +1,393 @@
+#ifndef CAFFE2_MPI_MPI_SHARDED_EMBEDDING_OPS_H_
+#define CAFFE2_MPI_MPI_SHARDED_EMBEDDING_OPS_H_
+
+#include <mpi.h>
+
+#include <limits>
+#include <numeric>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/mpi/mpi_common.h"
+#include "caffe2/perfkernels/embedding_lookup.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Common parts of the sharded embedding ops: which rank holds which row of
+// the table, and the all-to-all exchanges between the ranks.
+//
+// With shard_by = "row" (the default), row i of the table is row i / size of
+// the shard held by rank i % size. With shard_by = "table", the whole table
+// is held by the rank given by the "owner" argument, and the other ranks pass
+// an empty (0 rows) DATA of the same width.
+class MPIShardedEmbeddingOpBase : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  MPIShardedEmbeddingOpBase(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        OP_SINGLE_ARG(string, "shard_by", shard_by_, "row"),
+        OP_SINGLE_ARG(int, "owner", owner_, 0) {
+    CAFFE_ENFORCE(
+        shard_by_ == "row" || shard_by_ == "table",
+        "Unknown shard_by: ",
+        shard_by_);
+  }
+
+  bool IsCommunicationOp() const override {
+    return true;
+  }
+
+ protected:
+  template <typename TInd>
+  inline int shardOf(TInd id, int size) const {
+    return shard_by_ == "row" ? id % size : owner_;
+  }
+
+  template <typename TInd>
+  inline int64_t localRow(TInd id, int size) const {
+    return shard_by_ == "row" ? id / size : id;
+  }
+
+  // For every bag, the number of its indices held by each rank, as
+  // counts[rank * num_bags + bag].
+  template <typename TInd>
+  void shardLengths(
+      const TInd* indices,
+      const int* lengths,
+      int num_bags,
+      int size,
+      std::vector<int>* counts) const {
+    counts->assign(size * num_bags, 0);
+    TIndex pos = 0;
+    for (int bag = 0; bag < num_bags; ++bag) {
+      for (int i = 0; i < lengths[bag]; ++i, ++pos) {
+        CAFFE_ENFORCE_GE(indices[pos], 0, "Negative index");
+        (*counts)[shardOf(indices[pos], size) * num_bags + bag]++;
+      }
+    }
+  }
+
+  template <typename T>
+  void alltoallv(
+      MPI_Comm comm,
+      const T* send,
+      const std::vector<int>& send_counts,
+      T* recv,
+      const std::vector<int>& recv_counts) {
+    std::vector<int> send_displs(send_counts.size(), 0);
+    std::vector<int> recv_displs(recv_counts.size(), 0);
+    for (int i = 1; i < send_counts.size(); ++i) {
+      send_displs[i] = send_displs[i - 1] + send_counts[i - 1];
+      recv_displs[i] = recv_displs[i - 1] + recv_counts[i - 1];
+    }
+    MPI_CHECK(MPI_Alltoallv(
+        const_cast<T*>(send),
+        const_cast<int*>(send_counts.data()),
+        send_displs.data(),
+        MPIDataTypeWrapper<T>::type(),
+        recv,
+        const_cast<int*>(recv_counts.data()),
+        recv_displs.data(),
+        MPIDataTypeWrapper<T>::type(),
+        comm));
+  }
+
+  // Like alltoallv, for rows of block_size floats.
+  void alltoallvRows(
+      MPI_Comm comm,
+      const float* send,
+      const std::vector<int>& send_rows,
+      float* recv,
+      const std::vector<int>& recv_rows,
+      TIndex block_size) {
+    std::vector<int> send_counts(send_rows.size());
+    std::vector<int> recv_counts(recv_rows.size());
+    for (int i = 0; i < send_rows.size(); ++i) {
+      CAFFE_ENFORCE_LE(
+          send_rows[i] * block_size, std::numeric_limits<int>::max());
+      CAFFE_ENFORCE_LE(
+          recv_rows[i] * block_size, std::numeric_limits<int>::max());
+      send_counts[i] = send_rows[i] * block_size;
+      recv_counts[i] = recv_rows[i] * block_size;
+    }
+    alltoallv(comm, send, send_counts, recv, recv_counts);
+  }
+
+  string shard_by_;
+  int owner_;
+};
+
+// SparseLengthsSum over a table sharded across the ranks of the common world.
+// Every rank sends each index to the rank holding its row, the rows are
+// pooled there with a local SparseLengthsSum, and the partial sums are sent
+// back and added up.
+class MPIShardedSparseLengthsSumOp final : public MPIShardedEmbeddingOpBase {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  using MPIShardedEmbeddingOpBase::MPIShardedEmbeddingOpBase;
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename TInd>
+  bool DoRunWithType() {
+    const auto& world = OperatorBase::Input<MPICommonWorldWrapper>(COMM);
+    const int size = world.size();
+    auto& data = Input(DATA);
+    auto& indices = Input(INDICES);
+    auto& lengths = Input(LENGTHS);
+    CAFFE_ENFORCE_GE(data.ndim(), 1, "DATA should be at least 1-D");
+    CAFFE_ENFORCE_EQ(indices.ndim(), 1, "INDICES should be 1-D");
+    CAFFE_ENFORCE_EQ(lengths.ndim(), 1, "LENGTHS should be 1-D");
+    const TIndex block_size = data.size_from_dim(1);
+    const int num_bags = lengths.dim(0);
+    const int* lengths_data = lengths.template data<int>();
+    const TInd* indices_data = indices.template data<TInd>();
+
+    // Route the indices to the ranks holding their rows, bag by bag.
+    std::vector<int> counts;
+    shardLengths(indices_data, lengths_data, num_bags, size, &counts);
+    std::vector<int> send_ids(size, 0);
+    for (int i = 0; i < counts.size(); ++i) {
+      send_ids[i / num_bags] += counts[i];
+    }
+    CAFFE_ENFORCE_EQ(
+        std::accumulate(send_ids.begin(), send_ids.end(), TIndex(0)),
+        indices.size(),
+        "LENGTHS don't add up to the size of INDICES");
+    std::vector<int64_t> routed(indices.size());
+    std::vector<TIndex> cursor(size, 0);
+    for (int rank = 1; rank < size; ++rank) {
+      cursor[rank] = cursor[rank - 1] + send_ids[rank - 1];
+    }
+    for (TIndex i = 0; i < indices.size(); ++i) {
+      auto rank = shardOf(indices_data[i], size);
+      routed[cursor[rank]++] = localRow(indices_data[i], size);
+    }
+
+    std::vector<int> send_sizes(2 * size);
+    for (int rank = 0; rank < size; ++rank) {
+      send_sizes[2 * rank] = num_bags;
+      send_sizes[2 * rank + 1] = send_ids[rank];
+    }
+    std::vector<int> recv_sizes(2 * size);
+    MPI_CHECK(MPI_Alltoall(
+        send_sizes.data(),
+        2,
+        MPI_INT,
+        recv_sizes.data(),
+        2,
+        MPI_INT,
+        world.comm()));
+    std::vector<int> recv_bags(size), recv_ids(size);
+    for (int rank = 0; rank < size; ++rank) {
+      recv_bags[rank] = recv_sizes[2 * rank];
+      recv_ids[rank] = recv_sizes[2 * rank + 1];
+    }
+
+    auto* shard_bags = Output(SHARD_BAGS);
+    shard_bags->Resize(size);
+    std::copy(
+        recv_bags.begin(),
+        recv_bags.end(),
+        shard_bags->template mutable_data<int>());
+    auto* shard_lengths = Output(SHARD_LENGTHS);
+    shard_lengths->Resize(
+        std::accumulate(recv_bags.begin(), recv_bags.end(), TIndex(0)));
+    alltoallv(
+        world.comm(),
+        counts.data(),
+        std::vector<int>(size, num_bags),
+        shard_lengths->template mutable_data<int>(),
+        recv_bags);
+    auto* shard_indices = Output(SHARD_INDICES);
+    shard_indices->Resize(
+        std::accumulate(recv_ids.begin(), recv_ids.end(), TIndex(0)));
+    alltoallv(
+        world.comm(),
+        routed.data(),
+        send_ids,
+        shard_indices->template mutable_data<int64_t>(),
+        recv_ids);
+
+    // Pool the local rows of the non-empty bags of every rank.
+    const int* shard_lengths_data = shard_lengths->template data<int>();
+    std::vector<int> pooled_lengths;
+    std::vector<int> pooled_rows(size, 0);
+    TIndex pos = 0;
+    for (int rank = 0; rank < size; ++rank) {
+      for (int bag = 0; bag < recv_bags[rank]; ++bag, ++pos) {
+        if (shard_lengths_data[pos] > 0) {
+          pooled_lengths.push_back(shard_lengths_data[pos]);
+          pooled_rows[rank]++;
+        }
+      }
+    }
+    std::vector<float> pooled(pooled_lengths.size() * block_size);
+    EmbeddingLookup(
+        block_size,
+        pooled_lengths.size(),
+        shard_indices->size(),
+        data.dim(0),
+        data.template data<float>(),
+        shard_indices->template data<int64_t>(),
+        pooled_lengths.data(),
+        nullptr,
+        nullptr,
+        false,
+        pooled.data());
+
+    // Send the partial sums back and add them up.
+    std::vector<int> partial_rows(size, 0);
+    for (int i = 0; i < counts.size(); ++i) {
+      partial_rows[i / num_bags] += counts[i] > 0;
+    }
+    std::vector<float> partial(
+        std::accumulate(partial_rows.begin(), partial_rows.end(), TIndex(0)) *
+        block_size);
+    alltoallvRows(
+        world.comm(),
+        pooled.data(),
+        pooled_rows,
+        partial.data(),
+        partial_rows,
+        block_size);
+
+    auto* output = Output(0);
+    auto shape = data.dims();
+    shape[0] = num_bags;
+    output->Resize(shape);
+    float* out = output->template mutable_data<float>();
+    math::Set<float, CPUContext>(output->size(), 0.f, out, &context_);
+    const float* row = partial.data();
+    for (int rank = 0; rank < size; ++rank) {
+      for (int bag = 0; bag < num_bags; ++bag) {
+        if (counts[rank * num_bags + bag] > 0) {
+          math::Add<float, CPUContext>(
+              block_size,
+              out + bag * block_size,
+              row,
+              out + bag * block_size,
+              &context_);
+          row += block_size;
+        }
+      }
+    }
+    return true;
+  }
+
+  INPUT_TAGS(COMM, DATA, INDICES, LENGTHS);
+  OUTPUT_TAGS(OUTPUT, SHARD_LENGTHS, SHARD_INDICES, SHARD_BAGS);
+};
+
+// The gradient of MPIShardedSparseLengthsSum: the output gradient of every
+// bag is sent to the ranks holding its rows, which expand it into the
+// gradient of their local rows, as values for the local SHARD_INDICES.
+class MPIShardedSparseLengthsSumGradientOp final
+    : public MPIShardedEmbeddingOpBase {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  using MPIShardedEmbeddingOpBase::MPIShardedEmbeddingOpBase;
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename TInd>
+  bool DoRunWithType() {
+    const auto& world = OperatorBase::Input<MPICommonWorldWrapper>(COMM);
+    const int size = world.size();
+    auto& grad = Input(GRAD);
+    auto& indices = Input(INDICES);
+    auto& lengths = Input(LENGTHS);
+    auto& shard_lengths = Input(SHARD_LENGTHS);
+    auto& shard_indices = Input(SHARD_INDICES);
+    auto& shard_bags = Input(SHARD_BAGS);
+    const int num_bags = lengths.dim(0);
+    CAFFE_ENFORCE_EQ(grad.dim(0), num_bags);
+    CAFFE_ENFORCE_EQ(shard_bags.size(), size);
+    const TIndex block_size = grad.size_from_dim(1);
+
+    // Send the gradient of every bag to the ranks that pooled rows for it.
+    std::vector<int> counts;
+    shardLengths(
+        indices.template data<TInd>(),
+        lengths.template data<int>(),
+        num_bags,
+        size,
+        &counts);
+    std::vector<int> send_rows(size, 0);
+    std::vector<float> send;
+    const float* grad_data = grad.template data<float>();
+    for (int rank = 0; rank < size; ++rank) {
+      for (int bag = 0; bag < num_bags; ++bag) {
+        if (counts[rank * num_bags + bag] > 0) {
+          send.insert(
+              send.end(),
+              grad_data + bag * block_size,
+              grad_data + (bag + 1) * block_size);
+          send_rows[rank]++;
+        }
+      }
+    }
+
+    const int* shard_lengths_data = shard_lengths.template data<int>();
+    const int* shard_bags_data = shard_bags.template data<int>();
+    std::vector<int> recv_rows(size, 0);
+    TIndex pos = 0;
+    for (int rank = 0; rank < size; ++rank) {
+      for (int bag = 0; bag < shard_bags_data[rank]; ++bag, ++pos) {
+        recv_rows[rank] += shard_lengths_data[pos] > 0;
+      }
+    }
+    CAFFE_ENFORCE_EQ(pos, shard_lengths.size());
+    std::vector<float> recv(
+        std::accumulate(recv_rows.begin(), recv_rows.end(), TIndex(0)) *
+        block_size);
+    alltoallvRows(
+        world.comm(),
+        send.data(),
+        send_rows,
+        recv.data(),
+        recv_rows,
+        block_size);
+
+    // Every local index gets the gradient of its bag.
+    auto* output = Output(0);
+    auto shape = grad.dims();
+    shape[0] = shard_indices.size();
+    output->Resize(shape);
+    float* out = output->template mutable_data<float>();
+    const float* row = recv.data();
+    TIndex index = 0;
+    for (TIndex bag = 0; bag < shard_lengths.size(); ++bag) {
+      if (shard_lengths_data[bag] == 0) {
+        continue;
+      }
+      for (int i = 0; i < shard_lengths_data[bag]; ++i, ++index) {
+        context_.template Copy<float, CPUContext, CPUContext>(
+            block_size, row, out + index * block_size);
+      }
+      row += block_size;
+    }
+    CAFFE_ENFORCE_EQ(index, shard_indices.size());
+    return true;
+  }
+
+  INPUT_TAGS(
+      COMM,
+      GRAD,
+      INDICES,
+      LENGTHS,
+      SHARD_LENGTHS,
+      SHARD_INDICES,
+      SHARD_BAGS);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_MPI_MPI_SHARDED_EMBEDDING_OPS_H_
@@ -1,6 +1,7 @@
 #include "caffe2/core/init.h"
 #include "caffe2/core/net.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/operator_gradient.h"
 #include "caffe2/mpi/mpi_common.h"
 #include <gtest/gtest.h>
 
@@ -299,6 +300,109 @@ TEST(MPITest, TestInPlaceMPIAllreduce) {
   }
 }
 
+
+TEST(MPITest, TestMPIShardedSparseLengthsSum) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  const int kRows = 7 * size + 1;
+  const int kDim = 3;
+
+  Workspace ws;
+  OperatorDef create_def;
+  create_def.set_type("MPICreateCommonWorld");
+  create_def.add_output("comm");
+  CreateOperator(create_def, &ws)->Run();
+
+  // Row i of the table is filled with i, and held by rank i % size.
+  auto* data = ws.CreateBlob("data")->GetMutable<TensorCPU>();
+  data->Resize((kRows - rank + size - 1) / size, kDim);
+  for (int i = 0; i < data->dim(0); ++i) {
+    for (int j = 0; j < kDim; ++j) {
+      data->mutable_data<float>()[i * kDim + j] = i * size + rank;
+    }
+  }
+  // Bags of different lengths, including an empty one.
+  std::vector<int> lengths = {2, 0, rank + 1};
+  std::vector<int64_t> indices;
+  for (int i = 0; i < 2 + rank + 1; ++i) {
+    indices.push_back((rank * 5 + i * 3) % kRows);
+  }
+  auto* lengths_tensor = ws.CreateBlob("lengths")->GetMutable<TensorCPU>();
+  lengths_tensor->Resize(lengths.size());
+  std::copy(
+      lengths.begin(), lengths.end(), lengths_tensor->mutable_data<int>());
+  auto* indices_tensor = ws.CreateBlob("indices")->GetMutable<TensorCPU>();
+  indices_tensor->Resize(indices.size());
+  std::copy(
+      indices.begin(), indices.end(), indices_tensor->mutable_data<int64_t>());
+
+  OperatorDef def;
+  def.set_type("MPIShardedSparseLengthsSum");
+  for (const char* input : {"comm", "data", "indices", "lengths"}) {
+    def.add_input(input);
+  }
+  for (const char* output :
+       {"out", "shard_lengths", "shard_indices", "shard_bags"}) {
+    def.add_output(output);
+  }
+  EXPECT_TRUE(CreateOperator(def, &ws)->Run());
+
+  auto& out = ws.GetBlob("out")->Get<TensorCPU>();
+  ASSERT_EQ(out.dim(0), lengths.size());
+  ASSERT_EQ(out.dim(1), kDim);
+  int pos = 0;
+  for (int bag = 0; bag < lengths.size(); ++bag) {
+    float expected = 0;
+    for (int i = 0; i < lengths[bag]; ++i) {
+      expected += indices[pos++];
+    }
+    for (int j = 0; j < kDim; ++j) {
+      EXPECT_EQ(out.data<float>()[bag * kDim + j], expected);
+    }
+  }
+
+  // The gradient of every bag is 1 + bag on every rank, so the gradient of a
+  // row is the sum of the bags it is in.
+  auto* grad = ws.CreateBlob("out_grad")->GetMutable<TensorCPU>();
+  grad->Resize(lengths.size(), kDim);
+  for (int i = 0; i < grad->size(); ++i) {
+    grad->mutable_data<float>()[i] = 1 + i / kDim;
+  }
+  vector<GradientWrapper> grad_outputs(4);
+  grad_outputs[0].dense_ = "out_grad";
+  auto meta = GetGradientForOp(def, grad_outputs);
+  ASSERT_EQ(meta.ops_.size(), 1);
+  EXPECT_EQ(meta.g_input_.at(1).indices_, "shard_indices");
+  EXPECT_TRUE(CreateOperator(meta.ops_[0], &ws)->Run());
+
+  auto& values = ws.GetBlob(meta.g_input_.at(1).values_)->Get<TensorCPU>();
+  auto& shard_indices = ws.GetBlob("shard_indices")->Get<TensorCPU>();
+  ASSERT_EQ(values.dim(0), shard_indices.size());
+  std::vector<float> row_grads(data->dim(0), 0);
+  for (int i = 0; i < shard_indices.size(); ++i) {
+    auto row = shard_indices.data<int64_t>()[i];
+    ASSERT_LT(row, data->dim(0));
+    row_grads[row] += values.data<float>()[i * kDim];
+  }
+  // Recompute the expected gradient from the indices of all the ranks.
+  for (int row = 0; row < data->dim(0); ++row) {
+    float expected = 0;
+    for (int other = 0; other < size; ++other) {
+      std::vector<int> other_lengths = {2, 0, other + 1};
+      int i = 0;
+      for (int bag = 0; bag < other_lengths.size(); ++bag) {
+        for (int k = 0; k < other_lengths[bag]; ++k, ++i) {
+          if ((other * 5 + i * 3) % kRows == row * size + rank) {
+            expected += 1 + bag;
+          }
+        }
+      }
+    }
+    EXPECT_EQ(row_grads[row], expected);
+  }
+}
 }  // namespace caffe2
 
 
@@ -0,0 +1,309 @@
+#include "caffe2/observers/calibration_observer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace caffe2 {
+
+namespace {
+
+// the number of uint8 values
+constexpr int kQuantizedLevels = 256;
+
+} // namespace
+
+void CalibrationHistogram::Add(const float* data, TIndex size) {
+  float local_min = 0;
+  float local_max = 0;
+  TIndex finite = 0;
+  for (TIndex i = 0; i < size; ++i) {
+    if (!std::isfinite(data[i])) {
+      continue;
+    }
+    local_min = finite ? std::min(local_min, data[i]) : data[i];
+    local_max = finite ? std::max(local_max, data[i]) : data[i];
+    ++finite;
+  }
+  if (finite == 0) {
+    return;
+  }
+
+  if (total_ == 0) {
+    min_ = local_min;
+    max_ = local_max;
+    range_min_ = std::min(local_min, 0.0f);
+    range_max_ = std::max(local_max, 0.0f);
+    if (range_max_ == range_min_) {
+      range_max_ = range_min_ + 1;
+    }
+  } else {
+    min_ = std::min(min_, local_min);
+    max_ = std::max(max_, local_max);
+    if (local_min < range_min_ || local_max > range_max_) {
+      Grow(std::min(local_min, range_min_), std::max(local_max, range_max_));
+    }
+  }
+
+  const int nbins = bins_.size();
+  const float width = bin_width();
+  for (TIndex i = 0; i < size; ++i) {
+    if (!std::isfinite(data[i])) {
+      continue;
+    }
+    int bin = static_cast<int>((data[i] - range_min_) / width);
+    bins_[std::min(std::max(bin, 0), nbins - 1)]++;
+  }
+  total_ += finite;
+}
+
+void CalibrationHistogram::Grow(float new_min, float new_max) {
+  const int nbins = bins_.size();
+  const float old_width = bin_width();
+  const float old_min = range_min_;
+  range_min_ = new_min;
+  range_max_ = new_max;
+  const float width = bin_width();
+  std::vector<uint64_t> bins(nbins, 0);
+  for (int i = 0; i < nbins; ++i) {
+    if (bins_[i] == 0) {
+      continue;
+    }
+    const float center = old_min + (i + 0.5f) * old_width;
+    int bin = static_cast<int>((center - range_min_) / width);
+    bins[std::min(std::max(bin, 0), nbins - 1)] += bins_[i];
+  }
+  bins_.swap(bins);
+}
+
+QuantizationParams ChooseQuantizationParams(float min, float max) {
+  // real 0 has to be representable exactly, e.g. for padding
+  min = std::min(min, 0.0f);
+  max = std::max(max, 0.0f);
+  QuantizationParams params;
+  params.scale = (max - min) / (kQuantizedLevels - 1);
+  if (params.scale == 0) {
+    params.scale = 1;
+  }
+  params.zero_point = std::min(
+      std::max(static_cast<int32_t>(std::nearbyint(-min / params.scale)), 0),
+      kQuantizedLevels - 1);
+  return params;
+}
+
+namespace {
+
+QuantizationParams ChooseByPercentile(
+    const CalibrationHistogram& histogram,
+    float percentile) {
+  CAFFE_ENFORCE(percentile > 0 && percentile <= 100);
+  const auto& bins = histogram.bins();
+  const int nbins = bins.size();
+  const double tail = histogram.total() * (1 - percentile / 100) / 2;
+  int low = 0;
+  for (double count = bins[0]; count <= tail && low < nbins - 1;) {
+    count += bins[++low];
+  }
+  int high = nbins - 1;
+  for (double count = bins[nbins - 1]; count <= tail && high > low;) {
+    count += bins[--high];
+  }
+  const float min = histogram.range_min() + low * histogram.bin_width();
+  const float max = histogram.range_min() + (high + 1) * histogram.bin_width();
+  return ChooseQuantizationParams(
+      std::max(min, histogram.min()), std::min(max, histogram.max()));
+}
+
+// Clipping the upper tail: for every candidate number of bins i, the values
+// beyond bin i are folded into it (P), and P is compared with its
+// quantization to kQuantizedLevels levels spread over the same bins (Q).
+QuantizationParams ChooseByKLDivergence(const CalibrationHistogram& histogram) {
+  const auto& bins = histogram.bins();
+  const int nbins = bins.size();
+  if (nbins <= kQuantizedLevels) {
+    return ChooseQuantizationParams(histogram.min(), histogram.max());
+  }
+
+  std::vector<double> suffix_sums(nbins + 1, 0);
+  for (int i = nbins - 1; i >= 0; --i) {
+    suffix_sums[i] = suffix_sums[i + 1] + bins[i];
+  }
+
+  int best_bins = nbins;
+  double best_divergence = std::numeric_limits<double>::infinity();
+  std::vector<double> p;
+  std::vector<double> q;
+  for (int i = kQuantizedLevels; i <= nbins; ++i) {
+    p.assign(bins.begin(), bins.begin() + i);
+    p[i - 1] += suffix_sums[i];
+
+    q.assign(i, 0);
+    for (int level = 0; level < kQuantizedLevels; ++level) {
+      const int start = static_cast<int64_t>(level) * i / kQuantizedLevels;
+      const int end = static_cast<int64_t>(level + 1) * i / kQuantizedLevels;
+      double sum = 0;
+      int nonzero = 0;
+      for (int j = start; j < end; ++j) {
+        sum += bins[j];
+        nonzero += bins[j] != 0;
+      }
+      // the mass of the level is spread over the bins that had values
+      for (int j = start; j < end; ++j) {
+        if (bins[j] != 0) {
+          q[j] = sum / nonzero;
+        }
+      }
+    }
+
+    const double p_total = suffix_sums[0];
+    const double q_total = suffix_sums[0] - suffix_sums[i];
+    if (q_total == 0) {
+      continue;
+    }
+    double divergence = 0;
+    for (int j = 0; j < i; ++j) {
+      if (p[j] == 0) {
+        continue;
+      }
+      const double pj = p[j] / p_total;
+      // only the folded last bin can have values Q has none for
+      const double qj = std::max(q[j] / q_total, 1e-12);
+      divergence += pj * std::log(pj / qj);
+    }
+    if (divergence < best_divergence) {
+      best_divergence = divergence;
+      best_bins = i;
+    }
+  }
+
+  const float max = histogram.range_min() + best_bins * histogram.bin_width();
+  return ChooseQuantizationParams(
+      histogram.min(), std::min(max, histogram.max()));
+}
+
+} // namespace
+
+QuantizationParams ChooseQuantizationParams(
+    const CalibrationHistogram& histogram,
+    CalibrationMethod method,
+    float percentile) {
+  CAFFE_ENFORCE_GT(histogram.total(), 0, "no values to calibrate with");
+  switch (method) {
+    case CalibrationMethod::MIN_MAX:
+      return ChooseQuantizationParams(histogram.min(), histogram.max());
+    case CalibrationMethod::PERCENTILE:
+      return ChooseByPercentile(histogram, percentile);
+    case CalibrationMethod::KL_DIVERGENCE:
+      return ChooseByKLDivergence(histogram);
+  }
+  CAFFE_THROW("Unknown calibration method");
+}
+
+CalibrationOperatorObserver::CalibrationOperatorObserver(
+    OperatorBase* op,
+    CalibrationNetObserver* netObserver)
+    : RNNCapableOperatorObserver(op), netObserver_(netObserver) {
+  CAFFE_ENFORCE(netObserver_, "Observers can't operate outside of the net");
+}
+
+void CalibrationOperatorObserver::Stop() {
+  if (!subject_->has_debug_def()) {
+    return;
+  }
+  const auto& def = subject_->debug_def();
+  const auto& outputs = subject_->Outputs();
+  for (int i = 0; i < outputs.size() && i < def.output_size(); ++i) {
+    if (!outputs[i]->IsType<TensorCPU>()) {
+      continue;
+    }
+    const auto& tensor = outputs[i]->Get<TensorCPU>();
+    if (tensor.IsType<float>() && tensor.size() > 0) {
+      netObserver_->Add(def.output(i), tensor);
+    }
+  }
+}
+
+std::unique_ptr<ObserverBase<OperatorBase>>
+CalibrationOperatorObserver::rnnCopy(OperatorBase* subject, int rnn_order)
+    const {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new CalibrationOperatorObserver(subject, netObserver_));
+}
+
+void CalibrationNetObserver::Add(
+    const std::string& blob,
+    const TensorCPU& tensor) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = histograms_.find(blob);
+  if (it == histograms_.end()) {
+    it = histograms_.emplace(blob, CalibrationHistogram(nbins_)).first;
+  }
+  it->second.Add(tensor.data<float>(), tensor.size());
+}
+
+const CalibrationHistogram* CalibrationNetObserver::histogram(
+    const std::string& blob) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = histograms_.find(blob);
+  return it == histograms_.end() ? nullptr : &it->second;
+}
+
+std::unordered_map<std::string, QuantizationParams>
+CalibrationNetObserver::quantizationParams(
+    CalibrationMethod method,
+    float percentile) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::unordered_map<std::string, QuantizationParams> params;
+  for (const auto& entry : histograms_) {
+    if (entry.second.total() == 0) {
+      continue;
+    }
+    params.emplace(
+        entry.first,
+        ChooseQuantizationParams(entry.second, method, percentile));
+  }
+  return params;
+}
+
+void CalibrationNetObserver::SetOutputQuantizationArgs(
+    NetDef* net,
+    CalibrationMethod method,
+    float percentile) const {
+  const auto params = quantizationParams(method, percentile);
+  for (auto& op : *net->mutable_op()) {
+    if (op.type().compare(0, 4, "Int8") != 0 || op.output_size() == 0) {
+      continue;
+    }
+    auto it = params.find(op.output(0));
+    if (it == params.end()) {
+      continue;
+    }
+    auto* args = op.mutable_arg();
+    for (int i = args->size() - 1; i >= 0; --i) {
+      if (args->Get(i).name() == "Y_scale" ||
+          args->Get(i).name() == "Y_zero_point") {
+        args->DeleteSubrange(i, 1);
+      }
+    }
+    auto* scale = op.add_arg();
+    scale->set_name("Y_scale");
+    scale->set_f(it->second.scale);
+    auto* zero_point = op.add_arg();
+    zero_point->set_name("Y_zero_point");
+    zero_point->set_i(it->second.zero_point);
+  }
+}
+
+std::string CalibrationNetObserver::debugInfo() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::stringstream ss;
+  for (const auto& entry : histograms_) {
+    ss << entry.first << ": [" << entry.second.min() << ", "
+       << entry.second.max() << "] over " << entry.second.total()
+       << " values\n";
+  }
+  return ss.str();
+}
+
+} // namespace caffe2
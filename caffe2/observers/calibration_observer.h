@@ -0,0 +1,150 @@
+#ifndef CAFFE2_CONTRIB_OBSERVERS_CALIBRATION_OBSERVER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_CALIBRATION_OBSERVER_H_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+#include "caffe2/operators/rnn/rnn_capable_operator_observer.h"
+
+namespace caffe2 {
+
+// Histogram of the values of a tensor over many runs. The range always
+// contains 0 and grows to cover every value seen; when it grows, the counts
+// collected so far are moved to the bins containing their old bin centers.
+class CalibrationHistogram {
+ public:
+  explicit CalibrationHistogram(int nbins) : bins_(nbins, 0) {}
+
+  void Add(const float* data, TIndex size);
+
+  // the smallest and largest values seen
+  float min() const {
+    return min_;
+  }
+  float max() const {
+    return max_;
+  }
+  // bin i counts the values in
+  // [range_min() + i * bin_width(), range_min() + (i + 1) * bin_width())
+  float range_min() const {
+    return range_min_;
+  }
+  float bin_width() const {
+    return (range_max_ - range_min_) / bins_.size();
+  }
+  const std::vector<uint64_t>& bins() const {
+    return bins_;
+  }
+  uint64_t total() const {
+    return total_;
+  }
+
+ private:
+  void Grow(float new_min, float new_max);
+
+  float min_ = 0;
+  float max_ = 0;
+  float range_min_ = 0;
+  float range_max_ = 0;
+  uint64_t total_ = 0;
+  std::vector<uint64_t> bins_;
+};
+
+// uint8 quantization of a tensor: real = scale * (q - zero_point), what the
+// Int8* operators take as their Y_scale and Y_zero_point arguments.
+struct QuantizationParams {
+  float scale;
+  int32_t zero_point;
+};
+
+enum class CalibrationMethod {
+  // the full range of values seen
+  MIN_MAX,
+  // clips both tails, keeping the given percentile of the values
+  PERCENTILE,
+  // clips the upper tail to the threshold minimizing the KL divergence
+  // between the histogram and its quantized version, see
+  // http://on-demand.gputechconf.com/gtc/2017/presentation/s7310-8-bit-inference-with-tensorrt.pdf
+  KL_DIVERGENCE,
+};
+
+QuantizationParams ChooseQuantizationParams(float min, float max);
+QuantizationParams ChooseQuantizationParams(
+    const CalibrationHistogram& histogram,
+    CalibrationMethod method,
+    float percentile = 99.99f);
+
+class CalibrationNetObserver;
+
+class CalibrationOperatorObserver final : public RNNCapableOperatorObserver {
+ public:
+  explicit CalibrationOperatorObserver(OperatorBase* op) = delete;
+  CalibrationOperatorObserver(
+      OperatorBase* op,
+      CalibrationNetObserver* netObserver);
+  std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
+      OperatorBase* subject,
+      int rnn_order) const override;
+
+ private:
+  void Start() override {}
+  void Stop() override;
+
+  CalibrationNetObserver* netObserver_;
+};
+
+// Collects the histograms of the float CPU outputs of every operator of a
+// net over its runs (e.g. over a calibration dataset), and turns them into
+// quantization parameters for the int8 version of the net.
+class CalibrationNetObserver final
+    : public OperatorAttachingNetObserver<
+          CalibrationOperatorObserver,
+          CalibrationNetObserver> {
+ public:
+  explicit CalibrationNetObserver(NetBase* subject, int nbins = 2048)
+      : OperatorAttachingNetObserver<
+            CalibrationOperatorObserver,
+            CalibrationNetObserver>(subject, this),
+        nbins_(nbins) {}
+
+  // nullptr if the blob was never seen
+  const CalibrationHistogram* histogram(const std::string& blob) const;
+
+  std::unordered_map<std::string, QuantizationParams> quantizationParams(
+      CalibrationMethod method,
+      float percentile = 99.99f) const;
+
+  // Sets Y_scale and Y_zero_point on the Int8* operators of net whose first
+  // output was calibrated; the blob names of net have to be those of the
+  // observed net.
+  void SetOutputQuantizationArgs(
+      NetDef* net,
+      CalibrationMethod method,
+      float percentile = 99.99f) const;
+
+  std::string debugInfo() override;
+
+  friend class CalibrationOperatorObserver;
+
+ private:
+  void Start() override {}
+  void Stop() override {}
+
+  void Add(const std::string& blob, const TensorCPU& tensor);
+
+  int nbins_;
+  // operators of async nets run concurrently
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, CalibrationHistogram> histograms_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_CALIBRATION_OBSERVER_H_
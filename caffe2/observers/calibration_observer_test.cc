@@ -0,0 +1,130 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "calibration_observer.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+// Writes 0, 0.1, ..., 99.9 and, with the outlier argument, one 1000.
+class CalibrationTestFillOp final : public Operator<CPUContext> {
+ public:
+  CalibrationTestFillOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        outlier_(OperatorBase::GetSingleArgument<int>("outlier", 0)) {}
+
+  bool RunOnDevice() override {
+    auto* Y = Output(0);
+    Y->Resize(outlier_ ? 1001 : 1000);
+    float* data = Y->mutable_data<float>();
+    for (int i = 0; i < 1000; ++i) {
+      data[i] = i * 0.1f;
+    }
+    if (outlier_) {
+      data[1000] = 1000;
+    }
+    return true;
+  }
+
+ private:
+  int outlier_;
+};
+
+REGISTER_CPU_OPERATOR(CalibrationTestFill, CalibrationTestFillOp);
+OPERATOR_SCHEMA(CalibrationTestFill).NumInputs(0).NumOutputs(1);
+
+} // namespace
+
+TEST(CalibrationObserverTest, Histogram) {
+  CalibrationHistogram histogram(10);
+  const std::vector<float> first = {1, 2, 3, 4};
+  histogram.Add(first.data(), first.size());
+  EXPECT_EQ(histogram.total(), 4);
+  EXPECT_FLOAT_EQ(histogram.range_min(), 0);
+  EXPECT_FLOAT_EQ(histogram.bin_width(), 0.4f);
+
+  // grows the range to [-4, 4], keeping the counts
+  const std::vector<float> second = {-4, -3};
+  histogram.Add(second.data(), second.size());
+  EXPECT_EQ(histogram.total(), 6);
+  EXPECT_FLOAT_EQ(histogram.min(), -4);
+  EXPECT_FLOAT_EQ(histogram.max(), 4);
+  EXPECT_FLOAT_EQ(histogram.range_min(), -4);
+  uint64_t sum = 0;
+  for (auto count : histogram.bins()) {
+    sum += count;
+  }
+  EXPECT_EQ(sum, 6);
+  EXPECT_EQ(histogram.bins()[0], 1);
+  EXPECT_EQ(histogram.bins()[9], 1);
+}
+
+TEST(CalibrationObserverTest, ChooseQuantizationParams) {
+  auto params = ChooseQuantizationParams(-1.0f, 3.0f);
+  EXPECT_FLOAT_EQ(params.scale, 4.0f / 255);
+  EXPECT_EQ(params.zero_point, 64);
+  // 0 is always representable
+  params = ChooseQuantizationParams(2.0f, 4.0f);
+  EXPECT_FLOAT_EQ(params.scale, 4.0f / 255);
+  EXPECT_EQ(params.zero_point, 0);
+}
+
+TEST(CalibrationObserverTest, NetObserver) {
+  Workspace ws;
+  NetDef net_def;
+  {
+    auto& op = *net_def.add_op();
+    op.set_type("CalibrationTestFill");
+    op.add_output("Y");
+    auto& arg = *op.add_arg();
+    arg.set_name("outlier");
+    arg.set_i(1);
+  }
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  auto net_ob = caffe2::make_unique<CalibrationNetObserver>(net.get());
+  const auto* ob = net_ob.get();
+  net->AttachObserver(std::move(net_ob));
+  for (int i = 0; i < 3; ++i) {
+    net->Run();
+  }
+
+  const auto* histogram = ob->histogram("Y");
+  ASSERT_NE(histogram, nullptr);
+  EXPECT_EQ(histogram->total(), 3 * 1001);
+  EXPECT_FLOAT_EQ(histogram->max(), 1000);
+
+  auto min_max = ob->quantizationParams(CalibrationMethod::MIN_MAX).at("Y");
+  EXPECT_FLOAT_EQ(min_max.scale, 1000.0f / 255);
+  EXPECT_EQ(min_max.zero_point, 0);
+  // the outlier is 0.1% of the values
+  auto percentile =
+      ob->quantizationParams(CalibrationMethod::PERCENTILE, 99.8f).at("Y");
+  EXPECT_GT(percentile.scale * 255, 99.0f);
+  EXPECT_LT(percentile.scale * 255, 101.0f);
+  EXPECT_EQ(percentile.zero_point, 0);
+  // never clips into the bulk of the values
+  auto kl = ob->quantizationParams(CalibrationMethod::KL_DIVERGENCE).at("Y");
+  EXPECT_GT(kl.scale * 255, 99.0f);
+  EXPECT_LE(kl.scale, min_max.scale);
+
+  NetDef int8_net;
+  {
+    auto& op = *int8_net.add_op();
+    op.set_type("Int8Quantize");
+    op.add_input("X");
+    op.add_output("Y");
+    auto& arg = *op.add_arg();
+    arg.set_name("Y_scale");
+    arg.set_f(1);
+  }
+  ob->SetOutputQuantizationArgs(&int8_net, CalibrationMethod::MIN_MAX);
+  ArgumentHelper helper(int8_net.op(0));
+  EXPECT_FLOAT_EQ(helper.GetSingleArgument<float>("Y_scale", 0), min_max.scale);
+  EXPECT_EQ(helper.GetSingleArgument<int>("Y_zero_point", -1), 0);
+  EXPECT_EQ(int8_net.op(0).arg_size(), 2);
+}
+
+} // namespace caffe2
@@ -0,0 +1,269 @@
+#include "perf_counter_observer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator_schema.h"
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+namespace {
+
+#ifdef __linux__
+// A group of the three counters of the calling thread, in user space,
+// counting from the first read on. The group is read at once, so the counts
+// are consistent with each other.
+class ThreadPerfCounters {
+ public:
+  ThreadPerfCounters() {
+    const uint64_t configs[] = {PERF_COUNT_HW_CPU_CYCLES,
+                                PERF_COUNT_HW_INSTRUCTIONS,
+                                PERF_COUNT_HW_CACHE_MISSES};
+    for (int i = 0; i < kNumCounters; ++i) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fds_[i] = syscall(
+          __NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0);
+      if (fds_[i] < 0) {
+        VLOG(1) << "perf_event_open failed, hardware counters are disabled";
+        close();
+        return;
+      }
+    }
+  }
+
+  ~ThreadPerfCounters() {
+    close();
+  }
+
+  bool available() const {
+    return fds_[0] >= 0;
+  }
+
+  PerfCounterValues read() const {
+    PerfCounterValues values;
+    // nr, then the values of the group in order of creation
+    uint64_t buffer[1 + kNumCounters];
+    if (!available() ||
+        ::read(fds_[0], buffer, sizeof(buffer)) != sizeof(buffer) ||
+        buffer[0] != kNumCounters) {
+      return values;
+    }
+    values.cycles = buffer[1];
+    values.instructions = buffer[2];
+    values.llc_misses = buffer[3];
+    return values;
+  }
+
+ private:
+  void close() {
+    for (int i = kNumCounters - 1; i >= 0; --i) {
+      if (fds_[i] >= 0) {
+        ::close(fds_[i]);
+      }
+      fds_[i] = -1;
+    }
+  }
+
+  static constexpr int kNumCounters = 3;
+  int fds_[kNumCounters] = {-1, -1, -1};
+};
+
+const ThreadPerfCounters& threadPerfCounters() {
+  static thread_local ThreadPerfCounters counters;
+  return counters;
+}
+#endif // __linux__
+
+uint64_t tensorBytes(const TensorShape& shape) {
+  if (shape.unknown_shape()) {
+    return 0;
+  }
+  uint64_t size = DataTypeToTypeMeta(shape.data_type()).itemsize();
+  for (auto d : shape.dims()) {
+    size *= d;
+  }
+  return size;
+}
+
+void accumulate(const OperatorPerfStats& from, OperatorPerfStats* to) {
+  to->runs += from.runs;
+  to->milliseconds += from.milliseconds;
+  to->counters.cycles += from.counters.cycles;
+  to->counters.instructions += from.counters.instructions;
+  to->counters.llc_misses += from.counters.llc_misses;
+  to->flops += from.flops;
+  to->bytes_moved += from.bytes_moved;
+}
+
+} // namespace
+
+bool PerfCountersAvailable() {
+#ifdef __linux__
+  return threadPerfCounters().available();
+#else
+  return false;
+#endif
+}
+
+PerfCounterValues ReadPerfCounters() {
+#ifdef __linux__
+  return threadPerfCounters().read();
+#else
+  return PerfCounterValues();
+#endif
+}
+
+PerfCounterOperatorObserver::PerfCounterOperatorObserver(
+    OperatorBase* op,
+    PerfCounterNetObserver* netObserver)
+    : RNNCapableOperatorObserver(op), netObserver_(netObserver) {
+  CAFFE_ENFORCE(netObserver_, "Observers can't operate outside of the net");
+  if (op->has_debug_def()) {
+    stats_.type = op->debug_def().type();
+    if (op->debug_def().output_size() > 0) {
+      stats_.output = op->debug_def().output(0);
+    }
+  }
+}
+
+std::unique_ptr<ObserverBase<OperatorBase>>
+PerfCounterOperatorObserver::rnnCopy(OperatorBase* subject, int rnn_order)
+    const {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new PerfCounterOperatorObserver(subject, netObserver_));
+}
+
+OperatorPerfStats PerfCounterOperatorObserver::stats() const {
+  return stats_;
+}
+
+void PerfCounterOperatorObserver::Start() {
+  timer_.Start();
+  start_ = ReadPerfCounters();
+}
+
+void PerfCounterOperatorObserver::Stop() {
+  const auto end = ReadPerfCounters();
+  stats_.milliseconds += timer_.MilliSeconds();
+  stats_.counters.cycles += end.cycles - start_.cycles;
+  stats_.counters.instructions += end.instructions - start_.instructions;
+  stats_.counters.llc_misses += end.llc_misses - start_.llc_misses;
+  ++stats_.runs;
+
+  // The shapes may change between runs, so the cost is estimated every time.
+  auto* op = subject();
+  const OpSchema* schema = OpSchemaRegistry::Schema(stats_.type);
+  if (schema && schema->HasCostInferenceFunction() && op->has_debug_def()) {
+    const auto cost =
+        schema->InferCost(op->debug_def(), op->InputTensorShapes());
+    stats_.flops += cost.flops;
+    stats_.bytes_moved += cost.bytes_moved;
+  } else {
+    for (const Blob* blob : op->Inputs()) {
+      stats_.bytes_moved += tensorBytes(GetTensorShapeOfBlob(blob));
+    }
+    for (const Blob* blob : op->Outputs()) {
+      stats_.bytes_moved += tensorBytes(GetTensorShapeOfBlob(blob));
+    }
+  }
+}
+
+std::vector<OperatorPerfStats> PerfCounterNetObserver::operatorStats() const {
+  std::vector<OperatorPerfStats> stats;
+  for (const auto* observer : operator_observers_) {
+    stats.push_back(observer->stats());
+  }
+  return stats;
+}
+
+std::vector<OperatorPerfStats> PerfCounterNetObserver::typeStats() const {
+  std::map<std::string, OperatorPerfStats> byType;
+  for (const auto* observer : operator_observers_) {
+    const auto stats = observer->stats();
+    auto& total = byType[stats.type];
+    total.type = stats.type;
+    accumulate(stats, &total);
+  }
+  std::vector<OperatorPerfStats> stats;
+  for (const auto& it : byType) {
+    stats.push_back(it.second);
+  }
+  std::stable_sort(
+      stats.begin(),
+      stats.end(),
+      [](const OperatorPerfStats& a, const OperatorPerfStats& b) {
+        return a.milliseconds > b.milliseconds;
+      });
+  return stats;
+}
+
+std::string PerfCounterNetObserver::report(
+    double peak_gflops,
+    double peak_gbps) const {
+  const bool roofline = peak_gflops > 0 && peak_gbps > 0;
+  std::stringstream ss;
+  ss << std::left << std::setw(24) << "type" << std::right << std::setw(8)
+     << "runs" << std::setw(12) << "ms" << std::setw(16) << "cycles"
+     << std::setw(8) << "IPC" << std::setw(14) << "LLC misses"
+     << std::setw(12) << "GFLOP" << std::setw(12) << "MB" << std::setw(10)
+     << "flop/B" << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s";
+  if (roofline) {
+    ss << std::setw(9) << "bound" << std::setw(9) << "% roof";
+  }
+  ss << "\n";
+  ss << std::fixed;
+  for (const auto& stats : typeStats()) {
+    const double seconds = stats.milliseconds / 1000;
+    const double gflops = stats.flops / 1e9;
+    const double gbytes = stats.bytes_moved / 1e9;
+    const double intensity =
+        stats.bytes_moved > 0 ? double(stats.flops) / stats.bytes_moved : 0;
+    const double ipc = stats.counters.cycles > 0
+        ? double(stats.counters.instructions) / stats.counters.cycles
+        : 0;
+    const double achievedGflops = seconds > 0 ? gflops / seconds : 0;
+    const double achievedGbps = seconds > 0 ? gbytes / seconds : 0;
+    ss << std::left << std::setw(24) << stats.type << std::right
+       << std::setw(8) << stats.runs << std::setw(12) << std::setprecision(3)
+       << stats.milliseconds << std::setw(16) << stats.counters.cycles
+       << std::setw(8) << std::setprecision(2) << ipc << std::setw(14)
+       << stats.counters.llc_misses << std::setw(12) << std::setprecision(3)
+       << gflops << std::setw(12) << std::setprecision(2)
+       << stats.bytes_moved / 1e6 << std::setw(10) << intensity
+       << std::setw(10) << achievedGflops << std::setw(10) << achievedGbps;
+    if (roofline) {
+      // The roof of an op is the lower of the compute peak and the bandwidth
+      // peak times its arithmetic intensity.
+      const bool memoryBound = intensity * peak_gbps < peak_gflops;
+      const double roof = std::min(peak_gflops, intensity * peak_gbps);
+      // Without flops, the op is measured against the bandwidth alone.
+      const double fraction = stats.flops > 0
+          ? (roof > 0 ? achievedGflops / roof : 0)
+          : achievedGbps / peak_gbps;
+      ss << std::setw(9) << (memoryBound ? "memory" : "compute")
+         << std::setw(9) << std::setprecision(1) << 100 * fraction;
+    }
+    ss << "\n";
+  }
+  return ss.str();
+}
+
+} // namespace caffe2
@@ -0,0 +1,110 @@
+#ifndef CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTER_OBSERVER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTER_OBSERVER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+#include "caffe2/operators/rnn/rnn_capable_operator_observer.h"
+
+namespace caffe2 {
+
+// Hardware counters of the calling thread, from perf_event on Linux. They
+// only count the thread running the operator, not the threads of its thread
+// pool.
+struct PerfCounterValues {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t llc_misses = 0;
+};
+
+// Whether the counters can be read in this process (perf_event_open may be
+// disallowed by /proc/sys/kernel/perf_event_paranoid, or in containers).
+bool PerfCountersAvailable();
+
+// The current counts of the calling thread; all zeros if unavailable.
+PerfCounterValues ReadPerfCounters();
+
+// Totals over the runs of an operator.
+struct OperatorPerfStats {
+  std::string type;
+  std::string output;
+  int64_t runs = 0;
+  double milliseconds = 0;
+  PerfCounterValues counters;
+  // From the cost inference function of the op's schema, or the sizes of its
+  // inputs and outputs (and no flops) without one.
+  uint64_t flops = 0;
+  uint64_t bytes_moved = 0;
+};
+
+class PerfCounterNetObserver;
+
+class PerfCounterOperatorObserver final : public RNNCapableOperatorObserver {
+ public:
+  explicit PerfCounterOperatorObserver(OperatorBase* op) = delete;
+  PerfCounterOperatorObserver(
+      OperatorBase* op,
+      PerfCounterNetObserver* netObserver);
+  std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
+      OperatorBase* subject,
+      int rnn_order) const override;
+
+  OperatorPerfStats stats() const;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  PerfCounterNetObserver* netObserver_;
+  Timer timer_;
+  PerfCounterValues start_;
+  // the same operator may run on any thread of an async net, but not
+  // concurrently with itself
+  OperatorPerfStats stats_;
+};
+
+// Records the time, hardware counters and estimated flops and memory traffic
+// of every operator of a net over its runs. The report aggregates them by
+// operator type, roofline style: arithmetic intensity (flops per byte
+// moved), achieved GFLOP/s and GB/s, and, given the peak flops and
+// bandwidth of the machine, whether each type is bound by memory or compute
+// and how close it gets to its roof.
+class PerfCounterNetObserver final
+    : public OperatorAttachingNetObserver<
+          PerfCounterOperatorObserver,
+          PerfCounterNetObserver> {
+ public:
+  explicit PerfCounterNetObserver(NetBase* subject)
+      : OperatorAttachingNetObserver<
+            PerfCounterOperatorObserver,
+            PerfCounterNetObserver>(subject, this) {}
+
+  // One entry per operator of the net, in net order.
+  std::vector<OperatorPerfStats> operatorStats() const;
+
+  // The per type totals, most time first.
+  std::vector<OperatorPerfStats> typeStats() const;
+
+  // A table of typeStats(). The bound and roof columns need peak_gflops and
+  // peak_gbps.
+  std::string report(double peak_gflops = 0, double peak_gbps = 0) const;
+
+  std::string debugInfo() override {
+    return report();
+  }
+
+ private:
+  void Start() override {}
+  void Stop() override {}
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTER_OBSERVER_H_
@@ -0,0 +1,80 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+#include "perf_counter_observer.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+void fill(Workspace* ws, const std::string& name, const vector<TIndex>& dims) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  CPUContext context;
+  math::Set<float, CPUContext>(
+      tensor->size(), 0.5f, tensor->mutable_data<float>(), &context);
+}
+
+unique_ptr<NetBase> CreateNetTestHelper(Workspace* ws) {
+  NetDef net_def;
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("FC");
+    op.add_input("in");
+    op.add_input("W");
+    op.add_input("b");
+    op.add_output("hidden");
+  }
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("Relu");
+    op.add_input("hidden");
+    op.add_output("out");
+  }
+  net_def.add_external_input("in");
+  net_def.add_external_output("out");
+
+  return CreateNet(net_def, ws);
+}
+} // namespace
+
+TEST(PerfCounterObserverTest, TwoRuns) {
+  Workspace ws;
+  fill(&ws, "in", {16, 32});
+  fill(&ws, "W", {8, 32});
+  fill(&ws, "b", {8});
+  unique_ptr<NetBase> net(CreateNetTestHelper(&ws));
+  auto net_ob = caffe2::make_unique<PerfCounterNetObserver>(net.get());
+  const auto* ob = net_ob.get();
+  net->AttachObserver(std::move(net_ob));
+  ASSERT_TRUE(net->Run());
+  ASSERT_TRUE(net->Run());
+
+  const auto stats = ob->operatorStats();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].type, "FC");
+  EXPECT_EQ(stats[0].output, "hidden");
+  EXPECT_EQ(stats[1].type, "Relu");
+  for (const auto& op : stats) {
+    EXPECT_EQ(op.runs, 2);
+    EXPECT_GT(op.bytes_moved, 0);
+  }
+  // 2 runs of 16 x 8 dot products of size 32
+  EXPECT_GE(stats[0].flops, 2 * 16 * 8 * 32);
+  if (!PerfCountersAvailable()) {
+    EXPECT_EQ(stats[0].counters.cycles, 0);
+  }
+
+  const auto types = ob->typeStats();
+  EXPECT_EQ(types.size(), 2);
+  const auto report = ob->report(100, 10);
+  LOG(INFO) << "\n" << report;
+  EXPECT_NE(report.find("FC"), std::string::npos);
+  EXPECT_NE(report.find("Relu"), std::string::npos);
+  EXPECT_NE(report.find("bound"), std::string::npos);
+}
+} // namespace caffe2
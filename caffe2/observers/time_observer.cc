@@ -5,21 +5,38 @@ namespace caffe2 {
 
 void TimeObserver::Start() {
   start_time_ = timer_.MilliSeconds();
+  run_timer_.Start();
   ++iterations_;
 }
 
 void TimeObserver::Stop() {
+  latency_ns_->record(run_timer_.NanoSeconds());
   double current_run = timer_.MilliSeconds() - start_time_;
   total_time_ += current_run;
   VLOG(1) << "This net iteration took " << current_run << " ms to complete.\n";
 }
 
+TimeOperatorObserver::TimeOperatorObserver(
+    OperatorBase* subject,
+    TimeObserver* netObserver)
+    : RNNCapableOperatorObserver(subject) {
+  if (netObserver && subject->has_debug_def()) {
+    latency_ns_ = StatRegistry::get().addHistogram(
+        netObserver->subject()->Name() + "/" + subject->debug_def().type() +
+        "/latency_ns");
+  }
+}
+
 void TimeOperatorObserver::Start() {
   start_time_ = timer_.MilliSeconds();
+  run_timer_.Start();
   ++iterations_;
 }
 
 void TimeOperatorObserver::Stop() {
+  if (latency_ns_) {
+    latency_ns_->record(run_timer_.NanoSeconds());
+  }
   double current_run = timer_.MilliSeconds() - start_time_;
   total_time_ += current_run;
   VLOG(1) << "This operator iteration took " << current_run
@@ -29,8 +46,9 @@ void TimeOperatorObserver::Stop() {
 std::unique_ptr<ObserverBase<OperatorBase>> TimeOperatorObserver::rnnCopy(
     OperatorBase* subject,
     int rnn_order) const {
-  return std::unique_ptr<ObserverBase<OperatorBase>>(
-      new TimeOperatorObserver(subject, nullptr));
+  auto* copy = new TimeOperatorObserver(subject, nullptr);
+  copy->latency_ns_ = latency_ns_;
+  return std::unique_ptr<ObserverBase<OperatorBase>>(copy);
 }
 
 } // namespace caffe2
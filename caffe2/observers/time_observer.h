@@ -7,6 +7,7 @@
 #include "caffe2/core/net.h"
 #include "caffe2/core/observer.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
 #include "caffe2/core/timer.h"
 #include "caffe2/observers/operator_attaching_net_observer.h"
 #include "caffe2/operators/rnn/rnn_capable_operator_observer.h"
@@ -26,16 +27,19 @@ class TimeCounter {
   float start_time_ = 0.0f;
   float total_time_ = 0.0f;
   int iterations_ = 0;
+  // Times every run for the latency percentiles exported by StatRegistry.
+  Timer run_timer_;
+  StatHistogram* latency_ns_ = nullptr;
 };
 
 class TimeOperatorObserver final : public TimeCounter,
                                    public RNNCapableOperatorObserver {
  public:
   explicit TimeOperatorObserver(OperatorBase* subject) = delete;
-  explicit TimeOperatorObserver(
-      OperatorBase* subject,
-      TimeObserver* /* unused */)
-      : RNNCapableOperatorObserver(subject) {}
+  // Records the latency of the operator in the histogram
+  // "<net name>/<operator type>/latency_ns" of StatRegistry::get(), shared by
+  // the operators of the same type.
+  TimeOperatorObserver(OperatorBase* subject, TimeObserver* netObserver);
   std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
       OperatorBase* subject,
       int rnn_order) const override;
@@ -45,6 +49,8 @@ class TimeOperatorObserver final : public TimeCounter,
   void Stop() override;
 };
 
+// Also records the latency of the net in the histogram
+// "<net name>/latency_ns" of StatRegistry::get().
 class TimeObserver final
     : public TimeCounter,
       public OperatorAttachingNetObserver<TimeOperatorObserver, TimeObserver> {
@@ -52,7 +58,10 @@ class TimeObserver final
   explicit TimeObserver(NetBase* subject)
       : OperatorAttachingNetObserver<TimeOperatorObserver, TimeObserver>(
             subject,
-            this) {}
+            this) {
+    latency_ns_ =
+        StatRegistry::get().addHistogram(subject->Name() + "/latency_ns");
+  }
 
   float average_time_children() const {
     float sum = 0.0f;
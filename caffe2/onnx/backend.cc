@@ -14,12 +14,28 @@
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
+#include <algorithm>
 #include <cmath>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <list>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
+CAFFE2_DEFINE_int64(
+    caffe2_onnx_prepared_cache_bytes,
+    256 << 20,
+    "Size of the cache of the nets converted by Caffe2Backend::Prepare, by "
+    "model, device and extras. 0 disables the cache.");
+CAFFE2_DEFINE_int(
+    caffe2_onnx_conversion_threads,
+    4,
+    "Number of threads converting the initializers of large ONNX models.");
+
 namespace caffe2 {
 namespace onnx {
 
@@ -27,6 +43,97 @@ namespace {
 
 constexpr static int kKnownOpsetVersion = 6;
 
+// Below this total size, initializers are converted by the calling thread
+constexpr static size_t kParallelConversionBytes = 16 << 20;
+
+// The converted nets of the models prepared recently, least recently used
+// first out. Models are identified by hash and size rather than kept, so a
+// hit costs a hash of the model instead of a copy of it.
+class PreparedModelCache {
+ public:
+  struct Entry {
+    caffe2::NetDef init_net;
+    caffe2::NetDef pred_net;
+    std::vector<std::string> uninitialized_inputs;
+  };
+
+  static PreparedModelCache& Get() {
+    static PreparedModelCache cache;
+    return cache;
+  }
+
+  static std::string Key(
+      const std::string& onnx_model_str,
+      const std::string& device,
+      const std::vector<Caffe2Ops>& extras) {
+    std::string serialized_extras;
+    for (const auto& c2ops : extras) {
+      for (const auto* ops : {&c2ops.init_ops, &c2ops.ops}) {
+        for (const auto& op : *ops) {
+          std::string s;
+          op.SerializeToString(&s);
+          serialized_extras += s;
+        }
+      }
+      for (const auto& blob : c2ops.interface_blobs) {
+        serialized_extras += blob;
+      }
+    }
+    std::hash<std::string> hash;
+    return caffe2::MakeString(
+        hash(onnx_model_str),
+        ":",
+        onnx_model_str.size(),
+        ":",
+        hash(serialized_extras),
+        ":",
+        device);
+  }
+
+  std::shared_ptr<const Entry> Lookup(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    lru_.splice(lru_.end(), lru_, it->second);
+    return it->second->entry;
+  }
+
+  void Insert(const std::string& key, std::shared_ptr<const Entry> entry) {
+    const size_t bytes =
+        entry->init_net.ByteSize() + entry->pred_net.ByteSize();
+    const size_t capacity = FLAGS_caffe2_onnx_prepared_cache_bytes;
+    if (bytes > capacity) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key)) {
+      return;
+    }
+    while (bytes_ + bytes > capacity) {
+      bytes_ -= lru_.front().bytes;
+      index_.erase(lru_.front().key);
+      lru_.pop_front();
+    }
+    lru_.push_back(Item{key, bytes, std::move(entry)});
+    index_[key] = std::prev(lru_.end());
+    bytes_ += bytes;
+  }
+
+ private:
+  struct Item {
+    std::string key;
+    size_t bytes;
+    std::shared_ptr<const Entry> entry;
+  };
+
+  std::mutex mutex_;
+  std::list<Item> lru_;
+  std::unordered_map<std::string, std::list<Item>::iterator> index_;
+  size_t bytes_{0};
+};
+
 bool AlmostEqual(double a, double b) {
   constexpr static double kEps = 1e-15;
   return (fabs(a - b) < kEps);
@@ -938,10 +1045,7 @@ void Caffe2Backend::OnnxToCaffe2(
 
   // Convert initializer if necessary
   if (include_initializers) {
-    for (const auto& tp : onnx_model.graph().initializer()) {
-      auto* c2_op = init_net->add_op();
-      BuildTensorFillingOp(c2_op, tp);
-    }
+    ConvertInitializers(init_net, onnx_model.graph());
   }
 
   auto name_set = AllNamesInGraph(init_model.graph());
@@ -1002,11 +1106,69 @@ void Caffe2Backend::OnnxToCaffe2(
   converter(pred_model, pred_net);
 }
 
+void Caffe2Backend::ConvertInitializers(
+    caffe2::NetDef* init_net,
+    const GraphProto& graph) {
+  const int num_initializers = graph.initializer_size();
+  size_t bytes = 0;
+  for (const auto& tp : graph.initializer()) {
+    bytes += tp.ByteSize();
+  }
+  const int num_threads = std::min(
+      FLAGS_caffe2_onnx_conversion_threads, num_initializers);
+  if (bytes < kParallelConversionBytes || num_threads <= 1) {
+    for (const auto& tp : graph.initializer()) {
+      BuildTensorFillingOp(init_net->add_op(), tp);
+    }
+    return;
+  }
+
+  // The ops are added first, so that each thread fills its own
+  const int first = init_net->op_size();
+  for (int i = 0; i < num_initializers; ++i) {
+    init_net->add_op();
+  }
+  std::vector<std::exception_ptr> errors(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      try {
+        for (int i = t; i < num_initializers; i += num_threads) {
+          BuildTensorFillingOp(
+              init_net->mutable_op(first + i), graph.initializer(i));
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
 Caffe2BackendRep* Caffe2Backend::Prepare(
     const std::string& onnx_model_str,
     const std::string& device,
     const std::vector<Caffe2Ops>& extras) {
   Caffe2BackendRep* rep = new Caffe2BackendRep();
+  const bool use_cache = FLAGS_caffe2_onnx_prepared_cache_bytes > 0;
+  std::string cache_key;
+  if (use_cache) {
+    cache_key = PreparedModelCache::Key(onnx_model_str, device, extras);
+    if (auto prepared = PreparedModelCache::Get().Lookup(cache_key)) {
+      rep->init_net().CopyFrom(prepared->init_net);
+      rep->pred_net().CopyFrom(prepared->pred_net);
+      rep->uninitialized_inputs() = prepared->uninitialized_inputs;
+      return rep;
+    }
+  }
+
   ModelProto onnx_model;
   ParseProtoFromLargeString(onnx_model_str, &onnx_model);
 
@@ -1064,6 +1226,13 @@ Caffe2BackendRep* Caffe2Backend::Prepare(
     }
   }
 
+  if (use_cache) {
+    auto prepared = std::make_shared<PreparedModelCache::Entry>();
+    prepared->init_net.CopyFrom(rep->init_net());
+    prepared->pred_net.CopyFrom(rep->pred_net());
+    prepared->uninitialized_inputs = uninitialized_inputs;
+    PreparedModelCache::Get().Insert(cache_key, std::move(prepared));
+  }
   return rep;
 }
 
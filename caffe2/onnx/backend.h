@@ -133,6 +133,10 @@ class Caffe2Backend {
 
   std::unordered_set<std::string> AllNamesInGraph(const GraphProto& graph);
 
+  // Converts the initializers of graph to fill ops appended to init_net, in
+  // parallel for large models
+  void ConvertInitializers(caffe2::NetDef* init_net, const GraphProto& graph);
+
   void BuildTensorFillingOp(
       caffe2::OperatorDef* c2_op,
       const TensorProto& onnx_tensor,
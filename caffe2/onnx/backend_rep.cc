@@ -1,13 +1,169 @@
 #include "caffe2/core/common.h"
+#include "caffe2/core/operator.h"
 #include "caffe2/onnx/backend_rep.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <unordered_set>
 
 namespace caffe2 { namespace onnx {
 
+namespace {
+
+// The fill ops of plain old data the converter emits for initializers
+bool IsShareableFill(const caffe2::OperatorDef& op) {
+  static const std::unordered_set<std::string> kFills{
+      "GivenTensorFill",
+      "GivenTensorDoubleFill",
+      "GivenTensorIntFill",
+      "GivenTensorInt64Fill",
+      "GivenTensorBoolFill"};
+  return kFills.count(op.type()) && op.input_size() == 0 &&
+      op.output_size() == 1;
+}
+
+bool SameValue(const TensorCPU& a, const TensorCPU& b) {
+  return a.meta() == b.meta() && a.dims() == b.dims() &&
+      std::memcmp(a.raw_data(), b.raw_data(), a.nbytes()) == 0;
+}
+
+} // namespace
+
+std::unique_ptr<caffe2::Predictor> SharedInitializers::Load(
+    const caffe2::NetDef& init_net,
+    const caffe2::NetDef& pred_net,
+    std::unique_ptr<caffe2::Workspace>* ws,
+    std::vector<std::string>* shared) {
+  // A blob written by another op can't be shared
+  std::unordered_map<std::string, int> writes;
+  for (const auto* net : {&init_net, &pred_net}) {
+    for (const auto& op : net->op()) {
+      for (const auto& output : op.output()) {
+        ++writes[output];
+      }
+    }
+  }
+
+  caffe2::NetDef local_init;
+  local_init.set_name(init_net.name());
+  local_init.mutable_device_option()->CopyFrom(init_net.device_option());
+  std::unordered_map<std::string, std::string> forwarded;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  shared->clear();
+  try {
+    for (const auto& op : init_net.op()) {
+      const auto& device_option = op.has_device_option()
+          ? op.device_option()
+          : init_net.device_option();
+      if (!IsShareableFill(op) || device_option.device_type() != CPU ||
+          writes[op.output(0)] != 1) {
+        local_init.add_op()->CopyFrom(op);
+        continue;
+      }
+      const auto name = LoadFill(op, device_option);
+      shared->push_back(name);
+      forwarded[op.output(0)] = name;
+    }
+    // Predictor lists the blobs of its parent, so it is created under the
+    // lock
+    ws->reset(new caffe2::Workspace(&ws_, forwarded));
+    return caffe2::make_unique<caffe2::Predictor>(
+        local_init, pred_net, ws->get());
+  } catch (...) {
+    ws->reset();
+    ReleaseLocked(*shared);
+    shared->clear();
+    throw;
+  }
+}
+
+std::string SharedInitializers::LoadFill(
+    const caffe2::OperatorDef& op,
+    const caffe2::DeviceOption& device_option) {
+  caffe2::OperatorDef fill(op);
+  fill.clear_name();
+  fill.clear_output();
+  fill.mutable_device_option()->CopyFrom(device_option);
+  std::string serialized;
+  fill.SerializeToString(&serialized);
+  const size_t hash = std::hash<std::string>()(serialized);
+
+  const std::string pending = "__pending_initializer__";
+  fill.add_output(pending);
+  auto fill_op = CreateOperator(fill, &ws_);
+  CAFFE_ENFORCE(fill_op->Run(), "Failed to load initializer ", op.output(0));
+  const auto& value = ws_.GetBlob(pending)->Get<TensorCPU>();
+
+  auto& candidates = by_hash_[hash];
+  for (const auto& name : candidates) {
+    if (SameValue(ws_.GetBlob(name)->Get<TensorCPU>(), value)) {
+      ws_.RemoveBlob(pending);
+      ++entries_[name].uses;
+      return name;
+    }
+  }
+  const auto name = caffe2::MakeString("__shared_initializer_", next_id_++);
+  ws_.RenameBlob(pending, name);
+  candidates.push_back(name);
+  entries_[name] = Entry{hash, 1};
+  return name;
+}
+
+void SharedInitializers::Release(const std::vector<std::string>& shared) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReleaseLocked(shared);
+}
+
+void SharedInitializers::ReleaseLocked(
+    const std::vector<std::string>& shared) {
+  for (const auto& name : shared) {
+    auto it = entries_.find(name);
+    CAFFE_ENFORCE(it != entries_.end(), "Unknown shared initializer ", name);
+    if (--it->second.uses > 0) {
+      continue;
+    }
+    auto& candidates = by_hash_[it->second.hash];
+    candidates.erase(
+        std::find(candidates.begin(), candidates.end(), name));
+    if (candidates.empty()) {
+      by_hash_.erase(it->second.hash);
+    }
+    entries_.erase(it);
+    ws_.RemoveBlob(name);
+  }
+}
+
+size_t SharedInitializers::NumBlobs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+Caffe2BackendRep::~Caffe2BackendRep() {
+  predictor_.reset();
+  workspace_.reset();
+  if (shared_initializers_) {
+    shared_initializers_->Release(shared_blobs_);
+  }
+}
+
+void Caffe2BackendRep::ShareInitializers(
+    std::shared_ptr<SharedInitializers> shared) {
+  CAFFE_ENFORCE(!predictor_, "The model is already loaded");
+  shared_initializers_ = std::move(shared);
+}
+
 void Caffe2BackendRep::CheckInit() {
   if (!predictor_) {
-    predictor_ = caffe2::make_unique<caffe2::Predictor>(init_net_, pred_net_);
+    if (shared_initializers_) {
+      predictor_ = shared_initializers_->Load(
+          init_net_, pred_net_, &workspace_, &shared_blobs_);
+    } else {
+      predictor_ =
+          caffe2::make_unique<caffe2::Predictor>(init_net_, pred_net_);
+    }
     init_net_.Clear();
     pred_net_.Clear();
   }
@@ -4,12 +4,64 @@
 #include "caffe2/proto/caffe2.pb.h"
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace caffe2 { namespace onnx {
+
+// The parameters of the models of a process, shared by value: the output of
+// a constant fill op of an init_net (the converted ONNX initializers) is
+// loaded once per distinct type, shape and data, into a workspace of its
+// own, and removed when the last model using it is released. The models
+// must not write to their parameters.
+class SharedInitializers {
+ public:
+  // Runs init_net and returns a predictor of pred_net, which reads the
+  // shareable blobs of init_net from the shared workspace through *ws. The
+  // predictor and *ws must be destroyed before the shared blobs used,
+  // returned in *shared, are given back to Release.
+  std::unique_ptr<caffe2::Predictor> Load(
+      const caffe2::NetDef& init_net,
+      const caffe2::NetDef& pred_net,
+      std::unique_ptr<caffe2::Workspace>* ws,
+      std::vector<std::string>* shared);
+
+  void Release(const std::vector<std::string>& shared);
+
+  // The number of distinct parameters loaded
+  size_t NumBlobs() const;
+
+ private:
+  std::string LoadFill(
+      const caffe2::OperatorDef& op,
+      const caffe2::DeviceOption& device_option);
+  void ReleaseLocked(const std::vector<std::string>& shared);
+
+  struct Entry {
+    size_t hash;
+    int uses;
+  };
+
+  mutable std::mutex mutex_;
+  caffe2::Workspace ws_;
+  size_t next_id_{0};
+  std::unordered_map<std::string, Entry> entries_;
+  // Blobs by hash of their fill op, compared by value on a hit
+  std::unordered_map<size_t, std::vector<std::string>> by_hash_;
+};
+
 class Caffe2BackendRep {
  public:
+  Caffe2BackendRep() = default;
+  ~Caffe2BackendRep();
+
+  // Loads the initializers into `shared` rather than into a workspace of
+  // this model, with the ones of the same value as those of other models
+  // loaded only once. Must be called before the first run.
+  void ShareInitializers(std::shared_ptr<SharedInitializers> shared);
+
   void Run(
       const caffe2::Predictor::TensorVector& inputs,
       caffe2::Predictor::TensorVector* outputs);
@@ -43,6 +95,9 @@ class Caffe2BackendRep {
   caffe2::NetDef init_net_;
   caffe2::NetDef pred_net_;
   std::vector<std::string> uninitialized_inputs_;
+  std::shared_ptr<SharedInitializers> shared_initializers_;
+  std::vector<std::string> shared_blobs_;
+  std::unique_ptr<caffe2::Workspace> workspace_;
   std::unique_ptr<caffe2::Predictor> predictor_{nullptr};
 };
 }}
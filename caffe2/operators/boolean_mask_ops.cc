@@ -1,4 +1,5 @@
 #include "caffe2/operators/boolean_mask_ops.h"
+#include "caffe2/core/common_omp.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
 
@@ -45,6 +46,44 @@ class BooleanMaskLengthsOp final : public Operator<Context> {
 };
 } // namespace
 
+namespace {
+
+// The mask is split in chunks of this many items, which are counted and then
+// compacted independently, possibly on different threads.
+constexpr TIndex kBooleanMaskChunkSize = 1 << 14;
+
+// Stream compaction without branches on the mask: every item is written to
+// the next output slot, which only advances when the item is selected. Stops
+// once the count selected items are written, so dst needs no padding.
+template <typename T>
+void CompressItems(
+    const bool* mask,
+    const T* src,
+    const TIndex n,
+    const TIndex count,
+    T* dst) {
+  TIndex j = 0;
+  for (TIndex i = 0; i < n && j < count; ++i) {
+    dst[j] = src[i];
+    j += mask[i];
+  }
+}
+
+void CompressIndices(
+    const bool* mask,
+    const TIndex begin,
+    const TIndex n,
+    const TIndex count,
+    int64_t* dst) {
+  TIndex j = 0;
+  for (TIndex i = 0; i < n && j < count; ++i) {
+    dst[j] = begin + i;
+    j += mask[i];
+  }
+}
+
+} // namespace
+
 template <>
 bool BooleanMaskOp<CPUContext>::RunOnDevice() {
   auto& data = Input(0);
@@ -54,14 +93,31 @@ bool BooleanMaskOp<CPUContext>::RunOnDevice() {
   CAFFE_ENFORCE_EQ(mask.ndim(), 1);
   CAFFE_ENFORCE(data.dims()[0] == mask.dims()[0]);
 
+  // Each chunk's output starts at the number of items selected before it.
   const auto* maskPtr = mask.template data<bool>();
-  int numOutputs = 0;
-  int outerSize = mask.size();
-  for (int i = 0; i < outerSize; ++i) {
-    if (maskPtr[i]) {
-      ++numOutputs;
+  const TIndex outerSize = mask.size();
+  const TIndex numChunks =
+      (outerSize + kBooleanMaskChunkSize - 1) / kBooleanMaskChunkSize;
+  const auto innerSize = data.size_from_dim(1);
+  const auto innerSizeBytes = innerSize * data.meta().itemsize();
+  const bool parallel = numChunks > 1 &&
+      outerSize * std::max<TIndex>(innerSizeBytes, 1) >=
+          4 * kBooleanMaskChunkSize;
+  std::vector<TIndex> chunkStarts(numChunks + 1, 0);
+#pragma omp parallel for if (parallel)
+  for (TIndex c = 0; c < numChunks; ++c) {
+    const TIndex begin = c * kBooleanMaskChunkSize;
+    const TIndex end = std::min(begin + kBooleanMaskChunkSize, outerSize);
+    TIndex count = 0;
+    for (TIndex i = begin; i < end; ++i) {
+      count += maskPtr[i];
     }
+    chunkStarts[c + 1] = count;
   }
+  std::partial_sum(
+      chunkStarts.begin(), chunkStarts.end(), chunkStarts.begin());
+  const TIndex numOutputs = chunkStarts[numChunks];
+
   std::vector<TIndex> outShape;
   outShape.push_back(numOutputs);
   outShape.insert(outShape.end(), data.dims().begin() + 1, data.dims().end());
@@ -78,33 +134,85 @@ bool BooleanMaskOp<CPUContext>::RunOnDevice() {
   if (numOutputs == 0) {
     return true;
   }
-  const auto innerSize = data.size_from_dim(1);
-  const auto innerSizeBytes = innerSize * data.meta().itemsize();
 
-  TIndex lastStart = -1;
   const auto* inPtr = (char*)data.raw_data();
-  TIndex outStart = 0;
-
-  for (TIndex i = 0;; ++i) {
-    // mask was true and either a) became false, or b) sequence finished
-    if (lastStart != -1 && ((i >= outerSize) || !maskPtr[i])) {
-      const auto* src = inPtr + lastStart * innerSizeBytes;
-      auto* dst = outPtr + outStart * innerSizeBytes;
-      int numItems = i - lastStart;
-      context_.template CopyItems<CPUContext, CPUContext>(
-          data.meta(), numItems * innerSize, src, dst);
-      outStart += numItems;
-      lastStart = -1;
+  const bool compressItems = data.meta().copy() == nullptr && innerSize == 1 &&
+      (innerSizeBytes == 1 || innerSizeBytes == 2 || innerSizeBytes == 4 ||
+       innerSizeBytes == 8);
+
+#pragma omp parallel for if (parallel)
+  for (TIndex c = 0; c < numChunks; ++c) {
+    const TIndex begin = c * kBooleanMaskChunkSize;
+    const TIndex end = std::min(begin + kBooleanMaskChunkSize, outerSize);
+    const TIndex outBegin = chunkStarts[c];
+    const TIndex count = chunkStarts[c + 1] - outBegin;
+    if (count == 0) {
+      continue;
     }
-    if (i >= outerSize) {
-      break;
+    if (out_vec) {
+      CompressIndices(
+          maskPtr + begin, begin, end - begin, count, out_vec + outBegin);
     }
-    // mask was false and became true
-    if (lastStart == -1 && maskPtr[i]) {
-      lastStart = i;
+    if (compressItems) {
+      auto* dst = outPtr + outBegin * innerSizeBytes;
+      const auto* src = inPtr + begin * innerSizeBytes;
+      const auto* chunkMask = maskPtr + begin;
+      switch (innerSizeBytes) {
+        case 1:
+          CompressItems(
+              chunkMask,
+              (const uint8_t*)src,
+              end - begin,
+              count,
+              (uint8_t*)dst);
+          break;
+        case 2:
+          CompressItems(
+              chunkMask,
+              (const uint16_t*)src,
+              end - begin,
+              count,
+              (uint16_t*)dst);
+          break;
+        case 4:
+          CompressItems(
+              chunkMask,
+              (const uint32_t*)src,
+              end - begin,
+              count,
+              (uint32_t*)dst);
+          break;
+        default:
+          CompressItems(
+              chunkMask,
+              (const uint64_t*)src,
+              end - begin,
+              count,
+              (uint64_t*)dst);
+      }
+      continue;
     }
-    if (maskPtr[i] && OutputSize() == 2) {
-      *(out_vec++) = i;
+    // Larger rows are copied a run of selected rows at a time.
+    TIndex lastStart = -1;
+    TIndex outStart = outBegin;
+    for (TIndex i = begin;; ++i) {
+      // mask was true and either a) became false, or b) chunk finished
+      if (lastStart != -1 && ((i >= end) || !maskPtr[i])) {
+        const auto* src = inPtr + lastStart * innerSizeBytes;
+        auto* dst = outPtr + outStart * innerSizeBytes;
+        int numItems = i - lastStart;
+        context_.template CopyItems<CPUContext, CPUContext>(
+            data.meta(), numItems * innerSize, src, dst);
+        outStart += numItems;
+        lastStart = -1;
+      }
+      if (i >= end) {
+        break;
+      }
+      // mask was false and became true
+      if (lastStart == -1 && maskPtr[i]) {
+        lastStart = i;
+      }
     }
   }
   return true;
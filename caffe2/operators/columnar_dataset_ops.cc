@@ -0,0 +1,531 @@
+#include "caffe2/operators/columnar_dataset_ops.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<dataset_ops::ColumnarCursor>);
+
+namespace dataset_ops {
+namespace {
+
+const char kColumnarMagic[8] = {'C', '2', 'C', 'O', 'L', 'D', 'S', '\0'};
+const uint32_t kColumnarVersion = 1;
+// alignment of each field array and of the offset index in the file
+const int64_t kColumnarAlignment = 64;
+
+struct ColumnarHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t numFields;
+  int64_t numRecords;
+  int64_t numOffsetFields;
+  int64_t indexPos;
+};
+
+// Followed by ndim int64 dims and nameLen bytes of name.
+struct ColumnarFieldHeader {
+  int32_t dataType;
+  int32_t ndim;
+  int64_t dataPos;
+  int64_t nameLen;
+};
+
+int64_t alignUp(int64_t pos) {
+  return (pos + kColumnarAlignment - 1) / kColumnarAlignment *
+      kColumnarAlignment;
+}
+
+} // namespace
+
+void ColumnarDataset::Write(
+    const std::string& path,
+    const std::vector<std::string>& fieldNames,
+    const std::vector<const TensorCPU*>& fields) {
+  CAFFE_ENFORCE_EQ(fieldNames.size(), fields.size());
+  TreeIterator it(fieldNames);
+  for (int i = 0; i < fields.size(); ++i) {
+    const auto& meta = fields[i]->meta();
+    const auto dataType = TypeMetaToDataType(meta);
+    CAFFE_ENFORCE(
+        dataType != TensorProto_DataType_UNDEFINED &&
+            dataType != TensorProto_DataType_STRING && !meta.copy(),
+        "Field ",
+        fieldNames[i],
+        " has type ",
+        meta.name(),
+        " which can't be stored in a columnar dataset.");
+    CAFFE_ENFORCE_GE(fields[i]->ndim(), 1, "Field ", fieldNames[i]);
+  }
+
+  // compute the offset index, as in ComputeOffset
+  const TLength lenZero = 0;
+  std::vector<const TLength*> lengths(it.numLengthFields());
+  for (int i = 0; i < lengths.size(); ++i) {
+    const auto* in = fields[it.lengthField(i).id];
+    lengths[i] = in->size() > 0 ? in->data<TLength>() : &lenZero;
+  }
+  std::vector<TOffset> limits(
+      it.numOffsetFields(), std::numeric_limits<TOffset>::max());
+  for (int i = 0; i < fields.size(); ++i) {
+    auto& limit = limits[it.fields()[i].lengthFieldId + 1];
+    limit = std::min(limit, (TOffset)fields[i]->dim(0));
+  }
+  const TOffset numRecords = limits[0];
+  std::vector<TOffset> index;
+  index.reserve((numRecords + 1) * it.numOffsetFields());
+  std::vector<TOffset> offsets(it.numOffsetFields(), 0);
+  std::vector<TOffset> sizes;
+  for (TOffset k = 0; k <= numRecords; ++k) {
+    index.insert(index.end(), offsets.begin(), offsets.end());
+    it.advance(lengths, offsets, sizes, limits, 1);
+  }
+  for (int i = 0; i < fields.size(); ++i) {
+    CAFFE_ENFORCE_EQ(
+        fields[i]->dim(0),
+        offsets[it.fields()[i].lengthFieldId + 1],
+        "Field ",
+        fieldNames[i],
+        " is not consistent with its lengths field.");
+  }
+
+  // lay out the file
+  int64_t pos = sizeof(ColumnarHeader);
+  for (int i = 0; i < fields.size(); ++i) {
+    pos += sizeof(ColumnarFieldHeader) +
+        fields[i]->ndim() * sizeof(int64_t) + fieldNames[i].size();
+  }
+  std::vector<int64_t> dataPos(fields.size());
+  for (int i = 0; i < fields.size(); ++i) {
+    dataPos[i] = alignUp(pos);
+    pos = dataPos[i] + fields[i]->nbytes();
+  }
+  ColumnarHeader header;
+  std::memcpy(header.magic, kColumnarMagic, sizeof(kColumnarMagic));
+  header.version = kColumnarVersion;
+  header.numFields = fields.size();
+  header.numRecords = numRecords;
+  header.numOffsetFields = it.numOffsetFields();
+  header.indexPos = alignUp(pos);
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  CAFFE_ENFORCE(out.is_open(), "Cannot open ", path, " for writing.");
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (int i = 0; i < fields.size(); ++i) {
+    ColumnarFieldHeader fieldHeader;
+    fieldHeader.dataType = TypeMetaToDataType(fields[i]->meta());
+    fieldHeader.ndim = fields[i]->ndim();
+    fieldHeader.dataPos = dataPos[i];
+    fieldHeader.nameLen = fieldNames[i].size();
+    out.write(
+        reinterpret_cast<const char*>(&fieldHeader), sizeof(fieldHeader));
+    for (const auto d : fields[i]->dims()) {
+      const int64_t dim = d;
+      out.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+    }
+    out.write(fieldNames[i].data(), fieldNames[i].size());
+  }
+  const char padding[kColumnarAlignment] = {0};
+  for (int i = 0; i < fields.size(); ++i) {
+    out.write(padding, dataPos[i] - out.tellp());
+    out.write(
+        static_cast<const char*>(fields[i]->raw_data()), fields[i]->nbytes());
+  }
+  out.write(padding, header.indexPos - out.tellp());
+  out.write(
+      reinterpret_cast<const char*>(index.data()),
+      index.size() * sizeof(TOffset));
+  CAFFE_ENFORCE(out.good(), "Error writing columnar dataset to ", path);
+}
+
+ColumnarDataset::ColumnarDataset(const std::string& path) {
+#ifdef _WIN32
+  // No mmap: read the whole file instead.
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  CAFFE_ENFORCE(in.is_open(), "Cannot open ", path);
+  size_ = in.tellg();
+  CAFFE_ENFORCE_GE(size_, sizeof(ColumnarHeader), "File too short: ", path);
+  base_ = new char[size_];
+  in.seekg(0);
+  if (!in.read(base_, size_)) {
+    delete[] base_;
+    CAFFE_THROW("Error reading ", path);
+  }
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  CAFFE_ENFORCE(fd >= 0, "Cannot open ", path, ": ", strerror(errno));
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    CAFFE_THROW("Cannot stat ", path, ": ", strerror(errno));
+  }
+  size_ = st.st_size;
+  if (size_ < sizeof(ColumnarHeader)) {
+    close(fd);
+    CAFFE_THROW("File too short: ", path);
+  }
+  // Private writable mapping, so that consumers writing into a batch get
+  // their own copy of the page instead of a fault.
+  void* addr =
+      mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  CAFFE_ENFORCE(addr != MAP_FAILED, "mmap ", path, ": ", strerror(errno));
+  base_ = static_cast<char*>(addr);
+#endif
+  try {
+    parse(path);
+  } catch (...) {
+    release();
+    throw;
+  }
+}
+
+ColumnarDataset::~ColumnarDataset() {
+  release();
+}
+
+void ColumnarDataset::release() {
+#ifdef _WIN32
+  delete[] base_;
+#else
+  munmap(base_, size_);
+#endif
+}
+
+void ColumnarDataset::parse(const std::string& path) {
+  size_t pos = 0;
+  auto take = [&](size_t nbytes) {
+    CAFFE_ENFORCE_LE(pos + nbytes, size_, "Corrupted columnar dataset ", path);
+    const char* ptr = base_ + pos;
+    pos += nbytes;
+    return ptr;
+  };
+  ColumnarHeader header;
+  std::memcpy(&header, take(sizeof(header)), sizeof(header));
+  CAFFE_ENFORCE(
+      std::memcmp(header.magic, kColumnarMagic, sizeof(kColumnarMagic)) == 0,
+      path,
+      " is not a columnar dataset.");
+  CAFFE_ENFORCE_EQ(header.version, kColumnarVersion);
+  numRecords_ = header.numRecords;
+  numOffsetFields_ = header.numOffsetFields;
+
+  std::vector<std::string> names(header.numFields);
+  fields_.resize(header.numFields);
+  std::vector<int64_t> dataPos(header.numFields);
+  for (int i = 0; i < fields_.size(); ++i) {
+    ColumnarFieldHeader fieldHeader;
+    std::memcpy(&fieldHeader, take(sizeof(fieldHeader)), sizeof(fieldHeader));
+    auto& field = fields_[i];
+    field.meta = &DataTypeToTypeMeta(
+        static_cast<TensorProto::DataType>(fieldHeader.dataType));
+    field.dims.resize(fieldHeader.ndim);
+    std::memcpy(
+        field.dims.data(),
+        take(fieldHeader.ndim * sizeof(int64_t)),
+        fieldHeader.ndim * sizeof(int64_t));
+    field.name.assign(take(fieldHeader.nameLen), fieldHeader.nameLen);
+    names[i] = field.name;
+    field.itemBytes = field.meta->itemsize();
+    for (int d = 1; d < field.dims.size(); ++d) {
+      field.itemBytes *= field.dims[d];
+    }
+    dataPos[i] = fieldHeader.dataPos;
+  }
+  TreeIterator it(names);
+  CAFFE_ENFORCE_EQ(it.numOffsetFields(), numOffsetFields_);
+  for (int i = 0; i < fields_.size(); ++i) {
+    auto& field = fields_[i];
+    field.offsetFieldId = it.fields()[i].lengthFieldId + 1;
+    pos = dataPos[i];
+    field.data = take(field.dims.at(0) * field.itemBytes);
+  }
+  pos = header.indexPos;
+  index_ = reinterpret_cast<const TOffset*>(
+      take((numRecords_ + 1) * numOffsetFields_ * sizeof(TOffset)));
+}
+
+namespace {
+
+class WriteColumnarDatasetOp : public Operator<CPUContext> {
+ public:
+  WriteColumnarDatasetOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        path_(OperatorBase::GetSingleArgument<std::string>("path", "")),
+        fields_(OperatorBase::GetRepeatedArgument<std::string>("fields")) {
+    CAFFE_ENFORCE(!path_.empty(), "Must specify a path.");
+  }
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(InputSize(), fields_.size());
+    std::vector<const TensorCPU*> inputs;
+    for (int i = 0; i < InputSize(); ++i) {
+      inputs.push_back(&Input(i));
+    }
+    ColumnarDataset::Write(path_, fields_, inputs);
+    return true;
+  }
+
+ private:
+  std::string path_;
+  std::vector<std::string> fields_;
+};
+
+class OpenColumnarDatasetOp : public Operator<CPUContext> {
+ public:
+  OpenColumnarDatasetOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        path_(OperatorBase::GetSingleArgument<std::string>("path", "")) {
+    CAFFE_ENFORCE(!path_.empty(), "Must specify a path.");
+  }
+
+  bool RunOnDevice() override {
+    auto dataset = std::make_shared<const ColumnarDataset>(path_);
+    if (OutputSize() > 1) {
+      auto* size = Output(1);
+      size->Resize(std::vector<TIndex>{});
+      *size->mutable_data<int64_t>() = dataset->numRecords();
+    }
+    *OperatorBase::Output<std::unique_ptr<ColumnarCursor>>(0) =
+        caffe2::make_unique<ColumnarCursor>(std::move(dataset));
+    return true;
+  }
+
+ private:
+  std::string path_;
+};
+
+class ResetColumnarCursorOp : public Operator<CPUContext> {
+ public:
+  ResetColumnarCursorOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    auto& cursor = OperatorBase::Input<std::unique_ptr<ColumnarCursor>>(0);
+    std::lock_guard<std::mutex> lock(cursor->mutex_);
+    cursor->offset = 0;
+    return true;
+  }
+};
+
+class ReadNextColumnarBatchOp : public Operator<CPUContext> {
+ public:
+  ReadNextColumnarBatchOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        batchSize_(OperatorBase::GetSingleArgument<int>("batch_size", 1)),
+        enforceBatchSize_(OperatorBase::GetSingleArgument<bool>(
+            "enforce_batch_size",
+            false)) {}
+
+  bool RunOnDevice() override {
+    auto& cursor = OperatorBase::Input<std::unique_ptr<ColumnarCursor>>(0);
+    const auto& dataset = cursor->dataset;
+    CAFFE_ENFORCE_EQ(OutputSize(), dataset->fields().size());
+    TOffset begin;
+    TOffset end;
+    {
+      std::lock_guard<std::mutex> lock(cursor->mutex_);
+      begin = std::min(cursor->offset, dataset->numRecords());
+      end = std::min(begin + batchSize_, dataset->numRecords());
+      cursor->offset = end;
+    }
+    if (enforceBatchSize_ && end - begin < batchSize_) {
+      // not enough rows left for a full batch: return empty for all columns
+      end = begin;
+    }
+    // a range of records is contiguous in every field, so outputs alias
+    // the mapped file and keep it alive through their deleter
+    const TOffset* first = dataset->offsetsOf(begin);
+    const TOffset* last = dataset->offsetsOf(end);
+    for (int i = 0; i < dataset->fields().size(); ++i) {
+      const auto& field = dataset->fields()[i];
+      const auto offset = first[field.offsetFieldId];
+      auto outDim = field.dims;
+      outDim[0] = last[field.offsetFieldId] - offset;
+      auto* out = Output(i);
+      out->Resize(outDim);
+      out->ShareExternalPointer(
+          const_cast<char*>(field.data + offset * field.itemBytes),
+          *field.meta,
+          0,
+          [dataset](void*) {});
+    }
+    return true;
+  }
+
+ private:
+  int batchSize_;
+  bool enforceBatchSize_;
+};
+
+class ReadRandomColumnarBatchOp : public Operator<CPUContext> {
+ public:
+  ReadRandomColumnarBatchOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        batchSize_(OperatorBase::GetSingleArgument<int>("batch_size", 1)),
+        enforceBatchSize_(
+            OperatorBase::GetSingleArgument<bool>("enforce_batch_size", false)),
+        loopOver_(OperatorBase::GetSingleArgument<bool>("loop_over", false)) {}
+
+  bool RunOnDevice() override {
+    auto& cursor = OperatorBase::Input<std::unique_ptr<ColumnarCursor>>(0);
+    const auto& dataset = cursor->dataset;
+    auto& idxblob = Input(1);
+    CAFFE_ENFORCE_EQ(OutputSize(), dataset->fields().size());
+    const auto* idxvec = idxblob.template data<int64_t>();
+    TOffset idx;
+    {
+      std::lock_guard<std::mutex> lock(cursor->mutex_);
+      idx = cursor->offset;
+      // if we want to enforce batch size but we dont have a complete
+      // batch, skip the last rows.
+      if (enforceBatchSize_ && idx + batchSize_ > idxblob.size()) {
+        idx = idxblob.size();
+      }
+      if (loopOver_ && idx >= idxblob.size()) {
+        idx = 0;
+      }
+      cursor->offset = idx + batchSize_;
+    }
+    const TOffset idxEnd = std::min<TOffset>(idx + batchSize_, idxblob.size());
+    for (auto j = idx; j < idxEnd; ++j) {
+      CAFFE_ENFORCE(
+          idxvec[j] >= 0 && idxvec[j] < dataset->numRecords(),
+          "Record index out of bound: ",
+          idxvec[j]);
+    }
+
+    for (int i = 0; i < dataset->fields().size(); ++i) {
+      const auto& field = dataset->fields()[i];
+      const int ofs = field.offsetFieldId;
+      auto outDim = field.dims;
+      outDim[0] = 0;
+      for (auto j = idx; j < idxEnd; ++j) {
+        outDim[0] += dataset->offsetsOf(idxvec[j] + 1)[ofs] -
+            dataset->offsetsOf(idxvec[j])[ofs];
+      }
+      auto* out = Output(i);
+      out->Resize(outDim);
+      auto* dst = static_cast<char*>(out->raw_mutable_data(*field.meta));
+      for (auto j = idx; j < idxEnd; ++j) {
+        const auto offset = dataset->offsetsOf(idxvec[j])[ofs];
+        const auto size = dataset->offsetsOf(idxvec[j] + 1)[ofs] - offset;
+        const auto nbytes = size * field.itemBytes;
+        std::memcpy(dst, field.data + offset * field.itemBytes, nbytes);
+        dst += nbytes;
+      }
+    }
+    return true;
+  }
+
+ private:
+  int batchSize_;
+  bool enforceBatchSize_;
+  bool loopOver_;
+};
+
+REGISTER_CPU_OPERATOR(WriteColumnarDataset, WriteColumnarDatasetOp);
+REGISTER_CPU_OPERATOR(OpenColumnarDataset, OpenColumnarDatasetOp);
+REGISTER_CPU_OPERATOR(ResetColumnarCursor, ResetColumnarCursorOp);
+REGISTER_CPU_OPERATOR(ReadNextColumnarBatch, ReadNextColumnarBatchOp);
+REGISTER_CPU_OPERATOR(ReadRandomColumnarBatch, ReadRandomColumnarBatchOp);
+
+OPERATOR_SCHEMA(WriteColumnarDataset)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Writes the dataset given by the input field tensors to a file in columnar
+format: one contiguous array per field followed by the offset index of the
+records (as computed by ComputeOffset). The file can then be mapped with
+OpenColumnarDataset and read without loading it into memory. Only
+fixed-size types are supported.
+)DOC")
+    .Arg("path", "Path of the file to write.")
+    .Arg(
+        "fields",
+        "A list of strings each one representing a field of the dataset, "
+        "following the naming convention of CreateTreeCursor.")
+    .Input(0, "field_0", "First field of the dataset.");
+
+OPERATOR_SCHEMA(OpenColumnarDataset)
+    .NumInputs(0)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Maps a dataset written by WriteColumnarDataset and creates a cursor over it.
+Data pages are only read from disk when a batch touches them, so datasets
+larger than memory can be read.
+)DOC")
+    .Arg("path", "Path of the columnar dataset file.")
+    .Output(0, "cursor", "A blob containing a pointer to the cursor.")
+    .Output(1, "size", "(optional) int64 scalar, number of records.");
+
+OPERATOR_SCHEMA(ResetColumnarCursor)
+    .NumInputs(1)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Resets the offset of the given columnar cursor to the first record.
+)DOC")
+    .Input(0, "cursor", "A blob containing a pointer to the cursor.");
+
+OPERATOR_SCHEMA(ReadNextColumnarBatch)
+    .NumInputs(1)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Reads the next batch of records from a columnar dataset, one output per
+field. Outputs share the mapped memory of the file instead of copying it,
+and should not be written to. Returns empty tensors once the end of the
+dataset is reached.
+)DOC")
+    .Arg("batch_size", "Number of top-level entries to read.")
+    .Arg(
+        "enforce_batch_size",
+        "(bool) If true, return empty tensors once less than batch_size "
+        "records are left.")
+    .Input(0, "cursor", "A blob containing a pointer to the cursor.")
+    .Output(0, "field_0", "Tensor containing the next batch for field 0.");
+
+OPERATOR_SCHEMA(ReadRandomColumnarBatch)
+    .NumInputs(2)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Reads the batch of records whose ids are the next batch_size entries of
+`indices`, e.g. a shuffled permutation of the records. Records are located
+through the offset index of the file and gathered into the outputs, one per
+field.
+)DOC")
+    .Arg("batch_size", "Number of top-level entries to read.")
+    .Arg(
+        "enforce_batch_size",
+        "(bool) If true, return empty tensors once less than batch_size "
+        "indices are left.")
+    .Arg("loop_over", "(bool) Repeat the indices when reaching the end.")
+    .Input(0, "cursor", "A blob containing a pointer to the cursor.")
+    .Input(1, "indices", "int64 tensor of record ids to read, in order.")
+    .Output(0, "field_0", "Tensor containing the next batch for field 0.");
+
+SHOULD_NOT_DO_GRADIENT(WriteColumnarDataset);
+SHOULD_NOT_DO_GRADIENT(OpenColumnarDataset);
+SHOULD_NOT_DO_GRADIENT(ResetColumnarCursor);
+SHOULD_NOT_DO_GRADIENT(ReadNextColumnarBatch);
+SHOULD_NOT_DO_GRADIENT(ReadRandomColumnarBatch);
+
+} // namespace
+} // namespace dataset_ops
+} // namespace caffe2
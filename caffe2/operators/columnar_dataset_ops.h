@@ -0,0 +1,99 @@
+#ifndef CAFFE2_OPERATORS_COLUMNAR_DATASET_OPS_H_
+#define CAFFE2_OPERATORS_COLUMNAR_DATASET_OPS_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "caffe2/core/tensor.h"
+#include "caffe2/operators/dataset_ops.h"
+
+namespace caffe2 {
+namespace dataset_ops {
+
+/**
+ * On-disk columnar layout of a dataset, readable through mmap.
+ *
+ * The file holds the same field tensors as an in-memory dataset (values and
+ * "lengths" fields alike), each stored as one contiguous array aligned to
+ * kColumnarAlignment bytes, followed by the offset index: a
+ * (numRecords + 1) x numOffsetFields matrix of TOffset as computed by
+ * ComputeOffset. Row i of the index gives the start of record i in each
+ * offset domain, so any record range can be located without scanning the
+ * lengths.
+ *
+ * Only fixed-size types are supported; strings can't be mapped.
+ */
+class ColumnarDataset {
+ public:
+  struct Field {
+    std::string name;
+    const TypeMeta* meta;
+    // dims of the whole field; dims[0] is the number of items
+    std::vector<TIndex> dims;
+    // bytes per item along the first dimension
+    size_t itemBytes;
+    // index into the rows of the offset index
+    int offsetFieldId;
+    const char* data;
+  };
+
+  // Maps the file at `path` read-only; data pages are loaded lazily.
+  explicit ColumnarDataset(const std::string& path);
+  ~ColumnarDataset();
+
+  ColumnarDataset(const ColumnarDataset&) = delete;
+  ColumnarDataset& operator=(const ColumnarDataset&) = delete;
+
+  // Writes `fields` (named by `fieldNames`) to `path` in columnar format.
+  static void Write(
+      const std::string& path,
+      const std::vector<std::string>& fieldNames,
+      const std::vector<const TensorCPU*>& fields);
+
+  TOffset numRecords() const {
+    return numRecords_;
+  }
+
+  int numOffsetFields() const {
+    return numOffsetFields_;
+  }
+
+  const std::vector<Field>& fields() const {
+    return fields_;
+  }
+
+  // Offsets of record `record` (0 <= record <= numRecords()) in each domain.
+  const TOffset* offsetsOf(TOffset record) const {
+    return index_ + record * numOffsetFields_;
+  }
+
+ private:
+  void parse(const std::string& path);
+  void release();
+
+  char* base_ = nullptr;
+  size_t size_ = 0;
+  TOffset numRecords_ = 0;
+  int numOffsetFields_ = 0;
+  const TOffset* index_ = nullptr;
+  std::vector<Field> fields_;
+};
+
+/**
+ * Cursor over a ColumnarDataset. Tensors read through it keep the dataset
+ * mapped until they are released.
+ */
+class ColumnarCursor {
+ public:
+  explicit ColumnarCursor(std::shared_ptr<const ColumnarDataset> dataset)
+      : dataset(std::move(dataset)) {}
+  std::shared_ptr<const ColumnarDataset> dataset;
+  TOffset offset = 0;
+  std::mutex mutex_;
+};
+
+} // namespace dataset_ops
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_COLUMNAR_DATASET_OPS_H_
@@ -12,7 +12,12 @@ Creates a common world for communication operators.
     .Input(0, "kv_handler", "Key/value handler for rendezvous (optional).")
     .Output(0, "comm_world", "A common world for collective operations.")
     .Arg("size", "(int) size of the common world.")
-    .Arg("rank", "(int) rank of this node in the common world.");
+    .Arg("rank", "(int) rank of this node in the common world.")
+    .Arg(
+        "rendezvous_fanout",
+        "(int, optional) exchange the rendezvous keys through a tree with "
+        "this fanout instead of one store lookup per peer (default: 0, "
+        "disabled).");
 
 OPERATOR_SCHEMA(CloneCommonWorld)
     .NumInputs(1)
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "caffe2/operators/conv_op.h"
 #include "caffe2/operators/conv_op_impl.h"
 #include "caffe2/operators/conv_pool_op_base.h"
@@ -52,6 +54,139 @@ and a bias blob and computes the output. {conv_doc})DOC";
         "");
   };
 }
+
+// For every kernel tap, the loops only run over the output columns reading
+// inside the input, so that the inner loops have no bound checks. In NCHW,
+// an output plane (over the columns of a row) is accumulated per task; in
+// NHWC, an output row, with the filters transposed to taps x M so that the
+// inner loops are over contiguous channels.
+template <>
+bool ConvOp<float, CPUContext>::RunDepthwiseConv2D() {
+  const auto& X = Input(INPUT);
+  const auto& filter = Input(FILTER);
+  const bool nchw = order_ == StorageOrder::NCHW;
+  if (kernel_.size() != 2 || X.ndim() != 4 || filter.ndim() != 4) {
+    return false;
+  }
+  const int N = X.dim32(0);
+  const int C = X.dim32(nchw ? 1 : 3);
+  const int M = filter.dim32(0);
+  if (group_ != C || C == 1 || M % C != 0 ||
+      filter.dim32(nchw ? 1 : 3) != 1) {
+    return false;
+  }
+  CAFFE_ENFORCE_EQ(filter.dim32(nchw ? 2 : 1), kernel_h());
+  CAFFE_ENFORCE_EQ(filter.dim32(nchw ? 3 : 2), kernel_w());
+  const float* bias = nullptr;
+  if (InputSize() == 3) {
+    const auto& b = Input(BIAS);
+    CAFFE_ENFORCE_EQ(b.ndim(), 1);
+    CAFFE_ENFORCE_EQ(b.dim32(0), M);
+    bias = b.data<float>();
+  }
+
+  auto* Y = Output(0);
+  ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+  const int H = X.dim32(nchw ? 2 : 1), W = X.dim32(nchw ? 3 : 2);
+  const int out_h = Y->dim32(nchw ? 2 : 1), out_w = Y->dim32(nchw ? 3 : 2);
+  const int multiplier = M / C;
+  const int taps = kernel_h() * kernel_w();
+  const int stride = stride_w();
+  const float* X_data = X.data<float>();
+  float* Y_data = Y->mutable_data<float>();
+
+  // The output columns [*begin, *end) reading input column
+  // ow * stride + offset inside [0, W).
+  auto valid_columns = [&](int offset, int* begin, int* end) {
+    *begin = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+    *end = offset >= W ? 0 : std::min(out_w, (W - 1 - offset) / stride + 1);
+  };
+  ThreadPool* pool = ws_->GetThreadPool();
+
+  if (nchw) {
+    const float* filter_data = filter.data<float>();
+    pool->run(
+        [&](int /*threadId*/, size_t plane) {
+          const int n = plane / M, m = plane % M;
+          const float* image = X_data + (n * C + m / multiplier) * H * W;
+          const float* w = filter_data + m * taps;
+          float* output = Y_data + plane * out_h * out_w;
+          std::fill(output, output + out_h * out_w, bias ? bias[m] : 0);
+          for (int oh = 0; oh < out_h; ++oh) {
+            float* output_row = output + oh * out_w;
+            for (int kh = 0; kh < kernel_h(); ++kh) {
+              const int ih = oh * stride_h() - pad_t() + kh * dilation_h();
+              if (ih < 0 || ih >= H) {
+                continue;
+              }
+              const float* input_row = image + ih * W;
+              for (int kw = 0; kw < kernel_w(); ++kw) {
+                const int offset = kw * dilation_w() - pad_l();
+                int begin, end;
+                valid_columns(offset, &begin, &end);
+                const float weight = w[kh * kernel_w() + kw];
+                for (int ow = begin; ow < end; ++ow) {
+                  output_row[ow] += weight * input_row[ow * stride + offset];
+                }
+              }
+            }
+          }
+        },
+        N * M);
+    return true;
+  }
+
+  col_buffer_.Resize(taps, M);
+  const float* filter_data = filter.data<float>();
+  float* w = col_buffer_.mutable_data<float>();
+  for (int m = 0; m < M; ++m) {
+    for (int tap = 0; tap < taps; ++tap) {
+      w[tap * M + m] = filter_data[m * taps + tap];
+    }
+  }
+  pool->run(
+      [&](int /*threadId*/, size_t row) {
+        const int n = row / out_h, oh = row % out_h;
+        float* output_row = Y_data + row * out_w * M;
+        for (int ow = 0; ow < out_w; ++ow) {
+          float* output = output_row + ow * M;
+          if (bias) {
+            std::copy(bias, bias + M, output);
+          } else {
+            std::fill(output, output + M, 0);
+          }
+        }
+        for (int kh = 0; kh < kernel_h(); ++kh) {
+          const int ih = oh * stride_h() - pad_t() + kh * dilation_h();
+          if (ih < 0 || ih >= H) {
+            continue;
+          }
+          const float* input_row = X_data + (n * H + ih) * W * C;
+          for (int kw = 0; kw < kernel_w(); ++kw) {
+            const int offset = kw * dilation_w() - pad_l();
+            int begin, end;
+            valid_columns(offset, &begin, &end);
+            const float* weights = w + (kh * kernel_w() + kw) * M;
+            for (int ow = begin; ow < end; ++ow) {
+              const float* input = input_row + (ow * stride + offset) * C;
+              float* output = output_row + ow * M;
+              if (multiplier == 1) {
+                for (int c = 0; c < C; ++c) {
+                  output[c] += weights[c] * input[c];
+                }
+              } else {
+                for (int m = 0; m < M; ++m) {
+                  output[m] += weights[m] * input[m / multiplier];
+                }
+              }
+            }
+          }
+        }
+      },
+      N * out_h);
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(Conv, ConvOp<float, CPUContext>);
 
 OPERATOR_SCHEMA(Conv)
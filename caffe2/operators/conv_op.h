@@ -16,13 +16,7 @@ class ConvOp final : public ConvPoolOpBase<Context> {
   USE_CONV_POOL_BASE_FUNCTIONS(Context);
   ConvOp(const OperatorDef& operator_def, Workspace* ws)
       : ConvPoolOpBase<Context>(operator_def, ws) {
-    // Since this is the default convolution implementation, we will
-    // use CAFFE_ENFORCE instead of OPERATOR_NEEDS_FEATURE.
-    CAFFE_ENFORCE(
-        group_ == 1 || order_ == StorageOrder::NCHW,
-        "Group convolution only supports NCHW order right now.");
-
-    // Create shared buffer mutex in the constructor
+    // Create the shared buffers in the constructor
     // to avoid race-condition in DAGNet.
     if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
       createSharedBuffer<Context>(ws_);
@@ -34,6 +28,12 @@ class ConvOp final : public ConvPoolOpBase<Context> {
   bool RunOnDeviceWithOrderNHWC() override;
 
  private:
+  // Direct convolution for 2D depthwise convolutions (group == C, M a
+  // multiple of C), in either order, which im2col + GEMM would do as C
+  // separate single-channel GEMMs. Returns false if the convolution is not
+  // depthwise or there is no such kernel for the context.
+  bool RunDepthwiseConv2D();
+
   Tensor<Context> col_buffer_;
   Tensor<Context> bias_multiplier_;
   Tensor<Context> img_shape_device_;
@@ -43,6 +43,9 @@ class ConvOp final : public ConvPoolOpBase<Context> {
   INPUT_TAGS(INPUT, FILTER, BIAS);
 };
 
+template <>
+bool ConvOp<float, CPUContext>::RunDepthwiseConv2D();
+
 template <typename T, class Context>
 class ConvGradientOp final : public ConvPoolOpBase<Context> {
  public:
@@ -56,6 +59,9 @@ class ConvGradientOp final : public ConvPoolOpBase<Context> {
     CAFFE_ENFORCE(
         group_ == 1 || order_ == StorageOrder::NCHW,
         "Group convolution only supports NCHW order right now.");
+    if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+      createSharedBuffer<Context>(ws_);
+    }
   }
   ~ConvGradientOp() {}
 
@@ -38,6 +38,10 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
     kernel_dims_size *= kernel_[i];
   }
 
+  if (group_ > 1 && group_ == C && RunDepthwiseConv2D()) {
+    return true;
+  }
+
   ConvPoolOpBase<Context>::SetOutputSize(X, Y, filter.dim32(0));
 
   const vector<int> input_dims = GetDims(X);
@@ -157,7 +161,7 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   };
 
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
-    runWithSharedBuffer<Context>(ws_, f);
+    runWithSharedBuffer<Context>(ws_, &context_, f);
   } else {
     f(&col_buffer_);
   }
@@ -177,6 +181,14 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
       2,
       "Only 2d convolution is supported for NHWC storage type");
 
+  if (group_ > 1) {
+    CAFFE_ENFORCE(
+        RunDepthwiseConv2D(),
+        "Group convolution only supports NCHW order right now, except for "
+        "depthwise convolutions on CPU.");
+    return true;
+  }
+
   CAFFE_ENFORCE(X.ndim(), filter.ndim());
   const int M = filter.dim32(0);
   CAFFE_ENFORCE(filter.dim32(1) == kernel_h());
@@ -303,7 +315,7 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
       }
     };
     if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
-      runWithSharedBuffer<Context>(ws_, f);
+      runWithSharedBuffer<Context>(ws_, &context_, f);
     } else {
       f(&col_buffer_);
     }
@@ -311,6 +323,11 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   return true;
 }
 
+template <typename T, class Context>
+bool ConvOp<T, Context>::RunDepthwiseConv2D() {
+  return false;
+}
+
 template <typename T, class Context>
 bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   auto& X = Input(INPUT);
@@ -355,7 +372,11 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   col_buffer_shape.push_back(C / group_ * kernel_dims_size);
   col_buffer_shape.insert(
       col_buffer_shape.end(), output_dims.begin(), output_dims.end());
-  col_buffer_.Resize(col_buffer_shape);
+  Tensor<Context>* col_buffer = &col_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    col_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
+  col_buffer->Resize(col_buffer_shape);
 
   if (kernel_.size() != 2) {
     SetDeviceTensor(img_shape, &img_shape_device_);
@@ -367,7 +388,7 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
 
   // Pre-setting the gradients to zero.
@@ -545,12 +566,16 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const int output_image_size = dY.dim32(1) * dY.dim32(2);
   // The col buffer is stored in CHW order as well - kernel_dim, and the height
   // and width.
-  col_buffer_.Resize(output_image_size, kernel_dim);
+  Tensor<Context>* col_buffer = &col_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    col_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
+  col_buffer->Resize(output_image_size, kernel_dim);
 
   const T* Xdata = X.template data<T>();
   const T* const filter_data = filter.template data<T>();
   const T* const dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
 
   // Pre-setting the gradients to zero.
@@ -10,25 +10,18 @@ CAFFE2_DEFINE_bool(
 
 namespace caffe2 {
 
+CAFFE_KNOWN_TYPE(SharedBuffers<CPUContext>);
+
 template <>
 void createSharedBuffer<CPUContext>(Workspace* ws) {
-  auto* mutexPtr = ws->CreateBlob("__CAFFE2_SHARED_CONV_BUFFER_CPU_MUTEX__")
-                       ->GetMutable<std::unique_ptr<std::mutex>>();
-  mutexPtr->reset(new std::mutex());
-  ws->CreateBlob("__CAFFE2_SHARED_CONV_BUFFER_CPU__");
+  ws->CreateBlob("__CAFFE2_SHARED_CONV_BUFFER_CPU__")
+      ->GetMutable<SharedBuffers<CPUContext>>();
 }
 
 template <>
-void runWithSharedBuffer(
-    Workspace* ws,
-    std::function<void(Tensor<CPUContext>* buffer)> f) {
-  auto* mutexBlob = ws->GetBlob("__CAFFE2_SHARED_CONV_BUFFER_CPU_MUTEX__");
-  CAFFE_ENFORCE(mutexBlob, "Must call createSharedBuffer() first");
-
-  auto* mutexPtr = mutexBlob->GetMutable<std::unique_ptr<std::mutex>>();
-  std::lock_guard<std::mutex> g(**mutexPtr);
-  auto* buffer =
-      ws->GetBlob("__CAFFE2_SHARED_CONV_BUFFER_CPU__")->GetMutable<TensorCPU>();
-  f(buffer);
+Tensor<CPUContext>* getSharedBuffer(Workspace* ws, CPUContext* /*context*/) {
+  auto* blob = ws->GetBlob("__CAFFE2_SHARED_CONV_BUFFER_CPU__");
+  CAFFE_ENFORCE(blob, "Must call createSharedBuffer() first");
+  return blob->GetMutable<SharedBuffers<CPUContext>>()->Get(nullptr);
 }
 }
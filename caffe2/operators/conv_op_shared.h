@@ -1,6 +1,12 @@
 #ifndef CAFFE2_OPERATORS_CONV_OP_SHARED_H_
 #define CAFFE2_OPERATORS_CONV_OP_SHARED_H_
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/workspace.h"
@@ -8,20 +14,57 @@
 namespace caffe2 {
 
 /**
- * Creates a mutex and shared buffer in the workspace.
+ * The shared col buffers of a workspace: one for every thread using them,
+ * and on GPUs for every stream it runs ops on, so that the ops using them
+ * never wait for each other and the work queued on a buffer is ordered.
+ * The buffers only grow, to the biggest size asked for.
+ */
+template <typename Context>
+class SharedBuffers {
+ public:
+  // The buffer of the calling thread for stream (nullptr on the CPU).
+  Tensor<Context>* Get(void* stream) {
+    std::lock_guard<std::mutex> g(mutex_);
+    auto& buffer = buffers_[std::make_pair(std::this_thread::get_id(), stream)];
+    if (!buffer) {
+      buffer.reset(new Tensor<Context>());
+      buffer->SetKeepOnShrink(true);
+    }
+    return buffer.get();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<std::pair<std::thread::id, void*>, std::unique_ptr<Tensor<Context>>>
+      buffers_;
+};
+
+/**
+ * Creates the shared buffers in the workspace, unless they exist already.
  * Not thread-safe, must be called from the constructor.
  */
 template <typename Context>
 void createSharedBuffer(Workspace* ws);
 
 /**
- * Thread-safe, can be invoked from RunOnDevice() to serialize
- * access to shared buffer.
+ * Thread-safe, can be invoked from RunOnDevice() to get the shared buffer of
+ * the calling thread (and stream of context). Only that thread uses it, until
+ * it returns from its op.
+ */
+template <typename Context>
+Tensor<Context>* getSharedBuffer(Workspace* ws, Context* context);
+
+/**
+ * Thread-safe, can be invoked from RunOnDevice() to run f with the shared
+ * buffer of the calling thread.
  */
 template <typename Context>
 void runWithSharedBuffer(
     Workspace* ws,
-    std::function<void(Tensor<Context>* buffer)> f);
+    Context* context,
+    std::function<void(Tensor<Context>* buffer)> f) {
+  f(getSharedBuffer<Context>(ws, context));
+}
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_CONV_OP_SHARED_H_
@@ -3,25 +3,20 @@
 
 namespace caffe2 {
 
+CAFFE_KNOWN_TYPE(SharedBuffers<CUDAContext>);
+
 template <>
 void createSharedBuffer<CUDAContext>(Workspace* ws) {
-  auto* mutexPtr = ws->CreateBlob("__CAFFE2_SHARED_CONV_BUFFER_CUDA_MUTEX__")
-                       ->GetMutable<std::unique_ptr<std::mutex>>();
-  mutexPtr->reset(new std::mutex());
-  ws->CreateBlob("__CAFFE2_SHARED_CONV_BUFFER_CUDA__");
+  ws->CreateBlob("__CAFFE2_SHARED_CONV_BUFFER_CUDA__")
+      ->GetMutable<SharedBuffers<CUDAContext>>();
 }
 
 template <>
-void runWithSharedBuffer(
-    Workspace* ws,
-    std::function<void(Tensor<CUDAContext>* buffer)> f) {
-  auto* mutexBlob = ws->GetBlob("__CAFFE2_SHARED_CONV_BUFFER_CUDA_MUTEX__");
-  CAFFE_ENFORCE(mutexBlob, "Must call createSharedBuffer() first");
-
-  auto* mutexPtr = mutexBlob->GetMutable<std::unique_ptr<std::mutex>>();
-  std::lock_guard<std::mutex> g(**mutexPtr);
-  auto* buffer = ws->GetBlob("__CAFFE2_SHARED_CONV_BUFFER_CUDA__")
-                     ->GetMutable<TensorCUDA>();
-  f(buffer);
+Tensor<CUDAContext>* getSharedBuffer(Workspace* ws, CUDAContext* context) {
+  auto* blob = ws->GetBlob("__CAFFE2_SHARED_CONV_BUFFER_CUDA__");
+  CAFFE_ENFORCE(blob, "Must call createSharedBuffer() first");
+  // The streams belong to a device, so this is also a buffer per device.
+  return blob->GetMutable<SharedBuffers<CUDAContext>>()->Get(
+      context->cuda_stream());
 }
 }
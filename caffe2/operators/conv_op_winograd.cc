@@ -0,0 +1,247 @@
+#include <algorithm>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/perfkernels/winograd.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+constexpr int kLanes = kWinogradTiles;
+// Every 6x6 input tile gives a 4x4 output tile.
+constexpr int kInputTile = 6;
+constexpr int kOutputTile = 4;
+constexpr int kTileSize = kInputTile * kInputTile;
+
+// u = G g G^T for a 3x3 filter g, the 36 values of u strided by stride, with
+//
+//   G = |  1/4     0     0  |
+//       | -1/6  -1/6  -1/6  |
+//       | -1/6   1/6  -1/6  |
+//       | 1/24  1/12   1/6  |
+//       | 1/24 -1/12   1/6  |
+//       |    0     0     1  |
+void TransformFilter(const float* g, float* u, int stride) {
+  auto transform = [](const float* x, int x_stride, float* y, int y_stride) {
+    const float x0 = x[0], x1 = x[x_stride], x2 = x[2 * x_stride];
+    y[0] = x0 / 4;
+    y[y_stride] = -(x0 + x1 + x2) / 6;
+    y[2 * y_stride] = -(x0 - x1 + x2) / 6;
+    y[3 * y_stride] = x0 / 24 + x1 / 12 + x2 / 6;
+    y[4 * y_stride] = x0 / 24 - x1 / 12 + x2 / 6;
+    y[5 * y_stride] = x2;
+  };
+  float t[kInputTile * 3];
+  for (int j = 0; j < 3; ++j) {
+    transform(g + j, 3, t + j, 3);
+  }
+  for (int i = 0; i < kInputTile; ++i) {
+    transform(t + i * 3, 1, u + i * kInputTile * stride, stride);
+  }
+}
+
+} // namespace
+
+// Winograd F(4x4, 3x3) convolution (Lavin & Gray, "Fast Algorithms for
+// Convolutional Neural Networks") for 3x3 NCHW convolutions with stride and
+// dilation 1. Each 6x6 input tile is transformed to V = B^T d B and each
+// filter to U = G g G^T. The 36 elements of the transforms are then
+// independent GEMMs over the channels, M_e = U_e V_e, and the output tiles
+// are A^T M A. Compared to im2col + GEMM, the scratch space is 36 / 16
+// instead of 9 times the input, and the GEMMs do 4 times fewer
+// multiplications.
+//
+// The transforms of 8 tiles at a time are done by the perfkernels, on the
+// tiles in parallel on the workspace thread pool. With the
+// "convolution_transform_strategy" argument set to "PRECOMPUTE" (as for the
+// NNPACK engine), the filters are transformed on the first run only, i.e.
+// they must not change afterwards.
+class WinogradConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  WinogradConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        precompute_(
+            OperatorBase::GetSingleArgument<std::string>(
+                "convolution_transform_strategy", "COMPUTE") == "PRECOMPUTE") {
+    OPERATOR_NEEDS_FEATURE(
+        order_ == StorageOrder::NCHW, "Winograd Conv only supports NCHW.");
+    OPERATOR_NEEDS_FEATURE(
+        kernel_.size() == 2 && kernel_h() == 3 && kernel_w() == 3,
+        "Winograd Conv only supports 3x3 kernels.");
+    OPERATOR_NEEDS_FEATURE(
+        stride_h() == 1 && stride_w() == 1 && dilation_h() == 1 &&
+            dilation_w() == 1,
+        "Winograd Conv only supports stride and dilation 1.");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override;
+
+ private:
+  const bool precompute_;
+  bool filter_transformed_ = false;
+  // 36 x M x C / group
+  TensorCPU transformed_filter_;
+  // 36 x C x tiles
+  TensorCPU transformed_input_;
+  // 36 x M x tiles
+  TensorCPU transformed_output_;
+  INPUT_TAGS(INPUT, FILTER, BIAS);
+};
+
+bool WinogradConvOp::RunOnDeviceWithOrderNCHW() {
+  const auto& X = Input(INPUT);
+  const auto& filter = Input(FILTER);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE_EQ(X.ndim(), 4);
+  const int N = X.dim32(0), C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
+  CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+  const int M = filter.dim32(0);
+  CAFFE_ENFORCE_EQ(C % group_, 0);
+  CAFFE_ENFORCE_EQ(M % group_, 0);
+  const int C_group = C / group_;
+  const int M_group = M / group_;
+  CAFFE_ENFORCE_EQ(filter.dim32(1), C_group);
+  CAFFE_ENFORCE_EQ(filter.dim32(2), 3);
+  CAFFE_ENFORCE_EQ(filter.dim32(3), 3);
+  const float* bias = nullptr;
+  if (InputSize() == 3) {
+    const auto& b = Input(BIAS);
+    CAFFE_ENFORCE_EQ(b.ndim(), 1);
+    CAFFE_ENFORCE_EQ(b.dim32(0), M);
+    bias = b.data<float>();
+  }
+  ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+  const int out_h = Y->dim32(2);
+  const int out_w = Y->dim32(3);
+  const int tiles_h = (out_h + kOutputTile - 1) / kOutputTile;
+  const int tiles_w = (out_w + kOutputTile - 1) / kOutputTile;
+  const int image_tiles = tiles_h * tiles_w;
+  const int tiles = N * image_tiles;
+  const int blocks = (tiles + kLanes - 1) / kLanes;
+
+  if (!precompute_ || !filter_transformed_ ||
+      transformed_filter_.dims() != vector<TIndex>{kTileSize, M, C_group}) {
+    transformed_filter_.Resize(kTileSize, M, C_group);
+    const float* filter_data = filter.data<float>();
+    float* U = transformed_filter_.mutable_data<float>();
+    for (int m = 0; m < M; ++m) {
+      for (int c = 0; c < C_group; ++c) {
+        TransformFilter(
+            filter_data + (m * C_group + c) * 9,
+            U + m * C_group + c,
+            M * C_group);
+      }
+    }
+    filter_transformed_ = true;
+  }
+
+  transformed_input_.Resize(kTileSize, C, tiles);
+  transformed_output_.Resize(kTileSize, M, tiles);
+  const float* X_data = X.data<float>();
+  const float* U = transformed_filter_.data<float>();
+  float* V = transformed_input_.mutable_data<float>();
+  float* Z = transformed_output_.mutable_data<float>();
+  float* Y_data = Y->mutable_data<float>();
+  ThreadPool* pool = ws_->GetThreadPool();
+
+  // Input tiles: the transforms of kLanes tiles of a channel per task. Tiles
+  // overlap by 2 and read the padding (and beyond, for partial output tiles)
+  // as zeros.
+  pool->run(
+      [&](int /*threadId*/, size_t task) {
+        const int c = task / blocks;
+        const int tile_begin = (task % blocks) * kLanes;
+        const int count = std::min(kLanes, tiles - tile_begin);
+        float d[kTileSize * kLanes];
+        float v[kTileSize * kLanes];
+        for (int l = 0; l < kLanes; ++l) {
+          if (l >= count) {
+            for (int e = 0; e < kTileSize; ++e) {
+              d[e * kLanes + l] = 0;
+            }
+            continue;
+          }
+          const int tile = tile_begin + l;
+          const int n = tile / image_tiles;
+          const int h_begin =
+              (tile % image_tiles) / tiles_w * kOutputTile - pad_t();
+          const int w_begin =
+              (tile % image_tiles) % tiles_w * kOutputTile - pad_l();
+          const float* image = X_data + (n * C + c) * H * W;
+          for (int i = 0; i < kInputTile; ++i) {
+            const int h = h_begin + i;
+            for (int j = 0; j < kInputTile; ++j) {
+              const int w = w_begin + j;
+              d[(i * kInputTile + j) * kLanes + l] =
+                  h >= 0 && h < H && w >= 0 && w < W ? image[h * W + w] : 0;
+            }
+          }
+        }
+        WinogradF4x4_3x3InputTransform(d, v);
+        for (int e = 0; e < kTileSize; ++e) {
+          std::copy(
+              v + e * kLanes,
+              v + e * kLanes + count,
+              V + (e * C + c) * tiles + tile_begin);
+        }
+      },
+      C * blocks);
+
+  for (int e = 0; e < kTileSize; ++e) {
+    for (int g = 0; g < group_; ++g) {
+      math::Gemm<float, CPUContext>(
+          CblasNoTrans,
+          CblasNoTrans,
+          M_group,
+          tiles,
+          C_group,
+          1,
+          U + (e * M + g * M_group) * C_group,
+          V + (e * C + g * C_group) * tiles,
+          0,
+          Z + (e * M + g * M_group) * tiles,
+          &context_);
+    }
+  }
+
+  // Output tiles, cropped to the output size.
+  pool->run(
+      [&](int /*threadId*/, size_t task) {
+        const int m = task / blocks;
+        const int tile_begin = (task % blocks) * kLanes;
+        const int count = std::min(kLanes, tiles - tile_begin);
+        float z[kTileSize * kLanes];
+        float y[kOutputTile * kOutputTile * kLanes];
+        for (int e = 0; e < kTileSize; ++e) {
+          const float* src = Z + (e * M + m) * tiles + tile_begin;
+          for (int l = 0; l < kLanes; ++l) {
+            z[e * kLanes + l] = l < count ? src[l] : 0;
+          }
+        }
+        WinogradF4x4_3x3OutputTransform(z, y);
+        const float b = bias ? bias[m] : 0;
+        for (int l = 0; l < count; ++l) {
+          const int tile = tile_begin + l;
+          const int n = tile / image_tiles;
+          const int h_begin = (tile % image_tiles) / tiles_w * kOutputTile;
+          const int w_begin = (tile % image_tiles) % tiles_w * kOutputTile;
+          float* output = Y_data + (n * M + m) * out_h * out_w;
+          for (int i = 0; i < kOutputTile && h_begin + i < out_h; ++i) {
+            for (int j = 0; j < kOutputTile && w_begin + j < out_w; ++j) {
+              output[(h_begin + i) * out_w + w_begin + j] =
+                  y[(i * kOutputTile + j) * kLanes + l] + b;
+            }
+          }
+        }
+      },
+      M * blocks);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv, WINOGRAD, WinogradConvOp);
+
+} // namespace caffe2
@@ -46,7 +46,7 @@ class ConvPoolOpBase : public Operator<Context> {
         order_(StringToStorageOrder(
             OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
         shared_buffer_(
-            OperatorBase::GetSingleArgument<int>("shared_buffer", 0)),
+            OperatorBase::GetSingleArgument<int>("shared_buffer", 1)),
         ws_(ws) {
     // For the padding, they should either be the legacy padding strategy
     // (VALID or SAME), or an explicit, non-negative value.
@@ -131,7 +131,7 @@ bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNCHW() {
     }
   };
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
-    runWithSharedBuffer<Context>(ws_, f);
+    runWithSharedBuffer<Context>(ws_, &context_, f);
   } else {
     f(&col_buffer_);
   }
@@ -181,10 +181,10 @@ bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const T* filter_data = filter.template data<T>();
   T* Ydata = Y->template mutable_data<T>();
 
-  auto f = [&](Tensor<Context>* /*col_buffer*/) {
-    col_buffer_.Resize(
+  auto f = [&](Tensor<Context>* col_buffer) {
+    col_buffer->Resize(
         vector<TIndex>{H, W, this->kernel_h(), this->kernel_w(), C});
-    T* col_buffer_data = col_buffer_.template mutable_data<T>();
+    T* col_buffer_data = col_buffer->template mutable_data<T>();
     for (auto image_id = 0; image_id < N; ++image_id) {
       // Weight term
       math::Gemm<T, Context>(
@@ -239,7 +239,7 @@ bool ConvTransposeOp<T, Context>::RunOnDeviceWithOrderNHWC() {
     }
   };
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
-    runWithSharedBuffer<Context>(ws_, f);
+    runWithSharedBuffer<Context>(ws_, &context_, f);
   } else {
     f(&col_buffer_);
   }
@@ -270,7 +270,11 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const int kernel_dim = C * this->kernel_h() * this->kernel_w();
   const int output_image_size = dY.dim32(2) * dY.dim32(3);
   // The col buffer is stored in CHW order as well
-  col_buffer_.Resize(
+  Tensor<Context>* col_buffer = &col_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    col_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
+  col_buffer->Resize(
       vector<TIndex>{C, this->kernel_h(), this->kernel_w(), H, W});
   if (!no_bias_) {
     auto* dbias = Output(BIAS_OR_INPUT_GRAD);
@@ -285,7 +289,7 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
           &context_);
     }
   }
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* dYdata = dY.template data<T>();
@@ -422,7 +426,11 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const int kernel_dim = C * this->kernel_h() * this->kernel_w();
   const int output_image_size = dY.dim32(1) * dY.dim32(2);
   // The col buffer is stored in HWC order as well
-  col_buffer_.Resize(
+  Tensor<Context>* col_buffer = &col_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    col_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
+  col_buffer->Resize(
       vector<TIndex>{H, W, this->kernel_h(), this->kernel_w(), C});
   if (!no_bias_) {
     auto* dbias = Output(BIAS_OR_INPUT_GRAD);
@@ -437,7 +445,7 @@ bool ConvTransposeGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
           &context_);
     }
   }
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* dYdata = dY.template data<T>();
@@ -30,7 +30,7 @@ class ConvTransposeUnpoolBase : public Operator<Context> {
         order_(StringToStorageOrder(
             OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
         shared_buffer_(
-            OperatorBase::GetSingleArgument<int>("shared_buffer", 0)),
+            OperatorBase::GetSingleArgument<int>("shared_buffer", 1)),
         ws_(ws) {
     // For the padding, they should either be the legacy padding strategy
     // (VALID or SAME), or an explicit, non-negative value.
@@ -124,7 +124,7 @@ class ConvTransposeUnpoolBase : public Operator<Context> {
       CAFFE_ENFORCE_LE(adj_[dim], stride_[dim]);
     }
 
-    // Create shared buffer mutex in the constructor
+    // Create the shared buffers in the constructor
     // to avoid race-condition in DAGNet.
     if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
       createSharedBuffer<Context>(ws_);
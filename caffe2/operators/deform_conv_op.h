@@ -59,7 +59,7 @@ class DeformConvOp final : public DeformConvOpBase<T, Context> {
 
   DeformConvOp(const OperatorDef& operator_def, Workspace* ws)
       : DeformConvOpBase<T, Context>(operator_def, ws) {
-    // Create shared buffer mutex in the constructor
+    // Create the shared buffers in the constructor
     // to avoid race-condition in DAGNet.
     if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
       createSharedBuffer<Context>(ws_);
@@ -90,6 +90,9 @@ class DeformConvGradientOp final : public DeformConvOpBase<T, Context> {
     CAFFE_ENFORCE(
         !(no_bias_ && OutputSize() == 4),
         "If bias is not present, you should not have 4 grad output.");
+    if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+      createSharedBuffer<Context>(ws_);
+    }
   }
   ~DeformConvGradientOp() {}
 
@@ -180,7 +180,7 @@ bool DeformConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   };
 
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
-    runWithSharedBuffer<Context>(ws_, f);
+    runWithSharedBuffer<Context>(ws_, &context_, f);
   } else {
     f(&col_buffer_);
   }
@@ -280,15 +280,19 @@ bool DeformConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   col_buffer_shape.push_back(C * kernel_dims_size);
   col_buffer_shape.insert(
       col_buffer_shape.end(), output_dims.begin(), output_dims.end());
-  col_buffer_.Resize(col_buffer_shape);
+  Tensor<Context>* col_buffer = &col_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    col_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
+  col_buffer->Resize(col_buffer_shape);
 
-  const int col_buffer_offset = col_buffer_.size() / group_;
+  const int col_buffer_offset = col_buffer->size() / group_;
 
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* offset_data = offset.template data<T>();
   const T* dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
   T* doffset_data = doffset->template mutable_data<T>();
 
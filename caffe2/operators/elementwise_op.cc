@@ -20,11 +20,13 @@ namespace caffe2 {
         size_t pre,                                                            \
         size_t n,                                                              \
         CPUContext*) {                                                         \
-      for (int i = 0; i < pre; ++i) {                                          \
-        for (int j = 0; j < n; ++j) {                                          \
-          out[i * n + j] = op(a[i * n + j], b[j]);                             \
+      BroadcastParallelFor(pre, n, [=](size_t begin, size_t end) {             \
+        for (size_t i = begin; i < end; ++i) {                                 \
+          for (size_t j = 0; j < n; ++j) {                                     \
+            out[i * n + j] = op(a[i * n + j], b[j]);                           \
+          }                                                                    \
         }                                                                      \
-      }                                                                        \
+      });                                                                      \
     }                                                                          \
     template <typename T, typename R>                                          \
     void RunWithBroadcast2(                                                    \
@@ -35,13 +37,14 @@ namespace caffe2 {
         size_t n,                                                              \
         size_t post,                                                           \
         CPUContext*) {                                                         \
-      for (int i = 0; i < pre; ++i) {                                          \
-        for (int j = 0; j < n; ++j) {                                          \
-          for (int k = 0; k < post; ++k) {                                     \
-            out[(i * n + j) * post + k] = op(a[(i * n + j) * post + k], b[j]); \
+      BroadcastParallelFor(pre * n, post, [=](size_t begin, size_t end) {      \
+        for (size_t row = begin; row < end; ++row) {                           \
+          const T b_j = b[row % n];                                            \
+          for (size_t k = 0; k < post; ++k) {                                  \
+            out[row * post + k] = op(a[row * post + k], b_j);                  \
           }                                                                    \
         }                                                                      \
-      }                                                                        \
+      });                                                                      \
     }                                                                          \
   };                                                                           \
   REGISTER_CPU_OPERATOR(                                                       \
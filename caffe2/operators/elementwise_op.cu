@@ -9,25 +9,48 @@
 
 namespace caffe2 {
 
+namespace {
+
+// The type the CUDA_FUNCTOR ops compute in: float16 values are computed in
+// float, the other types in themselves.
+template <typename T>
+struct ComputeType {
+  using type = T;
+};
+template <>
+struct ComputeType<float16> {
+  using type = float;
+};
+
+template <typename T>
+inline __device__ typename ComputeType<T>::type ToCompute(T x) {
+  return convert::Get<typename ComputeType<T>::type>(x);
+}
+
+} // namespace
+
+// NumericTypes and float16
+using CUDANumericTypes = TensorTypes<int32_t, int64_t, float, double, float16>;
+
 #define CUDA_FUNCTOR(name, op, input_type, output_type) \
 template <int b_is_scalar, typename T, typename R> \
 __global__ void name##Kernel(const T* a, const T* b, R* out, int n) { \
   CUDA_1D_KERNEL_LOOP(i, n) { \
-    out[i] = op(a[i], b[b_is_scalar ? 0 : i]); \
+    out[i] = convert::Get<R>(op(ToCompute(a[i]), ToCompute(b[b_is_scalar ? 0 : i]))); \
   } \
 } \
 template <typename T, typename R> \
 __global__ void name##BroadcastKernel( \
     const T* a, const T* b, R* out, int pre, int n) { \
   CUDA_1D_KERNEL_LOOP(i, pre * n) { \
-    out[i] = op(a[i], b[i % n]); \
+    out[i] = convert::Get<R>(op(ToCompute(a[i]), ToCompute(b[i % n]))); \
   } \
 } \
 template <typename T, typename R> \
 __global__ void name##Broadcast2Kernel( \
     const T* a, const T* b, R* out, int pre, int n, int post) { \
   CUDA_1D_KERNEL_LOOP(i, pre * n * post) { \
-    out[i] = op(a[i], b[(i / post) % n]); \
+    out[i] = convert::Get<R>(op(ToCompute(a[i]), ToCompute(b[(i / post) % n]))); \
   } \
 } \
  \
@@ -64,25 +87,25 @@ REGISTER_CUDA_OPERATOR( \
         input_type, CUDAContext, Cuda##name##Functor, output_type>)
 
 #define CUDA_SUB(x, y) ((x) - (y))
-CUDA_FUNCTOR(Sub, CUDA_SUB, NumericTypes, SameTypeAsInput);
+CUDA_FUNCTOR(Sub, CUDA_SUB, CUDANumericTypes, SameTypeAsInput);
 #undef CUDA_SUB
 #define CUDA_MUL(x, y) ((x) * (y))
-CUDA_FUNCTOR(Mul, CUDA_MUL, NumericTypes, SameTypeAsInput);
+CUDA_FUNCTOR(Mul, CUDA_MUL, CUDANumericTypes, SameTypeAsInput);
 #undef CUDA_MUL
 #define CUDA_DIV(x, y) ((x) / (y))
-CUDA_FUNCTOR(Div, CUDA_DIV, NumericTypes, SameTypeAsInput);
+CUDA_FUNCTOR(Div, CUDA_DIV, CUDANumericTypes, SameTypeAsInput);
 #undef CUDA_DIV
 #define CUDA_LT(x, y) ((x) < (y))
-CUDA_FUNCTOR(LT, CUDA_LT, NumericTypes, FixedType<bool>);
+CUDA_FUNCTOR(LT, CUDA_LT, CUDANumericTypes, FixedType<bool>);
 #undef CUDA_LT
 #define CUDA_LE(x, y) ((x) <= (y))
-CUDA_FUNCTOR(LE, CUDA_LE, NumericTypes, FixedType<bool>);
+CUDA_FUNCTOR(LE, CUDA_LE, CUDANumericTypes, FixedType<bool>);
 #undef CUDA_LE
 #define CUDA_GT(x, y) ((x) > (y))
-CUDA_FUNCTOR(GT, CUDA_GT, NumericTypes, FixedType<bool>);
+CUDA_FUNCTOR(GT, CUDA_GT, CUDANumericTypes, FixedType<bool>);
 #undef CUDA_GT
 #define CUDA_GE(x, y) ((x) >= (y))
-CUDA_FUNCTOR(GE, CUDA_GE, NumericTypes, FixedType<bool>);
+CUDA_FUNCTOR(GE, CUDA_GE, CUDANumericTypes, FixedType<bool>);
 #undef CUDA_GE
 #define CUDA_EQ(x, y) ((x) == (y))
 CUDA_FUNCTOR(EQ, CUDA_EQ, IntBoolTypes, FixedType<bool>);
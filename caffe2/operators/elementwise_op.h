@@ -134,6 +134,28 @@ std::tuple<size_t, size_t, size_t> calculate_broadcast_sizes(
   return std::make_tuple(pre, n, post);
 }
 
+/**
+ * Calls f(begin, end) on consecutive ranges covering [0, num_rows), where each
+ * row has row_size items. The ranges are spread over the OpenMP threads when
+ * there are enough items to amortize them.
+ */
+template <typename F>
+void BroadcastParallelFor(size_t num_rows, size_t row_size, F f) {
+  constexpr size_t kMinItemsPerThread = 1 << 15;
+  const size_t rows_per_range =
+      std::max<size_t>(1, kMinItemsPerThread / std::max<size_t>(row_size, 1));
+  if (num_rows <= rows_per_range) {
+    f(0, num_rows);
+    return;
+  }
+  const int64_t num_ranges = (num_rows + rows_per_range - 1) / rows_per_range;
+#pragma omp parallel for
+  for (int64_t i = 0; i < num_ranges; ++i) {
+    const size_t begin = i * rows_per_range;
+    f(begin, std::min(begin + rows_per_range, num_rows));
+  }
+}
+
 /**
  * Performs a binary operation (e.g. +, - or /) with optional broadcast support.
  *
@@ -399,9 +421,11 @@ bool DivGradientOp<Context>::RunOnDevice() {
         size_t pre,                                                          \
         size_t n,                                                            \
         CPUContext*) {                                                       \
-      EigenArrayMap<R>(out, n, pre) = eigen_op(                              \
-          (ConstEigenArrayMap<T>(a, n, pre).colwise()),                      \
-          (ConstEigenVectorArrayMap<T>(b, n)));                              \
+      BroadcastParallelFor(pre, n, [=](size_t begin, size_t end) {           \
+        EigenArrayMap<R>(out + begin * n, n, end - begin) = eigen_op(        \
+            (ConstEigenArrayMap<T>(a + begin * n, n, end - begin).colwise()), \
+            (ConstEigenVectorArrayMap<T>(b, n)));                            \
+      });                                                                    \
     }                                                                        \
     template <typename T, typename R>                                        \
     void RunWithBroadcast2(                                                  \
@@ -412,11 +436,19 @@ bool DivGradientOp<Context>::RunOnDevice() {
         size_t n,                                                            \
         size_t post,                                                         \
         CPUContext*) {                                                       \
-      for (int i = 0; i < pre; ++i) {                                        \
-        EigenArrayMap<R>(out + i * n * post, post, n) = eigen_op(            \
-            (ConstEigenArrayMap<T>(a + i * n * post, post, n).rowwise()),    \
-            (Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>(b, n)));   \
-      }                                                                      \
+      /* Row i * n + j of the [pre * n, post] matrix a is broadcast with  */ \
+      /* b[j]; each range is split where j wraps around.                 */ \
+      BroadcastParallelFor(pre * n, post, [=](size_t begin, size_t end) {    \
+        for (size_t row = begin; row < end;) {                               \
+          const size_t j = row % n;                                          \
+          const size_t cols = std::min(n - j, end - row);                    \
+          EigenArrayMap<R>(out + row * post, post, cols) = eigen_op(         \
+              (ConstEigenArrayMap<T>(a + row * post, post, cols).rowwise()), \
+              (Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>(         \
+                  b + j, cols)));                                            \
+          row += cols;                                                       \
+        }                                                                    \
+      });                                                                    \
     }                                                                        \
   };                                                                         \
   REGISTER_CPU_OPERATOR(                                                     \
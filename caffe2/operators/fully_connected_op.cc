@@ -2,8 +2,36 @@
 
 #include "caffe2/operators/fully_connected_op.h"
 
+CAFFE2_DEFINE_int(
+    caffe2_fc_packed_max_rows,
+    64,
+    "CPU FC ops computing at most this many rows use a packed copy of their "
+    "weight, once it didn't change between two runs. 0 disables packing.");
+
 namespace caffe2 {
 
+template <>
+bool RunPackedFC<CPUContext, float, float, float, float>(
+    PackedGemmMatrixCache* packed_W,
+    const TensorCPU& X,
+    const TensorCPU& W,
+    const TensorCPU& b,
+    int M,
+    int N,
+    int K,
+    TensorCPU* Y) {
+  if (M > FLAGS_caffe2_fc_packed_max_rows) {
+    return false;
+  }
+  const auto* packed = packed_W->Get(&W, W.version(), N, K, W.data<float>());
+  if (!packed) {
+    return false;
+  }
+  packed->Compute(
+      M, X.data<float>(), b.data<float>(), Y->mutable_data<float>());
+  return true;
+}
+
 REGISTER_CPU_OPERATOR(FC, FullyConnectedOp<CPUContext>);
 REGISTER_CPU_OPERATOR(FCGradient, FullyConnectedGradientOp<CPUContext>);
 
@@ -5,9 +5,44 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/packed_gemm.h"
+
+CAFFE2_DECLARE_int(caffe2_fc_packed_max_rows);
 
 namespace caffe2 {
 
+// Computes Y = X * W^T + b with the packed copy of W kept in packed_W, and
+// returns true, or returns false when the FC has to call gemm. Only CPU
+// float FCs with at most caffe2_fc_packed_max_rows rows are packed.
+template <
+    class Context,
+    typename T_X,
+    typename T_W,
+    typename T_B,
+    typename T_Y>
+bool RunPackedFC(
+    PackedGemmMatrixCache* /*packed_W*/,
+    const Tensor<Context>& /*X*/,
+    const Tensor<Context>& /*W*/,
+    const Tensor<Context>& /*b*/,
+    int /*M*/,
+    int /*N*/,
+    int /*K*/,
+    Tensor<Context>* /*Y*/) {
+  return false;
+}
+
+template <>
+bool RunPackedFC<CPUContext, float, float, float, float>(
+    PackedGemmMatrixCache* packed_W,
+    const TensorCPU& X,
+    const TensorCPU& W,
+    const TensorCPU& b,
+    int M,
+    int N,
+    int K,
+    TensorCPU* Y);
+
 // This is Caffe's InnerProductOp, with a name that fits its purpose better.
 template <
     class Context,
@@ -89,6 +124,15 @@ class FullyConnectedOp final : public Operator<Context> {
       math_type = TensorProto_DataType_FLOAT16;
     }
 
+    // with a weight that doesn't change, e.g. in inference, the gemm of
+    // small batches mostly packs the weight
+    if (TransposeWeight && std::is_same<Engine, DefaultEngine>::value &&
+        !fp16_type<MATH>() &&
+        RunPackedFC<Context, T_X, T_W, T_B, T_Y>(
+            &packed_W_, X, W, b, M, N, K, Y)) {
+      return true;
+    }
+
     // W * x
     math::Gemm<T_X, Context, Engine>(
         CblasNoTrans,
@@ -145,6 +189,7 @@ class FullyConnectedOp final : public Operator<Context> {
   // a vector object every time we run Run().
   vector<TIndex> Y_shape_cache_;
   Tensor<Context> bias_multiplier_;
+  PackedGemmMatrixCache packed_W_;
 
   bool float16_compute_;
 };
@@ -0,0 +1,259 @@
+#include "caffe2/operators/fused_elementwise_op.h"
+
+#include <algorithm>
+#include <climits>
+#include <sstream>
+#include <unordered_map>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+using Kind = FusedElementwiseExpr::Kind;
+
+struct KindInfo {
+  Kind kind;
+  int arity;
+};
+
+const std::unordered_map<std::string, KindInfo>& Kinds() {
+  static const std::unordered_map<std::string, KindInfo> kinds = {
+      {"Add", {Kind::Add, 2}},
+      {"Sub", {Kind::Sub, 2}},
+      {"Mul", {Kind::Mul, 2}},
+      {"Div", {Kind::Div, 2}},
+      {"Relu", {Kind::Relu, 1}},
+      {"Sigmoid", {Kind::Sigmoid, 1}},
+      {"Tanh", {Kind::Tanh, 1}},
+      {"Exp", {Kind::Exp, 1}},
+      {"Log", {Kind::Log, 1}},
+      {"Abs", {Kind::Abs, 1}},
+      {"Sqrt", {Kind::Sqrt, 1}},
+      {"Negative", {Kind::Negative, 1}},
+  };
+  return kinds;
+}
+
+} // namespace
+
+FusedElementwiseExpr::FusedElementwiseExpr(
+    int numInputs,
+    const std::vector<std::string>& exprs)
+    : numInputs_(numInputs) {
+  CAFFE_ENFORCE(!exprs.empty(), "FusedElementwise needs an expression");
+  for (const auto& expr : exprs) {
+    std::istringstream ss(expr);
+    std::string type;
+    ss >> type;
+    int arity;
+    CAFFE_ENFORCE(IsSupported(type, &arity), "Unsupported op in: ", expr);
+    Node node{Kinds().at(type).kind, -1, -1};
+    const int values = numInputs_ + nodes_.size();
+    for (int* operand : {&node.lhs, &node.rhs}) {
+      if (operand == &node.rhs && arity == 1) {
+        break;
+      }
+      CAFFE_ENFORCE(ss >> *operand, "Missing operand in: ", expr);
+      CAFFE_ENFORCE(
+          *operand >= 0 && *operand < values, "Invalid operand in: ", expr);
+    }
+    std::string rest;
+    CAFFE_ENFORCE(!(ss >> rest), "Too many operands in: ", expr);
+    nodes_.push_back(node);
+  }
+}
+
+bool FusedElementwiseExpr::IsSupported(const std::string& op_type, int* arity) {
+  auto it = Kinds().find(op_type);
+  if (it == Kinds().end()) {
+    return false;
+  }
+  if (arity) {
+    *arity = it->second.arity;
+  }
+  return true;
+}
+
+std::string FusedElementwiseExpr::CudaSource() const {
+  std::stringstream ss;
+  for (int i = 0; i < numInputs_; ++i) {
+    ss << "const float v" << i << " = in" << i << "[index];\n";
+  }
+  for (size_t k = 0; k < nodes_.size(); ++k) {
+    const auto& node = nodes_[k];
+    const std::string a = "v" + caffe2::to_string(node.lhs);
+    const std::string b = "v" + caffe2::to_string(node.rhs);
+    ss << "const float v" << numInputs_ + k << " = ";
+    switch (node.kind) {
+      case Kind::Add:
+        ss << a << " + " << b;
+        break;
+      case Kind::Sub:
+        ss << a << " - " << b;
+        break;
+      case Kind::Mul:
+        ss << a << " * " << b;
+        break;
+      case Kind::Div:
+        ss << a << " / " << b;
+        break;
+      case Kind::Relu:
+        ss << "fmaxf(" << a << ", 0.f)";
+        break;
+      case Kind::Sigmoid:
+        ss << "1.f / (1.f + expf(-" << a << "))";
+        break;
+      case Kind::Tanh:
+        ss << "tanhf(" << a << ")";
+        break;
+      case Kind::Exp:
+        ss << "expf(" << a << ")";
+        break;
+      case Kind::Log:
+        ss << "logf(" << a << ")";
+        break;
+      case Kind::Abs:
+        ss << "fabsf(" << a << ")";
+        break;
+      case Kind::Sqrt:
+        ss << "sqrtf(" << a << ")";
+        break;
+      case Kind::Negative:
+        ss << "-" << a;
+        break;
+    }
+    ss << ";\n";
+  }
+  ss << "out0[index] = v" << numInputs_ + nodes_.size() - 1 << ";";
+  return ss.str();
+}
+
+namespace {
+
+// Evaluates the expression on blocks of kBlockSize elements, one node at a
+// time with Eigen, so that the intermediate values stay in cache and are
+// never written to blobs.
+class FusedElementwiseOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  FusedElementwiseOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        expr_(
+            InputSize(),
+            OperatorBase::GetRepeatedArgument<std::string>("exprs")) {}
+
+  bool RunOnDevice() override {
+    const auto& X0 = Input(0);
+    std::vector<const float*> inputs(InputSize());
+    for (int i = 0; i < InputSize(); ++i) {
+      CAFFE_ENFORCE(
+          Input(i).dims() == X0.dims(),
+          "All inputs of FusedElementwise must have the same shape");
+      inputs[i] = Input(i).data<float>();
+    }
+    auto* Y = Output(0);
+    Y->ResizeLike(X0);
+    float* y = Y->mutable_data<float>();
+    const auto& nodes = expr_.nodes();
+    buffer_.resize(nodes.size() * kBlockSize);
+
+    const TIndex size = X0.size();
+    for (TIndex begin = 0; begin < size; begin += kBlockSize) {
+      const int n = std::min<TIndex>(kBlockSize, size - begin);
+      auto value = [&](int v) {
+        return ConstEigenVectorArrayMap<float>(
+            v < InputSize()
+                ? inputs[v] + begin
+                : buffer_.data() + (v - InputSize()) * kBlockSize,
+            n);
+      };
+      for (size_t k = 0; k < nodes.size(); ++k) {
+        const auto& node = nodes[k];
+        // The last node writes the output directly. It may be one of the
+        // inputs, but the block has been read by then.
+        float* out =
+            k + 1 == nodes.size() ? y + begin : buffer_.data() + k * kBlockSize;
+        EigenVectorArrayMap<float> o(out, n);
+        const auto a = value(node.lhs);
+        switch (node.kind) {
+          case Kind::Add:
+            o = a + value(node.rhs);
+            break;
+          case Kind::Sub:
+            o = a - value(node.rhs);
+            break;
+          case Kind::Mul:
+            o = a * value(node.rhs);
+            break;
+          case Kind::Div:
+            o = a / value(node.rhs);
+            break;
+          case Kind::Relu:
+            o = a.cwiseMax(0.f);
+            break;
+          case Kind::Sigmoid:
+            o = 1.f / (1.f + (-a).exp());
+            break;
+          case Kind::Tanh:
+            o = a.tanh();
+            break;
+          case Kind::Exp:
+            o = a.exp();
+            break;
+          case Kind::Log:
+            o = a.log();
+            break;
+          case Kind::Abs:
+            o = a.abs();
+            break;
+          case Kind::Sqrt:
+            o = a.sqrt();
+            break;
+          case Kind::Negative:
+            o = -a;
+            break;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  static constexpr int kBlockSize = 1024;
+  const FusedElementwiseExpr expr_;
+  std::vector<float> buffer_;
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(FusedElementwise, FusedElementwiseOp);
+
+OPERATOR_SCHEMA(FusedElementwise)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1)
+    .AllowInplace([](int, int) { return true; })
+    .IdenticalTypeAndShapeOfInput(0)
+    .Arg(
+        "exprs",
+        "The expressions, \"<op> <operand> [<operand>]\", with the inputs "
+        "as values 0 to N - 1 and expression k as value N + k.")
+    .SetDoc(R"DOC(
+A DAG of elementwise float operations (Add, Sub, Mul, Div, Relu, Sigmoid,
+Tanh, Exp, Log, Abs, Sqrt and Negative, without broadcasting) over inputs of
+the same shape, computed without materializing the intermediate values. The
+output is the value of the last expression. For example, with inputs X and H,
+
+  exprs = ["Mul 0 1", "Sigmoid 2", "Add 3 0"]
+
+computes sigmoid(X * H) + X. It is made by the fuseElementwise pass of
+caffe2/opt/fusion.h. On GPU the expression is compiled to a single kernel with
+NVRTC.
+)DOC")
+    .Output(0, "Y", "The value of the last expression.");
+
+SHOULD_NOT_DO_GRADIENT(FusedElementwise);
+
+} // namespace caffe2
@@ -0,0 +1,69 @@
+#ifndef CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+#define CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+
+#include <string>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+// The expression computed by FusedElementwise, a DAG of elementwise float
+// operations over the inputs. It is given by the "exprs" argument, a list of
+// strings "<op> <operand> [<operand>]". Operands are value indices: the
+// inputs are the values 0 to numInputs - 1, and expression k is the value
+// numInputs + k. The output is the last expression. For example, with 2
+// inputs,
+//
+//   exprs = ["Mul 0 1", "Sigmoid 2"]
+//
+// computes sigmoid(in0 * in1). The ops are named after the Caffe2 operators
+// they replace (without broadcasting).
+class FusedElementwiseExpr {
+ public:
+  enum class Kind {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Relu,
+    Sigmoid,
+    Tanh,
+    Exp,
+    Log,
+    Abs,
+    Sqrt,
+    Negative,
+  };
+
+  struct Node {
+    Kind kind;
+    int lhs;
+    // -1 for unary ops.
+    int rhs;
+  };
+
+  FusedElementwiseExpr(int numInputs, const std::vector<std::string>& exprs);
+
+  // Whether op_type names an op of the expressions, and its arity.
+  static bool IsSupported(const std::string& op_type, int* arity = nullptr);
+
+  int numInputs() const {
+    return numInputs_;
+  }
+  const std::vector<Node>& nodes() const {
+    return nodes_;
+  }
+
+  // The body of a CUDA kernel computing the element index of out0 from the
+  // in<i> arrays.
+  std::string CudaSource() const;
+
+ private:
+  int numInputs_;
+  std::vector<Node> nodes_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
@@ -0,0 +1,124 @@
+#include <climits>
+#include <functional>
+#include <memory>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/fc_inference.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// <Op>Relu: runs <Op>, with the same arguments and engine, and applies Relu
+// to its output in place. Engines that can fuse the Relu into their kernel
+// register <Op>Relu themselves (e.g. NNPACK for ConvRelu).
+class ReluFusedOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  ReluFusedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {
+    const auto& type = operator_def.type();
+    CAFFE_ENFORCE(
+        type.size() > 4 && type.compare(type.size() - 4, 4, "Relu") == 0,
+        "Not a fused Relu operator: ",
+        type);
+    OperatorDef def = operator_def;
+    def.set_type(type.substr(0, type.size() - 4));
+    op_ = CreateOperator(def, ws);
+  }
+
+  bool RunOnDevice() override {
+    if (!op_->Run()) {
+      return false;
+    }
+    auto* Y = Output(0);
+    EigenVectorArrayMap<float> y(Y->mutable_data<float>(), Y->size());
+    y = y.cwiseMax(0.f);
+    return true;
+  }
+
+ private:
+  std::unique_ptr<OperatorBase> op_;
+};
+
+// Sum followed by Relu, with the Relu applied while adding the last input
+// rather than in a separate pass over the output.
+class SumReluOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  USE_SIMPLE_CTOR_DTOR(SumReluOp);
+
+  bool RunOnDevice() override {
+    const auto& X0 = Input(0);
+    for (int i = 1; i < InputSize(); ++i) {
+      CAFFE_ENFORCE(
+          X0.dims() == Input(i).dims(),
+          "All inputs of SumRelu must have the same shape");
+    }
+    auto* Y = Output(0);
+    Y->ResizeLike(X0);
+    const int n = X0.size();
+    auto x = [&](int i) {
+      return ConstEigenVectorArrayMap<float>(Input(i).data<float>(), n);
+    };
+    EigenVectorArrayMap<float> y(Y->mutable_data<float>(), n);
+    const int last = InputSize() - 1;
+    if (last == 0) {
+      y = x(0).cwiseMax(0.f);
+    } else if (last == 1) {
+      y = (x(0) + x(1)).cwiseMax(0.f);
+    } else {
+      y = x(0) + x(1);
+      for (int i = 2; i < last; ++i) {
+        y += x(i);
+      }
+      y = (y + x(last)).cwiseMax(0.f);
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(ConvRelu, ReluFusedOp);
+REGISTER_CPU_OPERATOR(FCRelu, ReluFusedOp);
+REGISTER_CPU_OPERATOR(SumRelu, SumReluOp);
+
+OPERATOR_SCHEMA(ConvRelu)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .SetDoc(R"DOC(
+Conv followed by Relu, as made by the fusion passes of caffe2/opt/fusion.h
+for inference. Takes the inputs and arguments of Conv.
+)DOC");
+
+OPERATOR_SCHEMA(FCRelu)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(
+        std::bind(FCShapeInference, std::placeholders::_1,
+                  std::placeholders::_2, false))
+    .SetDoc(R"DOC(
+FC followed by Relu, as made by the fusion passes of caffe2/opt/fusion.h for
+inference. Takes the inputs and arguments of FC.
+)DOC");
+
+OPERATOR_SCHEMA(SumRelu)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShapeOfInput(0)
+    .SetDoc(R"DOC(
+Sum followed by Relu, as made by the fusion passes of caffe2/opt/fusion.h for
+inference: the element-wise sum of the float inputs, all of the same shape,
+clamped below at 0.
+)DOC");
+
+SHOULD_NOT_DO_GRADIENT(ConvRelu);
+SHOULD_NOT_DO_GRADIENT(FCRelu);
+SHOULD_NOT_DO_GRADIENT(SumRelu);
+
+} // namespace caffe2
@@ -15,6 +15,29 @@ namespace caffe2 {
     return reinterpret_cast<const uint8_t*>(&kValue)[0] == 1; \
   }()
 
+// De-quantizes input_rows rows of the fused representation, input_columns
+// bytes each, to input_rows x (input_columns - 8) floats.
+inline void Fused8BitRowwiseQuantizedToFloat(
+    const uint8_t* input_data,
+    TIndex input_rows,
+    TIndex input_columns,
+    float* output_data) {
+  const auto output_columns = input_columns - 8;
+  for (TIndex row = 0; row < input_rows; ++row) {
+    const uint8_t* input_row = input_data + row * input_columns;
+    ConstEigenVectorArrayMap<uint8_t> input_row_values(
+        input_row, output_columns);
+    ConstEigenVectorArrayMap<float> input_row_scale_bias(
+        reinterpret_cast<const float*>(input_row + output_columns), 2);
+
+    EigenVectorArrayMap<float> output_row(
+        output_data + row * output_columns, output_columns);
+
+    output_row = input_row_values.cast<float>() * input_row_scale_bias(0) +
+        input_row_scale_bias(1);
+  }
+}
+
 template <class Context>
 class FloatToFused8BitRowwiseQuantizedOp : public Operator<Context> {
  public:
@@ -98,24 +121,12 @@ class Fused8BitRowwiseQuantizedToFloatOp : public Operator<Context> {
     const std::vector<TIndex> output_dimensions = {input_rows,
                                                    input_columns - 8};
     output->Resize(output_dimensions);
-    const auto output_columns = output->dim(1);
-
-    const auto* input_data = input.template data<uint8_t>();
-    auto* output_data = output->template mutable_data<float>();
 
-    for (size_t row = 0; row < input_rows; ++row) {
-      const uint8_t* input_row = input_data + row * input_columns;
-      ConstEigenVectorArrayMap<uint8_t> input_row_values(
-          input_row, output_columns);
-      ConstEigenVectorArrayMap<float> input_row_scale_bias(
-          reinterpret_cast<const float*>(input_row + output_columns), 2);
-
-      EigenVectorArrayMap<float> output_row(
-          output_data + row * output_columns, output_columns);
-
-      output_row = input_row_values.cast<float>() * input_row_scale_bias(0) +
-          input_row_scale_bias(1);
-    }
+    Fused8BitRowwiseQuantizedToFloat(
+        input.template data<uint8_t>(),
+        input_rows,
+        input_columns,
+        output->template mutable_data<float>());
     return true;
   }
 
@@ -1,12 +1,15 @@
+#include <algorithm>
 #include <atomic>
 #include <limits>
 #include <mutex>
 #include <sstream>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/utils/concurrent_int_map.h"
 
 namespace caffe2 {
 namespace {
@@ -36,19 +39,18 @@ struct IndexBase {
   const TypeMeta& Type() const { return meta_; }
 
   TIndexValue Size() {
-    std::lock_guard<std::mutex> guard(dictMutex_);
     return nextId_;
   }
 
  protected:
   int64_t maxElements_;
   TypeMeta meta_;
-  TIndexValue nextId_{1}; // guarded by dictMutex_
+  std::atomic<TIndexValue> nextId_{1};
   std::atomic<bool> frozen_{false};
   std::mutex dictMutex_;
 };
 
-template<typename T>
+template <typename T, typename Enable = void>
 struct Index: IndexBase {
   explicit Index(TIndexValue maxElements)
     : IndexBase(maxElements, TypeMeta::Make<T>()) {}
@@ -115,6 +117,75 @@ struct Index: IndexBase {
   std::unordered_map<T, TIndexValue> dict_;
 };
 
+// Integer keys are kept in a ConcurrentIntMap, which the threads running
+// IndexGet look up without taking a lock: only the keys missing from the
+// index lock (a shard of) it, to be inserted. A frozen index takes no lock.
+template <typename T>
+struct Index<T, typename std::enable_if<std::is_integral<T>::value>::type>
+    : IndexBase {
+  using Map = ConcurrentIntMap<T, TIndexValue>;
+
+  explicit Index(TIndexValue maxElements)
+    : IndexBase(maxElements, TypeMeta::Make<T>()), dict_(new Map()) {}
+
+  void Get(const T* keys, TIndexValue* values, size_t numKeys) {
+    // ids start at 1, so the missing keys get 0
+    if (dict_->Find(keys, numKeys, values, 0) == 0 || frozen_) {
+      return;
+    }
+    for (int i = 0; i < numKeys; ++i) {
+      if (values[i] == 0) {
+        values[i] = dict_->FindOrInsert(keys[i], [this]() { return NewId(); });
+      }
+    }
+  }
+
+  bool Load(const T* keys, size_t numKeys) {
+    CAFFE_ENFORCE(
+        numKeys <= maxElements_,
+        "Cannot load index: Tensor is larger than max_elements.");
+    std::unique_ptr<Map> dict(new Map(numKeys));
+    for (int i = 0; i < numKeys; ++i) {
+      CAFFE_ENFORCE(
+          dict->Insert(keys[i], i + 1),
+          "Repeated elements found: cannot load into dictionary.");
+    }
+    // assume no `get` is inflight while this happens
+    dict_.swap(dict);
+    nextId_ = numKeys + 1;
+    return true;
+  }
+
+  template<typename Ctx>
+  bool Store(Tensor<Ctx>* out) {
+    // an id is taken and inserted under the lock of the shard of its key,
+    // so ForEach, which locks all shards, sees every id taken
+    std::vector<T> keys;
+    dict_->ForEach([&keys](T key, TIndexValue id) {
+      if (keys.size() < static_cast<size_t>(id)) {
+        keys.resize(id);
+      }
+      keys[id - 1] = key;
+    });
+    out->Resize(keys.size());
+    std::copy(keys.begin(), keys.end(), out->template mutable_data<T>());
+    return true;
+  }
+
+ private:
+  TIndexValue NewId() {
+    TIndexValue id = nextId_;
+    do {
+      if (id >= maxElements_) {
+        CAFFE_THROW("Dict max size reached");
+      }
+    } while (!nextId_.compare_exchange_weak(id, id + 1));
+    return id;
+  }
+
+  std::unique_ptr<Map> dict_;
+};
+
 // TODO(azzolini): support sizes larger than int32
 template<class T>
 class IndexCreateOp: public Operator<CPUContext> {
@@ -42,6 +42,9 @@ If at least one input is passed, then it is assumed that that input blobs are a
 set of DBReaders to load from. Otherwise the db or dbs argument is used to load
 blobs from one single db or multiple dbs respectively. db_type argument is used
 to specify the type of the input db/dbs.
+
+A db written by Save with num_shards > 1 is loaded from its shards, which
+are read in parallel, as are multiple dbs.
 )DOC")
     .Arg(
         "absolute_path",
@@ -91,6 +94,10 @@ OPERATOR_SCHEMA(Save)
 The Save operator saves a set of blobs to a db. It takes [1, infinity) number
 of inputs and has no output. The contents of the inputs are written into the
 db specified by the arguments.
+
+With num_shards > 1, the blobs are spread over that many dbs, named after db
+with a ".shard_<i>" suffix, which are written in parallel. db then only holds
+the number of shards, and can be passed to Load like any other db.
 )DOC")
     .Arg(
         "absolute_path",
@@ -107,7 +114,11 @@ db specified by the arguments.
         "(list of strings) if set, used instead of original "
         "blob names. Must be the same length as number of blobs.")
     .Arg("db", "(string) the path to the db to load.")
-    .Arg("db_type", "(string) the type of the db.");
+    .Arg("db_type", "(string) the type of the db.")
+    .Arg(
+        "num_shards",
+        "(int, default 1) the number of dbs the blobs are spread over. All "
+        "the chunks of a blob are in the same db.");
 
 OPERATOR_SCHEMA(Checkpoint)
     .NumInputs(1, INT_MAX)
@@ -1,8 +1,13 @@
 #ifndef CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 #define CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <future>
 #include <map>
+#include <mutex>
+#include <numeric>
 #include <unordered_set>
 
 #include "caffe2/core/blob_serialization.h"
@@ -32,6 +37,24 @@ struct BlobState {
 };
 } // namespace
 
+// A sharded checkpoint (see the num_shards argument of Save) is a manifest db
+// with this single key, whose value is the number of shards, next to the
+// shard dbs named by ShardDBName.
+constexpr const char* kShardManifestKey = "__sharded_checkpoint_num_shards__";
+
+inline string ShardDBName(const string& db_name, int shard) {
+  return db_name + ".shard_" + caffe2::to_string(shard);
+}
+
+// The shards are read and written by one thread each.
+inline std::launch ShardLaunchPolicy() {
+#ifndef __ANDROID__
+  return std::launch::async;
+#else
+  return std::launch::deferred;
+#endif
+}
+
 using db::Cursor;
 using db::DB;
 using db::Transaction;
@@ -133,7 +156,7 @@ class LoadOp final : public Operator<Context> {
   void SetCurrentDevice(BlobProto* proto);
 
   bool RunOnDevice() override {
-    int total_loaded_blobs = 0;
+    std::atomic<int> total_loaded_blobs(0);
     std::unordered_map<string, BlobState> blob_states;
     if (InputSize() > 0) {
       for (int i = 0; i < InputSize(); ++i) {
@@ -141,15 +164,43 @@ class LoadOp final : public Operator<Context> {
         extract(i, reader.cursor(), &blob_states, &total_loaded_blobs);
       }
     } else {
-      for (int i = 0; i < db_names_.size(); ++i) {
-        string full_db_name = absolute_path_
-            ? db_names_[i]
-            : (ws_->RootFolder() + "/" + db_names_[i]);
-        std::unique_ptr<DB> in_db(
-            caffe2::db::CreateDB(db_type_, full_db_name, caffe2::db::READ));
-        CAFFE_ENFORCE(in_db.get(), "Cannot open db: ", full_db_name);
+      std::vector<string> full_db_names;
+      for (const string& db_name : db_names_) {
+        string full_db_name =
+            absolute_path_ ? db_name : (ws_->RootFolder() + "/" + db_name);
+        int num_shards = NumShards(full_db_name);
+        if (num_shards == 0) {
+          full_db_names.push_back(full_db_name);
+        }
+        for (int shard = 0; shard < num_shards; ++shard) {
+          full_db_names.push_back(ShardDBName(full_db_name, shard));
+        }
+      }
+
+      // A blob is only found in one db, so every db keeps its own states,
+      // and they are merged once all the dbs are read.
+      std::vector<std::unordered_map<string, BlobState>> db_blob_states(
+          full_db_names.size());
+      auto load_db = [&](int i) {
+        std::unique_ptr<DB> in_db(caffe2::db::CreateDB(
+            db_type_, full_db_names[i], caffe2::db::READ));
+        CAFFE_ENFORCE(in_db.get(), "Cannot open db: ", full_db_names[i]);
         std::unique_ptr<Cursor> cursor(in_db->NewCursor());
-        extract(i, cursor.get(), &blob_states, &total_loaded_blobs);
+        extract(i, cursor.get(), &db_blob_states[i], &total_loaded_blobs);
+      };
+      if (full_db_names.size() == 1) {
+        load_db(0);
+      } else {
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < full_db_names.size(); ++i) {
+          futures.push_back(std::async(ShardLaunchPolicy(), load_db, i));
+        }
+        for (auto& future : futures) {
+          future.get();
+        }
+      }
+      for (const auto& states : db_blob_states) {
+        blob_states.insert(states.begin(), states.end());
       }
     }
 
@@ -186,7 +237,7 @@ class LoadOp final : public Operator<Context> {
       int db_id,
       Cursor* cursor,
       std::unordered_map<string, BlobState>* blob_states,
-      int* total_loaded_blobs) {
+      std::atomic<int>* total_loaded_blobs) {
     if (load_all_) {
       extractAll(db_id, cursor, blob_states, total_loaded_blobs);
     } else {
@@ -203,15 +254,15 @@ class LoadOp final : public Operator<Context> {
       int db_id,
       Cursor* cursor,
       std::unordered_map<string, BlobState>* blob_states,
-      int* total_loaded_blobs) {
+      std::atomic<int>* total_loaded_blobs) {
     CAFFE_ENFORCE(cursor, "cursor is not valid");
-    int loaded_blobs = 0;
     for (; cursor->Valid(); cursor->Next()) {
       const auto key = buildBlobNameFromDbKey(cursor->key());
-      if (key_to_dbid_.count(key) && key_to_dbid_[key] != db_id) {
-        CAFFE_THROW("Duplicate Key ", key, " is found!\n");
-      } else {
-        key_to_dbid_[key] = db_id;
+      Blob* blob;
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        markKeyFromDb(key, db_id);
+        blob = ws_->CreateBlob(key);
       }
 
       BlobProto proto;
@@ -222,10 +273,8 @@ class LoadOp final : public Operator<Context> {
         // proto, we will set the current device.
         SetCurrentDevice(&proto);
       }
-      Blob* blob = ws_->CreateBlob(key);
-      ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
+      ProcessBlob(blob, proto, blob_states, key, total_loaded_blobs);
     }
-    *total_loaded_blobs += loaded_blobs;
   }
 
   void extractFrom(
@@ -233,18 +282,16 @@ class LoadOp final : public Operator<Context> {
       Cursor* cursor,
       const vector<Blob*>& outputs,
       std::unordered_map<string, BlobState>* blob_states,
-      int* total_loaded_blobs) {
+      std::atomic<int>* total_loaded_blobs) {
     CAFFE_ENFORCE(cursor);
-    int loaded_blobs = 0;
     for (; cursor->Valid(); cursor->Next()) {
       const auto key = buildBlobNameFromDbKey(cursor->key());
       if (!output_indices_.count(key)) {
         VLOG(1) << "Key " << key << " not used. Skipping.";
       } else {
-        if (key_to_dbid_.count(key) && key_to_dbid_[key] != db_id) {
-          CAFFE_THROW("Duplicate Key ", key, " is found!\n");
-        } else {
-          key_to_dbid_[key] = db_id;
+        {
+          std::lock_guard<std::mutex> guard(mutex_);
+          markKeyFromDb(key, db_id);
         }
 
         VLOG(2) << "Deserializing blob " << key;
@@ -257,15 +304,22 @@ class LoadOp final : public Operator<Context> {
         }
         auto blobIndex = output_indices_[key];
         Blob* blob = outputs.at(blobIndex);
-        ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
+        ProcessBlob(blob, proto, blob_states, key, total_loaded_blobs);
 
-        if (*total_loaded_blobs + loaded_blobs == OutputSize()) {
+        if (*total_loaded_blobs == OutputSize()) {
           break;
         }
       }
     }
+  }
 
-    *total_loaded_blobs += loaded_blobs;
+  // Called with mutex_ held
+  void markKeyFromDb(const string& key, int db_id) {
+    if (key_to_dbid_.count(key) && key_to_dbid_[key] != db_id) {
+      CAFFE_THROW("Duplicate Key ", key, " is found!\n");
+    } else {
+      key_to_dbid_[key] = db_id;
+    }
   }
 
   string buildBlobNameFromDbKey(const string& dbKey) {
@@ -281,6 +335,21 @@ class LoadOp final : public Operator<Context> {
   }
 
  private:
+  // Returns the number of shards if the db is the manifest of a sharded
+  // checkpoint, and 0 otherwise.
+  int NumShards(const string& full_db_name) {
+    std::unique_ptr<DB> in_db(
+        caffe2::db::CreateDB(db_type_, full_db_name, caffe2::db::READ));
+    CAFFE_ENFORCE(in_db.get(), "Cannot open db: ", full_db_name);
+    std::unique_ptr<Cursor> cursor(in_db->NewCursor());
+    if (!cursor->Valid() || cursor->key() != kShardManifestKey) {
+      return 0;
+    }
+    int num_shards = caffe2::stoi(cursor->value());
+    CAFFE_ENFORCE_GT(num_shards, 0, "Bad shard manifest: ", full_db_name);
+    return num_shards;
+  }
+
   // We are tracking sizes of already read tensor parts while reading data
   // chunks. This way we can make sure that all chunks were loaded in the end.
   void ProcessBlob(
@@ -288,7 +357,7 @@ class LoadOp final : public Operator<Context> {
       const BlobProto& proto,
       std::unordered_map<string, BlobState>* blob_states_ptr,
       const string& key,
-      int* loaded_blobs) {
+      std::atomic<int>* loaded_blobs) {
     auto& blob_states = *blob_states_ptr;
     if (blob_states.count(key) == 0) {
       // We reset the blob so that any existing content is destroyed. This
@@ -401,6 +470,8 @@ class LoadOp final : public Operator<Context> {
   bool allow_incomplete_;
   std::map<string, int> output_indices_;
   std::map<string, int> key_to_dbid_;
+  // guards key_to_dbid_ and the workspace while dbs are read in parallel
+  std::mutex mutex_;
   std::vector<std::string> blob_names_;
 };
 
@@ -417,10 +488,12 @@ class SaveOp final : public Operator<Context> {
             OperatorBase::GetSingleArgument<string>("strip_prefix", "")),
         db_name_(OperatorBase::GetSingleArgument<string>("db", "")),
         db_type_(OperatorBase::GetSingleArgument<string>("db_type", "")),
+        num_shards_(OperatorBase::GetSingleArgument<int>("num_shards", 1)),
         blob_names_(
             OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")) {
     CAFFE_ENFORCE_GT(db_name_.size(), 0, "Must specify a db name.");
     CAFFE_ENFORCE_GT(db_type_.size(), 0, "Must specify a db type.");
+    CAFFE_ENFORCE_GT(num_shards_, 0, "num_shards should be positive.");
     CAFFE_ENFORCE(
         blob_names_.empty() ||
             blob_names_.size() == OperatorBase::Inputs().size(),
@@ -455,6 +528,60 @@ class SaveOp final : public Operator<Context> {
   bool RunOnDevice() override {
     string full_db_name =
         absolute_path_ ? db_name_ : (ws_->RootFolder() + "/" + db_name_);
+    const vector<const Blob*>& inputs = OperatorBase::Inputs();
+    if (num_shards_ == 1) {
+      std::vector<int> all_inputs(inputs.size());
+      std::iota(all_inputs.begin(), all_inputs.end(), 0);
+      saveTo(full_db_name, all_inputs);
+      return true;
+    }
+
+    // Every blob goes, the largest first, to the shard with the fewest bytes
+    // so far. Load expects all the chunks of a blob in the same db.
+    std::vector<std::pair<size_t, int>> input_bytes;
+    for (int i = 0; i < inputs.size(); ++i) {
+      size_t bytes = 0;
+      if (inputs[i]->template IsType<Tensor<Context>>()) {
+        bytes = inputs[i]->template Get<Tensor<Context>>().nbytes();
+      }
+      input_bytes.emplace_back(bytes, i);
+    }
+    std::sort(input_bytes.rbegin(), input_bytes.rend());
+    std::vector<std::vector<int>> shard_inputs(num_shards_);
+    std::vector<size_t> shard_bytes(num_shards_, 0);
+    for (const auto& entry : input_bytes) {
+      auto shard =
+          std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+          shard_bytes.begin();
+      shard_inputs[shard].push_back(entry.second);
+      shard_bytes[shard] += entry.first;
+    }
+
+    std::vector<std::future<void>> futures;
+    for (int shard = 0; shard < num_shards_; ++shard) {
+      futures.push_back(std::async(ShardLaunchPolicy(), [&, shard]() {
+        saveTo(ShardDBName(full_db_name, shard), shard_inputs[shard]);
+      }));
+    }
+    for (auto& future : futures) {
+      future.get();
+    }
+
+    // The manifest is written last, so that a checkpoint interrupted while
+    // saving the shards can't be loaded.
+    std::unique_ptr<DB> manifest_db(
+        caffe2::db::CreateDB(db_type_, full_db_name, caffe2::db::NEW));
+    CAFFE_ENFORCE(
+        manifest_db.get(), "Cannot open db for writing: ", full_db_name);
+    auto transaction = manifest_db->NewTransaction();
+    transaction->Put(kShardManifestKey, caffe2::to_string(num_shards_));
+    transaction->Commit();
+    manifest_db->Close();
+    return true;
+  }
+
+ private:
+  void saveTo(const string& full_db_name, const std::vector<int>& indices) {
     std::unique_ptr<DB> out_db(
         caffe2::db::CreateDB(db_type_, full_db_name, caffe2::db::NEW));
     CAFFE_ENFORCE(out_db.get(), "Cannot open db for writing: ", full_db_name);
@@ -470,19 +597,18 @@ class SaveOp final : public Operator<Context> {
     };
 
     const vector<const Blob*>& inputs = OperatorBase::Inputs();
-    for (int i = 0; i < inputs.size(); ++i) {
+    for (int i : indices) {
       inputs[i]->Serialize(blob_names_[i], acceptor);
     }
     out_db->Close();
-    return true;
   }
 
- private:
   Workspace* ws_;
   bool absolute_path_;
   string strip_prefix_;
   string db_name_;
   string db_type_;
+  int num_shards_;
   std::vector<std::string> blob_names_;
 };
 
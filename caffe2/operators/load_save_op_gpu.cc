@@ -8,7 +8,9 @@ void LoadOp<CUDAContext>::SetCurrentDevice(BlobProto* proto) {
   if (proto->has_tensor()) {
     auto* device_detail = proto->mutable_tensor()->mutable_device_detail();
     device_detail->set_device_type(CUDA);
-    device_detail->set_cuda_gpu_id(CaffeCudaGetDevice());
+    // Uses the device of the op rather than the current one, as the dbs may
+    // be read on other threads.
+    device_detail->set_cuda_gpu_id(context_.cuda_gpu_id());
   }
 }
 
@@ -9,6 +9,8 @@
 #include "caffe2/operators/conv_pool_op_base.h"
 #include "caffe2/operators/locally_connected_op_util.h"
 
+CAFFE2_DECLARE_bool(caffe2_force_shared_col_buffer);
+
 namespace caffe2 {
 
 template <typename T, class Context>
@@ -23,6 +25,9 @@ class LocallyConnectedOp final : public ConvPoolOpBase<Context> {
     CAFFE_ENFORCE(
         group_ == 1 || order_ == StorageOrder::NCHW,
         "Group locally connected only supports NCHW order right now.");
+    if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+      createSharedBuffer<Context>(ws_);
+    }
   }
 
   ~LocallyConnectedOp() = default;
@@ -100,6 +105,9 @@ class LocallyConnectedGradientOp final : public ConvPoolOpBase<Context> {
     CAFFE_ENFORCE(
         group_ == 1 || order_ == StorageOrder::NCHW,
         "Group locally connected only supports NCHW order right now.");
+    if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+      createSharedBuffer<Context>(ws_);
+    }
   }
 
   ~LocallyConnectedGradientOp() = default;
@@ -85,13 +85,17 @@ bool LocallyConnectedOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   }
   T* Y_data = Y->template mutable_data<T>();
 
+  Tensor<Context>* column_buffer = &column_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    column_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
   RunOnDeviceWithOrderNCHWImpl(
       shape,
       X_data,
       filter_data,
       bias_data,
       Y_data,
-      &column_buffer_,
+      column_buffer,
       &column_transposed_buffer_,
       &Y_transposed_buffer_);
 
@@ -153,13 +157,17 @@ bool LocallyConnectedOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   }
   T* Y_data = Y->template mutable_data<T>();
 
+  Tensor<Context>* column_buffer = &column_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    column_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
   RunOnDeviceWithOrderNHWCImpl(
       shape,
       X_data,
       filter_data,
       bias_data,
       Y_data,
-      &column_buffer_,
+      column_buffer,
       &column_transposed_buffer_,
       &Y_transposed_buffer_);
 
@@ -464,6 +472,10 @@ bool LocallyConnectedGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
         shape.N, &bias_multiplier_);
     dbias_data = dbias->template mutable_data<T>();
   }
+  Tensor<Context>* column_buffer = &column_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    column_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
   RunOnDeviceWithOrderNCHWImpl(
       shape,
       X_data,
@@ -472,7 +484,7 @@ bool LocallyConnectedGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
       dfilter_data,
       dX_data,
       dbias_data,
-      &column_buffer_,
+      column_buffer,
       &column_transposed_buffer_,
       &dY_transposed_buffer_);
 
@@ -540,6 +552,10 @@ bool LocallyConnectedGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
         shape.N, &bias_multiplier_);
     dbias_data = dbias->template mutable_data<T>();
   }
+  Tensor<Context>* column_buffer = &column_buffer_;
+  if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
+    column_buffer = getSharedBuffer<Context>(ws_, &context_);
+  }
   RunOnDeviceWithOrderNHWCImpl(
       shape,
       X_data,
@@ -548,7 +564,7 @@ bool LocallyConnectedGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
       dfilter_data,
       dX_data,
       dbias_data,
-      &column_buffer_,
+      column_buffer,
       &column_transposed_buffer_,
       &dY_transposed_buffer_);
 
@@ -0,0 +1,148 @@
+#include "caffe2/operators/loss_scale_ops.h"
+
+#include <cmath>
+
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Y = X / scale, returning whether all of X is finite
+template <typename T>
+bool Unscale(const int N, const float scale, const T* X, T* Y) {
+  const float inv_scale = 1.0f / scale;
+  bool finite = true;
+  for (int i = 0; i < N; ++i) {
+    const float x = convert::To<T, float>(X[i]);
+    finite &= std::isfinite(x);
+    Y[i] = convert::To<float, T>(x * inv_scale);
+  }
+  return finite;
+}
+
+} // namespace
+
+template <>
+bool UnscaleGradientsOp<CPUContext>::RunOnDevice() {
+  auto& scale = Input(0);
+  CAFFE_ENFORCE_EQ(scale.size(), 1, "The loss scale must have 1 element");
+  const float scale_value = scale.data<float>()[0];
+  bool finite = true;
+  for (int i = 1; i < InputSize(); ++i) {
+    auto& X = Input(i);
+    auto* Y = Output(i - 1);
+    Y->ResizeLike(X);
+    if (X.IsType<float>()) {
+      finite &= Unscale<float>(
+          X.size(), scale_value, X.data<float>(), Y->mutable_data<float>());
+    } else if (X.IsType<float16>()) {
+      finite &= Unscale<float16>(
+          X.size(), scale_value, X.data<float16>(), Y->mutable_data<float16>());
+    } else {
+      CAFFE_THROW(
+          "UnscaleGradients only supports float and float16 gradients, got ",
+          X.meta().name());
+    }
+  }
+  if (!finite) {
+    for (int i = 0; i < OutputSize() - 1; ++i) {
+      auto* Y = Output(i);
+      if (Y->IsType<float>()) {
+        math::Set<float, CPUContext>(
+            Y->size(), 0.0f, Y->mutable_data<float>(), &context_);
+      } else {
+        math::Set<float16, CPUContext>(
+            Y->size(),
+            convert::To<float, float16>(0.0f),
+            Y->mutable_data<float16>(),
+            &context_);
+      }
+    }
+  }
+  auto* found_inf = Output(OutputSize() - 1);
+  found_inf->Resize(1);
+  found_inf->mutable_data<bool>()[0] = !finite;
+  return true;
+}
+
+template <>
+bool UpdateLossScaleOp<CPUContext>::RunOnDevice() {
+  auto& scale = Input(SCALE);
+  auto& found_inf = Input(FOUND_INF);
+  auto& good_steps = Input(GOOD_STEPS);
+  CAFFE_ENFORCE_EQ(scale.size(), 1);
+  CAFFE_ENFORCE_EQ(found_inf.size(), 1);
+  CAFFE_ENFORCE_EQ(good_steps.size(), 1);
+  float* scale_value = Output(OUTPUT_SCALE)->mutable_data<float>();
+  int64_t* steps = Output(OUTPUT_GOOD_STEPS)->mutable_data<int64_t>();
+  if (found_inf.data<bool>()[0]) {
+    *scale_value *= backoff_factor_;
+    *steps = 0;
+  } else if (++*steps == growth_interval_) {
+    *scale_value *= growth_factor_;
+    *steps = 0;
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(UnscaleGradients, UnscaleGradientsOp<CPUContext>);
+REGISTER_CPU_OPERATOR(UpdateLossScale, UpdateLossScaleOp<CPUContext>);
+
+OPERATOR_SCHEMA(UnscaleGradients)
+    .NumInputs(2, INT_MAX)
+    .NumOutputs(2, INT_MAX)
+    .NumInputsOutputs([](int in, int out) { return in == out; })
+    .AllowInplace([](int in, int out) { return in == out + 1; })
+    .SetDoc(R"DOC(
+Divides the gradients of a loss multiplied by a loss scale (as done in mixed
+precision training, so that the small float16 gradients don't flush to zero)
+by that loss scale. The gradients may be float or float16 ones, which are
+divided in float.
+
+If any of the gradients has an infinite or NaN element, all the gradients are
+set to zero and found_inf is true: the update that follows doesn't change the
+parameters (apart from momentum or weight decay terms) and UpdateLossScale
+lowers the scale for the next iteration.
+)DOC")
+    .Input(0, "scale", "The loss scale, a float tensor of 1 element")
+    .Input(1, "grad_1", "The first gradient, and so on for the next inputs")
+    .Output(0, "output_grad_1", "The first unscaled gradient (can be grad_1)")
+    .Output(
+        1,
+        "found_inf",
+        "The last output: a bool tensor of 1 element, true if one of the "
+        "gradients isn't finite");
+
+OPERATOR_SCHEMA(UpdateLossScale)
+    .NumInputs(3)
+    .NumOutputs(2)
+    .EnforceInplace({{0, 0}, {2, 1}})
+    .SetDoc(R"DOC(
+Updates the dynamic loss scale of mixed precision training from the found_inf
+output of UnscaleGradients. The scale is multiplied by backoff_factor when
+found_inf is true, and by growth_factor once growth_interval iterations in a
+row had finite gradients. The update runs on the device of the operator, so
+that the training loop doesn't wait for found_inf.
+)DOC")
+    .Arg("growth_factor", "(float, default 2) Scale growth factor")
+    .Arg("backoff_factor", "(float, default 0.5) Scale factor on overflows")
+    .Arg(
+        "growth_interval",
+        "(int, default 2000) Iterations with finite gradients before the "
+        "scale grows")
+    .Input(0, "scale", "The float loss scale, updated in place")
+    .Input(1, "found_inf", "The found_inf output of UnscaleGradients")
+    .Input(
+        2,
+        "num_good_steps",
+        "An int64 tensor of 1 element counting the iterations since the last "
+        "change of the scale, updated in place")
+    .Output(0, "output_scale", "The updated scale")
+    .Output(1, "output_num_good_steps", "The updated count");
+
+SHOULD_NOT_DO_GRADIENT(UnscaleGradients);
+SHOULD_NOT_DO_GRADIENT(UpdateLossScale);
+
+} // namespace caffe2
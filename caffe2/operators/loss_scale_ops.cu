@@ -0,0 +1,138 @@
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/loss_scale_ops.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+template <typename T>
+__global__ void UnscaleKernel(
+    const int N,
+    const float* scale,
+    const T* X,
+    T* Y,
+    bool* found_inf) {
+  const float inv_scale = 1.0f / *scale;
+  CUDA_1D_KERNEL_LOOP(i, N) {
+    const float x = convert::To<T, float>(X[i]);
+    if (!isfinite(x)) {
+      *found_inf = true;
+    }
+    Y[i] = convert::To<float, T>(x * inv_scale);
+  }
+}
+
+template <typename T>
+__global__ void ZeroIfFoundInfKernel(const int N, const bool* found_inf, T* Y) {
+  if (!*found_inf) {
+    return;
+  }
+  CUDA_1D_KERNEL_LOOP(i, N) {
+    Y[i] = convert::To<float, T>(0.0f);
+  }
+}
+
+__global__ void UpdateLossScaleKernel(
+    const bool* found_inf,
+    const float growth_factor,
+    const float backoff_factor,
+    const int64_t growth_interval,
+    float* scale,
+    int64_t* steps) {
+  if (*found_inf) {
+    *scale *= backoff_factor;
+    *steps = 0;
+  } else if (++*steps == growth_interval) {
+    *scale *= growth_factor;
+    *steps = 0;
+  }
+}
+
+template <typename T>
+void Unscale(
+    const float* scale,
+    const Tensor<CUDAContext>& X,
+    Tensor<CUDAContext>* Y,
+    bool* found_inf,
+    CUDAContext* context) {
+  UnscaleKernel<T><<<
+      CAFFE_GET_BLOCKS(X.size()),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context->cuda_stream()>>>(
+      X.size(), scale, X.data<T>(), Y->mutable_data<T>(), found_inf);
+}
+
+template <typename T>
+void ZeroIfFoundInf(
+    const bool* found_inf,
+    Tensor<CUDAContext>* Y,
+    CUDAContext* context) {
+  ZeroIfFoundInfKernel<T><<<
+      CAFFE_GET_BLOCKS(Y->size()),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context->cuda_stream()>>>(Y->size(), found_inf, Y->mutable_data<T>());
+}
+
+} // namespace
+
+template <>
+bool UnscaleGradientsOp<CUDAContext>::RunOnDevice() {
+  auto& scale = Input(0);
+  CAFFE_ENFORCE_EQ(scale.size(), 1, "The loss scale must have 1 element");
+  auto* found_inf = Output(OutputSize() - 1);
+  found_inf->Resize(1);
+  bool* found_inf_data = found_inf->mutable_data<bool>();
+  math::Set<bool, CUDAContext>(1, false, found_inf_data, &context_);
+  // found_inf stays on the device: the gradients are zeroed by a second pass
+  // of kernels that read it
+  for (int i = 1; i < InputSize(); ++i) {
+    auto& X = Input(i);
+    auto* Y = Output(i - 1);
+    Y->ResizeLike(X);
+    if (X.IsType<float>()) {
+      Unscale<float>(scale.data<float>(), X, Y, found_inf_data, &context_);
+    } else if (X.IsType<float16>()) {
+      Unscale<float16>(scale.data<float>(), X, Y, found_inf_data, &context_);
+    } else {
+      CAFFE_THROW(
+          "UnscaleGradients only supports float and float16 gradients, got ",
+          X.meta().name());
+    }
+  }
+  for (int i = 0; i < OutputSize() - 1; ++i) {
+    auto* Y = Output(i);
+    if (Y->IsType<float>()) {
+      ZeroIfFoundInf<float>(found_inf_data, Y, &context_);
+    } else {
+      ZeroIfFoundInf<float16>(found_inf_data, Y, &context_);
+    }
+  }
+  return true;
+}
+
+template <>
+bool UpdateLossScaleOp<CUDAContext>::RunOnDevice() {
+  auto& scale = Input(SCALE);
+  auto& found_inf = Input(FOUND_INF);
+  auto& good_steps = Input(GOOD_STEPS);
+  CAFFE_ENFORCE_EQ(scale.size(), 1);
+  CAFFE_ENFORCE_EQ(found_inf.size(), 1);
+  CAFFE_ENFORCE_EQ(good_steps.size(), 1);
+  UpdateLossScaleKernel<<<1, 1, 0, context_.cuda_stream()>>>(
+      found_inf.data<bool>(),
+      growth_factor_,
+      backoff_factor_,
+      growth_interval_,
+      Output(OUTPUT_SCALE)->mutable_data<float>(),
+      Output(OUTPUT_GOOD_STEPS)->mutable_data<int64_t>());
+  return true;
+}
+
+REGISTER_CUDA_OPERATOR(UnscaleGradients, UnscaleGradientsOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(UpdateLossScale, UpdateLossScaleOp<CUDAContext>);
+
+} // namespace caffe2
@@ -0,0 +1,55 @@
+#ifndef CAFFE2_OPERATORS_LOSS_SCALE_OPS_H_
+#define CAFFE2_OPERATORS_LOSS_SCALE_OPS_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+// Divides the float or float16 gradients of a scaled loss by the loss scale,
+// and tells if any of them isn't finite. The gradients are zeroed then, so
+// that the update which follows doesn't apply them.
+template <class Context>
+class UnscaleGradientsOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(UnscaleGradientsOp);
+
+  bool RunOnDevice() override;
+};
+
+// Updates the loss scale from the output of UnscaleGradients: the scale is
+// multiplied by backoff_factor after a step with non finite gradients, and by
+// growth_factor after growth_interval steps without any.
+template <class Context>
+class UpdateLossScaleOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  UpdateLossScaleOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        growth_factor_(
+            OperatorBase::GetSingleArgument<float>("growth_factor", 2.0f)),
+        backoff_factor_(
+            OperatorBase::GetSingleArgument<float>("backoff_factor", 0.5f)),
+        growth_interval_(OperatorBase::GetSingleArgument<int64_t>(
+            "growth_interval",
+            2000)) {
+    CAFFE_ENFORCE_GT(growth_factor_, 0);
+    CAFFE_ENFORCE_GT(backoff_factor_, 0);
+    CAFFE_ENFORCE_GT(growth_interval_, 0);
+  }
+
+  bool RunOnDevice() override;
+
+ protected:
+  float growth_factor_;
+  float backoff_factor_;
+  int64_t growth_interval_;
+
+  INPUT_TAGS(SCALE, FOUND_INF, GOOD_STEPS);
+  OUTPUT_TAGS(OUTPUT_SCALE, OUTPUT_GOOD_STEPS);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_LOSS_SCALE_OPS_H_
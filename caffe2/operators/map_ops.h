@@ -5,13 +5,13 @@
 #include <iterator>
 #include <string>
 #include <typeinfo>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/utils/concurrent_int_map.h"
 
 namespace caffe2 {
 
@@ -30,9 +30,12 @@ struct TypeNameTraits<int32_t> {
   static constexpr const char* name = "int32_t";
 };
 
+// The maps are ConcurrentIntMaps, which many threads can look up without
+// locking. They are serialized with the type name of the std::unordered_map
+// they replaced, so that saved maps still load.
 template <typename KEY_T, typename VALUE_T>
 struct MapTypeTraits {
-  using MapType = std::unordered_map<KEY_T, VALUE_T>;
+  using MapType = ConcurrentIntMap<KEY_T, VALUE_T>;
   static string MapTypeName() {
     return string("(std::unordered_map<") + TypeNameTraits<KEY_T>::name + ", " +
         TypeNameTraits<VALUE_T>::name + ">)";
@@ -129,7 +132,7 @@ class KeyValueToMapOp final : public Operator<Context> {
     auto* map_data = OperatorBase::Output<MapType>(MAP);
 
     for (int i = 0; i < key_input.size(); ++i) {
-      map_data->emplace(key_data[i], value_data[i]);
+      map_data->Insert(key_data[i], value_data[i]);
     }
 
     return true;
@@ -175,12 +178,10 @@ class MapToKeyValueOp final : public Operator<Context> {
     auto* key_data = key_output->template mutable_data<key_type>();
     auto* value_data = value_output->template mutable_data<mapped_type>();
 
-    for (const auto& it : map_data) {
-      *key_data = it.first;
-      *value_data = it.second;
-      key_data++;
-      value_data++;
-    }
+    map_data.ForEach([&](key_type key, mapped_type value) {
+      *key_data++ = key;
+      *value_data++ = value;
+    });
 
     return true;
   }
@@ -207,12 +208,10 @@ class MapSerializer : public BlobSerializerBase {
     value_tensor.Resize(sz);
     auto* key_data = key_tensor.mutable_data<KEY_T>();
     auto* value_data = value_tensor.mutable_data<VALUE_T>();
-    for (const auto& it : map_data) {
-      *key_data = it.first;
-      *value_data = it.second;
-      key_data++;
-      value_data++;
-    }
+    map_data.ForEach([&](KEY_T key, VALUE_T value) {
+      *key_data++ = key;
+      *value_data++ = value;
+    });
 
     TensorProtos tensor_protos;
     TensorSerializer<CPUContext> ser;
@@ -248,7 +247,7 @@ class MapDeserializer : public BlobDeserializerBase {
 
     auto* map_ptr = blob->template GetMutable<MapType>();
     for (int i = 0; i < key_tensor.size(); ++i) {
-      map_ptr->emplace(key_data[i], value_data[i]);
+      map_ptr->Insert(key_data[i], value_data[i]);
     }
   }
 };
@@ -0,0 +1,214 @@
+#include "caffe2/operators/max_inner_product_top_k_op.h"
+
+#include <algorithm>
+
+#include "caffe2/core/common_omp.h"
+#include "caffe2/core/types.h"
+#include "caffe2/operators/fused_rowwise_8bit_conversion_ops.h"
+#include "caffe2/perfkernels/half_float_convert.h"
+#include "caffe2/perfkernels/threshold_filter.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+bool ScoreComp(
+    const std::pair<float, TIndex>& lhs,
+    const std::pair<float, TIndex>& rhs) {
+  return lhs.first > rhs.first ||
+      (lhs.first == rhs.first && lhs.second < rhs.second);
+}
+
+// Scores are filtered in chunks of this many, so that the threshold rises
+// between chunks.
+constexpr TIndex kFilterChunkSize = 256;
+
+} // namespace
+
+void TopKAccumulator::Add(
+    const float* scores,
+    const TIndex n,
+    const TIndex first_index) {
+  TIndex i = 0;
+  for (; !full_ && i < n; ++i) {
+    candidates_.emplace_back(scores[i], first_index + i);
+    if (candidates_.size() == static_cast<size_t>(k_)) {
+      Prune();
+    }
+  }
+  // A later score equal to the threshold ranks below the candidates that
+  // set it, so strictly greater is enough.
+  const size_t max_candidates = std::max<TIndex>(2 * k_, 64);
+  passed_.resize(kFilterChunkSize);
+  for (; i < n; i += kFilterChunkSize) {
+    const TIndex count = FilterGreaterThan(
+        scores + i,
+        std::min(kFilterChunkSize, n - i),
+        threshold_,
+        passed_.data());
+    for (TIndex j = 0; j < count; ++j) {
+      candidates_.emplace_back(
+          scores[i + passed_[j]], first_index + i + passed_[j]);
+    }
+    if (candidates_.size() > max_candidates) {
+      Prune();
+    }
+  }
+}
+
+void TopKAccumulator::Prune() {
+  std::nth_element(
+      candidates_.begin(),
+      candidates_.begin() + k_ - 1,
+      candidates_.end(),
+      ScoreComp);
+  candidates_.resize(k_);
+  threshold_ = candidates_[k_ - 1].first;
+  full_ = true;
+}
+
+TIndex TopKAccumulator::Finish(float* values, TIndex* indices) {
+  if (candidates_.size() > static_cast<size_t>(k_)) {
+    Prune();
+  }
+  std::sort(candidates_.begin(), candidates_.end(), ScoreComp);
+  for (size_t i = 0; i < candidates_.size(); ++i) {
+    values[i] = candidates_[i].first;
+    indices[i] = candidates_[i].second;
+  }
+  return candidates_.size();
+}
+
+template <>
+const float* MaxInnerProductTopKOp<CPUContext>::ItemBlock(
+    const TensorCPU& items,
+    const TIndex begin,
+    const TIndex end,
+    const TIndex dim) {
+  if (items.IsType<float>()) {
+    return items.data<float>() + begin * dim;
+  }
+  items_block_.Resize(end - begin, dim);
+  float* block = items_block_.mutable_data<float>();
+  if (items.IsType<float16>()) {
+    Float16ToFloat(
+        (end - begin) * dim, items.data<float16>() + begin * dim, block);
+  } else {
+    Fused8BitRowwiseQuantizedToFloat(
+        items.data<uint8_t>() + begin * items.dim(1),
+        end - begin,
+        items.dim(1),
+        block);
+  }
+  return block;
+}
+
+template <>
+bool MaxInnerProductTopKOp<CPUContext>::RunOnDevice() {
+  const auto& queries = Input(QUERIES);
+  const auto& items = Input(ITEMS);
+  CAFFE_ENFORCE_EQ(queries.ndim(), 2, "queries must be a matrix");
+  CAFFE_ENFORCE_EQ(items.ndim(), 2, "items must be a matrix");
+  CAFFE_ENFORCE(
+      items.IsType<float>() || items.IsType<float16>() ||
+          items.IsType<uint8_t>(),
+      "items must be float, float16, or fused 8-bit rowwise quantized");
+  const TIndex num_queries = queries.dim(0);
+  const TIndex dim = queries.dim(1);
+  const TIndex num_items = items.dim(0);
+  CAFFE_ENFORCE_EQ(
+      items.IsType<uint8_t>() ? items.dim(1) - 8 : items.dim(1),
+      dim,
+      "queries and items must have the same dimension");
+  CAFFE_ENFORCE_LE(k_, num_items, "k should not be greater than the items");
+
+  auto* values = Output(VALUES);
+  auto* indices = Output(INDICES);
+  values->Resize(num_queries, k_);
+  indices->Resize(num_queries, k_);
+  float* values_data = values->mutable_data<float>();
+  TIndex* indices_data = indices->mutable_data<TIndex>();
+  if (num_queries == 0) {
+    return true;
+  }
+
+  const float* queries_data = queries.data<float>();
+  std::vector<TopKAccumulator> top(num_queries, TopKAccumulator(k_));
+  for (TIndex begin = 0; begin < num_items; begin += block_size_) {
+    const TIndex end = std::min<TIndex>(begin + block_size_, num_items);
+    const TIndex block_items = end - begin;
+    const float* block = ItemBlock(items, begin, end, dim);
+    scores_.Resize(num_queries, block_items);
+    float* scores = scores_.mutable_data<float>();
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasTrans,
+        num_queries,
+        block_items,
+        dim,
+        1,
+        queries_data,
+        block,
+        0,
+        scores,
+        &context_);
+#pragma omp parallel for if (num_queries > 1)
+    for (TIndex q = 0; q < num_queries; ++q) {
+      top[q].Add(scores + q * block_items, block_items, begin);
+    }
+  }
+  for (TIndex q = 0; q < num_queries; ++q) {
+    top[q].Finish(values_data + q * k_, indices_data + q * k_);
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    MaxInnerProductTopK,
+    MaxInnerProductTopKOp<CPUContext>);
+
+OPERATOR_SCHEMA(MaxInnerProductTopK)
+    .NumInputs(2)
+    .NumOutputs(2)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      ArgumentHelper helper(def);
+      const int k = helper.GetSingleArgument("k", -1);
+      vector<TensorShape> out(2);
+      out[0] = CreateTensorShape(
+          vector<TIndex>{in[0].dims(0), k}, TensorProto_DataType_FLOAT);
+      out[1] = CreateTensorShape(
+          vector<TIndex>{in[0].dims(0), k}, TensorProto_DataType_INT64);
+      return out;
+    })
+    .SetDoc(R"DOC(
+For each query, finds the k items with the largest inner products with it,
+i.e. TopK(FC(queries, items)), without materializing the scores of all the
+items: the items are scored a block at a time and each query keeps a running
+top k, so that only a [num_queries, block_size] block of scores is ever
+allocated. Given equal scores, the item with the lower index comes first.
+
+The item table can be stored in float, float16, or in the fused 8-bit rowwise
+quantized format of FloatToFused8BitRowwiseQuantized, in which case the items
+are scored as de-quantized by Fused8BitRowwiseQuantizedToFloat.
+)DOC")
+    .Arg("k", "Number of items to retrieve per query")
+    .Arg(
+        "block_size",
+        "Number of items scored at a time (default 1024)")
+    .Input(0, "queries", "[num_queries, dim] float queries")
+    .Input(
+        1,
+        "items",
+        "[num_items, dim] float or float16 items, or [num_items, dim + 8] "
+        "fused 8-bit rowwise quantized items")
+    .Output(
+        0,
+        "values",
+        "[num_queries, k] greatest inner products, in decreasing order")
+    .Output(1, "indices", "[num_queries, k] indices of the items");
+
+NO_GRADIENT(MaxInnerProductTopK);
+
+} // namespace caffe2
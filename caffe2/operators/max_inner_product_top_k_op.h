@@ -0,0 +1,85 @@
+#ifndef CAFFE2_OPERATORS_MAX_INNER_PRODUCT_TOP_K_OP_H_
+#define CAFFE2_OPERATORS_MAX_INNER_PRODUCT_TOP_K_OP_H_
+
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+/**
+ * The k greatest of a stream of scores, ties going to the lower index.
+ *
+ * Scores are added in increasing index order. Once k are known, only the
+ * scores greater than the k-th greatest so far are kept, and the kept ones
+ * are cut back to k whenever too many pile up.
+ */
+class TopKAccumulator {
+ public:
+  explicit TopKAccumulator(TIndex k) : k_(k) {}
+
+  // Adds scores[i] for the indices first_index + i, i < n.
+  void Add(const float* scores, TIndex n, TIndex first_index);
+
+  // Writes the (at most k) greatest scores and their indices, greatest first.
+  // Returns how many were written.
+  TIndex Finish(float* values, TIndex* indices);
+
+ private:
+  void Prune();
+
+  const TIndex k_;
+  float threshold_ = 0;
+  bool full_ = false;
+  std::vector<std::pair<float, TIndex>> candidates_;
+  std::vector<TIndex> passed_;
+};
+
+/**
+ * Exact k maximum inner products between queries and a table of items,
+ * without materializing the [queries, items] scores: the table is scored a
+ * block of items at a time with a GEMM, and each query keeps a running top k.
+ *
+ * The table can be float, float16, or in the fused 8-bit rowwise format of
+ * FloatToFused8BitRowwiseQuantized; compressed blocks are converted to float
+ * before scoring.
+ */
+template <class Context>
+class MaxInnerProductTopKOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  MaxInnerProductTopKOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        OP_SINGLE_ARG(int, "k", k_, -1),
+        OP_SINGLE_ARG(int, "block_size", block_size_, 1024) {
+    CAFFE_ENFORCE(k_ >= 1, "k argument must be >= 1");
+    CAFFE_ENFORCE(block_size_ >= 1, "block_size argument must be >= 1");
+  }
+
+  bool RunOnDevice() override;
+
+ private:
+  INPUT_TAGS(QUERIES, ITEMS);
+  OUTPUT_TAGS(VALUES, INDICES);
+
+  // Converts items [begin, end) of the table to rows of dim floats, or
+  // returns them directly if they already are.
+  const float* ItemBlock(
+      const Tensor<Context>& items,
+      TIndex begin,
+      TIndex end,
+      TIndex dim);
+
+  const int k_;
+  const int block_size_;
+  Tensor<Context> items_block_;
+  Tensor<Context> scores_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_MAX_INNER_PRODUCT_TOP_K_OP_H_
@@ -21,6 +21,13 @@ namespace caffe2 {
  *
  * All the input and output of the original operator should be TensorCPU.
  *
+ * The CPU copies of the inputs and outputs live in a local workspace and are
+ * kept across runs, so their (pinned, once CUDA is initialized) memory is
+ * reused. Copies in both directions are issued asynchronously on the op's
+ * stream: the inputs are waited for once before running the CPU op, and the
+ * outputs are only waited for before the CPU copies are overwritten by the
+ * next run.
+ *
  * Example usage: if you have a class MyMagicOp that is CPU based, and you use
  * the registration code
  *     REGISTER_CPU_OPERATOR(MyMagic, MyMagicOp);
@@ -57,9 +64,23 @@ class GPUFallbackOp final : public Operator<CUDAContext> {
       local_output_blobs_.push_back(local_ws_.GetBlob(name));
       CHECK_NOTNULL(local_output_blobs_.back());
     }
+    DeviceGuard g(context_.cuda_gpu_id());
+    CUDA_ENFORCE(cudaEventCreateWithFlags(
+        &output_copies_done_, cudaEventDisableTiming));
+  }
+
+  ~GPUFallbackOp() {
+    DeviceGuard g(context_.cuda_gpu_id());
+    CUDA_CHECK(cudaEventDestroy(output_copies_done_));
   }
 
   bool RunOnDevice() override {
+    // The copies of the previous run's outputs may still be reading the local
+    // blobs, which are about to be overwritten.
+    if (output_copies_pending_) {
+      CUDA_ENFORCE(cudaEventSynchronize(output_copies_done_));
+      output_copies_pending_ = false;
+    }
     bool need_sync = false;
     for (int i = 0; i < InputSize(); ++i) {
       if (OperatorBase::InputIsType<TensorCUDA>(i)) {
@@ -98,6 +119,11 @@ class GPUFallbackOp final : public Operator<CUDAContext> {
           "output type who needs copying.");
       Output(i)->CopyFrom(
           local_output_blobs_[i]->template Get<TensorCPU>(), &context_);
+      output_copies_pending_ = true;
+    }
+    if (output_copies_pending_) {
+      CUDA_ENFORCE(
+          cudaEventRecord(output_copies_done_, context_.cuda_stream()));
     }
     return true;
   }
@@ -107,6 +133,8 @@ class GPUFallbackOp final : public Operator<CUDAContext> {
   vector<Blob*> local_input_blobs_;
   vector<Blob*> local_output_blobs_;
   std::unique_ptr<CPUOp> base_op_;
+  cudaEvent_t output_copies_done_;
+  bool output_copies_pending_ = false;
 };
 
 } // namespace caffe2
@@ -79,4 +79,32 @@ TEST(OperatorFallbackTest, GPUIncrementByOneOp) {
   }
 }
 
+TEST(OperatorFallbackTest, GPUIncrementByOneOpRepeated) {
+  if (!HasCudaGPU()) return;
+  OperatorDef op_def = CreateOperatorDef(
+      "IncrementByOne", "", vector<string>{"X"},
+      vector<string>{"X"});
+  op_def.mutable_device_option()->set_device_type(CUDA);
+  Workspace ws;
+  TensorCPU source_tensor(vector<TIndex>{1000});
+  for (int i = 0; i < 1000; ++i) {
+    source_tensor.mutable_data<float>()[i] = i;
+  }
+  ws.CreateBlob("X")->GetMutable<TensorCUDA>()->CopyFrom(source_tensor);
+  unique_ptr<OperatorBase> op(CreateOperator(op_def, &ws));
+  EXPECT_TRUE(op.get() != nullptr);
+  // The local CPU buffers are reused, so every run has to see the output
+  // of the previous one.
+  for (int iter = 0; iter < 5; ++iter) {
+    EXPECT_TRUE(op->RunAsync());
+  }
+  op->Finish();
+  const TensorCUDA& output = ws.GetBlob("X")->Get<TensorCUDA>();
+  TensorCPU output_cpu(output);
+  EXPECT_EQ(output.size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(output_cpu.data<float>()[i], i + 5);
+  }
+}
+
 }  // namespace caffe2
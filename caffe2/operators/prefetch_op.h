@@ -17,6 +17,11 @@ namespace caffe2 {
 // For any operator that is derived from PrefetchOperator, it should
 // explicitly call the Finalize() function in its destructor, so that the
 // prefetching thread is properly destructed.
+//
+// On GPUs, the prefetching thread runs on its own streams (CUDAContext streams
+// are per thread), so the copies to the device done in Prefetch() overlap the
+// computation of the previous batch, and CopyPrefetched() should only copy
+// from device to device.
 
 // Note: We inherit from OperatorBase since we control the
 // synchronization properties of this operator ourselves (we inform
@@ -0,0 +1,21 @@
+#include "caffe2/operators/quantized/int8_add_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Add, int8::Int8AddOp);
+
+OPERATOR_SCHEMA(Int8Add)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}, {1, 0}})
+    .SetDoc(R"DOC(
+Elementwise sum of two uint8 Int8TensorCPUs of the same shape, which may
+have different scales and zero points. Broadcasting is not supported.
+)DOC")
+    .Arg("Y_scale", "Scale of the output, by default that of A")
+    .Arg("Y_zero_point", "Zero point of the output, by default that of A")
+    .Input(0, "A", "Int8TensorCPU")
+    .Input(1, "B", "Int8TensorCPU of the same shape as A")
+    .Output(0, "Y", "Int8TensorCPU sum");
+
+} // namespace caffe2
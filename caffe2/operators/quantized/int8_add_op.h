@@ -0,0 +1,51 @@
+#ifndef CAFFE2_OPERATORS_INT8_ADD_OP_H_
+#define CAFFE2_OPERATORS_INT8_ADD_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8AddOp final : public Operator<CPUContext> {
+ public:
+  Int8AddOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& A = OperatorBase::Input<Int8TensorCPU>(0);
+    const auto& B = OperatorBase::Input<Int8TensorCPU>(1);
+    CAFFE_ENFORCE(A.t.dims() == B.t.dims(), "Int8Add inputs must have the same shape");
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    // remember the input parameters, Y may be A or B
+    const float A_scale = A.scale;
+    const float B_scale = B.scale;
+    const int32_t A_zero_point = A.zero_point;
+    const int32_t B_zero_point = B.zero_point;
+    const uint8_t* A_data = A.t.data<uint8_t>();
+    const uint8_t* B_data = B.t.data<uint8_t>();
+    SetOutputQuantization(*this, A, Y);
+    Y->t.ResizeLike(A.t);
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+
+    const float a_multiplier = A_scale / Y->scale;
+    const float b_multiplier = B_scale / Y->scale;
+    for (TIndex i = 0; i < Y->t.size(); ++i) {
+      const float sum =
+          a_multiplier * (static_cast<int32_t>(A_data[i]) - A_zero_point) +
+          b_multiplier * (static_cast<int32_t>(B_data[i]) - B_zero_point);
+      Y_data[i] = Saturate(
+          Y->zero_point + static_cast<int32_t>(std::nearbyint(sum)));
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_ADD_OP_H_
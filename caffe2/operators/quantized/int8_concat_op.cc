@@ -0,0 +1,23 @@
+#include "caffe2/operators/quantized/int8_concat_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Concat, int8::Int8ConcatOp);
+
+OPERATOR_SCHEMA(Int8Concat)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Concatenates uint8 Int8TensorCPUs along an axis. Inputs quantized
+differently from the output are requantized.
+)DOC")
+    .Arg("axis", "Which axis to concat on, by default the channel axis of order")
+    .Arg("order", "Either NCHW or NHWC, used when axis is not set")
+    .Arg("Y_scale", "Scale of the output, by default that of the first input")
+    .Arg(
+        "Y_zero_point",
+        "Zero point of the output, by default that of the first input")
+    .Input(0, "X0", "First Int8TensorCPU")
+    .Output(0, "Y", "Concatenated Int8TensorCPU");
+
+} // namespace caffe2
@@ -0,0 +1,89 @@
+#ifndef CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
+
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8ConcatOp final : public Operator<CPUContext> {
+ public:
+  Int8ConcatOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {
+    if (OperatorBase::HasArgument("axis")) {
+      axis_ = OperatorBase::GetSingleArgument<int>("axis", -1);
+    } else {
+      axis_ = StringToStorageOrder(OperatorBase::GetSingleArgument<string>(
+                  "order", "NCHW")) == StorageOrder::NHWC
+          ? 3
+          : 1;
+    }
+  }
+
+  bool RunOnDevice() override {
+    const auto& X0 = OperatorBase::Input<Int8TensorCPU>(0);
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    SetOutputQuantization(*this, X0, Y);
+    const int axis = X0.t.canonical_axis_index(axis_);
+
+    vector<TIndex> Y_dims = X0.t.dims();
+    Y_dims[axis] = 0;
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& X = OperatorBase::Input<Int8TensorCPU>(i);
+      CAFFE_ENFORCE(&X != Y, "Int8Concat cannot run in place");
+      CAFFE_ENFORCE_EQ(X.t.ndim(), X0.t.ndim());
+      for (int d = 0; d < X.t.ndim(); ++d) {
+        if (d != axis) {
+          CAFFE_ENFORCE_EQ(X.t.dim(d), X0.t.dim(d), "dimension mismatch");
+        }
+      }
+      Y_dims[axis] += X.t.dim(axis);
+    }
+    Y->t.Resize(Y_dims);
+
+    const TIndex outer = Y->t.size_to_dim(axis);
+    const TIndex Y_inner = Y->t.size_from_dim(axis);
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    TIndex offset = 0;
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& X = OperatorBase::Input<Int8TensorCPU>(i);
+      const TIndex inner = X.t.size_from_dim(axis);
+      const uint8_t* X_data = X.t.data<uint8_t>();
+      // inputs that are quantized like the output are copied as they are
+      const bool same_quantization =
+          X.scale == Y->scale && X.zero_point == Y->zero_point;
+      const float multiplier = X.scale / Y->scale;
+      for (TIndex o = 0; o < outer; ++o) {
+        const uint8_t* src = X_data + o * inner;
+        uint8_t* dst = Y_data + o * Y_inner + offset;
+        if (same_quantization) {
+          std::memcpy(dst, src, inner);
+        } else {
+          for (TIndex j = 0; j < inner; ++j) {
+            dst[j] = Requantize(
+                static_cast<int32_t>(src[j]) - X.zero_point,
+                multiplier,
+                Y->zero_point);
+          }
+        }
+      }
+      offset += inner;
+    }
+    return true;
+  }
+
+ private:
+  int axis_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
@@ -0,0 +1,30 @@
+#include "caffe2/operators/quantized/int8_conv_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Conv, int8::Int8ConvOp);
+#ifdef __ARM_NEON__
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Int8Conv, NEON, int8::Int8ConvOp);
+#endif
+
+OPERATOR_SCHEMA(Int8Conv)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of Conv for 2D images in NCHW or NHWC order. X and W are
+uint8 Int8TensorCPUs, W of size M x C/group x kernel_h x kernel_w (NCHW)
+or M x kernel_h x kernel_w x C/group (NHWC), and b is an optional int32
+Int8TensorCPU of size M with zero point 0 and scale X.scale * W.scale.
+Takes the same kernel, stride, pad, dilation, group and order arguments
+as Conv. The products are accumulated in int32 and requantized to the
+output's scale and zero point. On ARM, the NEON engine computes them with
+NEON kernels.
+)DOC")
+    .Arg("Y_scale", "Scale of the output, by default that of X")
+    .Arg("Y_zero_point", "Zero point of the output, by default that of X")
+    .Input(0, "X", "Int8TensorCPU input")
+    .Input(1, "W", "Int8TensorCPU filters")
+    .Input(2, "b", "Optional int32 Int8TensorCPU bias of size M")
+    .Output(0, "Y", "Int8TensorCPU output");
+
+} // namespace caffe2
@@ -0,0 +1,218 @@
+#ifndef CAFFE2_OPERATORS_INT8_CONV_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONV_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/quantized/int8_neon.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+// 2D convolution of uint8 Int8TensorCPUs, as im2col followed by Int8Gemm for
+// every image and group. The columns are laid out like the weights of the
+// storage order, (C/G, kernel_h, kernel_w) for NCHW and (kernel_h,
+// kernel_w, C/G) for NHWC, so the weights are used as stored. Padding
+// is filled with the input zero point, i.e. with real zeros. Depthwise NHWC
+// convolutions (group == C == M) skip im2col and accumulate every kernel tap
+// over all the channels of a pixel at once.
+class Int8ConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8ConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        kernels_(Int8KernelsForEngine(operator_def.engine())) {
+    CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8Conv only supports 2D convolution");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    return RunOnDeviceWithOrder(StorageOrder::NCHW);
+  }
+  bool RunOnDeviceWithOrderNHWC() override {
+    return RunOnDeviceWithOrder(StorageOrder::NHWC);
+  }
+
+ private:
+  bool RunOnDeviceWithOrder(StorageOrder order) {
+    const auto& X = OperatorBase::Input<Int8TensorCPU>(0);
+    const auto& W = OperatorBase::Input<Int8TensorCPU>(1);
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(&X != Y, "Int8Conv cannot run in place");
+    SetOutputQuantization(*this, X, Y);
+    CAFFE_ENFORCE_EQ(X.t.ndim(), 4);
+    CAFFE_ENFORCE_EQ(W.t.ndim(), 4);
+
+    const bool nchw = order == StorageOrder::NCHW;
+    const int N = X.t.dim32(0);
+    const int C = nchw ? X.t.dim32(1) : X.t.dim32(3);
+    const int H = nchw ? X.t.dim32(2) : X.t.dim32(1);
+    const int W_in = nchw ? X.t.dim32(3) : X.t.dim32(2);
+    const int M = W.t.dim32(0);
+    CAFFE_ENFORCE_EQ(C % group_, 0);
+    CAFFE_ENFORCE_EQ(M % group_, 0);
+    const int C_group = C / group_;
+    const int M_group = M / group_;
+    if (nchw) {
+      CAFFE_ENFORCE_EQ(W.t.dim32(1), C_group);
+      CAFFE_ENFORCE_EQ(W.t.dim32(2), kernel_h());
+      CAFFE_ENFORCE_EQ(W.t.dim32(3), kernel_w());
+    } else {
+      CAFFE_ENFORCE_EQ(W.t.dim32(1), kernel_h());
+      CAFFE_ENFORCE_EQ(W.t.dim32(2), kernel_w());
+      CAFFE_ENFORCE_EQ(W.t.dim32(3), C_group);
+    }
+
+    const float acc_scale = X.scale * W.scale;
+    const int32_t* bias = InputSize() == 3
+        ? BiasData(OperatorBase::Input<Int8TensorCPU>(2), acc_scale, M)
+        : nullptr;
+
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), M);
+    const int out_h = nchw ? Y->t.dim32(2) : Y->t.dim32(1);
+    const int out_w = nchw ? Y->t.dim32(3) : Y->t.dim32(2);
+    if (!nchw && group_ == C && M == C) {
+      RunDepthwiseNHWC(X, W, bias, acc_scale, Y);
+      return true;
+    }
+    const int P = out_h * out_w;
+    const int K = C_group * kernel_h() * kernel_w();
+
+    cols_.Resize(P, K);
+    acc_.Resize(P, M_group);
+    const uint8_t* X_data = X.t.data<uint8_t>();
+    const uint8_t* W_data = W.t.data<uint8_t>();
+    uint8_t* cols = cols_.mutable_data<uint8_t>();
+    int32_t* acc = acc_.mutable_data<int32_t>();
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    const float multiplier = acc_scale / Y->scale;
+    const uint8_t pad_value = static_cast<uint8_t>(X.zero_point);
+
+    for (int n = 0; n < N; ++n) {
+      const uint8_t* image = X_data + n * C * H * W_in;
+      for (int g = 0; g < group_; ++g) {
+        // im2col for the channels [g * C_group, (g + 1) * C_group)
+        for (int oh = 0; oh < out_h; ++oh) {
+          for (int ow = 0; ow < out_w; ++ow) {
+            uint8_t* col = cols + (oh * out_w + ow) * K;
+            for (int kh = 0; kh < kernel_h(); ++kh) {
+              const int h = oh * stride_h() - pad_t() + kh * dilation_h();
+              for (int kw = 0; kw < kernel_w(); ++kw) {
+                const int w = ow * stride_w() - pad_l() + kw * dilation_w();
+                const bool inside = h >= 0 && h < H && w >= 0 && w < W_in;
+                for (int c = 0; c < C_group; ++c) {
+                  const int channel = g * C_group + c;
+                  const int k = nchw
+                      ? (c * kernel_h() + kh) * kernel_w() + kw
+                      : (kh * kernel_w() + kw) * C_group + c;
+                  col[k] = !inside ? pad_value
+                      : nchw ? image[(channel * H + h) * W_in + w]
+                             : image[(h * W_in + w) * C + channel];
+                }
+              }
+            }
+          }
+        }
+
+        kernels_.gemm(
+            P,
+            M_group,
+            K,
+            cols,
+            X.zero_point,
+            W_data + g * M_group * K,
+            W.zero_point,
+            bias ? bias + g * M_group : nullptr,
+            acc);
+
+        uint8_t* Y_image = Y_data + n * M * P;
+        for (int p = 0; p < P; ++p) {
+          for (int m = 0; m < M_group; ++m) {
+            const int channel = g * M_group + m;
+            const int index = nchw ? channel * P + p : p * M + channel;
+            Y_image[index] =
+                Requantize(acc[p * M_group + m], multiplier, Y->zero_point);
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  void RunDepthwiseNHWC(
+      const Int8TensorCPU& X,
+      const Int8TensorCPU& W,
+      const int32_t* bias,
+      float acc_scale,
+      Int8TensorCPU* Y) {
+    const int N = X.t.dim32(0);
+    const int H = X.t.dim32(1);
+    const int W_in = X.t.dim32(2);
+    const int C = X.t.dim32(3);
+    const int out_h = Y->t.dim32(1);
+    const int out_w = Y->t.dim32(2);
+    const int taps = kernel_h() * kernel_w();
+
+    // the filters as taps x C, so that each tap is contiguous over channels
+    cols_.Resize(taps, C);
+    uint8_t* filters = cols_.mutable_data<uint8_t>();
+    const uint8_t* W_data = W.t.data<uint8_t>();
+    for (int c = 0; c < C; ++c) {
+      for (int tap = 0; tap < taps; ++tap) {
+        filters[tap * C + c] = W_data[c * taps + tap];
+      }
+    }
+
+    acc_.Resize(C);
+    int32_t* acc = acc_.mutable_data<int32_t>();
+    const uint8_t* X_data = X.t.data<uint8_t>();
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    const float multiplier = acc_scale / Y->scale;
+    for (int n = 0; n < N; ++n) {
+      const uint8_t* image = X_data + n * H * W_in * C;
+      for (int oh = 0; oh < out_h; ++oh) {
+        for (int ow = 0; ow < out_w; ++ow) {
+          for (int c = 0; c < C; ++c) {
+            acc[c] = bias ? bias[c] : 0;
+          }
+          // padding holds the zero point, which contributes nothing
+          for (int kh = 0; kh < kernel_h(); ++kh) {
+            const int h = oh * stride_h() - pad_t() + kh * dilation_h();
+            if (h < 0 || h >= H) {
+              continue;
+            }
+            for (int kw = 0; kw < kernel_w(); ++kw) {
+              const int w = ow * stride_w() - pad_l() + kw * dilation_w();
+              if (w < 0 || w >= W_in) {
+                continue;
+              }
+              kernels_.depthwise_accumulate(
+                  C,
+                  image + (h * W_in + w) * C,
+                  X.zero_point,
+                  filters + (kh * kernel_w() + kw) * C,
+                  W.zero_point,
+                  acc);
+            }
+          }
+          uint8_t* pixel = Y_data + ((n * out_h + oh) * out_w + ow) * C;
+          for (int c = 0; c < C; ++c) {
+            pixel[c] = Requantize(acc[c], multiplier, Y->zero_point);
+          }
+        }
+      }
+    }
+  }
+
+  Int8Kernels kernels_;
+  TensorCPU cols_;
+  TensorCPU acc_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONV_OP_H_
@@ -0,0 +1,30 @@
+#include "caffe2/operators/quantized/int8_fc_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8FC, int8::Int8FCOp);
+#ifdef __ARM_NEON__
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Int8FC, NEON, int8::Int8FCOp);
+#endif
+
+OPERATOR_SCHEMA(Int8FC)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of FC: Y = X * W^T + b, where X (M x K after coercion
+along axis) and W (N x K) are uint8 Int8TensorCPUs and b is an optional
+int32 Int8TensorCPU of size N with zero point 0 and scale
+X.scale * W.scale. The products are accumulated in int32 and requantized
+to the output's scale and zero point. On ARM, the NEON engine computes them
+with NEON kernels.
+)DOC")
+    .Arg("axis", "(int32_t) default 1; the axis X is coerced to 2D along")
+    .Arg("axis_w", "(int32_t) default 1; the axis W is coerced to 2D along")
+    .Arg("Y_scale", "Scale of the output, by default that of X")
+    .Arg("Y_zero_point", "Zero point of the output, by default that of X")
+    .Input(0, "X", "Int8TensorCPU input")
+    .Input(1, "W", "Int8TensorCPU weights of size N x K")
+    .Input(2, "b", "Optional int32 Int8TensorCPU bias of size N")
+    .Output(0, "Y", "Int8TensorCPU output");
+
+} // namespace caffe2
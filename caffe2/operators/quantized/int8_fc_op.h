@@ -0,0 +1,76 @@
+#ifndef CAFFE2_OPERATORS_INT8_FC_OP_H_
+#define CAFFE2_OPERATORS_INT8_FC_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_neon.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8FCOp final : public Operator<CPUContext> {
+ public:
+  Int8FCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        axis_w_(OperatorBase::GetSingleArgument<int32_t>("axis_w", 1)),
+        kernels_(Int8KernelsForEngine(operator_def.engine())) {}
+
+  bool RunOnDevice() override {
+    const auto& X = OperatorBase::Input<Int8TensorCPU>(0);
+    const auto& W = OperatorBase::Input<Int8TensorCPU>(1);
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(&X != Y, "Int8FC cannot run in place");
+    SetOutputQuantization(*this, X, Y);
+
+    const auto canonical_axis = X.t.canonical_axis_index(axis_);
+    const auto M = X.t.size_to_dim(canonical_axis);
+    const auto K = X.t.size_from_dim(canonical_axis);
+    const auto canonical_axis_w = W.t.canonical_axis_index(axis_w_);
+    const auto N = W.t.size_to_dim(canonical_axis_w);
+    CAFFE_ENFORCE_EQ(K, W.t.size_from_dim(canonical_axis_w), "dimension mismatch");
+
+    const float acc_scale = X.scale * W.scale;
+    const int32_t* bias = InputSize() == 3
+        ? BiasData(OperatorBase::Input<Int8TensorCPU>(2), acc_scale, N)
+        : nullptr;
+
+    vector<TIndex> Y_shape(X.t.dims().begin(), X.t.dims().begin() + canonical_axis);
+    Y_shape.push_back(N);
+    Y->t.Resize(Y_shape);
+    acc_.Resize(M, N);
+    kernels_.gemm(
+        M,
+        N,
+        K,
+        X.t.data<uint8_t>(),
+        X.zero_point,
+        W.t.data<uint8_t>(),
+        W.zero_point,
+        bias,
+        acc_.mutable_data<int32_t>());
+
+    const float multiplier = acc_scale / Y->scale;
+    const int32_t* acc = acc_.data<int32_t>();
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    for (TIndex i = 0; i < M * N; ++i) {
+      Y_data[i] = Requantize(acc[i], multiplier, Y->zero_point);
+    }
+    return true;
+  }
+
+ private:
+  int32_t axis_;
+  int32_t axis_w_;
+  Int8Kernels kernels_;
+  TensorCPU acc_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_FC_OP_H_
@@ -0,0 +1,168 @@
+#ifndef CAFFE2_OPERATORS_INT8_NEON_H_
+#define CAFFE2_OPERATORS_INT8_NEON_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+namespace int8 {
+
+#ifdef __ARM_NEON__
+
+inline uint32_t SumLanesNEON(uint32x4_t v) {
+  const uint32x2_t sum = vadd_u32(vget_low_u32(v), vget_high_u32(v));
+  return vget_lane_u32(vpadd_u32(sum, sum), 0);
+}
+
+inline uint32_t RowSumNEON(const uint8_t* a, int K) {
+  uint32x4_t acc = vdupq_n_u32(0);
+  int k = 0;
+  for (; k + 16 <= K; k += 16) {
+    acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(a + k)));
+  }
+  uint32_t sum = SumLanesNEON(acc);
+  for (; k < K; ++k) {
+    sum += a[k];
+  }
+  return sum;
+}
+
+// Adds the 16 products of a and b to acc. A product of uint8_t values fits
+// in uint16_t, and pairs of them are summed into the uint32_t lanes.
+inline uint32x4_t DotAccumulateNEON(uint32x4_t acc, uint8x16_t a, uint8x16_t b) {
+  acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(a), vget_low_u8(b)));
+  return vpadalq_u16(acc, vmull_u8(vget_high_u8(a), vget_high_u8(b)));
+}
+
+// Int8Gemm with the dot products computed by vmull_u8 / vpadalq_u16, four
+// rows of B at a time so that every 16 bytes of A are loaded once for them.
+// The unsigned sums are exact for K up to 2^15, like those of Int8Gemm.
+inline void Int8GemmNEON(
+    int M,
+    int N,
+    int K,
+    const uint8_t* A,
+    int32_t a_zero_point,
+    const uint8_t* B,
+    int32_t b_zero_point,
+    const int32_t* bias,
+    int32_t* C) {
+  std::vector<int32_t> b_sums(N);
+  for (int j = 0; j < N; ++j) {
+    b_sums[j] = RowSumNEON(B + j * K, K);
+  }
+  const int32_t zero_points_term = K * a_zero_point * b_zero_point;
+  const int K16 = K - K % 16;
+  for (int i = 0; i < M; ++i) {
+    const uint8_t* a = A + i * K;
+    const int32_t a_sum = RowSumNEON(a, K);
+    auto store = [&](int j, uint32_t dot) {
+      C[i * N + j] = static_cast<int32_t>(dot) + zero_points_term -
+          b_zero_point * a_sum - a_zero_point * b_sums[j] +
+          (bias ? bias[j] : 0);
+    };
+
+    int j = 0;
+    for (; j + 4 <= N; j += 4) {
+      const uint8_t* b0 = B + j * K;
+      const uint8_t* b1 = b0 + K;
+      const uint8_t* b2 = b1 + K;
+      const uint8_t* b3 = b2 + K;
+      uint32x4_t acc0 = vdupq_n_u32(0);
+      uint32x4_t acc1 = vdupq_n_u32(0);
+      uint32x4_t acc2 = vdupq_n_u32(0);
+      uint32x4_t acc3 = vdupq_n_u32(0);
+      for (int k = 0; k < K16; k += 16) {
+        const uint8x16_t va = vld1q_u8(a + k);
+        acc0 = DotAccumulateNEON(acc0, va, vld1q_u8(b0 + k));
+        acc1 = DotAccumulateNEON(acc1, va, vld1q_u8(b1 + k));
+        acc2 = DotAccumulateNEON(acc2, va, vld1q_u8(b2 + k));
+        acc3 = DotAccumulateNEON(acc3, va, vld1q_u8(b3 + k));
+      }
+      uint32_t dot0 = SumLanesNEON(acc0);
+      uint32_t dot1 = SumLanesNEON(acc1);
+      uint32_t dot2 = SumLanesNEON(acc2);
+      uint32_t dot3 = SumLanesNEON(acc3);
+      for (int k = K16; k < K; ++k) {
+        dot0 += a[k] * b0[k];
+        dot1 += a[k] * b1[k];
+        dot2 += a[k] * b2[k];
+        dot3 += a[k] * b3[k];
+      }
+      store(j, dot0);
+      store(j + 1, dot1);
+      store(j + 2, dot2);
+      store(j + 3, dot3);
+    }
+    for (; j < N; ++j) {
+      const uint8_t* b = B + j * K;
+      uint32x4_t acc = vdupq_n_u32(0);
+      for (int k = 0; k < K16; k += 16) {
+        acc = DotAccumulateNEON(acc, vld1q_u8(a + k), vld1q_u8(b + k));
+      }
+      uint32_t dot = SumLanesNEON(acc);
+      for (int k = K16; k < K; ++k) {
+        dot += a[k] * b[k];
+      }
+      store(j, dot);
+    }
+  }
+}
+
+// Int8DepthwiseAccumulate over 8 channels at a time. The differences with
+// the zero points are in [-255, 255], so they are exact as int16_t.
+inline void Int8DepthwiseAccumulateNEON(
+    int C,
+    const uint8_t* x,
+    int32_t x_zero_point,
+    const uint8_t* w,
+    int32_t w_zero_point,
+    int32_t* acc) {
+  const uint8x8_t vx_zero_point = vdup_n_u8(static_cast<uint8_t>(x_zero_point));
+  const uint8x8_t vw_zero_point = vdup_n_u8(static_cast<uint8_t>(w_zero_point));
+  int c = 0;
+  for (; c + 8 <= C; c += 8) {
+    const int16x8_t dx =
+        vreinterpretq_s16_u16(vsubl_u8(vld1_u8(x + c), vx_zero_point));
+    const int16x8_t dw =
+        vreinterpretq_s16_u16(vsubl_u8(vld1_u8(w + c), vw_zero_point));
+    int32x4_t low = vld1q_s32(acc + c);
+    int32x4_t high = vld1q_s32(acc + c + 4);
+    low = vmlal_s16(low, vget_low_s16(dx), vget_low_s16(dw));
+    high = vmlal_s16(high, vget_high_s16(dx), vget_high_s16(dw));
+    vst1q_s32(acc + c, low);
+    vst1q_s32(acc + c + 4, high);
+  }
+  Int8DepthwiseAccumulate(
+      C - c, x + c, x_zero_point, w + c, w_zero_point, acc + c);
+}
+
+#endif // __ARM_NEON__
+
+// The kernels of an Int8 operator: the NEON ones for the "NEON" engine on
+// ARM, the portable ones otherwise.
+struct Int8Kernels {
+  decltype(&Int8Gemm) gemm;
+  decltype(&Int8DepthwiseAccumulate) depthwise_accumulate;
+};
+
+inline Int8Kernels Int8KernelsForEngine(const std::string& engine) {
+#ifdef __ARM_NEON__
+  if (engine == "NEON") {
+    return {Int8GemmNEON, Int8DepthwiseAccumulateNEON};
+  }
+#endif
+  return {Int8Gemm, Int8DepthwiseAccumulate};
+}
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_NEON_H_
@@ -0,0 +1,36 @@
+#include "caffe2/operators/quantized/int8_pool_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(
+    Int8MaxPool,
+    int8::Int8PoolOp<int8::Int8MaxPoolFunctor>);
+REGISTER_CPU_OPERATOR(
+    Int8AveragePool,
+    int8::Int8PoolOp<int8::Int8AveragePoolFunctor>);
+
+OPERATOR_SCHEMA(Int8MaxPool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Max pooling of a uint8 Int8TensorCPU holding 2D images in NCHW or NHWC
+order. Takes the same arguments as MaxPool. The output has the scale and
+zero point of the input.
+)DOC")
+    .Input(0, "X", "Int8TensorCPU input")
+    .Output(0, "Y", "Int8TensorCPU output");
+
+OPERATOR_SCHEMA(Int8AveragePool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Average pooling of a uint8 Int8TensorCPU holding 2D images in NCHW or NHWC
+order. Takes the same arguments as AveragePool; padding is not counted in
+the average.
+)DOC")
+    .Arg("Y_scale", "Scale of the output, by default that of X")
+    .Arg("Y_zero_point", "Zero point of the output, by default that of X")
+    .Input(0, "X", "Int8TensorCPU input")
+    .Output(0, "Y", "Int8TensorCPU output");
+
+} // namespace caffe2
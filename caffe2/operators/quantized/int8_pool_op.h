@@ -0,0 +1,134 @@
+#ifndef CAFFE2_OPERATORS_INT8_POOL_OP_H_
+#define CAFFE2_OPERATORS_INT8_POOL_OP_H_
+
+#include <limits>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+// The max of uint8 values is the same in any quantization, so the output
+// keeps that of the input.
+struct Int8MaxPoolFunctor {
+  int32_t init() const {
+    return std::numeric_limits<int32_t>::min();
+  }
+  int32_t reduce(int32_t acc, uint8_t x) const {
+    return std::max(acc, static_cast<int32_t>(x));
+  }
+  uint8_t finalize(
+      int32_t acc,
+      int /*count*/,
+      const Int8TensorCPU& /*X*/,
+      const Int8TensorCPU& /*Y*/) const {
+    return static_cast<uint8_t>(acc);
+  }
+  static bool HasOutputQuantization() {
+    return false;
+  }
+};
+
+// Averages over the part of the window inside the image, like AveragePool.
+struct Int8AveragePoolFunctor {
+  int32_t init() const {
+    return 0;
+  }
+  int32_t reduce(int32_t acc, uint8_t x) const {
+    return acc + x;
+  }
+  uint8_t finalize(
+      int32_t acc,
+      int count,
+      const Int8TensorCPU& X,
+      const Int8TensorCPU& Y) const {
+    return Requantize(
+        acc - count * X.zero_point, X.scale / (Y.scale * count), Y.zero_point);
+  }
+  static bool HasOutputQuantization() {
+    return true;
+  }
+};
+
+template <typename Functor>
+class Int8PoolOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8PoolOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8 pooling only supports 2D images");
+  }
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    return RunOnDeviceWithOrder(StorageOrder::NCHW);
+  }
+  bool RunOnDeviceWithOrderNHWC() override {
+    return RunOnDeviceWithOrder(StorageOrder::NHWC);
+  }
+
+ private:
+  bool RunOnDeviceWithOrder(StorageOrder order) {
+    const auto& X = OperatorBase::Input<Int8TensorCPU>(0);
+    auto* Y = Outputs()[0]->GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE(&X != Y, "Int8 pooling cannot run in place");
+    CAFFE_ENFORCE_EQ(X.t.ndim(), 4);
+    if (Functor::HasOutputQuantization()) {
+      SetOutputQuantization(*this, X, Y);
+    } else {
+      Y->scale = X.scale;
+      Y->zero_point = X.zero_point;
+    }
+
+    const bool nchw = order == StorageOrder::NCHW;
+    const int N = X.t.dim32(0);
+    const int C = nchw ? X.t.dim32(1) : X.t.dim32(3);
+    const int H = nchw ? X.t.dim32(2) : X.t.dim32(1);
+    const int W = nchw ? X.t.dim32(3) : X.t.dim32(2);
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), C);
+    const int out_h = nchw ? Y->t.dim32(2) : Y->t.dim32(1);
+    const int out_w = nchw ? Y->t.dim32(3) : Y->t.dim32(2);
+
+    const uint8_t* X_data = X.t.data<uint8_t>();
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    Functor functor;
+    for (int n = 0; n < N; ++n) {
+      const uint8_t* image = X_data + n * C * H * W;
+      uint8_t* Y_image = Y_data + n * C * out_h * out_w;
+      for (int oh = 0; oh < out_h; ++oh) {
+        const int h_start = std::max(oh * stride_h() - pad_t(), 0);
+        const int h_end = std::min(oh * stride_h() - pad_t() + kernel_h(), H);
+        for (int ow = 0; ow < out_w; ++ow) {
+          const int w_start = std::max(ow * stride_w() - pad_l(), 0);
+          const int w_end = std::min(ow * stride_w() - pad_l() + kernel_w(), W);
+          const int count = (h_end - h_start) * (w_end - w_start);
+          for (int c = 0; c < C; ++c) {
+            int32_t acc = functor.init();
+            for (int h = h_start; h < h_end; ++h) {
+              for (int w = w_start; w < w_end; ++w) {
+                acc = functor.reduce(
+                    acc,
+                    nchw ? image[(c * H + h) * W + w]
+                         : image[(h * W + w) * C + c]);
+              }
+            }
+            const int index = nchw ? (c * out_h + oh) * out_w + ow
+                                   : (oh * out_w + ow) * C + c;
+            Y_image[index] = functor.finalize(acc, count, X, *Y);
+          }
+        }
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_POOL_OP_H_
@@ -0,0 +1,31 @@
+#include "caffe2/operators/quantized/int8_quantize_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Quantize, int8::Int8QuantizeOp);
+REGISTER_CPU_OPERATOR(Int8Dequantize, int8::Int8DequantizeOp);
+
+OPERATOR_SCHEMA(Int8Quantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantizes a float tensor X into an Int8TensorCPU Y holding uint8 values q,
+with X ~= Y_scale * (q - Y_zero_point). Values outside of the representable
+range saturate.
+)DOC")
+    .Arg("Y_scale", "Scale of the output")
+    .Arg("Y_zero_point", "Zero point of the output, in [0, 255]")
+    .Input(0, "X", "Float tensor")
+    .Output(0, "Y", "Int8TensorCPU");
+
+OPERATOR_SCHEMA(Int8Dequantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Converts an Int8TensorCPU X back into a float tensor,
+Y = X.scale * (X - X.zero_point).
+)DOC")
+    .Input(0, "X", "Int8TensorCPU")
+    .Output(0, "Y", "Float tensor");
+
+} // namespace caffe2
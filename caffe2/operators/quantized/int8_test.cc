@@ -0,0 +1,338 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+namespace {
+
+using int8::Int8TensorCPU;
+
+Int8TensorCPU* AddInt8Input(
+    Workspace* ws,
+    const string& name,
+    const vector<TIndex>& dims,
+    float scale,
+    int32_t zero_point,
+    const vector<uint8_t>& values) {
+  auto* X = ws->CreateBlob(name)->GetMutable<Int8TensorCPU>();
+  X->scale = scale;
+  X->zero_point = zero_point;
+  X->t.Resize(dims);
+  CHECK_EQ(X->t.size(), values.size());
+  std::copy(values.begin(), values.end(), X->t.mutable_data<uint8_t>());
+  return X;
+}
+
+vector<uint8_t> RandomValues(size_t size, std::mt19937* gen) {
+  std::uniform_int_distribution<int> dist(0, 255);
+  vector<uint8_t> values(size);
+  for (auto& v : values) {
+    v = dist(*gen);
+  }
+  return values;
+}
+
+float Real(const Int8TensorCPU& X, TIndex i) {
+  return X.scale * (static_cast<int32_t>(X.t.data<uint8_t>()[i]) - X.zero_point);
+}
+
+OperatorDef MakeOp(
+    const string& type,
+    const vector<string>& inputs,
+    const string& output) {
+  OperatorDef def;
+  def.set_type(type);
+  for (const auto& input : inputs) {
+    def.add_input(input);
+  }
+  def.add_output(output);
+  return def;
+}
+
+void AddArg(OperatorDef* def, const string& name, float value) {
+  auto* arg = def->add_arg();
+  arg->set_name(name);
+  arg->set_f(value);
+}
+
+void AddArg(OperatorDef* def, const string& name, int value) {
+  auto* arg = def->add_arg();
+  arg->set_name(name);
+  arg->set_i(value);
+}
+
+void AddArg(OperatorDef* def, const string& name, const string& value) {
+  auto* arg = def->add_arg();
+  arg->set_name(name);
+  arg->set_s(value);
+}
+
+void RunOp(const OperatorDef& def, Workspace* ws) {
+  std::unique_ptr<OperatorBase> op(CreateOperator(def, ws));
+  ASSERT_NE(nullptr, op);
+  ASSERT_TRUE(op->Run());
+}
+
+TEST(Int8Test, QuantizeDequantize) {
+  Workspace ws;
+  auto* X = ws.CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(5);
+  const vector<float> values = {-1.0f, 0.0f, 0.5f, 2.0f, 100.0f};
+  std::copy(values.begin(), values.end(), X->mutable_data<float>());
+
+  auto quantize = MakeOp("Int8Quantize", {"X"}, "Xq");
+  AddArg(&quantize, "Y_scale", 0.1f);
+  AddArg(&quantize, "Y_zero_point", 10);
+  RunOp(quantize, &ws);
+  const auto& Xq = ws.GetBlob("Xq")->Get<Int8TensorCPU>();
+  EXPECT_FLOAT_EQ(Xq.scale, 0.1f);
+  EXPECT_EQ(Xq.zero_point, 10);
+  const vector<uint8_t> expected = {0, 10, 15, 30, 255};
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(Xq.t.data<uint8_t>()[i], expected[i]);
+  }
+
+  RunOp(MakeOp("Int8Dequantize", {"Xq"}, "Y"), &ws);
+  const auto& Y = ws.GetBlob("Y")->Get<TensorCPU>();
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NEAR(Y.data<float>()[i], values[i], 1e-5);
+  }
+  // saturated
+  EXPECT_NEAR(Y.data<float>()[4], 24.5f, 1e-5);
+}
+
+void TestFC(int M, int K, int N, const string& engine) {
+  Workspace ws;
+  std::mt19937 gen(0);
+  const auto& X = *AddInt8Input(&ws, "X", {M, K}, 0.05f, 120, RandomValues(M * K, &gen));
+  const auto& W = *AddInt8Input(&ws, "W", {N, K}, 0.02f, 130, RandomValues(N * K, &gen));
+  auto* B = ws.CreateBlob("B")->GetMutable<Int8TensorCPU>();
+  B->scale = X.scale * W.scale;
+  B->zero_point = 0;
+  B->t.Resize(N);
+  for (int j = 0; j < N; ++j) {
+    B->t.mutable_data<int32_t>()[j] = 100 * j - 200;
+  }
+
+  auto def = MakeOp("Int8FC", {"X", "W", "B"}, "Y");
+  def.set_engine(engine);
+  AddArg(&def, "Y_scale", 0.1f);
+  AddArg(&def, "Y_zero_point", 128);
+  RunOp(def, &ws);
+  const auto& Y = ws.GetBlob("Y")->Get<Int8TensorCPU>();
+  ASSERT_EQ(Y.t.dims(), vector<TIndex>({M, N}));
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) {
+      float expected = B->scale * B->t.data<int32_t>()[j];
+      for (int k = 0; k < K; ++k) {
+        expected += Real(X, i * K + k) * Real(W, j * K + k);
+      }
+      expected = std::min(std::max(expected, -12.8f), 12.7f);
+      EXPECT_NEAR(Real(Y, i * N + j), expected, Y.scale / 2 + 1e-4);
+    }
+  }
+}
+
+TEST(Int8Test, FC) {
+  TestFC(3, 17, 5, "");
+}
+
+TEST(Int8Test, FCNEON) {
+  TestFC(3, 17, 5, "NEON");
+  TestFC(2, 40, 9, "NEON");
+}
+
+// Compares Int8Conv in both storage orders against a float convolution of
+// the dequantized inputs.
+void TestConv(int C, int M, int G, const string& engine) {
+  std::mt19937 gen(1);
+  const int N = 2, H = 5, W = 6, KH = 3, KW = 2;
+  const int C_group = C / G, M_group = M / G;
+  const int pad = 1, stride = 2;
+  const auto X_values = RandomValues(N * C * H * W, &gen);
+  const auto W_values = RandomValues(M * C_group * KH * KW, &gen);
+  const float X_scale = 0.03f, W_scale = 0.01f, Y_scale = 0.05f;
+  const int32_t X_zero_point = 100, W_zero_point = 140, Y_zero_point = 127;
+  const int out_h = (H + 2 * pad - KH) / stride + 1;
+  const int out_w = (W + 2 * pad - KW) / stride + 1;
+
+  auto x = [&](int n, int c, int h, int w) {
+    if (h < 0 || h >= H || w < 0 || w >= W) {
+      return 0.0f;
+    }
+    return X_scale *
+        (X_values[((n * C + c) * H + h) * W + w] - X_zero_point);
+  };
+  auto w = [&](int m, int c, int kh, int kw) {
+    return W_scale *
+        (W_values[((m * C_group + c) * KH + kh) * KW + kw] - W_zero_point);
+  };
+
+  for (const string order : {"NCHW", "NHWC"}) {
+    const bool nchw = order == "NCHW";
+    Workspace ws;
+    vector<uint8_t> X_data = X_values;
+    vector<uint8_t> W_data = W_values;
+    if (!nchw) {
+      for (int n = 0; n < N; ++n)
+        for (int c = 0; c < C; ++c)
+          for (int h = 0; h < H; ++h)
+            for (int i = 0; i < W; ++i)
+              X_data[((n * H + h) * W + i) * C + c] =
+                  X_values[((n * C + c) * H + h) * W + i];
+      for (int m = 0; m < M; ++m)
+        for (int c = 0; c < C_group; ++c)
+          for (int kh = 0; kh < KH; ++kh)
+            for (int kw = 0; kw < KW; ++kw)
+              W_data[((m * KH + kh) * KW + kw) * C_group + c] =
+                  W_values[((m * C_group + c) * KH + kh) * KW + kw];
+    }
+    AddInt8Input(
+        &ws,
+        "X",
+        nchw ? vector<TIndex>{N, C, H, W} : vector<TIndex>{N, H, W, C},
+        X_scale,
+        X_zero_point,
+        X_data);
+    AddInt8Input(
+        &ws,
+        "W",
+        nchw ? vector<TIndex>{M, C_group, KH, KW}
+             : vector<TIndex>{M, KH, KW, C_group},
+        W_scale,
+        W_zero_point,
+        W_data);
+
+    auto def = MakeOp("Int8Conv", {"X", "W"}, "Y");
+    def.set_engine(engine);
+    AddArg(&def, "kernel_h", KH);
+    AddArg(&def, "kernel_w", KW);
+    AddArg(&def, "pad", pad);
+    AddArg(&def, "stride", stride);
+    AddArg(&def, "group", G);
+    AddArg(&def, "order", order);
+    AddArg(&def, "Y_scale", Y_scale);
+    AddArg(&def, "Y_zero_point", Y_zero_point);
+    RunOp(def, &ws);
+    const auto& Y = ws.GetBlob("Y")->Get<Int8TensorCPU>();
+    ASSERT_EQ(
+        Y.t.dims(),
+        nchw ? vector<TIndex>({N, M, out_h, out_w})
+             : vector<TIndex>({N, out_h, out_w, M}));
+
+    for (int n = 0; n < N; ++n) {
+      for (int m = 0; m < M; ++m) {
+        const int g = m / M_group;
+        for (int oh = 0; oh < out_h; ++oh) {
+          for (int ow = 0; ow < out_w; ++ow) {
+            float expected = 0;
+            for (int c = 0; c < C_group; ++c)
+              for (int kh = 0; kh < KH; ++kh)
+                for (int kw = 0; kw < KW; ++kw)
+                  expected += w(m, c, kh, kw) *
+                      x(n,
+                        g * C_group + c,
+                        oh * stride - pad + kh,
+                        ow * stride - pad + kw);
+            expected = std::min(
+                std::max(expected, -Y_scale * Y_zero_point),
+                Y_scale * (255 - Y_zero_point));
+            const int index = nchw ? ((n * M + m) * out_h + oh) * out_w + ow
+                                   : ((n * out_h + oh) * out_w + ow) * M + m;
+            EXPECT_NEAR(Real(Y, index), expected, Y_scale / 2 + 1e-4);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Int8Test, Conv) {
+  TestConv(4, 6, 2, "");
+}
+
+// Depthwise NHWC convolutions have their own kernel; the NEON engine falls
+// back to the portable kernels when not on ARM.
+TEST(Int8Test, DepthwiseConv) {
+  TestConv(11, 11, 11, "");
+  TestConv(11, 11, 11, "NEON");
+}
+
+TEST(Int8Test, ConvNEON) {
+  TestConv(4, 6, 2, "NEON");
+}
+
+TEST(Int8Test, AddRelu) {
+  Workspace ws;
+  AddInt8Input(&ws, "A", {4}, 0.5f, 10, {0, 10, 20, 30});
+  AddInt8Input(&ws, "B", {4}, 0.25f, 0, {0, 4, 8, 200});
+  auto add = MakeOp("Int8Add", {"A", "B"}, "Y");
+  AddArg(&add, "Y_scale", 1.0f);
+  AddArg(&add, "Y_zero_point", 20);
+  RunOp(add, &ws);
+  const auto& Y = ws.GetBlob("Y")->Get<Int8TensorCPU>();
+  // -5 + 0, 0 + 1, 5 + 2, 10 + 50
+  const vector<uint8_t> sums = {15, 21, 27, 80};
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(Y.t.data<uint8_t>()[i], sums[i]);
+  }
+
+  RunOp(MakeOp("Int8Relu", {"A"}, "R"), &ws);
+  const auto& R = ws.GetBlob("R")->Get<Int8TensorCPU>();
+  EXPECT_EQ(R.zero_point, 10);
+  const vector<uint8_t> relus = {10, 10, 20, 30};
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(R.t.data<uint8_t>()[i], relus[i]);
+  }
+}
+
+TEST(Int8Test, Pool) {
+  Workspace ws;
+  // one 1 x 4 x 4 image, NHWC
+  AddInt8Input(
+      &ws,
+      "X",
+      {1, 4, 4, 1},
+      0.5f,
+      8,
+      {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
+  for (const string type : {"Int8MaxPool", "Int8AveragePool"}) {
+    auto def = MakeOp(type, {"X"}, "Y");
+    AddArg(&def, "kernel", 2);
+    AddArg(&def, "stride", 2);
+    AddArg(&def, "order", string("NHWC"));
+    RunOp(def, &ws);
+    const auto& Y = ws.GetBlob("Y")->Get<Int8TensorCPU>();
+    ASSERT_EQ(Y.t.dims(), vector<TIndex>({1, 2, 2, 1}));
+    const vector<uint8_t> expected = type == "Int8MaxPool"
+        ? vector<uint8_t>{5, 7, 13, 15}
+        // the averages are 2.5, 4.5, 10.5, 12.5, rounded to even
+        : vector<uint8_t>{2, 4, 10, 12};
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(Y.t.data<uint8_t>()[i], expected[i]) << type;
+    }
+  }
+}
+
+TEST(Int8Test, Concat) {
+  Workspace ws;
+  AddInt8Input(&ws, "A", {2, 1}, 1.0f, 0, {1, 2});
+  AddInt8Input(&ws, "B", {2, 2}, 0.5f, 0, {2, 4, 6, 8});
+  RunOp(MakeOp("Int8Concat", {"A", "B"}, "Y"), &ws);
+  const auto& Y = ws.GetBlob("Y")->Get<Int8TensorCPU>();
+  ASSERT_EQ(Y.t.dims(), vector<TIndex>({2, 3}));
+  EXPECT_FLOAT_EQ(Y.scale, 1.0f);
+  const vector<uint8_t> expected = {1, 1, 2, 2, 3, 4};
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(Y.t.data<uint8_t>()[i], expected[i]);
+  }
+}
+
+} // namespace
+} // namespace caffe2
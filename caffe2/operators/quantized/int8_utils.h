@@ -0,0 +1,130 @@
+#ifndef CAFFE2_OPERATORS_INT8_UTILS_H_
+#define CAFFE2_OPERATORS_INT8_UTILS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+
+namespace caffe2 {
+namespace int8 {
+
+// An Int8TensorCPU holding uint8_t data q represents the real values
+// scale * (q - zero_point). Biases are int32_t, with zero_point 0 and the
+// scale of the product they are added to (input scale * weight scale), so
+// they can be added to the int32 accumulators directly.
+
+inline uint8_t Saturate(int32_t q) {
+  return static_cast<uint8_t>(std::min(std::max(q, 0), 255));
+}
+
+inline uint8_t QuantizeUint8(float scale, int32_t zero_point, float value) {
+  return Saturate(
+      zero_point + static_cast<int32_t>(std::nearbyint(value / scale)));
+}
+
+// Converts an int32 accumulator to the output's representation. multiplier
+// is the accumulator's scale divided by the output scale.
+inline uint8_t Requantize(int32_t acc, float multiplier, int32_t zero_point) {
+  return Saturate(
+      zero_point + static_cast<int32_t>(std::nearbyint(acc * multiplier)));
+}
+
+// C = (A - a_zero_point) * (B - b_zero_point)^T + bias, for M x K A and
+// N x K B (the layout of FC and convolution weights), both row major. The
+// products of uint8_t values are accumulated in int32_t, which is exact for
+// K up to 2^15. The zero points are taken out of the inner loop, using
+//   sum (a - za) (b - zb) = sum ab - zb sum a - za sum b + K za zb
+// so that it is a plain dot product of uint8_t rows the compiler vectorizes.
+inline void Int8Gemm(
+    int M,
+    int N,
+    int K,
+    const uint8_t* A,
+    int32_t a_zero_point,
+    const uint8_t* B,
+    int32_t b_zero_point,
+    const int32_t* bias,
+    int32_t* C) {
+  std::vector<int32_t> b_sums(N);
+  for (int j = 0; j < N; ++j) {
+    const uint8_t* b = B + j * K;
+    int32_t sum = 0;
+    for (int k = 0; k < K; ++k) {
+      sum += b[k];
+    }
+    b_sums[j] = sum;
+  }
+  const int32_t zero_points_term = K * a_zero_point * b_zero_point;
+  for (int i = 0; i < M; ++i) {
+    const uint8_t* a = A + i * K;
+    int32_t a_sum = 0;
+    for (int k = 0; k < K; ++k) {
+      a_sum += a[k];
+    }
+    for (int j = 0; j < N; ++j) {
+      const uint8_t* b = B + j * K;
+      int32_t acc = 0;
+      for (int k = 0; k < K; ++k) {
+        acc += static_cast<int32_t>(a[k]) * static_cast<int32_t>(b[k]);
+      }
+      acc += zero_points_term - b_zero_point * a_sum -
+          a_zero_point * b_sums[j];
+      C[i * N + j] = acc + (bias ? bias[j] : 0);
+    }
+  }
+}
+
+// acc[c] += (x[c] - x_zero_point) * (w[c] - w_zero_point) for c < C: one
+// kernel tap of a depthwise convolution over the channels of an NHWC pixel.
+inline void Int8DepthwiseAccumulate(
+    int C,
+    const uint8_t* x,
+    int32_t x_zero_point,
+    const uint8_t* w,
+    int32_t w_zero_point,
+    int32_t* acc) {
+  for (int c = 0; c < C; ++c) {
+    acc[c] += (static_cast<int32_t>(x[c]) - x_zero_point) *
+        (static_cast<int32_t>(w[c]) - w_zero_point);
+  }
+}
+
+// Biases of FC and Conv: int32_t values in units of the accumulator.
+inline const int32_t* BiasData(
+    const Int8TensorCPU& B,
+    float acc_scale,
+    TIndex size) {
+  CAFFE_ENFORCE(B.t.IsType<int32_t>(), "Int8 biases must be int32");
+  CAFFE_ENFORCE_EQ(B.t.size(), size);
+  CAFFE_ENFORCE_EQ(B.zero_point, 0);
+  CAFFE_ENFORCE_LT(
+      std::abs(B.scale - acc_scale),
+      1e-4 * acc_scale,
+      "the bias scale must be the input scale times the weight scale");
+  return B.t.data<int32_t>();
+}
+
+// The quantization of an op's output: the Y_scale and Y_zero_point
+// arguments, or those of the given input if they are not set.
+inline void SetOutputQuantization(
+    const OperatorBase& op,
+    const Int8TensorCPU& like,
+    Int8TensorCPU* Y) {
+  Y->scale = op.HasArgument("Y_scale")
+      ? op.GetSingleArgument<float>("Y_scale", 1)
+      : like.scale;
+  Y->zero_point = op.HasArgument("Y_zero_point")
+      ? op.GetSingleArgument<int32_t>("Y_zero_point", 0)
+      : like.zero_point;
+  CAFFE_ENFORCE_GT(Y->scale, 0);
+  CAFFE_ENFORCE(Y->zero_point >= 0 && Y->zero_point <= 255);
+}
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_UTILS_H_
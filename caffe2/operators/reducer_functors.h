@@ -419,6 +419,40 @@ class BaseReducerGradient {
   };
 };
 
+namespace detail {
+
+// out += alpha * in for one block of a front dimensions reduction. Blocks are
+// usually short (e.g. embedding dimensions), so instead of calling into
+// math::Axpy for every one of them the loop is inlined into the reducer and
+// left to the compiler to vectorize.
+template <typename T, int FixedSize>
+inline void AccumulateBlock(
+    TIndex block_size,
+    const T alpha,
+    const T* in,
+    T* out) {
+  if (FixedSize == 1) { // static if
+    *out += alpha * *in;
+    return;
+  }
+  for (TIndex i = 0; i < block_size; ++i) {
+    out[i] += alpha * in[i];
+  }
+}
+
+template <typename T, int FixedSize>
+inline void ScaleBlock(TIndex block_size, const T alpha, T* out) {
+  if (FixedSize == 1) { // static if
+    *out *= alpha;
+    return;
+  }
+  for (TIndex i = 0; i < block_size; ++i) {
+    out[i] *= alpha;
+  }
+}
+
+} // namespace detail
+
 // Put forward and backward in the same template?
 template <typename T, class Context>
 class SumReducer;
@@ -444,8 +478,7 @@ class SumReducer<T, CPUContext> : public BaseReducer {
       TIndex /*offset*/,
       CPUContext* context) {
     if (meta.first_dim) {
-      math::AxpyFixedSize<T, CPUContext, FixedSize>(
-          meta.block_size, 1, in, out_, context);
+      detail::AccumulateBlock<T, FixedSize>(meta.block_size, 1, in, out_);
     } else {
       math::Sum<T, CPUContext>(
           meta.block_size, in, out_ + current_size_++, context);
@@ -539,14 +572,17 @@ class WeightedSumReducer<T, CPUContext> : public BaseReducer {
     memset(out, 0, sizeof(T) * meta.block_size);
   }
   template <int FixedSize>
-  void
-  process(const Meta& meta, const T* in, TIndex offset, CPUContext* context) {
+  void process(
+      const Meta& meta,
+      const T* in,
+      TIndex offset,
+      CPUContext* /*context*/) {
     CAFFE_ENFORCE(
         meta.first_dim,
         "WeightedSumReducer implemented only for "
         "front dimensions reduction");
-    math::AxpyFixedSize<T, CPUContext, FixedSize>(
-        meta.block_size, meta.scalars[offset], in, out_, context);
+    detail::AccumulateBlock<T, FixedSize>(
+        meta.block_size, meta.scalars[offset], in, out_);
   }
 
  private:
@@ -675,8 +711,7 @@ class MeanReducer<T, CPUContext> : public BaseReducer {
       TIndex /*offset*/,
       CPUContext* context) {
     if (meta.first_dim) {
-      math::AxpyFixedSize<T, CPUContext, FixedSize>(
-          meta.block_size, 1, in, out_, context);
+      detail::AccumulateBlock<T, FixedSize>(meta.block_size, 1, in, out_);
     } else {
       math::Sum<T, CPUContext>(
           meta.block_size, in, out_ + current_size_, context);
@@ -688,8 +723,8 @@ class MeanReducer<T, CPUContext> : public BaseReducer {
   void finish(const Meta& meta, CPUContext* context) {
     if (meta.first_dim) {
       if (current_size_ > 0) {
-        math::ScaleFixedSize<T, CPUContext, FixedSize>(
-            meta.block_size, 1.0 / current_size_, out_, out_, context);
+        detail::ScaleBlock<T, FixedSize>(
+            meta.block_size, 1.0 / current_size_, out_);
       }
     } else {
       math::ScaleFixedSize<T, CPUContext, FixedSize>(
@@ -2,6 +2,9 @@
 #include "caffe2/core/workspace.h"
 #include "caffe2/utils/proto_utils.h"
 
+#include <algorithm>
+#include <set>
+
 #ifndef CAFFE2_RNN_NO_TEXT_FORMAT
 #endif
 
@@ -9,6 +12,11 @@ CAFFE2_DEFINE_bool(
     caffe2_rnn_executor,
     true,
     "If set, uses special RNN executor for executing RecurrentNetworkOp");
+CAFFE2_DEFINE_bool(
+    caffe2_rnn_hoist_input_projections,
+    true,
+    "If set, forward-only RecurrentNetworkOp computes the FCs of the input "
+    "sequence for all timesteps at once, before the recurrence");
 
 namespace caffe2 {
 CAFFE_KNOWN_TYPE(detail::ScratchWorkspaces);
@@ -194,6 +202,94 @@ void AddApplyLinkOps(
   detail::PrependOps(ops, netdef);
 }
 
+std::vector<OperatorDef> HoistInputProjections(
+    const OperatorDef& op,
+    const std::vector<RecurrentInput>& recurrentInputs,
+    std::vector<Link>* links,
+    NetDef* netdef) {
+  const std::set<std::string> opInputs(op.input().begin(), op.input().end());
+  std::set<std::string> states;
+  for (const auto& ri : recurrentInputs) {
+    states.insert(ri.state);
+  }
+  std::multiset<std::string> written;
+  for (const auto& stepOp : netdef->op()) {
+    written.insert(stepOp.output().begin(), stepOp.output().end());
+  }
+  const std::set<std::string> netInputs(
+      netdef->external_input().begin(), netdef->external_input().end());
+  auto findLink = [&](const std::string& internal) {
+    return std::find_if(
+        links->begin(), links->end(), [&](const Link& l) {
+          return l.internal == internal;
+        });
+  };
+  // The blob only holds the slice of an external input of the op at the
+  // current timestep, and nothing in the step net writes to that input.
+  auto isInputSlice = [&](const std::string& blob) {
+    auto link = findLink(blob);
+    if (link == links->end() || link->offset != 0 || link->window != 1 ||
+        !opInputs.count(link->external) || states.count(link->external) ||
+        written.count(blob)) {
+      return false;
+    }
+    for (const auto& l : *links) {
+      if (l.external == link->external && written.count(l.internal)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  auto isConstant = [&](const std::string& blob) {
+    return opInputs.count(blob) && !written.count(blob) &&
+        findLink(blob) == links->end();
+  };
+
+  std::vector<OperatorDef> hoisted;
+  std::vector<OperatorDef> kept;
+  for (const auto& stepOp : netdef->op()) {
+    // The step net sees 1 x N x D slices, so its FCs over them use axis 2,
+    // which also is the FC over the whole T x N x D sequence.
+    if (stepOp.type() != "FC" || stepOp.input_size() != 3 ||
+        stepOp.output_size() != 1 ||
+        ArgumentHelper(stepOp).GetSingleArgument<int>("axis", 1) != 2 ||
+        !isInputSlice(stepOp.input(0)) || !isConstant(stepOp.input(1)) ||
+        !isConstant(stepOp.input(2))) {
+      kept.push_back(stepOp);
+      continue;
+    }
+    const auto& output = stepOp.output(0);
+    if (written.count(output) != 1 || netInputs.count(output) ||
+        findLink(output) != links->end()) {
+      kept.push_back(stepOp);
+      continue;
+    }
+
+    OperatorDef sequenceOp(stepOp);
+    sequenceOp.clear_control_input();
+    sequenceOp.set_input(0, findLink(stepOp.input(0))->external);
+    sequenceOp.set_output(0, output + "_all_timesteps");
+    if (!sequenceOp.has_device_option()) {
+      sequenceOp.mutable_device_option()->CopyFrom(op.device_option());
+    }
+    VLOG(1) << "Hoisting " << output << " out of the step net";
+
+    Link link;
+    link.internal = output;
+    link.external = sequenceOp.output(0);
+    links->push_back(link);
+    hoisted.push_back(sequenceOp);
+  }
+
+  if (!hoisted.empty()) {
+    netdef->mutable_op()->Clear();
+    for (const auto& o : kept) {
+      netdef->add_op()->CopyFrom(o);
+    }
+  }
+  return hoisted;
+}
+
 void extractLinks(
     OperatorBase* op,
     const std::string& internalArg,
@@ -10,6 +10,7 @@
 #include "caffe2/utils/math.h"
 
 CAFFE2_DECLARE_bool(caffe2_rnn_executor);
+CAFFE2_DECLARE_bool(caffe2_rnn_hoist_input_projections);
 
 namespace caffe2 {
 namespace detail {
@@ -52,10 +53,11 @@ struct ScratchWorkspaces {
 };
 
 inline void UpdateTimestepBlob(Workspace* ws, std::string blob_name, int t) {
-  ws->CreateBlob(blob_name)->GetMutable<TensorCPU>()->Resize(1);
-  auto timestepBlob = ws->GetBlob(blob_name);
+  auto timestepBlob = ws->CreateBlob(blob_name);
   CAFFE_ENFORCE(timestepBlob);
-  timestepBlob->GetMutable<TensorCPU>()->mutable_data<int32_t>()[0] = t;
+  auto* timestep = timestepBlob->GetMutable<TensorCPU>();
+  timestep->Resize(1);
+  timestep->mutable_data<int32_t>()[0] = t;
 }
 
 std::map<string, string> GetRecurrentMapping(
@@ -158,6 +160,18 @@ void AddApplyLinkOps(
     const DeviceOption& device_option,
     NetDef* netdef);
 
+/**
+ * Moves the FCs of the step net over a slice of an input sequence out of the
+ * step net: they are returned as FCs over the whole sequence, each linked
+ * back into the step net by a new link. Only valid on forward-only ops, as
+ * the backward step net expects the FC outputs in the step workspaces.
+ */
+std::vector<OperatorDef> HoistInputProjections(
+    const OperatorDef& op,
+    const std::vector<RecurrentInput>& recurrentInputs,
+    std::vector<Link>* links,
+    NetDef* netdef);
+
 void extractLinks(
     OperatorBase* op,
     const std::string& internalArg,
@@ -190,6 +204,15 @@ class RecurrentNetworkOp final : public Operator<Context> {
     links_ = constructLinks();
     aliases_ = constructAliases();
 
+    // Without a backward pass, the input projections of all timesteps are
+    // computed by a single GEMM before the recurrence instead of T small ones
+    if (FLAGS_caffe2_rnn_hoist_input_projections && !hasBackwardPass()) {
+      for (const auto& def : detail::HoistInputProjections(
+               operator_def, recurrentInputs_, &links_, &stepNetDef_)) {
+        sequenceOps_.push_back(CreateOperator(def, sharedWs_));
+      }
+    }
+
     stepNetDef_.add_external_input(timestep_);
     detail::AddApplyLinkOps(
         links_, timestep_, operator_def.device_option(), &stepNetDef_);
@@ -292,6 +315,15 @@ class RecurrentNetworkOp final : public Operator<Context> {
     return links;
   }
 
+  // If we don't have a backward step net, this operator is forward_only
+  // and we can avoid creating multiple workspaces.
+  bool hasBackwardPass() {
+    return OperatorBase::HasSingleArgumentOfType<NetDef>("backward_step_net") ||
+        (OperatorBase::HasSingleArgumentOfType<string>("backward_step_net") &&
+         OperatorBase::GetSingleArgument<string>("backward_step_net", "") !=
+             "");
+  }
+
   template<typename T>
   bool DoRunWithType() {
     const auto seqLen = Input(0).dim32(0);
@@ -300,14 +332,11 @@ class RecurrentNetworkOp final : public Operator<Context> {
       detail::initializeRecurrentInput<T, Context>(
           ri, seqLen, batchSize, sharedWs_, &context_);
     }
+    for (auto& op : sequenceOps_) {
+      CAFFE_ENFORCE(op->Run(), "Failed to run ", op->debug_def().type());
+    }
 
-    // If we don't have a backward step net, this operator is forward_only
-    // and we can avoid creating multiple workspaces.
-    bool has_backward_pass =
-        OperatorBase::HasSingleArgumentOfType<NetDef>("backward_step_net") ||
-        (OperatorBase::HasSingleArgumentOfType<string>("backward_step_net") &&
-         OperatorBase::GetSingleArgument<string>("backward_step_net", "") !=
-             "");
+    bool has_backward_pass = hasBackwardPass();
 
     // With backward pass: we need to create workspace for each timestep
     detail::ScratchWorkspaces* scratch =
@@ -388,6 +417,8 @@ class RecurrentNetworkOp final : public Operator<Context> {
   Workspace* sharedWs_;
   bool enable_rnn_executor_;
   std::unique_ptr<RecurrentNetworkExecutorBase> rnnExecutor_;
+  // FCs hoisted out of the step net, run over the whole input sequence
+  std::vector<std::unique_ptr<OperatorBase>> sequenceOps_;
 
   std::vector<detail::Link> links_;
   std::vector<detail::OffsetAlias> aliases_;
@@ -1391,7 +1391,8 @@ template <
 class AbstractLengthsOp : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(AbstractLengthsOp);
+  AbstractLengthsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
 
   bool RunOnDevice() override {
     if (SparseFused) {
@@ -1424,7 +1425,7 @@ class AbstractLengthsOp : public Operator<Context> {
     TIndex dataToReduceSize;
     const TIndex outputSize = lengthsInput.dim(0);
 
-    const IndexType* indices;
+    const IndexType* indices = nullptr;
     if (SparseFused) { // static if
       auto& indicesInput = Input(INDICES);
       CAFFE_ENFORCE_EQ(1, indicesInput.ndim(), "INDICES must be a vector");
@@ -1454,6 +1455,33 @@ class AbstractLengthsOp : public Operator<Context> {
         dataInput.meta().name(),
         ".");
 
+    // The segments and indices are validated up front, so that the segments
+    // can be reduced independently (and on several threads) afterwards
+    offsets_.resize(outputSize + 1);
+    offsets_[0] = 0;
+    for (TIndex rangeIndex = 0; rangeIndex < outputSize; ++rangeIndex) {
+      offsets_[rangeIndex + 1] = offsets_[rangeIndex] +
+          std::max<TIndex>(lengths[rangeIndex], 0);
+    }
+    CAFFE_ENFORCE(
+        offsets_[outputSize] == dataToReduceSize,
+        offsets_[outputSize],
+        " != ",
+        dataToReduceSize);
+    if (SparseFused) { // static if
+      for (TIndex dataIndex = 0; dataIndex < dataToReduceSize; ++dataIndex) {
+        IndexType idx = indices[dataIndex];
+        CAFFE_ENFORCE(
+            0 <= idx && idx < dataSize,
+            "The ",
+            dataIndex,
+            "th index from the input indices is out of bounds: ",
+            idx,
+            " vs. valid range 0 to ",
+            dataSize);
+      }
+    }
+
     vector<TIndex> shape{outputSize};
     ctx.appendOutputShape(&shape);
     output->Resize(shape);
@@ -1462,44 +1490,54 @@ class AbstractLengthsOp : public Operator<Context> {
     TIndex out_block_size = output->size_from_dim(1);
     TData* out = output->template mutable_data<TData>();
 
-    TIndex dataIndex = 0;
-    for (TIndex rangeIndex = 0; rangeIndex < outputSize; ++rangeIndex) {
-      Reducer reducer(ctx, out + out_block_size * rangeIndex, &context_);
-      for (TIndex start = dataIndex; dataIndex < start + lengths[rangeIndex];
-           ++dataIndex) {
-        IndexType idx;
-        if (SparseFused) { // static if
-          idx = indices[dataIndex];
-          CAFFE_ENFORCE(
-              0 <= idx && idx < dataSize,
-              "The ",
-              dataIndex,
-              "th index from the input indices is out of bounds: ",
-              idx,
-              " vs. valid range 0 to ",
-              dataSize);
-        } else {
-          idx = dataIndex;
-          CAFFE_ENFORCE(
-              0 <= idx && idx < dataSize,
-              "When calculating the ",
-              rangeIndex,
-              "th output with length=",
-              lengths[rangeIndex],
-              ", the index is out of bounds: ",
-              idx,
-              " vs. valid range 0 to ",
-              dataSize);
+    auto reduceSegments = [&](TIndex begin, TIndex end) {
+      for (TIndex rangeIndex = begin; rangeIndex < end; ++rangeIndex) {
+        Reducer reducer(ctx, out + out_block_size * rangeIndex, &context_);
+        for (TIndex dataIndex = offsets_[rangeIndex];
+             dataIndex < offsets_[rangeIndex + 1];
+             ++dataIndex) {
+          const TIndex idx = SparseFused ? indices[dataIndex] : dataIndex;
+          const TData* input = inputAccessor_.getBlockPtr(in_block_size, idx);
+          reducer.template process<FixedSize>(
+              ctx, input, dataIndex, &context_);
         }
-
-        const TData* input = inputAccessor_.getBlockPtr(in_block_size, idx);
-        reducer.template process<FixedSize>(ctx, input, dataIndex, &context_);
+        reducer.template finish<FixedSize>(ctx, &context_);
       }
-      reducer.template finish<FixedSize>(ctx, &context_);
+    };
+
+    ThreadPool* pool = nullptr;
+    if (outputSize > 1 &&
+        dataToReduceSize * in_block_size >= kMinParallelReductionSize) {
+      pool = ws_->GetThreadPool();
+    }
+    if (!pool || pool->getNumThreads() < 2) {
+      reduceSegments(0, outputSize);
+      return true;
     }
-    CAFFE_ENFORCE(
-        dataIndex == dataToReduceSize, dataIndex, " != ", dataToReduceSize);
 
+    // Splits the segments into chunks of about the same number of rows to
+    // reduce (plus one per segment, for the per segment overhead). The pool
+    // runs chunks inline below its minimum work size, so there are at least
+    // that many; it hands out consecutive chunks to the same thread.
+    const TIndex numChunks = std::min<TIndex>(
+        outputSize,
+        std::max<TIndex>(pool->getNumThreads(), pool->getMinWorkSize()));
+    const TIndex cost = dataToReduceSize + outputSize;
+    chunks_.assign(numChunks + 1, outputSize);
+    chunks_[0] = 0;
+    TIndex chunk = 1;
+    for (TIndex rangeIndex = 0; rangeIndex < outputSize && chunk < numChunks;
+         ++rangeIndex) {
+      while (chunk < numChunks &&
+             offsets_[rangeIndex] + rangeIndex >= chunk * cost / numChunks) {
+        chunks_[chunk++] = rangeIndex;
+      }
+    }
+    pool->run(
+        [&](int /*threadId*/, size_t chunkIndex) {
+          reduceSegments(chunks_[chunkIndex], chunks_[chunkIndex + 1]);
+        },
+        numChunks);
     return true;
   }
 
@@ -1511,7 +1549,16 @@ class AbstractLengthsOp : public Operator<Context> {
   static constexpr int kNumInputs = Reducer::kInputCount + kSelfInputs;
 
  private:
+  // Below this many values to reduce the segments are reduced on the calling
+  // thread.
+  static constexpr TIndex kMinParallelReductionSize = 1 << 16;
+
+  Workspace* ws_;
   InputAccessor inputAccessor_;
+  // offsets_[i] is the first row to reduce for segment i
+  vector<TIndex> offsets_;
+  // the segments of chunk i are [chunks_[i], chunks_[i + 1])
+  vector<TIndex> chunks_;
 };
 
 /*
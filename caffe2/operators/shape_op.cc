@@ -7,6 +7,7 @@ REGISTER_CPU_OPERATOR(Shape, ShapeOp<CPUContext>);
 OPERATOR_SCHEMA(Shape)
     .NumInputs(1)
     .NumOutputs(1)
+    .ReadsOnlyInputMetadata()
     .TensorInferenceFunction([](const OperatorDef& /*def*/,
                                 const vector<TensorShape>& in) {
       vector<TensorShape> out(1);
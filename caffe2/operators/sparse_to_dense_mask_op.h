@@ -2,6 +2,8 @@
 #define CAFFE2_OPERATORS_SPARSE_TO_DENSE_MASK_OP_H_
 
 #include <algorithm>
+#include <cstring>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include "caffe2/core/context.h"
@@ -128,15 +130,30 @@ class SparseToDenseMaskOp : public SparseToDenseMaskBase<Context> {
     output->Resize(shape);
 
     // init
-    // TODO: consider unrolling CopyItems to make elemental types copy faster
     char* output_data =
         static_cast<char*>(output->raw_mutable_data(sparse_values.meta()));
-    for (int i = 0; i < cols * rows; i++) {
-      context_.template CopyItems<Context, Context>(
-          default_value.meta(),
-          block_size,
-          default_val,
-          output_data + i * block_nbytes);
+    // Items that are plain bytes are copied with memcpy rather than per item
+    // through the context, and the defaults are filled in by doubling the
+    // filled prefix of the output.
+    const bool plain_items = sparse_values.meta().copy() == nullptr &&
+        std::is_same<Context, CPUContext>::value;
+    const TIndex num_blocks = static_cast<TIndex>(cols) * rows;
+    if (plain_items && num_blocks > 0) {
+      memcpy(output_data, default_val, block_nbytes);
+      const size_t total_nbytes = num_blocks * block_nbytes;
+      for (size_t filled = block_nbytes; filled < total_nbytes;) {
+        const size_t n = std::min(filled, total_nbytes - filled);
+        memcpy(output_data + filled, output_data, n);
+        filled += n;
+      }
+    } else {
+      for (TIndex i = 0; i < num_blocks; i++) {
+        context_.template CopyItems<Context, Context>(
+            default_value.meta(),
+            block_size,
+            default_val,
+            output_data + i * block_nbytes);
+      }
     }
     bool* presence_mask_data = nullptr;
     if (returnPresenceMask_) {
@@ -159,11 +176,18 @@ class SparseToDenseMaskOp : public SparseToDenseMaskBase<Context> {
         }
         int idx = this->getFeatureIdx(sparse_index);
         if (idx != -1) {
-          context_.template CopyItems<Context, Context>(
-              sparse_values.meta(),
-              block_size,
-              sparse_values_vec + (offset + c) * block_nbytes,
-              output_data + (r * cols + idx) * block_nbytes);
+          if (plain_items) {
+            memcpy(
+                output_data + (r * cols + idx) * block_nbytes,
+                sparse_values_vec + (offset + c) * block_nbytes,
+                block_nbytes);
+          } else {
+            context_.template CopyItems<Context, Context>(
+                sparse_values.meta(),
+                block_size,
+                sparse_values_vec + (offset + c) * block_nbytes,
+                output_data + (r * cols + idx) * block_nbytes);
+          }
           if (returnPresenceMask_) {
             presence_mask_data[r * cols + idx] = true;
           }
@@ -25,10 +25,12 @@ class TensorProtosDBInput final : public PrefetchOperator<Context> {
  private:
   // Prefetch will always just happen on the CPU side.
   vector<Blob> prefetched_blobs_;
+  // The prefetched tensors, copied to the device by the prefetching thread
+  // when Context isn't CPUContext
+  vector<Tensor<Context>> prefetched_blobs_on_device_;
   int batch_size_;
   bool shape_inferred_ = false;
   string key_;
-  string value_;
 };
 
 template <class Context>
@@ -37,6 +39,7 @@ TensorProtosDBInput<Context>::TensorProtosDBInput(
     Workspace* ws)
     : PrefetchOperator<Context>(operator_def, ws),
       prefetched_blobs_(operator_def.output_size()),
+      prefetched_blobs_on_device_(operator_def.output_size()),
       batch_size_(
           OperatorBase::template GetSingleArgument<int>("batch_size", 0)) {}
 
@@ -47,9 +50,10 @@ bool TensorProtosDBInput<Context>::Prefetch() {
   if (batch_size_ == 0) {
     // We do not need to construct a batch. As a result, we will simply
     // deserialize everything into the target prefetched blob.
-    reader.Read(&key_, &value_);
     TensorProtos protos;
-    CAFFE_ENFORCE(protos.ParseFromString(value_));
+    reader.ReadView(&key_, [&protos](const db::ValueView& value) {
+      CAFFE_ENFORCE(protos.ParseFromArray(value.data, static_cast<int>(value.size)));
+    });
     CAFFE_ENFORCE(protos.protos_size() == OutputSize());
     for (int i = 0; i < protos.protos_size(); ++i) {
       if (protos.protos(i).has_device_detail()) {
@@ -62,9 +66,10 @@ bool TensorProtosDBInput<Context>::Prefetch() {
   } else {
     vector<TensorCPU> temp_tensors(OutputSize());
     for (int item_id = 0; item_id < batch_size_; ++item_id) {
-      reader.Read(&key_, &value_);
       TensorProtos protos;
-      CAFFE_ENFORCE(protos.ParseFromString(value_));
+      reader.ReadView(&key_, [&protos](const db::ValueView& value) {
+        CAFFE_ENFORCE(protos.ParseFromArray(value.data, static_cast<int>(value.size)));
+      });
       CAFFE_ENFORCE(protos.protos_size() == OutputSize());
       if (!shape_inferred_) {
         // First, set the shape of all the blobs.
@@ -92,14 +97,29 @@ bool TensorProtosDBInput<Context>::Prefetch() {
       }
     }
   }
+  // If the context is not CPUContext, the copy to the device also happens in
+  // the prefetch function: on the streams of the prefetching thread, it
+  // overlaps the computation on the current batch instead of delaying the
+  // next one. The CPU tensors are pinned, so that it runs asynchronously.
+  if (!std::is_same<Context, CPUContext>::value) {
+    for (int i = 0; i < OutputSize(); ++i) {
+      prefetched_blobs_on_device_[i].CopyFrom(
+          prefetched_blobs_[i].template Get<TensorCPU>(), &this->context_);
+    }
+  }
   return true;
 }
 
 template <class Context>
 bool TensorProtosDBInput<Context>::CopyPrefetched() {
   for (int i = 0; i < OutputSize(); ++i) {
-    OperatorBase::Output<Tensor<Context>>(i)->CopyFrom(
-        prefetched_blobs_[i].template Get<TensorCPU>(), &this->context_);
+    if (std::is_same<Context, CPUContext>::value) {
+      OperatorBase::Output<Tensor<Context>>(i)->CopyFrom(
+          prefetched_blobs_[i].template Get<TensorCPU>(), &this->context_);
+    } else {
+      OperatorBase::Output<Tensor<Context>>(i)->CopyFrom(
+          prefetched_blobs_on_device_[i], &this->context_);
+    }
   }
   return true;
 }
@@ -1,3 +1,8 @@
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
@@ -9,14 +14,11 @@ namespace caffe2 {
 
 struct TextFileReaderInstance {
   TextFileReaderInstance(
-      const std::vector<char>& delims,
-      char escape,
       const std::string& filename,
       int numPasses,
-      const std::vector<int>& types)
-      : fileReader(filename),
-        tokenizer(Tokenizer(delims, escape), &fileReader, numPasses),
-        fieldTypes(types) {
+      const std::vector<int>& types,
+      size_t blockSize)
+      : blockReader(filename, numPasses, blockSize), fieldTypes(types) {
     for (const auto dt : fieldTypes) {
       fieldMetas.push_back(
           DataTypeToTypeMeta(static_cast<TensorProto_DataType>(dt)));
@@ -24,16 +26,52 @@ struct TextFileReaderInstance {
     }
   }
 
-  FileReader fileReader;
-  BufferedTokenizer tokenizer;
+  // Sets lines to the next (up to) maxRows lines, without their '\n', and
+  // keeps the blocks holding them in blocks. Returns the index of the
+  // first line in the file.
+  size_t nextLines(
+      size_t maxRows,
+      std::vector<std::pair<const char*, const char*>>* lines,
+      std::vector<LineBlockReader::Block>* blocks) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    while (lines->size() < maxRows) {
+      if (!block_ || blockOffset_ == block_->size()) {
+        block_ = blockReader.next();
+        blockOffset_ = 0;
+        if (!block_) {
+          break;
+        }
+      }
+      blocks->push_back(block_);
+      const char* data = block_->data();
+      const char* end = data + block_->size();
+      const char* line = data + blockOffset_;
+      while (lines->size() < maxRows && line < end) {
+        // every block ends with a newline
+        auto* newline =
+            static_cast<const char*>(std::memchr(line, '\n', end - line));
+        lines->emplace_back(line, newline);
+        line = newline + 1;
+      }
+      blockOffset_ = line - data;
+    }
+    const size_t firstRow = rowsRead_;
+    rowsRead_ += lines->size();
+    return firstRow;
+  }
+
+  LineBlockReader blockReader;
   std::vector<int> fieldTypes;
   std::vector<TypeMeta> fieldMetas;
   std::vector<size_t> fieldByteSizes;
-  size_t rowsRead{0};
 
-  // hack to guarantee thread-safeness of the read op
-  // TODO(azzolini): support multi-threaded reading.
-  std::mutex globalMutex_;
+ private:
+  // only the lines are taken under the lock, so that concurrent reads
+  // parse their batches in parallel
+  std::mutex mutex_;
+  LineBlockReader::Block block_; // guarded by mutex_
+  size_t blockOffset_{0}; // guarded by mutex_
+  size_t rowsRead_{0}; // guarded by mutex_
 };
 
 class CreateTextFileReaderOp : public Operator<CPUContext> {
@@ -42,23 +80,74 @@ class CreateTextFileReaderOp : public Operator<CPUContext> {
       : Operator<CPUContext>(operator_def, ws),
         filename_(GetSingleArgument<string>("filename", "")),
         numPasses_(GetSingleArgument<int>("num_passes", 1)),
+        blockSize_(GetSingleArgument<int>("block_size", 1 << 22)),
         fieldTypes_(GetRepeatedArgument<int>("field_types")) {
     CAFFE_ENFORCE(fieldTypes_.size() > 0, "field_types arg must be non-empty");
+    CAFFE_ENFORCE_GT(blockSize_, 0, "block_size must be positive");
   }
 
   bool RunOnDevice() override {
     *OperatorBase::Output<std::unique_ptr<TextFileReaderInstance>>(0) =
         std::unique_ptr<TextFileReaderInstance>(new TextFileReaderInstance(
-            {'\n', '\t'}, '\0', filename_, numPasses_, fieldTypes_));
+            filename_, numPasses_, fieldTypes_, blockSize_));
     return true;
   }
 
  private:
   std::string filename_;
   int numPasses_;
+  int blockSize_;
   std::vector<int> fieldTypes_;
 };
 
+// Parses [src_start, src_end) as a decimal integer, without the locale
+// handling and copy strtol would need
+template <typename T>
+T parseInt(const char* src_start, const char* src_end) {
+  using U = typename std::make_unsigned<T>::type;
+  const char* ch = src_start;
+  bool negative = false;
+  if (ch < src_end && (*ch == '-' || *ch == '+')) {
+    negative = *ch == '-';
+    ++ch;
+  }
+  if (ch == src_end) {
+    throw std::runtime_error("Invalid integer: " + string(src_start, src_end));
+  }
+  const U limit = negative ? U(std::numeric_limits<T>::max()) + 1
+                           : U(std::numeric_limits<T>::max());
+  U val = 0;
+  for (; ch < src_end; ++ch) {
+    const unsigned digit = static_cast<unsigned char>(*ch) - '0';
+    if (digit > 9) {
+      throw std::runtime_error(
+          "Invalid integer: " + string(src_start, src_end));
+    }
+    if (val > (limit - digit) / 10) {
+      throw std::runtime_error(
+          "Integer out of range: " + string(src_start, src_end));
+    }
+    val = val * 10 + digit;
+  }
+  return negative ? static_cast<T>(U(0) - val) : static_cast<T>(val);
+}
+
+// Parses a float or double in place with parse (strtof or strtod): src_end
+// is followed by a delimiter, where parse stops
+template <typename T>
+T parseFloat(
+    const char* src_start,
+    const char* src_end,
+    T (*parse)(const char*, char**)) {
+  char* parsed_end;
+  T val = parse(src_start, &parsed_end);
+  // leading whitespace is skipped, which can run over an empty field
+  if (parsed_end == src_start || parsed_end > src_end) {
+    throw std::runtime_error("Invalid float: " + string(src_start, src_end));
+  }
+  return val;
+}
+
 inline void convert(
     TensorProto_DataType dst_type,
     const char* src_start,
@@ -69,15 +158,18 @@ inline void convert(
       static_cast<std::string*>(dst)->assign(src_start, src_end);
     } break;
     case TensorProto_DataType_FLOAT: {
-      // TODO(azzolini): avoid copy, use faster convertion
-      std::string str_copy(src_start, src_end);
-      const char* src_copy = str_copy.c_str();
-      char* src_copy_end;
-      float val = strtof(src_copy, &src_copy_end);
-      if (src_copy == src_copy_end) {
-        throw std::runtime_error("Invalid float: " + str_copy);
-      }
-      *static_cast<float*>(dst) = val;
+      *static_cast<float*>(dst) =
+          parseFloat<float>(src_start, src_end, strtof);
+    } break;
+    case TensorProto_DataType_DOUBLE: {
+      *static_cast<double*>(dst) =
+          parseFloat<double>(src_start, src_end, strtod);
+    } break;
+    case TensorProto_DataType_INT32: {
+      *static_cast<int32_t*>(dst) = parseInt<int32_t>(src_start, src_end);
+    } break;
+    case TensorProto_DataType_INT64: {
+      *static_cast<int64_t*>(dst) = parseInt<int64_t>(src_start, src_end);
     } break;
     default:
       throw std::runtime_error("Unsupported type.");
@@ -103,60 +195,52 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
             to_string(instance->fieldTypes.size()) + " got " +
             to_string(numFields));
 
+    lines_.clear();
+    blocks_.clear();
+    const size_t firstRow = instance->nextLines(batchSize_, &lines_, &blocks_);
+    const TIndex rowsRead = lines_.size();
+
     // char* datas[numFields];
     // MSVC does not allow using const int, so we will need to dynamically allocate
     // it.
     std::vector<char*> datas(numFields);
     for (int i = 0; i < numFields; ++i) {
-      Output(i)->Resize(batchSize_);
+      Output(i)->Resize(rowsRead);
       datas[i] = (char*)Output(i)->raw_mutable_data(instance->fieldMetas[i]);
     }
 
-    int rowsRead = 0;
-    {
-      // TODO(azzolini): support multi-threaded reading
-      std::lock_guard<std::mutex> guard(instance->globalMutex_);
-
-      bool finished = false;
-      Token token;
-      while (!finished && (rowsRead < batchSize_)) {
-        int field;
-        for (field = 0; field < numFields; ++field) {
-          finished = !instance->tokenizer.next(token);
-          if (finished) {
-            CAFFE_ENFORCE(
-                field == 0, "Invalid number of fields at end of file.");
-            break;
-          }
-          CAFFE_ENFORCE(
-              (field == 0 && token.startDelimId == 0) ||
-                  (field > 0 && token.startDelimId == 1),
-              "Invalid number of columns at row ",
-              instance->rowsRead + rowsRead + 1);
-          const auto& meta = instance->fieldMetas[field];
-          char*& data = datas[field];
-          convert(
-              (TensorProto_DataType)instance->fieldTypes[field],
-              token.start,
-              token.end,
-              data);
-          data += instance->fieldByteSizes[field];
-        }
-        if (!finished) {
-          ++rowsRead;
+    for (TIndex row = 0; row < rowsRead; ++row) {
+      const char* field = lines_[row].first;
+      const char* lineEnd = lines_[row].second;
+      for (int i = 0; i < numFields; ++i) {
+        auto* fieldEnd = static_cast<const char*>(
+            std::memchr(field, '\t', lineEnd - field));
+        const bool last = i == numFields - 1;
+        CAFFE_ENFORCE(
+            last == (fieldEnd == nullptr),
+            "Invalid number of columns at row ",
+            firstRow + row + 1);
+        if (last) {
+          fieldEnd = lineEnd;
         }
+        convert(
+            (TensorProto_DataType)instance->fieldTypes[i],
+            field,
+            fieldEnd,
+            datas[i]);
+        datas[i] += instance->fieldByteSizes[i];
+        field = fieldEnd + 1;
       }
-      instance->rowsRead += rowsRead;
-    }
-
-    for (int i = 0; i < numFields; ++i) {
-      Output(i)->Shrink(rowsRead);
     }
+    // drop the references to the blocks parsed
+    blocks_.clear();
     return true;
   }
 
  private:
   TIndex batchSize_;
+  std::vector<std::pair<const char*, const char*>> lines_;
+  std::vector<LineBlockReader::Block> blocks_;
 };
 
 CAFFE_KNOWN_TYPE(std::unique_ptr<TextFileReaderInstance>);
@@ -167,9 +251,14 @@ REGISTER_CPU_OPERATOR(TextFileReaderRead, TextFileReaderReadOp);
 OPERATOR_SCHEMA(CreateTextFileReader)
     .NumInputs(0)
     .NumOutputs(1)
-    .SetDoc("Create a text file reader. Fields are delimited by <TAB>.")
+    .SetDoc(R"DOC(
+Create a text file reader. Fields are delimited by <TAB> and rows by
+newlines. The file is read in blocks of whole lines by a background thread,
+and concurrent TextFileReaderRead ops parse their batches in parallel.
+)DOC")
     .Arg("filename", "Path to the file.")
     .Arg("num_passes", "Number of passes over the file.")
+    .Arg("block_size", "Size in bytes of the blocks read (default 4MB).")
     .Arg(
         "field_types",
         "List with type of each field. Type enum is found at core.DataType.")
@@ -1,6 +1,8 @@
 #include "caffe2/operators/text_file_reader_utils.h"
 
 #include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <sstream>
@@ -116,4 +118,88 @@ void FileReader::operator()(CharRange& range) {
   range.start = buffer;
   range.end = buffer + numRead;
 }
+
+LineBlockReader::LineBlockReader(
+    const std::string& path,
+    int numPasses,
+    size_t blockSize)
+    : blockSize_(blockSize), numPasses_(numPasses) {
+  fd_ = open(path.c_str(), O_RDONLY, 0777);
+  if (fd_ < 0) {
+    throw std::runtime_error(
+        "Error opening file for reading: " + std::string(std::strerror(errno)) +
+        " Path=" + path);
+  }
+  nextBlock_ = std::async(std::launch::async, [this]() { return readBlock(); });
+}
+
+LineBlockReader::~LineBlockReader() {
+  // the background read uses fd_
+  if (nextBlock_.valid()) {
+    nextBlock_.wait();
+  }
+  close(fd_);
+}
+
+LineBlockReader::Block LineBlockReader::next() {
+  if (!nextBlock_.valid()) {
+    return nullptr;
+  }
+  Block block = nextBlock_.get();
+  if (block) {
+    nextBlock_ =
+        std::async(std::launch::async, [this]() { return readBlock(); });
+  }
+  return block;
+}
+
+LineBlockReader::Block LineBlockReader::readBlock() {
+  while (true) {
+    std::vector<char> data;
+    data.swap(leftover_);
+    bool eof = false;
+    while (!eof) {
+      while (!eof && data.size() < blockSize_) {
+        eof = readInto(data, blockSize_ - data.size()) == 0;
+      }
+      if (eof) {
+        break;
+      }
+      auto lastNewline = std::find(data.rbegin(), data.rend(), '\n');
+      if (lastNewline != data.rend()) {
+        // the partial line after the last newline starts the next block
+        leftover_.assign(lastNewline.base(), data.end());
+        data.erase(lastNewline.base(), data.end());
+        break;
+      }
+      // a single line longer than the block
+      eof = readInto(data, blockSize_) == 0;
+    }
+    if (eof && !data.empty() && data.back() != '\n') {
+      data.push_back('\n');
+    }
+    if (!data.empty()) {
+      return std::make_shared<const std::vector<char>>(std::move(data));
+    }
+    if (++pass_ >= numPasses_) {
+      return nullptr;
+    }
+    if (lseek(fd_, 0, SEEK_SET) == -1) {
+      throw std::runtime_error(
+          "Error reseting file cursor: " + std::string(std::strerror(errno)));
+    }
+  }
+}
+
+size_t LineBlockReader::readInto(std::vector<char>& buffer, size_t size) {
+  const size_t offset = buffer.size();
+  buffer.resize(offset + size);
+  auto numRead = read(fd_, buffer.data() + offset, size);
+  if (numRead == -1) {
+    throw std::runtime_error(
+        "Error reading file: " + std::string(std::strerror(errno)));
+  }
+  buffer.resize(offset + numRead);
+  return numRead;
+}
 }
@@ -1,6 +1,7 @@
 #ifndef CAFFE2_OPERATORS_TEXT_FILE_READER_UTILS_H
 #define CAFFE2_OPERATORS_TEXT_FILE_READER_UTILS_H
 
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -117,6 +118,37 @@ class FileReader : public StringProvider {
   std::unique_ptr<char[]> buffer_;
 };
 
+// Reads a file in blocks of whole lines, each of them ending with '\n'
+// (which is appended to a last line missing it). The next block is read by a
+// background thread while the current one is parsed. A line longer than
+// blockSize makes a longer block.
+class LineBlockReader {
+ public:
+  using Block = std::shared_ptr<const std::vector<char>>;
+
+  LineBlockReader(
+      const std::string& path,
+      int numPasses = 1,
+      size_t blockSize = 1 << 22);
+  ~LineBlockReader();
+
+  // The next block, or nullptr after the last one of the last pass
+  Block next();
+
+ private:
+  Block readBlock();
+  // read()s up to size bytes at the end of buffer, returns how many
+  size_t readInto(std::vector<char>& buffer, size_t size);
+
+  const size_t blockSize_;
+  const int numPasses_;
+  int fd_;
+  // touched by the read of the next block only
+  int pass_{0};
+  std::vector<char> leftover_;
+  std::future<Block> nextBlock_;
+};
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_TEXT_FILE_READER_UTILS_H
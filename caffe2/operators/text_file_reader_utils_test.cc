@@ -119,4 +119,32 @@ TEST(TextFileReaderUtilsTest, TokenizeTest) {
   std::remove(tmpname);
 }
 
+TEST(TextFileReaderUtilsTest, LineBlockReaderTest) {
+  // the last line misses its newline
+  std::string content = "a\tbb\nccc\n\nlong line of text\nd";
+  char* tmpname = std::tmpnam(nullptr);
+  std::ofstream outFile;
+  outFile.open(tmpname);
+  outFile << content;
+  outFile.close();
+  for (size_t blockSize : {1, 4, 7, 100}) {
+    for (int numPasses = 1; numPasses <= 2; ++numPasses) {
+      LineBlockReader reader(tmpname, numPasses, blockSize);
+      std::string read;
+      while (auto block = reader.next()) {
+        EXPECT_FALSE(block->empty());
+        EXPECT_EQ('\n', block->back());
+        read.append(block->begin(), block->end());
+      }
+      EXPECT_FALSE(reader.next());
+      std::string expected;
+      for (int pass = 0; pass < numPasses; ++pass) {
+        expected += content + "\n";
+      }
+      EXPECT_EQ(expected, read);
+    }
+  }
+  std::remove(tmpname);
+}
+
 } // namespace caffe2
@@ -6,6 +6,8 @@
 #include <utility>
 #include <vector>
 
+#include "caffe2/core/common_omp.h"
+#include "caffe2/perfkernels/threshold_filter.h"
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/math.h"
 
@@ -13,6 +15,14 @@ namespace caffe2 {
 
 namespace {
 
+// Contiguous rows at least this long are selected by SelectTopK rather than
+// with a heap.
+constexpr TIndex kMinTopKSelectionSize = 4096;
+
+// Rows longer than this are split in segments selected on different threads,
+// when there are fewer rows than threads.
+constexpr TIndex kMinTopKSegmentSize = 1 << 16;
+
 template <typename T>
 struct ValueComp {
   bool operator()(
@@ -66,6 +76,127 @@ void GetTopK(
   }
 }
 
+// Positions in [0, n) of the values of x greater than threshold.
+template <typename T>
+TIndex FilterGreater(const T* x, TIndex n, T threshold, TIndex* indices) {
+  TIndex count = 0;
+  for (TIndex i = 0; i < n; ++i) {
+    if (x[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+inline TIndex
+FilterGreater(const float* x, TIndex n, float threshold, TIndex* indices) {
+  return FilterGreaterThan(x, n, threshold, indices);
+}
+
+// Appends the (at most) k greatest of the contiguous values x[begin, end),
+// unordered, to top.
+//
+// The values are scanned in chunks against the k-th greatest value seen so
+// far, and only the few that beat it are collected; the candidates are
+// pruned back to k with nth_element when too many have piled up. A value
+// equal to the threshold can be skipped since it comes after, and so ranks
+// below, the candidates that set it.
+template <typename T>
+void SelectTopK(
+    const T* x,
+    const TIndex begin,
+    const TIndex end,
+    const TIndex k,
+    std::vector<std::pair<T, TIndex>>* top) {
+  constexpr TIndex kChunkSize = 4096;
+  std::vector<std::pair<T, TIndex>> candidates;
+  const TIndex head = std::min(end, begin + k);
+  for (TIndex i = begin; i < head; ++i) {
+    candidates.emplace_back(x[i], i);
+  }
+  const auto prune = [&candidates, k]() {
+    std::nth_element(
+        candidates.begin(),
+        candidates.begin() + k - 1,
+        candidates.end(),
+        ValueComp<T>());
+    candidates.resize(k);
+    return candidates[k - 1].first;
+  };
+  if (head < end) {
+    const size_t max_candidates = std::max<TIndex>(2 * k, 64);
+    candidates.reserve(
+        std::min<TIndex>(max_candidates + kChunkSize, end - begin));
+    std::vector<TIndex> passed(std::min(kChunkSize, end - head));
+    T threshold = prune();
+    // The threshold rises fastest early on, so the chunks start small.
+    TIndex chunk_size = 128;
+    for (TIndex chunk = head; chunk < end; chunk += chunk_size) {
+      chunk_size = std::min(2 * chunk_size, kChunkSize);
+      const TIndex count = FilterGreater(
+          x + chunk,
+          std::min(chunk_size, end - chunk),
+          threshold,
+          passed.data());
+      for (TIndex i = 0; i < count; ++i) {
+        candidates.emplace_back(x[chunk + passed[i]], chunk + passed[i]);
+      }
+      if (candidates.size() > max_candidates) {
+        threshold = prune();
+      }
+    }
+    if (candidates.size() > static_cast<size_t>(k)) {
+      prune();
+    }
+  }
+  top->insert(top->end(), candidates.begin(), candidates.end());
+}
+
+// Top k of a contiguous row of n values, by SelectTopK over num_segments
+// ranges of the row, on the OpenMP threads when there is more than one.
+template <typename T>
+void GetTopKContiguous(
+    const T* input,
+    const TIndex n,
+    const TIndex k,
+    const TIndex src_offset,
+    const TIndex dst_offset,
+    const int num_segments,
+    T* values,
+    TIndex* indices,
+    TIndex* flatten_indices) {
+  const T* row = input + src_offset;
+  std::vector<std::pair<T, TIndex>> top;
+  if (num_segments == 1) {
+    SelectTopK(row, 0, n, k, &top);
+  } else {
+    std::vector<std::vector<std::pair<T, TIndex>>> segment_tops(num_segments);
+#pragma omp parallel for
+    for (int s = 0; s < num_segments; ++s) {
+      SelectTopK(
+          row,
+          n * s / num_segments,
+          n * (s + 1) / num_segments,
+          k,
+          &segment_tops[s]);
+    }
+    for (const auto& segment_top : segment_tops) {
+      top.insert(top.end(), segment_top.begin(), segment_top.end());
+    }
+    std::nth_element(
+        top.begin(), top.begin() + k - 1, top.end(), ValueComp<T>());
+    top.resize(k);
+  }
+  std::sort(top.begin(), top.end(), ValueComp<T>());
+  for (TIndex i = 0; i < k; ++i) {
+    values[dst_offset + i] = top[i].first;
+    indices[dst_offset + i] = top[i].second;
+    if (flatten_indices != nullptr) {
+      flatten_indices[dst_offset + i] = src_offset + top[i].second;
+    }
+  }
+}
+
 template <typename T>
 void SetTopKGradient(
     const T* values,
@@ -128,6 +259,50 @@ bool TopKOp<T, Context>::RunOnDevice() {
       std::multiplies<TIndex>());
   const TIndex src_offset_stride = input_dims[axis_] * next_size;
   const TIndex dst_offset_stride = k_ * next_size;
+  if (next_size == 1 && input_dims[axis_] >= kMinTopKSelectionSize) {
+    // Long contiguous rows: spread the rows over the threads, or the segments
+    // of each row if there are too few rows for that.
+    const TIndex n = input_dims[axis_];
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif // _OPENMP
+    int num_segments = 1;
+    if (prev_size < num_threads) {
+      num_segments = std::max<TIndex>(
+          1, std::min<TIndex>(num_threads, n / kMinTopKSegmentSize));
+    }
+    if (num_segments > 1) {
+      for (TIndex i = 0; i < prev_size; ++i) {
+        GetTopKContiguous(
+            input_data,
+            n,
+            k_,
+            i * src_offset_stride,
+            i * dst_offset_stride,
+            num_segments,
+            values_data,
+            indices_data,
+            flatten_indices_data);
+      }
+    } else {
+    const bool parallel = prev_size > 1 && prev_size * n >= kMinTopKSegmentSize;
+#pragma omp parallel for if (parallel)
+      for (TIndex i = 0; i < prev_size; ++i) {
+        GetTopKContiguous(
+            input_data,
+            n,
+            k_,
+            i * src_offset_stride,
+            i * dst_offset_stride,
+            1,
+            values_data,
+            indices_data,
+            flatten_indices_data);
+      }
+    }
+    return true;
+  }
   TIndex src_offset = 0;
   TIndex dst_offset = 0;
   for (TIndex i = 0; i < prev_size; ++i) {
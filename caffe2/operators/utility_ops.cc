@@ -387,6 +387,7 @@ OPERATOR_SCHEMA(CopyOnDeviceLike)
 OPERATOR_SCHEMA(HasElements)
     .NumInputs(1)
     .NumOutputs(1)
+    .ReadsOnlyInputMetadata()
     .SetDoc("Returns true iff the input tensor has size > 0")
     .Input(0, "tensor", "Tensor of any type.")
     .Output(
@@ -397,6 +398,7 @@ OPERATOR_SCHEMA(HasElements)
 OPERATOR_SCHEMA(IsEmpty)
     .NumInputs(1)
     .NumOutputs(1)
+    .ReadsOnlyInputMetadata()
     .SetDoc("Returns true iff the input tensor has size == 0")
     .ScalarType(::caffe2::TensorProto_DataType::TensorProto_DataType_BOOL)
     .Input(0, "tensor", "Tensor of any type.")
@@ -944,6 +946,7 @@ OPERATOR_SCHEMA(NanCheck)
 OPERATOR_SCHEMA(Size)
     .NumInputs(1)
     .NumOutputs(1)
+    .ReadsOnlyInputMetadata()
     .SetDoc(
         "Return a 1D tensor of type int64 that contains the number "
         "of elements of the input tensor")
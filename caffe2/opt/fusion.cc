@@ -0,0 +1,556 @@
+#include "fusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <sstream>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/operators/fused_elementwise_op.h"
+#include "caffe2/utils/proto_utils.h"
+#include "nomnigraph/Converters/Caffe2.h"
+
+namespace caffe2 {
+namespace opt {
+
+using namespace nom;
+using NodeRef = repr::NNGraph::NodeRef;
+
+namespace {
+
+// The OperatorDef an operator node was converted from, which the converter
+// back to a NetDef starts from, or nullptr if it is not of the given type.
+caffe2::OperatorDef* getOperatorDef(NodeRef node, const std::string& type) {
+  if (!repr::nn::is<repr::NeuralNetOperator>(node)) {
+    return nullptr;
+  }
+  auto* annotation =
+      repr::nn::get<repr::NeuralNetOperator>(node)->getMutableAnnotation();
+  if (!annotation || !annotation->getSaved()) {
+    return nullptr;
+  }
+  auto* def = static_cast<caffe2::OperatorDef*>(annotation->getSaved());
+  return def->type() == type ? def : nullptr;
+}
+
+std::string blobName(NodeRef tensorNode) {
+  return repr::nn::get<repr::NeuralNetData>(tensorNode)->getName();
+}
+
+// The consumer of producer's only output, if it is the only consumer and
+// producer can write the consumer's output instead. The output must not be
+// one of producer's inputs (other than an in-place accumulator), as the
+// fused op would overwrite it before reading it.
+NodeRef getFusableConsumer(
+    NodeRef producer,
+    const std::unordered_set<std::string>& externalOutputs) {
+  auto outputs = repr::nn::getOutputs(producer);
+  if (outputs.size() != 1) {
+    return nullptr;
+  }
+  auto consumers = repr::nn::getConsumers(outputs[0]);
+  if (consumers.size() != 1) {
+    return nullptr;
+  }
+  auto consumer = consumers[0];
+  auto consumerOutputs = repr::nn::getOutputs(consumer);
+  if (consumerOutputs.size() != 1) {
+    return nullptr;
+  }
+  const auto intermediate = blobName(outputs[0]);
+  const auto output = blobName(consumerOutputs[0]);
+  if (externalOutputs.count(intermediate) && intermediate != output) {
+    return nullptr;
+  }
+  const auto inputs = repr::nn::getInputs(producer);
+  const bool accumulates = getOperatorDef(producer, "Sum") != nullptr;
+  for (size_t i = accumulates ? 1 : 0; i < inputs.size(); ++i) {
+    if (blobName(inputs[i]) == output) {
+      return nullptr;
+    }
+  }
+  return consumer;
+}
+
+// Makes producer write the output of consumer, and removes consumer and the
+// tensor between them.
+void absorbConsumer(repr::NNGraph* g, NodeRef producer, NodeRef consumer) {
+  auto intermediate = repr::nn::getOutputs(producer)[0];
+  auto output = repr::nn::getOutputs(consumer)[0];
+  g->deleteNode(consumer);
+  g->deleteNode(intermediate);
+  g->createEdge(producer, output);
+}
+
+// Applies tryFuse to the operators until it no longer fuses any, restarting
+// after every fusion as it invalidates the nodes.
+void fuseAll(repr::NNGraph* g, const std::function<bool(NodeRef)>& tryFuse) {
+  bool fused = true;
+  while (fused) {
+    fused = false;
+    for (auto node : g->getMutableNodes()) {
+      if (repr::nn::is<repr::NeuralNetOperator>(node) && tryFuse(node)) {
+        fused = true;
+        break;
+      }
+    }
+  }
+}
+
+// The float CPU tensor of a blob in ws no operator writes.
+TensorCPU* getConstant(NodeRef tensorNode, Workspace* ws) {
+  if (repr::nn::hasProducer(tensorNode)) {
+    return nullptr;
+  }
+  const auto name = blobName(tensorNode);
+  if (!ws->HasBlob(name)) {
+    return nullptr;
+  }
+  auto* blob = ws->GetBlob(name);
+  if (!blob->IsType<TensorCPU>()) {
+    return nullptr;
+  }
+  auto* tensor = blob->GetMutable<TensorCPU>();
+  return tensor->IsType<float>() ? tensor : nullptr;
+}
+
+// A constant with no other reader, so that it can be rewritten.
+TensorCPU* getParameter(NodeRef tensorNode, Workspace* ws) {
+  if (repr::nn::getConsumers(tensorNode).size() != 1) {
+    return nullptr;
+  }
+  return getConstant(tensorNode, ws);
+}
+
+// Scales output channel m of the Conv or FC op by scale[m] and adds
+// shift[m] (if not null), creating its bias if it has none. Returns false,
+// with nothing changed, if the parameters can not be rewritten.
+bool foldChannelwiseAffine(
+    repr::NNGraph* g,
+    NodeRef op,
+    const float* scale,
+    const float* shift,
+    TIndex M,
+    Workspace* ws) {
+  auto inputs = repr::nn::getInputs(op);
+  if (inputs.size() < 2) {
+    return false;
+  }
+  auto* filter = getParameter(inputs[1], ws);
+  if (!filter || filter->ndim() < 2 || filter->dim(0) != M) {
+    return false;
+  }
+  TensorCPU* bias = nullptr;
+  if (inputs.size() > 2) {
+    bias = getParameter(inputs[2], ws);
+    if (!bias || bias->size() != M) {
+      return false;
+    }
+  } else if (shift) {
+    const auto biasName = blobName(inputs[1]) + "_bias";
+    if (ws->HasBlob(biasName)) {
+      return false;
+    }
+    bias = ws->CreateBlob(biasName)->GetMutable<TensorCPU>();
+    bias->Resize(M);
+    std::fill_n(bias->mutable_data<float>(), M, 0.f);
+    auto tensor = util::make_unique<repr::Tensor>(biasName);
+    g->createEdge(
+        g->createNode(unique_dyn_cast<repr::NeuralNetData>(tensor)), op);
+  }
+
+  const TIndex K = filter->size() / M;
+  float* w = filter->mutable_data<float>();
+  for (TIndex m = 0; m < M; ++m) {
+    for (TIndex k = 0; k < K; ++k) {
+      w[m * K + k] *= scale[m];
+    }
+  }
+  if (bias) {
+    float* b = bias->mutable_data<float>();
+    for (TIndex m = 0; m < M; ++m) {
+      b[m] = b[m] * scale[m] + (shift ? shift[m] : 0.f);
+    }
+  }
+  return true;
+}
+
+// Whether the second input of a broadcasting Mul or Add after producer is
+// laid out along the output channels of producer (a Conv or an FC).
+bool broadcastsAlongChannels(
+    const caffe2::OperatorDef& def,
+    const caffe2::OperatorDef& producerDef) {
+  ArgumentHelper args(def);
+  if (args.GetSingleArgument<int>("broadcast", 0) != 1 ||
+      args.HasArgument("axis_str")) {
+    return false;
+  }
+  const int axis = args.GetSingleArgument<int>("axis", -1);
+  ArgumentHelper producerArgs(producerDef);
+  if (producerDef.type() == "FC") {
+    return axis == -1 || axis == producerArgs.GetSingleArgument<int>("axis", 1);
+  }
+  if (producerArgs.GetSingleArgument<std::string>("order", "NCHW") == "NCHW") {
+    return axis == 1;
+  }
+  // NHWC: the channels are last.
+  return axis == -1;
+}
+
+// The inputs and "exprs" of an op as a FusedElementwise op.
+struct ElementwiseExpr {
+  std::vector<NodeRef> inputs;
+  std::vector<std::string> exprs;
+};
+
+bool getElementwiseExpr(NodeRef node, ElementwiseExpr* expr) {
+  if (!repr::nn::is<repr::NeuralNetOperator>(node) ||
+      repr::nn::getOutputs(node).size() != 1) {
+    return false;
+  }
+  auto* def = static_cast<caffe2::OperatorDef*>(
+      repr::nn::get<repr::NeuralNetOperator>(node)->getAnnotation()->getSaved());
+  if (!def) {
+    return false;
+  }
+  expr->inputs = repr::nn::getInputs(node);
+  ArgumentHelper args(*def);
+  if (def->type() == "FusedElementwise") {
+    expr->exprs = args.GetRepeatedArgument<std::string>("exprs");
+    return true;
+  }
+  int arity;
+  if (!FusedElementwiseExpr::IsSupported(def->type(), &arity) ||
+      args.GetSingleArgument<int>("broadcast", 0) ||
+      static_cast<int>(expr->inputs.size()) != arity) {
+    return false;
+  }
+  expr->exprs = {def->type() + (arity == 1 ? " 0" : " 0 1")};
+  return true;
+}
+
+bool onSameDevice(
+    const caffe2::OperatorDef& a,
+    const caffe2::OperatorDef& b) {
+  return a.device_option().device_type() == b.device_option().device_type() &&
+      a.device_option().cuda_gpu_id() == b.device_option().cuda_gpu_id();
+}
+
+// The expression strings with their operands renumbered by remap.
+void appendRemapped(
+    const std::vector<std::string>& exprs,
+    const std::function<int(int)>& remap,
+    std::vector<std::string>* out) {
+  for (const auto& expr : exprs) {
+    std::istringstream in(expr);
+    std::string type;
+    in >> type;
+    std::ostringstream ss;
+    ss << type;
+    int operand;
+    while (in >> operand) {
+      ss << " " << remap(operand);
+    }
+    out->push_back(ss.str());
+  }
+}
+
+} // namespace
+
+void fuseConvBN(
+    repr::NNModule* module,
+    Workspace* ws,
+    const std::unordered_set<std::string>& externalOutputs) {
+  auto* g = &module->dataFlow;
+  fuseAll(g, [&](NodeRef node) {
+    auto* convDef = getOperatorDef(node, "Conv");
+    if (!convDef) {
+      return false;
+    }
+    auto bnNode = getFusableConsumer(node, externalOutputs);
+    auto* bnDef = bnNode ? getOperatorDef(bnNode, "SpatialBN") : nullptr;
+    if (!bnDef) {
+      return false;
+    }
+    ArgumentHelper bnArgs(*bnDef);
+    if (!bnArgs.GetSingleArgument<int>("is_test", 0) ||
+        bnArgs.GetSingleArgument<std::string>("order", "NCHW") !=
+            ArgumentHelper(*convDef).GetSingleArgument<std::string>(
+                "order", "NCHW")) {
+      return false;
+    }
+    auto bnInputs = repr::nn::getInputs(bnNode);
+    if (bnInputs.size() != 5 || bnInputs[0] != repr::nn::getOutputs(node)[0]) {
+      return false;
+    }
+    TensorCPU* params[4];
+    for (int i = 0; i < 4; ++i) {
+      params[i] = getConstant(bnInputs[i + 1], ws);
+      if (!params[i] || params[i]->size() != params[0]->size()) {
+        return false;
+      }
+    }
+    const TIndex M = params[0]->size();
+    const float* bnScale = params[0]->data<float>();
+    const float* bnBias = params[1]->data<float>();
+    const float* mean = params[2]->data<float>();
+    const float* var = params[3]->data<float>();
+    const float epsilon = bnArgs.GetSingleArgument<float>("epsilon", 1e-5f);
+    std::vector<float> scale(M), shift(M);
+    for (TIndex m = 0; m < M; ++m) {
+      scale[m] = bnScale[m] / std::sqrt(var[m] + epsilon);
+      shift[m] = bnBias[m] - mean[m] * scale[m];
+    }
+    if (!foldChannelwiseAffine(g, node, scale.data(), shift.data(), M, ws)) {
+      return false;
+    }
+    absorbConsumer(g, node, bnNode);
+    return true;
+  });
+}
+
+void fuseMulAdd(
+    repr::NNModule* module,
+    Workspace* ws,
+    const std::unordered_set<std::string>& externalOutputs) {
+  auto* g = &module->dataFlow;
+  fuseAll(g, [&](NodeRef node) {
+    auto* def = getOperatorDef(node, "Conv");
+    if (!def) {
+      def = getOperatorDef(node, "FC");
+    }
+    if (!def) {
+      return false;
+    }
+    auto consumer = getFusableConsumer(node, externalOutputs);
+    if (!consumer) {
+      return false;
+    }
+    auto* mulDef = getOperatorDef(consumer, "Mul");
+    auto* addDef = getOperatorDef(consumer, "Add");
+    auto* consumerDef = mulDef ? mulDef : addDef;
+    if (!consumerDef || !broadcastsAlongChannels(*consumerDef, *def)) {
+      return false;
+    }
+    auto inputs = repr::nn::getInputs(consumer);
+    if (inputs.size() != 2 || repr::nn::getOutputs(node)[0] != inputs[0]) {
+      return false;
+    }
+    auto* constant = getConstant(inputs[1], ws);
+    if (!constant || constant->ndim() != 1) {
+      return false;
+    }
+    const TIndex M = constant->size();
+    const float* c = constant->data<float>();
+    const std::vector<float> ones(M, 1.f);
+    if (!foldChannelwiseAffine(
+            g, node, mulDef ? c : ones.data(), mulDef ? nullptr : c, M, ws)) {
+      return false;
+    }
+    absorbConsumer(g, node, consumer);
+    return true;
+  });
+}
+
+void fuseRelu(
+    repr::NNModule* module,
+    const std::unordered_set<std::string>& externalOutputs) {
+  auto* g = &module->dataFlow;
+  auto onCPU = [](const caffe2::OperatorDef& def) {
+    return def.device_option().device_type() == CPU;
+  };
+  fuseAll(g, [&](NodeRef node) {
+    caffe2::OperatorDef* def = nullptr;
+    for (const char* type : {"Conv", "FC", "Sum"}) {
+      if ((def = getOperatorDef(node, type))) {
+        break;
+      }
+    }
+    if (!def || !onCPU(*def)) {
+      return false;
+    }
+    auto reluNode = getFusableConsumer(node, externalOutputs);
+    auto* reluDef = reluNode ? getOperatorDef(reluNode, "Relu") : nullptr;
+    if (!reluDef || !onCPU(*reluDef)) {
+      return false;
+    }
+
+    auto* nnOp = repr::nn::get<repr::NeuralNetOperator>(node);
+    std::unique_ptr<repr::NeuralNetOperator> fused;
+    if (auto* conv = dyn_cast<repr::Conv>(nnOp)) {
+      fused = util::make_unique<repr::ConvRelu>(*conv);
+    } else if (isa<repr::Sum>(nnOp)) {
+      fused = util::make_unique<repr::SumRelu>();
+    } else {
+      fused = util::make_unique<repr::GenericOperator>("FCRelu");
+    }
+    fused->setLayout(nnOp->getLayout());
+    auto* annotation = nnOp->getMutableAnnotation();
+    if (auto* device = dyn_cast<repr::DeviceAnnotation>(annotation)) {
+      fused->setAnnotation(
+          util::make_unique<repr::DeviceAnnotation>(device->getDevice()));
+    } else {
+      fused->setAnnotation(util::make_unique<repr::Annotation>());
+    }
+    fused->getMutableAnnotation()->setSaved(annotation->getSaved());
+    def->set_type(def->type() + "Relu");
+
+    absorbConsumer(g, node, reluNode);
+    node->resetData(std::move(fused));
+    return true;
+  });
+}
+
+caffe2::NetDef optimizeForInference(caffe2::NetDef net, Workspace* ws) {
+  std::unordered_set<std::string> externalOutputs(
+      net.external_output().begin(), net.external_output().end());
+  auto module = nom::converters::convertFromCaffe2Proto(net);
+  fuseConvBN(&module, ws, externalOutputs);
+  fuseMulAdd(&module, ws, externalOutputs);
+  fuseRelu(&module, externalOutputs);
+  auto optimized = nom::converters::convertToCaffe2Proto(module);
+
+  // The biases created for ops that had none are read by the optimized
+  // net only.
+  std::unordered_set<std::string> known(
+      net.external_input().begin(), net.external_input().end());
+  for (const auto& op : net.op()) {
+    known.insert(op.input().begin(), op.input().end());
+    known.insert(op.output().begin(), op.output().end());
+  }
+  caffe2::NetDef result = net;
+  result.mutable_op()->CopyFrom(optimized.op());
+  for (const auto& op : result.op()) {
+    for (const auto& input : op.input()) {
+      if (known.insert(input).second && net.external_input_size()) {
+        result.add_external_input(input);
+      }
+    }
+  }
+  return result;
+}
+
+void fuseElementwise(
+    repr::NNModule* module,
+    caffe2::NetDef* fusedOps,
+    const std::unordered_set<std::string>& externalOutputs) {
+  auto* g = &module->dataFlow;
+  fuseAll(g, [&](NodeRef producer) {
+    ElementwiseExpr p, c;
+    if (!getElementwiseExpr(producer, &p)) {
+      return false;
+    }
+    auto intermediate = repr::nn::getOutputs(producer)[0];
+    auto consumers = repr::nn::getConsumers(intermediate);
+    // The consumer may read the intermediate more than once.
+    if (consumers.empty() ||
+        std::count(consumers.begin(), consumers.end(), consumers[0]) !=
+            static_cast<std::ptrdiff_t>(consumers.size()) ||
+        externalOutputs.count(blobName(intermediate))) {
+      return false;
+    }
+    auto consumer = consumers[0];
+    if (!getElementwiseExpr(consumer, &c)) {
+      return false;
+    }
+    auto* producerDef = static_cast<caffe2::OperatorDef*>(
+        repr::nn::get<repr::NeuralNetOperator>(producer)
+            ->getAnnotation()
+            ->getSaved());
+    auto* consumerNNOp = repr::nn::get<repr::NeuralNetOperator>(consumer);
+    auto* consumerDef = static_cast<caffe2::OperatorDef*>(
+        consumerNNOp->getAnnotation()->getSaved());
+    if (!onSameDevice(*producerDef, *consumerDef)) {
+      return false;
+    }
+
+    // The inputs of both, without the intermediate, each once. The
+    // producer's expressions come first and the consumer reads the last one
+    // for the intermediate.
+    std::vector<NodeRef> inputs;
+    auto inputIndex = [&](NodeRef input) {
+      auto it = std::find(inputs.begin(), inputs.end(), input);
+      if (it == inputs.end()) {
+        inputs.push_back(input);
+        return static_cast<int>(inputs.size()) - 1;
+      }
+      return static_cast<int>(it - inputs.begin());
+    };
+    for (auto input : p.inputs) {
+      inputIndex(input);
+    }
+    for (auto input : c.inputs) {
+      if (input != intermediate) {
+        inputIndex(input);
+      }
+    }
+    const int numInputs = inputs.size();
+    const int pInputs = p.inputs.size();
+    const int cInputs = c.inputs.size();
+    const int pExprs = p.exprs.size();
+    std::vector<std::string> exprs;
+    appendRemapped(
+        p.exprs,
+        [&](int v) {
+          return v < pInputs ? inputIndex(p.inputs[v]) : numInputs + v - pInputs;
+        },
+        &exprs);
+    appendRemapped(
+        c.exprs,
+        [&](int v) {
+          if (v >= cInputs) {
+            return numInputs + pExprs + v - cInputs;
+          }
+          return c.inputs[v] == intermediate ? numInputs + pExprs - 1
+                                             : inputIndex(c.inputs[v]);
+        },
+        &exprs);
+
+    auto* def = fusedOps->add_op();
+    def->set_type("FusedElementwise");
+    def->set_name(consumerDef->name());
+    *def->mutable_device_option() = consumerDef->device_option();
+    auto* arg = def->add_arg();
+    arg->set_name("exprs");
+    for (const auto& expr : exprs) {
+      arg->add_strings(expr);
+    }
+    auto fused = util::make_unique<repr::GenericOperator>("FusedElementwise");
+    auto* annotation = consumerNNOp->getMutableAnnotation();
+    if (auto* device = dyn_cast<repr::DeviceAnnotation>(annotation)) {
+      fused->setAnnotation(
+          util::make_unique<repr::DeviceAnnotation>(device->getDevice()));
+    } else {
+      fused->setAnnotation(util::make_unique<repr::Annotation>());
+    }
+    fused->getMutableAnnotation()->setSaved(def);
+
+    // The consumer's node becomes the fused op, in the consumer's place.
+    const auto inEdges = consumer->getInEdges();
+    for (auto edge : inEdges) {
+      g->deleteEdge(edge);
+    }
+    for (auto input : inputs) {
+      g->createEdge(input, consumer);
+    }
+    consumer->resetData(std::move(fused));
+    g->deleteNode(producer);
+    g->deleteNode(intermediate);
+    return true;
+  });
+}
+
+caffe2::NetDef fuseElementwiseOps(caffe2::NetDef net) {
+  std::unordered_set<std::string> externalOutputs(
+      net.external_output().begin(), net.external_output().end());
+  auto module = nom::converters::convertFromCaffe2Proto(net);
+  caffe2::NetDef fusedOps;
+  fuseElementwise(&module, &fusedOps, externalOutputs);
+  auto optimized = nom::converters::convertToCaffe2Proto(module);
+  caffe2::NetDef result = net;
+  result.mutable_op()->CopyFrom(optimized.op());
+  return result;
+}
+
+} // namespace opt
+} // namespace caffe2
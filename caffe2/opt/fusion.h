@@ -0,0 +1,60 @@
+#ifndef CAFFE2_OPT_FUSION_H_
+#define CAFFE2_OPT_FUSION_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "nomnigraph/Representations/NeuralNet.h"
+
+namespace caffe2 {
+namespace opt {
+
+// Fusion passes over the nomnigraph representation of an inference net.
+// They only fuse a pair of operators when the tensor between them is read
+// by nothing else and is not one of externalOutputs. The passes folding
+// constants into weights rewrite the parameters in ws (float CPU tensors),
+// so the optimized net replaces the original one on that workspace.
+
+// Folds SpatialBN (is_test) into the filter and bias of the Conv before it.
+void fuseConvBN(
+    nom::repr::NNModule* module,
+    Workspace* ws,
+    const std::unordered_set<std::string>& externalOutputs = {});
+
+// Folds Mul and Add by per output channel constants (broadcast along the
+// channel axis) into the filter and bias of the Conv or FC before them: the
+// scale and shift layers of converted models.
+void fuseMulAdd(
+    nom::repr::NNModule* module,
+    Workspace* ws,
+    const std::unordered_set<std::string>& externalOutputs = {});
+
+// Replaces Conv, FC and Sum followed by Relu by ConvRelu, FCRelu and
+// SumRelu, on CPU.
+void fuseRelu(
+    nom::repr::NNModule* module,
+    const std::unordered_set<std::string>& externalOutputs = {});
+
+// All of the above, in that order, on a net whose parameters are in ws.
+caffe2::NetDef optimizeForInference(caffe2::NetDef net, Workspace* ws);
+
+// Merges elementwise ops without broadcasting (the ops of
+// FusedElementwiseExpr) on the same device into FusedElementwise ops, when
+// each intermediate result is only read by the next op. The inputs must be
+// float tensors. The OperatorDefs of the fused ops are added to fusedOps,
+// which must outlive module.
+void fuseElementwise(
+    nom::repr::NNModule* module,
+    caffe2::NetDef* fusedOps,
+    const std::unordered_set<std::string>& externalOutputs = {});
+
+// fuseElementwise on a float net.
+caffe2::NetDef fuseElementwiseOps(caffe2::NetDef net);
+
+} // namespace opt
+} // namespace caffe2
+
+#endif // CAFFE2_OPT_FUSION_H_
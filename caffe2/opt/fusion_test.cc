@@ -0,0 +1,153 @@
+#include <cmath>
+#include <random>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/workspace.h"
+#include "fusion.h"
+
+#include <gtest/gtest.h>
+
+#define ADD_ARG(_op, _name, _type, _val)    \
+  {                                         \
+    caffe2::Argument* arg = _op->add_arg(); \
+    arg->set_name(_name);                   \
+    arg->set_##_type(_val);                 \
+  }
+
+namespace {
+
+caffe2::OperatorDef* addOp(
+    caffe2::NetDef* net,
+    const std::string& type,
+    const std::vector<std::string>& inputs,
+    const std::string& output) {
+  auto* def = net->add_op();
+  def->set_type(type);
+  for (const auto& input : inputs) {
+    def->add_input(input);
+  }
+  def->add_output(output);
+  return def;
+}
+
+void fill(
+    caffe2::Workspace* ws,
+    const std::string& name,
+    const std::vector<caffe2::TIndex>& dims,
+    float low,
+    float high) {
+  static std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(low, high);
+  auto* tensor = ws->CreateBlob(name)->GetMutable<caffe2::TensorCPU>();
+  tensor->Resize(dims);
+  float* data = tensor->mutable_data<float>();
+  for (caffe2::TIndex i = 0; i < tensor->size(); ++i) {
+    data[i] = dist(gen);
+  }
+}
+
+} // namespace
+
+TEST(FusionTest, InferenceNet) {
+  caffe2::NetDef net;
+  auto* conv = addOp(&net, "Conv", {"X", "W1", "b1"}, "Y1");
+  ADD_ARG(conv, "kernel", i, 3);
+  ADD_ARG(conv, "pad", i, 1);
+  auto* bn = addOp(&net, "SpatialBN", {"Y1", "s", "t", "mean", "var"}, "Y1");
+  ADD_ARG(bn, "is_test", i, 1);
+  addOp(&net, "Relu", {"Y1"}, "Y1");
+  conv = addOp(&net, "Conv", {"Y1", "W2"}, "Y2");
+  ADD_ARG(conv, "kernel", i, 1);
+  auto* mul = addOp(&net, "Mul", {"Y2", "scale"}, "Y3");
+  ADD_ARG(mul, "broadcast", i, 1);
+  ADD_ARG(mul, "axis", i, 1);
+  auto* add = addOp(&net, "Add", {"Y3", "shift"}, "Y3");
+  ADD_ARG(add, "broadcast", i, 1);
+  ADD_ARG(add, "axis", i, 1);
+  addOp(&net, "Sum", {"Y3", "X"}, "Y3");
+  addOp(&net, "Relu", {"Y3"}, "Y4");
+  addOp(&net, "FC", {"Y4", "W3", "b3"}, "F");
+  addOp(&net, "Relu", {"F"}, "F");
+  net.add_external_output("F");
+
+  caffe2::Workspace reference;
+  fill(&reference, "X", {2, 4, 5, 5}, -1, 1);
+  fill(&reference, "W1", {4, 4, 3, 3}, -1, 1);
+  fill(&reference, "b1", {4}, -1, 1);
+  fill(&reference, "s", {4}, 0.5, 1.5);
+  fill(&reference, "t", {4}, -1, 1);
+  fill(&reference, "mean", {4}, -1, 1);
+  fill(&reference, "var", {4}, 0.5, 1.5);
+  fill(&reference, "W2", {4, 4, 1, 1}, -1, 1);
+  fill(&reference, "scale", {4}, 0.5, 1.5);
+  fill(&reference, "shift", {4}, -1, 1);
+  fill(&reference, "W3", {3, 100}, -1, 1);
+  fill(&reference, "b3", {3}, -1, 1);
+  caffe2::Workspace ws;
+  for (const auto& name : reference.Blobs()) {
+    ws.CreateBlob(name)->GetMutable<caffe2::TensorCPU>()->CopyFrom(
+        reference.GetBlob(name)->Get<caffe2::TensorCPU>());
+  }
+
+  auto optimized = caffe2::opt::optimizeForInference(net, &ws);
+  std::vector<std::string> types;
+  for (const auto& op : optimized.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(
+      types,
+      (std::vector<std::string>{"ConvRelu", "Conv", "SumRelu", "FCRelu"}));
+
+  ASSERT_TRUE(reference.RunNetOnce(net));
+  ASSERT_TRUE(ws.RunNetOnce(optimized));
+  const auto& expected = reference.GetBlob("F")->Get<caffe2::TensorCPU>();
+  const auto& actual = ws.GetBlob("F")->Get<caffe2::TensorCPU>();
+  ASSERT_EQ(expected.dims(), actual.dims());
+  for (caffe2::TIndex i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(
+        expected.data<float>()[i],
+        actual.data<float>()[i],
+        1e-3 * (1 + std::abs(expected.data<float>()[i])));
+  }
+}
+
+TEST(FusionTest, Elementwise) {
+  caffe2::NetDef net;
+  addOp(&net, "Mul", {"X", "H"}, "A");
+  addOp(&net, "Sigmoid", {"A"}, "A");
+  addOp(&net, "Add", {"A", "X"}, "B");
+  addOp(&net, "Tanh", {"B"}, "Y");
+  // Broadcasting ops are not fused.
+  auto* mul = addOp(&net, "Mul", {"Y", "s"}, "Z");
+  ADD_ARG(mul, "broadcast", i, 1);
+  net.add_external_output("Z");
+
+  caffe2::Workspace reference;
+  fill(&reference, "X", {3, 7}, -1, 1);
+  fill(&reference, "H", {3, 7}, -1, 1);
+  fill(&reference, "s", {7}, -1, 1);
+  caffe2::Workspace ws;
+  for (const auto& name : reference.Blobs()) {
+    ws.CreateBlob(name)->GetMutable<caffe2::TensorCPU>()->CopyFrom(
+        reference.GetBlob(name)->Get<caffe2::TensorCPU>());
+  }
+
+  auto optimized = caffe2::opt::fuseElementwiseOps(net);
+  ASSERT_EQ(optimized.op_size(), 2);
+  const auto& fused = optimized.op(0);
+  EXPECT_EQ(fused.type(), "FusedElementwise");
+  EXPECT_EQ(
+      std::vector<std::string>(fused.input().begin(), fused.input().end()),
+      (std::vector<std::string>{"X", "H"}));
+  EXPECT_EQ(fused.output(0), "Y");
+  EXPECT_EQ(optimized.op(1).type(), "Mul");
+
+  ASSERT_TRUE(reference.RunNetOnce(net));
+  ASSERT_TRUE(ws.RunNetOnce(optimized));
+  const auto& expected = reference.GetBlob("Z")->Get<caffe2::TensorCPU>();
+  const auto& actual = ws.GetBlob("Z")->Get<caffe2::TensorCPU>();
+  ASSERT_EQ(expected.dims(), actual.dims());
+  for (caffe2::TIndex i = 0; i < expected.size(); ++i) {
+    EXPECT_NEAR(expected.data<float>()[i], actual.data<float>()[i], 1e-5);
+  }
+}
@@ -0,0 +1,75 @@
+#include "caffe2/perfkernels/adagrad.h"
+
+#include <cmath>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void AdagradUpdate__base(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float decay,
+    float lr) {
+  for (auto i = 0; i < N; ++i) {
+    float gi = g[i];
+    float hi = nh[i] = decay * h[i] + gi * gi;
+    nw[i] = w[i] + lr * gi / (std::sqrt(hi) + epsilon);
+  }
+}
+
+void AdagradUpdate(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float decay,
+    float lr) {
+  AVX2_FMA_DO(AdagradUpdate, N, w, g, h, nw, nh, epsilon, decay, lr);
+  BASE_DO(AdagradUpdate, N, w, g, h, nw, nh, epsilon, decay, lr);
+}
+
+void RowWiseAdagradUpdate__base(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float lr) {
+  float hs = 0.;
+  for (auto i = 0; i < N; ++i) {
+    float gi = g[i];
+    hs += gi * gi;
+  }
+  float hi = nh[0] = h[0] + hs / N;
+  float step = lr / (std::sqrt(hi) + epsilon);
+  for (auto i = 0; i < N; ++i) {
+    nw[i] = w[i] + g[i] * step;
+  }
+}
+
+void RowWiseAdagradUpdate(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float lr) {
+  AVX2_FMA_DO(RowWiseAdagradUpdate, N, w, g, h, nw, nh, epsilon, lr);
+  BASE_DO(RowWiseAdagradUpdate, N, w, g, h, nw, nh, epsilon, lr);
+}
+
+} // namespace caffe2
@@ -0,0 +1,44 @@
+#pragma once
+
+namespace caffe2 {
+
+/**
+ * Fused Adagrad update of N values, in a single pass over the data:
+ *
+ * for (i = 0..N-1)
+ *   nh[i] = decay * h[i] + g[i] * g[i]
+ *   nw[i] = w[i] + lr * g[i] / (sqrt(nh[i]) + epsilon)
+ *
+ * nw and nh may alias w and h.
+ */
+void AdagradUpdate(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float decay,
+    float lr);
+
+/**
+ * Row-wise Adagrad update of a row of N values sharing the single moment h:
+ *
+ * nh[0] = h[0] + sum(g[i] * g[i]) / N
+ * for (i = 0..N-1)
+ *   nw[i] = w[i] + g[i] * lr / (sqrt(nh[0]) + epsilon)
+ *
+ * nw and nh may alias w and h.
+ */
+void RowWiseAdagradUpdate(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float lr);
+
+} // namespace caffe2
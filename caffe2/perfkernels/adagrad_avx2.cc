@@ -0,0 +1,85 @@
+#include "caffe2/perfkernels/adagrad.h"
+
+#include <cmath>
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void AdagradUpdate__avx2_fma(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float decay,
+    float lr) {
+  constexpr int kSize = 8;
+  const __m256 mm_decay = _mm256_set1_ps(decay);
+  const __m256 mm_epsilon = _mm256_set1_ps(epsilon);
+  const __m256 mm_lr = _mm256_set1_ps(lr);
+  auto i = 0;
+  for (; i + kSize <= N; i += kSize) {
+    __m256 gi = _mm256_loadu_ps(g + i);
+    __m256 hi = _mm256_loadu_ps(h + i);
+    __m256 wi = _mm256_loadu_ps(w + i);
+
+    __m256 nhi = _mm256_fmadd_ps(gi, gi, _mm256_mul_ps(mm_decay, hi));
+    _mm256_storeu_ps(nh + i, nhi);
+    __m256 denominator = _mm256_add_ps(_mm256_sqrt_ps(nhi), mm_epsilon);
+    __m256 step = _mm256_div_ps(_mm256_mul_ps(mm_lr, gi), denominator);
+    _mm256_storeu_ps(nw + i, _mm256_add_ps(wi, step));
+  }
+
+  for (; i < N; ++i) {
+    float gi = g[i];
+    float hi = nh[i] = decay * h[i] + gi * gi;
+    nw[i] = w[i] + lr * gi / (std::sqrt(hi) + epsilon);
+  }
+}
+
+void RowWiseAdagradUpdate__avx2_fma(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float lr) {
+  constexpr int kSize = 8;
+  auto i = 0;
+  __m256 mm_hs = _mm256_setzero_ps();
+  for (; i + kSize <= N; i += kSize) {
+    __m256 gi = _mm256_loadu_ps(g + i);
+    mm_hs = _mm256_fmadd_ps(gi, gi, mm_hs);
+  }
+  // horizontal sum of the 8 partial sums
+  __m128 hs4 = _mm_add_ps(
+      _mm256_castps256_ps128(mm_hs), _mm256_extractf128_ps(mm_hs, 1));
+  hs4 = _mm_hadd_ps(hs4, hs4);
+  hs4 = _mm_hadd_ps(hs4, hs4);
+  float hs = _mm_cvtss_f32(hs4);
+  for (; i < N; ++i) {
+    float gi = g[i];
+    hs += gi * gi;
+  }
+
+  float hi = nh[0] = h[0] + hs / N;
+  float step = lr / (std::sqrt(hi) + epsilon);
+
+  const __m256 mm_step = _mm256_set1_ps(step);
+  i = 0;
+  for (; i + kSize <= N; i += kSize) {
+    __m256 gi = _mm256_loadu_ps(g + i);
+    __m256 wi = _mm256_loadu_ps(w + i);
+    _mm256_storeu_ps(nw + i, _mm256_fmadd_ps(gi, mm_step, wi));
+  }
+  for (; i < N; ++i) {
+    nw[i] = w[i] + g[i] * step;
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,79 @@
+#include "caffe2/perfkernels/adam.h"
+
+#include <cmath>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void AdamUpdate__base(
+    int N,
+    const float* w,
+    const float* g,
+    const float* m,
+    const float* v,
+    float* nw,
+    float* nm,
+    float* nv,
+    float beta1,
+    float beta2,
+    float eps_hat,
+    float correction,
+    float lr) {
+  for (auto i = 0; i < N; ++i) {
+    float gi = g[i];
+    float mi = nm[i] = m[i] * beta1 + gi * (1 - beta1);
+    float vi = nv[i] = v[i] * beta2 + gi * gi * (1 - beta2);
+    float ng = lr * correction * mi / (std::sqrt(vi) + eps_hat);
+    nw[i] = w[i] + ng;
+  }
+}
+
+void AdamUpdate(
+    int N,
+    const float* w,
+    const float* g,
+    const float* m,
+    const float* v,
+    float* nw,
+    float* nm,
+    float* nv,
+    float beta1,
+    float beta2,
+    float eps_hat,
+    float correction,
+    float lr) {
+  AVX2_FMA_DO(
+      AdamUpdate,
+      N,
+      w,
+      g,
+      m,
+      v,
+      nw,
+      nm,
+      nv,
+      beta1,
+      beta2,
+      eps_hat,
+      correction,
+      lr);
+  BASE_DO(
+      AdamUpdate,
+      N,
+      w,
+      g,
+      m,
+      v,
+      nw,
+      nm,
+      nv,
+      beta1,
+      beta2,
+      eps_hat,
+      correction,
+      lr);
+}
+
+} // namespace caffe2
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace caffe2 {
+
+/**
+ * Fused Adam update of N values, in a single pass over the data:
+ *
+ * for (i = 0..N-1)
+ *   nm[i] = beta1 * m[i] + (1 - beta1) * g[i]
+ *   nv[i] = beta2 * v[i] + (1 - beta2) * g[i] * g[i]
+ *   nw[i] = w[i] + lr * correction * nm[i] / (sqrt(nv[i]) + eps_hat)
+ *
+ * nw, nm and nv may alias w, m and v.
+ */
+void AdamUpdate(
+    int N,
+    const float* w,
+    const float* g,
+    const float* m,
+    const float* v,
+    float* nw,
+    float* nm,
+    float* nv,
+    float beta1,
+    float beta2,
+    float eps_hat,
+    float correction,
+    float lr);
+
+} // namespace caffe2
@@ -0,0 +1,58 @@
+#include "caffe2/perfkernels/adam.h"
+
+#include <cmath>
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void AdamUpdate__avx2_fma(
+    int N,
+    const float* w,
+    const float* g,
+    const float* m,
+    const float* v,
+    float* nw,
+    float* nm,
+    float* nv,
+    float beta1,
+    float beta2,
+    float eps_hat,
+    float correction,
+    float lr) {
+  constexpr int kSize = 8;
+  const __m256 mm_beta1 = _mm256_set1_ps(beta1);
+  const __m256 mm_one_minus_beta1 = _mm256_set1_ps(1 - beta1);
+  const __m256 mm_beta2 = _mm256_set1_ps(beta2);
+  const __m256 mm_one_minus_beta2 = _mm256_set1_ps(1 - beta2);
+  const __m256 mm_eps_hat = _mm256_set1_ps(eps_hat);
+  const __m256 mm_step = _mm256_set1_ps(lr * correction);
+  auto i = 0;
+  for (; i + kSize <= N; i += kSize) {
+    __m256 gi = _mm256_loadu_ps(g + i);
+    __m256 mi = _mm256_loadu_ps(m + i);
+    __m256 vi = _mm256_loadu_ps(v + i);
+    __m256 wi = _mm256_loadu_ps(w + i);
+
+    __m256 nmi =
+        _mm256_fmadd_ps(mi, mm_beta1, _mm256_mul_ps(gi, mm_one_minus_beta1));
+    __m256 nvi = _mm256_fmadd_ps(
+        vi, mm_beta2, _mm256_mul_ps(_mm256_mul_ps(gi, gi), mm_one_minus_beta2));
+    _mm256_storeu_ps(nm + i, nmi);
+    _mm256_storeu_ps(nv + i, nvi);
+
+    __m256 denominator = _mm256_add_ps(_mm256_sqrt_ps(nvi), mm_eps_hat);
+    __m256 ng = _mm256_div_ps(_mm256_mul_ps(mm_step, nmi), denominator);
+    _mm256_storeu_ps(nw + i, _mm256_add_ps(wi, ng));
+  }
+
+  for (; i < N; ++i) {
+    float gi = g[i];
+    float mi = nm[i] = m[i] * beta1 + gi * (1 - beta1);
+    float vi = nv[i] = v[i] * beta2 + gi * gi * (1 - beta2);
+    float ng = lr * correction * mi / (std::sqrt(vi) + eps_hat);
+    nw[i] = w[i] + ng;
+  }
+}
+
+} // namespace caffe2
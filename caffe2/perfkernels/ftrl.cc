@@ -0,0 +1,160 @@
+#include "caffe2/perfkernels/ftrl.h"
+
+#include <cmath>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+namespace {
+
+inline void FtrlCompute(
+    float w,
+    float n,
+    float z,
+    float g,
+    float* nw,
+    float* nn,
+    float* nz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  const float new_n = n + g * g;
+  const float sqrt_new_n = std::sqrt(new_n);
+  const float sigma = (sqrt_new_n - std::sqrt(n)) * alpha_inv;
+  const float new_z = z + g - sigma * w;
+  *nn = new_n;
+  *nz = new_z;
+  if (std::abs(new_z) > lambda1) {
+    *nw = (std::copysign(lambda1, new_z) - new_z) /
+        ((beta + sqrt_new_n) * alpha_inv + lambda2);
+  } else {
+    *nw = 0;
+  }
+}
+
+} // namespace
+
+void FtrlUpdate__base(
+    int N,
+    const float* w,
+    const float* nz,
+    const float* g,
+    float* new_w,
+    float* new_nz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  for (int i = 0; i < N; ++i) {
+    FtrlCompute(
+        w[i],
+        nz[2 * i],
+        nz[2 * i + 1],
+        g[i],
+        &new_w[i],
+        &new_nz[2 * i],
+        &new_nz[2 * i + 1],
+        alpha_inv,
+        beta,
+        lambda1,
+        lambda2);
+  }
+}
+
+void InterleavedFtrlUpdate__base(
+    int N,
+    const float* wnz,
+    const float* g,
+    float* new_wnz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  for (int i = 0; i < N; ++i) {
+    FtrlCompute(
+        wnz[i],
+        wnz[N + i],
+        wnz[2 * N + i],
+        g[i],
+        &new_wnz[i],
+        &new_wnz[N + i],
+        &new_wnz[2 * N + i],
+        alpha_inv,
+        beta,
+        lambda1,
+        lambda2);
+  }
+}
+
+void FtrlUpdate(
+    int N,
+    const float* w,
+    const float* nz,
+    const float* g,
+    float* new_w,
+    float* new_nz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  AVX2_FMA_DO(
+      FtrlUpdate,
+      N,
+      w,
+      nz,
+      g,
+      new_w,
+      new_nz,
+      alpha_inv,
+      beta,
+      lambda1,
+      lambda2);
+  BASE_DO(
+      FtrlUpdate,
+      N,
+      w,
+      nz,
+      g,
+      new_w,
+      new_nz,
+      alpha_inv,
+      beta,
+      lambda1,
+      lambda2);
+}
+
+void InterleavedFtrlUpdate(
+    int N,
+    const float* wnz,
+    const float* g,
+    float* new_wnz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  AVX2_FMA_DO(
+      InterleavedFtrlUpdate,
+      N,
+      wnz,
+      g,
+      new_wnz,
+      alpha_inv,
+      beta,
+      lambda1,
+      lambda2);
+  BASE_DO(
+      InterleavedFtrlUpdate,
+      N,
+      wnz,
+      g,
+      new_wnz,
+      alpha_inv,
+      beta,
+      lambda1,
+      lambda2);
+}
+
+} // namespace caffe2
@@ -0,0 +1,46 @@
+#pragma once
+
+namespace caffe2 {
+
+/**
+ * FTRL-Proximal update of N coordinates, with the per-coordinate state n and
+ * z interleaved in nz (n[i] at nz[2 * i], z[i] at nz[2 * i + 1]):
+ *
+ *   new_n = n + g * g
+ *   sigma = (sqrt(new_n) - sqrt(n)) * alpha_inv
+ *   new_z = z + g - sigma * w
+ *   new_w = |new_z| > lambda1
+ *       ? (lambda1 * sgn(new_z) - new_z) /
+ *             ((beta + sqrt(new_n)) * alpha_inv + lambda2)
+ *       : 0
+ *
+ * lambda1 has to be non-negative. The outputs may alias the inputs.
+ */
+void FtrlUpdate(
+    int N,
+    const float* w,
+    const float* nz,
+    const float* g,
+    float* new_w,
+    float* new_nz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2);
+
+/**
+ * Same as FtrlUpdate, for the interleaved layout of a row of N coordinates,
+ * where wnz holds w, then n, then z (w[i] at wnz[i], n[i] at wnz[N + i] and
+ * z[i] at wnz[2 * N + i]), so that all of the state of a row is contiguous.
+ */
+void InterleavedFtrlUpdate(
+    int N,
+    const float* wnz,
+    const float* g,
+    float* new_wnz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2);
+
+} // namespace caffe2
@@ -0,0 +1,180 @@
+#include "caffe2/perfkernels/ftrl.h"
+
+#include <cmath>
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+struct FtrlConstants {
+  FtrlConstants(float alpha_inv, float beta, float lambda1, float lambda2)
+      : alpha_inv(_mm256_set1_ps(alpha_inv)),
+        beta(_mm256_set1_ps(beta)),
+        lambda1(_mm256_set1_ps(lambda1)),
+        lambda2(_mm256_set1_ps(lambda2)),
+        sign_mask(_mm256_set1_ps(-0.0f)) {}
+  __m256 alpha_inv;
+  __m256 beta;
+  __m256 lambda1;
+  __m256 lambda2;
+  __m256 sign_mask;
+};
+
+// 8 coordinates of the update in ftrl.h
+inline void FtrlCompute(
+    __m256 w,
+    __m256 n,
+    __m256 z,
+    __m256 g,
+    __m256* nw,
+    __m256* nn,
+    __m256* nz,
+    const FtrlConstants& c) {
+  const __m256 new_n = _mm256_fmadd_ps(g, g, n);
+  const __m256 sqrt_new_n = _mm256_sqrt_ps(new_n);
+  const __m256 sigma =
+      _mm256_mul_ps(_mm256_sub_ps(sqrt_new_n, _mm256_sqrt_ps(n)), c.alpha_inv);
+  const __m256 new_z = _mm256_fnmadd_ps(sigma, w, _mm256_add_ps(z, g));
+  // lambda1 * sgn(new_z), as lambda1 is non-negative and new_z isn't 0 where
+  // it's used
+  const __m256 signed_lambda1 =
+      _mm256_or_ps(_mm256_and_ps(new_z, c.sign_mask), c.lambda1);
+  const __m256 denominator =
+      _mm256_fmadd_ps(_mm256_add_ps(c.beta, sqrt_new_n), c.alpha_inv, c.lambda2);
+  const __m256 mask = _mm256_cmp_ps(
+      _mm256_andnot_ps(c.sign_mask, new_z), c.lambda1, _CMP_GT_OQ);
+  *nn = new_n;
+  *nz = new_z;
+  *nw = _mm256_and_ps(
+      mask, _mm256_div_ps(_mm256_sub_ps(signed_lambda1, new_z), denominator));
+}
+
+inline void FtrlCompute(
+    float w,
+    float n,
+    float z,
+    float g,
+    float* nw,
+    float* nn,
+    float* nz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  const float new_n = n + g * g;
+  const float sqrt_new_n = std::sqrt(new_n);
+  const float sigma = (sqrt_new_n - std::sqrt(n)) * alpha_inv;
+  const float new_z = z + g - sigma * w;
+  *nn = new_n;
+  *nz = new_z;
+  if (std::abs(new_z) > lambda1) {
+    *nw = (std::copysign(lambda1, new_z) - new_z) /
+        ((beta + sqrt_new_n) * alpha_inv + lambda2);
+  } else {
+    *nw = 0;
+  }
+}
+
+} // namespace
+
+void FtrlUpdate__avx2_fma(
+    int N,
+    const float* w,
+    const float* nz,
+    const float* g,
+    float* new_w,
+    float* new_nz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  const FtrlConstants c(alpha_inv, beta, lambda1, lambda2);
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    // Splits the (n, z) pairs of 8 coordinates. Within each 128-bit lane the
+    // shuffle takes pairs 0, 1 of a and b, so the 64-bit halves are swapped
+    // back in order afterwards.
+    const __m256 a = _mm256_loadu_ps(nz + 2 * i);
+    const __m256 b = _mm256_loadu_ps(nz + 2 * i + 8);
+    const __m256 n = _mm256_castpd_ps(_mm256_permute4x64_pd(
+        _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+    const __m256 z = _mm256_castpd_ps(_mm256_permute4x64_pd(
+        _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+    __m256 nw, nn, nzz;
+    FtrlCompute(
+        _mm256_loadu_ps(w + i), n, z, _mm256_loadu_ps(g + i), &nw, &nn, &nzz, c);
+    const __m256 lo = _mm256_unpacklo_ps(nn, nzz);
+    const __m256 hi = _mm256_unpackhi_ps(nn, nzz);
+    _mm256_storeu_ps(new_w + i, nw);
+    _mm256_storeu_ps(new_nz + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(new_nz + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+  for (; i < N; ++i) {
+    FtrlCompute(
+        w[i],
+        nz[2 * i],
+        nz[2 * i + 1],
+        g[i],
+        &new_w[i],
+        &new_nz[2 * i],
+        &new_nz[2 * i + 1],
+        alpha_inv,
+        beta,
+        lambda1,
+        lambda2);
+  }
+}
+
+void InterleavedFtrlUpdate__avx2_fma(
+    int N,
+    const float* wnz,
+    const float* g,
+    float* new_wnz,
+    float alpha_inv,
+    float beta,
+    float lambda1,
+    float lambda2) {
+  const FtrlConstants c(alpha_inv, beta, lambda1, lambda2);
+  const float* w = wnz;
+  const float* n = wnz + N;
+  const float* z = wnz + 2 * N;
+  float* new_w = new_wnz;
+  float* new_n = new_wnz + N;
+  float* new_z = new_wnz + 2 * N;
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    __m256 nw, nn, nz;
+    FtrlCompute(
+        _mm256_loadu_ps(w + i),
+        _mm256_loadu_ps(n + i),
+        _mm256_loadu_ps(z + i),
+        _mm256_loadu_ps(g + i),
+        &nw,
+        &nn,
+        &nz,
+        c);
+    _mm256_storeu_ps(new_w + i, nw);
+    _mm256_storeu_ps(new_n + i, nn);
+    _mm256_storeu_ps(new_z + i, nz);
+  }
+  for (; i < N; ++i) {
+    FtrlCompute(
+        w[i],
+        n[i],
+        z[i],
+        g[i],
+        &new_w[i],
+        &new_n[i],
+        &new_z[i],
+        alpha_inv,
+        beta,
+        lambda1,
+        lambda2);
+  }
+}
+
+} // namespace caffe2
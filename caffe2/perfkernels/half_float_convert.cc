@@ -0,0 +1,31 @@
+#include "caffe2/perfkernels/half_float_convert.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void FloatToFloat16__base(int N, const float* X, float16* Y) {
+  for (int i = 0; i < N; ++i) {
+    Y[i] = convert::cpu_float2half_rn(X[i]);
+  }
+}
+
+void Float16ToFloat__base(int N, const float16* X, float* Y) {
+  for (int i = 0; i < N; ++i) {
+    Y[i] = convert::cpu_half2float(X[i]);
+  }
+}
+
+void FloatToFloat16(int N, const float* X, float16* Y) {
+  AVX_F16C_DO(FloatToFloat16, N, X, Y);
+  BASE_DO(FloatToFloat16, N, X, Y);
+}
+
+void Float16ToFloat(int N, const float16* X, float* Y) {
+  AVX_F16C_DO(Float16ToFloat, N, X, Y);
+  BASE_DO(Float16ToFloat, N, X, Y);
+}
+
+} // namespace caffe2
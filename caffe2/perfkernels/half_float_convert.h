@@ -0,0 +1,14 @@
+#pragma once
+
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+/**
+ * Converts N values from float to float16, rounding to the nearest even
+ * float16, and back. X and Y must not overlap.
+ */
+void FloatToFloat16(int N, const float* X, float16* Y);
+void Float16ToFloat(int N, const float16* X, float* Y);
+
+} // namespace caffe2
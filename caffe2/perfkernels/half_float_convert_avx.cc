@@ -0,0 +1,33 @@
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/cvtsh_ss_bugfix.h"
+#include "caffe2/perfkernels/half_float_convert.h"
+#include "caffe2/utils/conversions.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void FloatToFloat16__avx_f16c(int N, const float* X, float16* Y) {
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    __m128i y = _mm256_cvtps_ph(_mm256_loadu_ps(X + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(Y + i), y);
+  }
+  for (; i < N; ++i) {
+    Y[i] = convert::cpu_float2half_rn(X[i]);
+  }
+}
+
+void Float16ToFloat__avx_f16c(int N, const float16* X, float* Y) {
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(X + i));
+    _mm256_storeu_ps(Y + i, _mm256_cvtph_ps(x));
+  }
+  for (; i < N; ++i) {
+    Y[i] = _cvtsh_ss(X[i].x);
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,31 @@
+#include "caffe2/perfkernels/threshold_filter.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+int64_t FilterGreaterThan__base(
+    const float* x,
+    int64_t n,
+    float threshold,
+    int64_t* indices) {
+  int64_t count = 0;
+  for (int64_t i = 0; i < n; ++i) {
+    if (x[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+int64_t FilterGreaterThan(
+    const float* x,
+    int64_t n,
+    float threshold,
+    int64_t* indices) {
+  AVX2_DO(FilterGreaterThan, x, n, threshold, indices);
+  BASE_DO(FilterGreaterThan, x, n, threshold, indices);
+}
+
+} // namespace caffe2
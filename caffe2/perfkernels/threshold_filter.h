@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace caffe2 {
+
+/**
+ * Writes the positions i of the n values x with x[i] > threshold to indices,
+ * in increasing order, and returns how many there are. indices must have room
+ * for n positions.
+ *
+ * This is the scan of threshold-based selections such as top-k, where few
+ * values pass the threshold.
+ */
+int64_t FilterGreaterThan(
+    const float* x,
+    int64_t n,
+    float threshold,
+    int64_t* indices);
+
+} // namespace caffe2
@@ -0,0 +1,41 @@
+#include "caffe2/perfkernels/threshold_filter.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+int64_t FilterGreaterThan__avx2(
+    const float* x,
+    int64_t n,
+    float threshold,
+    int64_t* indices) {
+  // Compares 32 values at a time, so that the usual case of none of them
+  // passing costs a single test of the combined mask.
+  constexpr int kSize = 32;
+  const __m256 mm_threshold = _mm256_set1_ps(threshold);
+  int64_t count = 0;
+  int64_t i = 0;
+  for (; i + kSize <= n; i += kSize) {
+    const uint32_t mask0 = _mm256_movemask_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(x + i), mm_threshold, _CMP_GT_OQ));
+    const uint32_t mask1 = _mm256_movemask_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(x + i + 8), mm_threshold, _CMP_GT_OQ));
+    const uint32_t mask2 = _mm256_movemask_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(x + i + 16), mm_threshold, _CMP_GT_OQ));
+    const uint32_t mask3 = _mm256_movemask_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(x + i + 24), mm_threshold, _CMP_GT_OQ));
+    uint32_t mask = mask0 | (mask1 << 8) | (mask2 << 16) | (mask3 << 24);
+    while (mask) {
+      indices[count++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  for (; i < n; ++i) {
+    if (x[i] > threshold) {
+      indices[count++] = i;
+    }
+  }
+  return count;
+}
+
+} // namespace caffe2
@@ -0,0 +1,79 @@
+#include "caffe2/perfkernels/winograd.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+namespace {
+
+constexpr int kLanes = kWinogradTiles;
+
+// y = B^T x for the 6 values x[0], x[stride], ..., x[5 * stride] of every
+// tile, and the same for the 4 values of y = A^T x.
+void InputTransform6(const float* x, int stride, float* y, int y_stride) {
+  for (int l = 0; l < kLanes; ++l) {
+    const float x0 = x[l];
+    const float x1 = x[stride + l];
+    const float x2 = x[2 * stride + l];
+    const float x3 = x[3 * stride + l];
+    const float x4 = x[4 * stride + l];
+    const float x5 = x[5 * stride + l];
+    y[l] = 4 * x0 - 5 * x2 + x4;
+    y[y_stride + l] = -4 * (x1 + x2) + x3 + x4;
+    y[2 * y_stride + l] = 4 * (x1 - x2) - x3 + x4;
+    y[3 * y_stride + l] = -2 * (x1 - x3) - x2 + x4;
+    y[4 * y_stride + l] = 2 * (x1 - x3) - x2 + x4;
+    y[5 * y_stride + l] = 4 * x1 - 5 * x3 + x5;
+  }
+}
+
+void OutputTransform6(const float* x, int stride, float* y, int y_stride) {
+  for (int l = 0; l < kLanes; ++l) {
+    const float x0 = x[l];
+    const float x1 = x[stride + l];
+    const float x2 = x[2 * stride + l];
+    const float x3 = x[3 * stride + l];
+    const float x4 = x[4 * stride + l];
+    const float x5 = x[5 * stride + l];
+    y[l] = x0 + x1 + x2 + x3 + x4;
+    y[y_stride + l] = x1 - x2 + 2 * (x3 - x4);
+    y[2 * y_stride + l] = x1 + x2 + 4 * (x3 + x4);
+    y[3 * y_stride + l] = x1 - x2 + 8 * (x3 - x4) + x5;
+  }
+}
+
+} // namespace
+
+void WinogradF4x4_3x3InputTransform__base(const float* d, float* v) {
+  float t[36 * kLanes];
+  // columns, then rows
+  for (int j = 0; j < 6; ++j) {
+    InputTransform6(d + j * kLanes, 6 * kLanes, t + j * kLanes, 6 * kLanes);
+  }
+  for (int i = 0; i < 6; ++i) {
+    InputTransform6(t + i * 6 * kLanes, kLanes, v + i * 6 * kLanes, kLanes);
+  }
+}
+
+void WinogradF4x4_3x3InputTransform(const float* d, float* v) {
+  AVX2_FMA_DO(WinogradF4x4_3x3InputTransform, d, v);
+  BASE_DO(WinogradF4x4_3x3InputTransform, d, v);
+}
+
+void WinogradF4x4_3x3OutputTransform__base(const float* m, float* y) {
+  float t[24 * kLanes];
+  for (int j = 0; j < 6; ++j) {
+    OutputTransform6(m + j * kLanes, 6 * kLanes, t + j * kLanes, 6 * kLanes);
+  }
+  for (int i = 0; i < 4; ++i) {
+    OutputTransform6(t + i * 6 * kLanes, kLanes, y + i * 4 * kLanes, kLanes);
+  }
+}
+
+void WinogradF4x4_3x3OutputTransform(const float* m, float* y) {
+  AVX2_FMA_DO(WinogradF4x4_3x3OutputTransform, m, y);
+  BASE_DO(WinogradF4x4_3x3OutputTransform, m, y);
+}
+
+} // namespace caffe2
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace caffe2 {
+
+// The transforms of Winograd F(4x4, 3x3) convolutions work on this many
+// tiles at once, stored interleaved: element e of tile l is at
+// x[e * kWinogradTiles + l], with the elements of a tile in row major order.
+constexpr int kWinogradTiles = 8;
+
+/**
+ * Input transform of kWinogradTiles 6x6 input tiles d: v = B^T d B, with
+ *
+ *   B^T = | 4  0 -5  0  1  0 |
+ *         | 0 -4 -4  1  1  0 |
+ *         | 0  4 -4 -1  1  0 |
+ *         | 0 -2 -1  2  1  0 |
+ *         | 0  2 -1 -2  1  0 |
+ *         | 0  4  0 -5  0  1 |
+ */
+void WinogradF4x4_3x3InputTransform(const float* d, float* v);
+
+/**
+ * Output transform of kWinogradTiles 6x6 tiles m to 4x4 output tiles:
+ * y = A^T m A, with
+ *
+ *   A^T = | 1  1  1  1  1  0 |
+ *         | 0  1 -1  2 -2  0 |
+ *         | 0  1  1  4  4  0 |
+ *         | 0  1 -1  8 -8  1 |
+ */
+void WinogradF4x4_3x3OutputTransform(const float* m, float* y);
+
+} // namespace caffe2
@@ -0,0 +1,95 @@
+#include "caffe2/perfkernels/winograd.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+static_assert(kWinogradTiles == 8, "one __m256 holds an element of all tiles");
+
+constexpr int kLanes = kWinogradTiles;
+
+void InputTransform6(const float* x, int stride, float* y, int y_stride) {
+  const __m256 x0 = _mm256_loadu_ps(x);
+  const __m256 x1 = _mm256_loadu_ps(x + stride);
+  const __m256 x2 = _mm256_loadu_ps(x + 2 * stride);
+  const __m256 x3 = _mm256_loadu_ps(x + 3 * stride);
+  const __m256 x4 = _mm256_loadu_ps(x + 4 * stride);
+  const __m256 x5 = _mm256_loadu_ps(x + 5 * stride);
+  const __m256 two = _mm256_set1_ps(2);
+  const __m256 four = _mm256_set1_ps(4);
+  const __m256 five = _mm256_set1_ps(5);
+
+  const __m256 x4_minus_x2 = _mm256_sub_ps(x4, x2);
+  const __m256 x1_minus_x3 = _mm256_sub_ps(x1, x3);
+  const __m256 x1_plus_x2 = _mm256_add_ps(x1, x2);
+  const __m256 x1_minus_x2 = _mm256_sub_ps(x1, x2);
+  const __m256 x3_plus_x4 = _mm256_add_ps(x3, x4);
+  const __m256 x4_minus_x3 = _mm256_sub_ps(x4, x3);
+
+  _mm256_storeu_ps(
+      y, _mm256_fnmadd_ps(five, x2, _mm256_fmadd_ps(four, x0, x4)));
+  _mm256_storeu_ps(
+      y + y_stride, _mm256_fnmadd_ps(four, x1_plus_x2, x3_plus_x4));
+  _mm256_storeu_ps(
+      y + 2 * y_stride, _mm256_fmadd_ps(four, x1_minus_x2, x4_minus_x3));
+  _mm256_storeu_ps(
+      y + 3 * y_stride, _mm256_fnmadd_ps(two, x1_minus_x3, x4_minus_x2));
+  _mm256_storeu_ps(
+      y + 4 * y_stride, _mm256_fmadd_ps(two, x1_minus_x3, x4_minus_x2));
+  _mm256_storeu_ps(
+      y + 5 * y_stride,
+      _mm256_fnmadd_ps(five, x3, _mm256_fmadd_ps(four, x1, x5)));
+}
+
+void OutputTransform6(const float* x, int stride, float* y, int y_stride) {
+  const __m256 x0 = _mm256_loadu_ps(x);
+  const __m256 x1 = _mm256_loadu_ps(x + stride);
+  const __m256 x2 = _mm256_loadu_ps(x + 2 * stride);
+  const __m256 x3 = _mm256_loadu_ps(x + 3 * stride);
+  const __m256 x4 = _mm256_loadu_ps(x + 4 * stride);
+  const __m256 x5 = _mm256_loadu_ps(x + 5 * stride);
+
+  const __m256 x1_plus_x2 = _mm256_add_ps(x1, x2);
+  const __m256 x1_minus_x2 = _mm256_sub_ps(x1, x2);
+  const __m256 x3_plus_x4 = _mm256_add_ps(x3, x4);
+  const __m256 x3_minus_x4 = _mm256_sub_ps(x3, x4);
+
+  _mm256_storeu_ps(
+      y, _mm256_add_ps(_mm256_add_ps(x0, x1_plus_x2), x3_plus_x4));
+  _mm256_storeu_ps(
+      y + y_stride,
+      _mm256_fmadd_ps(_mm256_set1_ps(2), x3_minus_x4, x1_minus_x2));
+  _mm256_storeu_ps(
+      y + 2 * y_stride,
+      _mm256_fmadd_ps(_mm256_set1_ps(4), x3_plus_x4, x1_plus_x2));
+  _mm256_storeu_ps(
+      y + 3 * y_stride,
+      _mm256_add_ps(
+          _mm256_fmadd_ps(_mm256_set1_ps(8), x3_minus_x4, x1_minus_x2), x5));
+}
+
+} // namespace
+
+void WinogradF4x4_3x3InputTransform__avx2_fma(const float* d, float* v) {
+  float t[36 * kLanes];
+  for (int j = 0; j < 6; ++j) {
+    InputTransform6(d + j * kLanes, 6 * kLanes, t + j * kLanes, 6 * kLanes);
+  }
+  for (int i = 0; i < 6; ++i) {
+    InputTransform6(t + i * 6 * kLanes, kLanes, v + i * 6 * kLanes, kLanes);
+  }
+}
+
+void WinogradF4x4_3x3OutputTransform__avx2_fma(const float* m, float* y) {
+  float t[24 * kLanes];
+  for (int j = 0; j < 6; ++j) {
+    OutputTransform6(m + j * kLanes, 6 * kLanes, t + j * kLanes, 6 * kLanes);
+  }
+  for (int i = 0; i < 4; ++i) {
+    OutputTransform6(t + i * 6 * kLanes, kLanes, y + i * 4 * kLanes, kLanes);
+  }
+}
+
+} // namespace caffe2
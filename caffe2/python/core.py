@@ -2493,6 +2493,11 @@ class ExecutionStep(object):
         self._assert_can_mutate()
         self._step.num_concurrent_instances = num_concurrent_instances
 
+    def SetNumMicroBatches(self, num_micro_batches):
+        self._assert_can_mutate()
+        assert not self.HasNets(), 'A pipeline must have substeps as stages.'
+        self._step.num_micro_batches = num_micro_batches
+
     def SetOnlyOnce(self, only_once):
         self._assert_can_mutate()
         self._step.only_once = only_once
@@ -2726,7 +2731,8 @@ def execution_step(default_name,
                    only_once=None,
                    num_concurrent_instances=None,
                    create_workspace=False,
-                   run_every_ms=None):
+                   run_every_ms=None,
+                   num_micro_batches=None):
     """
     Helper for creating an ExecutionStep.
     - steps_or_nets can be:
@@ -2740,6 +2746,9 @@ def execution_step(default_name,
       - If specified and true, then this step will return immediately.
       - Be sure to handle race conditions if setting from concurrent threads.
     - if no should_stop_blob or num_iter is provided, defaults to num_iter=1
+    - if num_micro_batches is provided, the substeps are the stages of a
+      pipeline, each running in its own thread over num_micro_batches
+      micro-batches per iteration.
     """
     assert should_stop_blob is None or num_iter is None, (
         'Cannot set both should_stop_blob and num_iter.')
@@ -2764,6 +2773,8 @@ def execution_step(default_name,
         step.SetCreateWorkspace(True)
     if run_every_ms:
         step.RunEveryMillis(run_every_ms)
+    if num_micro_batches is not None:
+        step.SetNumMicroBatches(num_micro_batches)
 
     if isinstance(steps_or_nets, ExecutionStep):
         step.AddSubstep(steps_or_nets)
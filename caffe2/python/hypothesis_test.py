@@ -1272,6 +1272,50 @@ class TestOperators(hu.HypothesisTestCase):
             v += self.ws.blobs[str(counter)].fetch().tolist()
         self.assertEqual(v, truth)
 
+    @given(capacity=st.integers(1, 5),
+           num_iter=st.integers(1, 50))
+    def test_single_producer_single_consumer_blobs_queue(
+            self, capacity, num_iter):
+        init_net = core.Net('init_net')
+        queue = init_net.CreateBlobsQueue(
+            [], 1, capacity=capacity, num_blobs=1,
+            num_writers=1, num_readers=1)
+        counter = init_net.ConstantFill([], 1, value=0.0)
+        const_1 = init_net.ConstantFill([], 1, value=1.0)
+
+        producer_net = core.Net('producer')
+        producer_net.Add([counter, const_1], counter)
+        blob = producer_net.Copy(counter, 1)
+        status = producer_net.NextName()
+        producer_net.SafeEnqueueBlobs([queue, blob], [blob, status])
+        producer_exit_net = core.Net('producer_exit_net')
+        producer_exit_net.CloseBlobsQueue([queue], 0)
+        producer_step = core.execution_step('producer', [
+            core.execution_step('produce', producer_net, num_iter=num_iter),
+            core.execution_step('producer_exit', producer_exit_net)])
+
+        outputs = []
+
+        def append(ins, outs):
+            outputs.extend(ins[0].data.tolist())
+
+        consumer_net = core.Net('consumer')
+        blobs = consumer_net.SafeDequeueBlobs([queue], 2)
+        consumer_net.Python(append)([blobs[0]], 0)
+        consumer_step = core.execution_step(
+            'consumer', consumer_net, should_stop_blob=blobs[1])
+
+        plan = core.Plan('test')
+        plan.AddStep(core.execution_step('init', init_net))
+        plan.AddStep(core.execution_step(
+            'worker', [consumer_step, producer_step],
+            concurrent_substeps=True))
+        self.ws.run(plan)
+        # the records come out in order, none is lost; the last run of the
+        # consumer, which sees the queue closed, outputs a stale record
+        self.assertEqual(
+            outputs[:num_iter], [float(i + 1) for i in range(num_iter)])
+
     @given(num_queues=st.integers(1, 5),
            num_iter=st.integers(5, 10),
            capacity=st.integers(1, 5),
@@ -1709,6 +1753,43 @@ class TestOperators(hu.HypothesisTestCase):
             stat_val = self.ws.blobs[("stats_val")].fetch()
             self.assertEqual(num_iters * num_nets, stat_val[0])
 
+    @given(num_iters=st.integers(1, 4),
+           num_micro_batches=st.integers(1, 8),
+           capacity=st.integers(1, 3))
+    def test_pipelined_execution_step(self, num_iters, num_micro_batches,
+                                      capacity):
+        init_net = core.Net("init_net")
+        queue = init_net.CreateBlobsQueue(
+            [], "queue", capacity=capacity, num_blobs=1)
+        total = init_net.ConstantFill(
+            [], "total", shape=[1], value=0, dtype=core.DataType.INT64)
+        self.ws.create_blob("iter").feed(np.asarray([0]).astype(np.int64))
+
+        # The first stage produces the micro-batches, the second one
+        # accumulates them.
+        produce_net = core.Net("produce_net")
+        produce_net.Iter(["iter"], ["iter"])
+        produce_net.Copy(["iter"], ["micro_batch"])
+        produce_net.EnqueueBlobs([queue, "micro_batch"], ["micro_batch"])
+        consume_net = core.Net("consume_net")
+        consume_net.DequeueBlobs([queue], ["consumed"])
+        consume_net.Add([total, "consumed"], [total])
+
+        pipeline = core.execution_step(
+            "pipeline",
+            [core.execution_step("produce", produce_net),
+             core.execution_step("consume", consume_net)],
+            num_iter=num_iters,
+            num_micro_batches=num_micro_batches)
+        plan = core.Plan("plan")
+        plan.AddStep(core.execution_step("init", init_net))
+        plan.AddStep(pipeline)
+        self.ws.run(plan)
+
+        n = num_iters * num_micro_batches
+        self.assertEqual(self.ws.blobs[("iter")].fetch()[0], n)
+        self.assertEqual(self.ws.blobs[("total")].fetch()[0], n * (n + 1) // 2)
+
 
     @given(a=hu.tensor(),
            src=st.sampled_from(list(viewkeys(_NUMPY_TYPE_TO_ENUM))),
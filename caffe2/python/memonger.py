@@ -158,6 +158,40 @@ def optimize_inference_for_dag(net, input_blobs, namescope=""):
     return optim
 
 
+def share_blobs_by_lifetime(net, static_blobs=None, blob_dimensions=None):
+    '''
+    Shares the memory of the intermediate blobs of a net (forward and
+    backward) whose lifetimes do not overlap, taking blob sizes, types and
+    devices into account, and the operator dependencies for async nets.
+    The shapes are inferred from blob_dimensions, a dictionary of blob
+    dimensions, or from the workspace blobs if it is not given (so run the
+    param init net first). Parameters and other blobs that must keep their
+    own memory go in static_blobs; external inputs and outputs always do.
+
+    Returns the optimized NetDef.
+    '''
+    netproto = net.Proto() if isinstance(net, core.Net) else net
+    start_time = time.time()
+    optim_str, bytes_before, bytes_after = C.memonger_share_blobs_by_lifetime(
+        netproto.SerializeToString(),
+        [str(s).encode('utf-8') for s in (static_blobs or [])],
+        blob_dimensions or {},
+    )
+    log.info(
+        "Memonger shared blobs in {} secs: {:.1f} MB before, {:.1f} MB "
+        "after".format(
+            time.time() - start_time,
+            bytes_before / 1024.0 / 1024.0,
+            bytes_after / 1024.0 / 1024.0,
+        )
+    )
+    optim = caffe2_pb2.NetDef()
+    optim.ParseFromString(optim_str)
+    assert verify_graph_equality(netproto, optim), \
+        "Memonger graph is not equal to original."
+    return optim
+
+
 def estimate_memory_usage(protos, shapes, types, devicescope):
     import numpy as np
     '''
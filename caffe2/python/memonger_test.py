@@ -223,6 +223,45 @@ class MemongerTest(hu.HypothesisTestCase):
         np.testing.assert_almost_equal(loss, optimized_loss)
         np.testing.assert_almost_equal(grad, optimized_grad)
 
+    @given(input_dim=st.integers(min_value=1, max_value=4),
+           output_dim=st.integers(min_value=1, max_value=4),
+           batch_size=st.integers(min_value=1, max_value=4),
+           net_type=st.sampled_from(["simple", "dag"]))
+    def test_share_blobs_by_lifetime(
+            self, input_dim, output_dim, batch_size, net_type):
+        m = model_helper.ModelHelper()
+        m.Proto().type = net_type
+        fc1 = brew.fc(m, "data", "fc1", dim_in=input_dim, dim_out=output_dim)
+        fc2 = brew.fc(m, fc1, "fc2", dim_in=output_dim, dim_out=output_dim)
+        fc3 = brew.fc(m, fc2, "fc3", dim_in=output_dim, dim_out=output_dim)
+        fc3.Relu([], fc3)\
+           .Softmax([], "pred") \
+           .LabelCrossEntropy(["label"], ["xent"]) \
+           .AveragedLoss([], "loss")
+        input_to_grad = m.AddGradientOperators(["loss"])
+
+        data = np.random.randn(batch_size, input_dim).astype(np.float32)
+        label = np.random.randint(
+            low=0, high=output_dim, size=(batch_size,)).astype(np.int32)
+        workspace.RunNetOnce(m.param_init_net)
+        workspace.FeedBlob("data", data)
+        workspace.FeedBlob("label", label)
+        workspace.RunNetOnce(m.net)
+        loss = workspace.FetchBlob("loss")
+        grad = workspace.FetchBlob(str(input_to_grad["fc1_w"]))
+
+        static_blobs = set(str(p) for p in m.params) | \
+            set(str(g) for g in viewvalues(m.param_to_grad)) | \
+            {"data", "label", "loss"}
+        optim_proto = memonger.share_blobs_by_lifetime(m.net, static_blobs)
+        self.assertLess(count_blobs(optim_proto), count_blobs(m.net.Proto()))
+
+        workspace.FeedBlob(str(input_to_grad["fc1_w"]), np.array([0.0]))
+        workspace.RunNetOnce(optim_proto)
+        np.testing.assert_almost_equal(loss, workspace.FetchBlob("loss"))
+        np.testing.assert_almost_equal(
+            grad, workspace.FetchBlob(str(input_to_grad["fc1_w"])))
+
     @unittest.skipIf(not workspace.has_gpu_support, "No gpu support.")
     def test_memonger_mix_cpu_gpu(self):
         '''
@@ -12,6 +12,7 @@ import unittest
 
 from caffe2.python import core
 from caffe2.proto import caffe2_pb2
+import caffe2.python._import_c_extension as C
 
 import onnx
 from onnx.helper import make_node, make_graph, make_tensor, make_tensor_value_info, make_model
@@ -87,6 +88,50 @@ class TestCaffe2Basic(TestCase):
         output = c2_rep.run({"X": X, "Y": Y})
         np.testing.assert_almost_equal(output["W3"], W_ref)
 
+    def test_shared_initializers(self):
+        X = np.random.randn(2, 2).astype(np.float32)
+
+        def model(weight_name, weight):
+            graph_def = make_graph(
+                [make_node("Mul", ["X", weight_name], ["Y"])],
+                name="test_shared_initializers",
+                inputs=[
+                    make_tensor_value_info("X", onnx.TensorProto.FLOAT, (2, 2)),
+                    make_tensor_value_info(
+                        weight_name, onnx.TensorProto.FLOAT, (2, 2)),
+                ],
+                outputs=[
+                    make_tensor_value_info("Y", onnx.TensorProto.FLOAT, (2, 2))
+                ],
+                initializer=[make_tensor(weight_name,
+                                         onnx.TensorProto.FLOAT,
+                                         [2, 2],
+                                         weight.flatten().astype(float))]
+            )
+            return make_model(
+                graph_def, producer_name='caffe2-ref-test').SerializeToString()
+
+        weight = np.array([[1, 2], [3, 4]]).astype(np.float32)
+        other_weight = np.array([[1, 0], [0, 1]]).astype(np.float32)
+        models = [model("w1", weight), model("w2", weight),
+                  model("w1", other_weight)]
+
+        backend = C.Caffe2Backend()
+        # Preparing the same model again hits the cache of converted nets
+        self.assertEqual(backend.prepare(models[0], "CPU", []).pred_net(),
+                         backend.prepare(models[0], "CPU", []).pred_net())
+
+        shared = C.Caffe2SharedInitializers()
+        reps = []
+        for m, w in zip(models, [weight, weight, other_weight]):
+            rep = backend.prepare(m, "CPU", [])
+            rep.share_initializers(shared)
+            np.testing.assert_almost_equal(rep.run([X])[0], X * w)
+            reps.append(rep)
+        self.assertEqual(shared.num_blobs(), 2)
+        del rep, reps
+        self.assertEqual(shared.num_blobs(), 0)
+
     def test_gemm(self):
         # simple
         A = np.random.randn(3, 2).astype(np.float32)
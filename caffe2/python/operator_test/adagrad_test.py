@@ -283,3 +283,88 @@ class TestAdagrad(hu.HypothesisTestCase):
             gc, op,
             [param, momentum, indices, grad, lr],
             ref_row_wise_sparse)
+
+    # Big enough for the rows of unique indices to be updated in parallel,
+    # and with duplicated indices, which have to be updated one after the other.
+    @given(unique=st.booleans(), row_wise=st.booleans(), **hu.gcs_cpu_only)
+    @settings(max_examples=4)
+    def test_sparse_adagrad_many_rows(self, unique, row_wise, gc, dc):
+        num_rows, block_size, n = 4096, 64, 2048
+        epsilon = 1e-5
+        param = np.random.rand(num_rows, block_size).astype(np.float32)
+        if row_wise:
+            momentum = np.random.rand(num_rows).astype(np.float32)
+        else:
+            momentum = np.random.rand(num_rows, block_size).astype(np.float32)
+        if unique:
+            indices = np.random.permutation(num_rows)[:n].astype(np.int64)
+        else:
+            indices = np.random.randint(0, n // 4, size=n).astype(np.int64)
+        grad = np.random.rand(n, block_size).astype(np.float32) - 0.5
+        lr = np.array([0.1], dtype=np.float32)
+
+        op = core.CreateOperator(
+            "RowWiseSparseAdagrad" if row_wise else "SparseAdagrad",
+            ["param", "momentum", "indices", "grad", "lr"],
+            ["param", "momentum"],
+            epsilon=epsilon,
+            device_option=gc)
+
+        def ref_sparse(param, momentum, indices, grad, lr):
+            param_out = np.copy(param)
+            momentum_out = np.copy(momentum)
+            ref = self.ref_row_wise_adagrad if row_wise else self.ref_adagrad
+            for i, index in enumerate(indices):
+                param_out[index], momentum_out[index] = ref(
+                    param_out[index], momentum_out[index], grad[i], lr, epsilon)
+            return (param_out, momentum_out)
+
+        self.assertReferenceChecks(
+            gc, op, [param, momentum, indices, grad, lr], ref_sparse)
+
+    @given(is_mean=st.booleans(), row_wise=st.booleans(),
+           num_rows=st.integers(min_value=1, max_value=20),
+           block_size=st.integers(min_value=1, max_value=10),
+           lengths=st.lists(st.integers(min_value=0, max_value=5),
+                            min_size=1, max_size=6),
+           **hu.gcs_cpu_only)
+    def test_sparse_adagrad_fused_with_sparse_lengths_gradient(
+            self, is_mean, row_wise, num_rows, block_size, lengths, gc, dc):
+        epsilon = 1e-5
+        param = np.random.rand(num_rows, block_size).astype(np.float32)
+        if row_wise:
+            momentum = np.random.rand(num_rows).astype(np.float32)
+        else:
+            momentum = np.random.rand(num_rows, block_size).astype(np.float32)
+        lengths = np.array(lengths, dtype=np.int32)
+        # repeated indices included
+        indices = np.random.randint(
+            0, num_rows, size=np.sum(lengths)).astype(np.int64)
+        grad = np.random.rand(len(lengths), block_size).astype(np.float32)
+        lr = np.array([-0.1], dtype=np.float32)
+
+        op = core.CreateOperator(
+            "{}SparseAdagradFusedWithSparseLengths{}Gradient".format(
+                "RowWise" if row_wise else "", "Mean" if is_mean else "Sum"),
+            ["param", "momentum", "indices", "grad", "lr", "lengths"],
+            ["param", "momentum"],
+            epsilon=epsilon,
+            device_option=gc)
+
+        def ref_fused(param, momentum, indices, grad, lr, lengths):
+            param_out = np.copy(param)
+            momentum_out = np.copy(momentum)
+            ref = self.ref_row_wise_adagrad if row_wise else self.ref_adagrad
+            pos = 0
+            for segment, length in enumerate(lengths):
+                g = grad[segment]
+                if is_mean and length > 1:
+                    g = g / length
+                for index in indices[pos:pos + length]:
+                    param_out[index], momentum_out[index] = ref(
+                        param_out[index], momentum_out[index], g, lr, epsilon)
+                pos += length
+            return (param_out, momentum_out)
+
+        self.assertReferenceChecks(
+            gc, op, [param, momentum, indices, grad, lr, lengths], ref_fused)
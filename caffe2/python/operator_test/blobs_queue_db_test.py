@@ -73,6 +73,49 @@ class BlobsQueueDBTest(unittest.TestCase):
                 self.assertEqual(1, item)
         workspace.RunNetOnce(close_net)
 
+    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support.")
+    def test_tensor_protos_db_input_gpu(self):
+        # the batches are copied to the GPU by the prefetching thread
+        num_samples = 100
+        batch_size = 10
+        init_net = core.Net('init_net')
+        queue = init_net.CreateBlobsQueue([], 'queue', capacity=num_samples)
+        reader = init_net.CreateBlobsQueueDB(
+            [queue], 'blobs_queue_db_reader', value_blob_index=0,
+            timeout_secs=0.1)
+        workspace.RunNetOnce(init_net)
+        blob = core.BlobReference("blob")
+        status = core.BlobReference("blob_status")
+        for i in range(num_samples):
+            item = caffe2_pb2.TensorProtos()
+            data = item.protos.add()
+            data.data_type = core.DataType.FLOAT
+            data.dims.append(2)
+            data.float_data.extend([i, i + 0.5])
+            label = item.protos.add()
+            label.data_type = core.DataType.INT32
+            label.int32_data.append(i)
+            self._add_blob_to_queue(
+                queue, item.SerializeToString(), blob, status)
+
+        net = core.Net('test_tensor_protos_db_input_gpu')
+        net.TensorProtosDBInput(
+            [reader], ['data', 'label'], batch_size=batch_size,
+            device_option=core.DeviceOption(caffe2_pb2.CUDA, 0))
+        workspace.CreateNet(net)
+        for i in range(num_samples // batch_size):
+            with timeout_guard.CompleteInTimeOrDie(2.0):
+                workspace.RunNet(net)
+            first = np.arange(i * batch_size, (i + 1) * batch_size)
+            np.testing.assert_array_equal(
+                workspace.FetchBlob('data'),
+                np.stack([first, first + 0.5], axis=1).astype(np.float32))
+            np.testing.assert_array_equal(workspace.FetchBlob('label'), first)
+
+        close_net = core.Net('close_net')
+        close_net.CloseBlobsQueue([queue], [])
+        workspace.RunNetOnce(close_net)
+
     def _add_blob_to_queue(self, queue, data, blob, status):
         workspace.FeedBlob(blob, data)
         op = core.CreateOperator(
@@ -45,6 +45,24 @@ class TestBooleanMaskOp(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [x, mask], ref)
         self.assertDeviceChecks(dc, op, [x, mask], [0])
 
+    @given(n=st.integers(1, 100000),
+           inner=st.integers(1, 3),
+           dtype=st.sampled_from([np.float32, np.float64, np.int8, np.int16]),
+           p=st.floats(0, 1),
+           **hu.gcs)
+    def test_boolean_mask_long(self, n, inner, dtype, p, gc, dc):
+        # Long masks are compacted in chunks, possibly in parallel.
+        x = (np.random.rand(n, inner) * 100).astype(dtype)
+        mask = np.random.rand(n) < p
+        op = core.CreateOperator("BooleanMask",
+                                 ["data", "mask"],
+                                 ["masked_data", "masked_indices"])
+
+        def ref(x, mask):
+            return (x[mask], np.where(mask)[0])
+
+        self.assertReferenceChecks(gc, op, [x, mask], ref)
+
     @staticmethod
     def _dtype_conversion(x, dtype, gc, dc):
         """SequenceMask only supports fp16 with CUDA."""
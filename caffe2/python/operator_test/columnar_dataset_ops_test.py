@@ -0,0 +1,88 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from caffe2.python import core, workspace
+from caffe2.python.test_util import TestCase
+import os
+import tempfile
+import numpy as np
+
+
+class TestColumnarDataset(TestCase):
+    def setUp(self):
+        super(TestColumnarDataset, self).setUp()
+        self.fields = ['key', 'val:lengths', 'val:values']
+        self.data = [
+            np.array([100, 101, 102], dtype=np.int64),
+            np.array([2, 0, 3], dtype=np.int32),
+            np.arange(10, dtype=np.float32).reshape(5, 2),
+        ]
+        fd, self.path = tempfile.mkstemp()
+        os.close(fd)
+        for name, value in zip(self.fields, self.data):
+            workspace.FeedBlob(name, value)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'WriteColumnarDataset', self.fields, [],
+            path=self.path, fields=self.fields))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'OpenColumnarDataset', [], ['cursor', 'size'], path=self.path))
+
+    def tearDown(self):
+        os.remove(self.path)
+        super(TestColumnarDataset, self).tearDown()
+
+    def _fetch(self):
+        return [workspace.FetchBlob('out_' + n) for n in self.fields]
+
+    def test_read_next_batch(self):
+        self.assertEqual(workspace.FetchBlob('size'), 3)
+        out = ['out_' + n for n in self.fields]
+        op = core.CreateOperator(
+            'ReadNextColumnarBatch', ['cursor'], out, batch_size=2)
+        workspace.RunOperatorOnce(op)
+        key, lengths, values = self._fetch()
+        np.testing.assert_array_equal(key, [100, 101])
+        np.testing.assert_array_equal(lengths, [2, 0])
+        np.testing.assert_array_equal(values, self.data[2][:2])
+        workspace.RunOperatorOnce(op)
+        key, lengths, values = self._fetch()
+        np.testing.assert_array_equal(key, [102])
+        np.testing.assert_array_equal(values, self.data[2][2:])
+        workspace.RunOperatorOnce(op)
+        self.assertEqual(workspace.FetchBlob('out_key').size, 0)
+        self.assertEqual(workspace.FetchBlob('out_val:values').shape, (0, 2))
+
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ResetColumnarCursor', ['cursor'], []))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ReadNextColumnarBatch', ['cursor'], out,
+            batch_size=2, enforce_batch_size=True))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ReadNextColumnarBatch', ['cursor'], out,
+            batch_size=2, enforce_batch_size=True))
+        self.assertEqual(workspace.FetchBlob('out_key').size, 0)
+
+    def test_read_random_batch(self):
+        workspace.FeedBlob('indices', np.array([2, 0, 1], dtype=np.int64))
+        out = ['out_' + n for n in self.fields]
+        op = core.CreateOperator(
+            'ReadRandomColumnarBatch', ['cursor', 'indices'], out,
+            batch_size=2, loop_over=True)
+        workspace.RunOperatorOnce(op)
+        key, lengths, values = self._fetch()
+        np.testing.assert_array_equal(key, [102, 100])
+        np.testing.assert_array_equal(lengths, [3, 2])
+        np.testing.assert_array_equal(
+            values, np.concatenate([self.data[2][2:], self.data[2][:2]]))
+        workspace.RunOperatorOnce(op)
+        key, lengths, values = self._fetch()
+        np.testing.assert_array_equal(key, [101])
+        self.assertEqual(values.shape, (0, 2))
+        workspace.RunOperatorOnce(op)
+        np.testing.assert_array_equal(workspace.FetchBlob('out_key'), [102, 100])
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
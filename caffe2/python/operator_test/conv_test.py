@@ -344,6 +344,115 @@ class TestConvolution(hu.HypothesisTestCase):
         for i in range(len(inputs)):
             self.assertGradientChecks(gc, op, inputs, i, [0])
 
+    @given(pad=st.integers(0, 2),
+           height=st.integers(3, 13),
+           width=st.integers(3, 13),
+           input_channels=st.integers(1, 8),
+           output_channels=st.integers(1, 8),
+           group=st.integers(1, 2),
+           batch_size=st.integers(1, 3),
+           use_bias=st.booleans(),
+           transform_strategy=st.sampled_from(["COMPUTE", "PRECOMPUTE"]))
+    def test_winograd_convolution(self, pad, height, width, input_channels,
+                                  output_channels, group, batch_size,
+                                  use_bias, transform_strategy):
+        input_channels *= group
+        output_channels *= group
+        X = np.random.rand(
+            batch_size, input_channels, height, width).astype(np.float32) - 0.5
+        w = np.random.rand(
+            output_channels, input_channels // group, 3, 3
+        ).astype(np.float32) - 0.5
+        b = np.random.rand(output_channels).astype(np.float32) - 0.5
+        self.ws.create_blob("X").feed(X)
+        self.ws.create_blob("w").feed(w)
+        self.ws.create_blob("b").feed(b)
+
+        outputs = []
+        for engine in ["", "WINOGRAD"]:
+            op = core.CreateOperator(
+                "Conv",
+                ["X", "w", "b"] if use_bias else ["X", "w"],
+                ["Y"],
+                kernel=3,
+                pad=pad,
+                group=group,
+                order="NCHW",
+                engine=engine,
+                convolution_transform_strategy=transform_strategy,
+            )
+            # twice, to also run on the precomputed filters
+            self.ws.run(op)
+            self.ws.run(op)
+            outputs.append(self.ws.blobs["Y"].fetch())
+        np.testing.assert_allclose(outputs[0], outputs[1], atol=1e-4, rtol=1e-4)
+
+    @given(stride=st.integers(1, 3),
+           pad=st.integers(0, 2),
+           kernel=st.integers(1, 5),
+           dilation=st.integers(1, 2),
+           size=st.integers(7, 10),
+           channels=st.integers(2, 6),
+           multiplier=st.integers(1, 2),
+           batch_size=st.integers(1, 3),
+           order=st.sampled_from(["NCHW", "NHWC"]),
+           use_bias=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_depthwise_convolution(self, stride, pad, kernel, dilation, size,
+                                   channels, multiplier, batch_size, order,
+                                   use_bias, gc, dc):
+        dkernel = dilation * (kernel - 1) + 1
+        assume(size + 2 * pad >= dkernel)
+        output_channels = channels * multiplier
+        X = np.random.rand(
+            batch_size, channels, size, size).astype(np.float32) - 0.5
+        w = np.random.rand(
+            output_channels, 1, kernel, kernel).astype(np.float32) - 0.5
+        b = np.random.rand(output_channels).astype(np.float32) - 0.5
+
+        def depthwise_conv_ref(X, w, b=None):
+            if order == "NHWC":
+                X = X.transpose((0, 3, 1, 2))
+                w = w.transpose((0, 3, 1, 2))
+            X = np.pad(X, [(0, 0), (0, 0), (pad, pad), (pad, pad)], "constant")
+            out_size = (X.shape[2] - dkernel) // stride + 1
+            Y = np.zeros(
+                (batch_size, output_channels, out_size, out_size), np.float32)
+            for kh in range(kernel):
+                for kw in range(kernel):
+                    h = kh * dilation
+                    v = kw * dilation
+                    patch = X[:, :, h:h + stride * (out_size - 1) + 1:stride,
+                              v:v + stride * (out_size - 1) + 1:stride]
+                    Y += np.repeat(patch, multiplier, axis=1) * \
+                        w[:, 0, kh, kw].reshape((1, -1, 1, 1))
+            if b is not None:
+                Y += b.reshape((1, -1, 1, 1))
+            if order == "NHWC":
+                Y = Y.transpose((0, 2, 3, 1))
+            return [Y]
+
+        if order == "NHWC":
+            X = X.transpose((0, 2, 3, 1))
+            w = w.transpose((0, 2, 3, 1))
+        inputs = [X, w, b] if use_bias else [X, w]
+        op = core.CreateOperator(
+            "Conv",
+            ["X", "w", "b"] if use_bias else ["X", "w"],
+            ["Y"],
+            stride=stride,
+            kernel=kernel,
+            dilation=dilation,
+            pad=pad,
+            group=channels,
+            order=order,
+            device_option=gc,
+        )
+        self.assertReferenceChecks(gc, op, inputs, depthwise_conv_ref)
+        if order == "NCHW":
+            for i in range(len(inputs)):
+                self.assertGradientChecks(gc, op, inputs, i, [0])
+
     @given(op_type=st.sampled_from(["Conv", "Conv2D"]),
            stride=st.integers(1, 3),
            pad=st.integers(0, 3),
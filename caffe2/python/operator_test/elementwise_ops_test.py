@@ -38,6 +38,29 @@ class TestElementwiseOps(hu.HypothesisTestCase):
         self.assertGradientChecks(
             gc, op, [X, Y], 0, [0], stepsize=1e-4, threshold=1e-2)
 
+    @given(n=st.integers(0, 10), m=st.integers(4, 6),
+           op_type=st.sampled_from(["Sub", "Mul", "Div"]),
+           seed=st.integers(0, 1000), **hu.gcs_gpu_only)
+    def test_binary_fp16(self, n, m, op_type, gc, dc, seed):
+        # float16 inputs are computed in float
+        np.random.seed(seed)
+        X = np.random.rand(n, m).astype(np.float16)
+        Y = (np.random.rand(m) + 1.0).astype(np.float16)
+        ref = {"Sub": np.subtract, "Mul": np.multiply, "Div": np.divide}
+
+        def binary_op(X, Y):
+            return [ref[op_type](X.astype(np.float32), Y.astype(np.float32))
+                    .astype(np.float16)]
+
+        op = core.CreateOperator(op_type, ["X", "Y"], ["Z"], broadcast=1)
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, Y],
+            reference=binary_op,
+            threshold=1e-3,
+        )
+
     @given(n=st.integers(0, 6), m=st.integers(4, 6),
            seed=st.integers(0, 1000), **hu.gcs)
     def test_log(self, n, m, gc, dc, seed):
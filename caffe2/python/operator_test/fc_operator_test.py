@@ -4,7 +4,7 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 from caffe2.proto import caffe2_pb2
-from caffe2.python import core
+from caffe2.python import core, workspace
 from hypothesis import assume, given, settings
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
@@ -97,6 +97,40 @@ class TestFcOperator(hu.HypothesisTestCase):
     def test_fc_transposed(self, **kwargs):
         self._run_test(transposed=True, **kwargs)
 
+    @given(n=st.integers(1, 20),
+           m=st.integers(1, 10),
+           k=st.integers(1, 20),
+           **hu.gcs_cpu_only)
+    def test_fc_packed_weight(self, n, m, k, gc, dc):
+        # The weight is packed from the second run, and repacked when fed
+        # again or updated in place
+        X = np.random.rand(m, k).astype(np.float32) - 0.5
+        W = np.random.rand(n, k).astype(np.float32) - 0.5
+        b = np.random.rand(n).astype(np.float32) - 0.5
+        workspace.FeedBlob('X', X)
+        workspace.FeedBlob('W', W)
+        workspace.FeedBlob('b', b)
+        net = core.Net('fc_packed')
+        net.FC(['X', 'W', 'b'], 'out')
+        scale_net = core.Net('scale_w')
+        scale_net.Scale('W', 'W', scale=2.0)
+        workspace.CreateNet(net)
+        workspace.CreateNet(scale_net)
+
+        def check(W):
+            for _ in range(3):
+                workspace.RunNet(net.Proto().name)
+                np.testing.assert_allclose(
+                    workspace.FetchBlob('out'), np.dot(X, W.T) + b,
+                    rtol=1e-4, atol=1e-4)
+
+        check(W)
+        W = np.random.rand(n, k).astype(np.float32) - 0.5
+        workspace.FeedBlob('W', W)
+        check(W)
+        workspace.RunNet(scale_net.Proto().name)
+        check(2 * W)
+
 
 if __name__ == "__main__":
     import unittest
@@ -0,0 +1,151 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import hypothesis
+from hypothesis import given, settings
+import hypothesis.strategies as st
+import numpy as np
+
+from caffe2.python import core
+import caffe2.python.hypothesis_test_util as hu
+
+
+class TestFtrl(hu.HypothesisTestCase):
+
+    @staticmethod
+    def ref_ftrl(w, n, z, g, alpha, beta, lambda1, lambda2):
+        new_n = n + np.square(g)
+        sigma = (np.sqrt(new_n) - np.sqrt(n)) / alpha
+        new_z = z + g - sigma * w
+        new_w = np.where(
+            np.abs(new_z) > lambda1,
+            (lambda1 * np.sign(new_z) - new_z) /
+            ((beta + np.sqrt(new_n)) / alpha + lambda2),
+            0)
+        return (new_w.astype(np.float32), new_n.astype(np.float32),
+                new_z.astype(np.float32))
+
+    def ref_sparse_ftrl(self, var, n_z, indices, grad, args):
+        var_out = np.copy(var)
+        n_z_out = np.copy(n_z)
+        for i, index in enumerate(indices):
+            w, n, z = self.ref_ftrl(
+                var_out[index], n_z_out[index][..., 0],
+                n_z_out[index][..., 1], grad[i], **args)
+            var_out[index] = w
+            n_z_out[index][..., 0] = n
+            n_z_out[index][..., 1] = z
+        return (var_out, n_z_out)
+
+    def ref_interleaved_sparse_ftrl(self, state, indices, grad, args):
+        var_out, n_z_out = self.ref_sparse_ftrl(
+            state[:, 0], np.stack([state[:, 1], state[:, 2]], axis=-1),
+            indices, grad, args)
+        return (np.stack(
+            [var_out, n_z_out[..., 0], n_z_out[..., 1]], axis=1),)
+
+    @staticmethod
+    def make_inputs(num_rows, block_size, indices):
+        var = np.random.rand(num_rows, block_size).astype(np.float32) - 0.5
+        n_z = np.random.rand(num_rows, block_size, 2).astype(np.float32)
+        n_z[..., 1] -= 0.5
+        grad = np.random.rand(
+            len(indices), block_size).astype(np.float32) - 0.5
+        return var, n_z, grad
+
+    @given(num_rows=st.integers(min_value=1, max_value=20),
+           block_size=st.sampled_from([1, 3, 8, 19]),
+           data_strategy=st.data(),
+           **hu.gcs_cpu_only)
+    def test_sparse_ftrl(self, num_rows, block_size, data_strategy, gc, dc):
+        args = dict(alpha=0.1, beta=1.0, lambda1=0.01, lambda2=0.001)
+        indices = data_strategy.draw(
+            hu.tensor(dtype=np.int64, max_dim=1,
+                      elements=st.sampled_from(np.arange(num_rows))))
+        hypothesis.note('indices: %s' % indices)
+        var, n_z, grad = self.make_inputs(num_rows, block_size, indices)
+
+        op = core.CreateOperator(
+            "SparseFtrl",
+            ["var", "n_z", "indices", "grad"],
+            ["var", "n_z"],
+            device_option=gc,
+            **args)
+
+        self.assertReferenceChecks(
+            gc, op, [var, n_z, indices, grad],
+            lambda var, n_z, indices, grad: self.ref_sparse_ftrl(
+                var, n_z, indices, grad, args))
+
+    @given(num_rows=st.integers(min_value=1, max_value=20),
+           block_size=st.sampled_from([1, 3, 8, 19]),
+           data_strategy=st.data(),
+           **hu.gcs_cpu_only)
+    def test_interleaved_sparse_ftrl(self, num_rows, block_size,
+                                     data_strategy, gc, dc):
+        args = dict(alpha=0.1, beta=1.0, lambda1=0.01, lambda2=0.001)
+        indices = data_strategy.draw(
+            hu.tensor(dtype=np.int64, max_dim=1,
+                      elements=st.sampled_from(np.arange(num_rows))))
+        hypothesis.note('indices: %s' % indices)
+        var, n_z, grad = self.make_inputs(num_rows, block_size, indices)
+        state = np.stack([var, n_z[..., 0], n_z[..., 1]], axis=1)
+        alpha = np.array([args.pop('alpha')], dtype=np.float32)
+
+        op = core.CreateOperator(
+            "InterleavedSparseFtrl",
+            ["state", "indices", "grad", "alpha"],
+            ["state"],
+            device_option=gc,
+            **args)
+
+        self.assertReferenceChecks(
+            gc, op, [state, indices, grad, alpha],
+            lambda state, indices, grad, alpha:
+                self.ref_interleaved_sparse_ftrl(
+                    state, indices, grad, dict(args, alpha=alpha[0])))
+
+    # Big enough for the distinct rows to be updated in parallel, with and
+    # without rows that are updated more than once.
+    @given(unique=st.booleans(), interleaved=st.booleans(),
+           **hu.gcs_cpu_only)
+    @settings(max_examples=4)
+    def test_sparse_ftrl_many_rows(self, unique, interleaved, gc, dc):
+        num_rows, block_size, n = 4096, 64, 2048
+        args = dict(alpha=0.1, beta=1.0, lambda1=0.01, lambda2=0.001)
+        if unique:
+            indices = np.random.permutation(num_rows)[:n].astype(np.int64)
+        else:
+            indices = np.random.randint(0, n // 4, size=n).astype(np.int64)
+        var, n_z, grad = self.make_inputs(num_rows, block_size, indices)
+
+        if interleaved:
+            state = np.stack([var, n_z[..., 0], n_z[..., 1]], axis=1)
+            op = core.CreateOperator(
+                "InterleavedSparseFtrl",
+                ["state", "indices", "grad"],
+                ["state"],
+                device_option=gc,
+                **args)
+            self.assertReferenceChecks(
+                gc, op, [state, indices, grad],
+                lambda state, indices, grad: self.ref_interleaved_sparse_ftrl(
+                    state, indices, grad, args))
+        else:
+            op = core.CreateOperator(
+                "SparseFtrl",
+                ["var", "n_z", "indices", "grad"],
+                ["var", "n_z"],
+                device_option=gc,
+                **args)
+            self.assertReferenceChecks(
+                gc, op, [var, n_z, indices, grad],
+                lambda var, n_z, indices, grad: self.ref_sparse_ftrl(
+                    var, n_z, indices, grad, args))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -0,0 +1,50 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+from hypothesis import given
+import hypothesis.strategies as st
+import caffe2.python.hypothesis_test_util as hu
+from caffe2.python import core
+
+
+class TestFusedElementwise(hu.HypothesisTestCase):
+
+    @given(n=st.integers(min_value=1, max_value=3000),
+           inplace=st.booleans(),
+           **hu.gcs)
+    def test_binary_and_unary(self, n, inplace, gc, dc):
+        X = np.random.randn(n).astype(np.float32)
+        H = np.random.randn(n).astype(np.float32)
+        exprs = ["Mul 0 1", "Sigmoid 2", "Add 3 0", "Tanh 4", "Sub 5 1",
+                 "Relu 6", "Negative 7", "Abs 8"]
+        op = core.CreateOperator(
+            "FusedElementwise", ["X", "H"], ["X" if inplace else "Y"],
+            exprs=exprs)
+
+        def ref(X, H):
+            y = np.tanh(1 / (1 + np.exp(-X * H)) + X) - H
+            return (np.abs(-np.maximum(y, 0)),)
+
+        self.assertReferenceChecks(gc, op, [X, H], ref)
+        self.assertDeviceChecks(dc, op, [X, H], [0])
+
+    @given(X=hu.tensor(elements=st.floats(min_value=0.5, max_value=2)),
+           **hu.gcs)
+    def test_positive_inputs(self, X, gc, dc):
+        exprs = ["Log 0", "Sqrt 0", "Div 1 2", "Exp 3"]
+        op = core.CreateOperator(
+            "FusedElementwise", ["X"], ["Y"], exprs=exprs)
+
+        def ref(X):
+            return (np.exp(np.log(X) / np.sqrt(X)),)
+
+        self.assertReferenceChecks(gc, op, [X], ref)
+        self.assertDeviceChecks(dc, op, [X], [0])
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
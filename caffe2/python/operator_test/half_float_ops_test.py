@@ -0,0 +1,34 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from hypothesis import given
+import hypothesis.strategies as st
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+
+class TestHalfFloatOps(hu.HypothesisTestCase):
+    @given(n=st.integers(0, 100), **hu.gcs_cpu_only)
+    def test_float_to_half_round_trip(self, n, gc, dc):
+        # the vectorized conversion covers blocks of 8, the tail is scalar
+        X = (np.random.randn(n) * 1000).astype(np.float32)
+        workspace.FeedBlob("X", X)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "FloatToHalf", ["X"], ["H"], device_option=gc))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "HalfToFloat", ["H"], ["Y"], device_option=gc))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("H").view(np.uint16),
+            X.astype(np.float16).view(np.uint16))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("Y"), X.astype(np.float16).astype(np.float32))
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
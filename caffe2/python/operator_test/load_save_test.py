@@ -455,6 +455,44 @@ class TestLoadSave(TestLoadSaveBase):
             if e.errno != errno.ENOENT:
                 raise
 
+    def testSaveLoadSharded(self):
+        tmp_folder = tempfile.mkdtemp()
+        db_file = os.path.join(tmp_folder, "db")
+        workspace.ResetWorkspace()
+        arrays = [np.random.rand(i + 1, 3).astype(np.float32)
+                  for i in range(7)]
+        for i, arr in enumerate(arrays):
+            self.assertTrue(workspace.FeedBlob(str(i), arr))
+        op = core.CreateOperator(
+            "Save",
+            [str(i) for i in range(len(arrays))], [],
+            absolute_path=1,
+            db=db_file, db_type=self._db_type,
+            num_shards=3)
+        self.assertTrue(workspace.RunOperatorOnce(op))
+        for shard in range(3):
+            self.assertTrue(
+                os.path.exists(db_file + ".shard_{}".format(shard)))
+
+        for load_all in [True, False]:
+            workspace.ResetWorkspace()
+            self.assertEqual(len(workspace.Blobs()), 0)
+            op = core.CreateOperator(
+                "Load",
+                [], [] if load_all else [str(i) for i in range(len(arrays))],
+                absolute_path=1,
+                db=db_file, db_type=self._db_type,
+                load_all=load_all)
+            self.assertTrue(workspace.RunOperatorOnce(op))
+            self.assertEqual(len(workspace.Blobs()), len(arrays))
+            for i, arr in enumerate(arrays):
+                np.testing.assert_array_equal(workspace.FetchBlob(str(i)), arr)
+        try:
+            shutil.rmtree(tmp_folder)
+        except OSError as e:
+            if e.errno != errno.ENOENT:
+                raise
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,72 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from hypothesis import given
+import hypothesis.strategies as st
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+
+class TestLossScaleOps(hu.HypothesisTestCase):
+    @given(n=st.integers(1, 100),
+           dtype=st.sampled_from([np.float32, np.float16]),
+           found_inf=st.booleans(),
+           **hu.gcs)
+    def test_unscale_gradients(self, n, dtype, found_inf, gc, dc):
+        scale = np.array([1024.], dtype=np.float32)
+        G1 = (np.random.randn(n) * 100).astype(dtype)
+        G2 = (np.random.randn(3, n) * 100).astype(np.float32)
+        if found_inf:
+            G2[1, n // 2] = np.inf
+        workspace.FeedBlob("scale", scale, device_option=gc)
+        workspace.FeedBlob("G1", G1, device_option=gc)
+        workspace.FeedBlob("G2", G2, device_option=gc)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "UnscaleGradients", ["scale", "G1", "G2"],
+            ["G1", "G2_unscaled", "found_inf"], device_option=gc))
+        self.assertEqual(workspace.FetchBlob("found_inf")[0], found_inf)
+        if found_inf:
+            np.testing.assert_array_equal(
+                workspace.FetchBlob("G1"), np.zeros_like(G1))
+            np.testing.assert_array_equal(
+                workspace.FetchBlob("G2_unscaled"), np.zeros_like(G2))
+        else:
+            np.testing.assert_allclose(
+                workspace.FetchBlob("G1").astype(np.float32),
+                (G1.astype(np.float32) / scale[0]).astype(dtype),
+                rtol=1e-3, atol=1e-6)
+            np.testing.assert_allclose(
+                workspace.FetchBlob("G2_unscaled"), G2 / scale[0], rtol=1e-6)
+
+    @given(**hu.gcs)
+    def test_update_loss_scale(self, gc, dc):
+        workspace.FeedBlob(
+            "scale", np.array([1024.], dtype=np.float32), device_option=gc)
+        workspace.FeedBlob(
+            "steps", np.array([0], dtype=np.int64), device_option=gc)
+        op = core.CreateOperator(
+            "UpdateLossScale", ["scale", "found_inf", "steps"],
+            ["scale", "steps"], growth_interval=3, device_option=gc)
+
+        def step(found_inf, expected_scale, expected_steps):
+            workspace.FeedBlob(
+                "found_inf", np.array([found_inf]), device_option=gc)
+            workspace.RunOperatorOnce(op)
+            self.assertEqual(workspace.FetchBlob("scale")[0], expected_scale)
+            self.assertEqual(workspace.FetchBlob("steps")[0], expected_steps)
+
+        step(False, 1024., 1)
+        step(True, 512., 0)
+        step(False, 512., 1)
+        step(False, 512., 2)
+        step(False, 1024., 0)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
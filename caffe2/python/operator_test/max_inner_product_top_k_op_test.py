@@ -0,0 +1,81 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+from hypothesis import given
+import hypothesis.strategies as st
+import caffe2.python.hypothesis_test_util as hu
+from caffe2.python import core, workspace
+
+
+def max_inner_product_top_k_ref(queries, items, k):
+    scores = queries.dot(items.T)
+    # Greatest scores first, ties going to the lower index.
+    order = np.lexsort(
+        (np.tile(np.arange(items.shape[0]), (queries.shape[0], 1)), -scores))
+    indices = order[:, :k].astype(np.int64)
+    return (scores[np.arange(queries.shape[0])[:, None], indices], indices)
+
+
+class TestMaxInnerProductTopK(hu.HypothesisTestCase):
+    # Small integers keep the scores exact, whatever the summation order, and
+    # give plenty of ties.
+    @given(num_queries=st.integers(1, 5),
+           num_items=st.integers(1, 3000),
+           dim=st.integers(1, 32),
+           k=st.integers(1, 100),
+           block_size=st.sampled_from([1, 37, 1024]),
+           **hu.gcs_cpu_only)
+    def test_max_inner_product_top_k(
+            self, num_queries, num_items, dim, k, block_size, gc, dc):
+        k = min(k, num_items)
+        queries = np.random.randint(
+            -4, 5, size=(num_queries, dim)).astype(np.float32)
+        items = np.random.randint(
+            -4, 5, size=(num_items, dim)).astype(np.float32)
+        op = core.CreateOperator(
+            "MaxInnerProductTopK", ["queries", "items"],
+            ["values", "indices"], k=k, block_size=block_size)
+
+        def ref(queries, items):
+            return max_inner_product_top_k_ref(queries, items, k)
+
+        self.assertReferenceChecks(gc, op, [queries, items], ref)
+        self.assertReferenceChecks(
+            gc, op, [queries, items.astype(np.float16)], ref)
+
+    @given(num_queries=st.integers(1, 5),
+           num_items=st.integers(1, 3000),
+           dim=st.integers(2, 32),
+           k=st.integers(1, 100),
+           **hu.gcs_cpu_only)
+    def test_fused_8bit_rowwise_items(
+            self, num_queries, num_items, dim, k, gc, dc):
+        k = min(k, num_items)
+        queries = np.random.randint(
+            -4, 5, size=(num_queries, dim)).astype(np.float32)
+        # Rows spanning [0, 255] quantize exactly.
+        items = np.random.randint(
+            0, 256, size=(num_items, dim)).astype(np.float32)
+        items[:, 0] = 0
+        items[:, 1] = 255
+        workspace.FeedBlob("items_float", items)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "FloatToFused8BitRowwiseQuantized", ["items_float"],
+            ["items_8bit"]))
+        items_8bit = workspace.FetchBlob("items_8bit")
+        op = core.CreateOperator(
+            "MaxInnerProductTopK", ["queries", "items"],
+            ["values", "indices"], k=k, block_size=100)
+
+        def ref(queries, _):
+            return max_inner_product_top_k_ref(queries, items, k)
+
+        self.assertReferenceChecks(gc, op, [queries, items_8bit], ref)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
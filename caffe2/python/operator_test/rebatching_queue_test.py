@@ -165,6 +165,46 @@ class TestReBatchingQueue(TestCase):
                 workspace.FetchBlob(tensors[idx])[:5]
             )
 
+    def test_rebatching_queue_bucketing(self):
+        net = core.Net('net')
+
+        lengths = [1, 4, 2, 5, 7]
+        sequences = []
+        for i, length in enumerate(lengths):
+            name = 'sequence_%d' % i
+            workspace.FeedBlob(
+                name, np.full((length, 2), i + 1, dtype=np.float32)
+            )
+            sequences.append(name)
+
+        queue = net.CreateRebatchingQueue(
+            [], 1, capacity=10, num_blobs=1, bucket_boundaries=[3, 6]
+        )
+        for sequence in sequences:
+            net.EnqueueRebatchingQueue([queue, sequence], [])
+        net.CloseRebatchingQueue([queue], 0)
+
+        results = [
+            net.DequeueRebatchingQueue([queue], 2, num_elements=2)
+            for _ in range(3)
+        ]
+
+        workspace.RunNetOnce(net)
+
+        # the short sequences come together, padded to the longest one
+        data, batch_lengths = [workspace.FetchBlob(b) for b in results[0]]
+        npt.assert_array_equal(batch_lengths, [1, 2])
+        npt.assert_array_equal(
+            data, [[[1, 1], [0, 0]], [[3, 3], [3, 3]]]
+        )
+        data, batch_lengths = [workspace.FetchBlob(b) for b in results[1]]
+        npt.assert_array_equal(batch_lengths, [4, 5])
+        self.assertEquals(data.shape, (2, 5, 2))
+        # the last bucket is only returned once the queue is closed
+        data, batch_lengths = [workspace.FetchBlob(b) for b in results[2]]
+        npt.assert_array_equal(batch_lengths, [7])
+        self.assertEquals(data.shape, (1, 7, 2))
+
     @given(
         num_producers=st.integers(1, 5),
         num_consumers=st.integers(1, 5),
@@ -379,3 +379,58 @@ class RecurrentNetworkTest(hu.HypothesisTestCase):
             workspace.FetchBlob(output_states_2),
             decimal=3,
         )
+
+    @given(T=st.integers(1, 4),
+           n=st.integers(1, 5),
+           d=st.integers(1, 5),
+           forward_only=st.booleans())
+    def test_input_projection(self, T, n, d, forward_only):
+        '''
+        The step net FC over the input is precomputed for the whole sequence
+        when the op is forward only; the results must not change.
+        '''
+        model = ModelHelper(name='external')
+        workspace.ResetWorkspace()
+
+        input_blob, initial_input_blob, w, b = model.net.AddExternalInputs(
+            'input', 'initial_input', 'w', 'b')
+
+        step = ModelHelper(name='step', param_model=model)
+        input_t, output_t_prev = step.net.AddExternalInput(
+            'input_t', 'output_t_prev')
+        step.net.AddExternalInputs(w, b)
+        projection_t = step.net.FC([input_t, w, b], 'projection_t', axis=2)
+        output_t = step.net.Tanh(
+            step.net.Sum([projection_t, output_t_prev]), 'output_t')
+        step.net.AddExternalOutput(output_t)
+
+        output_all, output_last = recurrent.recurrent_net(
+            net=model.net,
+            cell_net=step.net,
+            inputs=[(input_t, input_blob)],
+            initial_cell_inputs=[(output_t_prev, initial_input_blob)],
+            links={output_t_prev: output_t},
+            scope="test_rnn_input_projection",
+            forward_only=forward_only,
+        )
+
+        inputs = np.random.randn(T, n, d).astype(np.float32)
+        initial_input = np.random.randn(1, n, d).astype(np.float32)
+        weights = np.random.randn(d, d).astype(np.float32)
+        bias = np.random.randn(d).astype(np.float32)
+        workspace.blobs[input_blob] = inputs
+        workspace.blobs[initial_input_blob] = initial_input
+        workspace.blobs[w] = weights
+        workspace.blobs[b] = bias
+        workspace.RunNetOnce(model.net)
+
+        expected = np.zeros((T, n, d), dtype=np.float32)
+        state = initial_input[0]
+        for t in range(T):
+            state = np.tanh(inputs[t].dot(weights.T) + bias + state)
+            expected[t] = state
+        np.testing.assert_allclose(
+            workspace.FetchBlob(output_all), expected, rtol=1e-4, atol=1e-4)
+        np.testing.assert_allclose(
+            workspace.FetchBlob(output_last).reshape(n, d), expected[-1],
+            rtol=1e-4, atol=1e-4)
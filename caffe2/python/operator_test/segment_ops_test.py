@@ -4,7 +4,7 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 from functools import partial
-from hypothesis import given
+from hypothesis import given, settings
 
 import numpy as np
 import unittest
@@ -558,6 +558,44 @@ class TestSegmentOps(hu.HypothesisTestCase):
         self.assertReferenceChecks(
             gc, op, [D, W, indices, L], ref_sparse)
 
+    # Enough segments and values for the segments to be reduced on the
+    # workspace thread pool
+    @given(reducer=st.sampled_from(["Sum", "Mean", "Max", "WeightedSum"]),
+           **hu.gcs_cpu_only)
+    @settings(max_examples=4)
+    def test_lengths_ops_many_segments(self, reducer, gc, dc):
+        L = np.random.randint(0, 8, size=2000).astype(np.int32)
+        L[np.random.randint(0, len(L), size=3)] = 1000
+        D = np.random.rand(np.sum(L), 64).astype(np.float32)
+        W = np.random.rand(np.sum(L)).astype(np.float32)
+        weighted = reducer == "WeightedSum"
+        op = core.CreateOperator(
+            "Lengths" + reducer,
+            ["D", "W", "L"] if weighted else ["D", "L"],
+            "out")
+
+        def ref(D, *args):
+            L = args[-1]
+            out = np.zeros((len(L), D.shape[1]), dtype=np.float32)
+            offsets = np.cumsum(np.concatenate([[0], L]))
+            for i in range(len(L)):
+                if L[i] == 0:
+                    continue
+                rows = D[offsets[i]:offsets[i + 1]]
+                if reducer == "Sum":
+                    out[i] = np.sum(rows, axis=0)
+                elif reducer == "Mean":
+                    out[i] = np.mean(rows, axis=0)
+                elif reducer == "Max":
+                    out[i] = np.max(rows, axis=0)
+                else:
+                    weights = args[0][offsets[i]:offsets[i + 1]]
+                    out[i] = np.dot(weights, rows)
+            return (out,)
+
+        self.assertReferenceChecks(
+            gc, op, [D, W, L] if weighted else [D, L], ref, threshold=1e-3)
+
    # @given(
    #     inputs=hu.lengths_tensor(
    #         dtype=np.float32,
@@ -62,6 +62,42 @@ class TestTextFileReader(TestCase):
                         else:
                             np.testing.assert_array_equal(col_batch, results[i])
 
+    def test_text_file_reader_numeric_fields(self):
+        schema = Struct(
+            ('field1', Scalar(dtype=np.int32)),
+            ('field2', Scalar(dtype=np.int64)),
+            ('field3', Scalar(dtype=np.float64)))
+        col_data = [
+            [1, -2, 2147483647, 0],
+            [-9223372036854775807, 5, 6, 7],
+            [1.5, -0.25, 1e10, 3.0],
+        ]
+        row_data = list(zip(*col_data))
+        with tempfile.NamedTemporaryFile(mode='w+', delete=False) as txt_file:
+            # no newline after the last row
+            txt_file.write('\n'.join(
+                '\t'.join(str(x) for x in f) for f in row_data))
+            txt_file.flush()
+
+            init_net = core.Net('init_net')
+            reader = TextFileReader(
+                init_net,
+                filename=txt_file.name,
+                schema=schema,
+                batch_size=3)
+            workspace.RunNetOnce(init_net)
+            net = core.Net('read_net')
+            should_stop, record = reader.read_record(net)
+            results = [[] for _ in col_data]
+            while True:
+                workspace.RunNetOnce(net)
+                for i, array in enumerate(FetchRecord(record).field_blobs()):
+                    results[i].extend(array.tolist())
+                if workspace.FetchBlob(should_stop):
+                    break
+            for i in range(len(col_data)):
+                np.testing.assert_array_equal(col_data[i], results[i])
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
@@ -183,6 +183,22 @@ class TestTopK(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [X], bind_ref)
         self.assertDeviceChecks(dc, op, [X], [0])
 
+    @given(bs=st.integers(1, 2), n=st.integers(5000, 100000),
+           k=st.integers(1, 200), **hu.gcs_cpu_only)
+    def test_top_k_long_rows_with_ties(self, bs, n, k, gc, dc):
+        # Long rows go through the threshold-based selection; the few distinct
+        # values check that ties resolve to the lower index.
+        X = np.random.randint(0, 100, size=(bs, n)).astype(np.float32)
+        op = core.CreateOperator("TopK", ["X"], ["Values", "Indices"],
+                                 k=k, device_option=gc)
+
+        def bind_ref(X_loc):
+            order = np.lexsort((np.tile(np.arange(n), (bs, 1)), -X_loc))
+            indices = order[:, :k].astype(np.int64)
+            return (X_loc[np.arange(bs)[:, None], indices], indices)
+
+        self.assertReferenceChecks(gc, op, [X], bind_ref)
+
     @given(X=hu.tensor(dtype=np.float32), k=st.integers(1, 5),
            axis=st.integers(-1, 5), flatten_indices=st.booleans(),
            **hu.gcs)
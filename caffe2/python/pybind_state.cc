@@ -12,6 +12,8 @@
 #include "caffe2/core/stats.h"
 #include "caffe2/core/transform.h"
 #include "caffe2/mkl/mkl_utils.h"
+#include "caffe2/observers/calibration_observer.h"
+#include "caffe2/observers/perf_counter_observer.h"
 #include "caffe2/observers/runcnt_observer.h"
 #include "caffe2/observers/time_observer.h"
 #include "caffe2/onnx/backend.h"
@@ -156,12 +158,12 @@ const Func& getGradientFunc(const std::string& token) {
   return getOpFunc(token + "_gradient");
 }
 
-py::object fetchBlob(Workspace* ws, const std::string& name) {
+py::object fetchBlob(Workspace* ws, const std::string& name, bool copy) {
   CAFFE_ENFORCE(ws->HasBlob(name), "Can't find blob: ", name);
   const caffe2::Blob& blob = *(ws->GetBlob(name));
   auto fetcher = CreateFetcher(blob.meta().id());
   if (fetcher) {
-    return fetcher->Fetch(blob);
+    return copy ? fetcher->Fetch(blob) : fetcher->FetchShared(blob);
   } else {
     // If there is no fetcher registered, return a metainfo string.
     // If all branches failed, we will return a metainfo string.
@@ -258,6 +260,34 @@ void addObjectMethods(py::module& m) {
                 cast_ob, "Observer does not implement this function.");
             return cast_ob->average_time_children();
           })
+      .def(
+          "quantization_params",
+          [](ObserverBase<NetBase>* ob,
+             const std::string& method,
+             float percentile) {
+            auto* cast_ob = dynamic_cast_if_rtti<CalibrationNetObserver*>(ob);
+            CAFFE_ENFORCE(
+                cast_ob, "Observer does not implement this function.");
+            CalibrationMethod calibration_method;
+            if (method == "min_max") {
+              calibration_method = CalibrationMethod::MIN_MAX;
+            } else if (method == "percentile") {
+              calibration_method = CalibrationMethod::PERCENTILE;
+            } else if (method == "kl") {
+              calibration_method = CalibrationMethod::KL_DIVERGENCE;
+            } else {
+              CAFFE_THROW("Unknown calibration method ", method);
+            }
+            std::map<std::string, std::pair<float, int32_t>> result;
+            for (const auto& entry :
+                 cast_ob->quantizationParams(calibration_method, percentile)) {
+              result[entry.first] =
+                  std::make_pair(entry.second.scale, entry.second.zero_point);
+            }
+            return result;
+          },
+          py::arg("method") = "kl",
+          py::arg("percentile") = 99.99f)
       .def("debug_info", [](ObserverBase<NetBase>* ob) {
         return ob->debugInfo();
       });
@@ -449,7 +479,11 @@ void addObjectMethods(py::module& m) {
             return py::cast(self->CreateBlob(name));
           },
           py::return_value_policy::reference_internal)
-      .def("fetch_blob", &python_detail::fetchBlob)
+      .def(
+          "fetch_blob",
+          &python_detail::fetchBlob,
+          py::arg("name"),
+          py::arg("copy") = true)
       .def(
           "has_blob",
           [](Workspace* self, const std::string& name) {
@@ -608,8 +642,21 @@ void addObjectMethods(py::module& m) {
         return c2ops;
       }));
 
+  py::class_<
+      caffe2::onnx::SharedInitializers,
+      std::shared_ptr<caffe2::onnx::SharedInitializers>>(
+      m, "Caffe2SharedInitializers")
+      .def(py::init<>())
+      .def("num_blobs", &caffe2::onnx::SharedInitializers::NumBlobs);
+
   py::class_<caffe2::onnx::Caffe2BackendRep>(m, "Caffe2BackenRep")
       .def(py::init<>())
+      .def(
+          "share_initializers",
+          [](caffe2::onnx::Caffe2BackendRep& instance,
+             std::shared_ptr<caffe2::onnx::SharedInitializers> shared) {
+            instance.ShareInitializers(shared);
+          })
       .def(
           "init_net",
           [](caffe2::onnx::Caffe2BackendRep& instance) {
@@ -1030,12 +1077,24 @@ void addGlobalMethods(py::module& m) {
         REGISTER_PYTHON_EXPOSED_OBSERVER(TimeObserver);
 #undef REGISTER_PYTHON_EXPOSED_OBSERVER
 
+        if (observer_type.compare("CalibrationObserver") == 0) {
+          unique_ptr<CalibrationNetObserver> net_ob =
+              make_unique<CalibrationNetObserver>(net);
+          observer = net->AttachObserver(std::move(net_ob));
+        }
+
         if (observer_type.compare("RunCountObserver") == 0) {
           unique_ptr<RunCountNetObserver> net_ob =
               make_unique<RunCountNetObserver>(net);
           observer = net->AttachObserver(std::move(net_ob));
         }
 
+        if (observer_type.compare("PerfCounterObserver") == 0) {
+          unique_ptr<PerfCounterNetObserver> net_ob =
+              make_unique<PerfCounterNetObserver>(net);
+          observer = net->AttachObserver(std::move(net_ob));
+        }
+
         CAFFE_ENFORCE(observer != nullptr);
         return py::cast(observer);
       });
@@ -1212,6 +1271,32 @@ void addGlobalMethods(py::module& m) {
         CAFFE_ENFORCE(optimized.SerializeToString(&protob));
         return py::bytes(protob);
       });
+  m.def(
+      "memonger_share_blobs_by_lifetime",
+      [](const py::bytes& net_def,
+         const std::vector<std::string>& static_blobs,
+         const std::map<std::string, std::vector<TIndex>>& blob_dimensions) {
+        NetDef def;
+        CAFFE_ENFORCE(
+            ParseProtoFromLargeString(net_def.cast<std::string>(), &def));
+        std::vector<NetDef*> nets{&def};
+        // Shapes of the workspace blobs, unless they are given.
+        TensorShapes shapes = blob_dimensions.empty()
+            ? InferBlobShapesAndTypesFromWorkspace(gWorkspace, nets)
+            : InferBlobShapesAndTypesFromMap(blob_dimensions, nets);
+        std::set<string> static_blobs_set(
+            static_blobs.begin(), static_blobs.end());
+        memonger::SharingStats stats;
+        std::string protob;
+        {
+          py::gil_scoped_release g;
+          NetDef optimized = caffe2::memonger::share_blobs_by_lifetime(
+              def, static_blobs_set, shapes, &stats);
+          CAFFE_ENFORCE(optimized.SerializeToString(&protob));
+        }
+        return std::make_tuple(
+            py::bytes(protob), stats.bytes_before, stats.bytes_after);
+      });
   m.def(
       "infer_shapes_and_types_from_workspace",
       [](const std::vector<py::bytes>& net_protos) {
@@ -1258,9 +1343,13 @@ void addGlobalMethods(py::module& m) {
     CAFFE_ENFORCE(gWorkspace->CreateBlob(name));
     return true;
   });
-  m.def("fetch_blob", [](const std::string& name) -> py::object {
-    return python_detail::fetchBlob(gWorkspace, name);
-  });
+  m.def(
+      "fetch_blob",
+      [](const std::string& name, bool copy) -> py::object {
+        return python_detail::fetchBlob(gWorkspace, name, copy);
+      },
+      py::arg("name"),
+      py::arg("copy") = true);
   m.def(
       "feed_blob",
       [](const std::string& name, py::object arg, py::object device_option) {
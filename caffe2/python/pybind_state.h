@@ -48,6 +48,11 @@ class BlobFetcherBase {
   };
   virtual ~BlobFetcherBase();
   virtual pybind11::object Fetch(const Blob& blob) = 0;
+  // Like Fetch, but may return a read-only view of the blob's memory instead
+  // of a copy. The default copies.
+  virtual pybind11::object FetchShared(const Blob& blob) {
+    return Fetch(blob);
+  }
 };
 
 class BlobFeederBase {
@@ -94,6 +99,58 @@ class TensorFetcher : public BlobFetcherBase {
     return FetchTensor(blob.Get<Tensor<Context>>(), true).obj;
   }
 
+  pybind11::object FetchShared(const Blob& blob) override {
+    const auto& tensor = blob.Get<Tensor<Context>>();
+    if (NeedsCopy(tensor.meta())) {
+      return Fetch(blob);
+    }
+    CAFFE_ENFORCE_GE(tensor.size(), 0, "Trying to fetch unitilized tensor");
+    const int numpy_type = CaffeToNumpyType(tensor.meta());
+    CAFFE_ENFORCE(
+        numpy_type != -1,
+        "This tensor's data type is not supported: ",
+        tensor.meta().name(),
+        ".");
+    std::vector<npy_intp> npy_dims;
+    for (const auto dim : tensor.dims()) {
+      npy_dims.push_back(dim);
+    }
+    // The array's base owns a tensor sharing the blob's memory, so that the
+    // memory outlives a later reallocation of the blob. The array is read-only
+    // since writing to it would modify the blob behind the net's back.
+    auto* shared = new Tensor<Context>();
+    shared->ResizeLike(tensor);
+    shared->ShareData(tensor);
+    auto base = py::reinterpret_steal<py::object>(
+        PyCapsule_New(shared, nullptr, [](PyObject* capsule) {
+          delete static_cast<Tensor<Context>*>(
+              PyCapsule_GetPointer(capsule, nullptr));
+        }));
+    if (!base) {
+      delete shared;
+      throw py::error_already_set();
+    }
+    auto obj = py::reinterpret_steal<py::object>(PyArray_New(
+        &PyArray_Type,
+        tensor.ndim(),
+        npy_dims.data(),
+        numpy_type,
+        nullptr,
+        const_cast<void*>(shared->raw_data()),
+        0,
+        NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_ALIGNED,
+        nullptr));
+    if (!obj) {
+      throw py::error_already_set();
+    }
+    if (PyArray_SetBaseObject(
+            reinterpret_cast<PyArrayObject*>(obj.ptr()), base.release()) ==
+        -1) {
+      throw py::error_already_set();
+    }
+    return obj;
+  }
+
   bool NeedsCopy(const TypeMeta& meta) const {
     return !std::is_same<Context, CPUContext>::value ||
         CaffeToNumpyType(meta) == NPY_OBJECT;
@@ -331,7 +388,8 @@ class PythonOpBase : public Operator<Context> {
             DLPackWrapper<Context> wrapper(
                 const_cast<Tensor<Context>*>(
                     &blob->template Get<Tensor<Context>>()),
-                this->device_option());
+                this->device_option(),
+                &context_);
             py_obj = py::cast(wrapper, py::return_value_policy::copy);
           } else {
             py_obj = py::cast(
@@ -382,7 +440,8 @@ class PythonOpBase : public Operator<Context> {
           if (use_dlpack) {
             DLPackWrapper<Context> wrapper(
                 blob->template GetMutable<Tensor<Context>>(),
-                this->device_option());
+                this->device_option(),
+                &context_);
             py_obj = py::cast(wrapper, py::return_value_policy::copy);
           } else {
             py_obj = py::cast(
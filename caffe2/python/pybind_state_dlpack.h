@@ -23,8 +23,11 @@ const TypeMeta& DLTypeToCaffe(const DLDataType& dl_type);
 template <class Context>
 class DLPackWrapper {
  public:
-  DLPackWrapper(Tensor<Context>* tensor, DeviceOption device_option)
-      : tensor(tensor), device_option(device_option) {}
+  DLPackWrapper(
+      Tensor<Context>* tensor,
+      DeviceOption device_option,
+      Context* context = nullptr)
+      : tensor(tensor), device_option(device_option), context(context) {}
 
   py::object data() {
     DLContext tensor_context;
@@ -81,8 +84,10 @@ class DLPackWrapper {
         device_type_ptr,
         "Unsupported device type: ",
         device_option.device_type());
+    // pinned host memory is fed to CPU tensors without a copy
     CAFFE_ENFORCE(
-        dlTensor->ctx.device_type == *device_type_ptr,
+        dlTensor->ctx.device_type == *device_type_ptr ||
+            (*device_type_ptr == kCPU && dlTensor->ctx.device_type == kCPUPinned),
         "DLPack tensor device type mismatch");
     int dlpack_device_id = dlTensor->ctx.device_id;
     CAFFE_ENFORCE_EQ(
@@ -122,6 +127,9 @@ class DLPackWrapper {
 
   Tensor<Context>* tensor;
   DeviceOption device_option;
+  // context of the operator the tensor belongs to, which orders the uses of
+  // CUDA tensors on its stream
+  Context* context;
   DLManagedTensor managed_tensor;
 };
 
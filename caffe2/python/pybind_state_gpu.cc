@@ -65,16 +65,42 @@ void addCUDAObjectMethods(py::module& m) {
             return t->data();
           },
           "Return DLPack tensor with tensor's data.")
+      .def_property_readonly(
+          "stream",
+          [](DLPackWrapper<CUDAContext>* t) -> uintptr_t {
+            CAFFE_ENFORCE(t->context, "Tensor has no operator context");
+            return reinterpret_cast<uintptr_t>(t->context->cuda_stream());
+          },
+          "cudaStream_t of the operator, on which the tensor data is "
+          "produced and consumed.")
       .def(
           "feed",
-          [](DLPackWrapper<CUDAContext>* t, py::object obj) {
+          [](DLPackWrapper<CUDAContext>* t, py::object obj, uintptr_t stream) {
             CAFFE_ENFORCE_EQ(
                 t->device_option.device_type(),
                 CUDA,
                 "Expected CUDA device option for CUDA tensor");
             t->feed(obj);
+            if (stream) {
+              // order the work of the producer before the next work of the
+              // operator, without synchronizing the host
+              CAFFE_ENFORCE(t->context, "Tensor has no operator context");
+              DeviceGuard g(t->device_option.cuda_gpu_id());
+              cudaEvent_t event;
+              CUDA_ENFORCE(
+                  cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+              CUDA_ENFORCE(
+                  cudaEventRecord(event, reinterpret_cast<cudaStream_t>(stream)));
+              CUDA_ENFORCE(
+                  cudaStreamWaitEvent(t->context->cuda_stream(), event, 0));
+              CUDA_ENFORCE(cudaEventDestroy(event));
+            }
           },
-          "Copy data from given DLPack tensor into this tensor.")
+          "Copy data from given DLPack tensor into this tensor. The work "
+          "queued on the producer stream, the cudaStream_t of the data as an "
+          "integer, is ordered before the next work of the operator.",
+          py::arg("obj"),
+          py::arg("stream") = 0)
       .def_property_readonly(
           "_shape",
           [](const DLPackWrapper<CUDAContext>& t) { return t.tensor->dims(); })
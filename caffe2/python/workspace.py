@@ -328,15 +328,18 @@ def FetchBlobs(names):
     return [FetchBlob(name) for name in names]
 
 
-def FetchBlob(name):
+def FetchBlob(name, copy=True):
     """Fetches a blob from the workspace.
 
     Inputs:
       name: the name of the blob - a string or a BlobReference
+      copy: if False, a CPU tensor is returned as a read-only numpy array
+        sharing the blob's memory, without copying it. The array keeps that
+        memory alive, but reflects later in-place writes to the blob.
     Returns:
       Fetched blob (numpy array or string) if successful
     """
-    result = C.fetch_blob(StringifyBlobName(name))
+    result = C.fetch_blob(StringifyBlobName(name), copy)
     if isinstance(result, tuple):
         raise TypeError(
             "Use FetchInt8Blob to fetch Int8 Blob {}".format(
@@ -151,6 +151,19 @@ class TestWorkspace(unittest.TestCase):
         self.assertEqual(fetched_again.shape, (1, 2, 3, 4))
         np.testing.assert_array_equal(fetched_again, 2.0)
 
+    def testFetchBlobWithoutCopy(self):
+        self.assertEqual(
+            workspace.RunNetOnce(self.net.Proto().SerializeToString()), True)
+        fetched = workspace.FetchBlob("testblob", copy=False)
+        self.assertEqual(fetched.shape, (1, 2, 3, 4))
+        np.testing.assert_array_equal(fetched, 1.0)
+        self.assertFalse(fetched.flags.writeable)
+        with self.assertRaises(ValueError):
+            fetched[:] = 2.0
+        # the array keeps the old memory alive when the blob is replaced
+        workspace.FeedBlob("testblob", np.zeros((10, 10), dtype=np.float32))
+        np.testing.assert_array_equal(fetched, 1.0)
+
     def testFetchFeedBlobViaBlobReference(self):
         self.assertEqual(
             workspace.RunNetOnce(self.net.Proto().SerializeToString()), True)
@@ -5,6 +5,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
 
 #include "caffe2/core/blob_stats.h"
 #include "caffe2/core/logging.h"
@@ -22,14 +23,22 @@ static constexpr uint64_t SDT_TIMEOUT = (uint64_t)-1;
 static constexpr uint64_t SDT_ABORT = (uint64_t)-2;
 static constexpr uint64_t SDT_CANCEL = (uint64_t)-3;
 
+// Number of times a side of an spsc queue polls the other one before
+// sleeping
+static constexpr int kSpscSpinCount = 128;
+
 BlobsQueue::BlobsQueue(
     Workspace* ws,
     const std::string& queueName,
     size_t capacity,
     size_t numBlobs,
     bool enforceUniqueName,
-    const std::vector<std::string>& fieldNames)
-    : numBlobs_(numBlobs), name_(queueName), stats_(queueName) {
+    const std::vector<std::string>& fieldNames,
+    bool singleProducerSingleConsumer)
+    : numBlobs_(numBlobs),
+      spsc_(singleProducerSingleConsumer),
+      name_(queueName),
+      stats_(queueName) {
   if (!fieldNames.empty()) {
     CAFFE_ENFORCE_EQ(
         fieldNames.size(), numBlobs, "Wrong number of fieldNames provided.");
@@ -57,13 +66,16 @@ BlobsQueue::BlobsQueue(
 bool BlobsQueue::blockingRead(
     const std::vector<Blob*>& inputs,
     float timeout_secs) {
+  if (spsc_) {
+    return spscRead(inputs, timeout_secs);
+  }
   Timer readTimer;
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
   CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
   std::unique_lock<std::mutex> g(mutex_);
   auto canRead = [this]() {
-    CAFFE_ENFORCE_LE(reader_, writer_);
+    CAFFE_ENFORCE_LE(reader_.load(), writer_.load());
     return reader_ != writer_;
   };
   // Decrease queue balance before reading to indicate queue read pressure
@@ -102,7 +114,120 @@ bool BlobsQueue::blockingRead(
   return true;
 }
 
+bool BlobsQueue::spscRead(
+    const std::vector<Blob*>& inputs,
+    float timeout_secs) {
+  Timer readTimer;
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
+  CAFFE_EVENT(stats_, queue_balance, -1);
+  // only this thread moves reader_, the writer publishes writer_ after
+  // filling the slot
+  const auto reader = reader_.load(std::memory_order_relaxed);
+  auto canRead = [this, reader]() { return writer_.load() != reader; };
+  if (!spscWait(canRead, timeout_secs)) {
+    if (timeout_secs > 0 && !closing_) {
+      LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_TIMEOUT);
+    } else {
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_CANCEL);
+    }
+    return false;
+  }
+  auto& result = queue_[reader % queue_.size()];
+  CAFFE_ENFORCE(inputs.size() >= result.size());
+  for (auto i = 0; i < result.size(); ++i) {
+    auto bytes = BlobStat::sizeBytes(*result[i]);
+    CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
+  CAFFE_SDT(queue_read_end, name, (void*)this, writer_ - reader);
+  CAFFE_EVENT(stats_, queue_dequeued_records);
+  reader_.store(reader + 1);
+  spscNotify();
+  CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
+  return true;
+}
+
+bool BlobsQueue::spscWrite(const std::vector<Blob*>& inputs, bool blocking) {
+  Timer writeTimer;
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(
+      queue_write_start,
+      name,
+      (void*)this,
+      blocking ? SDT_BLOCKING_OP : SDT_NONBLOCKING_OP);
+  const auto writer = writer_.load(std::memory_order_relaxed);
+  const int64_t size = queue_.size();
+  auto canWrite = [this, writer, size]() {
+    return writer - reader_.load() < size;
+  };
+  if (blocking) {
+    CAFFE_EVENT(stats_, queue_balance, 1);
+  }
+  if (!(blocking ? spscWait(canWrite, 0) : canWrite())) {
+    CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
+    return false;
+  }
+  if (!blocking) {
+    CAFFE_EVENT(stats_, queue_balance, 1);
+  }
+  auto& result = queue_[writer % size];
+  CAFFE_ENFORCE(inputs.size() >= result.size());
+  for (auto i = 0; i < result.size(); ++i) {
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
+  CAFFE_SDT(queue_write_end, name, (void*)this, reader_ + size - writer);
+  writer_.store(writer + 1);
+  spscNotify();
+  CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
+  return true;
+}
+
+bool BlobsQueue::spscWait(
+    const std::function<bool()>& ready,
+    float timeout_secs) {
+  for (int i = 0; i < kSpscSpinCount; ++i) {
+    if (ready()) {
+      return true;
+    }
+    if (closing_) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  std::unique_lock<std::mutex> g(mutex_);
+  // The other side publishes its index before checking waiters_, and we
+  // count ourselves before checking the index, so either it sees us
+  // waiting or we see its update.
+  ++waiters_;
+  if (timeout_secs > 0) {
+    std::chrono::milliseconds timeout_ms(int(timeout_secs * 1000));
+    cv_.wait_for(g, timeout_ms, [this, &ready]() {
+      return closing_ || ready();
+    });
+  } else {
+    cv_.wait(g, [this, &ready]() { return closing_ || ready(); });
+  }
+  --waiters_;
+  return ready();
+}
+
+void BlobsQueue::spscNotify() {
+  if (waiters_.load() > 0) {
+    std::lock_guard<std::mutex> g(mutex_);
+    cv_.notify_all();
+  }
+}
+
 bool BlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
+  if (spsc_) {
+    return spscWrite(inputs, false);
+  }
   Timer writeTimer;
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
@@ -122,6 +247,9 @@ bool BlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
 }
 
 bool BlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
+  if (spsc_) {
+    return spscWrite(inputs, true);
+  }
   Timer writeTimer;
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
@@ -151,8 +279,8 @@ void BlobsQueue::close() {
 bool BlobsQueue::canWrite() {
   // writer is always within [reader, reader + size)
   // we can write if reader is within [reader, reader + size)
-  CAFFE_ENFORCE_LE(reader_, writer_);
-  CAFFE_ENFORCE_LE(writer_, reader_ + queue_.size());
+  CAFFE_ENFORCE_LE(reader_.load(), writer_.load());
+  CAFFE_ENFORCE_LE(writer_.load(), reader_ + queue_.size());
   return writer_ != reader_ + queue_.size();
 }
 
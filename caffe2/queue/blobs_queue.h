@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -20,6 +21,12 @@ namespace caffe2 {
 // Containing blobs are owned by the workspace.
 // On read, we swap out the underlying data for the blob passed in for blobs
 
+// A queue created for a single producer and a single consumer doesn't take
+// the mutex to read or write: each side owns its index and publishes it to
+// the other one, and only waits on the condition variable after spinning
+// for a while on an empty (or full) queue. Reading or writing such a queue
+// from more than one thread at a time is undefined.
+
 class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
  public:
   BlobsQueue(
@@ -28,7 +35,8 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
       size_t capacity,
       size_t numBlobs,
       bool enforceUniqueName,
-      const std::vector<std::string>& fieldNames = {});
+      const std::vector<std::string>& fieldNames = {},
+      bool singleProducerSingleConsumer = false);
 
   ~BlobsQueue() {
     close();
@@ -48,13 +56,23 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
   bool canWrite();
   void doWrite(const std::vector<Blob*>& inputs);
 
+  // single producer single consumer mode
+  bool spscRead(const std::vector<Blob*>& inputs, float timeout_secs);
+  bool spscWrite(const std::vector<Blob*>& inputs, bool blocking);
+  bool spscWait(const std::function<bool()>& ready, float timeout_secs);
+  void spscNotify();
+
   std::atomic<bool> closing_{false};
 
   size_t numBlobs_;
-  std::mutex mutex_; // protects all variables in the class.
+  const bool spsc_;
+  std::mutex mutex_; // protects all variables in the class (but the indices
+                     // in spsc mode).
   std::condition_variable cv_;
-  int64_t reader_{0};
-  int64_t writer_{0};
+  std::atomic<int64_t> reader_{0};
+  std::atomic<int64_t> writer_{0};
+  // threads sleeping on cv_ in spsc mode
+  std::atomic<int> waiters_{0};
   std::vector<std::vector<Blob*>> queue_;
   const std::string name_;
 
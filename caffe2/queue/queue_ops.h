@@ -24,12 +24,21 @@ class CreateBlobsQueueOp final : public Operator<Context> {
         GetSingleArgument("enforce_unique_name", false);
     const auto fieldNames =
         OperatorBase::template GetRepeatedArgument<std::string>("field_names");
+    const auto singleProducerSingleConsumer =
+        GetSingleArgument("num_writers", 0) == 1 &&
+        GetSingleArgument("num_readers", 0) == 1;
     CAFFE_ENFORCE_EQ(this->OutputSize(), 1);
     auto queuePtr = Operator<Context>::Outputs()[0]
                         ->template GetMutable<std::shared_ptr<BlobsQueue>>();
     CAFFE_ENFORCE(queuePtr);
     *queuePtr = std::make_shared<BlobsQueue>(
-        ws_, name, capacity, numBlobs, enforceUniqueName, fieldNames);
+        ws_,
+        name,
+        capacity,
+        numBlobs,
+        enforceUniqueName,
+        fieldNames,
+        singleProducerSingleConsumer);
     return true;
   }
 
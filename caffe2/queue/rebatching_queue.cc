@@ -1,4 +1,10 @@
 #include "rebatching_queue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
 #include "caffe2/utils/smart_tensor_printer.h"
 
 namespace caffe2 {
@@ -63,6 +69,59 @@ void concat(
   }
 }
 
+// Concatenates elements whose tensors may differ in their first dimension:
+// the tensors are padded with zeros (default values for non-POD types) at
+// the end of their first dimension up to the longest one of the batch.
+void concatPadded(
+    CPUContext& context,
+    const std::vector<std::vector<TensorCPU>>& inputs,
+    const std::vector<TensorCPU*>& outputs) {
+  CAFFE_ENFORCE(!inputs.empty());
+
+  const auto& inputZero = inputs[0];
+  const auto numTensors = inputZero.size();
+  const auto numRows = inputs.size();
+  CAFFE_ENFORCE_EQ(outputs.size(), numTensors);
+
+  for (int j = 0; j < numTensors; ++j) {
+    auto outputDims = inputZero[j].dims();
+    for (int i = 0; i < numRows; ++i) {
+      const auto& input = inputs[i][j];
+      CAFFE_ENFORCE(inputZero[j].meta() == input.meta());
+      CAFFE_ENFORCE_EQ(inputZero[j].ndim(), input.ndim());
+      for (int k = 1; k < input.ndim(); ++k) {
+        CAFFE_ENFORCE_EQ(input.dims()[k], inputZero[j].dims()[k]);
+      }
+      if (input.ndim() > 0) {
+        outputDims[0] = std::max(outputDims[0], input.dims()[0]);
+      }
+    }
+    const auto rowSize = std::accumulate(
+        outputDims.begin(),
+        outputDims.end(),
+        TIndex(1),
+        std::multiplies<TIndex>());
+    outputDims.insert(outputDims.begin(), numRows);
+
+    const auto& meta = inputZero[j].meta();
+    outputs[j]->Resize(outputDims);
+    auto* destination = static_cast<char*>(outputs[j]->raw_mutable_data(meta));
+    if (!meta.ctor()) {
+      memset(destination, 0, outputs[j]->nbytes());
+    }
+    for (int i = 0; i < numRows; ++i) {
+      const auto& input = inputs[i][j];
+      if (input.size() > 0) {
+        context.CopyItems<CPUContext, CPUContext>(
+            meta,
+            input.size(),
+            input.raw_data() /* src */,
+            destination + i * rowSize * meta.itemsize() /* dst */);
+      }
+    }
+  }
+}
+
 std::vector<std::vector<TensorCPU>> split(
     CPUContext& context,
     const std::vector<const TensorCPU*>& inputs) {
@@ -100,11 +159,33 @@ std::vector<std::vector<TensorCPU>> split(
 RebatchingQueue::RebatchingQueue(size_t capacity, size_t numBlobs)
     : capacity_(capacity), numBlobs_(numBlobs), queue_(capacity) {}
 
+RebatchingQueue::RebatchingQueue(
+    size_t capacity,
+    size_t numBlobs,
+    std::vector<int64_t> bucketBoundaries,
+    size_t lengthBlob,
+    size_t maxTokens)
+    : capacity_(capacity),
+      numBlobs_(numBlobs),
+      bucketBoundaries_(std::move(bucketBoundaries)),
+      lengthBlob_(lengthBlob),
+      maxTokens_(maxTokens),
+      buckets_(bucketBoundaries_.size() + 1) {
+  CAFFE_ENFORCE(!bucketBoundaries_.empty());
+  CAFFE_ENFORCE(
+      std::is_sorted(bucketBoundaries_.begin(), bucketBoundaries_.end()),
+      "Bucket boundaries should be sorted");
+  CAFFE_ENFORCE_LT(lengthBlob_, numBlobs_);
+}
+
 RebatchingQueue::~RebatchingQueue() {
   close();
 }
 
 bool RebatchingQueue::canRead() const {
+  if (isBucketing()) {
+    return numBucketed_ > 0;
+  }
   return tail_ < head_;
 }
 
@@ -112,6 +193,10 @@ bool RebatchingQueue::dequeue(
     CPUContext& context,
     size_t numElements,
     const std::vector<TensorCPU*>& outputs) {
+  if (isBucketing()) {
+    return dequeueBucketed(context, numElements, outputs);
+  }
+
   std::vector<std::vector<TensorCPU>> results;
   results.reserve(numElements);
 
@@ -151,7 +236,126 @@ bool RebatchingQueue::dequeue(
   return true;
 }
 
+size_t RebatchingQueue::batchSize(
+    const std::deque<BucketElement>& bucket,
+    size_t numElements) const {
+  size_t count = 0;
+  TIndex maxLength = 0;
+  for (const auto& element : bucket) {
+    if (count == numElements) {
+      break;
+    }
+    const auto length = std::max(maxLength, element.length);
+    // a batch always holds at least one element, even over the budget
+    if (count > 0 && maxTokens_ > 0 && (count + 1) * static_cast<size_t>(length) > maxTokens_) {
+      break;
+    }
+    maxLength = length;
+    ++count;
+  }
+  return count;
+}
+
+int RebatchingQueue::readyBucket(size_t numElements) const {
+  // A bucket is ready when it fills a batch, either in elements or in
+  // tokens. The oldest ready bucket goes first.
+  int ready = -1;
+  for (int i = 0; i < buckets_.size(); ++i) {
+    const auto& bucket = buckets_[i];
+    if (bucket.empty()) {
+      continue;
+    }
+    const auto count = batchSize(bucket, numElements);
+    if ((count == numElements || count < bucket.size()) &&
+        (ready < 0 || bucket.front().id < buckets_[ready].front().id)) {
+      ready = i;
+    }
+  }
+  if (ready >= 0 || numBucketed_ == 0) {
+    return ready;
+  }
+  // No batch is complete. A full queue can't get any element until we
+  // dequeue, so the fullest bucket goes; a closed one is drained oldest
+  // first.
+  int best = -1;
+  for (int i = 0; i < buckets_.size(); ++i) {
+    const auto& bucket = buckets_[i];
+    if (bucket.empty()) {
+      continue;
+    }
+    if (best < 0) {
+      best = i;
+    } else if (isClosed_) {
+      if (bucket.front().id < buckets_[best].front().id) {
+        best = i;
+      }
+    } else if (bucket.size() > buckets_[best].size()) {
+      best = i;
+    }
+  }
+  return isClosed_ || !canWrite() ? best : -1;
+}
+
+bool RebatchingQueue::dequeueBucketed(
+    CPUContext& context,
+    size_t numElements,
+    const std::vector<TensorCPU*>& outputs) {
+  CAFFE_ENFORCE_GT(numElements, 0);
+  CAFFE_ENFORCE(
+      outputs.size() == numBlobs_ || outputs.size() == numBlobs_ + 1,
+      "Expected ",
+      numBlobs_,
+      " outputs, and optionally the lengths, got ",
+      outputs.size());
+
+  std::vector<std::vector<TensorCPU>> results;
+  std::vector<int> lengths;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    int bucketId = -1;
+    cvEmpty_.wait(lock, [this, numElements, &bucketId] {
+      bucketId = readyBucket(numElements);
+      return bucketId >= 0 || (isClosed_ && !canRead());
+    });
+
+    if (bucketId < 0) {
+      return false;
+    }
+
+    auto& bucket = buckets_[bucketId];
+    const auto count = batchSize(bucket, numElements);
+    results.reserve(count);
+    lengths.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      lengths.push_back(static_cast<int>(bucket.front().length));
+      results.push_back(std::move(bucket.front().tensors));
+      bucket.pop_front();
+    }
+    numBucketed_ -= count;
+  }
+
+  cvOverflow_.notify_all();
+
+  std::vector<TensorCPU*> tensorOutputs(
+      outputs.begin(), outputs.begin() + numBlobs_);
+  concatPadded(context, results, tensorOutputs);
+  if (outputs.size() > numBlobs_) {
+    auto* lengthsOutput = outputs.back();
+    lengthsOutput->Resize(lengths.size());
+    std::copy(
+        lengths.begin(),
+        lengths.end(),
+        lengthsOutput->template mutable_data<int>());
+  }
+
+  return true;
+}
+
 bool RebatchingQueue::canWrite() const {
+  if (isBucketing()) {
+    return numBucketed_ < capacity();
+  }
   return tail_ + capacity() > head_;
 }
 
@@ -181,6 +385,10 @@ bool RebatchingQueue::enqueueMany(
 
 bool RebatchingQueue::enqueue(
     std::vector<std::vector<TensorCPU>> splittedInputs) {
+  if (isBucketing()) {
+    return enqueueBucketed(std::move(splittedInputs));
+  }
+
   int idx = 0;
   for (;;) {
     if (idx >= splittedInputs.size()) {
@@ -209,6 +417,46 @@ bool RebatchingQueue::enqueue(
   return true;
 }
 
+bool RebatchingQueue::enqueueBucketed(
+    std::vector<std::vector<TensorCPU>> splittedInputs) {
+  int idx = 0;
+  while (idx < splittedInputs.size()) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+
+      cvOverflow_.wait(lock, [this] { return canWrite() || isClosed_; });
+
+      if (isClosed_) {
+        return false;
+      }
+
+      do {
+        auto& tensors = splittedInputs[idx++];
+        CAFFE_ENFORCE_EQ(tensors.size(), numBlobs_);
+        const auto& lengthTensor = tensors[lengthBlob_];
+        CAFFE_ENFORCE_GT(
+            lengthTensor.ndim(),
+            0,
+            "The length blob of a bucketing queue should have a first "
+            "dimension");
+        const auto length = lengthTensor.dim(0);
+        const auto bucketId = std::upper_bound(
+                                  bucketBoundaries_.begin(),
+                                  bucketBoundaries_.end(),
+                                  length) -
+            bucketBoundaries_.begin();
+        buckets_[bucketId].push_back(
+            BucketElement{nextId_++, length, std::move(tensors)});
+        ++numBucketed_;
+      } while (canWrite() && idx < splittedInputs.size());
+    }
+
+    cvEmpty_.notify_all();
+  }
+
+  return true;
+}
+
 size_t RebatchingQueue::capacity() const {
   return capacity_;
 }
@@ -217,6 +465,10 @@ size_t RebatchingQueue::numBlobs() const {
   return numBlobs_;
 }
 
+bool RebatchingQueue::isBucketing() const {
+  return !bucketBoundaries_.empty();
+}
+
 bool RebatchingQueue::isClosed() const {
   std::lock_guard<std::mutex> g(mutex_);
   return isClosed_;
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -21,6 +22,20 @@ class RebatchingQueue {
  public:
   RebatchingQueue(size_t capacity, size_t numBlobs);
 
+  // Bucketing mode, for variable-length elements: the length of an element
+  // is the first dimension of its component lengthBlob. Elements are kept in
+  // buckets by length, bucket i holding the lengths in
+  // [bucketBoundaries[i - 1], bucketBoundaries[i]), and a dequeue takes its
+  // elements from a single bucket, so that they need little padding. A
+  // batch is limited to maxTokens (number of elements times the longest
+  // length) when maxTokens > 0.
+  RebatchingQueue(
+      size_t capacity,
+      size_t numBlobs,
+      std::vector<int64_t> bucketBoundaries,
+      size_t lengthBlob,
+      size_t maxTokens);
+
   ~RebatchingQueue();
 
   bool enqueueOne(
@@ -40,6 +55,8 @@ class RebatchingQueue {
 
   size_t numBlobs() const;
 
+  bool isBucketing() const;
+
   bool isClosed() const;
 
   void close();
@@ -50,6 +67,23 @@ class RebatchingQueue {
   bool canWrite() const;
   bool canRead() const;
 
+  struct BucketElement {
+    uint64_t id;
+    TIndex length;
+    std::vector<TensorCPU> tensors;
+  };
+
+  bool enqueueBucketed(std::vector<std::vector<TensorCPU>> splittedInputs);
+  bool dequeueBucketed(
+      CPUContext& context,
+      size_t numElements,
+      const std::vector<TensorCPU*>& outputs);
+  // Number of elements of the bucket's front that fit in a batch
+  size_t batchSize(const std::deque<BucketElement>& bucket, size_t numElements)
+      const;
+  // Bucket to dequeue from, or -1 if none is worth a batch yet
+  int readyBucket(size_t numElements) const;
+
   const size_t capacity_;
   const size_t numBlobs_;
 
@@ -64,5 +98,13 @@ class RebatchingQueue {
   std::condition_variable cvOverflow_;
 
   std::vector<std::vector<TensorCPU>> queue_;
+
+  // bucketing mode only
+  const std::vector<int64_t> bucketBoundaries_;
+  const size_t lengthBlob_{0};
+  const size_t maxTokens_{0};
+  std::vector<std::deque<BucketElement>> buckets_;
+  size_t numBucketed_{0};
+  uint64_t nextId_{0};
 };
 } // caffe2
@@ -26,7 +26,20 @@ Creates the Queue.
     .Arg("num_blobs", "Number of input tensors the queue will support")
     .Arg(
         "capacity",
-        "Maximal number of elements the queue can hold at any given point");
+        "Maximal number of elements the queue can hold at any given point")
+    .Arg(
+        "bucket_boundaries",
+        "Sorted lengths splitting the elements into length buckets. When set, "
+        "each dequeue takes its elements from a single bucket and pads them "
+        "to the longest one, instead of taking them in FIFO order")
+    .Arg(
+        "length_blob",
+        "In bucketing mode, index of the component whose first dimension is "
+        "the length of an element. Defaults to 0")
+    .Arg(
+        "max_tokens",
+        "In bucketing mode, maximal number of elements times the longest "
+        "length in a dequeued batch. Defaults to 0 (no limit)");
 
 OPERATOR_SCHEMA(CloseRebatchingQueue)
     .NumInputs(1)
@@ -62,6 +75,11 @@ Dequeue Tensors from the Queue.
 If the Queue is closed this might return less elements than asked.
 If num_elements > 1 the returned elements will be concatenated into one
 tensor per component.
+In bucketing mode the elements come from a single length bucket: the oldest
+one holding a full batch (num_elements, or max_tokens), else the fullest one
+once the queue is full, or the oldest one once it is closed. The components
+are padded with zeros along their first dimension, and an extra output, if
+given, receives the lengths of the elements.
 )DOC")
     .Input(0, "rebatching_queue", "object representing the queue")
     .Input(1, "tensor", "First tensor to enqueue")
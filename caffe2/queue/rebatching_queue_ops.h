@@ -12,10 +12,22 @@ class CreateRebatchingQueueOp : public Operator<CPUContext> {
       : Operator(operator_def, ws) {}
 
   bool RunOnDevice() override {
-    *OperatorBase::Output<RebatchingQueuePtr>(0) =
-        RebatchingQueuePtr(new RebatchingQueue(
-            OperatorBase::GetSingleArgument<int>("capacity", 1),
-            OperatorBase::GetSingleArgument<int>("num_blobs", 1)));
+    const auto capacity = OperatorBase::GetSingleArgument<int>("capacity", 1);
+    const auto numBlobs = OperatorBase::GetSingleArgument<int>("num_blobs", 1);
+    auto bucketBoundaries =
+        OperatorBase::GetRepeatedArgument<int64_t>("bucket_boundaries");
+    if (bucketBoundaries.empty()) {
+      *OperatorBase::Output<RebatchingQueuePtr>(0) =
+          RebatchingQueuePtr(new RebatchingQueue(capacity, numBlobs));
+    } else {
+      *OperatorBase::Output<RebatchingQueuePtr>(0) =
+          RebatchingQueuePtr(new RebatchingQueue(
+              capacity,
+              numBlobs,
+              std::move(bucketBoundaries),
+              OperatorBase::GetSingleArgument<int>("length_blob", 0),
+              OperatorBase::GetSingleArgument<int>("max_tokens", 0)));
+    }
     return true;
   }
 };
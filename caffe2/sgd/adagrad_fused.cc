@@ -0,0 +1,97 @@
+#include "caffe2/sgd/adagrad_fused.h"
+
+namespace caffe2 {
+
+namespace {
+
+const char* kFusedDoc = R"DOC(
+
+Fuses SparseLengths{reducer}Gradient and {optimizer}: given inputs (param,
+moment, indices, grad, lr, lengths), where grad is the gradient of the output
+of SparseLengths{reducer} (param, indices, lengths), applies the {optimizer}
+update of the gradient of every looked up row directly to param, without
+materializing the per-index gradient. Indices repeated within or across
+segments are updated once per occurrence.
+
+)DOC";
+
+std::function<void(OpSchema&)> FusedDocGenerator(
+    const char* reducer,
+    const char* optimizer) {
+  return [=](OpSchema& schema) {
+    string doc = kFusedDoc;
+    ReplaceAll(doc, "{reducer}", reducer);
+    ReplaceAll(doc, "{optimizer}", optimizer);
+    schema.SetDoc(doc);
+    schema.Input(0, "param", "Parameters to be updated");
+    schema.Input(1, "moment", "Moment history");
+    schema.Input(2, "indices", "Integer vector of the looked up rows");
+    schema.Input(
+        3, "grad", "Gradient of the output, one row per segment");
+    schema.Input(4, "lr", "learning rate");
+    schema.Input(5, "lengths", "Vector with the lengths of the segments");
+    schema.Output(0, "output_param", "Updated parameters");
+    schema.Output(1, "output_moment_1", "Updated moment");
+    schema.Arg("epsilon", "Default 1e-5");
+  };
+}
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(
+    SparseAdagradFusedWithSparseLengthsSumGradient,
+    SparseAdagradFusedWithSparseLengthsGradientOp<
+        float,
+        CPUContext,
+        false,
+        false>);
+OPERATOR_SCHEMA(SparseAdagradFusedWithSparseLengthsSumGradient)
+    .NumInputs(6)
+    .NumOutputs(2)
+    .EnforceOneToOneInplace()
+    .FillUsing(FusedDocGenerator("Sum", "SparseAdagrad"));
+SHOULD_NOT_DO_GRADIENT(SparseAdagradFusedWithSparseLengthsSumGradient);
+
+REGISTER_CPU_OPERATOR(
+    SparseAdagradFusedWithSparseLengthsMeanGradient,
+    SparseAdagradFusedWithSparseLengthsGradientOp<
+        float,
+        CPUContext,
+        true,
+        false>);
+OPERATOR_SCHEMA(SparseAdagradFusedWithSparseLengthsMeanGradient)
+    .NumInputs(6)
+    .NumOutputs(2)
+    .EnforceOneToOneInplace()
+    .FillUsing(FusedDocGenerator("Mean", "SparseAdagrad"));
+SHOULD_NOT_DO_GRADIENT(SparseAdagradFusedWithSparseLengthsMeanGradient);
+
+REGISTER_CPU_OPERATOR(
+    RowWiseSparseAdagradFusedWithSparseLengthsSumGradient,
+    SparseAdagradFusedWithSparseLengthsGradientOp<
+        float,
+        CPUContext,
+        false,
+        true>);
+OPERATOR_SCHEMA(RowWiseSparseAdagradFusedWithSparseLengthsSumGradient)
+    .NumInputs(6)
+    .NumOutputs(2)
+    .EnforceOneToOneInplace()
+    .FillUsing(FusedDocGenerator("Sum", "RowWiseSparseAdagrad"));
+SHOULD_NOT_DO_GRADIENT(RowWiseSparseAdagradFusedWithSparseLengthsSumGradient);
+
+REGISTER_CPU_OPERATOR(
+    RowWiseSparseAdagradFusedWithSparseLengthsMeanGradient,
+    SparseAdagradFusedWithSparseLengthsGradientOp<
+        float,
+        CPUContext,
+        true,
+        true>);
+OPERATOR_SCHEMA(RowWiseSparseAdagradFusedWithSparseLengthsMeanGradient)
+    .NumInputs(6)
+    .NumOutputs(2)
+    .EnforceOneToOneInplace()
+    .FillUsing(FusedDocGenerator("Mean", "RowWiseSparseAdagrad"));
+SHOULD_NOT_DO_GRADIENT(RowWiseSparseAdagradFusedWithSparseLengthsMeanGradient);
+
+} // namespace caffe2
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/adagrad.h"
+
+namespace caffe2 {
+
+// The gradient of SparseLengths{Sum,Mean} w.r.t. the rows of the embedding
+// table it looked up is the output gradient of the segment each index is in
+// (divided by the segment length for Mean). These ops apply the (row-wise)
+// Adagrad update of those gradients directly to the table, without the
+// [num_indices x block_size] gradient SparseLengths*Gradient would produce.
+// Repeated indices are updated once per occurrence, like SparseAdagrad does.
+template <typename T, class Context, bool is_mean, bool row_wise>
+class SparseAdagradFusedWithSparseLengthsGradientOp final
+    : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  SparseAdagradFusedWithSparseLengthsGradientOp(
+      const OperatorDef& operator_def,
+      Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override {
+    // Enforce shapes
+    if (row_wise) {
+      CAFFE_ENFORCE_EQ(Input(PARAM).dims()[0], Input(MOMENT_1).size());
+    } else {
+      CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MOMENT_1).size());
+    }
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+    CAFFE_ENFORCE_EQ(Input(INDICES).ndim(), 1, "INDICES must be a vector");
+    CAFFE_ENFORCE_EQ(Input(LENGTHS).ndim(), 1, "LENGTHS must be a vector");
+    CAFFE_ENFORCE_GT(Input(GRAD).ndim(), 0);
+    CAFFE_ENFORCE_EQ(
+        Input(GRAD).dim(0),
+        Input(LENGTHS).dim(0),
+        "GRAD must have one row per segment");
+    CAFFE_ENFORCE_EQ(
+        Input(PARAM).size_from_dim(1), Input(GRAD).size_from_dim(1));
+
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto* lr = Input(LR).template data<T>();
+    const auto* indices = Input(INDICES).template data<SIndex>();
+    const auto* lengths = Input(LENGTHS).template data<int>();
+    const auto* gradIn = Input(GRAD).template data<T>();
+    const auto* paramIn = Input(PARAM).template data<T>();
+    const auto* momentIn = Input(MOMENT_1).template data<T>();
+    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<T>();
+    auto* momentOut = Output(OUTPUT_MOMENT_1)->template mutable_data<T>();
+
+    const TIndex n = Input(INDICES).size();
+    const TIndex num_segments = Input(LENGTHS).size();
+    const TIndex num_rows = Input(PARAM).dim(0);
+    const TIndex block_size = Input(PARAM).size_from_dim(1);
+    if (is_mean) {
+      scaled_grad_.Resize(block_size);
+    }
+
+    TIndex pos = 0;
+    for (TIndex s = 0; s < num_segments; ++s) {
+      const int length = lengths[s];
+      CAFFE_ENFORCE_GE(length, 0);
+      CAFFE_ENFORCE_LE(
+          pos + length, n, "The lengths add up to more than the indices");
+      const T* g = gradIn + s * block_size;
+      if (is_mean && length > 1) {
+        auto* scaled = scaled_grad_.template mutable_data<T>();
+        for (TIndex j = 0; j < block_size; ++j) {
+          scaled[j] = g[j] / length;
+        }
+        g = scaled;
+      }
+
+      for (int i = 0; i < length; ++i, ++pos) {
+        const SIndex idx = indices[pos];
+        CAFFE_ENFORCE(
+            0 <= idx && idx < num_rows,
+            "Index ",
+            pos,
+            " is out of bounds: ",
+            idx,
+            ", range 0 to ",
+            num_rows);
+        const TIndex offsetIdx = idx * block_size;
+        if (row_wise) {
+          RowWiseAdagradUpdate(
+              block_size,
+              paramIn + offsetIdx,
+              g,
+              momentIn + idx,
+              paramOut + offsetIdx,
+              momentOut + idx,
+              epsilon_,
+              lr[0]);
+        } else {
+          AdagradUpdate(
+              block_size,
+              paramIn + offsetIdx,
+              g,
+              momentIn + offsetIdx,
+              paramOut + offsetIdx,
+              momentOut + offsetIdx,
+              epsilon_,
+              1.0f,
+              lr[0]);
+        }
+      }
+    }
+    CAFFE_ENFORCE_EQ(pos, n, "The lengths don't add up to the indices");
+    return true;
+  }
+
+ protected:
+  T epsilon_;
+  Tensor<Context> scaled_grad_;
+  INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR, LENGTHS);
+  OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
+};
+
+} // namespace caffe2
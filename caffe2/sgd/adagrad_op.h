@@ -1,6 +1,8 @@
 #pragma once
 
 #include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/adagrad.h"
+#include "caffe2/sgd/sparse_update_utils.h"
 
 namespace caffe2 {
 
@@ -23,6 +25,22 @@ void adagrad_update(
   }
 }
 
+// The fused (vectorized) kernel of perfkernels/adagrad.h
+template <>
+inline void adagrad_update<CPUContext>(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float decay,
+    const float* lr,
+    CPUContext* /*context*/) {
+  AdagradUpdate(N, w, g, h, nw, nh, epsilon, decay, lr[0]);
+}
+
 template <typename T, class Context>
 class AdagradOp final : public Operator<Context> {
  public:
@@ -94,7 +112,35 @@ class SparseAdagradOp final : public Operator<Context> {
     }
 
     auto block_size = Input(GRAD).size() / n;
+
+#ifndef NDEBUG
+    // checked up front, the updates may run on several threads
     for (auto i = 0; i < n; ++i) {
+      auto idx = indices[i];
+      auto offsetI = i * block_size;
+      auto offsetIdx = idx * block_size;
+      CAFFE_ENFORCE_GE(
+          Input(PARAM).size(),
+          block_size + offsetIdx,
+          this->debug_def().input(PARAM),
+          ", out of bound,  idx:",
+          idx,
+          " for input i:",
+          i,
+          " and block size:",
+          block_size);
+      CAFFE_ENFORCE_GE(
+          Input(GRAD).size(),
+          block_size + offsetI,
+          this->debug_def().input(GRAD),
+          ", out of bound idx, idx:",
+          idx,
+          " for input i:",
+          i);
+    }
+#endif
+
+    auto update = [&](TIndex i) {
       auto idx = indices[i];
       if (block_size == 1) {
         float gi = gradIn[i];
@@ -103,27 +149,6 @@ class SparseAdagradOp final : public Operator<Context> {
       } else {
         auto offsetI = i * block_size;
         auto offsetIdx = idx * block_size;
-
-#ifndef NDEBUG
-        CAFFE_ENFORCE_GE(
-            Input(PARAM).size(),
-            block_size + offsetIdx,
-            this->debug_def().input(PARAM),
-            ", out of bound,  idx:",
-            idx,
-            " for input i:",
-            i,
-            " and block size:",
-            block_size);
-        CAFFE_ENFORCE_GE(
-            Input(GRAD).size(),
-            block_size + offsetI,
-            this->debug_def().input(GRAD),
-            ", out of bound idx, idx:",
-            idx,
-            " for input i:",
-            i);
-#endif
         adagrad_update(
             block_size,
             paramIn + offsetIdx,
@@ -136,6 +161,20 @@ class SparseAdagradOp final : public Operator<Context> {
             lr,
             &context_);
       }
+    };
+
+    // the rows of distinct indices don't depend on each other
+    if (ParallelizeSparseUpdate(indices, n, block_size)) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (TIndex i = 0; i < n; ++i) {
+        update(i);
+      }
+    } else {
+      for (TIndex i = 0; i < n; ++i) {
+        update(i);
+      }
     }
     return true;
   }
@@ -183,7 +222,34 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
 
     auto block_size = Input(GRAD).size() / n;
 
+#ifndef NDEBUG
+    // checked up front, the updates may run on several threads
     for (auto i = 0; i < n; ++i) {
+      auto idx = indices[i];
+      auto offsetI = i * block_size;
+      auto offsetIdx = idx * block_size;
+      CAFFE_ENFORCE_GE(
+          Input(PARAM).size(),
+          block_size + offsetIdx,
+          this->debug_def().input(PARAM),
+          ", out of bound,  idx:",
+          idx,
+          " for input i:",
+          i,
+          " and block size:",
+          block_size);
+      CAFFE_ENFORCE_GE(
+          Input(GRAD).size(),
+          block_size + offsetI,
+          this->debug_def().input(GRAD),
+          ", out of bound idx, idx:",
+          idx,
+          " for input i:",
+          i);
+    }
+#endif
+
+    auto update = [&](TIndex i) {
       auto idx = indices[i];
       if (block_size == 1) {
         float gi = gradIn[i];
@@ -192,43 +258,29 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
       } else {
         auto offsetI = i * block_size;
         auto offsetIdx = idx * block_size;
+        RowWiseAdagradUpdate(
+            block_size,
+            paramIn + offsetIdx,
+            gradIn + offsetI,
+            momentIn + idx,
+            paramOut + offsetIdx,
+            momentOut + idx,
+            epsilon_,
+            lr[0]);
+      }
+    };
 
-#ifndef NDEBUG
-        CAFFE_ENFORCE_GE(
-            Input(PARAM).size(),
-            block_size + offsetIdx,
-            this->debug_def().input(PARAM),
-            ", out of bound,  idx:",
-            idx,
-            " for input i:",
-            i,
-            " and block size:",
-            block_size);
-        CAFFE_ENFORCE_GE(
-            Input(GRAD).size(),
-            block_size + offsetI,
-            this->debug_def().input(GRAD),
-            ", out of bound idx, idx:",
-            idx,
-            " for input i:",
-            i);
+    // the rows of distinct indices don't depend on each other
+    if (ParallelizeSparseUpdate(indices, n, block_size)) {
+#ifdef _OPENMP
+#pragma omp parallel for
 #endif
-
-        const float* w = paramIn + offsetIdx;
-        const float* g = gradIn + offsetI;
-        const float* h = momentIn + idx;
-        float* nw = paramOut + offsetIdx;
-        float* nh = momentOut + idx;
-        float hs = 0.;
-        for (auto j = 0; j < block_size; ++j) {
-          float gj = g[j];
-          hs += gj * gj;
-        }
-        float hi = nh[0] = h[0] + hs / block_size;
-        float step = lr[0] / (std::sqrt(hi) + epsilon_);
-        for (auto j = 0; j < block_size; ++j) {
-          nw[j] = w[j] + g[j] * step;
-        }
+      for (TIndex i = 0; i < n; ++i) {
+        update(i);
+      }
+    } else {
+      for (TIndex i = 0; i < n; ++i) {
+        update(i);
       }
     }
     return true;
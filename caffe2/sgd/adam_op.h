@@ -1,6 +1,8 @@
 #pragma once
 
 #include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/adam.h"
+#include "caffe2/sgd/sparse_update_utils.h"
 
 namespace caffe2 {
 
@@ -52,6 +54,27 @@ void adam_compute(
   }
 }
 
+// The fused (vectorized) kernel of perfkernels/adam.h
+template <>
+inline void adam_compute<CPUContext>(
+    int N,
+    const float* w,
+    const float* g,
+    const float* m,
+    const float* v,
+    float* nw,
+    float* nm,
+    float* nv,
+    float beta1,
+    float beta2,
+    float eps_hat,
+    float correction,
+    const float* lr,
+    CPUContext* /*context*/) {
+  AdamUpdate(
+      N, w, g, m, v, nw, nm, nv, beta1, beta2, eps_hat, correction, lr[0]);
+}
+
 template <typename T, class Context>
 class AdamOp final : public Operator<Context> {
  public:
@@ -149,8 +172,35 @@ class SparseAdamOp final : public Operator<Context> {
     auto* moment1Out = Output(OUTPUT_MOMENT_1)->template mutable_data<T>();
     auto* moment2Out = Output(OUTPUT_MOMENT_2)->template mutable_data<T>();
 
+#ifndef NDEBUG
+    // checked up front, the updates may run on several threads
     for (auto i = 0; i < n; ++i) {
       auto idx = indices[i];
+      auto offsetI = i * block_size;
+      auto offsetIdx = idx * block_size;
+      CAFFE_ENFORCE_GE(
+          Input(PARAM).size(),
+          block_size + offsetIdx,
+          this->debug_def().input(PARAM),
+          ", out of bound,  idx:",
+          idx,
+          " for input i:",
+          i,
+          " and block size:",
+          block_size);
+      CAFFE_ENFORCE_GE(
+          Input(GRAD).size(),
+          block_size + offsetI,
+          this->debug_def().input(GRAD),
+          ", out of bound idx, idx:",
+          idx,
+          " for input i:",
+          i);
+    }
+#endif
+
+    auto update = [&](TIndex i) {
+      auto idx = indices[i];
 
       if (block_size == 1) {
         float gi = gradIn[i];
@@ -164,28 +214,6 @@ class SparseAdamOp final : public Operator<Context> {
       } else {
         auto offsetI = i * block_size;
         auto offsetIdx = idx * block_size;
-
-#ifndef NDEBUG
-        CAFFE_ENFORCE_GE(
-            Input(PARAM).size(),
-            block_size + offsetIdx,
-            this->debug_def().input(PARAM),
-            ", out of bound,  idx:",
-            idx,
-            " for input i:",
-            i,
-            " and block size:",
-            block_size);
-        CAFFE_ENFORCE_GE(
-            Input(GRAD).size(),
-            block_size + offsetI,
-            this->debug_def().input(GRAD),
-            ", out of bound idx, idx:",
-            idx,
-            " for input i:",
-            i);
-#endif
-
         adam_compute(
             block_size,
             paramIn + offsetIdx,
@@ -202,6 +230,20 @@ class SparseAdamOp final : public Operator<Context> {
             lr,
             &context_);
       }
+    };
+
+    // the rows of distinct indices don't depend on each other
+    if (ParallelizeSparseUpdate(indices, n, block_size)) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (TIndex i = 0; i < n; ++i) {
+        update(i);
+      }
+    } else {
+      for (TIndex i = 0; i < n; ++i) {
+        update(i);
+      }
     }
     return true;
   }
@@ -1,5 +1,10 @@
 #include "ftrl_op.h"
 
+#include <vector>
+
+#include "caffe2/perfkernels/ftrl.h"
+#include "caffe2/sgd/sparse_update_utils.h"
+
 namespace caffe2 {
 
 template <class T>
@@ -30,7 +35,6 @@ inline void ftrl_compute(
   }
 }
 
-// TODO(dzhulgakov): implement SIMD-based version
 template <typename Context, typename T>
 void ftrl_update(
     int N,
@@ -41,8 +45,6 @@ void ftrl_update(
     T* new_nz,
     const FtrlParams<T>& params,
     Context* /*context*/) {
-  // TODO(cxj): use OMP when it is reliable
-  // #pragma omp parallel for
   for (auto i = 0; i < N; ++i) {
     ftrl_compute(
         w[i],
@@ -56,6 +58,121 @@ void ftrl_update(
   }
 }
 
+template <>
+void ftrl_update<CPUContext, float>(
+    int N,
+    const float* w,
+    const float* nz,
+    const float* g,
+    float* new_w,
+    float* new_nz,
+    const FtrlParams<float>& params,
+    CPUContext* /*context*/) {
+  FtrlUpdate(
+      N,
+      w,
+      nz,
+      g,
+      new_w,
+      new_nz,
+      params.alphaInv,
+      params.beta,
+      params.lambda1,
+      params.lambda2);
+}
+
+// Same as ftrl_update, for a row of the interleaved layout of
+// InterleavedSparseFtrl: the N weights, then n, then z.
+template <typename T>
+void interleaved_ftrl_update(
+    int N,
+    const T* wnz,
+    const T* g,
+    T* new_wnz,
+    const FtrlParams<T>& params) {
+  for (auto i = 0; i < N; ++i) {
+    ftrl_compute(
+        wnz[i],
+        wnz[N + i],
+        wnz[2 * N + i],
+        g[i],
+        new_wnz[i],
+        new_wnz[N + i],
+        new_wnz[2 * N + i],
+        params);
+  }
+}
+
+template <>
+void interleaved_ftrl_update<float>(
+    int N,
+    const float* wnz,
+    const float* g,
+    float* new_wnz,
+    const FtrlParams<float>& params) {
+  InterleavedFtrlUpdate(
+      N,
+      wnz,
+      g,
+      new_wnz,
+      params.alphaInv,
+      params.beta,
+      params.lambda1,
+      params.lambda2);
+}
+
+// How many positions ahead of the one being updated the rows of a sparse
+// update are prefetched. The rows are scattered over tables much bigger than
+// the caches, so each update would otherwise wait for its row.
+constexpr TIndex kFtrlPrefetchDistance = 16;
+
+inline void prefetch_row(const void* row, TIndex bytes) {
+#if defined(__GNUC__)
+  const char* p = static_cast<const char*>(row);
+  // one prefetch per 64-byte cache line
+  for (TIndex offset = 0; offset < bytes; offset += 64) {
+    __builtin_prefetch(p + offset, 1 /* for writing */);
+  }
+#endif
+}
+
+// Calls update(i) for the n positions of a sparse update, after
+// prefetch(index) for the one kFtrlPrefetchDistance positions ahead. When
+// worth it, the distinct rows are updated in parallel, with the positions of
+// a row that is updated more than once applied in order.
+template <typename SIndex, typename Update, typename Prefetch>
+void sparse_ftrl_update(
+    const SIndex* indices,
+    TIndex n,
+    TIndex block_size,
+    Update update,
+    Prefetch prefetch) {
+  if (!SparseUpdateWorthParallelizing(n, block_size)) {
+    for (TIndex i = 0; i < n; ++i) {
+      if (i + kFtrlPrefetchDistance < n) {
+        prefetch(indices[i + kFtrlPrefetchDistance]);
+      }
+      update(i);
+    }
+    return;
+  }
+  std::vector<TIndex> order;
+  std::vector<TIndex> starts;
+  GroupSparseUpdateIndices(indices, n, &order, &starts);
+  const TIndex num_rows = starts.size() - 1;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (TIndex r = 0; r < num_rows; ++r) {
+    if (r + kFtrlPrefetchDistance < num_rows) {
+      prefetch(indices[order[starts[r + kFtrlPrefetchDistance]]]);
+    }
+    for (TIndex j = starts[r]; j < starts[r + 1]; ++j) {
+      update(order[j]);
+    }
+  }
+}
+
 template <typename T, typename Context>
 bool FtrlOp<T, Context>::RunOnDevice() {
   // run time learning rate override
@@ -99,9 +216,7 @@ void SparseFtrlOp<T>::DoRun() {
   const SIndex* idxs = indices.template data<SIndex>();
   const T* g = grad.template data<T>();
 
-  // TODO(cxj): use OMP when it is reliable
-  // #pragma omp parallel for
-  for (TIndex i = 0; i < K; ++i) {
+  auto update = [&](TIndex i) {
     SIndex idx = idxs[i];
     DCHECK(0 <= idx && idx < N) << "Index out of bounds: " << idx
                                 << ", range 0 to " << N;
@@ -127,7 +242,49 @@ void SparseFtrlOp<T>::DoRun() {
           params_,
           &context_);
     }
-  }
+  };
+  auto prefetch = [&](SIndex idx) {
+    prefetch_row(w + block_size * idx, block_size * sizeof(T));
+    prefetch_row(nz + block_size * idx * 2, block_size * 2 * sizeof(T));
+  };
+  sparse_ftrl_update(idxs, K, block_size, update, prefetch);
+}
+
+template <typename T>
+template <typename SIndex>
+void InterleavedSparseFtrlOp<T>::DoRun() {
+  auto* state = Output(OUTPUT_STATE);
+  auto& indices = Input(INDICES);
+  auto& grad = Input(GRAD);
+  CAFFE_ENFORCE_EQ(&Input(STATE), state, "In place operation is required");
+  CAFFE_ENFORCE_GE(state->ndim(), 2);
+  CAFFE_ENFORCE_EQ(
+      state->dim(1), 3, "The state has to hold the weights, n and z");
+  TIndex N = state->dim(0);
+  TIndex block_size = state->size_from_dim(2);
+  TIndex K = indices.size();
+  DCHECK_EQ(grad.size(), K * block_size);
+  T* wnz = state->template mutable_data<T>();
+  const SIndex* idxs = indices.template data<SIndex>();
+  const T* g = grad.template data<T>();
+
+  auto update = [&](TIndex i) {
+    SIndex idx = idxs[i];
+    DCHECK(0 <= idx && idx < N) << "Index out of bounds: " << idx
+                                << ", range 0 to " << N;
+    T* row = wnz + block_size * idx * 3;
+    if (block_size == 1) {
+      ftrl_compute(
+          row[0], row[1], row[2], g[i], row[0], row[1], row[2], params_);
+    } else {
+      interleaved_ftrl_update(
+          block_size, row, g + i * block_size, row, params_);
+    }
+  };
+  auto prefetch = [&](SIndex idx) {
+    prefetch_row(wnz + block_size * idx * 3, block_size * 3 * sizeof(T));
+  };
+  sparse_ftrl_update(idxs, K, block_size, update, prefetch);
 }
 
 namespace {
@@ -142,6 +299,32 @@ OPERATOR_SCHEMA(SparseFtrl)
     .NumOutputs(2)
     .EnforceInplace({{0, 0}, {1, 1}});
 SHOULD_NOT_DO_GRADIENT(SparseFtrl);
+
+REGISTER_CPU_OPERATOR(InterleavedSparseFtrl, InterleavedSparseFtrlOp<float>);
+OPERATOR_SCHEMA(InterleavedSparseFtrl)
+    .NumInputs(3, 4)
+    .NumOutputs(1)
+    .EnforceInplace({{0, 0}})
+    .SetDoc(R"DOC(
+
+Same as SparseFtrl, with the weights and the FTRL state n and z of every row
+interleaved in one tensor of shape (N, 3, ...): state[i][0] are the weights of
+row i, state[i][1] its n and state[i][2] its z. An update then finds all of
+the state of a row in the same cache lines, which for the logistic regression
+rows of a single weight is one line instead of two. The weights can be read in
+the forward pass by gathering the rows of the state and slicing out [:, 0].
+
+)DOC")
+    .Input(0, "state", "Interleaved weights and state, updated in place")
+    .Input(1, "indices", "Sparse indices")
+    .Input(2, "grad", "Gradient computed")
+    .Input(3, "alpha", "(optional) learning rate, overrides the argument")
+    .Output(0, "output_state", "Updated state")
+    .Arg("alpha", "Learning rate")
+    .Arg("beta", "Learning rate decay")
+    .Arg("lambda1", "L1 regularization strength")
+    .Arg("lambda2", "L2 regularization strength");
+SHOULD_NOT_DO_GRADIENT(InterleavedSparseFtrl);
 }
 
 }
@@ -75,4 +75,45 @@ class SparseFtrlOp final : public Operator<CPUContext> {
   void DoRun();
 };
 
+// SparseFtrl with the state of a row in one tensor of shape (N, 3, ...):
+// the weights, then n, then z. See the schema.
+template <typename T>
+class InterleavedSparseFtrlOp final : public Operator<CPUContext> {
+ public:
+  InterleavedSparseFtrlOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), params_(this) {
+    CAFFE_ENFORCE(
+        !HasArgument("alpha") || ALPHA >= InputSize(),
+        "Cannot specify alpha by both input and argument");
+  }
+
+  bool RunOnDevice() override {
+    // run time learning rate override
+    if (ALPHA < InputSize()) {
+      CAFFE_ENFORCE_EQ(Input(ALPHA).size(), 1, "alpha should be real-valued");
+      params_.alphaInv = 1.0 / *(Input(ALPHA).template data<T>());
+    }
+    // Use run-time polymorphism
+    auto& indices = Input(INDICES);
+    if (indices.template IsType<int32_t>()) {
+      DoRun<int32_t>();
+    } else if (indices.template IsType<int64_t>()) {
+      DoRun<int64_t>();
+    } else {
+      LOG(FATAL) << "Unsupported type of INDICES in InterleavedSparseFtrlOp: "
+                 << indices.meta().name();
+    }
+    return true;
+  }
+
+ protected:
+  FtrlParams<T> params_;
+  INPUT_TAGS(STATE, INDICES, GRAD, ALPHA);
+  OUTPUT_TAGS(OUTPUT_STATE);
+
+ private:
+  template <typename SIndex>
+  void DoRun();
+};
+
 }
@@ -0,0 +1,86 @@
+#ifndef CAFFE2_SGD_SPARSE_UPDATE_UTILS_H_
+#define CAFFE2_SGD_SPARSE_UPDATE_UTILS_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/common_omp.h"
+
+namespace caffe2 {
+
+// Below this many updated values a sparse update is not worth spreading over
+// threads.
+constexpr TIndex kMinParallelSparseUpdateSize = 1 << 16;
+
+// Whether a sparse update of n indices of block_size values each is worth
+// spreading over threads: it has to be built with OpenMP and big enough.
+inline bool SparseUpdateWorthParallelizing(TIndex n, TIndex block_size) {
+#ifdef _OPENMP
+  const bool multithreaded = omp_get_max_threads() > 1;
+#else
+  const bool multithreaded = false;
+#endif // _OPENMP
+  return multithreaded && n >= 2 &&
+      n * block_size >= kMinParallelSparseUpdateSize;
+}
+
+// Whether the rows of a sparse update of n indices of block_size values each
+// can be updated in parallel: it has to be worth it, and no row may be updated
+// twice, since the updates of a row read the moments written by its previous
+// update.
+template <typename SIndex>
+bool ParallelizeSparseUpdate(
+    const SIndex* indices,
+    TIndex n,
+    TIndex block_size) {
+  if (!SparseUpdateWorthParallelizing(n, block_size)) {
+    return false;
+  }
+  std::unordered_set<SIndex> seen;
+  seen.reserve(n);
+  for (TIndex i = 0; i < n; ++i) {
+    if (!seen.insert(indices[i]).second) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Groups the n positions of a sparse update by their index, so that the
+// distinct rows can be updated in parallel even when some of them are updated
+// more than once. The positions of the g-th distinct index are
+// order[starts[g]] to order[starts[g + 1] - 1], in the order they appear in
+// indices, and starts has one element more than there are distinct indices.
+template <typename SIndex>
+void GroupSparseUpdateIndices(
+    const SIndex* indices,
+    TIndex n,
+    std::vector<TIndex>* order,
+    std::vector<TIndex>* starts) {
+  std::unordered_map<SIndex, TIndex> groups;
+  groups.reserve(n);
+  std::vector<TIndex> group_of(n);
+  starts->assign(1, 0);
+  for (TIndex i = 0; i < n; ++i) {
+    auto it = groups.emplace(indices[i], groups.size()).first;
+    group_of[i] = it->second;
+    if (it->second + 1 == static_cast<TIndex>(starts->size())) {
+      starts->push_back(0);
+    }
+    ++(*starts)[it->second + 1];
+  }
+  for (size_t g = 1; g < starts->size(); ++g) {
+    (*starts)[g] += (*starts)[g - 1];
+  }
+  std::vector<TIndex> next(starts->begin(), starts->end() - 1);
+  order->resize(n);
+  for (TIndex i = 0; i < n; ++i) {
+    (*order)[next[group_of[i]]++] = i;
+  }
+}
+
+} // namespace caffe2
+
+#endif // CAFFE2_SGD_SPARSE_UPDATE_UTILS_H_
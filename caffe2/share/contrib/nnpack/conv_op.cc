@@ -36,6 +36,9 @@ class NNPACKConvOp final : public ConvPoolOpBase<CPUContext> {
       : ConvPoolOpBase<CPUContext>(operator_def, ws),
         algorithm_(getConvolutionAlgorithm()),
         transformStrategy_(getConvolutionTransformStrategy()),
+        activation_(
+            operator_def.type() == "ConvRelu" ? nnp_activation_relu
+                                              : nnp_activation_identity),
         ws_(ws) {
     OPERATOR_NEEDS_FEATURE(
         this->order_ == StorageOrder::NCHW,
@@ -65,6 +68,8 @@ class NNPACKConvOp final : public ConvPoolOpBase<CPUContext> {
   //                                       -> compute (on failing precompute)
   // - compute
   nnp_convolution_transform_strategy transformStrategy_;
+  // Relu for ConvRelu, applied by NNPACK as the output is computed
+  const nnp_activation activation_;
   Workspace* ws_;
   // Per-group transformed filters
   std::vector<TensorCPU*> transformedFilters_;
@@ -179,7 +184,8 @@ bool NNPACKConvOp::RunOnDeviceWithOrderNCHW() {
   initNNPACK();
   pthreadpool pool(ws_->GetThreadPool());
 
-  runWithSharedBuffer<CPUContext>(ws_, [&](Tensor<CPUContext>* buffer) {
+  runWithSharedBuffer<CPUContext>(
+      ws_, &context_, [&](Tensor<CPUContext>* buffer) {
     if (transformStrategy_ == nnp_convolution_transform_strategy_precompute) {
       transformedFilters_.resize(group_);
 
@@ -199,7 +205,7 @@ bool NNPACKConvOp::RunOnDeviceWithOrderNCHW() {
           nullptr /* output */,
           nullptr /* workspace buffer = transformed filter */,
           &transformedFilterSize,
-          nnp_activation_identity,
+          activation_,
           nullptr /* activation parameter */,
           &pool,
           nullptr /* profile */);
@@ -235,7 +241,7 @@ bool NNPACKConvOp::RunOnDeviceWithOrderNCHW() {
               static_cast<void*>(
                   transformedFilters_[g]->template mutable_data<float>()),
               &transformedFilterSize,
-              nnp_activation_identity,
+              activation_,
               nullptr /* activation parameter */,
               &pool,
               nullptr /* profile */);
@@ -298,7 +304,7 @@ bool NNPACKConvOp::RunOnDeviceWithOrderNCHW() {
                 g * oH * oW * (M / group_),
             static_cast<void*>(buffer->template mutable_data<float>()),
             &workspaceSize,
-            nnp_activation_identity,
+            activation_,
             nullptr /* activation parameter */,
             &pool,
             FLAGS_caffe2_profile_nnpack ? &profile : nullptr);
@@ -319,7 +325,7 @@ bool NNPACKConvOp::RunOnDeviceWithOrderNCHW() {
               nullptr /* output */,
               nullptr /* workspace buffer */,
               &workspaceSize,
-              nnp_activation_identity,
+              activation_,
               nullptr /* activation parameter */,
               &pool,
               nullptr /* profile */);
@@ -352,7 +358,7 @@ bool NNPACKConvOp::RunOnDeviceWithOrderNCHW() {
                     g * oH * oW * (M / group_),
                 static_cast<void*>(buffer->template mutable_data<float>()),
                 &workspaceSize,
-                nnp_activation_identity,
+                activation_,
                 nullptr /* activation parameter */,
                 &pool,
                 FLAGS_caffe2_profile_nnpack ? &profile : nullptr);
@@ -401,5 +407,6 @@ bool NNPACKConvOp::RunOnDeviceWithOrderNCHW() {
 }
 
 REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv, NNPACK, NNPACKConvOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(ConvRelu, NNPACK, NNPACKConvOp);
 
 } // namespace caffe2
@@ -0,0 +1,240 @@
+#include "caffe2/transforms/allreduce_bucketing_transform.h"
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/net.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+using transform::Graph;
+using transform::Node;
+
+namespace {
+
+// An Allreduce of a single blob, in place.
+bool IsBucketable(const OperatorDef& op) {
+  return op.type() == "Allreduce" && op.input_size() == 2 &&
+      op.output_size() == 1 && op.output(0) == op.input(1);
+}
+
+// Whether two Allreduce ops can run as a single one.
+bool IsSameAllreduce(const OperatorDef& a, const OperatorDef& b) {
+  if (a.input(0) != b.input(0) || a.engine() != b.engine() ||
+      a.device_option().SerializeAsString() !=
+          b.device_option().SerializeAsString() ||
+      a.arg_size() != b.arg_size()) {
+    return false;
+  }
+  for (int i = 0; i < a.arg_size(); i++) {
+    if (a.arg(i).SerializeAsString() != b.arg(i).SerializeAsString()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Touches(const OperatorDef& op, const std::set<string>& blobs) {
+  for (const auto& blob : op.input()) {
+    if (blobs.count(blob)) {
+      return true;
+    }
+  }
+  for (const auto& blob : op.output()) {
+    if (blobs.count(blob)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Writes(const OperatorDef& op, const string& blob) {
+  for (const auto& output : op.output()) {
+    if (output == blob) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+bool AllreduceBucketingTransform::PatternRule(
+    const Graph& g,
+    const std::vector<int>& subgraph,
+    int idx) {
+  const auto& op = g.node(idx).op;
+  if (!IsBucketable(op)) {
+    return false;
+  }
+  if (subgraph.size() == 0) {
+    return true;
+  }
+  if (subgraph.size() >= max_bucket_size_) {
+    return false;
+  }
+  const auto& first = g.node(subgraph.front()).op;
+  if (!IsSameAllreduce(first, op)) {
+    return false;
+  }
+
+  for (const int x : subgraph) {
+    if (g.node(x).op.input(1) == op.input(1)) {
+      return false;
+    }
+  }
+
+  // The bucket runs where its last Allreduce was, so the ops after each of
+  // its Allreduce ops must not see that blob before it is reduced.
+  std::set<string> blobs;
+  auto member = subgraph.begin();
+  for (int k = subgraph.front(); k < idx; k++) {
+    if (member != subgraph.end() && *member == k) {
+      blobs.insert(g.node(k).op.input(1));
+      ++member;
+      continue;
+    }
+    if (!g.node(k).active) {
+      continue;
+    }
+    const auto& other = g.node(k).op;
+    // Only consecutive Allreduce ops are bucketed, which also keeps the
+    // pattern matching linear in the number of candidates.
+    if (k > subgraph.back() && IsBucketable(other) &&
+        IsSameAllreduce(first, other)) {
+      return false;
+    }
+    if (Touches(other, blobs) || Writes(other, first.input(0))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A single Allreduce is left as it is.
+bool AllreduceBucketingTransform::ValidatorRule(
+    const Graph& /*g*/,
+    const std::vector<int>& subgraph) {
+  return subgraph.size() >= 2;
+}
+
+bool AllreduceBucketingTransform::ReplaceRule(
+    const std::vector<int>& subgraph,
+    Graph* g_ptr) {
+  CHECK(g_ptr);
+  auto& g = *g_ptr;
+
+  const OperatorDef first = g.node(subgraph.front()).op;
+  const string& common_world = first.input(0);
+  const string bucket = "transform/" + first.input(1) + "_bucket";
+  const string bucket_split = bucket + "_split";
+
+  std::vector<string> blobs;
+  std::vector<std::map<int, std::vector<string>>> parents;
+  std::vector<std::map<int, std::vector<string>>> children;
+  for (const int x : subgraph) {
+    blobs.push_back(g.node(x).op.input(1));
+    parents.push_back(g.node(x).parents);
+    children.push_back(g.node(x).children);
+  }
+  g.DeactivateSubgraph(subgraph);
+
+  auto flat = [](const string& blob) { return "transform/" + blob + "_flat"; };
+  auto shape = [](const string& blob) {
+    return "transform/" + blob + "_shape";
+  };
+  auto add_node = [&](
+      const string& type,
+      const std::vector<string>& inputs,
+      const std::vector<string>& outputs) {
+    OperatorDef op;
+    op.set_type(type);
+    for (const auto& input : inputs) {
+      op.add_input(input);
+    }
+    for (const auto& output : outputs) {
+      op.add_output(output);
+    }
+    op.mutable_device_option()->CopyFrom(first.device_option());
+    g.push_node(Node(
+        op,
+        true,
+        std::map<int, std::vector<string>>(),
+        std::map<int, std::vector<string>>()));
+    return g.size() - 1;
+  };
+  auto connect = [&](int parent, int child, const string& blob) {
+    g.node(parent).children[child].push_back(blob);
+    g.node(child).parents[parent].push_back(blob);
+  };
+
+  // Flatten every blob of the bucket.
+  std::vector<int> flatten_nodes;
+  for (int i = 0; i < blobs.size(); i++) {
+    int flatten =
+        add_node("Reshape", {blobs[i]}, {flat(blobs[i]), shape(blobs[i])});
+    g.node(flatten).op.add_arg()->CopyFrom(
+        MakeArgument<std::vector<int64_t>>("shape", {-1}));
+    for (const auto& parent : parents[i]) {
+      for (const auto& blob : parent.second) {
+        if (blob == blobs[i]) {
+          connect(parent.first, flatten, blob);
+        }
+      }
+    }
+    flatten_nodes.push_back(flatten);
+  }
+
+  // Concatenate them and reduce the bucket with the original op's settings.
+  std::vector<string> flat_blobs;
+  for (const auto& blob : blobs) {
+    flat_blobs.push_back(flat(blob));
+  }
+  int concat = add_node("Concat", flat_blobs, {bucket, bucket_split});
+  g.node(concat).op.add_arg()->CopyFrom(MakeArgument<int>("axis", 0));
+  for (int i = 0; i < blobs.size(); i++) {
+    connect(flatten_nodes[i], concat, flat_blobs[i]);
+  }
+
+  int allreduce = add_node("Allreduce", {common_world, bucket}, {bucket});
+  auto& allreduce_op = g.node(allreduce).op;
+  allreduce_op.set_engine(first.engine());
+  allreduce_op.mutable_arg()->CopyFrom(first.arg());
+  if (first.has_name()) {
+    allreduce_op.set_name(first.name());
+  }
+  connect(concat, allreduce, bucket);
+  for (const auto& parent : parents[0]) {
+    for (const auto& blob : parent.second) {
+      if (blob == common_world) {
+        connect(parent.first, allreduce, blob);
+      }
+    }
+  }
+
+  // Split the reduced bucket and restore the original shapes.
+  int split = add_node("Split", {bucket, bucket_split}, flat_blobs);
+  g.node(split).op.add_arg()->CopyFrom(MakeArgument<int>("axis", 0));
+  connect(allreduce, split, bucket);
+  connect(concat, split, bucket_split);
+
+  for (int i = 0; i < blobs.size(); i++) {
+    int restore = add_node(
+        "Reshape",
+        {flat_blobs[i], shape(blobs[i])},
+        {blobs[i], flat_blobs[i] + "_shape"});
+    connect(split, restore, flat_blobs[i]);
+    connect(flatten_nodes[i], restore, shape(blobs[i]));
+    for (const auto& child : children[i]) {
+      for (const auto& blob : child.second) {
+        connect(restore, child.first, blob);
+      }
+    }
+  }
+
+  return true;
+}
+
+REGISTER_TRANSFORM(AllreduceBucketing, AllreduceBucketingTransform);
+
+} // namespace caffe2
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/transform.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+/**
+ * Allreduce Bucketing
+ *
+ * Fuses consecutive single-blob Allreduce ops into buckets, so that a net
+ * with many small gradients pays the latency of one collective per bucket
+ * instead of one per gradient.
+ *
+ * Allreduce ops are bucketed together when they run in place on a single
+ * blob, on the same common world, with the same engine, arguments and device,
+ * and when no op between them reads or writes the blobs already in the
+ * bucket. Each bucket is replaced by:
+ *
+ *   Reshape(g_i) -> g_i_flat            (for every blob of the bucket)
+ *   Concat(g_1_flat, ..., g_n_flat) -> bucket
+ *   Allreduce(common_world, bucket) -> bucket
+ *   Split(bucket) -> g_1_flat, ..., g_n_flat
+ *   Reshape(g_i_flat) -> g_i            (restoring the original shape)
+ *
+ * The blobs of a bucket are expected to have the same data type.
+ */
+class AllreduceBucketingTransform : public Transform {
+ public:
+  explicit AllreduceBucketingTransform(int max_bucket_size = 16)
+      : max_bucket_size_(max_bucket_size) {
+    SetPatternMatchType(SORTED_WRT_EXECUTION_ORDER);
+  }
+
+ protected:
+  bool PatternRule(
+      const transform::Graph& g,
+      const std::vector<int>& subgraph,
+      int idx) override;
+  bool ValidatorRule(
+      const transform::Graph& g,
+      const std::vector<int>& subgraph) override;
+  bool ReplaceRule(const std::vector<int>& subgraph, transform::Graph* g_ptr)
+      override;
+
+ private:
+  // Max number of Allreduce ops fused into a bucket.
+  int max_bucket_size_;
+};
+
+} // namespace caffe2
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/allreduce_bucketing_transform.h"
+
+namespace caffe2 {
+
+namespace {
+
+using transform::Graph;
+
+int FindWriter(const NetDef& netdef, const string& blob) {
+  for (int i = 0; i < netdef.op_size(); i++) {
+    for (const auto& output : netdef.op(i).output()) {
+      if (output == blob) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+/**
+ *  Before: (Relu)-->(Allreduce)-->(Relu)    for g1, g2 and g3
+ *
+ *  After : (Relu)-->(Reshape)-\                    /-->(Reshape)-->(Relu)
+ *          (Relu)-->(Reshape)--(Concat)-->(Allreduce)-->(Split)-->(Reshape)...
+ *          (Relu)-->(Reshape)-/                    \-->(Reshape)-->(Relu)
+ */
+TEST(AllreduceBucketingTest, TestSimple) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"x"}, {"g1"});
+  AddOp(&netdef, "Allreduce", {"cw", "g1"}, {"g1"})->set_engine("GLOO");
+  AddOp(&netdef, "Relu", {"x"}, {"g2"});
+  AddOp(&netdef, "Allreduce", {"cw", "g2"}, {"g2"})->set_engine("GLOO");
+  AddOp(&netdef, "Relu", {"x"}, {"g3"});
+  AddOp(&netdef, "Allreduce", {"cw", "g3"}, {"g3"})->set_engine("GLOO");
+  AddOp(&netdef, "Relu", {"g1"}, {"out1"});
+  AddOp(&netdef, "Relu", {"g2"}, {"out2"});
+  AddOp(&netdef, "Relu", {"g3"}, {"out3"});
+
+  auto t = TransformRegistry()->Create("AllreduceBucketing");
+  CHECK(t);
+  EXPECT_EQ(t->PatternMatch(Graph(netdef)).size(), 1); // one bucket
+  EXPECT_EQ(t->PatternMatch(Graph(netdef)).at(0).size(), 3); // of 3 ops
+
+  NetDef transformed_netdef = t->ApplyTo(netdef);
+  // 6 Relu, 3 + 3 Reshape, Concat, Allreduce, Split
+  EXPECT_EQ(transformed_netdef.op_size(), 15);
+
+  int allreduces = 0;
+  for (const auto& op : transformed_netdef.op()) {
+    if (op.type() == "Allreduce") {
+      allreduces++;
+      EXPECT_EQ(op.engine(), "GLOO");
+      EXPECT_EQ(op.input(0), "cw");
+      EXPECT_EQ(op.input(1), op.output(0));
+    }
+  }
+  EXPECT_EQ(allreduces, 1);
+
+  // The consumers of the gradients run after their shapes are restored,
+  // which is after the reduction.
+  int allreduce = FindWriter(transformed_netdef, "transform/g1_bucket");
+  ASSERT_GE(allreduce, 0);
+  for (int i = 1; i <= 3; i++) {
+    auto grad = "g" + caffe2::to_string(i);
+    auto out = FindWriter(transformed_netdef, "out" + caffe2::to_string(i));
+    int restore = -1;
+    for (int j = 0; j < transformed_netdef.op_size(); j++) {
+      const auto& op = transformed_netdef.op(j);
+      if (op.type() == "Reshape" && op.output(0) == grad) {
+        restore = j;
+      }
+    }
+    EXPECT_GT(restore, allreduce);
+    EXPECT_GT(out, restore);
+  }
+}
+
+// An op reading a gradient between two Allreduce ops keeps them apart.
+TEST(AllreduceBucketingTest, TestReadInBetween) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"x"}, {"g1"});
+  AddOp(&netdef, "Allreduce", {"cw", "g1"}, {"g1"});
+  AddOp(&netdef, "Relu", {"g1"}, {"y"});
+  AddOp(&netdef, "Relu", {"x"}, {"g2"});
+  AddOp(&netdef, "Allreduce", {"cw", "g2"}, {"g2"});
+  AddOp(&netdef, "Relu", {"x"}, {"g3"});
+  AddOp(&netdef, "Allreduce", {"cw", "g3"}, {"g3"});
+
+  auto t = TransformRegistry()->Create("AllreduceBucketing");
+  CHECK(t);
+  auto matches = t->PatternMatch(Graph(netdef));
+  EXPECT_EQ(matches.size(), 1);
+  EXPECT_EQ(matches.at(0), std::vector<int>({4, 6}));
+}
+
+// Allreduce ops on different common worlds are not bucketed together.
+TEST(AllreduceBucketingTest, TestDifferentCommonWorlds) {
+  NetDef netdef;
+  AddOp(&netdef, "Relu", {"x"}, {"g1"});
+  AddOp(&netdef, "Allreduce", {"cw1", "g1"}, {"g1"});
+  AddOp(&netdef, "Relu", {"x"}, {"g2"});
+  AddOp(&netdef, "Allreduce", {"cw2", "g2"}, {"g2"});
+
+  auto t = TransformRegistry()->Create("AllreduceBucketing");
+  CHECK(t);
+  EXPECT_EQ(t->PatternMatch(Graph(netdef)).size(), 0);
+  EXPECT_EQ(t->ApplyTo(netdef).op_size(), 4);
+}
+
+} // namespace
+
+} // namespace caffe2
@@ -0,0 +1,289 @@
+#ifndef CAFFE2_UTILS_CONCURRENT_INT_MAP_H_
+#define CAFFE2_UTILS_CONCURRENT_INT_MAP_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace caffe2 {
+
+// A hash map from integer keys to integer values, for many threads looking
+// up and inserting keys at once. Entries can't be erased or changed once
+// inserted, except by clear().
+//
+// The map is split in kNumShards shards by the high bits of the key hash,
+// each of them an open addressing table with linear probing and a mutex
+// taken by inserts only. Lookups take no locks: the slots are atomics, and a
+// slot is published by its `full` flag once its key and value are written.
+// A table outgrown by its shard is kept alive, not freed, so a lookup racing
+// with the growth still reads valid (if stale) memory and at worst misses a
+// key inserted meanwhile. Since the tables double, the kept ones take less
+// memory than the live one.
+template <typename K, typename V>
+class ConcurrentIntMap {
+  static_assert(
+      std::is_integral<K>::value && std::is_integral<V>::value,
+      "ConcurrentIntMap only holds integer keys and values");
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+
+  static constexpr int kNumShardBits = 6;
+  static constexpr int kNumShards = 1 << kNumShardBits;
+
+  explicit ConcurrentIntMap(size_t capacity_hint = 0) {
+    size_t shard_capacity = kMinCapacity;
+    while (shard_capacity * kMaxLoadFactor < capacity_hint / kNumShards + 1) {
+      shard_capacity *= 2;
+    }
+    for (auto& shard : shards_) {
+      shard.Grow(shard_capacity);
+    }
+  }
+
+  ConcurrentIntMap(const ConcurrentIntMap&) = delete;
+  ConcurrentIntMap& operator=(const ConcurrentIntMap&) = delete;
+
+  // Sets *value to the value of key and returns true, or returns false if
+  // key is missing. Takes no lock.
+  bool Find(K key, V* value) const {
+    const uint64_t hash = Hash(key);
+    return shards_[ShardIndex(hash)].Find(key, hash, value);
+  }
+
+  // Looks up numKeys keys at once, setting values[i] to the value of
+  // keys[i], or to missing. The slots of a group of keys are prefetched
+  // before they are probed, so that the cache misses of the group overlap.
+  // Returns the number of missing keys. Takes no lock.
+  size_t Find(const K* keys, size_t numKeys, V* values, V missing) const {
+    constexpr size_t kGroupSize = 16;
+    uint64_t hashes[kGroupSize];
+    size_t numMissing = 0;
+    for (size_t begin = 0; begin < numKeys; begin += kGroupSize) {
+      const size_t n = std::min(kGroupSize, numKeys - begin);
+      for (size_t i = 0; i < n; ++i) {
+        hashes[i] = Hash(keys[begin + i]);
+        shards_[ShardIndex(hashes[i])].Prefetch(hashes[i]);
+      }
+      for (size_t i = 0; i < n; ++i) {
+        const auto& shard = shards_[ShardIndex(hashes[i])];
+        if (!shard.Find(keys[begin + i], hashes[i], &values[begin + i])) {
+          values[begin + i] = missing;
+          ++numMissing;
+        }
+      }
+    }
+    return numMissing;
+  }
+
+  // Returns the value of key, inserting make_value() for it if it is
+  // missing. make_value is called under the lock of the shard holding key,
+  // at most once, and may throw to leave key missing.
+  template <typename F>
+  V FindOrInsert(K key, F make_value) {
+    const uint64_t hash = Hash(key);
+    auto& shard = shards_[ShardIndex(hash)];
+    V value;
+    if (shard.Find(key, hash, &value)) {
+      return value;
+    }
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    if (shard.Find(key, hash, &value)) {
+      return value;
+    }
+    value = make_value();
+    shard.InsertLocked(key, hash, value);
+    return value;
+  }
+
+  // Inserts key with value and returns true, or returns false and leaves the
+  // map unchanged if key is already present (as std::unordered_map::emplace)
+  bool Insert(K key, V value) {
+    bool inserted = false;
+    FindOrInsert(key, [&]() {
+      inserted = true;
+      return value;
+    });
+    return inserted;
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+      size += shard.size.load(std::memory_order_relaxed);
+    }
+    return size;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  // Calls f(key, value) for every entry, with all the shards locked, so that
+  // the walk sees every insert that completed before it and none during it
+  template <typename F>
+  void ForEach(F f) const {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(kNumShards);
+    for (const auto& shard : shards_) {
+      locks.emplace_back(shard.mutex);
+    }
+    for (const auto& shard : shards_) {
+      const Table* table = shard.table.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < table->capacity; ++i) {
+        const Slot& slot = table->slots[i];
+        if (slot.full.load(std::memory_order_relaxed)) {
+          f(slot.key.load(std::memory_order_relaxed),
+            slot.value.load(std::memory_order_relaxed));
+        }
+      }
+    }
+  }
+
+  // Removes all the entries and frees the outgrown tables. Unlike the other
+  // methods, it must not run concurrently with any other call.
+  void clear() {
+    for (auto& shard : shards_) {
+      shard.tables.clear();
+      shard.size.store(0, std::memory_order_relaxed);
+      shard.Grow(kMinCapacity);
+    }
+  }
+
+ private:
+  static constexpr size_t kMinCapacity = 16;
+  // a shard grows when more than half of its slots are full, which keeps
+  // the probe sequences short
+  static constexpr size_t kMaxLoadFactor = 2;
+
+  struct Slot {
+    std::atomic<K> key;
+    std::atomic<V> value;
+    std::atomic<bool> full;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : capacity(capacity), slots(new Slot[capacity]) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].full.store(false, std::memory_order_relaxed);
+      }
+    }
+
+    const size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  struct Shard {
+    bool Find(K key, uint64_t hash, V* value) const {
+      const Table* t = table.load(std::memory_order_acquire);
+      const size_t mask = t->capacity - 1;
+      for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = t->slots[i];
+        if (!slot.full.load(std::memory_order_acquire)) {
+          return false;
+        }
+        if (slot.key.load(std::memory_order_relaxed) == key) {
+          *value = slot.value.load(std::memory_order_relaxed);
+          return true;
+        }
+      }
+    }
+
+    void Prefetch(uint64_t hash) const {
+#if defined(__GNUC__)
+      const Table* t = table.load(std::memory_order_acquire);
+      __builtin_prefetch(&t->slots[hash & (t->capacity - 1)]);
+#endif
+    }
+
+    // Inserts a missing key, under mutex
+    void InsertLocked(K key, uint64_t hash, V value) {
+      Table* t = table.load(std::memory_order_relaxed);
+      if ((size.load(std::memory_order_relaxed) + 1) * kMaxLoadFactor >
+          t->capacity) {
+        Grow(t->capacity * 2);
+        t = table.load(std::memory_order_relaxed);
+      }
+      Put(t, key, hash, value);
+      size.store(
+          size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Moves the entries to a new table of capacity slots, under mutex. The
+    // old table stays readable by concurrent lookups.
+    void Grow(size_t capacity) {
+      std::unique_ptr<Table> grown(new Table(capacity));
+      if (!tables.empty()) {
+        const Table* old = tables.back().get();
+        for (size_t i = 0; i < old->capacity; ++i) {
+          const Slot& slot = old->slots[i];
+          if (slot.full.load(std::memory_order_relaxed)) {
+            const K key = slot.key.load(std::memory_order_relaxed);
+            Put(grown.get(),
+                key,
+                Hash(key),
+                slot.value.load(std::memory_order_relaxed));
+          }
+        }
+      }
+      table.store(grown.get(), std::memory_order_release);
+      tables.push_back(std::move(grown));
+    }
+
+    static void Put(Table* t, K key, uint64_t hash, V value) {
+      const size_t mask = t->capacity - 1;
+      size_t i = hash & mask;
+      while (t->slots[i].full.load(std::memory_order_relaxed)) {
+        i = (i + 1) & mask;
+      }
+      t->slots[i].key.store(key, std::memory_order_relaxed);
+      t->slots[i].value.store(value, std::memory_order_relaxed);
+      // publishes the key and value to the lookups
+      t->slots[i].full.store(true, std::memory_order_release);
+    }
+
+    mutable std::mutex mutex;
+    std::atomic<Table*> table{nullptr};
+    std::atomic<size_t> size{0};
+    // every table of the shard, the live one last, guarded by mutex
+    std::vector<std::unique_ptr<Table>> tables;
+  };
+
+  // the finalizer of MurmurHash3, so that the sequential ids common as
+  // keys spread over the shards and slots
+  static uint64_t Hash(K key) {
+    uint64_t h = static_cast<uint64_t>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static size_t ShardIndex(uint64_t hash) {
+    return hash >> (64 - kNumShardBits);
+  }
+
+  Shard shards_[kNumShards];
+};
+
+template <typename K, typename V>
+constexpr int ConcurrentIntMap<K, V>::kNumShardBits;
+template <typename K, typename V>
+constexpr int ConcurrentIntMap<K, V>::kNumShards;
+template <typename K, typename V>
+constexpr size_t ConcurrentIntMap<K, V>::kMinCapacity;
+template <typename K, typename V>
+constexpr size_t ConcurrentIntMap<K, V>::kMaxLoadFactor;
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_CONCURRENT_INT_MAP_H_
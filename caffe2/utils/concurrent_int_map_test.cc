@@ -0,0 +1,84 @@
+#include <thread> // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/utils/concurrent_int_map.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+TEST(ConcurrentIntMapTest, InsertAndFind) {
+  ConcurrentIntMap<int64_t, int32_t> map;
+  EXPECT_TRUE(map.empty());
+  for (int64_t i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(map.Insert(i * 7919 - 5000, i));
+  }
+  // an existing key keeps its value
+  EXPECT_FALSE(map.Insert(-5000, 42));
+  EXPECT_EQ(map.size(), 10000);
+  for (int64_t i = 0; i < 10000; ++i) {
+    int32_t value = -1;
+    EXPECT_TRUE(map.Find(i * 7919 - 5000, &value));
+    EXPECT_EQ(value, i);
+  }
+  int32_t value = -1;
+  EXPECT_FALSE(map.Find(1, &value));
+
+  std::unordered_map<int64_t, int32_t> entries;
+  map.ForEach([&](int64_t k, int32_t v) { entries.emplace(k, v); });
+  EXPECT_EQ(entries.size(), 10000);
+  EXPECT_EQ(entries[7919 - 5000], 1);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.Find(-5000, &value));
+}
+
+TEST(ConcurrentIntMapTest, BatchedFind) {
+  ConcurrentIntMap<int32_t, int64_t> map(100);
+  for (int32_t i = 0; i < 100; ++i) {
+    map.Insert(i * 2, i + 1);
+  }
+  std::vector<int32_t> keys;
+  for (int32_t i = 0; i < 101; ++i) {
+    keys.push_back(i);
+  }
+  std::vector<int64_t> values(keys.size());
+  EXPECT_EQ(map.Find(keys.data(), keys.size(), values.data(), -1), 50);
+  for (int32_t i = 0; i < 101; ++i) {
+    EXPECT_EQ(values[i], i % 2 ? -1 : i / 2 + 1);
+  }
+}
+
+TEST(ConcurrentIntMapTest, ConcurrentFindOrInsert) {
+  ConcurrentIntMap<int64_t, int64_t> map;
+  std::atomic<int64_t> next_id{0};
+  const int kNumThreads = 8;
+  const int64_t kNumKeys = 20000;
+  std::vector<std::vector<int64_t>> ids(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      // each thread walks the keys in its own order
+      for (int64_t i = 0; i < kNumKeys; ++i) {
+        const int64_t key = (i * (2 * t + 1)) % kNumKeys;
+        ids[t].push_back(map.FindOrInsert(key, [&]() { return next_id++; }));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // every key got a single id
+  EXPECT_EQ(map.size(), kNumKeys);
+  EXPECT_EQ(next_id.load(), kNumKeys);
+  for (int t = 0; t < kNumThreads; ++t) {
+    for (int64_t i = 0; i < kNumKeys; ++i) {
+      int64_t id = -1;
+      EXPECT_TRUE(map.Find((i * (2 * t + 1)) % kNumKeys, &id));
+      EXPECT_EQ(ids[t][i], id);
+    }
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,264 @@
+#ifndef CAFFE2_UTILS_LOCK_FREE_THREAD_POOL_H_
+#define CAFFE2_UTILS_LOCK_FREE_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/numa.h"
+#include "caffe2/utils/thread_pool.h"
+
+namespace caffe2 {
+
+/// @brief Bounded multi-producer multi-consumer FIFO queue.
+///
+/// Every slot of the ring carries a sequence number telling whether it is
+/// ready to be written (sequence == position) or read (sequence ==
+/// position + 1), so producers and consumers only contend on a single
+/// compare-and-swap of their own position (Dmitry Vyukov's bounded queue).
+/// Capacity is rounded up to a power of two.
+template <typename T>
+class MPMCQueue {
+ public:
+  explicit MPMCQueue(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (std::size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  MPMCQueue(const MPMCQueue&) = delete;
+  MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+  std::size_t capacity() const {
+    return mask_ + 1;
+  }
+
+  /// @brief Returns false, leaving value untouched, when the queue is full.
+  bool push(T& value) {
+    Cell* cell;
+    auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) -
+          static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Returns false when the queue is empty.
+  bool pop(T& value) {
+    Cell* cell;
+    auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq) -
+          static_cast<std::intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->data);
+    cell->data = T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  std::size_t mask_;
+  // keep the two positions on separate cache lines
+  alignas(64) std::atomic<std::size_t> enqueue_pos_;
+  alignas(64) std::atomic<std::size_t> dequeue_pos_;
+};
+
+/// @brief Thread pool whose workers take their tasks from a lock-free ring.
+///
+/// Adding and taking a task doesn't lock as long as the ring has space and
+/// the workers are awake: an idle worker spins (yielding) for a while before
+/// going to sleep, and producers only take the mutex to wake sleeping
+/// workers. When the ring is full tasks spill into a mutex protected
+/// overflow queue. Tasks run first in first out, priorities are ignored.
+class LockFreeTaskThreadPool : public TaskThreadPool {
+ public:
+  explicit LockFreeTaskThreadPool(
+      std::size_t pool_size,
+      int numa_node_id = -1,
+      std::size_t queue_capacity = 4096)
+      : TaskThreadPool(0, numa_node_id),
+        queue_(queue_capacity),
+        threads_(pool_size),
+        numa_node_id_(numa_node_id) {
+    for (std::size_t i = 0; i < pool_size; ++i) {
+      threads_[i] = std::thread(&LockFreeTaskThreadPool::main_loop, this);
+    }
+  }
+
+  ~LockFreeTaskThreadPool() override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      running_ = false;
+      condition_.notify_all();
+    }
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+
+  size_t size() const override {
+    return threads_.size();
+  }
+
+  void run(const std::function<void()>& func) override {
+    // counted before the push so that a worker can't finish the task and
+    // see no outstanding work while it is still being added
+    outstanding_.fetch_add(1);
+    auto task = func;
+    if (!queue_.push(task)) {
+      std::lock_guard<std::mutex> lock(overflow_mutex_);
+      overflow_.push_back(std::move(task));
+      overflow_size_.fetch_add(1);
+    }
+    queued_.fetch_add(1);
+    // A worker increments sleeping_ before checking queued_ under the mutex,
+    // so either it sees the new task or we see it sleeping and wake it.
+    if (sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      condition_.notify_one();
+    }
+  }
+
+  void runWithPriority(const std::function<void()>& func, int64_t /* unused */)
+      override {
+    run(func);
+  }
+
+  void waitWorkComplete() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    completed_.wait(lock, [this] { return outstanding_.load() == 0; });
+  }
+
+ private:
+  // number of times an idle worker polls the queue before sleeping
+  static constexpr int kSpinCount = 1024;
+
+  bool try_pop(std::function<void()>& task) {
+    if (queue_.pop(task)) {
+      return true;
+    }
+    if (overflow_size_.load() > 0) {
+      std::lock_guard<std::mutex> lock(overflow_mutex_);
+      if (!overflow_.empty()) {
+        task = std::move(overflow_.front());
+        overflow_.pop_front();
+        overflow_size_.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool wait_for_task(std::function<void()>& task) {
+    while (true) {
+      for (int i = 0; i < kSpinCount; ++i) {
+        if (try_pop(task)) {
+          return true;
+        }
+        if (!running_.load(std::memory_order_relaxed)) {
+          return false;
+        }
+        std::this_thread::yield();
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      sleeping_.fetch_add(1);
+      condition_.wait(
+          lock, [this] { return queued_.load() > 0 || !running_.load(); });
+      sleeping_.fetch_sub(1);
+      if (!running_) {
+        return false;
+      }
+    }
+  }
+
+  void main_loop() {
+    NUMABind(numa_node_id_);
+
+    std::function<void()> task;
+    while (wait_for_task(task)) {
+      queued_.fetch_sub(1);
+      try {
+        task();
+      } catch (const std::exception&) {
+      }
+      // destroy the task (and whatever it holds) before reporting it done
+      task = nullptr;
+      if (outstanding_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed_.notify_all();
+      }
+    }
+  }
+
+  MPMCQueue<std::function<void()>> queue_;
+  std::mutex overflow_mutex_;
+  std::deque<std::function<void()>> overflow_;
+  std::atomic<std::size_t> overflow_size_{0};
+  // tasks added but not taken by a worker yet, briefly negative when a
+  // worker takes a task before its producer counted it
+  std::atomic<int64_t> queued_{0};
+  // tasks added but not finished yet
+  std::atomic<std::size_t> outstanding_{0};
+  std::atomic<int> sleeping_{0};
+  std::atomic<bool> running_{true};
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::condition_variable completed_;
+  int numa_node_id_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_LOCK_FREE_THREAD_POOL_H_
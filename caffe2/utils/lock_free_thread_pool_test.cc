@@ -0,0 +1,100 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "caffe2/utils/lock_free_thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+TEST(MPMCQueueTest, PushPopInOrder) {
+  MPMCQueue<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 4);
+  int value;
+  EXPECT_FALSE(queue.pop(value));
+  for (int i = 0; i < 4; ++i) {
+    value = i;
+    EXPECT_TRUE(queue.push(value));
+  }
+  value = 4;
+  EXPECT_FALSE(queue.push(value));
+  EXPECT_EQ(value, 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(MPMCQueueTest, ConcurrentProducersAndConsumers) {
+  const int kThreads = 4;
+  const int kPerThread = 10000;
+  MPMCQueue<int> queue(64);
+  std::atomic<int> popped(0);
+  std::vector<std::atomic<int>> seen(kThreads * kPerThread);
+  for (auto& s : seen) {
+    s = 0;
+  }
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kPerThread; ++i) {
+        int value = t * kPerThread + i;
+        while (!queue.push(value)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&]() {
+      int value;
+      while (popped.load() < kThreads * kPerThread) {
+        if (queue.pop(value)) {
+          seen[value]++;
+          popped++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& s : seen) {
+    EXPECT_EQ(s.load(), 1);
+  }
+}
+
+TEST(LockFreeTaskThreadPoolTest, RunsEveryTask) {
+  // a small ring, so that most of the tasks go through the overflow queue
+  LockFreeTaskThreadPool pool(4, -1, 8);
+  EXPECT_EQ(pool.size(), 4);
+  std::atomic<int> count(0);
+  for (int i = 0; i < 10000; ++i) {
+    pool.runWithPriority([&count]() { count++; }, i % 3);
+  }
+  pool.waitWorkComplete();
+  EXPECT_EQ(count.load(), 10000);
+
+  // workers that went to sleep are woken up by new tasks
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  pool.run([&count]() { count++; });
+  pool.waitWorkComplete();
+  EXPECT_EQ(count.load(), 10001);
+}
+
+TEST(LockFreeTaskThreadPoolTest, UsableAsTaskThreadPool) {
+  std::shared_ptr<TaskThreadPool> pool =
+      std::make_shared<LockFreeTaskThreadPool>(2);
+  std::atomic<int> count(0);
+  for (int i = 0; i < 100; ++i) {
+    pool->run([&count]() { count++; });
+  }
+  pool->waitWorkComplete();
+  EXPECT_EQ(count.load(), 100);
+  EXPECT_EQ(pool->size(), 2);
+}
+
+} // namespace caffe2
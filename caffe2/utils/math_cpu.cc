@@ -26,6 +26,10 @@
 #include "Eigen/Core"
 #include "Eigen/Dense"
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif // __SSE__
+
 #ifdef CAFFE2_USE_MKL
 #include <mkl.h>
 #endif  // CAFFE2_USE_MKL
@@ -1569,30 +1573,202 @@ void IncreaseIndex(const int* dims, std::vector<int>* index) {
   }
 }
 
+// Collapses the axes of a transpose to the fewest that describe the same
+// permutation of memory: unit axes are dropped, and input axes that stay
+// adjacent and in order in the output are merged. For example NCHW -> NHWC
+// (axes {0, 2, 3, 1}) becomes dims {N, C, HW} with axes {0, 2, 1}.
+void CollapseTransposeAxes(
+    const int num_axes,
+    const int* x_dims,
+    const int* axes,
+    std::vector<int>* dims,
+    std::vector<int>* new_axes) {
+  std::vector<int> kept_index(num_axes, -1);
+  std::vector<int> kept_dims;
+  for (int i = 0; i < num_axes; ++i) {
+    if (x_dims[i] != 1) {
+      kept_index[i] = kept_dims.size();
+      kept_dims.push_back(x_dims[i]);
+    }
+  }
+  // The first input axis of each run of consecutive axes, in output order.
+  std::vector<int> run_starts;
+  int prev = -2;
+  for (int i = 0; i < num_axes; ++i) {
+    const int axis = kept_index[axes[i]];
+    if (axis < 0) {
+      continue;
+    }
+    if (axis != prev + 1) {
+      run_starts.push_back(axis);
+    }
+    prev = axis;
+  }
+  // The runs partition the input axes, so their input order is the order of
+  // their first axes.
+  const int num_runs = run_starts.size();
+  std::vector<int> order(num_runs);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&run_starts](int i, int j) {
+    return run_starts[i] < run_starts[j];
+  });
+  dims->assign(num_runs, 1);
+  new_axes->resize(num_runs);
+  for (int r = 0; r < num_runs; ++r) {
+    const int begin = run_starts[order[r]];
+    const int end =
+        r + 1 < num_runs ? run_starts[order[r + 1]] : kept_dims.size();
+    for (int i = begin; i < end; ++i) {
+      (*dims)[r] *= kept_dims[i];
+    }
+    (*new_axes)[order[r]] = r;
+  }
+}
+
+// Transposes the tile [r_begin, r_end) x [c_begin, c_end) of the rows x cols
+// matrix X into the cols x rows matrix Y.
+template <typename T>
+void TransposeTileScalar(
+    const int rows,
+    const int cols,
+    const int r_begin,
+    const int r_end,
+    const int c_begin,
+    const int c_end,
+    const T* X,
+    T* Y) {
+  for (int r = r_begin; r < r_end; ++r) {
+    for (int c = c_begin; c < c_end; ++c) {
+      Y[c * rows + r] = X[r * cols + c];
+    }
+  }
+}
+
+template <typename T>
+void TransposeTile(
+    const int rows,
+    const int cols,
+    const int r_begin,
+    const int r_end,
+    const int c_begin,
+    const int c_end,
+    const T* X,
+    T* Y) {
+  TransposeTileScalar(rows, cols, r_begin, r_end, c_begin, c_end, X, Y);
+}
+
+#ifdef __SSE__
+
+template <>
+void TransposeTile<float>(
+    const int rows,
+    const int cols,
+    const int r_begin,
+    const int r_end,
+    const int c_begin,
+    const int c_end,
+    const float* X,
+    float* Y) {
+  // 4x4 blocks are transposed in registers, the edges one item at a time.
+  const int r_4 = r_begin + (r_end - r_begin) / 4 * 4;
+  const int c_4 = c_begin + (c_end - c_begin) / 4 * 4;
+  for (int r = r_begin; r < r_4; r += 4) {
+    for (int c = c_begin; c < c_4; c += 4) {
+      const float* x = X + r * cols + c;
+      __m128 row0 = _mm_loadu_ps(x);
+      __m128 row1 = _mm_loadu_ps(x + cols);
+      __m128 row2 = _mm_loadu_ps(x + 2 * cols);
+      __m128 row3 = _mm_loadu_ps(x + 3 * cols);
+      _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+      float* y = Y + c * rows + r;
+      _mm_storeu_ps(y, row0);
+      _mm_storeu_ps(y + rows, row1);
+      _mm_storeu_ps(y + 2 * rows, row2);
+      _mm_storeu_ps(y + 3 * rows, row3);
+    }
+  }
+  TransposeTileScalar(rows, cols, r_begin, r_4, c_4, c_end, X, Y);
+  TransposeTileScalar(rows, cols, r_4, r_end, c_begin, c_end, X, Y);
+}
+
+#endif // __SSE__
+
+// Transposes batch rows x cols matrices in 32x32 tiles, spreading the tiles
+// over the OpenMP threads when there is enough work.
+template <typename T>
+void BatchTranspose2D(
+    const int batch,
+    const int rows,
+    const int cols,
+    const T* X,
+    T* Y) {
+  constexpr int kTileSize = 32;
+  const int row_tiles = (rows + kTileSize - 1) / kTileSize;
+  const int col_tiles = (cols + kTileSize - 1) / kTileSize;
+  const int tiles_per_matrix = row_tiles * col_tiles;
+  const int num_tiles = batch * tiles_per_matrix;
+  const int matrix_size = rows * cols;
+#pragma omp parallel for if (batch * matrix_size >= (1 << 16))
+  for (int t = 0; t < num_tiles; ++t) {
+    const int b = t / tiles_per_matrix;
+    const int r = (t % tiles_per_matrix) / col_tiles * kTileSize;
+    const int c = (t % col_tiles) * kTileSize;
+    TransposeTile<T>(
+        rows,
+        cols,
+        r,
+        std::min(r + kTileSize, rows),
+        c,
+        std::min(c + kTileSize, cols),
+        X + b * matrix_size,
+        Y + b * matrix_size);
+  }
+}
+
 template <typename T>
 void TransposeCPU(
     const int num_axes,
     const int* x_dims,
-    const int* y_dims,
+    const int* /* y_dims */,
     const int* axes,
     const int data_size,
     const T* X,
     T* Y) {
-  // Measure amount of contiguous data we can copy at once
-  int block_size = 1;
-  int num_shared_idxs = 0;
-  for (int i = num_axes - 1; i >= 0 && axes[i] == i; --i) {
-    block_size *= y_dims[i];
-    ++num_shared_idxs;
+  if (data_size == 0) {
+    return;
   }
-
-  if (num_axes < 2 || num_shared_idxs == num_axes) {
+  std::vector<int> dims;
+  std::vector<int> perm;
+  CollapseTransposeAxes(num_axes, x_dims, axes, &dims, &perm);
+  const int ndim = dims.size();
+  if (ndim < 2) {
     memcpy(Y, X, data_size * sizeof(T));
     return;
   }
+  // Transposing the last two axes, possibly of a batch of matrices.
+  if (ndim == 2) {
+    BatchTranspose2D(1, dims[0], dims[1], X, Y);
+    return;
+  }
+  if (ndim == 3 && perm[0] == 0 && perm[1] == 2) {
+    BatchTranspose2D(dims[0], dims[1], dims[2], X, Y);
+    return;
+  }
 
-  const int itr_axes = num_axes - num_shared_idxs;
-  const std::vector<int> x_strides = ComputeXStrides(itr_axes, x_dims, axes);
+  // Otherwise walk the output, copying contiguous blocks if the last axis
+  // doesn't move.
+  std::vector<int> y_dims(ndim);
+  for (int i = 0; i < ndim; ++i) {
+    y_dims[i] = dims[perm[i]];
+  }
+  int block_size = 1;
+  int itr_axes = ndim;
+  if (perm[ndim - 1] == ndim - 1) {
+    block_size = dims[ndim - 1];
+    --itr_axes;
+  }
+  const std::vector<int> x_strides =
+      ComputeXStrides(itr_axes, dims.data(), perm.data());
   std::vector<int> index_digits(itr_axes, 0);
   const int num_blocks = data_size / block_size;
   for (int y_index = 0; y_index < num_blocks; ++y_index) {
@@ -1606,7 +1782,7 @@ void TransposeCPU(
           X + block_size * x_index,
           block_size * sizeof(T));
     }
-    IncreaseIndex(y_dims, &index_digits);
+    IncreaseIndex(y_dims.data(), &index_digits);
   }
 }
 
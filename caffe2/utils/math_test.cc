@@ -366,4 +366,62 @@ TEST(MathTest, TranposeTest) {
   }
 }
 
+TEST(MathTest, TransposeMatchesReference) {
+  DeviceOption option;
+  CPUContext cpu_context(option);
+
+  // Covers the batched 2D tiles (with edges not a multiple of the tile or
+  // the register block), axes merged in pairs, unit axes and the fallback.
+  const std::vector<std::pair<std::vector<int>, std::vector<int>>> cases = {
+      {{37, 70}, {1, 0}},
+      {{3, 1, 33, 5}, {0, 3, 2, 1}},
+      {{2, 3, 5, 7}, {0, 2, 3, 1}},
+      {{2, 3, 5, 7}, {0, 3, 1, 2}},
+      {{2, 3, 5, 7}, {3, 1, 0, 2}},
+      {{2, 3, 5, 7}, {2, 3, 0, 1}},
+      {{2, 3, 5, 7}, {1, 0, 2, 3}},
+      {{4, 1, 6}, {1, 0, 2}},
+      {{0, 3}, {1, 0}},
+  };
+  for (const auto& c : cases) {
+    const std::vector<int>& x_dims = c.first;
+    const std::vector<int>& axes = c.second;
+    const int num_axes = x_dims.size();
+    std::vector<int> y_dims(num_axes);
+    std::vector<int> x_strides(num_axes, 1);
+    for (int i = num_axes - 2; i >= 0; --i) {
+      x_strides[i] = x_strides[i + 1] * x_dims[i + 1];
+    }
+    for (int i = 0; i < num_axes; ++i) {
+      y_dims[i] = x_dims[axes[i]];
+    }
+    TensorCPU X(x_dims);
+    TensorCPU Y(y_dims);
+    float* x_data = X.mutable_data<float>();
+    for (int i = 0; i < X.size(); ++i) {
+      x_data[i] = static_cast<float>(i);
+    }
+    math::Transpose<float, CPUContext>(
+        num_axes,
+        x_dims.data(),
+        y_dims.data(),
+        axes.data(),
+        X.size(),
+        X.data<float>(),
+        Y.mutable_data<float>(),
+        &cpu_context);
+    std::vector<int> index(num_axes, 0);
+    for (int y_index = 0; y_index < Y.size(); ++y_index) {
+      int x_index = 0;
+      for (int i = 0; i < num_axes; ++i) {
+        x_index += index[i] * x_strides[axes[i]];
+      }
+      EXPECT_EQ(X.data<float>()[x_index], Y.data<float>()[y_index]);
+      for (int i = num_axes - 1; i >= 0 && ++index[i] == y_dims[i]; --i) {
+        index[i] = 0;
+      }
+    }
+  }
+}
+
 } // namespace caffe2
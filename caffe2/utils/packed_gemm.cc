@@ -0,0 +1,113 @@
+#include "caffe2/utils/packed_gemm.h"
+
+#include <algorithm>
+
+namespace caffe2 {
+
+constexpr int PackedGemmMatrix::kPanelWidth;
+
+namespace {
+
+constexpr int kPanelWidth = PackedGemmMatrix::kPanelWidth;
+// rows of X computed together, which read each panel once
+constexpr int kRows = 4;
+
+// Y[0:rows, 0:cols] = X[0:rows] * panel (+ b), with a full kPanelWidth wide
+// accumulator that the compiler keeps in vector registers
+template <int rows>
+void ComputePanel(
+    int K,
+    const float* X,
+    const float* panel,
+    const float* b,
+    int cols,
+    float* Y,
+    int ldy) {
+  float acc[rows][kPanelWidth] = {};
+  for (int k = 0; k < K; ++k) {
+    const float* w = panel + k * kPanelWidth;
+    for (int i = 0; i < rows; ++i) {
+      const float x = X[i * K + k];
+      for (int j = 0; j < kPanelWidth; ++j) {
+        acc[i][j] += x * w[j];
+      }
+    }
+  }
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      Y[i * ldy + j] = acc[i][j] + (b ? b[j] : 0.f);
+    }
+  }
+}
+
+} // namespace
+
+PackedGemmMatrix::PackedGemmMatrix(int N, int K, const float* W)
+    : N_(N), K_(K) {
+  const int num_panels = (N + kPanelWidth - 1) / kPanelWidth;
+  // the columns past N of the last panel are zeros
+  panels_.assign(static_cast<size_t>(num_panels) * K * kPanelWidth, 0.f);
+  for (int n = 0; n < N; ++n) {
+    float* panel = panels_.data() +
+        static_cast<size_t>(n / kPanelWidth) * K * kPanelWidth +
+        n % kPanelWidth;
+    const float* w = W + static_cast<size_t>(n) * K;
+    for (int k = 0; k < K; ++k) {
+      panel[k * kPanelWidth] = w[k];
+    }
+  }
+}
+
+void PackedGemmMatrix::Compute(int M, const float* X, const float* b, float* Y)
+    const {
+  for (int n = 0; n < N_; n += kPanelWidth) {
+    const float* panel =
+        panels_.data() + static_cast<size_t>(n / kPanelWidth) * K_ * kPanelWidth;
+    const int cols = std::min(kPanelWidth, N_ - n);
+    const float* panel_b = b ? b + n : nullptr;
+    int m = 0;
+    for (; m + kRows <= M; m += kRows) {
+      ComputePanel<kRows>(
+          K_,
+          X + static_cast<size_t>(m) * K_,
+          panel,
+          panel_b,
+          cols,
+          Y + static_cast<size_t>(m) * N_ + n,
+          N_);
+    }
+    for (; m < M; ++m) {
+      ComputePanel<1>(
+          K_,
+          X + static_cast<size_t>(m) * K_,
+          panel,
+          panel_b,
+          cols,
+          Y + static_cast<size_t>(m) * N_ + n,
+          N_);
+    }
+  }
+}
+
+const PackedGemmMatrix* PackedGemmMatrixCache::Get(
+    const void* tensor,
+    uint64_t version,
+    int N,
+    int K,
+    const float* W) {
+  if (tensor != tensor_ || version != version_ || N != N_ || K != K_) {
+    // a new weight, packed if the next run sees it unchanged
+    packed_.reset();
+    tensor_ = tensor;
+    version_ = version;
+    N_ = N;
+    K_ = K;
+    return nullptr;
+  }
+  if (!packed_) {
+    packed_.reset(new PackedGemmMatrix(N, K, W));
+  }
+  return packed_.get();
+}
+
+} // namespace caffe2
@@ -0,0 +1,64 @@
+#ifndef CAFFE2_UTILS_PACKED_GEMM_H_
+#define CAFFE2_UTILS_PACKED_GEMM_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace caffe2 {
+
+// A weight matrix W of N x K floats (row major, as the weight of an FC op),
+// packed once for the products Y = X * W^T + b of any number of rows M.
+//
+// BLAS gemm packs W into the panels its kernel reads on every call, which
+// dominates for the small M of inference. This packs W in panels of
+// kPanelWidth output columns, each of them K x kPanelWidth contiguous floats,
+// so Compute reads the panels in order with no repacking.
+class PackedGemmMatrix {
+ public:
+  static constexpr int kPanelWidth = 8;
+
+  PackedGemmMatrix(int N, int K, const float* W);
+
+  int N() const {
+    return N_;
+  }
+  int K() const {
+    return K_;
+  }
+
+  // Y (M x N) = X (M x K) * W^T + b, where b (N floats) may be nullptr
+  void Compute(int M, const float* X, const float* b, float* Y) const;
+
+ private:
+  int N_;
+  int K_;
+  std::vector<float> panels_;
+};
+
+// The packed weight of an FC op, repacked when the weight changes, as told by
+// Tensor::version(). The weight is only packed once it didn't change between
+// two runs, so that ops whose weight is updated every run (when training)
+// don't pack it for a single product.
+class PackedGemmMatrixCache {
+ public:
+  // The packed W, or nullptr when it should not be packed yet. W is
+  // identified by the tensor holding it and its version.
+  const PackedGemmMatrix* Get(
+      const void* tensor,
+      uint64_t version,
+      int N,
+      int K,
+      const float* W);
+
+ private:
+  const void* tensor_ = nullptr;
+  uint64_t version_ = 0;
+  int N_ = 0;
+  int K_ = 0;
+  std::unique_ptr<PackedGemmMatrix> packed_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_PACKED_GEMM_H_
@@ -0,0 +1,73 @@
+#include "caffe2/utils/packed_gemm.h"
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace caffe2 {
+
+namespace {
+
+void checkPackedGemm(int M, int N, int K, bool with_bias) {
+  std::mt19937 gen(M * 10007 + N * 101 + K);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> X(M * K), W(N * K), b(N), Y(M * N);
+  for (auto* v : {&X, &W, &b}) {
+    for (auto& x : *v) {
+      x = dist(gen);
+    }
+  }
+  PackedGemmMatrix packed(N, K, W.data());
+  EXPECT_EQ(packed.N(), N);
+  EXPECT_EQ(packed.K(), K);
+  packed.Compute(M, X.data(), with_bias ? b.data() : nullptr, Y.data());
+  for (int m = 0; m < M; ++m) {
+    for (int n = 0; n < N; ++n) {
+      float expected = with_bias ? b[n] : 0.f;
+      for (int k = 0; k < K; ++k) {
+        expected += X[m * K + k] * W[n * K + k];
+      }
+      EXPECT_NEAR(Y[m * N + n], expected, 1e-4)
+          << "M " << M << " N " << N << " K " << K << " at " << m << ", " << n;
+    }
+  }
+}
+
+} // namespace
+
+TEST(PackedGemmTest, MatchesGemm) {
+  // sizes around the panel width and the rows computed together
+  for (int M : {1, 3, 4, 5, 17}) {
+    for (int N : {1, 7, 8, 9, 33}) {
+      for (int K : {1, 16, 31}) {
+        checkPackedGemm(M, N, K, true);
+        checkPackedGemm(M, N, K, false);
+      }
+    }
+  }
+}
+
+TEST(PackedGemmTest, CacheRepacksChangedWeights) {
+  std::vector<float> W(6, 1.f);
+  PackedGemmMatrixCache cache;
+  int tensor = 0;
+  // packed from the second run with the same version
+  EXPECT_EQ(cache.Get(&tensor, 1, 2, 3, W.data()), nullptr);
+  const auto* packed = cache.Get(&tensor, 1, 2, 3, W.data());
+  ASSERT_NE(packed, nullptr);
+  EXPECT_EQ(cache.Get(&tensor, 1, 2, 3, W.data()), packed);
+
+  W[0] = 2.f;
+  EXPECT_EQ(cache.Get(&tensor, 2, 2, 3, W.data()), nullptr);
+  packed = cache.Get(&tensor, 2, 2, 3, W.data());
+  ASSERT_NE(packed, nullptr);
+  std::vector<float> X = {1.f, 0.f, 0.f};
+  std::vector<float> Y(2);
+  packed->Compute(1, X.data(), nullptr, Y.data());
+  EXPECT_EQ(Y[0], 2.f);
+  EXPECT_EQ(Y[1], 1.f);
+
+  int other_tensor = 0;
+  EXPECT_EQ(cache.Get(&other_tensor, 2, 2, 3, W.data()), nullptr);
+}
+
+} // namespace caffe2
@@ -2,11 +2,13 @@
 #define CAFFE2_UTILS_THREAD_POOL_H_
 
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "caffe2/core/numa.h"
 
@@ -16,16 +18,45 @@ class TaskThreadPool {
  private:
   struct task_element_t {
     bool run_with_id;
-    const std::function<void()> no_id;
-    const std::function<void(std::size_t)> with_id;
+    std::function<void()> no_id;
+    std::function<void(std::size_t)> with_id;
+    int64_t priority;
+    // insertion order, to run tasks of the same priority first in first out
+    uint64_t sequence;
+
+    task_element_t(
+        const std::function<void()>& f,
+        int64_t priority,
+        uint64_t sequence)
+        : run_with_id(false),
+          no_id(f),
+          with_id(nullptr),
+          priority(priority),
+          sequence(sequence) {}
+    task_element_t(
+        const std::function<void(std::size_t)>& f,
+        int64_t priority,
+        uint64_t sequence)
+        : run_with_id(true),
+          no_id(nullptr),
+          with_id(f),
+          priority(priority),
+          sequence(sequence) {}
+  };
 
-    explicit task_element_t(const std::function<void()>& f)
-        : run_with_id(false), no_id(f), with_id(nullptr) {}
-    explicit task_element_t(const std::function<void(std::size_t)>& f)
-        : run_with_id(true), no_id(nullptr), with_id(f) {}
+  // Orders the queue: the highest priority first, then the oldest task
+  struct task_order_t {
+    bool operator()(const task_element_t& a, const task_element_t& b) const {
+      if (a.priority != b.priority) {
+        return a.priority < b.priority;
+      }
+      return a.sequence > b.sequence;
+    }
   };
 
-  std::queue<task_element_t> tasks_;
+  std::priority_queue<task_element_t, std::vector<task_element_t>, task_order_t>
+      tasks_;
+  uint64_t sequence_ = 0;
   std::vector<std::thread> threads_;
   std::mutex mutex_;
   std::condition_variable condition_;
@@ -50,7 +81,7 @@ class TaskThreadPool {
   }
 
   // Set running flag to false then notify all threads.
-  ~TaskThreadPool() {
+  virtual ~TaskThreadPool() {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       running_ = false;
@@ -65,40 +96,53 @@ class TaskThreadPool {
     }
   }
 
-  size_t size() const {
+  virtual size_t size() const {
     return threads_.size();
   }
 
   /// @brief Add task to the thread pool if a thread is currently available.
+  /// Queued tasks with a higher priority run first, tasks of the same
+  /// priority in the order they were added.
   template <typename Task>
-  void runTask(Task task) {
+  void runTask(Task task, int64_t priority = 0) {
     std::unique_lock<std::mutex> lock(mutex_);
 
     // Set task and signal condition variable so that a worker thread will
     // wake up and use the task.
-    tasks_.push(task_element_t(static_cast<std::function<void()>>(task)));
+    tasks_.push(task_element_t(
+        static_cast<std::function<void()>>(task), priority, sequence_++));
     complete_ = false;
     condition_.notify_one();
   }
 
-  void run(const std::function<void()>& func) {
+  // run, runWithPriority, size and waitWorkComplete are the interface used
+  // through ThreadPoolRegistry, pools with another queue override them.
+  virtual void run(const std::function<void()>& func) {
     runTask(func);
   }
 
+  virtual void runWithPriority(
+      const std::function<void()>& func,
+      int64_t priority) {
+    runTask(func, priority);
+  }
+
   template <typename Task>
-  void runTaskWithID(Task task) {
+  void runTaskWithID(Task task, int64_t priority = 0) {
     std::unique_lock<std::mutex> lock(mutex_);
 
     // Set task and signal condition variable so that a worker thread will
     // wake up and use the task.
-    tasks_.push(
-        task_element_t(static_cast<std::function<void(std::size_t)>>(task)));
+    tasks_.push(task_element_t(
+        static_cast<std::function<void(std::size_t)>>(task),
+        priority,
+        sequence_++));
     complete_ = false;
     condition_.notify_one();
   }
 
   /// @brief Wait for queue to be empty
-  void waitWorkComplete() {
+  virtual void waitWorkComplete() {
     std::unique_lock<std::mutex> lock(mutex_);
     while (!complete_) {
       completed_.wait(lock);
@@ -128,7 +172,7 @@ class TaskThreadPool {
       // useful in the event that the function contains
       // shared_ptr arguments bound via bind.
       {
-        auto tasks = tasks_.front();
+        auto tasks = tasks_.top();
         tasks_.pop();
         // Decrement count, indicating thread is no longer available.
         --available_;
@@ -0,0 +1,44 @@
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/utils/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+TEST(TaskThreadPoolTest, RunsHighestPriorityFirst) {
+  TaskThreadPool pool(1);
+  std::mutex gate;
+  std::mutex order_mutex;
+  std::vector<int> order;
+
+  // keep the only worker busy until every task is queued
+  gate.lock();
+  std::atomic<bool> started(false);
+  pool.run([&]() {
+    started = true;
+    std::lock_guard<std::mutex> g(gate);
+  });
+  while (!started) {
+  }
+
+  auto record = [&](int id) {
+    return [&, id]() {
+      std::lock_guard<std::mutex> g(order_mutex);
+      order.push_back(id);
+    };
+  };
+  pool.runWithPriority(record(0), 1);
+  pool.runWithPriority(record(1), 5);
+  pool.run(record(2));
+  pool.runWithPriority(record(3), 5);
+  pool.runWithPriority(record(4), 3);
+  gate.unlock();
+  pool.waitWorkComplete();
+
+  // by priority, then in the order they were added
+  EXPECT_EQ(order, std::vector<int>({1, 3, 4, 0, 2}));
+}
+
+} // namespace caffe2
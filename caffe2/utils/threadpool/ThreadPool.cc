@@ -4,6 +4,8 @@
 
 #include <cpuinfo.h>
 
+#include <atomic>
+
 CAFFE2_DEFINE_bool(caffe2_threadpool_force_inline, false,
                    "Force to always run jobs on the calling thread");
 
@@ -13,6 +15,11 @@ CAFFE2_DEFINE_int(caffe2_threadpool_android_cap, true, "");
 // Whether or not threadpool caps apply to iOS
 CAFFE2_DEFINE_int(caffe2_threadpool_ios_cap, true, "");
 
+// Whether or not the workers only run on the big cores of big.LITTLE CPUs
+CAFFE2_DEFINE_bool(caffe2_threadpool_pin_big_cores, true,
+                   "Run the threadpool workers on the big cores of "
+                   "heterogeneous CPUs");
+
 
 namespace caffe2 {
 
@@ -24,6 +31,34 @@ constexpr size_t kDefaultMinWorkSize = 8;
 constexpr size_t kDefaultMinWorkSize = 80;
 #endif
 
+// Each thread gets about this many chunks of the range, so that faster
+// threads can take over the work of slower ones
+constexpr size_t kChunksPerThread = 8;
+
+namespace {
+
+// The processors of the big cores on heterogeneous ARM CPUs, or nothing
+// when the cores are all the same. cpuinfo sorts the clusters from the
+// fastest cores to the slowest ones.
+std::vector<int> bigCoreProcessors() {
+#if defined(__linux__) && (CPUINFO_ARCH_ARM || CPUINFO_ARCH_ARM64)
+  if (cpuinfo_get_clusters_count() < 2) {
+    return {};
+  }
+  const auto* cluster = cpuinfo_get_cluster(0);
+  std::vector<int> cpus;
+  for (uint32_t i = 0; i < cluster->processor_count; ++i) {
+    cpus.push_back(
+        cpuinfo_get_processor(cluster->processor_start + i)->linux_id);
+  }
+  return cpus;
+#else
+  return {};
+#endif
+}
+
+} // namespace
+
 std::unique_ptr<ThreadPool> ThreadPool::defaultThreadPool() {
   CAFFE_ENFORCE(cpuinfo_initialize(), "cpuinfo initialization failed");
   int numThreads = cpuinfo_get_processors_count();
@@ -35,7 +70,15 @@ std::unique_ptr<ThreadPool> ThreadPool::defaultThreadPool() {
   applyCap = caffe2::FLAGS_caffe2_threadpool_ios_cap;
 #endif
 
-  if (applyCap) {
+  std::vector<int> workerCpus;
+  if (FLAGS_caffe2_threadpool_pin_big_cores) {
+    workerCpus = bigCoreProcessors();
+  }
+
+  if (applyCap && !workerCpus.empty()) {
+    /* One thread per big core */
+    numThreads = workerCpus.size();
+  } else if (applyCap) {
     switch (numThreads) {
 #if CAFFE2_ANDROID && (CPUINFO_ARCH_ARM || CPUINFO_ARCH_ARM64)
       case 4:
@@ -76,13 +119,14 @@ std::unique_ptr<ThreadPool> ThreadPool::defaultThreadPool() {
         break;
     }
   }
-  LOG(INFO) << "Constructing thread pool with " << numThreads << " threads";
-  return caffe2::make_unique<ThreadPool>(numThreads);
+  LOG(INFO) << "Constructing thread pool with " << numThreads << " threads"
+            << (workerCpus.empty() ? "" : " on the big cores");
+  return caffe2::make_unique<ThreadPool>(numThreads, std::move(workerCpus));
 }
 
-ThreadPool::ThreadPool(int numThreads)
+ThreadPool::ThreadPool(int numThreads, std::vector<int> workerCpus)
     : minWorkSize_(kDefaultMinWorkSize), numThreads_(numThreads),
-      workersPool_(std::make_shared<WorkersPool>()) {}
+      workersPool_(std::make_shared<WorkersPool>(std::move(workerCpus))) {}
 
 ThreadPool::~ThreadPool() {}
 
@@ -120,35 +164,41 @@ void ThreadPool::run(const std::function<void(int, size_t)>& fn, size_t range) {
     virtual ~FnTask(){};
     const std::function<void(int, size_t)> *fn_;
     int idx_;
-    size_t start_;
-    size_t end_;
+    std::atomic<size_t> *next_;
+    size_t range_;
+    size_t chunk_;
     virtual void Run() override {
-      for (auto i = start_; i < end_; ++i) {
-        (*fn_)(idx_, i);
+      while (true) {
+        const size_t start = next_->fetch_add(chunk_, std::memory_order_relaxed);
+        if (start >= range_) {
+          break;
+        }
+        const size_t end = std::min(range_, start + chunk_);
+        for (auto i = start; i < end; ++i) {
+          (*fn_)(idx_, i);
+        }
       }
     }
   };
 
   CAFFE_ENFORCE_GE(numThreads_, 1);
-  const size_t unitsPerTask = (range + numThreads_ - 1) / numThreads_;
-  tasks_.resize(numThreads_);
-  for (size_t i = 0; i < numThreads_; ++i) {
+  const size_t numTasks = std::min(numThreads_, range);
+  const size_t chunk =
+      std::max<size_t>(1, range / (numTasks * kChunksPerThread));
+  // Execute() waits for all the tasks, so the counter can be on the stack
+  std::atomic<size_t> next{0};
+  tasks_.resize(numTasks);
+  for (size_t i = 0; i < numTasks; ++i) {
     if (!tasks_[i]) {
       tasks_[i].reset(new FnTask());
     }
     auto *task = (FnTask *)tasks_[i].get();
     task->fn_ = &fn;
     task->idx_ = i;
-    task->start_ = std::min<size_t>(range, i * unitsPerTask);
-    task->end_ = std::min<size_t>(range, (i + 1) * unitsPerTask);
-    if (task->start_ >= task->end_) {
-      tasks_.resize(i);
-      break;
-    }
-    CAFFE_ENFORCE_LE(task->start_, range);
-    CAFFE_ENFORCE_LE(task->end_, range);
+    task->next_ = &next;
+    task->range_ = range;
+    task->chunk_ = chunk;
   }
-  CAFFE_ENFORCE_LE(tasks_.size(), numThreads_);
   CAFFE_ENFORCE_GE(tasks_.size(), 1);
   workersPool_->Execute(tasks_);
 }
@@ -28,7 +28,8 @@ constexpr size_t kCacheLineSize = 64;
 class alignas(kCacheLineSize) ThreadPool {
  public:
   static std::unique_ptr<ThreadPool> defaultThreadPool();
-  ThreadPool(int numThreads);
+  // The worker threads only run on the given processors, if any
+  ThreadPool(int numThreads, std::vector<int> workerCpus = {});
   ~ThreadPool();
   // Returns the number of threads currently in use
   int getNumThreads() const;
@@ -38,6 +39,9 @@ class alignas(kCacheLineSize) ThreadPool {
   // main (calling) thread
   void setMinWorkSize(size_t size);
   size_t getMinWorkSize() const { return minWorkSize_; }
+  // Runs fn(thread, i) for i in [0, range). The range is handed out in small
+  // chunks to the threads as they finish the previous ones, so that slow
+  // cores only get the work they can keep up with.
   void run(const std::function<void(int, size_t)>& fn, size_t range);
 
   // Run an arbitrary function in a thread-safe manner accessing the Workers
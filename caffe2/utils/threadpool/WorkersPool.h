@@ -5,11 +5,16 @@
 #include <atomic>
 #include <thread>
 #include <condition_variable>
+#include <vector>
 
 #if defined(_MSC_VER)
 #include <intrin.h>
 #endif
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 namespace caffe2 {
 
 // Uses code derived from gemmlowp,
@@ -23,6 +28,7 @@ namespace caffe2 {
 // - cache-line align Worker.
 // - use std::atomic instead of volatile and custom barriers.
 // - use std::mutex/std::condition_variable instead of raw pthreads.
+// - optionally restrict the workers to some processors.
 
 constexpr size_t kGEMMLOWPCacheLineSize = 64;
 
@@ -205,6 +211,24 @@ class BlockingCounter {
   std::atomic<std::size_t> count_{0};
 };
 
+// Restricts the calling thread to the given processors (ids as in
+// /sys/devices/system/cpu). Does nothing for an empty list, or outside Linux.
+inline void SetCurrentThreadAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__)
+  if (cpus.empty()) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    LOG(WARNING) << "Failed to set the affinity of a worker thread";
+  }
+#endif
+}
+
 // A workload for a worker.
 struct Task {
   Task() {}
@@ -222,11 +246,16 @@ class alignas(kGEMMLOWPCacheLineSize) Worker {
     ExitAsSoonAsPossible // Should exit at earliest convenience.
   };
 
-  explicit Worker(BlockingCounter* counter_to_decrement_when_ready)
+  Worker(
+      BlockingCounter* counter_to_decrement_when_ready,
+      const std::vector<int>& cpus)
       : task_(nullptr),
         state_(State::ThreadStartup),
         counter_to_decrement_when_ready_(counter_to_decrement_when_ready) {
-    thread_ = caffe2::make_unique<std::thread>([this]() { this->ThreadFunc(); });
+    thread_ = caffe2::make_unique<std::thread>([this, cpus]() {
+      SetCurrentThreadAffinity(cpus);
+      this->ThreadFunc();
+    });
   }
 
   ~Worker() {
@@ -325,7 +354,8 @@ class alignas(kGEMMLOWPCacheLineSize) Worker {
 
 class WorkersPool {
  public:
-  WorkersPool() {}
+  // The workers only run on the given processors, or anywhere if empty.
+  explicit WorkersPool(std::vector<int> cpus = {}) : cpus_(std::move(cpus)) {}
 
   void Execute(const std::vector<std::shared_ptr<Task>>& tasks) {
     CAFFE_ENFORCE_GE(tasks.size(), 1);
@@ -354,7 +384,8 @@ class WorkersPool {
     }
     counter_to_decrement_when_ready_.Reset(workers_count - workers_.size());
     while (workers_.size() < workers_count) {
-      workers_.push_back(MakeAligned<Worker>::make(&counter_to_decrement_when_ready_));
+      workers_.push_back(
+          MakeAligned<Worker>::make(&counter_to_decrement_when_ready_, cpus_));
     }
     counter_to_decrement_when_ready_.Wait();
   }
@@ -363,5 +394,7 @@ class WorkersPool {
   std::vector<std::unique_ptr<Worker, AlignedDeleter<Worker>>> workers_;
   // The BlockingCounter used to wait for the workers.
   BlockingCounter counter_to_decrement_when_ready_;
+  // The processors the workers are restricted to.
+  const std::vector<int> cpus_;
 };
 } // namespace caffe2
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "caffe2/utils/threadpool/ThreadPool.h"
+#include "caffe2/utils/threadpool/WorkersPool.h"
+#include <gtest/gtest.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace caffe2 {
+
+TEST(ThreadPoolTest, RunsEachIndexOnce) {
+  ThreadPool pool(4);
+  pool.setMinWorkSize(0);
+  for (size_t range : {1, 3, 4, 31, 1000}) {
+    std::vector<std::atomic<int>> counts(range);
+    std::atomic<bool> badThread(false);
+    pool.run(
+        [&](int thread, size_t i) {
+          if (thread < 0 || thread >= 4) {
+            badThread = true;
+          }
+          counts[i]++;
+        },
+        range);
+    EXPECT_FALSE(badThread);
+    for (size_t i = 0; i < range; ++i) {
+      EXPECT_EQ(counts[i], 1) << "range " << range << ", index " << i;
+    }
+  }
+}
+
+TEST(ThreadPoolTest, FastThreadsTakeOverWork) {
+  // The calling thread is slow on the first index, so the worker runs
+  // more than the half of the range a static split would give it.
+  ThreadPool pool(2);
+  pool.setMinWorkSize(0);
+  const size_t range = 64;
+  std::atomic<size_t> workerCount(0);
+  pool.run(
+      [&](int thread, size_t i) {
+        if (i == 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        if (thread == 1) {
+          workerCount++;
+        }
+      },
+      range);
+  EXPECT_GT(workerCount, range / 2);
+}
+
+#if defined(__linux__)
+TEST(ThreadPoolTest, WorkersRunOnTheGivenCpus) {
+  cpu_set_t allowed;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  int cpu = 0;
+  while (!CPU_ISSET(cpu, &allowed)) {
+    cpu++;
+  }
+  ThreadPool pool(3, {cpu});
+  pool.setMinWorkSize(0);
+  std::atomic<int> wrongCpu(0);
+  pool.run(
+      [&](int thread, size_t) {
+        // the calling thread runs the first task and keeps its affinity
+        if (thread != 0 && sched_getcpu() != cpu) {
+          wrongCpu++;
+        }
+      },
+      300);
+  EXPECT_EQ(wrongCpu, 0);
+}
+#endif
+
+} // namespace caffe2
@@ -550,14 +550,34 @@ if (USE_NNAPI AND NOT ANDROID)
   set(USE_NNAPI OFF)
 endif()
 
+if (USE_VULKAN)
+  find_program(GLSLANG_VALIDATOR glslangValidator)
+  if (NOT GLSLANG_VALIDATOR)
+    message(WARNING "Not compiling with Vulkan. Could not find glslangValidator.")
+    set(USE_VULKAN OFF)
+  else()
+    # libvulkan.so is loaded at runtime, so devices without it still work
+    include_directories(${PROJECT_SOURCE_DIR}/caffe2/mobile/contrib/libvulkan-stub/include)
+    list(APPEND Caffe2_DEPENDENCY_LIBS ${CMAKE_DL_LIBS})
+  endif()
+endif()
+
 if (USE_ATEN)
+  set(CAFFE2_USE_ATEN 1)
   list(APPEND Caffe2_DEPENDENCY_LIBS aten_op_header_gen ATen)
   include_directories(${PROJECT_BINARY_DIR}/caffe2/contrib/aten/aten/src/ATen)
   include_directories(${PROJECT_SOURCE_DIR}/aten/src)
   include_directories(${PROJECT_BINARY_DIR}/caffe2/contrib/aten)
+  # The TH and THC headers, with the configured THGeneral.h and
+  # THCGeneral.h, for the thc memory pool
+  include_directories(${PROJECT_SOURCE_DIR}/aten/src/TH)
+  include_directories(${PROJECT_SOURCE_DIR}/aten/src/THC)
+  include_directories(${PROJECT_BINARY_DIR}/caffe2/contrib/aten/aten/src/TH)
+  include_directories(${PROJECT_BINARY_DIR}/caffe2/contrib/aten/aten/src/THC)
 endif()
 
 if (USE_ZSTD)
+  set(CAFFE2_USE_ZSTD 1)
   list(APPEND Caffe2_DEPENDENCY_LIBS libzstd_static)
   include_directories(${PROJECT_SOURCE_DIR}/third_party/zstd/lib)
   add_subdirectory(${PROJECT_SOURCE_DIR}/third_party/zstd/build/cmake)
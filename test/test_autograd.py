@@ -1773,6 +1773,73 @@ class TestAutograd(TestCase):
         out.sum().backward()
         self.assertEqual(x.grad.data, y_data)
 
+    def test_cpu_work_stealing(self):
+        # The number of CPU workers is read once, when the engine starts its
+        # threads, so this has to run in a fresh process.
+        import os
+        import subprocess
+        script = """if True:
+            import torch
+            from torch.autograd import Function
+
+            class Reenter(Function):
+                @staticmethod
+                def forward(ctx, x):
+                    with torch.enable_grad():
+                        ctx.x = x.detach().requires_grad_()
+                        ctx.output_var = ctx.x * 2
+                    return ctx.output_var.detach()
+
+                @staticmethod
+                def backward(ctx, grad_output):
+                    with torch.enable_grad():
+                        ctx.output_var.sum().backward()
+                    return ctx.x.grad * grad_output
+
+            w = torch.randn(10, 10, requires_grad=True)
+            branches = [(w * i).tanh().sum() for i in range(200)]
+            sum(branches).backward()
+            expected = sum((1 - (w * i).tanh() ** 2) * i for i in range(200))
+            assert (w.grad - expected).abs().max().item() < 1e-4
+
+            x = torch.randn(2, 2, requires_grad=True)
+            sum(Reenter.apply(x * i).sum() for i in range(50)).backward()
+            assert (x.grad - sum(2 * i for i in range(50))).abs().max().item() < 1e-4
+        """
+        env = dict(os.environ, TORCH_AUTOGRAD_CPU_WORKERS='4')
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
+    @unittest.skipIf(not torch.cuda.is_available(), "CUDA unavailable")
+    def test_cuda_backward_streams(self):
+        # The number of streams is read once, when the engine starts its
+        # threads, so this has to run in a fresh process.
+        import os
+        import subprocess
+        script = """if True:
+            import torch
+
+            x = torch.randn(64, 64, device='cuda', requires_grad=True)
+            towers = []
+            for i in range(8):
+                y = x
+                for _ in range(10):
+                    y = (y * 1.01).tanh()
+                towers.append(y)
+            # a buffer summed across streams, and one the CPU writes
+            out = sum(towers) + x.cpu().mean().cuda() * sum(towers)
+            out.sum().backward()
+            gpu_grad = x.grad.cpu()
+
+            x_cpu = x.detach().cpu().requires_grad_()
+            y = x_cpu
+            for _ in range(10):
+                y = (y * 1.01).tanh()
+            (8 * y + x_cpu.mean() * 8 * y).sum().backward()
+            assert (gpu_grad - x_cpu.grad).abs().max().item() < 1e-3
+        """
+        env = dict(os.environ, TORCH_AUTOGRAD_CUDA_STREAMS='4')
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
     def test_cat(self):
         f_args_variable = (Variable(torch.randn(1, S, S), requires_grad=True),
                            Variable(torch.randn(2, S, S), requires_grad=True),
@@ -1890,6 +1957,78 @@ class TestAutograd(TestCase):
             self.assertEqual(info.name, expected_name)
             last_end = info.cpu_interval.end
 
+    def test_fan_in_accumulation(self):
+        x = Variable(torch.randn(4, 4), requires_grad=True)
+        ys = [x * i for i in range(1, 6)]
+        sum(y.sum() for y in ys).backward()
+        self.assertEqual(x.grad.data, torch.ones(4, 4) * 15)
+
+        # sums built while create_graph is set stay differentiable
+        x.grad = None
+        y = sum((x * x * i).sum() for i in range(1, 4))
+        grad, = torch.autograd.grad(y, x, create_graph=True)
+        self.assertEqual(grad.data, x.data * 12)
+        grad.sum().backward()
+        self.assertEqual(x.grad.data, torch.ones(4, 4) * 12)
+
+    @unittest.skipIf(not torch.cuda.is_available(), "CUDA unavailable")
+    def test_offload_saved_tensors(self):
+        def run(offload):
+            torch.manual_seed(0)
+            x = torch.randn(64, 64).cuda()
+            x.requires_grad = True
+            with torch.autograd.offload_saved_tensors(enabled=offload, min_bytes=0):
+                y = x.tanh().exp().mul(x).sigmoid()
+            y.sum().backward()
+            return y, x.grad
+
+        expected_y, expected_grad = run(False)
+        y, grad = run(True)
+        self.assertEqual(y, expected_y)
+        self.assertEqual(grad, expected_grad)
+        # the previous policy is restored on exit
+        self.assertEqual(torch.autograd._get_offload_saved_tensors()[0], False)
+
+    def test_profiler_sampling_and_buffer(self):
+        x = Variable(torch.randn(10, 10))
+
+        with profile(sample_period=3) as p:
+            for _ in range(6):
+                x.mul(2)
+        self.assertEqual([info.name for info in p.function_events], ['mul', 'mul'])
+
+        with profile(buffer_size=4) as p:
+            x.mul(2)
+            x.add(4)
+            x.sub(1)
+        # each range is a push and a pop, so only the last two survive
+        self.assertEqual([info.name for info in p.function_events], ['add', 'sub'])
+
+    def test_profiler_export(self):
+        import json
+        import tempfile
+        x = Variable(torch.randn(10, 10))
+
+        with profile() as p:
+            for _ in range(3):
+                x.mul(2)
+            x.add(4)
+
+        stats = {op.name: op for op in p.op_stats()}
+        self.assertEqual(set(stats), {'mul', 'add'})
+        self.assertEqual(stats['mul'].count, 3)
+        self.assertEqual(sum(stats['mul'].cpu_histogram), 3)
+        self.assertLessEqual(stats['mul'].cpu_min_us, stats['mul'].cpu_max_us)
+        mul_total = sum(evt.cpu_time_total for evt in p.function_events if evt.name == 'mul')
+        self.assertAlmostEqual(stats['mul'].cpu_total_us, mul_total, places=3)
+
+        with tempfile.NamedTemporaryFile(mode='w+', suffix='.json') as f:
+            p.export_chrome_trace(f.name)
+            f.seek(0)
+            trace = json.load(f)
+        self.assertEqual([evt['name'] for evt in trace], ['mul', 'mul', 'mul', 'add'])
+        self.assertTrue(all(evt['ph'] == 'X' for evt in trace))
+
     def test_dir(self):
         x = Variable(torch.randn(10, 10))
         keys = dir(x)
@@ -2444,6 +2583,8 @@ method_tests = [
     ('sum', (S, S, S), NO_ARGS),
     ('sum', (S, S, S), (1,), 'dim', [0]),
     ('sum', (S, S, S), (1, True,), 'keepdim_dim', [0]),
+    ('sum', (S, S, S), ([1, 2],), 'multi_dim'),
+    ('sum', (S, S, S), ([1, 2], True,), 'multi_dim_keepdim'),
     ('sum', (), NO_ARGS, 'scalar'),
     ('sum', (), (0,), 'scalar_dim', [0]),
     ('sum', (), (0, True,), 'scalar_keepdim_dim', [0]),
@@ -2,13 +2,14 @@ import math
 import tempfile
 import re
 import unittest
-from itertools import repeat
+from itertools import repeat, product
 
 import torch
 import torch.cuda
 import torch.cuda.comm as comm
+import torch.nn.functional as F
 
-from test_torch import TestTorch
+from test_torch import TestTorch, BytesIOContext
 from common import TestCase, get_gpu_type, to_gpu, freeze_rng_state, run_tests
 
 HAS_CUDA = True
@@ -695,6 +696,58 @@ class TestCuda(TestCase):
         for _ in self._test_memory_stats_generator(self):
             pass
 
+    def test_memory_fragmentation_stats(self):
+        torch.cuda.empty_cache()
+        stats = torch.cuda.memory_fragmentation_stats()
+        self.assertEqual(stats['free_bytes'],
+                         torch.cuda.memory_cached() - torch.cuda.memory_allocated())
+
+        # 3 MB tensors are carved out of a shared 20 MB segment, so freeing
+        # every other one leaves free blocks between the live ones
+        tensors = [torch.cuda.ByteTensor(3 * 1024 * 1024) for _ in range(6)]
+        del tensors[::2]
+        stats = torch.cuda.memory_fragmentation_stats()
+        self.assertEqual(stats['free_bytes'],
+                         torch.cuda.memory_cached() - torch.cuda.memory_allocated())
+        self.assertGreaterEqual(stats['free_blocks'], 3)
+        self.assertGreaterEqual(stats['largest_free_block'], 3 * 1024 * 1024)
+        self.assertEqual(sum(c for c, _ in stats['size_classes'].values()), stats['free_blocks'])
+        self.assertEqual(sum(b for _, b in stats['size_classes'].values()), stats['free_bytes'])
+        for size_class, (count, nbytes) in stats['size_classes'].items():
+            self.assertGreaterEqual(nbytes, count * size_class)
+            self.assertLess(nbytes, count * size_class * 2)
+
+        # a new 3 MB tensor reuses one of the holes instead of calling cudaMalloc
+        cached = torch.cuda.memory_cached()
+        tensors.append(torch.cuda.ByteTensor(3 * 1024 * 1024))
+        self.assertEqual(torch.cuda.memory_cached(), cached)
+        del tensors
+        torch.cuda.empty_cache()
+
+    def test_thrust_temporaries_cached(self):
+        x = torch.randn(1000, device='cuda')
+        y = torch.rand(1000, device='cuda')
+        weight = torch.randn(100, 10, device='cuda')
+        idx = torch.randint(0, 100, (50,), device='cuda', dtype=torch.long)
+
+        def run():
+            x.mode()
+            x.sort()
+            F.l1_loss(x, y)
+            F.kl_div(x, y)
+            F.soft_margin_loss(x, y.sign())
+            F.binary_cross_entropy(y, y)
+            F.embedding(idx, weight.clone(), max_norm=1)
+            torch.cuda.synchronize()
+
+        # once the cache holds their temporary storage, the Thrust calls
+        # don't need new cudaMallocs
+        run()
+        num_cuda_mallocs = torch.cuda.num_cuda_mallocs()
+        for _ in range(3):
+            run()
+        self.assertEqual(torch.cuda.num_cuda_mallocs(), num_cuda_mallocs)
+
     @unittest.skipIf(torch.cuda.device_count() < 2, "only one GPU detected")
     def test_memory_stats_multigpu(self):
         # advance a generator with a end flag
@@ -884,6 +937,19 @@ class TestCuda(TestCase):
         ]
         self._test_broadcast_coalesced(self, tensors, num_bytes * 5 // 2)
 
+    @unittest.skipIf(torch.cuda.device_count() < 2, "only one GPU detected")
+    def test_broadcast_coalesced_packed(self):
+        # tensors laid out back to back in one storage are broadcast without
+        # being copied into a flat buffer first
+        flat = torch.randn(30).cuda()
+        tensors = [
+            flat.narrow(0, 0, 6).view(2, 3),
+            flat.narrow(0, 6, 4),
+            flat.narrow(0, 10, 20).view(4, 5),
+        ]
+        self._test_broadcast_coalesced(self, tensors, 1024)
+        self._test_broadcast_coalesced(self, tensors, 40)
+
     @unittest.skipIf(torch.cuda.device_count() < 2, "only one GPU detected")
     def test_reduce_add(self):
         x = torch.randn(5, 5)
@@ -1068,6 +1134,9 @@ class TestCuda(TestCase):
     def test_cat_empty(self):
         TestTorch._test_cat_empty(self, use_cuda=True)
 
+    def test_cat_many_inputs(self):
+        TestTorch._test_cat_many_inputs(self, use_cuda=True)
+
     def test_bernoulli(self):
         x = torch.tensor([0, 1], dtype=torch.cuda.float32)
         self.assertEqual(x.bernoulli().tolist(), [0, 1])
@@ -1093,6 +1162,18 @@ class TestCuda(TestCase):
         self.assertIs(type(x_copy), type(x))
         self.assertEqual(x_copy.get_device(), x.get_device())
 
+    def test_serialization_chunked(self):
+        # bigger than the pinned buffers the storages are read through
+        x = [torch.randn(5 << 20).cuda(), torch.randn(3, 1 << 20).double().cuda()]
+        for is_real_file in (True, False):
+            with (tempfile.NamedTemporaryFile() if is_real_file else BytesIOContext()) as f:
+                torch.save(x, f)
+                f.seek(0)
+                x_copy = torch.load(f)
+            for original, copy in zip(x, x_copy):
+                self.assertEqual(copy, original)
+                self.assertIs(type(copy), type(original))
+
     def test_serialization_array_with_empty(self):
         x = [torch.randn(4, 4).cuda(), torch.cuda.FloatTensor()]
         with tempfile.NamedTemporaryFile() as f:
@@ -1249,6 +1330,63 @@ class TestCuda(TestCase):
             tmp3 = torch.cuda.FloatTensor(t.size())
             self.assertEqual(tmp3.data_ptr(), ptr[0], 'allocation not re-used')
 
+    def test_dlpack_stream(self):
+        from torch.utils.dlpack import from_dlpack, to_dlpack
+        cycles_per_ms = get_cycles_per_ms()
+        x = torch.cuda.FloatTensor(1000).fill_(1)
+        stream = torch.cuda.Stream()
+
+        # the consumer stream waits for the delayed fill of the producer
+        torch.cuda._sleep(int(50 * cycles_per_ms))
+        x.fill_(2)
+        capsule = to_dlpack(x, stream)
+        with torch.cuda.stream(stream):
+            y = from_dlpack(capsule)
+            z = y.sum()
+        stream.synchronize()
+        self.assertEqual(z, 2000)
+
+        # and the importer waits for the producer stream
+        with torch.cuda.stream(stream):
+            torch.cuda._sleep(int(50 * cycles_per_ms))
+            x.fill_(3)
+        w = from_dlpack(to_dlpack(x), stream)
+        self.assertEqual(w.sum(), 3000)
+
+    def test_dlpack_pinned(self):
+        from torch.utils.dlpack import from_dlpack, to_dlpack
+        x = torch.FloatTensor([1, 2, 3]).pin_memory()
+        y = from_dlpack(to_dlpack(x))
+        self.assertEqual(y.data_ptr(), x.data_ptr())
+        self.assertTrue(y.is_pinned())
+        self.assertEqual(y, x)
+
+    def test_cross_stream_reuse(self):
+        cycles_per_ms = get_cycles_per_ms()
+        torch.cuda.empty_cache()
+        torch.cuda._set_cross_stream_reuse(True)
+        try:
+            stream = torch.cuda.Stream()
+            # large enough to get a dedicated segment
+            size = 24 * 1024 * 1024 + 1
+            with torch.cuda.stream(stream):
+                tmp = torch.cuda.ByteTensor(size)
+                ptr = tmp.data_ptr()
+                torch.cuda._sleep(int(50 * cycles_per_ms))
+                del tmp
+
+            # the background stream is still busy, so the block can't move
+            tmp2 = torch.cuda.ByteTensor(size)
+            self.assertNotEqual(tmp2.data_ptr(), ptr, 'allocation re-used too soon')
+
+            # once the free event completed the block is handed over without
+            # synchronizing the current stream
+            stream.synchronize()
+            tmp3 = torch.cuda.ByteTensor(size)
+            self.assertEqual(tmp3.data_ptr(), ptr, 'allocation not re-used')
+        finally:
+            torch.cuda._set_cross_stream_reuse(False)
+
     def test_noncontiguous_pinned_memory(self):
         # See issue #3266
         x = torch.arange(0, 10).view((2, 5))
@@ -1273,6 +1411,19 @@ class TestCuda(TestCase):
         self.assertNotEqual(t.data_ptr(), ptr, 'allocation re-used too soon')
         self.assertEqual(list(gpu_tensor), [1])
 
+    def test_caching_pinned_memory_size_classes(self):
+        # sizes are rounded up to a power of two, so a slightly smaller
+        # allocation re-uses the freed block
+        t = torch.ByteTensor(3000).pin_memory()
+        del t
+        before = torch.cuda.host_memory_stats()
+        t = torch.ByteTensor(2500).pin_memory()
+        after = torch.cuda.host_memory_stats()
+        self.assertEqual(after['allocations'], before['allocations'] + 1)
+        self.assertEqual(after['cache_hits'], before['cache_hits'] + 1)
+        self.assertGreaterEqual(after['allocated_bytes'], 4096)
+        self.assertGreaterEqual(after['cached_bytes'], after['allocated_bytes'])
+
     @unittest.skipIf(torch.cuda.device_count() < 2, "only one GPU detected")
     def test_caching_pinned_memory_multi_gpu(self):
         # checks that the events preventing pinned memory from being re-used
@@ -1314,6 +1465,13 @@ class TestCuda(TestCase):
             return torch.cuda.DoubleTensor(*sizes).normal_()
         TestTorch._test_fft_ifft_rfft_irfft(self, build_fn=cuda_randn_double)
 
+    def test_fft_plan_reuse(self):
+        def cuda_randn_double(*sizes):
+            return torch.cuda.DoubleTensor(*sizes).normal_()
+        TestTorch._test_fft_plan_reuse(self, build_fn=cuda_randn_double)
+        with torch.cuda.stream(torch.cuda.Stream()):
+            TestTorch._test_fft_plan_reuse(self, build_fn=cuda_randn_double)
+
     def test_stft(self):
         def cuda_randn_double(*sizes):
             return torch.cuda.DoubleTensor(*sizes).normal_()
@@ -1403,6 +1561,75 @@ class TestCuda(TestCase):
     def test_dim_reduction(self):
         TestTorch._test_dim_reduction(self, lambda t: t.cuda())
 
+    def test_dim_reduction_many_short_rows(self):
+        # rows short and numerous enough to be reduced by a warp each, in
+        # every dtype, including ones without a native shuffle
+        for size in [(20000, 1), (20000, 33), (5000, 64), (1000, 512), (1000, 513)]:
+            x = torch.randn(*size).mul_(4).abs_()
+            for t in ['DoubleTensor', 'FloatTensor', 'LongTensor', 'ByteTensor']:
+                cpu = x.type('torch.' + t)
+                gpu = cpu.cuda()
+                self.assertEqual(gpu.sum(1).cpu(), cpu.sum(1), prec=1e-3)
+                self.assertEqual(gpu[:, 1:].sum(1).cpu(), cpu[:, 1:].sum(1), prec=1e-3)
+            y = x.cuda()
+            z = x.div(64).add_(1)
+            self.assertEqual(z.cuda().prod(1).cpu(), z.prod(1), prec=1e-3)
+            self.assertEqual(y.norm(2, 1).cpu(), x.norm(2, 1), prec=1e-3)
+            h = y.half()
+            self.assertEqual(h.sum(1).float(), h.float().sum(1), prec=1e-2 * size[1])
+
+    def test_sort_topk_large_slices(self):
+        # slices longer than the in-place bitonic sort takes, and topk over
+        # rows like a 50k vocabulary
+        for t in ['FloatTensor', 'DoubleTensor', 'LongTensor', 'ByteTensor']:
+            rows = torch.randn(6, 5000).mul_(100).abs_().type('torch.' + t)
+            for dim, descending in product([0, 1], [False, True]):
+                x = rows.t().contiguous() if dim == 0 else rows
+                sorted_cpu, _ = x.sort(dim, descending)
+                y = x.cuda()
+                sorted_gpu, indices = y.sort(dim, descending)
+                self.assertEqual(sorted_gpu.cpu(), sorted_cpu)
+                # the indices point at the sorted values
+                self.assertEqual(y.gather(dim, indices), sorted_gpu)
+
+        x = torch.randn(8, 50000)
+        xc = x.cuda()
+        for k in [1, 5, 100, 3000]:
+            for largest in [True, False]:
+                values, indices = xc.topk(k, 1, largest, True)
+                expected, _ = x.topk(k, 1, largest, True)
+                self.assertEqual(values.cpu(), expected)
+                self.assertEqual(xc.gather(1, indices), values)
+        # many equal values
+        x = torch.randn(4, 10000).mul_(3).round_()
+        values, indices = x.cuda().topk(2000, 1)
+        self.assertEqual(values.cpu(), x.topk(2000, 1)[0])
+
+    def test_pointwise_vectorized(self):
+        # contiguous tensors take the vectorized apply kernels when their
+        # data is aligned; check odd sizes, unaligned views and mixed types
+        for n in [1, 7, 8, 1021, 65536 + 3]:
+            for offset in [0, 1, 2]:
+                x = torch.randn(n + offset)
+                y = torch.randn(n + offset)
+                z = torch.randn(n + offset)
+                xc, yc, zc = x.cuda()[offset:], y.cuda()[offset:], z.cuda()[offset:]
+                x, y, z = x[offset:], y[offset:], z[offset:]
+                self.assertEqual((xc + yc).cpu(), x + y)
+                self.assertEqual(xc.clone().mul_(3).cpu(), x.clone().mul_(3))
+                self.assertEqual(torch.addcmul(xc, 2, yc, zc).cpu(), torch.addcmul(x, 2, y, z))
+                self.assertEqual(xc.half().float().cpu(), x.half().float(), prec=1e-2)
+                self.assertEqual((xc.half() + yc.half()).float().cpu(), (x + y), prec=1e-2)
+                self.assertEqual(xc.double().cpu(), x.double())
+                self.assertEqual(xc.gt(yc).cpu(), x.gt(y))
+                # in place with the same tensor as input
+                self.assertEqual(xc.clone().add_(xc).cpu(), x.clone().add_(x))
+
+        # cross reads the neighbours of its elements
+        x = torch.randn(3, 16)
+        y = torch.randn(3, 16)
+        self.assertEqual(torch.cross(x.cuda(), y.cuda(), 0).cpu(), torch.cross(x, y, 0))
+
     def test_tensor_gather(self):
         TestTorch._test_gather(self, lambda t: t.cuda(), False)
 
@@ -1412,6 +1639,66 @@ class TestCuda(TestCase):
     def test_tensor_scatterAdd(self):
         TestTorch._test_scatter_base(self, lambda t: t.cuda(), 'scatter_add_', test_bounds=False)
 
+    def test_index_add_scatter_add_repeated_indices(self):
+        # Enough duplicates to take the sorted path without forcing it
+        def check():
+            for t in ['torch.FloatTensor', 'torch.DoubleTensor']:
+                src = torch.randn(1000, 7).type(t)
+                idx = torch.LongTensor(1000).random_(0, 10)
+                dst = torch.randn(10, 7).type(t)
+                res = dst.cuda().index_add_(0, idx.cuda(), src.cuda())
+                self.assertEqual(res.cpu(), dst.clone().index_add_(0, idx, src))
+
+                src = torch.randn(7, 1000).type(t)
+                idx = torch.LongTensor(7, 1000).random_(0, 10)
+                dst = torch.randn(7, 10).type(t)
+                res = dst.cuda().scatter_add_(1, idx.cuda(), src.cuda())
+                self.assertEqual(res.cpu(), dst.clone().scatter_add_(1, idx, src))
+
+        self.assertFalse(torch.cuda.deterministic_accumulation())
+        check()
+        # A few indices and no duplicates, forced through the sorted path
+        torch.cuda.set_deterministic_accumulation(True)
+        try:
+            self.assertTrue(torch.cuda.deterministic_accumulation())
+            check()
+            src = torch.randn(4, 100).cuda()
+            idx = torch.cuda.LongTensor([3, 0, 2])
+            dst = torch.zeros(4, 5).cuda()
+            res = dst.index_add_(1, idx, src[:, :3])
+            self.assertEqual(res[:, 1], torch.zeros(4).cuda())
+            self.assertEqual(res[:, 3], src[:, 0])
+
+            src = torch.randn(100000).cuda()
+            idx = torch.cuda.LongTensor(100000).random_(0, 3)
+            first = torch.zeros(3).cuda().index_add_(0, idx, src)
+            for _ in range(3):
+                again = torch.zeros(3).cuda().index_add_(0, idx, src)
+                self.assertEqual((again - first).abs().max(), 0, prec=0)
+        finally:
+            torch.cuda.set_deterministic_accumulation(False)
+
+    def test_tensor_op_float_math(self):
+        a = torch.randn(64, 128).cuda()
+        b = torch.randn(128, 32).cuda()
+        batch1 = torch.randn(4, 64, 128).cuda()
+        batch2 = torch.randn(4, 128, 32).cuda()
+        x = torch.randn(2, 8, 16, 16).cuda()
+        w = torch.randn(16, 8, 3, 3).cuda()
+        expected = (a.mm(b), batch1.bmm(batch2), torch.nn.functional.conv2d(x, w, padding=1))
+
+        self.assertFalse(torch.cuda.tensor_op_float_math())
+        torch.cuda.set_tensor_op_float_math(True)
+        try:
+            self.assertTrue(torch.cuda.tensor_op_float_math())
+            # the inputs may be rounded to half: compare with half precision
+            results = (a.mm(b), batch1.bmm(batch2), torch.nn.functional.conv2d(x, w, padding=1))
+            for result, ref in zip(results, expected):
+                self.assertEqual(result, ref, prec=ref.abs().max() * 1e-2)
+        finally:
+            torch.cuda.set_tensor_op_float_math(False)
+        self.assertEqual(a.mm(b), expected[0])
+
     def test_tensor_scatterFill(self):
         TestTorch._test_scatter_base(self, lambda t: t.cuda(), 'scatter_', True, test_bounds=False)
 
@@ -525,6 +525,15 @@ class TestDataLoader(TestCase):
             batch = next(iter(loader))
             self.assertIsInstance(batch, tt)
 
+    def test_default_collate_tensors(self):
+        # large enough to be copied on several threads
+        batch = [torch.randn(3, 256, 256) for _ in range(8)]
+        batch.append(torch.randn(256, 256, 3).permute(2, 0, 1))
+        self.assertEqual(default_collate(batch), torch.stack(batch, 0))
+
+        # samples of different sizes aren't collated natively
+        self.assertRaises(RuntimeError, lambda: default_collate([torch.randn(2), torch.randn(3)]))
+
     @unittest.skipIf(not TEST_NUMPY, "numpy unavailable")
     def test_default_colate_bad_numpy_types(self):
         import numpy as np
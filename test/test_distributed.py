@@ -24,7 +24,8 @@ MASTER_PORT = '29500'
 MASTER_ADDR = '127.0.0.1'
 
 DEFAULT_TIMEOUT = 15
-CUSTOMIZED_TIMEOUT = {'test_DistributedDataParallel': 25}
+CUSTOMIZED_TIMEOUT = {'test_DistributedDataParallel': 25,
+                      'test_DistributedDataParallel_single_device': 25}
 
 
 def get_timeout(test_id):
@@ -461,6 +462,77 @@ class _DistTestBase(object):
             group, group_id, rank, dist.reduce_op.SUM, 2, 10, 2 + (10 * (len(group) - 1)), True
         )
 
+    # COMPRESSED ALL REDUCE
+    @unittest.skipIf(BACKEND == 'nccl', "Nccl does not support CPU tensors")
+    def test_all_reduce_compressed_topk(self):
+        group, group_id, rank = self._init_global_test()
+        n = len(group)
+        tensor = torch.FloatTensor([10] * 5 + [1] * 5)
+        residual = torch.zeros(10)
+        dist.all_reduce_compressed(tensor, dist.compression.TOPK, residual, 0.5, group_id)
+        self.assertEqual(tensor, torch.FloatTensor([10 * n] * 5 + [0] * 5))
+        self.assertEqual(residual, torch.FloatTensor([0] * 5 + [1] * 5))
+
+        # the elements left out are sent in the next call
+        tensor.zero_()
+        dist.all_reduce_compressed(tensor, dist.compression.TOPK, residual, 0.5, group_id)
+        self.assertEqual(tensor, torch.FloatTensor([0] * 5 + [n] * 5))
+        self.assertEqual(residual, torch.zeros(10))
+        self._barrier()
+
+    @unittest.skipIf(BACKEND == 'nccl', "Nccl does not support CPU tensors")
+    def test_all_reduce_compressed_sign(self):
+        group, group_id, rank = self._init_global_test()
+        n = len(group)
+        # 19 elements: the packed bits don't fill the last byte
+        expected = torch.FloatTensor([2, -2] * 9 + [-2])
+        tensor = expected.clone()
+        residual = torch.zeros(19)
+        dist.all_reduce_compressed(tensor, dist.compression.SIGN, residual, group=group_id)
+        self.assertEqual(tensor, expected * n)
+        self.assertEqual(residual, torch.zeros(19))
+
+        tensor = torch.FloatTensor([3, -1])
+        residual = torch.zeros(2)
+        dist.all_reduce_compressed(tensor, dist.compression.SIGN, residual, group=group_id)
+        self.assertEqual(tensor, torch.FloatTensor([2 * n, -2 * n]))
+        self.assertEqual(residual, torch.FloatTensor([1, 1]))
+        self._barrier()
+
+    # SPARSE ALL REDUCE
+    @unittest.skipIf(BACKEND == 'nccl', "Nccl does not support CPU tensors")
+    def test_all_reduce_sparse(self):
+        group, group_id, rank = self._init_global_test()
+        rows = len(group) + 1
+        # every process has row 0 and its own row, rank 0 only row 0
+        indices = torch.LongTensor([[0] + list(range(1, rank + 1))[-1:]])
+        values = torch.ones(indices.size(1), 3) * (rank + 1)
+        tensor = torch.sparse.FloatTensor(indices, values, torch.Size([rows, 3]))
+        expected = torch.zeros(rows, 3)
+        for r in group:
+            expected[0] += r + 1
+            if r > 0:
+                expected[r] += r + 1
+
+        result = dist.all_reduce_sparse(tensor, group=group_id)
+        self.assertTrue(result.is_sparse)
+        self.assertEqual(result._nnz(), rows - 1)
+        self.assertEqual(result.to_dense(), expected)
+
+        result = dist.all_reduce_sparse(tensor, 0.5, group_id)
+        self.assertFalse(result.is_sparse)
+        self.assertEqual(result, expected)
+        self._barrier()
+
+    @unittest.skipIf(BACKEND != 'gloo', "Only Gloo backend supports CPU half allReduce")
+    def test_all_reduce_compressed_fp16(self):
+        group, group_id, rank = self._init_global_test()
+        tensor = _build_tensor(10, rank + 1)
+        residual = torch.zeros(tensor.size())
+        dist.all_reduce_compressed(tensor, dist.compression.FP16, residual, group=group_id)
+        self.assertEqual(tensor, _build_tensor(10, sum(r + 1 for r in group)))
+        self._barrier()
+
     @unittest.skipIf(BACKEND == 'nccl', "Nccl does not support CPU tensors")
     def test_all_reduce_product(self):
         group, group_id, rank = self._init_global_test()
@@ -702,6 +774,18 @@ class _DistTestBase(object):
             group, group_id, rank, rankToGPUMapping, dist.reduce_op.SUM,
             2, 10, (2 + 10 * (len(group) - 1)) * len(rankToGPUMapping[0]))
 
+    @unittest.skipIf(BACKEND != 'nccl',
+                     "Only Nccl backend supports allreduce multigpu")
+    @skip_if_no_multigpu
+    def test_all_reduce_multigpu_hierarchical(self):
+        group, _, rank = self._init_global_test()
+        group_id = dist.new_group(group, hierarchical=True)
+        rankToGPUMapping = self._init_multigpu_helper()
+        # the tensor sizes cover chunks that do and don't divide evenly
+        self._test_all_reduce_multigpu_helper(
+            group, group_id, rank, rankToGPUMapping, dist.reduce_op.SUM,
+            2, 10, (2 + 10 * (len(group) - 1)) * len(rankToGPUMapping[0]))
+
     def _test_reduce_multigpu_helper(self, group, group_id, rank,
                                      rankToGPUMapping, op, master_value,
                                      worker_value, expected_value):
@@ -759,6 +843,29 @@ class _DistTestBase(object):
         self._test_all_gather_multigpu_helper(group, group_id, rank,
                                               rankToGPUMapping)
 
+    # GRADIENT REDUCER
+    @unittest.skipIf(BACKEND == 'nccl', "Nccl does not support CPU tensors")
+    def test_reducer(self):
+        group, group_id, rank = self._init_global_test()
+        world_size = len(group)
+        # a small cap, so that the parameters are spread over several buckets
+        params = [torch.ones(3, requires_grad=True) for _ in range(4)]
+        unused = torch.ones(2, requires_grad=True)
+        reducer = torch._C._dist_new_reducer(params + [unused], 12, group_id)
+
+        for _ in range(2):
+            loss = sum(((i + 1) * (rank + 1) * p).sum() for i, p in enumerate(params))
+            loss.backward()
+            # gradients are averaged over the processes by the end of backward
+            expected_mean = (world_size + 1) / 2.0
+            for i, p in enumerate(params):
+                self.assertEqual(p.grad.data, torch.Tensor(3).fill_((i + 1) * expected_mean))
+            self.assertEqual(unused.grad.data, torch.zeros(2))
+            for p in params:
+                p.grad = None
+
+        self._barrier()
+
     # END TO END TEST FOR DISTRIBUTEDDATAPARALLEL
     def _test_DDP_helper(self, model, input_var, target, loss):
         model.train()
@@ -771,10 +878,22 @@ class _DistTestBase(object):
     @skip_if_no_cuda_distributed
     @skip_if_no_multigpu
     def test_DistributedDataParallel(self):
+        rankToGPUMapping = self._init_multigpu_helper()
+        self._test_DistributedDataParallel(list(rankToGPUMapping[dist.get_rank()]))
+
+    @unittest.skipIf(BACKEND != 'nccl' and BACKEND != 'gloo',
+                     "Only Nccl & Gloo backend support DistributedDataParallel")
+    @skip_if_no_cuda_distributed
+    @skip_if_no_multigpu
+    def test_DistributedDataParallel_single_device(self):
+        # one device per process goes through the C++ gradient reducer
+        rankToGPUMapping = self._init_multigpu_helper()
+        self._test_DistributedDataParallel(list(rankToGPUMapping[dist.get_rank()])[:1])
+
+    def _test_DistributedDataParallel(self, gpu_subset):
         # Run a simple end to end DDP model, use result of single node model
         # as baseline
         group, group_id, rank = self._init_global_test()
-        rankToGPUMapping = self._init_multigpu_helper()
 
         class Net(nn.Module):
             def __init__(self):
@@ -805,7 +924,6 @@ class _DistTestBase(object):
 
         # single gpu training setup
         model_gpu = copy.deepcopy(model)
-        gpu_subset = list(rankToGPUMapping[rank])
         model_gpu.cuda(gpu_subset[0])
 
         # DDP training setup
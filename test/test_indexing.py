@@ -80,6 +80,33 @@ class TestIndexing(TestCase):
         result = x[rows[:, None], columns]
         self.assertEqual(result.data.tolist(), [[0, 2], [9, 11]])
 
+    def test_int_indices_strided(self):
+        x = torch.arange(0, 2 * 5 * 4 * 3).view(2, 5, 4, 3)
+        rows = torch.LongTensor([[0, 1], [1, 0], [-1, 0]])
+        cols = torch.LongTensor([2, -1])
+        for src in [x, x.transpose(1, 3), x[:, ::2], x.permute(3, 2, 1, 0)]:
+            a = src.numpy()
+            r, c = rows.numpy(), cols.numpy()
+            self.assertEqual(src[rows, :, cols], torch.from_numpy(a[r, :, c]))
+            self.assertEqual(src[:, rows, cols], torch.from_numpy(a[:, r, c]))
+            self.assertEqual(src[rows], torch.from_numpy(a[r]))
+            self.assertEqual(src[rows[:, :1], cols], torch.from_numpy(a[r[:, :1], c]))
+
+    def test_int_indices_grad(self):
+        x = Variable(torch.randn(4, 5, 3), requires_grad=True)
+        rows = Variable(torch.LongTensor([0, 3, 0]))
+        cols = Variable(torch.LongTensor([1, 1, 2]))
+        x[rows, :, cols].sum().backward()
+        expected = torch.zeros(4, 5, 3)
+        for r, c in zip(rows.data.tolist(), cols.data.tolist()):
+            expected[r, :, c] += 1
+        self.assertEqual(x.grad.data, expected)
+
+    def test_int_indices_out_of_bounds(self):
+        x = torch.randn(4, 5)
+        self.assertRaises(RuntimeError, lambda: x[torch.LongTensor([4])])
+        self.assertRaises(RuntimeError, lambda: x[:, torch.LongTensor([-6])])
+
     def test_empty_index(self):
         x = Variable(torch.arange(0, 12).view(4, 3))
         idx = Variable(torch.LongTensor())
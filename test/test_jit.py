@@ -9,6 +9,7 @@ from torch.autograd import Variable, Function
 from torch.autograd.function import traceable
 from common import TestCase, run_tests, IS_WINDOWS
 import io
+import os
 import sys
 import unittest
 import inspect
@@ -258,6 +259,56 @@ class TestJit(TestCase):
     def test_run_lstm_fusion_cpu(self):
         self.run_lstm_fusion(False)
 
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
+    def test_fusion_disk_cache(self):
+        import os
+        import shutil
+        import subprocess
+        import tempfile
+        script = """if True:
+            import torch
+
+            def f(x, y):
+                return (x * y).sigmoid() + x.tanh() * y
+
+            torch.manual_seed(0)
+            x = torch.randn(4, 4).cuda()
+            y = torch.randn(4, 4).cuda()
+            compiled = torch.jit.compile(nderivs=0)(f)
+            print(compiled(x, y).sum().item())
+        """
+        cache_dir = tempfile.mkdtemp()
+        try:
+            env = dict(os.environ, PYTORCH_FUSION_CACHE_DIR=cache_dir)
+            out1 = subprocess.check_output([sys.executable, '-c', script], env=env)
+            entries = os.listdir(cache_dir)
+            self.assertTrue(len(entries) > 0)
+            self.assertTrue(all(e.endswith('.ptx') for e in entries))
+            # the second run loads the kernels from the cache
+            out2 = subprocess.check_output([sys.executable, '-c', script], env=env)
+            self.assertEqual(sorted(os.listdir(cache_dir)), sorted(entries))
+            self.assertEqual(out1, out2)
+        finally:
+            shutil.rmtree(cache_dir)
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fusion_cpu_ops(self):
+        # these ops are lowered to functions the CPU code has to define itself
+        def f(x, y):
+            a = x.abs().rsqrt() + x.frac() * y.reciprocal()
+            b = (a * y).clamp(-0.5, 0.5).sigmoid()
+            return a * b + (x * y).tanh()
+
+        x = Variable(torch.rand(4, 6).float() + 0.5)
+        y = Variable(torch.rand(4, 6).float() + 0.5)
+        compiled = torch.jit.compile(nderivs=0)(f)
+        z = compiled(x, y)
+        with self.assertCompiled(compiled):
+            z2 = compiled(x, y)
+        self.assertEqual(z, f(x, y))
+        self.assertEqual(z, z2)
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_run_lstm_fusion_concat(self):
@@ -377,6 +428,32 @@ class TestJit(TestCase):
         self.assertEqual(z, torch.sigmoid(torch.tanh(x * (x + y))))
         self.assertEqual(z, z2)
 
+    def test_compile_shape_class(self):
+        calls = []
+
+        @torch.jit.compile(nderivs=0, optimize=False)
+        def doit(x, y):
+            calls.append(x.size())
+            return torch.sigmoid(x * y + y)
+
+        @torch.jit.compile(nderivs=0, optimize=False)
+        def flat(x):
+            calls.append(x.size())
+            return x.view(x.size(0) * x.size(1)) * 2
+
+        for a, b in [(2, 3), (4, 5)]:
+            doit(torch.randn(a, b), torch.randn(a, b))
+            flat(torch.randn(a, b))
+        self.assertEqual(len(calls), 4)
+        # a trace of the same shape class that doesn't depend on the sizes
+        x, y = torch.randn(6, 7), torch.randn(6, 7)
+        with self.assertCompiled(doit):
+            self.assertEqual(doit(x, y), torch.sigmoid(x * y + y))
+        self.assertEqual(len(calls), 4)
+        # the view size is baked into the trace
+        self.assertEqual(flat(x), x.view(42) * 2)
+        self.assertEqual(len(calls), 5)
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_compile_addc(self):
@@ -424,6 +501,27 @@ class TestJit(TestCase):
         self.assertEqual(z, torch.sigmoid(torch.tanh(x * (x + y))))
         self.assertEqual(z, z2)
 
+    def test_inter_op_parallel_branches(self):
+        def two_towers(x, y):
+            a = torch.tanh(x.mm(y)).mm(y)
+            b = torch.sigmoid(x.mm(y.t())).mm(y)
+            return a * b + a, b.sum()
+
+        x = Variable(torch.randn(8, 8), requires_grad=True)
+        y = Variable(torch.randn(8, 8), requires_grad=True)
+        ge = torch._C.GraphExecutor(two_towers, (x, y))
+        expected = two_towers(x, y)
+        expected_grads = torch.autograd.grad(expected[0].sum() + expected[1], (x, y))
+        try:
+            torch._C._jit_set_inter_op_threads(4)
+            for _ in range(3):
+                outputs = ge(x, y)
+                self.assertEqual(outputs, expected)
+                grads = torch.autograd.grad(outputs[0].sum() + outputs[1], (x, y))
+                self.assertEqual(grads, expected_grads)
+        finally:
+            torch._C._jit_set_inter_op_threads(1)
+
     def test_disabled_traced_function(self):
         x = Variable(torch.Tensor([0.4]), requires_grad=True)
         y = Variable(torch.Tensor([0.7]), requires_grad=True)
@@ -1187,6 +1285,39 @@ class TestJit(TestCase):
         self.assertEqual(len(list(trace.graph().inputs())), 2)
         self.assertExpected(str(trace))
 
+    def test_constant_propagation_frozen_params(self):
+        linear = nn.Linear(4, 3)
+        x = Variable(torch.randn(2, 4))
+        trace, _ = torch.jit.get_trace_graph(linear, (x,))
+        torch._C._jit_pass_freeze_inputs(trace, 1, tuple(linear.parameters()))
+        torch._C._jit_pass_constant_propagation(trace)
+        torch._C._jit_pass_lint(trace)
+        graph = trace.graph()
+        self.assertEqual(len(list(graph.inputs())), 1)
+        self.assertNotIn('aten::t', [n.kind() for n in graph.nodes()])
+
+        ge = torch._C.GraphExecutor(graph)
+        with torch.no_grad():
+            self.assertEqual(ge(x), linear(x))
+
+    def test_fold_conv_batch_norm(self):
+        model = nn.Sequential(nn.Conv2d(3, 4, 3), nn.BatchNorm2d(4), nn.ReLU())
+        model[1].running_mean.uniform_()
+        model[1].running_var.uniform_(0.5, 2)
+        model.eval()
+        x = Variable(torch.randn(2, 3, 8, 8))
+        trace, _ = torch.jit.get_trace_graph(model, (x,))
+        state = tuple(torch.jit._unique_state_dict(model, keep_vars=True).values())
+        torch._C._jit_pass_freeze_inputs(trace, 1, state)
+        torch._C._jit_pass_fold_conv_batch_norm(trace)
+        torch._C._jit_pass_lint(trace)
+        graph = trace.graph()
+        self.assertNotIn('aten::batch_norm', [n.kind() for n in graph.nodes()])
+
+        ge = torch._C.GraphExecutor(graph)
+        with torch.no_grad():
+            self.assertEqual(ge(x), model(x))
+
     def test_nested_inplace(self):
         x = Variable(torch.randn(2, 2))
         trace, _ = torch.jit.get_trace_graph(lambda x: F.threshold(x, 0, 0, inplace=True), (x,), nderivs=0)
@@ -1275,6 +1406,15 @@ class TestJit(TestCase):
                                 (a - 2 * b) + b, [rand(1), rand(1)],
                                 optimize=optimize)
 
+        # independent mms that get batched: shared lhs, shared rhs, same sizes
+        def mms(x, w1, w2, w3, y):
+            return x.mm(w1) * x.mm(w2), x.mm(w3), w1.t().mm(y) * w2.t().mm(y)
+        self.checkGraphExecutor(mms, [rand(4, 3), rand(3, 5), rand(3, 5), rand(3, 2), rand(3, 4)],
+                                optimize=optimize)
+        self.checkGraphExecutor(lambda a, b, c, d: a.mm(b) * c.mm(d),
+                                [rand(4, 3), rand(3, 2), rand(4, 3), rand(3, 2)],
+                                optimize=optimize)
+
     def test_ge_unoptimized(self):
         self.run_ge_tests(False, False)
 
@@ -1310,6 +1450,29 @@ class TestJit(TestCase):
         g2result2 = torch.autograd.grad(l3, [da2, db2])
         self.assertEqual(g2result, g2result2)
 
+    def test_ge_batching(self):
+        import threading
+
+        def foo(x, w):
+            return (x.mm(w) + x.sum(1, keepdim=True)).sigmoid()
+
+        w = Variable(torch.rand(3, 4))
+        ge = torch._C.GraphExecutor(foo, (Variable(torch.rand(1, 3)), w))
+        ge.set_batching(max_batch_size=4, timeout_us=100000)
+        inputs = [Variable(torch.rand(1 + i % 2, 3)) for i in range(8)]
+        outputs = [None] * len(inputs)
+
+        def run(i):
+            outputs[i] = ge(inputs[i], w)
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(len(inputs))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for x, out in zip(inputs, outputs):
+            self.assertEqual(out, foo(x, w))
+
     def test_trace_annotation(self):
         @torch.jit.trace(Variable(torch.rand(1)))
         def foo(a):
@@ -1423,6 +1586,20 @@ class TestJit(TestCase):
         torch._C._jit_pass_shape_analysis(graph, (x, y), False)
         self.assertExpected(str(graph))
 
+    def test_shape_polymorphic_plans(self):
+        def fn(x, y, b):
+            return (x * y + b).tanh() * x
+
+        ge = torch.jit.script(fn)
+        # the graphs optimized for the first shapes are reused for the ones
+        # with the same symbolic signature, except when they bake in sizes,
+        # like the expand of the broadcasted b
+        for batch in [2, 3, 4, 2, 8]:
+            x = torch.randn(batch, 5)
+            y = torch.randn(batch, 5)
+            for b in [torch.randn(batch, 5), torch.randn(5)]:
+                self.assertEqual(ge(x, y, b), fn(x, y, b))
+
     def test_fuser_multiple_blocks(self):
         cu = torch.jit.CompilationUnit('''
         def test_fuser_multiple_blocks(this, that, theother, meme):
@@ -1766,6 +1943,134 @@ class TestScript(TestCase):
 
         self.assertEqual(test_script_for_in_range_ast(*inputs), 161700)
 
+    def test_loop_unrolling(self):
+        def fn(x):
+            y = x
+            for _ in range(20):
+                y = (y + x).sigmoid()
+            return y
+
+        x = torch.randn(3, 4)
+        graph = torch.jit._script_graph(fn)
+        torch._C._jit_pass_loop_unrolling(graph)
+        torch._C._jit_pass_lint(graph)
+        # 4 iterations are peeled off, the other 16 run in 2 iterations
+        self.assertEqual([n.kind() for n in graph.nodes()].count('prim::Loop'), 1)
+        self.assertEqual([n.kind() for n in graph.nodes()].count('aten::sigmoid'), 4)
+
+        ge = torch._C.GraphExecutor(graph, False)
+        self.assertEqual(ge(x), fn(x))
+
+    def test_loop_unrolling_counter(self):
+        def fn(zero):
+            c = zero
+            for i in range(20):
+                acc = zero
+                for j in range(i):
+                    acc += j
+                c += acc
+            for i in range(5):
+                c += i
+            return c
+
+        graph = torch.jit._script_graph(fn)
+        torch._C._jit_pass_loop_unrolling(graph)
+        torch._C._jit_pass_lint(graph)
+        # the first loop and the 4 copies of the inner loop peeled off it,
+        # the second loop is fully unrolled
+        self.assertEqual([n.kind() for n in graph.nodes()].count('prim::Loop'), 5)
+
+        ge = torch._C.GraphExecutor(graph, False)
+        inputs = self._make_scalar_vars([0], torch.int64)
+        self.assertEqual(ge(*inputs), 1150)
+
+    def test_licm(self):
+        def fn(x, w):
+            y = x
+            for _ in range(10):
+                y = (y.mm(w.t()) + x).sigmoid()
+            return y
+
+        x = torch.randn(3, 4)
+        w = torch.randn(4, 4)
+        graph = torch.jit._script_graph(fn)
+        torch._C._jit_pass_licm(graph)
+        torch._C._jit_pass_lint(graph)
+        self.assertIn('aten::t', [n.kind() for n in graph.nodes()])
+
+        ge = torch._C.GraphExecutor(graph, False)
+        self.assertEqual(ge(x, w), fn(x, w))
+
+    @unittest.skipIf(IS_WINDOWS, "tensor archives aren't supported on Windows")
+    def test_save_load_graph(self):
+        def fn(x, w):
+            y = x
+            for _ in range(3):
+                y = (y.mm(w) + 2).sigmoid()
+            return y
+
+        x = torch.randn(3, 4)
+        w = torch.randn(4, 4)
+        graph = torch.jit._script_graph(fn)
+        d = tempfile.mkdtemp()
+        try:
+            path = os.path.join(d, 'graph.pt')
+            torch._C._jit_save_graph(path, graph, (w,))
+            loaded, initializers = torch._C._jit_load_graph(path)
+            torch._C._jit_pass_lint(loaded)
+            self.assertEqual([n.kind() for n in loaded.nodes()], [n.kind() for n in graph.nodes()])
+            self.assertEqual(initializers, [w])
+
+            # loading is deterministic
+            torch._C._jit_save_graph(path, loaded, initializers)
+            self.assertEqual(str(torch._C._jit_load_graph(path)[0]), str(loaded))
+
+            ge = torch._C.GraphExecutor(loaded, False)
+            self.assertEqual(ge(x, *initializers), fn(x, w))
+        finally:
+            shutil.rmtree(d)
+
+    @unittest.skipIf(IS_WINDOWS, "tensor archives aren't supported on Windows")
+    def test_trace_cache(self):
+        calls = []
+
+        def make_fn():
+            def fn(x, w):
+                calls.append(x.size())
+                return (x.mm(w) + 2).sigmoid()
+            return fn
+
+        def trace(m, k):
+            x, w = torch.randn(m, k), torch.randn(k, k)
+            ge = torch.jit.trace(x, w, cache=d)(make_fn())
+            self.assertEqual(ge(x, w), (x.mm(w) + 2).sigmoid())
+
+        d = tempfile.mkdtemp()
+        try:
+            torch._C._jit_clear_trace_cache()
+            trace(3, 4)
+            trace(5, 6)
+            self.assertEqual(len(calls), 2)
+            # the same sizes, or the same shape class
+            trace(3, 4)
+            trace(7, 8)
+            self.assertEqual(len(calls), 2)
+            # what another process would see
+            torch._C._jit_clear_trace_cache()
+            trace(9, 10)
+            self.assertEqual(len(calls), 2)
+            # other code
+            def other(x, w):
+                calls.append(x.size())
+                return (x.mm(w) + 3).sigmoid() - 1
+            torch.jit.trace(torch.randn(3, 4), torch.randn(4, 4), cache=d)(other)
+            self.assertEqual(len(calls), 3)
+            # the graphs of the first two traces, of their shape class and of other
+            self.assertEqual(len(os.listdir(d)), 4)
+        finally:
+            torch._C._jit_clear_trace_cache()
+            shutil.rmtree(d)
+
     def test_script_bool_constant(self):
         script = '''
         def test_script_bool_constant():
@@ -2035,6 +2340,51 @@ class TestScript(TestCase):
         o = m(input)
         self.assertEqual(o, input + torch.ones(2, 2) + 2)
 
+    @unittest.skipIf(IS_WINDOWS, "tensor archives aren't supported on Windows")
+    def test_script_module_save_load(self):
+        class Sub(torch.jit.ScriptModule):
+            def __init__(self):
+                super(Sub, self).__init__(False)
+                self.weight = nn.Parameter(torch.randn(2))
+                self.register_buffer('scale', torch.randn(2))
+
+            @torch.jit.script_method
+            def forward(self, thing):
+                return self.weight * self.scale + thing
+
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__(False)
+                self.sub = Sub()
+                self.weight = nn.Parameter(torch.randn(2, 3))
+
+            @torch.jit.script_method
+            def doit(self, input):
+                return self.weight.mm(input)
+
+            @torch.jit.script_method
+            def forward(self, input):
+                return self.sub(self.doit(input))
+
+        m = M()
+        input = torch.randn(3, 2)
+        d = tempfile.mkdtemp()
+        try:
+            path = os.path.join(d, 'module.pt')
+            torch.jit.save(m, path)
+            loaded = torch.jit.load(path)
+        finally:
+            shutil.rmtree(d)
+        self.assertEqual(loaded(input), m(input))
+        self.assertEqual(loaded.doit(input), m.doit(input))
+        self.assertEqual(loaded.sub(input[0]), m.sub(input[0]))
+        self.assertEqual([name for name, _ in loaded.named_parameters()],
+                         [name for name, _ in m.named_parameters()])
+        self.assertEqual(list(loaded.parameters()), list(m.parameters()))
+        self.assertEqual(loaded.sub.scale, m.sub.scale)
+        self.assertTrue(loaded.weight.requires_grad)
+        self.assertFalse(loaded.sub.scale.requires_grad)
+
     def test_script_module_nochange_submodule(self):
         class M(torch.jit.ScriptModule):
             def __init__(self):
@@ -65,6 +65,15 @@ def sum_tensors(inq, outq):
                       tensor.numel(), tensor.storage().size()))
 
 
+def sum_tensor_batches(inq, outq):
+    while True:
+        batch = inq.get()
+        if batch is None:
+            break
+        outq.put([tensor.sum().item() for tensor in batch])
+        del batch
+
+
 def queue_get_exception(inqueue, outqueue):
     os.close(2)  # hide expected error message
     try:
@@ -293,6 +302,23 @@ class TestMultiprocessing(TestCase):
             for _ in range(TEST_REPEATS):
                 queue_put()
 
+    @unittest.skipIf(not HAS_SHM_FILES, "don't not how to check if shm files exist")
+    def test_fs_shm_pool(self):
+        with fs_sharing(), leak_checker(self) as lc:
+            torch._C._set_shm_pool_size(1 << 20)
+            try:
+                x = torch.FloatStorage._new_using_filename(100)
+                handle = x._share_filename_()[1]
+                y = torch.FloatStorage._new_using_filename(100)
+                self.assertNotEqual(y._share_filename_()[1], handle)
+                del x
+                # the segment is free, so it's reused
+                x = torch.FloatStorage._new_using_filename(90)
+                self.assertEqual(x._share_filename_()[1], handle)
+                del x, y
+            finally:
+                torch._C._set_shm_pool_size(0)
+
     def test_inherit_tensor(self):
         t = torch.zeros(5, 5)
         p = SubProcess(t.share_memory_())
@@ -334,6 +360,24 @@ class TestMultiprocessing(TestCase):
             self.assertEqual(tensor_size, 5)
             self.assertEqual(storage_size, 5)
 
+    @unittest.skipIf(not TEST_CUDA_IPC, 'CUDA IPC not available')
+    def test_cuda_segment_reuse(self):
+        # The batches are views of the same segment, which the consumer keeps
+        # open after freeing the previous batch
+        ctx = mp.get_context('spawn')
+        data = torch.arange(0, 1000).cuda()
+        batches = [[data[i:i + 10], data[i + 10:i + 50]] for i in range(0, 500, 50)]
+
+        inq = ctx.Queue()
+        outq = ctx.Queue()
+        p = ctx.Process(target=sum_tensor_batches, args=(inq, outq))
+        p.start()
+        for batch in batches:
+            inq.put(batch)
+            self.assertEqual(outq.get(), [t.sum().item() for t in batch])
+        inq.put(None)
+        p.join()
+
     @unittest.skipIf(IS_WINDOWS, 'not applicable to Windows (only fails with fork)')
     @unittest.skipIf(not torch.cuda.is_available(), 'CUDA not available')
     def test_cuda_bad_call(self):
@@ -6,6 +6,9 @@ import itertools
 import contextlib
 import warnings
 import pickle
+import os
+import shutil
+import tempfile
 from copy import deepcopy
 from itertools import repeat, product
 from functools import wraps, reduce
@@ -1260,6 +1263,48 @@ class TestNN(NNTestCase):
         self.assertTrue(embedding.weight.grad.is_sparse)
         self.assertEqual(embedding.weight.grad.shape, embedding.weight.shape)
 
+    def test_embedding_sparse_backward_coalesced(self):
+        # enough indices for the radix sort, and an index frequent enough for
+        # its gradient to be reduced in several pieces
+        indices = torch.cat([torch.LongTensor(5000).random_(0, 100), torch.LongTensor(3000).fill_(7)])
+        indices = indices[torch.randperm(indices.numel())]
+        offsets = torch.arange(0, indices.numel(), 50).long()
+        for padding_idx, mode, scale_grad_by_freq in [(None, None, False), (7, None, False), (None, None, True),
+                                                      (None, 'sum', False), (None, 'mean', True)]:
+            if mode is None:
+                dense = nn.Embedding(100, 4, padding_idx=padding_idx, scale_grad_by_freq=scale_grad_by_freq).double()
+                sparse = nn.Embedding(100, 4, padding_idx=padding_idx, scale_grad_by_freq=scale_grad_by_freq,
+                                      sparse=True).double()
+                args = (indices,)
+            else:
+                dense = nn.EmbeddingBag(100, 4, mode=mode, scale_grad_by_freq=scale_grad_by_freq).double()
+                sparse = nn.EmbeddingBag(100, 4, mode=mode, scale_grad_by_freq=scale_grad_by_freq,
+                                         sparse=True).double()
+                args = (indices, offsets)
+            sparse.weight.data.copy_(dense.weight.data)
+            grad = torch.randn(dense(*args).size(), dtype=torch.double)
+            dense(*args).backward(grad)
+            sparse(*args).backward(grad)
+
+            self.assertTrue(sparse.weight.grad.is_coalesced())
+            grad_indices = sparse.weight.grad._indices()
+            self.assertEqual(grad_indices, grad_indices.unique(sorted=True).view(1, -1))
+            self.assertEqual(sparse.weight.grad.to_dense(), dense.weight.grad)
+
+            # the reference: accumulate the rows one by one
+            weight = dense.weight.detach().requires_grad_()
+            if mode is None:
+                rows = weight.index_select(0, indices)
+                output = rows if padding_idx is None else rows * (indices != padding_idx).double().unsqueeze(1)
+            else:
+                output = weight.index_select(0, indices).view(-1, 50, 4)
+                output = output.sum(1) if mode == 'sum' else output.mean(1)
+            counts = torch.zeros(100, dtype=torch.double).index_add_(0, indices, torch.ones(indices.numel(),
+                                                                                              dtype=torch.double))
+            output.backward(grad)
+            expected = weight.grad / counts.clamp(min=1).unsqueeze(1) if scale_grad_by_freq else weight.grad
+            self.assertEqual(dense.weight.grad, expected)
+
     def test_embedding_padding_idx(self):
         embedding = nn.Embedding(10, 20, padding_idx=0)
         input = Variable(torch.LongTensor([[0, 2, 4, 5], [4, 3, 0, 9]]))
@@ -1561,6 +1606,74 @@ class TestNN(NNTestCase):
         self._test_EmbeddingBag(False, 'sum', True)
         self._test_EmbeddingBag(False, 'mean', True)
 
+    def test_embedding_bag_per_sample_weights(self):
+        for mode, sparse in [('sum', False), ('sum', True), ('mean', False)]:
+            es = nn.EmbeddingBag(10, 5, mode=mode, sparse=sparse).double()
+            input = torch.LongTensor([3, 1, 1, 9, 4, 0, 7])
+            offsets = torch.LongTensor([0, 3, 3])
+            weights = torch.rand(7, dtype=torch.double, requires_grad=True)
+            output = es(input, offsets, weights)
+
+            # reference: weighted embedding followed by a sum or mean per bag
+            rows = es.weight.index_select(0, input) * weights.unsqueeze(1)
+            bags = [rows[0:3], rows[3:3], rows[3:7]]
+            reduce = torch.sum if mode == 'sum' else torch.mean
+            expected = torch.stack([reduce(b, 0) if b.size(0) > 0 else b.new_zeros(5)
+                                    for b in bags])
+            self.assertEqual(output, expected)
+
+            grad = torch.randn(3, 5, dtype=torch.double)
+            weight_grad, weights_grad = torch.autograd.grad(output, (es.weight, weights), grad)
+            expected_weight_grad, expected_weights_grad = torch.autograd.grad(
+                expected, (es.weight, weights), grad)
+            if sparse:
+                weight_grad = weight_grad.to_dense()
+            self.assertEqual(weight_grad, expected_weight_grad)
+            self.assertEqual(weights_grad, expected_weights_grad)
+
+        es = nn.EmbeddingBag(10, 5)
+        self.assertRaises(ValueError, lambda: es(torch.LongTensor([[1, 2]]), None, torch.rand(3)))
+
+    def test_embedding_bag_half(self):
+        # Half weights are summed in float and rounded once per bag
+        weight = torch.randn(10, 37).half()
+        input = torch.LongTensor([3, 1, 1, 9, 4, 0, 7])
+        offsets = torch.LongTensor([0, 3, 3])
+        weights = torch.rand(7)
+        for mode, psw in [(0, None), (1, None), (0, weights)]:
+            output = torch.embedding_bag(weight, input, offsets, False, mode, False,
+                                         psw.half() if psw is not None else None)[0]
+            expected = torch.embedding_bag(weight.float(), input, offsets, False, mode, False,
+                                           psw.half().float() if psw is not None else None)[0]
+            self.assertEqual(output.dtype, torch.float16)
+            self.assertEqual(output.float(), expected.half().float(), 0)
+
+    def test_embedding_bag_fused_rowwise(self):
+        weight = torch.randn(10, 6)
+        input = torch.LongTensor([3, 1, 1, 9, 4, 0, 7])
+        offsets = torch.LongTensor([0, 3, 3])
+        weights = torch.rand(7)
+        for bits in [8, 4]:
+            quantized = torch.fused_rowwise_quantize(weight, bits)
+            self.assertEqual(quantized.dtype, torch.uint8)
+            self.assertEqual(quantized.size(), (10, 6 * bits // 8 + 8))
+            dequantized = torch.fused_rowwise_dequantize(quantized, bits)
+            # values are rounded to one of 2 ** bits levels per row
+            step = (weight.max(1, keepdim=True)[0] - weight.min(1, keepdim=True)[0]) / (2 ** bits - 1)
+            self.assertTrue(((dequantized - weight).abs() <= step / 2 + 1e-5).all())
+
+            for mode, psw in [(0, None), (1, None), (0, weights)]:
+                output = torch.embedding_bag_fused_rowwise(quantized, input, offsets, bits, mode, psw)
+                expected = torch.embedding_bag(dequantized, input, offsets, False, mode, False, psw)[0]
+                self.assertEqual(output, expected, prec=1e-5)
+
+        self.assertRaises(RuntimeError, lambda: torch.fused_rowwise_quantize(weight, 2))
+        self.assertRaises(RuntimeError, lambda: torch.fused_rowwise_quantize(torch.randn(3, 5), 4))
+        quantized = torch.fused_rowwise_quantize(weight)
+        self.assertRaises(RuntimeError, lambda: torch.embedding_bag_fused_rowwise(quantized, input, offsets, 8, 2))
+        self.assertRaises(RuntimeError, lambda: torch.embedding_bag_fused_rowwise(
+            quantized, torch.LongTensor([10]), torch.LongTensor([0])))
+
     @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
     @repeat_test_for_types(ALL_TENSORTYPES)
     def test_embedding_bag_cuda(self, dtype=torch.FloatTensor):
@@ -1816,6 +1929,35 @@ class TestNN(NNTestCase):
         self._test_LayerNorm_general(torch.cuda.FloatTensor)
         self._test_LayerNorm_cuda_half()
 
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_LayerNorm_fused_cuda(self):
+        # rows handled by a warp, by several warps, and rows longer than a block
+        for normalized_shape in [[5], [4, 50], [2000]]:
+            ln = nn.LayerNorm(normalized_shape)
+            ln.weight.data.uniform_(0.5, 2)
+            ln.bias.data.uniform_(-1, 1)
+            ln_cuda = deepcopy(ln).cuda()
+            input = torch.randn(*([7] + normalized_shape), requires_grad=True)
+            input_cuda = input.detach().cuda().requires_grad_()
+            grad = torch.randn(*input.size())
+            output = ln(input)
+            output.backward(grad)
+            output_cuda = ln_cuda(input_cuda)
+            output_cuda.backward(grad.cuda())
+            self.assertEqual(output, output_cuda, prec=1e-4)
+            self.assertEqual(input.grad, input_cuda.grad, prec=1e-4)
+            self.assertEqual(ln.weight.grad, ln_cuda.weight.grad, prec=1e-3)
+            self.assertEqual(ln.bias.grad, ln_cuda.bias.grad, prec=1e-3)
+
+        input = torch.randn(3, 2, 5, dtype=torch.double, device='cuda', requires_grad=True)
+        weight = torch.randn(2, 5, dtype=torch.double, device='cuda', requires_grad=True)
+        bias = torch.randn(2, 5, dtype=torch.double, device='cuda', requires_grad=True)
+        fn = lambda *inputs: F.layer_norm(inputs[0], [2, 5], inputs[1], inputs[2])
+        self.assertTrue(gradcheck(fn, (input, weight, bias)))
+        self.assertTrue(gradgradcheck(fn, (input, weight, bias)))
+        fn = lambda input: F.layer_norm(input, [2, 5])
+        self.assertTrue(gradgradcheck(fn, (input,)))
+
     def _test_GroupNorm_general(self, type):
         good_shape_g = {
             (1, 2, 3, 4): 2,
@@ -2711,6 +2853,56 @@ class TestNN(NNTestCase):
             self.assertEqual(conv1.bias.grad.data, conv2.bias.grad.data, prec=0.0)
             self.assertEqual(conv1.weight.grad.data, conv2.weight.grad.data, prec=0.0)
 
+    @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
+    @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
+    def test_cudnn_benchmark_cache(self):
+        inputs = torch.randn(2, 3, 7, 7, device='cuda', requires_grad=True)
+        conv = torch.nn.Conv2d(3, 4, 3).cuda()
+        directory = tempfile.mkdtemp()
+        try:
+            path = os.path.join(directory, 'cache')
+            with cudnn.flags(enabled=True, benchmark=True):
+                out = conv(inputs)
+                out.sum().backward()
+                cudnn.save_benchmark_cache(path)
+            with open(path) as f:
+                lines = f.read().splitlines()
+            self.assertEqual(lines[0], 'cudnn_benchmark_cache 1')
+            kinds = set(line.split()[0] for line in lines[4:])
+            self.assertTrue({'fwd', 'bwd_data', 'bwd_filter'} <= kinds)
+            self.assertEqual(cudnn.load_benchmark_cache(path), len(lines) - 4)
+            # the loaded algorithms are used without benchmarking again
+            with cudnn.flags(enabled=True, benchmark=False):
+                self.assertEqual(conv(inputs), out)
+
+            with open(path, 'w') as f:
+                f.write('not a cache\n')
+            self.assertRaises(RuntimeError, lambda: cudnn.load_benchmark_cache(path))
+        finally:
+            shutil.rmtree(directory)
+
+    @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
+    @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
+    def test_cudnn_workspace_limit(self):
+        inputs = torch.randn(2, 3, 9, 9, device='cuda', requires_grad=True)
+        conv = torch.nn.Conv2d(3, 4, 3).cuda()
+        with cudnn.flags(enabled=False):
+            expected = conv(inputs)
+        self.assertIsNone(cudnn.workspace_limit())
+        try:
+            cudnn.set_workspace_limit(0)
+            self.assertEqual(cudnn.workspace_limit(), 0)
+            for benchmark in [False, True]:
+                with cudnn.flags(enabled=True, benchmark=benchmark):
+                    out = conv(inputs)
+                    out.sum().backward()
+                self.assertEqual(out, expected, prec=1e-4)
+        finally:
+            cudnn.set_workspace_limit(None)
+        self.assertIsNone(cudnn.workspace_limit())
+        self.assertRaises(RuntimeError, lambda: cudnn.set_workspace_limit(-1))
+        torch.cuda.empty_cache()
+
     def test_Conv2d_missing_argument(self):
         c = nn.Conv2d(3, 3, 3)
         self.assertRaises(TypeError, lambda: c(None))
@@ -2786,6 +2978,64 @@ class TestNN(NNTestCase):
         test(False, nn.Conv3d(1, 1, (3, 3, 3)), (1, 3, 3, 3))
         test(False, nn.Conv3d(1, 1, (3, 3, 3), padding=1), (1, 2, 2, 2))
 
+    def test_conv_channels_last(self):
+        # channels last (NHWC) inputs are NCHW tensors with permuted strides
+        m = nn.Conv2d(3, 4, 3, padding=1)
+        x = torch.randn(2, 5, 6, 3).permute(0, 3, 1, 2).requires_grad_()
+        x_nchw = x.detach().contiguous().requires_grad_()
+        out = m(x)
+        out_nchw = m(x_nchw)
+        self.assertEqual(out, out_nchw)
+        grad = torch.randn(out.size())
+        out.backward(grad)
+        out_nchw.backward(grad)
+        self.assertEqual(x.grad, x_nchw.grad)
+
+    def test_pool2d_matches_thnn(self):
+        # the native CPU kernels should give the same results as THNN, for
+        # both contiguous and channels last inputs
+        configs = [
+            dict(kernel_size=2),
+            dict(kernel_size=3, stride=2, padding=1),
+            dict(kernel_size=(3, 2), stride=(1, 2), padding=(1, 1), ceil_mode=True),
+        ]
+        x = torch.randn(2, 7, 9, 5)
+        x[0, 2, 3] = float('nan')
+        x[1, 1] = 1
+        for input in [x.permute(0, 3, 1, 2).contiguous(), x.permute(0, 3, 1, 2), x[0].permute(2, 0, 1)]:
+            for config in configs:
+                for dilation in [1, 2]:
+                    out, indices = F.max_pool2d(input, dilation=dilation, return_indices=True, **config)
+                    out_thnn, indices_thnn = torch._C._nn.max_pool2d(input, dilation=dilation, **config)
+                    self.assertEqual(out, out_thnn)
+                    self.assertEqual(indices, indices_thnn)
+                for count_include_pad in [True, False]:
+                    out = F.avg_pool2d(input, count_include_pad=count_include_pad, **config)
+                    out_thnn = torch._C._nn.avg_pool2d(input, count_include_pad=count_include_pad, **config)
+                    self.assertEqual(out, out_thnn)
+
+    def test_softmax_matches_thnn(self):
+        # the vectorized CPU kernels should match THNN along the innermost dim
+        # (contiguous rows) and the others, including vector and column tails,
+        # masked (-inf) inputs and rows with a NaN
+        for dtype in [torch.float, torch.double]:
+            for size, dim in [((5, 3), 1), ((7, 1000), -1), ((2, 300, 70), 1), ((3, 19, 5, 2), 1),
+                              ((130, 9), 0), ((4, 17), 0), ((6,), 0)]:
+                x = torch.randn(*size, dtype=dtype) * 10
+                x[torch.rand(*size) < 0.2] = float('-inf')
+                x.view(-1)[-1] = float('nan')
+                for f, f_thnn in [(F.softmax, torch._C._nn.softmax),
+                                  (F.log_softmax, torch._C._nn.log_softmax)]:
+                    for input in [x, x.transpose(0, -1)]:
+                        out, out_thnn = f(input, dim), f_thnn(input, dim)
+                        # the log-probabilities of masked inputs are -inf
+                        inf = out_thnn == float('-inf')
+                        self.assertEqual(out == float('-inf'), inf)
+                        self.assertEqual(out.masked_fill(inf, 0), out_thnn.masked_fill(inf, 0), prec=1e-4)
+        x = torch.randn(3, 4, dtype=torch.double, requires_grad=True)
+        self.assertTrue(gradcheck(lambda x: F.softmax(x, 1), (x,)))
+        self.assertTrue(gradgradcheck(lambda x: F.log_softmax(x, 0), (x,)))
+
     def test_ConvTranspose2d_output_size(self):
         m = nn.ConvTranspose2d(3, 4, 3, 3, 0, 2)
         i = Variable(torch.randn(2, 3, 6, 6))
@@ -2830,6 +3080,28 @@ class TestNN(NNTestCase):
                          torch.cat([m1.weight.grad.data, m2.weight.grad.data], 0),
                          prec=type2prec[dtype.__name__])
 
+    def test_Conv2d_batch_gradients(self):
+        # the gradients of the parameters are accumulated over the batch by
+        # several threads; they have to match those of the frames one by one
+        for dtype in [torch.FloatTensor, torch.DoubleTensor]:
+            m = nn.Conv2d(3, 4, kernel_size=3, padding=1).type(dtype)
+            i = Variable(torch.randn(16, 3, 5, 5).type(dtype), requires_grad=True)
+            grad_output = torch.randn(16, 4, 5, 5).type(dtype)
+            m(i).backward(grad_output)
+
+            m1 = nn.Conv2d(3, 4, kernel_size=3, padding=1).type(dtype)
+            m1.weight.data.copy_(m.weight.data)
+            m1.bias.data.copy_(m.bias.data)
+            grad_input = []
+            for b in range(16):
+                i1 = Variable(i.data[b:b + 1].clone(), requires_grad=True)
+                m1(i1).backward(grad_output[b:b + 1])
+                grad_input.append(i1.grad.data)
+
+            self.assertEqual(i.grad.data, torch.cat(grad_input, 0))
+            self.assertEqual(m.weight.grad.data, m1.weight.grad.data, 1e-4)
+            self.assertEqual(m.bias.grad.data, m1.bias.grad.data, 1e-4)
+
     # For https://github.com/pytorch/pytorch/pull/1273
     # Almost identical to the above `test_Conv2d_naive_groups`
     def test_Conv2d_groups_nobias(self):
@@ -2868,7 +3140,13 @@ class TestNN(NNTestCase):
     @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
     @repeat_test_for_types(ALL_TENSORTYPES)
     def test_Conv2d_depthwise_naive_groups(self, dtype=torch.FloatTensor):
-        dtype = getattr(torch.cuda, dtype.__name__)
+        self._test_Conv2d_depthwise_naive_groups(getattr(torch.cuda, dtype.__name__))
+
+    def test_Conv2d_depthwise_naive_groups_cpu(self):
+        for dtype in [torch.FloatTensor, torch.DoubleTensor]:
+            self._test_Conv2d_depthwise_naive_groups(dtype)
+
+    def _test_Conv2d_depthwise_naive_groups(self, dtype):
         for depth_multiplier in [1, 2]:
             m = nn.Conv2d(2, 2 * depth_multiplier, kernel_size=3, groups=2).type(dtype)
             i = Variable(torch.randn(2, 2, 6, 6).type(dtype) / 2, requires_grad=True)
@@ -2987,6 +3265,40 @@ class TestNN(NNTestCase):
         with self.assertRaisesRegex(ValueError, 'Expected.*batch_size'):
             F.nll_loss(x, t)
 
+    def _test_cross_entropy_fused(self, cast, dtypes):
+        for dtype, ignore_index, label_smoothing in product(dtypes, [-100, 2], [0.0, 0.1]):
+            half = dtype == 'half'
+            input = getattr(cast(torch.randn(17, 2000).mul_(3)), dtype)().requires_grad_()
+            target = cast(torch.LongTensor(17).random_(0, 5))
+            ref_input = input.detach().double().requires_grad_()
+            for size_average, reduce in [(True, True), (False, True), (True, False)]:
+                loss = F.cross_entropy(input, target, size_average=size_average, reduce=reduce,
+                                       ignore_index=ignore_index, label_smoothing=label_smoothing)
+                log_probs = F.log_softmax(ref_input, 1)
+                ref = (1 - label_smoothing) * F.nll_loss(log_probs, target, reduce=False,
+                                                         ignore_index=ignore_index)
+                ref = ref - label_smoothing * log_probs.mean(1) * target.ne(ignore_index).double()
+                if reduce:
+                    ref = ref.sum() / (target.ne(ignore_index).sum().item() if size_average else 1)
+                self.assertEqual(loss.double(), ref, 5e-2 if half else 1e-4)
+
+                grad = torch.randn(loss.size()).type_as(ref)
+                grad_input, = torch.autograd.grad(loss, input, grad.type_as(loss))
+                ref_grad, = torch.autograd.grad(ref, ref_input, grad)
+                self.assertEqual(grad_input.double(), ref_grad, 1e-2 if half else 1e-5)
+
+        x = cast(torch.randn(4, 5).double()).requires_grad_()
+        t = cast(torch.LongTensor([0, 3, 4, 1]))
+        self.assertTrue(gradgradcheck(lambda i: F.cross_entropy(i, t, label_smoothing=0.2, ignore_index=3),
+                                      (x,)))
+
+    def test_cross_entropy_fused(self):
+        self._test_cross_entropy_fused(lambda t: t, ['float', 'double'])
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_cross_entropy_fused_cuda(self):
+        self._test_cross_entropy_fused(lambda t: t.cuda(), ['float', 'double', 'half'])
+
     def test_RNN_cell_no_broadcasting(self):
         def test(cell_module, input, hx, input_size, hidden_size):
             cell = cell_module(input_size, hidden_size)
@@ -3220,6 +3532,49 @@ class TestNN(NNTestCase):
 
             (hx + cx).sum().backward()
 
+    def test_rnn_cell_fused_cpu(self):
+        def lstm_ref(igates, hgates, cx, ibias=None, hbias=None):
+            gates = igates + hgates
+            if ibias is not None:
+                gates = gates + ibias + hbias
+            ingate, forgetgate, cellgate, outgate = gates.chunk(4, 1)
+            cy = forgetgate.sigmoid() * cx + ingate.sigmoid() * cellgate.tanh()
+            return outgate.sigmoid() * cy.tanh(), cy
+
+        def gru_ref(igates, hgates, hx, ibias=None, hbias=None):
+            if ibias is not None:
+                igates = igates + ibias
+                hgates = hgates + hbias
+            i_r, i_i, i_n = igates.chunk(3, 1)
+            h_r, h_i, h_n = hgates.chunk(3, 1)
+            resetgate = (i_r + h_r).sigmoid()
+            inputgate = (i_i + h_i).sigmoid()
+            newgate = (i_n + resetgate * h_n).tanh()
+            return newgate + inputgate * (hx - newgate)
+
+        def lstm_fused(*args):
+            hy, cy, _ = torch._thnn_fused_lstm_cell(*args)
+            return hy, cy
+
+        def gru_fused(*args):
+            return torch._thnn_fused_gru_cell(*args)[0]
+
+        # a hidden size that isn't a multiple of the vector width
+        batch, hidden_size = 5, 11
+        for num_gates, fused, ref in ((4, lstm_fused, lstm_ref), (3, gru_fused, gru_ref)):
+            for dtype, bias in product((torch.float, torch.double), (True, False)):
+                inputs = [torch.randn(batch, num_gates * hidden_size, dtype=dtype),
+                          torch.randn(batch, num_gates * hidden_size, dtype=dtype),
+                          torch.randn(batch, hidden_size, dtype=dtype)]
+                if bias:
+                    inputs += [torch.randn(num_gates * hidden_size, dtype=dtype),
+                               torch.randn(num_gates * hidden_size, dtype=dtype)]
+                inputs = [x.requires_grad_() for x in inputs]
+                prec = 1e-4 if dtype == torch.float else 1e-10
+                self.assertEqual(fused(*inputs), ref(*inputs), prec)
+                if dtype == torch.double:
+                    self.assertTrue(gradcheck(fused, inputs))
+
     @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
     def test_cudnn_weight_format(self):
         rnns = [
@@ -3299,6 +3654,62 @@ class TestNN(NNTestCase):
             output_cpu = rnn(input.cpu(), hx)
             self.assertEqual(output_cuda, output_cpu)
 
+    @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
+    def test_cudnn_rnn_descriptor_reuse(self):
+        # RNN and tensor descriptors are cached across calls; interleave
+        # modules and packed batches that differ in every cached parameter
+        # and check that each call still gives its first result
+        rnns = [
+            nn.LSTM(3, 4, num_layers=2, bidirectional=True).cuda(),
+            nn.GRU(3, 4).cuda(),
+            nn.LSTM(3, 5).cuda(),
+        ]
+        batches = [[5, 3, 3, 1], [5, 5], [2, 1, 1]]
+        inputs = []
+        for lengths in batches:
+            x = Variable(torch.randn(lengths[0], len(lengths), 3).cuda())
+            inputs.append(rnn_utils.pack_padded_sequence(x, lengths))
+
+        expected = {}
+        for _ in range(2):
+            for i, rnn in enumerate(rnns):
+                for j, packed in enumerate(inputs):
+                    out, _ = rnn(packed)
+                    if (i, j) in expected:
+                        self.assertEqual(out.data, expected[i, j])
+                    else:
+                        expected[i, j] = out.data
+
+        # and against the non-cuDNN implementation
+        with torch.backends.cudnn.flags(enabled=False):
+            for (i, j), out in expected.items():
+                self.assertEqual(rnns[i](inputs[j])[0].data, out)
+
+    @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
+    def test_cudnn_rnn_algo(self):
+        cudnn = torch.backends.cudnn
+        self.assertEqual(cudnn.rnn_algo(), 'auto')
+        self.assertRaises(RuntimeError, lambda: cudnn.set_rnn_algo('fastest'))
+
+        rnn = nn.LSTM(128, 128).cuda()
+        input = Variable(torch.randn(12, 8, 128).cuda(), requires_grad=True)
+        results = []
+        try:
+            for algo in ['standard', 'persist_static', 'auto']:
+                cudnn.set_rnn_algo(algo)
+                self.assertEqual(cudnn.rnn_algo(), algo)
+                rnn.zero_grad()
+                input.grad = None
+                output, _ = rnn(input)
+                output.sum().backward()
+                results.append([output.data, input.grad.data] +
+                               [p.grad.data for p in rnn.parameters()])
+        finally:
+            cudnn.set_rnn_algo('auto')
+        for result in results[1:]:
+            for a, b in zip(result, results[0]):
+                self.assertEqual(a, b, prec=1e-4)
+
     @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
     @repeat_test_for_types(ALL_TENSORTYPES)
     def test_cuda_rnn_fused(self, dtype=torch.FloatTensor):
@@ -3974,6 +4385,33 @@ class TestNN(NNTestCase):
     def test_batchnorm_update_stats_cuda(self):
         self._test_batchnorm_update_stats(torch.cuda.FloatTensor)
 
+    def test_batchnorm_matches_thnn(self):
+        # the native CPU batch norm should match THNN for contiguous, channels
+        # last and N x C inputs, with its fused ReLU matching a separate one
+        x = torch.randn(4, 6, 5, 3).double() * 3 + 2
+        for input in [x.permute(0, 3, 1, 2).contiguous(), x.permute(0, 3, 1, 2), x.view(4, -1)[:, :3]]:
+            C = input.size(1)
+            weight = torch.randn(C).double().requires_grad_()
+            bias = torch.randn(C).double().requires_grad_()
+            for training in [True, False]:
+                running_mean, running_var = torch.randn(C).double(), torch.rand(C).double() + 0.5
+                running_mean_thnn, running_var_thnn = running_mean.clone(), running_var.clone()
+                for relu in [False, True]:
+                    input_ = input.detach().requires_grad_()
+                    out = torch._batch_norm_cpu(input_, weight, bias, running_mean, running_var,
+                                                training, 0.1, 1e-5, relu)[0]
+                    input_thnn = input.detach().requires_grad_()
+                    out_thnn = torch._C._nn.thnn_batch_norm(input_thnn, weight, bias, running_mean_thnn,
+                                                            running_var_thnn, training, 0.1, 1e-5)
+                    if relu:
+                        out_thnn = F.relu(out_thnn)
+                    self.assertEqual(out, out_thnn)
+                    self.assertEqual(running_mean, running_mean_thnn)
+                    self.assertEqual(running_var, running_var_thnn)
+                    grad = torch.randn(out.size()).double()
+                    self.assertEqual(torch.autograd.grad(out, (input_, weight, bias), grad),
+                                     torch.autograd.grad(out_thnn, (input_thnn, weight, bias), grad))
+
     def test_batchnorm_raises_error_if_running_mean_is_not_same_size_as_input(self):
         input = Variable(torch.rand(2, 10))
         running_var = torch.rand(10)
@@ -4059,6 +4497,19 @@ class TestNN(NNTestCase):
         input2 = Variable(torch.randn(4, 4), requires_grad=True)
         self.assertTrue(gradcheck(lambda x, y: F.pairwise_distance(x, y), (input1, input2)))
 
+    def test_pairwise_distance_fused(self):
+        # the fused kernels should match the norm of the difference, also
+        # against a broadcast row
+        for size2 in [(6, 5), (1, 5), (5,)]:
+            x1 = torch.randn(6, 5).double().requires_grad_()
+            x2 = torch.randn(*size2).double().requires_grad_()
+            for p in [0, 1, 1.5, 2, float('inf')]:
+                for keepdim in [False, True]:
+                    self.assertEqual(F.pairwise_distance(x1, x2, p, keepdim=keepdim),
+                                     torch.norm(x1 - x2 + 1e-6, p, 1, keepdim))
+                if p != 0:
+                    self.assertTrue(gradcheck(lambda x, y: F.pairwise_distance(x, y, p), (x1, x2)))
+
     def test_cosine_embedding_loss_no_reduce(self):
         input1 = Variable(torch.randn(15, 10), requires_grad=True)
         input2 = Variable(torch.randn(15, 10), requires_grad=True)
@@ -4437,6 +4888,32 @@ class TestNN(NNTestCase):
         expected = m(inp.view(6, 5)).view(2, 3, 8)
         self.assertEqual(expected, m(inp))
 
+    def test_linear_packed_weight(self):
+        for bias in [True, False]:
+            m = nn.Linear(13, 21, bias=bias).eval()
+            for size in [(1, 13), (5, 13), (2, 3, 13), (13,)]:
+                inp = torch.randn(*size)
+                with torch.no_grad():
+                    self.assertEqual(m(inp), F.linear(inp, m.weight, m.bias))
+                    # the packed weight follows the in place updates
+                    m.weight.mul_(2)
+                    self.assertEqual(m(inp), F.linear(inp, m.weight, m.bias))
+                    m.weight = nn.Parameter(torch.randn(21, 13))
+                    self.assertEqual(m(inp), F.linear(inp, m.weight, m.bias))
+                m.weight.data.uniform_()
+                m.eval()
+                with torch.no_grad():
+                    self.assertEqual(m(inp), F.linear(inp, m.weight, m.bias))
+            # larger batches and training don't use the packed weight
+            inp = torch.randn(100, 13)
+            with torch.no_grad():
+                self.assertEqual(m(inp), F.linear(inp, m.weight, m.bias))
+            m.train()
+            out = m(inp[:2])
+            self.assertTrue(out.requires_grad)
+            out.sum().backward()
+            self.assertEqual(m.weight.grad, inp[:2].sum(0).expand(21, 13))
+
     def test_bilinear(self):
         module = nn.Bilinear(10, 10, 8)
         module_legacy = legacy.Bilinear(10, 10, 8)
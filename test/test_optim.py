@@ -267,6 +267,50 @@ class TestOptim(TestCase):
         with self.assertRaisesRegex(ValueError, "Invalid momentum value: -0.5"):
             optim.SGD(None, lr=1e-2, momentum=-0.5)
 
+    def _test_fused(self, constructor):
+        # The fused steps match the steps of the params one at a time, and the
+        # non-contiguous params still take those
+        devices = ['cpu', 'cuda'] if torch.cuda.is_available() else ['cpu']
+        for device in devices:
+            values = [torch.randn(10, 5), torch.randn(10), torch.randn(7, 2)[:, 0], torch.randn(3).double()]
+            if device == 'cuda':
+                values = [v.cuda() for v in values]
+            params = [Variable(v.clone(), requires_grad=True) for v in values]
+            params_fused = [Variable(v.clone(), requires_grad=True) for v in values]
+            optimizer = constructor(params)
+            optimizer_fused = constructor(params_fused, fused=True)
+            for i in range(10):
+                for ps, o in [(params, optimizer), (params_fused, optimizer_fused)]:
+                    o.zero_grad()
+                    sum((p ** 2 + p).sum().double() for p in ps).backward()
+                    o.step()
+                for p, p_fused in zip(params, params_fused):
+                    self.assertEqual(p, p_fused, prec=1e-6)
+
+    def test_sgd_fused(self):
+        self._test_fused(lambda params, **kwargs: optim.SGD(params, lr=1e-2, **kwargs))
+        self._test_fused(lambda params, **kwargs: optim.SGD(params, lr=1e-2, momentum=0.9,
+                                                            weight_decay=1e-2, **kwargs))
+        self._test_fused(lambda params, **kwargs: optim.SGD(params, lr=1e-2, momentum=0.9,
+                                                            nesterov=True, **kwargs))
+        self._test_basic_cases(
+            lambda weight, bias: optim.SGD([weight, bias], lr=1e-3, momentum=0.9, fused=True)
+        )
+
+    def test_fused_sgd_step_master_weights(self):
+        devices = ['cpu', 'cuda'] if torch.cuda.is_available() else ['cpu']
+        for device in devices:
+            params = [torch.randn(10, 5, device=device), torch.randn(7, device=device)]
+            model_params = [p.half() for p in params]
+            grads = [torch.randn(p.size(), device=device).half() for p in params]
+            expected = [p - 0.1 * g.float() for p, g in zip(params, grads)]
+            torch._fused_sgd_step(params, grads, [], model_params, 0.1, 0, 0, 0, False, False)
+            for p, model_p, e in zip(params, model_params, expected):
+                self.assertEqual(p, e, prec=1e-6)
+                self.assertEqual(model_p.float(), e.half().float(), prec=0)
+            with self.assertRaisesRegex(RuntimeError, "params"):
+                torch._fused_sgd_step(params, grads[:1], [], [], 0.1, 0, 0, 0, False, False)
+
     def test_sgd_sparse(self):
         self._test_rosenbrock_sparse(
             lambda params: optim.SGD(params, lr=5e-3)
@@ -301,6 +345,13 @@ class TestOptim(TestCase):
         with self.assertRaisesRegex(ValueError, "Invalid beta parameter at index 0: 1.0"):
             optim.Adam(None, lr=1e-2, betas=(1.0, 0.0))
 
+    def test_adam_fused(self):
+        self._test_fused(lambda params, **kwargs: optim.Adam(params, lr=1e-2, **kwargs))
+        self._test_fused(lambda params, **kwargs: optim.Adam(params, lr=1e-2, weight_decay=1e-2, **kwargs))
+        self._test_basic_cases(
+            lambda weight, bias: optim.Adam([weight, bias], lr=1e-3, fused=True)
+        )
+
     def test_sparse_adam(self):
         self._test_rosenbrock_sparse(
             lambda params: optim.SparseAdam(params, lr=4e-2),
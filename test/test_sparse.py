@@ -410,6 +410,51 @@ class TestSparse(TestCase):
         test_shape(100, 1000, 200)
         test_shape(64, 10000, 300)
 
+    def test_mm_reuses_row_pointers(self):
+        # The row pointers of a coalesced matrix are computed by its first
+        # product and must follow later changes of its indices
+        x = self._gen_sparse(2, 20, [50, 30])[0].coalesce()
+        other = self._gen_sparse(2, 20, [50, 30])[0].coalesce()
+        y = self.randn(30, 10)
+        for _ in range(2):
+            self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+        x.add_(other)
+        x = x.coalesce()
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+        x.zero_()
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+
+    def test_accumulate_uncoalesced(self):
+        # In-place adds into an uncoalesced tensor append to its entries
+        shape = [10, 5, 3]
+        acc = self._gen_sparse(2, 7, shape)[0]
+        acc = acc + self._gen_sparse(2, 7, shape)[0] * 0
+        expected = self.safeToDense(acc)
+        for i in range(20):
+            x = self._gen_sparse(2, 1 + i, shape)[0]
+            acc.add_(0.5, x)
+            expected += 0.5 * self.safeToDense(x)
+        acc.add_(acc)
+        expected *= 2
+        self.assertEqual(self.safeToDense(acc), expected)
+        coalesced = acc.coalesce()
+        self.assertTrue(coalesced.is_coalesced())
+        self.assertEqual(self.safeToDense(coalesced), expected)
+        self.assertEqual(self.ValueTensor(10, 5, 3).zero_() + acc, expected)
+
+    def test_coalesce_sorted(self):
+        # Sorted indices, without and with duplicates
+        i = self.IndexTensor([[0, 1, 1, 3], [2, 0, 4, 1]])
+        v = self.ValueTensor([1, 2, 3, 4])
+        x = self.SparseTensor(i, v, torch.Size([4, 5]))
+        self.assertEqual(x.coalesce()._indices(), i)
+        self.assertEqual(x.coalesce()._values(), v)
+        i = self.IndexTensor([[0, 1, 1, 3], [2, 0, 0, 1]])
+        x = self.SparseTensor(i, v, torch.Size([4, 5]))
+        y = x.coalesce()
+        self.assertEqual(y._indices(), self.IndexTensor([[0, 1, 3], [2, 0, 1]]))
+        self.assertEqual(y._values(), self.ValueTensor([1, 5, 4]))
+
     @cpu_only
     def test_saddmm(self):
         def test_shape(di, dj, dk):
@@ -13,6 +13,7 @@ import warnings
 import pickle
 from torch.utils.dlpack import from_dlpack, to_dlpack
 from torch._utils import _rebuild_tensor
+from collections import OrderedDict
 from itertools import product, combinations
 from functools import reduce
 from common import TestCase, iter_indices, TEST_NUMPY, TEST_SCIPY, TEST_MKL, \
@@ -79,6 +80,14 @@ class BytesIOContext(io.BytesIO):
 
 class TestTorch(TestCase):
 
+    def test_numa_policy(self):
+        for policy in ['interleave', 'local', 'default']:
+            torch.set_numa_policy(policy, -1)
+            x = torch.ones(1 << 20)
+            self.assertEqual(x.sum(), 1 << 20)
+        self.assertRaises(RuntimeError, lambda: torch.set_numa_policy('remote'))
+        self.assertRaises(RuntimeError, lambda: torch.bind_threads_to_numa_node(-1))
+
     def test_dot(self):
         types = {
             'torch.DoubleTensor': 1e-8,
@@ -281,6 +290,15 @@ class TestTorch(TestCase):
         check_non_contiguous((5, 7), torch.float)
         check_non_contiguous((1024,), torch.float)
 
+        def check_strided(dtype):
+            input = torch.randn(53, 37, dtype=dtype)
+            for strided in (input.t(), input[:, 3:30], input[::2, ::3], input.t()[5:]):
+                self.assertEqual(torchfn(strided), torchfn(strided.contiguous()), 'strided')
+
+        # transposed and sliced layouts
+        check_strided(torch.double)
+        check_strided(torch.float)
+
         def check_large(dtype):
             input = torch.randn(1024, 512, dtype=dtype)
             actual = torchfn(input)
@@ -456,7 +474,13 @@ class TestTorch(TestCase):
         self._test_math(torch.rsqrt, rsqrt)
 
     def test_sigmoid(self):
-        # TODO: why not simulate math.sigmoid like with rsqrt?
+        def sigmoid(x):
+            try:
+                return 1 / (1 + math.exp(-x))
+            except OverflowError:
+                return 0.
+        self._test_math(torch.sigmoid, sigmoid)
+
         inputValues = [-1000, -1, 0, 0.5, 1, 2, 1000]
         expectedOutput = [0.0000, 0.2689, 0.5, 0.6225, 0.7311, 0.8808, 1.000]
         precision_4dps = 0.0002
@@ -1086,6 +1110,22 @@ class TestTorch(TestCase):
             r = torch.mm(b1[i], b2[i])
             self.assertEqual(r, res[i])
 
+        # transposed and non-contiguous operands and results, and integers
+        b1t = torch.randn(num_batches, N, M).transpose(1, 2)
+        b2t = torch.randn(num_batches, O, N).transpose(1, 2)
+        b2s = torch.randn(num_batches, N, 2 * O)[:, :, ::2]
+        for x, y in [(b1t, b2), (b1, b2t), (b1t, b2t), (b1, b2s)]:
+            expected = torch.stack([torch.mm(x[i], y[i]) for i in range(num_batches)])
+            self.assertEqual(torch.bmm(x, y), expected)
+            out = torch.zeros(num_batches, O, M).transpose(1, 2)
+            torch.bmm(x, y, out=out)
+            self.assertEqual(out, expected)
+        b1 = torch.LongTensor(num_batches, M, N).random_(-5, 5)
+        b2 = torch.LongTensor(num_batches, N, O).random_(-5, 5)
+        res = torch.bmm(b1, b2)
+        for i in range(num_batches):
+            self.assertEqual(torch.mm(b1[i], b2[i]), res[i])
+
     def test_addbmm(self):
         # num_batches = 10
         # M, N, O = 12, 8, 5
@@ -1321,6 +1361,23 @@ class TestTorch(TestCase):
         check_sum_dim(torch.randn(50, 50, 50), 0)
         check_sum_dim(torch.randn(50, 50, 50), 1)
         check_sum_dim(torch.randn(50, 50, 50), 2)
+        check_sum_dim(torch.randn(50, 50, 50), (0, 2))
+        check_sum_dim(torch.randn(50, 50, 50), (1, -1))
+        check_sum_dim(torch.randn(50, 50, 50), (0, 1, 2))
+        check_sum_dim(torch.randn(50, 50, 50).transpose(0, 2), 0)
+        check_sum_dim(torch.randn(50, 50, 50).transpose(0, 2), (0, 1))
+        check_sum_dim(torch.randn(1000, 100)[:, ::3], 0)
+        check_sum_dim(torch.randn(100, 1000)[::2, 1:], (0, 1))
+
+    def test_sum_multiple_dims(self):
+        x = torch.randn(4, 5, 6, 7)
+        res = x.sum((1, 3), keepdim=True)
+        self.assertEqual(res.size(), (4, 1, 6, 1))
+        self.assertEqual(res, x.sum(3, True).sum(1, True))
+        self.assertEqual(x.sum((3, 1)), x.sum(3).sum(1))
+        self.assertEqual(x.sum(()), x)
+        self.assertRaises(RuntimeError, lambda: x.sum((1, 1)))
+        self.assertRaises(RuntimeError, lambda: x.sum((1, -3)))
 
     def test_sum_out(self):
         x = torch.rand(100, 100)
@@ -1360,6 +1417,25 @@ class TestTorch(TestCase):
         torch.cross(x, y, out=res2)
         self.assertEqual(res1, res2)
 
+    def test_cdist(self):
+        def reference(x1, x2, p):
+            return torch.norm(x1.unsqueeze(1) - x2.unsqueeze(0), p, 2)
+
+        # the large sizes use the GEMM expansion for p = 2
+        for n, m, d in [(5, 7, 3), (4, 1, 20), (30, 40, 17)]:
+            x1 = torch.randn(n, d).double()
+            x2 = torch.randn(m, d).double()
+            x2[0].copy_(x1[0])
+            for p in [0, 1, 1.5, 2, 3, float('inf')]:
+                self.assertEqual(torch.cdist(x1, x2, p), reference(x1, x2, p))
+
+        x1 = torch.randn(4, 5).double().requires_grad_()
+        x2 = torch.randn(6, 5).double().requires_grad_()
+        for p in [1, 1.5, 2, 3, float('inf')]:
+            self.assertTrue(torch.autograd.gradcheck(lambda a, b: torch.cdist(a, b, p), (x1, x2)))
+        self.assertRaises(RuntimeError, lambda: torch.cdist(torch.randn(3, 4), torch.randn(3, 5)))
+        self.assertRaises(RuntimeError, lambda: torch.cdist(torch.randn(3, 4), torch.randn(3, 4), -1))
+
     def test_zeros(self):
         res1 = torch.zeros(100, 100)
         res2 = torch.Tensor()
@@ -2322,6 +2398,29 @@ class TestTorch(TestCase):
         torch.zeros(5, 6).copy_(torch.zeros(6))
         self.assertRaises(RuntimeError, lambda: torch.zeros(5, 6).copy_(torch.zeros(30)))
 
+    def test_unary_keeps_channels_last(self):
+        x = torch.randn(2, 5, 6, 3).permute(0, 3, 1, 2)
+        for fn in [torch.exp, torch.sigmoid, torch.abs]:
+            res = fn(x)
+            self.assertEqual(res.stride(), x.stride())
+            self.assertEqual(res, fn(x.contiguous()))
+        self.assertTrue(torch.exp(x.contiguous()).is_contiguous())
+
+    def test_copy_transpose(self):
+        def check(x):
+            self.assertEqual(x.contiguous(), torch.tensor(x.tolist(), dtype=x.dtype), 0)
+            self.assertEqual(torch.empty_like(x).copy_(x), x, 0)
+
+        for dtype in [torch.uint8, torch.int64, torch.float32, torch.float64]:
+            x = torch.arange(0, 100 * 97).remainder(200).to(dtype)
+            check(x.view(100, 97).t())
+            check(x.view(100, 97).t()[1:, 3:])
+            # NCHW <-> NHWC
+            nchw = torch.arange(0, 2 * 3 * 67 * 71).remainder(200).to(dtype).view(2, 3, 67, 71)
+            check(nchw.permute(0, 2, 3, 1))
+            check(nchw.contiguous().permute(0, 2, 3, 1).contiguous().permute(0, 3, 1, 2))
+            check(nchw.permute(3, 2, 1, 0))
+
     def test_randperm(self):
         _RNGState = torch.get_rng_state()
         res1 = torch.randperm(100)
@@ -2671,6 +2770,31 @@ class TestTorch(TestCase):
     def test_cat_empty(self):
         self._test_cat_empty(self)
 
+    @staticmethod
+    def _test_cat_many_inputs(self, use_cuda=False):
+        # more inputs than fit in a single batch of the old kernels, catted
+        # along every dimension
+        device = 'cuda' if use_cuda else 'cpu'
+        for dim in range(3):
+            sizes = [[3, 4, 5] for _ in range(2000)]
+            for i, size in enumerate(sizes):
+                size[dim] = 1 + i % 3
+            inputs = [torch.randn(*size, device=device) for size in sizes]
+            res = torch.cat(inputs, dim)
+            offset = 0
+            for x in inputs:
+                self.assertEqual(res.narrow(dim, offset, x.size(dim)), x, 0)
+                offset += x.size(dim)
+            self.assertEqual(res.size(dim), offset)
+
+            same_size = inputs[::3]
+            stacked = torch.stack(same_size, dim)
+            for i, x in enumerate(same_size):
+                self.assertEqual(stacked.select(dim, i), x, 0)
+
+    def test_cat_many_inputs(self):
+        self._test_cat_many_inputs(self)
+
     def test_stack(self):
         x = torch.rand(2, 3, 4)
         y = torch.rand(2, 3, 4)
@@ -3505,6 +3629,27 @@ class TestTorch(TestCase):
             return torch.DoubleTensor(*sizes).normal_()
         self._test_fft_ifft_rfft_irfft(self, build_fn=randn_double)
 
+    @staticmethod
+    def _test_fft_plan_reuse(self, build_fn):
+        # transforms of the same sizes, which differ in strides, batch,
+        # direction or scaling, must not run with each other's plans
+        x = build_fn(8, 16, 2)
+        for _ in range(2):
+            ref = x.fft(1)
+            self.assertEqual(x.transpose(0, 1).contiguous().transpose(0, 1).fft(1), ref, 1e-8)
+            self.assertEqual(x.narrow(0, 0, 4).fft(1), ref[:4], 1e-8)
+            self.assertEqual(x.fft(1, normalized=True), ref / 4, 1e-8)
+            self.assertEqual(ref.ifft(1), x, 1e-8)
+            self.assertEqual(x.fft(1).ifft(1, normalized=True), x * 4, 1e-8)
+            real = x.select(2, 0)
+            self.assertEqual(real.rfft(1).irfft(1, signal_sizes=(16,)), real, 1e-8)
+
+    @unittest.skipIf(not TEST_MKL, "PyTorch is built without MKL support")
+    def test_fft_plan_reuse(self):
+        def randn_double(*sizes):
+            return torch.DoubleTensor(*sizes).normal_()
+        self._test_fft_plan_reuse(self, build_fn=randn_double)
+
     @staticmethod
     def _test_stft(self, build_fn):
         # the conv_fn to convert tensors can be slow in cuda tests, so we use
@@ -3811,6 +3956,40 @@ class TestTorch(TestCase):
         self.assertEqual(seeded, reseeded, 0,
                          'repeated calls to manual_seed not generating same sequence of normally distributed numbers')
 
+    def test_philox_fills(self):
+        # uniform_, normal_ and bernoulli_ draw from a counter-based stream,
+        # so their results don't depend on the number of threads
+        num_threads = torch.get_num_threads()
+        results = []
+        try:
+            for threads in [1, 4]:
+                torch.set_num_threads(threads)
+                torch.manual_seed(123)
+                results.append([torch.rand(100001), torch.randn(100001),
+                                torch.Tensor(100001).bernoulli_(0.3),
+                                torch.DoubleTensor(301, 300).t().uniform_(-1, 2)])
+        finally:
+            torch.set_num_threads(num_threads)
+        for x, y in zip(*results):
+            self.assertEqual(x, y, 0)
+        rand, randn, bernoulli, uniform = results[0]
+        self.assertNotEqual(rand[:50000], rand[50001:100001])
+        self.assertLess(abs(randn.mean()), 0.02)
+        self.assertLess(abs(randn.std() - 1), 0.02)
+        self.assertLess(abs(bernoulli.mean() - 0.3), 0.01)
+        self.assertGreaterEqual(uniform.min(), -1)
+        self.assertLess(uniform.max(), 2)
+
+        # states saved without the Philox offset still load
+        state = torch.get_rng_state()
+        torch.set_rng_state(state[:-8])
+        torch.set_rng_state(state)
+
+        # the native kernels cover integral bernoulli_ and check their arguments
+        self.assertTrue(torch.ByteTensor(1000).bernoulli_(0.5).le(1).all())
+        self.assertRaises(RuntimeError, lambda: torch.Tensor(10).bernoulli_(1.5))
+        self.assertRaises(RuntimeError, lambda: torch.Tensor(10).normal_(0, -1))
+
     def test_manual_seed(self):
         rng_state = torch.get_rng_state()
         torch.manual_seed(2)
@@ -5517,6 +5696,58 @@ class TestTorch(TestCase):
     def test_serialization_offset_filelike(self):
         self._test_serialization_offset(BytesIOContext)
 
+    def test_serialization_page_aligned(self):
+        a = torch.randn(5, 5)
+        b = [a, a[1], torch.arange(1, 11).int(), a.storage()[2:5], torch.randn(3).double()]
+        with tempfile.NamedTemporaryFile() as f:
+            pickle.dump(41, f)
+            torch.save(b, f, page_aligned=True)
+            f.flush()
+            for mmap in (False, True):
+                f.seek(0)
+                self.assertEqual(pickle.load(f), 41)
+                c = torch.load(f, mmap=mmap)
+                self.assertEqual(b, c, 0)
+                self.assertEqual(c[0].storage().data_ptr(), c[1].storage().data_ptr())
+                self.assertEqual(c[3].data_ptr() - c[0].data_ptr(), 2 * a.element_size())
+            # storages are views of the mapping, and writes to them don't
+            # change the file
+            data_ptrs = [tensor.storage().data_ptr() for tensor in (c[0], c[2], c[4])]
+            self.assertTrue(all(ptr % torch.serialization.STORAGE_ALIGNMENT == 0 for ptr in data_ptrs))
+            c[0].fill_(10)
+            f.seek(0)
+            pickle.load(f)
+            self.assertEqual(torch.load(f, mmap=True)[0], a, 0)
+
+        with BytesIOContext() as f:
+            torch.save(b, f, page_aligned=True)
+            f.seek(0)
+            self.assertEqual(b, torch.load(f, mmap=True), 0)
+
+    def test_save_load_tensors(self):
+        a = torch.randn(5, 5)
+        tensors = OrderedDict([
+            ('weight', a),
+            ('weight.t', a.t()),
+            ('bias', torch.arange(1, 11).int()),
+            ('empty', torch.randn(0).double()),
+            ('scalar', torch.tensor(3)),
+        ])
+        with tempfile.NamedTemporaryFile() as f:
+            torch.save_tensors(tensors, f.name)
+            for mmap in (False, True):
+                loaded = torch.load_tensors(f.name, mmap=mmap)
+                self.assertEqual(list(loaded.keys()), list(tensors.keys()))
+                for name in tensors:
+                    self.assertEqual(loaded[name].type(), tensors[name].type())
+                    self.assertEqual(loaded[name], tensors[name], 0)
+                self.assertTrue(loaded['weight'].data_ptr() % 64 == 0)
+            # writes to mapped tensors don't change the file
+            loaded['weight'].fill_(10)
+            self.assertEqual(torch.load_tensors(f.name)['weight'], a, 0)
+
+        self.assertRaises(TypeError, lambda: torch.save_tensors({'a': 1}, 'unused'))
+
     def test_half_tensor(self):
         x = torch.randn(5, 5).float()
         y = torch.randn(5, 5).float()
@@ -5533,6 +5764,33 @@ class TestTorch(TestCase):
             xh2 = torch.load(f)
             self.assertEqual(xh.float(), xh2.float())
 
+    @unittest.skipIf(not TEST_NUMPY, 'Numpy not found')
+    def test_half_conversion(self):
+        # contiguous copies convert blocks of values at a time, the others
+        # one by one, and both round to the nearest even half
+        x = torch.randn(10007) * 1000
+        x[:4] = torch.Tensor([65519.99, 65520, 2.98023224e-08, -0.0])
+        expected = torch.from_numpy(x.numpy().astype(np.float16).astype(np.float32))
+        self.assertEqual(x.half().float(), expected, 0)
+        self.assertEqual(x[::2].half().float(), expected[::2], 0)
+        h = torch.from_numpy(np.arange(-32768, 32768, dtype=np.int16).view(np.float16))
+        finite = torch.from_numpy(np.isfinite(h.numpy()).astype(np.uint8))
+        self.assertEqual(h.float()[finite], torch.from_numpy(h.numpy().astype(np.float32))[finite], 0)
+
+    def test_half_mm(self):
+        # CPU Half products are computed in float, in blocks of rows
+        a = torch.randn(600, 40).half()
+        b = torch.randn(40, 30).half()
+        expected = a.float().mm(b.float())
+        self.assertEqual(a.mm(b).dtype, torch.float16)
+        self.assertEqual(a.mm(b).float(), expected, 1e-2)
+        self.assertEqual(a[:, :20].mm(b.t().contiguous().t()[:20]).float(),
+                         a[:, :20].float().mm(b[:20].float()), 1e-2)
+        out = torch.HalfTensor()
+        torch.mm(a, b, out=out)
+        self.assertEqual(out.float(), expected, 1e-2)
+        self.assertRaises(RuntimeError, lambda: a.mm(a))
+
     @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
     def test_half_tensor_cuda(self):
         x = torch.randn(5, 5).half()
@@ -6062,6 +6320,24 @@ class TestTorch(TestCase):
         x = np.zeros((0, 2))
         self.assertEqual(torch.from_numpy(x).shape, (0,))
 
+        # check negative strides, which are copied
+        x = np.arange(12, dtype=np.float64).reshape(3, 4)[::-1, ::-2]
+        self.assertEqual(torch.from_numpy(x), torch.from_numpy(np.ascontiguousarray(x)))
+
+        # check byte-swapped arrays, which are copied
+        x = np.arange(4, dtype=np.dtype(np.int32).newbyteorder())
+        self.assertEqual(torch.from_numpy(x).tolist(), [0, 1, 2, 3])
+
+        # check read-only arrays, which give read-only tensors
+        x = np.arange(4, dtype=np.float32)
+        x.flags.writeable = False
+        tensor = torch.from_numpy(x)
+        self.assertEqual(tensor, torch.arange(4))
+        self.assertRaisesRegex(RuntimeError, 'read-only', lambda: tensor.add_(1))
+        self.assertRaisesRegex(RuntimeError, 'read-only', lambda: tensor.__setitem__(0, 1))
+        self.assertEqual(tensor + 1, torch.arange(1, 5))
+        self.assertFalse(tensor.numpy().flags.writeable)
+
     @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
     def test_ctor_with_numpy_array(self):
         dtypes = [
@@ -6377,6 +6653,34 @@ class TestTorch(TestCase):
         self.assertEqual(double_tensor[2], 0.0, prec=0.0)  # tiny_double to zero
         torch.set_flush_denormal(False)
 
+    def test_sort_topk_large_integer(self):
+        # rows long enough for the radix sort, sorted in parallel
+        for t in [torch.LongTensor, torch.IntTensor, torch.ShortTensor, torch.ByteTensor, torch.CharTensor]:
+            x = t(6, 5000).random_(0, 100)
+            if t is not torch.ByteTensor:
+                x -= 50
+            for descending in [False, True]:
+                values, indices = x.sort(1, descending)
+                self.assertEqual(values, x.gather(1, indices))
+                if descending:
+                    self.assertTrue((values[:, :-1] >= values[:, 1:]).all())
+                else:
+                    self.assertTrue((values[:, :-1] <= values[:, 1:]).all())
+                # the radix sort is stable
+                equal = values[:, :-1] == values[:, 1:]
+                self.assertTrue((indices[:, :-1][equal] < indices[:, 1:][equal]).all())
+            # a non contiguous slice
+            values, indices = x.t().sort(0)
+            self.assertEqual(values, x.t().gather(0, indices))
+            self.assertTrue((values[:-1] <= values[1:]).all())
+
+        x = torch.randn(64, 3000)
+        for largest in [True, False]:
+            values, indices = x.topk(20, 1, largest, True)
+            expected = x.sort(1, largest)[0][:, :20]
+            self.assertEqual(values, expected)
+            self.assertEqual(values, x.gather(1, indices))
+
     def test_unique_cpu(self):
         x = torch.LongTensor([1, 2, 3, 2, 8, 5, 2, 3])
         expected_unique = torch.LongTensor([1, 2, 3, 5, 8])
@@ -6427,6 +6731,28 @@ class TestTorch(TestCase):
         self.assertEqual(torch.ByteTensor([7, 42, 128, 133]), byte_unique)
         self.assertEqual(torch.LongTensor([3, 0, 0, 0, 1, 2]), byte_inverse)
 
+        x_unique, x_inverse, x_counts = x.unique(sorted=True, return_inverse=True, return_counts=True)
+        self.assertEqual(expected_unique, x_unique)
+        self.assertEqual(expected_inverse, x_inverse)
+        self.assertEqual(torch.LongTensor([1, 3, 2, 1, 1]), x_counts)
+        x_unique, x_counts = torch.unique(x, return_counts=True)
+        self.assertEqual(expected_unique, x_unique)
+        self.assertEqual(torch.LongTensor([1, 3, 2, 1, 1]), x_counts)
+
+        # -0 and 0 are the same value
+        zero_unique = torch.unique(torch.DoubleTensor([0., -1., -0., 2.]), sorted=True)
+        self.assertEqual(torch.DoubleTensor([-1., 0., 2.]), zero_unique)
+
+        # large enough for the radix sort, with negative values
+        for t in [torch.LongTensor, torch.IntTensor, torch.DoubleTensor, torch.FloatTensor]:
+            big = t(100000).random_(0, 2000) - 1000
+            big_unique, big_inverse, big_counts = big.unique(sorted=True, return_inverse=True, return_counts=True)
+            expected = sorted(set(big.tolist()))
+            self.assertEqual(expected, big_unique.tolist())
+            self.assertEqual(big, big_unique[big_inverse])
+            self.assertEqual(torch.zeros(len(expected)).long().index_add_(0, big_inverse, torch.ones(100000).long()),
+                             big_counts)
+
     @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
     def test_unique_cuda(self):
         # unique currently does not support CUDA.
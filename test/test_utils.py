@@ -17,6 +17,7 @@ from torch.utils.trainer import Trainer
 from torch.utils.trainer.plugins import *
 from torch.utils.trainer.plugins.plugin import Plugin
 from torch.utils.serialization import load_lua
+from torch.utils.checkpoint import checkpoint, checkpoint_sequential
 from torch.autograd._functions.utils import prepare_onnx_paddings
 from torch.autograd._functions.utils import check_onnx_broadcast
 from common import IS_WINDOWS
@@ -152,6 +153,66 @@ class TestDataLoader(TestCase):
         self.assertEqual(len(list(dataiter)), 1)
 
 
+class TestCheckpoint(TestCase):
+
+    def _leaves(self, inputs):
+        leaves = []
+        for inp in inputs:
+            leaf = inp.detach()
+            leaf.requires_grad = True
+            leaves.append(leaf)
+        return leaves
+
+    def _test_matches_plain(self, run, *inputs):
+        plain_inputs = self._leaves(inputs)
+        torch.manual_seed(0)
+        expected = run(*plain_inputs)
+        expected.sum().backward()
+
+        ckpt_inputs = self._leaves(inputs)
+        torch.manual_seed(0)
+        out = checkpoint(run, *ckpt_inputs)
+        self.assertEqual(out, expected)
+        out.sum().backward()
+        for ckpt_inp, plain_inp in zip(ckpt_inputs, plain_inputs):
+            self.assertEqual(ckpt_inp.grad, plain_inp.grad)
+
+    def test_checkpoint(self):
+        model = torch.nn.Sequential(torch.nn.Linear(10, 10), torch.nn.Tanh(), torch.nn.Linear(10, 4))
+        self._test_matches_plain(model, torch.randn(3, 10))
+        self._test_matches_plain(lambda x, y: (x * y).exp(), torch.randn(5), torch.randn(5))
+
+    def test_checkpoint_rng_state(self):
+        # dropout draws the same mask when the segment is rerun in backward
+        self._test_matches_plain(lambda x: torch.nn.functional.dropout(x * 2, training=True),
+                                 torch.randn(100))
+
+        torch.manual_seed(0)
+        x = torch.randn(10, requires_grad=True)
+        checkpoint(lambda x: torch.nn.functional.dropout(x, training=True), x).sum().backward()
+        after = torch.rand(1)
+        torch.manual_seed(0)
+        torch.nn.functional.dropout(torch.randn(10), training=True)
+        # the rerun does not advance the generator
+        self.assertEqual(after, torch.rand(1))
+
+    def test_checkpoint_sequential(self):
+        model = torch.nn.Sequential(*[torch.nn.Linear(8, 8) for _ in range(6)])
+        x = torch.randn(2, 8, requires_grad=True)
+        expected = model(x)
+        expected.sum().backward()
+        expected_grads = [p.grad.clone() for p in model.parameters()]
+        model.zero_grad()
+
+        x_ckpt, = self._leaves([x])
+        out = checkpoint_sequential(model, 3, x_ckpt)
+        self.assertEqual(out, expected)
+        out.sum().backward()
+        self.assertEqual(x_ckpt.grad, x.grad)
+        for p, grad in zip(model.parameters(), expected_grads):
+            self.assertEqual(p.grad, grad)
+
+
 class TestTrainer(TestCase):
 
     intervals = [
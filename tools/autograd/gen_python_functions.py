@@ -88,6 +88,10 @@ set_requires_grad(${call_dispatch}, ${requires_grad})""")
 PY_VARIABLE_WRAP = CodeTemplate("""\
 return wrap(${call_dispatch});""")
 
+PY_VARIABLE_RETURN_NONE = CodeTemplate("""\
+${call_dispatch};
+Py_RETURN_NONE;""")
+
 PY_VARIABLE_DISPATCH = CodeTemplate("""\
 inline ${return_type} ${dispatch_name}(${formal_args}) {
   ${initialize_cuda}
@@ -114,7 +118,7 @@ SUPPORTED_RETURN_TYPES = {
     'std::tuple<Tensor,Tensor,Tensor,Tensor>',
     'std::tuple<Tensor,Tensor,Tensor,Tensor,Tensor>',
     'std::vector<Tensor>',
-    'Scalar', 'bool', 'int64_t', 'void*'
+    'Scalar', 'bool', 'int64_t', 'void*', 'void'
 }
 
 
@@ -399,7 +403,10 @@ def create_python_bindings(python_functions, has_self, is_module=False):
         if requires_grad:
             call_dispatch = PY_VARIABLE_SET_REQUIRES_GRAD.substitute(env, call_dispatch=call_dispatch,
                                                                      requires_grad=requires_grad)
-        body.append(PY_VARIABLE_WRAP.substitute(env, call_dispatch=call_dispatch))
+        if declaration['return_type'] == 'void':
+            body.append(PY_VARIABLE_RETURN_NONE.substitute(env, call_dispatch=call_dispatch))
+        else:
+            body.append(PY_VARIABLE_WRAP.substitute(env, call_dispatch=call_dispatch))
         py_method_dispatch.append(PY_VARIABLE_DISPATCH.substitute(env))
         return body
 
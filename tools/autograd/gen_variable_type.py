@@ -114,7 +114,8 @@ if (${cond}) {
 """)
 
 RECORD_FUNCTION = CodeTemplate("""\
-profiler::RecordFunction profiler("${name}");""")
+static const jit::Symbol profiler_name = jit::Symbol::aten("${name}");
+profiler::RecordFunction profiler(profiler_name);""")
 
 PRE_RECORD_TRACE = CodeTemplate("""\
 jit::tracer::PreTraceInfo trace_info;
@@ -403,7 +404,7 @@ def emit_body(declaration):
                 call = wrap_output(call)
         else:
             call = CALL_VIA_TYPE.substitute(declaration)
-        if not modifies_arguments:
+        if not modifies_arguments and declaration['return_type'] != 'void':
             call = '{} = {}'.format(tie_return_values(), call)
         return call + ';'
 
@@ -487,7 +488,8 @@ def emit_body(declaration):
     body.append(post_record_trace)
     if requires_derivative:
         body.append(emit_save_outputs())
-    body.append('return {};'.format(get_return_value()))
+    if declaration['return_type'] != 'void':
+        body.append('return {};'.format(get_return_value()))
     return body
 
 
@@ -137,6 +137,23 @@ Tensor sum_backward(const Tensor & grad, IntList sizes, int64_t dim, bool keepdi
   }
 }
 
+Tensor sum_backward(const Tensor & grad, IntList sizes, IntList dims, bool keepdim) {
+  if (!keepdim && sizes.size() > 0) {
+    std::vector<int64_t> wrapped;
+    for (auto dim : dims) {
+      wrapped.push_back(at::maybe_wrap_dim(dim, sizes.size()));
+    }
+    std::sort(wrapped.begin(), wrapped.end());
+    Tensor res = grad;
+    for (auto dim : wrapped) {
+      res = res.unsqueeze(dim);
+    }
+    return res.expand(sizes);
+  } else {
+    return grad.expand(sizes);
+  }
+}
+
 Tensor reverse_dim(const Tensor& t, int64_t dim) {
   Tensor index = at::arange(t.type().toScalarType(at::ScalarType::Long), t.size(dim) - 1, -1, -1);
   return t.index_select(dim, index);
@@ -621,6 +638,19 @@ Tensor glu_double_backward_grad_output(const Tensor & grad, const Tensor & input
   return tmp.narrow(dim, 0, sizes[dim]) + tmp.narrow(dim, sizes[dim], sizes[dim]);
 }
 
+Tensor cross_entropy_double_backward_grad_output(const Tensor & grad, const Tensor & self, const Tensor & target, const Tensor & logsumexp, double label_smoothing, int64_t ignore_index) {
+  auto d = _cross_entropy_backward(ones_like(target).toType(self.type()), self, target, logsumexp, label_smoothing, ignore_index);
+  return (grad * d).sum(1);
+}
+
+Tensor cross_entropy_double_backward(const Tensor & grad, const Tensor & grad_output, const Tensor & self, const Tensor & target, const Tensor & logsumexp, int64_t ignore_index) {
+  // The first backward is grad_output * (softmax(self) - q), and q does
+  // not depend on self, so this is the softmax double backward.
+  auto probs = (self - logsumexp.toType(self.type()).unsqueeze(1)).exp();
+  auto scale = (grad_output * target.ne(ignore_index).toType(self.type())).unsqueeze(1);
+  return scale * probs * (grad - (grad * probs).sum(1, true));
+}
+
 Tensor kl_div_double_backward_grad_output(const Tensor & grad, const Tensor & input, const Tensor & target, bool size_average, bool reduce) {
   auto result = kl_div_backward(grad, input, target, size_average, false);
   if (reduce && size_average) {
@@ -1164,6 +1194,92 @@ std::tuple<Tensor, Tensor, Tensor> batchnorm_double_backward(
 
 }
 
+// The gradients of _layer_norm_backward, seen as a function of the input,
+// gamma and gO. The M rows of N elements of the input are normalized as
+// xhat = (input - mean) * rstd, and h = gO * gamma is the gradient of xhat,
+// from which the first backward computes
+// gI = rstd * (h - mean(h) - xhat * mean(h * xhat)).
+std::tuple<Tensor, Tensor, Tensor> layer_norm_double_backward(
+    const Tensor & input_,
+    const Tensor & gamma,
+    const Tensor & ggI,
+    const Tensor & ggG,
+    const Tensor & ggB,
+    const Tensor & gO_,
+    const Tensor & save_mean,
+    const Tensor & save_rstd,
+    int64_t M,
+    int64_t N,
+    std::array<bool,3> output_mask) {
+
+  auto input = input_.contiguous().view({M, N});
+  auto gO = gO_.contiguous().view({M, N});
+  // the statistics are kept in the accumulation type of half inputs
+  auto mean = save_mean.type_as(input).view({M, 1});
+  auto rstd = save_rstd.type_as(input).view({M, 1});
+  auto xhat = (input - mean) * rstd;
+  auto gamma_row = gamma.defined() ? gamma.contiguous().view({1, N})
+                                   : input.type().tensor({}).fill_(1);
+  auto h = gO * gamma_row;
+
+  Tensor gI, gG, ggO;
+  // the gradient of the output of the first backward with respect to xhat,
+  // and the factor of xhat in its gradient through rstd
+  Tensor gxhat, grstd_term;
+  if (ggI.defined()) {
+    auto v = ggI.contiguous().view({M, N});
+    auto v_mean = v.mean(1, true);
+    auto vxhat_mean = (v * xhat).mean(1, true);
+    // the first backward applied to ggI instead of h
+    auto t = rstd * (v - v_mean - xhat * vxhat_mean);
+    ggO = t * gamma_row;
+    if (gamma.defined()) {
+      gG = (gO * t).sum(0);
+    }
+    if (output_mask[0]) {
+      auto h_mean = h.mean(1, true);
+      auto hxhat_mean = (h * xhat).mean(1, true);
+      gxhat = -rstd * (v * hxhat_mean + vxhat_mean * h);
+      grstd_term = rstd.pow(2) *
+          ((v * h).mean(1, true) - v_mean * h_mean - vxhat_mean * hxhat_mean);
+    }
+  }
+  if (ggG.defined()) {
+    auto ggG_row = ggG.contiguous().view({1, N});
+    auto ggO_G_term = ggG_row * xhat;
+    ggO = ggO.defined() ? ggO.add_(ggO_G_term) : ggO_G_term;
+    if (output_mask[0]) {
+      auto gxhat_G_term = gO * ggG_row;
+      gxhat = gxhat.defined() ? gxhat.add_(gxhat_G_term) : gxhat_G_term;
+    }
+  }
+  if (ggB.defined()) {
+    auto ggO_B_term = ggB.contiguous().view({1, N}).expand({M, N});
+    ggO = ggO.defined() ? ggO.add(ggO_B_term) : ggO_B_term;
+  }
+
+  // backpropagate gxhat through the normalization of the input
+  if (output_mask[0] && gxhat.defined()) {
+    gI = rstd * (gxhat - gxhat.mean(1, true) - xhat * (gxhat * xhat).mean(1, true));
+    if (grstd_term.defined()) {
+      gI = gI.sub_(grstd_term * xhat);
+    }
+  }
+
+  if (output_mask[0]) {
+    gI = gI.defined() ? gI.view(input_.sizes()) : at::zeros_like(input_);
+  }
+  if (output_mask[1]) {
+    AT_ASSERT(gamma.defined(), "gamma should always be defined when it requires grad");
+    gG = gG.defined() ? gG.view(gamma.sizes()) : at::zeros_like(gamma);
+  }
+  if (output_mask[2]) {
+    ggO = ggO.defined() ? ggO.contiguous().view(gO_.sizes()) : at::zeros_like(gO_);
+  }
+
+  return std::tuple<Tensor, Tensor, Tensor>{gI, gG, ggO};
+}
+
 } // anonymous namespace
 
 ${autograd_function_definitions}
@@ -277,12 +277,23 @@ static void check_no_requires_grad(const Tensor& tensor, const char* name) {
   }
 }
 
+static void check_no_requires_grad(TensorList tensors, const char* name) {
+  for (auto& tensor : tensors) {
+    check_no_requires_grad(tensor, name);
+  }
+}
+
 static void check_inplace(const Tensor& tensor) {
   auto& var = static_cast<const Variable&>(tensor);
   if (var.requires_grad() && var.is_leaf() && GradMode::is_enabled()) {
     AT_ERROR(
       "a leaf Variable that requires grad has been used in an in-place operation.");
   }
+  if (!var.type().is_sparse() && var.storage()->has_flag(Storage::READONLY)) {
+    AT_ERROR(
+      "a read-only tensor (e.g. one sharing the memory of a non-writeable "
+      "numpy array) has been used in an in-place operation.");
+  }
 }
 
 static void throw_error_out_requires_grad(const char* name) {
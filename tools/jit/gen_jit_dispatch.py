@@ -33,6 +33,12 @@ KW_ASSIGNMENT = CodeTemplate("""\
 auto ${name} = ${type_cast}(node->${method}(Symbol::attr("${name}")));\
 """)
 
+# IntList[N] arguments also accept a single int, which is what the script
+# compiler emits for a scalar constant
+INT_LIST_KW_ASSIGNMENT = CodeTemplate("""\
+auto ${name} = as_int_list(node, Symbol::attr("${name}"));\
+""")
+
 POS_ASSIGNMENT = CodeTemplate("""\
 auto ${name} = tensor_as<${type}>(std::move(peek(stack, ${i}, ${N})));\
 """)
@@ -130,6 +136,10 @@ def gen_jit_dispatch(declarations, out):
                                                    N=static_inputs)
                 pos_assignments.append(assign)
                 arguments.append(arg['name'])
+            elif arg['simple_type'] == 'IntList' and arg.get('size'):
+                kw_assignments.append(INT_LIST_KW_ASSIGNMENT.substitute(name=arg['name']))
+                attr_names.append(arg['name'])
+                arguments.append(arg['name'])
             else:
                 assign = KW_ASSIGNMENT.substitute(type_cast=TYPE_CASTS.get(arg['simple_type'], arg['simple_type']),
                                                   name=arg['name'],
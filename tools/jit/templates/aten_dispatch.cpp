@@ -65,6 +65,12 @@ void pack(Stack & stack, std::tuple<Args...> && t) {
   TuplePacker<sizeof...(Args), Args...>::execute(stack, std::move(t));
 }
 
+std::vector<int64_t> as_int_list(Node * node, Symbol name) {
+  if (node->kindOf(name) == AttributeKind::i)
+    return {node->i(name)};
+  return node->is(name);
+}
+
 int deviceForInputs(Stack & stack, size_t N) {
   if(N == 0)
     return -1;
@@ -156,7 +156,7 @@ def set_default_tensor_type(t):
     _C._set_default_tensor_type(t)
 
 from .random import set_rng_state, get_rng_state, manual_seed, initial_seed
-from .serialization import save, load
+from .serialization import save, load, save_tensors, load_tensors
 from ._tensor_str import set_printoptions
 
 ################################################################################
@@ -710,6 +710,35 @@ Example::
 
 """)
 
+add_docstr(torch.cdist,
+           r"""
+cdist(x1, x2, p=2) -> Tensor
+
+Computes the p-norm distance between every row of :attr:`x1` and every row
+of :attr:`x2`, without materializing their differences.
+
+For ``p = 2`` and large inputs the distances are computed as
+:math:`\sqrt{\|x_1\|^2 + \|x_2\|^2 - 2 x_1 x_2^T}`, with a matrix product.
+
+Args:
+    x1 (Tensor): input tensor of shape :math:`(N, D)`
+    x2 (Tensor): input tensor of shape :math:`(M, D)`
+    p (float, optional): the norm degree, in :math:`[0, \infty]`. Default: 2
+
+Returns:
+    the :math:`(N, M)` tensor of the distances
+
+Example::
+
+    >>> a = torch.tensor([[0., 0.], [1., 1.]])
+    >>> b = torch.tensor([[3., 4.]])
+    >>> torch.cdist(a, b)
+
+     5.0000
+     3.6056
+    [torch.FloatTensor of size (2,1)]
+""")
+
 add_docstr(torch.ceil,
            r"""
 ceil(input, out=None) -> Tensor
@@ -1761,6 +1790,10 @@ The returned tensor and `ndarray` share the same memory. Modifications to the
 tensor will be reflected in the `ndarray` and vice versa. The returned tensor
 is not resizable.
 
+Arrays with negative strides, or not in native byte order, are copied first;
+the tensor then shares the copy's memory. If `ndarray` is not writeable, the
+returned tensor is read-only: in-place operations on it raise an error.
+
 Example::
 
     >>> a = numpy.array([1, 2, 3])
@@ -4518,6 +4551,33 @@ set_num_threads(int)
 Sets the number of OpenMP threads used for parallelizing CPU operations
 """)
 
+add_docstr(torch.set_numa_policy,
+           r"""
+set_numa_policy(policy, node=None)
+
+Sets where the memory of large CPU tensors is placed on NUMA machines, on
+Linux.
+
+- ``'default'``: the pages go to the node of the thread that first writes
+  them.
+- ``'local'``: on the node of the allocating thread, given by :attr:`node`
+  for the calling thread, or by :func:`torch.bind_threads_to_numa_node`. A
+  :attr:`node` of ``-1`` means the node of the cpu the thread runs on.
+- ``'interleave'``: the pages are spread across all the nodes, which
+  balances the bandwidth of tensors used by every thread.
+
+Only allocations of 1MB or more are placed.
+""")
+
+add_docstr(torch.bind_threads_to_numa_node,
+           r"""
+bind_threads_to_numa_node(node)
+
+Binds the calling thread and the OpenMP threads parallelizing CPU operations
+to the cpus of a NUMA node, on Linux. The ``'local'`` policy of
+:func:`torch.set_numa_policy` then allocates on this node.
+""")
+
 add_docstr(torch.sigmoid,
            r"""
 sigmoid(input, out=None) -> Tensor
@@ -4879,16 +4939,17 @@ Example::
 .. function:: sum(input, dim, keepdim=False, out=None) -> Tensor
 
 Returns the sum of each row of the :attr:`input` tensor in the given
-dimension :attr:`dim`.
+dimension :attr:`dim`. If :attr:`dim` is a list of dimensions,
+reduce over all of them.
 
 If :attr:`keepdim` is ``True``, the output tensor is of the same size
-as :attr:`input` except in the dimension :attr:`dim` where it is of size 1.
+as :attr:`input` except in the dimension(s) :attr:`dim` where it is of size 1.
 Otherwise, :attr:`dim` is squeezed (see :func:`torch.squeeze`), resulting in
-the output tensor having 1 fewer dimension than :attr:`input`.
+the output tensor having 1 (or ``len(dim)``) fewer dimension(s).
 
 Args:
     input (Tensor): the input tensor
-    dim (int): the dimension to reduce
+    dim (int or tuple of ints): the dimension or dimensions to reduce
     keepdim (bool): whether the output tensor has :attr:`dim` retained or not
     out (Tensor, optional): the output tensor
 
@@ -4911,6 +4972,11 @@ Example::
      2.2440
     [torch.FloatTensor of size (4,)]
 
+    >>> torch.sum(a, (0, 1))
+
+     0.0245
+    [torch.FloatTensor of size ()]
+
 """)
 
 add_docstr(torch.svd,
@@ -11,6 +11,7 @@ from .variable import Variable
 from .function import Function, NestedIOFunction
 from .gradcheck import gradcheck
 from .grad_mode import no_grad, enable_grad, set_grad_enabled
+from .offload import offload_saved_tensors
 from . import profiler
 
 __all__ = ['Variable', 'Function', 'backward', 'grad_mode', 'variable']
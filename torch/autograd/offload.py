@@ -0,0 +1,43 @@
+import torch
+
+
+class offload_saved_tensors(object):
+    r"""Context-manager that keeps the large CUDA tensors saved for backward
+    in pinned host memory.
+
+    Every CUDA tensor of at least :attr:`min_bytes` bytes that an operation
+    saves for its backward while the context is active is copied to pinned
+    host memory on a side stream, and the device copy is released. When
+    backward runs, the engine starts copying the tensors of each function
+    back to the device while the functions before it run, so most of the
+    transfer overlaps with computation.
+
+    This trades PCIe bandwidth for device memory. It only pays off for
+    activations that are large compared to the work done between their use
+    in forward and backward.
+
+    Arguments:
+        enabled (bool, optional): Setting this to False makes this context
+            manager a no-op. Default: ``True``.
+        min_bytes (int, optional): smallest tensor that is offloaded.
+            Default: 1MB.
+
+    Example::
+
+        >>> with torch.autograd.offload_saved_tensors():
+        ...     loss = model(input).sum()
+        >>> loss.backward()
+    """
+
+    def __init__(self, enabled=True, min_bytes=1024 * 1024):
+        self.enabled = enabled
+        self.min_bytes = min_bytes
+
+    def __enter__(self):
+        self.prev = torch.autograd._get_offload_saved_tensors()
+        if self.enabled:
+            torch.autograd._set_offload_saved_tensors(True, self.min_bytes)
+
+    def __exit__(self, *args):
+        torch.autograd._set_offload_saved_tensors(*self.prev)
+        return False
@@ -142,6 +142,15 @@ class profile(object):
             Adds approximately 4us of overhead to each tensor operation.
             Default: ``False``
 
+        sample_period (int, optional): Only record one in every ``sample_period``
+            top-level ranges of each thread, together with everything nested in
+            it. Default: ``1`` (record everything)
+
+        buffer_size (int, optional): Only keep the last ``buffer_size`` ranges
+            recorded by each thread, in a preallocated buffer, so that the
+            profiler can stay enabled in long running jobs. ``0`` keeps all
+            of them. Default: ``0``
+
     .. warning:
         This context managers should not be called recursively, i.e. at most one
         instance should be enabled at any given time.
@@ -166,10 +175,13 @@ class profile(object):
         N5torch8autograd5CloneE                        4.088us          0.000us
     """
 
-    def __init__(self, enabled=True, use_cuda=False):
+    def __init__(self, enabled=True, use_cuda=False, sample_period=1, buffer_size=0):
         self.enabled = enabled
         self.use_cuda = use_cuda
+        self.sample_period = sample_period
+        self.buffer_size = buffer_size
         self.function_events = None
+        self.records = None
         if not self.enabled:
             return
         self.entered = False
@@ -182,14 +194,14 @@ class profile(object):
         self.entered = True
         profiler_kind = torch.autograd.ProfilerState.CUDA if self.use_cuda \
             else torch.autograd.ProfilerState.CPU
-        torch.autograd._enable_profiler(profiler_kind)
+        torch.autograd._enable_profiler(profiler_kind, self.sample_period, self.buffer_size)
         return self
 
     def __exit__(self, exc_type, exc_val, exc_tb):
         if not self.enabled:
             return
-        records = torch.autograd._disable_profiler()
-        self.function_events = EventList(parse_cpu_trace(records))
+        self.records = torch.autograd._disable_profiler()
+        self.function_events = EventList(parse_cpu_trace(self.records))
         return False
 
     def __repr__(self):
@@ -213,9 +225,23 @@ class profile(object):
 
     def export_chrome_trace(self, path):
         self._check_finish()
-        return self.function_events.export_chrome_trace(path)
+        # written straight from the raw records, which is much faster than
+        # going through the EventList for large traces
+        return torch.autograd._export_chrome_trace(self.records, path)
     export_chrome_trace.__doc__ = EventList.export_chrome_trace.__doc__
 
+    def op_stats(self):
+        """Returns per-op totals computed in C++ from the raw records.
+
+        Each entry has ``name``, ``count``, ``cpu_total_us``, ``cpu_min_us``,
+        ``cpu_max_us``, ``cuda_total_us`` and ``cpu_histogram``, where
+        ``cpu_histogram[i]`` counts the calls that took between ``2 ** (i - 1)``
+        and ``2 ** i`` microseconds. Entries are sorted by decreasing
+        ``cpu_total_us``.
+        """
+        self._check_finish()
+        return torch.autograd._aggregate_profile(self.records)
+
     def key_averages(self):
         self._check_finish()
         return self.function_events.key_averages()
@@ -444,6 +470,9 @@ def parse_cpu_trace(thread_records):
             record_stack.append((next_id, record))
             next_id += 1
         elif record.kind() == 'pop':
+            # With a bounded buffer the push may have been overwritten
+            if not record_stack or record_stack[-1][1].thread_id() != record.thread_id():
+                continue
             function_id, start = record_stack.pop()
             fe = FunctionEvent(
                 id=function_id,
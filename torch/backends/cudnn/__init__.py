@@ -166,6 +166,91 @@ def flags(enabled=False, benchmark=False, deterministic=False, verbose=False):
             set_flags(orig_flags[0], orig_flags[1], orig_flags[2], orig_flags[3])
 
 
+def set_workspace_limit(limit):
+    r"""Limits the workspace of the cuDNN convolution algorithms.
+
+    cuDNN calls borrow their workspace from a buffer kept for each device and
+    stream, which grows to the largest workspace asked for and is only freed
+    by :func:`torch.cuda.empty_cache`. The algorithms needing more than
+    ``limit`` bytes aren't benchmarked or picked, and the convolutions fall
+    back to their default algorithms when nothing faster fits. The limit can
+    also be set in megabytes with ``TORCH_CUDNN_WORKSPACE_LIMIT_MB``.
+
+    Arguments:
+        limit (int or None): the largest workspace in bytes, or ``None`` for
+            no limit (default)
+    """
+    torch._C._cudnn_set_workspace_limit(limit)
+
+
+def workspace_limit():
+    r"""Returns the limit set by :func:`set_workspace_limit`, in bytes, or
+    ``None`` if there is none."""
+    return torch._C._cudnn_get_workspace_limit()
+
+
+def set_rnn_algo(algo):
+    r"""Sets how the cuDNN RNNs pick their algorithm.
+
+    Persistent kernels (``CUDNN_RNN_ALGO_PERSIST_STATIC``) keep the recurrent
+    weights on chip for the whole sequence, which is several times faster
+    than the standard algorithm for small batches and hidden sizes. They
+    need a device of compute capability 6.0 or higher, and packed sequences
+    always use the standard algorithm. The algorithm can also be set with
+    ``TORCH_CUDNN_RNN_ALGO``.
+
+    The backward of an RNN has to use the algorithm of its forward, so don't
+    change it between the two.
+
+    Arguments:
+        algo (str): ``'auto'`` to use persistent kernels where they are
+            expected to be faster (default), ``'standard'`` to never use
+            them, or ``'persist_static'`` to always use them when supported
+    """
+    torch._C._cudnn_set_rnn_algo(algo)
+
+
+def rnn_algo():
+    r"""Returns the RNN algorithm setting set by :func:`set_rnn_algo`."""
+    return torch._C._cudnn_get_rnn_algo()
+
+
+def save_benchmark_cache(path):
+    r"""Saves the convolution algorithms picked so far to a file.
+
+    With ``torch.backends.cudnn.benchmark = True``, the first convolution of
+    every shape benchmarks all the cuDNN algorithms to pick the fastest one.
+    A file saved by this function can be loaded with
+    :func:`load_benchmark_cache` by other processes, so that they skip these
+    benchmarks. The file is replaced atomically, so that processes loading
+    it at the same time never read a partial file.
+
+    The algorithms are tagged with the cuDNN version and the name of the
+    current GPU, and are only loaded with the same ones.
+
+    Arguments:
+        path (str): the file to write
+    """
+    torch._C._cudnn_save_benchmark_cache(path)
+
+
+def load_benchmark_cache(path):
+    r"""Loads the convolution algorithms saved by :func:`save_benchmark_cache`.
+
+    The convolutions with the same parameters use these algorithms instead
+    of picking theirs, whether ``torch.backends.cudnn.benchmark`` is set or
+    not. A file saved with another cuDNN version or GPU model loads nothing.
+
+    Arguments:
+        path (str): the file to read
+
+    Returns:
+        the number of algorithms loaded
+    """
+    torch.cuda._lazy_init()
+    return torch._C._cudnn_load_benchmark_cache(path)
+
+
 class CuDNNHandle:
     def __init__(self):
         ptr = ctypes.c_void_p()
@@ -1,5 +1,15 @@
 #include "DataLoader.h"
 
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "torch/csrc/Exceptions.h"
+#include "torch/csrc/autograd/python_variable.h"
+#include "torch/csrc/utils/auto_gil.h"
+#include "torch/csrc/utils/object_ptr.h"
+
 // In cases like DataLoader, if a worker process die due to bus error/segfault
 // or just hang, the main process, if implemented with
 // multiprocessing.queue.SimpleQueue, will hang waiting for data. This is
@@ -207,10 +217,99 @@ static PyObject *THPModule_errorIfAnyWorkerFails(PyObject *module, PyObject *_ig
 
 #endif
 
+// Copies the samples into the rows of `out`, which the caller allocated, in
+// shared memory if needed, on several threads and without the GIL. The
+// threads only share the work when there is enough data to copy.
+// Python handle is _collate_into(out, samples).
+static const size_t kCollateBytesPerThread = 1 << 20;
+
+static PyObject *THPModule_collateInto(PyObject *module, PyObject *args) {
+  HANDLE_TH_ERRORS
+
+  if (PyTuple_GET_SIZE(args) != 2) {
+    throw TypeError("_collate_into expects exactly 2 arguments.");
+  }
+  PyObject *out_obj = PyTuple_GET_ITEM(args, 0);
+  PyObject *samples_obj = PyTuple_GET_ITEM(args, 1);
+  if (!THPVariable_Check(out_obj)) {
+    throw TypeError("_collate_into expects a tensor for out, but got %s.",
+        Py_TYPE(out_obj)->tp_name);
+  }
+  if (!PySequence_Check(samples_obj)) {
+    throw TypeError("_collate_into expects a sequence of tensors for samples, but got %s.",
+        Py_TYPE(samples_obj)->tp_name);
+  }
+
+  at::Tensor out = THPVariable_UnpackData(out_obj);
+  Py_ssize_t num_samples = PySequence_Size(samples_obj);
+  if (num_samples < 0) {
+    throw python_error();
+  }
+  if (out.type().is_cuda() || out.dim() == 0 || out.size(0) != num_samples) {
+    throw ValueError("_collate_into expects a CPU tensor with one row per sample for out.");
+  }
+  std::vector<at::Tensor> samples;
+  samples.reserve(num_samples);
+  for (Py_ssize_t i = 0; i < num_samples; i++) {
+    THPObjectPtr item(PySequence_GetItem(samples_obj, i));
+    if (!item) {
+      throw python_error();
+    }
+    if (!THPVariable_Check(item.get())) {
+      throw TypeError("_collate_into expects a sequence of tensors for samples, but "
+          "sample %d is %s.", (int)i, Py_TYPE(item.get())->tp_name);
+    }
+    at::Tensor sample = THPVariable_UnpackData(item.get());
+    if (sample.type() != out.type() || !sample.sizes().equals(out[0].sizes())) {
+      throw ValueError("_collate_into expects all the samples to have the type and "
+          "the size of a row of out, but sample %d doesn't.", (int)i);
+    }
+    samples.push_back(sample);
+  }
+  if (num_samples == 0) {
+    Py_RETURN_NONE;
+  }
+
+  size_t total_bytes = out.numel() * out.type().elementSizeInBytes();
+  size_t num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  num_threads = std::min(num_threads, (size_t)num_samples);
+  num_threads = std::min(num_threads, std::max<size_t>(total_bytes / kCollateBytesPerThread, 1));
+
+  with_no_gil([&] {
+    std::vector<std::exception_ptr> errors(num_threads);
+    auto copy_rows = [&](size_t thread_id) {
+      try {
+        for (size_t i = thread_id; i < samples.size(); i += num_threads) {
+          out[i].copy_(samples[i]);
+        }
+      } catch (...) {
+        errors[thread_id] = std::current_exception();
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; t++) {
+      threads.emplace_back(copy_rows, t);
+    }
+    copy_rows(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  });
+
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyMethodDef DataLoaderMethods[] = {
   {"_set_worker_signal_handlers",  (PyCFunction)THPModule_setWorkerSignalHandlers,  METH_NOARGS,   NULL},
   {"_update_worker_pids",          (PyCFunction)THPModule_updateWorkerPIDs,         METH_VARARGS,  NULL},
   {"_remove_worker_pids",          (PyCFunction)THPModule_removeWorkerPIDs,         METH_O,        NULL},
   {"_error_if_any_worker_fails",   (PyCFunction)THPModule_errorIfAnyWorkerFails,    METH_NOARGS,   NULL},
+  {"_collate_into",                (PyCFunction)THPModule_collateInto,              METH_VARARGS,  NULL},
   {NULL, NULL, 0, NULL}
 };
@@ -29,6 +29,7 @@
 #include "torch/csrc/tensor/python_tensor.h"
 #include "torch/csrc/utils/tensor_dtypes.h"
 #include "torch/csrc/utils/python_strings.h"
+#include "torch/csrc/utils/tensor_archive.h"
 #include "torch/csrc/utils/tensor_layouts.h"
 #include "torch/csrc/utils/tensor_numpy.h"
 #include "torch/csrc/jit/python_tracer.h"
@@ -37,6 +38,9 @@
 
 #ifdef WITH_CUDNN
 #include "cudnn.h"
+#include <ATen/cudnn/BenchmarkCache.h>
+#include <ATen/cudnn/RNNAlgo.h>
+#include <ATen/cudnn/Workspace.h>
 #endif
 
 #define WITH_NUMPY_IMPORT_ARRAY
@@ -120,6 +124,118 @@ static PyObject * THPModule_setNumThreads(PyObject *module, PyObject *arg)
   Py_RETURN_NONE;
 }
 
+static PyObject * THPModule_setNumaPolicy(PyObject *module, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  const char *policy_name;
+  PyObject *node = Py_None;
+  if (!PyArg_ParseTuple(args, "s|O", &policy_name, &node)) {
+    return NULL;
+  }
+  THPUtils_assert(node == Py_None || THPUtils_checkLong(node), "set_numa_policy "
+          "expects an int for node, but got %s", THPUtils_typename(node));
+  std::string name(policy_name);
+  int policy;
+  if (name == "default") {
+    policy = TH_NUMA_DEFAULT;
+  } else if (name == "local") {
+    policy = TH_NUMA_LOCAL;
+  } else if (name == "interleave") {
+    policy = TH_NUMA_INTERLEAVE;
+  } else {
+    THPUtils_setError("set_numa_policy expects 'default', 'local' or "
+        "'interleave', but got '%s'", policy_name);
+    return NULL;
+  }
+  THSetNumaPolicy(policy);
+  if (node != Py_None) {
+    THSetNumaNode((int)THPUtils_unpackLong(node));
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_bindThreadsToNumaNode(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "bind_threads_to_numa_node expects "
+          "an int, but got %s", THPUtils_typename(arg));
+  THBindThreadsToNumaNode((int)THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+// Python handle is _save_tensor_archive(path, [(name, tensor), ...])
+static PyObject * THPModule_saveTensorArchive(PyObject *module, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  PyObject *path, *items;
+  if (!PyArg_ParseTuple(args, "OO", &path, &items)) {
+    return NULL;
+  }
+  THPUtils_assert(THPUtils_checkString(path), "_save_tensor_archive expects a "
+          "string path, but got %s", THPUtils_typename(path));
+  THPUtils_assert(PyList_Check(items), "_save_tensor_archive expects a list of "
+          "(name, tensor) tuples, but got %s", THPUtils_typename(items));
+  torch::utils::NamedTensors tensors;
+  for (Py_ssize_t i = 0; i < PyList_GET_SIZE(items); i++) {
+    PyObject *item = PyList_GET_ITEM(items, i);
+    THPUtils_assert(PyTuple_Check(item) && PyTuple_GET_SIZE(item) == 2 &&
+            THPUtils_checkString(PyTuple_GET_ITEM(item, 0)) &&
+            THPVariable_Check(PyTuple_GET_ITEM(item, 1)),
+            "_save_tensor_archive expects a list of (name, tensor) tuples");
+    tensors.emplace_back(THPUtils_unpackString(PyTuple_GET_ITEM(item, 0)),
+                         THPVariable_UnpackData(PyTuple_GET_ITEM(item, 1)));
+  }
+  std::string filename = THPUtils_unpackString(path);
+  with_no_gil([&] {
+    torch::utils::save_tensor_archive(filename, tensors);
+  });
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+// Python handle is _load_tensor_archive(path, mmap), returns a list of
+// (name, tensor) tuples
+static PyObject * THPModule_loadTensorArchive(PyObject *module, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  PyObject *path, *mmap;
+  if (!PyArg_ParseTuple(args, "OO", &path, &mmap)) {
+    return NULL;
+  }
+  THPUtils_assert(THPUtils_checkString(path), "_load_tensor_archive expects a "
+          "string path, but got %s", THPUtils_typename(path));
+  std::string filename = THPUtils_unpackString(path);
+  bool use_mmap = PyObject_IsTrue(mmap);
+  torch::utils::NamedTensors tensors;
+  with_no_gil([&] {
+    tensors = torch::utils::load_tensor_archive(filename, use_mmap);
+  });
+  THPObjectPtr result(PyList_New(tensors.size()));
+  if (!result) return NULL;
+  for (size_t i = 0; i < tensors.size(); i++) {
+    THPObjectPtr name(THPUtils_packString(tensors[i].first));
+    if (!name) return NULL;
+    PyObject *tensor = THPVariable_Wrap(torch::autograd::make_variable(tensors[i].second));
+    if (!tensor) return NULL;
+    PyList_SET_ITEM(result.get(), i, PyTuple_Pack(2, name.get(), tensor));
+    Py_DECREF(tensor);
+  }
+  return result.release();
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_setShmPoolSize(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "_set_shm_pool_size expects an int, "
+          "but got %s", THPUtils_typename(arg));
+  libshm_set_pool_size((ptrdiff_t)THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THPModule_setDefaultTensorType(PyObject *_unused, PyObject *type)
 {
   HANDLE_TH_ERRORS
@@ -240,19 +356,40 @@ PyObject *THPModule_hasDistributed(PyObject *_unused)
 #endif
 }
 
-PyObject *THPModule_toDLPack(PyObject *_unused, PyObject *data)
+// The optional stream argument of _to_dlpack and _from_dlpack is the
+// cudaStream_t of the consumer, or of the producer, as an integer
+PyObject *THPModule_toDLPack(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
+  PyObject *data = nullptr;
+  PyObject *stream = nullptr;
+  if (!PyArg_ParseTuple(args, "O|O", &data, &stream)) {
+    return NULL;
+  }
   THPUtils_assert(THPVariable_Check(data), "data must be a Tensor");
-  DLManagedTensor* dlMTensor = at::toDLPack(THPVariable_UnpackData(data));
+  auto& tensor = THPVariable_UnpackData(data);
+  DLManagedTensor* dlMTensor;
+  if (stream && stream != Py_None) {
+    THPUtils_assert(THPUtils_checkLong(stream), "stream must be an int");
+    dlMTensor = at::toDLPack(tensor, (cudaStream_t)(uintptr_t)THPUtils_unpackLong(stream));
+  } else {
+    dlMTensor = at::toDLPack(tensor);
+  }
   return PyCapsule_New(dlMTensor, "dltensor", NULL);
   END_HANDLE_TH_ERRORS
 }
 
-PyObject *THPModule_fromDLPack(PyObject *_unused, PyObject *data)
+PyObject *THPModule_fromDLPack(PyObject *_unused, PyObject *args)
 {
   using namespace torch::autograd;
   HANDLE_TH_ERRORS
+  PyObject *data = nullptr;
+  PyObject *stream = nullptr;
+  if (!PyArg_ParseTuple(args, "O|O", &data, &stream)) {
+    return NULL;
+  }
+  THPUtils_assert(!stream || stream == Py_None || THPUtils_checkLong(stream),
+    "stream must be an int");
   DLManagedTensor * dlMTensor = (DLManagedTensor *)PyCapsule_GetPointer(data, "dltensor");
   THPUtils_assert(dlMTensor, "from_dlpack received an invalid capsule. "
     "Note that DLTensor capsules can be consumed only once, "
@@ -260,7 +397,9 @@ PyObject *THPModule_fromDLPack(PyObject *_unused, PyObject *data)
   // atensor steals the ownership of the underlying storage. It also passes a
   // destructor function that will be called when the underlying storage goes
   // out of scope. When the destructor is called, the dlMTensor is destructed too.
-  auto atensor = make_variable(at::fromDLPack(dlMTensor), false);
+  auto atensor = make_variable(stream && stream != Py_None ?
+      at::fromDLPack(dlMTensor, (cudaStream_t)(uintptr_t)THPUtils_unpackLong(stream)) :
+      at::fromDLPack(dlMTensor), false);
 
   // It is possible that the call to at::fromDLPack is the very first
   // call to create a Tensor in PyTorch. If so, then _lazy_init has
@@ -347,20 +486,25 @@ static PyMethodDef TorchMethods[] = {
   {"_safe_call",      (PyCFunction)THPModule_safeCall,          METH_VARARGS | METH_KEYWORDS, NULL},
   {"_set_default_tensor_type", (PyCFunction)THPModule_setDefaultTensorType, METH_O, NULL},
   {"_infer_size",     (PyCFunction)THPModule_inferSize,         METH_VARARGS, NULL},
+  {"_set_shm_pool_size", (PyCFunction)THPModule_setShmPoolSize, METH_O,     NULL},
   {"_set_backcompat_broadcast_warn", (PyCFunction)THPModule_setBackcompatBroadcastWarn, METH_O, NULL},
   {"_get_backcompat_broadcast_warn", (PyCFunction)THPModule_getBackcompatBroadcastWarn, METH_NOARGS, NULL},
   {"_set_backcompat_keepdim_warn", (PyCFunction)THPModule_setBackcompatKeepdimWarn, METH_O, NULL},
   {"_get_backcompat_keepdim_warn", (PyCFunction)THPModule_getBackcompatKeepdimWarn, METH_NOARGS, NULL},
   {"get_num_threads", (PyCFunction)THPModule_getNumThreads,     METH_NOARGS,  NULL},
   {"set_num_threads", (PyCFunction)THPModule_setNumThreads,     METH_O,       NULL},
+  {"set_numa_policy", (PyCFunction)THPModule_setNumaPolicy,     METH_VARARGS, NULL},
+  {"_save_tensor_archive", (PyCFunction)THPModule_saveTensorArchive, METH_VARARGS, NULL},
+  {"_load_tensor_archive", (PyCFunction)THPModule_loadTensorArchive, METH_VARARGS, NULL},
+  {"bind_threads_to_numa_node", (PyCFunction)THPModule_bindThreadsToNumaNode, METH_O, NULL},
   {"_get_cudnn_enabled", (PyCFunction)THPModule_userEnabledCuDNN, METH_NOARGS,     NULL},
   {"_set_cudnn_enabled", (PyCFunction)THPModule_setUserEnabledCuDNN, METH_O,  NULL},
   {"_get_cudnn_benchmark", (PyCFunction)THPModule_benchmarkCuDNN, METH_NOARGS,     NULL},
   {"_set_cudnn_benchmark", (PyCFunction)THPModule_setBenchmarkCuDNN, METH_O,  NULL},
   {"_get_cudnn_deterministic", (PyCFunction)THPModule_deterministicCuDNN, METH_NOARGS,     NULL},
   {"_set_cudnn_deterministic", (PyCFunction)THPModule_setDeterministicCuDNN, METH_O,  NULL},
-  {"_to_dlpack",      (PyCFunction)THPModule_toDLPack,          METH_O,       NULL},
-  {"_from_dlpack",    (PyCFunction)THPModule_fromDLPack,        METH_O,       NULL},
+  {"_to_dlpack",      (PyCFunction)THPModule_toDLPack,          METH_VARARGS, NULL},
+  {"_from_dlpack",    (PyCFunction)THPModule_fromDLPack,        METH_VARARGS, NULL},
   {"set_flush_denormal", (PyCFunction)THPModule_setFlushDenormal, METH_O,     NULL},
   {"get_default_dtype", (PyCFunction)THPModule_getDefaultDtype, METH_NOARGS,  NULL},
   {NULL, NULL, 0, NULL}
@@ -417,8 +561,80 @@ static PyObject * THCUDNN_cudnn_version(PyObject *self, PyObject *args)
   return PyLong_FromLong(CUDNN_VERSION);
 }
 
+static PyObject * THCUDNN_save_benchmark_cache(PyObject *self, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkString(arg), "_cudnn_save_benchmark_cache expects a "
+          "path, but got %s", THPUtils_typename(arg));
+  std::string path = THPUtils_unpackString(arg);
+  at::native::cudnn_save_benchmark_cache(path);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THCUDNN_load_benchmark_cache(PyObject *self, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkString(arg), "_cudnn_load_benchmark_cache expects a "
+          "path, but got %s", THPUtils_typename(arg));
+  std::string path = THPUtils_unpackString(arg);
+  return PyLong_FromLongLong(at::native::cudnn_load_benchmark_cache(path));
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THCUDNN_get_workspace_limit(PyObject *self)
+{
+  HANDLE_TH_ERRORS
+  size_t limit = at::native::getCudnnWorkspaceLimit();
+  if (limit == SIZE_MAX) {
+    Py_RETURN_NONE;
+  }
+  return PyLong_FromSize_t(limit);
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THCUDNN_set_workspace_limit(PyObject *self, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  if (arg == Py_None) {
+    at::native::setCudnnWorkspaceLimit(SIZE_MAX);
+    Py_RETURN_NONE;
+  }
+  THPUtils_assert(THPUtils_checkLong(arg), "_cudnn_set_workspace_limit expects an int "
+          "or None, but got %s", THPUtils_typename(arg));
+  int64_t limit = THPUtils_unpackLong(arg);
+  THPUtils_assert(limit >= 0, "the cuDNN workspace limit should be non-negative, but got %lld",
+          (long long)limit);
+  at::native::setCudnnWorkspaceLimit((size_t)limit);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THCUDNN_get_rnn_algo(PyObject *self)
+{
+  HANDLE_TH_ERRORS
+  return THPUtils_packString(at::native::getCudnnRNNAlgo());
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THCUDNN_set_rnn_algo(PyObject *self, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkString(arg), "_cudnn_set_rnn_algo expects a string, "
+          "but got %s", THPUtils_typename(arg));
+  at::native::setCudnnRNNAlgo(THPUtils_unpackString(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 static PyMethodDef _THCUDNN_methods[] = {
   {"_cudnn_version", (PyCFunction)THCUDNN_cudnn_version, METH_VARARGS, NULL},
+  {"_cudnn_save_benchmark_cache", (PyCFunction)THCUDNN_save_benchmark_cache, METH_O, NULL},
+  {"_cudnn_load_benchmark_cache", (PyCFunction)THCUDNN_load_benchmark_cache, METH_O, NULL},
+  {"_cudnn_get_workspace_limit", (PyCFunction)THCUDNN_get_workspace_limit, METH_NOARGS, NULL},
+  {"_cudnn_set_workspace_limit", (PyCFunction)THCUDNN_set_workspace_limit, METH_O, NULL},
+  {"_cudnn_get_rnn_algo", (PyCFunction)THCUDNN_get_rnn_algo, METH_NOARGS, NULL},
+  {"_cudnn_set_rnn_algo", (PyCFunction)THCUDNN_set_rnn_algo, METH_O, NULL},
   {NULL}
 };
 
@@ -47,6 +47,24 @@ static void free_wrapper(void *ctx, void *ptr) {
   ((T*)ctx)->free(ptr);
 }
 
+static void * borrowed_malloc(void *ctx, ptrdiff_t size) {
+  THError("can't allocate memory for a storage viewing the memory of another object");
+  return nullptr;
+}
+
+static void * borrowed_realloc(void *ctx, void *ptr, ptrdiff_t size) {
+  THError("can't resize a storage viewing the memory of another object");
+  return nullptr;
+}
+
+static void borrowed_free(void *ctx, void *ptr) {}
+
+THAllocator THBorrowedAllocator = {
+  borrowed_malloc,
+  borrowed_realloc,
+  borrowed_free,
+};
+
 THAllocator THObjectPtrAllocator = {
   malloc_wrapper<ObjectPtrAllocator>,
   realloc_wrapper<ObjectPtrAllocator>,
@@ -61,6 +61,9 @@ public:
 };
 #endif
 
+// Never frees: for memory owned by the object wrapped by an
+// ObjectPtrAllocator.
+extern THAllocator THBorrowedAllocator;
 extern THAllocator THObjectPtrAllocator;
 extern THAllocator THStorageWeakRefAllocator;
 #ifdef WITH_CUDA
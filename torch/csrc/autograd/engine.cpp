@@ -3,12 +3,18 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/functions/basic_ops.h"
 #include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/saved_variable.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/utils/auto_gpu.h"
+#include "torch/csrc/utils/auto_stream.h"
 
+#include "caffe2/core/static_tracepoint.h"
+
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -25,6 +31,7 @@
 #ifdef WITH_CUDA
 #include <cuda.h>
 #include <THC/THC.h>
+#include <THC/THCCachingAllocator.h>
 #endif
 
 namespace torch { namespace autograd {
@@ -38,6 +45,14 @@ static constexpr int NO_DEVICE = -2;
 // handling reentrant backwards calls; see Note [Reentrant backwards]
 static thread_local int worker_device = NO_DEVICE;
 
+// Index of the CPU worker running on this thread (only meaningful when
+// worker_device == -1). See Note [CPU work stealing]
+static thread_local std::size_t cpu_worker_index = 0;
+
+// Index of the engine stream the function evaluated on this thread runs on,
+// or -1 for the current stream of the thread. See Note [Backward CUDA streams]
+static thread_local int worker_stream = -1;
+
 // XXX: Changes to the way multithreading works in execute should be done with
 // great care. Right now the implementation guarantees that a single function's
 // apply will never be entered concurrently (even if multiple graphs are
@@ -52,6 +67,12 @@ struct FunctionTask {
   // gradients flowing here.  Once all the dependencies are finished, we
   // use the contents of this buffer to run the function.
   InputBuffer inputs;
+  // The engine stream to run on, or -1 to pick one when the task is popped,
+  // and the engine stream that wrote the inputs last, or -1 when they were
+  // written on the current stream of a thread.
+  // See Note [Backward CUDA streams]
+  int stream = -1;
+  int wait_stream = -1;
 
   FunctionTask(GraphTask* base, std::shared_ptr<Function> fn, InputBuffer inputs)
     : base(base)
@@ -59,8 +80,12 @@ struct FunctionTask {
     , inputs(std::move(inputs)) {}
 };
 
+// Dummy tasks (the ones with fn == nullptr, used to wake up the owner of a
+// reentrant GraphTask) are always ordered first.
 struct CompareFunctionTaskTime {
   bool operator()(FunctionTask const & t1, FunctionTask const & t2) {
+    if (!t1.fn) return false;
+    if (!t2.fn) return true;
     return t1.fn->sequence_nr() < t2.fn->sequence_nr();
   }
 };
@@ -69,11 +94,99 @@ struct ReadyQueue {
   std::priority_queue<FunctionTask, std::vector<FunctionTask>, CompareFunctionTaskTime> heap;
   std::condition_variable not_empty;
   std::mutex mutex;
+  // Set for the CPU queues when there is more than one CPU worker.
+  // See Note [CPU work stealing]
+  WorkStealingGroup* group = nullptr;
+  std::size_t index = 0;
+#ifdef WITH_CUDA
+  // Used by the GPU workers, and only touched by the thread of the queue.
+  // See Note [Backward CUDA streams]
+  std::vector<THCStream*> streams;
+  std::size_t next_stream = 0;
+#endif
 
   void push(FunctionTask item);
   FunctionTask pop();
+  bool try_pop(FunctionTask& task, bool steal, bool blocking);
+};
+
+// Note [CPU work stealing]
+// ~~~~~~~~~~~~~~~~~~~~~~~~
+// By default all CPU work is processed by a single worker thread. When
+// TORCH_AUTOGRAD_CPU_WORKERS is set to N > 1 the engine starts N CPU workers,
+// each owning its own ReadyQueue:
+//
+//  - Tasks produced by a CPU worker are pushed to its own queue, so that
+//    chains of functions stay on the same thread.  Tasks produced by other
+//    threads (the caller of execute() or a GPU worker) are distributed
+//    round-robin.
+//
+//  - A worker pops from its own queue first, and when it is empty it steals
+//    the highest priority task of another worker's queue.  Since every queue
+//    is still a heap ordered by sequence_nr, the usual ordering is kept as a
+//    best-effort priority.  Dummy tasks are never stolen, because they are
+//    meant to wake up a particular worker (see Note [Reentrant backwards]).
+//
+//  - Idle workers sleep on a single condition variable of the group.  The
+//    pusher only takes the group lock when somebody is actually sleeping, so
+//    in the steady state the only contended locks are the per-worker queue
+//    locks.
+//
+// Several CPU workers break the guarantee that a function's apply is never
+// entered concurrently (see the XXX note above), so in this mode functions
+// evaluated on the CPU are serialized through a small table of striped
+// locks keyed by the Function pointer.
+struct WorkStealingGroup {
+  std::vector<ReadyQueue*> queues;
+  // Number of workers that are about to sleep or are sleeping on not_empty
+  std::atomic<int> num_idle;
+  // Bumped (under mutex) every time a task is pushed while somebody is idle
+  uint64_t epoch;
+  std::mutex mutex;
+  std::condition_variable not_empty;
+
+  WorkStealingGroup() : num_idle(0), epoch(0) {}
+
+  void notify(bool all);
+  FunctionTask pop(std::size_t own);
 };
 
+static constexpr std::size_t NUM_FUNCTION_LOCKS = 64;
+static std::recursive_mutex function_locks[NUM_FUNCTION_LOCKS];
+
+static std::recursive_mutex& function_lock(Function* fn) {
+  auto key = reinterpret_cast<std::uintptr_t>(fn);
+  return function_locks[(key >> 4) % NUM_FUNCTION_LOCKS];
+}
+
+// Note [Backward CUDA streams]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The worker of a device normally issues every function on its current
+// stream, so independent branches of the graph are serialized on the GPU.
+// When TORCH_AUTOGRAD_CUDA_STREAMS is set to N > 1 each GPU worker creates N
+// streams and runs every function on one of them. There is still one thread
+// per device, only the kernels it launches can overlap.
+//
+//  - A function keeps running on the stream of the function that made it
+//    ready, so chains don't need any synchronization.  The other functions
+//    made ready by the same function are spread round-robin.
+//
+//  - GraphTask::buffer_streams remembers the stream that wrote an input
+//    buffer last.  A function adding to a buffer last written on another
+//    stream first makes its stream wait for that one (with an event), so the
+//    last writer is always ordered after all the previous ones, and the
+//    consumer only has to wait for the last writer.
+//
+//  - The caching allocator gives every stream its own pool, so the inputs
+//    of a function are recorded on its stream before it runs.  They can be
+//    freed as soon as it returns, and the block must not be reused before
+//    the kernels reading it are done.
+//
+// The streams are blocking, so the work issued on the legacy default stream
+// (by the user, the CPU workers or the rest of the program) and the engine
+// streams are ordered with respect to each other, and -1 ("the current
+// stream of the thread") never needs an explicit wait.
+
 // Note [Reentrant backwards]
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~
 // To understand the reentrant backwards problem, we have to notice two
@@ -127,6 +240,9 @@ struct GraphTask {
   std::condition_variable not_done;
   std::unordered_map<Function*, InputBuffer> not_ready;
   std::unordered_map<Function*, int> dependencies;
+  // The engine stream that wrote each buffer of not_ready last, for the ones
+  // written on an engine stream. See Note [Backward CUDA streams]
+  std::unordered_map<Function*, int> buffer_streams;
 
   struct ExecInfo {
     struct Capture {
@@ -154,6 +270,9 @@ struct GraphTask {
   // The value of worker_device in the thread that created this task.
   // See Note [Reentrant backwards]
   int owner;
+  // The value of cpu_worker_index in the thread that created this task.
+  // See Note [CPU work stealing]
+  std::size_t owner_worker;
 
   GraphTask(bool keep_graph, bool grad_mode)
     : exception()
@@ -165,26 +284,171 @@ struct GraphTask {
     , not_done()
     , not_ready()
     , dependencies()
-    , owner(NO_DEVICE) {}
+    , owner(NO_DEVICE)
+    , owner_worker(0) {}
 };
 
 auto ReadyQueue::push(FunctionTask item) -> void {
+  bool is_dummy = !item.fn;
   {
     std::lock_guard<std::mutex> lock(mutex);
     ++item.base->outstanding_tasks;
+    CAFFE_SDT(autograd_ready_queue_push, this, item.fn.get(), heap.size());
     heap.push(std::move(item));
   }
-  not_empty.notify_one();
+  if (group) {
+    // Dummy tasks can only be processed by the worker owning this queue, so
+    // we can't just wake up any of the sleeping workers.
+    group->notify(is_dummy);
+  } else {
+    not_empty.notify_one();
+  }
 }
 
 auto ReadyQueue::pop() -> FunctionTask {
+  if (group) {
+    return group->pop(index);
+  }
   std::unique_lock<std::mutex> lock(mutex);
   not_empty.wait(lock, [this]{ return !heap.empty(); });
   auto task = std::move(const_cast<FunctionTask&>(heap.top())); heap.pop();
+  CAFFE_SDT(autograd_ready_queue_pop, this, task.fn.get(), heap.size(), false);
   return task;
 }
 
-Engine::Engine() : ready_queues() {
+// Pops the top of the heap if there is one. Stealing never takes dummy
+// tasks, and a non-blocking attempt gives up if the queue is locked.
+auto ReadyQueue::try_pop(FunctionTask& task, bool steal, bool blocking) -> bool {
+  std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+  if (blocking) {
+    lock.lock();
+  } else if (!lock.try_lock()) {
+    return false;
+  }
+  if (heap.empty()) return false;
+  if (steal && !heap.top().fn) return false;
+  task = std::move(const_cast<FunctionTask&>(heap.top())); heap.pop();
+  CAFFE_SDT(autograd_ready_queue_pop, this, task.fn.get(), heap.size(), steal);
+  return true;
+}
+
+auto WorkStealingGroup::notify(bool all) -> void {
+  // Pairs with the increment of num_idle in pop(): either the sleeping
+  // worker sees the task when it rescans the queues, or we see it's idle.
+  if (num_idle.load() == 0) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++epoch;
+  }
+  if (all) {
+    not_empty.notify_all();
+  } else {
+    not_empty.notify_one();
+  }
+}
+
+auto WorkStealingGroup::pop(std::size_t own) -> FunctionTask {
+  FunctionTask task(nullptr, nullptr, InputBuffer(0));
+  auto num_queues = queues.size();
+  // Fast path: own queue first, then opportunistically steal from others
+  if (queues[own]->try_pop(task, false, false)) return task;
+  for (std::size_t i = 1; i < num_queues; ++i) {
+    if (queues[(own + i) % num_queues]->try_pop(task, true, false)) return task;
+  }
+  while (true) {
+    ++num_idle;
+    uint64_t seen_epoch;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      seen_epoch = epoch;
+    }
+    // Rescan with blocking locks, so that a task pushed before num_idle was
+    // incremented can't be missed.
+    bool found = queues[own]->try_pop(task, false, true);
+    for (std::size_t i = 1; !found && i < num_queues; ++i) {
+      found = queues[(own + i) % num_queues]->try_pop(task, true, true);
+    }
+    if (!found) {
+      std::unique_lock<std::mutex> lock(mutex);
+      not_empty.wait(lock, [&]{ return epoch != seen_epoch; });
+    }
+    --num_idle;
+    if (found) return task;
+  }
+}
+
+#ifdef WITH_CUDA
+static void stream_wait(THCStream* waiting, THCStream* on) {
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, on->stream));
+  THCudaCheck(cudaStreamWaitEvent(waiting->stream, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+
+// Keeps the caching allocator from reusing the memory of tensor before the
+// work queued on stream so far is done
+static void record_stream(const at::Tensor& tensor, THCStream* stream) {
+  if (!tensor.defined() || !tensor.type().is_cuda()) return;
+  if (tensor.type().is_sparse()) {
+    record_stream(tensor._indices(), stream);
+    record_stream(tensor._values(), stream);
+    return;
+  }
+  auto storage = tensor.storage();
+  if (storage && storage->data()) {
+    THCCachingAllocator_recordStream(storage->data(), stream);
+  }
+}
+#endif
+
+// Makes the engine stream of a task current while its function runs.
+// See Note [Backward CUDA streams]
+struct TaskStreamGuard {
+  TaskStreamGuard(FunctionTask& task, ReadyQueue* queue, int num_streams)
+    : previous_stream(worker_stream) {
+#ifdef WITH_CUDA
+    if (!queue) return;
+    auto& streams = queue->streams;
+    if (streams.empty()) {
+      // These are leaked, like the queues
+      for (int i = 0; i < num_streams; ++i) {
+        streams.push_back(THCStream_new(cudaStreamDefault));
+      }
+    }
+    int stream = task.stream;
+    if (stream < 0) {
+      stream = queue->next_stream++ % streams.size();
+    }
+    if (task.wait_stream >= 0 && task.wait_stream != stream) {
+      stream_wait(streams[stream], streams[task.wait_stream]);
+    }
+    for (std::size_t i = 0; i < task.inputs.size(); ++i) {
+      auto input = task.inputs[i];
+      if (input.defined()) {
+        record_stream(input.data(), streams[stream]);
+      }
+    }
+    worker_stream = stream;
+    stream_guard.reset(new AutoStream(streams[stream]));
+#endif
+  }
+
+  ~TaskStreamGuard() {
+    worker_stream = previous_stream;
+  }
+
+  int previous_stream;
+#ifdef WITH_CUDA
+  std::unique_ptr<AutoStream> stream_guard;
+#endif
+};
+
+Engine::Engine()
+  : ready_queues()
+  , num_cpu_workers_(1)
+  , num_cuda_streams_(1)
+  , next_cpu_queue(0) {
 }
 
 // This Engine's ReadyQueues and their corresponding threads are leaked here
@@ -212,11 +476,11 @@ auto Engine::thread_init(int device) -> void {
 // It's all ok and is handled right now, but it should be accounted for
 // in case this code is to be changed.
 auto Engine::thread_main(GraphTask *graph_task) -> void {
-  auto queue = ready_queues[worker_device + 1];
+  auto& queue = ready_queue(worker_device);
   // Why the test on graph_task->outstanding_tasks?  See
   // Note [Reentrant backwards]
   while (!graph_task || graph_task->outstanding_tasks > 0) {
-    FunctionTask task = queue->pop();
+    FunctionTask task = queue.pop();
     if (task.fn && !task.base->has_error.load()) {
       GradMode::set_enabled(task.base->grad_mode);
       try {
@@ -238,17 +502,22 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
     } else {
       // If it's a task initiated from this thread, decrease the counter, but
       // don't do anything - loop condition will do all checks for us next.
-      if (base_owner == worker_device) {
+      bool owned_here = base_owner == worker_device &&
+          (worker_device != -1 || task.base->owner_worker == cpu_worker_index);
+      if (owned_here) {
         --task.base->outstanding_tasks;
       // Otherwise send a dummy function task to the owning thread just to
       // ensure that it's not sleeping. If it has work, it might see that
       // graph_task->outstanding_tasks == 0 before it gets to the task, but
       // it's a no-op anyway.
-      } else if (base_owner != worker_device) {
+      } else {
         if (--task.base->outstanding_tasks == 0) {
           // Synchronize outstanding_tasks with queue mutex
           std::atomic_thread_fence(std::memory_order_release);
-          ready_queue(base_owner).push(FunctionTask(task.base, nullptr, InputBuffer(0)));
+          auto& owner_queue = base_owner == -1
+              ? *ready_queues.at(task.base->owner_worker)
+              : ready_queue(base_owner);
+          owner_queue.push(FunctionTask(task.base, nullptr, InputBuffer(0)));
         }
       }
     }
@@ -303,7 +572,33 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
     if (!fn_info.needed) return;
   }
 
-  auto outputs = call_function(task);
+  // See Note [Backward CUDA streams]
+  bool use_streams = worker_device >= 0 && num_cuda_streams_ > 1;
+  TaskStreamGuard stream_guard(
+      task, use_streams ? &ready_queue(worker_device) : nullptr, num_cuda_streams_);
+
+  // Saved variables offloaded to the host are copied back while this
+  // function runs, ahead of the functions that consume its outputs
+  if (SavedVariableOffload::any_offloaded()) {
+    for (const auto& edge : task.fn->next_edges()) {
+      if (edge.function) {
+        edge.function->prefetch_variables();
+      }
+    }
+  }
+
+  // The mangled type name is a static string, unlike Function::name()
+  CAFFE_SDT(autograd_function_start, task.fn.get(), typeid(*task.fn).name(),
+            task.fn->sequence_nr(), task.fn->num_inputs(), worker_device);
+  variable_list outputs;
+  if (num_cpu_workers_ > 1 && worker_device == -1) {
+    // See Note [CPU work stealing]
+    std::lock_guard<std::recursive_mutex> lock(function_lock(task.fn.get()));
+    outputs = call_function(task);
+  } else {
+    outputs = call_function(task);
+  }
+  CAFFE_SDT(autograd_function_end, task.fn.get(), outputs.size());
 
   auto& fn = *task.fn;
   if (!task.base->keep_graph) {
@@ -320,12 +615,33 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
   int num_outputs = outputs.size();
   if (num_outputs == 0) return; // Don't even acquire the mutex
   std::lock_guard<std::mutex> lock(task.base->mutex);
+  // The first function made ready here keeps running on this stream
+  bool stream_taken = false;
+  auto push_ready = [&](std::shared_ptr<Function> next_fn, InputBuffer input_buffer, int writer) {
+    int device = input_buffer.device();
+    FunctionTask next_task(task.base, std::move(next_fn), std::move(input_buffer));
+    if (writer >= 0 && device == worker_device) {
+      next_task.wait_stream = writer;
+      if (writer == worker_stream && !stream_taken) {
+        next_task.stream = writer;
+        stream_taken = true;
+      }
+    }
+    ready_queue(device).push(std::move(next_task));
+  };
   for (int i = 0; i < num_outputs; ++i) {
     auto& output = outputs[i];
     const auto& next = fn.next_edge(i);
 
     if (!next.is_valid()) continue;
 
+    // The engine stream that writes output into the buffer, if any
+    int output_stream = -1;
+    if (worker_stream >= 0 && output.defined() && output.type().is_cuda() &&
+        output.get_device() == worker_device) {
+      output_stream = worker_stream;
+    }
+
     // Check if the next function is ready to be computed
     bool is_ready = false;
     auto& dependencies = task.base->dependencies;
@@ -352,19 +668,42 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
       InputBuffer input_buffer(next.function->num_inputs());
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
-        queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
+        push_ready(next.function, std::move(input_buffer), output_stream);
       } else {
         not_ready.emplace(next.function.get(), std::move(input_buffer));
+        if (output_stream >= 0) {
+          task.base->buffer_streams[next.function.get()] = output_stream;
+        }
       }
     } else {
       // The function already has a buffer
       auto &input_buffer = not_ready_it->second;
+      auto& buffer_streams = task.base->buffer_streams;
+      auto writer_it = buffer_streams.find(next.function.get());
+      int writer = writer_it == buffer_streams.end() ? -1 : writer_it->second;
+#ifdef WITH_CUDA
+      if (output_stream >= 0 && writer >= 0 && writer != output_stream) {
+        // See Note [Backward CUDA streams]
+        auto& streams = ready_queue(worker_device).streams;
+        stream_wait(streams[output_stream], streams[writer]);
+        auto old_var = input_buffer[next.input_nr];
+        if (old_var.defined()) {
+          record_stream(old_var.data(), streams[output_stream]);
+        }
+      }
+#endif
+      if (output.defined()) {
+        writer = output_stream;
+      }
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
-        queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
+        push_ready(next.function, std::move(input_buffer), writer);
         not_ready.erase(not_ready_it);
+        if (writer_it != buffer_streams.end()) buffer_streams.erase(writer_it);
+      } else if (writer >= 0) {
+        buffer_streams[next.function.get()] = writer;
+      } else if (writer_it != buffer_streams.end()) {
+        buffer_streams.erase(writer_it);
       }
     }
   }
@@ -438,6 +777,7 @@ auto Engine::execute(const edge_list& input_roots,
     // complete!
     // See Note [Reentrant backwards]
     graph_task.owner = worker_device;
+    graph_task.owner_worker = cpu_worker_index;
     lock.unlock();
     thread_main(&graph_task);
   }
@@ -477,7 +817,26 @@ void Engine::queue_callback(std::function<void()> callback) {
 }
 
 auto Engine::ready_queue(int device) -> ReadyQueue& {
-  return *ready_queues.at(device + 1);
+  if (device == -1 && num_cpu_workers_ > 1) {
+    // CPU workers keep the work they produce, everyone else spreads it
+    // See Note [CPU work stealing]
+    if (worker_device == -1) {
+      return *ready_queues[cpu_worker_index];
+    }
+    return *ready_queues[next_cpu_queue++ % num_cpu_workers_];
+  }
+  return *ready_queues.at(device + num_cpu_workers_);
+}
+
+static int get_positive_env(const char* name) {
+  const char * env = getenv(name);
+  if (!env) return 1;
+  int value = std::atoi(env);
+  if (value < 1) {
+    throw std::runtime_error(
+        std::string(name) + " must be a positive integer, but got " + env);
+  }
+  return value;
 }
 
 auto Engine::start_threads() -> void {
@@ -489,13 +848,29 @@ auto Engine::start_threads() -> void {
     num_devices = 0;
   }
 #endif
-  // One for CPU, plus one for every GPU device
-  int num_threads = num_devices + 1;
+  // One for every CPU worker (by default only one), plus one for every GPU device
+  num_cpu_workers_ = get_positive_env("TORCH_AUTOGRAD_CPU_WORKERS");
+  // See Note [Backward CUDA streams]
+  num_cuda_streams_ = get_positive_env("TORCH_AUTOGRAD_CUDA_STREAMS");
+  int num_threads = num_devices + num_cpu_workers_;
   ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
   for (auto& queue : ready_queues)
     queue.reset(new ReadyQueue());
+  if (num_cpu_workers_ > 1) {
+    cpu_group = std::make_shared<WorkStealingGroup>();
+    for (int i = 0; i < num_cpu_workers_; ++i) {
+      ready_queues[i]->group = cpu_group.get();
+      ready_queues[i]->index = i;
+      cpu_group->queues.push_back(ready_queues[i].get());
+    }
+  }
   for (int i = 0; i < num_threads; ++i) {
-    std::thread t(&Engine::thread_init, this, i - 1);
+    int device = std::max(i - num_cpu_workers_, -1);
+    std::size_t worker_index = device == -1 ? i : 0;
+    std::thread t([this, device, worker_index] {
+      cpu_worker_index = worker_index;
+      thread_init(device);
+    });
     t.detach();
   }
 }
@@ -3,8 +3,10 @@
 // Engine implements backpropagation from output variables and their gradients
 // to "root" variables (variables created by the user with requires_grad=True).
 
+#include <atomic>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -16,6 +18,7 @@
 namespace torch { namespace autograd {
 
 struct ReadyQueue;
+struct WorkStealingGroup;
 struct FunctionTask;
 struct GraphTask;
 
@@ -41,6 +44,19 @@ struct Engine {
 
   static Engine& getDefaultEngine();
 
+  // Number of threads processing CPU work. Defaults to 1, and can be raised
+  // with the TORCH_AUTOGRAD_CPU_WORKERS environment variable, in which case
+  // the CPU workers steal tasks from each other's queues.
+  // See Note [CPU work stealing]
+  int num_cpu_workers() const { return num_cpu_workers_; }
+
+  // Number of CUDA streams the worker of every device issues backward
+  // functions on. Defaults to 1 (the worker's current stream), and can be
+  // raised with the TORCH_AUTOGRAD_CUDA_STREAMS environment variable, in
+  // which case independent functions can run concurrently on the device.
+  // See Note [Backward CUDA streams]
+  int num_cuda_streams() const { return num_cuda_streams_; }
+
 protected:
   void compute_dependencies(Function* root, GraphTask& task);
   void evaluate_function(FunctionTask& task);
@@ -51,7 +67,13 @@ protected:
   virtual void thread_on_exception(FunctionTask& task, std::exception& e);
 
   std::once_flag start_threads_flag;
+  // The first num_cpu_workers_ queues belong to the CPU workers, and the
+  // rest to the GPU devices (one per device).
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues;
+  std::shared_ptr<WorkStealingGroup> cpu_group;
+  int num_cpu_workers_;
+  int num_cuda_streams_;
+  std::atomic<std::size_t> next_cpu_queue;
   std::vector<std::function<void()>> final_callbacks;
   std::mutex post_callbacks_lock;
 };
@@ -256,6 +256,10 @@ struct Function : std::enable_shared_from_this<Function> {
   /// release variables as they run.
   virtual void will_release_variables() {}
 
+  /// Starts copying saved variables that were offloaded to the host back to
+  /// their devices. Called by the engine ahead of running the function.
+  virtual void prefetch_variables() {}
+
   /// Returns true if this function is traceable. An op is traceable if all
   /// operations happening within `apply()` are performed on autograd
   /// `Variables` (i.e. apply mostly instantiates and applies other functions).
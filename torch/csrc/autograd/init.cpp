@@ -5,6 +5,9 @@
 #include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/python_function.h"
+#include "torch/csrc/autograd/saved_variable.h"
+
+#include <fstream>
 
 PyObject * THPAutograd_initExtension(PyObject *_unused)
 {
@@ -38,8 +41,39 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   .value("CUDA", torch::autograd::profiler::ProfilerState::CUDA)
   .value("NVTX", torch::autograd::profiler::ProfilerState::NVTX);
 
-  m.def("_enable_profiler", torch::autograd::profiler::enableProfiler);
+  m.def("_enable_profiler", [](torch::autograd::profiler::ProfilerState state,
+                               uint32_t sample_period, std::size_t buffer_size) {
+    using namespace torch::autograd::profiler;
+    enableProfiler(ProfilerConfig(state, sample_period, buffer_size));
+  }, py::arg("state"), py::arg("sample_period") = 1, py::arg("buffer_size") = 0);
   m.def("_disable_profiler", torch::autograd::profiler::disableProfiler);
+  py::class_<torch::autograd::profiler::OpStats>(m, "ProfilerOpStats")
+  .def_readonly("name", &torch::autograd::profiler::OpStats::name)
+  .def_readonly("count", &torch::autograd::profiler::OpStats::count)
+  .def_readonly("cpu_total_us", &torch::autograd::profiler::OpStats::cpu_total_us)
+  .def_readonly("cpu_min_us", &torch::autograd::profiler::OpStats::cpu_min_us)
+  .def_readonly("cpu_max_us", &torch::autograd::profiler::OpStats::cpu_max_us)
+  .def_readonly("cuda_total_us", &torch::autograd::profiler::OpStats::cuda_total_us)
+  .def_readonly("cpu_histogram", &torch::autograd::profiler::OpStats::cpu_histogram);
+  m.def("_aggregate_profile", torch::autograd::profiler::aggregateOps);
+  m.def("_export_chrome_trace", [](const torch::autograd::profiler::thread_event_lists& lists,
+                                   const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+      throw std::runtime_error("can't open " + path + " for writing");
+    }
+    torch::autograd::profiler::exportChromeTrace(lists, out);
+  });
+
+  m.def("_set_offload_saved_tensors", [](bool enabled, int64_t min_bytes) {
+    using torch::autograd::SavedVariableOffload;
+    SavedVariableOffload::set_enabled(enabled);
+    SavedVariableOffload::set_min_bytes(min_bytes);
+  });
+  m.def("_get_offload_saved_tensors", []() {
+    using torch::autograd::SavedVariableOffload;
+    return std::make_tuple(SavedVariableOffload::is_enabled(), SavedVariableOffload::min_bytes());
+  });
 
   m.def("_push_range", [](const char *name) {
     using namespace torch::autograd::profiler;
@@ -2,10 +2,21 @@
 
 #include "torch/csrc/assertions.h"
 #include "torch/csrc/autograd/functions/basic_ops.h"
+#include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/utils/auto_gpu.h"
 
 namespace torch { namespace autograd {
 
+// Adding to `sum` in place is only invisible to autograd while no graph is
+// being built through it, and only cheap when no broadcasting or sparse
+// addition is involved.
+static bool canAccumulateInPlace(const Variable& sum, const Variable& var) {
+  if (GradMode::is_enabled() && (sum.requires_grad() || var.requires_grad())) {
+    return false;
+  }
+  return !sum.type().is_sparse() && &sum.type() == &var.type() &&
+      sum.sizes().equals(var.sizes());
+}
 
 void InputBuffer::add(size_t pos, Variable var) {
   TORCH_ASSERT(pos >= 0 && pos < buffer.size());
@@ -15,6 +26,8 @@ void InputBuffer::add(size_t pos, Variable var) {
   auto& old_var = buffer[pos];
   if (!old_var.defined()) {
     buffer[pos] = std::move(var);
+  } else if (owned[pos] && canAccumulateInPlace(old_var, var)) {
+    old_var.data().add_(var.data());
   } else {
     // ATen doesn't route sparse additions correctly...
     if (old_var.type().is_sparse()) {
@@ -22,6 +35,7 @@ void InputBuffer::add(size_t pos, Variable var) {
     } else {
       buffer[pos] = old_var + var;
     }
+    owned[pos] = true;
   }
 }
 
@@ -4,6 +4,10 @@
 // function. It implements logic to avoid modifying the passed
 // values in-place (adding an input twice will accumulate the result).
 // This behaviour needed and used only in backward graphs.
+//
+// The first sum at an index allocates a new Variable. Nothing else can hold
+// it, so the gradients arriving after that are added to it in place, and an
+// input with k gradients costs one allocation instead of k - 1.
 
 #include <vector>
 #include <utility>
@@ -16,7 +20,8 @@ namespace torch { namespace autograd {
 
 struct InputBuffer {
   explicit InputBuffer(size_t size)
-    : buffer(size) {}
+    : buffer(size)
+    , owned(size, false) {}
   InputBuffer(const InputBuffer& other) = delete;
   InputBuffer(InputBuffer&& other) = default;
   InputBuffer& operator=(InputBuffer&& other) = default;
@@ -28,11 +33,15 @@ struct InputBuffer {
 
   Variable operator[](std::size_t pos) { return buffer[pos]; }
 
+  std::size_t size() const { return buffer.size(); }
+
   // Returns the inputs as a list of variables. Destroys given InputBuffer.
   static std::vector<Variable> variables(InputBuffer&& buffer);
 
 private:
   std::vector<Variable> buffer;
+  // Set for the entries that are sums created by add()
+  std::vector<bool> owned;
 };
 
 }}  // namespace torch::autograd
@@ -1,17 +1,29 @@
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/function.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+
 namespace torch { namespace autograd { namespace profiler {
 
 ProfilerState state = ProfilerState::Disabled;
+uint32_t sample_period = 1;
+std::size_t buffer_size = 0;
+uint32_t profiler_epoch = 0;
 uint32_t next_thread_id = 0;
 std::mutex all_event_lists_mutex;
 std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 thread_local std::shared_ptr<RangeEventList> event_list;
 thread_local int32_t thread_id;
+thread_local uint32_t range_count = 0;
+thread_local uint32_t unrecorded_depth = 0;
+thread_local uint32_t recorded_depth = 0;
+thread_local uint32_t thread_epoch = 0;
 
 void RecordFunction::pushFunctionRange(Function* fn) {
-  pushRange(fn->name());
+  pushRange(internName(fn->name()));
 }
 
 #ifdef WITH_CUDA
@@ -27,7 +39,15 @@ static void onEachDevice(std::function<void(int)> op) {
 #endif
 
 void enableProfiler(ProfilerState new_state) {
+  enableProfiler(ProfilerConfig(new_state));
+}
+
+void enableProfiler(ProfilerConfig config) {
+  ProfilerState new_state = config.state;
   TORCH_ASSERT(new_state != ProfilerState::Disabled);
+  if (config.sample_period == 0) {
+    throw std::runtime_error("profiler sample_period must be positive");
+  }
 #ifndef WITH_CUDA
   if (new_state == ProfilerState::NVTX)
     throw std::runtime_error("Can't use NVTX profiler - PyTorch was compiled without CUDA");
@@ -35,6 +55,18 @@ void enableProfiler(ProfilerState new_state) {
   if (state != ProfilerState::Disabled && new_state != state) {
       throw std::runtime_error("can't change kind of profiling (e.g. NVTX to CPU) while profiler is running");
   }
+  sample_period = config.sample_period;
+  buffer_size = config.buffer_size;
+  profiler_epoch++;
+  {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    for (auto & list : all_event_lists) {
+      list->setCapacity(buffer_size);
+#ifdef WITH_CUDA
+      list->cuda_events.releaseAll();
+#endif
+    }
+  }
   state = new_state;
 
 #ifdef WITH_CUDA
@@ -87,4 +119,151 @@ thread_event_lists disableProfiler() {
   }
 }
 
+std::vector<ProfilerRange> matchRanges(const thread_event_lists& lists) {
+  const Event* start_event = nullptr;
+  std::unordered_map<int, const Event*> cuda_start_events;
+  for (auto & list : lists) {
+    for (auto & event : list) {
+      if (event.eventKind() != EventKind::Mark) continue;
+      auto name = event.name();
+      if (name == "__start_profile") {
+        start_event = &event;
+      } else if (name == "__cuda_start_event") {
+        cuda_start_events[event.device()] = &event;
+      }
+    }
+  }
+  if (!start_event) {
+    throw std::runtime_error("profiler records have no __start_profile mark");
+  }
+
+  // Same correction as parse_cpu_trace: the start event of each device was
+  // recorded a little after or before __start_profile on the CPU
+  auto cuda_time = [&](const Event& event) {
+    auto it = cuda_start_events.find(event.device());
+    if (it == cuda_start_events.end()) {
+      throw std::runtime_error("profiler records have no __cuda_start_event for a device");
+    }
+    return it->second->cuda_elapsed_us(event) + start_event->cpu_elapsed_us(*it->second);
+  };
+
+  std::vector<ProfilerRange> ranges;
+  std::vector<const Event*> stack;
+  for (auto & list : lists) {
+    stack.clear();
+    for (auto & event : list) {
+      if (event.eventKind() == EventKind::PushRange) {
+        stack.push_back(&event);
+      } else if (event.eventKind() == EventKind::PopRange) {
+        // With a bounded buffer the push may have been overwritten
+        if (stack.empty()) continue;
+        const Event& start = *stack.back();
+        stack.pop_back();
+        ProfilerRange range;
+        range.name = start.name();
+        range.thread_id = start.thread_id();
+        range.cpu_start_us = start_event->cpu_elapsed_us(start);
+        range.cpu_end_us = start_event->cpu_elapsed_us(event);
+        if (start.has_cuda() && event.has_cuda()) {
+          range.device = start.device();
+          range.cuda_start_us = cuda_time(start);
+          range.cuda_end_us = cuda_time(event);
+        }
+        ranges.push_back(std::move(range));
+      }
+    }
+  }
+  std::sort(ranges.begin(), ranges.end(), [](const ProfilerRange& a, const ProfilerRange& b) {
+    return a.cpu_start_us < b.cpu_start_us;
+  });
+  return ranges;
+}
+
+static void writeJSONString(std::ostream& out, const std::string& str) {
+  out << '"';
+  for (char c : str) {
+    switch (c) {
+      case '"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      case '\t': out << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", c);
+          out << buf;
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+void exportChromeTrace(const thread_event_lists& lists, std::ostream& out) {
+  auto ranges = matchRanges(lists);
+  bool first = true;
+  auto begin_event = [&](const std::string& name, const char* phase, double ts) {
+    out << (first ? "[\n" : ",\n") << "{\"name\": ";
+    first = false;
+    writeJSONString(out, name);
+    out << ", \"ph\": \"" << phase << "\", \"ts\": " << ts;
+  };
+
+  out.precision(15);
+  int64_t flow_id = 0;
+  for (auto & range : ranges) {
+    begin_event(range.name, "X", range.cpu_start_us);
+    out << ", \"dur\": " << range.cpu_end_us - range.cpu_start_us
+        << ", \"tid\": " << range.thread_id << ", \"pid\": \"CPU functions\", \"args\": {}}";
+    if (range.device == -1) continue;
+    // 's' and 'f' draw a flow arrow from the CPU launch to the GPU range
+    begin_event(range.name, "s", range.cpu_start_us);
+    out << ", \"tid\": " << range.thread_id << ", \"pid\": \"CPU functions\", \"id\": " << flow_id
+        << ", \"cat\": \"cpu_to_cuda\", \"args\": {}}";
+    begin_event(range.name, "f", range.cuda_start_us);
+    out << ", \"tid\": " << range.device << ", \"pid\": \"CUDA functions\", \"id\": " << flow_id
+        << ", \"cat\": \"cpu_to_cuda\", \"args\": {}}";
+    begin_event(range.name, "X", range.cuda_start_us);
+    out << ", \"dur\": " << range.cuda_end_us - range.cuda_start_us
+        << ", \"tid\": " << range.device << ", \"pid\": \"CUDA functions\", \"args\": {}}";
+    flow_id++;
+  }
+  out << (first ? "[]\n" : "\n]\n");
+}
+
+void OpStats::add(const ProfilerRange& range) {
+  double cpu_us = range.cpu_end_us - range.cpu_start_us;
+  cpu_min_us = count == 0 ? cpu_us : std::min(cpu_min_us, cpu_us);
+  cpu_max_us = std::max(cpu_max_us, cpu_us);
+  cpu_total_us += cpu_us;
+  if (range.device != -1) {
+    cuda_total_us += range.cuda_end_us - range.cuda_start_us;
+  }
+  std::size_t bucket = 0;
+  if (cpu_us >= 1) {
+    bucket = std::min<std::size_t>(static_cast<std::size_t>(std::log2(cpu_us)) + 1, num_buckets - 1);
+  }
+  cpu_histogram[bucket]++;
+  count++;
+}
+
+std::vector<OpStats> aggregateOps(const thread_event_lists& lists) {
+  std::unordered_map<std::string, OpStats> stats;
+  for (auto & range : matchRanges(lists)) {
+    auto & op = stats[range.name];
+    op.name = range.name;
+    op.add(range);
+  }
+  std::vector<OpStats> result;
+  result.reserve(stats.size());
+  for (auto & entry : stats) {
+    result.push_back(std::move(entry.second));
+  }
+  std::sort(result.begin(), result.end(), [](const OpStats& a, const OpStats& b) {
+    return a.cpu_total_us > b.cpu_total_us;
+  });
+  return result;
+}
+
 }}}
@@ -16,6 +16,7 @@
 #include <tuple>
 #include "ATen/ATen.h"
 #include "torch/csrc/cuda/cuda_check.h"
+#include "torch/csrc/jit/interned_strings.h"
 #ifdef WITH_CUDA
 #include <cuda_runtime.h>
 #endif
@@ -42,25 +43,19 @@ enum class EventKind {
   PopRange
 };
 
+// Events store an interned name, so recording one never allocates.
+// Operator ranges are aten:: symbols, everything else (autograd Functions,
+// Python ranges, marks) goes in the scope:: namespace.
+inline jit::Symbol internName(const std::string& name) {
+  return jit::Symbol::scope(name);
+}
+
 struct Event {
-  Event(EventKind kind, std::string name, uint32_t thread_id, bool record_cuda)
+  Event(EventKind kind, jit::Symbol name, uint32_t thread_id)
   : kind_(kind)
-  , name_(std::move(name))
-  , thread_id_(thread_id) {
-#ifdef WITH_CUDA
-    if(record_cuda) {
-      TORCH_CUDA_CHECK(cudaGetDevice(&device_));
-      TORCH_CUDA_CHECK(cudaEventCreate(&event));
-      auto stream = at::globalContext().getCurrentCUDAStream();
-      cpu_ns_ = getTime();
-      TORCH_CUDA_CHECK(cudaEventRecord(event, stream));
-    } else {
-      cpu_ns_ = getTime();
-    }
-#else
-    cpu_ns_ = getTime();
-#endif
-  }
+  , name_(name)
+  , thread_id_(thread_id)
+  , cpu_ns_(getTime()) {}
   std::string kind() const {
     switch(kind_) {
       case EventKind::Mark: return "mark";
@@ -69,16 +64,19 @@ struct Event {
     }
     throw std::runtime_error("unknown EventKind");
   }
-  const std::string & name() const {
-    return name_;
+  EventKind eventKind() const {
+    return kind_;
+  }
+  std::string name() const {
+    return name_ == jit::Symbol() ? std::string() : name_.toUnqualString();
   }
   uint32_t thread_id() const {
     return thread_id_;
   }
-  double cpu_elapsed_us(const Event & e) {
+  double cpu_elapsed_us(const Event & e) const {
     return (e.cpu_ns_ - cpu_ns_)/(1000.0);
   }
-  double cuda_elapsed_us(const Event & e) {
+  double cuda_elapsed_us(const Event & e) const {
 #ifdef WITH_CUDA
     if(!e.has_cuda() || !has_cuda()) {
       throw std::logic_error("Events were not recorded for CUDA");
@@ -105,9 +103,20 @@ struct Event {
   int device() const {
     return device_;
   }
+#ifdef WITH_CUDA
+  // `cuda_event` comes from the recording thread's CUDAEventPool
+  void recordCUDA(cudaEvent_t cuda_event, int device) {
+    event = cuda_event;
+    device_ = device;
+    TORCH_CUDA_CHECK(cudaEventRecord(event, at::globalContext().getCurrentCUDAStream()));
+  }
+  cudaEvent_t cudaEvent() const {
+    return event;
+  }
+#endif
 private:
   EventKind kind_;
-  std::string name_;
+  jit::Symbol name_;
   uint32_t thread_id_;
   int64_t cpu_ns_; // signed to allow for negative intervals
 #ifdef WITH_CUDA
@@ -116,9 +125,53 @@ private:
   int device_ = -1;
 };
 
+#ifdef WITH_CUDA
+// Creating a CUDA event costs about as much as the range it is timing, so
+// every thread keeps the events it has created and hands them out again.
+// Events returned by disableProfiler() stay valid until the profiler is
+// enabled again, which is when they all go back into the pool.
+struct CUDAEventPool {
+  cudaEvent_t acquire(int device) {
+    if (device >= static_cast<int>(free.size())) {
+      free.resize(device + 1);
+    }
+    if (!free[device].empty()) {
+      auto event = free[device].back();
+      free[device].pop_back();
+      return event;
+    }
+    cudaEvent_t event;
+    TORCH_CUDA_CHECK(cudaEventCreate(&event));
+    created.emplace_back(device, event);
+    return event;
+  }
+
+  void release(int device, cudaEvent_t event) {
+    free[device].push_back(event);
+  }
+
+  void releaseAll() {
+    for (auto & events : free) {
+      events.clear();
+    }
+    for (auto & created_event : created) {
+      release(created_event.first, created_event.second);
+    }
+  }
+
+  std::vector<std::vector<cudaEvent_t>> free;
+  std::vector<std::pair<int, cudaEvent_t>> created;
+};
+#endif
+
 // a linked-list of fixed sized vectors, to avoid
 // a std::vector resize from taking a large amount of time inside
 // a profiling  event
+//
+// When a capacity is set, ranges go to a preallocated ring buffer of that
+// many events instead, overwriting the oldest once it is full, so the
+// profiler can be left running. Marks are rare and are what timestamps are
+// measured from, so they are always kept.
 struct RangeEventList {
   constexpr static std::size_t MB = 1024 * 1024;
   constexpr static std::size_t event_block_size = 16 * MB;
@@ -133,12 +186,41 @@ struct RangeEventList {
     blocks.front().reserve(num_block_elements);
   }
 
-  template<typename... Args>
-  void record(Args&&... args) {
-    if (blocks.empty() || blocks.front().size() == num_block_elements) {
-      allocBlock();
+  void setCapacity(std::size_t new_capacity) {
+    capacity = new_capacity;
+    ring.clear();
+    ring.reserve(capacity);
+    ring_next = 0;
+  }
+
+  void record(EventKind kind, jit::Symbol name, uint32_t thread_id, bool record_cuda) {
+    Event* event;
+    if (capacity == 0 || kind == EventKind::Mark) {
+      if (blocks.empty() || blocks.front().size() == num_block_elements) {
+        allocBlock();
+      }
+      blocks.front().emplace_back(kind, name, thread_id);
+      event = &blocks.front().back();
+    } else if (ring.size() < capacity) {
+      ring.emplace_back(kind, name, thread_id);
+      event = &ring.back();
+    } else {
+      event = &ring[ring_next];
+#ifdef WITH_CUDA
+      if (event->has_cuda()) {
+        cuda_events.release(event->device(), event->cudaEvent());
+      }
+#endif
+      *event = Event(kind, name, thread_id);
+      ring_next = (ring_next + 1) % capacity;
+    }
+#ifdef WITH_CUDA
+    if (record_cuda) {
+      int device;
+      TORCH_CUDA_CHECK(cudaGetDevice(&device));
+      event->recordCUDA(cuda_events.acquire(device), device);
     }
-    blocks.front().emplace_back(std::forward<Args>(args)...);
+#endif
   }
 
   std::vector<Event> consolidate() {
@@ -149,10 +231,21 @@ struct RangeEventList {
                     std::make_move_iterator(block.end()));
     }
     blocks.clear();
+    // oldest surviving range first
+    result.insert(result.end(), ring.begin() + ring_next, ring.end());
+    result.insert(result.end(), ring.begin(), ring.begin() + ring_next);
+    ring.clear();
+    ring_next = 0;
     return result;
   }
 
   std::forward_list<block_type> blocks;
+  std::vector<Event> ring;
+  std::size_t capacity = 0;
+  std::size_t ring_next = 0;
+#ifdef WITH_CUDA
+  CUDAEventPool cuda_events;
+#endif
 };
 
 enum class ProfilerState {
@@ -162,48 +255,101 @@ enum class ProfilerState {
     NVTX,  // only emit NVTX markers
 };
 
+// Knobs for keeping the profiler on in long running jobs. With the
+// defaults every range is recorded and kept.
+struct ProfilerConfig {
+  explicit ProfilerConfig(ProfilerState state, uint32_t sample_period = 1,
+                          std::size_t buffer_size = 0)
+  : state(state)
+  , sample_period(sample_period)
+  , buffer_size(buffer_size) {}
+  ProfilerState state;
+  // Record one in every `sample_period` outermost ranges of a thread, along
+  // with the ranges nested in it.
+  uint32_t sample_period;
+  // Keep only the last `buffer_size` ranges of each thread (0 keeps all).
+  std::size_t buffer_size;
+};
+
 extern ProfilerState state;
+extern uint32_t sample_period;
+extern std::size_t buffer_size;
 extern uint32_t next_thread_id;
 extern std::mutex all_event_lists_mutex;
 extern std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 
 extern thread_local std::shared_ptr<RangeEventList> event_list;
 extern thread_local int32_t thread_id;
+// Ranges seen by this thread, for sampling
+extern thread_local uint32_t range_count;
+// Depth of pushes not being recorded: the inside of a range that was not
+// sampled, or a range that was started before the profiler was enabled
+extern thread_local uint32_t unrecorded_depth;
+extern thread_local uint32_t recorded_depth;
+// Bumped by enableProfiler, so threads drop the depths left over from an
+// earlier session that was disabled in the middle of a range
+extern uint32_t profiler_epoch;
+extern thread_local uint32_t thread_epoch;
+
+inline void syncSamplingState() {
+  if (thread_epoch != profiler_epoch) {
+    thread_epoch = profiler_epoch;
+    range_count = 0;
+    unrecorded_depth = 0;
+    recorded_depth = 0;
+  }
+}
 
 inline RangeEventList& getEventList() {
   if (!event_list) {
     std::lock_guard<std::mutex> guard(all_event_lists_mutex);
     event_list = std::make_shared<RangeEventList>();
+    event_list->setCapacity(buffer_size);
     thread_id = next_thread_id++;
     all_event_lists.emplace_front(event_list);
   }
   return *event_list;
 }
 
-inline void mark(std::string name, bool include_cuda = true) {
+inline void mark(jit::Symbol name, bool include_cuda = true) {
   if (state == ProfilerState::NVTX) {
 #ifdef WITH_CUDA
-    nvtxMarkA(name.c_str());
+    nvtxMarkA(name.toUnqualString());
 #else
     throw std::logic_error("mark called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::Mark, std::move(name), thread_id, include_cuda && state == ProfilerState::CUDA);
+    getEventList().record(EventKind::Mark, name, thread_id, include_cuda && state == ProfilerState::CUDA);
   }
 }
 
-inline void pushRange(std::string name) {
+inline void mark(const std::string& name, bool include_cuda = true) {
+  mark(internName(name), include_cuda);
+}
+
+inline void pushRange(jit::Symbol name) {
   if (state == ProfilerState::NVTX) {
 #ifdef WITH_CUDA
-    nvtxRangePushA(name.c_str());
+    nvtxRangePushA(name.toUnqualString());
 #else
     throw std::logic_error("pushRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PushRange, std::move(name), thread_id, state == ProfilerState::CUDA);
+    syncSamplingState();
+    if (unrecorded_depth > 0 ||
+        (recorded_depth == 0 && sample_period > 1 && range_count++ % sample_period != 0)) {
+      unrecorded_depth++;
+      return;
+    }
+    recorded_depth++;
+    getEventList().record(EventKind::PushRange, name, thread_id, state == ProfilerState::CUDA);
   }
 }
 
+inline void pushRange(const std::string& name) {
+  pushRange(internName(name));
+}
+
 inline void popRange() {
   if (state == ProfilerState::NVTX) {
 #ifdef WITH_CUDA
@@ -212,7 +358,15 @@ inline void popRange() {
     throw std::logic_error("popRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PopRange, std::string(), thread_id, state == ProfilerState::CUDA);
+    syncSamplingState();
+    if (unrecorded_depth > 0) {
+      unrecorded_depth--;
+      return;
+    }
+    if (recorded_depth > 0) {
+      recorded_depth--;
+    }
+    getEventList().record(EventKind::PopRange, jit::Symbol(), thread_id, state == ProfilerState::CUDA);
   }
 }
 
@@ -224,10 +378,16 @@ struct RecordFunction {
 
   explicit RecordFunction(std::string name) {
     if (state == ProfilerState::Disabled) return;
-    pushRange(std::move(name));
+    pushRange(name);
   }
 
   explicit RecordFunction(const char *name) {
+    if (state == ProfilerState::Disabled) return;
+    pushRange(std::string(name));
+  }
+
+  // For names interned once up front, e.g. the aten:: symbol of an op
+  explicit RecordFunction(jit::Symbol name) {
     if (state == ProfilerState::Disabled) return;
     pushRange(name);
   }
@@ -245,7 +405,46 @@ using thread_event_lists = std::vector<std::vector<Event>>;
 // NOTE: changing profiler modes is **NOT THREAD SAFE**. You should ensure that
 // there no autograd functions are being executed when these function are used.
 void enableProfiler(ProfilerState state);
+void enableProfiler(ProfilerConfig config);
 thread_event_lists disableProfiler();
 
+// A push matched with its pop. Times are in us since __start_profile, the
+// CUDA ones measured on the device the range started on.
+struct ProfilerRange {
+  std::string name;
+  uint32_t thread_id;
+  double cpu_start_us;
+  double cpu_end_us;
+  int device = -1;
+  double cuda_start_us = 0;
+  double cuda_end_us = 0;
+};
+
+std::vector<ProfilerRange> matchRanges(const thread_event_lists& lists);
+
+// Writes the ranges in the trace format read by chrome://tracing, without
+// going through the Python EventList.
+void exportChromeTrace(const thread_event_lists& lists, std::ostream& out);
+
+// Per-op totals over a profiling session.
+struct OpStats {
+  constexpr static std::size_t num_buckets = 32;
+
+  std::string name;
+  uint64_t count = 0;
+  double cpu_total_us = 0;
+  double cpu_min_us = 0;
+  double cpu_max_us = 0;
+  double cuda_total_us = 0;
+  // cpu_histogram[i] counts the calls that took [2^(i-1), 2^i) us, the
+  // first bucket everything under 1us and the last everything above
+  std::vector<uint64_t> cpu_histogram = std::vector<uint64_t>(num_buckets);
+
+  void add(const ProfilerRange& range);
+};
+
+// Sorted by decreasing total CPU time
+std::vector<OpStats> aggregateOps(const thread_event_lists& lists);
+
 } // namespace profiler
 }} // namespace torch::autograd
@@ -24,7 +24,11 @@ THP_API PyObject * THPVariable_Wrap(torch::autograd::Variable var);
 
 inline bool THPVariable_Check(PyObject *obj)
 {
-  return THPVariableClass && PyObject_IsInstance(obj, THPVariableClass);
+  // Nearly every argument is a plain torch.Tensor, which doesn't need the
+  // generic (and much slower) isinstance protocol
+  return THPVariableClass &&
+      (Py_TYPE(obj) == (PyTypeObject*)THPVariableClass ||
+       PyObject_IsInstance(obj, THPVariableClass));
 }
 
 inline torch::autograd::Variable& THPVariable_Unpack(PyObject* obj) {
@@ -4,15 +4,116 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/jit/tracer_state.h"
+#include "torch/csrc/utils/auto_gpu.h"
+#include "torch/csrc/utils/auto_stream.h"
 
 #include <ATen/Tensor.h>
+#include <ATen/PinnedMemoryAllocator.h>
 
+#include <atomic>
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace torch { namespace autograd {
 
+thread_local bool SavedVariableOffload::_enabled = false;
+thread_local int64_t SavedVariableOffload::_min_bytes = 1 << 20;
+
+static std::atomic<int64_t> num_offloaded(0);
+
+bool SavedVariableOffload::any_offloaded() {
+  return num_offloaded.load() > 0;
+}
+
+#ifdef WITH_CUDA
+namespace {
+
+// One copy stream per device, created on first use and kept for the
+// lifetime of the process
+THCStream* offload_stream(int device) {
+  static std::mutex mutex;
+  static std::unordered_map<int, THCStream*> streams;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& stream = streams[device];
+  if (!stream) {
+    AutoGPU gpu_guard(device);
+    stream = THCStream_new(cudaStreamNonBlocking);
+  }
+  return stream;
+}
+
+void stream_wait(cudaStream_t waiting, cudaStream_t on) {
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, on));
+  THCudaCheck(cudaStreamWaitEvent(waiting, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+
+} // anonymous namespace
+#endif
+
+struct SavedVariable::Offload {
+  explicit Offload(int device) : device(device) {
+    num_offloaded++;
+  }
+  ~Offload() {
+    num_offloaded--;
+  }
+
+  // prefetch() and unpack() can be called from the worker threads of
+  // different devices
+  std::mutex mutex;
+  int device;
+  // The copy issued by prefetch(), written on the offload stream
+  at::Tensor prefetched;
+};
+
+void SavedVariable::offload() {
+#ifdef WITH_CUDA
+  int device = data_.get_device();
+  AutoGPU gpu_guard(device);
+  auto stream = offload_stream(device);
+  // start once the work producing the tensor is done
+  stream_wait(stream->stream, THCState_getCurrentStream(state));
+  auto host = data_.type().toBackend(at::kCPU).tensorWithAllocator(
+      data_.sizes(), data_.strides(), std::unique_ptr<at::Allocator>(new at::PinnedMemoryAllocator()));
+  {
+    AutoStream stream_guard(stream);
+    host.copy_(data_, /*non_blocking=*/true);
+  }
+  // Once data_ is released the caching allocators may hand both buffers out
+  // again. They must wait for the copy, which runs on another stream.
+  THCCachingAllocator_recordStream(data_.storage()->data(), stream);
+  THCudaCheck(THCCachingHostAllocator_recordEvent(host.storage()->data(), stream));
+  offload_ = std::make_shared<Offload>(device);
+  data_ = std::move(host);
+#endif
+}
+
+void SavedVariable::prefetch() {
+#ifdef WITH_CUDA
+  if (!offload_) return;
+  std::lock_guard<std::mutex> lock(offload_->mutex);
+  if (offload_->prefetched.defined()) return;
+  AutoGPU gpu_guard(offload_->device);
+  auto stream = offload_stream(offload_->device);
+  // The buffer comes from the current stream's pool, where work that used it
+  // last may still be queued
+  auto device_data = data_.type().toBackend(at::kCUDA).tensor(data_.sizes(), data_.strides());
+  stream_wait(stream->stream, THCState_getCurrentStream(state));
+  {
+    AutoStream stream_guard(stream);
+    device_data.copy_(data_, /*non_blocking=*/true);
+  }
+  THCudaCheck(THCCachingHostAllocator_recordEvent(data_.storage()->data(), stream));
+  offload_->prefetched = std::move(device_data);
+#endif
+}
+
 SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
   if (variable.defined()) {
     was_default_constructed_ = false;
@@ -33,6 +134,12 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
       tracing_state_.reset(
           new jit::tracer::ValueTracingState(variable.tracing_state()));
     }
+    if (SavedVariableOffload::is_enabled() && data_.type().is_cuda() && !data_.type().is_sparse() &&
+        static_cast<int64_t>(data_.numel() * data_.type().elementSizeInBytes()) >=
+            SavedVariableOffload::min_bytes() &&
+        data_.is_contiguous()) {
+      offload();
+    }
   }
 }
 
@@ -50,6 +157,23 @@ Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
         "modified by an inplace operation");
   }
 
+  at::Tensor data = data_;
+#ifdef WITH_CUDA
+  if (offload_) {
+    std::lock_guard<std::mutex> lock(offload_->mutex);
+    AutoGPU gpu_guard(offload_->device);
+    auto current = THCState_getCurrentStream(state);
+    if (offload_->prefetched.defined()) {
+      stream_wait(current, offload_stream(offload_->device)->stream);
+      data = std::move(offload_->prefetched);
+    } else {
+      data = data_.type().toBackend(at::kCUDA).tensor(data_.sizes(), data_.strides());
+      data.copy_(data_, /*non_blocking=*/true);
+      THCudaCheck(THCCachingHostAllocator_recordEvent(data_.storage()->data(), THCState_getStream(state)));
+    }
+  }
+#endif
+
   auto grad_fn = grad_fn_;
   if (has_grad_fn_ && !grad_fn) {
     if (!saved_for) {
@@ -65,9 +189,9 @@ Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
   // in-place functions on unpacked variables.
   Variable var;
   if (grad_fn) {
-    var = make_variable(data_, Edge(std::move(grad_fn), output_nr_));
+    var = make_variable(data, Edge(std::move(grad_fn), output_nr_));
   } else {
-    var = make_variable(data_, requires_grad_);
+    var = make_variable(data, requires_grad_);
   }
   var.set_version_counter(saved_version_);
 
@@ -16,6 +16,31 @@ struct Function;
 
 extern const char* ERR_BACKWARD_TWICE;
 
+/// Opt-in policy for keeping large saved CUDA tensors in pinned host memory
+/// until backward needs them. Like `GradMode`, it applies to the variables
+/// saved by the current thread.
+struct SavedVariableOffload {
+  static bool is_enabled() {
+    return _enabled;
+  }
+  static void set_enabled(bool enabled) {
+    _enabled = enabled;
+  }
+  /// Only tensors of at least this many bytes are offloaded.
+  static int64_t min_bytes() {
+    return _min_bytes;
+  }
+  static void set_min_bytes(int64_t min_bytes) {
+    _min_bytes = min_bytes;
+  }
+  /// True while any offloaded variable is alive, so the engine only looks
+  /// for variables to prefetch when there can be some.
+  static bool any_offloaded();
+private:
+  static thread_local bool _enabled;
+  static thread_local int64_t _min_bytes;
+};
+
 /// A snapshot of a variable at a certain version. A `SavedVariable` stores
 /// enough information to reconstruct a variable from a certain point in time.
 class SavedVariable {
@@ -31,11 +56,22 @@ class SavedVariable {
   Variable unpack(std::shared_ptr<Function> saved_for = nullptr) const;
 
   void reset_data() {
+    offload_.reset();
     return data_.reset();
   }
 
+  /// If the data was offloaded to the host, starts copying it back to its
+  /// device on a side stream, so that `unpack()` only has to wait for it.
+  void prefetch();
+
  private:
+  struct Offload;
+
+  void offload();
+
   at::Tensor data_;
+  // Set when data_ is a pinned host copy of a CUDA tensor
+  std::shared_ptr<Offload> offload_;
 
   // The gradient function associated with this node. If has_grad_fn
   // is false, then this is a leaf node. Note that the grad_fn is not saved if
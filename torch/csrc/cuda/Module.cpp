@@ -8,6 +8,11 @@
 #include <TH/TH.h>
 #include <ATen/ATen.h>
 #include <THC/THCCachingAllocator.h>
+#include <THC/THCCachingHostAllocator.h>
+#include <THC/THCIpcMemHandleCache.h>
+#ifdef WITH_CUDNN
+#include <ATen/cudnn/Workspace.h>
+#endif
 #ifdef WITH_NCCL
 #include <nccl.h>
 #endif
@@ -241,8 +246,12 @@ PyObject * THCPModule_cudaUnlockMutex(PyObject *module)
 PyObject * THCPModule_emptyCache(PyObject *_unused)
 {
   HANDLE_TH_ERRORS
+#ifdef WITH_CUDNN
+  at::native::releaseCudnnWorkspaces();
+#endif
   auto device_allocator = THCState_getDeviceAllocator(state);
   THCudaCheck(device_allocator->emptyCache(device_allocator->state));
+  THCudaCheck(THCIpcMemHandleCache_emptyCache());
   END_HANDLE_TH_ERRORS
   Py_RETURN_NONE;
 }
@@ -287,6 +296,97 @@ PyObject * THCPModule_maxMemoryCached(PyObject *_unused, PyObject *arg)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject * THCPModule_numCudaMallocs(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "invalid argument to num_cuda_mallocs");
+  int device = (int) THPUtils_unpackLong(arg);
+  auto num_cuda_mallocs = THCCachingAllocator_numCudaMallocs(device);
+  return PyLong_FromUnsignedLongLong(num_cuda_mallocs);
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_setCrossStreamReuse(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "set_cross_stream_reuse expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  THCCachingAllocator_setCrossStreamReuse(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_setDeterministicAccumulation(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "set_deterministic_accumulation expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  THCState_setDeterministicAccumulation(state, arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_getDeterministicAccumulation(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  return PyBool_FromLong(THCState_getDeterministicAccumulation(state));
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_setTensorOpFloatMath(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "set_tensor_op_float_math expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  THCState_setTensorOpFloatMath(state, arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_getTensorOpFloatMath(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  return PyBool_FromLong(THCState_getTensorOpFloatMath(state));
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_memoryFragmentationStats(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "invalid argument to memory_fragmentation_stats");
+  int device = (int) THPUtils_unpackLong(arg);
+  THCCachingAllocatorFreeStats stats;
+  THCCachingAllocator_freeBlockStats(device, &stats);
+  py::dict size_classes;
+  for (int i = 0; i < THC_CACHING_ALLOCATOR_SIZE_CLASSES; i++) {
+    if (stats.size_class_blocks[i] == 0) continue;
+    size_classes[py::int_(uint64_t(1) << i)] = py::make_tuple(
+        stats.size_class_blocks[i], stats.size_class_bytes[i]);
+  }
+  py::dict result;
+  result["free_blocks"] = py::int_(stats.num_free_blocks);
+  result["free_bytes"] = py::int_(stats.amount_free);
+  result["largest_free_block"] = py::int_(stats.largest_free_block);
+  result["size_classes"] = size_classes;
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_hostMemoryStats(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  THCCachingHostAllocatorStats stats;
+  THCCachingHostAllocator_getStats(&stats);
+  py::dict result;
+  result["allocated_bytes"] = py::int_(stats.allocated_bytes);
+  result["cached_bytes"] = py::int_(stats.cached_bytes);
+  result["arena_bytes"] = py::int_(stats.arena_bytes);
+  result["allocations"] = py::int_(stats.allocations);
+  result["cache_hits"] = py::int_(stats.cache_hits);
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Cuda module initialization
 ////////////////////////////////////////////////////////////////////////////////
@@ -402,6 +502,14 @@ static struct PyMethodDef _THCPModule_methods[] = {
   {"_cuda_maxMemoryAllocated", (PyCFunction) THCPModule_maxMemoryAllocated, METH_O,  NULL},
   {"_cuda_memoryCached", (PyCFunction) THCPModule_memoryCached, METH_O,  NULL},
   {"_cuda_maxMemoryCached", (PyCFunction) THCPModule_maxMemoryCached, METH_O,  NULL},
+  {"_cuda_numCudaMallocs", (PyCFunction) THCPModule_numCudaMallocs, METH_O,  NULL},
+  {"_cuda_setCrossStreamReuse", (PyCFunction) THCPModule_setCrossStreamReuse, METH_O,  NULL},
+  {"_cuda_setDeterministicAccumulation", (PyCFunction) THCPModule_setDeterministicAccumulation, METH_O,  NULL},
+  {"_cuda_getDeterministicAccumulation", (PyCFunction) THCPModule_getDeterministicAccumulation, METH_NOARGS,  NULL},
+  {"_cuda_setTensorOpFloatMath", (PyCFunction) THCPModule_setTensorOpFloatMath, METH_O,  NULL},
+  {"_cuda_getTensorOpFloatMath", (PyCFunction) THCPModule_getTensorOpFloatMath, METH_NOARGS,  NULL},
+  {"_cuda_memoryFragmentationStats", (PyCFunction) THCPModule_memoryFragmentationStats, METH_O,  NULL},
+  {"_cuda_hostMemoryStats", (PyCFunction) THCPModule_hostMemoryStats, METH_NOARGS,  NULL},
   {"_cuda_manualSeed",  (PyCFunction)THCPModule_manualSeed,       METH_O,       NULL},
   {"_cuda_manualSeedAll", (PyCFunction)THCPModule_manualSeedAll,  METH_O,       NULL},
   {"_cuda_seed",        (PyCFunction)THCPModule_seed,             METH_NOARGS,  NULL},
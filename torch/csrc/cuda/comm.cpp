@@ -2,6 +2,8 @@
 
 #include "torch/csrc/utils/tensor_flatten.h"
 #include "torch/csrc/utils/auto_gpu.h"
+#include "torch/csrc/utils/auto_stream.h"
+#include "torch/csrc/utils/functional.h"
 #include "torch/csrc/cuda/device_set.h"
 #ifdef WITH_NCCL
 #include "torch/csrc/cuda/nccl.h"
@@ -9,6 +11,11 @@
 
 #include <ATen/ATen.h>
 
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
 namespace torch { namespace cuda {
 
 using namespace at;
@@ -27,6 +34,131 @@ struct unique_type_checker {
   bool unique = true;
 };
 
+#ifdef WITH_NCCL
+namespace {
+
+// The chunks of the coalesced collectives are handed in turn to
+// kNumChunkStreams side streams of every device, so that flattening a chunk
+// overlaps with the collective of the previous one.
+constexpr std::size_t kNumChunkStreams = 2;
+
+void stream_wait(cudaStream_t waiter, cudaStream_t waitee) {
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, waitee));
+  THCudaCheck(cudaStreamWaitEvent(waiter, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+
+// Side streams of the devices, created on first use and kept for the
+// lifetime of the process
+THCStream* side_stream(int64_t device, std::size_t index) {
+  static std::mutex mutex;
+  static std::unordered_map<int64_t, std::array<THCStream*, kNumChunkStreams>> streams;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = streams.find(device);
+  if (it == streams.end()) {
+    AutoGPU gpu_guard(device);
+    std::array<THCStream*, kNumChunkStreams> device_streams;
+    for (auto& stream : device_streams) {
+      stream = THCStream_new(cudaStreamNonBlocking);
+    }
+    it = streams.emplace(device, device_streams).first;
+  }
+  return it->second[index];
+}
+
+// The side streams used by a coalesced collective. They start after the
+// work already issued on the current streams of the devices, and join()
+// makes the current streams wait for them.
+//
+// Tensors used on the side streams are allocated with the current streams,
+// and have to be kept alive until join(): otherwise the caching allocator
+// could hand their memory out on the current stream while a side stream
+// still uses it.
+struct ChunkStreams {
+  explicit ChunkStreams(IntList devices)
+    : devices(devices.begin(), devices.end())
+    , streams(kNumChunkStreams) {
+    AutoGPU gpu_guard;
+    for (auto device : this->devices) {
+      gpu_guard.setDevice(device);
+      auto current = THCState_getCurrentStreamOnDevice(state, device);
+      for (std::size_t i = 0; i < kNumChunkStreams; ++i) {
+        auto stream = side_stream(device, i);
+        stream_wait(stream->stream, current);
+        streams[i].push_back(stream);
+      }
+    }
+  }
+
+  const nccl::stream_list& get(std::size_t chunk) {
+    used = std::max(used, std::min(chunk + 1, kNumChunkStreams));
+    return streams[chunk % kNumChunkStreams];
+  }
+
+  void join() {
+    AutoGPU gpu_guard;
+    for (std::size_t d = 0; d < devices.size(); ++d) {
+      gpu_guard.setDevice(devices[d]);
+      auto current = THCState_getCurrentStreamOnDevice(state, devices[d]);
+      for (std::size_t i = 0; i < used; ++i) {
+        stream_wait(current, streams[i][d]->stream);
+      }
+    }
+    keep_alive.clear();
+  }
+
+  std::vector<int64_t> devices;
+  std::vector<nccl::stream_list> streams;
+  std::size_t used = 0;
+  std::vector<Tensor> keep_alive;
+};
+
+// Returns true if the tensors are contiguous and laid out back to back in
+// the same storage, e.g. slices of a flat parameter buffer
+bool is_packed(const std::vector<Tensor>& tensors) {
+  for (auto& tensor : tensors) {
+    if (tensor.numel() == 0 || !tensor.is_contiguous()) {
+      return false;
+    }
+  }
+  auto storage = tensors[0].storage();
+  int64_t offset = tensors[0].storageOffset();
+  for (auto& tensor : tensors) {
+    if (tensor.storageOffset() != offset ||
+        tensor.storage()->data() != storage->data()) {
+      return false;
+    }
+    offset += tensor.numel();
+  }
+  return true;
+}
+
+// Flattens the tensors into a 1-d tensor on `stream`. Packed tensors are
+// viewed as one instead, without a copy: when the same tensors are
+// coalesced again and again (e.g. the parameters of a module), keeping them
+// in one flat buffer makes the flatten kernels go away.
+Tensor flatten_on_stream(const std::vector<Tensor>& tensors, THCStream* stream,
+                         ChunkStreams& chunk_streams) {
+  int64_t numel = 0;
+  for (auto& tensor : tensors) {
+    numel += tensor.numel();
+  }
+  if (is_packed(tensors)) {
+    return tensors[0].as_strided({numel}, {1});
+  }
+  AutoGPU gpu_guard(tensors[0]);
+  auto flat = tensors[0].type().tensor({numel});
+  chunk_streams.keep_alive.push_back(flat);
+  AutoStream stream_guard(stream);
+  at::cat_out(flat, fmap(tensors, [](const Tensor& t) { return t.contiguous().view({-1}); }), 0);
+  return flat;
+}
+
+} // anonymous namespace
+#endif
+
 std::vector<Tensor> broadcast(const Tensor& tensor, IntList devices) {
   auto & type = tensor.type();
   if (type.is_cuda() && tensor.get_device() != devices[0])
@@ -66,6 +198,10 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, std::size
   for (auto & o : outputs)
     o.reserve(tensors.size());
 
+#ifdef WITH_NCCL
+  ChunkStreams chunk_streams(devices);
+  std::size_t num_dense_chunks = 0;
+#endif
   unique_type_checker type_checker;
   for (auto & chunk : utils::take_tensors(tensors, buffer_size)) {
     auto & type = chunk.type();
@@ -86,8 +222,24 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, std::size
       }
     } else {
       AutoGPU auto_gpu(devices[0]);
+#ifdef WITH_NCCL
+      // Flatten on the side stream of the chunk, allocate the outputs on
+      // the current streams, and broadcast on the side streams
+      auto& streams = chunk_streams.get(num_dense_chunks++);
+      std::vector<Tensor> results;
+      results.reserve(devices.size());
+      results.push_back(flatten_on_stream(chunk.tensors, streams[0], chunk_streams));
+      for (std::size_t i = 1, num_devices = devices.size(); i < num_devices; ++i) {
+        auto_gpu.setDevice(devices[i]);
+        results.push_back(type.tensor(results[0].sizes()));
+      }
+      chunk_streams.keep_alive.insert(chunk_streams.keep_alive.end(),
+                                      results.begin(), results.end());
+      nccl::broadcast(results, streams);
+#else
       std::vector<Tensor> results = broadcast(utils::flatten_dense_tensors(chunk.tensors),
                                               devices);
+#endif
       for (std::size_t i = 1, num_devices = devices.size(); i < num_devices; ++i) {
         auto_gpu.setDevice(devices[i]);
         auto & device_outputs = outputs[i];
@@ -97,6 +249,10 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, std::size
     }
   }
 
+#ifdef WITH_NCCL
+  chunk_streams.join();
+#endif
+
   // If we only saw a single tensor type, then we can skip expensive reordering
   if (!type_checker.unique) {
     for (auto & o : outputs)
@@ -105,4 +261,78 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, std::size
   return outputs;
 }
 
+std::vector<Tensor> reduce_add_coalesced(const tensor_list2d& inputs,
+                                         int64_t destination,
+                                         std::size_t buffer_size) {
+#ifdef WITH_NCCL
+  if (inputs.empty() || inputs[0].empty()) {
+    return {};
+  }
+  std::vector<int64_t> devices;
+  int32_t root = -1;
+  for (auto & device_inputs : inputs) {
+    if (device_inputs.size() != inputs[0].size()) {
+      throw std::runtime_error("every device should have the same number of tensors");
+    }
+    auto device = device_inputs[0].get_device();
+    if (!std::all_of(device_inputs.begin(), device_inputs.end(),
+                     [&](const at::Tensor& t) { return t.get_device() == device; })) {
+      throw std::runtime_error("the tensors of each list should be on the same device");
+    }
+    if (device == destination) {
+      root = devices.size();
+    }
+    devices.push_back(device);
+  }
+  if (root < 0) {
+    throw std::runtime_error("destination should be the device of one of the tensor lists");
+  }
+
+  // The chunks are the same on every device, since take_tensors only
+  // depends on the types and the sizes
+  std::vector<std::vector<utils::TensorGroup>> chunks;
+  chunks.reserve(inputs.size());
+  for (auto & device_inputs : inputs) {
+    chunks.push_back(utils::take_tensors(device_inputs, buffer_size));
+  }
+
+  ChunkStreams chunk_streams(devices);
+  std::vector<Tensor> outputs;
+  outputs.reserve(inputs[0].size());
+  unique_type_checker type_checker;
+  AutoGPU auto_gpu;
+  for (std::size_t c = 0, num_chunks = chunks[0].size(); c < num_chunks; ++c) {
+    type_checker.show(chunks[root][c].type());
+    auto& streams = chunk_streams.get(c);
+    std::vector<Tensor> flat_inputs;
+    std::vector<Tensor> flat_outputs;
+    for (std::size_t i = 0; i < devices.size(); ++i) {
+      flat_inputs.push_back(flatten_on_stream(chunks[i][c].tensors, streams[i], chunk_streams));
+      // only the output of the root is written
+      if (static_cast<int32_t>(i) == root) {
+        auto_gpu.setDevice(destination);
+        flat_outputs.push_back(flat_inputs.back().type().tensor(flat_inputs.back().sizes()));
+      } else {
+        flat_outputs.push_back(flat_inputs.back());
+      }
+    }
+    chunk_streams.keep_alive.insert(chunk_streams.keep_alive.end(),
+                                    flat_inputs.begin(), flat_inputs.end());
+    chunk_streams.keep_alive.push_back(flat_outputs[root]);
+    nccl::reduce(flat_inputs, flat_outputs, root, ncclSum, streams);
+    auto_gpu.setDevice(destination);
+    for (auto & t : utils::unflatten_dense_tensors(flat_outputs[root], chunks[root][c].tensors))
+      outputs.push_back(std::move(t));
+  }
+  chunk_streams.join();
+
+  if (!type_checker.unique) {
+    utils::reorder_tensors_like(outputs, inputs[root]);
+  }
+  return outputs;
+#else
+  throw std::runtime_error("PyTorch built without NCCL support");
+#endif
+}
+
 }}
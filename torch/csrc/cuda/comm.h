@@ -10,5 +10,10 @@ using tensor_list2d = std::vector<std::vector<at::Tensor>>;
 std::vector<at::Tensor> broadcast(const at::Tensor& tensor, at::IntList devices);
 tensor_list2d broadcast_coalesced(at::TensorList tensors, at::IntList devices,
                                   std::size_t buffer_size);
+// Sums dense tensors of several devices into destination. inputs[i] are the
+// tensors of a device, with the same types and sizes on every device.
+std::vector<at::Tensor> reduce_add_coalesced(const tensor_list2d& inputs,
+                                             int64_t destination,
+                                             std::size_t buffer_size);
 
 }}
@@ -46,5 +46,11 @@ bool is_available(at::TensorList tensors);
 void broadcast(at::TensorList tensors,
                const stream_list& streams = {},
                const comm_list& user_comms = {});
+void reduce(at::TensorList inputs,
+            at::TensorList outputs,
+            int32_t root = 0,
+            int32_t op = ncclSum,
+            const stream_list& streams = {},
+            const comm_list& user_comms = {});
 
 }}}
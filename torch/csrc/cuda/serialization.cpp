@@ -3,6 +3,7 @@
 #include "THCP.h"
 
 #include "override_macros.h"
+#include "torch/csrc/utils/auto_gpu.h"
 
 #include <system_error>
 #include <memory>
@@ -8,6 +8,7 @@
 #include "THDP.h"
 #include "torch/csrc/PythonTypes.h"
 #include "torch/csrc/autograd/python_variable.h"
+#include "torch/csrc/distributed/Reducer.h"
 
 #ifdef WITH_CUDA
 #include "torch/csrc/cuda/Stream.h"
@@ -89,12 +90,13 @@ extern THCState* state;
 PyObject* THDPModule_initProcessGroup(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 5 || !THPUtils_checkString(PyTuple_GET_ITEM(args, 0)) ||
+  if (PyTuple_GET_SIZE(args) != 6 || !THPUtils_checkString(PyTuple_GET_ITEM(args, 0)) ||
         !THPUtils_checkString(PyTuple_GET_ITEM(args, 1)) ||
         !THPUtils_checkLong(PyTuple_GET_ITEM(args, 2)) ||
         !THPUtils_checkString(PyTuple_GET_ITEM(args, 3)) ||
-        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 4))) {
-    THPUtils_invalidArguments(args, NULL, "init_process_group", 1, "(string backend, string init_method, int world_size, string group_name, int rank)");
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 4)) ||
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 5))) {
+    THPUtils_invalidArguments(args, NULL, "init_process_group", 1, "(string backend, string init_method, int world_size, string group_name, int rank, int min_world_size)");
     return NULL;
   }
 
@@ -103,11 +105,13 @@ PyObject* THDPModule_initProcessGroup(PyObject *_unused, PyObject *args)
   int world_size = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 2));
   std::string group_name = THPUtils_unpackString(PyTuple_GET_ITEM(args, 3));
   int rank = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 4));
+  int min_world_size = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 5));
 
   THDChannelType channel_type = name2channel_type.at(backend_name);
   {
     AutoNoGIL nogil;
-    THDProcessGroupInit(channel_type, init_method, world_size, group_name, rank);
+    THDProcessGroupInit(channel_type, init_method, world_size, group_name, rank,
+                        min_world_size);
   }
 #ifdef WITH_CUDA
   THDSetCudaStatePtr(&state);
@@ -116,6 +120,16 @@ PyObject* THDPModule_initProcessGroup(PyObject *_unused, PyObject *args)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject* THDPModule_rebuildProcessGroup(PyObject *_unused) {
+  HANDLE_TH_ERRORS
+  {
+    AutoNoGIL nogil;
+    THDProcessGroupRebuild();
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject* THDPModule_destroyProcessGroup(PyObject *_unused) {
   HANDLE_TH_ERRORS
   {
@@ -226,6 +240,21 @@ static THDGroup _getGroup(PyObject *obj)
   return it->second;
 }
 
+// Some functions take an optional trailing bool flag (e.g. async_op of the
+// collectives) after their num_args regular arguments
+static bool _hasFlagArg(PyObject *args, Py_ssize_t num_args)
+{
+  Py_ssize_t size = PyTuple_GET_SIZE(args);
+  return size == num_args ||
+      (size == num_args + 1 && PyBool_Check(PyTuple_GET_ITEM(args, num_args)));
+}
+
+static bool _getFlagArg(PyObject *args, Py_ssize_t num_args)
+{
+  return PyTuple_GET_SIZE(args) > num_args &&
+      PyTuple_GET_ITEM(args, num_args) == Py_True;
+}
+
 PyObject* THDPModule_clearGroupCache(PyObject *_unused, PyObject *args) {
   HANDLE_TH_ERRORS
   if (PyTuple_GET_SIZE(args) != 1) {
@@ -594,14 +623,23 @@ invalid_arguments:
 PyObject* THDPModule_allReduce(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 3 || !THPVariable_Check(PyTuple_GET_ITEM(args, 0))) {
-    THPUtils_invalidArguments(args, NULL, "all_reduce", 1, "(tensor in_out, reduce_op op, group gr)");
+  if (!_hasFlagArg(args, 3) || !THPVariable_Check(PyTuple_GET_ITEM(args, 0))) {
+    THPUtils_invalidArguments(args, NULL, "all_reduce", 1,
+        "(tensor in_out, reduce_op op, group gr, bool async_op=False)");
     return NULL;
   }
 
   THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
   THDReduceOp op = _getReduceOp(PyTuple_GET_ITEM(args, 1));
   auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
+  if (_getFlagArg(args, 3)) {
+    THDRequest* req;
+    {
+      AutoNoGIL guard;
+      req = THDIallReduce(desc, op, group);
+    }
+    return THPWrapper_New(req, (void(*)(void*))THDRequest_free);
+  }
   {
     AutoNoGIL guard;
     THDAllReduce(desc, op, group);
@@ -610,6 +648,57 @@ PyObject* THDPModule_allReduce(PyObject *_unused, PyObject *args)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject* THDPModule_allReduceCompressed(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  if (PyTuple_GET_SIZE(args) != 5 || !THPVariable_Check(PyTuple_GET_ITEM(args, 0)) ||
+        (PyTuple_GET_ITEM(args, 1) != Py_None &&
+         !THPVariable_Check(PyTuple_GET_ITEM(args, 1))) ||
+        !THPUtils_checkLong(PyTuple_GET_ITEM(args, 2)) ||
+        !THPUtils_checkDouble(PyTuple_GET_ITEM(args, 3))) {
+    THPUtils_invalidArguments(args, NULL, "all_reduce_compressed", 1,
+        "(tensor in_out, tensor residual, int compression, float ratio, group gr)");
+    return NULL;
+  }
+
+  THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 4));
+  auto compression = static_cast<THDCompression>(THPUtils_unpackLong(PyTuple_GET_ITEM(args, 2)));
+  double ratio = THPUtils_unpackDouble(PyTuple_GET_ITEM(args, 3));
+  auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
+  THDTensorDescriptor residual;
+  if (PyTuple_GET_ITEM(args, 1) != Py_None) {
+    residual = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 1));
+  }
+  {
+    AutoNoGIL guard;
+    THDAllReduceCompressed(desc, residual, compression, ratio, group);
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject* THDPModule_allReduceSparse(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  if (PyTuple_GET_SIZE(args) != 3 || !THPVariable_Check(PyTuple_GET_ITEM(args, 0)) ||
+        !THPUtils_checkDouble(PyTuple_GET_ITEM(args, 1))) {
+    THPUtils_invalidArguments(args, NULL, "all_reduce_sparse", 1,
+        "(tensor input, float density_threshold, group gr)");
+    return NULL;
+  }
+
+  THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
+  double density_threshold = THPUtils_unpackDouble(PyTuple_GET_ITEM(args, 1));
+  auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
+  at::Tensor result;
+  {
+    AutoNoGIL guard;
+    result = THDAllReduceSparse(desc, density_threshold, group);
+  }
+  return THPVariable_Wrap(torch::autograd::make_variable(result));
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject* THDPModule_reduce(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
@@ -635,16 +724,24 @@ PyObject* THDPModule_reduce(PyObject *_unused, PyObject *args)
 PyObject* THDPModule_broadcast(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
-  if (PyTuple_GET_SIZE(args) != 3 || !THPVariable_Check(PyTuple_GET_ITEM(args, 0)) ||
+  if (!_hasFlagArg(args, 3) || !THPVariable_Check(PyTuple_GET_ITEM(args, 0)) ||
         !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1))) {
     THPUtils_invalidArguments(args, NULL, "broadcast", 1,
-        "(tensor src_dst, int src_rank, group gr)");
+        "(tensor src_dst, int src_rank, group gr, bool async_op=False)");
     return NULL;
   }
 
   THDGroup group = _getGroup(PyTuple_GET_ITEM(args, 2));
   auto desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 0));
   int src_rank = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  if (_getFlagArg(args, 3)) {
+    THDRequest* req;
+    {
+      AutoNoGIL guard;
+      req = THDIbroadcast(desc, src_rank, group);
+    }
+    return THPWrapper_New(req, (void(*)(void*))THDRequest_free);
+  }
   {
     AutoNoGIL guard;
     THDBroadcast(desc, src_rank, group);
@@ -663,7 +760,7 @@ PyObject* THDPModule_allGather(PyObject *_unused, PyObject *args)
   THDGroup group;
   at::Tensor desc;
 
-  if (PyTuple_GET_SIZE(args) != 3 ||
+  if (!_hasFlagArg(args, 3) ||
       !PySequence_Check(PyTuple_GET_ITEM(args, 0)) ||
       !THPVariable_Check(PyTuple_GET_ITEM(args, 1))) {
 
@@ -692,6 +789,14 @@ PyObject* THDPModule_allGather(PyObject *_unused, PyObject *args)
 
   group = _getGroup(PyTuple_GET_ITEM(args, 2));
   desc = THDPModule_makeDescriptor(PyTuple_GET_ITEM(args, 1));
+  if (_getFlagArg(args, 3)) {
+    THDRequest* req;
+    {
+      AutoNoGIL guard;
+      req = THDIallGather(raw_descriptors.data(), length, desc, group);
+    }
+    return THPWrapper_New(req, (void(*)(void*))THDRequest_free);
+  }
   {
     AutoNoGIL guard;
     THDAllGather(raw_descriptors.data(), length, desc, group);
@@ -700,7 +805,7 @@ PyObject* THDPModule_allGather(PyObject *_unused, PyObject *args)
 
 invalid_arguments:
   THPUtils_invalidArguments(args, NULL, "allGather", 1,
-      "(list[tensor] output, tensor input, group gr)");
+      "(list[tensor] output, tensor input, group gr, bool async_op=False)");
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
 }
@@ -865,11 +970,13 @@ PyObject* THDPModule_newGroup(PyObject *_unused, PyObject *args)
   THPObjectPtr sequence;
   std::size_t length;
   std::vector<int> ranks;
+  bool hierarchical;
 
-  if (PyTuple_GET_SIZE(args) != 1 ||
+  if (!_hasFlagArg(args, 1) ||
       !PySequence_Check(PyTuple_GET_ITEM(args, 0))) {
     goto invalid_arguments;
   }
+  hierarchical = _getFlagArg(args, 1);
 
   sequence = THPObjectPtr(PySequence_Fast(PyTuple_GET_ITEM(args, 0),
                                           "expected a sequence"));
@@ -895,12 +1002,14 @@ PyObject* THDPModule_newGroup(PyObject *_unused, PyObject *args)
   THDGroup group;
   {
     AutoNoGIL guard;
-    group = THDNewGroup(ranks.data(), length);
+    group = hierarchical ? THDNewHierarchicalGroup(ranks.data(), length)
+                         : THDNewGroup(ranks.data(), length);
   }
   return PyInt_FromLong(group);
 
 invalid_arguments:
-  THPUtils_invalidArguments(args, NULL, "newGroup", 1, "(list[int] ranks)");
+  THPUtils_invalidArguments(args, NULL, "newGroup", 1,
+      "(list[int] ranks, bool hierarchical=False)");
   return NULL;
   END_HANDLE_TH_ERRORS
 }
@@ -933,6 +1042,57 @@ PyObject* THDPModule_requestWait(PyObject *_unused, PyObject *_req)
   END_HANDLE_TH_ERRORS
 }
 
+static void _freeReducer(void *reducer)
+{
+  delete static_cast<std::shared_ptr<torch::distributed::Reducer>*>(reducer);
+}
+
+PyObject* THDPModule_newReducer(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  THPObjectPtr sequence;
+  std::size_t length;
+  std::vector<torch::autograd::Variable> params;
+  std::size_t bucket_bytes_cap;
+  THDGroup group;
+  std::shared_ptr<torch::distributed::Reducer> reducer;
+
+  if (PyTuple_GET_SIZE(args) != 3 ||
+      !PySequence_Check(PyTuple_GET_ITEM(args, 0)) ||
+      !THPUtils_checkLong(PyTuple_GET_ITEM(args, 1))) {
+    goto invalid_arguments;
+  }
+
+  sequence = THPObjectPtr(PySequence_Fast(PyTuple_GET_ITEM(args, 0),
+                                          "expected a sequence"));
+  if (!sequence.get()) {
+    goto invalid_arguments;
+  }
+
+  length = static_cast<std::size_t>(PySequence_Fast_GET_SIZE(sequence.get()));
+  params.reserve(length);
+  for (std::size_t i = 0; i < length; ++i) {
+    PyObject *param = PySequence_Fast_GET_ITEM(sequence.get(), i);
+    if (!THPVariable_Check(param))
+      goto invalid_arguments;
+    params.push_back(((THPVariable*)param)->cdata);
+  }
+
+  bucket_bytes_cap = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  group = _getGroup(PyTuple_GET_ITEM(args, 2));
+  reducer = torch::distributed::Reducer::create(std::move(params),
+                                                bucket_bytes_cap, group);
+  return THPWrapper_New(
+      new std::shared_ptr<torch::distributed::Reducer>(std::move(reducer)),
+      _freeReducer);
+
+invalid_arguments:
+  THPUtils_invalidArguments(args, NULL, "newReducer", 1,
+      "(list[tensor] params, int bucket_bytes_cap, group gr)");
+  return NULL;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject* THDPModule_initExtension(PyObject *_unused, PyObject *args) {
   if (PyTuple_GET_SIZE(args) != 3) {
     THPUtils_invalidArguments(args, NULL, "initExtension", 1, "(bool is_master_worker, reduce_op obj, group obj)");
@@ -978,6 +1138,7 @@ PyObject* THDPModule_initExtension(PyObject *_unused, PyObject *args) {
 static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_init_extension", (PyCFunction)THDPModule_initExtension, METH_VARARGS, NULL},
   {"_dist_init_process_group", (PyCFunction)THDPModule_initProcessGroup, METH_VARARGS, NULL},
+  {"_dist_rebuild_process_group", (PyCFunction)THDPModule_rebuildProcessGroup, METH_NOARGS, NULL},
   {"_dist_destroy_process_group", (PyCFunction)THDPModule_destroyProcessGroup, METH_NOARGS, NULL},
   {"_dist_clear_group_cache", (PyCFunction)THDPModule_clearGroupCache, METH_VARARGS, NULL},
   {"_dist_init_master_worker", (PyCFunction)THDPModule_initMasterWorker, METH_VARARGS, NULL},
@@ -992,6 +1153,8 @@ static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_recv_any_source", (PyCFunction)THDPModule_recvAnySource, METH_O, NULL},
   {"_dist_recv", (PyCFunction)THDPModule_recv, METH_VARARGS, NULL},
   {"_dist_all_reduce", (PyCFunction)THDPModule_allReduce, METH_VARARGS, NULL},
+  {"_dist_all_reduce_compressed", (PyCFunction)THDPModule_allReduceCompressed, METH_VARARGS, NULL},
+  {"_dist_all_reduce_sparse", (PyCFunction)THDPModule_allReduceSparse, METH_VARARGS, NULL},
   {"_dist_all_reduce_multigpu", (PyCFunction)THDPModule_allReduceMultiGPU, METH_VARARGS, NULL},
   {"_dist_reduce", (PyCFunction)THDPModule_reduce, METH_VARARGS, NULL},
   {"_dist_reduce_multigpu", (PyCFunction)THDPModule_reduceMultiGPU, METH_VARARGS, NULL},
@@ -1007,6 +1170,7 @@ static struct PyMethodDef _THDPModule_methods[] = {
   {"_dist_new_group", (PyCFunction)THDPModule_newGroup, METH_VARARGS, NULL},
   {"_dist_request_is_completed", (PyCFunction)THDPModule_requestIsCompleted, METH_O, NULL},
   {"_dist_request_wait", (PyCFunction)THDPModule_requestWait, METH_O, NULL},
+  {"_dist_new_reducer", (PyCFunction)THDPModule_newReducer, METH_VARARGS, NULL},
   {NULL}
 };
 
@@ -0,0 +1,185 @@
+#include "torch/csrc/distributed/Reducer.h"
+
+#include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/function_hook.h"
+#include "torch/csrc/utils/auto_gpu.h"
+#include "torch/csrc/utils/tensor_flatten.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace torch { namespace distributed {
+
+using autograd::Variable;
+using autograd::variable_list;
+
+struct ReducerHook : autograd::FunctionPostHook {
+  ReducerHook(std::weak_ptr<Reducer> reducer, std::size_t param_index)
+    : reducer_(std::move(reducer)), param_index_(param_index) {}
+
+  variable_list operator()(const variable_list& grad_input,
+                           const variable_list& grad_output) override {
+    if (auto reducer = reducer_.lock()) {
+      reducer->mark_ready(param_index_);
+    }
+    return grad_input;
+  }
+
+private:
+  std::weak_ptr<Reducer> reducer_;
+  std::size_t param_index_;
+};
+
+std::shared_ptr<Reducer> Reducer::create(
+    std::vector<Variable> params,
+    std::size_t bucket_bytes_cap,
+    THDGroup group) {
+  std::shared_ptr<Reducer> reducer(
+      new Reducer(std::move(params), bucket_bytes_cap, group));
+  reducer->register_hooks();
+  return reducer;
+}
+
+Reducer::Reducer(std::vector<Variable> params,
+                 std::size_t bucket_bytes_cap,
+                 THDGroup group)
+  : params_(std::move(params))
+  , bucket_of_(params_.size())
+  , ready_(params_.size(), false)
+  , group_(group) {
+  // Gradients come out of backward roughly in the reverse order of the
+  // parameters, fill the buckets in that order. A bucket only holds
+  // tensors of one type, so that it can be flattened.
+  // type -> (bucket index, bytes in the bucket)
+  std::unordered_map<at::Type*, std::pair<std::size_t, std::size_t>> open_buckets;
+  for (std::size_t i = params_.size(); i-- > 0;) {
+    auto& param = params_[i];
+    if (!param.requires_grad()) {
+      throw std::runtime_error("Reducer: all the parameters should require grad");
+    }
+    auto* type = &param.data().type();
+    std::size_t bytes = param.numel() * type->elementSizeInBytes();
+    auto it = open_buckets.find(type);
+    if (it == open_buckets.end() || it->second.second + bytes > bucket_bytes_cap) {
+      buckets_.emplace_back();
+      open_buckets[type] = std::make_pair(buckets_.size() - 1, 0);
+      it = open_buckets.find(type);
+    }
+    auto& bucket = buckets_[it->second.first];
+    bucket.params.push_back(i);
+    bucket.pending++;
+    bucket_of_[i] = it->second.first;
+    it->second.second += bytes;
+  }
+}
+
+Reducer::~Reducer() {
+  for (auto& bucket : buckets_) {
+    if (bucket.request) {
+      THDRequest_wait(bucket.request);
+      THDRequest_free(bucket.request);
+    }
+  }
+}
+
+void Reducer::register_hooks() {
+  std::weak_ptr<Reducer> self = shared_from_this();
+  grad_accumulators_.reserve(params_.size());
+  for (std::size_t i = 0; i < params_.size(); ++i) {
+    auto grad_accumulator = params_[i].grad_accumulator();
+    grad_accumulator->add_post_hook(
+        std::unique_ptr<autograd::FunctionPostHook>(new ReducerHook(self, i)));
+    grad_accumulators_.push_back(std::move(grad_accumulator));
+  }
+}
+
+void Reducer::mark_ready(std::size_t param_index) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!finalize_queued_) {
+    std::weak_ptr<Reducer> self = shared_from_this();
+    autograd::Engine::getDefaultEngine().queue_callback([self] {
+      if (auto reducer = self.lock()) {
+        reducer->finalize();
+      }
+    });
+    finalize_queued_ = true;
+  }
+  if (ready_[param_index]) {
+    return;
+  }
+  init_grad(param_index);
+  if (params_[param_index].grad().requires_grad()) {
+    throw std::runtime_error("Reducer only works with gradients that don't "
+                             "require grad");
+  }
+  ready_[param_index] = true;
+  buckets_[bucket_of_[param_index]].pending--;
+  launch_ready_buckets();
+}
+
+void Reducer::init_grad(std::size_t param_index) {
+  auto& param = params_[param_index];
+  if (!param.grad().defined()) {
+    AutoGPU gpu_guard(param.data());
+    param.grad() = autograd::make_variable(at::zeros_like(param.data()));
+  }
+}
+
+void Reducer::launch_ready_buckets() {
+  // Buckets can fill up in any order when backward runs on several threads,
+  // but they are launched in order on every process.
+  while (next_bucket_ < buckets_.size() && buckets_[next_bucket_].pending == 0) {
+    launch(buckets_[next_bucket_++]);
+  }
+}
+
+void Reducer::launch(Bucket& bucket) {
+  std::vector<at::Tensor> grads;
+  grads.reserve(bucket.params.size());
+  for (auto index : bucket.params) {
+    grads.push_back(params_[index].grad().data());
+  }
+  AutoGPU gpu_guard(grads[0]);
+  bucket.flat = utils::flatten_dense_tensors(grads);
+  bucket.flat.div_(THDGetNumProcesses());
+  bucket.request = THDIallReduce(bucket.flat, THDReduceSUM, group_);
+}
+
+void Reducer::finalize() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Parameters that weren't used in this backward contribute zeros
+  for (std::size_t i = 0; i < params_.size(); ++i) {
+    if (ready_[i]) {
+      continue;
+    }
+    init_grad(i);
+    ready_[i] = true;
+    buckets_[bucket_of_[i]].pending--;
+  }
+  launch_ready_buckets();
+
+  for (auto& bucket : buckets_) {
+    THDRequest_wait(bucket.request);
+    THDRequest_free(bucket.request);
+    bucket.request = nullptr;
+
+    std::vector<at::Tensor> grads;
+    grads.reserve(bucket.params.size());
+    for (auto index : bucket.params) {
+      grads.push_back(params_[index].grad().data());
+    }
+    AutoGPU gpu_guard(grads[0]);
+    auto reduced = utils::unflatten_dense_tensors(bucket.flat, grads);
+    for (std::size_t i = 0; i < grads.size(); ++i) {
+      grads[i].copy_(reduced[i]);
+    }
+    bucket.flat = at::Tensor();
+    bucket.pending = bucket.params.size();
+  }
+  std::fill(ready_.begin(), ready_.end(), false);
+  next_bucket_ = 0;
+  finalize_queued_ = false;
+}
+
+}} // namespace torch::distributed
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <THD/THD.h>
+
+#include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace torch { namespace distributed {
+
+struct ReducerHook;
+
+// Averages the gradients of a set of parameters over the processes of a
+// group while backward is still running.
+//
+// The parameters are packed in buckets of at most bucket_bytes_cap bytes, in
+// reverse order of registration, which is roughly the order in which
+// backward produces their gradients. A hook on the gradient accumulator of
+// every parameter marks it ready, and as soon as all the gradients of a
+// bucket are there they are flattened and an async allreduce is started on
+// it, so communication overlaps with the rest of backward. A callback
+// queued at the end of backward waits for the allreduces and copies the
+// averaged gradients back.
+//
+// Buckets are always reduced in the same order, so that all the processes
+// issue the same collectives in the same order. Parameters that didn't get a
+// gradient in a backward contribute zeros.
+struct Reducer : std::enable_shared_from_this<Reducer> {
+  static std::shared_ptr<Reducer> create(
+      std::vector<autograd::Variable> params,
+      std::size_t bucket_bytes_cap,
+      THDGroup group);
+
+  ~Reducer();
+
+  std::size_t num_buckets() const {
+    return buckets_.size();
+  }
+
+private:
+  friend struct ReducerHook;
+
+  struct Bucket {
+    std::vector<std::size_t> params;
+    std::size_t pending = 0;
+    at::Tensor flat;
+    THDRequest* request = nullptr;
+  };
+
+  Reducer(std::vector<autograd::Variable> params,
+          std::size_t bucket_bytes_cap,
+          THDGroup group);
+
+  void register_hooks();
+  void mark_ready(std::size_t param_index);
+  void init_grad(std::size_t param_index);
+  void launch_ready_buckets();
+  void launch(Bucket& bucket);
+  void finalize();
+
+  std::mutex mutex_;
+  std::vector<autograd::Variable> params_;
+  // the variables only keep weak references to their accumulators
+  std::vector<std::shared_ptr<autograd::Function>> grad_accumulators_;
+  std::vector<Bucket> buckets_;
+  std::vector<std::size_t> bucket_of_;
+  std::vector<bool> ready_;
+  // buckets before this one have been launched
+  std::size_t next_bucket_ = 0;
+  bool finalize_queued_ = false;
+  THDGroup group_;
+};
+
+}} // namespace torch::distributed
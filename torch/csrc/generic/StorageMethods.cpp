@@ -197,6 +197,42 @@ static PyObject * THPStorage_(fromFile)(PyObject *_unused, PyObject *args, PyObj
   END_HANDLE_TH_ERRORS
 }
 
+#if !defined(THC_GENERIC_FILE) && !defined(THD_GENERIC_FILE)
+// Returns a storage viewing the record written by _write_file at `offset`
+// in a ByteStorage, which is usually a mapping of the whole file. The new
+// storage keeps the ByteStorage alive.
+static PyObject * THPStorage_(newWithMapping)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  PyObject *mapping_obj;
+  Py_ssize_t offset;
+  if (!PyArg_ParseTuple(args, "On", &mapping_obj, &offset)) {
+    return NULL;
+  }
+  THPUtils_assert(THPByteStorage_Check(mapping_obj), "_new_with_mapping "
+      "expected a torch.ByteStorage, but got %s", THPUtils_typename(mapping_obj));
+  THByteStorage *mapping = ((THPByteStorage*)mapping_obj)->cdata;
+
+  int64_t size;
+  THPUtils_assert(offset >= 0 && offset + (ptrdiff_t)sizeof(int64_t) <= mapping->size,
+      "_new_with_mapping: offset %ld is out of the mapping", (int64_t)offset);
+  memcpy(&size, mapping->data + offset, sizeof(int64_t));
+  offset += sizeof(int64_t);
+  if (size < 0 || size > (mapping->size - offset) / (ptrdiff_t)sizeof(real))
+    throw std::runtime_error("unexpected EOF. The file might be corrupted.");
+  THPUtils_assert(offset % sizeof(real) == 0, "_new_with_mapping: the record "
+      "at offset %ld is misaligned", (int64_t)offset);
+
+  // the data is read in place, so it has the byte order of the file
+  THStorage *storage = THStorage_(newWithDataAndAllocator)(
+      (real*)(mapping->data + offset), size, &THObjectPtrAllocator,
+      new ObjectPtrAllocator(mapping_obj, &THBorrowedAllocator, nullptr));
+  THStorage_(clearFlag)(storage, TH_STORAGE_RESIZABLE);
+  return (PyObject*)THPStorage_(New)(storage);
+  END_HANDLE_TH_ERRORS
+}
+#endif
+
 #ifndef THD_GENERIC_FILE
 PyObject * THPStorage_(writeFile)(THPStorage *self, PyObject *args)
 {
@@ -328,6 +364,7 @@ static PyMethodDef THPStorage_(methods)[] = {
 #endif // !defined(THD_GENERIC_FILE)
 #if !defined(THC_GENERIC_FILE) && !defined(THD_GENERIC_FILE)
   {"from_buffer", (PyCFunction)THPStorage_(fromBuffer), METH_VARARGS | METH_KEYWORDS | METH_STATIC, NULL},
+  {"_new_with_mapping", (PyCFunction)THPStorage_(newWithMapping), METH_VARARGS | METH_STATIC, NULL},
 #endif
   {"from_file", (PyCFunction)THPStorage_(fromFile), METH_VARARGS | METH_KEYWORDS | METH_STATIC, NULL},
 #ifdef THC_GENERIC_FILE
@@ -245,12 +245,12 @@ static PyObject * THPStorage_(shareCuda)(THPStorage *self)
   THPObjectPtr _offset(PyLong_FromLong(0));
   THPObjectPtr view_size(PyLong_FromLong(storage->size));
   if (storage->data) {
+    // the handle of the whole segment, exported once and reused for all the
+    // storages in it
     size_t base_size;
-    void *base_ptr = THCCachingAllocator_getBaseAllocation(storage->data, &base_size);
-    ptrdiff_t offset = (char*)storage->data - (char*)base_ptr;
-
     cudaIpcMemHandle_t handle;
-    THCudaCheck(cudaIpcGetMemHandle(&handle, base_ptr));
+    void *base_ptr = THCCachingAllocator_getIpcMemHandle(storage->data, &base_size, &handle);
+    ptrdiff_t offset = (char*)storage->data - (char*)base_ptr;
 
     _handle = PyBytes_FromStringAndSize((char *)&handle, CUDA_IPC_HANDLE_SIZE);
     _offset = PyLong_FromSsize_t((Py_ssize_t)offset);
@@ -300,8 +300,9 @@ static PyObject * THPStorage_(newSharedCuda)(PyObject *_unused, PyObject *args)
   THPUtils_assert(handle_size == CUDA_IPC_HANDLE_SIZE, "incorrect handle size");
   cudaIpcMemHandle_t handle = *(cudaIpcMemHandle_t*)buffer;
 
-  void *devPtr = NULL;
-  THCudaCheck(cudaIpcOpenMemHandle(&devPtr, handle, cudaIpcMemLazyEnablePeerAccess));
+  // segments stay open after their last storage is freed, see
+  // THCIpcMemHandleCache.h
+  void *devPtr = THCIpcMemHandleCache_open(device, handle);
 
   THStoragePtr base(THStorage_(newWithDataAndAllocator)(
       LIBRARY_STATE (real*)devPtr, storage_size, &THCIpcAllocator, (void*)device));
@@ -62,40 +62,18 @@ void THPStorage_(writeFileRaw)(THStorage *self, io fd)
 template void THPStorage_(writeFileRaw<int>)(THStorage *self, int fd);
 template void THPStorage_(writeFileRaw<PyObject*>)(THStorage *self, PyObject* fd);
 
+// Reads `count` elements, stored little endian in the file, into host memory
 template <class io>
-THStorage * THPStorage_(readFileRaw)(io file, THStorage *_storage)
+static void THPStorage_(readFileData)(io file, real *data, int64_t count)
 {
-  real *data;
-  int64_t size;
-  ssize_t result = doRead(file, &size, sizeof(int64_t));
-  if (result == 0)
-    throw std::runtime_error("unexpected EOF. The file might be corrupted.");
-  if (result != sizeof(int64_t))
-    throw std::system_error(result, std::system_category());
-  THStoragePtr storage;
-  if (_storage == nullptr) {
-    storage = THStorage_(newWithSize)(LIBRARY_STATE size);
-  } else {
-    THPUtils_assert(_storage->size == size,
-        "storage has wrong size: expected %ld got %ld",
-        size, _storage->size);
-    storage = _storage;
-  }
-
-#ifndef THC_GENERIC_FILE
-  data = storage->data;
-#else
-  std::unique_ptr<char[]> cpu_data(new char[size * sizeof(real)]);
-  data = (real*)cpu_data.get();
-#endif
-
   // fast track for bytes and little endian
   if (sizeof(real) == 1 || THP_nativeByteOrder() == THPByteOrder::THP_LITTLE_ENDIAN) {
     char *bytes = (char *) data;
-    int64_t remaining = sizeof(real) * storage->size;
+    int64_t remaining = sizeof(real) * count;
+    ssize_t result = 0;
     while (remaining > 0) {
       // we write and read in 1GB blocks to avoid bugs on some OSes
-      ssize_t result = doRead(file, bytes, THMin(remaining, 1073741824));
+      result = doRead(file, bytes, THMin(remaining, 1073741824));
       if (result == 0) // 0 means EOF, which is also an error
         throw std::runtime_error("unexpected EOF. The file might be corrupted.");
       if (result < 0)
@@ -106,12 +84,12 @@ THStorage * THPStorage_(readFileRaw)(io file, THStorage *_storage)
     if (remaining != 0)
       throw std::system_error(result, std::system_category());
   } else {
-    int64_t buffer_size = std::min(size, (int64_t)5000);
+    int64_t buffer_size = std::min(count, (int64_t)5000);
     std::unique_ptr<uint8_t[]> le_buffer(new uint8_t[buffer_size * sizeof(real)]);
 
 
-    for (int64_t i = 0; i < size; i += buffer_size) {
-      size_t to_convert = std::min(size - i, buffer_size);
+    for (int64_t i = 0; i < count; i += buffer_size) {
+      size_t to_convert = std::min(count - i, buffer_size);
       SYSCHECK(doRead(file, le_buffer.get(), sizeof(real) * to_convert));
 
       if (sizeof(real) == 2) {
@@ -132,9 +110,93 @@ THStorage * THPStorage_(readFileRaw)(io file, THStorage *_storage)
       }
     }
   }
+}
 
 #ifdef THC_GENERIC_FILE
-  THCudaCheck(cudaMemcpy(storage->data, data, size * sizeof(real), cudaMemcpyHostToDevice));
+// Reads the file in chunks into two pinned buffers, so that a chunk is
+// copied to the device on a side stream while the next one is read.
+template <class io>
+static void THPStorage_(readFileToDevice)(io file, THStorage *storage)
+{
+  struct Staging {
+    THCStream *stream = nullptr;
+    void *buffers[2] = {nullptr, nullptr};
+    cudaEvent_t copied[2] = {nullptr, nullptr};
+    cudaEvent_t allocated = nullptr;
+
+    ~Staging() {
+      // the buffers may still be read by the copies if reading failed
+      if (stream)
+        cudaStreamSynchronize(stream->stream);
+      for (int i = 0; i < 2; ++i) {
+        if (buffers[i])
+          THCCachingHostAllocator.free(nullptr, buffers[i]);
+        if (copied[i])
+          cudaEventDestroy(copied[i]);
+      }
+      if (allocated)
+        cudaEventDestroy(allocated);
+      if (stream)
+        THCStream_free(stream);
+    }
+  };
+
+  int64_t size = storage->size;
+  if (size == 0)
+    return;
+  AutoGPU gpu_guard(THCStorage_(getDevice)(LIBRARY_STATE storage));
+  int64_t chunk_size = std::min(size, std::max((int64_t)1, (int64_t)(16 << 20) / (int64_t)sizeof(real)));
+
+  Staging staging;
+  staging.stream = THCStream_new(cudaStreamNonBlocking);
+  cudaStream_t copy_stream = staging.stream->stream;
+  for (int i = 0; i < 2; ++i) {
+    staging.buffers[i] = THCCachingHostAllocator.malloc(nullptr, chunk_size * sizeof(real));
+    THCudaCheck(cudaEventCreateWithFlags(&staging.copied[i], cudaEventDisableTiming));
+  }
+  // the memory of the storage may still be used by the current stream
+  THCudaCheck(cudaEventCreateWithFlags(&staging.allocated, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(staging.allocated, THCState_getCurrentStream(LIBRARY_STATE_NOARGS)));
+  THCudaCheck(cudaStreamWaitEvent(copy_stream, staging.allocated, 0));
+
+  for (int64_t offset = 0, chunk = 0; offset < size; offset += chunk_size, ++chunk) {
+    int b = chunk % 2;
+    int64_t count = std::min(size - offset, chunk_size);
+    real *buffer = (real*)staging.buffers[b];
+    // the buffer is free once the copy of two chunks ago is done
+    THCudaCheck(cudaEventSynchronize(staging.copied[b]));
+    THPStorage_(readFileData)(file, buffer, count);
+    THCudaCheck(cudaMemcpyAsync(storage->data + offset, buffer, count * sizeof(real),
+                                cudaMemcpyHostToDevice, copy_stream));
+    THCudaCheck(cudaEventRecord(staging.copied[b], copy_stream));
+  }
+  THCudaCheck(cudaStreamSynchronize(copy_stream));
+}
+#endif
+
+template <class io>
+THStorage * THPStorage_(readFileRaw)(io file, THStorage *_storage)
+{
+  int64_t size;
+  ssize_t result = doRead(file, &size, sizeof(int64_t));
+  if (result == 0)
+    throw std::runtime_error("unexpected EOF. The file might be corrupted.");
+  if (result != sizeof(int64_t))
+    throw std::system_error(result, std::system_category());
+  THStoragePtr storage;
+  if (_storage == nullptr) {
+    storage = THStorage_(newWithSize)(LIBRARY_STATE size);
+  } else {
+    THPUtils_assert(_storage->size == size,
+        "storage has wrong size: expected %ld got %ld",
+        size, _storage->size);
+    storage = _storage;
+  }
+
+#ifndef THC_GENERIC_FILE
+  THPStorage_(readFileData)(file, storage->data, size);
+#else
+  THPStorage_(readFileToDevice)(file, storage.get());
 #endif
   return storage.release();
 }
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
+#include "ATen/optional.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/utils/hash.h"
 #include "torch/csrc/jit/variable_tensor_list.h"
@@ -71,10 +73,7 @@ struct ArgumentSpec {
     }
     // we precompute the hash_code to minimize the time inside of hash
     // table operations where we may need to hold a compiler cache lock.
-    hash_code = hash_combine(0, ntensors);
-    for(auto d : data) {
-      hash_code = hash_combine(hash_code, d);
-    }
+    computeHashCode();
   }
 
   // equality is fast: check ntensors, and then check the raw array data,
@@ -82,9 +81,107 @@ struct ArgumentSpec {
   bool operator==(const ArgumentSpec & spec) const {
     return ntensors == spec.ntensors && data == spec.data;
   }
+  // same as ArgumentSpec(with_grad, tensors) == *this, but it compares the
+  // tensors against this spec directly, without allocating or hashing a new
+  // spec, and stops at the first mismatch.
+  bool matches(bool with_grad, const variable_tensor_list & tensors) const {
+    if(tensors.size() != ntensors)
+      return false;
+    auto pods = tensor_info();
+    const int64_t * next_dim = sizes_strides();
+    uint32_t total_dims = 0;
+    for(size_t i = 0; i < ntensors; i++) {
+      const auto & t = tensors[i];
+      const auto & pod = pods[i];
+      if(pod.defined != t.defined())
+        return false;
+      if(t.defined()) {
+        if(pod.type != static_cast<unsigned int>(t.type().scalarType()) ||
+           pod.device != ((!t.type().is_cuda()) ? -1 : t.get_device()) ||
+           pod.requires_grad != (with_grad && static_cast<const autograd::Variable&>(t).requires_grad()))
+          return false;
+        auto sizes = t.sizes();
+        total_dims += sizes.size();
+        // also guarantees there are enough dimensions left to compare against
+        if(pod.total_dims != total_dims)
+          return false;
+        if(!std::equal(sizes.begin(), sizes.end(), next_dim))
+          return false;
+        next_dim += sizes.size();
+        auto strides = t.strides();
+        if(!std::equal(strides.begin(), strides.end(), next_dim))
+          return false;
+        next_dim += strides.size();
+      } else if(pod.total_dims != total_dims) {
+        return false;
+      }
+    }
+    return true;
+  }
   bool operator!=(const ArgumentSpec & spec) const {
     return !(*this == spec);
   }
+  // The symbolic signature of this spec: the sizes other than 0 and 1 are
+  // replaced by symbols, numbered in order of first appearance, so that equal
+  // sizes get the same symbol, and the strides are dropped. The sizes the
+  // symbols stand for are appended to symbol_sizes.
+  // Only specs of contiguous tensors have one, since their strides follow
+  // from their sizes.
+  at::optional<ArgumentSpec> symbolic(std::vector<int64_t> & symbol_sizes) const {
+    ArgumentSpec spec = *this;
+    auto pods = tensor_info();
+    int64_t * next_dim = spec.sizes_strides();
+    uint32_t total_dims = 0;
+    for(size_t i = 0; i < ntensors; i++) {
+      size_t ndim = pods[i].total_dims - total_dims;
+      total_dims = pods[i].total_dims;
+      int64_t * sizes = next_dim;
+      int64_t * strides = next_dim + ndim;
+      int64_t expected_stride = 1;
+      for(size_t d = ndim; d-- > 0;) {
+        if(strides[d] != expected_stride)
+          return at::nullopt;
+        expected_stride *= sizes[d];
+        strides[d] = 0;
+      }
+      for(size_t d = 0; d < ndim; d++) {
+        int64_t size = sizes[d];
+        if(size <= 1)
+          continue;
+        auto it = std::find(symbol_sizes.begin(), symbol_sizes.end(), size);
+        sizes[d] = -1 - (it - symbol_sizes.begin());
+        if(it == symbol_sizes.end())
+          symbol_sizes.push_back(size);
+      }
+      next_dim += 2 * ndim;
+    }
+    spec.computeHashCode();
+    return spec;
+  }
+  // The inverse of symbolic(): the spec of contiguous tensors whose sizes are
+  // the ones of this symbolic spec, with symbol k standing for symbol_sizes[k].
+  ArgumentSpec instantiate(at::ArrayRef<int64_t> symbol_sizes) const {
+    ArgumentSpec spec = *this;
+    auto pods = tensor_info();
+    int64_t * next_dim = spec.sizes_strides();
+    uint32_t total_dims = 0;
+    for(size_t i = 0; i < ntensors; i++) {
+      size_t ndim = pods[i].total_dims - total_dims;
+      total_dims = pods[i].total_dims;
+      int64_t * sizes = next_dim;
+      int64_t * strides = next_dim + ndim;
+      int64_t stride = 1;
+      for(size_t d = ndim; d-- > 0;) {
+        if(sizes[d] < 0)
+          sizes[d] = symbol_sizes.at(-1 - sizes[d]);
+        strides[d] = stride;
+        stride *= sizes[d];
+      }
+      next_dim += 2 * ndim;
+    }
+    spec.computeHashCode();
+    return spec;
+  }
   friend struct TensorInfo;
   TensorInfo tensorInfo(size_t i) const;
   size_t size() const {
@@ -95,6 +192,12 @@ struct ArgumentSpec {
   }
 
 private:
+  void computeHashCode() {
+    hash_code = hash_combine(0, ntensors);
+    for(auto d : data) {
+      hash_code = hash_combine(hash_code, d);
+    }
+  }
   ArrayRef<TensorInfoPOD> tensor_info() const {
     return ArrayRef<TensorInfoPOD>(reinterpret_cast<const TensorInfoPOD*>(data.data()), ntensors);
   }
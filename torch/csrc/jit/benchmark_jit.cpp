@@ -0,0 +1,143 @@
+// Framework overhead benchmarks: the time per op of each layer between a
+// user call and the ATen kernel, measured on synthetic chains of N additions
+// of 1-element CPU tensors, so that the math is negligible.
+//
+//   benchmark_jit [N=100] [iterations=1000]
+//
+// Every line reports ns per op of N ops. Subtracting the line above from a
+// line gives the cost of the layer it adds.
+
+#include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/variable.h"
+#include "torch/csrc/jit/graph_executor.h"
+#include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/symbolic_variable.h"
+#include "torch/csrc/jit/tracer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace torch { namespace jit {
+
+using Var = SymbolicVariable;
+using autograd::Variable;
+using autograd::make_variable;
+
+// The mean ns of a call to f, after a warmup call.
+template<typename F>
+static double nsPerCall(F&& f, int iterations) {
+  f();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// y = x + b + b + ... + b, with n additions.
+template<typename T>
+static T addChain(const T& x, const T& b, int n) {
+  T y = x;
+  for (int i = 0; i < n; ++i) {
+    y = y + b;
+  }
+  return y;
+}
+
+static std::shared_ptr<Graph> buildAddChain(int n) {
+  auto graph = std::make_shared<Graph>();
+  auto x = Var::asNewInput(*graph, "x");
+  auto b = Var::asNewInput(*graph, "b");
+  addChain(x, b, n).addAsOutput();
+  return graph;
+}
+
+static void report(const char* layer, double ns_per_call, int n) {
+  std::printf("%-40s %10.1f ns/op\n", layer, ns_per_call / n);
+}
+
+void runJITCPPBenchmarks(int n, int iterations) {
+  auto x = at::ones(at::CPU(at::kFloat), {1});
+  auto b = at::ones(at::CPU(at::kFloat), {1});
+  auto vx = make_variable(x, /*requires_grad=*/false);
+  auto vb = make_variable(b, /*requires_grad=*/false);
+  auto gx = make_variable(x, /*requires_grad=*/true);
+
+  // ATen, without VariableType
+  report("aten dispatch", nsPerCall([&] { addChain(x, b, n); }, iterations), n);
+
+  // VariableType dispatch, without and with recording the autograd graph
+  report("VariableType dispatch", nsPerCall([&] {
+    addChain<at::Tensor>(vx, vb, n);
+  }, iterations), n);
+  report("VariableType dispatch, requires_grad", nsPerCall([&] {
+    addChain<at::Tensor>(gx, vb, n);
+  }, iterations), n);
+
+  // Engine::execute, per backward node. The graph is kept, so that only the
+  // backward pass is measured.
+  {
+    Variable y = addChain<at::Tensor>(gx, vb, n);
+    auto& engine = autograd::Engine::getDefaultEngine();
+    auto grad = make_variable(at::ones(at::CPU(at::kFloat), {1}), false);
+    report("Engine::execute", nsPerCall([&] {
+      engine.execute({y.gradient_edge()}, {grad}, /*keep_graph=*/true,
+                     /*create_graph=*/false);
+    }, iterations), n);
+  }
+
+  auto graph = buildAddChain(n);
+
+  // The interpreter, on tensors; a new InterpreterState is needed per run.
+  {
+    Code code(graph, /*values_are_variables=*/false);
+    report("interpreter", nsPerCall([&] {
+      InterpreterState interp(code);
+      std::vector<at::Tensor> stack = {x, b};
+      interp.runOneStage(stack);
+    }, iterations), n);
+  }
+
+  // GraphExecutor::run: the ArgumentSpec cache lookup of the inputs on top
+  // of the interpreter, on variables.
+  {
+    GraphExecutor executor(graph, /*optimize=*/false);
+    report("GraphExecutor (no optimization)", nsPerCall([&] {
+      executor.run(variable_tensor_list(std::vector<at::Tensor>{vx, vb}));
+    }, iterations), n);
+  }
+  {
+    GraphExecutor executor(graph, /*optimize=*/true);
+    report("GraphExecutor", nsPerCall([&] {
+      executor.run(variable_tensor_list(std::vector<at::Tensor>{vx, vb}));
+    }, iterations), n);
+  }
+
+  // Tracing the chain, on top of VariableType dispatch.
+  report("tracer", nsPerCall([&] {
+    auto state = tracer::enter({vx, vb}, 1);
+    auto& inputs = state.second;
+    Variable y = addChain<at::Tensor>(inputs[0], inputs[1], n);
+    tracer::exit({y});
+  }, iterations), n);
+}
+
+}} // namespace torch::jit
+
+int main(int argc, char* argv[]) {
+  const int n = argc > 1 ? std::atoi(argv[1]) : 100;
+  const int iterations = argc > 2 ? std::atoi(argv[2]) : 1000;
+  if (n <= 0 || iterations <= 0) {
+    std::fprintf(stderr, "usage: %s [N] [iterations]\n", argv[0]);
+    return 1;
+  }
+  std::printf("%d ops per graph, %d iterations\n", n, iterations);
+  torch::jit::runJITCPPBenchmarks(n, iterations);
+  return 0;
+}
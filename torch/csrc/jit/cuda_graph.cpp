@@ -0,0 +1,256 @@
+#include "torch/csrc/jit/cuda_graph.h"
+#include "torch/csrc/utils/auto_gpu.h"
+
+#ifdef WITH_CUDA
+#include <THC/THC.h>
+#include <THC/THCCachingAllocator.h>
+#include <cuda_runtime.h>
+#endif
+
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// cudaStreamCaptureModeRelaxed, which lets the ops of the capture call
+// cudaMalloc, appeared in CUDA 10.1
+#if defined(WITH_CUDA) && CUDART_VERSION >= 10010
+#define TORCH_CUDA_GRAPHS_ENABLED
+#endif
+
+namespace torch { namespace jit {
+
+#ifdef TORCH_CUDA_GRAPHS_ENABLED
+namespace {
+
+THCState * thcState() {
+  return at::globalContext().lazyInitCUDA();
+}
+
+// The capture stream of each device, created on first use and kept for the
+// lifetime of the process. The capture can't be done on the current stream,
+// which may be the legacy default stream.
+THCStream * capture_stream(int device) {
+  static std::mutex mutex;
+  static std::unordered_map<int, THCStream*> streams;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto & stream = streams[device];
+  if (!stream) {
+    AutoGPU gpu_guard(device);
+    stream = THCStream_new(cudaStreamNonBlocking);
+  }
+  return stream;
+}
+
+void stream_wait(cudaStream_t waiting, cudaStream_t on) {
+  if (waiting == on)
+    return;
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, on));
+  THCudaCheck(cudaStreamWaitEvent(waiting, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+
+// Makes stream the current stream of the thread, like AutoStream
+struct CaptureStreamGuard {
+  explicit CaptureStreamGuard(THCStream * stream)
+    : original_stream(THCState_getStream(thcState())) {
+    THCStream_retain(original_stream);
+    THCState_setStream(thcState(), stream);
+  }
+  ~CaptureStreamGuard() {
+    THCState_setStream(thcState(), original_stream);
+    THCStream_free(original_stream);
+  }
+  THCStream * original_stream;
+};
+
+} // anonymous namespace
+#endif
+
+struct CudaGraphImpl {
+  CudaGraphImpl(Code code, int warmup_runs)
+    : code(std::move(code)), warmup_runs(warmup_runs) {}
+
+  ~CudaGraphImpl() {
+#ifdef TORCH_CUDA_GRAPHS_ENABLED
+    try {
+      release();
+    } catch (...) {
+      // the CUDA runtime may already be shut down at exit
+    }
+#endif
+  }
+
+  bool run(std::vector<at::Tensor> & stack) {
+#ifdef TORCH_CUDA_GRAPHS_ENABLED
+    // the graph is single threaded: concurrent calls run eagerly
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock() || disabled || !checkInputs(stack))
+      return false;
+    if (!exec) {
+      if (eager_runs < warmup_runs) {
+        ++eager_runs;
+        return false;
+      }
+      if (!capture(stack))
+        return false;
+    }
+    replay(stack);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+private:
+#ifdef TORCH_CUDA_GRAPHS_ENABLED
+  bool checkInputs(const std::vector<at::Tensor> & inputs) {
+    // the parallel stages of the interpreter run on threads which don't use
+    // the capture stream
+    if (getInterOpThreads() > 1)
+      return false;
+    int input_device = -1;
+    for (auto & input : inputs) {
+      if (!input.defined() || !input.type().is_cuda())
+        return false;
+      int d = input.get_device();
+      if (input_device != -1 && d != input_device)
+        return false;
+      input_device = d;
+    }
+    return input_device != -1 && (device == -1 || input_device == device);
+  }
+
+  bool capture(const std::vector<at::Tensor> & inputs) {
+    device = inputs[0].get_device();
+    AutoGPU gpu_guard(device);
+    auto state = thcState();
+    cudaStream_t current = THCState_getCurrentStream(state);
+    THCStream * stream = capture_stream(device);
+    stream_wait(stream->stream, current);
+
+    std::string error;
+    bool captured = false;
+    cudaGraph_t cuda_graph = nullptr;
+    {
+      // all the memory of the graph is allocated on the capture stream
+      CaptureStreamGuard stream_guard(stream);
+      for (auto & input : inputs)
+        static_inputs.push_back(input.clone());
+      graph = THCCachingAllocator_beginGraphCapture();
+      cudaError_t err = cudaStreamBeginCapture(stream->stream, cudaStreamCaptureModeRelaxed);
+      if (err == cudaSuccess) {
+        captured = true;
+        try {
+          std::vector<at::Tensor> outputs = static_inputs;
+          InterpreterState(code).runOneStage(outputs);
+          static_outputs = std::move(outputs);
+        } catch (const std::exception & e) {
+          error = e.what();
+          captured = false;
+        }
+        err = cudaStreamEndCapture(stream->stream, &cuda_graph);
+        if (captured && err == cudaSuccess) {
+#if CUDART_VERSION >= 12000
+          err = cudaGraphInstantiate(&exec, cuda_graph, 0);
+#else
+          err = cudaGraphInstantiate(&exec, cuda_graph, nullptr, nullptr, 0);
+#endif
+        }
+        if (cuda_graph)
+          cudaGraphDestroy(cuda_graph);
+      }
+      if (err != cudaSuccess) {
+        if (error.empty())
+          error = cudaGetErrorString(err);
+        captured = false;
+        // clear the error of the capture
+        cudaGetLastError();
+      }
+      THCCachingAllocator_endGraphCapture();
+    }
+    for (auto & output : static_outputs) {
+      // host tensors are computed once by the capture, and not by replays
+      if (captured && (!output.defined() || !output.type().is_cuda())) {
+        error = "an output is not a CUDA tensor";
+        captured = false;
+      }
+    }
+    if (!captured) {
+      if (exec) {
+        cudaGraphExecDestroy(exec);
+        exec = nullptr;
+      }
+      last_stream = stream->stream;
+      release();
+      disabled = true;
+      if (!error.empty()) {
+        std::cerr << "warning: the graph can't be captured into a CUDA graph ("
+                  << error << "), running it eagerly" << std::endl;
+      }
+      return false;
+    }
+    last_stream = stream->stream;
+    return true;
+  }
+
+  void replay(std::vector<at::Tensor> & stack) {
+    AutoGPU gpu_guard(device);
+    cudaStream_t current = THCState_getCurrentStream(thcState());
+    // the previous replay may still read the static inputs
+    stream_wait(current, last_stream);
+    for (size_t i = 0; i < stack.size(); ++i)
+      static_inputs[i].copy_(stack[i]);
+    THCudaCheck(cudaGraphLaunch(exec, current));
+    last_stream = current;
+    stack.clear();
+    for (auto & output : static_outputs)
+      stack.push_back(output.clone());
+  }
+
+  // Returns the memory of the graph to the caching allocator, once the
+  // capture stream, which its blocks were allocated on, is ordered after the
+  // last replay
+  void release() {
+    if (graph == 0)
+      return;
+    AutoGPU gpu_guard(device);
+    stream_wait(capture_stream(device)->stream, last_stream);
+    if (exec) {
+      THCudaCheck(cudaGraphExecDestroy(exec));
+      exec = nullptr;
+    }
+    static_inputs.clear();
+    static_outputs.clear();
+    THCCachingAllocator_releaseGraph(graph);
+    graph = 0;
+  }
+
+  std::mutex mutex;
+  // the device of the inputs, -1 until the capture
+  int device = -1;
+  int eager_runs = 0;
+  bool disabled = false;
+  std::vector<at::Tensor> static_inputs;
+  std::vector<at::Tensor> static_outputs;
+  cudaGraphExec_t exec = nullptr;
+  // the id of the graph's memory in the caching allocator, 0 if none
+  int graph = 0;
+  // the stream of the last replay
+  cudaStream_t last_stream = nullptr;
+#endif
+  Code code;
+  int warmup_runs;
+};
+
+CudaGraph::CudaGraph(Code code, int warmup_runs)
+: pImpl(new CudaGraphImpl(std::move(code), warmup_runs)) {}
+
+CudaGraph::~CudaGraph() {}
+
+bool CudaGraph::run(std::vector<at::Tensor> & stack) {
+  return pImpl->run(stack);
+}
+
+}}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/utils/disallow_copy.h"
+
+#include <ATen/ATen.h>
+
+#include <memory>
+#include <vector>
+
+namespace torch { namespace jit {
+
+struct CudaGraphImpl;
+
+// Runs a Code on CUDA tensors by replaying a CUDA graph of its kernels.
+// After warmup_runs eager runs, a run is captured on a side stream into a
+// graph that reads static copies of the inputs and writes static outputs.
+// Every later run copies its inputs into the static ones, launches the graph
+// on the current stream and returns copies of the static outputs, so the
+// host cost of a run no longer depends on the number of operators.
+//
+// The code must be specialized to the shapes of its inputs (as the plans of
+// GraphExecutor are), and must not do host work that depends on the values
+// of the run, which is not replayed. The memory allocated by the capture is
+// kept until the CudaGraph is destroyed.
+struct CudaGraph {
+  TH_DISALLOW_COPY_AND_ASSIGN(CudaGraph);
+  explicit CudaGraph(Code code, int warmup_runs = 1);
+  ~CudaGraph();
+
+  // Runs the code on the inputs on the stack, and replaces them with the
+  // outputs. Returns false, leaving the stack untouched, when the run has to
+  // be done eagerly: during warmup, when the inputs are not CUDA tensors on
+  // a single device, when another thread is replaying the graph, or when the
+  // capture failed (the graph is then disabled for good).
+  bool run(std::vector<at::Tensor> & stack);
+
+private:
+  std::unique_ptr<CudaGraphImpl> pImpl;
+};
+
+}}
@@ -17,6 +17,7 @@
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <fstream>
 #include <dlfcn.h>
 #include <unistd.h>
 
@@ -83,12 +84,21 @@ void ${kernelName}(IndexType totalElements, ${formals}) {
 }
 )");
 
+// Some of the functions that encodeRHS emits are CUDA builtins, or don't
+// exist at all in math.h, so the CPU code defines them here.
 auto cpu_compilation_unit_template = CodeTemplate(R"(
 #include <cstddef>
 #include <math.h>
 #include <iostream>
 ${type_declarations}
 
+static inline float min(float a, float b) { return a < b ? a : b; }
+static inline float max(float a, float b) { return a > b ? a : b; }
+static inline float absf(float x) { return fabsf(x); }
+static inline float rsqrtf(float x) { return 1.f / sqrtf(x); }
+static inline float fracf(float x) { return x - truncf(x); }
+static inline float reciprocalf(float x) { return 1.f / x; }
+
 #define OMP_THRESHOLD 100000
 static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
   #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
@@ -203,9 +213,9 @@ std::string encodeRHS(Node * n) {
     {aten::div, "${0} / ${1}"},
     {aten::eq, "${0} == ${1}"},
     {aten::fmod, "fmodf(${0}, ${1})"},
-    {aten::ge, "${0} >= ${1})"},
+    {aten::ge, "${0} >= ${1}"},
     {aten::gt, "${0} > ${1}"},
-    {aten::le, "${0} <= ${1})"},
+    {aten::le, "${0} <= ${1}"},
     {aten::lt, "${0} < ${1}"},
     {aten::mul, "${0} * ${1}"},
     {aten::ne, "${0} != ${1}"},
@@ -489,8 +499,63 @@ void checkCUDAVersion(const cudaDeviceProp & prop) {
   }
 }
 
+// On-disk cache of the PTX produced by NVRTC, enabled by setting
+// PYTORCH_FUSION_CACHE_DIR. Entries are named after a hash of their key
+// (the kernel source, the target architecture and the CUDA and NVRTC
+// versions), and also store the full key so that collisions are detected.
+struct PTXDiskCache {
+  PTXDiskCache(const std::string & dir, std::string key_)
+  : key(std::move(key_)) {
+    // 64-bit FNV-1a, std::hash isn't guaranteed to be stable across builds
+    uint64_t hash = 14695981039346656037ULL;
+    for(char c : key) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ULL;
+    }
+    std::stringstream ss;
+    ss << dir << "/fusion_" << std::hex << hash << ".ptx";
+    path = ss.str();
+  }
+  bool load(std::vector<char> & ptx) {
+    std::ifstream in(path, std::ios::binary);
+    if(!in)
+      return false;
+    std::string magic;
+    size_t key_size = 0;
+    if(!std::getline(in, magic) || magic != kMagic || !(in >> key_size) || in.get() != '\n')
+      return false;
+    std::string stored_key(key_size, '\0');
+    if(!in.read(&stored_key[0], key_size) || stored_key != key)
+      return false;
+    ptx.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !ptx.empty();
+  }
+  // Failing to write the cache is not an error, we just compile again next time.
+  void store(const std::vector<char> & ptx) {
+    // write to a temporary file first, so that concurrent processes never
+    // see a partially written entry
+    std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+    {
+      std::ofstream out(tmp_path, std::ios::binary);
+      out << kMagic << "\n" << key.size() << "\n" << key;
+      out.write(ptx.data(), ptx.size());
+      if(!out) {
+        out.close();
+        unlink(tmp_path.c_str());
+        return;
+      }
+    }
+    if(rename(tmp_path.c_str(), path.c_str()) != 0)
+      unlink(tmp_path.c_str());
+  }
+private:
+  const std::string kMagic = "PYTORCH_FUSION_PTX 1";
+  std::string key;
+  std::string path;
+};
+
 struct CUDAFusionFunction : public CompiledFusionFunction {
-  CUDAFusionFunction(const std::string & name, AnnotatedGraph & agraph)
+  CUDAFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config)
   : CompiledFusionFunction(name, agraph) {
     AutoGPU gpu_guard(agraph.device);
 
@@ -500,10 +565,38 @@ struct CUDAFusionFunction : public CompiledFusionFunction {
     std::stringstream cu;
     concat_desc = codegen::emitCompilationUnit(cu, name, agraph, true);
     compilation_unit = cu.str();
+    std::string compute = "--gpu-architecture=compute_" + std::to_string(prop.major) + std::to_string(prop.minor);
+
+    std::unique_ptr<PTXDiskCache> disk_cache;
+    if(!config.cache_dir.empty()) {
+      int nvrtc_major, nvrtc_minor;
+      TORCH_NVRTC_CHECK(nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+      std::stringstream key;
+      key << "cuda " << CUDA_VERSION << " nvrtc " << nvrtc_major << "." << nvrtc_minor
+          << " " << compute << "\n" << compilation_unit;
+      disk_cache.reset(new PTXDiskCache(config.cache_dir, key.str()));
+    }
+    if(!disk_cache || !disk_cache->load(ptx)) {
+      compileToPTX(compute, cu);
+      if(disk_cache)
+        disk_cache->store(ptx);
+    }
+
+    TORCH_CU_CHECK(cuModuleLoadData(&module, ptx.data()));
+    TORCH_CU_CHECK(cuModuleGetFunction(&function, module, name.c_str()));
+
+    TORCH_CU_CHECK(cuOccupancyMaxActiveBlocksPerMultiprocessor(
+      &maxBlocks, function, 128, 0));
+    maxBlocks *= prop.multiProcessorCount;
+  }
+  virtual ~CUDAFusionFunction() override {
+    TORCH_CU_CHECK(cuModuleUnload(module));
+  }
+protected:
+  void compileToPTX(const std::string & compute, std::stringstream & cu) {
     nvrtcProgram program;
     TORCH_NVRTC_CHECK(nvrtcCreateProgram(&program, compilation_unit.c_str(), NULL, 0, nullptr, nullptr));
 
-    std::string compute = "--gpu-architecture=compute_" + std::to_string(prop.major) + std::to_string(prop.minor);
     std::vector<const char *> args = {"--std=c++11", compute.c_str()};
     nvrtcResult result = nvrtcCompileProgram(program, args.size(), args.data());
     if (result == NVRTC_ERROR_COMPILATION) {
@@ -523,18 +616,8 @@ struct CUDAFusionFunction : public CompiledFusionFunction {
     TORCH_NVRTC_CHECK(nvrtcGetPTXSize(program, &ptx_size));
     ptx.resize(ptx_size);
     TORCH_NVRTC_CHECK(nvrtcGetPTX(program, ptx.data()));
-
-    TORCH_CU_CHECK(cuModuleLoadData(&module, ptx.data()));
-    TORCH_CU_CHECK(cuModuleGetFunction(&function, module, name.c_str()));
-
-    TORCH_CU_CHECK(cuOccupancyMaxActiveBlocksPerMultiprocessor(
-      &maxBlocks, function, 128, 0));
-    maxBlocks *= prop.multiProcessorCount;
   }
-  virtual ~CUDAFusionFunction() override {
-    TORCH_CU_CHECK(cuModuleUnload(module));
-  }
-protected:
+
   virtual at::Backend backend() const override {
     return at::kCUDA;
   }
@@ -710,32 +793,60 @@ protected:
 };
 
 std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(AnnotatedGraph & agraph) {
+  // The generated code doesn't depend on the sizes of the tensors, or on the
+  // types the graph was annotated with, so we use it as the key together with
+  // what compressContiguous relies on at launch (the full contiguity vectors).
   std::stringstream key;
-  key << *agraph.graph << "\n";
+  bool use_cuda = agraph.device != kCPUDevice;
+  codegen::emitCompilationUnit(key, "kernel", agraph, use_cuda);
   key << "device " << agraph.device << "\n";
   for(auto & i : agraph.input_desc)
     key << i << "\n";
   for(auto & i : agraph.output_desc)
     key << i << "\n";
+  for(auto o : agraph.graph->outputs()) {
+    if(o->node()->kind() == aten::cat)
+      key << "cat " << o->node()->i(attr::dim) << "\n";
+  }
   std::string key_ = key.str();
 
   auto it = cache.find(key_);
-  if (it == cache.end()) {
-    std::string name = "kernel_" + std::to_string(cache.size());
-    CompiledFusionFunction * raw_func;
-    if(agraph.device != kCPUDevice) {
+  if (it != cache.end()) {
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->second;
+  }
+  std::string name = "kernel_" + std::to_string(kernel_count++);
+  CompiledFusionFunction * raw_func;
+  if(use_cuda) {
 #ifdef WITH_CUDA
-      raw_func = new CUDAFusionFunction(name, agraph);
+    raw_func = new CUDAFusionFunction(name, agraph, config_);
 #else
-      throw std::runtime_error("cannot compile a CUDA fusion group, CUDA is not enabled.");
+    throw std::runtime_error("cannot compile a CUDA fusion group, CUDA is not enabled.");
 #endif
-    } else {
-      JIT_ASSERT(canCompileOnCPU());
-      raw_func = new CPUFusionFunction(name, agraph, config_);
-    }
-    it = cache.emplace(key_, std::shared_ptr<CompiledFusionFunction>(raw_func)).first;
+  } else {
+    JIT_ASSERT(canCompileOnCPU());
+    raw_func = new CPUFusionFunction(name, agraph, config_);
+  }
+  lru.emplace_front(key_, std::shared_ptr<CompiledFusionFunction>(raw_func));
+  cache.emplace(std::move(key_), lru.begin());
+  evictKernels();
+  return lru.front().second;
+}
+
+// Evicted kernels stay alive for as long as somebody (e.g. an interpreter)
+// holds on to them, they just have to be recompiled on the next lookup.
+void FusionCompiler::evictKernels() {
+  if(config_.cache_size == 0)
+    return;
+  while(lru.size() > config_.cache_size) {
+    cache.erase(lru.back().first);
+    lru.pop_back();
   }
-  return it->second;
+}
+
+void FusionCompiler::setCacheSize(size_t cache_size) {
+  config_.cache_size = cache_size;
+  evictKernels();
 }
 
 std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(Node* fusion_group) {
@@ -792,6 +903,14 @@ FusionCompiler::FusionCompiler() {
   }
   const char * debug_env = getenv("PYTORCH_FUSION_DEBUG");
   config_.debug = debug_env && atoi(debug_env) != 0;
+  const char * cache_dir_env = getenv("PYTORCH_FUSION_CACHE_DIR");
+  if(cache_dir_env != nullptr) {
+    config_.cache_dir = cache_dir_env;
+  }
+  const char * cache_size_env = getenv("PYTORCH_FUSION_CACHE_SIZE");
+  if(cache_size_env != nullptr) {
+    config_.cache_size = std::max(atoi(cache_size_env), 0);
+  }
 }
 
 //TODO: thread safety
@@ -850,6 +969,8 @@ std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(Graph & gra
 
 void FusionCompiler::debugLaunchGraph(Graph & graph, int device, at::ArrayRef<at::Tensor> inputs, at::ArrayRef<at::Tensor> outputs) {}
 
+void FusionCompiler::setCacheSize(size_t cache_size) {}
+
 FusionCompiler::FusionCompiler() {}
 
 FusionCompiler & sharedFusionCompiler() {
@@ -4,6 +4,7 @@
 #include "ATen/ATen.h"
 #include <string>
 #include <algorithm>
+#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -121,9 +122,22 @@ struct FusionCompilerConfig {
   std::string cxx = "g++"; // compiler location
   bool debug = false; // emit debugging information about fusions
   bool openmp = true;
+  // maximum number of compiled kernels kept in the cache, the least recently
+  // used ones are evicted first. 0 means unbounded.
+  size_t cache_size = 0;
+  // directory where the PTX of CUDA kernels is saved and loaded from, so that
+  // other processes don't have to run NVRTC again. Empty means disabled.
+  std::string cache_dir;
 };
 
 // caching compiler
+//
+// Kernels are cached by their generated source and the TensorDescs of their
+// inputs and outputs, i.e. by the scalar types, ranks and contiguity of the
+// tensors, but not by their sizes, which are passed to the kernel at
+// runtime. Fusion groups that only differ in the sizes recorded in their
+// types (e.g. because they come from ExecutionPlans specialized to different
+// sequence lengths) share a single compiled kernel.
 struct FusionCompiler {
   TH_DISALLOW_COPY_AND_ASSIGN(FusionCompiler);
   FusionCompiler();
@@ -146,9 +160,21 @@ struct FusionCompiler {
   bool canCompileOnCPU() const {
     return config_.cxx.size() > 0;
   }
+  // number of kernels currently in the cache
+  size_t cacheSize() const {
+    return cache.size();
+  }
+  void setCacheSize(size_t cache_size);
 private:
+  using CacheEntry = std::pair<std::string, std::shared_ptr<CompiledFusionFunction>>;
+  void evictKernels();
+
   FusionCompilerConfig config_;
-  std::unordered_map<std::string, std::shared_ptr<CompiledFusionFunction>> cache;
+  // most recently used kernels first
+  std::list<CacheEntry> lru;
+  std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache;
+  // used to give every compiled kernel a unique name
+  size_t kernel_count = 0;
 };
 
 FusionCompiler & sharedFusionCompiler();
@@ -2,6 +2,7 @@
 #include "torch/csrc/jit/ir.h"
 #include "torch/csrc/jit/argument_spec.h"
 #include "torch/csrc/jit/autodiff.h"
+#include "torch/csrc/jit/cuda_graph.h"
 #include "torch/csrc/jit/interpreter.h"
 #include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/jit/passes/create_autodiff_subgraphs.h"
@@ -12,10 +13,18 @@
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/passes/inplace_check.h"
 #include "torch/csrc/jit/passes/batch_mm.h"
+#include "torch/csrc/jit/passes/loop_invariant_code_motion.h"
+#include "torch/csrc/jit/passes/loop_unrolling.h"
 
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/edge.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
 #include <unordered_map>
 
 namespace torch { namespace jit {
@@ -64,20 +73,24 @@ private:
 // to the output Variables if present.
 struct ExecutionPlan {
   ExecutionPlan(std::shared_ptr<Graph>& graph)
-      : f(graph, /*values_are_variables=*/false) {}
+      : f(graph, /*values_are_variables=*/false),
+        cuda_graph(std::make_shared<CudaGraph>(f)) {}
   ExecutionPlan(std::shared_ptr<Graph>& graph, Gradient grad)
       : f(graph, /*values_are_variables=*/false),
         grad(std::move(grad)),
         grad_executor(this->grad.df) {}
 
-  variable_tensor_list run(variable_tensor_list&& inputs) const {
+  // use_cuda_graph replays the plan as a CUDA graph when it can, see
+  // GraphExecutor::setCudaGraphs
+  variable_tensor_list run(variable_tensor_list&& inputs, bool use_cuda_graph = false) const {
     if(grad) {
       return runWithGrad(std::move(inputs));
     }
     // TODO: interpreter needs to accept moved inputs
     // and delete incrementally
     auto stack = unwrapVariables(std::move(inputs));
-    InterpreterState(f).runOneStage(stack);
+    if(!use_cuda_graph || !cuda_graph->run(stack))
+      InterpreterState(f).runOneStage(stack);
     return wrapTensors(std::move(stack));
   }
 private:
@@ -148,8 +161,138 @@ private:
   Gradient grad; // if(grad) is false when this is unused
   // executor for df, including code caches
   GraphExecutor grad_executor;
+  // replays f when no gradient is needed, null when grad is used
+  std::shared_ptr<CudaGraph> cuda_graph;
 };
 
+// Checks whether two graphs are the same up to the sizes of their tensors.
+// Their types still have to agree on everything else that the execution of
+// a graph depends on: the ranks, the dimensions of size 1 (broadcasting),
+// and the contiguity of every dimension (what fused kernels are compiled for).
+struct GraphMatcher {
+  bool matchGraphs(Graph & a, Graph & b) {
+    return matchBlocks(a.block(), b.block());
+  }
+
+private:
+  static std::vector<bool> contiguity(const TensorType & t) {
+    auto & sizes = t.sizes();
+    auto & strides = t.strides();
+    std::vector<bool> cont(sizes.size());
+    for(size_t i = 0; i < sizes.size(); ++i) {
+      int64_t expected_stride = (i + 1 < sizes.size()) ? sizes[i+1]*strides[i+1] : 1;
+      cont[i] = strides[i] == expected_stride;
+    }
+    return cont;
+  }
+  static bool matchTypes(const TypePtr & a, const TypePtr & b) {
+    auto ta = a->cast<TensorType>();
+    auto tb = b->cast<TensorType>();
+    if(!ta || !tb)
+      return !ta && !tb && *a == *b;
+    if(ta->scalarType() != tb->scalarType() || ta->device() != tb->device() ||
+       ta->sizes().size() != tb->sizes().size() || contiguity(*ta) != contiguity(*tb))
+      return false;
+    for(size_t i = 0; i < ta->sizes().size(); ++i) {
+      if((ta->sizes()[i] == 1) != (tb->sizes()[i] == 1))
+        return false;
+    }
+    return true;
+  }
+  static bool matchAttributes(Node * a, Node * b) {
+    auto names = a->attributeNames();
+    auto b_names = b->attributeNames();
+    std::sort(names.begin(), names.end());
+    std::sort(b_names.begin(), b_names.end());
+    if(names != b_names)
+      return false;
+    for(auto name : names) {
+      if(a->kindOf(name) != b->kindOf(name))
+        return false;
+      switch(a->kindOf(name)) {
+        case AttributeKind::f: if(a->f(name) != b->f(name)) return false; break;
+        case AttributeKind::fs: if(a->fs(name) != b->fs(name)) return false; break;
+        case AttributeKind::i: if(a->i(name) != b->i(name)) return false; break;
+        case AttributeKind::is: if(a->is(name) != b->is(name)) return false; break;
+        case AttributeKind::s: if(a->s(name) != b->s(name)) return false; break;
+        case AttributeKind::ss: if(a->ss(name) != b->ss(name)) return false; break;
+        case AttributeKind::t: {
+          auto & ta = a->t(name);
+          auto & tb = b->t(name);
+          if(&ta.type() != &tb.type() || !ta.sizes().equals(tb.sizes()) || !ta.equal(tb))
+            return false;
+        } break;
+        case AttributeKind::g:
+          if(!GraphMatcher().matchGraphs(*a->g(name), *b->g(name)))
+            return false;
+          break;
+        default:
+          // NB: tensor and graph lists don't appear in optimized graphs
+          return false;
+      }
+    }
+    return true;
+  }
+  bool defineValues(ArrayRef<Value*> a, ArrayRef<Value*> b) {
+    if(a.size() != b.size())
+      return false;
+    for(size_t i = 0; i < a.size(); ++i) {
+      if(!matchTypes(a[i]->type(), b[i]->type()))
+        return false;
+      value_map[a[i]] = b[i];
+    }
+    return true;
+  }
+  bool useValues(ArrayRef<Value*> a, ArrayRef<Value*> b) {
+    if(a.size() != b.size())
+      return false;
+    for(size_t i = 0; i < a.size(); ++i) {
+      auto it = value_map.find(a[i]);
+      if(it == value_map.end() || it->second != b[i])
+        return false;
+    }
+    return true;
+  }
+  bool matchNodes(Node * a, Node * b) {
+    if(a->kind() != b->kind() || a->blocks().size() != b->blocks().size() ||
+       !useValues(a->inputs(), b->inputs()) || !matchAttributes(a, b))
+      return false;
+    for(size_t i = 0; i < a->blocks().size(); ++i) {
+      if(!matchBlocks(a->blocks()[i], b->blocks()[i]))
+        return false;
+    }
+    return defineValues(a->outputs(), b->outputs());
+  }
+  bool matchBlocks(Block * a, Block * b) {
+    if(!defineValues(a->inputs(), b->inputs()))
+      return false;
+    auto it_a = a->nodes().begin(), end_a = a->nodes().end();
+    auto it_b = b->nodes().begin(), end_b = b->nodes().end();
+    for(; it_a != end_a && it_b != end_b; ++it_a, ++it_b) {
+      if(!matchNodes(*it_a, *it_b))
+        return false;
+    }
+    return it_a == end_a && it_b == end_b && useValues(a->outputs(), b->outputs());
+  }
+
+  std::unordered_map<Value*, Value*> value_map;
+};
+
+// The types of a graph shared by specs with different sizes are the ones of
+// the spec it was optimized for. Memory planning relies on the sizes of the
+// outputs of fusion groups, so these are erased in the copies run with other
+// sizes, which then allocate their outputs instead.
+void eraseFusionGroupSizes(Block * block) {
+  for(auto n : block->nodes()) {
+    for(auto b : n->blocks())
+      eraseFusionGroupSizes(b);
+    if(n->kind() == prim::FusionGroup) {
+      for(auto o : n->outputs())
+        o->setType(DynamicType::get());
+    }
+  }
+}
+
 } // anonymous namespace
 
 // a Graph can be created via tracing, or via a language-based frontend
@@ -174,6 +317,29 @@ struct GraphExecutorImpl {
       ss << "expected " << num_inputs << " inputs but got " << inputs.size() << " inputs";
       throw std::runtime_error(ss.str());
     }
+    if(max_batch_size > 1 && canBatch(inputs)) {
+      return runBatched(std::move(inputs));
+    }
+    return runUnbatched(std::move(inputs));
+  }
+
+  void setBatching(size_t max_batch_size_, int64_t timeout_us) {
+    std::lock_guard<std::mutex> lock(batch_mutex);
+    max_batch_size = max_batch_size_;
+    batch_timeout = std::chrono::microseconds(timeout_us);
+  }
+  bool isBatching() {
+    std::lock_guard<std::mutex> lock(batch_mutex);
+    return max_batch_size > 1;
+  }
+
+  void setCudaGraphs(bool enabled) {
+    cuda_graphs = enabled;
+  }
+
+private:
+
+  variable_tensor_list runUnbatched(variable_tensor_list inputs) {
     // this is the fallback pathway, when we cannot differentiate
     if(!optimize || (!symbolically_differentiable && needsGradient(inputs))) {
       auto & fb = getOrCreateAutogradFallback();
@@ -188,10 +354,161 @@ struct GraphExecutorImpl {
     // go down the route where we treat the inputs as tensors
     // and fully optimize
     auto & implementation = getOrCompile(inputs);
-    return implementation.run(std::move(inputs));
+    return implementation.run(std::move(inputs), cuda_graphs.load());
   }
 
-private:
+  // A group of concurrent calls that will be run together. The first call
+  // to join a batch (the leader) runs it, the others wait for their outputs.
+  struct Batch {
+    std::vector<variable_tensor_list> inputs;
+    // the batch size of each call
+    std::vector<int64_t> sizes;
+    // inputs that every call passes the exact same tensor for (e.g. module
+    // parameters) are not concatenated. This is decided when the second call
+    // joins the batch.
+    std::vector<bool> shared;
+    std::vector<variable_tensor_list> outputs;
+    std::exception_ptr error;
+    bool done = false;
+  };
+
+  bool canBatch(const variable_tensor_list & inputs) {
+    if(!optimize || inputs.empty() || needsGradient(inputs))
+      return false;
+    for(auto & t : inputs) {
+      if(!t.defined())
+        return false;
+    }
+    return true;
+  }
+  // Returns the batch size of inputs if they can be concatenated with the
+  // non-shared inputs of first, or -1.
+  static int64_t batchSize(const variable_tensor_list & first, const variable_tensor_list & inputs, const std::vector<bool> & shared) {
+    int64_t batch_size = -1;
+    for(size_t i = 0; i < inputs.size(); ++i) {
+      auto & a = first[i];
+      auto & b = inputs[i];
+      if(shared[i]) {
+        if(a.get() != b.get())
+          return -1;
+        continue;
+      }
+      if(&a.type() != &b.type() || a.dim() == 0 || a.dim() != b.dim())
+        return -1;
+      if(a.type().is_cuda() && a.get_device() != b.get_device())
+        return -1;
+      if(!a.sizes().slice(1).equals(b.sizes().slice(1)))
+        return -1;
+      if(batch_size == -1)
+        batch_size = b.size(0);
+      else if(b.size(0) != batch_size)
+        return -1;
+    }
+    return batch_size;
+  }
+  bool tryJoin(Batch & batch, const variable_tensor_list & inputs) {
+    auto & first = batch.inputs[0];
+    if(batch.inputs.size() == 1) {
+      std::vector<bool> shared;
+      for(size_t i = 0; i < inputs.size(); ++i)
+        shared.push_back(first[i].get() == inputs[i].get());
+      auto first_size = batchSize(first, first, shared);
+      auto size = batchSize(first, inputs, shared);
+      if(first_size == -1 || size == -1)
+        return false;
+      batch.shared = std::move(shared);
+      batch.sizes.push_back(first_size);
+      batch.sizes.push_back(size);
+      return true;
+    }
+    auto size = batchSize(first, inputs, batch.shared);
+    if(size == -1)
+      return false;
+    batch.sizes.push_back(size);
+    return true;
+  }
+
+  variable_tensor_list runBatched(variable_tensor_list inputs) {
+    std::unique_lock<std::mutex> lock(batch_mutex);
+    bool leader = !pending_batch;
+    if(leader) {
+      pending_batch = std::make_shared<Batch>();
+    } else if(!tryJoin(*pending_batch, inputs)) {
+      lock.unlock();
+      return runUnbatched(std::move(inputs));
+    }
+    auto batch = pending_batch;
+    size_t index = batch->inputs.size();
+    batch->inputs.push_back(std::move(inputs));
+
+    if(!leader) {
+      if(batch->inputs.size() >= max_batch_size)
+        batch_changed.notify_all();
+      batch_changed.wait(lock, [&] { return batch->done; });
+      if(batch->error)
+        std::rethrow_exception(batch->error);
+      return std::move(batch->outputs[index]);
+    }
+
+    batch_changed.wait_for(lock, batch_timeout, [&] {
+      return batch->inputs.size() >= max_batch_size;
+    });
+    // close the batch, later calls start a new one
+    pending_batch = nullptr;
+    lock.unlock();
+    try {
+      batch->outputs = runBatch(*batch);
+    } catch(...) {
+      batch->error = std::current_exception();
+    }
+    lock.lock();
+    batch->done = true;
+    batch_changed.notify_all();
+    if(batch->error)
+      std::rethrow_exception(batch->error);
+    return std::move(batch->outputs[0]);
+  }
+
+  std::vector<variable_tensor_list> runBatch(Batch & batch) {
+    auto & requests = batch.inputs;
+    if(requests.size() == 1) {
+      return {runUnbatched(std::move(requests[0]))};
+    }
+    int64_t total_size = 0;
+    for(auto size : batch.sizes)
+      total_size += size;
+    variable_tensor_list inputs;
+    inputs.reserve(num_inputs);
+    for(size_t i = 0; i < num_inputs; ++i) {
+      if(batch.shared[i]) {
+        inputs.push_back(requests[0][i]);
+        continue;
+      }
+      std::vector<at::Tensor> parts;
+      parts.reserve(requests.size());
+      for(auto & r : requests) {
+        parts.push_back(std::move(r[i]));
+      }
+      inputs.push_back(at::cat(parts, 0));
+    }
+    auto outputs = runUnbatched(std::move(inputs));
+    std::vector<variable_tensor_list> results(requests.size());
+    for(size_t i = 0; i < outputs.size(); ++i) {
+      auto & o = outputs[i];
+      if(!o.defined() || o.dim() == 0 || o.size(0) != total_size) {
+        std::stringstream ss;
+        ss << "batched GraphExecutor: output " << i << " doesn't have the batch size ("
+           << total_size << ") in dimension 0";
+        throw std::runtime_error(ss.str());
+      }
+      int64_t offset = 0;
+      for(size_t r = 0; r < requests.size(); ++r) {
+        results[r].push_back(o.narrow(0, offset, batch.sizes[r]));
+        offset += batch.sizes[r];
+      }
+    }
+    return results;
+  }
 
   static bool needsGradient(const variable_tensor_list & inputs) {
     if (!autograd::GradMode::is_enabled()) {
@@ -210,6 +527,9 @@ private:
 
     EliminateDeadCode(graph);
     CheckInplace(graph);
+    // hoisting first, so that the invariants aren't copied by unrolling
+    HoistLoopInvariants(graph);
+    UnrollLoops(graph);
     EliminateCommonSubexpression(graph);
 
     if (!graphMustSupportVariables) {
@@ -241,17 +561,39 @@ private:
     return autograd_fallback;
   }
   const ExecutionPlan & getOrCompile(const variable_tensor_list & inputs) {
+    bool with_grad = autograd::GradMode::is_enabled();
+    // fastest path: the inputs look like the ones of the previous call,
+    // checked without building a new spec
+    const PlanEntry * last = last_plan.load(std::memory_order_acquire);
+    if(last && last->first.matches(with_grad, inputs))
+      return last->second;
+
     // outside lock guard, to minimize the time holding the lock on the fast path
     // ArgumentSpec even computes its hashCode here.
-    ArgumentSpec spec(autograd::GradMode::is_enabled(), inputs);
+    ArgumentSpec spec(with_grad, inputs);
+    // fast path: a plan compiled earlier, found without taking compile_mutex
+    auto table = std::atomic_load(&plan_table);
+    if(table) {
+      auto it = table->find(spec);
+      if(it != table->end()) {
+        last_plan.store(it->second, std::memory_order_release);
+        return it->second->second;
+      }
+    }
     {
       std::lock_guard<std::mutex> lock(compile_mutex);
       auto it = plan_cache.find(spec);
-      if(it != plan_cache.end())
-        return it->second;
-      auto plan = compileSpec(spec);
-      auto r = plan_cache.emplace(std::move(spec), std::move(plan));
-      return r.first->second;
+      if(it == plan_cache.end()) {
+        auto plan = compileSpec(spec);
+        it = plan_cache.emplace(std::move(spec), std::move(plan)).first;
+        // publish a new table: readers holding the old one keep using it
+        auto new_table = std::make_shared<PlanTable>();
+        for(auto & entry : plan_cache)
+          new_table->emplace(entry.first, &entry);
+        std::atomic_store(&plan_table, std::shared_ptr<const PlanTable>(std::move(new_table)));
+      }
+      last_plan.store(&*it, std::memory_order_release);
+      return it->second;
     }
   }
   bool needsGradient(const ArgumentSpec & spec) {
@@ -315,14 +657,59 @@ private:
     // calculate all input shapes
     PropagateInputShapes(*g, spec);
   }
-  ExecutionPlan compileSpec(const ArgumentSpec & spec) {
+  std::shared_ptr<Graph> optimizeForSpec(const ArgumentSpec & spec) {
     auto graph_ = graph->copy();
     specializeToSpec(graph_, spec);
+    runOptimization(graph_, /*graphMustSupportVariables=*/false);
+    return graph_;
+  }
+  // Whether the graph optimized for symbolic.instantiate(symbol_sizes) is
+  // also the one for every other instance of symbolic. We check that it
+  // doesn't change when another instance is optimized, whose sizes are
+  // multiples of these ones (so that e.g. chunks stay even), with a
+  // different factor for each symbol, so that relations that only hold by
+  // coincidence between sizes that are not equal don't hold there anymore.
+  bool isShapePolymorphic(Graph & optimized, const ArgumentSpec & symbolic,
+                          const std::vector<int64_t> & symbol_sizes) {
+    std::vector<int64_t> other_sizes(symbol_sizes.size());
+    for(size_t i = 0; i < symbol_sizes.size(); ++i) {
+      other_sizes[i] = symbol_sizes[i] * static_cast<int64_t>(i + 2);
+    }
+    std::shared_ptr<Graph> other;
+    try {
+      other = optimizeForSpec(symbolic.instantiate(other_sizes));
+    } catch(std::exception &) {
+      // e.g. a view to a fixed size, which only works for some sizes
+      return false;
+    }
+    return GraphMatcher().matchGraphs(optimized, *other);
+  }
+  ExecutionPlan compileSpec(const ArgumentSpec & spec) {
     if(!needsGradient(spec)) {
-      runOptimization(graph_, /*graphMustSupportVariables=*/false);
+      // Specs of contiguous tensors share the optimized graph of the first
+      // one with the same symbolic signature, when it doesn't depend on the
+      // sizes. Only the (cheap) ExecutionPlan is per spec then, e.g. so that
+      // CUDA graphs are still captured for a single shape.
+      std::vector<int64_t> symbol_sizes;
+      auto symbolic = spec.symbolic(symbol_sizes);
+      auto it = symbolic ? polymorphic_graphs.find(*symbolic) : polymorphic_graphs.end();
+      if(it != polymorphic_graphs.end() && it->second) {
+        auto graph_ = it->second->copy();
+        eraseFusionGroupSizes(graph_->block());
+        return ExecutionPlan(graph_);
+      }
+      auto graph_ = optimizeForSpec(spec);
+      if(!symbolic)
+        return ExecutionPlan(graph_);
+      if(it == polymorphic_graphs.end()) {
+        bool polymorphic = isShapePolymorphic(*graph_, *symbolic, symbol_sizes);
+        polymorphic_graphs.emplace(std::move(*symbolic), polymorphic ? graph_ : nullptr);
+      }
       return ExecutionPlan(graph_);
     }
     JIT_ASSERT(symbolically_differentiable);
+    auto graph_ = graph->copy();
+    specializeToSpec(graph_, spec);
 
     std::vector<bool> requires_grads;
     requires_grads.reserve(spec.size());
@@ -359,6 +746,20 @@ private:
   // optimizable code paths, used when we can differentiate or when no derivative is needed
   // Spec describes input conditions, Plan describes how to execute them.
   std::unordered_map<ArgumentSpec, ExecutionPlan> plan_cache;
+  // Calls that find their plan already compiled don't take compile_mutex:
+  // plan_table is an immutable copy of plan_cache's index, replaced
+  // (with std::atomic_store) after every compilation, and last_plan is the
+  // entry used by the most recent call. Entries of plan_cache are never
+  // removed, so the pointers stay valid for the executor's lifetime.
+  using PlanEntry = std::pair<const ArgumentSpec, ExecutionPlan>;
+  using PlanTable = std::unordered_map<ArgumentSpec, const PlanEntry*>;
+  std::shared_ptr<const PlanTable> plan_table;
+  std::atomic<const PlanEntry*> last_plan {nullptr};
+  // the optimized graphs shared by the plans of the specs with the same
+  // symbolic signature (see ArgumentSpec::symbolic), or null when the graph
+  // optimized for the first of them turned out to depend on its sizes.
+  // Protected by compile_mutex.
+  std::unordered_map<ArgumentSpec, std::shared_ptr<Graph>> polymorphic_graphs;
 
   // GraphExecutor can be accessed from  multiple thread so
   // anytime we are checking or updating the autograd_fallback or
@@ -366,6 +767,19 @@ private:
   // along the fast path (no compilation) code should
   // hold this for as little time as possible.
   std::mutex compile_mutex;
+
+  // calls are batched when max_batch_size > 1, see GraphExecutor::setBatching.
+  // Every total batch size gets its own entry in plan_cache.
+  std::atomic<size_t> max_batch_size {0};
+  std::chrono::microseconds batch_timeout {0};
+  // the batch new calls join, protected by batch_mutex
+  std::shared_ptr<Batch> pending_batch;
+  std::mutex batch_mutex;
+  std::condition_variable batch_changed;
+
+  // plans without a gradient are replayed as CUDA graphs, see
+  // GraphExecutor::setCudaGraphs
+  std::atomic<bool> cuda_graphs {false};
 };
 
 GraphExecutor::GraphExecutor(std::shared_ptr<Graph> graph, bool optimize)
@@ -378,4 +792,20 @@ variable_tensor_list GraphExecutor::run(variable_tensor_list && inputs) {
   return pImpl->run(std::move(inputs));
 }
 
+void GraphExecutor::setBatching(size_t max_batch_size, int64_t timeout_us) {
+  pImpl->setBatching(max_batch_size, timeout_us);
+}
+
+bool GraphExecutor::isBatching() const {
+  return pImpl->isBatching();
+}
+
+void GraphExecutor::setCudaGraphs(bool enabled) {
+  pImpl->setCudaGraphs(enabled);
+}
+
+bool matchGraphsUpToSizes(Graph & a, Graph & b) {
+  return GraphMatcher().matchGraphs(a, b);
+}
+
 }}
@@ -13,6 +13,24 @@ struct GraphExecutor {
   // note: if not specified, symbolically_differentiable is computed from the graph.
   GraphExecutor(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable);
   variable_tensor_list run(variable_tensor_list && inputs);
+  // Combine concurrent calls to run into a single execution of the graph.
+  // The first caller waits up to timeout_us microseconds for up to
+  // max_batch_size calls, concatenates their inputs along dimension 0
+  // (except for inputs that all calls pass the same tensor for, like
+  // parameters), runs the graph once, and splits every output back along
+  // dimension 0.
+  // This is only correct for graphs that treat dimension 0 as a batch
+  // dimension. Calls that need a gradient, or whose inputs can't be
+  // concatenated with the pending ones, run on their own.
+  // max_batch_size <= 1 disables batching.
+  void setBatching(size_t max_batch_size, int64_t timeout_us);
+  bool isBatching() const;
+  // Replay the plans that need no gradient as CUDA graphs (CUDA 10.1+):
+  // after a warmup run, the kernels of a run on CUDA inputs of one device
+  // are captured, and the next runs with the same input shapes launch them
+  // at once. Only correct for graphs whose host work doesn't depend on the
+  // values of their inputs. Plans that can't be captured run eagerly.
+  void setCudaGraphs(bool enabled);
   operator bool() const {
     return pImpl != nullptr;
   }
@@ -20,4 +38,9 @@ private:
   std::shared_ptr<GraphExecutorImpl> pImpl;
 };
 
+// Whether two graphs are the same up to the sizes of their tensors: same
+// nodes and attributes, with types that agree on everything but the sizes
+// other than 1 (rank, scalar type, device and contiguity).
+bool matchGraphsUpToSizes(Graph & a, Graph & b);
+
 }}
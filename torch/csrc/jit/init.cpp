@@ -5,7 +5,9 @@
 #include "torch/csrc/jit/python_ir.h"
 #include "torch/csrc/jit/python_arg_flatten.h"
 #include "torch/csrc/jit/export.h"
+#include "torch/csrc/jit/serialization.h"
 #include "torch/csrc/jit/python_compiled_function.h"
+#include "torch/csrc/jit/python_trace_cache.h"
 #include "torch/csrc/jit/argument_spec.h"
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/passes/onnx.h"
@@ -13,11 +15,17 @@
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
 #include "torch/csrc/jit/passes/peephole.h"
 #include "torch/csrc/jit/passes/canonicalize.h"
+#include "torch/csrc/jit/passes/constant_propagation.h"
+#include "torch/csrc/jit/passes/loop_invariant_code_motion.h"
+#include "torch/csrc/jit/passes/loop_unrolling.h"
+#include "torch/csrc/jit/passes/fold_conv_batch_norm.h"
 #include "torch/csrc/jit/passes/onnx/peephole.h"
 #include "torch/csrc/jit/passes/shape_analysis.h"
 #include "torch/csrc/jit/graph_executor.h"
+#include "torch/csrc/jit/interpreter.h"
 #include "torch/csrc/jit/script/init.h"
 #include "torch/csrc/jit/script/python_tree_views.h"
+#include "torch/csrc/utils/auto_gil.h"
 
 
 namespace torch  { namespace jit {
@@ -71,6 +79,17 @@ void initJITBindings(PyObject *module) {
    .def("_jit_pass_peephole", graph_pass<PeepholeOptimize>)
    .def("_jit_pass_canonicalize", graph_pass<Canonicalize>)
    .def("_jit_pass_lint", graph_pass<LintGraph>)
+   .def("_jit_pass_constant_propagation", graph_pass<ConstantPropagation>)
+   .def("_jit_pass_fold_conv_batch_norm", graph_pass<FoldConvBatchNorm>)
+   .def("_jit_pass_loop_unrolling", graph_pass<UnrollLoops>)
+   .def("_jit_pass_licm", graph_pass<HoistLoopInvariants>)
+   .def("_jit_pass_freeze_inputs", [](const std::shared_ptr<tracer::TracingState>& state, size_t first, py::tuple values) {
+     std::vector<at::Tensor> data;
+     for (auto & var : createVariableTensorList(values)) {
+       data.push_back(static_cast<autograd::Variable&>(var).data());
+     }
+     FreezeInputs(state->graph, first, data);
+   })
    .def("_jit_pass_shape_analysis", [](Graph& graph, py::tuple inputs, bool with_grad) {
      auto tensor_inputs = createVariableTensorList(inputs);
      PropagateInputShapes(graph, ArgumentSpec(with_grad, tensor_inputs));
@@ -82,29 +101,69 @@ void initJITBindings(PyObject *module) {
    })
    .def("_jit_unflatten", [](autograd::variable_list vars, python::IODescriptor& desc) {
      return py::reinterpret_steal<py::object>(python::unflatten(vars, desc));
-   });
+   })
+   .def("_jit_save_graph", [](const std::string& path, std::shared_ptr<Graph> graph, py::tuple initializers) {
+     std::vector<at::Tensor> data;
+     for (auto & var : createVariableTensorList(initializers)) {
+       data.push_back(static_cast<autograd::Variable&>(var).data());
+     }
+     SaveGraph(path, graph, data);
+   })
+   .def("_jit_load_graph", [](const std::string& path) {
+     auto loaded = LoadGraph(path);
+     variable_list initializers;
+     for (auto & tensor : loaded.second) {
+       initializers.push_back(autograd::make_variable(tensor, false));
+     }
+     return std::make_pair(loaded.first, initializers);
+   })
+   .def("_jit_clear_trace_cache", python::clearTraceCache)
+   .def("_jit_set_inter_op_threads", &setInterOpThreads);
 
   py::class_<GraphExecutor>(m, "GraphExecutor")
       .def(
           py::init([](py::function func,
                       variable_list inputs,
-                      bool optimize) {
+                      bool optimize,
+                      const std::string& cache_key,
+                      const std::string& cache_dir) {
               size_t num_inputs = inputs.size();
-              auto graph = tracer::createGraphByTracing(func, std::move(inputs), num_inputs);
+              auto graph = cache_key.empty()
+                  ? tracer::createGraphByTracing(func, std::move(inputs), num_inputs)
+                  : python::createGraphByTracingCached(func, std::move(inputs), num_inputs,
+                                                       cache_key, cache_dir);
               return GraphExecutor(graph, optimize);
           }),
           py::arg("func"),
           py::arg("inputs"),
-          py::arg("optimize") = true)
+          py::arg("optimize") = true,
+          py::arg("cache_key") = "",
+          py::arg("cache_dir") = "")
       .def(
           py::init([](std::shared_ptr<Graph> graph, bool optimize) {
             return GraphExecutor(std::move(graph), optimize);
           }),
           py::arg("graph"),
           py::arg("optimize") = true)
+      .def(
+          "set_batching",
+          &GraphExecutor::setBatching,
+          py::arg("max_batch_size"),
+          py::arg("timeout_us"))
+      .def(
+          "set_cuda_graphs",
+          &GraphExecutor::setCudaGraphs,
+          py::arg("enabled"))
       .def("__call__", [](GraphExecutor& ge, py::args args) -> py::object {
         auto inputs = createVariableTensorList(args);
-        auto outputs = ge.run(std::move(inputs));
+        variable_tensor_list outputs;
+        if (ge.isBatching()) {
+          // other threads have to be able to join the batch while we wait
+          AutoNoGIL no_gil;
+          outputs = ge.run(std::move(inputs));
+        } else {
+          outputs = ge.run(std::move(inputs));
+        }
         // if we don't tell pybind these are variables it chokes on the
         // conversion.
         // TODO: fix conversions to be sane and make sure this works.
@@ -6,15 +6,27 @@
 #include "torch/csrc/autograd/edge.h"
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/functions/special.h"
+#include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/jit/fusion_compiler.h"
 #include "torch/csrc/jit/generated/aten_dispatch.h"
 #include "torch/csrc/jit/graph_executor.h"
 #include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/passes/memory_planning.h"
 #include "torch/csrc/jit/tensor_conversions.h"
-
+#include "torch/csrc/utils/auto_gpu.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <typeinfo>
+#include <unordered_set>
 
 #ifndef NO_PYTHON
 #include "torch/csrc/autograd/python_engine.h"
@@ -778,12 +790,281 @@ int relativeJump(int from_inst, int to_inst) {
   return to_inst - (from_inst + 1);
 }
 
+// Arenas of the InterpreterState running on this thread. Instructions whose
+// outputs were assigned memory by the MemoryPlan write into views of these.
+static thread_local std::vector<at::Tensor> * current_arenas = nullptr;
+
+struct ArenaGuard {
+  ArenaGuard(std::vector<at::Tensor> * arenas)
+  : prev(current_arenas) {
+    current_arenas = arenas;
+  }
+  ~ArenaGuard() {
+    current_arenas = prev;
+  }
+  std::vector<at::Tensor> * prev;
+};
+
+// Inter-op parallelism: the straight-line part of a stage can be run in
+// dataflow order on a pool of threads, so that independent branches of the
+// graph (e.g. the towers of a two-tower model) run concurrently. It is off
+// by default; TORCH_JIT_INTER_OP_THREADS or setInterOpThreads() turn it on.
+
+static std::size_t defaultInterOpThreads() {
+  const char * threads_env = getenv("TORCH_JIT_INTER_OP_THREADS");
+  if (!threads_env) return 1;
+  int num_threads = std::atoi(threads_env);
+  if (num_threads < 1) {
+    throw std::runtime_error(
+        std::string("TORCH_JIT_INTER_OP_THREADS must be a positive integer, but got ") +
+        threads_env);
+  }
+  return num_threads;
+}
+
+// 0 until set, or read from the environment on the first run
+static std::atomic<std::size_t> num_inter_op_threads(0);
+
+static std::size_t interOpThreads() {
+  std::size_t num_threads = num_inter_op_threads.load();
+  if (num_threads == 0) {
+    std::size_t unset = 0;
+    num_inter_op_threads.compare_exchange_strong(unset, defaultInterOpThreads());
+    num_threads = num_inter_op_threads.load();
+  }
+  return num_threads;
+}
+
+// A stage running in parallel never starts another parallel run from the
+// pool's threads, which could otherwise all end up waiting for each other
+static thread_local bool in_parallel_stage = false;
+
+struct InterOpThreadPool {
+  void run(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // threads are only added: the pool lives as long as the process
+    while (num_threads < interOpThreads()) {
+      std::thread([this] { workerLoop(); }).detach();
+      num_threads++;
+    }
+    tasks.push_back(std::move(task));
+    task_available.notify_one();
+  }
+
+private:
+  void workerLoop() {
+    in_parallel_stage = true;
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        task_available.wait(lock, [this] { return !tasks.empty(); });
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable task_available;
+  std::deque<std::function<void()>> tasks;
+  std::size_t num_threads = 0;
+};
+
+static InterOpThreadPool & interOpThreadPool() {
+  // leaked, like the autograd engine's threads
+  static InterOpThreadPool * pool = new InterOpThreadPool();
+  return *pool;
+}
+
+void setInterOpThreads(std::size_t num_threads) {
+  JIT_ASSERTM(num_threads >= 1, "the number of inter-op threads must be positive");
+  num_inter_op_threads = num_threads;
+}
+
+std::size_t getInterOpThreads() {
+  return interOpThreads();
+}
+
+// The dependencies between the instructions [begin, end) of a stage
+struct ParallelSchedule {
+  size_t begin = 0;
+  size_t end = 0;
+  // indexed by instruction - begin
+  std::vector<std::vector<size_t>> dependents;
+  std::vector<int> num_dependencies;
+  std::vector<size_t> roots;
+};
+
 struct CodeImpl {
   CodeImpl(std::shared_ptr<Graph>& graph_, bool values_are_variables)
       : values_are_variables(values_are_variables), preprocess(*graph_) {
     graph = preprocess.graph;
+    // Memory planning only applies to plain tensors run in a single stage:
+    // Variables would need their own version tracking, and registers that
+    // survive between stages could be overwritten by a clone of this state.
+    if (!values_are_variables && preprocess.stage_input_types.size() == 1) {
+      memory_plan = PlanMemory(*graph);
+    }
     //std::cout << "into code graph:\n" << *graph << "\n";
     insertNodesFromBlock(graph->block());
+    // Memory planning reuses buffers based on the sequential order of the
+    // instructions, so it rules out running them in any other order
+    if (memory_plan.empty()) {
+      size_t stage_begin = 0;
+      for (auto stage_end_pc : stage_end) {
+        parallel_schedules.push_back(createParallelSchedule(stage_begin, stage_end_pc));
+        stage_begin = stage_end_pc;
+      }
+    }
+  }
+
+  // Each stage is a Store, the instructions computing the stage, and a Load.
+  // The ones in between can run in parallel when they are all ATen ops,
+  // fusion groups and bookkeeping: control flow needs a program counter,
+  // and the remaining kinds call into Python or autograd, or print.
+  // Returns a schedule without dependents when the stage has to run in order
+  // or has nothing to run concurrently.
+  ParallelSchedule createParallelSchedule(size_t stage_begin, size_t stage_end_pc) {
+    ParallelSchedule schedule;
+    if (stage_end_pc - stage_begin < 4)
+      return schedule;
+    size_t begin = stage_begin + 1;
+    size_t end = stage_end_pc - 1;
+    JIT_ASSERT(instructions[stage_begin].debug_name == prim::Store);
+    JIT_ASSERT(instructions[end].debug_name == prim::Load);
+    for (size_t pc = begin; pc < end; ++pc) {
+      auto kind = instructions[pc].debug_name;
+      if (!kind.is_aten() && kind != prim::FusionGroup && kind != prim::Constant &&
+          kind != prim::Undefined && kind != prim::ReplaceIfUndef && kind != prim::Drop) {
+        return schedule;
+      }
+    }
+
+    size_t n = end - begin;
+    std::vector<std::unordered_set<size_t>> dependencies(n);
+    std::unordered_map<int, size_t> writer;
+    std::unordered_map<int, std::vector<size_t>> readers;
+    for (size_t i = 0; i < n; ++i) {
+      auto & inst = instructions[begin + i];
+      for (int j = 0; j < inst.inputs.values.size; ++j) {
+        int reg = get(inst.inputs.values, j);
+        // registers written by the Store or by earlier stages are already set
+        auto w = writer.find(reg);
+        if (w != writer.end())
+          dependencies[i].insert(w->second);
+        // the last use moves the value out, after every other use
+        if (get(inst.inputs.free_flags, j)) {
+          for (auto reader : readers[reg]) {
+            if (reader != i)
+              dependencies[i].insert(reader);
+          }
+        }
+        readers[reg].push_back(i);
+      }
+      for (int j = 0; j < inst.outputs.size; ++j) {
+        writer[get(inst.outputs, j)] = i;
+      }
+    }
+
+    schedule.dependents.resize(n);
+    schedule.num_dependencies.resize(n);
+    bool has_concurrency = false;
+    for (size_t i = 0; i < n; ++i) {
+      schedule.num_dependencies[i] = dependencies[i].size();
+      if (dependencies[i].empty())
+        schedule.roots.push_back(i);
+      for (auto d : dependencies[i]) {
+        schedule.dependents[d].push_back(i);
+        has_concurrency |= schedule.dependents[d].size() > 1;
+      }
+    }
+    has_concurrency |= schedule.roots.size() > 1;
+    if (!has_concurrency)
+      return ParallelSchedule();
+    schedule.begin = begin;
+    schedule.end = end;
+    return schedule;
+  }
+
+  // Returns a set of arenas for the memory plan, reusing the ones released
+  // by previous runs when possible, or nullptr when nothing was planned.
+  std::shared_ptr<std::vector<at::Tensor>> acquireArenas() {
+    if (memory_plan.empty())
+      return nullptr;
+    std::vector<at::Tensor> arenas;
+    {
+      std::lock_guard<std::mutex> guard(arena_mutex);
+      if (!free_arenas.empty()) {
+        arenas = std::move(free_arenas.back());
+        free_arenas.pop_back();
+      }
+    }
+    if (arenas.empty()) {
+      for (auto & arena : memory_plan.arenas) {
+        AutoGPU gpu_guard(arena.device);
+        auto backend = arena.device < 0 ? at::kCPU : at::kCUDA;
+        arenas.push_back(at::getType(backend, arena.scalar_type).tensor({arena.numel}));
+      }
+    }
+    return std::shared_ptr<std::vector<at::Tensor>>(
+        new std::vector<at::Tensor>(std::move(arenas)),
+        [this](std::vector<at::Tensor> * arenas) {
+          std::lock_guard<std::mutex> guard(arena_mutex);
+          free_arenas.push_back(std::move(*arenas));
+          delete arenas;
+        });
+  }
+
+  // Like the FusionGroup operation in getOperation, but the outputs that have
+  // an allocation in the memory plan are views of the current arenas.
+  // Falls back to allocating them if the inputs don't have the sizes the
+  // plan was made for.
+  Operation createPlannedFusionOperation(Node * node) {
+    auto input_type = node->inputs().at(0)->type()->cast<TensorType>();
+    if (!input_type)
+      return getOperation(node, values_are_variables);
+    auto fusion_fn = sharedFusionCompiler().getOrCompile(node);
+    auto num_inputs = node->inputs().size();
+    auto map_size = input_type->sizes();
+    std::vector<const MemoryPlan::Allocation*> allocations;
+    for (auto output : node->outputs()) {
+      auto it = memory_plan.allocations.find(output);
+      allocations.push_back(it == memory_plan.allocations.end() ? nullptr : &it->second);
+    }
+    return [fusion_fn, num_inputs, map_size, allocations](Stack & stack) {
+      autograd::profiler::RecordFunction record("FusionGroup");
+      auto inputs = last(stack, num_inputs);
+      std::vector<at::Tensor> toutputs;
+      if (current_arenas && inputs[0].sizes().equals(map_size)) {
+        auto & descs = fusion_fn->outputDescriptors();
+        auto backend = inputs[0].type().backend();
+        toutputs.reserve(allocations.size());
+        for (size_t i = 0; i < allocations.size(); ++i) {
+          if (auto a = allocations[i]) {
+            toutputs.push_back((*current_arenas)[a->arena].as_strided(a->sizes, a->strides, a->offset));
+          } else {
+            AutoGPU gpu_guard(inputs[0]);
+            toutputs.push_back(at::getType(backend, descs[i].scalar_type).tensor());
+          }
+        }
+        fusion_fn->launch_with_tensors(inputs, toutputs);
+      } else {
+        fusion_fn->launch(inputs, toutputs);
+      }
+      drop(stack, num_inputs);
+      stack.insert(stack.end(), toutputs.begin(), toutputs.end());
+      return 0;
+    };
+  }
+
+  bool hasPlannedOutputs(Node * n) {
+    for (auto output : n->outputs()) {
+      if (memory_plan.allocations.count(output) > 0)
+        return true;
+    }
+    return false;
   }
 
   // jump when input is 0
@@ -907,7 +1188,11 @@ struct CodeImpl {
 
   size_t insertInstruction(Node * n) {
     auto inst = insertInstruction(n->kind(), n->getSourceLocation(), n->inputs(), moveFlags(n) , n->outputs());
-    instructions[inst].callback = getOperation(n, values_are_variables);
+    if (n->kind() == prim::FusionGroup && hasPlannedOutputs(n)) {
+      instructions[inst].callback = createPlannedFusionOperation(n);
+    } else {
+      instructions[inst].callback = getOperation(n, values_are_variables);
+    }
     return inst;
   }
   size_t insertInstruction(Symbol sym,
@@ -1036,11 +1321,18 @@ struct CodeImpl {
   bool values_are_variables;
   PreprocessGraph preprocess;
 
+  MemoryPlan memory_plan;
+  // arenas released by finished InterpreterStates, ready for the next run
+  std::mutex arena_mutex;
+  std::vector<std::vector<at::Tensor>> free_arenas;
+
   std::unordered_map<size_t, int> unique_to_reg; // map from unique of nodes to register in register table
 
   friend struct InterpreterState;
   std::vector<Instruction> instructions;
   std::vector<size_t> stage_end; // each stage runs while(pc < stage_end[stage])
+  // one per stage when memory planning is off, see createParallelSchedule
+  std::vector<ParallelSchedule> parallel_schedules;
   int register_size = 0;
 
   // all memory ArrayRef<int> are slices of this, to make sure
@@ -1055,39 +1347,114 @@ struct InterpreterStateImpl {
   : function(function_.pImpl),
     int_data(function->int_data.data()),
     bool_data(function->bool_data),
+    arenas(function->acquireArenas()),
     registers(function->register_size) {
   }
   void runOneStage(Stack & stack) {
+    ArenaGuard arena_guard(arenas.get());
     // std::cout << "running stage: " << current_stage << " of " << function->stage_end.size() << "\n";
     // std::cout << *function->graph << "\n";
     // function->dump(std::cout);
     size_t pc = current_pc;
     size_t last = function->stage_end[current_stage];
-    auto & instructions = function->instructions;
+    if (auto schedule = parallelSchedule(stack)) {
+      while(pc < schedule->begin) {
+        pc = runInstruction(pc, stack);
+      }
+      runParallel(*schedule);
+      pc = schedule->end;
+    }
     while(pc < last) {
         // std::cout << "executing " << pc << ": ";
         // function->dumpInstruction(std::cout, pc);
         // std::cout << "\n";
-        try {
-          auto & inst = instructions[pc];
-          loadTensorsFromRegisters(inst.inputs, stack);
-          size_t new_pc = pc + 1 + inst.callback(stack);
-          for(int i = inst.outputs.size - 1; i >= 0; i--) {
-            int reg = get(inst.outputs,i);
-            registers[reg] = pop(stack);
-            // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
-          }
-          pc = new_pc;
-        } catch(std::exception & e) {
-          if(!instructions[pc].debug_location)
-            throw; // rethrow original exception
-          // throw a new exception with enhanced debugging information
-          instructions[pc].debug_location->wrapAndRethrowException(e, "operation failed in interpreter");
-        }
+        pc = runInstruction(pc, stack);
     }
     current_pc = pc;
     current_stage++;
   }
+  // runs instruction pc and returns the next one
+  size_t runInstruction(size_t pc, Stack & stack) {
+    auto & instructions = function->instructions;
+    try {
+      auto & inst = instructions[pc];
+      loadTensorsFromRegisters(inst.inputs, stack);
+      size_t new_pc = pc + 1 + inst.callback(stack);
+      for(int i = inst.outputs.size - 1; i >= 0; i--) {
+        int reg = get(inst.outputs,i);
+        registers[reg] = pop(stack);
+        // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
+      }
+      return new_pc;
+    } catch(std::exception & e) {
+      if(!instructions[pc].debug_location)
+        throw; // rethrow original exception
+      // throw a new exception with enhanced debugging information
+      instructions[pc].debug_location->wrapAndRethrowException(e, "operation failed in interpreter");
+      throw; // not reached
+    }
+  }
+  // The schedule of the current stage, if it should run in parallel. CUDA
+  // inputs run in order: the pool's threads don't share the current stream.
+  const ParallelSchedule * parallelSchedule(const Stack & stack) {
+    if (interOpThreads() <= 1 || in_parallel_stage ||
+        current_stage >= function->parallel_schedules.size())
+      return nullptr;
+    auto & schedule = function->parallel_schedules[current_stage];
+    if (schedule.dependents.empty() || current_pc + 1 != schedule.begin)
+      return nullptr;
+    for (auto & input : stack) {
+      if (input.defined() && input.type().is_cuda())
+        return nullptr;
+    }
+    return &schedule;
+  }
+  // Runs the instructions of the schedule on the inter-op thread pool, each
+  // one once all the instructions it depends on are done
+  void runParallel(const ParallelSchedule & schedule) {
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::vector<int> pending = schedule.num_dependencies;
+    size_t in_flight = 0;
+    std::exception_ptr error;
+    bool grad_mode = autograd::GradMode::is_enabled();
+    auto & pool = interOpThreadPool();
+
+    // called with mutex held
+    std::function<void(size_t)> submit = [&](size_t i) {
+      in_flight++;
+      pool.run([&, i] {
+        std::exception_ptr task_error;
+        try {
+          autograd::AutoGradMode grad_mode_guard(grad_mode);
+          ArenaGuard arena_guard(nullptr);
+          Stack task_stack;
+          runInstruction(schedule.begin + i, task_stack);
+        } catch (...) {
+          task_error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (task_error && !error)
+          error = task_error;
+        // after an error, only wait for what is already running
+        if (!error) {
+          for (auto d : schedule.dependents[i]) {
+            if (--pending[d] == 0)
+              submit(d);
+          }
+        }
+        if (--in_flight == 0)
+          finished.notify_all();
+      });
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto root : schedule.roots)
+      submit(root);
+    finished.wait(lock, [&] { return in_flight == 0; });
+    if (error)
+      std::rethrow_exception(error);
+  }
   const TensorType & tensorTypeForInput(size_t i) const {
     return *function->preprocess.stage_input_types.at(current_stage).at(i)->expect<TensorType>();
   }
@@ -1116,6 +1483,9 @@ struct InterpreterStateImpl {
   int * int_data;
   const std::vector<bool> & bool_data;
 
+  // memory for the values planned by function->memory_plan, returned to
+  // function when the last state using it is destroyed
+  std::shared_ptr<std::vector<at::Tensor>> arenas;
 
   // this holds all the tensors for this interpreter run
   // we don't bother minimizing the size of this vector, since the extra
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -32,6 +33,12 @@ private:
   friend std::ostream & operator<<(std::ostream & out, const Code & code);
 };
 
+// Number of threads used to run independent instructions of a stage
+// concurrently (1, the default, runs everything in order on the calling
+// thread). Defaults to TORCH_JIT_INTER_OP_THREADS when it is set.
+void setInterOpThreads(std::size_t num_threads);
+std::size_t getInterOpThreads();
+
 struct InterpreterState {
   InterpreterState(const Code & code);
   // advance the interpreter state by running one stage. Returning the
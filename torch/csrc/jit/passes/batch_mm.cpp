@@ -6,6 +6,7 @@
 
 #include <ATen/ATen.h>
 #include <algorithm>
+#include <map>
 #include <unordered_map>
 
 namespace torch { namespace jit {
@@ -64,6 +65,22 @@ namespace torch { namespace jit {
 // topological order and labeling nodes with TreeTokens. Then, we look for roots of
 // the trees we formed and fuse them.
 
+// Note [Independent MMs]
+// After the trees are merged, we also batch mm ops that don't feed an add, but
+// are independent of each other, like the projections in multi-head attention
+// or the per-gate matmuls of an RNN cell:
+//
+// * if they all share their lhs, we cat the rhs operands along dim 1, do a
+//   single mm, and narrow the columns of the result for every original mm,
+// * if they all share their rhs, we do the same with the lhs operands and rows,
+// * otherwise, if all operands have the same sizes, we stack them and do a bmm,
+//   selecting every original result from it.
+//
+// To keep the check for data dependencies simple, an mm can only join a group
+// if all of its operands are already available at the first mm of the group.
+// This guarantees that none of them depends on another one, and that the
+// batched op can simply be inserted before the first mm.
+
 // Tunable parameter. Set to something larger if it turns out to be better.
 static constexpr std::size_t min_fusion_size = 2;
 
@@ -139,6 +156,152 @@ struct TreeToken {
   }
 };
 
+struct MMGroup {
+  enum class Kind { Single, SharedLHS, SharedRHS, SameSizes };
+  Kind kind = Kind::Single;
+  std::vector<Node*> matmuls;
+};
+
+static TensorType* mmOperandType(Value *v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type || type->sizes().size() != 2)
+    return nullptr;
+  return type;
+}
+
+static void batchIndependentMMs(Block* block) {
+  using Kind = MMGroup::Kind;
+  auto graph = block->owningGraph();
+
+  std::unordered_map<Node*, size_t> position;
+  for (auto node : block->nodes()) {
+    position.emplace(node, position.size());
+  }
+  // values defined outside of this block (and its inputs) are always available
+  auto availableAt = [&](Value *v, Node *n) {
+    auto it = position.find(v->node());
+    return it == position.end() || it->second < position.at(n);
+  };
+
+  std::vector<MMGroup> groups;
+  // the most recent group for every key, that later mms can try to join
+  std::unordered_map<Value*, size_t> by_lhs;
+  std::unordered_map<Value*, size_t> by_rhs;
+  std::map<std::vector<int64_t>, size_t> by_sizes;
+  for (auto node : block->nodes()) {
+    if (node->kind() != aten::mm || node->inputs().size() != 2)
+      continue;
+    Value *lhs = node->inputs()[0];
+    Value *rhs = node->inputs()[1];
+    auto lhs_type = mmOperandType(lhs);
+    auto rhs_type = mmOperandType(rhs);
+    if (!lhs_type || !rhs_type || !node->output()->type()->cast<TensorType>())
+      continue;
+    std::vector<int64_t> sizes_key {
+      static_cast<int64_t>(lhs_type->scalarType()), lhs_type->device(),
+      lhs_type->sizes()[0], lhs_type->sizes()[1],
+      rhs_type->sizes()[0], rhs_type->sizes()[1]};
+
+    auto tryJoin = [&](size_t idx, Kind kind) {
+      auto & group = groups[idx];
+      if (group.kind != Kind::Single && group.kind != kind)
+        return false;
+      Node *first = group.matmuls.front();
+      if (!availableAt(lhs, first) || !availableAt(rhs, first))
+        return false;
+      group.kind = kind;
+      group.matmuls.push_back(node);
+      return true;
+    };
+    auto lhs_it = by_lhs.find(lhs);
+    if (lhs_it != by_lhs.end() && tryJoin(lhs_it->second, Kind::SharedLHS))
+      continue;
+    auto rhs_it = by_rhs.find(rhs);
+    if (rhs_it != by_rhs.end() && tryJoin(rhs_it->second, Kind::SharedRHS))
+      continue;
+    auto sizes_it = by_sizes.find(sizes_key);
+    if (sizes_it != by_sizes.end() && tryJoin(sizes_it->second, Kind::SameSizes))
+      continue;
+
+    groups.emplace_back();
+    groups.back().matmuls.push_back(node);
+    by_lhs[lhs] = by_rhs[rhs] = by_sizes[sizes_key] = groups.size() - 1;
+  }
+
+  for (auto & group : groups) {
+    auto & matmuls = group.matmuls;
+    if (matmuls.size() < min_fusion_size)
+      continue;
+    Node *first = matmuls.front();
+    WithInsertPoint guard(first);
+    if (group.kind == Kind::SharedLHS || group.kind == Kind::SharedRHS) {
+      bool shared_lhs = group.kind == Kind::SharedLHS;
+      int64_t cat_dim = shared_lhs ? 1 : 0;
+      int64_t operand = shared_lhs ? 1 : 0;
+      std::vector<Value*> parts;
+      int64_t cat_size = 0;
+      for (auto mm : matmuls) {
+        parts.push_back(mm->inputs()[operand]);
+        cat_size += mmOperandType(mm->inputs()[operand])->sizes()[cat_dim];
+      }
+      auto part_type = mmOperandType(parts[0]);
+      auto cat_sizes = part_type->sizes();
+      cat_sizes[cat_dim] = cat_size;
+      Node *cat = graph->insertNode(graph->create(aten::cat, parts)->i_(attr::dim, cat_dim));
+      cat->output()->setType(part_type->withSizes(cat_sizes));
+
+      auto out_type = first->output()->type()->expect<TensorType>();
+      auto out_sizes = out_type->sizes();
+      out_sizes[cat_dim] = cat_size;
+      Node *batch_mm = shared_lhs
+        ? graph->create(aten::mm, {first->inputs()[0], cat->output()})
+        : graph->create(aten::mm, {cat->output(), first->inputs()[1]});
+      graph->insertNode(batch_mm);
+      auto batch_type = out_type->withSizes(out_sizes);
+      batch_mm->output()->setType(batch_type);
+
+      int64_t offset = 0;
+      for (auto mm : matmuls) {
+        auto length = mm->output()->type()->expect<TensorType>()->sizes()[cat_dim];
+        Node *narrow = graph->insertNode(graph->create(aten::narrow, {batch_mm->output()})
+                                         ->i_(attr::dim, cat_dim)
+                                         ->i_(attr::start, offset)
+                                         ->i_(attr::length, length));
+        auto sizes = out_sizes;
+        sizes[cat_dim] = length;
+        narrow->output()->setType(batch_type->expect<TensorType>()->withSizesStrides(
+            sizes, batch_type->expect<TensorType>()->strides()));
+        mm->output()->replaceAllUsesWith(narrow->output());
+        offset += length;
+      }
+    } else {
+      auto stack_inputs = [&](size_t operand) {
+        auto inputs = fmap(matmuls, [=](Node *mm) { return mm->inputs()[operand]; });
+        auto type = mmOperandType(inputs[0]);
+        auto sizes = type->sizes();
+        sizes.insert(sizes.begin(), matmuls.size());
+        Node *stack = graph->insertNode(graph->create(aten::stack, inputs)->i_(attr::dim, 0));
+        stack->output()->setType(type->withSizes(sizes));
+        return stack->output();
+      };
+      auto lhs_batch = stack_inputs(0);
+      auto rhs_batch = stack_inputs(1);
+      auto out_type = first->output()->type()->expect<TensorType>();
+      auto sizes = out_type->sizes();
+      sizes.insert(sizes.begin(), matmuls.size());
+      Node *bmm = graph->insertNode(graph->create(aten::bmm, {lhs_batch, rhs_batch}));
+      bmm->output()->setType(out_type->withSizes(sizes));
+      for (size_t i = 0; i < matmuls.size(); ++i) {
+        Node *select = graph->insertNode(graph->create(aten::select, {bmm->output()})
+                                         ->i_(attr::dim, 0)
+                                         ->i_(attr::index, i));
+        select->output()->setType(out_type->contiguous());
+        matmuls[i]->output()->replaceAllUsesWith(select->output());
+      }
+    }
+  }
+}
+
 void BatchMMBlock(Block* block) {
   enum class Side { LHS, RHS };
   auto graph = block->owningGraph();
@@ -203,6 +366,10 @@ void BatchMMBlock(Block* block) {
     // NB: don't bother with cleaning up after yourself. We'll use DCE for that.
   }
   EliminateDeadCode(block);
+
+  // See Note [Independent MMs]
+  batchIndependentMMs(block);
+  EliminateDeadCode(block);
 }
 
 void BatchMM(std::shared_ptr<Graph>& graph) {
@@ -0,0 +1,104 @@
+#include "torch/csrc/jit/passes/constant_propagation.h"
+
+#include "torch/csrc/jit/passes/dead_code_elimination.h"
+#include "torch/csrc/jit/generated/aten_dispatch.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace torch { namespace jit {
+
+namespace {
+
+// ops that have to draw new random numbers on every run
+std::unordered_set<std::string> nondeterministic_ops = {
+  "alpha_dropout",
+  "bernoulli",
+  "dropout",
+  "feature_alpha_dropout",
+  "feature_dropout",
+  "multinomial",
+  "normal",
+  "poisson",
+  "rand",
+  "rand_like",
+  "randint",
+  "randint_like",
+  "randn",
+  "randn_like",
+  "randperm",
+  "rrelu",
+  "rrelu_with_noise",
+  "_standard_gamma",
+};
+
+} // anonymous namespace
+
+bool isNondeterministic(Node * n) {
+  return n->kind().is_aten() && nondeterministic_ops.count(n->kind().toUnqualString()) > 0;
+}
+
+namespace {
+
+bool isFoldable(Node * n) {
+  if (!n->kind().is_aten() || n->blocks().size() > 0 || n->outputs().size() == 0)
+    return false;
+  std::string name = n->kind().toUnqualString();
+  // in-place ops would modify the constants they are given
+  if (name.back() == '_' || isNondeterministic(n))
+    return false;
+  for (auto input : n->inputs()) {
+    if (input->node()->kind() != prim::Constant)
+      return false;
+  }
+  return hasTensorOp(n);
+}
+
+void ConstantPropagation(Block * block) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end(); ++it) {
+    auto * n = *it;
+    for (Block * sub_block : n->blocks()) {
+      ConstantPropagation(sub_block);
+    }
+    if (!isFoldable(n))
+      continue;
+
+    Stack stack;
+    for (auto input : n->inputs()) {
+      stack.push_back(input->node()->t(attr::value));
+    }
+    getTensorOp(n).op(stack);
+    JIT_ASSERT(stack.size() == n->outputs().size());
+    for (size_t i = 0; i < stack.size(); ++i) {
+      // createConstant stores a contiguous copy, so e.g. a transposed weight
+      // feeding addmm is laid out once here instead of on every run
+      auto constant = block->owningGraph()->createConstant(stack[i])->insertBefore(n);
+      constant->output()->inferTypeFrom(constant->t(attr::value));
+      n->outputs()[i]->replaceAllUsesWith(constant->output());
+    }
+    it.destroyCurrent();
+  }
+}
+
+} // anonymous namespace
+
+void FreezeInputs(std::shared_ptr<Graph>& graph, size_t first, at::ArrayRef<at::Tensor> values) {
+  JIT_ASSERT(first + values.size() <= graph->inputs().size());
+  // prepended in reverse, so the constants end up in the order of the inputs
+  for (size_t i = values.size(); i > 0; --i) {
+    auto constant = graph->prependNode(graph->createConstant(values[i - 1]));
+    constant->output()->inferTypeFrom(constant->t(attr::value));
+    graph->inputs()[first + i - 1]->replaceAllUsesWith(constant->output());
+  }
+  for (size_t i = values.size(); i > 0; --i) {
+    graph->eraseInput(first + i - 1);
+  }
+}
+
+void ConstantPropagation(std::shared_ptr<Graph>& graph) {
+  ConstantPropagation(graph->block());
+  // the constants that were only used by folded nodes
+  EliminateDeadCode(graph);
+}
+
+}}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Replaces the graph inputs [first, first + values.size()) with constants
+// holding values, e.g. to freeze the parameters of a module used only for
+// inference.
+void FreezeInputs(std::shared_ptr<Graph>& graph, size_t first, at::ArrayRef<at::Tensor> values);
+
+// Evaluates the ATen nodes whose inputs are all constants once, and replaces
+// them with constants holding their results.
+void ConstantPropagation(std::shared_ptr<Graph>& graph);
+
+// Whether n draws new random numbers every time it runs, so that it can
+// neither be evaluated ahead of time nor moved out of a loop.
+bool isNondeterministic(Node * n);
+
+}}
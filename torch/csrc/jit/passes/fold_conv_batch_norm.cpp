@@ -0,0 +1,89 @@
+#include "torch/csrc/jit/passes/fold_conv_batch_norm.h"
+
+#include "torch/csrc/jit/passes/dead_code_elimination.h"
+
+#include <ATen/ATen.h>
+
+namespace torch { namespace jit {
+
+namespace {
+
+bool isConstant(Value * v) {
+  return v->node()->kind() == prim::Constant;
+}
+
+bool isConstantOrUndefined(Value * v) {
+  return isConstant(v) || v->node()->kind() == prim::Undefined;
+}
+
+// In eval mode, batch_norm(conv(x, W, b)) is a per output channel affine
+// transform of the convolution, which can be applied to its parameters:
+//   scale = gamma / sqrt(running_var + eps)
+//   W' = W * scale
+//   b' = (b - running_mean) * scale + beta
+// This saves reading and writing the whole activation once more.
+bool canFold(Node * bn) {
+  if (bn->kind() != aten::batch_norm || bn->i(attr::training))
+    return false;
+  auto conv = bn->inputs()[0]->node();
+  if (conv->kind() != aten::_convolution || conv->i(attr::transposed) ||
+      conv->output()->uses().size() != 1 || conv->owningBlock() != bn->owningBlock())
+    return false;
+  return isConstant(conv->inputs()[1]) && isConstantOrUndefined(conv->inputs()[2]) &&
+         isConstantOrUndefined(bn->inputs()[1]) && isConstantOrUndefined(bn->inputs()[2]) &&
+         isConstant(bn->inputs()[3]) && isConstant(bn->inputs()[4]);
+}
+
+at::Tensor constantValue(Value * v) {
+  if (v->node()->kind() == prim::Undefined)
+    return at::Tensor();
+  return v->node()->t(attr::value);
+}
+
+void FoldConvBatchNorm(Block * block) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end(); ++it) {
+    auto * bn = *it;
+    for (Block * sub_block : bn->blocks()) {
+      FoldConvBatchNorm(sub_block);
+    }
+    if (!canFold(bn))
+      continue;
+    auto conv = bn->inputs()[0]->node();
+    auto weight = constantValue(conv->inputs()[1]);
+    auto bias = constantValue(conv->inputs()[2]);
+    auto gamma = constantValue(bn->inputs()[1]);
+    auto beta = constantValue(bn->inputs()[2]);
+    auto mean = constantValue(bn->inputs()[3]);
+    auto var = constantValue(bn->inputs()[4]);
+
+    auto scale = (var + bn->f(attr::eps)).rsqrt();
+    if (gamma.defined())
+      scale = scale * gamma;
+    std::vector<int64_t> scale_sizes(weight.dim(), 1);
+    scale_sizes[0] = -1;
+    auto new_weight = weight * scale.view(scale_sizes);
+    auto new_bias = ((bias.defined() ? bias - mean : -mean) * scale);
+    if (beta.defined())
+      new_bias = new_bias + beta;
+
+    Graph * graph = block->owningGraph();
+    auto weight_node = graph->createConstant(new_weight)->insertBefore(conv);
+    weight_node->output()->inferTypeFrom(new_weight);
+    auto bias_node = graph->createConstant(new_bias)->insertBefore(conv);
+    bias_node->output()->inferTypeFrom(new_bias);
+    conv->replaceInput(1, weight_node->output());
+    conv->replaceInput(2, bias_node->output());
+    bn->output()->replaceAllUsesWith(conv->output());
+    it.destroyCurrent();
+  }
+}
+
+} // anonymous namespace
+
+void FoldConvBatchNorm(std::shared_ptr<Graph>& graph) {
+  FoldConvBatchNorm(graph->block());
+  // the original parameters, if nothing else uses them
+  EliminateDeadCode(graph);
+}
+
+}}
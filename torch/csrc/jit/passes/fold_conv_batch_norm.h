@@ -0,0 +1,11 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Folds eval mode batch_norm nodes into the _convolution producing their
+// input, when the weights of both are constants (see FreezeInputs).
+void FoldConvBatchNorm(std::shared_ptr<Graph>& graph);
+
+}}
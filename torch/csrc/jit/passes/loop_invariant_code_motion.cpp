@@ -0,0 +1,67 @@
+#include "torch/csrc/jit/passes/loop_invariant_code_motion.h"
+
+#include "torch/csrc/jit/passes/constant_propagation.h"
+
+#include <string>
+
+namespace torch { namespace jit {
+
+namespace {
+
+bool isHoistable(Node * n) {
+  if (n->kind() == prim::Constant)
+    return true;
+  if (!n->kind().is_aten() || n->blocks().size() > 0)
+    return false;
+  std::string name = n->kind().toUnqualString();
+  // in-place ops would modify their inputs once instead of on every iteration
+  return name.back() != '_' && !isNondeterministic(n);
+}
+
+bool isDefinedIn(Value * v, Block * block) {
+  for (Block * b = v->node()->owningBlock(); b != nullptr;) {
+    if (b == block)
+      return true;
+    Node * owner = b->owningNode();
+    b = owner ? owner->owningBlock() : nullptr;
+  }
+  return false;
+}
+
+void hoistFromLoop(Node * loop) {
+  Block * body = loop->blocks()[0];
+  // nodes are visited in order, so the invariants that use hoisted values
+  // are hoisted as well
+  for (auto it = body->nodes().begin(); it != body->nodes().end();) {
+    Node * n = *it++;
+    if (!isHoistable(n))
+      continue;
+    bool invariant = true;
+    for (Value * input : n->inputs()) {
+      invariant &= !isDefinedIn(input, body);
+    }
+    if (invariant)
+      n->moveBefore(loop);
+  }
+}
+
+void HoistLoopInvariants(Block * block) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node * n = *it++;
+    // inner loops first, so that their invariants can move out of all the
+    // loops they don't depend on
+    for (Block * sub_block : n->blocks()) {
+      HoistLoopInvariants(sub_block);
+    }
+    if (n->kind() == prim::Loop)
+      hoistFromLoop(n);
+  }
+}
+
+} // anonymous namespace
+
+void HoistLoopInvariants(std::shared_ptr<Graph>& graph) {
+  HoistLoopInvariants(graph->block());
+}
+
+}}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Moves the constants and the pure ATen nodes of prim::Loop bodies that only
+// depend on values defined outside the loop in front of the loop, e.g. the
+// transposes of the weights of a scripted RNN cell. Hoisted nodes run even if
+// the loop doesn't, which only matters if they fail.
+void HoistLoopInvariants(std::shared_ptr<Graph>& graph);
+
+}}
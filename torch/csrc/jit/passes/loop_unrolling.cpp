@@ -0,0 +1,182 @@
+#include "torch/csrc/jit/passes/loop_unrolling.h"
+
+#include "ATen/optional.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace torch { namespace jit {
+
+namespace {
+
+static constexpr int64_t kUnrollFactor = 8;
+static constexpr int64_t kMaxBodySize = 32;
+
+at::optional<int64_t> getConstantInt(Value * v) {
+  Node * n = v->node();
+  if (n->kind() != prim::Constant)
+    return at::nullopt;
+  const at::Tensor & t = n->t(attr::value);
+  if (t.numel() != 1 || !at::isIntegralType(t.type().scalarType()))
+    return at::nullopt;
+  return at::Scalar(t).toLong();
+}
+
+// Loop counters are single element long tensors, see desugarTripCounts in
+// interpreter.cpp
+Value * insertCounter(Graph * g, int64_t value) {
+  auto constant = g->insertNode(g->createConstant(at::zeros(at::CPU(at::kLong), {1}).fill_(value)));
+  constant->output()->inferTypeFrom(constant->t(attr::value));
+  return constant->output();
+}
+
+int64_t bodySize(Block * body) {
+  int64_t size = 0;
+  for (Node * n : body->nodes()) {
+    if (n->kind() == prim::Constant)
+      continue;
+    size++;
+    for (Block * sub_block : n->blocks()) {
+      size += bodySize(sub_block);
+    }
+  }
+  return size;
+}
+
+// for loops: a constant trip count, and conditions that are always true
+bool isUnrollable(Node * loop) {
+  Block * body = loop->blocks()[0];
+  auto trip_count = getConstantInt(loop->inputs()[0]);
+  auto start_cond = getConstantInt(loop->inputs()[1]);
+  auto body_cond = getConstantInt(body->outputs()[0]);
+  return trip_count && start_cond && *start_cond != 0 && body_cond && *body_cond != 0 &&
+         bodySize(body) <= kMaxBodySize;
+}
+
+// A copy of the nodes of a loop body, taken before the body is modified.
+// A copy of the body is inserted at the insertion point by calling it with
+// the counter (which may be null if the body doesn't use it) and the values
+// of the loop-carried dependencies, and returns their values after the copy.
+struct BodyCopier {
+  BodyCopier(Block * body)
+  : body(body)
+  , counter(body->inputs()[0])
+  , nodes(body->nodes().begin(), body->nodes().end())
+  , outputs(body->outputs().vec()) {}
+
+  std::vector<Value*> operator()(Value * counter_value, at::ArrayRef<Value*> carried) {
+    Graph * g = body->owningGraph();
+    std::unordered_map<Value*, Value*> value_map;
+    if (counter_value)
+      value_map[counter] = counter_value;
+    for (size_t i = 0; i < carried.size(); ++i) {
+      value_map[body->inputs()[i + 1]] = carried[i];
+    }
+    auto env = [&](Value * v) {
+      auto it = value_map.find(v);
+      return it != value_map.end() ? it->second : v;
+    };
+    for (Node * n : nodes) {
+      Node * copy = g->insertNode(g->createClone(n, env));
+      for (size_t i = 0; i < n->outputs().size(); ++i) {
+        value_map[n->outputs()[i]] = copy->outputs()[i];
+      }
+    }
+    std::vector<Value*> result;
+    for (size_t i = 1; i < outputs.size(); ++i) {
+      result.push_back(env(outputs[i]));
+    }
+    return result;
+  }
+
+  Block * body;
+  // the value the nodes use as the iteration number
+  Value * counter;
+  std::vector<Node*> nodes;
+  std::vector<Value*> outputs;
+};
+
+void unroll(Node * loop) {
+  Graph * g = loop->owningGraph();
+  Block * body = loop->blocks()[0];
+  int64_t trip_count = std::max<int64_t>(*getConstantInt(loop->inputs()[0]), 0);
+  bool uses_counter = body->inputs()[0]->uses().size() > 0;
+  BodyCopier copy_body(body);
+
+  // peel off the iterations that don't fill a whole unrolled iteration
+  int64_t peeled = trip_count <= kUnrollFactor ? trip_count : trip_count % kUnrollFactor;
+  std::vector<Value*> carried(loop->inputs().begin() + 2, loop->inputs().end());
+  {
+    WithInsertPoint guard(loop);
+    for (int64_t i = 0; i < peeled; ++i) {
+      carried = copy_body(uses_counter ? insertCounter(g, i) : nullptr, carried);
+    }
+  }
+  if (peeled == trip_count) {
+    for (size_t i = 0; i < carried.size(); ++i) {
+      loop->outputs()[i]->replaceAllUsesWith(carried[i]);
+    }
+    loop->destroy();
+    return;
+  }
+  for (size_t i = 0; i < carried.size(); ++i) {
+    loop->replaceInput(i + 2, carried[i]);
+  }
+  {
+    WithInsertPoint guard(loop);
+    loop->replaceInput(0, insertCounter(g, trip_count / kUnrollFactor));
+  }
+
+  // iteration i now runs the original iterations
+  // peeled + i * kUnrollFactor + k for k in [0, kUnrollFactor)
+  Value * first_counter = nullptr;
+  if (uses_counter) {
+    Value * counter = body->inputs()[0];
+    WithInsertPoint guard(*body->nodes().begin());
+    Node * mul = g->insertNode(g->create(aten::mul, {counter, insertCounter(g, kUnrollFactor)}));
+    first_counter = mul->output();
+    if (peeled > 0) {
+      Value * one = insertCounter(g, 1);
+      first_counter = g->insertNode(g->create(aten::add, {first_counter, insertCounter(g, peeled), one}))->output();
+    }
+    counter->replaceAllUsesWith(first_counter);
+    mul->replaceInput(0, counter);
+    // the copies are taken from the body, which now uses first_counter
+    copy_body.counter = first_counter;
+  }
+  std::vector<Value*> body_carried(copy_body.outputs.begin() + 1, copy_body.outputs.end());
+  WithInsertPoint guard(body);
+  Value * one = uses_counter ? insertCounter(g, 1) : nullptr;
+  for (int64_t k = 1; k < kUnrollFactor; ++k) {
+    Value * counter = nullptr;
+    if (uses_counter) {
+      counter = g->insertNode(g->create(aten::add, {first_counter, insertCounter(g, k), one}))->output();
+    }
+    body_carried = copy_body(counter, body_carried);
+  }
+  for (size_t i = 0; i < body_carried.size(); ++i) {
+    body->return_node()->replaceInput(i + 1, body_carried[i]);
+  }
+}
+
+void UnrollLoops(Block * block) {
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node * n = *it++;
+    // inner loops first, the outer ones are then unrolled only if the
+    // unrolled inner loops still fit in their body
+    for (Block * sub_block : n->blocks()) {
+      UnrollLoops(sub_block);
+    }
+    if (n->kind() == prim::Loop && isUnrollable(n))
+      unroll(n);
+  }
+}
+
+} // anonymous namespace
+
+void UnrollLoops(std::shared_ptr<Graph>& graph) {
+  UnrollLoops(graph->block());
+}
+
+}}
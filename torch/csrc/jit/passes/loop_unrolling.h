@@ -0,0 +1,14 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Unrolls the small prim::Loops that run a constant number of iterations:
+// loops of at most 8 iterations are replaced by copies of their body, and
+// longer ones run 8 copies of their body per iteration, after the remaining
+// iterations are peeled off in front of them. Bodies with more than 32 nodes
+// are left alone.
+void UnrollLoops(std::shared_ptr<Graph>& graph);
+
+}}
@@ -0,0 +1,151 @@
+#include "torch/csrc/jit/passes/memory_planning.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+
+namespace torch { namespace jit {
+
+namespace {
+
+// Offsets are rounded up to this many elements, so that every planned tensor
+// starts at an address the fused kernels can load from efficiently.
+constexpr int64_t kAlignment = 16;
+
+// Nodes that don't hold on to their inputs after they run, and whose outputs
+// never share memory with their inputs. A value used only by these is dead
+// after its last use, so its memory can be handed to another value.
+bool isNonAliasingUser(Node * n) {
+  static std::unordered_set<Symbol> ops = {
+    prim::FusionGroup,
+    prim::Drop,
+    aten::mm,
+    aten::addmm,
+    aten::bmm,
+    aten::baddbmm,
+    aten::add,
+    aten::sub,
+    aten::mul,
+    aten::div,
+    aten::sigmoid,
+    aten::tanh,
+    aten::relu,
+    aten::exp,
+    aten::log,
+    aten::neg,
+    aten::cat,
+    aten::sum,
+    aten::mean,
+  };
+  return ops.count(n->kind()) > 0;
+}
+
+int64_t alignUp(int64_t n) {
+  return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+struct LiveRange {
+  Value * value;
+  size_t begin;
+  size_t end; // inclusive
+  size_t arena;
+  int64_t numel;
+  int64_t offset;
+};
+
+bool overlaps(const LiveRange & a, const LiveRange & b) {
+  return a.begin <= b.end && b.begin <= a.end;
+}
+
+} // anonymous namespace
+
+MemoryPlan PlanMemory(Graph& graph) {
+  MemoryPlan plan;
+
+  std::unordered_map<Node*, size_t> position;
+  for (auto n : graph.nodes()) {
+    position.emplace(n, position.size());
+  }
+  // Uses inside nested blocks are attributed to the top-level node owning
+  // them, which keeps the value alive for the whole If or Loop.
+  auto topLevelPosition = [&](Node * n) {
+    while (n->owningBlock() != graph.block()) {
+      n = n->owningBlock()->owningNode();
+    }
+    return position.at(n);
+  };
+
+  std::map<std::pair<at::ScalarType, int>, size_t> arena_index;
+  std::vector<LiveRange> ranges;
+  for (auto n : graph.nodes()) {
+    if (n->kind() != prim::FusionGroup)
+      continue;
+    for (auto output : n->outputs()) {
+      auto type = output->type()->cast<TensorType>();
+      if (!type || output->uses().empty())
+        continue;
+      bool plannable = true;
+      size_t end = position.at(n);
+      for (auto & use : output->uses()) {
+        // values escaping through a block's return (or the interpreter's
+        // Load of the graph outputs) outlive the run, so their memory can't
+        // be reused
+        if (use.user->kind() == prim::Return || use.user->kind() == prim::Load ||
+            !isNonAliasingUser(use.user)) {
+          plannable = false;
+          break;
+        }
+        end = std::max(end, topLevelPosition(use.user));
+      }
+      if (!plannable)
+        continue;
+      int64_t numel = 1;
+      for (auto s : type->sizes())
+        numel *= s;
+      if (numel == 0)
+        continue;
+      auto key = std::make_pair(type->scalarType(), type->device());
+      auto it = arena_index.find(key);
+      if (it == arena_index.end()) {
+        it = arena_index.emplace(key, plan.arenas.size()).first;
+        plan.arenas.push_back(MemoryPlan::Arena{key.first, key.second, 0});
+      }
+      ranges.push_back(LiveRange{output, position.at(n), end, it->second, numel, 0});
+    }
+  }
+
+  // Greedy first-fit: placing the largest values first keeps the arenas
+  // close to the peak amount of live memory.
+  std::stable_sort(ranges.begin(), ranges.end(), [](const LiveRange & a, const LiveRange & b) {
+    return a.numel > b.numel;
+  });
+  std::vector<const LiveRange*> placed;
+  for (auto & r : ranges) {
+    std::vector<const LiveRange*> conflicts;
+    for (auto p : placed) {
+      if (p->arena == r.arena && overlaps(*p, r))
+        conflicts.push_back(p);
+    }
+    std::sort(conflicts.begin(), conflicts.end(), [](const LiveRange * a, const LiveRange * b) {
+      return a->offset < b->offset;
+    });
+    int64_t offset = 0;
+    for (auto c : conflicts) {
+      if (offset + r.numel <= c->offset)
+        break;
+      offset = std::max(offset, alignUp(c->offset + c->numel));
+    }
+    r.offset = offset;
+    placed.push_back(&r);
+    auto & arena = plan.arenas[r.arena];
+    arena.numel = std::max(arena.numel, offset + r.numel);
+
+    // fusion kernels always produce contiguous outputs
+    auto type = r.value->type()->expect<TensorType>()->contiguous();
+    auto contiguous = type->expect<TensorType>();
+    plan.allocations.emplace(r.value, MemoryPlan::Allocation{r.arena, offset, contiguous->sizes(), contiguous->strides()});
+  }
+  return plan;
+}
+
+}}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+#include <ATen/ATen.h>
+#include <unordered_map>
+#include <vector>
+
+namespace torch { namespace jit {
+
+// Describes where the intermediate values of a graph that can be written to
+// preallocated memory (currently the outputs of FusionGroups) should live.
+// Values whose live ranges don't overlap share memory, and all the values of
+// the same scalar type and device are carved out of a single arena, so
+// running the graph needs one allocation per arena instead of one per value.
+struct MemoryPlan {
+  struct Arena {
+    at::ScalarType scalar_type;
+    int device;
+    int64_t numel;
+  };
+  struct Allocation {
+    size_t arena;
+    int64_t offset; // in elements
+    std::vector<int64_t> sizes;
+    std::vector<int64_t> strides;
+  };
+
+  std::vector<Arena> arenas;
+  std::unordered_map<Value*, Allocation> allocations;
+
+  bool empty() const {
+    return allocations.empty();
+  }
+};
+
+// Requires complete TensorTypes (e.g. after PropagateInputShapes). Values
+// without them are simply not planned.
+MemoryPlan PlanMemory(Graph& graph);
+
+}}
@@ -5,6 +5,7 @@
 
 #include <ATen/ExpandUtils.h>
 
+#include <algorithm>
 #include <iostream>
 
 namespace torch { namespace jit {
@@ -198,15 +199,28 @@ void PropagateShapeOnNode(Node * node) {
     case aten::sum: {
       if (check_overload(/*num_inputs=*/1, /*num_outputs=*/1,
                          {{AKind::i, attr::dim},
+                          {AKind::i, attr::keepdim}}) ||
+          check_overload(/*num_inputs=*/1, /*num_outputs=*/1,
+                         {{AKind::is, attr::dim},
                           {AKind::i, attr::keepdim}})) {
         auto tp = types.at(0);
         auto sizes = tp->sizes();
-        int64_t dim = node->i(attr::dim);
-        SHAPE_ASSERT(dim >= 0 && static_cast<size_t>(dim) < sizes.size());
-        if (node->i(attr::keepdim)) {
-          sizes.at(dim) = 1;
+        std::vector<int64_t> dims;
+        if (node->kindOf(attr::dim) == AKind::i) {
+          dims.push_back(node->i(attr::dim));
         } else {
-          sizes.erase(sizes.begin() + dim);
+          dims = node->is(attr::dim);
+        }
+        std::sort(dims.begin(), dims.end());
+        // erase from the back, so the remaining dims keep their position
+        for (auto it = dims.rbegin(); it != dims.rend(); ++it) {
+          int64_t dim = *it;
+          SHAPE_ASSERT(dim >= 0 && static_cast<size_t>(dim) < sizes.size());
+          if (node->i(attr::keepdim)) {
+            sizes.at(dim) = 1;
+          } else {
+            sizes.erase(sizes.begin() + dim);
+          }
         }
         node->output()->setType(tp->withSizes(sizes));
       } else if (check_overload(/*num_inputs=*/1, /*num_outputs=*/1)) {
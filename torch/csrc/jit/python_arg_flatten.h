@@ -5,6 +5,7 @@
 #include "torch/csrc/utils/hash.h"
 
 #include <ATen/ATen.h>
+#include <algorithm>
 #include <tuple>
 #include <vector>
 #include <functional>
@@ -49,6 +50,26 @@ struct IODescriptor {
       metadata.emplace_back(var);
   }
 
+  // The shape class of this descriptor. Like ArgumentSpec::symbolic, the
+  // sizes other than 0 and 1 are replaced by symbols (-1, -2, ...), numbered
+  // in order of first appearance so that equal sizes get the same symbol,
+  // and the sizes the symbols stand for are appended to symbol_sizes.
+  IODescriptor symbolic(std::vector<int64_t>& symbol_sizes) const {
+    IODescriptor desc = *this;
+    for (auto & meta : desc.metadata) {
+      for (auto & size : meta.sizes) {
+        if (size <= 1)
+          continue;
+        auto it = std::find(symbol_sizes.begin(), symbol_sizes.end(), size);
+        auto symbol = it - symbol_sizes.begin();
+        if (it == symbol_sizes.end())
+          symbol_sizes.push_back(size);
+        size = -1 - symbol;
+      }
+    }
+    return desc;
+  }
+
   // Description of argument structure. Variables are replaced with
   // different characters, depending on their flags, beginnings and
   // ends of tuples and lists are denoted by a pair of parenthesis
@@ -7,6 +7,7 @@
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/jit/tracer.h"
 #include "torch/csrc/jit/tracer_state.h"
+#include "torch/csrc/jit/graph_executor.h"
 #include "torch/csrc/jit/passes/dead_code_elimination.h"
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
 #include "torch/csrc/jit/passes/peephole.h"
@@ -51,12 +52,17 @@ py::object steal(py::handle x) {
 //   as the compiled trace.
 // - When we encounter an input configuration whose trace is compiled,
 //   we just directly run the compiled trace.
+// - Input configurations that only differ in sizes share a shape class (see
+//   IODescriptor::symbolic). Once the compiled traces of two configurations
+//   of a class match up to sizes, the other configurations of the class
+//   reuse the compiled trace without tracing the function again.
 struct CompiledFunction {
 
   struct TraceForKey {
-    TraceForKey(CompiledFunction& fn, bool grad_enabled)
+    TraceForKey(CompiledFunction& fn, IODescriptor desc)
       : fn_(fn)
-      , grad_enabled_(grad_enabled) {}
+      , desc_(std::move(desc))
+      , grad_enabled_(desc_.grad_enabled) {}
 
     bool ready() {
       if (is_ready_) return true;
@@ -93,9 +99,21 @@ struct CompiledFunction {
       factory_ = std::make_shared<InterpreterFunctionFactory>(complete_trace.get());
       graph_ = complete_trace->graph;
       is_ready_ = true;
+      fn_.addToShapeClass(*this);
       return true;
     }
 
+    // Makes this the same compiled trace as other, which has another
+    // configuration of the same shape class
+    void shareTrace(const TraceForKey& other) {
+      JIT_ASSERT(other.is_ready_);
+      traces_.clear();
+      out_desc_ = other.out_desc_;
+      factory_ = other.factory_;
+      graph_ = other.graph_;
+      is_ready_ = true;
+    }
+
     variable_list run(variable_list inputs) {
       JIT_ASSERT(is_ready_);
       AutoNoGIL _gil_guard;
@@ -146,6 +164,7 @@ struct CompiledFunction {
     }
 
     CompiledFunction& fn_;
+    IODescriptor desc_;
     IODescriptor out_desc_;
     std::vector<std::shared_ptr<TracingState>> traces_;
     bool grad_enabled_ = false;
@@ -158,13 +177,43 @@ struct CompiledFunction {
   TraceForKey& getTrace(ParsedArgs& args) {
     auto it = ktraces_.find(args.desc);
     if (it == ktraces_.end()) {
-      bool grad_enabled = args.desc.grad_enabled;
       std::tie(it, std::ignore) = ktraces_.emplace(args.desc,
-                                                   TraceForKey(*this, grad_enabled));
+                                                   TraceForKey(*this, args.desc));
+      std::vector<int64_t> symbol_sizes;
+      auto class_it = shape_classes_.find(args.desc.symbolic(symbol_sizes));
+      if (class_it != shape_classes_.end() && class_it->second.polymorphic) {
+        it->second.shareTrace(*class_it->second.first);
+      }
     }
     return it->second;
   }
 
+  // A shape class is polymorphic when the compiled traces of two of its
+  // configurations match up to sizes. These have to differ in every symbol,
+  // or a size baked into the trace could be the same in both by chance.
+  struct ShapeClass {
+    TraceForKey* first = nullptr;
+    std::vector<int64_t> symbol_sizes;
+    bool decided = false;
+    bool polymorphic = false;
+  };
+
+  void addToShapeClass(TraceForKey& trace) {
+    std::vector<int64_t> symbol_sizes;
+    auto & shape_class = shape_classes_[trace.desc_.symbolic(symbol_sizes)];
+    if (shape_class.decided) return;
+    if (!shape_class.first) {
+      shape_class.first = &trace;
+      shape_class.symbol_sizes = std::move(symbol_sizes);
+      return;
+    }
+    for (std::size_t i = 0; i < symbol_sizes.size(); ++i) {
+      if (symbol_sizes[i] == shape_class.symbol_sizes[i]) return;
+    }
+    shape_class.decided = true;
+    shape_class.polymorphic = matchGraphsUpToSizes(*shape_class.first->graph_, *trace.graph_);
+  }
+
   ParsedArgs flattenArgs(py::handle pyargs) {
     auto args = flatten(pyargs);
     // We need to take captured_var types into account when choosing the trace
@@ -203,6 +252,7 @@ struct CompiledFunction {
   }
 
   void clearCache() {
+    shape_classes_.clear();
     ktraces_.clear();
   }
 
@@ -227,6 +277,9 @@ struct CompiledFunction {
   std::string name_;
   variable_list captured_vars_;
   std::unordered_map<IODescriptor, TraceForKey, torch::hash<IODescriptor>> ktraces_;
+  // Keyed by the symbolic descriptors. The traces they point to are values
+  // of ktraces_, which never moves them.
+  std::unordered_map<IODescriptor, ShapeClass, torch::hash<IODescriptor>> shape_classes_;
 };
 
 
@@ -0,0 +1,212 @@
+#include "torch/csrc/jit/python_trace_cache.h"
+
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/jit/graph_executor.h"
+#include "torch/csrc/jit/python_arg_flatten.h"
+#include "torch/csrc/jit/serialization.h"
+#include "torch/csrc/jit/tracer.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace torch { namespace jit { namespace python {
+
+namespace {
+
+// Bumped when what a key stands for changes, so that the graphs saved
+// before are left alone
+constexpr int kTraceCacheVersion = 1;
+
+// FNV-1a, which unlike std::hash is the same in every process
+uint64_t stableHash(const std::string& s) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : s) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string keyString(const std::string& kind, const std::string& key,
+                      const IODescriptor& desc) {
+  std::ostringstream ss;
+  ss << "trace cache v" << kTraceCacheVersion << " " << kind << "\n"
+     << key << "\n" << desc;
+  return ss.str();
+}
+
+std::string cachePath(const std::string& directory, const std::string& key_string) {
+  char name[32];
+  snprintf(name, sizeof(name), "%016" PRIx64 ".pt", stableHash(key_string));
+  return directory + "/" + name;
+}
+
+// Whether graph takes inputs described by desc. The sizes are only checked
+// when they aren't symbols. This catches the files of another key with the
+// same hash, as long as they don't take the same inputs.
+bool takesInputs(Graph& graph, const IODescriptor& desc) {
+  if (graph.inputs().size() != desc.metadata.size())
+    return false;
+  for (size_t i = 0; i < desc.metadata.size(); ++i) {
+    auto& meta = desc.metadata[i];
+    auto type = graph.inputs()[i]->type()->cast<TensorType>();
+    if (!type || type->scalarType() != meta.type || type->device() != meta.device ||
+        type->sizes().size() != meta.sizes.size())
+      return false;
+    for (size_t d = 0; d < meta.sizes.size(); ++d) {
+      auto size = meta.sizes[d];
+      if (size >= 0 ? type->sizes()[d] != size : type->sizes()[d] <= 1)
+        return false;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<Graph> loadGraph(const std::string& directory,
+                                 const std::string& key_string,
+                                 const IODescriptor& desc) {
+  if (directory.empty())
+    return nullptr;
+  auto path = cachePath(directory, key_string);
+  if (!std::ifstream(path))
+    return nullptr;
+  try {
+    auto graph = LoadGraph(path).first;
+    return takesInputs(*graph, desc) ? graph : nullptr;
+  } catch (std::exception&) {
+    // e.g. a file written by an older version, which gets replaced
+    return nullptr;
+  }
+}
+
+void saveGraph(const std::string& directory, const std::string& key_string,
+               const std::shared_ptr<Graph>& graph) {
+  if (directory.empty())
+    return;
+  // Written to a temporary first, so that other processes never load a
+  // partial file
+  auto path = cachePath(directory, key_string);
+  auto tmp_path = path + ".tmp" + std::to_string(getpid());
+  try {
+    SaveGraph(tmp_path, graph);
+  } catch (std::exception&) {
+    std::remove(tmp_path.c_str());
+    return;
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+  }
+}
+
+// See createGraphByTracingCached. A class is decided when the graphs of two
+// of its instances that differ in every symbol were compared.
+struct ShapeClass {
+  std::shared_ptr<Graph> first;
+  std::vector<int64_t> symbol_sizes;
+  bool decided = false;
+  // set when decided and the graphs match
+  std::shared_ptr<Graph> graph;
+};
+
+struct TraceCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::shared_ptr<Graph>> graphs;
+  std::unordered_map<std::string, ShapeClass> classes;
+};
+
+TraceCache& traceCache() {
+  static TraceCache cache;
+  return cache;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<Graph> createGraphByTracingCached(
+    py::function func,
+    autograd::variable_list inputs,
+    size_t num_func_inputs,
+    const std::string& key,
+    const std::string& directory) {
+  IODescriptor desc;
+  desc.structure = std::string(inputs.size(), 'v');
+  desc.grad_enabled = autograd::GradMode::is_enabled();
+  desc.extend(inputs);
+  std::vector<int64_t> symbol_sizes;
+  auto symbolic = desc.symbolic(symbol_sizes);
+  auto instance_key = keyString("instance", key, desc);
+  auto class_key = keyString("class", key, symbolic);
+
+  auto& cache = traceCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.graphs.find(instance_key);
+    if (it != cache.graphs.end())
+      return it->second->copy();
+    auto class_it = cache.classes.find(class_key);
+    if (class_it != cache.classes.end() && class_it->second.graph) {
+      cache.graphs.emplace(instance_key, class_it->second.graph);
+      return class_it->second.graph->copy();
+    }
+  }
+  if (auto graph = loadGraph(directory, instance_key, desc)) {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.graphs.emplace(instance_key, graph);
+    return graph->copy();
+  }
+  if (auto graph = loadGraph(directory, class_key, symbolic)) {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto& shape_class = cache.classes[class_key];
+    shape_class.decided = true;
+    shape_class.graph = graph;
+    cache.graphs.emplace(instance_key, graph);
+    return graph->copy();
+  }
+
+  auto graph = tracer::createGraphByTracing(func, std::move(inputs), num_func_inputs);
+  auto cached = graph->copy();
+  bool polymorphic = false;
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.graphs[instance_key] = cached;
+    auto& shape_class = cache.classes[class_key];
+    if (!shape_class.first) {
+      shape_class.first = cached;
+      shape_class.symbol_sizes = symbol_sizes;
+    } else if (!shape_class.decided) {
+      bool all_differ = true;
+      for (size_t i = 0; i < symbol_sizes.size(); ++i) {
+        all_differ = all_differ && symbol_sizes[i] != shape_class.symbol_sizes[i];
+      }
+      if (all_differ) {
+        shape_class.decided = true;
+        polymorphic = matchGraphsUpToSizes(*shape_class.first, *cached);
+        if (polymorphic)
+          shape_class.graph = cached;
+      }
+    }
+  }
+  saveGraph(directory, instance_key, cached);
+  if (polymorphic)
+    saveGraph(directory, class_key, cached);
+  return graph;
+}
+
+void clearTraceCache() {
+  auto& cache = traceCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.graphs.clear();
+  cache.classes.clear();
+}
+
+}}} // namespace torch::jit::python
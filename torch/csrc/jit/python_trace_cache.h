@@ -0,0 +1,34 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/pybind.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <memory>
+#include <string>
+
+namespace torch { namespace jit { namespace python {
+
+// Like tracer::createGraphByTracing, but the graphs are cached under key,
+// which has to identify func (e.g. a fingerprint of its code), and the
+// descriptor of the inputs (see python_arg_flatten.h). A cached graph is
+// returned without calling func when:
+//
+// - func was traced with inputs of the same descriptor before, or
+// - the inputs are in a polymorphic shape class (see IODescriptor::symbolic):
+//   two of its instances that differ in every size symbol gave graphs that
+//   match up to sizes, which means that no traced op depends on the sizes.
+//
+// When directory isn't empty, the graphs are also saved there (see
+// SaveGraph), shared by all the processes using it. Graphs that can't be
+// saved, like the ones with Python ops, are only cached in memory.
+std::shared_ptr<Graph> createGraphByTracingCached(
+    py::function func,
+    autograd::variable_list inputs,
+    size_t num_func_inputs,
+    const std::string& key,
+    const std::string& directory);
+
+void clearTraceCache();
+
+}}} // namespace torch::jit::python
@@ -1,5 +1,7 @@
 #include "torch/csrc/jit/script/init.h"
 #include "torch/csrc/jit/script/compiler.h"
+#include "torch/csrc/jit/serialization.h"
+#include "torch/csrc/jit/python_trace_cache.h"
 
 namespace torch {
 namespace jit {
@@ -347,7 +349,9 @@ void initJitScriptBindings(PyObject* module) {
         Module& self,
         const std::string& name,
         py::function func,
-        tracer::variable_list inputs) {
+        tracer::variable_list inputs,
+        const std::string& cache_key,
+        const std::string& cache_dir) {
           size_t num_inputs = inputs.size();
           // prereq: Module's buffers and parameters are unique
           // this was ensured in python before calling this function
@@ -356,8 +360,20 @@ void initJitScriptBindings(PyObject* module) {
           for(at::Tensor* param : parameters) {
             inputs.push_back(static_cast<autograd::Variable&>(*param));
           }
-          auto graph = tracer::createGraphByTracing(func, std::move(inputs), num_inputs);
+          auto graph = cache_key.empty()
+              ? tracer::createGraphByTracing(func, std::move(inputs), num_inputs)
+              : ::torch::jit::python::createGraphByTracingCached(
+                    func, std::move(inputs), num_inputs, cache_key, cache_dir);
           self.create_method(name, std::move(graph), std::move(parameters));
+      }, py::arg("name"), py::arg("func"), py::arg("inputs"),
+         py::arg("cache_key") = "", py::arg("cache_dir") = "")
+      .def("_save", [](Module& self, const std::string& path) {
+        SaveModule(path, self);
+      })
+      .def("_load", [](Module& self, const std::string& path, py::function make_submodule) {
+        LoadModule(path, self, [&](Module& parent, const std::string& name) {
+          return py::cast<std::shared_ptr<Module>>(make_submodule(parent.shared_from_this(), name));
+        });
       });
 
   py::class_<Method>(m, "ScriptMethod")
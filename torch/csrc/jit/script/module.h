@@ -50,6 +50,13 @@ struct Method {
   const std::string & name() const {
     return name_;
   }
+  bool is_optimized() const {
+    return optimize;
+  }
+  // the parameter slots which are passed as the trailing inputs of graph()
+  const std::vector<at::Tensor*> & params() const {
+    return member_inputs;
+  }
   // emit a function call by inlining the callees Graph into this one
   // adding any extra parameters necessary to do this call
 
@@ -192,6 +199,9 @@ struct Module : public std::enable_shared_from_this<Module> {
   void set_optimized(bool o) {
     optimize = o;
   }
+  bool is_optimized() const {
+    return optimize;
+  }
 
   void register_parameter(const std::string & name, autograd::Variable v, bool is_buffer) {
     if(auto p = parameters.find(name)){
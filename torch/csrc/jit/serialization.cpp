@@ -0,0 +1,534 @@
+#include "torch/csrc/jit/serialization.h"
+
+#include "torch/csrc/autograd/variable.h"
+#include "torch/csrc/utils/auto_gpu.h"
+#include "torch/csrc/utils/tensor_archive.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace torch { namespace jit {
+
+namespace {
+
+// The IR record:
+//   uint32 version, uint8 kind (kGraphFile or kModuleFile)
+//   graph file:  graph, uint32 num_initializers, tensor refs
+//   module file: module, uint32 num_methods, methods
+//
+//   graph:   uint64 stage, block
+//   block:   uint32 num_inputs, values, uint32 num_nodes, nodes,
+//            uint32 num_outputs, value ids
+//   node:    string kind, uint64 stage, uint32 num_inputs, value ids,
+//            uint32 num_attributes, attributes, uint32 num_outputs, values,
+//            uint32 num_blocks, blocks
+//   value:   string name ("" for numbered values), type
+//   type:    uint8 TypeKind, for tensors: string scalar type, int32 device,
+//            uint32 dim, int64 sizes[dim], strides[dim]
+//   attribute: string name, uint8 AttributeKind, value
+//   tensor ref: int32 device, uint32 index of the record after the IR record
+//   module:  uint8 optimize, uint32 num_parameters, parameters,
+//            uint32 num_submodules, (string name, module)...
+//   parameter: string name, uint8 is_buffer, uint8 requires_grad, tensor ref
+//   method:  uint32 module, string name, uint8 optimize, graph,
+//            uint32 num_member_inputs, uint32 parameters[num_member_inputs]
+// Values are numbered in the order they are defined, separately in each
+// graph. Modules and parameters are numbered in the order they are saved,
+// which is depth first.
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint8_t kGraphFile = 0;
+constexpr uint8_t kModuleFile = 1;
+const char* kIRRecordName = "ir";
+
+std::runtime_error formatError(const std::string& what) {
+  return std::runtime_error("jit serialization: " + what);
+}
+
+at::ScalarType scalarTypeFromName(const std::string& name) {
+#define RETURN_IF_NAME(_1, n, _2) \
+  if (name == #n) return at::ScalarType::n;
+  AT_FORALL_SCALAR_TYPES(RETURN_IF_NAME)
+#undef RETURN_IF_NAME
+  throw formatError("unknown scalar type " + name);
+}
+
+// numbered values don't keep their number, they are renumbered when loaded
+bool hasExplicitName(const Value* v) {
+  return v->uniqueName() != std::to_string(v->unique());
+}
+
+struct Encoder {
+  template<typename T>
+  void write(T value) {
+    ir.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void writeString(const std::string& str) {
+    write<uint32_t>(str.size());
+    ir.append(str);
+  }
+
+  void writeTensor(const std::string& name, const at::Tensor& tensor) {
+    if (!tensor.defined()) {
+      throw formatError("cannot save the undefined tensor " + name);
+    }
+    at::Tensor data = autograd::is_variable(tensor) ? autograd::Variable(tensor).data() : tensor;
+    write<int32_t>(data.type().is_cuda() ? data.get_device() : -1);
+    write<uint32_t>(tensors.size());
+    tensors.emplace_back(name, data.toBackend(at::kCPU));
+  }
+
+  void writeType(const Type& type) {
+    write<uint8_t>(static_cast<uint8_t>(type.kind()));
+    if (auto tensor_type = type.cast<TensorType>()) {
+      writeString(at::toString(tensor_type->scalarType()));
+      write<int32_t>(tensor_type->device());
+      write<uint32_t>(tensor_type->sizes().size());
+      for (auto size : tensor_type->sizes()) write<int64_t>(size);
+      for (auto stride : tensor_type->strides()) write<int64_t>(stride);
+    }
+  }
+
+  void writeGraph(Graph& graph) {
+    std::unordered_map<const Value*, uint32_t> ids;
+    write<uint64_t>(graph.stage());
+    writeBlock(graph.block(), ids);
+  }
+
+  void writeValue(const Value* v, std::unordered_map<const Value*, uint32_t>& ids) {
+    uint32_t id = ids.size();
+    ids[v] = id;
+    writeString(hasExplicitName(v) ? v->uniqueName() : "");
+    writeType(*v->type());
+  }
+
+  void writeValueId(const Value* v, const std::unordered_map<const Value*, uint32_t>& ids) {
+    auto it = ids.find(v);
+    JIT_ASSERT(it != ids.end());
+    write<uint32_t>(it->second);
+  }
+
+  void writeBlock(Block* block, std::unordered_map<const Value*, uint32_t>& ids) {
+    write<uint32_t>(block->inputs().size());
+    for (auto input : block->inputs()) writeValue(input, ids);
+    uint32_t num_nodes = 0;
+    for (auto it = block->nodes().begin(); it != block->nodes().end(); ++it) num_nodes++;
+    write<uint32_t>(num_nodes);
+    for (auto node : block->nodes()) writeNode(node, ids);
+    write<uint32_t>(block->outputs().size());
+    for (auto output : block->outputs()) writeValueId(output, ids);
+  }
+
+  void writeNode(Node* n, std::unordered_map<const Value*, uint32_t>& ids) {
+    if (n->kind() == prim::PythonOp || n->kind() == prim::CppOp) {
+      throw formatError("cannot save " + std::string(n->kind().toDisplayString()) +
+                        " nodes, they hold Python or C++ objects");
+    }
+    writeString(n->kind().toQualString());
+    write<uint64_t>(n->stage());
+    write<uint32_t>(n->inputs().size());
+    for (auto input : n->inputs()) writeValueId(input, ids);
+    auto names = n->attributeNames();
+    write<uint32_t>(names.size());
+    for (auto name : names) writeAttribute(n, name);
+    write<uint32_t>(n->outputs().size());
+    for (auto output : n->outputs()) writeValue(output, ids);
+    write<uint32_t>(n->blocks().size());
+    for (auto block : n->blocks()) writeBlock(block, ids);
+  }
+
+  std::string constantName() {
+    return "constants." + std::to_string(tensors.size());
+  }
+
+  void writeAttribute(Node* n, Symbol name) {
+    writeString(name.toUnqualString());
+    auto kind = n->kindOf(name);
+    write<uint8_t>(static_cast<uint8_t>(kind));
+    switch (kind) {
+      case AttributeKind::f:
+        write<double>(n->f(name));
+        break;
+      case AttributeKind::fs:
+        write<uint32_t>(n->fs(name).size());
+        for (auto v : n->fs(name)) write<double>(v);
+        break;
+      case AttributeKind::i:
+        write<int64_t>(n->i(name));
+        break;
+      case AttributeKind::is:
+        write<uint32_t>(n->is(name).size());
+        for (auto v : n->is(name)) write<int64_t>(v);
+        break;
+      case AttributeKind::s:
+        writeString(n->s(name));
+        break;
+      case AttributeKind::ss:
+        write<uint32_t>(n->ss(name).size());
+        for (auto& v : n->ss(name)) writeString(v);
+        break;
+      case AttributeKind::t:
+        writeTensor(constantName(), n->t(name));
+        break;
+      case AttributeKind::ts:
+        write<uint32_t>(n->ts(name).size());
+        for (auto& v : n->ts(name)) writeTensor(constantName(), v);
+        break;
+      case AttributeKind::g:
+        writeGraph(*n->g(name));
+        break;
+      case AttributeKind::gs:
+        write<uint32_t>(n->gs(name).size());
+        for (auto& v : n->gs(name)) writeGraph(*v);
+        break;
+    }
+  }
+
+  // numbers the modules and parameter slots, which the methods refer to
+  void writeModule(const script::Module& module, const std::string& prefix,
+                   std::vector<const script::Module*>& modules,
+                   std::unordered_map<const at::Tensor*, uint32_t>& slots) {
+    modules.push_back(&module);
+    write<uint8_t>(module.is_optimized());
+    write<uint32_t>(module.get_parameters().size());
+    for (auto& param : module.get_parameters()) {
+      uint32_t slot = slots.size();
+      slots[param.slot()] = slot;
+      writeString(param.name);
+      write<uint8_t>(param.is_buffer);
+      write<uint8_t>(autograd::Variable(*param.slot()).requires_grad());
+      writeTensor(prefix + param.name, *param.slot());
+    }
+    write<uint32_t>(module.get_modules().size());
+    for (auto& sub : module.get_modules()) {
+      writeString(sub.name);
+      writeModule(*sub.module, prefix + sub.name + ".", modules, slots);
+    }
+  }
+
+  void save(const std::string& path) {
+    utils::NamedTensors records;
+    records.reserve(tensors.size() + 1);
+    auto& type = at::CPU(at::kByte);
+    records.emplace_back(kIRRecordName, type.tensorFromBlob(&ir[0], {static_cast<int64_t>(ir.size())}));
+    records.insert(records.end(), tensors.begin(), tensors.end());
+    utils::save_tensor_archive(path, records);
+  }
+
+  std::string ir;
+  utils::NamedTensors tensors;
+};
+
+struct Decoder {
+  explicit Decoder(const std::string& path)
+  : tensors(utils::load_tensor_archive(path, /*mmap=*/true)) {
+    if (tensors.empty() || tensors[0].first != kIRRecordName ||
+        tensors[0].second.type().scalarType() != at::kByte ||
+        tensors[0].second.dim() != 1) {
+      throw formatError(path + " doesn't hold a graph or a module");
+    }
+    ir = tensors[0].second;
+    data = static_cast<const char*>(ir.data_ptr());
+    size = ir.numel();
+    pos = 0;
+  }
+
+  void need(std::size_t n) {
+    if (n > size - pos) {
+      throw formatError("truncated IR");
+    }
+  }
+
+  template<typename T>
+  T read() {
+    need(sizeof(T));
+    T value;
+    std::memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+
+  std::string readString() {
+    auto length = read<uint32_t>();
+    need(length);
+    std::string str(data + pos, length);
+    pos += length;
+    return str;
+  }
+
+  void readHeader(uint8_t expected_kind) {
+    auto version = read<uint32_t>();
+    if (version != kFormatVersion) {
+      throw formatError("unsupported version " + std::to_string(version));
+    }
+    auto kind = read<uint8_t>();
+    if (kind != expected_kind) {
+      throw formatError(expected_kind == kGraphFile ? "expected a graph, found a module"
+                                                    : "expected a module, found a graph");
+    }
+  }
+
+  at::Tensor readTensor() {
+    auto device = read<int32_t>();
+    auto index = read<uint32_t>();
+    if (index + 1 >= tensors.size()) {
+      throw formatError("invalid tensor " + std::to_string(index));
+    }
+    at::Tensor tensor = tensors[index + 1].second;
+    if (device >= 0) {
+      AutoGPU guard(device);
+      tensor = tensor.toBackend(at::kCUDA);
+    }
+    return tensor;
+  }
+
+  TypePtr readType() {
+    auto kind = static_cast<TypeKind>(read<uint8_t>());
+    switch (kind) {
+      case TypeKind::DynamicType:
+        return DynamicType::get();
+      case TypeKind::HandleType:
+        return HandleType::get();
+      case TypeKind::TensorType: {
+        auto scalar_type = scalarTypeFromName(readString());
+        auto device = read<int32_t>();
+        auto dim = read<uint32_t>();
+        std::vector<int64_t> sizes(dim), strides(dim);
+        for (auto& size : sizes) size = read<int64_t>();
+        for (auto& stride : strides) stride = read<int64_t>();
+        return std::make_shared<TensorType>(scalar_type, device, sizes, strides);
+      }
+    }
+    throw formatError("unknown type kind " + std::to_string(static_cast<int>(kind)));
+  }
+
+  std::shared_ptr<Graph> readGraph() {
+    auto graph = std::make_shared<Graph>();
+    auto stage = read<uint64_t>();
+    std::vector<Value*> values;
+    readBlock(graph->block(), values);
+    graph->setStage(stage);
+    return graph;
+  }
+
+  void readValue(Value* v, std::vector<Value*>& values) {
+    auto name = readString();
+    if (!name.empty()) v->setUniqueName(name);
+    v->setType(readType());
+    values.push_back(v);
+  }
+
+  Value* readValueId(const std::vector<Value*>& values) {
+    auto id = read<uint32_t>();
+    if (id >= values.size()) {
+      throw formatError("use of the undefined value " + std::to_string(id));
+    }
+    return values[id];
+  }
+
+  void readBlock(Block* block, std::vector<Value*>& values) {
+    auto num_inputs = read<uint32_t>();
+    for (uint32_t i = 0; i < num_inputs; i++) readValue(block->addInput(), values);
+    auto num_nodes = read<uint32_t>();
+    for (uint32_t i = 0; i < num_nodes; i++) readNode(block, values);
+    auto num_outputs = read<uint32_t>();
+    for (uint32_t i = 0; i < num_outputs; i++) block->registerOutput(readValueId(values));
+  }
+
+  void readNode(Block* block, std::vector<Value*>& values) {
+    auto kind = Symbol::fromQualString(readString());
+    Node* n = block->appendNode(block->owningGraph()->create(kind, 0));
+    n->setStage(read<uint64_t>());
+    auto num_inputs = read<uint32_t>();
+    for (uint32_t i = 0; i < num_inputs; i++) n->addInput(readValueId(values));
+    auto num_attributes = read<uint32_t>();
+    for (uint32_t i = 0; i < num_attributes; i++) readAttribute(n);
+    auto num_outputs = read<uint32_t>();
+    for (uint32_t i = 0; i < num_outputs; i++) readValue(n->addOutput(), values);
+    auto num_blocks = read<uint32_t>();
+    for (uint32_t i = 0; i < num_blocks; i++) readBlock(n->addBlock(), values);
+  }
+
+  template<typename T, typename F>
+  std::vector<T> readList(F read_one) {
+    std::vector<T> list(read<uint32_t>());
+    for (auto& v : list) v = read_one();
+    return list;
+  }
+
+  void readAttribute(Node* n) {
+    auto name = Symbol::attr(readString());
+    auto kind = read<uint8_t>();
+    switch (static_cast<AttributeKind>(kind)) {
+      case AttributeKind::f:
+        n->f_(name, read<double>());
+        break;
+      case AttributeKind::fs:
+        n->fs_(name, readList<double>([&] { return read<double>(); }));
+        break;
+      case AttributeKind::i:
+        n->i_(name, read<int64_t>());
+        break;
+      case AttributeKind::is:
+        n->is_(name, readList<int64_t>([&] { return read<int64_t>(); }));
+        break;
+      case AttributeKind::s:
+        n->s_(name, readString());
+        break;
+      case AttributeKind::ss:
+        n->ss_(name, readList<std::string>([&] { return readString(); }));
+        break;
+      case AttributeKind::t:
+        n->t_(name, readTensor());
+        break;
+      case AttributeKind::ts:
+        n->ts_(name, readList<at::Tensor>([&] { return readTensor(); }));
+        break;
+      case AttributeKind::g:
+        n->g_(name, readGraph());
+        break;
+      case AttributeKind::gs:
+        n->gs_(name, readList<std::shared_ptr<Graph>>([&] { return readGraph(); }));
+        break;
+      default:
+        throw formatError("unknown attribute kind " + std::to_string(kind));
+    }
+  }
+
+  void readModule(script::Module& module, const SubmoduleFactory& make_submodule,
+                  std::vector<script::Module*>& modules, std::vector<at::Tensor*>& slots) {
+    modules.push_back(&module);
+    module.set_optimized(read<uint8_t>());
+    auto num_parameters = read<uint32_t>();
+    for (uint32_t i = 0; i < num_parameters; i++) {
+      auto name = readString();
+      bool is_buffer = read<uint8_t>();
+      bool requires_grad = read<uint8_t>();
+      module.register_parameter(name, autograd::make_variable(readTensor(), requires_grad), is_buffer);
+      slots.push_back(module.parameter_slot(name));
+    }
+    auto num_submodules = read<uint32_t>();
+    for (uint32_t i = 0; i < num_submodules; i++) {
+      auto name = readString();
+      std::shared_ptr<script::Module> submodule;
+      if (make_submodule) {
+        submodule = make_submodule(module, name);
+      } else {
+        submodule = std::make_shared<script::Module>();
+        module.register_module(name, submodule);
+      }
+      readModule(*submodule, make_submodule, modules, slots);
+    }
+  }
+
+  utils::NamedTensors tensors;
+  at::Tensor ir;
+  const char* data;
+  std::size_t size;
+  std::size_t pos;
+};
+
+} // anonymous namespace
+
+void SaveGraph(const std::string& path,
+               const std::shared_ptr<Graph>& graph,
+               const std::vector<at::Tensor>& initializers) {
+  if (initializers.size() > graph->inputs().size()) {
+    throw formatError("more initializers than graph inputs");
+  }
+  Encoder encoder;
+  encoder.write<uint32_t>(kFormatVersion);
+  encoder.write<uint8_t>(kGraphFile);
+  encoder.writeGraph(*graph);
+  encoder.write<uint32_t>(initializers.size());
+  for (size_t i = 0; i < initializers.size(); i++) {
+    encoder.writeTensor("initializers." + std::to_string(i), initializers[i]);
+  }
+  encoder.save(path);
+}
+
+std::pair<std::shared_ptr<Graph>, std::vector<at::Tensor>> LoadGraph(const std::string& path) {
+  Decoder decoder(path);
+  decoder.readHeader(kGraphFile);
+  auto graph = decoder.readGraph();
+  auto initializers = decoder.readList<at::Tensor>([&] { return decoder.readTensor(); });
+  return std::make_pair(std::move(graph), std::move(initializers));
+}
+
+void SaveModule(const std::string& path, const script::Module& module) {
+  Encoder encoder;
+  encoder.write<uint32_t>(kFormatVersion);
+  encoder.write<uint8_t>(kModuleFile);
+  std::vector<const script::Module*> modules;
+  std::unordered_map<const at::Tensor*, uint32_t> slots;
+  encoder.writeModule(module, "", modules, slots);
+
+  uint32_t num_methods = 0;
+  for (auto m : modules) num_methods += m->get_methods().size();
+  encoder.write<uint32_t>(num_methods);
+  for (uint32_t i = 0; i < modules.size(); i++) {
+    for (auto& method : modules[i]->get_methods()) {
+      encoder.write<uint32_t>(i);
+      encoder.writeString(method->name());
+      encoder.write<uint8_t>(method->is_optimized());
+      encoder.writeGraph(*method->graph());
+      encoder.write<uint32_t>(method->params().size());
+      for (auto slot : method->params()) {
+        auto it = slots.find(slot);
+        if (it == slots.end()) {
+          throw formatError("method " + method->name() + " uses a parameter of a "
+                            "module which isn't a submodule of the saved one");
+        }
+        encoder.write<uint32_t>(it->second);
+      }
+    }
+  }
+  encoder.save(path);
+}
+
+void LoadModule(const std::string& path, script::Module& module,
+                const SubmoduleFactory& make_submodule) {
+  Decoder decoder(path);
+  decoder.readHeader(kModuleFile);
+  std::vector<script::Module*> modules;
+  std::vector<at::Tensor*> slots;
+  decoder.readModule(module, make_submodule, modules, slots);
+
+  // the methods are created once all the parameters they may use exist
+  auto num_methods = decoder.read<uint32_t>();
+  for (uint32_t i = 0; i < num_methods; i++) {
+    auto index = decoder.read<uint32_t>();
+    if (index >= modules.size()) {
+      throw formatError("invalid module " + std::to_string(index));
+    }
+    auto name = decoder.readString();
+    bool optimize = decoder.read<uint8_t>();
+    auto graph = decoder.readGraph();
+    auto member_inputs = decoder.readList<at::Tensor*>([&] {
+      auto slot = decoder.read<uint32_t>();
+      if (slot >= slots.size()) {
+        throw formatError("invalid parameter " + std::to_string(slot));
+      }
+      return slots[slot];
+    });
+    if (member_inputs.size() > graph->inputs().size()) {
+      throw formatError("method " + name + " has more parameters than inputs");
+    }
+    // Module::create_method gives the method the current flag of the module
+    auto& owner = *modules[index];
+    bool module_optimize = owner.is_optimized();
+    owner.set_optimized(optimize);
+    owner.create_method(name, std::move(graph), std::move(member_inputs));
+    owner.set_optimized(module_optimize);
+  }
+}
+
+std::shared_ptr<script::Module> LoadModule(const std::string& path) {
+  auto module = std::make_shared<script::Module>();
+  LoadModule(path, *module);
+  return module;
+}
+
+}}
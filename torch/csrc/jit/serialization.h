@@ -0,0 +1,48 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/script/module.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace torch { namespace jit {
+
+// A native file format for graphs and script modules, which can be written
+// and read without Python or protobuf.
+//
+// The file is a tensor archive (see torch/csrc/utils/tensor_archive.h): the
+// IR is stored in a compact binary form as its first record, a byte tensor,
+// and every tensor the IR refers to (tensor attributes, initializers and
+// module parameters) is one of the following records, as raw data aligned
+// on 64 bytes. Loading maps the file, decodes the IR and makes the tensors
+// views of the mapping, so it costs little more than the page-ins of the
+// weights that are actually used. CUDA tensors are saved from the CPU and
+// moved back to their device when loaded.
+//
+// Nodes that hold Python or C++ objects (PythonOp and CppOp) can't be saved.
+
+// Saves graph and initializers, the values of its trailing inputs.
+void SaveGraph(const std::string& path,
+               const std::shared_ptr<Graph>& graph,
+               const std::vector<at::Tensor>& initializers = {});
+
+std::pair<std::shared_ptr<Graph>, std::vector<at::Tensor>> LoadGraph(const std::string& path);
+
+// Saves the parameters, submodules and methods of module.
+void SaveModule(const std::string& path, const script::Module& module);
+
+// Creates the submodule `name` of `parent` while a module is loaded into it.
+using SubmoduleFactory = std::function<std::shared_ptr<script::Module>(script::Module& parent, const std::string& name)>;
+
+// Loads a module saved by SaveModule into module, which should be empty.
+// Submodules are created by make_submodule, which by default registers a new
+// script::Module.
+void LoadModule(const std::string& path, script::Module& module,
+                const SubmoduleFactory& make_submodule = nullptr);
+
+std::shared_ptr<script::Module> LoadModule(const std::string& path);
+
+}}
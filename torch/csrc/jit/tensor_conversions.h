@@ -39,7 +39,8 @@ struct tensor_as_impl<at::IntList> {
   at::IntList operator()(at::Tensor&& t) {
     if (t.type().scalarType() != at::ScalarType::Long)
       throw std::runtime_error("Expected a LongTensor");
-    if (t.dim() != 1)
+    // a 0-dim tensor is accepted as a list of one element
+    if (t.dim() > 1)
       throw std::runtime_error("Expected a 1D LongTensor");
     if (!t.is_contiguous())
       throw std::runtime_error("Expected a contiguous LongTensor");
@@ -24,6 +24,7 @@
 #include "torch/csrc/jit/argument_spec.h"
 #include "torch/csrc/jit/passes/shape_analysis.h"
 #include "torch/csrc/jit/passes/dead_code_elimination.h"
+#include "torch/csrc/jit/passes/memory_planning.h"
 
 #include "torch/csrc/assertions.h"
 
@@ -236,6 +237,40 @@ static void fusionTests() {
   testConcat(0);
   testConcat(1);
   testConcat(2);
+
+  auto testCacheIgnoresSizes = [&] {
+    FusionCompiler cache_comp;
+    auto compile = [&](std::vector<int64_t> sizes) {
+      Graph graph;
+      Var i0 = Var::asNewInput(graph);
+      Var i1 = Var::asNewInput(graph);
+      auto o0 = i0 * i1;
+      o0.addAsOutput();
+      auto a = at::rand(at::CUDA(at::kFloat), sizes);
+      auto o = at::zeros(at::CUDA(at::kFloat), sizes);
+      i0.value()->inferTypeFrom(a);
+      i1.value()->inferTypeFrom(a);
+      o0.value()->inferTypeFrom(o);
+      auto fn = cache_comp.getOrCompile(graph, 0, {a,a}, {o});
+      fn->launch_with_tensors({a,a}, {o});
+      float max_diff = (a*a - o).abs().max().toCDouble();
+      REQUIRE(max_diff == 0);
+      return fn;
+    };
+    auto fn = compile({3,4});
+    REQUIRE(compile({7,4}) == fn);
+    REQUIRE(compile({128,33}) == fn);
+    REQUIRE(cache_comp.cacheSize() == 1);
+    // a different rank needs a different kernel
+    REQUIRE(compile({3,4,5}) != fn);
+    REQUIRE(cache_comp.cacheSize() == 2);
+
+    cache_comp.setCacheSize(1);
+    REQUIRE(cache_comp.cacheSize() == 1);
+    REQUIRE(compile({3,4}) != fn); // evicted, has to be recompiled
+    REQUIRE(cache_comp.cacheSize() == 1);
+  };
+  testCacheIgnoresSizes();
 }
 
 struct Attr : public Attributes<Attr> {
@@ -746,6 +781,12 @@ void argumentSpecTest() {
   ArgumentSpec no_grad(/*with_grad=*/false, list);
   REQUIRE(no_grad != a);
 
+  REQUIRE(a.matches(true, list));
+  REQUIRE(a.matches(true, list2));
+  REQUIRE(!a.matches(false, list));
+  REQUIRE(no_grad.matches(false, list));
+  REQUIRE(!a.matches(true, createVarList({ var(CF, {1}, true) })));
+
   std::unordered_set<ArgumentSpec> spec;
   spec.insert(std::move(a));
   REQUIRE(spec.count(b) > 0);
@@ -757,7 +798,26 @@ void argumentSpecTest() {
   ArgumentSpec c(true, list2); // same as list, except for one stride
   REQUIRE(!(c == a));
   REQUIRE(spec.count(c) == 0);
-
+  REQUIRE(!b.matches(true, list2));
+
+  // symbolic signatures only depend on which sizes are equal, 0 or 1
+  auto sym_list = createVarList({ var(CF, {8, 4}, false), var(CF, {4}, false), var(CF, {8, 1}, false) });
+  auto sym_list2 = createVarList({ var(CF, {3, 2}, false), var(CF, {2}, false), var(CF, {3, 1}, false) });
+  auto sym_list3 = createVarList({ var(CF, {4, 4}, false), var(CF, {4}, false), var(CF, {4, 1}, false) });
+  std::vector<int64_t> sym_sizes, sym_sizes2, sym_sizes3;
+  auto sym = ArgumentSpec(false, sym_list).symbolic(sym_sizes);
+  auto sym2 = ArgumentSpec(false, sym_list2).symbolic(sym_sizes2);
+  auto sym3 = ArgumentSpec(false, sym_list3).symbolic(sym_sizes3);
+  REQUIRE(sym && sym2 && sym3);
+  REQUIRE(*sym == *sym2);
+  REQUIRE(sym->hashCode() == sym2->hashCode());
+  REQUIRE(*sym != *sym3);
+  REQUIRE((sym_sizes == std::vector<int64_t>{8, 4}));
+  REQUIRE(sym->instantiate(sym_sizes) == ArgumentSpec(false, sym_list));
+  REQUIRE(sym->instantiate(sym_sizes2) == ArgumentSpec(false, sym_list2));
+  // non-contiguous tensors have no symbolic signature
+  std::vector<int64_t> unused;
+  REQUIRE(!ArgumentSpec(true, list).symbolic(unused));
 }
 
 void shapeAnalysisTest() {
@@ -884,6 +944,38 @@ void testControlFlow() {
   REQUIRE(256 == run_binary("while_test",2,0));
 }
 
+void testMemoryPlanning() {
+  // x -> a -> b -> c -> d, where each arrow is a FusionGroup
+  Graph graph;
+  auto t = at::rand(at::CPU(at::kFloat), {4, 4});
+  auto x = graph.addInput();
+  x->inferTypeFrom(t);
+  std::vector<Value*> values;
+  Value * last = x;
+  for (int i = 0; i < 4; ++i) {
+    auto n = graph.appendNode(graph.create(prim::FusionGroup, {last}));
+    last = n->output();
+    last->inferTypeFrom(t);
+    values.push_back(last);
+  }
+  graph.registerOutput(last);
+
+  auto plan = PlanMemory(graph);
+  REQUIRE(plan.arenas.size() == 1);
+  REQUIRE(plan.allocations.size() == 3); // d is a graph output
+  REQUIRE(plan.allocations.count(values[3]) == 0);
+  auto & a = plan.allocations.at(values[0]);
+  auto & b = plan.allocations.at(values[1]);
+  auto & c = plan.allocations.at(values[2]);
+  // b is live together with a and c, but a and c can share memory
+  REQUIRE(a.offset != b.offset);
+  REQUIRE(c.offset != b.offset);
+  REQUIRE(a.offset == c.offset);
+  REQUIRE(plan.arenas[0].numel == 32);
+  REQUIRE(a.sizes == std::vector<int64_t>({4, 4}));
+  REQUIRE(a.strides == std::vector<int64_t>({4, 1}));
+}
+
 #ifdef NO_PYTHON
 
 TEST_CASE( "jit test CPU", "[cpu]" ) {
@@ -891,6 +983,8 @@ TEST_CASE( "jit test CPU", "[cpu]" ) {
   std::stringstream out;
   SECTION( "control flow" )
     testControlFlow();
+  SECTION( "memory planning" )
+    testMemoryPlanning();
   SECTION( "blocks" )
     testBlocks(out);
   SECTION( "create autodiff subgraphs" )
@@ -930,6 +1024,7 @@ TEST_CASE( "jit test CUDA", "[cuda]" ) {
 std::string runJITCPPTests() {
   std::stringstream out;
   testControlFlow();
+  testMemoryPlanning();
   testGraphExecutor();
   testBlocks(out);
   testCreateAutodiffSubgraphs(out);
@@ -369,6 +369,12 @@ bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
     return false;
   }
 
+  // Every required parameter needs an argument of its own, so overloads
+  // with too many of them can be skipped without checking any types
+  if (!raise_exception && nargs + remaining_kwargs < min_args) {
+    return false;
+  }
+
   int i = 0;
   for (auto& param : params) {
     PyObject* obj = nullptr;
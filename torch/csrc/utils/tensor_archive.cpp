@@ -0,0 +1,289 @@
+#include "torch/csrc/utils/tensor_archive.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace torch { namespace utils {
+
+namespace {
+
+// Format:
+//   char     magic[8]           "PTARCHV1"
+//   uint64   num_tensors
+//   uint64   data_offset        start of the payloads
+//   entries, each:
+//     uint32 name_length, name
+//     uint32 type_length, name of the scalar type, e.g. "Float"
+//     uint32 dim
+//     int64  sizes[dim], strides[dim]   in elements
+//     uint64 offset, nbytes             of the payload, from the start of the file
+const char kMagic[8] = {'P', 'T', 'A', 'R', 'C', 'H', 'V', '1'};
+
+std::size_t align(std::size_t offset) {
+  return (offset + kTensorArchiveAlignment - 1) / kTensorArchiveAlignment * kTensorArchiveAlignment;
+}
+
+at::ScalarType scalar_type_from_name(const std::string& name) {
+#define RETURN_IF_NAME(_1, n, _2) \
+  if (name == #n) return at::ScalarType::n;
+  AT_FORALL_SCALAR_TYPES(RETURN_IF_NAME)
+#undef RETURN_IF_NAME
+  throw std::runtime_error("tensor archive: unknown scalar type " + name);
+}
+
+template<typename T>
+void append(std::string& buffer, T value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void append_string(std::string& buffer, const std::string& str) {
+  append<uint32_t>(buffer, str.size());
+  buffer.append(str);
+}
+
+struct Reader {
+  const char* data;
+  std::size_t size;
+  std::size_t pos;
+
+  void need(std::size_t n) {
+    if (n > size - pos) {
+      throw std::runtime_error("tensor archive: truncated header");
+    }
+  }
+
+  template<typename T>
+  T read() {
+    need(sizeof(T));
+    T value;
+    std::memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+  }
+
+  std::string read_string() {
+    auto length = read<uint32_t>();
+    need(length);
+    std::string str(data + pos, length);
+    pos += length;
+    return str;
+  }
+};
+
+#ifndef _WIN32
+std::system_error io_error(const std::string& what, const std::string& path) {
+  return std::system_error(errno, std::system_category(), "tensor archive: " + what + " " + path);
+}
+
+// Unmapped when the last tensor viewing it is freed
+struct Mapping {
+  Mapping(void* data, std::size_t size) : data(data), size(size) {}
+  ~Mapping() { munmap(data, size); }
+
+  void* data;
+  std::size_t size;
+};
+
+void write_all(int fd, std::vector<struct iovec>& iovs, const std::string& path) {
+  std::size_t i = 0;
+  while (i < iovs.size()) {
+    int count = static_cast<int>(std::min<std::size_t>(iovs.size() - i, IOV_MAX));
+    ssize_t written = ::writev(fd, &iovs[i], count);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      throw io_error("cannot write", path);
+    }
+    // skip what was written, which may end in the middle of a buffer
+    std::size_t left = written;
+    while (i < iovs.size() && left >= iovs[i].iov_len) {
+      left -= iovs[i].iov_len;
+      i++;
+    }
+    if (left > 0) {
+      iovs[i].iov_base = static_cast<char*>(iovs[i].iov_base) + left;
+      iovs[i].iov_len -= left;
+    }
+  }
+}
+#endif
+
+} // anonymous namespace
+
+#ifndef _WIN32
+
+void save_tensor_archive(const std::string& path, const NamedTensors& tensors) {
+  std::vector<at::Tensor> payloads;
+  payloads.reserve(tensors.size());
+  for (auto& named : tensors) {
+    auto& tensor = named.second;
+    if (!tensor.defined() || tensor.type().is_cuda() || tensor.type().is_sparse()) {
+      throw std::runtime_error("tensor archive: " + named.first + " should be a "
+                               "dense CPU tensor");
+    }
+    payloads.push_back(tensor.contiguous());
+  }
+
+  // the size of the header doesn't depend on the offsets, so it is built once
+  // with them left at 0
+  std::string header(kMagic, sizeof(kMagic));
+  append<uint64_t>(header, tensors.size());
+  std::size_t data_offset_pos = header.size();
+  append<uint64_t>(header, 0);
+  std::vector<std::size_t> offset_pos;
+  offset_pos.reserve(tensors.size());
+  for (std::size_t i = 0; i < tensors.size(); i++) {
+    auto& payload = payloads[i];
+    append_string(header, tensors[i].first);
+    append_string(header, at::toString(payload.type().scalarType()));
+    append<uint32_t>(header, payload.dim());
+    for (auto size : payload.sizes()) append<int64_t>(header, size);
+    for (auto stride : payload.strides()) append<int64_t>(header, stride);
+    offset_pos.push_back(header.size());
+    append<uint64_t>(header, 0);
+    append<uint64_t>(header, payload.numel() * payload.type().elementSizeInBytes());
+  }
+
+  static const char padding[kTensorArchiveAlignment] = {0};
+  std::vector<struct iovec> iovs;
+  iovs.reserve(2 * tensors.size() + 2);
+  iovs.push_back({nullptr, header.size()});
+  std::size_t offset = header.size();
+  auto pad = [&]() {
+    std::size_t aligned = align(offset);
+    if (aligned > offset) {
+      iovs.push_back({const_cast<char*>(padding), aligned - offset});
+      offset = aligned;
+    }
+  };
+  pad();
+  uint64_t data_offset = offset;
+  std::memcpy(&header[data_offset_pos], &data_offset, sizeof(data_offset));
+  for (std::size_t i = 0; i < payloads.size(); i++) {
+    uint64_t payload_offset = offset;
+    std::memcpy(&header[offset_pos[i]], &payload_offset, sizeof(payload_offset));
+    std::size_t nbytes = payloads[i].numel() * payloads[i].type().elementSizeInBytes();
+    if (nbytes == 0) continue;
+    iovs.push_back({payloads[i].data_ptr(), nbytes});
+    offset += nbytes;
+    pad();
+  }
+  iovs[0].iov_base = &header[0];
+
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw io_error("cannot open", path);
+  }
+  try {
+    write_all(fd, iovs, path);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  if (::close(fd) != 0) {
+    throw io_error("cannot close", path);
+  }
+}
+
+NamedTensors load_tensor_archive(const std::string& path, bool mmap) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw io_error("cannot open", path);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw io_error("cannot stat", path);
+  }
+  std::size_t file_size = st.st_size;
+  if (file_size < sizeof(kMagic)) {
+    ::close(fd);
+    throw std::runtime_error("tensor archive: " + path + " is not a tensor archive");
+  }
+  // private and writable, so that the tensors can be modified in memory
+  void* data = ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw io_error("cannot map", path);
+  }
+  auto mapping = std::make_shared<Mapping>(data, file_size);
+  char* base = static_cast<char*>(data);
+
+  if (std::memcmp(base, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("tensor archive: " + path + " is not a tensor archive");
+  }
+  Reader reader{base, file_size, sizeof(kMagic)};
+  auto num_tensors = reader.read<uint64_t>();
+  reader.read<uint64_t>();  // data_offset
+
+  NamedTensors result;
+  for (uint64_t i = 0; i < num_tensors; i++) {
+    auto name = reader.read_string();
+    auto scalar_type = scalar_type_from_name(reader.read_string());
+    auto dim = reader.read<uint32_t>();
+    std::vector<int64_t> sizes(dim), strides(dim);
+    for (auto& size : sizes) size = reader.read<int64_t>();
+    for (auto& stride : strides) stride = reader.read<int64_t>();
+    auto offset = reader.read<uint64_t>();
+    auto nbytes = reader.read<uint64_t>();
+
+    auto& type = at::CPU(scalar_type);
+    std::size_t element_size = type.elementSizeInBytes();
+    // the payload should hold every element the strides can reach
+    uint64_t extent = 1;
+    // tensors without elements may have no dimension either
+    bool empty = dim == 0 && nbytes == 0;
+    for (uint32_t d = 0; d < dim; d++) {
+      if (sizes[d] == 0) empty = true;
+      if (sizes[d] < 0 || strides[d] < 0) {
+        throw std::runtime_error("tensor archive: invalid sizes of " + name);
+      }
+      extent += (sizes[d] - 1) * strides[d];
+    }
+    if (empty) extent = 0;
+    if (offset > file_size || nbytes > file_size - offset ||
+        extent * element_size > nbytes || offset % element_size != 0) {
+      throw std::runtime_error("tensor archive: invalid payload of " + name);
+    }
+
+    at::Tensor tensor;
+    if (empty) {
+      tensor = type.tensor(sizes);
+    } else {
+      tensor = type.tensorFromBlob(base + offset, sizes, strides,
+                                   [mapping](void*) {});
+      if (!mmap) {
+        tensor = tensor.clone();
+      }
+    }
+    result.emplace_back(std::move(name), std::move(tensor));
+  }
+  return result;
+}
+
+#else
+
+void save_tensor_archive(const std::string& path, const NamedTensors& tensors) {
+  throw std::runtime_error("tensor archives aren't supported on Windows");
+}
+
+NamedTensors load_tensor_archive(const std::string& path, bool mmap) {
+  throw std::runtime_error("tensor archives aren't supported on Windows");
+}
+
+#endif
+
+}}
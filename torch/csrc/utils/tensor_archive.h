@@ -0,0 +1,28 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace torch { namespace utils {
+
+// A flat file of named CPU tensors, which doesn't need Python to be written
+// or read. It has a header table of the name, scalar type, sizes, strides
+// and payload offset of every tensor, followed by the payloads, each
+// aligned on kTensorArchiveAlignment bytes. Numbers are stored in the byte
+// order of the machine.
+constexpr std::size_t kTensorArchiveAlignment = 64;
+
+using NamedTensors = std::vector<std::pair<std::string, at::Tensor>>;
+
+// Writes the tensors with writev, up to IOV_MAX buffers per call. Tensors
+// which aren't contiguous are saved as contiguous copies.
+void save_tensor_archive(const std::string& path, const NamedTensors& tensors);
+
+// If `mmap` is true, the tensors are views of a private mapping of the file,
+// which stays mapped until they are all freed, and writes to them don't
+// reach the file. Otherwise they are copied from it.
+NamedTensors load_tensor_archive(const std::string& path, bool mmap);
+
+}}
@@ -48,6 +48,20 @@ static std::vector<int64_t> to_aten_shape(int ndim, npy_intp* values) {
 
 static int aten_to_dtype(const at::Type& type);
 
+static bool can_share_memory(PyArrayObject* array) {
+  if (!PyArray_ISALIGNED(array) || !PyArray_ISNOTSWAPPED(array)) {
+    return false;
+  }
+  auto element_size_in_bytes = PyArray_ITEMSIZE(array);
+  for (int i = 0; i < PyArray_NDIM(array); i++) {
+    auto stride = PyArray_STRIDES(array)[i];
+    if (stride < 0 || stride % element_size_in_bytes != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 PyObject* tensor_to_numpy(const at::Tensor& tensor) {
   auto dtype = aten_to_dtype(tensor.type());
   auto sizes = to_numpy_shape(tensor.sizes());
@@ -58,6 +72,14 @@ PyObject* tensor_to_numpy(const at::Tensor& tensor) {
     stride *= element_size_in_bytes;
   }
 
+  // Tensors on read-only storage (e.g. from a non-writeable array) give back
+  // non-writeable arrays
+  auto storage = tensor.storage();
+  int flags = NPY_ARRAY_ALIGNED;
+  if (!storage->has_flag(Storage::READONLY)) {
+    flags |= NPY_ARRAY_WRITEABLE;
+  }
+
   auto array = THPObjectPtr(PyArray_New(
       &PyArray_Type,
       tensor.dim(),
@@ -66,7 +88,7 @@ PyObject* tensor_to_numpy(const at::Tensor& tensor) {
       strides.data(),
       tensor.data_ptr(),
       0,
-      NPY_ARRAY_ALIGNED | NPY_ARRAY_WRITEABLE,
+      flags,
       nullptr));
   if (!array) return NULL;
 
@@ -79,7 +101,7 @@ PyObject* tensor_to_numpy(const at::Tensor& tensor) {
   if (PyArray_SetBaseObject((PyArrayObject*)array.get(), py_tensor) == -1) {
     return NULL;
   }
-  tensor.storage()->clear_flag(Storage::RESIZABLE);
+  storage->clear_flag(Storage::RESIZABLE);
 
   return array.release();
 }
@@ -90,6 +112,23 @@ at::Tensor tensor_from_numpy(PyObject* obj) {
   }
 
   auto array = (PyArrayObject*)obj;
+  auto& type = CPU(numpy_dtype_to_aten(PyArray_TYPE(array)));
+
+  // Tensors can't have negative strides, and don't know about byte order or
+  // misaligned data, so such arrays are copied once into an aligned array in
+  // native byte order, which the tensor then shares.
+  THPObjectPtr copy;
+  if (!can_share_memory(array)) {
+    auto descr = PyArray_DescrNewByteorder(PyArray_DESCR(array), NPY_NATIVE);
+    if (!descr) throw python_error();
+    // steals descr
+    copy = PyArray_FromArray(
+        array, descr, NPY_ARRAY_CARRAY | NPY_ARRAY_ENSURECOPY);
+    if (!copy) throw python_error();
+    obj = copy.get();
+    array = (PyArrayObject*)obj;
+  }
+
   int ndim = PyArray_NDIM(array);
   auto sizes = to_aten_shape(ndim, PyArray_DIMS(array));
   auto strides = to_aten_shape(ndim, PyArray_STRIDES(array));
@@ -99,24 +138,17 @@ at::Tensor tensor_from_numpy(PyObject* obj) {
     stride /= element_size_in_bytes;
   }
 
-  size_t storage_size = 1;
-  for (int i = 0; i < ndim; i++) {
-    if (strides[i] < 0) {
-      throw ValueError(
-          "some of the strides of a given numpy array are negative. This is "
-          "currently not supported, but will be added in future releases.");
-    }
-    // XXX: this won't work for negative strides
-    storage_size += (sizes[i] - 1) * strides[i];
-  }
-
   void* data_ptr = PyArray_DATA(array);
-  auto& type = CPU(numpy_dtype_to_aten(PyArray_TYPE(array)));
   Py_INCREF(obj);
-  return type.tensorFromBlob(data_ptr, sizes, strides, [obj](void* data) {
+  auto tensor = type.tensorFromBlob(data_ptr, sizes, strides, [obj](void* data) {
     AutoGIL gil;
     Py_DECREF(obj);
   });
+  // In-place ops must not write to the memory of a non-writeable array
+  if (!PyArray_ISWRITEABLE(array)) {
+    tensor.storage()->set_flag(Storage::READONLY);
+  }
+  return tensor;
 }
 
 static int aten_to_dtype(const at::Type& type) {
@@ -354,7 +354,8 @@ def current_blas_handle():
 def empty_cache():
     r"""Releases all unoccupied cached memory currently held by the caching
     allocator so that those can be used in other GPU application and visible in
-    `nvidia-smi`.
+    `nvidia-smi`. Also closes the memory of other processes that was kept
+    mapped after the last tensor received from it was freed.
 
     .. note::
         :meth:`~torch.cuda.empty_cache` doesn't increase the amount of GPU
@@ -443,6 +444,136 @@ def max_memory_cached(device=None):
     return torch._C._cuda_maxMemoryCached(device)
 
 
+def num_cuda_mallocs(device=None):
+    r"""Returns the number of ``cudaMalloc`` calls the caching allocator made
+    for a given device.
+
+    It only grows when an allocation can't be served from the cache, so a
+    workload that repeats after warming up the cache shouldn't change it.
+
+    Arguments:
+        device (int, optional): selected device. Returns statistic for the
+                                current device, given by
+                                :meth:`~torch.cuda.current_device`, if
+                                :attr:`device` is ``None`` (default).
+
+    .. note::
+        See :ref:`cuda-memory-management` for more details about GPU memory
+        management.
+    """
+    if device is None:
+        device = current_device()
+    return torch._C._cuda_numCudaMallocs(device)
+
+
+def memory_fragmentation_stats(device=None):
+    r"""Returns statistics about the GPU memory that is cached but not
+    currently used by tensors, for a given device.
+
+    The result is a dictionary with the following keys:
+
+    - ``free_blocks``: number of cached blocks that are not in use
+    - ``free_bytes``: total size of these blocks in bytes. This is
+      :meth:`~torch.cuda.memory_cached` minus
+      :meth:`~torch.cuda.memory_allocated`.
+    - ``largest_free_block``: size of the largest free block in bytes. An
+      allocation larger than this requires a new ``cudaMalloc`` call.
+    - ``size_classes``: histogram of the free blocks. Maps a power of two
+      ``2**i`` to a ``(count, bytes)`` tuple describing the free blocks whose
+      size is in ``[2**i, 2**(i + 1))``. Empty size classes are omitted.
+
+    Arguments:
+        device (int, optional): selected device. Returns statistic for the
+                                current device, given by
+                                :meth:`~torch.cuda.current_device`, if
+                                :attr:`device` is ``None`` (default).
+
+    .. note::
+        See :ref:`cuda-memory-management` for more details about GPU memory
+        management.
+    """
+    if device is None:
+        device = current_device()
+    return torch._C._cuda_memoryFragmentationStats(device)
+
+
+def host_memory_stats():
+    r"""Returns statistics about the pinned host memory held by the caching
+    host allocator, which serves :meth:`~torch.Tensor.pin_memory` and the
+    other page-locked allocations.
+
+    The result is a dictionary with the following keys:
+
+    - ``allocated_bytes``: size of the blocks currently in use
+    - ``cached_bytes``: pinned memory held by the allocator, in use or not
+    - ``arena_bytes``: size of the arena preallocated when
+      ``THC_CACHING_HOST_ALLOCATOR_ARENA_MB`` is set, included in
+      ``cached_bytes``
+    - ``allocations``: number of allocations since the program started
+    - ``cache_hits``: number of these that were served by a cached block.
+      ``cache_hits / allocations`` is the hit rate of the cache.
+
+    .. note::
+        Allocation sizes are rounded up to a power of two, so that freed
+        blocks can serve later requests of similar sizes.
+    """
+    _lazy_init()
+    return torch._C._cuda_hostMemoryStats()
+
+
+def _set_cross_stream_reuse(enabled):
+    r"""Allows the caching allocator to hand free blocks over to other streams
+    once all the work queued on their allocation stream has completed.
+    Equivalent to setting ``THC_CACHING_ALLOCATOR_CROSS_STREAM=1``."""
+    _lazy_init()
+    torch._C._cuda_setCrossStreamReuse(enabled)
+
+
+def set_deterministic_accumulation(enabled):
+    r"""Makes :meth:`~torch.Tensor.index_add_` and
+    :meth:`~torch.Tensor.scatter_add_` on CUDA tensors produce the same
+    result on every run.
+
+    By default these ops accumulate with atomic additions, whose order
+    varies between runs, and only switch to summing over sorted indices
+    when many indices hit the same output. With ``enabled=True`` the sorted
+    version is always used, which can be slower when indices rarely repeat.
+
+    Arguments:
+        enabled (bool): whether to always accumulate in a fixed order.
+    """
+    _lazy_init()
+    torch._C._cuda_setDeterministicAccumulation(enabled)
+
+
+def deterministic_accumulation():
+    r"""Returns whether :func:`set_deterministic_accumulation` is enabled."""
+    _lazy_init()
+    return torch._C._cuda_getDeterministicAccumulation()
+
+
+def set_tensor_op_float_math(enabled):
+    r"""Lets float matrix products and cuDNN convolutions on CUDA tensors use
+    the tensor cores of the GPU (compute capability 7.0 and later).
+
+    Tensor cores multiply half precision inputs: with ``enabled=True`` the
+    float inputs of these ops are rounded to half precision and accumulated
+    in float, which is several times faster but only about as precise as
+    half. Half tensors always use tensor cores when the GPU has them.
+
+    Arguments:
+        enabled (bool): whether float ops may use tensor cores.
+    """
+    _lazy_init()
+    torch._C._cuda_setTensorOpFloatMath(enabled)
+
+
+def tensor_op_float_math():
+    r"""Returns whether :func:`set_tensor_op_float_math` is enabled."""
+    _lazy_init()
+    return torch._C._cuda_getTensorOpFloatMath()
+
+
 def _host_allocator():
     _lazy_init()
     return torch._C._cuda_cudaHostAllocator()
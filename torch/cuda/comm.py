@@ -113,8 +113,17 @@ def reduce_add_coalesced(inputs, destination=None, buffer_size=10485760):
             for coll, t in zip(dense_tensors, tensor_at_gpus):
                 coll.append(t.to_dense() if t.is_sparse else t)
             ref_order.append(dense_tensors[0][-1])
-    itrs = [_take_tensors(tensors, buffer_size) for tensors in dense_tensors]
+    if destination is None:
+        destination = torch.cuda.current_device()
     # now the dense ones, which have consistent sizes
+    if len(dense_tensors[0]) > 0 and \
+            nccl.is_available([tensors[0] for tensors in dense_tensors]) and \
+            destination in [tensors[0].get_device() for tensors in dense_tensors]:
+        # chunks are flattened and reduced by NCCL on side streams, the
+        # flatten of a chunk overlapping with the reduction of the previous one
+        output.extend(torch._C._reduce_add_coalesced(dense_tensors, destination, buffer_size))
+        return tuple(_reorder_tensors_as(output, ref_order))
+    itrs = [_take_tensors(tensors, buffer_size) for tensors in dense_tensors]
     for chunks in zip(*itrs):
         flat_tensors = [_flatten_dense_tensors(chunk) for chunk in chunks]
         flat_result = reduce_add(flat_tensors, destination)
@@ -59,6 +59,13 @@ def init_process_group(backend, init_method='env://', **kwargs):
         world_size (int, optional): Number of processes participating in the job.
         rank (int, optional): Rank of the current process.
         group_name (str, optional): Group name. See description of init methods.
+        min_world_size (int, optional): Makes the process group elastic: it is
+            formed as soon as this many processes joined and no more of them
+            came for ``THD_JOIN_TIMEOUT`` milliseconds (default 30000), with
+            ``world_size`` being the maximum. Rank 0 is the rendezvous host,
+            the other processes get ranks in the order they joined. Supported
+            by the ``tcp``, ``gloo`` and ``nccl`` backends with ``env://`` or
+            ``tcp://`` with a master address. See :func:`rebuild_process_group`.
 
     To enable ``backend == mpi``, PyTorch needs to built from source on a system that
     supports MPI.
@@ -67,6 +74,7 @@ def init_process_group(backend, init_method='env://', **kwargs):
     world_size = kwargs.pop('world_size', -1)
     group_name = kwargs.pop('group_name', '')
     rank = kwargs.pop('rank', -1)
+    min_world_size = kwargs.pop('min_world_size', -1)
     assert len(kwargs) == 0, "got unexpected keyword arguments: %s" % ",".join(kwargs.keys())
 
     if not is_available():
@@ -91,7 +99,7 @@ def init_process_group(backend, init_method='env://', **kwargs):
         raise RuntimeError("Invalid distributed backend name: " + backend)
 
     torch._C._dist_init_process_group(backend, init_method, world_size,
-                                      group_name, rank)
+                                      group_name, rank, min_world_size)
     _initialized = _INITIALIZED_PG
 
     if _backend == dist_backend.NCCL:
@@ -101,6 +109,24 @@ def init_process_group(backend, init_method='env://', **kwargs):
         raise RuntimeError("distributed module initialization failed")
 
 
+def rebuild_process_group():
+    """Repeats the rendezvous of :func:`init_process_group` and reconnects the
+    process group to the processes which took part in it, without restarting
+    the process.
+
+    This is meant for elastic jobs: at an iteration boundary the surviving
+    processes call it, together with new processes calling
+    :func:`init_process_group`, and the group is formed again from them. Rank
+    and world size can change, so they have to be queried again afterwards,
+    and groups created with :func:`new_group` are no longer valid. The
+    process with rank 0 hosts the rendezvous, so it must not be the one that
+    leaves.
+    """
+    assert _initialized == _INITIALIZED_PG, \
+        "rebuild_process_group requires an initialized process group"
+    torch._C._dist_rebuild_process_group()
+
+
 def init_master_worker(backend, init_method='env://', **kwargs):
     warnings.warn("""
     ================================================================================
@@ -143,6 +169,12 @@ class group(object):
     WORLD = object()
 
 
+class compression(object):
+    FP16 = 0
+    TOPK = 1
+    SIGN = 2
+
+
 class _DistributedRequest(object):
     def __init__(self, request):
         self.request = request
@@ -260,7 +292,7 @@ def broadcast_multigpu(tensor_list, src, group=group.WORLD):
     return torch._C._dist_broadcast_multigpu(tensor_list, src, group)
 
 
-def broadcast(tensor, src, group=group.WORLD):
+def broadcast(tensor, src, group=group.WORLD, async_op=False):
     """Broadcasts the tensor to the whole group.
 
     ``tensor`` must have the same number of elements in all processes
@@ -271,9 +303,15 @@ def broadcast(tensor, src, group=group.WORLD):
             process, and tensor to be used to save received data otherwise.
         src (int): Source rank.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether this op should be an async op.
+
+    Returns:
+        A distributed request object if ``async_op`` is set, None otherwise.
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
+    if async_op:
+        return _DistributedRequest(torch._C._dist_broadcast(tensor, src, group, True))
     return torch._C._dist_broadcast(tensor, src, group)
 
 
@@ -308,7 +346,7 @@ def all_reduce_multigpu(tensor_list, op=reduce_op.SUM, group=group.WORLD):
     return torch._C._dist_all_reduce_multigpu(tensor_list, op, group)
 
 
-def all_reduce(tensor, op=reduce_op.SUM, group=group.WORLD):
+def all_reduce(tensor, op=reduce_op.SUM, group=group.WORLD, async_op=False):
     """Reduces the tensor data across all machines in such a way that all get
     the final result.
 
@@ -320,12 +358,82 @@ def all_reduce(tensor, op=reduce_op.SUM, group=group.WORLD):
         op (optional): One of the values from ``torch.distributed.reduce_op``
             enum.  Specifies an operation used for element-wise reductions.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether this op should be an async op.
+
+    Returns:
+        A distributed request object if ``async_op`` is set, None otherwise.
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
+    if async_op:
+        return _DistributedRequest(torch._C._dist_all_reduce(tensor, op, group, True))
     return torch._C._dist_all_reduce(tensor, op, group)
 
 
+def all_reduce_compressed(tensor, compression, residual=None, ratio=0.01,
+                          group=group.WORLD):
+    """Sums the tensor data across all machines like :func:`all_reduce`, but
+    sends it compressed, trading accuracy for bandwidth.
+
+    The available compressions are:
+
+    * ``compression.FP16``: the tensor is sent as half precision floats.
+    * ``compression.TOPK``: only the ``ratio`` fraction of the elements with
+      the largest magnitude is sent, with their indices.
+    * ``compression.SIGN``: one bit per element is sent, its sign, scaled by
+      the mean absolute value of the tensor. Only floating point tensors are
+      supported.
+
+    ``residual`` accumulates what the compression dropped (error feedback),
+    and is added back to ``tensor`` in the next call, so that the dropped
+    part of the gradients is eventually applied. It should have the size and
+    type of ``tensor``, start filled with zeros, and be passed again in every
+    call involving the same tensor. When it is ``None``, the dropped part is
+    lost.
+
+    Arguments:
+        tensor (Tensor): Input and output of the collective. The function
+            operates in-place.
+        compression: One of the values from
+            ``torch.distributed.compression``.
+        residual (Tensor, optional): Error feedback of ``tensor``, updated
+            in-place.
+        ratio (float, optional): Fraction of the elements sent by
+            ``compression.TOPK``.
+        group (optional): Group of the collective.
+    """
+    assert torch.distributed._initialized == _INITIALIZED_PG, \
+        "collective only supported in process-group mode"
+    return torch._C._dist_all_reduce_compressed(tensor, residual, compression, ratio, group)
+
+
+def all_reduce_sparse(tensor, density_threshold=None, group=group.WORLD):
+    """Sums a sparse tensor across all machines, and returns the result.
+
+    The indices and values of every process are gathered and coalesced, so
+    the amount of data sent depends on the number of non-zero entries, not
+    on the size of the tensor. If ``density_threshold`` is given and the
+    gathered entries would cover at least this fraction of the tensor, the
+    tensor is densified and reduced with :func:`all_reduce` instead, and the
+    result is a dense tensor.
+
+    Arguments:
+        tensor (Tensor): Sparse input of the collective. It is left
+            unchanged.
+        density_threshold (float, optional): Density above which the
+            reduction is dense.
+        group (optional): Group of the collective.
+
+    Returns:
+        The sum of the tensors, sparse and coalesced, or dense.
+    """
+    assert torch.distributed._initialized == _INITIALIZED_PG, \
+        "collective only supported in process-group mode"
+    if density_threshold is None:
+        density_threshold = float('inf')
+    return torch._C._dist_all_reduce_sparse(tensor, density_threshold, group)
+
+
 def reduce_multigpu(tensor_list, dst, op=reduce_op.SUM, group=group.WORLD):
     """Reduces the tensor data on multiple GPUs across all machines. Each tensor
     in tensor_list should reside on a separate GPU
@@ -428,7 +536,7 @@ def all_gather_multigpu(output_tensor_lists,
     return ret
 
 
-def all_gather(tensor_list, tensor, group=group.WORLD):
+def all_gather(tensor_list, tensor, group=group.WORLD, async_op=False):
     """Gathers tensors from the whole group in a list.
 
     Arguments:
@@ -436,9 +544,20 @@ def all_gather(tensor_list, tensor, group=group.WORLD):
             correctly-sized tensors to be used for output of the collective.
         tensor (Tensor): Tensor to be broadcast from current process.
         group (optional): Group of the collective.
+        async_op (bool, optional): Whether this op should be an async op.
+
+    Returns:
+        A distributed request object if ``async_op`` is set, None otherwise.
+
+    .. note::
+        Async collectives run in the order they were issued, but not in order
+        with the blocking ones: wait for the pending requests before calling
+        a blocking collective on the same group.
     """
     assert torch.distributed._initialized == _INITIALIZED_PG, \
         "collective only supported in process-group mode"
+    if async_op:
+        return _DistributedRequest(torch._C._dist_all_gather(tensor_list, tensor, group, True))
     if _backend != dist_backend.NCCL:
         return torch._C._dist_all_gather(tensor_list, tensor, group)
     else:
@@ -519,7 +638,7 @@ def barrier(group=group.WORLD):
     return torch._C._dist_barrier(group)
 
 
-def new_group(ranks=None):
+def new_group(ranks=None, hierarchical=False):
     """Creates a new distributed group.
 
     This function requires that all processes in the main group (i.e. all
@@ -529,6 +648,11 @@ def new_group(ranks=None):
 
     Arguments:
         ranks (list[int]): List of ranks of group members.
+        hierarchical (bool, optional): With the ``nccl`` backend,
+            :func:`all_reduce_multigpu` on such a group reduce-scatters the
+            tensors between the local GPUs, allreduces every slice across
+            the processes, and allgathers the slices back, instead of
+            running a single flat ring. Ignored by the other backends.
 
     Returns:
         A handle of distributed group that can be given to collective calls.
@@ -537,7 +661,7 @@ def new_group(ranks=None):
         "collective only supported in process-group mode"
     if ranks is None:
         ranks = list(range(get_world_size()))
-    return torch._C._dist_new_group(ranks)
+    return torch._C._dist_new_group(ranks, hierarchical)
 
 
 def _clear_group_cache(group=group.WORLD):
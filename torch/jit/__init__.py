@@ -3,7 +3,7 @@ from torch import Tensor
 from torch.autograd import Variable, function
 from torch.nn import Module, ModuleList, ParameterList, Parameter
 from torch.jit.frontend import get_jit_ast
-from torch._six import raise_from, with_metaclass
+from torch._six import raise_from, with_metaclass, string_classes
 from collections import defaultdict, OrderedDict, namedtuple
 import sys
 import warnings
@@ -16,6 +16,7 @@ import functools
 import inspect
 import copy
 import numbers
+import hashlib
 
 
 _flatten = torch._C._jit_flatten
@@ -454,6 +455,14 @@ def trace(*args, **kwargs):
 
     Keyword arguments:
         optimize (bool, optional): whether or not to apply optimizations.  Default: ``True``.
+        cache (bool or str, optional): reuse the traces of functions with the
+            same code, for inputs of the same structure, types and sizes, or
+            of a shape class (the same sizes up to renaming) in which no traced
+            op depended on the sizes. If a directory is given, the traces are
+            also saved there, for other processes. Only the code of the
+            function (or the ``forward`` of the module, and its ``repr``) is
+            checked, so what else the trace depends on, like global variables
+            and the functions it calls, must not change. Default: ``False``.
 
         >>> @jit.trace(torch.autograd.Variable(torch.rand(1)))
         >>> def f(x):
@@ -463,18 +472,56 @@ def trace(*args, **kwargs):
         executor_options = {'optimize': True}
         for name in executor_options:
             executor_options[name] = kwargs.pop(name, executor_options[name])
+        cache = kwargs.pop('cache', False)
         if len(kwargs) != 0:
             raise TypeError("got unexpected keyword arguments: {}".format(", ".join(kwargs.keys())))
 
+        cache_options = {}
+        if cache:
+            cache_dir = cache if isinstance(cache, string_classes) else ''
+            if cache_dir and not os.path.isdir(cache_dir):
+                os.makedirs(cache_dir)
+            cache_options = {'cache_key': _trace_cache_key(func), 'cache_dir': cache_dir}
+
         if isinstance(func, torch.nn.Module):
             module = TopLevelTracedModule(func, **executor_options)
-            module._create_method_from_trace('forward', func, args)
+            module._create_method_from_trace('forward', func, args, **cache_options)
             return module
         else:
-            return torch._C.GraphExecutor(func, args, **executor_options)
+            return torch._C.GraphExecutor(func, args, **dict(executor_options, **cache_options))
     return wrapper
 
 
+def _code_fingerprint(code, h):
+    h.update(code.co_code)
+    h.update(repr(code.co_names).encode('utf-8'))
+    for const in code.co_consts:
+        if inspect.iscode(const):
+            _code_fingerprint(const, h)
+        else:
+            h.update(repr(const).encode('utf-8'))
+
+
+def _trace_cache_key(func):
+    # Identifies func in the trace cache, see the cache argument of trace()
+    h = hashlib.sha1()
+    h.update(torch.__version__.encode('utf-8'))
+    if isinstance(func, torch.nn.Module):
+        cls = type(func)
+        name = '{}.{}'.format(cls.__module__, cls.__name__)
+        forward = getattr(cls.forward, '__func__', cls.forward)
+        _code_fingerprint(forward.__code__, h)
+        h.update('{} training={}'.format(repr(func), func.training).encode('utf-8'))
+    else:
+        name = '{}.{}'.format(getattr(func, '__module__', ''), getattr(func, '__name__', ''))
+        code = getattr(func, '__code__', None)
+        if code is None:
+            raise ValueError("can't cache the traces of {}, which has no code".format(func))
+        _code_fingerprint(code, h)
+        h.update(repr(func.__defaults__).encode('utf-8'))
+    return '{}:{}'.format(name, h.hexdigest())
+
+
 def createResolutionCallback(frame_id=2):
     """
     Creates a function which, given a string variable name,
@@ -870,5 +917,41 @@ class _ConstModuleList(ScriptModule):
         keys = [key for key in keys if not key.isdigit()]
         return keys
 
+
+def save(m, f):
+    """
+    Save a script or traced module to the file named `f`, in a native format
+    which stores the graphs of its methods and the raw data of its parameters
+    and buffers, and can be loaded from C++ without Python.
+
+    Arguments:
+        m (ScriptModule): the module to save.
+        f (str): the name of the file.
+    """
+    m._save(f)
+
+
+def load(f):
+    """
+    Load a module saved by :func:`torch.jit.save`. The parameters and buffers
+    are views of a mapping of the file, so only the parts of it that are used
+    are read. Modifying them in place doesn't change the file.
+
+    Arguments:
+        f (str): the name of the file.
+
+    Returns:
+        a ScriptModule with the submodules, parameters, buffers and methods
+        of the saved module.
+    """
+    def make_submodule(parent, name):
+        submodule = ScriptModule()
+        setattr(parent, name, submodule)
+        return submodule
+
+    m = ScriptModule()
+    m._load(f, make_submodule)
+    return m
+
 if not torch._C._jit_init():
     raise RuntimeError("JIT initialization failed")
@@ -9,6 +9,7 @@
 #include "data_channels/DataChannelNccl.hpp"
 #endif // WITH_DISTRIBUTED_NCCL
 #include "data_channels/DataChannelTCP.hpp"
+#include "data_channels/DataChannelUtils.hpp"
 
 #include <algorithm>
 #include <stdexcept>
@@ -16,16 +17,176 @@
 
 namespace thd {
 
-#define GET_CONFIG getInitConfig(init_method, world_size, group_name, rank)
+namespace {
+
+struct AsyncRequest : DataChannel::Request {
+  AsyncRequest(QueueWorker::Request&& request)
+    : _request(std::move(request)) {}
+
+  bool isCompleted() override {
+    return _request.isCompleted();
+  }
+
+  void wait() override {
+    _request.wait();
+  }
+
+private:
+  QueueWorker::Request _request;
+};
+
+} // namespace
+
+DataChannel::DataChannel() {}
+
+
+DataChannel::~DataChannel() {}
+
+
+void DataChannel::rebuild(InitMethod::Config config) {
+  throw std::runtime_error("this data channel does not support rebuilding "
+                           "its process group");
+}
+
+
+DataChannel::Request* DataChannel::_runAsync(
+    std::function<void ()>&& collective) {
+  {
+    std::lock_guard<std::mutex> lock(_async_mutex);
+    if (!_async_worker)
+      _async_worker.reset(new QueueWorker());
+  }
+  return new AsyncRequest(_async_worker->push(std::move(collective)));
+}
+
+
+DataChannel::Request* DataChannel::iallReduce(at::Tensor& data,
+                                              THDReduceOp operation,
+                                              THDGroup group_id) {
+  return _runAsync([this, data, operation, group_id]() mutable {
+    this->allReduce(data, operation, group_id);
+  });
+}
+
+
+DataChannel::Request* DataChannel::ibroadcast(at::Tensor& data,
+                                              rank_type src_rank,
+                                              THDGroup group_id) {
+  return _runAsync([this, data, src_rank, group_id]() mutable {
+    this->broadcast(data, src_rank, group_id);
+  });
+}
+
+
+DataChannel::Request* DataChannel::iallGather(std::vector<at::Tensor>& output,
+                                              at::Tensor& input,
+                                              THDGroup group_id) {
+  return _runAsync([this, output, input, group_id]() mutable {
+    this->allGather(output, input, group_id);
+  });
+}
+
+
+THDGroup DataChannel::newHierarchicalGroup(const std::vector<rank_type>& ranks) {
+  return newGroup(ranks);
+}
+
+
+at::Tensor DataChannel::allReduceSparse(at::Tensor& data,
+                                        double density_threshold,
+                                        THDGroup group_id) {
+  if (!data.type().is_sparse()) {
+    throw std::invalid_argument("allReduceSparse expects a sparse tensor");
+  }
+  auto input = data.coalesce();
+  int64_t nnz = input._nnz();
+  int64_t dim_i = input._dimI();
+  auto sizes = input.sizes();
+  // number of dense elements of a single sparse entry
+  int64_t entry_numel = 1;
+  for (std::size_t d = dim_i; d < sizes.size(); ++d) {
+    entry_numel *= sizes[d];
+  }
+  int64_t numel = entry_numel;
+  for (int64_t d = 0; d < dim_i; ++d) {
+    numel *= sizes[d];
+  }
+
+  auto& index_type = input._indices().type();
+  auto& value_type = input._values().type();
+  auto group_size = getGroupSize(group_id);
+
+  // Exchange the number of entries first, every process then knows the
+  // sizes of all the payloads
+  auto local_nnz = index_type.tensor({1});
+  local_nnz.fill_(nnz);
+  std::vector<at::Tensor> all_nnz;
+  for (rank_type i = 0; i < group_size; ++i) {
+    all_nnz.push_back(index_type.tensor({1}));
+  }
+  allGather(all_nnz, local_nnz, group_id);
+  auto counts = at::cat(all_nnz, 0).toBackend(at::kCPU);
+  auto counts_data = counts.data<int64_t>();
+  int64_t total_nnz = 0, max_nnz = 0;
+  for (rank_type i = 0; i < group_size; ++i) {
+    total_nnz += counts_data[i];
+    max_nnz = std::max(max_nnz, counts_data[i]);
+  }
+
+  // All the processes take the same decision, since they all know the sizes
+  if (total_nnz * entry_numel >= density_threshold * numel) {
+    auto dense = input.to_dense();
+    allReduce(dense, THDReduceSUM, group_id);
+    return dense;
+  }
+  if (max_nnz == 0) {
+    return input;
+  }
+
+  // allGather needs inputs of the same size, pad them to the largest one
+  std::vector<int64_t> value_sizes(sizes.begin() + dim_i, sizes.end());
+  value_sizes.insert(value_sizes.begin(), max_nnz);
+  auto indices = at::zeros(index_type, {dim_i, max_nnz});
+  auto values = at::zeros(value_type, value_sizes);
+  if (nnz > 0) {
+    indices.narrow(1, 0, nnz).copy_(input._indices());
+    values.narrow(0, 0, nnz).copy_(input._values());
+  }
+  std::vector<at::Tensor> all_indices, all_values;
+  for (rank_type i = 0; i < group_size; ++i) {
+    all_indices.push_back(index_type.tensor({dim_i, max_nnz}));
+    all_values.push_back(value_type.tensor(value_sizes));
+  }
+  allGather(all_indices, indices, group_id);
+  allGather(all_values, values, group_id);
+
+  std::vector<at::Tensor> gathered_indices, gathered_values;
+  for (rank_type i = 0; i < group_size; ++i) {
+    if (counts_data[i] == 0) {
+      continue;
+    }
+    gathered_indices.push_back(all_indices[i].narrow(1, 0, counts_data[i]));
+    gathered_values.push_back(all_values[i].narrow(0, 0, counts_data[i]));
+  }
+  return input.type().sparse_coo_tensor(at::cat(gathered_indices, 1),
+                                        at::cat(gathered_values, 0),
+                                        sizes).coalesce();
+}
+
+
+#define GET_CONFIG getInitConfig(init_method, world_size, group_name, rank, \
+                                   min_world_size)
 DataChannel* DataChannel::newChannel(THDChannelType type, std::string init_method,
                                      int world_size, std::string group_name,
-                                     int rank) {
+                                     int rank, int min_world_size) {
   switch (type) {
     case THDChannelTCP:
       return new DataChannelTCP(GET_CONFIG);
 
     case THDChannelMPI:
 #ifdef WITH_MPI
+      if (min_world_size != -1)
+        throw std::runtime_error("the MPI backend does not support min_world_size");
       return new DataChannelMPI();
 #endif // WITH_MPI
       throw std::runtime_error(
@@ -9,6 +9,9 @@
 
 #include <ATen/ATen.h>
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 #include <utility>
@@ -21,6 +24,8 @@ MAKE_HASHABLE(at::ScalarType, static_cast<int>(t));
 
 namespace thd {
 
+struct QueueWorker;
+
 struct DataChannel {
 
   struct Request {
@@ -70,8 +75,8 @@ struct DataChannel {
     std::unordered_map<rank_type, rank_type> _old2new;
   };
 
-  DataChannel() {};
-  virtual ~DataChannel() {};
+  DataChannel();
+  virtual ~DataChannel();
 
   virtual bool init() = 0;
 
@@ -81,8 +86,18 @@ struct DataChannel {
    */
   virtual void destroy() = 0;
 
+  /**
+   * Connects a destroyed channel to the processes of a new rendezvous, e.g.
+   * an elastic one after processes left or joined the job. Rank and world
+   * size can change, only THDGroupWORLD exists afterwards and communicator
+   * caches are filled again as groups get used. Throws for channels which
+   * can't change their processes.
+   */
+  virtual void rebuild(InitMethod::Config config);
+
   virtual rank_type getRank() = 0;
   virtual rank_type getNumProcesses() = 0;
+  virtual rank_type getGroupSize(THDGroup group_id) = 0;
 
  /**
    * All gather inputs from multiple GPUs, each Tensor in input vector should be
@@ -144,15 +159,62 @@ struct DataChannel {
   virtual Request* isend(at::Tensor& data, rank_type dst_rank) = 0;
   virtual Request* ireceive(at::Tensor& data, rank_type src_rank) = 0;
 
+  /**
+   * Non-blocking collectives: they return once the collective is issued,
+   * and the returned request completes when it is done. The tensors must
+   * not be used until then.
+   *
+   * By default the blocking collective runs on a background progress thread
+   * of the channel, one after the other in the order they were issued. All
+   * processes must issue the same collectives in the same order, so the
+   * requests should be waited for before calling a blocking collective of
+   * the same group. The requests must complete before the channel is
+   * destroyed.
+   */
+  virtual Request* iallReduce(at::Tensor& data, THDReduceOp operation,
+                              THDGroup group_id = THDGroupWORLD);
+  virtual Request* ibroadcast(at::Tensor& data, rank_type src_rank,
+                              THDGroup group_id = THDGroupWORLD);
+  virtual Request* iallGather(std::vector<at::Tensor>& output,
+                              at::Tensor& input,
+                              THDGroup group_id = THDGroupWORLD);
+
+  /**
+   * Sums a sparse tensor over the group, and returns the result.
+   *
+   * The indices and values of every process are gathered, their sizes
+   * being exchanged first, and coalesced locally. When the gathered entries
+   * would cover at least `density_threshold` of the dense tensor, it is
+   * densified and allreduced instead, and the result is dense.
+   */
+  virtual at::Tensor allReduceSparse(at::Tensor& data,
+                                     double density_threshold,
+                                     THDGroup group_id = THDGroupWORLD);
+
   virtual void barrier(THDGroup group_id = THDGroupWORLD) = 0;
 
   virtual THDGroup newGroup(const std::vector<rank_type>& ranks) = 0;
+  /**
+   * Creates a group whose collectives may be run hierarchically (within
+   * the nodes, then across them). Channels without such an implementation
+   * create a regular group.
+   */
+  virtual THDGroup newHierarchicalGroup(const std::vector<rank_type>& ranks);
   virtual void clearGroupCache(THDGroup group_id = THDGroupWORLD) = 0;
 
   static DataChannel* newChannel(THDChannelType type,
                                  std::string init_method,
                                  int world_size,
-                                 std::string group_name, int rank);
+                                 std::string group_name, int rank,
+                                 int min_world_size = -1);
+
+protected:
+  // Runs `collective` on the background progress thread of the channel
+  Request* _runAsync(std::function<void ()>&& collective);
+
+private:
+  std::mutex _async_mutex; // protects `_async_worker` creation
+  std::unique_ptr<QueueWorker> _async_worker;
 };
 
 } // namespace thd
@@ -71,12 +71,9 @@ DataChannelGloo::Group::Group(const std::string& addr, port_type port,
   , _store(new Store(addr, port, store_socket)) {}
 
 DataChannelGloo::DataChannelGloo(InitMethod::Config config)
-  : _rank(config.rank)
-  , _listen_socket(-1)
+  : _listen_socket(-1)
   , _cache(nullptr)
 {
-  _num_processes = config.world_size;
-
 #if defined(WITH_GLOO_IBVERBS) && WITH_GLOO_IBVERBS
 
   // This helper function automatically detects the IB device in the system
@@ -108,6 +105,13 @@ DataChannelGloo::DataChannelGloo(InitMethod::Config config)
     _deviceList.push_back(::gloo::transport::tcp::CreateDevice(attr));
   }
 
+  _configure(config);
+}
+
+
+void DataChannelGloo::_configure(const InitMethod::Config& config) {
+  _rank = config.rank;
+  _num_processes = config.world_size;
   if (_rank == 0) {
     _addr = "localhost";
     _port = config.master.listen_port;
@@ -115,13 +119,27 @@ DataChannelGloo::DataChannelGloo(InitMethod::Config config)
   } else {
     _addr = config.worker.master_addr;
     _port = config.worker.master_port;
+    _listen_socket = -1;
   }
 }
 
 
 DataChannelGloo::~DataChannelGloo() {}
 
-void DataChannelGloo::destroy() {}
+void DataChannelGloo::destroy() {
+  // Contexts have to go before the stores of their groups. Destroying the
+  // stores stops the master's store deamon, which closes the listen socket.
+  _cache.reset();
+  _groups.clear();
+  _listen_socket = -1;
+}
+
+void DataChannelGloo::rebuild(InitMethod::Config config) {
+  // The transport devices are kept, the cache gets new contexts and
+  // algorithms for the new processes as groups are used again.
+  _configure(config);
+  init();
+}
 
 bool DataChannelGloo::init() {
   _cache = std::unique_ptr<GlooCache>(new GlooCache(_rank, _deviceList));
@@ -148,6 +166,10 @@ rank_type DataChannelGloo::getNumProcesses() {
   return _num_processes;
 }
 
+rank_type DataChannelGloo::getGroupSize(THDGroup group_id) {
+  return _groups.at(group_id).size();
+}
+
 
 template<typename T>
 void DataChannelGloo::allGatherT(std::vector<at::Tensor>& output,
@@ -211,8 +233,8 @@ template<typename T>
 void DataChannelGloo::allReduceT(at::Tensor& t, THDReduceOp operation,
                                  THDGroup group_id) {
   std::uint64_t tensor_bytes = t.type().elementSizeInBytes() * t.numel();
-  auto ret = _cache->getAlgorithm<CollectiveType::ALL_REDUCE, T>(
-    group_id, _groups.at(group_id), getDeviceType(t), tensor_bytes, t.numel(), operation);
+  auto ret = _cache->getAlgorithmFor<CollectiveType::ALL_REDUCE, T>(
+    t, group_id, _groups.at(group_id), getDeviceType(t), tensor_bytes, t.numel(), operation);
 
   {
     std::lock_guard<std::mutex> lock(*GlooCache::mutex(ret));
@@ -240,8 +262,8 @@ template<typename T>
 void DataChannelGloo::broadcastT(at::Tensor& data, rank_type src_rank,
                                  THDGroup group_id) {
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
-  auto ret = _cache->getAlgorithm<CollectiveType::BROADCAST, T>(
-    group_id, _groups.at(group_id), getDeviceType(data), tensor_bytes, data.numel(),
+  auto ret = _cache->getAlgorithmFor<CollectiveType::BROADCAST, T>(
+    data, group_id, _groups.at(group_id), getDeviceType(data), tensor_bytes, data.numel(),
     _groups.at(group_id).mustGetGroupRank(src_rank));
 
   {
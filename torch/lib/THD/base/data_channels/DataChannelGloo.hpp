@@ -42,9 +42,11 @@ struct DataChannelGloo : DataChannel {
 
   bool init() override;
   void destroy() override;
+  void rebuild(InitMethod::Config config) override;
 
   rank_type getRank() override;
   rank_type getNumProcesses() override;
+  rank_type getGroupSize(THDGroup group_id) override;
 
   void allGather(std::vector<at::Tensor>& output,
                  std::vector<at::Tensor>& input,
@@ -99,6 +101,8 @@ private:
   void broadcastT(at::Tensor& data, rank_type src_rank,
                   THDGroup group_id = THDGroupWORLD);
 
+  void _configure(const InitMethod::Config& config);
+
   rank_type _rank; // Current process' rank
   std::string _addr;
   port_type _port;
@@ -137,6 +137,10 @@ rank_type DataChannelMPI::getNumProcesses() {
   return _num_processes;
 }
 
+rank_type DataChannelMPI::getGroupSize(THDGroup group_id) {
+  return _groups.at(group_id).second.size();
+}
+
 struct AutoGPU {
   AutoGPU(int new_device) {
     if (new_device == -1) return;
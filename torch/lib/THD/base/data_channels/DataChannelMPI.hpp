@@ -39,6 +39,7 @@ struct DataChannelMPI : DataChannel {
 
   rank_type getRank() override;
   rank_type getNumProcesses() override;
+  rank_type getGroupSize(THDGroup group_id) override;
 
   void allGather(std::vector<at::Tensor>& output,
                  std::vector<at::Tensor>& input,
@@ -8,6 +8,7 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <stdexcept>
 #include <unordered_set>
@@ -69,7 +70,11 @@ DataChannelNccl::DataChannelNccl(InitMethod::Config config, int timeout)
   , _timeout(timeout)
   , _masterListeningSocket(-1)
   , _slaveSocket(-1) {
+  _connectSockets(config);
+}
+
 
+void DataChannelNccl::_connectSockets(const InitMethod::Config& config) {
   // Establish the socket connections from rank 0 to all others
   if (_rank == 0) {
     _masterListeningSocket = config.master.listen_socket;
@@ -165,36 +170,75 @@ void DataChannelNccl::destroy() {
    * TODO: creating C++ wrappers for CUDA and NCCL resources to do the
    *       cleanup automatically
    */
+  std::unordered_set<THDGroup> cachedGroups;
   for (auto& itemPair : _groupNcclResources) {
-    auto groupId = itemPair.first;
+    cachedGroups.insert(itemPair.first);
+  }
+  for (auto& itemPair : _groupHierarchicalResources) {
+    cachedGroups.insert(itemPair.first);
+  }
+  for (auto groupId : cachedGroups) {
     _destroyNcclResources(groupId);
   }
 
   _groupNcclResources.clear();
   _groupDevices.clear();
+  _groupHierarchicalResources.clear();
+  _groupHierarchicalDevices.clear();
 
   _groups.clear();
+  _hierarchicalGroups.clear();
+
+  std::lock_guard<std::mutex> streamsLock(_collectiveStreamsMutex);
+  for (auto& itemPair : _collectiveStreams) {
+    gpuGuard.setDevice(itemPair.first);
+    THCudaCheck(cudaStreamSynchronize(itemPair.second->stream));
+    THCStream_free(itemPair.second);
+  }
+  _collectiveStreams.clear();
+}
+
+
+void DataChannelNccl::rebuild(InitMethod::Config config) {
+  // NCCL communicators of the new processes are created on the first use
+  // of every group
+  std::unique_lock<std::mutex> channelLock(_mutex);
+  _rank = config.rank;
+  _numProcesses = config.world_size;
+  _connectSockets(config);
+  channelLock.unlock();
+
+  init();
 }
 
 
 // Helper function that destroys the CUDA event and NCCL communicator
 void DataChannelNccl::_destroyNcclResources(THDGroup groupId) {
-  if (_groupNcclResources.find(groupId) != _groupNcclResources.end()) {
+  auto destroy = [](NcclResources& resources, const std::string& deviceList) {
     // Devices used for this group ID
-    auto devices = getDevicesList(_groupDevices[groupId]);
+    auto devices = getDevicesList(deviceList);
     // Guard GPU device
     AutoGPU gpuGuard;
     // Destroy the CUDA events
     size_t idx = 0;
-    for (auto& event : *(_groupNcclResources[groupId].ncclCudaEvents())) {
+    for (auto& event : *(resources.ncclCudaEvents())) {
       gpuGuard.setDevice(devices[idx++]);
       THCudaCheck(cudaEventSynchronize(event));
       THCudaCheck(cudaEventDestroy(event));
     }
     // Destroy the communicators
-    for (auto& comm : *(_groupNcclResources[groupId].ncclComms())) {
+    for (auto& comm : *(resources.ncclComms())) {
       NCCL_CHECK(ncclCommDestroy(comm));
     }
+  };
+
+  if (_groupNcclResources.find(groupId) != _groupNcclResources.end()) {
+    destroy(_groupNcclResources[groupId], _groupDevices[groupId]);
+  }
+  if (_groupHierarchicalResources.find(groupId) !=
+      _groupHierarchicalResources.end()) {
+    destroy(_groupHierarchicalResources[groupId],
+            _groupHierarchicalDevices[groupId]);
   }
 }
 
@@ -208,6 +252,8 @@ void DataChannelNccl::clearGroupCache(THDGroup groupId) {
 
   _groupNcclResources.erase(groupId);
   _groupDevices.erase(groupId);
+  _groupHierarchicalResources.erase(groupId);
+  _groupHierarchicalDevices.erase(groupId);
 }
 
 
@@ -243,6 +289,11 @@ rank_type DataChannelNccl::getNumProcesses() {
   return _numProcesses;
 }
 
+rank_type DataChannelNccl::getGroupSize(THDGroup group_id) {
+  std::unique_lock<std::mutex> channelLock(_mutex);
+  return _groups.at(group_id).size();
+}
+
 
 NcclResourcePair DataChannelNccl::_getNcclResourcePair(
     std::vector<at::Tensor>& input,
@@ -333,6 +384,80 @@ NcclResourcePair DataChannelNccl::_getNcclResourcePair(
 }
 
 
+NcclResourcePair DataChannelNccl::_getHierarchicalNcclResourcePair(
+    std::vector<at::Tensor>& input,
+    THDGroup groupId) {
+
+  std::vector<int> devices;
+  std::string deviceList;
+  for (auto tensor : input) {
+    devices.push_back(tensor.get_device());
+    if (deviceList.empty()) {
+      deviceList = std::to_string(tensor.get_device());
+    } else {
+      deviceList += "," + std::to_string(tensor.get_device());
+    }
+  }
+
+  auto cached = _groupHierarchicalResources.find(groupId);
+  if (cached != _groupHierarchicalResources.end()) {
+    if (deviceList == _groupHierarchicalDevices[groupId]) {
+      return std::make_pair(cached->second.ncclComms(),
+                            cached->second.ncclCudaEvents());
+    }
+    // Same as in _getNcclResourcePair, a new device list rebuilds the cache
+    _destroyNcclResources(groupId);
+    _groupNcclResources.erase(groupId);
+    _groupDevices.erase(groupId);
+    _groupHierarchicalResources.erase(groupId);
+    _groupHierarchicalDevices.erase(groupId);
+  }
+
+  _groupHierarchicalDevices[groupId] = deviceList;
+
+  auto comms =
+    std::unique_ptr<std::vector<ncclComm_t>>(new std::vector<ncclComm_t>());
+  comms->resize(2 * input.size());
+
+  auto events =
+    std::unique_ptr<std::vector<cudaEvent_t>>(new std::vector<cudaEvent_t>());
+  events->resize(input.size());
+
+  AutoGPU gpuGuard;
+  for (size_t i = 0; i < input.size(); ++i) {
+    gpuGuard.setDevice(devices[i]);
+    THCudaCheck(cudaEventCreate(&((*events)[i])));
+  }
+
+  // The communicator between the devices of this process
+  NCCL_CHECK(ncclCommInitAll(comms->data(), input.size(), devices.data()));
+
+  /**
+   * One communicator for each device index across the processes. Every
+   * process creates them in the same order, each communicator has a single
+   * rank in each process.
+   */
+  for (size_t i = 0; i < input.size(); ++i) {
+    ncclUniqueId ncclId;
+    NCCL_CHECK(ncclGetUniqueId(&ncclId));
+    broadcastUniqueNcclId(&ncclId);
+
+    gpuGuard.setDevice(devices[i]);
+    NCCL_CHECK(ncclCommInitRank(&((*comms)[input.size() + i]),
+                                int(_numProcesses),
+                                ncclId,
+                                _rank));
+  }
+
+  _groupHierarchicalResources.emplace(
+      std::make_pair(groupId, NcclResources(std::move(comms),
+                                            std::move(events))));
+
+  return std::make_pair(_groupHierarchicalResources[groupId].ncclComms(),
+                        _groupHierarchicalResources[groupId].ncclCudaEvents());
+}
+
+
 // Helper function that checks the input and output tensors for validity
 bool DataChannelNccl::_tensorCheckHelper(
     const std::vector<at::Tensor>& input,
@@ -419,6 +544,12 @@ void DataChannelNccl::allReduce(std::vector<at::Tensor>& data,
   }
   _checkGroupIdValid(groupId);
 
+  if (data.size() > 1 && _numProcesses > 1 &&
+      _hierarchicalGroups.find(groupId) != _hierarchicalGroups.end()) {
+    _hierarchicalAllReduce(data, operation, groupId);
+    return;
+  }
+
   auto ncclResourcePair  = _getNcclResourcePair(data, groupId);
   auto comms = ncclResourcePair.first;
   auto events = ncclResourcePair.second;
@@ -450,6 +581,109 @@ void DataChannelNccl::allReduce(std::vector<at::Tensor>& data,
 }
 
 
+void DataChannelNccl::_hierarchicalAllReduce(std::vector<at::Tensor>& data,
+                                            THDReduceOp operation,
+                                            THDGroup groupId) {
+
+  auto ncclResourcePair = _getHierarchicalNcclResourcePair(data, groupId);
+  auto comms = ncclResourcePair.first;
+  auto events = ncclResourcePair.second;
+
+  size_t numDevices = data.size();
+  auto* localComms = comms->data();
+  auto* crossComms = comms->data() + numDevices;
+
+  /**
+   * Device i owns the i-th chunk of the tensor. The elements that don't
+   * divide evenly (fewer than the number of devices) are reduced between
+   * the local devices and then by every slice across the processes.
+   */
+  size_t numel = data[0].numel();
+  size_t chunk = numel / numDevices;
+  size_t tail = numel - chunk * numDevices;
+  auto dataType = _getNcclDataType(data[0].type().scalarType());
+  size_t elementSize = data[0].type().elementSizeInBytes();
+
+  AutoGPU gpuGuard;
+
+  std::unique_lock<std::mutex> cudaFreeMutexLock(
+      *(THCCachingAllocator_getCudaFreeMutex()));
+
+  auto offset = [&](size_t i, size_t elements) {
+    return static_cast<char*>(data[i].data_ptr()) + elements * elementSize;
+  };
+
+  // Each step is issued on the current streams, after the previous one
+  if (chunk > 0) {
+    NCCL_CHECK(ncclGroupStart());
+    for (size_t i = 0; i < numDevices; ++i) {
+      gpuGuard.setDevice(data[i].get_device());
+      auto stream = THCState_getCurrentStream(THDGetCudaState());
+      NCCL_CHECK(ncclReduceScatter(data[i].data_ptr(), offset(i, i * chunk),
+                                   chunk, dataType, ncclOp[operation],
+                                   localComms[i], stream));
+    }
+    NCCL_CHECK(ncclGroupEnd());
+  }
+  if (tail > 0) {
+    NCCL_CHECK(ncclGroupStart());
+    for (size_t i = 0; i < numDevices; ++i) {
+      gpuGuard.setDevice(data[i].get_device());
+      auto stream = THCState_getCurrentStream(THDGetCudaState());
+      NCCL_CHECK(ncclAllReduce(offset(i, chunk * numDevices),
+                               offset(i, chunk * numDevices),
+                               tail, dataType, ncclOp[operation],
+                               localComms[i], stream));
+    }
+    NCCL_CHECK(ncclGroupEnd());
+  }
+
+  // The slices are independent, each one runs on its own communicator
+  if (chunk > 0) {
+    NCCL_CHECK(ncclGroupStart());
+    for (size_t i = 0; i < numDevices; ++i) {
+      gpuGuard.setDevice(data[i].get_device());
+      auto stream = THCState_getCurrentStream(THDGetCudaState());
+      NCCL_CHECK(ncclAllReduce(offset(i, i * chunk), offset(i, i * chunk),
+                               chunk, dataType, ncclOp[operation],
+                               crossComms[i], stream));
+    }
+    NCCL_CHECK(ncclGroupEnd());
+  }
+  if (tail > 0) {
+    NCCL_CHECK(ncclGroupStart());
+    for (size_t i = 0; i < numDevices; ++i) {
+      gpuGuard.setDevice(data[i].get_device());
+      auto stream = THCState_getCurrentStream(THDGetCudaState());
+      NCCL_CHECK(ncclAllReduce(offset(i, chunk * numDevices),
+                               offset(i, chunk * numDevices),
+                               tail, dataType, ncclOp[operation],
+                               crossComms[i], stream));
+    }
+    NCCL_CHECK(ncclGroupEnd());
+  }
+
+  if (chunk > 0) {
+    NCCL_CHECK(ncclGroupStart());
+    for (size_t i = 0; i < numDevices; ++i) {
+      gpuGuard.setDevice(data[i].get_device());
+      auto stream = THCState_getCurrentStream(THDGetCudaState());
+      NCCL_CHECK(ncclAllGather(offset(i, i * chunk), data[i].data_ptr(),
+                               chunk, dataType, localComms[i], stream));
+    }
+    NCCL_CHECK(ncclGroupEnd());
+  }
+
+  for (size_t i = 0; i < numDevices; ++i) {
+    gpuGuard.setDevice(data[i].get_device());
+    auto stream = THCState_getCurrentStream(THDGetCudaState());
+    THCudaCheck(cudaEventRecord((*events)[i], stream));
+  }
+
+  cudaFreeMutexLock.unlock();
+}
+
+
 void DataChannelNccl::allReduce(at::Tensor& data,
                                 THDReduceOp operation,
                                 THDGroup groupId) {
@@ -650,6 +884,17 @@ THDGroup DataChannelNccl::newGroup(const std::vector<rank_type>& ranks) {
 }
 
 
+THDGroup DataChannelNccl::newHierarchicalGroup(
+    const std::vector<rank_type>& ranks) {
+
+  auto groupId = newGroup(ranks);
+
+  std::unique_lock<std::mutex> channelLock(_mutex);
+  _hierarchicalGroups.insert(groupId);
+  return groupId;
+}
+
+
 // Helper function that checks if the given groupId is valid
 void DataChannelNccl::_checkGroupIdValid(THDGroup groupId) {
 
@@ -706,6 +951,152 @@ void DataChannelNccl::receive(at::Tensor& data, rank_type srcRank) {
 
 
 
+DataChannelNccl::RequestNcclStream::RequestNcclStream(
+    std::vector<std::pair<int, cudaEvent_t>>&& events,
+    std::vector<at::Tensor> tensors)
+  : _events(std::move(events))
+  , _tensors(std::move(tensors)) {}
+
+
+DataChannelNccl::RequestNcclStream::~RequestNcclStream() {
+  AutoGPU gpuGuard;
+  for (auto& devEvent : _events) {
+    gpuGuard.setDevice(devEvent.first);
+    // the tensors must outlive the collective
+    cudaEventSynchronize(devEvent.second);
+    cudaEventDestroy(devEvent.second);
+  }
+}
+
+
+bool DataChannelNccl::RequestNcclStream::isCompleted() {
+  AutoGPU gpuGuard;
+  for (auto& devEvent : _events) {
+    gpuGuard.setDevice(devEvent.first);
+    auto status = cudaEventQuery(devEvent.second);
+    if (status == cudaErrorNotReady)
+      return false;
+    THCudaCheck(status);
+  }
+  return true;
+}
+
+
+void DataChannelNccl::RequestNcclStream::wait() {
+  AutoGPU gpuGuard;
+  for (auto& devEvent : _events) {
+    gpuGuard.setDevice(devEvent.first);
+    THCudaCheck(cudaEventSynchronize(devEvent.second));
+  }
+}
+
+
+DataChannelNccl::RequestNccl* DataChannelNccl::_runOnCollectiveStreams(
+    std::vector<at::Tensor> tensors,
+    const std::function<void ()>& collective) {
+
+  auto state = THDGetCudaState();
+  // Guard GPU device
+  AutoGPU gpuGuard;
+
+  std::vector<int> devices;
+  for (auto& tensor : tensors) {
+    auto device = tensor.get_device();
+    if (std::find(devices.begin(), devices.end(), device) == devices.end())
+      devices.push_back(device);
+  }
+
+  // Make the collective streams wait for the work issued so far on the
+  // current streams, and make them current
+  std::vector<THCStream*> previousStreams;
+  for (auto device : devices) {
+    gpuGuard.setDevice(device);
+    THCStream* stream;
+    {
+      std::lock_guard<std::mutex> streamsLock(_collectiveStreamsMutex);
+      auto it = _collectiveStreams.find(device);
+      if (it == _collectiveStreams.end()) {
+        it = _collectiveStreams.emplace(
+            device, THCStream_new(cudaStreamNonBlocking)).first;
+      }
+      stream = it->second;
+    }
+    auto previous = THCState_getStream(state);
+    THCStream_retain(previous);
+    previousStreams.push_back(previous);
+
+    cudaEvent_t ready;
+    THCudaCheck(cudaEventCreateWithFlags(&ready, cudaEventDisableTiming));
+    THCudaCheck(cudaEventRecord(ready, previous->stream));
+    THCudaCheck(cudaStreamWaitEvent(stream->stream, ready, 0));
+    THCudaCheck(cudaEventDestroy(ready));
+    THCState_setStream(state, stream);
+  }
+
+  auto restoreStreams = [&]() {
+    for (size_t i = 0; i < devices.size(); ++i) {
+      gpuGuard.setDevice(devices[i]);
+      THCState_setStream(state, previousStreams[i]);
+      THCStream_free(previousStreams[i]);
+    }
+  };
+
+  try {
+    collective();
+  } catch (...) {
+    restoreStreams();
+    throw;
+  }
+
+  std::vector<std::pair<int, cudaEvent_t>> events;
+  for (auto device : devices) {
+    gpuGuard.setDevice(device);
+    cudaEvent_t done;
+    THCudaCheck(cudaEventCreateWithFlags(&done, cudaEventDisableTiming));
+    THCudaCheck(cudaEventRecord(done, THCState_getCurrentStream(state)));
+    events.emplace_back(device, done);
+  }
+  restoreStreams();
+
+  return new RequestNcclStream(std::move(events), std::move(tensors));
+}
+
+
+DataChannelNccl::RequestNccl* DataChannelNccl::iallReduce(
+    at::Tensor& data,
+    THDReduceOp operation,
+    THDGroup groupId) {
+
+  return _runOnCollectiveStreams({data}, [&]() {
+    allReduce(data, operation, groupId);
+  });
+}
+
+
+DataChannelNccl::RequestNccl* DataChannelNccl::ibroadcast(
+    at::Tensor& data,
+    rank_type srcRank,
+    THDGroup groupId) {
+
+  return _runOnCollectiveStreams({data}, [&]() {
+    broadcast(data, srcRank, groupId);
+  });
+}
+
+
+DataChannelNccl::RequestNccl* DataChannelNccl::iallGather(
+    std::vector<at::Tensor>& output,
+    at::Tensor& input,
+    THDGroup groupId) {
+
+  std::vector<at::Tensor> tensors(output);
+  tensors.push_back(input);
+  return _runOnCollectiveStreams(std::move(tensors), [&]() {
+    allGather(output, input, groupId);
+  });
+}
+
+
 DataChannelNccl::RequestNccl* DataChannelNccl::isend(at::Tensor& data,
                                                      rank_type dstRank) {
 
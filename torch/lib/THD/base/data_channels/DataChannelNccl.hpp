@@ -5,10 +5,12 @@
 
 #include <nccl.h>
 
+#include <functional>
 #include <utility>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 
@@ -24,6 +26,8 @@
 } while (0)
 
 
+struct THCStream;
+
 namespace thd {
 
 // Type aliasing
@@ -35,6 +39,26 @@ struct DataChannelNccl : DataChannel {
   // Nothing to implement
   struct RequestNccl : DataChannel::Request {};
 
+  /**
+   * Request of a collective issued on the collective streams, completed
+   * when its CUDA events are. It keeps the tensors of the collective alive,
+   * so that the caching allocator doesn't reuse their memory while the
+   * collective stream may still use it.
+   */
+  struct RequestNcclStream : RequestNccl {
+    RequestNcclStream(std::vector<std::pair<int, cudaEvent_t>>&& events,
+                      std::vector<at::Tensor> tensors);
+    virtual ~RequestNcclStream();
+
+    bool isCompleted() override;
+    void wait() override;
+
+  private:
+    // (device, event) pairs
+    std::vector<std::pair<int, cudaEvent_t>> _events;
+    std::vector<at::Tensor> _tensors;
+  };
+
   // Wrapper on the pair of NCCL resources
   class NcclResources {
 
@@ -78,9 +102,11 @@ struct DataChannelNccl : DataChannel {
 
   bool init() override;
   void destroy() override;
+  void rebuild(InitMethod::Config config) override;
 
   rank_type getRank() override;
   rank_type getNumProcesses() override;
+  rank_type getGroupSize(THDGroup group_id) override;
 
   void allReduce(std::vector<at::Tensor>& data,
                  THDReduceOp operation,
@@ -120,6 +146,16 @@ struct DataChannelNccl : DataChannel {
 
   THDGroup newGroup(const std::vector<rank_type>& ranks) override;
 
+  /**
+   * allReduce of a hierarchical group on several GPUs of each process first
+   * reduce-scatters the tensors between the local GPUs, then allreduces
+   * each slice across the processes on a communicator of its own, one per
+   * local GPU, and finally allgathers the slices between the local GPUs.
+   * Only 1 / (number of GPUs) of the data crosses the nodes on every GPU,
+   * and the slices use the inter-node links in parallel.
+   */
+  THDGroup newHierarchicalGroup(const std::vector<rank_type>& ranks) override;
+
   void clearGroupCache(THDGroup groupId = THDGroupWORLD) override;
 
   // Not supported functions
@@ -147,6 +183,24 @@ struct DataChannelNccl : DataChannel {
 
   RequestNccl* ireceive(at::Tensor& data, rank_type srcRank) override;
 
+  /**
+   * Non-blocking collectives are issued on a dedicated CUDA stream of each
+   * device (the collective stream), after the work already issued on the
+   * current streams, so that they overlap with the work issued later on the
+   * current streams.
+   */
+  RequestNccl* iallReduce(at::Tensor& data,
+                          THDReduceOp operation,
+                          THDGroup groupId = THDGroupWORLD) override;
+
+  RequestNccl* ibroadcast(at::Tensor& data,
+                          rank_type srcRank,
+                          THDGroup groupId = THDGroupWORLD) override;
+
+  RequestNccl* iallGather(std::vector<at::Tensor>& output,
+                          at::Tensor& input,
+                          THDGroup groupId = THDGroupWORLD) override;
+
 private:
 
   // Current process' rank
@@ -219,11 +273,37 @@ private:
   // Existing groups
   std::unordered_map<THDGroup, DataChannel::Group> _groups;
 
+  // Groups created with `newHierarchicalGroup`
+  std::unordered_set<THDGroup> _hierarchicalGroups;
+
+  /**
+   * Same as `_groupDevices` and `_groupNcclResources` for the hierarchical
+   * allReduce, where the communicator vector holds the intra-process
+   * communicators of the devices followed by the communicator of each
+   * device across the processes
+   */
+  std::unordered_map<THDGroup, std::string> _groupHierarchicalDevices;
+  std::unordered_map<THDGroup, NcclResources> _groupHierarchicalResources;
+
+  // Collective stream of each device, see `iallReduce`
+  std::unordered_map<int, THCStream*> _collectiveStreams;
+  std::mutex _collectiveStreamsMutex;
+
 
   // Helper function that gets the NCCL communicator
   NcclResourcePair _getNcclResourcePair(std::vector<at::Tensor>& input,
                                         THDGroup groupId);
 
+  // Helper function that gets the NCCL communicators of a hierarchical group
+  NcclResourcePair _getHierarchicalNcclResourcePair(
+      std::vector<at::Tensor>& input,
+      THDGroup groupId);
+
+  // Helper that runs the hierarchical allReduce, see `newHierarchicalGroup`
+  void _hierarchicalAllReduce(std::vector<at::Tensor>& data,
+                              THDReduceOp operation,
+                              THDGroup groupId);
+
   /**
    * Helper function that broadcasts the NCCL unique ID to everyone in the rank
    * NCCLID pointed by ncclId of Rank 0 will be sent to other ranks' NCCID
@@ -244,6 +324,16 @@ private:
 
   // Helper fucntion that destroys all the open sockets
   void _destroySockets();
+
+  // Helper function that connects rank 0 to all the other ranks
+  void _connectSockets(const InitMethod::Config& config);
+
+  /**
+   * Helper function that runs `collective` with the collective streams of
+   * the devices of `tensors` as the current streams
+   */
+  RequestNccl* _runOnCollectiveStreams(std::vector<at::Tensor> tensors,
+                                       const std::function<void ()>& collective);
 };
 
 } // namespace thd
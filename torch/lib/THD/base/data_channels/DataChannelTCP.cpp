@@ -28,6 +28,30 @@ inline std::uint32_t log2ceil(std::uint32_t value) {
   return dim;
 }
 
+// Messages of at least this size are allreduced with the ring algorithm,
+// smaller ones with recursive doubling.
+constexpr std::uint64_t RING_ALLREDUCE_THRESHOLD = 256 * 1024; // bytes
+// The chunks of the ring allreduce are sent in segments of this size, so
+// that a segment is reduced while the next ones are received.
+constexpr std::uint64_t RING_SEGMENT_BYTES = 1024 * 1024;
+
+// Number of sockets opened to every other process, read from this
+// environment variable (default 1). It must be the same on all processes.
+constexpr char TCP_STREAMS_ENV[] = "THD_TCP_STREAMS";
+// Tensors of at least this size are striped over all the sockets to the
+// destination; smaller ones only use the first socket.
+constexpr std::uint64_t STRIPE_THRESHOLD = 1024 * 1024; // bytes
+
+std::size_t getStreamsFromEnv() {
+  const char* value = std::getenv(TCP_STREAMS_ENV);
+  if (!value)
+    return 1;
+  long streams = std::strtol(value, nullptr, 10);
+  if (streams < 1)
+    throw std::invalid_argument(std::string(TCP_STREAMS_ENV) + " should be a positive integer");
+  return static_cast<std::size_t>(streams);
+}
+
 // Finds nearest power-of-two less than or equal to `value`.
 template<typename T>
 inline std::uint64_t pow2(T value) {
@@ -67,10 +91,17 @@ DataChannelTCP::DataChannelTCP(InitMethod::Config config, int timeout)
   : _socket(-1)
   , _port(0)
   , _timeout(timeout)
-  , _processes(config.world_size)
+  , _streams(getStreamsFromEnv())
   , _poll_events(nullptr)
 {
+  _configure(config);
+}
+
+
+void DataChannelTCP::_configure(const InitMethod::Config& config) {
   _rank = config.rank;
+  _processes.clear();
+  _processes.resize(config.world_size);
 
   if (_rank == 0) { // MASTER
     _socket = config.master.listen_socket;
@@ -100,16 +131,37 @@ DataChannelTCP::~DataChannelTCP() {
 
 
 void DataChannelTCP::destroy() {
- if (_socket != -1)
+  if (_socket != -1) {
     ::close(_socket);
+    _socket = -1;
+  }
 
-  for (const auto& process : _processes) {
-    if ((process.rank != _rank) && (process.socket != -1))
+  for (auto& process : _processes) {
+    if ((process.rank != _rank) && (process.socket != -1)) {
       ::close(process.socket);
+      process.socket = -1;
+    }
+    // stop the stripe threads before closing their sockets
+    process.stripe_send_workers.clear();
+    process.stripe_recv_workers.clear();
+    for (auto socket : process.stripe_sockets) {
+      if (socket != -1)
+        ::close(socket);
+    }
+    process.stripe_sockets.clear();
   }
 }
 
 
+void DataChannelTCP::rebuild(InitMethod::Config config) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _groups.clear();
+  _poll_events.reset();
+  _configure(config);
+  init();
+}
+
+
 bool DataChannelTCP::initWorker() {
   auto& master = _processes[0];
   master.socket = connect(master.address, master.port);
@@ -133,6 +185,9 @@ bool DataChannelTCP::initWorker() {
     };
   }
 
+  for (auto& process : _processes)
+    process.stripe_sockets.assign(_streams - 1, -1);
+
   /*
    * Firstly we are connecting to workers with rank lower than our rank,
    * then we accepting connections from other wokers with higher rank.
@@ -145,23 +200,19 @@ bool DataChannelTCP::initWorker() {
     auto& process = _processes[r];
     process.socket = connect(process.address, process.port);
 
-    // send rank to tell to the accepting process who we are
-    send_value<rank_type>(process.socket, _rank);
+    // send rank to tell to the accepting process who we are, and which of
+    // its sockets this is (0 is the first one, see `initStripes`)
+    send_value<rank_type>(process.socket, _rank, true);
+    send_value<std::uint64_t>(process.socket, 0);
   }
 
-  for (rank_type i = _rank + 1; i < _processes.size(); ++i) {
-    int socket;
-    std::tie(socket, std::ignore) = accept(_socket, _timeout);
-
-    // get rank of process we have just accepted
-    rank_type p_rank = recv_value<rank_type>(socket);
-    _processes[p_rank].socket = socket;
+  for (rank_type i = _rank + 1; i < _processes.size();) {
+    // processes that are done with this loop may already open their
+    // additional sockets, keep them for `initStripes`
+    if (_acceptConnection() == 0)
+      ++i;
   }
 
-  // close socket for listening, we will not use it anymore
-  ::close(_socket);
-  _socket = -1;
-
   return true;
 }
 
@@ -198,6 +249,9 @@ bool DataChannelTCP::initMaster() {
     };
   }
 
+  for (auto& process : _processes)
+    process.stripe_sockets.assign(_streams - 1, -1);
+
   // send informations about processes to all workers
   for (const auto& worker : _processes) {
     if (worker.rank == 0) continue;
@@ -211,17 +265,73 @@ bool DataChannelTCP::initMaster() {
     }
   }
 
-  // close socket for listening, we will not use it anymore
-  ::close(_socket);
-  _socket = -1;
-
   return true;
 }
 
 
+std::uint64_t DataChannelTCP::_acceptConnection() {
+  int socket;
+  std::tie(socket, std::ignore) = accept(_socket, _timeout);
+
+  // get rank of process we have just accepted, and which socket it is
+  rank_type p_rank = recv_value<rank_type>(socket);
+  auto index = recv_value<std::uint64_t>(socket);
+  auto& process = _processes.at(p_rank);
+  if (index == 0) {
+    process.socket = socket;
+  } else {
+    process.stripe_sockets.at(index - 1) = socket;
+  }
+  return index;
+}
+
+
+void DataChannelTCP::initStripes() {
+  auto stripes = _streams - 1;
+
+  // Same order as for the first sockets: connect to the lower ranks, then
+  // accept the connections of the higher ones.
+  for (rank_type r = 0; r < _rank; ++r) {
+    auto& process = _processes[r];
+    for (std::size_t i = 0; i < stripes; ++i) {
+      process.stripe_sockets[i] = connect(process.address, process.port);
+      send_value<rank_type>(process.stripe_sockets[i], _rank, true);
+      send_value<std::uint64_t>(process.stripe_sockets[i], i + 1);
+    }
+  }
+
+  // some of them may have been accepted in `initWorker` already
+  std::size_t missing = 0;
+  for (rank_type r = _rank + 1; r < _processes.size(); ++r) {
+    auto& sockets = _processes[r].stripe_sockets;
+    missing += std::count(sockets.begin(), sockets.end(), -1);
+  }
+  for (std::size_t n = 0; n < missing; ++n) {
+    if (_acceptConnection() == 0)
+      throw std::logic_error("unexpected connection while connecting stripes");
+  }
+
+  for (auto& process : _processes) {
+    if (process.rank == _rank)
+      continue;
+    for (std::size_t i = 0; i < stripes; ++i) {
+      process.stripe_send_workers.emplace_back(new QueueWorker());
+      process.stripe_recv_workers.emplace_back(new QueueWorker());
+    }
+  }
+}
+
+
 bool DataChannelTCP::init() {
   bool ok = (_rank == 0 ? initMaster() : initWorker());
   if (ok) {
+    if (_streams > 1)
+      initStripes();
+
+    // close socket for listening, we will not use it anymore
+    ::close(_socket);
+    _socket = -1;
+
     std::vector<rank_type> ranks;
     ranks.reserve(_processes.size());
     for (rank_type rank = 0; rank < _processes.size(); ++rank)
@@ -246,6 +356,10 @@ rank_type DataChannelTCP::getNumProcesses() {
   return _processes.size();
 }
 
+rank_type DataChannelTCP::getGroupSize(THDGroup group_id) {
+  return _groups.at(group_id).size();
+}
+
 
 void DataChannelTCP::allGather(std::vector<at::Tensor>& output,
                                at::Tensor& input, THDGroup group_id) {
@@ -363,11 +477,15 @@ void DataChannelTCP::scatter(std::vector<at::Tensor>& input,
 void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
                                THDGroup group_id) {
   /*
-   * Allreduce implementation is recursive doubling algorithm. It is good
-   * algorithm for small sizes of message but other (theoratically better)
-   * implementations could not be addapted because of non-commutative
-   * operations on tensors (operation cannot be commutative because this could
-   * introduce different numerical errors on different workers).
+   * Allreduce implementation is recursive doubling algorithm for small
+   * messages, and the ring algorithm (see `_ringAllReduce`) for large ones.
+   * Recursive doubling is good for small sizes of message, where latency
+   * dominates, but it sends the whole message log(p) times.
+   *
+   * Operations on tensors are not commutative numerically (a different
+   * order would introduce different numerical errors on different workers),
+   * so both algorithms make sure that every worker ends up with exactly the
+   * same result.
    *
    * More about efficiency can be found here:
    *   > http://www.mcs.anl.gov/~thakur/papers/ijhpca-coll.pdf (section 4.5)
@@ -387,6 +505,12 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
     return;
 
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  if (group.size() > 1 && tensor_bytes >= RING_ALLREDUCE_THRESHOLD &&
+      data.numel() >= static_cast<std::int64_t>(group.size())) {
+    _ringAllReduce(data, operation, group, group_rank);
+    return;
+  }
+
   auto tmp_tensor = data.clone();
 
   auto pof2 = pow2(group.size());
@@ -438,6 +562,122 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
 }
 
 
+void DataChannelTCP::_ringAllReduce(at::Tensor& data, THDReduceOp operation,
+                                    const DataChannel::Group& group,
+                                    rank_type group_rank) {
+  /*
+   * Ring allreduce: a reduce-scatter followed by an allgather, both going
+   * around the ring of the group. The data is split in `p` chunks; at step
+   * `s` of the reduce-scatter a process sends chunk `rank - s` to its right
+   * neighbour and reduces the chunk `rank - s - 1` received from its left
+   * one, so after `p - 1` steps it holds the fully reduced chunk
+   * `rank + 1`. The `p - 1` steps of the allgather pass the reduced chunks
+   * around the ring. Each process sends and receives 2 (p - 1) / p times
+   * the size of the data, which is bandwidth optimal.
+   *
+   * The chunk reduced (or received) at a step is the one sent at the next
+   * step, so it is sent segment by segment as soon as each segment is
+   * ready, and all the segments of a chunk are received in the background
+   * while the first ones are reduced. Every chunk is reduced along the same
+   * path on all processes and then copied, so they all get the same result.
+   *
+   * More about efficiency can be found here:
+   *   > http://www.mcs.anl.gov/~thakur/papers/ijhpca-coll.pdf (section 4.5)
+   */
+
+  if (!data.is_contiguous())
+    throw std::logic_error("tensor to allReduce is not contiguous");
+
+  const std::int64_t size = group.size();
+  auto flat = data.view({data.numel()});
+  const std::int64_t numel = flat.numel();
+  const std::int64_t segment_numel = std::max<std::int64_t>(
+      1, RING_SEGMENT_BYTES / data.type().elementSizeInBytes());
+
+  auto chunk_begin = [numel, size](std::int64_t chunk) {
+    return numel * chunk / size;
+  };
+  // Segments of a chunk, as (offset in the chunk, length)
+  auto segments = [&](std::int64_t chunk) {
+    std::vector<std::pair<std::int64_t, std::int64_t>> result;
+    auto length = chunk_begin(chunk + 1) - chunk_begin(chunk);
+    for (std::int64_t offset = 0; offset < length; offset += segment_numel)
+      result.emplace_back(offset, std::min(segment_numel, length - offset));
+    return result;
+  };
+  auto slice = [&](at::Tensor& tensor, std::int64_t chunk,
+                   const std::pair<std::int64_t, std::int64_t>& segment) {
+    return tensor.narrow(0, chunk_begin(chunk) + segment.first, segment.second);
+  };
+
+  auto left = group.mustGetGlobalRank((group_rank + size - 1) % size);
+  auto right = group.mustGetGlobalRank((group_rank + 1) % size);
+  auto chunk_at = [group_rank, size](std::int64_t step) {
+    return ((group_rank - step) % size + size) % size;
+  };
+
+  // Sends of each step (the steps of the allgather come after the ones of
+  // the reduce-scatter). The receives of the allgather overwrite chunks sent
+  // during the reduce-scatter, so these sends must be out first.
+  std::vector<std::vector<req_ptr>> sends(2 * (size - 1));
+  auto send_segment = [&](std::int64_t step, at::Tensor segment) {
+    sends.at(step).emplace_back(isend(segment, right));
+  };
+
+  // The first chunk sent is our own, untouched one
+  for (const auto& segment : segments(chunk_at(0)))
+    send_segment(0, slice(flat, chunk_at(0), segment));
+
+  auto max_chunk_numel = chunk_begin(1);
+  for (std::int64_t chunk = 1; chunk < size; ++chunk)
+    max_chunk_numel = std::max(max_chunk_numel,
+                               chunk_begin(chunk + 1) - chunk_begin(chunk));
+  auto recv_buffer = flat.type().tensor({max_chunk_numel});
+
+  // reduce-scatter
+  for (std::int64_t step = 0; step < size - 1; ++step) {
+    auto chunk = chunk_at(step + 1);
+    auto chunk_segments = segments(chunk);
+    std::vector<at::Tensor> received;
+    std::vector<req_ptr> receives;
+    for (const auto& segment : chunk_segments) {
+      received.push_back(recv_buffer.narrow(0, segment.first, segment.second));
+      receives.emplace_back(ireceive(received.back(), left));
+    }
+    for (std::size_t i = 0; i < chunk_segments.size(); ++i) {
+      receives[i]->wait();
+      auto reduced = slice(flat, chunk, chunk_segments[i]);
+      _reduce(reduced, received[i], operation);
+      send_segment(step + 1, reduced);
+    }
+  }
+
+  // allgather, the received chunks are already reduced
+  for (std::int64_t step = 0; step < size - 1; ++step) {
+    auto chunk = chunk_at(step);
+    for (auto& request : sends.at(step))
+      request->wait();
+    auto chunk_segments = segments(chunk);
+    std::vector<at::Tensor> received;
+    std::vector<req_ptr> receives;
+    for (const auto& segment : chunk_segments) {
+      received.push_back(slice(flat, chunk, segment));
+      receives.emplace_back(ireceive(received.back(), left));
+    }
+    for (std::size_t i = 0; i < chunk_segments.size(); ++i) {
+      receives[i]->wait();
+      // the last chunk received doesn't go any further
+      if (step < size - 2)
+        send_segment(size + step, received[i]);
+    }
+  }
+
+  for (auto& step_sends : sends)
+    for (auto& request : step_sends)
+      request->wait();
+}
+
+
 void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
                             rank_type dst_rank, THDGroup group_id) {
   /*
@@ -702,12 +942,14 @@ void DataChannelTCP::_send(const at::Tensor& data, rank_type dst_rank) {
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
   send_bytes<std::uint64_t>(process_dst.socket, &tensor_bytes, 1, true);
 
+  auto bytes = reinterpret_cast<std::uint8_t*>(data.data_ptr());
+  if (tensor_bytes >= STRIPE_THRESHOLD && !process_dst.stripe_sockets.empty()) {
+    _transferStriped(process_dst, bytes, tensor_bytes, true);
+    return;
+  }
+
   // send data (bytes)
-  send_bytes<std::uint8_t>(
-    process_dst.socket,
-    reinterpret_cast<const std::uint8_t*>(data.data_ptr()),
-    tensor_bytes
-  );
+  send_bytes<std::uint8_t>(process_dst.socket, bytes, tensor_bytes);
 }
 
 
@@ -759,7 +1001,12 @@ void DataChannelTCP::_receive(const at::Tensor& data, rank_type src_rank) {
   recv_bytes<std::uint64_t>(process_src.socket, &tensor_bytes, 1);
 
   std::uint64_t actual_tensor_bytes = data.type().elementSizeInBytes() * data.numel();
-  if (actual_tensor_bytes == tensor_bytes) {
+  bool striped = tensor_bytes >= STRIPE_THRESHOLD && !process_src.stripe_sockets.empty();
+  if (actual_tensor_bytes == tensor_bytes && striped) {
+    _transferStriped(process_src,
+                     reinterpret_cast<std::uint8_t*>(data.data_ptr()),
+                     tensor_bytes, false);
+  } else if (actual_tensor_bytes == tensor_bytes) {
     recv_bytes<std::uint8_t>(
       process_src.socket,
       reinterpret_cast<std::uint8_t*>(data.data_ptr()),
@@ -768,11 +1015,53 @@ void DataChannelTCP::_receive(const at::Tensor& data, rank_type src_rank) {
   } else {
     // remove invalid data from recv buffer
     std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[tensor_bytes]);
-    recv_bytes<std::uint8_t>(process_src.socket, bytes.get(), tensor_bytes);
+    if (striped) {
+      _transferStriped(process_src, bytes.get(), tensor_bytes, false);
+    } else {
+      recv_bytes<std::uint8_t>(process_src.socket, bytes.get(), tensor_bytes);
+    }
     throw std::logic_error("tensor sizes do not match");
   }
 }
 
+
+void DataChannelTCP::_transferStriped(const Process& process, std::uint8_t* bytes,
+                                      std::uint64_t length, bool send) {
+  /*
+   * The message is cut in one part per socket. The first part goes through
+   * the first socket from the calling thread, the others through the
+   * stripe sockets from their threads, so that all the sockets (and the
+   * NICs they are routed through) are used at once.
+   */
+  auto parts = process.stripe_sockets.size() + 1;
+  auto part_bytes = (length + parts - 1) / parts;
+  std::vector<QueueWorker::Request> requests;
+  requests.reserve(parts - 1);
+  for (std::size_t i = 1; i < parts; ++i) {
+    auto offset = std::min(i * part_bytes, length);
+    auto size = std::min(part_bytes, length - offset);
+    int socket = process.stripe_sockets[i - 1];
+    auto data = bytes + offset;
+    if (send) {
+      requests.push_back(process.stripe_send_workers[i - 1]->push([socket, data, size]() {
+        send_bytes<std::uint8_t>(socket, data, size);
+      }));
+    } else {
+      requests.push_back(process.stripe_recv_workers[i - 1]->push([socket, data, size]() {
+        recv_bytes<std::uint8_t>(socket, data, size);
+      }));
+    }
+  }
+
+  if (send) {
+    send_bytes<std::uint8_t>(process.socket, bytes, std::min(part_bytes, length));
+  } else {
+    recv_bytes<std::uint8_t>(process.socket, bytes, std::min(part_bytes, length));
+  }
+  for (auto& request : requests)
+    request.wait();
+}
+
 void DataChannelTCP::_reduce(at::Tensor& result, at::Tensor& data,
                              THDReduceOp operation) const {
   assertSameSizeAndType(result, data, "reduce");
@@ -793,9 +1082,28 @@ void DataChannelTCP::_reduce(at::Tensor& result, at::Tensor& data,
 void DataChannelTCP::allReduce(std::vector<at::Tensor>& data,
                                THDReduceOp operation,
                                THDGroup groupId) {
+  /*
+   * The tensors of this process are reduced into the first one, in order,
+   * which is allreduced with the other processes, and the result is copied
+   * back to the other tensors.
+   */
 
-  throw std::runtime_error("DataChannelTCP does not support mult-GPU cross "
-                           "node allreduce");
+  if (data.empty())
+    throw std::logic_error("allReduce: no tensors to reduce");
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    bool exists;
+    std::tie(std::ignore, exists) = _groups.at(groupId).getGroupRank(_rank);
+    if (!exists)
+      return;
+  }
+
+  for (std::size_t i = 1; i < data.size(); ++i)
+    _reduce(data[0], data[i], operation);
+  allReduce(data[0], operation, groupId);
+  for (std::size_t i = 1; i < data.size(); ++i)
+    data[i].copy_(data[0]);
 }
 
 
@@ -32,9 +32,11 @@ struct DataChannelTCP : DataChannel {
 
   bool init() override;
   void destroy() override;
+  void rebuild(InitMethod::Config config) override;
 
   rank_type getRank() override;
   rank_type getNumProcesses() override;
+  rank_type getGroupSize(THDGroup group_id) override;
 
   void allGather(std::vector<at::Tensor>& output,
                  std::vector<at::Tensor>& input,
@@ -82,23 +84,36 @@ private:
     std::string address;
     port_type port;
     int socket;
+    // Additional sockets big messages are striped over, each with its own
+    // sending and receiving thread (see THD_TCP_STREAMS)
+    std::vector<int> stripe_sockets;
+    std::vector<std::unique_ptr<QueueWorker>> stripe_send_workers;
+    std::vector<std::unique_ptr<QueueWorker>> stripe_recv_workers;
   };
 
+  void _configure(const InitMethod::Config& config);
   bool initMaster();
   bool initWorker();
+  void initStripes();
+  std::uint64_t _acceptConnection();
 
   void _send(const Scalar& data, rank_type dst_id);
   void _send(const at::Tensor& data, rank_type dst_id);
   void _receive(Scalar& data, rank_type src_id);
   void _receive(const at::Tensor& data, rank_type src_id);
+  void _transferStriped(const Process& process, std::uint8_t* bytes,
+                        std::uint64_t length, bool send);
   void _reduce(at::Tensor& result, at::Tensor& data,
                THDReduceOp operation) const;
+  void _ringAllReduce(at::Tensor& data, THDReduceOp operation,
+                      const DataChannel::Group& group, rank_type group_rank);
 
 
   rank_type _rank; // Rank of current process, range: [0.._processes.size()-1]
   int _socket; // Socket on which process is listening
   port_type _port; // Port on which process is listening
   int _timeout; // Accept waiting timeout in milliseconds (it is optional, default = infinity)
+  std::size_t _streams; // Number of sockets to every other process
 
   std::vector<Process> _processes; // Other processes in network
   std::unique_ptr<struct pollfd[]> _poll_events; // Events array for `poll`
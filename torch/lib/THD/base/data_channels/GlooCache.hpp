@@ -49,6 +49,11 @@ const int UNUSED_STREAM = -1;
 const rank_type UNUSED_RANK = -1;
 const std::size_t UNUSED_BYTES = 0;
 
+// Collectives on tensors at least this big run directly on the tensor's
+// memory when every process passes the same buffer twice in a row,
+// instead of copying it in and out of a buffer owned by the cache
+const std::size_t ZERO_COPY_MIN_BYTES = 1 << 22;
+
 // Forward declaration
 template<CollectiveType D, typename T>
 struct algorithm_spec;
@@ -108,6 +113,12 @@ struct GlooCache {
     return std::get<3>(t);
   }
 
+  // Non owning buffer pointing at the memory of a tensor
+  static std::shared_ptr<buffer_type> wrapBuffer(void* ptr) {
+    return std::shared_ptr<buffer_type>(static_cast<buffer_type*>(ptr),
+                                        [](buffer_type*) {});
+  }
+
 
   // NOTE: this function needs to be thread safe
   std::shared_ptr<context_type> createContext(
@@ -177,10 +188,71 @@ struct GlooCache {
     return it->second;
   }
 
+  /**
+   * Same as getAlgorithm, but for big tensors the returned algorithm may
+   * work on the memory of `t` itself, in which case memcpy_input and
+   * memcpy_output don't copy anything.
+   *
+   * The memory of a tensor is only registered once it is seen twice in a
+   * row for the same key on every process of the group, so that tensors
+   * allocated anew for every call don't recreate an algorithm each time.
+   * Algorithms are created collectively, so the processes first agree on
+   * what to use with an allreduce of a single int over the group.
+   */
+  template<CollectiveType D, typename T, typename... Args>
+  value_type getAlgorithmFor(at::Tensor& t, THDGroup group_id,
+                             const DataChannelGloo::Group& group,
+                             Args... args) {
+    auto key = gloo_cache::algorithm_spec<D, T>::key(group_id, args...);
+    if (std::get<4>(key) < gloo_cache::ZERO_COPY_MIN_BYTES) {
+      return getAlgorithm<D, T>(group_id, group, args...);
+    }
+
+    void* ptr = t.is_contiguous() ? t.data_ptr() : nullptr;
+    // 2: the registered algorithm works on ptr, 1: ptr is the same as in
+    // the previous call, 0: neither
+    int vote = 0;
+    std::size_t generation;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto& state = _zeroCopy[key];
+      if (ptr && ptr == state.bound) {
+        vote = 2;
+      } else if (ptr && ptr == state.last) {
+        vote = 1;
+      }
+      state.last = ptr;
+      generation = state.generation;
+    }
+
+    vote = agree(group_id, group, vote);
+    if (vote == 0) {
+      return getAlgorithm<D, T>(group_id, group, args...);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto& state = _zeroCopy[key];
+    if (vote == 1) {
+      lock.unlock();
+      auto algorithm = gloo_cache::algorithm_spec<D, T>::create(*this, group,
+              print_key(key) + "-zc" + std::to_string(generation),
+              wrapBuffer(ptr), std::forward<Args>(args)...);
+      lock.lock();
+
+      state.algorithm = std::move(algorithm);
+      state.bound = ptr;
+      state.generation = generation + 1;
+    }
+    return state.algorithm;
+  }
+
   static void memcpy_input(value_type& info, at::Tensor& t) {
     std::uint64_t tensor_bytes = t.type().elementSizeInBytes() * t.numel();
     auto t_dev = getDeviceType(t);
     auto input_buffer = GlooCache::input_buffer(info).get();
+    if (input_buffer == t.data_ptr()) {
+      return;
+    }
 
     if (t_dev == DeviceType::CPU) {
       std::memcpy(input_buffer, t.data_ptr(), tensor_bytes);
@@ -199,6 +271,9 @@ struct GlooCache {
     std::uint64_t tensor_bytes = t.type().elementSizeInBytes() * t.numel();
     auto t_dev = getDeviceType(t);
     auto output_buffer = GlooCache::output_buffer(info).get();
+    if (output_buffer == t.data_ptr()) {
+      return;
+    }
 
     if (t_dev == DeviceType::CPU) {
       std::memcpy(t.data_ptr(), output_buffer, tensor_bytes);
@@ -214,6 +289,18 @@ struct GlooCache {
   }
 
 private:
+  // Zero copy state of a key of getAlgorithmFor
+  struct ZeroCopyState {
+    void* last = nullptr;  // buffer passed in the previous call
+    void* bound = nullptr; // buffer the algorithm works on
+    value_type algorithm;
+    // number of algorithms created for the key, the same on every process
+    std::size_t generation = 0;
+  };
+
+  // Returns the minimum of value over the group
+  int agree(THDGroup group_id, const DataChannelGloo::Group& group, int value);
+
   std::string print_key(const key_type& k) {
     return std::to_string(static_cast<uint8_t>(std::get<0>(k))) + "-"
       + std::to_string(std::get<1>(k)) + "-"
@@ -232,6 +319,7 @@ private:
   std::mutex _mutex;
 
   std::unordered_map<key_type, value_type> _algorithms;
+  std::unordered_map<key_type, ZeroCopyState> _zeroCopy;
 };
 
 namespace gloo_cache {
@@ -307,9 +395,17 @@ struct algorithm_spec<CollectiveType::ALL_REDUCE, T> {
   static GlooCache::value_type create(GlooCache& cache,
     const DataChannelGloo::Group& group, const std::string& store_prefix,
     DeviceType device, std::size_t input_bytes, std::size_t count, THDReduceOp op
+  ) {
+    return create(cache, group, store_prefix, cache.createBuffer(input_bytes, device),
+                  device, input_bytes, count, op);
+  }
+
+  static GlooCache::value_type create(GlooCache& cache,
+    const DataChannelGloo::Group& group, const std::string& store_prefix,
+    std::shared_ptr<GlooCache::buffer_type> input_buffer,
+    DeviceType device, std::size_t input_bytes, std::size_t count, THDReduceOp op
   ) {
     auto context = cache.createContext(group, store_prefix);
-    auto input_buffer = cache.createBuffer(input_bytes, device);
 
     std::shared_ptr<GlooCache::algorithm_type> algo;
     if (device == DeviceType::CPU) {
@@ -377,9 +473,17 @@ struct algorithm_spec<CollectiveType::BROADCAST, T> {
   static GlooCache::value_type create(GlooCache& cache,
     const DataChannelGloo::Group& group, const std::string& store_prefix,
     DeviceType device, std::size_t input_bytes, std::size_t count, rank_type src_rank
+  ) {
+    return create(cache, group, store_prefix, cache.createBuffer(input_bytes, device),
+                  device, input_bytes, count, src_rank);
+  }
+
+  static GlooCache::value_type create(GlooCache& cache,
+    const DataChannelGloo::Group& group, const std::string& store_prefix,
+    std::shared_ptr<GlooCache::buffer_type> input_buffer,
+    DeviceType device, std::size_t input_bytes, std::size_t count, rank_type src_rank
   ) {
     auto context = cache.createContext(group, store_prefix);
-    auto input_buffer = cache.createBuffer(input_bytes, device);
 
     std::shared_ptr<GlooCache::algorithm_type> algo;
     if (device == DeviceType::CPU) {
@@ -452,4 +556,15 @@ struct algorithm_spec<CollectiveType::BARRIER, T> {
 
 } // namespace gloo_cache
 
+inline int GlooCache::agree(THDGroup group_id, const DataChannelGloo::Group& group,
+                            int value) {
+  auto ret = getAlgorithm<CollectiveType::ALL_REDUCE, int>(
+    group_id, group, DeviceType::CPU, sizeof(int), 1, THDReduceMIN);
+  std::lock_guard<std::mutex> lock(*GlooCache::mutex(ret));
+  auto buffer = reinterpret_cast<int*>(GlooCache::input_buffer(ret).get());
+  *buffer = value;
+  GlooCache::algorithm(ret)->run();
+  return *buffer;
+}
+
 } // namespace thd
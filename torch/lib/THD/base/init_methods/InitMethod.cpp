@@ -4,18 +4,20 @@ namespace thd {
 namespace init {
 
 InitMethod::Config initTCP(std::string argument, rank_type world_size,
-                           std::string group_name, int rank);
+                           std::string group_name, int rank, int min_world_size);
 InitMethod::Config initFile(std::string argument, rank_type world_size,
                             std::string group_name, int rank);
-InitMethod::Config initEnv(int world_size, std::string group_name, int rank);
+InitMethod::Config initEnv(int world_size, std::string group_name, int rank,
+                           int min_world_size);
 
 }
 
 InitMethod::Config getInitConfig(std::string argument, int world_size,
-                                 std::string group_name, int rank) {
+                                 std::string group_name, int rank,
+                                 int min_world_size) {
   InitMethod::Config config;
   if (argument.find("env://") == 0) {
-    config = init::initEnv(world_size, group_name, rank);
+    config = init::initEnv(world_size, group_name, rank, min_world_size);
   } else {
     rank_type r_world_size;
     try {
@@ -31,9 +33,13 @@ InitMethod::Config getInitConfig(std::string argument, int world_size,
 
     if (argument.find("tcp://") == 0) {
       argument.erase(0, 6); // chop "tcp://"
-      config = init::initTCP(argument, r_world_size, group_name, rank);
+      config = init::initTCP(argument, r_world_size, group_name, rank,
+                             min_world_size);
     } else if (argument.find("file://") == 0) {
       argument.erase(0, 7); // chop "file://"
+      if (min_world_size != -1)
+        throw std::invalid_argument("min_world_size is not supported in "
+                                    "file:// init method");
       config = init::initFile(argument, r_world_size, group_name, rank);
     }
   }
@@ -63,7 +63,16 @@ struct InitMethod {
   };
 };
 
+/*
+ * When `min_world_size` is set, the rendezvous is elastic: `world_size` is
+ * only the maximum, and it completes as soon as `min_world_size` processes
+ * joined and no more of them came in THD_JOIN_TIMEOUT milliseconds. The
+ * master has to be given rank 0, the other processes are ranked in the order
+ * they joined, whatever rank they were given. Supported by `env://` and
+ * `tcp://` with a master address (not by multicast or `file://`).
+ */
 InitMethod::Config getInitConfig(std::string argument, int world_size = -1,
-                                 std::string group_name = "", int rank = -1);
+                                 std::string group_name = "", int rank = -1,
+                                 int min_world_size = -1);
 
 } // namespace thd
@@ -8,6 +8,7 @@ namespace {
 
 constexpr char RANK_ENV[] = "RANK";
 constexpr char WORLD_SIZE_ENV[] = "WORLD_SIZE";
+constexpr char MIN_WORLD_SIZE_ENV[] = "MIN_WORLD_SIZE";
 constexpr char MASTER_PORT_ENV[] = "MASTER_PORT";
 constexpr char MASTER_ADDR_ENV[] = "MASTER_ADDR";
 
@@ -43,17 +44,36 @@ rank_type maybeLoadEnv(const char* env_name, int value, std::string parameter_na
 
 } // anonymous namespace
 
-InitMethod::Config initEnv(int world_size, std::string group_name, int rank) {
+InitMethod::Config initEnv(int world_size, std::string group_name, int rank,
+                           int min_world_size) {
   InitMethod::Config config;
 
   config.rank = maybeLoadEnv(RANK_ENV, rank, "rank");
   config.world_size = maybeLoadEnv(WORLD_SIZE_ENV, world_size, "world_size");
+  if (std::getenv(MIN_WORLD_SIZE_ENV) != nullptr || min_world_size != -1) {
+    min_world_size = maybeLoadEnv(MIN_WORLD_SIZE_ENV, min_world_size, "min_world_size");
+  }
 
   if (group_name != "") {
     throw std::runtime_error("group_name is not supported in env:// init method");
   }
 
-  if (config.rank == 0) {
+  if (min_world_size != -1) {
+    if (min_world_size < 1 || min_world_size > config.world_size)
+      throw std::invalid_argument("min_world_size should be in range [1, world_size]");
+
+    if (config.rank == 0) {
+      config.master.listen_port = convertToPort(std::stoul(mustGetEnv(MASTER_PORT_ENV)));
+      std::tie(config.master.listen_socket, std::ignore) = listen(config.master.listen_port);
+      std::tie(config.public_address, config.world_size) =
+        discoverWorkersElastic(config.master.listen_socket, min_world_size,
+                               config.world_size);
+    } else {
+      std::tie(config.worker.master_addr, config.worker.master_port) = loadWorkerEnv();
+      std::tie(config.public_address, config.rank, config.world_size) =
+        discoverMasterElastic(config.worker.master_addr, config.worker.master_port);
+    }
+  } else if (config.rank == 0) {
     config.master.listen_port = convertToPort(std::stoul(mustGetEnv(MASTER_PORT_ENV)));
     std::tie(config.master.listen_socket, std::ignore) = listen(config.master.listen_port);
     config.public_address = discoverWorkers(config.master.listen_socket,
@@ -207,7 +207,8 @@ std::vector<MulticastMessage> getMessages(struct sockaddr* addr, rank_type world
 
 
 InitMethod::Config initTCPMaster(std::string address, std::string str_port,
-                                 rank_type world_size, int assigned_rank) {
+                                 rank_type world_size, int assigned_rank,
+                                 int min_world_size) {
   InitMethod::Config config;
   if (assigned_rank == -1) {
     throw std::invalid_argument("tcp:// method with non-multicast addresses "
@@ -217,7 +218,22 @@ InitMethod::Config initTCPMaster(std::string address, std::string str_port,
   config.rank = convertToRank(assigned_rank);
   config.world_size = world_size;
   auto port = convertToPort(std::stoul(str_port));
-  if (config.rank == 0) {
+  if (min_world_size != -1) {
+    if (min_world_size < 1 || min_world_size > world_size)
+      throw std::invalid_argument("min_world_size should be in range [1, world_size]");
+
+    if (config.rank == 0) {
+      config.master.listen_port = port;
+      std::tie(config.master.listen_socket, std::ignore) = listen(port);
+      std::tie(config.public_address, config.world_size) =
+        discoverWorkersElastic(config.master.listen_socket, min_world_size, world_size);
+    } else {
+      config.worker.master_addr = address;
+      config.worker.master_port = port;
+      std::tie(config.public_address, config.rank, config.world_size) =
+        discoverMasterElastic(address, port);
+    }
+  } else if (config.rank == 0) {
     config.master.listen_port = port;
     std::tie(config.master.listen_socket, std::ignore) = listen(port);
     config.public_address = discoverWorkers(config.master.listen_socket, world_size);
@@ -298,7 +314,7 @@ InitMethod::Config initTCPMulticast(std::string group_name, rank_type world_size
 } // anonymous namespace
 
 InitMethod::Config initTCP(std::string argument, rank_type world_size,
-                           std::string group_name, int rank) {
+                           std::string group_name, int rank, int min_world_size) {
   // Parse arguments
   std::string address, str_port;
   std::tie(address, str_port) = splitAddress(argument);
@@ -316,9 +332,13 @@ InitMethod::Config initTCP(std::string argument, rank_type world_size,
     if (head->ai_family != AF_INET && head->ai_family != AF_INET6) continue;
     try {
       if (isMulticastAddress(head->ai_addr)) {
+        if (min_world_size != -1)
+          throw std::invalid_argument("min_world_size is not supported with "
+                                      "multicast tcp:// init method");
         return initTCPMulticast(group_name, world_size, rank, head->ai_addr);
       } else {
-        return initTCPMaster(address, str_port, world_size, rank);
+        return initTCPMaster(address, str_port, world_size, rank,
+                             min_world_size);
       }
     } catch (std::exception &e) {
       if (!head->ai_next) throw;
@@ -6,12 +6,28 @@
 #include <net/if.h>
 #include <ifaddrs.h>
 
+#include <chrono>
+#include <cstdlib>
 #include <tuple>
 
 namespace thd {
 
 namespace {
 
+// Milliseconds the elastic rendezvous waits for more processes once
+// `min_world_size` of them joined (default 30 seconds).
+constexpr char JOIN_TIMEOUT_ENV[] = "THD_JOIN_TIMEOUT";
+
+int getJoinTimeoutFromEnv() {
+  const char* value = std::getenv(JOIN_TIMEOUT_ENV);
+  if (!value)
+    return 30000;
+  long timeout = std::strtol(value, nullptr, 10);
+  if (timeout < 0)
+    throw std::invalid_argument(std::string(JOIN_TIMEOUT_ENV) + " should be a non-negative integer");
+  return static_cast<int>(timeout);
+}
+
 void sendPeerName(int socket) {
   struct sockaddr_storage master_addr;
   socklen_t master_addr_len = sizeof(master_addr);
@@ -61,6 +77,61 @@ std::string discoverWorkers(int listen_socket, rank_type world_size) {
   return public_addr;
 }
 
+std::pair<std::string, rank_type>
+discoverWorkersElastic(int listen_socket, rank_type min_world_size,
+                       rank_type max_world_size) {
+  using namespace std::chrono;
+  const int join_timeout = getJoinTimeoutFromEnv();
+  auto deadline = steady_clock::now() + milliseconds(join_timeout);
+
+  std::vector<int> sockets;
+  ResourceGuard sockets_guard([&sockets]() {
+    for (auto socket : sockets)
+      ::close(socket);
+  });
+
+  std::string public_addr;
+  while (sockets.size() + 1 < max_world_size) {
+    bool enough = sockets.size() + 1 >= min_world_size;
+    int timeout = -1;
+    if (enough) {
+      auto left = duration_cast<milliseconds>(deadline - steady_clock::now());
+      if (left.count() <= 0)
+        break;
+      timeout = static_cast<int>(left.count());
+    }
+
+    int socket;
+    try {
+      std::tie(socket, std::ignore) = accept(listen_socket, timeout);
+    } catch (const std::exception& e) {
+      if (enough) break;
+      throw;
+    }
+
+    // A process which went away before finishing the handshake doesn't
+    // join, the next one can take its place.
+    try {
+      sendPeerName(socket);
+      public_addr = recv_string(socket);
+    } catch (const std::exception& e) {
+      ::close(socket);
+      continue;
+    }
+    sockets.push_back(socket);
+
+    if (sockets.size() + 1 == min_world_size)
+      deadline = steady_clock::now() + milliseconds(join_timeout);
+  }
+
+  rank_type world_size = sockets.size() + 1;
+  for (rank_type i = 0; i < sockets.size(); ++i) {
+    send_value<rank_type>(sockets[i], i + 1, true);
+    send_value<rank_type>(sockets[i], world_size);
+  }
+  return std::make_pair(public_addr, world_size);
+}
+
 std::pair<std::string, std::string> discoverMaster(std::vector<std::string> addresses, port_type port) {
   // try to connect to address via any of the addresses
   std::string master_address = "";
@@ -83,4 +154,18 @@ std::pair<std::string, std::string> discoverMaster(std::vector<std::string> addr
   return std::make_pair(master_address, my_address);
 }
 
+std::tuple<std::string, rank_type, rank_type>
+discoverMasterElastic(const std::string& address, port_type port) {
+  // the master may still be tearing down the previous channel, so keep
+  // retrying until it listens again
+  int socket = connect(address, port, true);
+  ResourceGuard socket_guard([socket]() { ::close(socket); });
+  sendPeerName(socket);
+  std::string my_address = recv_string(socket);
+  rank_type rank = recv_value<rank_type>(socket);
+  rank_type world_size = recv_value<rank_type>(socket);
+
+  return std::make_tuple(my_address, rank, world_size);
+}
+
 }
@@ -3,6 +3,7 @@
 #include "../ChannelUtils.hpp"
 
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace thd {
@@ -11,8 +12,24 @@ std::vector<std::string> getInterfaceAddresses();
 
 std::string discoverWorkers(int listen_socket, rank_type world_size);
 
+/*
+ * Elastic variant of `discoverWorkers`: accepts between `min_world_size` and
+ * `max_world_size` processes (master included). Once enough processes joined,
+ * others are only waited for as long as the join timeout (THD_JOIN_TIMEOUT).
+ * Workers are given ranks in the order they joined.
+ *
+ * Returns pair of public_address, world_size.
+ */
+std::pair<std::string, rank_type>
+discoverWorkersElastic(int listen_socket, rank_type min_world_size,
+                       rank_type max_world_size);
+
 // pair of master_address, my_address
 std::pair<std::string, std::string>
 discoverMaster(std::vector<std::string> addresses, port_type port);
 
+// tuple of my_address, rank, world_size assigned by `discoverWorkersElastic`
+std::tuple<std::string, rank_type, rank_type>
+discoverMasterElastic(const std::string& address, port_type port);
+
 } // namespace thd
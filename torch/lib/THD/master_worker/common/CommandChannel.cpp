@@ -2,7 +2,10 @@
 #include "Functions.hpp"
 #include "../../base/ChannelUtils.hpp"
 
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
 #include <climits>
 #include <cstdlib>
 #include <cstring>
@@ -16,28 +19,51 @@
 namespace thd {
 namespace {
 
-void sendMessage(int socket, std::unique_ptr<rpc::RPCMessage> msg) {
-  auto& bytes = msg.get()->bytes();
-  std::uint64_t msg_length = static_cast<std::uint64_t>(bytes.length());
-
-  send_bytes<std::uint64_t>(socket, &msg_length, 1, true);
-  send_bytes<std::uint8_t>(
-    socket,
-    reinterpret_cast<const std::uint8_t*>(bytes.data()),
-    msg_length
-  );
-}
-
-std::unique_ptr<rpc::RPCMessage> receiveMessage(int socket) {
-  std::uint64_t msg_length;
-  recv_bytes<std::uint64_t>(socket, &msg_length, 1);
-
-  std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[msg_length]);
-  recv_bytes<std::uint8_t>(socket, bytes.get(), msg_length);
+// Size of the worker's receive buffer; bigger messages are read directly
+constexpr std::size_t RECV_BUFFER_SIZE = 64 * 1024;
+// `sendMessage` blocks when this many bytes are waiting for a worker
+constexpr std::size_t MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+// Writes the messages, each preceded by its length, gathering them straight
+// from their buffers.
+void sendMessages(int socket, const std::vector<std::unique_ptr<rpc::RPCMessage>>& msgs) {
+  std::vector<std::uint64_t> lengths(msgs.size());
+  std::vector<struct iovec> iov;
+  iov.reserve(2 * msgs.size());
+  for (std::size_t i = 0; i < msgs.size(); ++i) {
+    auto& bytes = msgs[i]->bytes();
+    lengths[i] = static_cast<std::uint64_t>(bytes.length());
+    iov.push_back({&lengths[i], sizeof(std::uint64_t)});
+    if (lengths[i] > 0)
+      iov.push_back({const_cast<char*>(bytes.data()), bytes.length()});
+  }
 
-  return std::unique_ptr<rpc::RPCMessage>(
-    new rpc::RPCMessage(reinterpret_cast<char*>(bytes.get()), msg_length)
-  );
+  std::size_t first = 0;
+  while (first < iov.size()) {
+    struct msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov[first];
+    header.msg_iovlen = std::min<std::size_t>(iov.size() - first, IOV_MAX);
+
+    ssize_t bytes_sent;
+    SYSCHECK(bytes_sent = ::sendmsg(socket, &header, 0))
+    if (bytes_sent == 0)
+      throw std::system_error(ECONNRESET, std::system_category());
+
+    // skip what has been sent, the last buffer may be sent partially
+    std::size_t left = bytes_sent;
+    while (left > 0) {
+      auto& buffer = iov[first];
+      if (left >= buffer.iov_len) {
+        left -= buffer.iov_len;
+        ++first;
+      } else {
+        buffer.iov_base = static_cast<char*>(buffer.iov_base) + left;
+        buffer.iov_len -= left;
+        left = 0;
+      }
+    }
+  }
 }
 
 } // anonymous namespace
@@ -48,7 +74,8 @@ MasterCommandChannel::MasterCommandChannel(InitMethod::Config config)
   , _poll_events(nullptr)
   , _error_pipe(-1)
   , _error(nullptr)
-  , _mutexes(config.world_size)
+  , _outboxes(config.world_size)
+  , _stop_sender(false)
 {
   _sockets[0] = config.master.listen_socket;
 }
@@ -64,15 +91,26 @@ MasterCommandChannel::~MasterCommandChannel() {
   }
 
   auto world_size = _sockets.size();
-  for (std::size_t i = 0; i < world_size; ++i) {
-    auto socket = _sockets[i];
-    if (socket == -1) continue;
-    try {
-      sendMessage(rpc::packMessage(Functions::exit), i);
-    } catch(...) {}
-    ::close(socket);
+  if (_sender_thread.joinable()) {
+    for (std::size_t i = 1; i < world_size; ++i) {
+      try {
+        sendMessage(rpc::packMessage(Functions::exit), i);
+      } catch(...) {}
+    }
+
+    // the sender sends everything that is left before exiting
+    {
+      std::lock_guard<std::mutex> lock(_outbox_mutex);
+      _stop_sender = true;
+    }
+    _outbox_changed.notify_all();
+    _sender_thread.join();
   }
 
+  for (std::size_t i = 0; i < world_size; ++i) {
+    if (_sockets[i] != -1)
+      ::close(_sockets[i]);
+  }
 }
 
 bool MasterCommandChannel::init() {
@@ -100,6 +138,7 @@ bool MasterCommandChannel::init() {
   _sockets[0] = fd[0];
   _error_pipe = fd[1];
   _error_thread = std::thread(&MasterCommandChannel::errorHandler, this);
+  _sender_thread = std::thread(&MasterCommandChannel::sender, this);
   return true;
 }
 
@@ -116,18 +155,92 @@ void MasterCommandChannel::errorHandler() {
   }
 }
 
-void MasterCommandChannel::sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank) {
+void MasterCommandChannel::checkErrors() {
   // Throw error received from a worker.
   if (_error) {
     throw std::runtime_error(*_error);
   }
+  if (_send_error) {
+    throw std::runtime_error(*_send_error);
+  }
+}
 
+void MasterCommandChannel::sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank) {
   if ((rank <= 0) || (rank >= _sockets.size())) {
     throw std::domain_error("sendMessage received invalid rank as parameter");
   }
 
-  std::lock_guard<std::mutex> guard(_mutexes[rank]);
-  ::thd::sendMessage(_sockets[rank], std::move(msg));
+  std::unique_lock<std::mutex> lock(_outbox_mutex);
+  checkErrors();
+  auto& outbox = _outboxes[rank];
+  // don't let the queue grow without bounds when the worker is slow
+  _outbox_changed.wait(lock, [this, &outbox] {
+    return outbox.bytes < MAX_QUEUED_BYTES || _send_error;
+  });
+  checkErrors();
+
+  outbox.bytes += msg->bytes().length();
+  outbox.messages.push_back(std::move(msg));
+  lock.unlock();
+  _outbox_changed.notify_all();
+}
+
+void MasterCommandChannel::flush(int rank) {
+  if ((rank <= 0) || (rank >= _sockets.size())) {
+    throw std::domain_error("flush received invalid rank as parameter");
+  }
+
+  std::unique_lock<std::mutex> lock(_outbox_mutex);
+  auto& outbox = _outboxes[rank];
+  _outbox_changed.wait(lock, [this, &outbox] {
+    return (outbox.messages.empty() && !outbox.busy) || _send_error;
+  });
+  checkErrors();
+}
+
+void MasterCommandChannel::sender() {
+  std::unique_lock<std::mutex> lock(_outbox_mutex);
+  std::size_t next = 1;
+  while (true) {
+    // take the messages of the next worker which has some, round robin
+    std::size_t rank = 0;
+    for (std::size_t i = 0; i < _outboxes.size() - 1; ++i) {
+      auto candidate = 1 + (next - 1 + i) % (_outboxes.size() - 1);
+      if (!_outboxes[candidate].messages.empty()) {
+        rank = candidate;
+        break;
+      }
+    }
+
+    if (rank == 0) {
+      if (_stop_sender || _send_error)
+        return;
+      _outbox_changed.wait(lock);
+      continue;
+    }
+
+    auto& outbox = _outboxes[rank];
+    auto batch = std::move(outbox.messages);
+    outbox.messages.clear();
+    outbox.bytes = 0;
+    outbox.busy = true;
+    next = rank + 1;
+    lock.unlock();
+
+    std::string error;
+    try {
+      sendMessages(_sockets[rank], batch);
+    } catch (const std::exception& e) {
+      error = "error (rank " + std::to_string(rank) + "): send: " + e.what();
+    }
+    batch.clear();
+
+    lock.lock();
+    outbox.busy = false;
+    if (!error.empty() && !_send_error)
+      _send_error.reset(new std::string(error));
+    _outbox_changed.notify_all();
+  }
 }
 
 std::tuple<rank_type, std::string> MasterCommandChannel::recvError() {
@@ -181,6 +294,9 @@ std::tuple<rank_type, std::string> MasterCommandChannel::recvError() {
 WorkerCommandChannel::WorkerCommandChannel(InitMethod::Config config)
   : _rank(config.rank)
   , _socket(-1)
+  , _buffer(new char[RECV_BUFFER_SIZE])
+  , _buffer_begin(0)
+  , _buffer_end(0)
   , _master_addr(config.worker.master_addr)
   , _master_port(config.worker.master_port)
 {}
@@ -199,8 +315,42 @@ bool WorkerCommandChannel::init() {
   return true;
 }
 
+void WorkerCommandChannel::recvBuffered(void* dst, std::size_t length) {
+  auto bytes = static_cast<char*>(dst);
+  while (length > 0) {
+    if (_buffer_begin == _buffer_end) {
+      if (length >= RECV_BUFFER_SIZE) {
+        // don't copy big messages through the buffer
+        recv_bytes<char>(_socket, bytes, length);
+        return;
+      }
+
+      ssize_t bytes_received;
+      SYSCHECK(bytes_received = ::recv(_socket, _buffer.get(), RECV_BUFFER_SIZE, 0))
+      if (bytes_received == 0)
+        throw std::system_error(ECONNRESET, std::system_category());
+      _buffer_begin = 0;
+      _buffer_end = bytes_received;
+    }
+
+    auto chunk = std::min(length, _buffer_end - _buffer_begin);
+    std::memcpy(bytes, _buffer.get() + _buffer_begin, chunk);
+    _buffer_begin += chunk;
+    bytes += chunk;
+    length -= chunk;
+  }
+}
+
 std::unique_ptr<rpc::RPCMessage> WorkerCommandChannel::recvMessage() {
-  return ::thd::receiveMessage(_socket);
+  std::uint64_t msg_length;
+  recvBuffered(&msg_length, sizeof(msg_length));
+
+  std::unique_ptr<char[]> bytes(new char[msg_length]);
+  recvBuffered(bytes.get(), msg_length);
+
+  return std::unique_ptr<rpc::RPCMessage>(
+    new rpc::RPCMessage(bytes.get(), msg_length)
+  );
 }
 
 void WorkerCommandChannel::sendError(const std::string& error) {
@@ -4,6 +4,8 @@
 
 #include <sys/poll.h>
 #include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -19,11 +21,31 @@ struct MasterCommandChannel {
 
   bool init();
 
+  /*
+   * Queues the message for the worker and returns without waiting for it to
+   * be sent. A sending thread writes the messages queued for a worker in
+   * batches, with a single `sendmsg` pointing at their buffers, so commands
+   * issued while the previous batch was being sent share one write.
+   */
   void sendMessage(std::unique_ptr<rpc::RPCMessage> msg, int rank);
+  // Waits until all the messages queued for the worker have been sent. It
+  // has to be called before waiting for any data from the worker.
+  void flush(int rank);
 
 private:
+  // Messages waiting to be sent to a worker
+  struct Outbox {
+    Outbox() : bytes(0), busy(false) {}
+
+    std::vector<std::unique_ptr<rpc::RPCMessage>> messages;
+    std::size_t bytes;
+    bool busy; // a batch of this worker is being sent
+  };
+
   std::tuple<rank_type, std::string> recvError();
   void errorHandler();
+  void sender();
+  void checkErrors();
 
   rank_type _rank;
   std::vector<int> _sockets;
@@ -32,7 +54,13 @@ private:
   int _error_pipe; // informs error handler thread that we are exiting
   std::unique_ptr<std::string> _error;
   std::thread _error_thread;
-  std::vector<std::mutex> _mutexes;
+
+  std::vector<Outbox> _outboxes;
+  std::mutex _outbox_mutex;
+  std::condition_variable _outbox_changed;
+  bool _stop_sender;
+  std::unique_ptr<std::string> _send_error;
+  std::thread _sender_thread;
 };
 
 struct WorkerCommandChannel {
@@ -45,8 +73,15 @@ struct WorkerCommandChannel {
   void sendError(const std::string& error);
 
 private:
+  void recvBuffered(void* dst, std::size_t length);
+
   rank_type _rank;
   int _socket;
+  // Messages are read from the socket in big chunks, several at once when
+  // the master sent a batch of them
+  std::unique_ptr<char[]> _buffer;
+  std::size_t _buffer_begin;
+  std::size_t _buffer_end;
 
   std::string _master_addr;
   port_type _master_port;
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "process_group/General.hpp"
+#include "Master.hpp"
 
 template<typename T>
 T receiveValueFromWorker(int worker_id) {
+  // the worker can only answer once it got the command
+  thd::master::masterCommandChannel->flush(worker_id);
   thd::RPCType type = thd::type_traits<T>::type;
   if (thd::isInteger(type)) {
     thd::IntScalar wrapped_value;
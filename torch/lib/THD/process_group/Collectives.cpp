@@ -27,6 +27,17 @@ void THDAllReduce(THDTensorDescriptor& desc, THDReduceOp operation, THDGroup gro
   dataChannel->allReduce(desc, operation, group);
 }
 
+THDRequest* THDIallReduce(THDTensorDescriptor& desc, THDReduceOp operation,
+                          THDGroup group) {
+  return dataChannel->iallReduce(desc, operation, group);
+}
+
+THDTensorDescriptor THDAllReduceSparse(THDTensorDescriptor& desc,
+                                       double density_threshold,
+                                       THDGroup group) {
+  return dataChannel->allReduceSparse(desc, density_threshold, group);
+}
+
 void THDReduceMultiGPU(THDTensorDescriptor* desc,
                        size_t len,
                        THDReduceOp operation,
@@ -53,6 +64,10 @@ void THDBroadcast(THDTensorDescriptor& desc, int src_rank, THDGroup group) {
   dataChannel->broadcast(desc, convertToRank(src_rank), group);
 }
 
+THDRequest* THDIbroadcast(THDTensorDescriptor& desc, int src_rank, THDGroup group) {
+  return dataChannel->ibroadcast(desc, convertToRank(src_rank), group);
+}
+
 THDRequest* THDIsend(THDTensorDescriptor& desc, int dst_rank) {
   return dataChannel->isend(desc, convertToRank(dst_rank));
 }
@@ -89,6 +104,12 @@ void THDAllGather(THDTensorDescriptor* output, size_t len,
   dataChannel->allGather(v_output, input, group);
 }
 
+THDRequest* THDIallGather(THDTensorDescriptor* output, size_t len,
+                          THDTensorDescriptor& input, THDGroup group) {
+  std::vector<at::Tensor> v_output(output, output + len);
+  return dataChannel->iallGather(v_output, input, group);
+}
+
 void THDGatherSend(THDTensorDescriptor& input, int dst_rank, THDGroup group) {
   std::vector<at::Tensor> v_output;
   dataChannel->gather(v_output, input, convertToRank(dst_rank), group);
@@ -127,6 +148,15 @@ THDGroup THDNewGroup(const int *ranks, size_t len) {
   return dataChannel->newGroup(v_ranks);
 }
 
+THDGroup THDNewHierarchicalGroup(const int *ranks, size_t len) {
+  std::vector<rank_type> v_ranks(len);
+  for (std::size_t i = 0; i < len; ++i) {
+    v_ranks[i] = convertToRank(ranks[i]);
+  }
+
+  return dataChannel->newHierarchicalGroup(v_ranks);
+}
+
 bool THDRequest_isCompleted(THDRequest* request) {
   return request->isCompleted();
 }
@@ -3,6 +3,12 @@
 #include "../THD.h"
 #include "../base/DataChannel.h"
 
+enum THDCompression {
+  THDCompressionFP16 = 0,
+  THDCompressionTOPK,
+  THDCompressionSIGN,
+};
+
 THD_API int THDGetRank();
 THD_API int THDGetNumProcesses();
 THD_API void THDAllReduceMultiGPU(THDTensorDescriptor* data,
@@ -11,6 +17,26 @@ THD_API void THDAllReduceMultiGPU(THDTensorDescriptor* data,
                                   THDGroup group);
 THD_API void THDAllReduce(THDTensorDescriptor& desc, THDReduceOp operation,
                           THDGroup group);
+THD_API THDRequest* THDIallReduce(THDTensorDescriptor& desc,
+                                  THDReduceOp operation, THDGroup group);
+/*
+ * Sums `desc` over the group, compressing it for the transport. `residual`
+ * keeps what the compression dropped, and is added back in the next call
+ * (see Compression.hpp); it may be an undefined tensor.
+ */
+THD_API void THDAllReduceCompressed(THDTensorDescriptor& desc,
+                                    THDTensorDescriptor& residual,
+                                    THDCompression compression,
+                                    double ratio,
+                                    THDGroup group);
+/*
+ * Sums a sparse tensor over the group and returns the result, which is
+ * dense when the gathered entries cover at least `density_threshold` of
+ * the tensor.
+ */
+THD_API THDTensorDescriptor THDAllReduceSparse(THDTensorDescriptor& desc,
+                                               double density_threshold,
+                                               THDGroup group);
 THD_API void THDReduceMultiGPU(THDTensorDescriptor* desc,
                                size_t len,
                                THDReduceOp operation,
@@ -23,6 +49,8 @@ THD_API void THDBroadcastMultiGPU(THDTensorDescriptor* desc,
                                   int src_rank,
                                   THDGroup group);
 THD_API void THDBroadcast(THDTensorDescriptor& desc, int src_rank, THDGroup group);
+THD_API THDRequest* THDIbroadcast(THDTensorDescriptor& desc, int src_rank,
+                                  THDGroup group);
 THD_API THDRequest* THDIsend(THDTensorDescriptor& desc, int dst_rank);
 THD_API THDRequest* THDIrecv(THDTensorDescriptor& desc, int src_rank);
 THD_API void THDSend(THDTensorDescriptor& desc, int dst_rank);
@@ -35,6 +63,8 @@ THD_API void THDAllGatherMultiGPU(THDTensorDescriptor* output,
                                   THDGroup group);
 THD_API void THDAllGather(THDTensorDescriptor* output, size_t len,
                           THDTensorDescriptor& input, THDGroup group);
+THD_API THDRequest* THDIallGather(THDTensorDescriptor* output, size_t len,
+                                  THDTensorDescriptor& input, THDGroup group);
 THD_API void THDGatherSend(THDTensorDescriptor& input, int dst_rank, THDGroup group);
 THD_API void THDGatherRecv(THDTensorDescriptor* output, size_t len,
                            THDTensorDescriptor& input, THDGroup group);
@@ -43,5 +73,6 @@ THD_API void THDScatterSend(THDTensorDescriptor* input, size_t len,
 THD_API void THDScatterRecv(THDTensorDescriptor& output, int src_rank, THDGroup group);
 THD_API void THDBarrier(THDGroup group);
 THD_API THDGroup THDNewGroup(const int* ranks, size_t len);
+THD_API THDGroup THDNewHierarchicalGroup(const int* ranks, size_t len);
 THD_API bool THDRequest_isCompleted(THDRequest* request);
 THD_API void THDRequest_wait(THDRequest* request);
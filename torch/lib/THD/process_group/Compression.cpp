@@ -0,0 +1,189 @@
+#include "Compression.hpp"
+#include "General.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace thd {
+
+void Compressor::allReduce(at::Tensor& data, at::Tensor& residual,
+                           THDGroup group_id) {
+  if (residual.defined()) {
+    if (!residual.is_contiguous() || residual.numel() != data.numel() ||
+        residual.type() != data.type()) {
+      throw std::invalid_argument("compressed allReduce: residual should be a "
+                                  "contiguous tensor of the size and type of "
+                                  "the reduced tensor");
+    }
+  }
+  if (data.numel() == 0) {
+    return;
+  }
+
+  auto flat = data.contiguous().view({-1});
+  auto flat_residual = residual.defined() ? residual.view({-1}) : residual;
+  allReduceFlat(flat, flat_residual, group_id);
+  if (!data.is_contiguous()) {
+    data.copy_(flat.view(data.sizes()));
+  }
+}
+
+namespace {
+
+// Sends the tensor as half precision floats. The residual keeps the
+// rounding error.
+struct FP16Compressor : Compressor {
+protected:
+  void allReduceFlat(at::Tensor& data, at::Tensor& residual,
+                     THDGroup group_id) override {
+    at::Tensor half;
+    if (residual.defined()) {
+      auto compensated = data + residual;
+      half = compensated.toType(at::kHalf);
+      residual.copy_(compensated - half.toType(data.type().scalarType()));
+    } else {
+      half = data.toType(at::kHalf);
+    }
+    dataChannel->allReduce(half, THDReduceSUM, group_id);
+    data.copy_(half);
+  }
+};
+
+// Sends the `ratio` fraction of the elements with the largest magnitude,
+// with their indices. The residual keeps the others.
+struct TopKCompressor : Compressor {
+  explicit TopKCompressor(double ratio) : _ratio(ratio) {
+    if (ratio <= 0 || ratio > 1) {
+      throw std::invalid_argument("top-k compression ratio should be in (0, 1]");
+    }
+  }
+
+protected:
+  void allReduceFlat(at::Tensor& data, at::Tensor& residual,
+                     THDGroup group_id) override {
+    int64_t numel = data.numel();
+    int64_t k = static_cast<int64_t>(std::ceil(_ratio * numel));
+    k = std::min(std::max<int64_t>(k, 1), numel);
+
+    auto compensated = residual.defined() ? data + residual : data.clone();
+    auto indices = std::get<1>(compensated.abs().topk(k, 0, true, false));
+    auto values = compensated.index_select(0, indices);
+    if (residual.defined()) {
+      residual.copy_(compensated.index_fill_(0, indices, 0));
+    }
+
+    // every process sends k elements, so their values and indices can be
+    // gathered as they are
+    auto group_size = dataChannel->getGroupSize(group_id);
+    std::vector<at::Tensor> all_values, all_indices;
+    for (rank_type i = 0; i < group_size; ++i) {
+      all_values.push_back(values.type().tensor({k}));
+      all_indices.push_back(indices.type().tensor({k}));
+    }
+    dataChannel->allGather(all_values, values, group_id);
+    dataChannel->allGather(all_indices, indices, group_id);
+
+    data.zero_();
+    data.index_add_(0, at::cat(all_indices, 0), at::cat(all_values, 0));
+  }
+
+private:
+  double _ratio;
+};
+
+// Sends one bit per element, its sign, packed 8 to a byte, and the mean
+// absolute value of the tensor, which every element is scaled by. The
+// residual keeps the difference with the tensor.
+struct SignCompressor : Compressor {
+protected:
+  void allReduceFlat(at::Tensor& data, at::Tensor& residual,
+                     THDGroup group_id) override {
+    if (!at::isFloatingType(data.type().scalarType())) {
+      throw std::invalid_argument("sign compression only works with floating "
+                                  "point tensors");
+    }
+    int64_t numel = data.numel();
+    auto compensated = residual.defined() ? data + residual : data;
+    auto scale = data.type().tensor({1});
+    scale.fill_(compensated.abs().mean());
+    auto bits = compensated.ge(0);
+    if (residual.defined()) {
+      residual.copy_(compensated - decode(bits, scale, data.type()));
+    }
+    auto packed = pack(bits);
+
+    auto group_size = dataChannel->getGroupSize(group_id);
+    std::vector<at::Tensor> all_packed, all_scales;
+    for (rank_type i = 0; i < group_size; ++i) {
+      all_packed.push_back(packed.type().tensor(packed.sizes()));
+      all_scales.push_back(scale.type().tensor({1}));
+    }
+    dataChannel->allGather(all_packed, packed, group_id);
+    dataChannel->allGather(all_scales, scale, group_id);
+
+    data.zero_();
+    for (rank_type i = 0; i < group_size; ++i) {
+      data.add_(decode(unpack(all_packed[i], numel), all_scales[i], data.type()));
+    }
+  }
+
+private:
+  static at::Tensor pack(const at::Tensor& bits) {
+    int64_t numel = bits.numel();
+    int64_t bytes = (numel + 7) / 8;
+    auto padded = at::zeros(bits.type(), {bytes * 8});
+    padded.narrow(0, 0, numel).copy_(bits);
+    padded = padded.view({bytes, 8});
+    auto packed = at::zeros(bits.type(), {bytes});
+    for (int64_t j = 0; j < 8; ++j) {
+      packed.add_(padded.select(1, j).mul(1 << j));
+    }
+    return packed;
+  }
+
+  static at::Tensor unpack(const at::Tensor& packed, int64_t numel) {
+    int64_t bytes = packed.numel();
+    auto bits = packed.type().tensor({bytes, 8});
+    for (int64_t j = 0; j < 8; ++j) {
+      bits.select(1, j).copy_(packed.div(1 << j).remainder(2));
+    }
+    return bits.view({-1}).narrow(0, 0, numel);
+  }
+
+  // bits of 1 become `scale`, bits of 0 `-scale`
+  static at::Tensor decode(const at::Tensor& bits, const at::Tensor& scale,
+                           const at::Type& type) {
+    auto signs = bits.toType(type);
+    return signs.mul_(2).sub_(1).mul_(scale);
+  }
+};
+
+} // anonymous namespace
+
+std::unique_ptr<Compressor> newCompressor(THDCompression compression,
+                                          double ratio) {
+  switch (compression) {
+    case THDCompressionFP16:
+      return std::unique_ptr<Compressor>(new FP16Compressor());
+    case THDCompressionTOPK:
+      return std::unique_ptr<Compressor>(new TopKCompressor(ratio));
+    case THDCompressionSIGN:
+      return std::unique_ptr<Compressor>(new SignCompressor());
+    default:
+      throw std::invalid_argument("unknown compression");
+  }
+}
+
+} // namespace thd
+
+using namespace thd;
+
+void THDAllReduceCompressed(THDTensorDescriptor& desc,
+                            THDTensorDescriptor& residual,
+                            THDCompression compression,
+                            double ratio,
+                            THDGroup group) {
+  newCompressor(compression, ratio)->allReduce(desc, residual, group);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "base/DataChannel.hpp"
+#include "Collectives.h"
+
+#include <memory>
+
+namespace thd {
+
+/**
+ * A compressor sums a tensor over a group like allReduce, but sends
+ * fewer bytes than the tensor holds. Lossy compressors add what they
+ * dropped to `residual` (error feedback), which is added back to the
+ * tensor in the next call, so that nothing is lost over the iterations.
+ *
+ * `residual` has the size and type of the tensor and lives on the same
+ * device. It is owned by the caller, who should zero it at first and keep
+ * it between calls with the same tensor. It may be undefined, in which
+ * case the error is dropped.
+ */
+struct Compressor {
+  virtual ~Compressor() {}
+
+  void allReduce(at::Tensor& data, at::Tensor& residual, THDGroup group_id);
+
+protected:
+  // `data` and `residual` are 1-d and contiguous here
+  virtual void allReduceFlat(at::Tensor& data, at::Tensor& residual,
+                             THDGroup group_id) = 0;
+};
+
+/**
+ * `ratio` is the fraction of the elements sent by THDCompressionTOPK, and
+ * is ignored by the other compressors.
+ */
+std::unique_ptr<Compressor> newCompressor(THDCompression compression,
+                                          double ratio);
+
+} // namespace thd
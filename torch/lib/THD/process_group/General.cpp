@@ -5,15 +5,44 @@ namespace thd {
 std::unique_ptr<DataChannel> dataChannel;
 } // namespace thd
 
+namespace {
+
+// Arguments of THDProcessGroupInit, the rendezvous is repeated with them
+// when the process group is rebuilt
+struct {
+  std::string init_method;
+  int world_size;
+  std::string group_name;
+  int rank;
+  int min_world_size;
+} initArgs;
+
+} // anonymous namespace
+
 using namespace thd;
 
 void THDProcessGroupInit(THDChannelType channel_type, std::string init_method = "env://",
-                         int world_size = -1, std::string group_name = "", int rank = -1) {
+                         int world_size = -1, std::string group_name = "", int rank = -1,
+                         int min_world_size) {
   HANDLE_EXCEPTIONS
   dataChannel = std::unique_ptr<DataChannel>(
       thd::DataChannel::newChannel(channel_type, init_method, world_size,
-                                   group_name, rank));
+                                   group_name, rank, min_world_size));
   dataChannel->init();
+  initArgs = {init_method, world_size, group_name, rank, min_world_size};
+  END_HANDLE_EXCEPTIONS
+}
+
+void THDProcessGroupRebuild() {
+  HANDLE_EXCEPTIONS
+  if (!dataChannel)
+    throw std::runtime_error("the process group is not initialized");
+  // The channel is torn down first, so that the master can listen on its
+  // port again for the new rendezvous.
+  dataChannel->destroy();
+  dataChannel->rebuild(getInitConfig(initArgs.init_method, initArgs.world_size,
+                                     initArgs.group_name, initArgs.rank,
+                                     initArgs.min_world_size));
   END_HANDLE_EXCEPTIONS
 }
 
@@ -5,7 +5,9 @@
 #include <string>
 
 THD_API void THDProcessGroupInit(THDChannelType channel_type, std::string init_method,
-                                 int world_size, std::string group_name, int rank);
+                                 int world_size, std::string group_name, int rank,
+                                 int min_world_size = -1);
+THD_API void THDProcessGroupRebuild();
 THD_API void THDProcessGroupDestroy();
 THD_API void THDClearGroupCache(THDGroup group);
 
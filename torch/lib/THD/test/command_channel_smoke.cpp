@@ -12,6 +12,8 @@
 
 using namespace thd;
 
+constexpr int PIPELINED_MESSAGES = 1000;
+
 std::vector<std::thread> g_all_workers;
 std::mutex g_mutex;
 std::unique_ptr<Barrier> g_barrier;
@@ -32,6 +34,12 @@ void init_worker(const int& rank, const std::string& master_addr) {
       (int)msg.get()->bytes().length(), msg.get()->bytes().data());
   assert(expected.compare(msg.get()->bytes().to_string()) == 0);
 
+  // messages queued one after another arrive in order
+  for (int i = 0; i < PIPELINED_MESSAGES; ++i) {
+    msg = channel->recvMessage();
+    assert(msg.get()->bytes().to_string() == std::to_string(i));
+  }
+
   /*
    * We need to wait until master will do all receiving and sending. This
    * is because when worker is destroyed it closes all sockets what results in
@@ -61,6 +69,18 @@ void init_master(int world_size, const std::string& master_port) {
     channel->sendMessage(std::move(rpc_msg), worker_rank);
   }
 
+  for (int i = 0; i < PIPELINED_MESSAGES; ++i) {
+    for (int worker_rank = 1; worker_rank < world_size; ++worker_rank) {
+      std::string number = std::to_string(i);
+      rpc::ByteArray arr(number.data(), number.size());
+      channel->sendMessage(std::unique_ptr<rpc::RPCMessage>(new rpc::RPCMessage(arr)), worker_rank);
+    }
+  }
+
+  for (int worker_rank = 1; worker_rank < world_size; ++worker_rank) {
+    channel->flush(worker_rank);
+  }
+
   g_barrier->wait();
 
   // wait for all workers to finish
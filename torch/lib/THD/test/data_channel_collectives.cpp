@@ -45,6 +45,28 @@ void test_send_recv_tensor(std::shared_ptr<thd::DataChannel> data_channel) {
   }
 }
 
+// Big enough to be striped over the sockets when THD_TCP_STREAMS > 1
+void test_send_recv_big_tensor(std::shared_ptr<thd::DataChannel> data_channel) {
+  if (g_data_channel_type == "gloo") {
+    return; // XXX: Gloo does not support send/recv
+  }
+
+  // not a multiple of the number of sockets
+  std::vector<int64_t> size = {1000003};
+  if (data_channel->getRank() == 0) {
+    auto float_tensor = buildTensor<float>(size, 4.2);
+    data_channel->send(*float_tensor, 1);
+    data_channel->receive(*float_tensor, 1);
+    ASSERT_TENSOR_VALUE(float, *float_tensor, -4.2)
+  } else if (data_channel->getRank() == 1) {
+    auto float_tensor = buildTensor<float>(size, -1.0);
+    data_channel->receive(*float_tensor, 0);
+    ASSERT_TENSOR_VALUE(float, *float_tensor, 4.2)
+    float_tensor->fill(-4.2);
+    data_channel->send(*float_tensor, 0);
+  }
+}
+
 void test_send_recv_tensor_any_source(std::shared_ptr<thd::DataChannel> data_channel,
                                       int workers) {
   if (g_data_channel_type == "gloo") {
@@ -121,13 +143,14 @@ void test_reduce(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
 }
 
 void _test_allReduce_helper(std::shared_ptr<thd::DataChannel> data_channel,
-                            THDReduceOp op_type, int64_t init_value, int64_t expected_value) {
+                            THDReduceOp op_type, int64_t init_value, int64_t expected_value,
+                            std::vector<int64_t> shape = {1, 2, 3, 4, 5, 6, 7, 100}) {
   if (data_channel->getRank() == 0) {
-    auto int_tensor = buildTensor<int>({1, 2, 3, 4, 5, 6, 7, 100}, init_value);
+    auto int_tensor = buildTensor<int>(shape, init_value);
     data_channel->allReduce(*int_tensor, op_type, 0);
     ASSERT_TENSOR_VALUE(int, *int_tensor, expected_value)
   } else {
-    auto int_tensor = buildTensor<int>({1, 2, 3, 4, 5, 6, 7, 100}, data_channel->getRank());
+    auto int_tensor = buildTensor<int>(shape, data_channel->getRank());
     data_channel->allReduce(*int_tensor, op_type, 0);
     ASSERT_TENSOR_VALUE(int, *int_tensor, expected_value)
   }
@@ -141,6 +164,41 @@ void test_allReduce(std::shared_ptr<thd::DataChannel> data_channel, int workers)
   _test_allReduce_helper(data_channel, THDReduceOp::THDReduceMIN, 10010, 1);
   _test_allReduce_helper(data_channel, THDReduceOp::THDReduceMAX,
                          -1, data_channel->getNumProcesses() - 1);
+  // large enough for the ring algorithm of the TCP data channel, with an
+  // odd size so that the chunks differ in size
+  _test_allReduce_helper(data_channel, THDReduceOp::THDReduceSUM,
+                         2, 2 + (workers * (workers + 1) / 2), {3, 100003});
+  _test_allReduce_helper(data_channel, THDReduceOp::THDReduceMAX,
+                         -1, data_channel->getNumProcesses() - 1, {3, 100003});
+}
+
+void test_async_collectives(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+  auto rank = data_channel->getRank();
+  auto reduced = buildTensor<int>({1, 2, 3, 4, 5, 6, 7, 100}, rank == 0 ? 2 : rank);
+  auto broadcasted = buildTensor<int>({1, 2, 3}, rank == 0 ? 42 : -1);
+  std::unique_ptr<thd::DataChannel::Request> reduce_req(
+    data_channel->iallReduce(*reduced, THDReduceOp::THDReduceSUM, 0));
+  std::unique_ptr<thd::DataChannel::Request> broadcast_req(
+    data_channel->ibroadcast(*broadcasted, 0, 0));
+
+  // requests complete in issue order
+  broadcast_req->wait();
+  assert(reduce_req->isCompleted());
+  ASSERT_TENSOR_VALUE(int, *reduced, 2 + (workers * (workers + 1) / 2))
+  ASSERT_TENSOR_VALUE(int, *broadcasted, 42)
+
+  std::vector<std::shared_ptr<thpp::IntTensor>> tensors;
+  std::vector<thpp::Tensor*> raw_tensors;
+  for (std::size_t i = 0; i < data_channel->getNumProcesses(); ++i) {
+    tensors.push_back(buildTensor<int>({1, 2, 3, 4, 5}, -1));
+    raw_tensors.push_back(tensors.back().get());
+  }
+  auto input = buildTensor<int>({1, 2, 3, 4, 5}, rank);
+  std::unique_ptr<thd::DataChannel::Request> gather_req(
+    data_channel->iallGather(raw_tensors, *input, 0));
+  gather_req->wait();
+  for (std::size_t i = 0; i < tensors.size(); ++i)
+    ASSERT_TENSOR_VALUE(int, *(tensors[i]), i)
 }
 
 void test_scatter(std::shared_ptr<thd::DataChannel> data_channel) {
@@ -613,11 +671,13 @@ void test_tensors_are_not_the_same(std::shared_ptr<thd::DataChannel> data_channe
 
 void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
   test_send_recv_tensor(data_channel);
+  test_send_recv_big_tensor(data_channel);
   test_send_recv_tensor_any_source(data_channel, workers);
   test_send_recv_scalar(data_channel);
   test_broadcast(data_channel);
   test_reduce(data_channel, workers);
   test_allReduce(data_channel, workers);
+  test_async_collectives(data_channel, workers);
   test_scatter(data_channel);
   test_gather(data_channel);
   test_allGather(data_channel);
@@ -734,6 +794,23 @@ int main(int argc, char const *argv[]) {
       std::cout << "TCP - OK" << std::endl;
     }
 
+    // the same with several sockets per pair of processes
+    setenv("THD_TCP_STREAMS", "3", 1);
+    for (auto workers : WORKERS_NUM) {
+      std::cout << "TCP with 3 streams (workers: " << workers << "):" << std::endl;
+      std::thread tcp_master_thread(init_tcp_master, workers);
+
+      for (int id = 1; id <= workers; ++id) {
+        g_all_workers.push_back(std::thread(init_tcp_worker, id, workers));
+      }
+
+      tcp_master_thread.join();
+      g_all_workers.clear();
+
+      std::cout << "TCP with 3 streams - OK" << std::endl;
+    }
+    unsetenv("THD_TCP_STREAMS");
+
 #ifdef WITH_GLOO
     g_data_channel_type = "gloo";
     for (auto workers : WORKERS_NUM) {
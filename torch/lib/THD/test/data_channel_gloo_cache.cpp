@@ -32,12 +32,37 @@ void test(std::shared_ptr<thd::DataChannel> data_channel) {
   }
 }
 
+// Big tensors run without staging copies once the same buffer is passed
+// twice in a row, and go back to the staging buffers when it changes
+void test_zero_copy(std::shared_ptr<thd::DataChannel> data_channel) {
+  auto processes = data_channel->getNumProcesses();
+  auto float_tensor = buildTensor<float>({1 << 20}, 1.0);
+  for (std::size_t i = 0; i < 4; ++i) {
+    float_tensor->fill(1.0);
+    data_channel->allReduce(*float_tensor, THDReduceOp::THDReduceSUM);
+    ASSERT_TENSOR_VALUE(float, *float_tensor, processes)
+  }
+
+  auto other_tensor = buildTensor<float>({1 << 20}, 2.0);
+  data_channel->allReduce(*other_tensor, THDReduceOp::THDReduceSUM);
+  ASSERT_TENSOR_VALUE(float, *other_tensor, 2 * processes)
+
+  for (std::size_t i = 0; i < 3; ++i) {
+    if (data_channel->getRank() == 0) {
+      float_tensor->fill(i);
+    }
+    data_channel->broadcast(*float_tensor, 0);
+    ASSERT_TENSOR_VALUE(float, *float_tensor, i)
+  }
+}
+
 void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
   // NOTE: without properly working GlooCache this test would create
   // about (1000 * WORKERS ^ 3) connections what is over 'normal' system configuration
   for (std::size_t i = 0; i < 1000; ++i) {
     test(data_channel);
   }
+  test_zero_copy(data_channel);
 }
 
 
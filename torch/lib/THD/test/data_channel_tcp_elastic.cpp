@@ -0,0 +1,74 @@
+#include "../base/data_channels/DataChannelTCP.hpp"
+#include "TestUtils.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+constexpr int MAX_WORLD_SIZE = 4;
+constexpr int WORKERS_NUM = 2;
+constexpr int MASTER_PORT = 45681;
+
+const std::string INIT_METHOD = "tcp://127.0.0.1:" + std::to_string(MASTER_PORT);
+
+Barrier g_barrier(WORKERS_NUM + 1);
+
+thd::InitMethod::Config rendezvous(int rank, int min_world_size) {
+  return thd::getInitConfig(INIT_METHOD, MAX_WORLD_SIZE, "", rank, min_world_size);
+}
+
+void master()
+{
+  // only WORKERS_NUM workers are started, so the join timeout ends the rendezvous
+  auto channel = std::make_shared<thd::DataChannelTCP>(rendezvous(0, 2));
+  assert(channel->init());
+  assert(channel->getRank() == 0);
+  assert(channel->getNumProcesses() == WORKERS_NUM + 1);
+  channel->barrier();
+
+  // one of the workers leaves
+  g_barrier.wait();
+  channel->destroy();
+  channel->rebuild(rendezvous(0, 2));
+  assert(channel->getRank() == 0);
+  assert(channel->getNumProcesses() == WORKERS_NUM);
+  channel->barrier();
+}
+
+void worker(int id)
+{
+  auto channel = std::make_shared<thd::DataChannelTCP>(rendezvous(id, 2));
+  assert(channel->init());
+  assert(channel->getRank() > 0 && channel->getRank() <= WORKERS_NUM);
+  assert(channel->getNumProcesses() == WORKERS_NUM + 1);
+  channel->barrier();
+
+  g_barrier.wait();
+  channel->destroy();
+  if (id == WORKERS_NUM)
+    return;
+
+  channel->rebuild(rendezvous(id, 2));
+  assert(channel->getRank() == 1);
+  assert(channel->getNumProcesses() == WORKERS_NUM);
+  channel->barrier();
+}
+
+
+int main() {
+  setenv("THD_JOIN_TIMEOUT", "1000", 1);
+
+  std::thread master_thread(master);
+  std::vector<std::thread> workers;
+  for (int id = 1; id <= WORKERS_NUM; ++id) {
+    workers.push_back(std::thread(worker, id));
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  master_thread.join();
+  std::cout << "OK" << std::endl;
+  return 0;
+}
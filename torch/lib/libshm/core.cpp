@@ -1,6 +1,10 @@
 #include <cstring>
+#include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <sys/mman.h>
 
 #include <TH/TH.h>
 #include "err.h"
@@ -91,11 +95,11 @@ char * copy_handle(const std::string &handle) {
   return new_handle;
 }
 
-AllocInfo get_alloc_info(libshm_context *ctx) {
+AllocInfo get_alloc_info(THMapAllocatorContext *th_context) {
   AllocInfo info = {0};
   info.pid = getpid();
   info.free = false;
-  const char *filename = THMapAllocatorContext_filename(ctx->th_context);
+  const char *filename = THMapAllocatorContext_filename(th_context);
   size_t len = strlen(filename);
   if (len >= sizeof(info.filename)) {
     throw std::runtime_error("THMapAllocatorContext_filename too long");
@@ -104,6 +108,139 @@ AllocInfo get_alloc_info(libshm_context *ctx) {
   return info;
 }
 
+// Segments created by this process can be kept mapped when their storages
+// are freed, and reused once the other processes that mapped them have
+// freed them too. The pool holds a reference to every segment, so a
+// refcount of one in the segment means that it's free everywhere else;
+// no message needs to come back from the processes the segments were sent
+// to. Only segments of up to kMaxPooledSize bytes are pooled, rounded up
+// to a power of two.
+class SegmentPool {
+public:
+  ~SegmentPool() {
+    // storages may still use the segments at exit, so they stay mapped
+    for (auto &entry : segments) {
+      Segment &segment = entry.second;
+      const char *filename = THMapAllocatorContext_filename(segment.th_context);
+      if (THRefcountedMapAllocator_decref(segment.th_context, entry.first))
+        shm_unlink(filename);
+    }
+  }
+
+  void set_capacity(ptrdiff_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = bytes;
+    evict(0);
+  }
+
+  // Returns nullptr if the storage isn't pooled
+  void * alloc(libshm_context *ctx, ClientSocket &socket, ptrdiff_t size) {
+    ptrdiff_t segment_size = kMinPooledSize;
+    while (segment_size < size)
+      segment_size *= 2;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (segment_size > kMaxPooledSize || segment_size > capacity)
+      return nullptr;
+
+    for (void *data : by_size[segment_size]) {
+      Segment &segment = segments.at(data);
+      if (segment.local_users == 0 &&
+          THRefcountedMapAllocator_refcount(segment.th_context, data) == 1) {
+        return use(ctx, segment, data);
+      }
+    }
+
+    if (bytes + segment_size > capacity)
+      evict(segment_size);
+    if (bytes + segment_size > capacity)
+      return nullptr;
+    // the context of the storage becomes the one owning the mapping
+    Segment segment;
+    segment.th_context = ctx->th_context;
+    segment.size = segment_size;
+    segment.manager_handle = ctx->manager_handle;
+    AllocInfo info = get_alloc_info(segment.th_context);
+    socket.register_allocation(info);
+    void *data = THRefcountedMapAllocator.malloc(segment.th_context, segment_size);
+    ctx->th_context = nullptr;
+    auto &added = segments.emplace(data, std::move(segment)).first->second;
+    by_size[segment_size].push_back(data);
+    bytes += segment_size;
+    return use(ctx, added, data);
+  }
+
+  // Returns false if the storage wasn't pooled
+  bool free(libshm_context *ctx, void *data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = segments.find(data);
+    if (it == segments.end())
+      return false;
+    Segment &segment = it->second;
+    THRefcountedMapAllocator_decref(ctx->th_context, data);
+    THMapAllocatorContext_free(ctx->th_context);
+    libshm_context_free(ctx);
+    segment.local_users--;
+    evict(0);
+    return true;
+  }
+
+private:
+  static constexpr ptrdiff_t kMinPooledSize = 4096;
+  static constexpr ptrdiff_t kMaxPooledSize = 16 << 20;
+
+  struct Segment {
+    THMapAllocatorContext *th_context;
+    ptrdiff_t size;
+    int local_users = 0;
+    std::string manager_handle;
+  };
+
+  void * use(libshm_context *ctx, Segment &segment, void *data) {
+    const char *filename = THMapAllocatorContext_filename(segment.th_context);
+    if (ctx->th_context)
+      THMapAllocatorContext_free(ctx->th_context);
+    ctx->th_context = THMapAllocatorContext_new(filename, TH_ALLOCATOR_MAPPED_SHAREDMEM);
+    THRefcountedMapAllocator_incref(ctx->th_context, data);
+    segment.local_users++;
+    return data;
+  }
+
+  // Drops the segments unused in this process until `needed` more bytes
+  // fit. The last process to free a segment unlinks it.
+  void evict(ptrdiff_t needed) {
+    for (auto &entry : by_size) {
+      auto &list = entry.second;
+      for (auto it = list.begin(); it != list.end() && bytes + needed > capacity;) {
+        Segment &segment = segments.at(*it);
+        if (segment.local_users > 0) {
+          ++it;
+          continue;
+        }
+        AllocInfo info = get_alloc_info(segment.th_context);
+        info.free = true;
+        ClientSocket &socket = get_manager_socket(&segment.manager_handle[0]);
+        THRefcountedMapAllocator.free(segment.th_context, *it);
+        socket.register_deallocation(info);
+        bytes -= segment.size;
+        segments.erase(*it);
+        it = list.erase(it);
+      }
+    }
+  }
+
+  std::mutex mutex;
+  std::unordered_map<void*, Segment> segments;
+  std::map<ptrdiff_t, std::vector<void*>> by_size;
+  ptrdiff_t bytes = 0;
+  ptrdiff_t capacity = 0;
+};
+
+SegmentPool pool;
+
+void libshm_set_pool_size(ptrdiff_t bytes) {
+  pool.set_capacity(bytes);
+}
+
 void * libshm_alloc(void *_ctx, ptrdiff_t size) {
   // TODO: unlock GIL when contacting the manager
   auto *ctx = (libshm_context*)_ctx;
@@ -113,13 +250,17 @@ void * libshm_alloc(void *_ctx, ptrdiff_t size) {
     if (ctx->manager_handle) {
       socket = &get_manager_socket(ctx->manager_handle);
     } else {
+      // the segment is created by this process, so it can be pooled
       if (managers.size() == 0)
           start_manager();
       const auto &manager = managers.begin();
       ctx->manager_handle = copy_handle(manager->first);
       socket = &manager->second;
+      void *data = pool.alloc(ctx, *socket, size);
+      if (data)
+        return data;
     }
-    AllocInfo info = get_alloc_info(ctx);
+    AllocInfo info = get_alloc_info(ctx->th_context);
     socket->register_allocation(info);
   } catch(std::exception &e) {
     THError(e.what());
@@ -134,7 +275,9 @@ void * libshm_realloc(void *_ctx, void *data, ptrdiff_t size) {
 
 void libshm_free(void *_ctx, void *data) {
   auto *ctx = (libshm_context*)_ctx;
-  AllocInfo info = get_alloc_info(ctx);
+  if (pool.free(ctx, data))
+    return;
+  AllocInfo info = get_alloc_info(ctx->th_context);
   info.free = true;
   ClientSocket &socket = get_manager_socket(ctx->manager_handle);
   THRefcountedMapAllocator.free(ctx->th_context, data);
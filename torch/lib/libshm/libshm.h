@@ -17,6 +17,10 @@ typedef struct {
 EXPORT_API void libshm_init(const char *manager_exec_path);
 EXPORT_API libshm_context * libshm_context_new(const char *manager_handle, const char *filename, int flags);
 EXPORT_API void libshm_context_free(libshm_context *context);
+// Up to `bytes` of the shared memory segments created by this process are
+// reused for new storages instead of being unlinked. 0, the default,
+// disables the pool.
+EXPORT_API void libshm_set_pool_size(ptrdiff_t bytes);
 
 extern THAllocator THManagedSharedAllocator;
 
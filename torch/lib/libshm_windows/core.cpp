@@ -20,6 +20,9 @@ void libshm_context_free(libshm_context *ctx) {
   delete ctx;
 }
 
+void libshm_set_pool_size(ptrdiff_t bytes) {
+}
+
 void * libshm_alloc(void *_ctx, ptrdiff_t size) {
   auto *ctx = (libshm_context*)_ctx;
   return THRefcountedMapAllocator.malloc(ctx->th_context, size);
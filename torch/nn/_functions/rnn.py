@@ -1,4 +1,5 @@
 import warnings
+import torch
 from torch.autograd import NestedIOFunction, Variable
 import torch.backends.cudnn as cudnn
 from .. import functional as F
@@ -10,6 +11,9 @@ try:
 except ImportError:
     pass
 
+# CPU types with fused pointwise LSTM and GRU cell kernels
+_fused_cpu_types = ('torch.FloatTensor', 'torch.DoubleTensor')
+
 
 def RNNReLUCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
     hy = F.relu(F.linear(input, w_ih, b_ih) + F.linear(hidden, w_hh, b_hh))
@@ -28,6 +32,12 @@ def LSTMCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
         state = fusedBackend.LSTMFused.apply
         return state(igates, hgates, hidden[1]) if b_ih is None else state(igates, hgates, hidden[1], b_ih, b_hh)
 
+    if input.type() in _fused_cpu_types:
+        igates = F.linear(input, w_ih)
+        hgates = F.linear(hidden[0], w_hh)
+        hy, cy, _ = torch._C._VariableFunctions._thnn_fused_lstm_cell(igates, hgates, hidden[1], b_ih, b_hh)
+        return hy, cy
+
     hx, cx = hidden
     gates = F.linear(input, w_ih, b_ih) + F.linear(hx, w_hh, b_hh)
 
@@ -52,6 +62,12 @@ def GRUCell(input, hidden, w_ih, w_hh, b_ih=None, b_hh=None):
         state = fusedBackend.GRUFused.apply
         return state(gi, gh, hidden) if b_ih is None else state(gi, gh, hidden, b_ih, b_hh)
 
+    if input.type() in _fused_cpu_types:
+        gi = F.linear(input, w_ih)
+        gh = F.linear(hidden, w_hh)
+        hy, _ = torch._C._VariableFunctions._thnn_fused_gru_cell(gi, gh, hidden, b_ih, b_hh)
+        return hy
+
     gi = F.linear(input, w_ih, b_ih)
     gh = F.linear(hidden, w_hh, b_hh)
     i_r, i_i, i_n = gi.chunk(3, 1)
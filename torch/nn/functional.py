@@ -249,28 +249,28 @@ def avg_pool1d(input, kernel_size, stride=None, padding=0,
                       ceil_mode, count_include_pad).squeeze(3)
 
 
-avg_pool2d = _add_docstr(torch._C._nn.avg_pool2d, r"""
-avg_pool2d(input, kernel_size, stride=None, padding=0, ceil_mode=False, count_include_pad=True) -> Tensor
+def avg_pool2d(input, kernel_size, stride=None, padding=0, ceil_mode=False, count_include_pad=True):
+    r"""Applies 2D average-pooling operation in :math:`kH \times kW` regions by step size
+    :math:`sH \times sW` steps. The number of output features is equal to the number of
+    input planes.
 
-Applies 2D average-pooling operation in :math:`kH \times kW` regions by step size
-:math:`sH \times sW` steps. The number of output features is equal to the number of
-input planes.
+    See :class:`~torch.nn.AvgPool2d` for details and output shape.
 
-See :class:`~torch.nn.AvgPool2d` for details and output shape.
+    Args:
+        input: input tensor (:math:`minibatch \times in\_channels \times iH \times iW`)
+        kernel_size: size of the pooling region. Can be a single number or a
+          tuple (:math:`kH \times kW`)
+        stride: stride of the pooling operation. Can be a single number or a
+          tuple `(sH, sW)`. Default: :attr:`kernel_size`
+        padding: implicit zero paddings on both sides of the input. Can be a
+          single number or a tuple `(padH, padW)`. Default: 0
+        ceil_mode: when True, will use `ceil` instead of `floor` in the formula
+            to compute the output shape. Default: ``False``
+        count_include_pad: when True, will include the zero-padding in the
+            averaging calculation. Default: ``True``
+    """
+    return torch._avg_pool2d(input, kernel_size, stride, padding, ceil_mode, count_include_pad)
 
-Args:
-    input: input tensor (:math:`minibatch \times in\_channels \times iH \times iW`)
-    kernel_size: size of the pooling region. Can be a single number or a
-      tuple (:math:`kH \times kW`)
-    stride: stride of the pooling operation. Can be a single number or a
-      tuple `(sH, sW)`. Default: :attr:`kernel_size`
-    padding: implicit zero paddings on both sides of the input. Can be a
-      single number or a tuple `(padH, padW)`. Default: 0
-    ceil_mode: when True, will use `ceil` instead of `floor` in the formula
-        to compute the output shape. Default: ``False``
-    count_include_pad: when True, will include the zero-padding in the
-        averaging calculation. Default: ``True``
-""")
 
 avg_pool3d = _add_docstr(torch._C._nn.avg_pool3d, r"""
 avg_pool3d(input, kernel_size, stride=None, padding=0, ceil_mode=False, count_include_pad=True) -> Tensor
@@ -360,7 +360,10 @@ def max_pool2d(input, kernel_size, stride=None, padding=0, dilation=1,
 
     See :class:`~torch.nn.MaxPool2d` for details.
     """
-    ret = torch._C._nn.max_pool2d(input, kernel_size, stride, padding, dilation, ceil_mode)
+    # the indices are only computed when they are returned or needed by the
+    # backward
+    need_indices = return_indices or (torch.is_grad_enabled() and input.requires_grad)
+    ret = torch._max_pool2d(input, kernel_size, stride, padding, dilation, ceil_mode, need_indices)
     return ret if return_indices else ret[0]
 
 
@@ -835,7 +838,7 @@ def softmin(input, dim=None, _stacklevel=3):
     """
     if dim is None:
         dim = _get_softmax_dim('softmin', input.dim(), _stacklevel)
-    return torch._C._nn.softmax(-input, dim)
+    return torch._softmax(-input, dim)
 
 
 def softmax(input, dim=None, _stacklevel=3):
@@ -862,7 +865,7 @@ def softmax(input, dim=None, _stacklevel=3):
     """
     if dim is None:
         dim = _get_softmax_dim('softmax', input.dim(), _stacklevel)
-    return torch._C._nn.softmax(input, dim)
+    return torch._softmax(input, dim)
 
 
 def _sample_gumbel(shape, eps=1e-10, out=None):
@@ -944,7 +947,7 @@ def log_softmax(input, dim=None, _stacklevel=3):
     """
     if dim is None:
         dim = _get_softmax_dim('log_softmax', input.dim(), _stacklevel)
-    return torch._C._nn.log_softmax(input, dim)
+    return torch._log_softmax(input, dim)
 
 
 softshrink = _add_docstr(torch._C._nn.softshrink, r"""
@@ -1088,7 +1091,8 @@ def embedding(input, weight, padding_idx=None, max_norm=None, norm_type=2,
 
 
 def embedding_bag(embedding_matrix, indices, offsets=None,
-                  max_norm=None, norm_type=2, scale_grad_by_freq=False, mode='mean', sparse=False):
+                  max_norm=None, norm_type=2, scale_grad_by_freq=False, mode='mean', sparse=False,
+                  per_sample_weights=None):
     r"""Computes sums or means of 'bags' of embeddings, without instantiating the
         intermediate embeddings.
 
@@ -1115,6 +1119,9 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
             mode (string, optional): 'sum' | 'mean'. Specifies the way to reduce the bag. Default: 'mean'
             sparse (boolean, optional): if ``True``, gradient w.r.t. weight matrix will be a sparse tensor. See Notes
                                         for more details regarding sparse gradients.
+            per_sample_weights (Tensor, optional): a tensor of the same size as `indices` (after flattening)
+                                                   whose entries scale the matching embeddings before they are
+                                                   reduced. Only supported on the CPU.
 
         Shape:
             - Embedding_matrix: FloatTensor `(V, embedding_dim)`,
@@ -1142,6 +1149,11 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
             [torch.FloatTensor of size (2,3)]
 
         """
+    if per_sample_weights is not None and per_sample_weights.size() != indices.size():
+        raise ValueError("per_sample_weights has to be of the same size as input ({}), "
+                         "but got per_sample_weights of size {}"
+                         .format(tuple(indices.size()), tuple(per_sample_weights.size())))
+
     if indices.dim() == 2:
         if offsets is not None:
             raise ValueError("if input is 2D, then offsets has to be None"
@@ -1152,6 +1164,8 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
             offsets = Variable(torch.arange(0, indices.numel(), indices.size(1),
                                             out=indices.data.new().long()))
             indices = indices.view(-1)
+            if per_sample_weights is not None:
+                per_sample_weights = per_sample_weights.reshape(-1)
     elif indices.dim() == 1:
         if offsets is None:
             raise ValueError("offsets has to be a 1D Tensor but got None")
@@ -1186,7 +1200,8 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
         offsets,
         scale_grad_by_freq,
         mode,
-        sparse)
+        sparse,
+        per_sample_weights)
     return ret
 
 
@@ -1419,7 +1434,8 @@ Args:
 """)
 
 
-def cross_entropy(input, target, weight=None, size_average=True, ignore_index=-100, reduce=True):
+def cross_entropy(input, target, weight=None, size_average=True, ignore_index=-100, reduce=True,
+                  label_smoothing=0.0):
     r"""This criterion combines `log_softmax` and `nll_loss` in a single
     function.
 
@@ -1442,6 +1458,14 @@ def cross_entropy(input, target, weight=None, size_average=True, ignore_index=-1
                 observations for each minibatch depending on :attr:`size_average`. When :attr:`reduce`
                 is ``False``, returns a loss per batch instead and ignores
                 :attr:`size_average`. Default: ``True``
+        label_smoothing (float, optional): The target distribution puts
+                :math:`1 - \text{label_smoothing}` on the target class and spreads
+                :attr:`label_smoothing` evenly over all `C` classes. Not supported
+                together with :attr:`weight`. Default: 0.0
+
+    For a 2D :attr:`input` without :attr:`weight`, this runs as a single
+    fused op that saves only the log-sum-exp of each row for backward,
+    rather than the whole log-softmax output.
 
     Examples::
 
@@ -1450,6 +1474,17 @@ def cross_entropy(input, target, weight=None, size_average=True, ignore_index=-1
         >>> loss = F.cross_entropy(input, target)
         >>> loss.backward()
     """
+    if weight is None and input.dim() == 2:
+        return torch.cross_entropy_loss(input, target, label_smoothing, ignore_index, size_average, reduce)
+    if label_smoothing != 0:
+        if weight is not None:
+            raise ValueError("cross_entropy: label_smoothing is not supported together with weight")
+        # Move the classes last and fall back to the 2D case
+        num_classes = input.size(1)
+        flat_input = input.transpose(1, -1).contiguous().view(-1, num_classes)
+        loss = torch.cross_entropy_loss(flat_input, target.contiguous().view(-1), label_smoothing,
+                                        ignore_index, size_average, reduce)
+        return loss if reduce else loss.view(target.size())
     return nll_loss(log_softmax(input, 1), target, weight, size_average, ignore_index, reduce)
 
 
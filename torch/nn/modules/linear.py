@@ -26,6 +26,13 @@ class Linear(Module):
             `(out_features x in_features)`
         bias:   the learnable bias of the module of shape `(out_features)`
 
+    .. note::
+        In evaluation mode, with gradients disabled, the products of small
+        batches of float CPU inputs use a copy of the weight packed for them
+        once. The copy is packed again when the weight is modified in place
+        or replaced, or when :meth:`~Module.train` or :meth:`~Module.eval`
+        is called, which is needed after modifying ``weight.data`` in place.
+
     Examples::
 
         >>> m = nn.Linear(20, 30)
@@ -51,9 +58,38 @@ class Linear(Module):
         if self.bias is not None:
             self.bias.data.uniform_(-stdv, stdv)
 
+    # the largest number of rows of the inputs using the packed weight above
+    # which the GEMM of F.linear is faster
+    _packed_max_rows = 64
+
     def forward(self, input):
+        if self._use_packed_weight(input):
+            return torch._packed_linear(input, self._get_packed_weight(),
+                                        self.bias, self.out_features)
         return F.linear(input, self.weight, self.bias)
 
+    def _use_packed_weight(self, input):
+        return (not self.training and not torch.is_grad_enabled() and
+                input.dim() >= 1 and input.size(-1) == self.in_features and
+                input.type() == 'torch.FloatTensor' and
+                self.weight.type() == 'torch.FloatTensor' and
+                (self.bias is None or self.bias.type() == 'torch.FloatTensor') and
+                input.numel() <= self._packed_max_rows * self.in_features)
+
+    def _get_packed_weight(self):
+        # the version counter and the storage of the weight tell when it
+        # changed. getattr, for the modules pickled without a packed weight
+        key = (self.weight._version, self.weight.data_ptr())
+        if getattr(self, '_packed_weight_key', None) != key:
+            self._packed_weight = torch._pack_linear_weight(self.weight)
+            self._packed_weight_key = key
+        return self._packed_weight
+
+    def train(self, mode=True):
+        self._packed_weight = None
+        self._packed_weight_key = None
+        return super(Linear, self).train(mode)
+
     def extra_repr(self):
         return 'in_features={}, out_features={}, bias={}'.format(
             self.in_features, self.out_features, self.bias is not None
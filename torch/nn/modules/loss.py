@@ -723,6 +723,9 @@ class CrossEntropyLoss(_WeightedLoss):
             observations for each minibatch depending on `size_average`. When reduce
             is ``False``, returns a loss per batch instead and ignores
             size_average. Default: ``True``
+        label_smoothing (float, optional): Moves this much of the target
+            probability off the target class and spreads it evenly over all
+            classes. Cannot be combined with `weight`. Default: 0.0
 
     Shape:
         - Input: :math:`(N, C)` where `C = number of classes`
@@ -738,14 +741,20 @@ class CrossEntropyLoss(_WeightedLoss):
         >>> output.backward()
     """
 
-    def __init__(self, weight=None, size_average=True, ignore_index=-100, reduce=True):
+    def __init__(self, weight=None, size_average=True, ignore_index=-100, reduce=True,
+                 label_smoothing=0.0):
         super(CrossEntropyLoss, self).__init__(weight, size_average, reduce)
         self.ignore_index = ignore_index
+        self.label_smoothing = label_smoothing
 
     def forward(self, input, target):
         _assert_no_grad(target)
         return F.cross_entropy(input, target, self.weight, self.size_average,
-                               self.ignore_index, self.reduce)
+                               self.ignore_index, self.reduce, self.label_smoothing)
+
+    def __setstate__(self, d):
+        super(CrossEntropyLoss, self).__setstate__(d)
+        self.__dict__.setdefault('label_smoothing', 0.0)
 
 
 class MultiLabelSoftMarginLoss(_WeightedLoss):
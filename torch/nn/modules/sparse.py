@@ -187,6 +187,9 @@ class EmbeddingBag(Module):
                                    does not need to be given, as the `input` is
                                    treated as a mini-batch of fixed length sequences
                                    of length `N` each.
+        - **per_sample_weights** (Tensor, optional): a tensor of the same size as `input`
+                                   whose entries scale the matching embeddings before
+                                   they are reduced. Only supported on the CPU.
 
 
     Shape:
@@ -232,10 +235,11 @@ class EmbeddingBag(Module):
     def reset_parameters(self):
         self.weight.data.normal_(0, 1)
 
-    def forward(self, input, offsets=None):
+    def forward(self, input, offsets=None, per_sample_weights=None):
         return F.embedding_bag(self.weight, input, offsets,
                                self.max_norm, self.norm_type,
-                               self.scale_grad_by_freq, self.mode, self.sparse)
+                               self.scale_grad_by_freq, self.mode, self.sparse,
+                               per_sample_weights)
 
     def extra_repr(self):
         s = '{num_embeddings}, {embedding_dim}'
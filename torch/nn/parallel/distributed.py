@@ -80,6 +80,12 @@ class DistributedDataParallel(Module):
         (e.g. BatchNorm stats) are broadcast form the module in process of rank
         0, to all other replicas in the system in every iteration.
 
+    .. note::
+        With a single device per process (``device_ids`` of length 1), the
+        gradients are packed in buckets and the allreduce of a bucket starts
+        as soon as backward computed all its gradients, overlapping
+        communication with the rest of backward.
+
     .. warning::
         Forward and backward hooks defined on :attr:`module` and its submodules
         won't be invoked anymore, unless the hooks are initialized in the
@@ -120,6 +126,7 @@ class DistributedDataParallel(Module):
         # used for intra-node param sync and inter-node sync as well
         self.broadcast_bucket_size = 10 * MB
         self.nccl_reduce_bucket_size = 256 * MB
+        self.reduce_bucket_size = 10 * MB
 
         # Sync params and buffers
         module_states = list(self.module.state_dict().values())
@@ -141,6 +148,13 @@ class DistributedDataParallel(Module):
         else:
             self._module_copies = [self.module]
 
+        # With a single device per process the gradients are bucketed and
+        # reduced by a C++ reducer, which starts the allreduce of a bucket as
+        # soon as backward produced all its gradients.
+        if len(device_ids) == 1:
+            self._register_reducer()
+            return
+
         # For NCCL backend, since every single NCCL call is asynchoronous, we
         # therefore directly enqueue all the NCCL reduction calls to the
         # default CUDA stream without spawning up other reduction threads.
@@ -193,7 +207,9 @@ class DistributedDataParallel(Module):
 
     def __getstate__(self):
         attrs = copy.copy(self.__dict__)
-        if dist._backend != dist.dist_backend.NCCL:
+        if len(self.device_ids) == 1:
+            del attrs['_reducer']
+        elif dist._backend != dist.dist_backend.NCCL:
             del attrs['_grad_accs'], attrs['_reduction_queues'], \
                 attrs['_reduction_streams'], attrs['_reduction_threads'], \
                 attrs['_nccl_streams'], attrs['_default_streams']
@@ -201,7 +217,9 @@ class DistributedDataParallel(Module):
 
     def __setstate__(self, state):
         super(DistributedDataParallel, self).__setstate__(state)
-        if dist._backend == dist.dist_backend.NCCL:
+        if len(self.device_ids) == 1:
+            self._register_reducer()
+        elif dist._backend == dist.dist_backend.NCCL:
             self._register_nccl_grad_hook()
         else:
             self._register_grad_hooks()
@@ -270,6 +288,12 @@ class DistributedDataParallel(Module):
                         for tensor, buf in zip(tensors, module._all_buffers()):
                             buf.set_(tensor)
 
+    def _register_reducer(self):
+        params = [p for p in self.module.parameters() if p.requires_grad]
+        self.reduction_group_id = dist.new_group()
+        self._reducer = torch._C._dist_new_reducer(params, self.reduce_bucket_size,
+                                                   self.reduction_group_id)
+
     def _register_grad_hooks(self):
         self._grad_accs = []  # need to keep them in scope
         for device_idx, module in enumerate(self._module_copies):
@@ -207,7 +207,9 @@ def sum(g, self, dim=None, keepdim=None):
         return g.op("Sum", self)
     if keepdim is None:
         keepdim = 0
-    return g.op("ReduceSum", self, axes_i=[dim], keepdims_i=keepdim)
+    if not isinstance(dim, (list, tuple)):
+        dim = [dim]
+    return g.op("ReduceSum", self, axes_i=dim, keepdims_i=keepdim)
 
 
 def cumsum(g, input, dim):
@@ -243,11 +245,13 @@ def embedding_bag(g,
                   offsets,
                   scale_grad_by_freq,
                   mode,
-                  sparse):
+                  sparse,
+                  per_sample_weights):
+    args = [embedding_matrix, indices, offsets]
+    if per_sample_weights.node().kind() != "prim::Undefined":
+        args.append(per_sample_weights)
     return g.op("ATen",
-                embedding_matrix,
-                indices,
-                offsets,
+                *args,
                 operator_s="embedding_bag",
                 outputs=3,
                 scale_grad_by_freq_i=scale_grad_by_freq,
@@ -367,6 +371,10 @@ def softmax(g, input, dim=None):
     return g.op('Softmax', input, axis_i=dim)
 
 
+def _softmax(g, input, dim):
+    return softmax(g, input, dim)
+
+
 def softplus(g, self, beta, threshold):
     if beta != 1:
         return _unimplemented("beta", "has to be 1")
@@ -413,6 +421,14 @@ def avg_pool2d(g, input, kernel_size, stride, padding, ceil_mode, count_include_
                 pads_i=_pair(padding) * 2)
 
 
+def _max_pool2d(g, input, kernel_size, stride, padding, dilation, ceil_mode, return_indices):
+    return max_pool2d(g, input, kernel_size, stride, padding, dilation, ceil_mode)
+
+
+def _avg_pool2d(g, input, kernel_size, stride, padding, ceil_mode, count_include_pad):
+    return avg_pool2d(g, input, kernel_size, stride, padding, ceil_mode, count_include_pad)
+
+
 def avg_pool3d(g, input, kernel_size, stride, padding, ceil_mode, count_include_pad):
     if ceil_mode:
         return _unimplemented("avg_pool3d", "ceil_mode")
@@ -471,6 +487,10 @@ def log_softmax(g, input, dim=None):
     return g.op("LogSoftmax", input, axis_i=dim)
 
 
+def _log_softmax(g, input, dim):
+    return log_softmax(g, input, dim)
+
+
 def _convolution(g, input, weight, bias, stride, padding, dilation,
                  transposed, output_padding, groups, benchmark, deterministic, cudnn_enabled):
     weight_size = weight.type().sizes()
@@ -619,6 +639,11 @@ def _unique(g, input, sorted, return_inverse):
                 return_inverse_i=return_inverse, outputs=2)
 
 
+def _unique_with_counts(g, input, sorted, return_inverse):
+    return g.op("ATen", input, operator_s="_unique_with_counts", sorted_i=sorted,
+                return_inverse_i=return_inverse, outputs=3)
+
+
 # Metaprogram symbolics for each ATen native specialized cast operator.
 # For e.g. we specify a function named `_cast_uint8_t` that instantiates an
 # ONNX cast node with `to` attribute 'UINT8'
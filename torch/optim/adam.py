@@ -1,4 +1,6 @@
 import math
+from collections import OrderedDict
+
 import torch
 from .optimizer import Optimizer
 
@@ -19,6 +21,10 @@ class Adam(Optimizer):
         weight_decay (float, optional): weight decay (L2 penalty) (default: 0)
         amsgrad (boolean, optional): whether to use the AMSGrad variant of this
             algorithm from the paper `On the Convergence of Adam and Beyond`_
+        fused (boolean, optional): updates the parameters with dense, contiguous
+            gradients of each type and step count in a single fused step,
+            which takes a few kernel launches on CUDA instead of several per
+            parameter. Not used with amsgrad (default: False)
 
     .. _Adam\: A Method for Stochastic Optimization:
         https://arxiv.org/abs/1412.6980
@@ -27,7 +33,7 @@ class Adam(Optimizer):
     """
 
     def __init__(self, params, lr=1e-3, betas=(0.9, 0.999), eps=1e-8,
-                 weight_decay=0, amsgrad=False):
+                 weight_decay=0, amsgrad=False, fused=False):
         if not 0.0 <= lr:
             raise ValueError("Invalid learning rate: {}".format(lr))
         if not 0.0 <= eps:
@@ -37,13 +43,48 @@ class Adam(Optimizer):
         if not 0.0 <= betas[1] < 1.0:
             raise ValueError("Invalid beta parameter at index 1: {}".format(betas[1]))
         defaults = dict(lr=lr, betas=betas, eps=eps,
-                        weight_decay=weight_decay, amsgrad=amsgrad)
+                        weight_decay=weight_decay, amsgrad=amsgrad, fused=fused)
         super(Adam, self).__init__(params, defaults)
 
     def __setstate__(self, state):
         super(Adam, self).__setstate__(state)
         for group in self.param_groups:
             group.setdefault('amsgrad', False)
+            group.setdefault('fused', False)
+
+    def _fused_step(self, group, params):
+        """Updates the params with dense, contiguous gradients with
+        torch._fused_adam_step, once for each type and step count, and returns
+        the others."""
+        # (type, step) -> params
+        buckets = OrderedDict()
+        rest = []
+        for p in params:
+            if p.grad.data.is_sparse or not p.grad.data.is_contiguous() or not p.data.is_contiguous():
+                rest.append(p)
+                continue
+            state = self.state[p]
+            if len(state) == 0:
+                state['step'] = 0
+                state['exp_avg'] = torch.zeros_like(p.data)
+                state['exp_avg_sq'] = torch.zeros_like(p.data)
+            if not state['exp_avg'].is_contiguous() or not state['exp_avg_sq'].is_contiguous():
+                rest.append(p)
+                continue
+            buckets.setdefault((p.data.type(), state['step']), []).append(p)
+
+        beta1, beta2 = group['betas']
+        for (_, step), bucket in buckets.items():
+            for p in bucket:
+                self.state[p]['step'] += 1
+            bias_correction1 = 1 - beta1 ** (step + 1)
+            bias_correction2 = 1 - beta2 ** (step + 1)
+            step_size = group['lr'] * math.sqrt(bias_correction2) / bias_correction1
+            torch._fused_adam_step([p.data for p in bucket], [p.grad.data for p in bucket],
+                                   [self.state[p]['exp_avg'] for p in bucket],
+                                   [self.state[p]['exp_avg_sq'] for p in bucket], [],
+                                   step_size, beta1, beta2, group['eps'], group['weight_decay'])
+        return rest
 
     def step(self, closure=None):
         """Performs a single optimization step.
@@ -57,9 +98,11 @@ class Adam(Optimizer):
             loss = closure()
 
         for group in self.param_groups:
-            for p in group['params']:
-                if p.grad is None:
-                    continue
+            params = [p for p in group['params'] if p.grad is not None]
+            if group['fused'] and not group['amsgrad']:
+                params = self._fused_step(group, params)
+
+            for p in params:
                 grad = p.grad.data
                 if grad.is_sparse:
                     raise RuntimeError('Adam does not support sparse gradients, please consider SparseAdam instead')
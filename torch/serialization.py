@@ -9,6 +9,7 @@ import torch
 import tarfile
 import tempfile
 import warnings
+from collections import OrderedDict
 from contextlib import closing, contextmanager
 from ._utils import _import_dotted_name
 from ._six import string_classes as _string_classes
@@ -27,6 +28,9 @@ SHORT_SIZE = struct.Struct('=h').size
 MAGIC_NUMBER = 0x1950a86a20f9469cfc6c
 PROTOCOL_VERSION = 1001
 STORAGE_KEY_SEPARATOR = ','
+# The data of the storages saved with page_aligned=True starts at a multiple
+# of this many bytes in the file.
+STORAGE_ALIGNMENT = 4096
 
 
 class SourceChangeWarning(Warning):
@@ -131,7 +135,8 @@ def _is_real_file(f):
         return False
 
 
-def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
+def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL,
+         page_aligned=False):
     """Saves an object to a disk file.
 
     See also: :ref:`recommend-saving-models`
@@ -142,6 +147,11 @@ def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
            containing a file name
         pickle_module: module used for pickling metadata and objects
         pickle_protocol: can be specified to override the default protocol
+        page_aligned: if ``True``, the data of every storage starts on a page
+           boundary of the file, and an index of the storages is saved, so
+           that the file can be loaded with ``torch.load(f, mmap=True)``.
+           ``f`` also has to implement tell and seek then. Such files can't
+           be loaded by versions of PyTorch that don't have this argument.
 
     .. warning::
         If you are using Python 2, torch.save does NOT support StringIO.StringIO
@@ -158,10 +168,11 @@ def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
         >>> buffer = io.BytesIO()
         >>> torch.save(x, buffer)
     """
-    return _with_file_like(f, "wb", lambda f: _save(obj, f, pickle_module, pickle_protocol))
+    return _with_file_like(f, "wb", lambda f: _save(obj, f, pickle_module, pickle_protocol,
+                                                    page_aligned))
 
 
-def _save(obj, f, pickle_module, pickle_protocol):
+def _save(obj, f, pickle_module, pickle_protocol, page_aligned):
     if sys.version_info[0] == 2:
         import StringIO
         if isinstance(f, StringIO.StringIO):
@@ -223,10 +234,17 @@ def _save(obj, f, pickle_module, pickle_protocol):
             long=LONG_SIZE,
         ),
     )
+    if page_aligned:
+        sys_info['storage_alignment'] = STORAGE_ALIGNMENT
 
     pickle_module.dump(MAGIC_NUMBER, f, protocol=pickle_protocol)
     pickle_module.dump(PROTOCOL_VERSION, f, protocol=pickle_protocol)
     pickle_module.dump(sys_info, f, protocol=pickle_protocol)
+    if page_aligned:
+        # placeholder for the offset of the storage index, which is only
+        # known once the storages are written
+        index_offset_position = f.tell()
+        f.write(struct.pack('<q', 0))
     pickler = pickle_module.Pickler(f, protocol=pickle_protocol)
     pickler.persistent_id = persistent_id
     pickler.dump(obj)
@@ -234,11 +252,29 @@ def _save(obj, f, pickle_module, pickle_protocol):
     serialized_storage_keys = sorted(serialized_storages.keys())
     pickle_module.dump(serialized_storage_keys, f, protocol=pickle_protocol)
     f.flush()
+    storage_offsets = {}
     for key in serialized_storage_keys:
+        if page_aligned:
+            # every record is the size of the storage as an int64, then its
+            # data, which should start on a page boundary
+            offset = f.tell()
+            padding = -(offset + 8) % STORAGE_ALIGNMENT
+            f.write(b'\0' * padding)
+            f.flush()
+            storage_offsets[key] = offset + padding
         serialized_storages[key]._write_file(f, _is_real_file(f))
 
+    if page_aligned:
+        index_offset = f.tell()
+        pickle_module.dump(storage_offsets, f, protocol=pickle_protocol)
+        end = f.tell()
+        f.seek(index_offset_position)
+        f.write(struct.pack('<q', index_offset))
+        f.seek(end)
+        f.flush()
 
-def load(f, map_location=None, pickle_module=pickle):
+
+def load(f, map_location=None, pickle_module=pickle, mmap=False):
     """Loads an object saved with :func:`torch.save` from a file.
 
     :meth:`torch.load` uses Python's unpickling facilities but treats storages,
@@ -277,6 +313,13 @@ def load(f, map_location=None, pickle_module=pickle):
             locations
         pickle_module: module used for unpickling metadata and objects (has to
             match the pickle_module used to serialize file)
+        mmap: if ``True``, and ``f`` was saved with ``page_aligned=True``, the
+            CPU storages are views of a private memory mapping of the file,
+            which is only read as the storages are accessed, and whose pages
+            are shared with other processes mapping the same file. Writes to
+            the storages aren't written to the file. ``f`` has to be a file
+            name or a real file with a ``name``. Ignored for other files, and
+            on big endian machines.
 
     Example:
         >>> torch.load('tensors.pt')
@@ -300,13 +343,13 @@ def load(f, map_location=None, pickle_module=pickle):
         new_fd = True
         f = open(f, 'rb')
     try:
-        return _load(f, map_location, pickle_module)
+        return _load(f, map_location, pickle_module, mmap)
     finally:
         if new_fd:
             f.close()
 
 
-def _load(f, map_location, pickle_module):
+def _load(f, map_location, pickle_module, mmap):
     deserialized_objects = {}
 
     if map_location is None:
@@ -433,8 +476,15 @@ def _load(f, map_location, pickle_module):
         elif typename == 'storage':
             data_type, root_key, location, size, view_metadata = data
             if root_key not in deserialized_objects:
-                deserialized_objects[root_key] = restore_location(
-                    data_type(size), location)
+                if mapping is not None:
+                    cpu_type = getattr(torch, data_type.__name__)
+                    storage = cpu_type._new_with_mapping(mapping, storage_offsets[root_key])
+                    if storage.size() != size:
+                        raise RuntimeError("storage has wrong size: expected {} got {}"
+                                           .format(size, storage.size()))
+                else:
+                    storage = data_type(size)
+                deserialized_objects[root_key] = restore_location(storage, location)
             storage = deserialized_objects[root_key]
             if view_metadata is not None:
                 view_key, offset, view_size = view_metadata
@@ -464,16 +514,81 @@ def _load(f, map_location, pickle_module):
         raise RuntimeError("Invalid protocol version: %s" % protocol_version)
 
     _sys_info = pickle_module.load(f)
+    storage_offsets = None
+    mapping = None
+    if 'storage_alignment' in _sys_info:
+        index_offset, = struct.unpack('<q', f.read(8))
+        position = f.tell()
+        f.seek(index_offset)
+        storage_offsets = pickle_module.load(f)
+        f.seek(position)
+        if mmap and f_is_real_file and isinstance(getattr(f, 'name', None), _string_classes) and \
+                sys.byteorder == 'little':
+            mapping = torch.ByteStorage.from_file(f.name, False, 0)
+
     unpickler = pickle_module.Unpickler(f)
     unpickler.persistent_load = persistent_load
     result = unpickler.load()
 
     deserialized_storage_keys = pickle_module.load(f)
+    if mapping is not None:
+        return result
 
     offset = f.tell() if f_is_real_file else None
     for key in deserialized_storage_keys:
         assert key in deserialized_objects
+        if storage_offsets is not None:
+            offset = storage_offsets[key]
+            if not f_is_real_file:
+                f.seek(offset)
+                offset = None
         deserialized_objects[key]._set_from_file(f, offset, f_is_real_file)
         offset = None
 
     return result
+
+
+def save_tensors(tensors, path):
+    """Saves a dictionary of tensors, like a ``state_dict``, to a flat file
+    without pickling.
+
+    The file has a table of the names, types, sizes and strides of the
+    tensors, followed by their data, each aligned on 64 bytes, and is written
+    with vectored writes. It can be read from C++ without Python.
+    Only the tensors are saved: the data of views is copied, and CUDA tensors
+    are saved as CPU tensors.
+
+    Args:
+        tensors: a dict mapping names to tensors. The order of the keys is
+            kept.
+        path: a string containing a file name
+
+    Example:
+        >>> torch.save_tensors(model.state_dict(), 'model.pta')
+    """
+    items = []
+    for name, tensor in tensors.items():
+        if not torch.is_tensor(tensor):
+            raise TypeError("save_tensors expects a dict of tensors, but {} is a {}"
+                            .format(name, torch.typename(tensor)))
+        items.append((name, tensor.cpu()))
+    torch._C._save_tensor_archive(path, items)
+
+
+def load_tensors(path, mmap=False):
+    """Loads the tensors saved with :func:`torch.save_tensors` on the CPU.
+
+    Args:
+        path: a string containing a file name
+        mmap: if ``True``, the tensors are views of a private memory mapping
+            of the file, which is only read as they are accessed. Writes to the
+            tensors aren't written to the file.
+
+    Returns:
+        An ``OrderedDict`` mapping the names to the tensors, in the order they
+        were saved.
+
+    Example:
+        >>> model.load_state_dict(torch.load_tensors('model.pta'))
+    """
+    return OrderedDict(torch._C._load_tensor_archive(path, mmap))
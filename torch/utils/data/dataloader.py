@@ -2,7 +2,7 @@ import random
 import torch
 import torch.multiprocessing as multiprocessing
 from torch._C import _set_worker_signal_handlers, _update_worker_pids, \
-    _remove_worker_pids, _error_if_any_worker_fails
+    _remove_worker_pids, _error_if_any_worker_fails, _collate_into
 from .sampler import SequentialSampler, RandomSampler, BatchSampler
 import signal
 import functools
@@ -30,6 +30,10 @@ class ExceptionWrapper(object):
 _use_shared_memory = False
 r"""Whether to use shared memory in default_collate"""
 
+_worker_shm_pool_size = 256 * 1024 * 1024
+r"""Bytes of shared memory segments that every worker reuses for its batches
+with the file_system sharing strategy, instead of creating new ones"""
+
 
 def _worker_loop(dataset, index_queue, data_queue, collate_fn, seed, init_fn, worker_id):
     global _use_shared_memory
@@ -48,17 +52,24 @@ def _worker_loop(dataset, index_queue, data_queue, collate_fn, seed, init_fn, wo
     if init_fn is not None:
         init_fn(worker_id)
 
-    while True:
-        r = index_queue.get()
-        if r is None:
-            break
-        idx, batch_indices = r
-        try:
-            samples = collate_fn([dataset[i] for i in batch_indices])
-        except Exception:
-            data_queue.put((idx, ExceptionWrapper(sys.exc_info())))
-        else:
-            data_queue.put((idx, samples))
+    if multiprocessing.get_sharing_strategy() == 'file_system':
+        torch._C._set_shm_pool_size(_worker_shm_pool_size)
+
+    try:
+        while True:
+            r = index_queue.get()
+            if r is None:
+                break
+            idx, batch_indices = r
+            try:
+                samples = collate_fn([dataset[i] for i in batch_indices])
+            except Exception:
+                data_queue.put((idx, ExceptionWrapper(sys.exc_info())))
+            else:
+                data_queue.put((idx, samples))
+    finally:
+        # the segments still used by the main process are unlinked by it
+        torch._C._set_shm_pool_size(0)
 
 
 def _worker_manager_loop(in_queue, out_queue, done_event, pin_memory, device_id):
@@ -98,6 +109,13 @@ numpy_type_map = {
 }
 
 
+def _can_collate_into(batch):
+    first = batch[0]
+    if first.is_cuda or first.dim() == 0:
+        return False
+    return all(x.type() == first.type() and x.size() == first.size() for x in batch)
+
+
 def default_collate(batch):
     r"""Puts each data field into a tensor with outer dimension batch size"""
 
@@ -111,6 +129,12 @@ def default_collate(batch):
             numel = sum([x.numel() for x in batch])
             storage = batch[0].storage()._new_shared(numel)
             out = batch[0].new(storage)
+        if _can_collate_into(batch):
+            # copies the samples on several threads, without the GIL
+            size = (len(batch),) + batch[0].size()
+            out = batch[0].new(*size) if out is None else out.view(*size)
+            _collate_into(out, batch)
+            return out
         return torch.stack(batch, 0, out=out)
     elif elem_type.__module__ == 'numpy' and elem_type.__name__ != 'str_' \
             and elem_type.__name__ != 'string_':
@@ -1,4 +1,42 @@
 import torch
 
-from torch._C import _from_dlpack as from_dlpack
-from torch._C import _to_dlpack as to_dlpack
+from torch._C import _from_dlpack
+from torch._C import _to_dlpack
+
+
+def _stream_handle(stream):
+    if stream is None or isinstance(stream, int):
+        return stream
+    return stream.cuda_stream
+
+
+def to_dlpack(tensor, stream=None):
+    r"""Returns a DLPack capsule sharing the memory of :attr:`tensor`.
+
+    CPU tensors in pinned memory are exported with the ``kDLCPUPinned``
+    device type.
+
+    Arguments:
+        tensor (Tensor): the tensor to export
+        stream (torch.cuda.Stream or int, optional): the stream, or the raw
+            ``cudaStream_t`` of the consumer of a CUDA tensor. The work
+            queued so far on the current stream is ordered before the work
+            queued next on :attr:`stream`, without synchronizing the host.
+            Once the consumer releases the capsule, the memory is only
+            reused after the work it queued on :attr:`stream`.
+    """
+    return _to_dlpack(tensor, _stream_handle(stream))
+
+
+def from_dlpack(capsule, stream=None):
+    r"""Returns a tensor sharing the memory of a DLPack capsule, which can
+    only be consumed once.
+
+    Arguments:
+        capsule: the DLPack capsule
+        stream (torch.cuda.Stream or int, optional): the stream, or the raw
+            ``cudaStream_t`` of the producer of a CUDA tensor. The work
+            queued so far on :attr:`stream` is ordered before the work queued
+            next on the current stream, without synchronizing the host.
+    """
+    return _from_dlpack(capsule, _stream_handle(stream))